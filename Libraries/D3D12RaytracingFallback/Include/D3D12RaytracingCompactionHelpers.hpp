@@ -0,0 +1,299 @@
+//=============================================================================================================================
+// D3D12 Raytracing Acceleration Structure Compaction Helpers
+//
+// Builds bottom-level acceleration structures in batches, queries their compacted sizes without stalling, and a few
+// frames later compacts them into large pooled buffers, releasing the memory the builds used.
+// Works with the DXR interfaces (ID3D12Device5/ID3D12GraphicsCommandList4) or the Fallback Layer's
+// (ID3D12RaytracingFallbackDevice/ID3D12RaytracingFallbackCommandList).
+// Uses STL and d3dx12.h
+//
+// Usage:
+//   UINT handle = compactor.AddBottomLevel(inputs);      // Queue as many as needed
+//   compactor.BuildPending(pCommandList, pRaytracingCommandList);
+//   ... execute the command list, then compactor.Signal(pCommandQueue)
+//
+//   Once per frame, until IsIdle() returns true:
+//   if (compactor.Update(pCommandList, pRaytracingCommandList))
+//       ... bottom levels have moved, rebuild the top level from GetGpuVirtualAddress(handle)
+//   ... execute the command list, then compactor.Signal(pCommandQueue)
+//
+// Bottom levels are suballocated, so the Fallback Layer's wrapped pointers need a UAV on GetResource(handle) and
+// GetOffsetInBytes(handle) as the offset. The pool only grows; it is released with the compactor.
+//=============================================================================================================================
+#pragma once
+#include <algorithm>
+#include <memory>
+#include <vector>
+#include <atlbase.h>
+
+template <class TRaytracingDevice, class TRaytracingCommandList>
+class CD3D12_ACCELERATION_STRUCTURE_COMPACTOR
+{
+public:
+    CD3D12_ACCELERATION_STRUCTURE_COMPACTOR(
+        ID3D12Device *pDevice,
+        TRaytracingDevice *pRaytracingDevice,
+        D3D12_RESOURCE_STATES AccelerationStructureState,
+        UINT64 PoolChunkSizeInBytes = 16 * 1024 * 1024) :
+        m_pDevice(pDevice),
+        m_pRaytracingDevice(pRaytracingDevice),
+        m_AccelerationStructureState(AccelerationStructureState),
+        m_PoolChunkSizeInBytes(PoolChunkSizeInBytes),
+        m_PoolChunkOffset(PoolChunkSizeInBytes),
+        m_NextFenceValue(1),
+        m_BuiltSizeInBytes(0),
+        m_CompactedSizeInBytes(0)
+    {
+        m_pDevice->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&m_pFence));
+    }
+
+    // Queues a bottom level to be built by the next BuildPending(). ALLOW_COMPACTION is added to the build flags.
+    UINT AddBottomLevel(const D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS &Inputs)
+    {
+        BOTTOM_LEVEL BottomLevel = {};
+        BottomLevel.Inputs = Inputs;
+        BottomLevel.Inputs.Flags |= D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_ALLOW_COMPACTION;
+
+        // The geometry descs are copied so the caller doesn't need to keep them alive until BuildPending()
+        BottomLevel.pGeometryDescs.reset(new D3D12_RAYTRACING_GEOMETRY_DESC[Inputs.NumDescs]);
+        for (UINT i = 0; i < Inputs.NumDescs; i++)
+        {
+            BottomLevel.pGeometryDescs[i] = Inputs.DescsLayout == D3D12_ELEMENTS_LAYOUT_ARRAY ?
+                Inputs.pGeometryDescs[i] : *Inputs.ppGeometryDescs[i];
+        }
+        BottomLevel.Inputs.DescsLayout = D3D12_ELEMENTS_LAYOUT_ARRAY;
+        BottomLevel.Inputs.pGeometryDescs = BottomLevel.pGeometryDescs.get();
+
+        m_BottomLevels.push_back(std::move(BottomLevel));
+        m_PendingBuilds.push_back((UINT)m_BottomLevels.size() - 1);
+        return (UINT)m_BottomLevels.size() - 1;
+    }
+
+    // Records the builds for every queued bottom level, followed by a query of their compacted sizes.
+    // For the Fallback Layer, the app's descriptor heaps must already be set on the command list.
+    void BuildPending(ID3D12GraphicsCommandList *pCommandList, TRaytracingCommandList *pRaytracingCommandList)
+    {
+        if (m_PendingBuilds.empty())
+        {
+            return;
+        }
+
+        std::unique_ptr<BATCH> pBatch(new BATCH);
+        pBatch->BottomLevels.swap(m_PendingBuilds);
+        pBatch->FenceValue = m_NextFenceValue;
+        pBatch->bCompacting = false;
+
+        // Every build in the batch gets its own result and scratch range so the builds can overlap on the GPU
+        UINT64 ResultSize = 0;
+        UINT64 ScratchSize = 0;
+        std::vector<UINT64> ScratchOffsets(pBatch->BottomLevels.size());
+        for (size_t i = 0; i < pBatch->BottomLevels.size(); i++)
+        {
+            BOTTOM_LEVEL &BottomLevel = m_BottomLevels[pBatch->BottomLevels[i]];
+            D3D12_RAYTRACING_ACCELERATION_STRUCTURE_PREBUILD_INFO PrebuildInfo = {};
+            m_pRaytracingDevice->GetRaytracingAccelerationStructurePrebuildInfo(&BottomLevel.Inputs, &PrebuildInfo);
+
+            BottomLevel.OffsetInBytes = ResultSize;
+            BottomLevel.SizeInBytes = PrebuildInfo.ResultDataMaxSizeInBytes;
+            ScratchOffsets[i] = ScratchSize;
+            ResultSize += AlignUp(PrebuildInfo.ResultDataMaxSizeInBytes);
+            ScratchSize += AlignUp(PrebuildInfo.ScratchDataSizeInBytes);
+        }
+
+        const UINT64 PostbuildInfoSize = pBatch->BottomLevels.size() * sizeof(D3D12_RAYTRACING_ACCELERATION_STRUCTURE_POSTBUILD_INFO_COMPACTED_SIZE_DESC);
+        CreateBuffer(ResultSize, D3D12_HEAP_TYPE_DEFAULT, m_AccelerationStructureState, &pBatch->pResult);
+        CreateBuffer(ScratchSize, D3D12_HEAP_TYPE_DEFAULT, D3D12_RESOURCE_STATE_UNORDERED_ACCESS, &pBatch->pScratch);
+        CreateBuffer(PostbuildInfoSize, D3D12_HEAP_TYPE_DEFAULT, D3D12_RESOURCE_STATE_UNORDERED_ACCESS, &pBatch->pPostbuildInfo);
+        CreateBuffer(PostbuildInfoSize, D3D12_HEAP_TYPE_READBACK, D3D12_RESOURCE_STATE_COPY_DEST, &pBatch->pPostbuildInfoReadback);
+
+        std::vector<D3D12_GPU_VIRTUAL_ADDRESS> BottomLevelAddresses(pBatch->BottomLevels.size());
+        for (size_t i = 0; i < pBatch->BottomLevels.size(); i++)
+        {
+            BOTTOM_LEVEL &BottomLevel = m_BottomLevels[pBatch->BottomLevels[i]];
+            BottomLevel.pResource = pBatch->pResult;
+            BottomLevelAddresses[i] = pBatch->pResult->GetGPUVirtualAddress() + BottomLevel.OffsetInBytes;
+            m_BuiltSizeInBytes += BottomLevel.SizeInBytes;
+
+            D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_DESC BuildDesc = {};
+            BuildDesc.Inputs = BottomLevel.Inputs;
+            BuildDesc.DestAccelerationStructureData = BottomLevelAddresses[i];
+            BuildDesc.ScratchAccelerationStructureData = pBatch->pScratch->GetGPUVirtualAddress() + ScratchOffsets[i];
+            pRaytracingCommandList->BuildRaytracingAccelerationStructure(&BuildDesc, 0, nullptr);
+        }
+
+        D3D12_RESOURCE_BARRIER UavBarrier = CD3DX12_RESOURCE_BARRIER::UAV(nullptr);
+        pCommandList->ResourceBarrier(1, &UavBarrier);
+
+        D3D12_RAYTRACING_ACCELERATION_STRUCTURE_POSTBUILD_INFO_DESC PostbuildInfoDesc = {};
+        PostbuildInfoDesc.DestBuffer = pBatch->pPostbuildInfo->GetGPUVirtualAddress();
+        PostbuildInfoDesc.InfoType = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_POSTBUILD_INFO_COMPACTED_SIZE;
+        pRaytracingCommandList->EmitRaytracingAccelerationStructurePostbuildInfo(
+            &PostbuildInfoDesc, (UINT)BottomLevelAddresses.size(), BottomLevelAddresses.data());
+
+        D3D12_RESOURCE_BARRIER CopySourceBarrier = CD3DX12_RESOURCE_BARRIER::Transition(
+            pBatch->pPostbuildInfo, D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_COPY_SOURCE);
+        pCommandList->ResourceBarrier(1, &CopySourceBarrier);
+        pCommandList->CopyResource(pBatch->pPostbuildInfoReadback, pBatch->pPostbuildInfo);
+
+        m_Batches.push_back(std::move(pBatch));
+    }
+
+    // Compacts every batch whose sizes have been read back, and frees the batches whose compaction has finished.
+    // Returns true when bottom levels have moved, after which the top level must be rebuilt (after a UAV barrier).
+    bool Update(ID3D12GraphicsCommandList *pCommandList, TRaytracingCommandList *pRaytracingCommandList)
+    {
+        const UINT64 CompletedFenceValue = m_pFence->GetCompletedValue();
+        bool bMoved = false;
+        for (auto Iter = m_Batches.begin(); Iter != m_Batches.end();)
+        {
+            BATCH &Batch = **Iter;
+            if (Batch.FenceValue > CompletedFenceValue)
+            {
+                ++Iter;
+                continue;
+            }
+
+            if (Batch.bCompacting)
+            {
+                // Nothing references the builds anymore
+                Iter = m_Batches.erase(Iter);
+                continue;
+            }
+
+            const D3D12_RAYTRACING_ACCELERATION_STRUCTURE_POSTBUILD_INFO_COMPACTED_SIZE_DESC *pCompactedSizes = nullptr;
+            Batch.pPostbuildInfoReadback->Map(0, nullptr, (void **)&pCompactedSizes);
+            for (size_t i = 0; i < Batch.BottomLevels.size(); i++)
+            {
+                BOTTOM_LEVEL &BottomLevel = m_BottomLevels[Batch.BottomLevels[i]];
+                const D3D12_GPU_VIRTUAL_ADDRESS SourceAddress = BottomLevel.pResource->GetGPUVirtualAddress() + BottomLevel.OffsetInBytes;
+
+                BottomLevel.SizeInBytes = pCompactedSizes[i].CompactedSizeInBytes;
+                AllocateFromPool(BottomLevel.SizeInBytes, BottomLevel.pResource, BottomLevel.OffsetInBytes);
+                m_CompactedSizeInBytes += BottomLevel.SizeInBytes;
+
+                pRaytracingCommandList->CopyRaytracingAccelerationStructure(
+                    BottomLevel.pResource->GetGPUVirtualAddress() + BottomLevel.OffsetInBytes,
+                    SourceAddress,
+                    D3D12_RAYTRACING_ACCELERATION_STRUCTURE_COPY_MODE_COMPACT);
+            }
+            D3D12_RANGE EmptyRange = {};
+            Batch.pPostbuildInfoReadback->Unmap(0, &EmptyRange);
+
+            // The builds stay alive until the compaction has finished with them
+            Batch.bCompacting = true;
+            Batch.FenceValue = m_NextFenceValue;
+            Batch.pScratch.Release();
+            Batch.pPostbuildInfo.Release();
+            Batch.pPostbuildInfoReadback.Release();
+            bMoved = true;
+            ++Iter;
+        }
+
+        if (bMoved)
+        {
+            D3D12_RESOURCE_BARRIER UavBarrier = CD3DX12_RESOURCE_BARRIER::UAV(nullptr);
+            pCommandList->ResourceBarrier(1, &UavBarrier);
+        }
+        return bMoved;
+    }
+
+    // Must be called after each command list passed to BuildPending() or Update() has been executed on pCommandQueue
+    void Signal(ID3D12CommandQueue *pCommandQueue)
+    {
+        pCommandQueue->Signal(m_pFence, m_NextFenceValue++);
+    }
+
+    // True when nothing is waiting to be built, compacted or freed
+    bool IsIdle() const { return m_PendingBuilds.empty() && m_Batches.empty(); }
+
+    D3D12_GPU_VIRTUAL_ADDRESS GetGpuVirtualAddress(UINT Handle) const
+    {
+        return m_BottomLevels[Handle].pResource->GetGPUVirtualAddress() + m_BottomLevels[Handle].OffsetInBytes;
+    }
+    ID3D12Resource *GetResource(UINT Handle) const { return m_BottomLevels[Handle].pResource; }
+    UINT64 GetOffsetInBytes(UINT Handle) const { return m_BottomLevels[Handle].OffsetInBytes; }
+
+    // Sum of the built sizes of every bottom level, and the sum of their compacted sizes once compacted
+    UINT64 GetBuiltSizeInBytes() const { return m_BuiltSizeInBytes; }
+    UINT64 GetCompactedSizeInBytes() const { return m_CompactedSizeInBytes; }
+
+private:
+    struct BOTTOM_LEVEL
+    {
+        D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS Inputs;
+        std::unique_ptr<D3D12_RAYTRACING_GEOMETRY_DESC[]> pGeometryDescs;
+        CComPtr<ID3D12Resource> pResource;
+        UINT64 OffsetInBytes;
+        UINT64 SizeInBytes;
+    };
+
+    struct BATCH
+    {
+        std::vector<UINT> BottomLevels;
+        CComPtr<ID3D12Resource> pResult;
+        CComPtr<ID3D12Resource> pScratch;
+        CComPtr<ID3D12Resource> pPostbuildInfo;
+        CComPtr<ID3D12Resource> pPostbuildInfoReadback;
+        UINT64 FenceValue;
+        bool bCompacting;
+    };
+
+    static UINT64 AlignUp(UINT64 Size)
+    {
+        const UINT64 Alignment = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BYTE_ALIGNMENT;
+        return (Size + Alignment - 1) & ~(Alignment - 1);
+    }
+
+    void CreateBuffer(UINT64 Size, D3D12_HEAP_TYPE HeapType, D3D12_RESOURCE_STATES InitialState, ID3D12Resource **ppResource)
+    {
+        CD3DX12_HEAP_PROPERTIES HeapProperties(HeapType);
+        CD3DX12_RESOURCE_DESC BufferDesc = CD3DX12_RESOURCE_DESC::Buffer(std::max<UINT64>(Size, 1),
+            HeapType == D3D12_HEAP_TYPE_DEFAULT ? D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS : D3D12_RESOURCE_FLAG_NONE);
+        m_pDevice->CreateCommittedResource(&HeapProperties, D3D12_HEAP_FLAG_NONE, &BufferDesc, InitialState, nullptr, IID_PPV_ARGS(ppResource));
+    }
+
+    void AllocateFromPool(UINT64 Size, CComPtr<ID3D12Resource> &pResource, UINT64 &OffsetInBytes)
+    {
+        Size = AlignUp(Size);
+        if (Size > m_PoolChunkSizeInBytes)
+        {
+            // Too large to share a chunk
+            pResource.Release();
+            CreateBuffer(Size, D3D12_HEAP_TYPE_DEFAULT, m_AccelerationStructureState, &pResource);
+            m_Pool.push_back(pResource);
+            OffsetInBytes = 0;
+            return;
+        }
+
+        if (m_PoolChunkOffset + Size > m_PoolChunkSizeInBytes)
+        {
+            m_pPoolChunk.Release();
+            CreateBuffer(m_PoolChunkSizeInBytes, D3D12_HEAP_TYPE_DEFAULT, m_AccelerationStructureState, &m_pPoolChunk);
+            m_Pool.push_back(m_pPoolChunk);
+            m_PoolChunkOffset = 0;
+        }
+
+        pResource = m_pPoolChunk;
+        OffsetInBytes = m_PoolChunkOffset;
+        m_PoolChunkOffset += Size;
+    }
+
+    ID3D12Device *m_pDevice;
+    TRaytracingDevice *m_pRaytracingDevice;
+    D3D12_RESOURCE_STATES m_AccelerationStructureState;
+
+    std::vector<BOTTOM_LEVEL> m_BottomLevels;
+    std::vector<UINT> m_PendingBuilds;
+    std::vector<std::unique_ptr<BATCH>> m_Batches;
+
+    const UINT64 m_PoolChunkSizeInBytes;
+    std::vector<CComPtr<ID3D12Resource>> m_Pool;
+    CComPtr<ID3D12Resource> m_pPoolChunk;
+    UINT64 m_PoolChunkOffset;
+
+    CComPtr<ID3D12Fence> m_pFence;
+    UINT64 m_NextFenceValue;
+
+    UINT64 m_BuiltSizeInBytes;
+    UINT64 m_CompactedSizeInBytes;
+};
@@ -65,6 +65,41 @@ public:
     virtual ID3D12StateObject *GetStateObject() = 0;
 };
 
+enum D3D12_RAYTRACING_FALLBACK_STATE_OBJECT_STATUS
+{
+    D3D12_RAYTRACING_FALLBACK_STATE_OBJECT_STATUS_PENDING = 0,
+    D3D12_RAYTRACING_FALLBACK_STATE_OBJECT_STATUS_CREATING,
+    D3D12_RAYTRACING_FALLBACK_STATE_OBJECT_STATUS_COMPLETE,
+    D3D12_RAYTRACING_FALLBACK_STATE_OBJECT_STATUS_FAILED
+};
+
+// State objects being created on worker threads by ID3D12RaytracingFallbackDevice::CreateStateObjects.
+// The status queries don't block, so a loading screen can poll them every frame.
+class
+_declspec(uuid("bfb8d0f8-2758-4e25-936f-5be11015fcdc"))
+ID3D12RaytracingFallbackStateObjectBatch : public IUnknown
+{
+public:
+    virtual ~ID3D12RaytracingFallbackStateObjectBatch() {};
+
+    virtual UINT STDMETHODCALLTYPE GetStateObjectCount(void) = 0;
+
+    // Number of state objects whose creation has finished, successfully or not
+    virtual UINT STDMETHODCALLTYPE GetCompletedCount(void) = 0;
+
+    virtual D3D12_RAYTRACING_FALLBACK_STATE_OBJECT_STATUS STDMETHODCALLTYPE GetStatus(
+        _In_ UINT Index) = 0;
+
+    // Blocks until every state object in the batch has finished
+    virtual void STDMETHODCALLTYPE Wait(void) = 0;
+
+    // Blocks until the state object at Index has finished, then returns it or the error its creation failed with
+    virtual HRESULT STDMETHODCALLTYPE GetStateObject(
+        _In_ UINT Index,
+        _In_ REFIID riid,
+        _COM_Outptr_ void **ppStateObject) = 0;
+};
+
 class
 _declspec(uuid("348a2a6b-6760-4b78-a9a7-1758b6f78d46"))
 ID3D12RaytracingFallbackCommandList : public IUnknown
@@ -121,6 +156,17 @@ public:
     virtual WRAPPED_GPU_POINTER GetWrappedPointerFromGpuVA(D3D12_GPU_VIRTUAL_ADDRESS gpuVA) = 0;
 
     virtual D3D12_RESOURCE_STATES GetAccelerationStructureResourceState() = 0;
+
+    // Reports whether acceleration structures serialized with D3D12_RAYTRACING_ACCELERATION_STRUCTURE_COPY_MODE_SERIALIZE,
+    // possibly in a previous run or on another machine, can be deserialized on this device
+    virtual D3D12_DRIVER_MATCHING_IDENTIFIER_STATUS CheckDriverMatchingIdentifier(
+        _In_ D3D12_SERIALIZED_DATA_TYPE SerializedDataType,
+        _In_ const D3D12_SERIALIZED_DATA_DRIVER_MATCHING_IDENTIFIER *pIdentifierToCheck) = 0;
+
+    // Keeps the shaders and pipelines the compute fallback links for each state object in the file at pFilePath,
+    // so that creating the same state object in a later run skips DXIL linking and PSO compilation. Pass null to
+    // stop caching. Raytracing drivers keep their own shader caches, so this does nothing on them.
+    virtual HRESULT SetStateObjectCacheFile(_In_opt_ LPCWSTR pFilePath) = 0;
     
     virtual UINT STDMETHODCALLTYPE GetShaderIdentifierSize(void) = 0;
 
@@ -129,6 +175,15 @@ public:
         REFIID riid,
         _COM_Outptr_  void **ppStateObject) = 0;
 
+    // Creates independent state objects concurrently on worker threads and returns without waiting for them.
+    // The descs and everything they point to must stay valid until the batch has finished. Existing collections
+    // they reference must already have been created. Releasing the batch waits for it to finish.
+    virtual HRESULT STDMETHODCALLTYPE CreateStateObjects(
+        _In_ UINT NumStateObjects,
+        _In_reads_(NumStateObjects) const D3D12_STATE_OBJECT_DESC *pDescs,
+        REFIID riid,
+        _COM_Outptr_ void **ppStateObjectBatch) = 0;
+
     virtual void STDMETHODCALLTYPE GetRaytracingAccelerationStructurePrebuildInfo(
         _In_  const D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS *pDesc,
         _Out_  D3D12_RAYTRACING_ACCELERATION_STRUCTURE_PREBUILD_INFO *pInfo) = 0;
@@ -41,7 +41,8 @@ void main(uint3 DTid : SV_DispatchThreadID)
     uint offsetToBoxes = SizeOfBVHOffsets;
     uint offsetToPrimitives = GetOffsetToPrimitives(Constants.NumberOfElements);
     uint offsetToPrimitiveMetaData = offsetToPrimitives + GetOffsetFromPrimitivesToPrimitiveMetaData(Constants.NumberOfElements);
-    uint totalSize = offsetToPrimitiveMetaData + Constants.NumberOfElements * SizeOfPrimitiveMetaData;
+    uint offsetToWideBVHNodes = offsetToPrimitiveMetaData + GetOffsetFromPrimitiveMetaDataToWideBVHNodes(Constants.NumberOfElements);
+    uint totalSize = offsetToWideBVHNodes + GetSizeOfWideBVHNodes(Constants.NumberOfElements);
 
     if (DTid.x == 0)
     {
@@ -32,23 +32,43 @@ void WriteParent(uint parentIndex, int leftBoxIndex, int rightBoxIndex)
     hierarchyBuffer[parentIndex].RightChildIndex = rightBoxIndex;
 }
 
+// Elements with equal codes are told apart by their sorted index, as if it were appended to the
+// code, so the prefix they share is always longer than that of any two distinct codes.  Without
+// this, runs of duplicate codes would all get the same range and split.
 int GetLongestCommonPrefix(uint indexA, uint indexB)
 {
     if (indexA >= Constants.NumberOfElements || indexB >= Constants.NumberOfElements)
     {
         return -1;
     }
+    else if (Constants.Use64BitMortonCodes)
+    {
+        uint2 mortonCodeA = mortonCodes.Load2(indexA * 8);
+        uint2 mortonCodeB = mortonCodes.Load2(indexB * 8);
+        if (mortonCodeA.y != mortonCodeB.y)
+        {
+            return CountLeadingZeroes(mortonCodeA.y ^ mortonCodeB.y);
+        }
+        else if (mortonCodeA.x != mortonCodeB.x)
+        {
+            return CountLeadingZeroes(mortonCodeA.x ^ mortonCodeB.x) + 32;
+        }
+        else
+        {
+            return CountLeadingZeroes(indexA ^ indexB) + 64;
+        }
+    }
     else
     {
-        uint mortonCodeA = mortonCodes[indexA];
-        uint mortonCodeB = mortonCodes[indexB];
+        uint mortonCodeA = mortonCodes.Load(indexA * 4);
+        uint mortonCodeB = mortonCodes.Load(indexB * 4);
         if (mortonCodeA != mortonCodeB)
         {
-            return CountLeadingZeroes(mortonCodes[indexA] ^ mortonCodes[indexB]);
+            return CountLeadingZeroes(mortonCodeA ^ mortonCodeB);
         }
         else
         {
-            // TODO: Technically this should be primitive ID
+            // The codes are only 30 bits, so distinct codes never share more than 31
             return CountLeadingZeroes(indexA ^ indexB) + 31;
         }
     }
@@ -105,6 +105,50 @@ uint CalculateMortonCode(float3 elementCentroid)
 }
 #endif
 
+// Same bit layout as the 32-bit code, but with 21 bits per axis the code needs 63 bits. Bit i of
+// the code is returned in bit (i % 32) of word (i / 32).
+uint2 GetMortonCode64FromUnitCoord(float3 unitCoord)
+{
+    uint2 mortonCode = 0;
+    const unsigned int numBits = 21;
+    unsigned int maxCoord = 1u << numBits;
+
+    float3 adjustedCoord = min(max(unitCoord * maxCoord, 0.0f), maxCoord - 1);
+    const unsigned int numAxis = 3;
+    uint coords[numAxis] = { adjustedCoord.y, adjustedCoord.x, adjustedCoord.z };
+    for (uint bitIndex = 0; bitIndex < numBits; bitIndex++)
+    {
+        for (uint axis = 0; axis < numAxis; axis++)
+        {
+            uint bit = BIT(bitIndex) & coords[axis];
+            if (bit)
+            {
+                uint codeBit = bitIndex * numAxis + axis;
+                if (codeBit < 32)
+                {
+                    mortonCode.x |= BIT(codeBit);
+                }
+                else
+                {
+                    mortonCode.y |= BIT(codeBit - 32);
+                }
+            }
+        }
+    }
+    return mortonCode;
+}
+
+uint2 CalculateMortonCode64(float3 elementCentroid)
+{
+    const float epsilon = 0.00001;
+
+    AABB sceneAABB = GetSceneAABB();
+    float3 sceneDimension = max(sceneAABB.max - sceneAABB.min, epsilon);
+    float3 unitCoord = (elementCentroid - sceneAABB.min) / sceneDimension;
+
+    return GetMortonCode64FromUnitCoord(unitCoord);
+}
+
 [numthreads(THREAD_GROUP_1D_WIDTH, 1, 1)]
 void main(uint3 DTid : SV_DispatchThreadID)
 {
@@ -112,8 +156,13 @@ void main(uint3 DTid : SV_DispatchThreadID)
     if (elementIndex >= Constants.NumberOfElements) return;
 
     float3 elementCentroid = GetCentroid(elementIndex);
-    uint mortonCode = CalculateMortonCode(elementCentroid);
-
-    OutputMortonCodesBuffer[elementIndex] = mortonCode;
+    if (Constants.Use64BitCodes)
+    {
+        OutputMortonCodesBuffer.Store2(elementIndex * 8, CalculateMortonCode64(elementCentroid));
+    }
+    else
+    {
+        OutputMortonCodesBuffer.Store(elementIndex * 4, CalculateMortonCode(elementCentroid));
+    }
     OutputIndicesBuffer[elementIndex] = elementIndex;
 }
\ No newline at end of file
@@ -18,6 +18,9 @@
 struct MortonCodeCalculatorConstants
 {
     uint NumberOfElements;
+
+    // Nonzero to write 64-bit codes, with 21 bits per axis instead of 10
+    uint Use64BitCodes;
 };
 
 // UAVs
@@ -31,7 +34,8 @@ struct MortonCodeCalculatorConstants
 
 #ifdef HLSL
 RWStructuredBuffer<uint> OutputIndicesBuffer : UAV_REGISTER(MortonCodeCalculatorCalculatorOutputIndices);
-RWStructuredBuffer<uint> OutputMortonCodesBuffer : UAV_REGISTER(MortonCodeCalculatorCalculatorOutputMortonCodes);
+// 32-bit codes, or 64-bit codes stored as (low word, high word)
+RWByteAddressBuffer OutputMortonCodesBuffer : UAV_REGISTER(MortonCodeCalculatorCalculatorOutputMortonCodes);
 RWByteAddressBuffer SceneAABB : UAV_REGISTER(MortonCodeCalculatorSceneAABBRegister);
 cbuffer MortonCodeCalculatorConstants : CONSTANT_REGISTER(MortonCodeCalculatorConstantsRegister)
 {
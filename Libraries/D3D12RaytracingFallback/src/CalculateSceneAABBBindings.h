@@ -17,7 +17,7 @@
 #include "RaytracingHlslCompat.h"
 
 #define ElementsSummedPerThread 8
-
+#define ElementsSummedPerGroup (ElementsSummedPerThread * THREAD_GROUP_1D_WIDTH)
 
 struct SceneAABBCalculatorConstants
 {
@@ -28,27 +28,122 @@ struct SceneAABBCalculatorConstants
 #define SceneAABBCalculatorAABBBuffer 0
 #define SceneAABBCalculatorOutputBuffer 1
 #define SceneAABBCalculatorInputBufferRegister 2
+#define SceneAABBCalculatorGroupCounterBuffer 3
 
 // CBVs
 #define SceneAABBCalculatorConstantsRegister 0
 
 #ifdef HLSL
-RWStructuredBuffer<AABB> AABBBuffer : UAV_REGISTER(SceneAABBCalculatorAABBBuffer);
+// One AABB per group.  Other groups write it, so it has to bypass non-coherent caches.
+globallycoherent RWStructuredBuffer<AABB> AABBBuffer : UAV_REGISTER(SceneAABBCalculatorAABBBuffer);
 RWStructuredBuffer<AABB> OutputBuffer : UAV_REGISTER(SceneAABBCalculatorOutputBuffer);
+// Counts the groups that have written their AABB.  The last group resets it for the next dispatch.
+globallycoherent RWByteAddressBuffer GroupCounter : UAV_REGISTER(SceneAABBCalculatorGroupCounterBuffer);
 cbuffer SceneAABBCalculatorConstants : CONSTANT_REGISTER(SceneAABBCalculatorConstantsRegister)
 {
     SceneAABBCalculatorConstants Constants;
 }
 
-AABB CalculateSceneAABB(uint baseElementIndex);
+AABB GetElementAABB(uint elementIndex);
+
+groupshared float3 waveMin[THREAD_GROUP_1D_WIDTH];
+groupshared float3 waveMax[THREAD_GROUP_1D_WIDTH];
+groupshared uint isLastGroup;
+
+AABB GetEmptyAABB()
+{
+    AABB aabb;
+    aabb.min = float3(FLT_MAX, FLT_MAX, FLT_MAX);
+    aabb.max = float3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+    return aabb;
+}
+
+// Must be called by the whole group. The result is only valid on the first thread.
+AABB GroupCombineAABBs(AABB aabb, uint groupIndex)
+{
+    const uint laneCount = WaveGetLaneCount();
+    aabb.min = WaveActiveMin(aabb.min);
+    aabb.max = WaveActiveMax(aabb.max);
+
+    GroupMemoryBarrierWithGroupSync();
+    if (WaveIsFirstLane())
+    {
+        waveMin[groupIndex / laneCount] = aabb.min;
+        waveMax[groupIndex / laneCount] = aabb.max;
+    }
+    GroupMemoryBarrierWithGroupSync();
 
+    if (groupIndex == 0)
+    {
+        const uint numberOfWaves = (THREAD_GROUP_1D_WIDTH + laneCount - 1) / laneCount;
+        for (uint i = 1; i < numberOfWaves; i++)
+        {
+            aabb.min = min(aabb.min, waveMin[i]);
+            aabb.max = max(aabb.max, waveMax[i]);
+        }
+    }
+    return aabb;
+}
+
+// Each group combines its elements into one AABB and the last group to finish combines those, so the
+// whole reduction takes a single dispatch
 [numthreads(THREAD_GROUP_1D_WIDTH, 1, 1)]
-void main(uint3 DTid : SV_DispatchThreadID)
+void main(uint3 Gid : SV_GroupID, uint GI : SV_GroupIndex)
 {
-    uint outputAABBIndex = DTid.x;
-    uint BaseElementIndex = DTid.x * ElementsSummedPerThread;
-    if (BaseElementIndex >= Constants.NumberOfElements) return;
+    const uint numberOfGroups = (Constants.NumberOfElements + ElementsSummedPerGroup - 1) / ElementsSummedPerGroup;
+
+    // Neighboring threads read neighboring elements
+    AABB threadAABB = GetEmptyAABB();
+    for (uint i = 0; i < ElementsSummedPerThread; i++)
+    {
+        uint elementIndex = Gid.x * ElementsSummedPerGroup + i * THREAD_GROUP_1D_WIDTH + GI;
+        if (elementIndex < Constants.NumberOfElements)
+        {
+            AABB aabb = GetElementAABB(elementIndex);
+            threadAABB.min = min(threadAABB.min, aabb.min);
+            threadAABB.max = max(threadAABB.max, aabb.max);
+        }
+    }
+
+    AABB groupAABB = GroupCombineAABBs(threadAABB, GI);
+    if (numberOfGroups == 1)
+    {
+        if (GI == 0)
+        {
+            OutputBuffer[0] = groupAABB;
+        }
+        return;
+    }
+
+    if (GI == 0)
+    {
+        AABBBuffer[Gid.x] = groupAABB;
+        DeviceMemoryBarrier();
+
+        uint finishedGroups;
+        GroupCounter.InterlockedAdd(0, 1, finishedGroups);
+        isLastGroup = (finishedGroups == numberOfGroups - 1) ? 1 : 0;
+        if (isLastGroup)
+        {
+            GroupCounter.Store(0, 0);
+        }
+    }
+    GroupMemoryBarrierWithGroupSync();
+
+    if (isLastGroup == 0) return;
+
+    AABB sceneAABB = GetEmptyAABB();
+    for (uint groupIndex = GI; groupIndex < numberOfGroups; groupIndex += THREAD_GROUP_1D_WIDTH)
+    {
+        AABB aabb = AABBBuffer[groupIndex];
+        sceneAABB.min = min(sceneAABB.min, aabb.min);
+        sceneAABB.max = max(sceneAABB.max, aabb.max);
+    }
 
-    OutputBuffer[outputAABBIndex] = CalculateSceneAABB(BaseElementIndex);
+    sceneAABB = GroupCombineAABBs(sceneAABB, GI);
+    if (GI == 0)
+    {
+        OutputBuffer[0] = sceneAABB;
+    }
 }
 #endif
@@ -22,18 +22,7 @@ AABB ReadBottomLevelAABB(uint bottomLevelIndex)
     return RawDataToAABB(dataA, dataB);
 }
 
-AABB CalculateSceneAABB(uint baseElementIndex)
+AABB GetElementAABB(uint elementIndex)
 {
-    uint aabbsToRead = min(Constants.NumberOfElements - baseElementIndex, ElementsSummedPerThread);
-
-    AABB sceneAABB;
-    sceneAABB.min = float3(FLT_MAX, FLT_MAX, FLT_MAX);
-    sceneAABB.max = float3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
-    for (uint i = 0; i < aabbsToRead; i++)
-    {
-        AABB aabb = ReadBottomLevelAABB(baseElementIndex + i);
-        sceneAABB.min = min(aabb.min, sceneAABB.min);
-        sceneAABB.max = max(aabb.max, sceneAABB.max);
-    }
-    return sceneAABB;
+    return ReadBottomLevelAABB(elementIndex);
 }
@@ -13,28 +13,19 @@
 #include "RayTracingHelper.hlsli"
 
 RWStructuredBuffer<Primitive> InputBuffer : UAV_REGISTER(SceneAABBCalculatorInputBufferRegister);
-AABB CalculateSceneAABB(uint baseElementIndex)
+AABB GetElementAABB(uint elementIndex)
 {
-    uint primitivesToRead = min(Constants.NumberOfElements - baseElementIndex, ElementsSummedPerThread);
-
-    AABB sceneAABB;
-    sceneAABB.min = float3(FLT_MAX, FLT_MAX, FLT_MAX);
-    sceneAABB.max = float3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
-    for (uint i = 0; i < primitivesToRead; i++)
+    Primitive primitive = InputBuffer[elementIndex];
+    if (primitive.PrimitiveType == TRIANGLE_TYPE)
+    {
+        Triangle tri = GetTriangle(primitive);
+        AABB aabb;
+        aabb.min = min(min(tri.v0, tri.v1), tri.v2);
+        aabb.max = max(max(tri.v0, tri.v1), tri.v2);
+        return aabb;
+    }
+    else // if(primitive.PrimitiveType == PROCEDURAL_PRIMITIVE_TYPE)
     {
-        Primitive primitive = InputBuffer[baseElementIndex + i];
-        if (primitive.PrimitiveType == TRIANGLE_TYPE)
-        {
-            Triangle tri = GetTriangle(primitive);
-            sceneAABB.min = min(min(min(tri.v0, sceneAABB.min), tri.v1), tri.v2);
-            sceneAABB.max = max(max(max(tri.v0, sceneAABB.max), tri.v1), tri.v2);
-        }
-        else // if(primitive.PrimitiveType == PROCEDURAL_PRIMITIVE_TYPE)
-        {
-            AABB aabb = GetProceduralPrimitiveAABB(primitive);
-            sceneAABB.min = min(sceneAABB.min, aabb.min);
-            sceneAABB.max = max(sceneAABB.max, aabb.max);
-        }
+        return GetProceduralPrimitiveAABB(primitive);
     }
-    return sceneAABB;
 }
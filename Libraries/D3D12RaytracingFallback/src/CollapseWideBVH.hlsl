@@ -0,0 +1,130 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+#define HLSL
+#include "CollapseWideBVHBindings.h"
+#include "RayTracingHelper.hlsli"
+
+static uint children[WIDE_BVH_WIDTH];
+static AABB childAABBs[WIDE_BVH_WIDTH];
+
+AABB ReadNodeAABB(uint nodeIndex, out uint2 flags)
+{
+    const uint boxAddress = GetBoxAddress(SizeOfBVHOffsets, nodeIndex);
+    BoundingBox box = RawDataToBoundingBox(outputBVH.Load4(boxAddress), outputBVH.Load4(boxAddress + 16), flags);
+
+    AABB aabb;
+    aabb.min = box.center - box.halfDim;
+    aabb.max = box.center + box.halfDim;
+    return aabb;
+}
+
+void AppendChild(uint nodeIndex, uint2 flags, AABB aabb, inout uint numChildren)
+{
+    children[numChildren] = nodeIndex | (IsLeaf(flags) ? WideBVHChildIsLeafFlag : 0);
+    childAABBs[numChildren] = aabb;
+    numChildren++;
+}
+
+// A BVH2 child that is an internal node gets replaced by its own two children
+void AppendChildOrGrandchildren(uint nodeIndex, inout uint numChildren)
+{
+    uint2 flags;
+    AABB aabb = ReadNodeAABB(nodeIndex, flags);
+    if (IsLeaf(flags))
+    {
+        AppendChild(nodeIndex, flags, aabb, numChildren);
+    }
+    else
+    {
+        uint2 leftFlags, rightFlags;
+        const uint leftNodeIndex = GetLeftNodeIndex(flags);
+        const uint rightNodeIndex = GetRightNodeIndex(flags);
+        AABB leftAABB = ReadNodeAABB(leftNodeIndex, leftFlags);
+        AABB rightAABB = ReadNodeAABB(rightNodeIndex, rightFlags);
+        AppendChild(leftNodeIndex, leftFlags, leftAABB, numChildren);
+        AppendChild(rightNodeIndex, rightFlags, rightAABB, numChildren);
+    }
+}
+
+// One thread per BVH2 internal node writes the wide node with the same index. Only
+// the nodes at even depths are reachable from the root, the rest are never read.
+[numthreads(THREAD_GROUP_1D_WIDTH, 1, 1)]
+void main(uint3 DTid : SV_DispatchThreadID)
+{
+    const uint nodeIndex = DTid.x;
+    if (nodeIndex >= GetNumInternalNodes(Constants.NumberOfElements))
+    {
+        return;
+    }
+
+    [unroll]
+    for (uint i = 0; i < WIDE_BVH_WIDTH; i++)
+    {
+        children[i] = InvalidWideBVHChild;
+    }
+
+    uint2 flags;
+    const AABB nodeAABB = ReadNodeAABB(nodeIndex, flags);
+    uint numChildren = 0;
+    if (IsLeaf(flags))
+    {
+        // Internal nodes can be collapsed into leaves by treelet reordering
+        AppendChild(nodeIndex, flags, nodeAABB, numChildren);
+    }
+    else
+    {
+        AppendChildOrGrandchildren(GetLeftNodeIndex(flags), numChildren);
+        AppendChildOrGrandchildren(GetRightNodeIndex(flags), numChildren);
+    }
+
+    // Use the smallest power of two step per axis that covers the node in 255 steps,
+    // bumping it up if log2 rounded down
+    const float3 origin = nodeAABB.min;
+    const float3 extent = nodeAABB.max - nodeAABB.min;
+    int3 exponents = int3(ceil(log2(max(extent / 255.0, 1e-30))));
+    exponents += int3(exp2(float3(exponents)) * 255.0 < extent);
+    exponents = clamp(exponents, -126, 127);
+
+    const uint3 biasedExponents = uint3(exponents + 127);
+    const float3 scale = asfloat(biasedExponents << 23);
+
+    uint3 quantizedMin = 0;
+    uint3 quantizedMax = 0;
+    [unroll]
+    for (uint j = 0; j < WIDE_BVH_WIDTH; j++)
+    {
+        if (children[j] == InvalidWideBVHChild)
+        {
+            continue;
+        }
+
+        uint3 childMin = uint3(clamp(floor((childAABBs[j].min - origin) / scale), 0, 255));
+        uint3 childMax = uint3(clamp(ceil((childAABBs[j].max - origin) / scale), 0, 255));
+
+        // Rounding in the subtraction can leave the decoded bounds just inside the
+        // real ones, step out by one so the quantized box stays conservative
+        childMin -= uint3(origin + float3(childMin) * scale > childAABBs[j].min) * uint3(childMin > 0);
+        childMax += uint3(origin + float3(childMax) * scale < childAABBs[j].max) * uint3(childMax < 255);
+
+        const uint shift = j * 8;
+        quantizedMin |= childMin << shift;
+        quantizedMax |= childMax << shift;
+    }
+
+    const uint offsetToWideBVHNodes = outputBVH.Load(OffsetToPrimitiveMetaDataOffset) + GetOffsetFromPrimitiveMetaDataToWideBVHNodes(Constants.NumberOfElements);
+    const uint nodeAddress = offsetToWideBVHNodes + nodeIndex * SizeOfWideBVHNode;
+    const uint packedExponents = biasedExponents.x | (biasedExponents.y << 8) | (biasedExponents.z << 16);
+
+    outputBVH.Store4(nodeAddress, uint4(asuint(origin), packedExponents));
+    outputBVH.Store4(nodeAddress + OffsetToWideBVHChildren, uint4(children[0], children[1], children[2], children[3]));
+    outputBVH.Store4(nodeAddress + OffsetToWideBVHQuantizedBounds, uint4(quantizedMin, quantizedMax.x));
+    outputBVH.Store4(nodeAddress + OffsetToWideBVHQuantizedBounds + 16, uint4(quantizedMax.yz, 0, 0));
+}
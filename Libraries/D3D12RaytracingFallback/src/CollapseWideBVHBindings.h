@@ -0,0 +1,35 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+#pragma once
+#include "RaytracingHlslCompat.h"
+#ifdef HLSL
+#include "ShaderUtil.hlsli"
+#endif
+
+struct CollapseWideBVHConstants
+{
+    uint NumberOfElements;
+};
+
+// UAVs
+#define OutputBVHRegister 0
+
+// CBVs
+#define CollapseWideBVHConstantsRegister 0
+
+#ifdef HLSL
+RWByteAddressBuffer outputBVH : UAV_REGISTER(OutputBVHRegister);
+
+cbuffer CollapseWideBVHConstants : CONSTANT_REGISTER(CollapseWideBVHConstantsRegister)
+{
+    CollapseWideBVHConstants Constants;
+};
+#endif
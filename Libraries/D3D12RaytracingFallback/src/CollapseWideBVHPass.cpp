@@ -0,0 +1,51 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+#include "pch.h"
+#include "CollapseWideBVHBindings.h"
+#include "CompiledShaders/CollapseWideBVH.h"
+
+namespace FallbackLayer
+{
+    CollapseWideBVHPass::CollapseWideBVHPass(ID3D12Device *pDevice, UINT nodeMask)
+    {
+        CD3DX12_ROOT_PARAMETER1 rootParameters[NumRootParameters];
+        rootParameters[OutputBVHRootUAVParam].InitAsUnorderedAccessView(OutputBVHRegister);
+        rootParameters[InputRootConstants].InitAsConstants(SizeOfInUint32(CollapseWideBVHConstants), CollapseWideBVHConstantsRegister);
+
+        auto rootSignatureDesc = CD3DX12_VERSIONED_ROOT_SIGNATURE_DESC(ARRAYSIZE(rootParameters), rootParameters);
+        CreateRootSignatureHelper(pDevice, rootSignatureDesc, &m_pRootSignature);
+
+        CreatePSOHelper(pDevice, nodeMask, m_pRootSignature, COMPILED_SHADER(g_pCollapseWideBVH), &m_pCollapseWideBVH);
+    }
+
+    void CollapseWideBVHPass::CollapseWideBVH(ID3D12GraphicsCommandList *pCommandList,
+        D3D12_GPU_VIRTUAL_ADDRESS outputVH,
+        UINT numElements)
+    {
+        // A single leaf has no internal nodes to collapse, traversal falls back to the BVH2
+        if (numElements < 2) return;
+
+        CollapseWideBVHConstants constants = {};
+        constants.NumberOfElements = numElements;
+
+        pCommandList->SetComputeRootSignature(m_pRootSignature);
+        pCommandList->SetComputeRoot32BitConstants(InputRootConstants, SizeOfInUint32(CollapseWideBVHConstants), &constants, 0);
+        pCommandList->SetComputeRootUnorderedAccessView(OutputBVHRootUAVParam, outputVH);
+        pCommandList->SetPipelineState(m_pCollapseWideBVH);
+
+        const UINT dispatchWidth = DivideAndRoundUp<UINT>(GetNumInternalNodes(numElements), THREAD_GROUP_1D_WIDTH);
+        pCommandList->Dispatch(dispatchWidth, 1, 1);
+
+        // Only given the GPU VA not the resource itself so need to resort to doing an overarching UAV barrier
+        auto uavBarrier = CD3DX12_RESOURCE_BARRIER::UAV(nullptr);
+        pCommandList->ResourceBarrier(1, &uavBarrier);
+    }
+}
@@ -0,0 +1,35 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+#pragma once
+namespace FallbackLayer
+{
+    // Collapses a bottom-level BVH2 into 4-wide nodes with quantized child bounds.
+    // Must run after the AABBs of the BVH2 have been constructed.
+    class CollapseWideBVHPass
+    {
+    public:
+        CollapseWideBVHPass(ID3D12Device *pDevice, UINT nodeMask);
+
+        void CollapseWideBVH(ID3D12GraphicsCommandList *pCommandList,
+            D3D12_GPU_VIRTUAL_ADDRESS outputVH,
+            UINT numElements);
+    private:
+        enum RootParameterSlot
+        {
+            OutputBVHRootUAVParam = 0,
+            InputRootConstants,
+            NumRootParameters,
+        };
+
+        CComPtr<ID3D12RootSignature> m_pRootSignature;
+        CComPtr<ID3D12PipelineState> m_pCollapseWideBVH;
+    };
+}
@@ -0,0 +1,66 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+#define HLSL
+#include "CompressTrianglesBindings.h"
+#include "RayTracingHelper.hlsli"
+
+// Runs right after the triangles are rearranged into the output. Each triangle is quantized into
+// the staging buffer along with a copy of its metadata, and its vertices in the output are snapped to the decoded positions so that
+// treelet reordering and the AABB construction fit the triangles that traversal will test.
+[numthreads(THREAD_GROUP_1D_WIDTH, 1, 1)]
+void main(uint3 DTid : SV_DispatchThreadID)
+{
+    const uint primitiveIndex = DTid.x;
+    if (primitiveIndex >= Constants.NumberOfElements)
+    {
+        return;
+    }
+
+    // Quantizing every vertex to the same grid keeps shared edges watertight
+    const AABB sceneAABB = SceneAABB[0];
+    const float3 origin = sceneAABB.min;
+    const float3 step = (sceneAABB.max - sceneAABB.min) / CompressedTriangleGridSteps;
+    if (primitiveIndex == 0)
+    {
+        compressedTriangles.Store4(0, uint4(COMPRESSED_TRIANGLES_TYPE, asuint(origin)));
+        compressedTriangles.Store4(OffsetToCompressedTriangleGridStep, uint4(asuint(step), 0));
+    }
+
+    const uint offsetToPrimitive = GetOffsetToPrimitives(Constants.NumberOfElements) + primitiveIndex * SizeOfPrimitive + OffsetToPrimitiveData;
+    Triangle tri = RawDataToTriangle(
+        outputBVH.Load4(offsetToPrimitive),
+        outputBVH.Load4(offsetToPrimitive + 16),
+        outputBVH.Load(offsetToPrimitive + 32));
+
+    const uint2 v0 = EncodeCompressedVertex(tri.v0, origin, step);
+    const uint2 v1 = EncodeCompressedVertex(tri.v1, origin, step);
+    const uint2 v2 = EncodeCompressedVertex(tri.v2, origin, step);
+
+    const uint triangleOffset = SizeOfCompressedTriangleGrid + primitiveIndex * SizeOfCompressedTriangle;
+    compressedTriangles.Store4(triangleOffset, uint4(v0, v1));
+    compressedTriangles.Store2(triangleOffset + 16, v2);
+
+    const uint offsetToPrimitiveMetaData = GetOffsetToPrimitives(Constants.NumberOfElements) + GetOffsetFromPrimitivesToPrimitiveMetaData(Constants.NumberOfElements);
+    const uint metadataOffset = primitiveIndex * SizeOfPrimitiveMetaData;
+    compressedTriangles.Store3(GetOffsetFromCompressedPrimitivesToPrimitiveMetaData(Constants.NumberOfElements) + metadataOffset,
+        outputBVH.Load3(offsetToPrimitiveMetaData + metadataOffset));
+
+    tri.v0 = DecodeCompressedVertex(v0, origin, step);
+    tri.v1 = DecodeCompressedVertex(v1, origin, step);
+    tri.v2 = DecodeCompressedVertex(v2, origin, step);
+
+    uint4 a, b;
+    uint c;
+    TriangleToRawData(tri, a, b, c);
+    outputBVH.Store4(offsetToPrimitive, a);
+    outputBVH.Store4(offsetToPrimitive + 16, b);
+    outputBVH.Store(offsetToPrimitive + 32, c);
+}
@@ -0,0 +1,39 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+#pragma once
+#include "RaytracingHlslCompat.h"
+#ifdef HLSL
+#include "ShaderUtil.hlsli"
+#endif
+
+struct CompressTrianglesConstants
+{
+    uint NumberOfElements;
+};
+
+// UAVs
+#define OutputBVHRegister 0
+#define SceneAABBRegister 1
+#define CompressedTrianglesRegister 2
+
+// CBVs
+#define CompressTrianglesConstantsRegister 0
+
+#ifdef HLSL
+RWByteAddressBuffer outputBVH : UAV_REGISTER(OutputBVHRegister);
+RWStructuredBuffer<AABB> SceneAABB : UAV_REGISTER(SceneAABBRegister);
+RWByteAddressBuffer compressedTriangles : UAV_REGISTER(CompressedTrianglesRegister);
+
+cbuffer CompressTrianglesConstants : CONSTANT_REGISTER(CompressTrianglesConstantsRegister)
+{
+    CompressTrianglesConstants Constants;
+};
+#endif
@@ -0,0 +1,82 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+#include "pch.h"
+#include "CompressTrianglesBindings.h"
+#include "CompiledShaders/CompressTriangles.h"
+#include "CompiledShaders/StoreCompressedTriangles.h"
+
+namespace FallbackLayer
+{
+    CompressTrianglesPass::CompressTrianglesPass(ID3D12Device *pDevice, UINT nodeMask)
+    {
+        CD3DX12_ROOT_PARAMETER1 rootParameters[NumRootParameters];
+        rootParameters[OutputBVHRootUAVParam].InitAsUnorderedAccessView(OutputBVHRegister);
+        rootParameters[SceneAABBRootUAVParam].InitAsUnorderedAccessView(SceneAABBRegister);
+        rootParameters[CompressedTrianglesRootUAVParam].InitAsUnorderedAccessView(CompressedTrianglesRegister);
+        rootParameters[InputRootConstants].InitAsConstants(SizeOfInUint32(CompressTrianglesConstants), CompressTrianglesConstantsRegister);
+
+        auto rootSignatureDesc = CD3DX12_VERSIONED_ROOT_SIGNATURE_DESC(ARRAYSIZE(rootParameters), rootParameters);
+        CreateRootSignatureHelper(pDevice, rootSignatureDesc, &m_pRootSignature);
+
+        CreatePSOHelper(pDevice, nodeMask, m_pRootSignature, COMPILED_SHADER(g_pCompressTriangles), &m_pCompressTriangles);
+        CreatePSOHelper(pDevice, nodeMask, m_pRootSignature, COMPILED_SHADER(g_pStoreCompressedTriangles), &m_pStoreCompressedTriangles);
+    }
+
+    UINT64 CompressTrianglesPass::RequiredSizeForCompressedTrianglesBuffer(UINT numElements)
+    {
+        return GetOffsetFromCompressedPrimitivesToPrimitiveMetaData(numElements) + numElements * sizeof(PrimitiveMetaData);
+    }
+
+    void CompressTrianglesPass::CompressTriangles(ID3D12GraphicsCommandList *pCommandList,
+        D3D12_GPU_VIRTUAL_ADDRESS outputBVH,
+        D3D12_GPU_VIRTUAL_ADDRESS sceneAABB,
+        D3D12_GPU_VIRTUAL_ADDRESS compressedTrianglesBuffer,
+        UINT numElements)
+    {
+        Dispatch(pCommandList, m_pCompressTriangles, outputBVH, sceneAABB, compressedTrianglesBuffer, numElements);
+    }
+
+    void CompressTrianglesPass::StoreCompressedTriangles(ID3D12GraphicsCommandList *pCommandList,
+        D3D12_GPU_VIRTUAL_ADDRESS outputBVH,
+        D3D12_GPU_VIRTUAL_ADDRESS compressedTrianglesBuffer,
+        UINT numElements)
+    {
+        // The scene AABB is baked into the staged grid and isn't read again
+        Dispatch(pCommandList, m_pStoreCompressedTriangles, outputBVH, compressedTrianglesBuffer, compressedTrianglesBuffer, numElements);
+    }
+
+    void CompressTrianglesPass::Dispatch(ID3D12GraphicsCommandList *pCommandList,
+        ID3D12PipelineState *pPSO,
+        D3D12_GPU_VIRTUAL_ADDRESS outputBVH,
+        D3D12_GPU_VIRTUAL_ADDRESS sceneAABB,
+        D3D12_GPU_VIRTUAL_ADDRESS compressedTrianglesBuffer,
+        UINT numElements)
+    {
+        if (numElements == 0) return;
+
+        CompressTrianglesConstants constants = {};
+        constants.NumberOfElements = numElements;
+
+        pCommandList->SetComputeRootSignature(m_pRootSignature);
+        pCommandList->SetComputeRoot32BitConstants(InputRootConstants, SizeOfInUint32(CompressTrianglesConstants), &constants, 0);
+        pCommandList->SetComputeRootUnorderedAccessView(OutputBVHRootUAVParam, outputBVH);
+        pCommandList->SetComputeRootUnorderedAccessView(SceneAABBRootUAVParam, sceneAABB);
+        pCommandList->SetComputeRootUnorderedAccessView(CompressedTrianglesRootUAVParam, compressedTrianglesBuffer);
+        pCommandList->SetPipelineState(pPSO);
+
+        const UINT dispatchWidth = DivideAndRoundUp<UINT>(numElements, THREAD_GROUP_1D_WIDTH);
+        pCommandList->Dispatch(dispatchWidth, 1, 1);
+
+        // Only given the GPU VA not the resource itself so need to resort to doing an overarching UAV barrier
+        auto uavBarrier = CD3DX12_RESOURCE_BARRIER::UAV(nullptr);
+        pCommandList->ResourceBarrier(1, &uavBarrier);
+    }
+}
@@ -0,0 +1,55 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+#pragma once
+namespace FallbackLayer
+{
+    // Replaces the full precision triangles of a bottom-level BVH with vertices quantized to a
+    // grid spanning the scene AABB. CompressTriangles must run right after the triangles are
+    // rearranged into the output, StoreCompressedTriangles once the AABBs have been constructed.
+    class CompressTrianglesPass
+    {
+    public:
+        CompressTrianglesPass(ID3D12Device *pDevice, UINT nodeMask);
+
+        void CompressTriangles(ID3D12GraphicsCommandList *pCommandList,
+            D3D12_GPU_VIRTUAL_ADDRESS outputBVH,
+            D3D12_GPU_VIRTUAL_ADDRESS sceneAABB,
+            D3D12_GPU_VIRTUAL_ADDRESS compressedTrianglesBuffer,
+            UINT numElements);
+
+        void StoreCompressedTriangles(ID3D12GraphicsCommandList *pCommandList,
+            D3D12_GPU_VIRTUAL_ADDRESS outputBVH,
+            D3D12_GPU_VIRTUAL_ADDRESS compressedTrianglesBuffer,
+            UINT numElements);
+
+        static UINT64 RequiredSizeForCompressedTrianglesBuffer(UINT numElements);
+    private:
+        void Dispatch(ID3D12GraphicsCommandList *pCommandList,
+            ID3D12PipelineState *pPSO,
+            D3D12_GPU_VIRTUAL_ADDRESS outputBVH,
+            D3D12_GPU_VIRTUAL_ADDRESS sceneAABB,
+            D3D12_GPU_VIRTUAL_ADDRESS compressedTrianglesBuffer,
+            UINT numElements);
+
+        enum RootParameterSlot
+        {
+            OutputBVHRootUAVParam = 0,
+            SceneAABBRootUAVParam,
+            CompressedTrianglesRootUAVParam,
+            InputRootConstants,
+            NumRootParameters,
+        };
+
+        CComPtr<ID3D12RootSignature> m_pRootSignature;
+        CComPtr<ID3D12PipelineState> m_pCompressTriangles;
+        CComPtr<ID3D12PipelineState> m_pStoreCompressedTriangles;
+    };
+}
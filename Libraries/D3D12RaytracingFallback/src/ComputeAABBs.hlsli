@@ -14,6 +14,13 @@ static const uint rootNodeIndex = 0;
 static const int offsetToBoxes = SizeOfBVHOffsets;
 static const int MaxLeavesPerNode = 4;
 
+// During incremental updates, the counter of an internal node holds a bit for each of its children
+// that was modified, and above them the number of modified children that have been refit so far
+static const uint ModifiedLeftChildBit = 0x1;
+static const uint ModifiedRightChildBit = 0x2;
+static const uint ModifiedChildrenMask = ModifiedLeftChildBit | ModifiedRightChildBit;
+static const uint RefitChildIncrement = 0x4;
+
 uint GetLeafCount(uint boxIndex)
 {
     uint nodeAddress = GetBoxAddress(offsetToBoxes, boxIndex);
@@ -66,6 +73,49 @@ uint GetParentIndex(uint boxIndex)
     return GetActualParentIndex(hierarchyBuffer[boxIndex].ParentIndex);
 }
 
+#ifdef MARK_MODIFIED_LEAVES
+// Runs between preparing and computing the AABBs of an incremental update.  Leaves whose box didn't
+// change are dropped from the list of nodes to start refitting from, and every other leaf marks the
+// path to the root.  Subtrees without a modified leaf then keep their boxes and are never visited.
+[numthreads(THREAD_GROUP_1D_WIDTH, 1, 1)]
+void main(uint3 DTid : SV_DispatchThreadID)
+{
+    uint NumberOfInternalNodes = GetNumInternalNodes(Constants.NumberOfElements);
+    if (DTid.x >= Constants.NumberOfElements)
+    {
+        return;
+    }
+
+    uint threadScratchAddress = DTid.x * SizeOfUINT32;
+    uint nodeIndex = scratchMemory.Load(threadScratchAddress);
+    int offsetToPrimitives = outputBVH.Load(OffsetToPrimitivesOffset);
+
+    // The hierarchy still holds the box this leaf got from the same inputs last time
+    uint2 unusedFlags;
+    BoundingBox box = ComputeLeafAABB(nodeIndex - NumberOfInternalNodes, offsetToPrimitives, unusedFlags);
+    BoundingBox previousBox = GetBoxFromBuffer(outputBVH, offsetToBoxes, nodeIndex);
+    if (all(box.center == previousBox.center) && all(box.halfDim == previousBox.halfDim))
+    {
+        scratchMemory.Store(threadScratchAddress, InvalidNodeIndex);
+        return;
+    }
+
+    while (nodeIndex != rootNodeIndex)
+    {
+        uint parentNodeIndex = GetParentIndex(nodeIndex);
+        uint childBit = GetLeftChildIndex(parentNodeIndex) == nodeIndex ? ModifiedLeftChildBit : ModifiedRightChildBit;
+
+        // Whoever marked the parent first also marks the rest of the path
+        uint previousMarks;
+        childNodesProcessedCounter.InterlockedOr(parentNodeIndex * SizeOfUINT32, childBit, previousMarks);
+        if (previousMarks != 0)
+        {
+            break;
+        }
+        nodeIndex = parentNodeIndex;
+    }
+}
+#else
 [numthreads(THREAD_GROUP_1D_WIDTH, 1, 1)]
 void main(uint3 DTid : SV_DispatchThreadID)
 {
@@ -143,6 +193,22 @@ void main(uint3 DTid : SV_DispatchThreadID)
         }
 
         uint parentNodeIndex = GetParentIndex(nodeIndex);
+        if (ShouldUpdateIncrementally)
+        {
+            // A child that wasn't modified still has the right box, so only wait for the other
+            // child when both were. The child order is left as it is.
+            uint previousCount;
+            childNodesProcessedCounter.InterlockedAdd(parentNodeIndex * SizeOfUINT32, RefitChildIncrement, previousCount);
+            bool isOtherChildPending = (previousCount & ModifiedChildrenMask) == ModifiedChildrenMask &&
+                previousCount < RefitChildIncrement;
+            if (isOtherChildPending)
+            {
+                break;
+            }
+            nodeIndex = parentNodeIndex;
+            continue;
+        }
+
         uint trianglesFromOtherChild;
         // If this counter was already incremented, that means both children for the parent 
         // node have computed their AABB, and the parent is ready to be processed
@@ -170,3 +236,4 @@ void main(uint3 DTid : SV_DispatchThreadID)
     }
     
 }
+#endif
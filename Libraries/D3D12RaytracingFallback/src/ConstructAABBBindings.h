@@ -35,8 +35,10 @@ struct InputConstants
 
 #define PREPARE_UPDATE_FLAG 0x1
 #define PERFORM_UPDATE_FLAG 0x2
+#define INCREMENTAL_UPDATE_FLAG 0x4
 #define ShouldPrepareUpdate Constants.UpdateFlags & PREPARE_UPDATE_FLAG
 #define ShouldPerformUpdate Constants.UpdateFlags & PERFORM_UPDATE_FLAG
+#define ShouldUpdateIncrementally Constants.UpdateFlags & INCREMENTAL_UPDATE_FLAG
 
 #ifdef HLSL
 globallycoherent RWByteAddressBuffer outputBVH : UAV_REGISTER(OutputBVHRegister);
@@ -12,6 +12,7 @@
 #include "ConstructAABBBindings.h"
 #include "CompiledShaders/TopLevelPrepareForComputeAABBs.h"
 #include "CompiledShaders/TopLevelComputeAABBs.h"
+#include "CompiledShaders/TopLevelMarkModifiedAABBs.h"
 #include "CompiledShaders/BottomLevelComputeAABBs.h"
 #include "CompiledShaders/BottomLevelPrepareForComputeAABBs.h"
 
@@ -34,6 +35,7 @@ namespace FallbackLayer
 
         CreatePSOHelper(pDevice, nodeMask, m_pRootSignature, COMPILED_SHADER(g_pTopLevelComputeAABBs), &m_pComputeAABBs[Level::Top]);
         CreatePSOHelper(pDevice, nodeMask, m_pRootSignature, COMPILED_SHADER(g_pTopLevelPrepareForComputeAABBs), &m_pPrepareForComputeAABBs[Level::Top]);
+        CreatePSOHelper(pDevice, nodeMask, m_pRootSignature, COMPILED_SHADER(g_pTopLevelMarkModifiedAABBs), &m_pMarkModifiedTopLevelAABBs);
 
         CreatePSOHelper(pDevice, nodeMask, m_pRootSignature, COMPILED_SHADER(g_pBottomLevelComputeAABBs), &m_pComputeAABBs[Level::Bottom]);
         CreatePSOHelper(pDevice, nodeMask, m_pRootSignature, COMPILED_SHADER(g_pBottomLevelPrepareForComputeAABBs), &m_pPrepareForComputeAABBs[Level::Bottom]);
@@ -54,9 +56,13 @@ namespace FallbackLayer
         bool isEmptyAccelerationStructure = numElements == 0;
         Level level = (sceneType == SceneType::Triangles) ? Level::Bottom : Level::Top;
 
+        // Top-level updates only refit the paths above instances whose box changed. Scenes where
+        // most instances are static then skip nearly all of the hierarchy.
+        const bool incrementalUpdate = performUpdate && level == Top;
+
         InputConstants constants = {};
         constants.NumberOfElements = numElements;
-        constants.UpdateFlags = ((UINT) prepareUpdate) | (performUpdate << 1);
+        constants.UpdateFlags = ((UINT) prepareUpdate) | (performUpdate << 1) | (incrementalUpdate << 2);
 
         pCommandList->SetComputeRootSignature(m_pRootSignature);
         pCommandList->SetComputeRoot32BitConstants(InputRootConstants, SizeOfInUint32(InputConstants), &constants, 0);
@@ -88,6 +94,13 @@ namespace FallbackLayer
 
         if (isEmptyAccelerationStructure) return;
 
+        if (incrementalUpdate)
+        {
+            pCommandList->SetPipelineState(m_pMarkModifiedTopLevelAABBs);
+            pCommandList->Dispatch(dispatchWidth, 1, 1);
+            pCommandList->ResourceBarrier(1, &uavBarrier);
+        }
+
         // Build the AABBs from the bottom-up
         pCommandList->SetPipelineState(m_pComputeAABBs[level]);
         pCommandList->Dispatch(dispatchWidth, 1, 1);
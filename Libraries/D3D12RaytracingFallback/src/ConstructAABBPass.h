@@ -50,5 +50,6 @@ namespace FallbackLayer
         CComPtr<ID3D12RootSignature> m_pRootSignature;
         CComPtr<ID3D12PipelineState> m_pPrepareForComputeAABBs[Level::NumLevels];
         CComPtr<ID3D12PipelineState> m_pComputeAABBs[Level::NumLevels];
+        CComPtr<ID3D12PipelineState> m_pMarkModifiedTopLevelAABBs;
     };
 }
@@ -17,6 +17,9 @@
 struct InputConstants
 {
     uint NumberOfElements;
+
+    // Nonzero if the sorted Morton codes are 64-bit
+    uint Use64BitMortonCodes;
 };
 
 // UAVs
@@ -30,7 +33,7 @@ struct InputConstants
 #define InputConstantsRegister 0
 
 #ifdef HLSL
-RWStructuredBuffer<uint> mortonCodes : UAV_REGISTER(MortonCodesBufferRegister);
+RWByteAddressBuffer mortonCodes : UAV_REGISTER(MortonCodesBufferRegister);
 RWStructuredBuffer<HierarchyNode> hierarchyBuffer : UAV_REGISTER(HierarchyBufferRegister);
 RWByteAddressBuffer DescriptorHeapBufferTable[] : UAV_REGISTER_SPACE(GlobalDescriptorHeapRegister, GlobalDescriptorHeapRegisterSpace);
 
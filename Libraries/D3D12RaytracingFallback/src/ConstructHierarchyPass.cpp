@@ -37,13 +37,14 @@ namespace FallbackLayer
         D3D12_GPU_VIRTUAL_ADDRESS mortonCodeBuffer,
         D3D12_GPU_VIRTUAL_ADDRESS hierarchyBuffer,
         D3D12_GPU_DESCRIPTOR_HANDLE globalDescriptorHeap,
-        UINT numElements)
+        UINT numElements,
+        bool use64BitMortonCodes)
     {
         if (numElements == 0) return;
 
         Level level = (sceneType == SceneType::Triangles) ? Level::Bottom : Level::Top;
 
-        InputConstants constants = { numElements };
+        InputConstants constants = { numElements, use64BitMortonCodes ? 1u : 0u };
 
         pCommandList->SetComputeRootSignature(m_pRootSignature);
         pCommandList->SetComputeRoot32BitConstants(InputRootConstants, SizeOfInUint32(InputConstants), &constants, 0);
@@ -21,7 +21,8 @@ namespace FallbackLayer
             D3D12_GPU_VIRTUAL_ADDRESS mortonCodeBuffer,
             D3D12_GPU_VIRTUAL_ADDRESS hierarchyBuffer,
             D3D12_GPU_DESCRIPTOR_HANDLE globalDescriptorHeap,
-            UINT numElements);
+            UINT numElements,
+            bool use64BitMortonCodes = false);
     private:
         enum RootParameterSlot
         {
@@ -9,6 +9,9 @@
 //
 //*********************************************************
 #include "pch.h"
+#include <atomic>
+#include <mutex>
+#include <thread>
 
 namespace FallbackLayer
 {
@@ -19,54 +22,12 @@ namespace FallbackLayer
         std::vector<PrimitiveMetaData> m_metadata;
     };
 
-    static
-        void AddExtentToBox(
-            AABB& box,
-            const AABB& extent)
-    {
-        box.min.x = std::min(box.min.x, extent.min.x);
-        box.max.x = std::max(box.max.x, extent.max.x);
-
-        box.min.y = std::min(box.min.y, extent.min.y);
-        box.max.y = std::max(box.max.y, extent.max.y);
-
-        box.min.z = std::min(box.min.z, extent.min.z);
-        box.max.z = std::max(box.max.z, extent.max.z);
-    }
-
     UINT UnpackTriangleIndex(
         UINT v)
     {
         return v & 0x00ffffff;
     }
 
-    static
-        void ComputeBox(
-            AABB& overallBox,
-            const std::vector<AABB>& boxes,
-            const std::vector<PrimitiveMetaData>& metadata)
-    {
-        if (metadata.empty())
-        {
-            overallBox.max.x = overallBox.min.x = 0;
-            overallBox.max.y = overallBox.min.y = 0;
-            overallBox.max.z = overallBox.min.z = 0;
-            return;
-        }
-
-        overallBox = boxes[metadata[0].PrimitiveIndex];
-
-        const UINT32 numTris = (UINT32)metadata.size();
-        for (UINT32 i = 1; i < numTris; ++i)
-        {
-            const UINT32 triId = metadata[i].PrimitiveIndex;
-            assert(triId < boxes.size());
-            const AABB& newBox = boxes[triId];
-
-            AddExtentToBox(overallBox, newBox);
-        }
-    }
-
     //
     // Convert a 16-bit float to 32-bit.
     //
@@ -116,408 +77,450 @@ namespace FallbackLayer
         return v;
     }
 
-    static
-        UINT32 BuildBVHAddNode(
-            BVH& bvh,
-            const AABB& box,
-            UINT32 maxDimension)
-    {
-        UNREFERENCED_PARAMETER(maxDimension);
-        assert(maxDimension < 3);
-        const UINT32 nodeIndex = (UINT32)bvh.m_nodes.size();
+    static const UINT NUM_SAH_BINS = 64;
 
-        float cX = (box.max.x + box.min.x) * 0.5f;
-        float cY = (box.max.y + box.min.y) * 0.5f;
-        float cZ = (box.max.z + box.min.z) * 0.5f;
-        cX = QuantizeToFp16(cX);
-        cY = QuantizeToFp16(cY);
-        cZ = QuantizeToFp16(cZ);
+    // Subtrees with fewer primitives than this are built by the thread that splits them
+    // off rather than being handed to the scheduler, since the overhead isn't worth it
+    static const UINT MIN_PRIMITIVES_PER_TASK = 4096;
 
-        float dX = max(box.max.x - cX, cX - box.min.x);
-        float dY = max(box.max.y - cY, cY - box.min.y);
-        float dZ = max(box.max.z - cZ, cZ - box.min.z);
-
-        AABBNode packedBox;
-        packedBox.center[0] = cX;
-        packedBox.center[1] = cY;
-        packedBox.center[2] = cZ;
-        packedBox.halfDim[0] = dX;
-        packedBox.halfDim[1] = dY;
-        packedBox.halfDim[2] = dZ;
-        packedBox.nodeAllBits = 0;
-
-        bvh.m_nodes.push_back(packedBox);
-
-        assert(bvh.m_nodes.size() - 1 == nodeIndex);
-
-        bvh.m_nodes[nodeIndex].internalNode.separatingAxis = 0;
+    struct SimdAABB
+    {
+        DirectX::XMVECTOR min;
+        DirectX::XMVECTOR max;
+    };
 
-        return nodeIndex;
+    static
+        void InitBoxToInverseMax(
+            SimdAABB& box)
+    {
+        box.min = DirectX::XMVectorReplicate(FLT_MAX);
+        box.max = DirectX::XMVectorReplicate(-FLT_MAX);
     }
 
     static
-        UINT32 BuildBVHAddLeaf(
-            BVH& bvh,
-            const AABB& box,
-            const std::vector<PrimitiveMetaData>& metadata)
+        void AddExtentToBox(
+            SimdAABB& box,
+            const SimdAABB& extent)
     {
-        const UINT32 nodeIndex = BuildBVHAddNode(bvh, box, 0);
-
-        bvh.m_nodes[nodeIndex].nodeAllBits = 0;
-        bvh.m_nodes[nodeIndex].leaf = true;
-
-        const UINT32 idIndex = (UINT32)bvh.m_metadata.size();
-
-        std::copy(metadata.begin(), metadata.end(), std::back_inserter(bvh.m_metadata));
-
-        assert(metadata.size() < 128);
-        assert(idIndex < (1 << 24));
-
-        bvh.m_nodes[nodeIndex].leafNode.firstTriangleId = idIndex;
-        bvh.m_nodes[nodeIndex].leafNode.numTriangleIds = (UINT32)metadata.size();
-
-        return nodeIndex;
+        box.min = DirectX::XMVectorMin(box.min, extent.min);
+        box.max = DirectX::XMVectorMax(box.max, extent.max);
     }
 
-    //
-    // Sort min to max by centroid
-    //
-
     static
-        void SortByCentroid(
-            std::vector<PrimitiveMetaData>& metadata,
-            const std::vector<AABB>& boxes,
-            UINT32 maxDimension)
+        void AddPointToBox(
+            SimdAABB& box,
+            DirectX::FXMVECTOR point)
     {
-        struct TriPosition
-        {
-            float   pos;
-            UINT32  id;
-        };
-
-        std::vector<TriPosition> sortTris(metadata.size());
-
-        for (UINT32 i = 0; i < metadata.size(); ++i)
-        {
-            const UINT32 triId = metadata[i].PrimitiveIndex;
-            const AABB& box = boxes[triId];
-
-            const float boxCenter = (box.maxArr[maxDimension] + box.minArr[maxDimension]) / 2;
-
-            sortTris[i].pos = boxCenter;
-            sortTris[i].id = metadata[i].PrimitiveIndex;
-        }
-
-        // Split the list into left and right sublists
-        std::sort(sortTris.begin(), sortTris.end(), [](auto&& a, auto&& b) -> bool { return a.pos < b.pos; });
-
-        // Update the output
-        for (UINT32 i = 0; i < metadata.size(); ++i)
-        {
-            metadata[i].PrimitiveIndex = sortTris[i].id;
-        }
+        box.min = DirectX::XMVectorMin(box.min, point);
+        box.max = DirectX::XMVectorMax(box.max, point);
     }
 
-
     static
         float ComputeBoxSurfaceArea(
-            const AABB& box)
+            const SimdAABB& box)
     {
-        const float dims[3] =
-        {
-            box.max.x - box.min.x,
-            box.max.y - box.min.y,
-            box.max.z - box.min.z
-        };
-
-        return 2 * (dims[0] * dims[1] + dims[0] * dims[2] + dims[1] * dims[2]);
+        using namespace DirectX;
+        const XMVECTOR dims = XMVectorMax(XMVectorSubtract(box.max, box.min), XMVectorZero());
+        return 2 * XMVectorGetX(XMVector3Dot(dims, XMVectorSwizzle<1, 2, 0, 3>(dims)));
     }
 
     static
-        void InitBoxToInverseMax(
-            AABB& box)
+        void WriteNodeBox(
+            AABBNode& node,
+            const SimdAABB& box)
     {
-        box.max.x = box.max.y = box.max.z = -10e10f;//FLT_MAX;
-        box.min.x = box.min.y = box.min.z = 10e10f;//FLT_MAX;
+        using namespace DirectX;
+        XMFLOAT3 boxMin, boxMax;
+        XMStoreFloat3(&boxMin, box.min);
+        XMStoreFloat3(&boxMax, box.max);
+
+        float cX = (boxMax.x + boxMin.x) * 0.5f;
+        float cY = (boxMax.y + boxMin.y) * 0.5f;
+        float cZ = (boxMax.z + boxMin.z) * 0.5f;
+        cX = QuantizeToFp16(cX);
+        cY = QuantizeToFp16(cY);
+        cZ = QuantizeToFp16(cZ);
+
+        node.center[0] = cX;
+        node.center[1] = cY;
+        node.center[2] = cZ;
+        node.halfDim[0] = std::max(boxMax.x - cX, cX - boxMin.x);
+        node.halfDim[1] = std::max(boxMax.y - cY, cY - boxMin.y);
+        node.halfDim[2] = std::max(boxMax.z - cZ, cZ - boxMin.z);
+        node.nodeAllBits = 0;
     }
 
     //
-    // A feeble attempt at a SAH builder
+    // Binned SAH builder that splits the work over subtrees across threads.
     //
-
-    static
-        void SahSplit(
-            std::vector<PrimitiveMetaData>& metadata,
-            UINT32& maxDimension,
-            UINT32& numTrisInLeftNode,
-            const AABB& nodeBox,
-            const std::vector<AABB>& boxes)
+    // "Uniform BVH"
+    // -- both children are valid for all internal nodes
+    // -- the left child's index is +1 of the parent index, the right child's index is
+    //    stored in the packed AABB structure. A subtree with N leaves always takes up
+    //    2N - 1 nodes, so every subtree knows where its nodes go before it is built,
+    //    which keeps the output identical regardless of the number of threads.
+    // -- primitives are partitioned in place, so a leaf simply references its range
+    //
+    class BinnedSahBuilder
     {
-        static const UINT NUM_SAH_BINS = 64;
-
-        struct SahBin
+    public:
+        BinnedSahBuilder(
+            BVH& bvh,
+            const std::vector<AABB>& boxes,
+            UINT32 maxTrisInLeaf) :
+            m_bvh(bvh),
+            m_maxTrisInLeaf(maxTrisInLeaf),
+            m_numWorkers(1),
+            m_outstandingTasks(0)
         {
-            AABB    box;
-            UINT    numTriangles;
-        };
-
-        // NOTE: use vector if this blows out the stack?
-        SahBin  sahBins[3][NUM_SAH_BINS];
-
-        // For the score to be meaningful it seems we need to normalize it to something
-        const float normalizeToParent = 1.f / ComputeBoxSurfaceArea(nodeBox);
-
-        const UINT numTris = (UINT)metadata.size();
-
-        float bestSah = FLT_MAX;
-        maxDimension = 0;
-        //numTrisInLeftNode = triangleIds.size() / 2;
+            using namespace DirectX;
+            m_boxes.resize(boxes.size());
+            m_centroids.resize(boxes.size());
+            for (size_t i = 0; i < boxes.size(); ++i)
+            {
+                m_boxes[i].min = XMLoadFloat3(&boxes[i].min);
+                m_boxes[i].max = XMLoadFloat3(&boxes[i].max);
+                m_centroids[i] = XMVectorScale(XMVectorAdd(m_boxes[i].min, m_boxes[i].max), 0.5f);
+            }
+        }
 
-        // Compute SAH score per axis
-        for (UINT i = 0; i < 3; ++i)
+        void Build(UINT numThreads)
         {
-            const float extents = nodeBox.maxArr[i] - nodeBox.minArr[i];
-            if (extents == 0)
-                continue;
+            const UINT numPrimitives = (UINT)m_bvh.m_metadata.size();
 
-            const float rangeMin = nodeBox.minArr[i];
+            BuildTask rootTask;
+            rootTask.begin = 0;
+            rootTask.end = numPrimitives;
+            rootTask.nodeIndex = 0;
+            ComputeBounds(0, numPrimitives, rootTask.bounds);
 
-            const float inverseExtents = 1.f / extents;
-
-            // Init boxes
-            for (UINT j = 0; j < NUM_SAH_BINS; ++j)
+            m_bvh.m_nodes.resize(numPrimitives ? 2 * numPrimitives - 1 : 1);
+            if (numPrimitives == 0)
             {
-                sahBins[i][j].numTriangles = 0;
-                InitBoxToInverseMax(sahBins[i][j].box);
+                // Empty acceleration structures get a single empty leaf with a zero-sized box
+                rootTask.bounds.min = rootTask.bounds.max = DirectX::XMVectorZero();
+                WriteLeaf(rootTask);
+                return;
             }
 
-            // Place triangles into the buckets
-            for (UINT j = 0; j < metadata.size(); ++j)
-            {
-                const UINT triId = metadata[j].PrimitiveIndex;
-
-                const AABB& triBox = boxes[triId];
+            const UINT maxUsefulThreads = std::max(1u, numPrimitives / MIN_PRIMITIVES_PER_TASK);
+            m_numWorkers = std::max(1u, std::min(numThreads, maxUsefulThreads));
+            m_pWorkerQueues = std::unique_ptr<WorkerQueue[]>(new WorkerQueue[m_numWorkers]);
 
-                const float centroid = (triBox.maxArr[i] + triBox.minArr[i]) * 0.5f;
+            PushTask(0, rootTask);
 
-                const UINT binIndex = std::min(NUM_SAH_BINS - 1,
-                    UINT(NUM_SAH_BINS * ((centroid - rangeMin) * inverseExtents)));
-
-                sahBins[i][binIndex].numTriangles++;
-                AddExtentToBox(sahBins[i][binIndex].box, triBox);
+            std::vector<std::thread> workers;
+            for (UINT i = 1; i < m_numWorkers; ++i)
+            {
+                workers.push_back(std::thread(&BinnedSahBuilder::WorkerLoop, this, i));
             }
+            WorkerLoop(0);
 
-            // Make sure we caught all of them once
-            UINT testTris = 0;
-            for (UINT j = 0; j < NUM_SAH_BINS; ++j)
+            for (auto& worker : workers)
             {
-                testTris += sahBins[i][j].numTriangles;
+                worker.join();
             }
-            assert(testTris == numTris);
+        }
+
+    private:
+        struct BuildTask
+        {
+            SimdAABB    bounds;
+            UINT32      begin;
+            UINT32      end;
+            UINT32      nodeIndex;
+        };
 
-            // Precompute left and right boxes with counts to be able to test plane positionings
+        struct WorkerQueue
+        {
+            std::mutex              lock;
+            std::deque<BuildTask>   tasks;
+        };
 
-            AABB leftBoxes[NUM_SAH_BINS];
-            AABB rightBoxes[NUM_SAH_BINS];
+        struct SahBin
+        {
+            SimdAABB    box;
+            UINT        numTriangles;
+        };
 
-            for (UINT j = 0; j < NUM_SAH_BINS; ++j)
+        void PushTask(UINT workerIndex, const BuildTask& task)
+        {
+            m_outstandingTasks++;
+            WorkerQueue& queue = m_pWorkerQueues[workerIndex];
+            std::lock_guard<std::mutex> guard(queue.lock);
+            queue.tasks.push_back(task);
+        }
+
+        // Workers take the most recently added task of their own queue, which keeps the
+        // subtree they just split hot in cache, and steal the oldest (largest) task of others
+        bool TryGetTask(UINT workerIndex, BuildTask& task)
+        {
+            for (UINT i = 0; i < m_numWorkers; ++i)
             {
-                const UINT rightIdx = NUM_SAH_BINS - j - 1;
+                const UINT queueIndex = (workerIndex + i) % m_numWorkers;
+                WorkerQueue& queue = m_pWorkerQueues[queueIndex];
+                std::lock_guard<std::mutex> guard(queue.lock);
+                if (queue.tasks.empty())
+                {
+                    continue;
+                }
 
-                rightBoxes[rightIdx] = sahBins[i][rightIdx].box;
-                leftBoxes[j] = sahBins[i][j].box;
+                if (queueIndex == workerIndex)
+                {
+                    task = queue.tasks.back();
+                    queue.tasks.pop_back();
+                }
+                else
+                {
+                    task = queue.tasks.front();
+                    queue.tasks.pop_front();
+                }
+                return true;
+            }
+            return false;
+        }
 
-                if (j > 0)
+        void WorkerLoop(UINT workerIndex)
+        {
+            // A task is only retired after the subtasks it spawned were queued,
+            // so no work is left once the count drops to 0
+            while (m_outstandingTasks > 0)
+            {
+                BuildTask task;
+                if (TryGetTask(workerIndex, task))
+                {
+                    BuildSubtree(workerIndex, task);
+                    m_outstandingTasks--;
+                }
+                else
                 {
-                    AddExtentToBox(leftBoxes[j], leftBoxes[j - 1]);
-                    AddExtentToBox(rightBoxes[rightIdx], rightBoxes[rightIdx + 1]);
+                    std::this_thread::yield();
                 }
             }
+        }
 
-            UINT numTrianglesOnLeft = 0;
-            UINT numTrianglesOnRight = numTris;
+        void ComputeBounds(UINT32 begin, UINT32 end, SimdAABB& bounds) const
+        {
+            InitBoxToInverseMax(bounds);
+            for (UINT32 i = begin; i < end; ++i)
+            {
+                AddExtentToBox(bounds, m_boxes[m_bvh.m_metadata[i].PrimitiveIndex]);
+            }
+        }
+
+        void WriteLeaf(const BuildTask& task)
+        {
+            const UINT32 numTriangles = task.end - task.begin;
+            assert(numTriangles < 128);
+            assert(task.begin < (1 << 24));
+
+            AABBNode& node = m_bvh.m_nodes[task.nodeIndex];
+            WriteNodeBox(node, task.bounds);
+            node.leaf = true;
+            node.leafNode.firstTriangleId = task.begin;
+            node.leafNode.numTriangleIds = numTriangles;
+            node.numTriangles = numTriangles;
+        }
 
-            // Find the plane with the best score
-            for (UINT j = 0; j < NUM_SAH_BINS - 1; ++j)
+        void BuildSubtree(UINT workerIndex, const BuildTask& subtreeTask)
+        {
+            std::vector<BuildTask> stack(1, subtreeTask);
+            while (!stack.empty())
             {
-                if (!sahBins[i][j].numTriangles)
+                BuildTask task = stack.back();
+                stack.pop_back();
+
+                if (task.end - task.begin <= m_maxTrisInLeaf)
                 {
+                    WriteLeaf(task);
                     continue;
                 }
 
-                numTrianglesOnLeft += sahBins[i][j].numTriangles;
-                numTrianglesOnRight -= sahBins[i][j].numTriangles;
-
-                const float sah = (numTrianglesOnLeft * ComputeBoxSurfaceArea(leftBoxes[j]) +
-                    numTrianglesOnRight * ComputeBoxSurfaceArea(rightBoxes[j + 1])) *
-                    normalizeToParent;
+                BuildTask leftTask, rightTask;
+                Split(task, leftTask, rightTask);
 
-                assert(!_isnan(sah));
+                AABBNode& node = m_bvh.m_nodes[task.nodeIndex];
+                WriteNodeBox(node, task.bounds);
+                node.internalNode.leftNodeIndex = leftTask.nodeIndex;
+                node.rightNodeIndex = rightTask.nodeIndex;
 
-                if (sah < bestSah)
+                if (m_numWorkers > 1 && rightTask.end - rightTask.begin >= MIN_PRIMITIVES_PER_TASK)
+                {
+                    PushTask(workerIndex, rightTask);
+                }
+                else
                 {
-                    bestSah = sah;
-                    maxDimension = i;
-                    numTrisInLeftNode = numTrianglesOnLeft;
+                    stack.push_back(rightTask);
                 }
+                stack.push_back(leftTask);
             }
         }
 
-        //
-        // Split the set to try to get a balanced tree
-        //
-
-        SortByCentroid(metadata, boxes, maxDimension);
-    }
-
-    //
-    // It's a good idea to do a breadth-first build because then nodes from the same level
-    // get adjacent memory locations. It does take a lot of memory though.
-    //
-    // "Uniform BVH"
-    // -- both children are valid for all internal nodes
-    // -- left child's index is +1 of the parent index, right child's index is stored
-    //    in the packed AABB structure.
-    // -- there could be a varaible number of triangles in leaves
-    //
-    static
-        void BuildBVH(
-            BVH& bvh,
-            const std::vector<AABB>& boxes,
-            const std::vector<PrimitiveMetaData>& primitiveMetaData,
-            UINT32 maxTrisInLeaf)
-    {
-        //
-        // These are huge so use pointers
-        //
-        struct StackItem
+        void Split(const BuildTask& task, BuildTask& leftTask, BuildTask& rightTask)
         {
-            std::vector<PrimitiveMetaData> primitiveMetaData;
-            UINT32              parentIndex;
-            UINT                right : 1;
-            UINT                axis : 2;
-        };
-
-        std::deque<StackItem*>   fifoLefts;
-        std::deque<StackItem*>   fifoRights;
+            using namespace DirectX;
+            const UINT32 numTris = task.end - task.begin;
 
-        StackItem* temp = new StackItem;
-        temp->parentIndex = (UINT)-1;
-        temp->primitiveMetaData = primitiveMetaData;
-        temp->right = false;
-        temp->axis = 0;
-        fifoRights.push_back(temp);
+            // Bin by centroid rather than by the node bounds so every bin range is populated
+            SimdAABB centroidBounds;
+            InitBoxToInverseMax(centroidBounds);
+            for (UINT32 i = task.begin; i < task.end; ++i)
+            {
+                AddPointToBox(centroidBounds, m_centroids[m_bvh.m_metadata[i].PrimitiveIndex]);
+            }
 
-        while (!fifoLefts.empty() || !fifoRights.empty())
-        {
-            // Uniform BVH pops the first left node
-            StackItem* item = nullptr;
+            const XMVECTOR extents = XMVectorSubtract(centroidBounds.max, centroidBounds.min);
+            const XMVECTOR hasExtents = XMVectorGreater(extents, XMVectorZero());
+            const XMVECTOR binScale = XMVectorSelect(
+                XMVectorZero(),
+                XMVectorDivide(XMVectorReplicate((float)NUM_SAH_BINS), extents),
+                hasExtents);
 
-            if (!fifoRights.empty())
+            SahBin sahBins[3][NUM_SAH_BINS];
+            for (UINT axis = 0; axis < 3; ++axis)
             {
-                item = fifoRights.back();
-                fifoRights.pop_back();
+                for (UINT j = 0; j < NUM_SAH_BINS; ++j)
+                {
+                    sahBins[axis][j].numTriangles = 0;
+                    InitBoxToInverseMax(sahBins[axis][j].box);
+                }
             }
 
-            if (!item)
+            // Place triangles into the buckets of all 3 axes at once
+            for (UINT32 i = task.begin; i < task.end; ++i)
             {
-                item = fifoLefts.back();
-                fifoLefts.pop_back();
-            }
+                const UINT32 triId = m_bvh.m_metadata[i].PrimitiveIndex;
+                XMFLOAT3 binIndex;
+                XMStoreFloat3(&binIndex, XMVectorMultiply(XMVectorSubtract(m_centroids[triId], centroidBounds.min), binScale));
 
-            //
-            // Compute overall bounding box
-            //
-            AABB nodeBox;
-            ComputeBox(nodeBox, boxes, item->primitiveMetaData);
+                const float binIndices[3] = { binIndex.x, binIndex.y, binIndex.z };
+                for (UINT axis = 0; axis < 3; ++axis)
+                {
+                    SahBin& bin = sahBins[axis][std::min(NUM_SAH_BINS - 1, (UINT)binIndices[axis])];
+                    bin.numTriangles++;
+                    AddExtentToBox(bin.box, m_boxes[triId]);
+                }
+            }
 
-            const UINT32 numTrianglesInNode = (UINT32)item->primitiveMetaData.size();
-            const UINT32 parentIndex = item->parentIndex;
+            // For the score to be meaningful it seems we need to normalize it to something
+            const float normalizeToParent = 1.f / ComputeBoxSurfaceArea(task.bounds);
 
-            UINT32 thisNodeIndex;
+            float bestSah = FLT_MAX;
+            UINT bestAxis = 0;
+            UINT bestSplitBin = 0;
+            UINT numTrisInLeftNode = 0;
+            SimdAABB bestLeftBox, bestRightBox;
 
-            // Leaf or internal node?
-            if (numTrianglesInNode <= maxTrisInLeaf)
-            {
-                thisNodeIndex = BuildBVHAddLeaf(bvh, nodeBox, item->primitiveMetaData);
-            }
-            else
+            for (UINT axis = 0; axis < 3; ++axis)
             {
-                //
-                // Find separating plane. Use Median for speed.
-                // SAH is better but also more expensive to build.
-                //
-
-                UINT splitDimension;
-                UINT leftChildNumNodes;
-
-                SahSplit(item->primitiveMetaData,
-                    splitDimension,
-                    leftChildNumNodes,
-                    nodeBox,
-                    boxes);
-
-                assert(leftChildNumNodes <= item->primitiveMetaData.size());
-
-                // Try to balance by using the median if SAH failed
-                if ((leftChildNumNodes == 0 ||
-                    leftChildNumNodes == item->primitiveMetaData.size()) &&
-                    item->primitiveMetaData.size() > MAX_TRIS_IN_LEAF)
+                if (!XMVectorGetIntByIndex(hasExtents, axis))
+                    continue;
+
+                // Precompute right boxes with counts to be able to test plane positionings
+                SimdAABB rightBoxes[NUM_SAH_BINS];
+                rightBoxes[NUM_SAH_BINS - 1] = sahBins[axis][NUM_SAH_BINS - 1].box;
+                for (UINT j = NUM_SAH_BINS - 1; j > 0; --j)
                 {
-                    leftChildNumNodes = (UINT)item->primitiveMetaData.size() / 2;
+                    rightBoxes[j - 1] = sahBins[axis][j - 1].box;
+                    AddExtentToBox(rightBoxes[j - 1], rightBoxes[j]);
                 }
 
-                const UINT32 rightChildNumNodes = (UINT32)item->primitiveMetaData.size() - leftChildNumNodes;
+                SimdAABB leftBox;
+                InitBoxToInverseMax(leftBox);
+                UINT numTrianglesOnLeft = 0;
 
+                // Find the plane with the best score, the plane sits right after bin j
+                for (UINT j = 0; j < NUM_SAH_BINS - 1; ++j)
+                {
+                    numTrianglesOnLeft += sahBins[axis][j].numTriangles;
+                    AddExtentToBox(leftBox, sahBins[axis][j].box);
 
-                //
-                // "Recurse"
-                //
+                    const UINT numTrianglesOnRight = numTris - numTrianglesOnLeft;
+                    if (numTrianglesOnLeft == 0 || numTrianglesOnRight == 0)
+                    {
+                        continue;
+                    }
 
-                thisNodeIndex = BuildBVHAddNode(bvh, nodeBox, splitDimension);
+                    const float sah = (numTrianglesOnLeft * ComputeBoxSurfaceArea(leftBox) +
+                        numTrianglesOnRight * ComputeBoxSurfaceArea(rightBoxes[j + 1])) *
+                        normalizeToParent;
 
-                StackItem* leftItem = new StackItem;
-                leftItem->parentIndex = thisNodeIndex;
-                leftItem->primitiveMetaData.resize(leftChildNumNodes);
-                leftItem->right = false;
-                leftItem->axis = splitDimension;
-                for (UINT32 i = 0; i < leftChildNumNodes; ++i)
-                {
-                    leftItem->primitiveMetaData[i] = item->primitiveMetaData[i];
-                }
+                    assert(!_isnan(sah));
 
-                StackItem* rightItem = new StackItem;
-                rightItem->parentIndex = thisNodeIndex;
-                rightItem->primitiveMetaData.resize(rightChildNumNodes);
-                rightItem->right = true;
-                rightItem->axis = splitDimension;
-                for (UINT32 i = 0; i < rightChildNumNodes; ++i)
-                {
-                    rightItem->primitiveMetaData[i] = item->primitiveMetaData[i + leftChildNumNodes];
+                    if (sah < bestSah)
+                    {
+                        bestSah = sah;
+                        bestAxis = axis;
+                        bestSplitBin = j;
+                        numTrisInLeftNode = numTrianglesOnLeft;
+                        bestLeftBox = leftBox;
+                        bestRightBox = rightBoxes[j + 1];
+                    }
                 }
-
-                fifoLefts.push_back(leftItem);
-                fifoRights.push_back(rightItem);
             }
 
-            // Update child link of the parent
-            if (parentIndex != -1)
+            UINT32 splitIndex;
+            if (numTrisInLeftNode != 0)
             {
-                if (!item->right)
+                auto begin = m_bvh.m_metadata.begin() + task.begin;
+                auto end = m_bvh.m_metadata.begin() + task.end;
+                auto split = std::partition(begin, end, [&](const PrimitiveMetaData& metadata) -> bool
                 {
-                    bvh.m_nodes[parentIndex].internalNode.leftNodeIndex = thisNodeIndex;
-                    bvh.m_nodes[parentIndex].rightNodeIndex = parentIndex + 1;
-                }
+                    const XMVECTOR binIndex = XMVectorMultiply(XMVectorSubtract(m_centroids[metadata.PrimitiveIndex], centroidBounds.min), binScale);
+                    return std::min(NUM_SAH_BINS - 1, (UINT)XMVectorGetByIndex(binIndex, bestAxis)) <= bestSplitBin;
+                });
+                splitIndex = task.begin + (UINT32)(split - begin);
+                assert(splitIndex - task.begin == numTrisInLeftNode);
+
+                leftTask.bounds = bestLeftBox;
+                rightTask.bounds = bestRightBox;
+            }
+            else
+            {
+                // All centroids are in the same spot, any split is as good as another,
+                // so balance the tree by using the median
+                splitIndex = task.begin + numTris / 2;
+                ComputeBounds(task.begin, splitIndex, leftTask.bounds);
+                ComputeBounds(splitIndex, task.end, rightTask.bounds);
             }
 
-            // Free the item after use
-            delete item;
+            leftTask.begin = task.begin;
+            leftTask.end = splitIndex;
+            leftTask.nodeIndex = task.nodeIndex + 1;
+
+            rightTask.begin = splitIndex;
+            rightTask.end = task.end;
+            rightTask.nodeIndex = leftTask.nodeIndex + 2 * (splitIndex - task.begin) - 1;
         }
+
+        BVH&                            m_bvh;
+        std::vector<SimdAABB>           m_boxes;
+        std::vector<DirectX::XMVECTOR>  m_centroids;
+        const UINT32                    m_maxTrisInLeaf;
+
+        UINT                            m_numWorkers;
+        std::unique_ptr<WorkerQueue[]>  m_pWorkerQueues;
+        std::atomic<UINT>               m_outstandingTasks;
+    };
+
+    static
+        void BuildBVH(
+            BVH& bvh,
+            const std::vector<AABB>& boxes,
+            const std::vector<PrimitiveMetaData>& primitiveMetaData,
+            UINT32 maxTrisInLeaf,
+            UINT numThreads)
+    {
+        bvh.m_metadata = primitiveMetaData;
+
+        BinnedSahBuilder builder(bvh, boxes, maxTrisInLeaf);
+        builder.Build(numThreads);
     }
 
     void BuildUniformBVH(
         _In_  UINT NumElements,
         _In_reads_opt_(NumElements)  const D3D12_RAYTRACING_GEOMETRY_DESC *pGeometries,
+        _In_  UINT NumThreads,
         BVH &bvh)
     {
         using namespace DirectX;
@@ -635,7 +638,7 @@ namespace FallbackLayer
         // Create a BVH
         //
 
-        BuildBVH(bvh, boxes, primitiveMetaData, MAX_TRIS_IN_LEAF);
+        BuildBVH(bvh, boxes, primitiveMetaData, MAX_TRIS_IN_LEAF, NumThreads);
 
         //
         // Now copy and compress geometry
@@ -667,10 +670,16 @@ namespace FallbackLayer
 
 void BuildRaytracingAccelerationStructureOnCpu(
     _In_  const D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_DESC *pDesc,
-    _Out_ void *pData)
+    _Out_ void *pData,
+    _In_  UINT NumThreads)
 {
+    if (NumThreads == 0)
+    {
+        NumThreads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
     FallbackLayer::BVH bvh;
-    FallbackLayer::BuildUniformBVH(pDesc->Inputs.NumDescs, pDesc->Inputs.pGeometryDescs, bvh);
+    FallbackLayer::BuildUniformBVH(pDesc->Inputs.NumDescs, pDesc->Inputs.pGeometryDescs, NumThreads, bvh);
 
     BYTE* outputData = (BYTE*)pData;
     BVHOffsets offsets;
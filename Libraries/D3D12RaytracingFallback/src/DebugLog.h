@@ -23,7 +23,7 @@
 #define LOG_FLOAT         5
 #define LOG_FLOAT3        6
 
-#ifdef HLSL
+#if defined(HLSL) && ENABLE_UAV_LOG
 void BeginLog();
 void LogInt(int val);
 void LogInt2(int2 val);
@@ -32,4 +32,4 @@ void LogFloat(float val);
 void LogFloat3(float3 val);
 void LogTraceRayStart();
 void LogTraceRayEnd();
-#endif // HLSL
+#endif // HLSL && ENABLE_UAV_LOG
@@ -10,17 +10,16 @@
 //*********************************************************
 #include "DebugLog.h"
 
+#if ENABLE_UAV_LOG
 static const uint EntryStartOffset = 1; // First entry used as a header for the entry count
 void Log(uint4 LogEntry)
 {
-#if ENABLE_UAV_LOG
     if (DispatchRaysIndex().x == LOG_RAY_INDEX_X && DispatchRaysIndex().y == LOG_RAY_INDEX_Y)
     {
         int count = DebugLog[0].x;
         DebugLog[count + EntryStartOffset] = LogEntry;
         DebugLog[0].x = count + 1;
     }
-#endif
 }
 
 void LogNoData(uint EntryType)
@@ -62,3 +61,4 @@ void LogFloat3(float3 val)
 {
   Log(uint4(LOG_FLOAT3, asuint(val)));
 }
+#endif // ENABLE_UAV_LOG
@@ -17,6 +17,15 @@ RWByteAddressBuffer PointerGetBuffer(GpuVA address)
     return DescriptorHeapBufferTable[NonUniformResourceIndex(address[EmulatedPointerDescriptorHeapIndex])];
 }
 
+// Only valid for addresses that are the same for every thread in the dispatch
+// (i.e. ones read from constants). Skips the NonUniformResourceIndex decode so
+// the descriptor can be fetched once with scalar loads.
+static
+RWByteAddressBuffer PointerGetUniformBuffer(GpuVA address)
+{
+    return DescriptorHeapBufferTable[address[EmulatedPointerDescriptorHeapIndex]];
+}
+
 uint PointerGetBufferStartOffset(GpuVA address)
 {
     return address[EmulatedPointerOffsetIndex];
@@ -33,5 +42,11 @@ RWByteAddressBufferPointer CreateRWByteAddressBufferPointerFromGpuVA(GpuVA addre
     return CreateRWByteAddressBufferPointer(PointerGetBuffer(address), PointerGetBufferStartOffset(address));
 }
 
+static
+RWByteAddressBufferPointer CreateRWByteAddressBufferPointerFromUniformGpuVA(GpuVA address)
+{
+    return CreateRWByteAddressBufferPointer(PointerGetUniformBuffer(address), PointerGetBufferStartOffset(address));
+}
+
 
 
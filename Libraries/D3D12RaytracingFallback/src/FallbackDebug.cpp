@@ -57,6 +57,23 @@ void OutputDebugLog(ID3D12RaytracingFallbackDevice *pDevice)
 }
 #endif
 
+#if ENABLE_TRAVERSAL_STATS
+FallbackTraversalStats GetTraversalStats(ID3D12RaytracingFallbackDevice *pDevice)
+{
+    FallbackLayer::RaytracingDevice &device = *(FallbackLayer::RaytracingDevice *)pDevice;
+
+    static_assert(sizeof(FallbackTraversalStats) == TraversalStatsSize, "FallbackTraversalStats must match the TraversalStats buffer");
+    FallbackTraversalStats stats;
+    void *pData;
+    D3D12_RANGE readRange = { 0, TraversalStatsSize };
+    device.GetTraversalStatsReadbackHeap().Map(0, &readRange, &pData);
+    memcpy(&stats, pData, sizeof(stats));
+    D3D12_RANGE writtenRange = { 0, 0 };
+    device.GetTraversalStatsReadbackHeap().Unmap(0, &writtenRange);
+    return stats;
+}
+#endif
+
 #if ENABLE_ACCELERATION_STRUCTURE_VISUALIZATION
 void VisualizeAccelerationStructureLevel(ID3D12RaytracingFallbackDevice *pDevice, UINT level)
 {
@@ -9,8 +9,14 @@
 //
 //*********************************************************
 #pragma once
+// Set to 1 to log the calls made while tracing the ray at (LOG_RAY_INDEX_X, LOG_RAY_INDEX_Y), which
+// OutputDebugLog prints after the dispatch. With 0, none of the logging code is compiled into traversal.
 #define ENABLE_UAV_LOG 0
 
+// Set to 1 to count the rays traced, BVH nodes visited and triangles tested by each DispatchRays,
+// which GetTraversalStats reads back. Counts are summed per wave so there is one atomic per wave and counter.
+#define ENABLE_TRAVERSAL_STATS 0
+
 // Set to 1 to visualize acceleration structure. 
 // Since this writes to a raytracing output during ray traversal, 
 // the Fallback Layer must have an output that is used by the application defined and
@@ -70,6 +70,9 @@ enum RootSignatureParameterOffset {
 #if ENABLE_UAV_LOG
   DebugUAVLog,
 #endif
+#if ENABLE_TRAVERSAL_STATS
+  TraversalStatsUAV,
+#endif
 #if ENABLE_ACCELERATION_STRUCTURE_VISUALIZATION
   DebugConstants,
 #endif
@@ -62,6 +62,26 @@ namespace FallbackLayer
         }
 #endif
 
+#if ENABLE_TRAVERSAL_STATS
+        {
+            auto statsDesc = CD3DX12_RESOURCE_DESC::Buffer(TraversalStatsSize, D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
+            auto defaultHeapProperties = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT);
+            ThrowInternalFailure(m_pDevice->CreateCommittedResource(&defaultHeapProperties, D3D12_HEAP_FLAG_NONE, &statsDesc, D3D12_RESOURCE_STATE_COMMON, nullptr, IID_PPV_ARGS(&m_pTraversalStats)));
+
+            auto statsReadbackDesc = CD3DX12_RESOURCE_DESC::Buffer(TraversalStatsSize);
+            auto readbackHeapProperties = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_READBACK);
+            ThrowInternalFailure(m_pDevice->CreateCommittedResource(&readbackHeapProperties, D3D12_HEAP_FLAG_NONE, &statsReadbackDesc, D3D12_RESOURCE_STATE_COPY_DEST, nullptr, IID_PPV_ARGS(&m_pTraversalStatsReadback)));
+
+            auto uploadHeapProperties = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD);
+            ThrowInternalFailure(m_pDevice->CreateCommittedResource(&uploadHeapProperties, D3D12_HEAP_FLAG_NONE, &statsReadbackDesc, D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(&m_pTraversalStatsZeroBuffer)));
+
+            void *pZeros;
+            m_pTraversalStatsZeroBuffer->Map(0, nullptr, &pZeros);
+            ZeroMemory(pZeros, TraversalStatsSize);
+            m_pTraversalStatsZeroBuffer->Unmap(0, nullptr);
+        }
+#endif
+
     }
 
 
@@ -75,6 +95,32 @@ namespace FallbackLayer
         return D3D12_RESOURCE_STATE_UNORDERED_ACCESS;
     }
 
+    D3D12_DRIVER_MATCHING_IDENTIFIER_STATUS RaytracingDevice::CheckDriverMatchingIdentifier(
+        _In_ D3D12_SERIALIZED_DATA_TYPE SerializedDataType,
+        _In_ const D3D12_SERIALIZED_DATA_DRIVER_MATCHING_IDENTIFIER *pIdentifierToCheck)
+    {
+        if (SerializedDataType != D3D12_SERIALIZED_DATA_RAYTRACING_ACCELERATION_STRUCTURE)
+        {
+            return D3D12_DRIVER_MATCHING_IDENTIFIER_UNSUPPORTED_TYPE;
+        }
+
+        const UINT32 fallbackGuid[] = {
+            SerializedAccelerationStructureGuid0,
+            SerializedAccelerationStructureGuid1,
+            SerializedAccelerationStructureGuid2,
+            SerializedAccelerationStructureGuid3 };
+        static_assert(sizeof(fallbackGuid) == sizeof(pIdentifierToCheck->DriverOpaqueGUID), L"Incorrect size for the serialized data GUID");
+        if (memcmp(&pIdentifierToCheck->DriverOpaqueGUID, fallbackGuid, sizeof(fallbackGuid)) != 0)
+        {
+            return D3D12_DRIVER_MATCHING_IDENTIFIER_UNRECOGNIZED;
+        }
+
+        UINT32 version;
+        memcpy(&version, pIdentifierToCheck->DriverOpaqueVersioningData, sizeof(version));
+        return version == SerializedAccelerationStructureVersion ?
+            D3D12_DRIVER_MATCHING_IDENTIFIER_COMPATIBLE_WITH_DEVICE : D3D12_DRIVER_MATCHING_IDENTIFIER_INCOMPATIBLE_VERSION;
+    }
+
     WRAPPED_GPU_POINTER RaytracingDevice::GetWrappedPointerSimple(UINT32 DescriptorHeapIndex, D3D12_GPU_VIRTUAL_ADDRESS gpuVA)
     {
         UNREFERENCED_PARAMETER(gpuVA);
@@ -259,6 +305,9 @@ namespace FallbackLayer
 #if ENABLE_UAV_LOG
             patchedRootParameters[patchedParameterOffset + DebugUAVLog].InitAsUnorderedAccessView(UAVLogRegister, FallbackLayerRegisterSpace);
 #endif
+#if ENABLE_TRAVERSAL_STATS
+            patchedRootParameters[patchedParameterOffset + TraversalStatsUAV].InitAsUnorderedAccessView(TraversalStatsRegister, FallbackLayerRegisterSpace);
+#endif
 #if ENABLE_ACCELERATION_STRUCTURE_VISUALIZATION
             patchedRootParameters[patchedParameterOffset + DebugConstants].InitAsConstants(SizeOfInUint32(DebugVariables), DebugConstantRegister, FallbackLayerRegisterSpace);
 #endif
@@ -479,6 +528,20 @@ namespace FallbackLayer
     }
 
 
+    HRESULT RaytracingDevice::SetStateObjectCacheFile(_In_opt_ LPCWSTR pFilePath)
+    {
+        try
+        {
+            m_RaytracingProgramFactory.GetStateObjectCache().SetFile(pFilePath);
+        }
+        catch (_com_error &e)
+        {
+            return e.Error();
+        }
+
+        return S_OK;
+    }
+
     HRESULT STDMETHODCALLTYPE RaytracingDevice::CreateStateObject(
         const D3D12_STATE_OBJECT_DESC *pDesc,
         REFIID riid,
@@ -513,6 +576,10 @@ namespace FallbackLayer
                     pCommandList->SetComputeRootUnorderedAccessView(
                         patchRootSignatureParameterStart + DebugUAVLog, m_pUAVLog->GetGPUVirtualAddress());
 #endif
+#if ENABLE_TRAVERSAL_STATS
+                    pCommandList->SetComputeRootUnorderedAccessView(
+                        patchRootSignatureParameterStart + TraversalStatsUAV, m_pTraversalStats->GetGPUVirtualAddress());
+#endif
 
 #if ENABLE_ACCELERATION_STRUCTURE_VISUALIZATION
                     DebugVariables variables;
@@ -533,17 +600,28 @@ namespace FallbackLayer
         return S_OK;
     }
 
+    HRESULT STDMETHODCALLTYPE RaytracingDevice::CreateStateObjects(
+        UINT NumStateObjects,
+        const D3D12_STATE_OBJECT_DESC *pDescs,
+        REFIID riid,
+        _COM_Outptr_  void **ppStateObjectBatch)
+    {
+        return CreateStateObjectBatch(this, NumStateObjects, pDescs, riid, ppStateObjectBatch);
+    }
+
     void STDMETHODCALLTYPE D3D12RaytracingCommandList::EmitRaytracingAccelerationStructurePostbuildInfo(
         _In_  const D3D12_RAYTRACING_ACCELERATION_STRUCTURE_POSTBUILD_INFO_DESC *pDesc,
         _In_  UINT NumSourceAccelerationStructures,
         _In_reads_(NumSourceAccelerationStructures)  const D3D12_GPU_VIRTUAL_ADDRESS *pSourceAccelerationStructureData)
     {
-        if (pDesc->InfoType != D3D12_RAYTRACING_ACCELERATION_STRUCTURE_POSTBUILD_INFO_COMPACTED_SIZE ||
-            pDesc->InfoType != D3D12_RAYTRACING_ACCELERATION_STRUCTURE_POSTBUILD_INFO_CURRENT_SIZE)
+        if (pDesc->InfoType != D3D12_RAYTRACING_ACCELERATION_STRUCTURE_POSTBUILD_INFO_COMPACTED_SIZE &&
+            pDesc->InfoType != D3D12_RAYTRACING_ACCELERATION_STRUCTURE_POSTBUILD_INFO_CURRENT_SIZE &&
+            pDesc->InfoType != D3D12_RAYTRACING_ACCELERATION_STRUCTURE_POSTBUILD_INFO_SERIALIZATION)
         {
             ThrowFailure(E_INVALIDARG,
                 L"Unsupported InfoType passed in, only supported POSTBUILD_INFO flags are "
-                L"D3D12_RAYTRACING_ACCELERATION_STRUCTURE_POSTBUILD_INFO_COMPACTED_SIZE and D3D12_RAYTRACING_ACCELERATION_STRUCTURE_POSTBUILD_INFO_CURRENT_SIZE, "
+                L"D3D12_RAYTRACING_ACCELERATION_STRUCTURE_POSTBUILD_INFO_COMPACTED_SIZE, D3D12_RAYTRACING_ACCELERATION_STRUCTURE_POSTBUILD_INFO_CURRENT_SIZE "
+                L"and D3D12_RAYTRACING_ACCELERATION_STRUCTURE_POSTBUILD_INFO_SERIALIZATION"
             );
         }
 #if USE_PIX_MARKERS
@@ -629,6 +707,9 @@ namespace FallbackLayer
 #if ENABLE_UAV_LOG
         m_device.ResetLog(m_pCommandList);
 #endif
+#if ENABLE_TRAVERSAL_STATS
+        m_device.ResetTraversalStats(m_pCommandList);
+#endif
 #if USE_PIX_MARKERS
         PIXScopedEvent(m_pCommandList.p, FallbackPixColor, L"DispatchRays(%d, %d)", pDesc->Width, pDesc->Height);
 #endif
@@ -641,6 +722,9 @@ namespace FallbackLayer
 
 #if ENABLE_UAV_LOG
         m_pCommandList->CopyResource(&m_device.GetUAVDebugLogReadbackHeap(), &m_device.GetUAVDebugLog());
+#endif
+#if ENABLE_TRAVERSAL_STATS
+        m_device.ReadBackTraversalStats(m_pCommandList);
 #endif
     }
 
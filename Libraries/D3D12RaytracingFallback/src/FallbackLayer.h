@@ -137,6 +137,10 @@ namespace FallbackLayer
         virtual WRAPPED_GPU_POINTER GetWrappedPointerFromDescriptorHeapIndex(UINT32 DescriptorHeapIndex, UINT32 OffsetInBytes = 0);
         virtual WRAPPED_GPU_POINTER GetWrappedPointerFromGpuVA(D3D12_GPU_VIRTUAL_ADDRESS gpuVA);
         virtual D3D12_RESOURCE_STATES GetAccelerationStructureResourceState();
+        virtual D3D12_DRIVER_MATCHING_IDENTIFIER_STATUS CheckDriverMatchingIdentifier(
+            _In_ D3D12_SERIALIZED_DATA_TYPE SerializedDataType,
+            _In_ const D3D12_SERIALIZED_DATA_DRIVER_MATCHING_IDENTIFIER *pIdentifierToCheck);
+        virtual HRESULT SetStateObjectCacheFile(_In_opt_ LPCWSTR pFilePath);
 
 
         virtual HRESULT STDMETHODCALLTYPE CreateStateObject(
@@ -144,6 +148,12 @@ namespace FallbackLayer
             REFIID riid,
             _COM_Outptr_  void **ppStateObject);
 
+        virtual HRESULT STDMETHODCALLTYPE CreateStateObjects(
+            UINT NumStateObjects,
+            const D3D12_STATE_OBJECT_DESC *pDescs,
+            REFIID riid,
+            _COM_Outptr_  void **ppStateObjectBatch);
+
         virtual UINT STDMETHODCALLTYPE GetShaderIdentifierSize(void);
 
         virtual void STDMETHODCALLTYPE GetRaytracingAccelerationStructurePrebuildInfo(
@@ -232,6 +242,42 @@ namespace FallbackLayer
             return *m_pUAVLogReadback;
         }
 #endif
+
+#if ENABLE_TRAVERSAL_STATS
+    private:
+        CComPtr<ID3D12Resource> m_pTraversalStatsZeroBuffer;
+        CComPtr<ID3D12Resource> m_pTraversalStats;
+        CComPtr<ID3D12Resource> m_pTraversalStatsReadback;
+
+    public:
+        // Buffers decay to COMMON between command lists, so the reset copy always starts from
+        // COPY_DEST, whether promoted or left there by a previous dispatch in the same list
+        void ResetTraversalStats(ID3D12GraphicsCommandList *pCommandList)
+        {
+            pCommandList->CopyBufferRegion(m_pTraversalStats, 0, m_pTraversalStatsZeroBuffer, 0, TraversalStatsSize);
+            auto toUAV = CD3DX12_RESOURCE_BARRIER::Transition(m_pTraversalStats, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+            pCommandList->ResourceBarrier(1, &toUAV);
+        }
+
+        void ReadBackTraversalStats(ID3D12GraphicsCommandList *pCommandList)
+        {
+            auto toCopySource = CD3DX12_RESOURCE_BARRIER::Transition(m_pTraversalStats, D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_COPY_SOURCE);
+            pCommandList->ResourceBarrier(1, &toCopySource);
+            pCommandList->CopyBufferRegion(m_pTraversalStatsReadback, 0, m_pTraversalStats, 0, TraversalStatsSize);
+            auto toCopyDest = CD3DX12_RESOURCE_BARRIER::Transition(m_pTraversalStats, D3D12_RESOURCE_STATE_COPY_SOURCE, D3D12_RESOURCE_STATE_COPY_DEST);
+            pCommandList->ResourceBarrier(1, &toCopyDest);
+        }
+
+        ID3D12Resource &GetTraversalStats()
+        {
+            return *m_pTraversalStats;
+        }
+
+        ID3D12Resource &GetTraversalStatsReadbackHeap()
+        {
+            return *m_pTraversalStatsReadback;
+        }
+#endif
     };
 
 #if ENABLE_UAV_LOG
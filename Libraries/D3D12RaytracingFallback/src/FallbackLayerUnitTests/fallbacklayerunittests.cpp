@@ -388,7 +388,8 @@ namespace FallbackLayerUnitTests
         void CopyAccelerationStructure(
             BuilderWrapper &builder,
             ID3D12Resource *pDestAccelerationStructure,
-            ID3D12Resource *pSourceAccelerationStructure)
+            ID3D12Resource *pSourceAccelerationStructure,
+            D3D12_RAYTRACING_ACCELERATION_STRUCTURE_COPY_MODE mode = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_COPY_MODE_CLONE)
         {
             ID3D12Device &device = m_d3d12Context.GetDevice();
             CComPtr<ID3D12GraphicsCommandList> pCommandList;
@@ -398,7 +399,7 @@ namespace FallbackLayerUnitTests
                 pCommandList,
                 pDestAccelerationStructure->GetGPUVirtualAddress(),
                 pSourceAccelerationStructure->GetGPUVirtualAddress(),
-                D3D12_RAYTRACING_ACCELERATION_STRUCTURE_COPY_MODE_CLONE);
+                mode);
 
             auto uavBarrier = CD3DX12_RESOURCE_BARRIER::UAV(nullptr);
             pCommandList->ResourceBarrier(1, &uavBarrier);
@@ -775,12 +776,40 @@ namespace FallbackLayerUnitTests
                 testCase);
         }
 
+        TEST_METHOD(ParallelStressBottomLevelCpuBVHBuilder)
+        {
+            // Enough triangles for subtrees to be spread across the threads
+            std::vector<float> AutoGeneratedReferenceVertices;
+            std::vector<UINT16> AutoGeneratedReferenceIndicies;
+            for (UINT i = 0; i < 7000; i++)
+            {
+                for (float f : ReferenceVerticies0)
+                {
+                    AutoGeneratedReferenceVertices.push_back(f + (i % 100) + (i / 100) * 0.25f);
+                }
+
+                for (UINT16 index : ReferenceIndices0)
+                {
+                    AutoGeneratedReferenceIndicies.push_back(index + (UINT16)ARRAYSIZE(ReferenceIndices0) * i);
+                }
+            }
+            CpuGeometryDescriptor testCase(AutoGeneratedReferenceVertices.data(),
+                (UINT)(AutoGeneratedReferenceVertices.size() / 3),
+                AutoGeneratedReferenceIndicies.data(),
+                (UINT)AutoGeneratedReferenceIndicies.size());
+
+            TestCpuBvh2Builder(
+                testCase,
+                4);
+        }
+
         template <UINT numBottomLevels>
         void SimpleTopLevelGpuBVHBuilder(
             D3D12_ELEMENTS_LAYOUT layoutToTest,
             bool applyRandomInstanceTransforms,
             bool testCopyAccelerationStructure = false,
-            bool testWithUpdate = false) {
+            bool testWithUpdate = false,
+            bool testSerializeAccelerationStructure = false) {
             const UINT referenceVertexArraySize = ARRAYSIZE(ReferenceVerticies0);
             const UINT referenceIndexArraySize = ARRAYSIZE(ReferenceIndices0);
 
@@ -869,6 +898,34 @@ namespace FallbackLayerUnitTests
                 pResourceToReadback = pTopLevelCopy;
             }
 
+            CComPtr<ID3D12Resource> pSerializedTopLevel;
+            CComPtr<ID3D12Resource> pDeserializedTopLevel;
+            if (testSerializeAccelerationStructure)
+            {
+                const UINT serializedSize = dataSize + SizeOfSerializedAccelerationStructureHeader;
+                auto heapProperties = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT);
+                auto serializedDesc = CD3DX12_RESOURCE_DESC::Buffer(serializedSize, D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
+                device.CreateCommittedResource(&heapProperties, D3D12_HEAP_FLAG_NONE, &serializedDesc, D3D12_RESOURCE_STATE_COMMON, nullptr, IID_PPV_ARGS(&pSerializedTopLevel));
+                m_pBuilderHelper->CopyAccelerationStructure(builderWrapper, pSerializedTopLevel, pResourceToReadback, D3D12_RAYTRACING_ACCELERATION_STRUCTURE_COPY_MODE_SERIALIZE);
+
+                D3D12_SERIALIZED_RAYTRACING_ACCELERATION_STRUCTURE_HEADER header;
+                m_d3d12Context.ReadbackResource(pSerializedTopLevel, &header, sizeof(header));
+                Assert::IsTrue(header.DeserializedSizeInBytes > 0 && header.DeserializedSizeInBytes <= dataSize, L"Incorrect deserialized size in the serialized header");
+                Assert::IsTrue(header.DeserializedSizeInBytes + SizeOfSerializedAccelerationStructureHeader == header.SerializedSizeInBytesIncludingHeader, L"Incorrect serialized size in the serialized header");
+                Assert::IsTrue(header.NumBottomLevelAccelerationStructurePointersAfterHeader == 0, L"Fallback serialized data should have no pointers to patch");
+
+                CComPtr<ID3D12RaytracingFallbackDevice> pFallbackDevice;
+                AssertSucceeded(D3D12CreateRaytracingFallbackDevice(&device, CreateRaytracingFallbackDeviceFlags::ForceComputeFallback, 0, IID_PPV_ARGS(&pFallbackDevice)));
+                Assert::IsTrue(D3D12_DRIVER_MATCHING_IDENTIFIER_COMPATIBLE_WITH_DEVICE == pFallbackDevice->CheckDriverMatchingIdentifier(
+                    D3D12_SERIALIZED_DATA_RAYTRACING_ACCELERATION_STRUCTURE, &header.DriverMatchingIdentifier), L"Serialized data is not recognized by the Fallback Layer");
+
+                auto deserializedDesc = CD3DX12_RESOURCE_DESC::Buffer(dataSize, D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
+                device.CreateCommittedResource(&heapProperties, D3D12_HEAP_FLAG_NONE, &deserializedDesc, D3D12_RESOURCE_STATE_COMMON, nullptr, IID_PPV_ARGS(&pDeserializedTopLevel));
+                m_pBuilderHelper->CopyAccelerationStructure(builderWrapper, pDeserializedTopLevel, pSerializedTopLevel, D3D12_RAYTRACING_ACCELERATION_STRUCTURE_COPY_MODE_DESERIALIZE);
+
+                pResourceToReadback = pDeserializedTopLevel;
+            }
+
 
             std::unique_ptr<BYTE[]> pData = std::unique_ptr<BYTE[]>(new BYTE[dataSize]);
             Assert::AreNotEqual(pData.get(), (BYTE *)nullptr, L"Failed to allocate output data");
@@ -879,6 +936,10 @@ namespace FallbackLayerUnitTests
             if (!validator.VerifyTopLevelOutput(containingBoxes, applyRandomInstanceTransforms ? pTransformations : nullptr, numBottomLevels, pData.get(), errorMessage)) {
                 Assert::Fail(errorMessage.c_str());
             }
+
+            if (!ValidateOnGpu(pResourceToReadback, D3D12_RAYTRACING_ACCELERATION_STRUCTURE_TYPE_TOP_LEVEL, numBottomLevels, errorMessage)) {
+                Assert::Fail(errorMessage.c_str());
+            }
         }
 
         TEST_METHOD(SimpleTopLevelGpuBVHBuilderSingleBottomLevel)
@@ -891,6 +952,11 @@ namespace FallbackLayerUnitTests
             SimpleTopLevelGpuBVHBuilder<50>(D3D12_ELEMENTS_LAYOUT_ARRAY, false, true);
         }
 
+        TEST_METHOD(SimpleTopLevelGpuBVHBuilderWithSerialization)
+        {
+            SimpleTopLevelGpuBVHBuilder<50>(D3D12_ELEMENTS_LAYOUT_ARRAY, false, false, false, true);
+        }
+
         TEST_METHOD(SimpleTopLevelGpuBVHBuilder_ArrayLayout) {
             SimpleTopLevelGpuBVHBuilder<50>(D3D12_ELEMENTS_LAYOUT_ARRAY, false);
         }
@@ -951,7 +1017,7 @@ namespace FallbackLayerUnitTests
             std::vector<float> pInitialData;
 
             auto heapProperties = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT);
-            auto countBufferDesc = CD3DX12_RESOURCE_DESC::Buffer(sizeof(UINT32) * numBottomLevels, D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
+            auto countBufferDesc = CD3DX12_RESOURCE_DESC::Buffer(sizeof(D3D12_RAYTRACING_ACCELERATION_STRUCTURE_POSTBUILD_INFO_CURRENT_SIZE_DESC) * numBottomLevels, D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
             device.CreateCommittedResource(&heapProperties, D3D12_HEAP_FLAG_NONE, &countBufferDesc, D3D12_RESOURCE_STATE_COMMON, nullptr, IID_PPV_ARGS(&pOutputCountBuffer));
 
             const UINT floatsPerVertex = 3;
@@ -1040,8 +1106,8 @@ namespace FallbackLayerUnitTests
             pCommandList->Close();
             m_d3d12Context.ExecuteCommandList(pCommandList);
 
-            std::vector<UINT32> accelerationStructureSizes(numBottomLevels);
-            m_d3d12Context.ReadbackResource(pOutputCountBuffer, accelerationStructureSizes.data(), (UINT)(accelerationStructureSizes.size() * sizeof(UINT32)));
+            std::vector<UINT64> accelerationStructureSizes(numBottomLevels);
+            m_d3d12Context.ReadbackResource(pOutputCountBuffer, accelerationStructureSizes.data(), (UINT)(accelerationStructureSizes.size() * sizeof(UINT64)));
             for (UINT i = 1; i < numBottomLevels; i++)
             {
                 Assert::IsTrue(accelerationStructureSizes[i] != 0 &&
@@ -1165,10 +1231,99 @@ namespace FallbackLayerUnitTests
             }
         }
 
+#if ENABLE_WIDE_BVH
+        TEST_METHOD(CollapseBottomLevelToWideBVH) {
+            ID3D12Device &device = m_d3d12Context.GetDevice();
+            std::unique_ptr<FallbackLayer::IAccelerationStructureBuilder> pBuilder =
+                std::unique_ptr<FallbackLayer::IAccelerationStructureBuilder>(
+                    new FallbackLayer::GpuBvh2Builder(&device, m_d3d12Context.GetTotalLaneCount(), 0));
+            InternalFallbackBuilder builderWrapper(pBuilder.get());
+
+            UINT numVertices = VERTEX_COUNT(ReferenceVerticies1);
+            UINT numTriangles = numVertices / 3;
+
+            CpuGeometryDescriptor geomDesc = CpuGeometryDescriptor(ReferenceVerticies1, VERTEX_COUNT(ReferenceVerticies1));
+
+            std::unique_ptr<BYTE[]> pData;
+            BuildBottomLevelAccelerationStructureAndGetCpuData(
+                builderWrapper,
+                &geomDesc,
+                1,
+                pData,
+                D3D12_ELEMENTS_LAYOUT_ARRAY,
+                D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_PREFER_FAST_BUILD);
+
+            const BYTE *pOutputBVH = pData.get();
+            BVHOffsets offsets = *(BVHOffsets*)pOutputBVH;
+            AABBNode *pNodeArray = (AABBNode*)((BYTE *)pOutputBVH + offsets.offsetToBoxes);
+            UINT offsetToWideNodes = offsets.offsetToPrimitiveMetaData + GetOffsetFromPrimitiveMetaDataToWideBVHNodes(numTriangles);
+            WideBVHNode *pWideNodeArray = (WideBVHNode*)((BYTE *)pOutputBVH + offsetToWideNodes);
+            Assert::AreEqual(offsetToWideNodes + GetSizeOfWideBVHNodes(numTriangles), offsets.totalSize, L"Wide nodes not included in the total size.");
+
+            // Walk the wide hierarchy from the root and make sure every leaf is reached
+            // exactly once through conservative child bounds
+            UINT numLeavesVisited = 0;
+            std::vector<UINT> nodeStack(1, 0);
+            while (nodeStack.size())
+            {
+                UINT nodeIndex = nodeStack.back();
+                nodeStack.pop_back();
+
+                const WideBVHNode &wideNode = pWideNodeArray[nodeIndex];
+                const AABBNode &binaryNode = pNodeArray[nodeIndex];
+                for (UINT i = 0; i < WIDE_BVH_WIDTH; i++)
+                {
+                    if (wideNode.children[i] == InvalidWideBVHChild) continue;
+
+                    const UINT childIndex = wideNode.children[i] & ~WideBVHChildIsLeafFlag;
+                    const AABBNode &childNode = pNodeArray[childIndex];
+                    const bool isLeaf = (wideNode.children[i] & WideBVHChildIsLeafFlag) != 0;
+                    Assert::AreEqual((bool)childNode.leaf, isLeaf, L"Wide node child has the wrong leaf flag.");
+
+                    bool isDescendant = binaryNode.leaf && childIndex == nodeIndex;
+                    if (!binaryNode.leaf)
+                    {
+                        for (UINT binaryChildIndex : { (UINT)binaryNode.internalNode.leftNodeIndex, binaryNode.rightNodeIndex })
+                        {
+                            const AABBNode &binaryChild = pNodeArray[binaryChildIndex];
+                            isDescendant |= binaryChildIndex == childIndex;
+                            isDescendant |= !binaryChild.leaf &&
+                                (binaryChild.internalNode.leftNodeIndex == childIndex || binaryChild.rightNodeIndex == childIndex);
+                        }
+                    }
+                    Assert::IsTrue(isDescendant, L"Wide node child is not a child or grandchild of the BVH2 node.");
+
+                    for (UINT axis = 0; axis < 3; axis++)
+                    {
+                        UINT exponentBits = ((wideNode.scaleExponents >> (axis * 8)) & 0xff) << 23;
+                        float scale;
+                        memcpy(&scale, &exponentBits, sizeof(scale));
+
+                        float quantizedMin = wideNode.origin[axis] + ((wideNode.quantizedMin[axis] >> (i * 8)) & 0xff) * scale;
+                        float quantizedMax = wideNode.origin[axis] + ((wideNode.quantizedMax[axis] >> (i * 8)) & 0xff) * scale;
+                        Assert::IsTrue(quantizedMin <= childNode.center[axis] - childNode.halfDim[axis], L"Quantized min bound is not conservative.");
+                        Assert::IsTrue(quantizedMax >= childNode.center[axis] + childNode.halfDim[axis], L"Quantized max bound is not conservative.");
+                    }
+
+                    if (isLeaf)
+                    {
+                        numLeavesVisited += childNode.numTriangles;
+                    }
+                    else
+                    {
+                        nodeStack.push_back(childIndex);
+                    }
+                }
+            }
+            Assert::AreEqual(numTriangles, numLeavesVisited, L"Not all leaves are reachable from the wide BVH root.");
+        }
+#endif
+
         void BuildAndUpdateBottomLevelAccelerationStructure(
             const float *startVertices,
             const float *updatedVertices,
-            int numVertices)
+            int numVertices,
+            bool updateIntoSeparateResource = false)
         {
             ID3D12Device &device = m_d3d12Context.GetDevice();
             std::unique_ptr<FallbackLayer::IAccelerationStructureBuilder> pBuilder =
@@ -1227,10 +1382,19 @@ namespace FallbackLayerUnitTests
             device.CreateCommittedResource(&heapProperties, D3D12_HEAP_FLAG_NONE, &accelerationStructureDesc, D3D12_RESOURCE_STATE_COMMON, nullptr, IID_PPV_ARGS(&pBottomLevelResource));
             bottomLevelGpuVA = pBottomLevelResource->GetGPUVirtualAddress();
 
+            Assert::IsTrue(prebuildInfo.UpdateScratchDataSizeInBytes > 0 && prebuildInfo.UpdateScratchDataSizeInBytes <= prebuildInfo.ScratchDataSizeInBytes, L"Unexpected update scratch size");
+
             CComPtr<ID3D12Resource> pScratchBufferResources[2];
             auto scratchBufferDesc = CD3DX12_RESOURCE_DESC::Buffer(prebuildInfo.ScratchDataSizeInBytes, D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
+            auto updateScratchBufferDesc = CD3DX12_RESOURCE_DESC::Buffer(prebuildInfo.UpdateScratchDataSizeInBytes, D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
             device.CreateCommittedResource(&heapProperties, D3D12_HEAP_FLAG_NONE, &scratchBufferDesc, D3D12_RESOURCE_STATE_COMMON, nullptr, IID_PPV_ARGS(&pScratchBufferResources[0]));
-            device.CreateCommittedResource(&heapProperties, D3D12_HEAP_FLAG_NONE, &scratchBufferDesc, D3D12_RESOURCE_STATE_COMMON, nullptr, IID_PPV_ARGS(&pScratchBufferResources[1]));
+            device.CreateCommittedResource(&heapProperties, D3D12_HEAP_FLAG_NONE, &updateScratchBufferDesc, D3D12_RESOURCE_STATE_COMMON, nullptr, IID_PPV_ARGS(&pScratchBufferResources[1]));
+
+            CComPtr<ID3D12Resource> pUpdatedBottomLevelResource;
+            if (updateIntoSeparateResource)
+            {
+                device.CreateCommittedResource(&heapProperties, D3D12_HEAP_FLAG_NONE, &accelerationStructureDesc, D3D12_RESOURCE_STATE_COMMON, nullptr, IID_PPV_ARGS(&pUpdatedBottomLevelResource));
+            }
 
             CComPtr<ID3D12GraphicsCommandList> pCommandList;
             m_d3d12Context.GetGraphicsCommandList(&pCommandList);
@@ -1247,6 +1411,11 @@ namespace FallbackLayerUnitTests
             bottomLevelDesc.ScratchAccelerationStructureData = pScratchBufferResources[1]->GetGPUVirtualAddress();
             bottomLevelInputs.Flags |= D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_PERFORM_UPDATE;
             geometryDesc.Triangles.VertexBuffer.StartAddress = pUpdatedVertexBuffer->GetGPUVirtualAddress();
+            if (updateIntoSeparateResource)
+            {
+                bottomLevelDesc.SourceAccelerationStructureData = bottomLevelGpuVA;
+                bottomLevelDesc.DestAccelerationStructureData = pUpdatedBottomLevelResource->GetGPUVirtualAddress();
+            }
 
             
             pBuilder->BuildRaytracingAccelerationStructure(
@@ -1262,7 +1431,7 @@ namespace FallbackLayerUnitTests
             std::unique_ptr<BYTE[]> outputData = std::unique_ptr<BYTE[]>(new BYTE[(UINT)prebuildInfo.ResultDataMaxSizeInBytes]);
             Assert::AreNotEqual(outputData.get(), (BYTE *)nullptr, L"Failed to allocate output data");
 
-            m_d3d12Context.ReadbackResource(pBottomLevelResource, outputData.get(), (UINT)prebuildInfo.ResultDataMaxSizeInBytes);
+            m_d3d12Context.ReadbackResource(updateIntoSeparateResource ? pUpdatedBottomLevelResource : pBottomLevelResource, outputData.get(), (UINT)prebuildInfo.ResultDataMaxSizeInBytes);
 
             CpuGeometryDescriptor cpuGeomDescAfter = CpuGeometryDescriptor(updatedVertices, numVertices);
 
@@ -1292,6 +1461,24 @@ namespace FallbackLayerUnitTests
             );
         }
 
+        TEST_METHOD(RefitAABBsOnUpdateIntoSeparateResource) {
+            const UINT numVertices = VERTEX_COUNT(ReferenceVerticies1);
+            std::vector<float> UpdatedVertices(numVertices * 3);
+            for (UINT i = 0; i < UpdatedVertices.size(); i++)
+            {
+                UINT vertexIndex = i / 3;
+                UINT triangleIndex = vertexIndex / 3;
+                UpdatedVertices[i] = (((ReferenceVerticies1[i] + vertexIndex) * (vertexIndex % 2 == 0 ? -8 : 8))) * ((triangleIndex % 2 == 0) ? -12 : 12);
+            }
+
+            BuildAndUpdateBottomLevelAccelerationStructure(
+                ReferenceVerticies1,
+                UpdatedVertices.data(),
+                numVertices,
+                true
+            );
+        }
+
     private:
 #define TEST_EPSILON 0.001
         bool IsChildContainedByParent(const AABB &parent, const AABB &child)
@@ -1341,7 +1528,7 @@ namespace FallbackLayerUnitTests
             }
         }
 
-        void TestCpuBvh2Builder(CpuGeometryDescriptor *pGeomDescs, UINT numGeoms, D3D12_ELEMENTS_LAYOUT layoutToTest = D3D12_ELEMENTS_LAYOUT_ARRAY)
+        void TestCpuBvh2Builder(CpuGeometryDescriptor *pGeomDescs, UINT numGeoms, D3D12_ELEMENTS_LAYOUT layoutToTest = D3D12_ELEMENTS_LAYOUT_ARRAY, UINT numThreads = 0)
         {
             ID3D12Device &device = m_d3d12Context.GetDevice();
             std::unique_ptr<FallbackLayer::IAccelerationStructureBuilder> pBuilder =
@@ -1378,18 +1565,29 @@ namespace FallbackLayerUnitTests
             inputs.Type = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL;
             inputs.pGeometryDescs = geomDescs.data();
 
-            BuildRaytracingAccelerationStructureOnCpu(&desc, pData.get());
+            BuildRaytracingAccelerationStructureOnCpu(&desc, pData.get(), numThreads);
             std::wstring errorMessage;
             auto &validator = FallbackLayer::GetAccelerationStructureValidator(pBuilder->GetAccelerationStructureType());
             if (!validator.VerifyBottomLevelOutput(pGeomDescs, numGeoms, pData.get(), errorMessage))
             {
                 Assert::Fail(errorMessage.c_str());
             }
+
+            // The layout must not depend on how the subtrees got scheduled
+            if (numThreads != 1)
+            {
+                std::unique_ptr<BYTE[]> pSingleThreadedData = std::unique_ptr<BYTE[]>(new BYTE[prebuildInfo.ResultDataMaxSizeInBytes]);
+                BuildRaytracingAccelerationStructureOnCpu(&desc, pSingleThreadedData.get(), 1);
+
+                const UINT totalSize = ((BVHOffsets *)pData.get())->totalSize;
+                Assert::AreEqual(totalSize, ((BVHOffsets *)pSingleThreadedData.get())->totalSize, L"Multi-threaded build has a different size");
+                Assert::IsTrue(memcmp(pData.get(), pSingleThreadedData.get(), totalSize) == 0, L"Multi-threaded build doesn't match the single-threaded build");
+            }
         }
 
-        void TestCpuBvh2Builder(CpuGeometryDescriptor &geomDesc)
+        void TestCpuBvh2Builder(CpuGeometryDescriptor &geomDesc, UINT numThreads = 0)
         {
-            TestCpuBvh2Builder(&geomDesc, 1);
+            TestCpuBvh2Builder(&geomDesc, 1, D3D12_ELEMENTS_LAYOUT_ARRAY, numThreads);
         }
 
         void TestGpuBvh2Builder(CpuGeometryDescriptor *pGeomDescs, UINT numGeoms, D3D12_ELEMENTS_LAYOUT layoutToTest = D3D12_ELEMENTS_LAYOUT_ARRAY)
@@ -1422,6 +1620,113 @@ namespace FallbackLayerUnitTests
             TestGpuBvh2Builder(&geomDesc, 1);
         }
 
+        bool ValidateOnGpu(
+            ID3D12Resource *pAccelerationStructure,
+            D3D12_RAYTRACING_ACCELERATION_STRUCTURE_TYPE type,
+            UINT numElements,
+            std::wstring &errorMessage)
+        {
+            ID3D12Device &device = m_d3d12Context.GetDevice();
+            FallbackLayer::GpuBvhValidator validator(&device, 0);
+
+            CComPtr<ID3D12Resource> pScratchBuffer;
+            CComPtr<ID3D12Resource> pErrorListBuffer;
+            auto heapProperties = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT);
+            auto scratchBufferDesc = CD3DX12_RESOURCE_DESC::Buffer(FallbackLayer::GpuBvhValidator::RequiredSizeForScratchBuffer(numElements), D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
+            auto errorListBufferDesc = CD3DX12_RESOURCE_DESC::Buffer(FallbackLayer::GpuBvhValidator::RequiredSizeForErrorListBuffer(), D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
+            AssertSucceeded(device.CreateCommittedResource(&heapProperties, D3D12_HEAP_FLAG_NONE, &scratchBufferDesc, D3D12_RESOURCE_STATE_COMMON, nullptr, IID_PPV_ARGS(&pScratchBuffer)));
+            AssertSucceeded(device.CreateCommittedResource(&heapProperties, D3D12_HEAP_FLAG_NONE, &errorListBufferDesc, D3D12_RESOURCE_STATE_COMMON, nullptr, IID_PPV_ARGS(&pErrorListBuffer)));
+
+            CComPtr<ID3D12GraphicsCommandList> pCommandList;
+            m_d3d12Context.GetGraphicsCommandList(&pCommandList);
+            validator.Validate(
+                pCommandList,
+                pAccelerationStructure->GetGPUVirtualAddress(),
+                type,
+                numElements,
+                pScratchBuffer->GetGPUVirtualAddress(),
+                pErrorListBuffer->GetGPUVirtualAddress());
+            AssertSucceeded(pCommandList->Close());
+            m_d3d12Context.ExecuteCommandList(pCommandList);
+            m_d3d12Context.WaitForGpuWork();
+
+            BYTE errorList[SizeOfBVHValidationErrorList];
+            m_d3d12Context.ReadbackResource(pErrorListBuffer, errorList, sizeof(errorList));
+            return FallbackLayer::GpuBvhValidator::GetErrorMessage(errorList, errorMessage);
+        }
+
+        TEST_METHOD(StressBottomLevelGpuBVHBuilderWithGpuValidation)
+        {
+            // Too many triangles for BvhValidator to get through in a reasonable time
+            std::vector<float> AutoGeneratedReferenceVertices;
+            for (UINT i = 0; i < 100000; i++)
+            {
+                for (float f : ReferenceVerticies0)
+                {
+                    AutoGeneratedReferenceVertices.push_back(f + (i % 300) + (i / 300) * 0.25f);
+                }
+            }
+            const UINT numVertices = (UINT)(AutoGeneratedReferenceVertices.size() / 3);
+            CpuGeometryDescriptor testCase(AutoGeneratedReferenceVertices.data(), numVertices);
+
+            ID3D12Device &device = m_d3d12Context.GetDevice();
+            std::unique_ptr<FallbackLayer::IAccelerationStructureBuilder> pBuilder =
+                std::unique_ptr<FallbackLayer::IAccelerationStructureBuilder>(
+                    new FallbackLayer::GpuBvh2Builder(&device, m_d3d12Context.GetTotalLaneCount(), 0));
+            InternalFallbackBuilder builderWrapper(pBuilder.get());
+
+            CComPtr<ID3D12Resource> pResource;
+            m_pBuilderHelper->BuildBottomLevelAccelerationStructure(builderWrapper, &testCase, 1, &pResource, D3D12_ELEMENTS_LAYOUT_ARRAY, 0,
+                D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_PREFER_FAST_TRACE);
+
+            std::wstring errorMessage;
+            if (!ValidateOnGpu(pResource, D3D12_RAYTRACING_ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL, numVertices / 3, errorMessage))
+            {
+                Assert::Fail(errorMessage.c_str());
+            }
+        }
+
+        TEST_METHOD(GpuValidationFindsCorruptedBVH)
+        {
+            const UINT numVertices = VERTEX_COUNT(ReferenceVerticies1);
+            CpuGeometryDescriptor testCase(ReferenceVerticies1, numVertices);
+
+            ID3D12Device &device = m_d3d12Context.GetDevice();
+            std::unique_ptr<FallbackLayer::IAccelerationStructureBuilder> pBuilder =
+                std::unique_ptr<FallbackLayer::IAccelerationStructureBuilder>(
+                    new FallbackLayer::GpuBvh2Builder(&device, m_d3d12Context.GetTotalLaneCount(), 0));
+            InternalFallbackBuilder builderWrapper(pBuilder.get());
+
+            std::unique_ptr<BYTE[]> pData;
+            BuildBottomLevelAccelerationStructureAndGetCpuData(builderWrapper, &testCase, 1, pData);
+
+            // Point both children of the root at the left one, which cuts off the right subtree
+            const UINT dataSize = ((BVHOffsets *)pData.get())->totalSize;
+            AABBNode *pRoot = (AABBNode *)(pData.get() + SizeOfBVHOffsets);
+            pRoot->rightNodeIndex = pRoot->internalNode.leftNodeIndex;
+
+            CComPtr<ID3D12Resource> pUploadBuffer;
+            m_d3d12Context.CreateResourceWithInitialData(pData.get(), dataSize, &pUploadBuffer);
+
+            CComPtr<ID3D12Resource> pCorruptedBVH;
+            auto heapProperties = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT);
+            auto bufferDesc = CD3DX12_RESOURCE_DESC::Buffer(dataSize, D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
+            AssertSucceeded(device.CreateCommittedResource(&heapProperties, D3D12_HEAP_FLAG_NONE, &bufferDesc, D3D12_RESOURCE_STATE_COPY_DEST, nullptr, IID_PPV_ARGS(&pCorruptedBVH)));
+
+            CComPtr<ID3D12GraphicsCommandList> pCommandList;
+            m_d3d12Context.GetGraphicsCommandList(&pCommandList);
+            pCommandList->CopyBufferRegion(pCorruptedBVH, 0, pUploadBuffer, 0, dataSize);
+            AssertSucceeded(pCommandList->Close());
+            m_d3d12Context.ExecuteCommandList(pCommandList);
+            m_d3d12Context.WaitForGpuWork();
+
+            std::wstring errorMessage;
+            Assert::IsFalse(ValidateOnGpu(pCorruptedBVH, D3D12_RAYTRACING_ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL, numVertices / 3, errorMessage),
+                L"GPU validation didn't catch a BVH with an unreachable subtree");
+            Assert::IsTrue(errorMessage.find(L"more than one parent") != std::wstring::npos, L"GPU validation didn't report the node with two parents");
+            Assert::IsTrue(errorMessage.find(L"not reachable") != std::wstring::npos, L"GPU validation didn't report the unreachable nodes");
+        }
+
         void BuildBottomLevelAccelerationStructureAndGetCpuData(
             BuilderWrapper &builder,
             CpuGeometryDescriptor *pGeomDescs,
@@ -2538,6 +2843,177 @@ namespace FallbackLayerUnitTests
             Assert::IsNotNull(pStateObject->GetShaderIdentifier(stringCopy.c_str()));
         }
 
+        TEST_METHOD(StateObjectCacheTesting)
+        {
+            WCHAR tempPath[MAX_PATH];
+            WCHAR cacheFile[MAX_PATH];
+            Assert::IsTrue(GetTempPath(ARRAYSIZE(tempPath), tempPath) > 0);
+            Assert::IsTrue(GetTempFileName(tempPath, L"FLC", 0, cacheFile) > 0);
+            DeleteFile(cacheFile);
+
+            LPCWSTR exportNames[] = { L"RayGen", L"Miss", L"HitGroup" };
+            BYTE shaderIdentifiers[ARRAYSIZE(exportNames)][D3D12_SHADER_IDENTIFIER_SIZE_IN_BYTES];
+            UINT64 stackSizes[ARRAYSIZE(exportNames)];
+
+            // The first device links the state object and writes the cache, the second one
+            // is created like a later run would and has to load it back identically
+            for (UINT run = 0; run < 2; run++)
+            {
+                CComPtr<ID3D12RaytracingFallbackDevice> rayTracingDevice;
+                AssertSucceeded(D3D12CreateRaytracingFallbackDevice(
+                    &m_d3d12Context.GetDevice(),
+                    CreateRaytracingFallbackDeviceFlags::ForceComputeFallback,
+                    0,
+                    IID_PPV_ARGS(&rayTracingDevice)));
+                AssertSucceeded(rayTracingDevice->SetStateObjectCacheFile(cacheFile));
+
+                CComPtr<ID3D12RaytracingFallbackStateObject> pStateObject;
+                CreateSimpleStateObject(rayTracingDevice, &pStateObject);
+
+                for (UINT i = 0; i < ARRAYSIZE(exportNames); i++)
+                {
+                    void *pShaderIdentifier = pStateObject->GetShaderIdentifier(exportNames[i]);
+                    Assert::IsNotNull(pShaderIdentifier);
+                    if (run == 0)
+                    {
+                        memcpy(shaderIdentifiers[i], pShaderIdentifier, sizeof(shaderIdentifiers[i]));
+                        stackSizes[i] = pStateObject->GetShaderStackSize(exportNames[i]);
+                    }
+                    else
+                    {
+                        Assert::IsTrue(memcmp(shaderIdentifiers[i], pShaderIdentifier, sizeof(shaderIdentifiers[i])) == 0, L"Cached shader identifier doesn't match the linked one");
+                        Assert::AreEqual(stackSizes[i], pStateObject->GetShaderStackSize(exportNames[i]), L"Cached stack size doesn't match the linked one");
+                    }
+                }
+
+                Assert::IsTrue(GetFileAttributes(cacheFile) != INVALID_FILE_ATTRIBUTES, L"State object cache file was not written");
+            }
+
+            DeleteFile(cacheFile);
+        }
+
+        TEST_METHOD(StateObjectBatchTesting)
+        {
+            CComPtr<ID3D12RaytracingFallbackDevice> rayTracingDevice;
+            AssertSucceeded(D3D12CreateRaytracingFallbackDevice(
+                &m_d3d12Context.GetDevice(),
+                CreateRaytracingFallbackDeviceFlags::ForceComputeFallback,
+                0,
+                IID_PPV_ARGS(&rayTracingDevice)));
+
+            CComPtr<ID3D12RaytracingFallbackStateObject> pExpectedStateObject;
+            CreateSimpleStateObject(rayTracingDevice, &pExpectedStateObject);
+
+            const UINT numStateObjects = 4;
+            WithSimpleStateObjectDesc(rayTracingDevice, [&](const D3D12_STATE_OBJECT_DESC &stateObjectDesc)
+            {
+                std::vector<D3D12_STATE_OBJECT_DESC> descs(numStateObjects, stateObjectDesc);
+
+                CComPtr<ID3D12RaytracingFallbackStateObjectBatch> pBatch;
+                AssertSucceeded(rayTracingDevice->CreateStateObjects((UINT)descs.size(), descs.data(), IID_PPV_ARGS(&pBatch)));
+                Assert::AreEqual(numStateObjects, pBatch->GetStateObjectCount());
+
+                // Fetching the last state object first must only wait on that one
+                for (UINT i = numStateObjects; i-- > 0;)
+                {
+                    CComPtr<ID3D12RaytracingFallbackStateObject> pStateObject;
+                    AssertSucceeded(pBatch->GetStateObject(i, IID_PPV_ARGS(&pStateObject)));
+                    Assert::IsTrue(pBatch->GetStatus(i) == D3D12_RAYTRACING_FALLBACK_STATE_OBJECT_STATUS_COMPLETE);
+
+                    void *pShaderIdentifier = pStateObject->GetShaderIdentifier(L"HitGroup");
+                    Assert::IsNotNull(pShaderIdentifier);
+                    Assert::IsTrue(memcmp(pExpectedStateObject->GetShaderIdentifier(L"HitGroup"), pShaderIdentifier, D3D12_SHADER_IDENTIFIER_SIZE_IN_BYTES) == 0,
+                        L"State object created in a batch doesn't match one created directly");
+                }
+
+                pBatch->Wait();
+                Assert::AreEqual(numStateObjects, pBatch->GetCompletedCount());
+            });
+        }
+
+    private:
+        void CreateSimpleStateObject(ID3D12RaytracingFallbackDevice *pRaytracingDevice, ID3D12RaytracingFallbackStateObject **ppStateObject)
+        {
+            WithSimpleStateObjectDesc(pRaytracingDevice, [&](const D3D12_STATE_OBJECT_DESC &stateObjectDesc)
+            {
+                AssertSucceeded(pRaytracingDevice->CreateStateObject(&stateObjectDesc, IID_PPV_ARGS(ppStateObject)));
+            });
+        }
+
+        // Calls useDesc with a desc for a state object built from SimpleRayTracing.hlsl, which
+        // is only valid during the call
+        template<typename UseDescFunction>
+        void WithSimpleStateObjectDesc(ID3D12RaytracingFallbackDevice *pRaytracingDevice, UseDescFunction useDesc)
+        {
+            CComPtr<ID3D12RootSignature> pRootSignature;
+            {
+                CD3DX12_DESCRIPTOR_RANGE UAVDescriptor;
+                UAVDescriptor.Init(D3D12_DESCRIPTOR_RANGE_TYPE_UAV, 1, 0);
+                CD3DX12_ROOT_PARAMETER rootParameters[2];
+                rootParameters[0].InitAsShaderResourceView(0);
+                rootParameters[1].InitAsDescriptorTable(1, &UAVDescriptor);
+                CD3DX12_ROOT_SIGNATURE_DESC rootSignatureDesc(ARRAYSIZE(rootParameters), rootParameters);
+
+                CComPtr<ID3DBlob> pRootSignatureBlob;
+                AssertSucceeded(pRaytracingDevice->D3D12SerializeRootSignature(&rootSignatureDesc, D3D_ROOT_SIGNATURE_VERSION_1, &pRootSignatureBlob, nullptr));
+                AssertSucceeded(pRaytracingDevice->CreateRootSignature(
+                    1,
+                    pRootSignatureBlob->GetBufferPointer(),
+                    pRootSignatureBlob->GetBufferSize(),
+                    IID_PPV_ARGS(&pRootSignature)));
+            }
+
+            std::vector<D3D12_STATE_SUBOBJECT> subObjects;
+
+            D3D12_STATE_SUBOBJECT rootSignatureSubObject;
+            rootSignatureSubObject.pDesc = &pRootSignature.p;
+            rootSignatureSubObject.Type = D3D12_STATE_SUBOBJECT_TYPE_GLOBAL_ROOT_SIGNATURE;
+            subObjects.push_back(rootSignatureSubObject);
+
+            D3D12_STATE_SUBOBJECT shaderConfigSubObject;
+            D3D12_RAYTRACING_SHADER_CONFIG shaderConfig;
+            shaderConfig.MaxAttributeSizeInBytes = shaderConfig.MaxPayloadSizeInBytes = 8;
+            shaderConfigSubObject.pDesc = &shaderConfig;
+            shaderConfigSubObject.Type = D3D12_STATE_SUBOBJECT_TYPE_RAYTRACING_SHADER_CONFIG;
+            subObjects.push_back(shaderConfigSubObject);
+
+            D3D12_STATE_SUBOBJECT pipelineConfigSubObject;
+            D3D12_RAYTRACING_PIPELINE_CONFIG pipelineConfig;
+            pipelineConfig.MaxTraceRecursionDepth = 2;
+            pipelineConfigSubObject.pDesc = &pipelineConfig;
+            pipelineConfigSubObject.Type = D3D12_STATE_SUBOBJECT_TYPE_RAYTRACING_PIPELINE_CONFIG;
+            subObjects.push_back(pipelineConfigSubObject);
+
+            D3D12_STATE_SUBOBJECT hitGroupSubObject;
+            D3D12_HIT_GROUP_DESC hitGroupDesc = {};
+            hitGroupDesc.ClosestHitShaderImport = L"Hit";
+            hitGroupDesc.HitGroupExport = L"HitGroup";
+            hitGroupSubObject.pDesc = &hitGroupDesc;
+            hitGroupSubObject.Type = D3D12_STATE_SUBOBJECT_TYPE_HIT_GROUP;
+            subObjects.push_back(hitGroupSubObject);
+
+            D3D12_EXPORT_DESC exports[] = {
+                { L"Hit", nullptr, D3D12_EXPORT_FLAG_NONE },
+                { L"RayGen", nullptr, D3D12_EXPORT_FLAG_NONE },
+                { L"Miss", nullptr, D3D12_EXPORT_FLAG_NONE },
+            };
+
+            D3D12_DXIL_LIBRARY_DESC libraryDesc = {};
+            libraryDesc.DXILLibrary = CD3DX12_SHADER_BYTECODE((void *)g_pSimpleRayTracing, ARRAYSIZE(g_pSimpleRayTracing));
+            libraryDesc.NumExports = ARRAYSIZE(exports);
+            libraryDesc.pExports = exports;
+            D3D12_STATE_SUBOBJECT DxilLibrarySubObject = {};
+            DxilLibrarySubObject.Type = D3D12_STATE_SUBOBJECT_TYPE_DXIL_LIBRARY;
+            DxilLibrarySubObject.pDesc = &libraryDesc;
+            subObjects.push_back(DxilLibrarySubObject);
+
+            D3D12_STATE_OBJECT_DESC stateObject;
+            stateObject.NumSubobjects = (UINT)subObjects.size();
+            stateObject.pSubobjects = subObjects.data();
+            stateObject.Type = D3D12_STATE_OBJECT_TYPE_RAYTRACING_PIPELINE;
+
+            useDesc(stateObject);
+        }
 
         D3D12Context m_d3d12Context;
     };
@@ -2792,7 +3268,14 @@ namespace FallbackLayerUnitTests
             TestCalculateSceneAABBPass(1000, SceneType::BottomLevelBVHs);
         }
 
-        void TestCalculateSceneAABBPass(UINT numElements, SceneType sceneType)
+        TEST_METHOD(TestCalculateTriangleSceneAABBPassRepeated)
+        {
+            // The groups are merged by the last one to finish, so make sure that works
+            // across many groups and that the group counter is ready for the next build
+            TestCalculateSceneAABBPass(50000, SceneType::Triangles, 3);
+        }
+
+        void TestCalculateSceneAABBPass(UINT numElements, SceneType sceneType, UINT numBuilds = 1)
         {
             AABB expectedAABB;
             std::vector<byte> outputData;
@@ -2818,7 +3301,10 @@ namespace FallbackLayerUnitTests
             CComPtr<ID3D12GraphicsCommandList> pCommandList;
             m_d3d12Context.GetGraphicsCommandList(&pCommandList);
 
-            sceneAABBCalculator.CalculateSceneAABB(pCommandList, sceneType, pInputBuffer->GetGPUVirtualAddress(), numElements, pScratchBuffer->GetGPUVirtualAddress(), pOutputAABBBuffer->GetGPUVirtualAddress());
+            for (UINT i = 0; i < numBuilds; i++)
+            {
+                sceneAABBCalculator.CalculateSceneAABB(pCommandList, sceneType, pInputBuffer->GetGPUVirtualAddress(), numElements, pScratchBuffer->GetGPUVirtualAddress(), pOutputAABBBuffer->GetGPUVirtualAddress());
+            }
             pCommandList->Close();
 
             m_d3d12Context.ExecuteCommandList(pCommandList);
@@ -2854,11 +3340,95 @@ namespace FallbackLayerUnitTests
             TestCalculatingAndSortingMortonCodes(5000, SceneType::BottomLevelBVHs);
         }
 
-        void TestSortingMortonCodes(UINT numTriangles, std::vector<MortonCodeIndexPair> &expectedMortonCodes, ID3D12Resource *pMortonCodeBuffer, ID3D12Resource *pIndexBuffer)
-            // Now try the sorting pass
+        TEST_METHOD(CalculatingAndRadixSortingMortonCodesMedium)
         {
-            CComPtr<ID3D12GraphicsCommandList> pCommandList;
-            m_d3d12Context.GetGraphicsCommandList(&pCommandList);
+            TestCalculatingAndSortingMortonCodes(300, SceneType::Triangles, true);
+        }
+
+        TEST_METHOD(CalculatingAndRadixSortingMortonCodesLarge)
+        {
+            TestCalculatingAndSortingMortonCodes(5000, SceneType::Triangles, true);
+        }
+
+        TEST_METHOD(CalculatingAndRadixSortingMortonCodesBVHLarge)
+        {
+            TestCalculatingAndSortingMortonCodes(5000, SceneType::BottomLevelBVHs, true);
+        }
+
+        TEST_METHOD(RadixSorting64BitKeys)
+        {
+            TestRadixSorting64BitKeys(5000);
+        }
+
+        void TestRadixSorting64BitKeys(UINT numElements)
+        {
+            // Few enough distinct high words that many keys only differ in the low word, plus exact duplicates
+            // to check the sort is stable
+            std::vector<UINT64> keys(numElements);
+            std::vector<UINT32> indices(numElements);
+            for (UINT i = 0; i < numElements; i++)
+            {
+                UINT64 highWord = rand() % 64;
+                UINT64 lowWord = ((UINT32)rand() << 16) ^ (UINT32)rand();
+                keys[i] = (i % 8 == 0 && i > 0) ? keys[i - 1] : (highWord << 32) | lowWord;
+                indices[i] = i;
+            }
+
+            auto &d3d12Device = m_d3d12Context.GetDevice();
+            D3D12_HEAP_PROPERTIES defaultHeapProperties = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT);
+
+            CComPtr<ID3D12Resource> pKeyBuffer, pIndexBuffer, pScratchBuffer;
+            auto keyBufferDesc = CD3DX12_RESOURCE_DESC::Buffer(numElements * sizeof(UINT64), D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
+            AssertSucceeded(d3d12Device.CreateCommittedResource(&defaultHeapProperties, D3D12_HEAP_FLAG_NONE, &keyBufferDesc, D3D12_RESOURCE_STATE_COPY_DEST, nullptr, IID_PPV_ARGS(&pKeyBuffer)));
+            auto indexBufferDesc = CD3DX12_RESOURCE_DESC::Buffer(numElements * sizeof(UINT32), D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
+            AssertSucceeded(d3d12Device.CreateCommittedResource(&defaultHeapProperties, D3D12_HEAP_FLAG_NONE, &indexBufferDesc, D3D12_RESOURCE_STATE_COPY_DEST, nullptr, IID_PPV_ARGS(&pIndexBuffer)));
+            auto scratchBufferDesc = CD3DX12_RESOURCE_DESC::Buffer(RadixSort::RequiredSizeForScratchBuffer(numElements, true), D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
+            AssertSucceeded(d3d12Device.CreateCommittedResource(&defaultHeapProperties, D3D12_HEAP_FLAG_NONE, &scratchBufferDesc, D3D12_RESOURCE_STATE_UNORDERED_ACCESS, nullptr, IID_PPV_ARGS(&pScratchBuffer)));
+
+            CComPtr<ID3D12Resource> pKeyUpload, pIndexUpload;
+            m_d3d12Context.CreateResourceWithInitialData(keys.data(), keys.size() * sizeof(UINT64), &pKeyUpload);
+            m_d3d12Context.CreateResourceWithInitialData(indices.data(), indices.size() * sizeof(UINT32), &pIndexUpload);
+
+            CComPtr<ID3D12GraphicsCommandList> pCommandList;
+            m_d3d12Context.GetGraphicsCommandList(&pCommandList);
+            pCommandList->CopyBufferRegion(pKeyBuffer, 0, pKeyUpload, 0, keys.size() * sizeof(UINT64));
+            pCommandList->CopyBufferRegion(pIndexBuffer, 0, pIndexUpload, 0, indices.size() * sizeof(UINT32));
+
+            D3D12_RESOURCE_BARRIER toUAVBarriers[] = {
+                CD3DX12_RESOURCE_BARRIER::Transition(pKeyBuffer, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_UNORDERED_ACCESS),
+                CD3DX12_RESOURCE_BARRIER::Transition(pIndexBuffer, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_UNORDERED_ACCESS)
+            };
+            pCommandList->ResourceBarrier(ARRAYSIZE(toUAVBarriers), toUAVBarriers);
+
+            RadixSort radixSorter(&m_d3d12Context.GetDevice(), 0);
+            radixSorter.Sort(pCommandList, pKeyBuffer->GetGPUVirtualAddress(), pIndexBuffer->GetGPUVirtualAddress(), pScratchBuffer->GetGPUVirtualAddress(), numElements, true, true);
+
+            D3D12_RESOURCE_BARRIER toReadBackBarriers[] = {
+                CD3DX12_RESOURCE_BARRIER::Transition(pKeyBuffer, D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_COPY_SOURCE),
+                CD3DX12_RESOURCE_BARRIER::Transition(pIndexBuffer, D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_COPY_SOURCE)
+            };
+            pCommandList->ResourceBarrier(ARRAYSIZE(toReadBackBarriers), toReadBackBarriers);
+
+            pCommandList->Close();
+            m_d3d12Context.ExecuteCommandList(pCommandList);
+
+            std::vector<UINT64> sortedKeys(numElements);
+            std::vector<UINT32> sortedIndices(numElements);
+            m_d3d12Context.ReadbackResource(pKeyBuffer, sortedKeys.data(), (UINT)(sortedKeys.size() * sizeof(UINT64)));
+            m_d3d12Context.ReadbackResource(pIndexBuffer, sortedIndices.data(), (UINT)(sortedIndices.size() * sizeof(UINT32)));
+
+            std::stable_sort(indices.begin(), indices.end(), [&keys](UINT32 a, UINT32 b) { return keys[a] < keys[b]; });
+            for (UINT i = 0; i < numElements; i++)
+            {
+                Assert::IsTrue(indices[i] == sortedIndices[i] && keys[indices[i]] == sortedKeys[i], L"Sorted 64-bit keys incorrect");
+            }
+        }
+
+        void TestSortingMortonCodes(UINT numTriangles, std::vector<MortonCodeIndexPair> &expectedMortonCodes, ID3D12Resource *pMortonCodeBuffer, ID3D12Resource *pIndexBuffer, bool useRadixSort)
+            // Now try the sorting pass
+        {
+            CComPtr<ID3D12GraphicsCommandList> pCommandList;
+            m_d3d12Context.GetGraphicsCommandList(&pCommandList);
 
             D3D12_RESOURCE_BARRIER toUAVBarriers[] = {
                 CD3DX12_RESOURCE_BARRIER::Transition(pMortonCodeBuffer, D3D12_RESOURCE_STATE_COPY_SOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS),
@@ -2866,8 +3436,22 @@ namespace FallbackLayerUnitTests
             };
             pCommandList->ResourceBarrier(ARRAYSIZE(toUAVBarriers), toUAVBarriers);
 
-            BitonicSort bitonicSorter(&m_d3d12Context.GetDevice(), 0);
-            bitonicSorter.Sort(pCommandList, pMortonCodeBuffer->GetGPUVirtualAddress(), pIndexBuffer->GetGPUVirtualAddress(), numTriangles, false, true);
+            CComPtr<ID3D12Resource> pScratchBuffer;
+            if (useRadixSort)
+            {
+                auto &d3d12Device = m_d3d12Context.GetDevice();
+                D3D12_HEAP_PROPERTIES defaultHeapProperties = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT);
+                auto scratchBufferDesc = CD3DX12_RESOURCE_DESC::Buffer(RadixSort::RequiredSizeForScratchBuffer(numTriangles), D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
+                AssertSucceeded(d3d12Device.CreateCommittedResource(&defaultHeapProperties, D3D12_HEAP_FLAG_NONE, &scratchBufferDesc, D3D12_RESOURCE_STATE_UNORDERED_ACCESS, nullptr, IID_PPV_ARGS(&pScratchBuffer)));
+
+                RadixSort radixSorter(&m_d3d12Context.GetDevice(), 0);
+                radixSorter.Sort(pCommandList, pMortonCodeBuffer->GetGPUVirtualAddress(), pIndexBuffer->GetGPUVirtualAddress(), pScratchBuffer->GetGPUVirtualAddress(), numTriangles, true);
+            }
+            else
+            {
+                BitonicSort bitonicSorter(&m_d3d12Context.GetDevice(), 0);
+                bitonicSorter.Sort(pCommandList, pMortonCodeBuffer->GetGPUVirtualAddress(), pIndexBuffer->GetGPUVirtualAddress(), numTriangles, false, true);
+            }
 
             auto toReadBackBarrier = CD3DX12_RESOURCE_BARRIER::Transition(pMortonCodeBuffer, D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_COPY_SOURCE);
             pCommandList->ResourceBarrier(1, &toReadBackBarrier);
@@ -2887,7 +3471,7 @@ namespace FallbackLayerUnitTests
             }
         }
 
-        void TestCalculatingAndSortingMortonCodes(UINT numElements, SceneType sceneType)
+        void TestCalculatingAndSortingMortonCodes(UINT numElements, SceneType sceneType, bool useRadixSort = false)
         {
             AABB sceneAABB;
             std::vector<byte> outputData;
@@ -2941,7 +3525,7 @@ namespace FallbackLayerUnitTests
                 Assert::IsTrue(IsMortonCodeEqual(expectedMortonCodes[i].MortonCode, calculatedMortonCodes[i]), L"Calculated morton code is incorrect");
             }
 
-            TestSortingMortonCodes(numElements, expectedMortonCodes, pOutputMortonCodeBuffer, pOutputIndexBuffer);
+            TestSortingMortonCodes(numElements, expectedMortonCodes, pOutputMortonCodeBuffer, pOutputIndexBuffer, useRadixSort);
         }
 
         TEST_METHOD(TreeletReorderingFastTrace)
@@ -4081,4 +4665,676 @@ namespace FallbackLayerUnitTests
         D3D12Context m_d3d12Context = D3D12Context(D3D12Context::CreationFlags::ForceHardware);
         std::unique_ptr<DescriptorHeapStack> m_pDescriptorHeapStack;
     };
+
+    // Measures the BVH builders rather than testing them: for each mesh it reports how long every
+    // builder takes, the SAH cost and node count of what it builds, and how fast the traversal
+    // shader traces against the result. The numbers are written to the test output so that builder
+    // changes can be compared before and after. Runs that only care about correctness can skip the
+    // class with /TestCaseFilter:"Category!=Benchmark".
+    //
+    // The meshes are generated so that the results don't depend on assets outside this project, at
+    // triangle counts similar to the sample scenes.
+    TEST_CLASS(AccelerationStructureBenchmarks)
+    {
+        BEGIN_TEST_CLASS_ATTRIBUTE()
+            TEST_CLASS_ATTRIBUTE(L"Category", L"Benchmark")
+        END_TEST_CLASS_ATTRIBUTE()
+
+    public:
+        TEST_METHOD_INITIALIZE(MethodSetup)
+        {
+            auto &d3d12device = m_d3d12Context.GetDevice();
+            AssertSucceeded(D3D12CreateRaytracingFallbackDevice(
+                &d3d12device,
+                CreateRaytracingFallbackDeviceFlags::ForceComputeFallback,
+                0,
+                IID_PPV_ARGS(&m_pRaytracingDevice)));
+
+            CD3DX12_DESCRIPTOR_RANGE UAVDescriptor;
+            UAVDescriptor.Init(D3D12_DESCRIPTOR_RANGE_TYPE_UAV, 1, 0);
+            CD3DX12_ROOT_PARAMETER rootParameters[NumParameters];
+            rootParameters[OutputViewSlot].InitAsDescriptorTable(1, &UAVDescriptor);
+            rootParameters[AccelerationStructureSlot].InitAsShaderResourceView(0);
+            rootParameters[ViewportConstantSlot].InitAsConstants(SizeOfInUint32(RayGenViewport), 0, 0);
+            CD3DX12_ROOT_SIGNATURE_DESC rootSignatureDesc(ARRAYSIZE(rootParameters), rootParameters);
+
+            CComPtr<ID3DBlob> pRootSignatureBlob;
+            AssertSucceeded(m_pRaytracingDevice->D3D12SerializeRootSignature(&rootSignatureDesc, D3D_ROOT_SIGNATURE_VERSION_1, &pRootSignatureBlob, nullptr));
+            AssertSucceeded(m_pRaytracingDevice->CreateRootSignature(1, pRootSignatureBlob->GetBufferPointer(), pRootSignatureBlob->GetBufferSize(), IID_PPV_ARGS(&m_pRootSignature)));
+
+            auto descriptorHeapType = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
+            m_pDescriptorHeapStack = std::unique_ptr<DescriptorHeapStack>(
+                new DescriptorHeapStack(d3d12device, 64, descriptorHeapType, 0));
+
+            auto defaultHeapProperties = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT);
+            auto uavDesc = CD3DX12_RESOURCE_DESC::Tex2D(DXGI_FORMAT_R8G8B8A8_UNORM, cTraceWidth, cTraceHeight, 1, 1, 1, 0, D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
+            AssertSucceeded(d3d12device.CreateCommittedResource(&defaultHeapProperties, D3D12_HEAP_FLAG_NONE, &uavDesc, D3D12_RESOURCE_STATE_UNORDERED_ACCESS, nullptr, IID_PPV_ARGS(&m_pRaytracingOutputResource)));
+
+            D3D12_CPU_DESCRIPTOR_HANDLE uavDescriptorHandle;
+            UINT uavDescriptorHeapIndex;
+            m_pDescriptorHeapStack->AllocateDescriptor(uavDescriptorHandle, uavDescriptorHeapIndex);
+            d3d12device.CreateUnorderedAccessView(m_pRaytracingOutputResource, nullptr, nullptr, uavDescriptorHandle);
+            m_UAVGpuDescriptor = m_pDescriptorHeapStack->GetGpuHandle(uavDescriptorHeapIndex);
+
+            D3D12_QUERY_HEAP_DESC queryHeapDesc = {};
+            queryHeapDesc.Type = D3D12_QUERY_HEAP_TYPE_TIMESTAMP;
+            queryHeapDesc.Count = 2;
+            AssertSucceeded(d3d12device.CreateQueryHeap(&queryHeapDesc, IID_PPV_ARGS(&m_pTimestampHeap)));
+
+            auto readbackHeapProperties = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_READBACK);
+            auto readbackDesc = CD3DX12_RESOURCE_DESC::Buffer(2 * sizeof(UINT64));
+            AssertSucceeded(d3d12device.CreateCommittedResource(&readbackHeapProperties, D3D12_HEAP_FLAG_NONE, &readbackDesc, D3D12_RESOURCE_STATE_COPY_DEST, nullptr, IID_PPV_ARGS(&m_pTimestampReadback)));
+            AssertSucceeded(m_d3d12Context.GetQueue().GetTimestampFrequency(&m_timestampFrequency));
+
+            BuildSimpleStateObject();
+        }
+
+        TEST_METHOD(BenchmarkTerrain)
+        {
+            // A heightfield, the large, evenly tessellated surfaces of a level
+            BenchmarkMesh mesh = { L"Terrain" };
+            const UINT quadsPerTile = 64;
+            const UINT tilesPerSide = 4;
+            const UINT quadsPerSide = quadsPerTile * tilesPerSide;
+            auto Height = [](float x, float y)
+            {
+                return 1.0f + 0.2f * sin(6.0f * x) * cos(5.0f * y) + 0.05f * sin(40.0f * x + 30.0f * y);
+            };
+
+            for (UINT tileY = 0; tileY < tilesPerSide; tileY++)
+            {
+                for (UINT tileX = 0; tileX < tilesPerSide; tileX++)
+                {
+                    std::vector<float> vertices;
+                    for (UINT y = 0; y <= quadsPerTile; y++)
+                    {
+                        for (UINT x = 0; x <= quadsPerTile; x++)
+                        {
+                            float u = -1.0f + 2.0f * (tileX * quadsPerTile + x) / quadsPerSide;
+                            float v = -1.0f + 2.0f * (tileY * quadsPerTile + y) / quadsPerSide;
+                            vertices.insert(vertices.end(), { u, v, Height(u, v) });
+                        }
+                    }
+
+                    std::vector<UINT16> indices;
+                    const UINT16 verticesPerRow = quadsPerTile + 1;
+                    for (UINT16 y = 0; y < quadsPerTile; y++)
+                    {
+                        for (UINT16 x = 0; x < quadsPerTile; x++)
+                        {
+                            UINT16 corner = (UINT16)(y * verticesPerRow + x);
+                            indices.insert(indices.end(), {
+                                corner, (UINT16)(corner + verticesPerRow), (UINT16)(corner + 1),
+                                (UINT16)(corner + 1), (UINT16)(corner + verticesPerRow), (UINT16)(corner + verticesPerRow + 1) });
+                        }
+                    }
+                    mesh.AddTriangles(vertices, indices);
+                }
+            }
+
+            RunBottomLevelBenchmark(mesh);
+        }
+
+        TEST_METHOD(BenchmarkClutter)
+        {
+            // Boxes of very different sizes in front of a wall, like the props filling an interior
+            BenchmarkMesh mesh = { L"Clutter" };
+            mesh.AddTriangles({ -1, -1, 1.5f, -1, 1, 1.5f, 1, -1, 1.5f, 1, 1, 1.5f }, { 0, 1, 2, 2, 1, 3 });
+
+            srand(0);
+            const UINT numBoxes = 10000;
+            for (UINT i = 0; i < numBoxes; i++)
+            {
+                float size = RandomFloat(0.005f, 0.08f);
+                float x = RandomFloat(-1.0f, 1.0f - size);
+                float y = RandomFloat(-1.0f, 1.0f - size);
+                float z = RandomFloat(0.5f, 1.4f - size);
+
+                std::vector<float> vertices;
+                for (UINT corner = 0; corner < 8; corner++)
+                {
+                    vertices.insert(vertices.end(), {
+                        x + (corner & 1 ? size : 0),
+                        y + (corner & 2 ? size : 0),
+                        z + (corner & 4 ? size : 0) });
+                }
+                mesh.AddTriangles(vertices, {
+                    0, 2, 1, 1, 2, 3,   4, 5, 6, 5, 7, 6,
+                    0, 1, 4, 1, 5, 4,   2, 6, 3, 3, 6, 7,
+                    0, 4, 2, 2, 4, 6,   1, 3, 5, 3, 7, 5 });
+            }
+
+            RunBottomLevelBenchmark(mesh);
+        }
+
+        TEST_METHOD(BenchmarkFoliage)
+        {
+            // Small, randomly oriented triangles that overlap each other, the worst case for any BVH
+            BenchmarkMesh mesh = { L"Foliage" };
+
+            srand(0);
+            const UINT numTriangles = 120000;
+            const float triangleRadius = 0.02f;
+            for (UINT i = 0; i < numTriangles; i++)
+            {
+                float x = RandomFloat(-1.0f + triangleRadius, 1.0f - triangleRadius);
+                float y = RandomFloat(-1.0f + triangleRadius, 1.0f - triangleRadius);
+                float z = RandomFloat(0.5f + triangleRadius, 1.5f - triangleRadius);
+
+                std::vector<float> vertices;
+                for (UINT vertex = 0; vertex < 3; vertex++)
+                {
+                    vertices.insert(vertices.end(), {
+                        x + RandomFloat(-triangleRadius, triangleRadius),
+                        y + RandomFloat(-triangleRadius, triangleRadius),
+                        z + RandomFloat(-triangleRadius, triangleRadius) });
+                }
+                mesh.AddTriangles(vertices, { 0, 1, 2 });
+            }
+
+            RunBottomLevelBenchmark(mesh);
+        }
+
+        TEST_METHOD(BenchmarkTopLevel)
+        {
+            // Many copies of one small bottom level, like a scene made of instanced props
+            const UINT instancesPerSide = 128;
+            const float cellSize = 2.0f / instancesPerSide;
+
+            BenchmarkMesh mesh = { L"Cube" };
+            std::vector<float> vertices;
+            for (UINT corner = 0; corner < 8; corner++)
+            {
+                vertices.insert(vertices.end(), { corner & 1 ? 1.0f : 0.0f, corner & 2 ? 1.0f : 0.0f, corner & 4 ? 1.0f : 0.0f });
+            }
+            mesh.AddTriangles(vertices, {
+                0, 2, 1, 1, 2, 3,   4, 5, 6, 5, 7, 6,
+                0, 1, 4, 1, 5, 4,   2, 6, 3, 3, 6, 7,
+                0, 4, 2, 2, 4, 6,   1, 3, 5, 3, 7, 5 });
+
+            CComPtr<ID3D12Resource> pBottomLevel;
+            double bottomLevelBuildMilliseconds;
+            BuildOnGpu(mesh, D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_PREFER_FAST_TRACE, &pBottomLevel, bottomLevelBuildMilliseconds);
+
+            srand(0);
+            std::vector<D3D12_RAYTRACING_FALLBACK_INSTANCE_DESC> instanceDescs(instancesPerSide * instancesPerSide);
+            for (UINT i = 0; i < instanceDescs.size(); i++)
+            {
+                float scale = cellSize * RandomFloat(0.25f, 1.0f);
+                float transform[FloatsPerMatrix] = {
+                    scale, 0, 0, -1.0f + cellSize * (i % instancesPerSide),
+                    0, scale, 0, -1.0f + cellSize * (i / instancesPerSide),
+                    0, 0, scale, RandomFloat(0.5f, 1.5f - scale) };
+                memcpy(instanceDescs[i].Transform, transform, sizeof(transform));
+            }
+
+            LPCWSTR buildNames[] = { L"GPU LBVH fast build", L"GPU LBVH fast trace" };
+            D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAGS buildFlags[] = {
+                D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_PREFER_FAST_BUILD,
+                D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_PREFER_FAST_TRACE };
+            for (UINT i = 0; i < ARRAYSIZE(buildFlags); i++)
+            {
+                double buildMilliseconds;
+                BuildTopLevel(pBottomLevel, instanceDescs, buildFlags[i], buildMilliseconds);
+                double megaRaysPerSecond = MeasureTraceRate();
+
+                WCHAR message[256];
+                swprintf_s(message, L"Top level, %u instances, %s: build %.3f ms, %.1f Mrays/s\n",
+                    (UINT)instanceDescs.size(), buildNames[i], buildMilliseconds, megaRaysPerSecond);
+                Logger::WriteMessage(message);
+            }
+        }
+
+    private:
+        static const UINT cNumIterations = 5;
+        static const UINT cTraceWidth = 1024;
+        static const UINT cTraceHeight = 1024;
+
+        // Same layout as TracingTests, which also trace with SimpleRayTracing.hlsl
+        struct RayGenViewport
+        {
+            float Left;
+            float Top;
+            float Right;
+            float Bottom;
+            unsigned DispatchDimensionWidth;
+            unsigned DispatchDimensionHeight;
+            unsigned RayFlags;
+            unsigned InstanceInclusionMask;
+        };
+
+        enum RootSignatureParams
+        {
+            AccelerationStructureSlot = 0,
+            OutputViewSlot,
+            ViewportConstantSlot,
+            NumParameters
+        };
+
+        // Meshes fit in x, y = [-1, 1] and z = [0.5, 1.5], so the rays SimpleRayTracing.hlsl shoots
+        // down +z from the unit square cover all of them. The CPU builder only reads 16-bit indices,
+        // so a mesh is split into geometries of up to 64k vertices.
+        struct BenchmarkGeometry
+        {
+            std::vector<float> Vertices;
+            std::vector<UINT16> Indices;
+
+            CpuGeometryDescriptor GetDescriptor() const
+            {
+                return CpuGeometryDescriptor(Vertices.data(), (UINT)Vertices.size() / 3, Indices.data(), (UINT)Indices.size(), DXGI_FORMAT_R16_UINT);
+            }
+        };
+
+        struct BenchmarkMesh
+        {
+            LPCWSTR Name;
+            std::vector<BenchmarkGeometry> Geometries;
+
+            void AddTriangles(const std::vector<float> &vertices, const std::vector<UINT16> &indices)
+            {
+                const size_t maxVerticesPerGeometry = 0x10000;
+                const size_t numVertices = vertices.size() / 3;
+                if (Geometries.empty() || Geometries.back().Vertices.size() / 3 + numVertices > maxVerticesPerGeometry)
+                {
+                    Geometries.emplace_back();
+                }
+
+                BenchmarkGeometry &geometry = Geometries.back();
+                const UINT16 baseVertex = (UINT16)(geometry.Vertices.size() / 3);
+                geometry.Vertices.insert(geometry.Vertices.end(), vertices.begin(), vertices.end());
+                for (UINT16 index : indices)
+                {
+                    geometry.Indices.push_back(baseVertex + index);
+                }
+            }
+
+            UINT GetTriangleCount() const
+            {
+                UINT numTriangles = 0;
+                for (auto &geometry : Geometries)
+                {
+                    numTriangles += (UINT)geometry.Indices.size() / 3;
+                }
+                return numTriangles;
+            }
+        };
+
+        static float RandomFloat(float min, float max)
+        {
+            return min + (max - min) * (rand() / (float)RAND_MAX);
+        }
+
+        void RunBottomLevelBenchmark(const BenchmarkMesh &mesh)
+        {
+            enum BuilderType { CpuSah, GpuLbvh, GpuLbvhWithTreelets, NumBuilderTypes };
+            LPCWSTR builderNames[NumBuilderTypes] = { L"CPU binned SAH", L"GPU LBVH", L"GPU LBVH + treelets" };
+
+            for (UINT builderType = 0; builderType < NumBuilderTypes; builderType++)
+            {
+                CComPtr<ID3D12Resource> pBottomLevel;
+                double buildMilliseconds;
+                switch (builderType)
+                {
+                case CpuSah:
+                    BuildOnCpu(mesh, &pBottomLevel, buildMilliseconds);
+                    break;
+                case GpuLbvh:
+                    BuildOnGpu(mesh, D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_PREFER_FAST_BUILD, &pBottomLevel, buildMilliseconds);
+                    break;
+                case GpuLbvhWithTreelets:
+                    BuildOnGpu(mesh, D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_PREFER_FAST_TRACE, &pBottomLevel, buildMilliseconds);
+                    break;
+                }
+
+                double sahCost;
+                UINT nodeCount;
+                EvaluateBvh(pBottomLevel, sahCost, nodeCount);
+
+                D3D12_RAYTRACING_FALLBACK_INSTANCE_DESC instanceDesc = {};
+                instanceDesc.Transform[0][0] = instanceDesc.Transform[1][1] = instanceDesc.Transform[2][2] = 1.0f;
+                double topLevelBuildMilliseconds;
+                BuildTopLevel(pBottomLevel, { instanceDesc }, D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_PREFER_FAST_BUILD, topLevelBuildMilliseconds);
+                double megaRaysPerSecond = MeasureTraceRate();
+
+                WCHAR message[256];
+                swprintf_s(message, L"%s, %u triangles, %s: build %.3f ms, SAH cost %.2f, %u nodes, %.1f Mrays/s\n",
+                    mesh.Name, mesh.GetTriangleCount(), builderNames[builderType], buildMilliseconds, sahCost, nodeCount, megaRaysPerSecond);
+                Logger::WriteMessage(message);
+            }
+        }
+
+        D3D12_RAYTRACING_ACCELERATION_STRUCTURE_PREBUILD_INFO GetPrebuildInfo(
+            const std::vector<D3D12_RAYTRACING_GEOMETRY_DESC> &geometryDescs,
+            D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAGS buildFlags)
+        {
+            D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS inputs = {};
+            inputs.Type = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL;
+            inputs.DescsLayout = D3D12_ELEMENTS_LAYOUT_ARRAY;
+            inputs.Flags = buildFlags;
+            inputs.NumDescs = (UINT)geometryDescs.size();
+            inputs.pGeometryDescs = geometryDescs.data();
+
+            D3D12_RAYTRACING_ACCELERATION_STRUCTURE_PREBUILD_INFO prebuildInfo;
+            m_pRaytracingDevice->GetRaytracingAccelerationStructurePrebuildInfo(&inputs, &prebuildInfo);
+            return prebuildInfo;
+        }
+
+        // The best of cNumIterations builds, since the first one also pays for warming up caches
+        void BuildOnGpu(const BenchmarkMesh &mesh, D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAGS buildFlags, ID3D12Resource **ppBottomLevel, double &buildMilliseconds)
+        {
+            auto &d3d12device = m_d3d12Context.GetDevice();
+
+            std::vector<CComPtr<ID3D12Resource>> vertexBuffers(mesh.Geometries.size());
+            std::vector<CComPtr<ID3D12Resource>> indexBuffers(mesh.Geometries.size());
+            std::vector<D3D12_RAYTRACING_GEOMETRY_DESC> geometryDescs;
+            for (UINT i = 0; i < mesh.Geometries.size(); i++)
+            {
+                const BenchmarkGeometry &geometry = mesh.Geometries[i];
+                m_d3d12Context.CreateResourceWithInitialData(geometry.Vertices.data(), geometry.Vertices.size() * sizeof(float), &vertexBuffers[i]);
+                m_d3d12Context.CreateResourceWithInitialData(geometry.Indices.data(), geometry.Indices.size() * sizeof(UINT16), &indexBuffers[i]);
+                geometryDescs.push_back(GetGeometryDesc(geometry.GetDescriptor(), vertexBuffers[i], indexBuffers[i]));
+            }
+
+            auto prebuildInfo = GetPrebuildInfo(geometryDescs, buildFlags);
+            CComPtr<ID3D12Resource> pScratchResource;
+            AllocateUAVBuffer(d3d12device, prebuildInfo.ScratchDataSizeInBytes, &pScratchResource);
+            AllocateUAVBuffer(d3d12device, prebuildInfo.ResultDataMaxSizeInBytes, ppBottomLevel);
+
+            D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_DESC buildDesc = {};
+            buildDesc.Inputs.Type = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL;
+            buildDesc.Inputs.DescsLayout = D3D12_ELEMENTS_LAYOUT_ARRAY;
+            buildDesc.Inputs.Flags = buildFlags;
+            buildDesc.Inputs.NumDescs = (UINT)geometryDescs.size();
+            buildDesc.Inputs.pGeometryDescs = geometryDescs.data();
+            buildDesc.DestAccelerationStructureData = (*ppBottomLevel)->GetGPUVirtualAddress();
+            buildDesc.ScratchAccelerationStructureData = pScratchResource->GetGPUVirtualAddress();
+
+            buildMilliseconds = DBL_MAX;
+            for (UINT i = 0; i < cNumIterations; i++)
+            {
+                buildMilliseconds = std::min(buildMilliseconds, RecordAndTime([&](ID3D12RaytracingFallbackCommandList *pRaytracingCommandList)
+                {
+                    pRaytracingCommandList->BuildRaytracingAccelerationStructure(&buildDesc, 0, nullptr);
+                }));
+            }
+        }
+
+        // Builds on the CPU with every hardware thread and copies the result to the GPU for tracing
+        void BuildOnCpu(const BenchmarkMesh &mesh, ID3D12Resource **ppBottomLevel, double &buildMilliseconds)
+        {
+            auto &d3d12device = m_d3d12Context.GetDevice();
+
+            std::vector<D3D12_RAYTRACING_GEOMETRY_DESC> geometryDescs;
+            for (auto &geometry : mesh.Geometries)
+            {
+                D3D12_RAYTRACING_GEOMETRY_DESC geometryDesc = GetGeometryDesc(geometry.GetDescriptor());
+                geometryDesc.Triangles.VertexBuffer.StartAddress = (D3D12_GPU_VIRTUAL_ADDRESS)geometry.Vertices.data();
+                geometryDesc.Triangles.IndexBuffer = (D3D12_GPU_VIRTUAL_ADDRESS)geometry.Indices.data();
+                geometryDescs.push_back(geometryDesc);
+            }
+
+            // The GPU builder's result size also covers the CPU builder's output
+            auto prebuildInfo = GetPrebuildInfo(geometryDescs, D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_PREFER_FAST_BUILD);
+            std::unique_ptr<BYTE[]> pData(new BYTE[prebuildInfo.ResultDataMaxSizeInBytes]);
+
+            D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_DESC buildDesc = {};
+            buildDesc.Inputs.Type = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL;
+            buildDesc.Inputs.DescsLayout = D3D12_ELEMENTS_LAYOUT_ARRAY;
+            buildDesc.Inputs.NumDescs = (UINT)geometryDescs.size();
+            buildDesc.Inputs.pGeometryDescs = geometryDescs.data();
+
+            LARGE_INTEGER frequency;
+            QueryPerformanceFrequency(&frequency);
+            buildMilliseconds = DBL_MAX;
+            for (UINT i = 0; i < cNumIterations; i++)
+            {
+                LARGE_INTEGER start, end;
+                QueryPerformanceCounter(&start);
+                BuildRaytracingAccelerationStructureOnCpu(&buildDesc, pData.get());
+                QueryPerformanceCounter(&end);
+                buildMilliseconds = std::min(buildMilliseconds, (end.QuadPart - start.QuadPart) * 1000.0 / frequency.QuadPart);
+            }
+
+            const UINT totalSize = ((BVHOffsets *)pData.get())->totalSize;
+            CComPtr<ID3D12Resource> pUploadResource;
+            m_d3d12Context.CreateResourceWithInitialData(pData.get(), totalSize, &pUploadResource);
+            AllocateUAVBuffer(d3d12device, prebuildInfo.ResultDataMaxSizeInBytes, ppBottomLevel);
+
+            CComPtr<ID3D12GraphicsCommandList> pCommandList;
+            m_d3d12Context.GetGraphicsCommandList(&pCommandList);
+            pCommandList->CopyBufferRegion(*ppBottomLevel, 0, pUploadResource, 0, totalSize);
+            pCommandList->Close();
+            m_d3d12Context.ExecuteCommandList(pCommandList);
+            m_d3d12Context.WaitForGpuWork();
+        }
+
+        // SAH cost relative to the root's surface area, with the common weights of 1.2 per node
+        // visited and 1 per triangle tested. Every leaf holds a single triangle (MAX_TRIS_IN_LEAF).
+        void EvaluateBvh(ID3D12Resource *pBottomLevel, double &sahCost, UINT &nodeCount)
+        {
+            const UINT dataSize = (UINT)pBottomLevel->GetDesc().Width;
+            std::unique_ptr<BYTE[]> pData(new BYTE[dataSize]);
+            m_d3d12Context.ReadbackResource(pBottomLevel, pData.get(), dataSize);
+
+            const BVHOffsets &offsets = *(BVHOffsets *)pData.get();
+            const AABBNode *pNodes = (AABBNode *)(pData.get() + offsets.offsetToBoxes);
+            auto SurfaceArea = [](const AABBNode &node)
+            {
+                return 8.0 * ((double)node.halfDim[0] * node.halfDim[1] + (double)node.halfDim[1] * node.halfDim[2] + (double)node.halfDim[2] * node.halfDim[0]);
+            };
+
+            const double traversalCost = 1.2;
+            const double intersectionCost = 1.0;
+            const double rootArea = std::max(SurfaceArea(pNodes[0]), DBL_MIN);
+
+            sahCost = 0.0;
+            nodeCount = 0;
+            std::vector<UINT> nodeStack(1, 0);
+            while (nodeStack.size())
+            {
+                const AABBNode &node = pNodes[nodeStack.back()];
+                nodeStack.pop_back();
+                nodeCount++;
+
+                const double area = SurfaceArea(node) / rootArea;
+                if (node.leaf)
+                {
+                    sahCost += intersectionCost * area;
+                }
+                else
+                {
+                    sahCost += traversalCost * area;
+                    nodeStack.push_back(node.internalNode.leftNodeIndex);
+                    nodeStack.push_back(node.rightNodeIndex);
+                }
+            }
+        }
+
+        void BuildTopLevel(
+            ID3D12Resource *pBottomLevel,
+            std::vector<D3D12_RAYTRACING_FALLBACK_INSTANCE_DESC> instanceDescs,
+            D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAGS buildFlags,
+            double &buildMilliseconds)
+        {
+            auto &d3d12device = m_d3d12Context.GetDevice();
+
+            UINT bottomLevelDescriptorIndex = m_pDescriptorHeapStack->AllocateBufferUav(*pBottomLevel);
+            WRAPPED_GPU_POINTER bottomLevelPointer = m_pRaytracingDevice->GetWrappedPointerSimple(bottomLevelDescriptorIndex, pBottomLevel->GetGPUVirtualAddress());
+            for (auto &instanceDesc : instanceDescs)
+            {
+                instanceDesc.AccelerationStructure = bottomLevelPointer;
+                instanceDesc.InstanceMask = 0xff;
+            }
+            CComPtr<ID3D12Resource> pInstanceDescs;
+            m_d3d12Context.CreateResourceWithInitialData(instanceDescs.data(), instanceDescs.size() * sizeof(instanceDescs[0]), &pInstanceDescs);
+
+            D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_DESC buildDesc = {};
+            D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS &inputs = buildDesc.Inputs;
+            inputs.Type = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_TYPE_TOP_LEVEL;
+            inputs.DescsLayout = D3D12_ELEMENTS_LAYOUT_ARRAY;
+            inputs.Flags = buildFlags;
+            inputs.NumDescs = (UINT)instanceDescs.size();
+            inputs.InstanceDescs = pInstanceDescs->GetGPUVirtualAddress();
+
+            D3D12_RAYTRACING_ACCELERATION_STRUCTURE_PREBUILD_INFO prebuildInfo;
+            m_pRaytracingDevice->GetRaytracingAccelerationStructurePrebuildInfo(&inputs, &prebuildInfo);
+            CComPtr<ID3D12Resource> pScratchResource;
+            AllocateUAVBuffer(d3d12device, prebuildInfo.ScratchDataSizeInBytes, &pScratchResource);
+            m_pTopLevelAccelerationStructure = nullptr;
+            AllocateUAVBuffer(d3d12device, prebuildInfo.ResultDataMaxSizeInBytes, &m_pTopLevelAccelerationStructure);
+
+            UINT topLevelDescriptorIndex = m_pDescriptorHeapStack->AllocateBufferUav(*m_pTopLevelAccelerationStructure);
+            m_TopLevelAccelerationStructurePointer = m_pRaytracingDevice->GetWrappedPointerSimple(topLevelDescriptorIndex, m_pTopLevelAccelerationStructure->GetGPUVirtualAddress());
+
+            buildDesc.DestAccelerationStructureData = m_pTopLevelAccelerationStructure->GetGPUVirtualAddress();
+            buildDesc.ScratchAccelerationStructureData = pScratchResource->GetGPUVirtualAddress();
+
+            buildMilliseconds = DBL_MAX;
+            for (UINT i = 0; i < cNumIterations; i++)
+            {
+                buildMilliseconds = std::min(buildMilliseconds, RecordAndTime([&](ID3D12RaytracingFallbackCommandList *pRaytracingCommandList)
+                {
+                    pRaytracingCommandList->BuildRaytracingAccelerationStructure(&buildDesc, 0, nullptr);
+                }));
+            }
+        }
+
+        // Primary rays from the unit square against the last top level built, best of cNumIterations
+        double MeasureTraceRate()
+        {
+            RayGenViewport viewport = { -1.0f, -1.0f, 1.0f, 1.0f, cTraceWidth, cTraceHeight, 0, 0xff };
+
+            D3D12_DISPATCH_RAYS_DESC dispatchRaysDesc = {};
+            dispatchRaysDesc.Width = cTraceWidth;
+            dispatchRaysDesc.Height = cTraceHeight;
+            dispatchRaysDesc.Depth = 1;
+            dispatchRaysDesc.HitGroupTable.StartAddress = m_pHitShaderTable->GetGPUVirtualAddress();
+            dispatchRaysDesc.HitGroupTable.SizeInBytes = m_pHitShaderTable->GetDesc().Width;
+            dispatchRaysDesc.HitGroupTable.StrideInBytes = dispatchRaysDesc.HitGroupTable.SizeInBytes;
+            dispatchRaysDesc.MissShaderTable.StartAddress = m_pMissShaderTable->GetGPUVirtualAddress();
+            dispatchRaysDesc.MissShaderTable.SizeInBytes = m_pMissShaderTable->GetDesc().Width;
+            dispatchRaysDesc.MissShaderTable.StrideInBytes = dispatchRaysDesc.MissShaderTable.SizeInBytes;
+            dispatchRaysDesc.RayGenerationShaderRecord.StartAddress = m_pRayGenShaderTable->GetGPUVirtualAddress();
+            dispatchRaysDesc.RayGenerationShaderRecord.SizeInBytes = m_pRayGenShaderTable->GetDesc().Width;
+
+            double traceMilliseconds = DBL_MAX;
+            for (UINT i = 0; i < cNumIterations; i++)
+            {
+                traceMilliseconds = std::min(traceMilliseconds, RecordAndTime([&](ID3D12RaytracingFallbackCommandList *pRaytracingCommandList)
+                {
+                    ID3D12GraphicsCommandList *pCommandList = m_pCurrentCommandList;
+                    pCommandList->SetComputeRootSignature(m_pRootSignature);
+                    pCommandList->SetComputeRoot32BitConstants(ViewportConstantSlot, SizeOfInUint32(viewport), &viewport, 0);
+                    pCommandList->SetComputeRootDescriptorTable(OutputViewSlot, m_UAVGpuDescriptor);
+                    pRaytracingCommandList->SetTopLevelAccelerationStructure(AccelerationStructureSlot, m_TopLevelAccelerationStructurePointer);
+                    pRaytracingCommandList->SetPipelineState1(m_pRaytracingStateObject);
+                    pRaytracingCommandList->DispatchRays(&dispatchRaysDesc);
+                }));
+            }
+
+            const double numRays = (double)cTraceWidth * cTraceHeight;
+            return numRays / (traceMilliseconds * 1000.0);
+        }
+
+        // Runs record on a new command list between two timestamps and returns the GPU time in
+        // milliseconds. m_pCurrentCommandList is the list being recorded for the duration of the call.
+        template<typename RecordFunction>
+        double RecordAndTime(RecordFunction record)
+        {
+            CComPtr<ID3D12GraphicsCommandList> pCommandList;
+            m_d3d12Context.GetGraphicsCommandList(&pCommandList);
+            CComPtr<ID3D12RaytracingFallbackCommandList> pRaytracingCommandList;
+            m_pRaytracingDevice->QueryRaytracingCommandList(pCommandList, IID_PPV_ARGS(&pRaytracingCommandList));
+
+            ID3D12DescriptorHeap *pDescriptorHeaps[] = { &m_pDescriptorHeapStack->GetDescriptorHeap() };
+            pRaytracingCommandList->SetDescriptorHeaps(ARRAYSIZE(pDescriptorHeaps), pDescriptorHeaps);
+
+            m_pCurrentCommandList = pCommandList;
+            pCommandList->EndQuery(m_pTimestampHeap, D3D12_QUERY_TYPE_TIMESTAMP, 0);
+            record(pRaytracingCommandList.p);
+            pCommandList->EndQuery(m_pTimestampHeap, D3D12_QUERY_TYPE_TIMESTAMP, 1);
+            pCommandList->ResolveQueryData(m_pTimestampHeap, D3D12_QUERY_TYPE_TIMESTAMP, 0, 2, m_pTimestampReadback, 0);
+            m_pCurrentCommandList = nullptr;
+
+            pCommandList->Close();
+            m_d3d12Context.ExecuteCommandList(pCommandList);
+            m_d3d12Context.WaitForGpuWork();
+
+            UINT64 *pTimestamps;
+            D3D12_RANGE readRange = { 0, 2 * sizeof(UINT64) };
+            AssertSucceeded(m_pTimestampReadback->Map(0, &readRange, (void **)&pTimestamps));
+            const double milliseconds = (pTimestamps[1] - pTimestamps[0]) * 1000.0 / m_timestampFrequency;
+            D3D12_RANGE writtenRange = {};
+            m_pTimestampReadback->Unmap(0, &writtenRange);
+            return milliseconds;
+        }
+
+        void BuildSimpleStateObject()
+        {
+            D3D12_EXPORT_DESC exports[] = {
+                { L"Hit", nullptr, D3D12_EXPORT_FLAG_NONE },
+                { L"RayGen", nullptr, D3D12_EXPORT_FLAG_NONE },
+                { L"Miss", nullptr, D3D12_EXPORT_FLAG_NONE },
+            };
+
+            std::vector<D3D12_STATE_SUBOBJECT> subObjects;
+
+            D3D12_DXIL_LIBRARY_DESC libraryDesc = {};
+            libraryDesc.DXILLibrary = CD3DX12_SHADER_BYTECODE((void *)g_pSimpleRayTracing, ARRAYSIZE(g_pSimpleRayTracing));
+            libraryDesc.NumExports = ARRAYSIZE(exports);
+            libraryDesc.pExports = exports;
+            subObjects.push_back({ D3D12_STATE_SUBOBJECT_TYPE_DXIL_LIBRARY, &libraryDesc });
+
+            D3D12_HIT_GROUP_DESC hitGroupDesc = {};
+            hitGroupDesc.ClosestHitShaderImport = L"Hit";
+            hitGroupDesc.HitGroupExport = L"HitGroup";
+            subObjects.push_back({ D3D12_STATE_SUBOBJECT_TYPE_HIT_GROUP, &hitGroupDesc });
+
+            UINT nodeMask = 1;
+            subObjects.push_back({ D3D12_STATE_SUBOBJECT_TYPE_NODE_MASK, &nodeMask });
+
+            ID3D12RootSignature *pGlobalRootSignature = m_pRootSignature;
+            subObjects.push_back({ D3D12_STATE_SUBOBJECT_TYPE_GLOBAL_ROOT_SIGNATURE, &pGlobalRootSignature });
+
+            D3D12_RAYTRACING_SHADER_CONFIG shaderConfig;
+            shaderConfig.MaxAttributeSizeInBytes = shaderConfig.MaxPayloadSizeInBytes = 8;
+            subObjects.push_back({ D3D12_STATE_SUBOBJECT_TYPE_RAYTRACING_SHADER_CONFIG, &shaderConfig });
+
+            D3D12_RAYTRACING_PIPELINE_CONFIG pipelineConfig;
+            pipelineConfig.MaxTraceRecursionDepth = 2;
+            subObjects.push_back({ D3D12_STATE_SUBOBJECT_TYPE_RAYTRACING_PIPELINE_CONFIG, &pipelineConfig });
+
+            D3D12_STATE_OBJECT_DESC stateObject;
+            stateObject.NumSubobjects = (UINT)subObjects.size();
+            stateObject.pSubobjects = subObjects.data();
+            stateObject.Type = D3D12_STATE_OBJECT_TYPE_RAYTRACING_PIPELINE;
+            ThrowFailure(m_pRaytracingDevice->CreateStateObject(&stateObject, IID_PPV_ARGS(&m_pRaytracingStateObject)));
+
+            UINT shaderIdentifierSize = m_pRaytracingDevice->GetShaderIdentifierSize();
+            m_d3d12Context.CreateResourceWithInitialData(m_pRaytracingStateObject->GetShaderIdentifier(L"Miss"), shaderIdentifierSize, &m_pMissShaderTable);
+            m_d3d12Context.CreateResourceWithInitialData(m_pRaytracingStateObject->GetShaderIdentifier(L"HitGroup"), shaderIdentifierSize, &m_pHitShaderTable);
+            m_d3d12Context.CreateResourceWithInitialData(m_pRaytracingStateObject->GetShaderIdentifier(L"RayGen"), shaderIdentifierSize, &m_pRayGenShaderTable);
+        }
+
+        // Force hardware due to WARP bugs when dealing with the uber shader, and because WARP
+        // timings say nothing about the builders
+        D3D12Context m_d3d12Context = D3D12Context(D3D12Context::CreationFlags::ForceHardware);
+        std::unique_ptr<DescriptorHeapStack> m_pDescriptorHeapStack;
+
+        CComPtr<ID3D12RaytracingFallbackDevice> m_pRaytracingDevice;
+        CComPtr<ID3D12RootSignature> m_pRootSignature;
+        CComPtr<ID3D12RaytracingFallbackStateObject> m_pRaytracingStateObject;
+        CComPtr<ID3D12Resource> m_pMissShaderTable, m_pHitShaderTable, m_pRayGenShaderTable;
+
+        CComPtr<ID3D12Resource> m_pRaytracingOutputResource;
+        D3D12_GPU_DESCRIPTOR_HANDLE m_UAVGpuDescriptor;
+
+        CComPtr<ID3D12Resource> m_pTopLevelAccelerationStructure;
+        WRAPPED_GPU_POINTER m_TopLevelAccelerationStructurePointer;
+
+        CComPtr<ID3D12QueryHeap> m_pTimestampHeap;
+        CComPtr<ID3D12Resource> m_pTimestampReadback;
+        UINT64 m_timestampFrequency;
+        ID3D12GraphicsCommandList *m_pCurrentCommandList = nullptr;
+    };
 }
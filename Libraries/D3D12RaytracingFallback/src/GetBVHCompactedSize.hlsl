@@ -24,7 +24,6 @@ void main( uint3 DTid : SV_DispatchThreadID )
 {
     if (DTid.x >= Constants.NumberOfBoundBVHs) return;
 
-    uint outputOffset = DTid.x * 4;
     uint size = 0;
     switch (DTid.x + 1)
     {
@@ -59,5 +58,15 @@ void main( uint3 DTid : SV_DispatchThreadID )
         GetBVHSize(29);
         GetBVHSize(30);
     }
-    OutputCount.Store(outputOffset, size);
+
+    if (Constants.OutputSerializationInfo)
+    {
+        // SerializedSizeInBytes and NumBottomLevelAccelerationStructurePointers as UINT64s
+        OutputCount.Store4(DTid.x * SizeOfSerializationInfo, uint4(size + SizeOfSerializedAccelerationStructureHeader, 0, 0, 0));
+    }
+    else
+    {
+        // CompactedSizeInBytes or CurrentSizeInBytes as a UINT64
+        OutputCount.Store2(DTid.x * SizeOfSizeInfo, uint2(size, 0));
+    }
 }
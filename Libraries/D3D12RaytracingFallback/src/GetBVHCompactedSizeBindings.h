@@ -16,9 +16,14 @@
 #endif
 
 #define NumberOfReadableBVHsPerDispatch 30
+#define SizeOfSizeInfo 8
+#define SizeOfSerializationInfo 16
 struct GetBVHCompactedSizeConstants
 {
     uint NumberOfBoundBVHs;
+
+    // Write a D3D12_RAYTRACING_ACCELERATION_STRUCTURE_POSTBUILD_INFO_SERIALIZATION_DESC per BVH instead of its size
+    uint OutputSerializationInfo;
 };
 
 // UAVs
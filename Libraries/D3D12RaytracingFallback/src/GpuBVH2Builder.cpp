@@ -23,6 +23,8 @@ namespace FallbackLayer
         m_loadPrimitivesPass(pDevice, nodeMask),
         m_constructHierarchyPass(pDevice, nodeMask),
         m_constructAABBPass(pDevice, nodeMask),
+        m_collapseWideBVHPass(pDevice, nodeMask),
+        m_compressTrianglesPass(pDevice, nodeMask),
         m_postBuildInfoQuery(pDevice, nodeMask),
         m_copyPass(pDevice, totalLaneCount, nodeMask),
         m_treeletReorder(pDevice, nodeMask)
@@ -61,6 +63,7 @@ namespace FallbackLayer
         buffers.sceneAABB = scratchGpuVA + scratchMemoryPartition.OffsetToSceneAABB;
         buffers.sceneAABBScratchMemory = scratchGpuVA + scratchMemoryPartition.OffsetToSceneAABBScratchMemory;
         buffers.indexBuffer = scratchGpuVA + scratchMemoryPartition.OffsetToIndexBuffer;
+        buffers.sortScratchMemory = scratchGpuVA + scratchMemoryPartition.OffsetToSortScratchMemory;
         buffers.hierarchyBuffer = scratchGpuVA + scratchMemoryPartition.OffsetToHierarchy;
         buffers.calculateAABBScratchBuffer = scratchGpuVA + scratchMemoryPartition.OffsetToCalculateAABBDispatchArgs;
         buffers.nodeCountBuffer = scratchGpuVA + scratchMemoryPartition.OffsetToPerNodeCounter;
@@ -71,6 +74,11 @@ namespace FallbackLayer
             buffers.baseTreeletsIndexBuffer = buffers.baseTreeletsCountBuffer + sizeof(UINT);
         }
 
+        if (ShouldCompressTriangles(bvhLevel, pDesc->Inputs))
+        {
+            buffers.compressedTrianglesBuffer = scratchGpuVA + scratchMemoryPartition.OffsetToCompressedTriangles;
+        }
+
         switch(bvhLevel) 
         {
             case Level::Top:
@@ -152,7 +160,35 @@ namespace FallbackLayer
         const bool updatesAllowed = updatesAllowed(pDesc->Inputs.Flags);
         const bool performUpdate = shouldPerformUpdate(pDesc->Inputs.Flags);
 
-        // Load in the leaf-node elements of the BVH and calculate the entire scene's AABB.
+        if (performUpdate)
+        {
+            // An update refits the hierarchy of the source acceleration structure, so it relies on
+            // the sort results and parent indices that were only saved if that build allowed updates.
+            if (!updatesAllowed)
+            {
+                ThrowFailure(E_INVALIDARG,
+                    L"D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_PERFORM_UPDATE requires "
+                    L"D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_ALLOW_UPDATE to be set as well");
+            }
+            // The refit happens in place, so start from a copy of the source when it lives elsewhere.
+            // A null source is treated as an in-place update of the destination.
+            if (pDesc->SourceAccelerationStructureData != 0 &&
+                pDesc->SourceAccelerationStructureData != pDesc->DestAccelerationStructureData)
+            {
+                const UINT totalNumNodes = numElements + GetNumberOfInternalNodes(numElements);
+                const UINT updateDataSize = (numElements + totalNumNodes) * sizeof(UINT);
+                m_copyPass.CopyRaytracingAccelerationStructure(
+                    pCommandList,
+                    pDesc->DestAccelerationStructureData,
+                    pDesc->SourceAccelerationStructureData,
+                    updateDataSize);
+
+                auto uavBarrier = CD3DX12_RESOURCE_BARRIER::UAV(nullptr);
+                pCommandList->ResourceBarrier(1, &uavBarrier);
+            }
+        }
+
+        // Load in the leaf-node elements of the BVH.
         LoadBVHElements(
             pCommandList,
             pDesc,
@@ -161,12 +197,11 @@ namespace FallbackLayer
             performUpdate ? buffers.outputElementBuffer   : buffers.scratchElementBuffer, // If we're updating, write straight to output.
             performUpdate ? buffers.outputMetadataBuffer  : buffers.scratchMetadataBuffer, 
             performUpdate ? buffers.outputSortCacheBuffer : 0,
-            buffers.sceneAABBScratchMemory,
-            buffers.sceneAABB,
             globalDescriptorHeap);
 
         // If we don't have PERFORM_UPDATE set, rebuild the entire hierarchy.
-        // (i.e. calc morton codes, sort, rearrange, build hierarchy, treelet reorder)
+        // (i.e. calc scene AABB, morton codes, sort, rearrange, build hierarchy, treelet reorder)
+        // Otherwise the existing hierarchy is kept and only its AABBs are refit below.
         if (!performUpdate) {
             BuildBVHHierarchy(
                 pCommandList,
@@ -181,11 +216,13 @@ namespace FallbackLayer
                 buffers.sceneAABB,
                 buffers.mortonCodeBuffer,
                 buffers.indexBuffer,
+                buffers.sortScratchMemory,
                 updatesAllowed ? buffers.outputSortCacheBuffer : 0,
                 buffers.hierarchyBuffer,
                 buffers.nodeCountBuffer,
                 buffers.baseTreeletsCountBuffer,
                 buffers.baseTreeletsIndexBuffer,
+                buffers.compressedTrianglesBuffer,
                 globalDescriptorHeap);
         }
 
@@ -202,6 +239,26 @@ namespace FallbackLayer
             updatesAllowed && !performUpdate,
             performUpdate,
             numElements);
+
+        if (buffers.compressedTrianglesBuffer)
+        {
+            m_compressTrianglesPass.StoreCompressedTriangles(
+                pCommandList,
+                pDesc->DestAccelerationStructureData,
+                buffers.compressedTrianglesBuffer,
+                numElements);
+        }
+
+#if ENABLE_WIDE_BVH
+        // Rebuilt after updates too, since the quantized bounds are derived from the refit AABBs
+        if (bvhLevel == Level::Bottom)
+        {
+            m_collapseWideBVHPass.CollapseWideBVH(
+                pCommandList,
+                pDesc->DestAccelerationStructureData,
+                numElements);
+        }
+#endif
     }
 
     void GpuBvh2Builder::LoadBVHElements(
@@ -212,8 +269,6 @@ namespace FallbackLayer
         D3D12_GPU_VIRTUAL_ADDRESS elementBuffer,
         D3D12_GPU_VIRTUAL_ADDRESS metadataBuffer,
         D3D12_GPU_VIRTUAL_ADDRESS indexBuffer,
-        D3D12_GPU_VIRTUAL_ADDRESS sceneAABBScratchMemory,
-        D3D12_GPU_VIRTUAL_ADDRESS sceneAABB,
         D3D12_GPU_DESCRIPTOR_HANDLE globalDescriptorHeap)
     {
         switch(sceneType) 
@@ -244,14 +299,6 @@ namespace FallbackLayer
                 indexBuffer);
             break;
         }
-
-        m_sceneAABBCalculator.CalculateSceneAABB(
-            pCommandList, 
-            sceneType, 
-            elementBuffer, 
-            numElements, 
-            sceneAABBScratchMemory, 
-            sceneAABB);
     }
 
     void GpuBvh2Builder::BuildBVHHierarchy(
@@ -267,13 +314,25 @@ namespace FallbackLayer
         D3D12_GPU_VIRTUAL_ADDRESS sceneAABB,
         D3D12_GPU_VIRTUAL_ADDRESS mortonCodeBuffer,
         D3D12_GPU_VIRTUAL_ADDRESS indexBuffer,
+        D3D12_GPU_VIRTUAL_ADDRESS sortScratchMemory,
         D3D12_GPU_VIRTUAL_ADDRESS outputSortCacheBuffer,
         D3D12_GPU_VIRTUAL_ADDRESS hierarchyBuffer,
         D3D12_GPU_VIRTUAL_ADDRESS nodeCountBuffer,
         D3D12_GPU_VIRTUAL_ADDRESS baseTreeletsCountBuffer,
         D3D12_GPU_VIRTUAL_ADDRESS baseTreeletsIndexBuffer,
+        D3D12_GPU_VIRTUAL_ADDRESS compressedTrianglesBuffer,
         D3D12_GPU_DESCRIPTOR_HANDLE globalDescriptorHeap) 
     {
+        m_sceneAABBCalculator.CalculateSceneAABB(
+            pCommandList, 
+            sceneType, 
+            scratchElementBuffer, 
+            numElements, 
+            sceneAABBScratchMemory, 
+            sceneAABB);
+
+        const bool use64BitMortonCodes = Use64BitMortonCodes(numElements);
+
         m_mortonCodeCalculator.CalculateMortonCodes(
             pCommandList, 
             sceneType, 
@@ -281,8 +340,19 @@ namespace FallbackLayer
             numElements, 
             sceneAABB, 
             indexBuffer, 
-            mortonCodeBuffer);
+            mortonCodeBuffer,
+            use64BitMortonCodes);
 
+#if USE_RADIX_SORT_FOR_MORTON_CODES
+        m_sorterPass.Sort(
+            pCommandList,
+            mortonCodeBuffer,
+            indexBuffer,
+            sortScratchMemory,
+            numElements,
+            true,
+            use64BitMortonCodes);
+#else
         m_sorterPass.Sort(
             pCommandList, 
             mortonCodeBuffer, 
@@ -290,6 +360,7 @@ namespace FallbackLayer
             numElements, 
             false, 
             true);
+#endif
 
         m_rearrangePass.Rearrange(
             pCommandList,
@@ -302,13 +373,25 @@ namespace FallbackLayer
             outputMetadataBuffer,
             outputSortCacheBuffer);
 
+        // Snaps the output triangles to the grid, so this has to come before anything reads them back
+        if (compressedTrianglesBuffer)
+        {
+            m_compressTrianglesPass.CompressTriangles(
+                pCommandList,
+                pDesc->DestAccelerationStructureData,
+                sceneAABB,
+                compressedTrianglesBuffer,
+                numElements);
+        }
+
         m_constructHierarchyPass.ConstructHierarchy(
             pCommandList,
             sceneType,
             mortonCodeBuffer,
             hierarchyBuffer,
             globalDescriptorHeap,
-            numElements);
+            numElements,
+            use64BitMortonCodes);
 
         if (sceneType == SceneType::Triangles) 
         {
@@ -333,16 +416,20 @@ namespace FallbackLayer
         _In_  D3D12_GPU_VIRTUAL_ADDRESS SourceAccelerationStructureData,
         _In_  D3D12_RAYTRACING_ACCELERATION_STRUCTURE_COPY_MODE Mode)
     {
-        if (Mode == D3D12_RAYTRACING_ACCELERATION_STRUCTURE_COPY_MODE_CLONE ||
-            Mode == D3D12_RAYTRACING_ACCELERATION_STRUCTURE_COPY_MODE_COMPACT)
-        {
-            m_copyPass.CopyRaytracingAccelerationStructure(pCommandList, DestAccelerationStructureData, SourceAccelerationStructureData);
-        }
-        else
+        switch (Mode)
         {
+        case D3D12_RAYTRACING_ACCELERATION_STRUCTURE_COPY_MODE_CLONE:
+        case D3D12_RAYTRACING_ACCELERATION_STRUCTURE_COPY_MODE_COMPACT:
+        case D3D12_RAYTRACING_ACCELERATION_STRUCTURE_COPY_MODE_SERIALIZE:
+        case D3D12_RAYTRACING_ACCELERATION_STRUCTURE_COPY_MODE_DESERIALIZE:
+            // Serialized data drops the update info past the BVH's total size, the same as a compacting copy
+            m_copyPass.CopyRaytracingAccelerationStructure(pCommandList, DestAccelerationStructureData, SourceAccelerationStructureData, 0, Mode);
+            break;
+        default:
             ThrowFailure(E_INVALIDARG,
                 L"The only flags supported for CopyRaytracingAccelerationStructure are: "
-                L"D3D12_RAYTRACING_ACCELERATION_STRUCTURE_COPY_MODE_CLONE/D3D12_RAYTRACING_ACCELERATION_STRUCTURE_COPY_MODE_COMPACT");
+                L"D3D12_RAYTRACING_ACCELERATION_STRUCTURE_COPY_MODE_CLONE/D3D12_RAYTRACING_ACCELERATION_STRUCTURE_COPY_MODE_COMPACT/"
+                L"D3D12_RAYTRACING_ACCELERATION_STRUCTURE_COPY_MODE_SERIALIZE/D3D12_RAYTRACING_ACCELERATION_STRUCTURE_COPY_MODE_DESERIALIZE");
         }
     }
 
@@ -365,20 +452,29 @@ namespace FallbackLayer
         scratchMemoryPartitions.OffsetToElements = totalSize;
         totalSize += ALIGN_GPU_VA_OFFSET(sizePerElement * numPrimitives);
 
-        const UINT mortonCodeBufferSize = ALIGN_GPU_VA_OFFSET(sizeof(UINT) * numPrimitives);
+        const bool use64BitMortonCodes = Use64BitMortonCodes(numPrimitives);
+        const UINT mortonCodeBufferSize = ALIGN_GPU_VA_OFFSET((use64BitMortonCodes ? sizeof(UINT64) : sizeof(UINT)) * numPrimitives);
         scratchMemoryPartitions.OffsetToMortonCodes = totalSize;
 
         const UINT indexBufferSize = ALIGN_GPU_VA_OFFSET(sizeof(UINT) * numPrimitives);
-        scratchMemoryPartitions.OffsetToIndexBuffer = scratchMemoryPartitions.OffsetToMortonCodes + indexBufferSize;
+        scratchMemoryPartitions.OffsetToIndexBuffer = scratchMemoryPartitions.OffsetToMortonCodes + mortonCodeBufferSize;
+
+#if USE_RADIX_SORT_FOR_MORTON_CODES
+        const UINT64 sortScratchSize = ALIGN_GPU_VA_OFFSET(RadixSort::RequiredSizeForScratchBuffer(numPrimitives, use64BitMortonCodes));
+#else
+        const UINT64 sortScratchSize = 0;
+#endif
+        scratchMemoryPartitions.OffsetToSortScratchMemory = scratchMemoryPartitions.OffsetToIndexBuffer + indexBufferSize;
 
         {
             // The scratch buffer used for calculating AABBs can alias over the MortonCode/IndexBuffer
             // because it's calculated before the MortonCode/IndexBuffer are needed. Additionally,
-            // the AABB buffer used for treelet reordering is done after both stages so it can also alias
+            // the AABB buffer used for treelet reordering is done after both stages so it can also alias.
+            // The sort's scratch memory is only needed while sorting, so it sits in the same region.
             scratchMemoryPartitions.OffsetToSceneAABBScratchMemory = scratchMemoryPartitions.OffsetToMortonCodes;
             INT64 sizeNeededToCalculateAABB = m_sceneAABBCalculator.ScratchBufferSizeNeeded(numPrimitives);
             INT64 sizeNeededForTreeletAABBs = TreeletReorder::RequiredSizeForAABBBuffer(numPrimitives);
-            INT64 sizeNeededByMortonCodeAndIndexBuffer = mortonCodeBufferSize + indexBufferSize;
+            INT64 sizeNeededByMortonCodeAndIndexBuffer = mortonCodeBufferSize + indexBufferSize + sortScratchSize;
             UINT64 extraBufferSize = std::max(sizeNeededToCalculateAABB, std::max(sizeNeededForTreeletAABBs, sizeNeededByMortonCodeAndIndexBuffer));
 
             totalSize += extraBufferSize;
@@ -392,7 +488,20 @@ namespace FallbackLayer
             scratchMemoryPartitions.OffsetToPerNodeCounter = sizeNeededForAABBCalculation;
             sizeNeededForAABBCalculation += ALIGN_GPU_VA_OFFSET(sizeof(UINT) * (numInternalNodes));
 
+            // Updates keep the hierarchy and skip everything but refitting the AABBs
+            scratchMemoryPartitions.TotalUpdateSize = sizeNeededForAABBCalculation;
+
             totalSize = std::max(sizeNeededForAABBCalculation, totalSize);
+
+            // The compressed triangles are staged from the rearrange until after the AABBs are built, so
+            // they sit just past the AABB calculation's scratch. That range is within the elements, which
+            // are no longer needed once they're rearranged.
+            scratchMemoryPartitions.OffsetToCompressedTriangles = ALIGN_GPU_VA_OFFSET(sizeNeededForAABBCalculation);
+            if (level == Level::Bottom)
+            {
+                totalSize = std::max(scratchMemoryPartitions.OffsetToCompressedTriangles +
+                    CompressTrianglesPass::RequiredSizeForCompressedTrianglesBuffer(numPrimitives), totalSize);
+            }
         }
 
         const UINT64 hierarchySize = ALIGN_GPU_VA_OFFSET(sizeof(HierarchyNode) * totalNumNodes);
@@ -429,6 +538,7 @@ namespace FallbackLayer
             totalNumNodes = numLeaves + GetNumberOfInternalNodes(numLeaves);
 
             pInfo->ResultDataMaxSizeInBytes = sizeof(BVHOffsets) + totalNumNodes * sizeof(AABBNode) + numLeaves * (sizeof(Primitive) + sizeof(PrimitiveMetaData));
+            pInfo->ResultDataMaxSizeInBytes += GetSizeOfWideBVHNodes(numLeaves);
         }
         break;
         case D3D12_RAYTRACING_ACCELERATION_STRUCTURE_TYPE_TOP_LEVEL:
@@ -452,6 +562,10 @@ namespace FallbackLayer
 
         pInfo->ScratchDataSizeInBytes = CalculateScratchMemoryUsage(level, numLeaves).TotalSize;
         pInfo->UpdateScratchDataSizeInBytes = 0;
+        if (updatesAllowed(pDesc->Flags))
+        {
+            pInfo->UpdateScratchDataSizeInBytes = CalculateScratchMemoryUsage(level, numLeaves).TotalUpdateSize;
+        }
     }
 
     void GpuBvh2Builder::EmitRaytracingAccelerationStructurePostbuildInfo(
@@ -460,9 +574,10 @@ namespace FallbackLayer
         _In_  UINT NumSourceAccelerationStructures,
         _In_reads_(NumSourceAccelerationStructures)  const D3D12_GPU_VIRTUAL_ADDRESS *pSourceAccelerationStructureData)
     {
-        m_postBuildInfoQuery.GetCompactedBVHSizes(
+        m_postBuildInfoQuery.GetPostBuildInfo(
             pCommandList,
             pDesc->DestBuffer,
+            pDesc->InfoType,
             NumSourceAccelerationStructures,
             pSourceAccelerationStructureData);
     }
@@ -471,4 +586,33 @@ namespace FallbackLayer
     {
         return level == Level::Bottom;
     }
+
+    // Compression is opt-in since it costs precision. Refitting would need the full precision
+    // vertices, and the format has no room for procedural primitives.
+    bool GpuBvh2Builder::ShouldCompressTriangles(Level level, const D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS &inputs)
+    {
+#if ENABLE_COMPRESSED_TRIANGLES
+        if (level != Level::Bottom ||
+            (inputs.Flags & D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_MINIMIZE_MEMORY) == 0 ||
+            updatesAllowed(inputs.Flags))
+        {
+            return false;
+        }
+
+        for (UINT elementIndex = 0; elementIndex < inputs.NumDescs; elementIndex++)
+        {
+            if (GetGeometryDesc(inputs, elementIndex).Type != D3D12_RAYTRACING_GEOMETRY_TYPE_TRIANGLES)
+            {
+                return false;
+            }
+        }
+
+        // A lone triangle is smaller without the grid in front of it
+        return GetTotalPrimitiveCount(inputs) > 1;
+#else
+        UNREFERENCED_PARAMETER(level);
+        UNREFERENCED_PARAMETER(inputs);
+        return false;
+#endif
+    }
 }
@@ -33,12 +33,25 @@ GpuBvh2Copy::GpuBvh2Copy(ID3D12Device *pDevice, UINT totalLaneCount, UINT nodeMa
 void GpuBvh2Copy::CopyRaytracingAccelerationStructure(
     _In_  ID3D12GraphicsCommandList *pCommandList,
     _In_  D3D12_GPU_VIRTUAL_ADDRESS DestAccelerationStructureData,
-    _In_  D3D12_GPU_VIRTUAL_ADDRESS SourceAccelerationStructureData)
+    _In_  D3D12_GPU_VIRTUAL_ADDRESS SourceAccelerationStructureData,
+    _In_  UINT AdditionalBytesToCopy,
+    _In_  D3D12_RAYTRACING_ACCELERATION_STRUCTURE_COPY_MODE Mode)
 {
+    UINT copyMode = GpuBvh2CopyModeClone;
+    if (Mode == D3D12_RAYTRACING_ACCELERATION_STRUCTURE_COPY_MODE_SERIALIZE)
+    {
+        copyMode = GpuBvh2CopyModeSerialize;
+    }
+    else if (Mode == D3D12_RAYTRACING_ACCELERATION_STRUCTURE_COPY_MODE_DESERIALIZE)
+    {
+        copyMode = GpuBvh2CopyModeDeserialize;
+    }
+
     pCommandList->SetComputeRootSignature(m_pRootSignature);
     pCommandList->SetPipelineState(m_pPSO);
     pCommandList->SetComputeRootUnorderedAccessView(DestBvh, DestAccelerationStructureData);
     pCommandList->SetComputeRootUnorderedAccessView(SourceBvh, SourceAccelerationStructureData);
-    pCommandList->SetComputeRoot32BitConstant(Constants, m_OptimalDispatchWidth, 0);
+    DispatchWidthConstant constants = { m_OptimalDispatchWidth, AdditionalBytesToCopy, copyMode };
+    pCommandList->SetComputeRoot32BitConstants(Constants, SizeOfInUint32(DispatchWidthConstant), &constants, 0);
     pCommandList->Dispatch(m_OptimalDispatchWidth, 1, 1);
 }
@@ -10,6 +10,16 @@
 //*********************************************************
 #pragma once
 
+// Sort Morton codes with RadixSort, whose cost is linear in the number of elements, instead of
+// BitonicSort.  The radix sort needs extra scratch memory for a second copy of the codes and indices.
+#define USE_RADIX_SORT_FOR_MORTON_CODES 1
+
+// Use 64-bit Morton codes, with 21 bits per axis instead of 10, for builds with at least
+// GpuBvh2Builder::c64BitMortonCodeThreshold elements.  A 1024^3 grid puts many primitives of a
+// large, detailed scene in the same cell, and elements with equal codes are split by index
+// rather than position.  Only the radix sort handles 64-bit keys.
+#define USE_64_BIT_MORTON_CODES USE_RADIX_SORT_FOR_MORTON_CODES
+
 namespace FallbackLayer
 {
     class GpuBvh2Builder : public IAccelerationStructureBuilder
@@ -55,6 +65,7 @@ namespace FallbackLayer
             UINT64 OffsetToElements;
             UINT64 OffsetToMortonCodes;
             UINT64 OffsetToIndexBuffer;
+            UINT64 OffsetToSortScratchMemory;
             UINT64 OffsetToHierarchy;
             UINT64 OffsetToBaseTreeletsCount;
 
@@ -62,18 +73,32 @@ namespace FallbackLayer
 
             UINT64 OffsetToCalculateAABBDispatchArgs;
             UINT64 OffsetToPerNodeCounter;
+            UINT64 OffsetToCompressedTriangles;
             UINT64 TotalSize;
+            UINT64 TotalUpdateSize;
         };
 
         ScratchMemoryPartitions CalculateScratchMemoryUsage(Level level, UINT numTriangles);
 
+        static const UINT c64BitMortonCodeThreshold = 1 << 16;
+        static bool Use64BitMortonCodes(UINT numElements)
+        {
+            return USE_64_BIT_MORTON_CODES && numElements >= c64BitMortonCodeThreshold;
+        }
+
         SceneAABBCalculator m_sceneAABBCalculator;
         MortonCodesCalculator m_mortonCodeCalculator;
+#if USE_RADIX_SORT_FOR_MORTON_CODES
+        RadixSort m_sorterPass;
+#else
         BitonicSort m_sorterPass;
+#endif
         RearrangeElementsPass m_rearrangePass;
         LoadInstancesPass m_loadInstancesPass;
         LoadPrimitivesPass m_loadPrimitivesPass;
         ConstructAABBPass m_constructAABBPass;
+        CollapseWideBVHPass m_collapseWideBVHPass;
+        CompressTrianglesPass m_compressTrianglesPass;
         ConstructHierarchyPass m_constructHierarchyPass;
         TreeletReorder m_treeletReorder;
 
@@ -89,6 +114,7 @@ namespace FallbackLayer
             D3D12_GPU_VIRTUAL_ADDRESS sceneAABB;
             D3D12_GPU_VIRTUAL_ADDRESS mortonCodeBuffer;
             D3D12_GPU_VIRTUAL_ADDRESS indexBuffer;
+            D3D12_GPU_VIRTUAL_ADDRESS sortScratchMemory;
             D3D12_GPU_VIRTUAL_ADDRESS outputSortCacheBuffer;
             D3D12_GPU_VIRTUAL_ADDRESS hierarchyBuffer;
             D3D12_GPU_VIRTUAL_ADDRESS nodeCountBuffer;
@@ -96,6 +122,7 @@ namespace FallbackLayer
             D3D12_GPU_VIRTUAL_ADDRESS baseTreeletsIndexBuffer;
             D3D12_GPU_VIRTUAL_ADDRESS calculateAABBScratchBuffer;
             D3D12_GPU_VIRTUAL_ADDRESS outputAABBParentBuffer;
+            D3D12_GPU_VIRTUAL_ADDRESS compressedTrianglesBuffer;
         };
 
         void GpuBvh2Builder::LoadGpuBVHBuffers(
@@ -133,8 +160,6 @@ namespace FallbackLayer
             D3D12_GPU_VIRTUAL_ADDRESS elementBuffer,
             D3D12_GPU_VIRTUAL_ADDRESS metadataBuffer,
             D3D12_GPU_VIRTUAL_ADDRESS indexBuffer,
-            D3D12_GPU_VIRTUAL_ADDRESS sceneAABBScratchMemory,
-            D3D12_GPU_VIRTUAL_ADDRESS sceneAABB,
             D3D12_GPU_DESCRIPTOR_HANDLE globalDescriptorHeap
         );
 
@@ -151,14 +176,17 @@ namespace FallbackLayer
             D3D12_GPU_VIRTUAL_ADDRESS sceneAABB,
             D3D12_GPU_VIRTUAL_ADDRESS mortonCodeBuffer,
             D3D12_GPU_VIRTUAL_ADDRESS indexBuffer,
+            D3D12_GPU_VIRTUAL_ADDRESS sortScratchMemory,
             D3D12_GPU_VIRTUAL_ADDRESS outputSortCacheBuffer,
             D3D12_GPU_VIRTUAL_ADDRESS hierarchyBuffer,
             D3D12_GPU_VIRTUAL_ADDRESS nodeCountBuffer,
             D3D12_GPU_VIRTUAL_ADDRESS baseTreeletsCountBuffer,
             D3D12_GPU_VIRTUAL_ADDRESS baseTreeletsIndexBuffer,
+            D3D12_GPU_VIRTUAL_ADDRESS compressedTrianglesBuffer,
             D3D12_GPU_DESCRIPTOR_HANDLE globalDescriptorHeap
         );
 
         bool GpuBvh2Builder::SupportsTreeletReordering(Level level);
+        static bool ShouldCompressTriangles(Level level, const D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS &inputs);
     };
 }
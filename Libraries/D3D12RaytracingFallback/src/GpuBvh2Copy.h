@@ -18,7 +18,9 @@ public:
     void CopyRaytracingAccelerationStructure(
         _In_  ID3D12GraphicsCommandList *pCommandList,
         _In_  D3D12_GPU_VIRTUAL_ADDRESS DestAccelerationStructureData,
-        _In_  D3D12_GPU_VIRTUAL_ADDRESS SourceAccelerationStructureData);
+        _In_  D3D12_GPU_VIRTUAL_ADDRESS SourceAccelerationStructureData,
+        _In_  UINT AdditionalBytesToCopy = 0,
+        _In_  D3D12_RAYTRACING_ACCELERATION_STRUCTURE_COPY_MODE Mode = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_COPY_MODE_CLONE);
 
 private:
     enum RootParameterSlot
@@ -14,14 +14,47 @@
 
 static const uint BytesPerLoad = 4;
 
+void StoreSerializedHeader(uint bvhSizeInBytes)
+{
+    DestBVH.Store4(0, uint4(
+        SerializedAccelerationStructureGuid0,
+        SerializedAccelerationStructureGuid1,
+        SerializedAccelerationStructureGuid2,
+        SerializedAccelerationStructureGuid3));
+    DestBVH.Store4(OffsetToSerializedVersioningData, uint4(SerializedAccelerationStructureVersion, 0, 0, 0));
+
+    // SerializedSizeInBytesIncludingHeader and DeserializedSizeInBytes as UINT64s
+    DestBVH.Store4(OffsetToSerializedSizes, uint4(bvhSizeInBytes + SizeOfSerializedAccelerationStructureHeader, 0, bvhSizeInBytes, 0));
+
+    // Bottom levels only hold self-relative offsets, and top levels keep their instance pointers
+    // in place, so there are never any pointers for the app to patch after the header
+    DestBVH.Store2(OffsetToSerializedNumBottomLevelPointers, uint2(0, 0));
+}
+
 [numthreads(GPU_BVH2_COPY_THREAD_GROUP_WIDTH, 1, 1)]
 void main( uint3 DTid : SV_DispatchThreadID )
 {
-    uint copySizeInBytes = SourceBVH.Load(OffsetToTotalSize);
+    uint sourceOffset = 0;
+    uint destOffset = 0;
+    if (Constants.CopyMode == GpuBvh2CopyModeSerialize)
+    {
+        destOffset = SizeOfSerializedAccelerationStructureHeader;
+    }
+    else if (Constants.CopyMode == GpuBvh2CopyModeDeserialize)
+    {
+        sourceOffset = SizeOfSerializedAccelerationStructureHeader;
+    }
+
+    uint copySizeInBytes = SourceBVH.Load(sourceOffset + OffsetToTotalSize) + Constants.AdditionalBytesToCopy;
+    if (Constants.CopyMode == GpuBvh2CopyModeSerialize && DTid.x == 0)
+    {
+        StoreSerializedHeader(copySizeInBytes);
+    }
+
     uint offsetToCopy = DTid.x * BytesPerLoad;
     while (offsetToCopy < copySizeInBytes)
     {
-        DestBVH.Store(offsetToCopy, SourceBVH.Load(offsetToCopy));
+        DestBVH.Store(destOffset + offsetToCopy, SourceBVH.Load(sourceOffset + offsetToCopy));
         offsetToCopy += BytesPerLoad * GPU_BVH2_COPY_THREAD_GROUP_WIDTH * Constants.DispatchWidth;
     }
 }
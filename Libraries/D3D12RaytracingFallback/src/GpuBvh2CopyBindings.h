@@ -24,9 +24,20 @@
 // CBVs
 #define DispatchWidthConstantsRegister 0
 
+// Copy modes
+#define GpuBvh2CopyModeClone 0
+#define GpuBvh2CopyModeSerialize 1
+#define GpuBvh2CopyModeDeserialize 2
+
 struct DispatchWidthConstant
 {
     uint DispatchWidth;
+
+    // Bytes past the BVH's total size to copy as well, such as the data that updates rely on
+    uint AdditionalBytesToCopy;
+
+    // Serializing writes a header ahead of the BVH, deserializing skips over it
+    uint CopyMode;
 };
 
 #ifdef HLSL
@@ -0,0 +1,125 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+#include "pch.h"
+#include "CompiledShaders/ValidateBVHClear.h"
+#include "CompiledShaders/ValidateBVHNodes.h"
+#include "CompiledShaders/ValidateBVHReachability.h"
+
+namespace FallbackLayer
+{
+    static_assert(sizeof(BVHValidationError) == SizeOfBVHValidationError, L"Incorrect sizeof for BVHValidationError");
+
+    GpuBvhValidator::GpuBvhValidator(ID3D12Device *pDevice, UINT nodeMask)
+    {
+        CD3DX12_ROOT_PARAMETER1 rootParameters[NumParameters];
+        rootParameters[AccelerationStructureSlot].InitAsUnorderedAccessView(ValidateBVHBufferRegister);
+        rootParameters[ScratchSlot].InitAsUnorderedAccessView(ValidateBVHScratchRegister);
+        rootParameters[ErrorListSlot].InitAsUnorderedAccessView(ValidateBVHErrorListRegister);
+        rootParameters[ConstantsSlot].InitAsConstants(SizeOfInUint32(ValidateBVHConstants), ValidateBVHConstantsRegister);
+
+        auto rootSignatureDesc = CD3DX12_VERSIONED_ROOT_SIGNATURE_DESC(ARRAYSIZE(rootParameters), rootParameters);
+        CreateRootSignatureHelper(pDevice, rootSignatureDesc, &m_pRootSignature);
+
+        CreatePSOHelper(pDevice, nodeMask, m_pRootSignature, COMPILED_SHADER(g_pValidateBVHClear), &m_pClearPSO);
+        CreatePSOHelper(pDevice, nodeMask, m_pRootSignature, COMPILED_SHADER(g_pValidateBVHNodes), &m_pValidateNodesPSO);
+        CreatePSOHelper(pDevice, nodeMask, m_pRootSignature, COMPILED_SHADER(g_pValidateBVHReachability), &m_pValidateReachabilityPSO);
+    }
+
+    void GpuBvhValidator::Validate(
+        _In_ ID3D12GraphicsCommandList *pCommandList,
+        _In_ D3D12_GPU_VIRTUAL_ADDRESS accelerationStructureData,
+        _In_ D3D12_RAYTRACING_ACCELERATION_STRUCTURE_TYPE type,
+        _In_ UINT numElements,
+        _In_ D3D12_GPU_VIRTUAL_ADDRESS scratchBuffer,
+        _In_ D3D12_GPU_VIRTUAL_ADDRESS errorListBuffer)
+    {
+        if (numElements == 0)
+        {
+            ThrowFailure(E_INVALIDARG, L"An acceleration structure with no elements has no BVH to validate");
+        }
+
+        ValidateBVHConstants constants;
+        constants.NumberOfElements = numElements;
+        constants.IsTopLevel = (type == D3D12_RAYTRACING_ACCELERATION_STRUCTURE_TYPE_TOP_LEVEL);
+
+        pCommandList->SetComputeRootSignature(m_pRootSignature);
+        pCommandList->SetComputeRootUnorderedAccessView(AccelerationStructureSlot, accelerationStructureData);
+        pCommandList->SetComputeRootUnorderedAccessView(ScratchSlot, scratchBuffer);
+        pCommandList->SetComputeRootUnorderedAccessView(ErrorListSlot, errorListBuffer);
+        pCommandList->SetComputeRoot32BitConstants(ConstantsSlot, SizeOfInUint32(ValidateBVHConstants), &constants, 0);
+
+        // Every pass has a thread per node, of which there are always more than elements
+        const UINT numGroups = DivideAndRoundUp<UINT>(GetNumBVHValidationNodes(numElements), THREAD_GROUP_1D_WIDTH);
+        const UINT numGroupsX = std::min(numGroups, (UINT)ValidateBVHGroupsPerRow);
+        const UINT numGroupsY = DivideAndRoundUp<UINT>(numGroups, ValidateBVHGroupsPerRow);
+
+        auto uavBarrier = CD3DX12_RESOURCE_BARRIER::UAV(nullptr);
+        pCommandList->SetPipelineState(m_pClearPSO);
+        pCommandList->Dispatch(numGroupsX, numGroupsY, 1);
+        pCommandList->ResourceBarrier(1, &uavBarrier);
+
+        pCommandList->SetPipelineState(m_pValidateNodesPSO);
+        pCommandList->Dispatch(numGroupsX, numGroupsY, 1);
+        pCommandList->ResourceBarrier(1, &uavBarrier);
+
+        pCommandList->SetPipelineState(m_pValidateReachabilityPSO);
+        pCommandList->Dispatch(numGroupsX, numGroupsY, 1);
+        pCommandList->ResourceBarrier(1, &uavBarrier);
+    }
+
+    UINT GpuBvhValidator::RequiredSizeForScratchBuffer(UINT numElements)
+    {
+        return GetBVHValidationScratchSize(numElements);
+    }
+
+    UINT GpuBvhValidator::RequiredSizeForErrorListBuffer()
+    {
+        return SizeOfBVHValidationErrorList;
+    }
+
+    static const wchar_t *GetBVHValidationErrorString(UINT errorType)
+    {
+        switch (errorType)
+        {
+        case BVHValidationErrorInvalidHeader: return L"BVH header doesn't match the number of elements";
+        case BVHValidationErrorInvalidBox: return L"Box with a NaN";
+        case BVHValidationErrorInvalidChildIndex: return L"Invalid child index";
+        case BVHValidationErrorChildNotContained: return L"AABB not contained by parent";
+        case BVHValidationErrorInvalidLeafIndex: return L"Leaf index past the last element";
+        case BVHValidationErrorPrimitiveNotContained: return L"Primitive not contained by leaf";
+        case BVHValidationErrorWideChildNotContained: return L"Node not contained by its quantized box in the wide BVH";
+        case BVHValidationErrorMultipleParents: return L"Node with more than one parent";
+        case BVHValidationErrorUnreachableNode: return L"Node not reachable from the root";
+        case BVHValidationErrorMissingLeaf: return L"Element without a leaf";
+        case BVHValidationErrorDuplicateLeaf: return L"Element with more than one leaf";
+        default: return L"Unknown error";
+        }
+    }
+
+    bool GpuBvhValidator::GetErrorMessage(_In_reads_bytes_(SizeOfBVHValidationErrorList) const BYTE *pErrorList, std::wstring &errorMessage)
+    {
+        const UINT numErrors = *(const UINT *)pErrorList;
+        const BVHValidationError *pErrors = (const BVHValidationError *)(pErrorList + OffsetToBVHValidationErrors);
+
+        errorMessage.clear();
+        for (UINT i = 0; i < std::min(numErrors, (UINT)MaxBVHValidationErrors); i++)
+        {
+            errorMessage += GetBVHValidationErrorString(pErrors[i].ErrorType);
+            errorMessage += L" (index " + std::to_wstring(pErrors[i].Index) + L")\n";
+        }
+
+        if (numErrors > MaxBVHValidationErrors)
+        {
+            errorMessage += std::to_wstring(numErrors - MaxBVHValidationErrors) + L" more errors not recorded\n";
+        }
+        return numErrors == 0;
+    }
+}
@@ -0,0 +1,54 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+#pragma once
+namespace FallbackLayer
+{
+    // Checks a BVH where it lives instead of reading it back like BvhValidator, so that
+    // validation stays cheap on large acceleration structures. Each node is checked in
+    // parallel for containment of its children and primitive, and every node and element
+    // has to be reachable from the root exactly once. The result is a short error list.
+    class GpuBvhValidator
+    {
+    public:
+        GpuBvhValidator(ID3D12Device *pDevice, UINT nodeMask);
+
+        // numElements is the number of primitives in a bottom level or instances in a top level.
+        // The scratch and error list buffers are overwritten, all three buffers need to be UAVs.
+        void Validate(
+            _In_ ID3D12GraphicsCommandList *pCommandList,
+            _In_ D3D12_GPU_VIRTUAL_ADDRESS accelerationStructureData,
+            _In_ D3D12_RAYTRACING_ACCELERATION_STRUCTURE_TYPE type,
+            _In_ UINT numElements,
+            _In_ D3D12_GPU_VIRTUAL_ADDRESS scratchBuffer,
+            _In_ D3D12_GPU_VIRTUAL_ADDRESS errorListBuffer);
+
+        static UINT RequiredSizeForScratchBuffer(UINT numElements);
+        static UINT RequiredSizeForErrorListBuffer();
+
+        // Describes every error in an error list read back from the GPU. Returns false if there are any.
+        static bool GetErrorMessage(_In_reads_bytes_(SizeOfBVHValidationErrorList) const BYTE *pErrorList, std::wstring &errorMessage);
+
+    private:
+        enum RootParameterSlot
+        {
+            AccelerationStructureSlot = 0,
+            ScratchSlot,
+            ErrorListSlot,
+            ConstantsSlot,
+            NumParameters
+        };
+
+        CComPtr<ID3D12RootSignature> m_pRootSignature;
+        CComPtr<ID3D12PipelineState> m_pClearPSO;
+        CComPtr<ID3D12PipelineState> m_pValidateNodesPSO;
+        CComPtr<ID3D12PipelineState> m_pValidateReachabilityPSO;
+    };
+}
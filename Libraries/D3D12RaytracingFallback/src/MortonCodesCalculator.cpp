@@ -32,7 +32,7 @@ namespace FallbackLayer
     }
 
 
-    void MortonCodesCalculator::CalculateMortonCodes(ID3D12GraphicsCommandList *pCommandList, SceneType sceneType, D3D12_GPU_VIRTUAL_ADDRESS elementsBuffer, UINT numElements, D3D12_GPU_VIRTUAL_ADDRESS sceneAABB, D3D12_GPU_VIRTUAL_ADDRESS outputIndices, D3D12_GPU_VIRTUAL_ADDRESS outputMortonCodes)
+    void MortonCodesCalculator::CalculateMortonCodes(ID3D12GraphicsCommandList *pCommandList, SceneType sceneType, D3D12_GPU_VIRTUAL_ADDRESS elementsBuffer, UINT numElements, D3D12_GPU_VIRTUAL_ADDRESS sceneAABB, D3D12_GPU_VIRTUAL_ADDRESS outputIndices, D3D12_GPU_VIRTUAL_ADDRESS outputMortonCodes, bool use64BitCodes)
     {
         if (numElements == 0) return;
 
@@ -49,7 +49,7 @@ namespace FallbackLayer
             assert(false);
         }
 
-        MortonCodeCalculatorConstants constants{ numElements };
+        MortonCodeCalculatorConstants constants{ numElements, use64BitCodes ? 1u : 0u };
 
         pCommandList->SetComputeRootUnorderedAccessView(InputElementsList, elementsBuffer);
         pCommandList->SetComputeRootUnorderedAccessView(OutputIndices, outputIndices);
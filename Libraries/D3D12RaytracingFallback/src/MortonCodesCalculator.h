@@ -15,7 +15,8 @@ namespace FallbackLayer
     {
     public:
         MortonCodesCalculator(ID3D12Device *pDevice, UINT nodeMask);
-        void CalculateMortonCodes(ID3D12GraphicsCommandList *pCommandList, SceneType sceneType, D3D12_GPU_VIRTUAL_ADDRESS triangleBuffer, UINT numTriangles, D3D12_GPU_VIRTUAL_ADDRESS sceneAABB, D3D12_GPU_VIRTUAL_ADDRESS outputIndices, D3D12_GPU_VIRTUAL_ADDRESS outputMortonCodes);
+        // With use64BitCodes, outputMortonCodes receives a UINT64 per element instead of a UINT
+        void CalculateMortonCodes(ID3D12GraphicsCommandList *pCommandList, SceneType sceneType, D3D12_GPU_VIRTUAL_ADDRESS triangleBuffer, UINT numTriangles, D3D12_GPU_VIRTUAL_ADDRESS sceneAABB, D3D12_GPU_VIRTUAL_ADDRESS outputIndices, D3D12_GPU_VIRTUAL_ADDRESS outputMortonCodes, bool use64BitCodes = false);
     
     private:
         enum RootParameterSlot
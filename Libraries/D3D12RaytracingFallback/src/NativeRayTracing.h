@@ -167,6 +167,18 @@ public:
         return D3D12_RESOURCE_STATE_RAYTRACING_ACCELERATION_STRUCTURE;
     }
 
+    virtual D3D12_DRIVER_MATCHING_IDENTIFIER_STATUS CheckDriverMatchingIdentifier(
+        _In_ D3D12_SERIALIZED_DATA_TYPE SerializedDataType,
+        _In_ const D3D12_SERIALIZED_DATA_DRIVER_MATCHING_IDENTIFIER *pIdentifierToCheck)
+    {
+        return m_pDevice->CheckDriverMatchingIdentifier(SerializedDataType, pIdentifierToCheck);
+    }
+
+    virtual HRESULT SetStateObjectCacheFile(_In_opt_ LPCWSTR)
+    {
+        return S_OK;
+    }
+
     virtual HRESULT STDMETHODCALLTYPE CreateStateObject(
         const D3D12_STATE_OBJECT_DESC *pDesc,
         REFIID riid,
@@ -189,6 +201,15 @@ public:
         return  hr;
     }
 
+    virtual HRESULT STDMETHODCALLTYPE CreateStateObjects(
+        UINT NumStateObjects,
+        const D3D12_STATE_OBJECT_DESC *pDescs,
+        REFIID riid,
+        _COM_Outptr_  void **ppStateObjectBatch)
+    {
+        return FallbackLayer::CreateStateObjectBatch(this, NumStateObjects, pDescs, riid, ppStateObjectBatch);
+    }
+
     virtual UINT STDMETHODCALLTYPE GetShaderIdentifierSize(void)
     {
         return D3D12_SHADER_IDENTIFIER_SIZE_IN_BYTES;
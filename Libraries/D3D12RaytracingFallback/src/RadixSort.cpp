@@ -0,0 +1,103 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#include "pch.h"
+
+#include "CompiledShaders/RadixSortCountCS.h"
+#include "CompiledShaders/RadixSortScanCS.h"
+#include "CompiledShaders/RadixSortScatterCS.h"
+
+RadixSort::RadixSort(ID3D12Device *pDevice, UINT nodeMask)
+{
+    CD3DX12_ROOT_PARAMETER1 parameters[NumParameters];
+    parameters[InputConstants].InitAsConstants(5, 0);
+    parameters[InputKeysUAV].InitAsUnorderedAccessView(0);
+    parameters[InputIndicesUAV].InitAsUnorderedAccessView(1);
+    parameters[OutputKeysUAV].InitAsUnorderedAccessView(2);
+    parameters[OutputIndicesUAV].InitAsUnorderedAccessView(3);
+    parameters[HistogramUAV].InitAsUnorderedAccessView(4);
+
+    auto rootSignatureDesc = CD3DX12_VERSIONED_ROOT_SIGNATURE_DESC(ARRAYSIZE(parameters), parameters);
+    CreateRootSignatureHelper(pDevice, rootSignatureDesc, &m_pRootSignature);
+
+    CreatePSOHelper(pDevice, nodeMask, m_pRootSignature, COMPILED_SHADER(g_pRadixSortCountCS), &m_pRadixSortCountCS);
+    CreatePSOHelper(pDevice, nodeMask, m_pRootSignature, COMPILED_SHADER(g_pRadixSortScanCS), &m_pRadixSortScanCS);
+    CreatePSOHelper(pDevice, nodeMask, m_pRootSignature, COMPILED_SHADER(g_pRadixSortScatterCS), &m_pRadixSortScatterCS);
+}
+
+UINT64 RadixSort::RequiredSizeForScratchBuffer(UINT ElementCount, bool Use64BitKeys)
+{
+    const UINT64 numBlocks = (ElementCount + cBlockSize - 1) / cBlockSize;
+    const UINT64 keySize = Use64BitKeys ? sizeof(UINT64) : sizeof(UINT);
+
+    // A second copy of the keys and indices, followed by the per-block histograms
+    return (keySize + sizeof(UINT)) * (UINT64)ElementCount + sizeof(UINT) * cNumBins * numBlocks;
+}
+
+void RadixSort::Sort(
+    ID3D12GraphicsCommandList *pCommandList,
+    D3D12_GPU_VIRTUAL_ADDRESS SortKeyBuffer,
+    D3D12_GPU_VIRTUAL_ADDRESS IndexBuffer,
+    D3D12_GPU_VIRTUAL_ADDRESS ScratchBuffer,
+    UINT ElementCount,
+    bool SortAscending,
+    bool Use64BitKeys)
+{
+    if (ElementCount == 0) return;
+
+    const UINT numBlocks = (ElementCount + cBlockSize - 1) / cBlockSize;
+    const D3D12_GPU_VIRTUAL_ADDRESS scratchKeyBuffer = ScratchBuffer;
+    const UINT keyWords = Use64BitKeys ? 2 : 1;
+    const D3D12_GPU_VIRTUAL_ADDRESS scratchIndexBuffer = scratchKeyBuffer + sizeof(UINT) * keyWords * ElementCount;
+    const D3D12_GPU_VIRTUAL_ADDRESS histogramBuffer = scratchIndexBuffer + sizeof(UINT) * ElementCount;
+
+    pCommandList->SetComputeRootSignature(m_pRootSignature);
+    pCommandList->SetComputeRootUnorderedAccessView(HistogramUAV, histogramBuffer);
+
+    D3D12_GPU_VIRTUAL_ADDRESS srcKeys = SortKeyBuffer;
+    D3D12_GPU_VIRTUAL_ADDRESS srcIndices = IndexBuffer;
+    D3D12_GPU_VIRTUAL_ADDRESS dstKeys = scratchKeyBuffer;
+    D3D12_GPU_VIRTUAL_ADDRESS dstIndices = scratchIndexBuffer;
+
+    auto uavBarrier = CD3DX12_RESOURCE_BARRIER::UAV(nullptr);
+    for (UINT digitShift = 0; digitShift < 32 * keyWords; digitShift += cRadixBits)
+    {
+        struct RadixSortConstants
+        {
+            UINT ListCount;
+            UINT NumBlocks;
+            UINT DigitShift;
+            UINT KeyFlip;
+            UINT KeyWords;
+        } constants { ElementCount, numBlocks, digitShift, SortAscending ? 0 : 0xffffffff, keyWords };
+
+        pCommandList->SetComputeRoot32BitConstants(InputConstants, SizeOfInUint32(RadixSortConstants), &constants, 0);
+        pCommandList->SetComputeRootUnorderedAccessView(InputKeysUAV, srcKeys);
+        pCommandList->SetComputeRootUnorderedAccessView(InputIndicesUAV, srcIndices);
+        pCommandList->SetComputeRootUnorderedAccessView(OutputKeysUAV, dstKeys);
+        pCommandList->SetComputeRootUnorderedAccessView(OutputIndicesUAV, dstIndices);
+
+        pCommandList->SetPipelineState(m_pRadixSortCountCS);
+        pCommandList->Dispatch(numBlocks, 1, 1);
+        pCommandList->ResourceBarrier(1, &uavBarrier);
+
+        pCommandList->SetPipelineState(m_pRadixSortScanCS);
+        pCommandList->Dispatch(1, 1, 1);
+        pCommandList->ResourceBarrier(1, &uavBarrier);
+
+        pCommandList->SetPipelineState(m_pRadixSortScatterCS);
+        pCommandList->Dispatch(numBlocks, 1, 1);
+        pCommandList->ResourceBarrier(1, &uavBarrier);
+
+        std::swap(srcKeys, dstKeys);
+        std::swap(srcIndices, dstIndices);
+    }
+}
@@ -0,0 +1,87 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+//
+// A least-significant-digit radix sort of 32-bit or 64-bit keys paired with
+// 32-bit indices.  Unlike BitonicSort, its cost is linear in the number of elements,
+// which matters when sorting the Morton codes of meshes with millions of
+// triangles.
+//
+// Each pass, eight for 32-bit keys and sixteen for 64-bit keys, sorts on one
+// 4-bit digit of the key:
+//
+//   1. Count:    Every block of 1024 elements counts how many of its keys
+//                have each digit value.  The counts are stored digit-major,
+//                i.e. Histogram[Digit * NumBlocks + Block].
+//   2. Scan:     One thread group replaces the counts with their exclusive
+//                prefix sum, which gives each block the first output slot
+//                for each digit.
+//   3. Scatter:  Every block writes its elements to their output slots,
+//                keeping elements with equal digits in their input order.
+//
+// Because every pass is stable, elements with equal keys keep the order of
+// their indices when the input indices are ascending, matching BitonicSort.
+// The passes ping-pong between the caller's buffers and a scratch buffer, and
+// with an even number of passes the result ends up back in the caller's
+// buffers.
+
+#pragma once
+
+class RadixSort
+{
+public:
+    RadixSort(ID3D12Device *pDevice, UINT nodeMask);
+
+    // Size of the scratch buffer that Sort() needs for this many elements
+    static UINT64 RequiredSizeForScratchBuffer(UINT ElementCount, bool Use64BitKeys = false);
+
+    void Sort(
+        // An existing command list
+        ID3D12GraphicsCommandList *pCommandList,
+
+        // Sort keys and the 32-bit indices that travel with them
+        D3D12_GPU_VIRTUAL_ADDRESS SortKeyBuffer,
+        D3D12_GPU_VIRTUAL_ADDRESS IndexBuffer,
+
+        // At least RequiredSizeForScratchBuffer(ElementCount) bytes of UAV memory
+        D3D12_GPU_VIRTUAL_ADDRESS ScratchBuffer,
+
+        // Count of elements in the list
+        UINT ElementCount,
+
+        // True to sort in ascending order (smallest to largest).  False to sort in descending order.
+        bool SortAscending,
+
+        // True if the keys are UINT64s rather than UINTs
+        bool Use64BitKeys = false
+    );
+
+private:
+    enum RootSignatureParams
+    {
+        InputConstants,
+        InputKeysUAV,
+        InputIndicesUAV,
+        OutputKeysUAV,
+        OutputIndicesUAV,
+        HistogramUAV,
+        NumParameters
+    };
+
+    static const UINT cRadixBits = 4;
+    static const UINT cNumBins = 1 << cRadixBits;
+    static const UINT cBlockSize = 1024;
+
+    CComPtr<ID3D12RootSignature> m_pRootSignature;
+
+    CComPtr<ID3D12PipelineState> m_pRadixSortCountCS;
+    CComPtr<ID3D12PipelineState> m_pRadixSortScanCS;
+    CComPtr<ID3D12PipelineState> m_pRadixSortScatterCS;
+};
@@ -0,0 +1,57 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#define NUM_BINS 16
+#define GROUP_SIZE 256
+#define BLOCK_SIZE 1024
+
+cbuffer Constants : register(b0)
+{
+    uint ListCount;
+    uint NumBlocks;
+    uint DigitShift;
+
+    // 0 for an ascending sort, 0xffffffff for a descending sort
+    uint KeyFlip;
+
+    // 1 for 32-bit keys, 2 for 64-bit keys stored as (low word, high word)
+    uint KeyWords;
+}
+
+RWByteAddressBuffer g_InputKeys : register(u0);
+RWByteAddressBuffer g_InputIndices : register(u1);
+RWByteAddressBuffer g_OutputKeys : register(u2);
+RWByteAddressBuffer g_OutputIndices : register(u3);
+
+// Digit-major per-block digit counts, replaced in place by their exclusive prefix sum
+RWByteAddressBuffer g_Histograms : register(u4);
+
+uint2 LoadKey(uint Element)
+{
+    if (KeyWords == 2)
+        return g_InputKeys.Load2(Element * 8);
+    else
+        return uint2(g_InputKeys.Load(Element * 4), 0);
+}
+
+void StoreKey(uint Element, uint2 Key)
+{
+    if (KeyWords == 2)
+        g_OutputKeys.Store2(Element * 8, Key);
+    else
+        g_OutputKeys.Store(Element * 4, Key.x);
+}
+
+uint GetDigit(uint2 Key)
+{
+    uint Word = DigitShift < 32 ? Key.x : Key.y;
+    return ((Word ^ KeyFlip) >> (DigitShift % 32)) & (NUM_BINS - 1);
+}
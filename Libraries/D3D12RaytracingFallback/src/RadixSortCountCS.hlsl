@@ -0,0 +1,38 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#include "RadixSortCommon.hlsli"
+
+groupshared uint gs_Counts[NUM_BINS];
+
+[numthreads(GROUP_SIZE, 1, 1)]
+void main( uint3 Gid : SV_GroupID, uint GI : SV_GroupIndex )
+{
+    if (GI < NUM_BINS)
+        gs_Counts[GI] = 0;
+
+    GroupMemoryBarrierWithGroupSync();
+
+    const uint BlockStart = Gid.x * BLOCK_SIZE;
+
+    [unroll]
+    for (uint i = 0; i < BLOCK_SIZE; i += GROUP_SIZE)
+    {
+        uint Element = BlockStart + i + GI;
+        if (Element < ListCount)
+            InterlockedAdd(gs_Counts[GetDigit(LoadKey(Element))], 1);
+    }
+
+    GroupMemoryBarrierWithGroupSync();
+
+    if (GI < NUM_BINS)
+        g_Histograms.Store((GI * NumBlocks + Gid.x) * 4, gs_Counts[GI]);
+}
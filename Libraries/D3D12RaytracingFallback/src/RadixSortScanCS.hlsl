@@ -0,0 +1,53 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+//
+// Description:  Replaces the digit-major histograms with their exclusive
+// prefix sum.  There is one histogram entry per digit per 1024 elements, so
+// a single thread group can scan them, with each thread summing a contiguous
+// run of entries.
+
+#include "RadixSortCommon.hlsli"
+
+#define SCAN_THREADS 1024
+
+groupshared uint gs_Sums[SCAN_THREADS];
+
+[numthreads(SCAN_THREADS, 1, 1)]
+void main( uint GI : SV_GroupIndex )
+{
+    const uint NumEntries = NUM_BINS * NumBlocks;
+    const uint EntriesPerThread = (NumEntries + SCAN_THREADS - 1) / SCAN_THREADS;
+    const uint RunStart = min(GI * EntriesPerThread, NumEntries);
+    const uint RunEnd = min(RunStart + EntriesPerThread, NumEntries);
+
+    uint RunSum = 0;
+    for (uint i = RunStart; i < RunEnd; ++i)
+        RunSum += g_Histograms.Load(i * 4);
+
+    gs_Sums[GI] = RunSum;
+
+    // Inclusive scan of the run sums
+    for (uint Offset = 1; Offset < SCAN_THREADS; Offset *= 2)
+    {
+        GroupMemoryBarrierWithGroupSync();
+        uint Addend = GI >= Offset ? gs_Sums[GI - Offset] : 0;
+        GroupMemoryBarrierWithGroupSync();
+        gs_Sums[GI] += Addend;
+    }
+
+    uint Prefix = gs_Sums[GI] - RunSum;
+    for (uint j = RunStart; j < RunEnd; ++j)
+    {
+        uint Count = g_Histograms.Load(j * 4);
+        g_Histograms.Store(j * 4, Prefix);
+        Prefix += Count;
+    }
+}
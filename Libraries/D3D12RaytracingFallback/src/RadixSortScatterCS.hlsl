@@ -0,0 +1,86 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+//
+// Description:  Moves every element of a block to its sorted position for
+// the current digit.  The block is processed in chunks of GROUP_SIZE elements
+// so that each element's rank among the elements with the same digit can be
+// found from a bit mask of the threads holding that digit.  Ranks follow the
+// thread index and chunks are processed in order, so the scatter is stable.
+
+#include "RadixSortCommon.hlsli"
+
+#define MASK_WORDS (GROUP_SIZE / 32)
+
+// The next output slot for each digit
+groupshared uint gs_DigitStart[NUM_BINS];
+
+// For each digit, which threads of the current chunk hold an element with that digit
+groupshared uint gs_DigitMask[NUM_BINS * MASK_WORDS];
+
+[numthreads(GROUP_SIZE, 1, 1)]
+void main( uint3 Gid : SV_GroupID, uint GI : SV_GroupIndex )
+{
+    if (GI < NUM_BINS)
+        gs_DigitStart[GI] = g_Histograms.Load((GI * NumBlocks + Gid.x) * 4);
+
+    const uint BlockStart = Gid.x * BLOCK_SIZE;
+    const uint Word = GI / 32;
+    const uint Bit = 1u << (GI % 32);
+
+    for (uint i = 0; i < BLOCK_SIZE; i += GROUP_SIZE)
+    {
+        if (GI < NUM_BINS * MASK_WORDS)
+            gs_DigitMask[GI] = 0;
+
+        GroupMemoryBarrierWithGroupSync();
+
+        const uint Element = BlockStart + i + GI;
+        const bool IsValid = Element < ListCount;
+
+        uint2 Key = 0;
+        uint Index = 0, Digit = 0;
+        if (IsValid)
+        {
+            Key = LoadKey(Element);
+            Index = g_InputIndices.Load(Element * 4);
+            Digit = GetDigit(Key);
+            InterlockedOr(gs_DigitMask[Digit * MASK_WORDS + Word], Bit);
+        }
+
+        GroupMemoryBarrierWithGroupSync();
+
+        if (IsValid)
+        {
+            // Count the threads before this one that hold the same digit
+            uint Rank = countbits(gs_DigitMask[Digit * MASK_WORDS + Word] & (Bit - 1));
+            for (uint w = 0; w < Word; ++w)
+                Rank += countbits(gs_DigitMask[Digit * MASK_WORDS + w]);
+
+            const uint Dest = gs_DigitStart[Digit] + Rank;
+            StoreKey(Dest, Key);
+            g_OutputIndices.Store(Dest * 4, Index);
+        }
+
+        GroupMemoryBarrierWithGroupSync();
+
+        // Advance each digit past the elements written by this chunk
+        if (GI < NUM_BINS)
+        {
+            uint Count = 0;
+            [unroll]
+            for (uint w = 0; w < MASK_WORDS; ++w)
+                Count += countbits(gs_DigitMask[GI * MASK_WORDS + w]);
+            gs_DigitStart[GI] += Count;
+        }
+
+        GroupMemoryBarrierWithGroupSync();
+    }
+}
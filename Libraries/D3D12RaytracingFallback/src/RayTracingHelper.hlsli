@@ -49,6 +49,11 @@ static const int OffsetToLeafNodeMetaDataOffset = 4;
 
 static const int OffsetToTotalSize = 12;
 
+// WideBVHNode
+static const int OffsetToWideBVHScaleExponents = 12;
+static const int OffsetToWideBVHChildren = 16;
+static const int OffsetToWideBVHQuantizedBounds = 32;
+
 
 int GetLeafIndexFromFlag(uint2 flag)
 {
@@ -99,6 +104,29 @@ int GetOffsetToPrimitiveMetaData(RWByteAddressBufferPointer pointer)
     return GetOffsetToOffset(pointer, OffsetToPrimitiveMetaDataOffset);
 }
 
+// Returns 0 if the bottom level was built without wide nodes, i.e. by the CPU builder
+// or with ENABLE_WIDE_BVH turned off, in which case the BVH2 nodes are traversed instead
+static
+uint GetOffsetToWideBVHNodes(RWByteAddressBufferPointer pointer)
+{
+    const uint4 offsets = pointer.buffer.Load4(pointer.offsetInBytes);
+    const uint offsetToPrimitives = offsets.y;
+    const uint offsetToPrimitiveMetaData = offsets.z;
+    const uint totalSize = offsets.w;
+
+    uint numPrimitives = (offsetToPrimitiveMetaData - offsetToPrimitives) / SizeOfPrimitive;
+#if ENABLE_COMPRESSED_TRIANGLES
+    if (pointer.buffer.Load(pointer.offsetInBytes + offsetToPrimitives) == COMPRESSED_TRIANGLES_TYPE)
+    {
+        numPrimitives = (offsetToPrimitiveMetaData - offsetToPrimitives - SizeOfCompressedTriangleGrid) / SizeOfCompressedTriangle;
+    }
+#endif
+    const uint offsetToWideBVHNodes = offsetToPrimitiveMetaData + GetOffsetFromPrimitiveMetaDataToWideBVHNodes(numPrimitives);
+    const uint sizeOfWideBVHNodes = GetSizeOfWideBVHNodes(numPrimitives);
+    const bool hasWideBVHNodes = sizeOfWideBVHNodes > 0 && totalSize >= offsetToWideBVHNodes + sizeOfWideBVHNodes;
+    return hasWideBVHNodes ? pointer.offsetInBytes + offsetToWideBVHNodes : 0;
+}
+
 bool IsLeaf(uint2 flag)
 {
     return (flag.x & IsLeafFlag);
@@ -228,6 +256,26 @@ void WriteBoxToBuffer(RWByteAddressBuffer buffer, uint boxStartOffset, uint boxI
     buffer.Store4(boxAddress + 16, data2);
 }
 
+// Both the build and traversal decode vertices with this, precise keeps the
+// result bit-identical so the boxes fit around the triangles that get tested
+float3 DecodeCompressedVertex(uint2 packedVertex, float3 origin, float3 step)
+{
+    const uint3 quantized = uint3(
+        packedVertex.x & CompressedTriangleGridSteps,
+        (packedVertex.x >> 21) | ((packedVertex.y & 0x3FF) << 11),
+        packedVertex.y >> 10);
+    precise float3 vertex = origin + float3(quantized) * step;
+    return vertex;
+}
+
+uint2 EncodeCompressedVertex(float3 vertex, float3 origin, float3 step)
+{
+    // A flat axis has a step of 0 and every vertex sits at the origin
+    const float3 steps = step > 0 ? round((vertex - origin) / max(step, 1e-37)) : 0;
+    const uint3 quantized = uint3(clamp(steps, 0, CompressedTriangleGridSteps));
+    return uint2(quantized.x | (quantized.y << 21), (quantized.y >> 11) | (quantized.z << 10));
+}
+
 static
 void BVHReadTriangle(
     RWByteAddressBufferPointer pointer,
@@ -236,7 +284,24 @@ void BVHReadTriangle(
     out float3 v2,
     uint triId)
 {
-    uint baseOffset = GetOffsetToVertices(pointer) + triId * SizeOfPrimitive
+    const uint offsetToPrimitives = GetOffsetToVertices(pointer);
+#if ENABLE_COMPRESSED_TRIANGLES
+    const uint4 grid = pointer.buffer.Load4(offsetToPrimitives);
+    if (grid.x == COMPRESSED_TRIANGLES_TYPE)
+    {
+        const float3 step = asfloat(pointer.buffer.Load3(offsetToPrimitives + OffsetToCompressedTriangleGridStep));
+        const uint triangleOffset = offsetToPrimitives + SizeOfCompressedTriangleGrid + triId * SizeOfCompressedTriangle;
+        const uint4 a = pointer.buffer.Load4(triangleOffset);
+        const uint2 b = pointer.buffer.Load2(triangleOffset + 16);
+
+        v0 = DecodeCompressedVertex(a.xy, asfloat(grid.yzw), step);
+        v1 = DecodeCompressedVertex(a.zw, asfloat(grid.yzw), step);
+        v2 = DecodeCompressedVertex(b, asfloat(grid.yzw), step);
+        return;
+    }
+#endif
+
+    uint baseOffset = offsetToPrimitives + triId * SizeOfPrimitive
         + OffsetToPrimitiveData;
 
     const float4 a = asfloat(pointer.buffer.Load4(baseOffset));
@@ -284,6 +349,21 @@ BoundingBox GetBoxDataFromTriangle(float3 v0, float3 v1, float3 v2, int triangle
     return box;
 }
 
+// Every ray ANDs its inclusion mask with an instance's mask, so an instance with a mask of 0 can never
+// be hit.  Turning its box inside out makes every ray miss it and leaves the bounds of any box it's
+// merged into unchanged.  The center stays where it was so the instance still sorts next to its
+// neighbors, in case a later update gives it a mask again.
+BoundingBox CullMaskedInstance(BoundingBox box, RaytracingInstanceDesc instanceDesc)
+{
+#if CULL_MASKED_INSTANCES
+    if (GetInstanceMask(instanceDesc) == 0)
+    {
+        box.halfDim = -1e30f;
+    }
+#endif
+    return box;
+}
+
 float3 GetMinCorner(BoundingBox box)
 {
     return box.center - box.halfDim;
@@ -25,7 +25,24 @@
 //*************************************************************************
 
 
+// Collapses bottom-level BVH2s into 4-wide nodes with quantized child bounds that
+// the traversal shader walks instead of the binary hierarchy.
+#define ENABLE_WIDE_BVH 1
+
+// Gives top-level instances with an InstanceMask of 0 an inside-out box, so that they cost nothing
+// during traversal and don't grow the boxes of the nodes above them.
+#define CULL_MASKED_INSTANCES 1
+
+// Lets bottom levels built with D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_MINIMIZE_MEMORY store
+// their triangles as vertices quantized to a grid over the whole bottom level, 24 bytes per triangle instead of 40.
+#define ENABLE_COMPRESSED_TRIANGLES 1
+
+#if ENABLE_WIDE_BVH
+// Popping a wide node can push up to 4 children instead of 2
+#define     TRAVERSAL_MAX_STACK_DEPTH       48
+#else
 #define     TRAVERSAL_MAX_STACK_DEPTH       32
+#endif
 
 #define     MAX_TRIS_IN_LEAF                1
 
@@ -139,6 +156,8 @@ static_assert(sizeof(Triangle) == SizeOfTriangle, L"Incorrect sizeof for Triangl
 
 #define TRIANGLE_TYPE 0x1
 #define PROCEDURAL_PRIMITIVE_TYPE 0x2
+// Takes the place of the first primitive's type when the primitives are compressed
+#define COMPRESSED_TRIANGLES_TYPE 0x4
 struct Primitive
 {
     uint PrimitiveType;
@@ -199,6 +218,24 @@ static_assert(sizeof(Primitive) == SizeOfPrimitive, L"Incorrect sizeof for Primi
 static_assert(offsetof(Primitive, triangle) == OffsetToPrimitiveData, L"Incorrect offset to Primitive data");
 #endif
 
+// Compressed primitives start with the grid that every vertex is quantized to. The grid has
+// 2^21 - 1 steps per axis, so a vertex packs into a uint2 and a triangle into 24 bytes.
+struct CompressedTriangleGrid
+{
+    uint PrimitiveType; // COMPRESSED_TRIANGLES_TYPE
+    float3 Origin;
+    float3 Step;
+    uint Padding;
+};
+#define SizeOfCompressedTriangleGrid 32
+#define OffsetToCompressedTriangleGridStep 16
+#define SizeOfCompressedTriangle 24
+#define CompressedTriangleGridSteps 0x1FFFFF
+#ifndef HLSL
+static_assert(sizeof(CompressedTriangleGrid) == SizeOfCompressedTriangleGrid, L"Incorrect sizeof for CompressedTriangleGrid");
+static_assert(offsetof(CompressedTriangleGrid, Step) == OffsetToCompressedTriangleGridStep, L"Incorrect offset to CompressedTriangleGrid step");
+#endif
+
 struct PrimitiveMetaData
 {
     uint GeometryContributionToHitGroupIndex;
@@ -411,6 +448,26 @@ struct AABBNode
 static_assert(sizeof(AABBNode) == SizeOfAABBNode, L"Incorrect sizeof for AABB");
 #endif
 
+// 4-wide node that a bottom-level BVH2 is collapsed into, one per BVH2 internal node.
+// Child bounds are stored as 8-bit offsets from the origin in steps of a power of two
+// per axis, so that a whole node fits in 64 bytes.
+#define WIDE_BVH_WIDTH 4
+#define WideBVHChildIsLeafFlag 0x80000000
+#define InvalidWideBVHChild 0xffffffff
+struct WideBVHNode
+{
+    float   origin[3];
+    uint    scaleExponents;               // Biased float exponent of the step size, a byte per axis
+    uint    children[WIDE_BVH_WIDTH];     // BVH2 node index | WideBVHChildIsLeafFlag, or InvalidWideBVHChild
+    uint    quantizedMin[3];              // A byte per child for each axis
+    uint    quantizedMax[3];
+    uint    padding[2];
+};
+#define SizeOfWideBVHNode (4 * 16)
+#ifndef HLSL
+static_assert(sizeof(WideBVHNode) == SizeOfWideBVHNode, L"Incorrect sizeof for WideBVHNode");
+#endif
+
 // BVH description for the traversal shader
 struct BVHOffsets
 {
@@ -424,6 +481,24 @@ struct BVHOffsets
 static_assert(sizeof(BVHOffsets) == SizeOfBVHOffsets, L"Incorrect sizeof for BVHOffsets");
 #endif
 
+// Serialized acceleration structures (D3D12_RAYTRACING_ACCELERATION_STRUCTURE_COPY_MODE_SERIALIZE) are the BVH
+// prefixed with a D3D12_SERIALIZED_RAYTRACING_ACCELERATION_STRUCTURE_HEADER. The driver matching identifier is
+// the fallback's own GUID followed by a layout version, which must be bumped whenever the BVH layout changes.
+#define SizeOfSerializedAccelerationStructureHeader 56
+#define OffsetToSerializedVersioningData 16
+#define OffsetToSerializedSizes 32
+#define OffsetToSerializedNumBottomLevelPointers 48
+
+#define SerializedAccelerationStructureGuid0 0x3c8a5f0e
+#define SerializedAccelerationStructureGuid1 0x4b6e91d2
+#define SerializedAccelerationStructureGuid2 0x9f2d47a1
+#define SerializedAccelerationStructureGuid3 0x6e0b3c58
+#define SerializedAccelerationStructureVersion (1 | (ENABLE_WIDE_BVH << 16) | (ENABLE_COMPRESSED_TRIANGLES << 17))
+#ifndef HLSL
+static_assert(sizeof(D3D12_SERIALIZED_RAYTRACING_ACCELERATION_STRUCTURE_HEADER) == SizeOfSerializedAccelerationStructureHeader, L"Incorrect sizeof for serialized header");
+static_assert(offsetof(D3D12_SERIALIZED_RAYTRACING_ACCELERATION_STRUCTURE_HEADER, SerializedSizeInBytesIncludingHeader) == OffsetToSerializedSizes, L"Incorrect offset to serialized sizes");
+#endif
+
 inline
 uint GetNumInternalNodes(uint numLeaves)
 {
@@ -442,17 +517,39 @@ uint GetOffsetToBVHSortedIndices(uint numElements) {
 }
 
 inline
-uint GetOffsetFromPrimitiveMetaDataToSortedIndices(uint numPrimitives)
+uint GetOffsetFromPrimitiveMetaDataToWideBVHNodes(uint numPrimitives)
 {
     return SizeOfPrimitiveMetaData * numPrimitives;
 }
 
+inline
+uint GetSizeOfWideBVHNodes(uint numPrimitives)
+{
+#if ENABLE_WIDE_BVH
+    return numPrimitives > 1 ? SizeOfWideBVHNode * GetNumInternalNodes(numPrimitives) : 0;
+#else
+    return 0;
+#endif
+}
+
+inline
+uint GetOffsetFromPrimitiveMetaDataToSortedIndices(uint numPrimitives)
+{
+    return GetOffsetFromPrimitiveMetaDataToWideBVHNodes(numPrimitives) + GetSizeOfWideBVHNodes(numPrimitives);
+}
+
 inline
 uint GetOffsetFromPrimitivesToPrimitiveMetaData(uint numPrimitives)
 {
     return SizeOfPrimitive * numPrimitives;
 }
 
+inline
+uint GetOffsetFromCompressedPrimitivesToPrimitiveMetaData(uint numPrimitives)
+{
+    return SizeOfCompressedTriangleGrid + SizeOfCompressedTriangle * numPrimitives;
+}
+
 inline
 uint GetOffsetToLeafNodeAABBs(uint numElements)
 {
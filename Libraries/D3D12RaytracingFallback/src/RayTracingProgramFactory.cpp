@@ -30,7 +30,7 @@ namespace FallbackLayer
         switch (programType)
         {
         case RaytracingProgramFactory::UberShader:
-                return new UberShaderRaytracingProgram(m_pDevice, m_DxilShaderPatcher, stateObjectCollection);
+                return new UberShaderRaytracingProgram(m_pDevice, m_DxilShaderPatcher, m_StateObjectCache, stateObjectCollection);
             default:
                 ThrowInternalFailure(E_INVALIDARG);
                 return nullptr;
@@ -51,7 +51,7 @@ namespace FallbackLayer
         return NewRaytracingProgram(programType, stateObjectCollection);
     }
 
-    RaytracingProgramFactory::RaytracingProgramFactory(ID3D12Device *pDevice) : m_pDevice(pDevice)
+    RaytracingProgramFactory::RaytracingProgramFactory(ID3D12Device *pDevice) : m_pDevice(pDevice), m_StateObjectCache(pDevice)
     {
         m_spTraversalShaderBuilder.reset(NewTraversalShaderBuilder(m_DefaultAccelerationStructureLayoutType));
     }
@@ -52,6 +52,8 @@ namespace FallbackLayer
         IRaytracingProgram *GetRaytracingProgram(
             const StateObjectCollection &stateObjectCollection);
 
+        StateObjectCache &GetStateObjectCache() { return m_StateObjectCache; }
+
     private:
         ID3D12Device *m_pDevice;
 
@@ -61,6 +63,7 @@ namespace FallbackLayer
         };
 
         DxilShaderPatcher m_DxilShaderPatcher;
+        StateObjectCache m_StateObjectCache;
 
         ProgramTypes DetermineBestProgram(const StateObjectCollection &stateObjectCollection);
         IRaytracingProgram *NewRaytracingProgram(ProgramTypes programTypes, const StateObjectCollection &stateObjectCollection);
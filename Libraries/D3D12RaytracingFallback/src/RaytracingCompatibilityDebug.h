@@ -15,10 +15,27 @@
 void OutputDebugLog(ID3D12RaytracingFallbackDevice *pDevice);
 #endif
 
+#if ENABLE_TRAVERSAL_STATS
+struct FallbackTraversalStats
+{
+    UINT Rays;
+    UINT NodesVisited;
+    UINT TrianglesTested;
+};
+
+// Counts from the last DispatchRays recorded by any command list of pDevice. That command list
+// must have finished executing on the GPU.
+FallbackTraversalStats GetTraversalStats(ID3D12RaytracingFallbackDevice *pDevice);
+#endif
+
 #if ENABLE_ACCELERATION_STRUCTURE_VISUALIZATION
 void VisualizeAccelerationStructureLevel(ID3D12RaytracingFallbackDevice *pDevice, UINT level);
 #endif
 
+// Builds a bottom-level BVH2 on the CPU with a binned SAH builder that spreads subtrees
+// across NumThreads threads, 0 uses one thread per hardware thread. The output is the
+// same for any number of threads.
 void BuildRaytracingAccelerationStructureOnCpu(
     _In_  const D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_DESC *pDesc,
-    _Out_ void *pData);
+    _Out_ void *pData,
+    _In_  UINT NumThreads = 0);
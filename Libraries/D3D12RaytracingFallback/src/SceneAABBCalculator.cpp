@@ -10,7 +10,6 @@
 //*********************************************************
 #include "pch.h"
 #include "CalculateSceneAABBBindings.h"
-#include "CompiledShaders/CalculateSceneAABBFromAABBs.h"
 #include "CompiledShaders/CalculateSceneAABBFromPrimitives.h"
 #include "CompiledShaders/CalculateSceneAABBFromBVHs.h"
 
@@ -23,13 +22,23 @@ namespace FallbackLayer
         parameters[InputConstants].InitAsConstants(SizeOfInUint32(SceneAABBCalculatorConstants), SceneAABBCalculatorConstantsRegister);
         parameters[InputAABBBuffer].InitAsUnorderedAccessView(SceneAABBCalculatorAABBBuffer);
         parameters[OutputBuffer].InitAsUnorderedAccessView(SceneAABBCalculatorOutputBuffer);
+        parameters[GroupCounterBuffer].InitAsUnorderedAccessView(SceneAABBCalculatorGroupCounterBuffer);
 
         auto rootSignatureDesc = CD3DX12_VERSIONED_ROOT_SIGNATURE_DESC(ARRAYSIZE(parameters), parameters);
         CreateRootSignatureHelper(pDevice, rootSignatureDesc, &m_pRootSignature);
 
-        CreatePSOHelper(pDevice, nodeMask, m_pRootSignature, COMPILED_SHADER(g_pCalculateSceneAABBFromAABBs), &m_pCalculateSceneAABBFromAABBs);
         CreatePSOHelper(pDevice, nodeMask, m_pRootSignature, COMPILED_SHADER(g_pCalculateSceneAABBFromPrimitives), &m_pCalculateSceneAABBFromPrimitives);
         CreatePSOHelper(pDevice, nodeMask, m_pRootSignature, COMPILED_SHADER(g_pCalculateSceneAABBFromBVHs), &m_pCalculateSceneAABBFromBVHs);
+
+        auto defaultHeapProperties = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT, nodeMask, nodeMask);
+        auto groupCounterDesc = CD3DX12_RESOURCE_DESC::Buffer(sizeof(UINT), D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
+        ThrowInternalFailure(pDevice->CreateCommittedResource(
+            &defaultHeapProperties,
+            D3D12_HEAP_FLAG_NONE,
+            &groupCounterDesc,
+            D3D12_RESOURCE_STATE_UNORDERED_ACCESS,
+            nullptr,
+            IID_PPV_ARGS(&m_pGroupCounter)));
     }
 
 
@@ -51,47 +60,23 @@ namespace FallbackLayer
         }
 
         SceneAABBCalculatorConstants constants = {};
+        constants.NumberOfElements = numElements;
+        pCommandList->SetComputeRoot32BitConstants(InputConstants, SizeOfInUint32(constants), &constants, 0);
         pCommandList->SetComputeRootUnorderedAccessView(InputBuffer, inputBuffer);
+        pCommandList->SetComputeRootUnorderedAccessView(InputAABBBuffer, scratchBuffer);
+        pCommandList->SetComputeRootUnorderedAccessView(OutputBuffer, outputAABB);
+        pCommandList->SetComputeRootUnorderedAccessView(GroupCounterBuffer, m_pGroupCounter->GetGPUVirtualAddress());
 
-        D3D12_GPU_VIRTUAL_ADDRESS scratchBuffers[2];
-        scratchBuffers[0] = scratchBuffer;
-        scratchBuffers[1] = scratchBuffer + GetNumAABBsOutputFromPass(numElements) * sizeof(AABB);
-
-        UINT outputScratchBufferIndex = 0;
-        UINT inputScratchBufferIndex = 1;
+        // The groups are combined by whichever one finishes last, so there's only one dispatch
+        pCommandList->Dispatch(GetNumberOfGroups(numElements), 1, 1);
 
         auto uavBarrier = CD3DX12_RESOURCE_BARRIER::UAV(nullptr);
-        UINT threadsNeeded;
-        UINT elementsToProcess = numElements;
-        for (; elementsToProcess > 1; elementsToProcess = threadsNeeded)
-        {
-            threadsNeeded = GetNumAABBsOutputFromPass(elementsToProcess);
-
-            const bool bFirstPass = (elementsToProcess == numElements);
-            const bool bLastPass = (threadsNeeded == 1);
-
-            constants.NumberOfElements = elementsToProcess;
-            pCommandList->SetComputeRoot32BitConstants(InputConstants, SizeOfInUint32(constants), &constants, 0);
-            pCommandList->SetComputeRootUnorderedAccessView(OutputBuffer, bLastPass ? outputAABB : scratchBuffers[outputScratchBufferIndex]);
-            if (!bFirstPass)
-            {
-                pCommandList->SetComputeRootUnorderedAccessView(InputAABBBuffer, scratchBuffers[inputScratchBufferIndex]);
-            }
-            const UINT dispatchWidth = DivideAndRoundUp<UINT>(threadsNeeded, THREAD_GROUP_1D_WIDTH);
-            pCommandList->Dispatch(dispatchWidth, 1, 1);
-            pCommandList->ResourceBarrier(1, &uavBarrier);
-
-            std::swap(outputScratchBufferIndex, inputScratchBufferIndex);
-            if (bFirstPass)
-            {
-                pCommandList->SetPipelineState(m_pCalculateSceneAABBFromAABBs);
-            }
-        }
+        pCommandList->ResourceBarrier(1, &uavBarrier);
     }
 
-    UINT SceneAABBCalculator::GetNumAABBsOutputFromPass(UINT numElements)
+    UINT SceneAABBCalculator::GetNumberOfGroups(UINT numElements)
     {
-        return  DivideAndRoundUp<UINT>(numElements, ElementsSummedPerThread);
+        return DivideAndRoundUp<UINT>(numElements, ElementsSummedPerGroup);
     }
 
 
@@ -99,13 +84,7 @@ namespace FallbackLayer
     {
         if (numTriangles == 0) return 0;
 
-        // Data is ping-ponged between the upper and lower part of the scratch buffer so
-        // only need to sum the first 2 biggest passes
-        auto numberOfAABBsOutput = GetNumAABBsOutputFromPass(numTriangles);
-        if (numberOfAABBsOutput > 1)
-        {
-            numberOfAABBsOutput += GetNumAABBsOutputFromPass(numberOfAABBsOutput);
-        }
-        return numberOfAABBsOutput * sizeof(AABB);
+        // One AABB per group, combined by the last group to finish
+        return GetNumberOfGroups(numTriangles) * sizeof(AABB);
     }
 }
@@ -25,14 +25,18 @@ namespace FallbackLayer
             InputConstants,
             InputAABBBuffer,
             OutputBuffer,
+            GroupCounterBuffer,
             NumParameters
         };
 
-        static UINT GetNumAABBsOutputFromPass(UINT numElements);
+        static UINT GetNumberOfGroups(UINT numElements);
 
         CComPtr<ID3D12RootSignature> m_pRootSignature;
         CComPtr<ID3D12PipelineState> m_pCalculateSceneAABBFromPrimitives;
         CComPtr<ID3D12PipelineState> m_pCalculateSceneAABBFromBVHs;
-        CComPtr<ID3D12PipelineState> m_pCalculateSceneAABBFromAABBs;
+
+        // Holds the count of groups that have finished. Committed resources start out zeroed and the
+        // last group of every dispatch sets it back to 0, so it never needs clearing.
+        CComPtr<ID3D12Resource> m_pGroupCounter;
     };
 }
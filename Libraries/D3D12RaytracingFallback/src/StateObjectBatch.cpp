@@ -0,0 +1,106 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+#include "pch.h"
+
+namespace FallbackLayer
+{
+    StateObjectBatch::StateObjectBatch(ID3D12RaytracingFallbackDevice *pDevice, UINT numStateObjects, const D3D12_STATE_OBJECT_DESC *pDescs) :
+        m_pDevice(pDevice), m_jobs(new Job[numStateObjects]), m_numJobs(numStateObjects)
+    {
+        for (UINT i = 0; i < numStateObjects; i++)
+        {
+            m_jobs[i].pDesc = &pDescs[i];
+        }
+
+        UINT numWorkers = std::min(numStateObjects, std::max(std::thread::hardware_concurrency(), 2u) - 1);
+        for (UINT i = 0; i < numWorkers; i++)
+        {
+            m_workers.emplace_back(&StateObjectBatch::RunJobs, this);
+        }
+    }
+
+    StateObjectBatch::~StateObjectBatch()
+    {
+        for (auto &worker : m_workers)
+        {
+            worker.join();
+        }
+    }
+
+    void StateObjectBatch::RunJobs()
+    {
+        for (UINT i = m_nextJob++; i < m_numJobs; i = m_nextJob++)
+        {
+            Job &job = m_jobs[i];
+            job.Status = D3D12_RAYTRACING_FALLBACK_STATE_OBJECT_STATUS_CREATING;
+
+            CComPtr<ID3D12RaytracingFallbackStateObject> pStateObject;
+            HRESULT hr;
+            try
+            {
+                hr = m_pDevice->CreateStateObject(job.pDesc, IID_PPV_ARGS(&pStateObject));
+            }
+            catch (_com_error &e)
+            {
+                hr = e.Error();
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                job.Result = hr;
+                if (SUCCEEDED(hr))
+                {
+                    job.pStateObject = pStateObject;
+                }
+                job.Status = SUCCEEDED(hr) ? D3D12_RAYTRACING_FALLBACK_STATE_OBJECT_STATUS_COMPLETE : D3D12_RAYTRACING_FALLBACK_STATE_OBJECT_STATUS_FAILED;
+                m_completedCount++;
+            }
+            m_jobFinished.notify_all();
+        }
+    }
+
+    D3D12_RAYTRACING_FALLBACK_STATE_OBJECT_STATUS StateObjectBatch::GetStatus(UINT Index)
+    {
+        if (Index >= m_numJobs)
+        {
+            ThrowFailure(E_INVALIDARG, L"State object index is out of range of the batch");
+        }
+        return m_jobs[Index].Status;
+    }
+
+    void StateObjectBatch::Wait(void)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_jobFinished.wait(lock, [this] { return m_completedCount == m_numJobs; });
+    }
+
+    HRESULT StateObjectBatch::GetStateObject(UINT Index, REFIID riid, void **ppStateObject)
+    {
+        if (!ppStateObject || riid != __uuidof(ID3D12RaytracingFallbackStateObject) || Index >= m_numJobs)
+        {
+            return E_INVALIDARG;
+        }
+        *ppStateObject = nullptr;
+
+        Job &job = m_jobs[Index];
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_jobFinished.wait(lock, [&job]
+        {
+            return job.Status == D3D12_RAYTRACING_FALLBACK_STATE_OBJECT_STATUS_COMPLETE || job.Status == D3D12_RAYTRACING_FALLBACK_STATE_OBJECT_STATUS_FAILED;
+        });
+
+        if (SUCCEEDED(job.Result))
+        {
+            job.pStateObject.CopyTo((ID3D12RaytracingFallbackStateObject **)ppStateObject);
+        }
+        return job.Result;
+    }
+}
@@ -0,0 +1,72 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+#pragma once
+
+namespace FallbackLayer
+{
+    // Runs ID3D12RaytracingFallbackDevice::CreateStateObject for every desc on a pool of
+    // worker threads. Each worker takes the next pending desc until none are left, so a
+    // few expensive state objects don't hold up the cheap ones behind them. The pool
+    // leaves one core free for the thread that is presenting a loading screen.
+    class StateObjectBatch : public ID3D12RaytracingFallbackStateObjectBatch
+    {
+    public:
+        StateObjectBatch(ID3D12RaytracingFallbackDevice *pDevice, UINT numStateObjects, const D3D12_STATE_OBJECT_DESC *pDescs);
+        virtual ~StateObjectBatch();
+
+        virtual UINT STDMETHODCALLTYPE GetStateObjectCount(void) { return m_numJobs; }
+        virtual UINT STDMETHODCALLTYPE GetCompletedCount(void) { return m_completedCount; }
+        virtual D3D12_RAYTRACING_FALLBACK_STATE_OBJECT_STATUS STDMETHODCALLTYPE GetStatus(UINT Index);
+        virtual void STDMETHODCALLTYPE Wait(void);
+        virtual HRESULT STDMETHODCALLTYPE GetStateObject(UINT Index, REFIID riid, void **ppStateObject);
+
+    private:
+        struct Job
+        {
+            const D3D12_STATE_OBJECT_DESC *pDesc = nullptr;
+            std::atomic<D3D12_RAYTRACING_FALLBACK_STATE_OBJECT_STATUS> Status = D3D12_RAYTRACING_FALLBACK_STATE_OBJECT_STATUS_PENDING;
+            HRESULT Result = S_OK;
+            CComPtr<ID3D12RaytracingFallbackStateObject> pStateObject;
+        };
+
+        void RunJobs();
+
+        // Keeps the device alive for as long as the workers may call into it
+        CComPtr<ID3D12RaytracingFallbackDevice> m_pDevice;
+        std::unique_ptr<Job[]> m_jobs;
+        const UINT m_numJobs;
+        std::atomic<UINT> m_nextJob = 0;
+        std::atomic<UINT> m_completedCount = 0;
+        std::vector<std::thread> m_workers;
+
+        // Guards a job's results between its worker and the threads waiting on it
+        std::mutex m_mutex;
+        std::condition_variable m_jobFinished;
+
+        COM_IMPLEMENTATION();
+    };
+
+    inline HRESULT CreateStateObjectBatch(
+        ID3D12RaytracingFallbackDevice *pDevice,
+        UINT numStateObjects,
+        const D3D12_STATE_OBJECT_DESC *pDescs,
+        REFIID riid,
+        void **ppStateObjectBatch)
+    {
+        if (!ppStateObjectBatch || riid != __uuidof(ID3D12RaytracingFallbackStateObjectBatch) || (numStateObjects && !pDescs))
+        {
+            return E_INVALIDARG;
+        }
+
+        *ppStateObjectBatch = new StateObjectBatch(pDevice, numStateObjects, pDescs);
+        return *ppStateObjectBatch ? S_OK : E_OUTOFMEMORY;
+    }
+}
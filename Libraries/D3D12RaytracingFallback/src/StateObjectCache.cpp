@@ -0,0 +1,218 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+#include "pch.h"
+
+namespace FallbackLayer
+{
+    void StateObjectCache::SetFile(LPCWSTR pFilePath)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_pPipelineLibrary = nullptr;
+        m_pipelineLibraryData.clear();
+        m_stateObjects.clear();
+        m_dirty = false;
+
+        m_filePath = pFilePath ? pFilePath : L"";
+        if (IsEnabled())
+        {
+            Load();
+        }
+    }
+
+    bool StateObjectCache::Find(UINT64 key, CachedStateObject &stateObject) const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto entry = m_stateObjects.find(key);
+        if (entry == m_stateObjects.end())
+        {
+            return false;
+        }
+        stateObject = entry->second;
+        return true;
+    }
+
+    void StateObjectCache::Store(UINT64 key, CachedStateObject &&stateObject)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stateObjects[key] = std::move(stateObject);
+        m_dirty = true;
+    }
+
+    void StateObjectCache::CreatePipelineState(UINT64 key, const D3D12_COMPUTE_PIPELINE_STATE_DESC &desc, ID3D12PipelineState **ppPipelineState)
+    {
+        WCHAR pipelineName[17];
+        swprintf_s(pipelineName, L"%016llx", key);
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_pPipelineLibrary && SUCCEEDED(m_pPipelineLibrary->LoadComputePipeline(pipelineName, &desc, IID_PPV_ARGS(ppPipelineState))))
+            {
+                return;
+            }
+        }
+
+        ThrowInternalFailure(m_pDevice->CreateComputePipelineState(&desc, IID_PPV_ARGS(ppPipelineState)));
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_pPipelineLibrary && SUCCEEDED(m_pPipelineLibrary->StorePipeline(pipelineName, *ppPipelineState)))
+        {
+            m_dirty = true;
+        }
+    }
+
+    void StateObjectCache::CreatePipelineLibrary(const void *pData, SIZE_T size)
+    {
+        // Without ID3D12Device1 only the linked DXIL is cached
+        CComPtr<ID3D12Device1> pDevice1;
+        if (FAILED(m_pDevice->QueryInterface(&pDevice1)))
+        {
+            return;
+        }
+
+        if (size == 0 || FAILED(pDevice1->CreatePipelineLibrary(pData, size, IID_PPV_ARGS(&m_pPipelineLibrary))))
+        {
+            // The library was serialized by a different driver or adapter, so start over
+            m_pPipelineLibrary = nullptr;
+            m_pipelineLibraryData.clear();
+            if (FAILED(pDevice1->CreatePipelineLibrary(nullptr, 0, IID_PPV_ARGS(&m_pPipelineLibrary))))
+            {
+                m_pPipelineLibrary = nullptr;
+            }
+        }
+    }
+
+    void StateObjectCache::Load()
+    {
+        std::vector<BYTE> fileData;
+        {
+            std::ifstream file(m_filePath, std::ios::in | std::ios::binary | std::ios::ate);
+            if (file)
+            {
+                fileData.resize((size_t)file.tellg());
+                file.seekg(0);
+                if (!file.read((char *)fileData.data(), fileData.size()))
+                {
+                    fileData.clear();
+                }
+            }
+        }
+
+        // Every read is bounds checked so that a truncated or corrupt file only leaves the cache empty
+        size_t offset = 0;
+        auto Read = [&](void *pDest, size_t size)
+        {
+            if (size > fileData.size() - offset)
+            {
+                return false;
+            }
+            memcpy(pDest, fileData.data() + offset, size);
+            offset += size;
+            return true;
+        };
+
+        FileHeader header = {};
+        bool isValid = Read(&header, sizeof(header)) && header.Magic == FileMagic && header.Version == FileVersion;
+
+        std::unordered_map<UINT64, CachedStateObject> stateObjects;
+        for (UINT i = 0; isValid && i < header.NumStateObjects; i++)
+        {
+            UINT64 key;
+            UINT32 dxilSize;
+            UINT32 numShaders = 0;
+            CachedStateObject stateObject;
+
+            isValid = Read(&key, sizeof(key)) && Read(&dxilSize, sizeof(dxilSize)) && dxilSize <= fileData.size() - offset;
+            if (isValid)
+            {
+                stateObject.LinkedDxil.resize(dxilSize);
+                isValid = Read(stateObject.LinkedDxil.data(), dxilSize) && Read(&numShaders, sizeof(numShaders));
+            }
+
+            for (UINT32 s = 0; isValid && s < numShaders; s++)
+            {
+                UINT32 nameLength;
+                CachedShaderData shaderData;
+                isValid = Read(&nameLength, sizeof(nameLength)) && nameLength > 0 && nameLength * sizeof(wchar_t) <= fileData.size() - offset;
+                if (isValid)
+                {
+                    std::wstring name(nameLength, L'\0');
+                    isValid = Read(&name[0], nameLength * sizeof(wchar_t)) && Read(&shaderData, sizeof(shaderData));
+                    stateObject.ShaderData[name] = shaderData;
+                }
+            }
+
+            if (isValid)
+            {
+                stateObjects[key] = std::move(stateObject);
+            }
+        }
+
+        isValid = isValid && header.PipelineLibrarySize == fileData.size() - offset;
+        if (isValid)
+        {
+            m_stateObjects = std::move(stateObjects);
+            m_pipelineLibraryData.assign(fileData.begin() + offset, fileData.end());
+        }
+
+        CreatePipelineLibrary(m_pipelineLibraryData.data(), m_pipelineLibraryData.size());
+    }
+
+    void StateObjectCache::Flush()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_dirty || !IsEnabled())
+        {
+            return;
+        }
+        m_dirty = false;
+
+        std::vector<BYTE> pipelineLibraryData;
+        if (m_pPipelineLibrary)
+        {
+            pipelineLibraryData.resize(m_pPipelineLibrary->GetSerializedSize());
+            if (FAILED(m_pPipelineLibrary->Serialize(pipelineLibraryData.data(), pipelineLibraryData.size())))
+            {
+                pipelineLibraryData.clear();
+            }
+        }
+
+        // A write that fails part way leaves a file whose sizes don't add up, which Load() discards
+        std::ofstream file(m_filePath, std::ios::out | std::ios::binary | std::ios::trunc);
+        auto Write = [&](const void *pData, size_t size)
+        {
+            file.write((const char *)pData, size);
+        };
+
+        FileHeader header = { FileMagic, FileVersion, (UINT32)m_stateObjects.size(), 0, pipelineLibraryData.size() };
+        Write(&header, sizeof(header));
+
+        for (auto &entry : m_stateObjects)
+        {
+            const CachedStateObject &stateObject = entry.second;
+            UINT32 dxilSize = (UINT32)stateObject.LinkedDxil.size();
+            UINT32 numShaders = (UINT32)stateObject.ShaderData.size();
+            Write(&entry.first, sizeof(entry.first));
+            Write(&dxilSize, sizeof(dxilSize));
+            Write(stateObject.LinkedDxil.data(), dxilSize);
+            Write(&numShaders, sizeof(numShaders));
+
+            for (auto &shaderEntry : stateObject.ShaderData)
+            {
+                UINT32 nameLength = (UINT32)shaderEntry.first.size();
+                Write(&nameLength, sizeof(nameLength));
+                Write(shaderEntry.first.c_str(), nameLength * sizeof(wchar_t));
+                Write(&shaderEntry.second, sizeof(shaderEntry.second));
+            }
+        }
+
+        Write(pipelineLibraryData.data(), pipelineLibraryData.size());
+    }
+}
@@ -0,0 +1,113 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+#pragma once
+
+namespace FallbackLayer
+{
+    // 64-bit FNV-1a over everything that goes into linking a state object
+    class StateObjectHash
+    {
+    public:
+        void Add(const void *pData, size_t size)
+        {
+            const BYTE *pBytes = (const BYTE *)pData;
+            for (size_t i = 0; i < size; i++)
+            {
+                m_hash = (m_hash ^ pBytes[i]) * 1099511628211ull;
+            }
+        }
+
+        void Add(UINT value) { Add(&value, sizeof(value)); }
+
+        // Null and empty strings hash differently so that optional imports can't alias
+        void Add(LPCWSTR pString)
+        {
+            UINT length = pString ? (UINT)wcslen(pString) + 1 : 0;
+            Add(length);
+            Add(pString, length * sizeof(wchar_t));
+        }
+
+        UINT64 GetHash() const { return m_hash; }
+
+    private:
+        UINT64 m_hash = 14695981039346656037ull;
+    };
+
+    struct CachedShaderData
+    {
+        ShaderIdentifier Identifier;
+        UINT StackSize;
+    };
+
+    struct CachedStateObject
+    {
+        std::vector<BYTE> LinkedDxil;
+        std::unordered_map<std::wstring, CachedShaderData> ShaderData;
+    };
+
+    // Persists linked uber-shaders across runs so that recreating a state object skips
+    // DXIL linking, and keeps the compute pipelines compiled from them in an
+    // ID3D12PipelineLibrary so that the PSO compile is skipped as well. If the driver
+    // rejects the library, for example after a driver update, the linked DXIL is still
+    // reused and the pipelines are recompiled into a new library.
+    //
+    // Entries are keyed on a StateObjectHash of the inputs and the whole file is rewritten
+    // by Flush() whenever entries were added. Failing to read or write the file is never
+    // an error; it only costs the time the cache would have saved.
+    //
+    // State objects may be created from several threads at once, so every method other
+    // than SetFile() is thread-safe. The pipeline compile itself runs outside the lock.
+    class StateObjectCache
+    {
+    public:
+        StateObjectCache(ID3D12Device *pDevice) : m_pDevice(pDevice) {}
+
+        // Loads the cache from pFilePath, which is created on the first Flush() if it
+        // doesn't exist yet. Passing null disables the cache.
+        void SetFile(LPCWSTR pFilePath);
+        bool IsEnabled() const { return !m_filePath.empty(); }
+
+        // Copies out the entry, since other threads may add entries while it is in use
+        bool Find(UINT64 key, CachedStateObject &stateObject) const;
+        void Store(UINT64 key, CachedStateObject &&stateObject);
+
+        // Loads the pipeline stored under key, or compiles it and stores it for next time
+        void CreatePipelineState(UINT64 key, const D3D12_COMPUTE_PIPELINE_STATE_DESC &desc, ID3D12PipelineState **ppPipelineState);
+
+        void Flush();
+
+    private:
+        static const UINT32 FileMagic = 0x4F534C46; // 'FLSO'
+        static const UINT32 FileVersion = 1;
+
+        struct FileHeader
+        {
+            UINT32 Magic;
+            UINT32 Version;
+            UINT32 NumStateObjects;
+            UINT32 Padding;
+            UINT64 PipelineLibrarySize;
+        };
+
+        void Load();
+        void CreatePipelineLibrary(const void *pData, SIZE_T size);
+
+        mutable std::mutex m_mutex;
+        CComPtr<ID3D12Device> m_pDevice;
+        std::wstring m_filePath;
+        std::unordered_map<UINT64, CachedStateObject> m_stateObjects;
+
+        // The library reads pipelines from the blob it was created from for its whole lifetime
+        std::vector<BYTE> m_pipelineLibraryData;
+        CComPtr<ID3D12PipelineLibrary> m_pPipelineLibrary;
+        bool m_dirty = false;
+    };
+}
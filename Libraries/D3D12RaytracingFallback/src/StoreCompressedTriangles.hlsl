@@ -0,0 +1,46 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+#define HLSL
+#include "CompressTrianglesBindings.h"
+#include "RayTracingHelper.hlsli"
+
+// Runs once the AABBs are built, which is the last pass that needs the full precision
+// primitives. Replaces them with the staged grid, quantized triangles and metadata.
+[numthreads(THREAD_GROUP_1D_WIDTH, 1, 1)]
+void main(uint3 DTid : SV_DispatchThreadID)
+{
+    const uint primitiveIndex = DTid.x;
+    const uint numPrimitives = Constants.NumberOfElements;
+    if (primitiveIndex >= numPrimitives)
+    {
+        return;
+    }
+
+    const uint offsetToPrimitives = GetOffsetToPrimitives(numPrimitives);
+    const uint offsetFromPrimitivesToMetaData = GetOffsetFromCompressedPrimitivesToPrimitiveMetaData(numPrimitives);
+    const uint offsetToCompressedPrimitiveMetaData = offsetToPrimitives + offsetFromPrimitivesToMetaData;
+
+    if (primitiveIndex == 0)
+    {
+        outputBVH.Store4(offsetToPrimitives, compressedTriangles.Load4(0));
+        outputBVH.Store4(offsetToPrimitives + OffsetToCompressedTriangleGridStep, compressedTriangles.Load4(OffsetToCompressedTriangleGridStep));
+
+        outputBVH.Store(OffsetToPrimitiveMetaDataOffset, offsetToCompressedPrimitiveMetaData);
+        outputBVH.Store(OffsetToTotalSize, offsetToCompressedPrimitiveMetaData +
+            GetOffsetFromPrimitiveMetaDataToWideBVHNodes(numPrimitives) + GetSizeOfWideBVHNodes(numPrimitives));
+    }
+
+    const uint triangleOffset = SizeOfCompressedTriangleGrid + primitiveIndex * SizeOfCompressedTriangle;
+    outputBVH.Store4(offsetToPrimitives + triangleOffset, compressedTriangles.Load4(triangleOffset));
+    outputBVH.Store2(offsetToPrimitives + triangleOffset + 16, compressedTriangles.Load2(triangleOffset + 16));
+    const uint metadataOffset = offsetFromPrimitivesToMetaData + primitiveIndex * SizeOfPrimitiveMetaData;
+    outputBVH.Store3(offsetToPrimitives + metadataOffset, compressedTriangles.Load3(metadataOffset));
+}
@@ -29,7 +29,7 @@ BoundingBox ComputeLeafAABB(uint leafIndex, uint unused, out uint2 flags)
 
     flags.x = leafIndex | IsLeafFlag;
     flags.y = 1;
-    return AABBtoBoundingBox(TransformAABB(box, ObjectToWorld));
+    return CullMaskedInstance(AABBtoBoundingBox(TransformAABB(box, ObjectToWorld)), metadata.instanceDesc);
 }
 
 #include "ComputeAABBs.hlsli"
@@ -85,9 +85,10 @@ void main(uint3 DTid : SV_DispatchThreadID)
    
     // The AABBs for all top level nodes needs to be in world-space
     AABB transformedBox = TransformAABB(box, ObjectToWorld);
+    BoundingBox leafBox = CullMaskedInstance(AABBtoBoundingBox(transformedBox), instanceDesc);
 
     int leafFlag = IsLeafFlag | instanceIndex;
-    WriteBoxToBuffer(outputBVH, 0, outputIndex, AABBtoBoundingBox(transformedBox), leafFlag);
+    WriteBoxToBuffer(outputBVH, 0, outputIndex, leafBox, leafFlag);
     
     BVHMetadata metadata;
     metadata.instanceDesc = instanceDesc;
@@ -481,7 +481,7 @@ float ComputeCullFaceDir(uint instanceFlags, uint rayFlags)
 // Explicit phases. This reconverges after reaching leaves. It makes for a more level performance.
 //
 
-#if 1
+#if ENABLE_UAV_LOG
 #define MARK(x,y) LogInt(x*100+10+y)
 
 void dump(BoundingBox box, uint2 flags)
@@ -495,6 +495,26 @@ void dump(BoundingBox box, uint2 flags)
 void dump(BoundingBox box, uint2 flags) {}
 #endif
 
+#if ENABLE_TRAVERSAL_STATS
+#define COUNT_STAT(counter) counter++
+
+// Sums the counts of the active lanes so that each counter takes one atomic per wave
+void RecordTraversalStats(uint nodesVisited, uint trianglesTested)
+{
+    uint rays = WaveActiveCountBits(true);
+    uint waveNodesVisited = WaveActiveSum(nodesVisited);
+    uint waveTrianglesTested = WaveActiveSum(trianglesTested);
+    if (WaveIsFirstLane())
+    {
+        TraversalStats.InterlockedAdd(TraversalStatsRaysOffset, rays);
+        TraversalStats.InterlockedAdd(TraversalStatsNodesVisitedOffset, waveNodesVisited);
+        TraversalStats.InterlockedAdd(TraversalStatsTrianglesTestedOffset, waveTrianglesTested);
+    }
+}
+#else
+#define COUNT_STAT(counter)
+#endif
+
 Declare_Fallback_SetPendingAttr(BuiltInTriangleIntersectionAttributes);
 
 #define EndSearch 0x1
@@ -517,6 +537,88 @@ bool GetBoolFlag(uint flagContainer, uint flag)
     return flagContainer & flag;
 }
 
+#if ENABLE_WIDE_BVH
+void SortFarthestFirst(inout float tA, inout uint entryA, inout float tB, inout uint entryB)
+{
+    if (tA < tB)
+    {
+        float t = tA;
+        tA = tB;
+        tB = t;
+
+        uint entry = entryA;
+        entryA = entryB;
+        entryB = entry;
+    }
+}
+
+// Tests all children of a wide node and pushes the ones the ray hits so that
+// the nearest one is popped first. Returns the number of pushed children.
+uint TestWideBVHNode(
+    RWByteAddressBuffer buffer,
+    uint nodeAddress,
+    float closestT,
+    RayData rayData,
+    inout int stackTop,
+    uint level,
+    uint tidInWave)
+{
+    const uint4 header = buffer.Load4(nodeAddress);
+    const uint4 children = buffer.Load4(nodeAddress + OffsetToWideBVHChildren);
+    const uint4 quantizedA = buffer.Load4(nodeAddress + OffsetToWideBVHQuantizedBounds);
+    const uint4 quantizedB = buffer.Load4(nodeAddress + OffsetToWideBVHQuantizedBounds + 16);
+
+    const float3 origin = asfloat(header.xyz);
+    const float3 scale = asfloat(((header.www >> uint3(0, 8, 16)) & 0xff) << 23);
+    const uint3 quantizedMin = quantizedA.xyz;
+    const uint3 quantizedMax = uint3(quantizedA.w, quantizedB.xy);
+
+    float childT[WIDE_BVH_WIDTH];
+    uint childEntry[WIDE_BVH_WIDTH];
+
+    [unroll]
+    for (uint i = 0; i < WIDE_BVH_WIDTH; i++)
+    {
+        const uint shift = i * 8;
+        const float3 boxMin = origin + float3((quantizedMin >> shift) & 0xff) * scale;
+        const float3 boxMax = origin + float3((quantizedMax >> shift) & 0xff) * scale;
+        const float3 boxCenter = (boxMin + boxMax) * 0.5;
+
+        float t;
+        bool hit = RayBoxTest(
+            t,
+            closestT,
+            rayData.OriginTimesRayInverseDirection,
+            rayData.InverseDirection,
+            boxCenter,
+            boxMax - boxCenter);
+        hit = hit && children[i] != InvalidWideBVHChild;
+
+        childT[i] = hit ? t : FLT_MAX;
+        childEntry[i] = hit ? children[i] : InvalidWideBVHChild;
+    }
+
+    // Sorting network for 4 elements, misses sort to the bottom
+    SortFarthestFirst(childT[0], childEntry[0], childT[1], childEntry[1]);
+    SortFarthestFirst(childT[2], childEntry[2], childT[3], childEntry[3]);
+    SortFarthestFirst(childT[0], childEntry[0], childT[2], childEntry[2]);
+    SortFarthestFirst(childT[1], childEntry[1], childT[3], childEntry[3]);
+    SortFarthestFirst(childT[1], childEntry[1], childT[2], childEntry[2]);
+
+    uint numPushed = 0;
+    [unroll]
+    for (uint j = 0; j < WIDE_BVH_WIDTH; j++)
+    {
+        if (childEntry[j] != InvalidWideBVHChild)
+        {
+            StackPush(stackTop, childEntry[j], level, tidInWave);
+            numPushed++;
+        }
+    }
+    return numPushed;
+}
+#endif
+
 bool Traverse(
     uint InstanceInclusionMask,
     uint RayContributionToHitGroupIndex,
@@ -537,18 +639,21 @@ bool Traverse(
     uint instanceFlags = 0;
     uint instanceOffset = 0;
     uint instanceId = 0;
+#if ENABLE_WIDE_BVH
+    uint offsetToWideBVHNodes = 0;
+#endif
 
     uint stackPointer = 0;
     nodesToProcess[TOP_LEVEL_INDEX] = 0;
 
-    RWByteAddressBufferPointer topLevelAccelerationStructure = CreateRWByteAddressBufferPointerFromGpuVA(TopLevelAccelerationStructureGpuVA);
+    // The top level comes from constants, so it never needs the non-uniform decode
+    RWByteAddressBufferPointer topLevelAccelerationStructure = CreateRWByteAddressBufferPointerFromUniformGpuVA(TopLevelAccelerationStructureGpuVA);
     uint offsetToInstanceDescs = GetOffsetToInstanceDesc(topLevelAccelerationStructure);
 
-    RWByteAddressBufferPointer currentBVH = CreateRWByteAddressBufferPointerFromGpuVA(currentGpuVA);
     uint2 flags;
     float unusedT;
     BoundingBox topLevelBox = BVHReadBoundingBox(
-        currentBVH,
+        topLevelAccelerationStructure,
         0,
         flags);
 
@@ -569,6 +674,10 @@ bool Traverse(
 
 
     uint hitLevel = 0;
+#if ENABLE_TRAVERSAL_STATS
+    uint nodesVisited = 0;
+    uint trianglesTested = 0;
+#endif
 
     MARK(1, 0);
     while (nodesToProcess[TOP_LEVEL_INDEX] != 0)
@@ -580,8 +689,35 @@ bool Traverse(
             uint currentLevel;
             uint thisNodeIndex = StackPop(stackPointer, currentLevel, GI);
             nodesToProcess[GetBoolFlag(flagContainer, ProcessingBottomLevel)]--;
+            COUNT_STAT(nodesVisited);
 
-            RWByteAddressBufferPointer currentBVH = CreateRWByteAddressBufferPointerFromGpuVA(currentGpuVA);
+            RWByteAddressBufferPointer currentBVH = topLevelAccelerationStructure;
+            if (GetBoolFlag(flagContainer, ProcessingBottomLevel))
+            {
+                currentBVH = CreateRWByteAddressBufferPointerFromGpuVA(currentGpuVA);
+            }
+
+#if ENABLE_WIDE_BVH
+            // Bottom-level entries index wide nodes, except for leaves that
+            // are read from the BVH2 nodes like before
+            if (GetBoolFlag(flagContainer, ProcessingBottomLevel) && offsetToWideBVHNodes != 0)
+            {
+                if (!(thisNodeIndex & WideBVHChildIsLeafFlag))
+                {
+                    MARK(9, 1);
+                    nodesToProcess[BOTTOM_LEVEL_INDEX] += TestWideBVHNode(
+                        currentBVH.buffer,
+                        offsetToWideBVHNodes + thisNodeIndex * SizeOfWideBVHNode,
+                        RayTCurrent(),
+                        currentRayData,
+                        stackPointer,
+                        currentLevel + 1,
+                        GI);
+                    continue;
+                }
+                thisNodeIndex &= ~WideBVHChildIsLeafFlag;
+            }
+#endif
 
             uint2 flags;
 
@@ -616,6 +752,9 @@ bool Traverse(
                             StackPush(stackPointer, 0, currentLevel + 1, GI);
                             currentGpuVA = instanceDesc.AccelerationStructure;
                             instanceFlags = GetInstanceFlags(instanceDesc);
+#if ENABLE_WIDE_BVH
+                            offsetToWideBVHNodes = GetOffsetToWideBVHNodes(CreateRWByteAddressBufferPointerFromGpuVA(currentGpuVA));
+#endif
 
                             float3x4 CurrentWorldToObject = CreateMatrix(instanceDesc.Transform);
                             float3x4 CurrentObjectToWorld = CreateMatrix(metadata.ObjectToWorld);
@@ -652,6 +791,10 @@ bool Traverse(
                         bool endSearch = false;
 #ifdef DISABLE_PROCEDURAL_GEOMETRY
                         isProceduralGeometry = false;
+#endif
+#if ENABLE_TRAVERSAL_STATS
+                        if (!culled && !isProceduralGeometry)
+                            COUNT_STAT(trianglesTested);
 #endif
                         if (!culled && isProceduralGeometry)
                         {
@@ -791,6 +934,9 @@ bool Traverse(
         currentGpuVA = TopLevelAccelerationStructureGpuVA;
     } 
     MARK(10,0);
+#if ENABLE_TRAVERSAL_STATS
+    RecordTraversalStats(nodesVisited, trianglesTested);
+#endif
     bool isHit = Fallback_InstanceIndex() != NO_HIT_SENTINEL;
 #if ENABLE_ACCELERATION_STRUCTURE_VISUALIZATION
     VisualizeAcceleratonStructure(hitLevel);
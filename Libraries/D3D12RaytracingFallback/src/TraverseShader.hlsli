@@ -35,7 +35,9 @@ export void Fallback_TraceRay(
     float tMax,
     uint payloadOffset)
 {
+#if ENABLE_UAV_LOG
     LogTraceRayStart();
+#endif
     uint oldPayloadOffset = Fallback_TraceRayBegin(rayFlags, float3(originX, originY, originZ), tMin, float3(directionX, directionY, directionZ), tMax, payloadOffset);
     
     bool hit = Traverse(
@@ -69,5 +71,7 @@ export void Fallback_TraceRay(
     }
 
     Fallback_TraceRayEnd(oldPayloadOffset);
+#if ENABLE_UAV_LOG
     LogTraceRayEnd();
+#endif
 }
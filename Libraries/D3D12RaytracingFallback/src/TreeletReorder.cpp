@@ -46,11 +46,12 @@ namespace FallbackLayer
         D3D12_GPU_VIRTUAL_ADDRESS baseTreeletsIndexBuffer,
         D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAGS buildFlag)
     {
-        if (numElements == 0) return;
+        const OptimizationSettings settings = GetOptimizationSettings(buildFlag);
+        if (numElements == 0 || settings.NumPasses == 0) return;
 
         InputConstants constants;
         constants.NumberOfElements = numElements;
-        constants.MinTrianglesPerTreelet = FullTreeletSize;
+        constants.MinTrianglesPerTreelet = settings.MinTrianglesPerTreelet;
 
         pCommandList->SetComputeRootSignature(m_pRootSignature);
         pCommandList->SetComputeRootUnorderedAccessView(HierarchyBufferSlot, hierarchyBuffer);
@@ -60,25 +61,7 @@ namespace FallbackLayer
         pCommandList->SetComputeRootUnorderedAccessView(BaseTreeletsCountBufferSlot, baseTreeletsCountBuffer);
         pCommandList->SetComputeRootUnorderedAccessView(BaseTreeletsIndexBufferSlot, baseTreeletsIndexBuffer);
 
-        bool bPrioritizeTrace = buildFlag & D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_PREFER_FAST_TRACE;
-        bool bPrioritizeBuild = buildFlag & D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_PREFER_FAST_BUILD;
-
-        UINT numOptimizationPasses;
-
-        if (bPrioritizeBuild)
-        {
-            numOptimizationPasses = 0;
-        }
-        else if (bPrioritizeTrace)
-        {
-            numOptimizationPasses = 3;
-        }
-        else
-        {
-            numOptimizationPasses = 1;
-        }
-
-        for (UINT i = 0; i < numOptimizationPasses; i++)
+        for (UINT i = 0; i < settings.NumPasses; i++)
         {
             if (constants.MinTrianglesPerTreelet > numElements)
             {
@@ -104,8 +87,35 @@ namespace FallbackLayer
             pCommandList->Dispatch(maxNumTreelets, 1, 1);
             pCommandList->ResourceBarrier(1, &uavBarrier);
 
-            constants.MinTrianglesPerTreelet *= 2;
+            constants.MinTrianglesPerTreelet *= settings.TreeletGrowthFactor;
+        }
+    }
+
+    TreeletReorder::OptimizationSettings TreeletReorder::GetOptimizationSettings(D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAGS buildFlags)
+    {
+        const bool bPrioritizeTrace = buildFlags & D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_PREFER_FAST_TRACE;
+        const bool bPrioritizeBuild = buildFlags & D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_PREFER_FAST_BUILD;
+        const bool bDynamic = buildFlags & D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_ALLOW_UPDATE;
+
+        // The shaders reorder treelets of exactly FullTreeletSize leaves, so that is also
+        // the smallest subtree a treelet can be rooted at
+        OptimizationSettings settings = {};
+        settings.MinTrianglesPerTreelet = FullTreeletSize;
+        settings.TreeletGrowthFactor = 2;
+
+        if (bPrioritizeTrace)
+        {
+            settings.NumPasses = 3;
+        }
+        else if (bPrioritizeBuild || bDynamic)
+        {
+            settings.NumPasses = 0;
+        }
+        else
+        {
+            settings.NumPasses = 1;
         }
+        return settings;
     }
 
     UINT TreeletReorder::RequiredSizeForAABBBuffer(UINT numElements)
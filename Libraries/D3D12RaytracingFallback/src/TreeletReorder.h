@@ -16,6 +16,21 @@ namespace FallbackLayer
     public:
         TreeletReorder(ID3D12Device *pDevice, UINT nodeMask);
 
+        // How much of the build is spent reordering treelets. Each pass reorders the treelets
+        // rooted at subtrees of at least MinTrianglesPerTreelet triangles, and every pass after
+        // the first starts from subtrees TreeletGrowthFactor times larger, moving up the tree.
+        struct OptimizationSettings
+        {
+            UINT NumPasses;
+            UINT MinTrianglesPerTreelet;
+            UINT TreeletGrowthFactor;
+        };
+
+        // PREFER_FAST_BUILD and acceleration structures that allow updates skip reordering
+        // unless PREFER_FAST_TRACE is also set, since they are expected to be rebuilt or
+        // refit often. Only PREFER_FAST_TRACE runs more than one pass.
+        static OptimizationSettings GetOptimizationSettings(D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAGS buildFlags);
+
         void Optimize(
             ID3D12GraphicsCommandList *pCommandList,
             UINT numElements,
@@ -19,6 +19,7 @@
 #endif
 
 #define UAVLogRegister 1
+#define TraversalStatsRegister 2
 #define DebugConstantRegister 10
 
 struct DebugVariables
@@ -26,6 +27,12 @@ struct DebugVariables
     uint LevelToVisualize;
 };
 
+// Byte offsets of the counters in the TraversalStats buffer
+#define TraversalStatsRaysOffset 0
+#define TraversalStatsNodesVisitedOffset 4
+#define TraversalStatsTrianglesTestedOffset 8
+#define TraversalStatsSize 12
+
 #define FallbackLayerDescriptorHeapRegisterSpace 214743648
 #ifdef HLSL
 cbuffer Constants : CONSTANT_REGISTER_SPACE(FallbackLayerDispatchConstantsRegister, FallbackLayerRegisterSpace)
@@ -57,6 +64,10 @@ RWByteAddressBuffer DescriptorHeapBufferTable[] : UAV_REGISTER_SPACE(FallbackLay
 RWStructuredBuffer<uint4> DebugLog : UAV_REGISTER_SPACE(UAVLogRegister, FallbackLayerRegisterSpace);
 #endif
 
+#if ENABLE_TRAVERSAL_STATS
+RWByteAddressBuffer TraversalStats : UAV_REGISTER_SPACE(TraversalStatsRegister, FallbackLayerRegisterSpace);
+#endif
+
 #if ENABLE_ACCELERATION_STRUCTURE_VISUALIZATION
 cbuffer DebugVariables : CONSTANT_REGISTER_SPACE(DebugConstantRegister, FallbackLayerRegisterSpace)
 {
@@ -13,14 +13,60 @@
 
 namespace FallbackLayer
 {
-    void CompilePSO(ID3D12Device *pDevice, D3D12_SHADER_BYTECODE shaderByteCode, const StateObjectCollection &stateObjectCollection, ID3D12PipelineState **ppPipelineState)
+    void AddRootSignatureToHash(StateObjectHash &hash, ID3D12RootSignature *pRootSignature)
     {
-        D3D12_COMPUTE_PIPELINE_STATE_DESC psoDesc = {};
-        psoDesc.CS = CD3DX12_SHADER_BYTECODE(shaderByteCode);
-        psoDesc.NodeMask = stateObjectCollection.m_nodeMask;
-        psoDesc.pRootSignature = stateObjectCollection.m_pGlobalRootSignature;
+        UINT blobSize = 0;
+        if (pRootSignature && SUCCEEDED(pRootSignature->GetPrivateData(FallbackLayerBlobPrivateDataGUID, &blobSize, nullptr)))
+        {
+            std::unique_ptr<BYTE[]> pBlobData = std::unique_ptr<BYTE[]>(new BYTE[blobSize]);
+            pRootSignature->GetPrivateData(FallbackLayerBlobPrivateDataGUID, &blobSize, pBlobData.get());
+            hash.Add(pBlobData.get(), blobSize);
+        }
+        hash.Add(blobSize);
+    }
+
+    // Hashes every input to linking and to the PSO compile. Descriptor sizes are
+    // baked into the patched shader records, so they're part of the key too.
+    UINT64 GetStateObjectCacheKey(const StateObjectCollection &stateObjectCollection, UINT cbvSrvUavHandleSize, UINT samplerHandleSize)
+    {
+        StateObjectHash hash;
+        for (auto &lib : stateObjectCollection.m_dxilLibraries)
+        {
+            hash.Add(lib.DXILLibrary.pShaderBytecode, lib.DXILLibrary.BytecodeLength);
+            hash.Add((UINT)lib.DXILLibrary.BytecodeLength);
+        }
+
+        for (auto &exportDesc : stateObjectCollection.m_exportDescs)
+        {
+            hash.Add(exportDesc.ExportName);
+            hash.Add(exportDesc.ExportToRename);
+        }
 
-        ThrowInternalFailure(pDevice->CreateComputePipelineState(&psoDesc, IID_PPV_ARGS(ppPipelineState)));
+        for (auto &associationPair : stateObjectCollection.m_shaderAssociations)
+        {
+            hash.Add(associationPair.first.c_str());
+            AddRootSignatureToHash(hash, associationPair.second.m_pRootSignature);
+        }
+
+        for (auto &hitGroupMapEntry : stateObjectCollection.m_hitGroups)
+        {
+            hash.Add(hitGroupMapEntry.first.c_str());
+            hash.Add(hitGroupMapEntry.second.ClosestHitShaderImport);
+            hash.Add(hitGroupMapEntry.second.AnyHitShaderImport);
+            hash.Add(hitGroupMapEntry.second.IntersectionShaderImport);
+        }
+
+        auto &traversalShader = stateObjectCollection.m_traversalShader.DXILLibrary;
+        hash.Add(traversalShader.pShaderBytecode, traversalShader.BytecodeLength);
+        hash.Add(g_pStateMachineLib, sizeof(g_pStateMachineLib));
+        AddRootSignatureToHash(hash, stateObjectCollection.m_pGlobalRootSignature);
+
+        hash.Add(stateObjectCollection.m_maxAttributeSizeInBytes);
+        hash.Add(stateObjectCollection.m_config.MaxTraceRecursionDepth);
+        hash.Add(stateObjectCollection.m_nodeMask);
+        hash.Add(cbvSrvUavHandleSize);
+        hash.Add(samplerHandleSize);
+        return hash.GetHash();
     }
 
     UINT64 UberShaderRaytracingProgram::GetShaderStackSize(LPCWSTR pExportName)
@@ -49,8 +95,7 @@ namespace FallbackLayer
     }
 
 
-    UberShaderRaytracingProgram::UberShaderRaytracingProgram(ID3D12Device *pDevice, DxilShaderPatcher &dxilShaderPatcher, const StateObjectCollection &stateObjectCollection) :
-        m_DxilShaderPatcher(dxilShaderPatcher)
+    void UberShaderRaytracingProgram::Link(const StateObjectCollection &stateObjectCollection, UINT cbvSrvUavHandleSize, UINT samplerHandleSize, std::vector<BYTE> &linkedDxil)
     {
         UINT numLibraries = (UINT)stateObjectCollection.m_dxilLibraries.size();
 
@@ -62,9 +107,6 @@ namespace FallbackLayer
 
         std::vector<CComPtr<IDxcBlob>> patchedBlobList;
 
-        UINT cbvSrvUavHandleSize = pDevice->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
-        UINT samplerHandleSize = pDevice->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER);
-        
         ViewKey SRVViewsList[FallbackLayerNumDescriptorHeapSpacesPerView];
         UINT SRVsUsed = 0;
         ViewKey UAVViewsList[FallbackLayerNumDescriptorHeapSpacesPerView];
@@ -179,11 +221,56 @@ namespace FallbackLayer
         CComPtr<IDxcBlob> pLinkedBlob;
         m_DxilShaderPatcher.LinkStateObject(stateObjectCollection.m_maxAttributeSizeInBytes, stackSize, pCollectionBlob, exportNames, shaderInfo, &pLinkedBlob);
 
-        CompilePSO(
-            pDevice, 
-            CD3DX12_SHADER_BYTECODE(pLinkedBlob->GetBufferPointer(), pLinkedBlob->GetBufferSize()), 
-            stateObjectCollection, 
-            &m_pRayTracePSO);
+        const BYTE *pLinkedDxil = (const BYTE *)pLinkedBlob->GetBufferPointer();
+        linkedDxil.assign(pLinkedDxil, pLinkedDxil + pLinkedBlob->GetBufferSize());
+    }
+
+    UberShaderRaytracingProgram::UberShaderRaytracingProgram(ID3D12Device *pDevice, DxilShaderPatcher &dxilShaderPatcher, StateObjectCache &stateObjectCache, const StateObjectCollection &stateObjectCollection) :
+        m_DxilShaderPatcher(dxilShaderPatcher)
+    {
+        UINT cbvSrvUavHandleSize = pDevice->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+        UINT samplerHandleSize = pDevice->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER);
+
+        UINT64 cacheKey = 0;
+        CachedStateObject linkedStateObject;
+        bool isCached = false;
+        if (stateObjectCache.IsEnabled())
+        {
+            cacheKey = GetStateObjectCacheKey(stateObjectCollection, cbvSrvUavHandleSize, samplerHandleSize);
+            isCached = stateObjectCache.Find(cacheKey, linkedStateObject);
+        }
+
+        if (isCached)
+        {
+            for (auto &shaderEntry : linkedStateObject.ShaderData)
+            {
+                m_ExportNameToShaderData[shaderEntry.first] = { shaderEntry.second.Identifier, shaderEntry.second.StackSize };
+            }
+        }
+        else
+        {
+            Link(stateObjectCollection, cbvSrvUavHandleSize, samplerHandleSize, linkedStateObject.LinkedDxil);
+            for (auto &shaderEntry : m_ExportNameToShaderData)
+            {
+                linkedStateObject.ShaderData[shaderEntry.first] = { shaderEntry.second.stateIdentifier, shaderEntry.second.stackSize };
+            }
+        }
+        const std::vector<BYTE> &linkedDxil = linkedStateObject.LinkedDxil;
+
+        D3D12_COMPUTE_PIPELINE_STATE_DESC psoDesc = {};
+        psoDesc.CS = CD3DX12_SHADER_BYTECODE(linkedDxil.data(), linkedDxil.size());
+        psoDesc.NodeMask = stateObjectCollection.m_nodeMask;
+        psoDesc.pRootSignature = stateObjectCollection.m_pGlobalRootSignature;
+        stateObjectCache.CreatePipelineState(cacheKey, psoDesc, &m_pRayTracePSO);
+
+        if (stateObjectCache.IsEnabled())
+        {
+            if (!isCached)
+            {
+                stateObjectCache.Store(cacheKey, std::move(linkedStateObject));
+            }
+            stateObjectCache.Flush();
+        }
         
         UINT sizeOfParamterStart = sizeof(m_patchRootSignatureParameterStart);
         ThrowFailure(stateObjectCollection.m_pGlobalRootSignature->GetPrivateData(
@@ -15,7 +15,7 @@ namespace FallbackLayer
     class UberShaderRaytracingProgram : public IRaytracingProgram
     {
     public:
-        UberShaderRaytracingProgram(ID3D12Device *m_pDevice, DxilShaderPatcher &dxilShaderPatcher, const StateObjectCollection &stateObjectCollection);
+        UberShaderRaytracingProgram(ID3D12Device *m_pDevice, DxilShaderPatcher &dxilShaderPatcher, StateObjectCache &stateObjectCache, const StateObjectCollection &stateObjectCollection);
         virtual ~UberShaderRaytracingProgram() {}
         virtual void DispatchRays(
             ID3D12GraphicsCommandList *pCommandList, 
@@ -35,6 +35,9 @@ namespace FallbackLayer
     private:
         StateIdentifier GetStateIdentfier(LPCWSTR pExportName);
 
+        // Patches and links the collection into the uber-shader, filling in m_ExportNameToShaderData
+        void Link(const StateObjectCollection &stateObjectCollection, UINT cbvSrvUavHandleSize, UINT samplerHandleSize, std::vector<BYTE> &linkedDxil);
+
         DxilShaderPatcher &m_DxilShaderPatcher;
         struct ShaderData
         {
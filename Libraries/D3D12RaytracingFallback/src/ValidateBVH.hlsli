@@ -0,0 +1,27 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+#define HLSL
+#include "ValidateBVHBindings.h"
+#include "RayTracingHelper.hlsli"
+
+static const uint RootNodeIndex = 0;
+
+uint GetThreadIndex(uint3 DTid)
+{
+    return DTid.y * ValidateBVHGroupsPerRow * THREAD_GROUP_1D_WIDTH + DTid.x;
+}
+
+// Boxes are followed by the primitives in a bottom level and by the instance metadata
+// in a top level, either way the header has to agree with the number of elements
+bool IsBVHHeaderValid(RWByteAddressBufferPointer pointer)
+{
+    return GetOffsetToVertices(pointer) == GetOffsetToPrimitives(Constants.NumberOfElements);
+}
@@ -0,0 +1,110 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+#pragma once
+#include "RaytracingHlslCompat.h"
+#ifdef HLSL
+#include "ShaderUtil.hlsli"
+#endif
+
+struct ValidateBVHConstants
+{
+    uint NumberOfElements;
+
+    // Top level leaves point at instances, which are only checked for coverage
+    uint IsTopLevel;
+};
+
+// Multi-million triangle bottom levels have more nodes than a single row of
+// groups can cover, so the dispatches wrap into more rows of this many groups
+#define ValidateBVHGroupsPerRow 65535
+
+// CBVs
+#define ValidateBVHConstantsRegister 0
+
+// UAVs
+#define ValidateBVHBufferRegister 0
+#define ValidateBVHScratchRegister 1
+#define ValidateBVHErrorListRegister 2
+
+// The error list is a count followed by up to MaxBVHValidationErrors errors. The
+// count keeps going past the maximum so that callers know how many were dropped.
+#define MaxBVHValidationErrors 256
+#define OffsetToBVHValidationErrors 4
+#define SizeOfBVHValidationError 8
+#define SizeOfBVHValidationErrorList (OffsetToBVHValidationErrors + MaxBVHValidationErrors * SizeOfBVHValidationError)
+
+struct BVHValidationError
+{
+    uint ErrorType;
+
+    // Node index, or element index for the leaf coverage errors
+    uint Index;
+};
+
+#define BVHValidationErrorInvalidHeader 1         // The header's offsets don't match the number of elements
+#define BVHValidationErrorInvalidBox 2            // A box has a NaN in it
+#define BVHValidationErrorInvalidChildIndex 3     // A child index is out of range or points at the root
+#define BVHValidationErrorChildNotContained 4     // A child's box isn't contained by its parent's
+#define BVHValidationErrorInvalidLeafIndex 5      // A leaf points past the last element
+#define BVHValidationErrorPrimitiveNotContained 6 // A leaf's box doesn't contain its primitive
+#define BVHValidationErrorWideChildNotContained 7 // A wide node's quantized child box doesn't contain the BVH2 child
+#define BVHValidationErrorMultipleParents 8       // A node is the child of more than one node
+#define BVHValidationErrorUnreachableNode 9       // A node can't be reached from the root
+#define BVHValidationErrorMissingLeaf 10          // An element isn't referenced by any leaf
+#define BVHValidationErrorDuplicateLeaf 11        // An element is referenced by more than one leaf
+
+// Scratch holds a parent count and a parent index per node, then a leaf count per element
+inline
+uint GetNumBVHValidationNodes(uint numElements)
+{
+    return numElements + GetNumInternalNodes(numElements);
+}
+
+inline
+uint GetOffsetToBVHValidationParentIndices(uint numElements)
+{
+    return SizeOfUINT32 * GetNumBVHValidationNodes(numElements);
+}
+
+inline
+uint GetOffsetToBVHValidationLeafCounts(uint numElements)
+{
+    return 2 * SizeOfUINT32 * GetNumBVHValidationNodes(numElements);
+}
+
+inline
+uint GetBVHValidationScratchSize(uint numElements)
+{
+    return GetOffsetToBVHValidationLeafCounts(numElements) + SizeOfUINT32 * numElements;
+}
+
+#ifdef HLSL
+cbuffer ValidateBVHConstants : CONSTANT_REGISTER(ValidateBVHConstantsRegister)
+{
+    ValidateBVHConstants Constants;
+}
+
+// These need to be UAVs despite being read-only because the fallback layer only gets a 
+// GPU VA and the API doesn't allow any way to transition that GPU VA from UAV->SRV
+RWByteAddressBuffer BVH : UAV_REGISTER(ValidateBVHBufferRegister);
+RWByteAddressBuffer ValidationScratch : UAV_REGISTER(ValidateBVHScratchRegister);
+RWByteAddressBuffer ErrorList : UAV_REGISTER(ValidateBVHErrorListRegister);
+
+void ReportBVHValidationError(uint errorType, uint index)
+{
+    uint errorIndex;
+    ErrorList.InterlockedAdd(0, 1, errorIndex);
+    if (errorIndex < MaxBVHValidationErrors)
+    {
+        ErrorList.Store2(OffsetToBVHValidationErrors + errorIndex * SizeOfBVHValidationError, uint2(errorType, index));
+    }
+}
+#endif
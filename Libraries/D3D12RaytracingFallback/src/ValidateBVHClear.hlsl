@@ -0,0 +1,33 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+#include "ValidateBVH.hlsli"
+
+[numthreads(THREAD_GROUP_1D_WIDTH, 1, 1)]
+void main(uint3 DTid : SV_DispatchThreadID)
+{
+    const uint threadIndex = GetThreadIndex(DTid);
+    if (threadIndex == 0)
+    {
+        ErrorList.Store(0, 0);
+    }
+
+    // Parent counts and leaf counts, the parent indices are only read for nodes with a parent
+    const uint numberOfNodes = GetNumBVHValidationNodes(Constants.NumberOfElements);
+    if (threadIndex < numberOfNodes)
+    {
+        ValidationScratch.Store(threadIndex * SizeOfUINT32, 0);
+    }
+
+    if (threadIndex < Constants.NumberOfElements)
+    {
+        ValidationScratch.Store(GetOffsetToBVHValidationLeafCounts(Constants.NumberOfElements) + threadIndex * SizeOfUINT32, 0);
+    }
+}
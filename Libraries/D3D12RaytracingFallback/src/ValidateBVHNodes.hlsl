@@ -0,0 +1,184 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+#include "ValidateBVH.hlsli"
+
+// Same as TEST_EPSILON in BVHValidator.cpp, but scaled up for boxes far enough from
+// the origin that a float can't resolve it
+static const float ContainmentEpsilon = 0.001;
+
+bool IsBoxInvalid(AABB box)
+{
+    return any(isnan(box.min)) || any(isnan(box.max));
+}
+
+// Instances with an InstanceMask of 0 get an inside-out box that anything contains
+bool IsBoxEmpty(AABB box)
+{
+    return any(box.min > box.max);
+}
+
+bool IsContainedBy(AABB parent, AABB child, float epsilonScale)
+{
+    const float3 epsilon = epsilonScale * max(ContainmentEpsilon, 1e-5 * max(abs(parent.min), abs(parent.max)));
+    return IsBoxEmpty(child) || (all(parent.min - epsilon <= child.min) && all(parent.max + epsilon >= child.max));
+}
+
+AABB ReadNodeAABB(RWByteAddressBufferPointer pointer, uint nodeIndex, out uint2 flags)
+{
+    return BoundingBoxToAABB(BVHReadBoundingBox(pointer, nodeIndex, flags));
+}
+
+AABB ReadPrimitiveAABB(RWByteAddressBufferPointer pointer, uint primitiveIndex, bool isProceduralGeometry)
+{
+    AABB aabb;
+    if (isProceduralGeometry)
+    {
+        const uint primitiveAddress = GetOffsetToVertices(pointer) + primitiveIndex * SizeOfPrimitive + OffsetToPrimitiveData;
+        aabb = RawDataToAABB(BVH.Load4(primitiveAddress), BVH.Load2(primitiveAddress + 16));
+    }
+    else
+    {
+        float3 v0, v1, v2;
+        BVHReadTriangle(pointer, v0, v1, v2, primitiveIndex);
+        aabb.min = min(v0, min(v1, v2));
+        aabb.max = max(v0, max(v1, v2));
+    }
+    return aabb;
+}
+
+void ValidateChild(RWByteAddressBufferPointer pointer, uint nodeIndex, AABB nodeAABB, uint childIndex, uint numberOfNodes)
+{
+    if (childIndex == RootNodeIndex || childIndex == nodeIndex || childIndex >= numberOfNodes)
+    {
+        ReportBVHValidationError(BVHValidationErrorInvalidChildIndex, nodeIndex);
+        return;
+    }
+
+    ValidationScratch.InterlockedAdd(childIndex * SizeOfUINT32, 1);
+    ValidationScratch.Store(GetOffsetToBVHValidationParentIndices(Constants.NumberOfElements) + childIndex * SizeOfUINT32, nodeIndex);
+
+    uint2 childFlags;
+    if (!IsContainedBy(nodeAABB, ReadNodeAABB(pointer, childIndex, childFlags), 1.0))
+    {
+        ReportBVHValidationError(BVHValidationErrorChildNotContained, childIndex);
+    }
+}
+
+// The quantized boxes are rounded outwards when the wide node is written, so they must
+// contain the BVH2 boxes they stand in for. The small epsilon only covers the decode
+// here getting contracted differently than the one in CollapseWideBVH.hlsl.
+void ValidateWideBVHNode(RWByteAddressBufferPointer pointer, uint nodeAddress, uint nodeIndex, uint numberOfNodes)
+{
+    const uint4 header = BVH.Load4(nodeAddress);
+    const uint4 children = BVH.Load4(nodeAddress + OffsetToWideBVHChildren);
+    const uint4 quantizedA = BVH.Load4(nodeAddress + OffsetToWideBVHQuantizedBounds);
+    const uint4 quantizedB = BVH.Load4(nodeAddress + OffsetToWideBVHQuantizedBounds + 16);
+
+    const float3 origin = asfloat(header.xyz);
+    const float3 scale = asfloat(((header.www >> uint3(0, 8, 16)) & 0xff) << 23);
+    const uint3 quantizedMin = quantizedA.xyz;
+    const uint3 quantizedMax = uint3(quantizedA.w, quantizedB.xy);
+
+    [unroll]
+    for (uint i = 0; i < WIDE_BVH_WIDTH; i++)
+    {
+        if (children[i] == InvalidWideBVHChild)
+        {
+            continue;
+        }
+
+        const uint childIndex = children[i] & ~WideBVHChildIsLeafFlag;
+        if (childIndex >= numberOfNodes)
+        {
+            ReportBVHValidationError(BVHValidationErrorInvalidChildIndex, nodeIndex);
+            continue;
+        }
+
+        uint2 childFlags;
+        const AABB childAABB = ReadNodeAABB(pointer, childIndex, childFlags);
+        if (IsLeaf(childFlags) != ((children[i] & WideBVHChildIsLeafFlag) != 0))
+        {
+            ReportBVHValidationError(BVHValidationErrorInvalidChildIndex, nodeIndex);
+            continue;
+        }
+
+        const uint shift = i * 8;
+        AABB wideChildAABB;
+        wideChildAABB.min = origin + float3((quantizedMin >> shift) & 0xff) * scale;
+        wideChildAABB.max = origin + float3((quantizedMax >> shift) & 0xff) * scale;
+        if (!IsContainedBy(wideChildAABB, childAABB, 0.01))
+        {
+            ReportBVHValidationError(BVHValidationErrorWideChildNotContained, childIndex);
+        }
+    }
+}
+
+// One thread per node checks the node against its children or its primitive, and
+// counts the parents of every node and the leaves of every element for the next pass
+[numthreads(THREAD_GROUP_1D_WIDTH, 1, 1)]
+void main(uint3 DTid : SV_DispatchThreadID)
+{
+    const uint nodeIndex = GetThreadIndex(DTid);
+    const RWByteAddressBufferPointer pointer = CreateRWByteAddressBufferPointer(BVH, 0);
+    if (!IsBVHHeaderValid(pointer))
+    {
+        if (nodeIndex == 0)
+        {
+            ReportBVHValidationError(BVHValidationErrorInvalidHeader, 0);
+        }
+        return;
+    }
+
+    const uint numberOfNodes = GetNumBVHValidationNodes(Constants.NumberOfElements);
+    if (nodeIndex >= numberOfNodes)
+    {
+        return;
+    }
+
+    uint2 flags;
+    const AABB nodeAABB = ReadNodeAABB(pointer, nodeIndex, flags);
+    if (IsBoxInvalid(nodeAABB))
+    {
+        ReportBVHValidationError(BVHValidationErrorInvalidBox, nodeIndex);
+    }
+
+    if (!Constants.IsTopLevel && nodeIndex < GetNumInternalNodes(Constants.NumberOfElements))
+    {
+        const uint offsetToWideBVHNodes = GetOffsetToWideBVHNodes(pointer);
+        if (offsetToWideBVHNodes != 0)
+        {
+            ValidateWideBVHNode(pointer, offsetToWideBVHNodes + nodeIndex * SizeOfWideBVHNode, nodeIndex, numberOfNodes);
+        }
+    }
+
+    if (IsLeaf(flags))
+    {
+        const uint elementIndex = GetLeafIndexFromFlag(flags);
+        if (elementIndex >= Constants.NumberOfElements)
+        {
+            ReportBVHValidationError(BVHValidationErrorInvalidLeafIndex, nodeIndex);
+            return;
+        }
+
+        ValidationScratch.InterlockedAdd(GetOffsetToBVHValidationLeafCounts(Constants.NumberOfElements) + elementIndex * SizeOfUINT32, 1);
+
+        if (!Constants.IsTopLevel &&
+            !IsContainedBy(nodeAABB, ReadPrimitiveAABB(pointer, elementIndex, IsProceduralGeometry(flags)), 1.0))
+        {
+            ReportBVHValidationError(BVHValidationErrorPrimitiveNotContained, nodeIndex);
+        }
+    }
+    else
+    {
+        ValidateChild(pointer, nodeIndex, nodeAABB, GetLeftNodeIndex(flags), numberOfNodes);
+        ValidateChild(pointer, nodeIndex, nodeAABB, GetRightNodeIndex(flags), numberOfNodes);
+    }
+}
@@ -0,0 +1,78 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+#include "ValidateBVH.hlsli"
+
+uint LoadParentCount(uint nodeIndex)
+{
+    return ValidationScratch.Load(nodeIndex * SizeOfUINT32);
+}
+
+uint LoadParentIndex(uint nodeIndex)
+{
+    return ValidationScratch.Load(GetOffsetToBVHValidationParentIndices(Constants.NumberOfElements) + nodeIndex * SizeOfUINT32);
+}
+
+// Every node but the root needs exactly one parent, and following the parents has to
+// lead to the root, otherwise the node is part of a cycle that traversal never enters.
+// Every element needs exactly one leaf.
+[numthreads(THREAD_GROUP_1D_WIDTH, 1, 1)]
+void main(uint3 DTid : SV_DispatchThreadID)
+{
+    const uint threadIndex = GetThreadIndex(DTid);
+    if (!IsBVHHeaderValid(CreateRWByteAddressBufferPointer(BVH, 0)))
+    {
+        return;
+    }
+
+    if (threadIndex < Constants.NumberOfElements)
+    {
+        const uint leafCount = ValidationScratch.Load(GetOffsetToBVHValidationLeafCounts(Constants.NumberOfElements) + threadIndex * SizeOfUINT32);
+        if (leafCount == 0)
+        {
+            ReportBVHValidationError(BVHValidationErrorMissingLeaf, threadIndex);
+        }
+        else if (leafCount > 1)
+        {
+            ReportBVHValidationError(BVHValidationErrorDuplicateLeaf, threadIndex);
+        }
+    }
+
+    const uint numberOfNodes = GetNumBVHValidationNodes(Constants.NumberOfElements);
+    const uint nodeIndex = threadIndex;
+    if (nodeIndex >= numberOfNodes || nodeIndex == RootNodeIndex)
+    {
+        return;
+    }
+
+    const uint parentCount = LoadParentCount(nodeIndex);
+    if (parentCount > 1)
+    {
+        ReportBVHValidationError(BVHValidationErrorMultipleParents, nodeIndex);
+        return;
+    }
+
+    // A cycle can't be longer than the number of nodes, a valid tree ends at
+    // the root after as many steps as the node is deep
+    uint ancestorIndex = nodeIndex;
+    for (uint step = 0; step < numberOfNodes && ancestorIndex != RootNodeIndex; step++)
+    {
+        if (LoadParentCount(ancestorIndex) == 0)
+        {
+            break;
+        }
+        ancestorIndex = LoadParentIndex(ancestorIndex);
+    }
+
+    if (ancestorIndex != RootNodeIndex)
+    {
+        ReportBVHValidationError(BVHValidationErrorUnreachableNode, nodeIndex);
+    }
+}
@@ -26,6 +26,11 @@
 #include <map>
 #include <deque>
 #include <string>
+#include <fstream>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 #include <strsafe.h>
 #include "d3d12_1.h"
 #include "d3dx12.h"
@@ -50,6 +55,7 @@
 #include "D3D12RaytracingFallback.h"
 #include "RaytracingCompatibilityDebug.h"
 #include "ComObject.h"
+#include "StateObjectBatch.h"
 
 #include "NativeRaytracing.h"
 #include "ExperimentalRaytracing.h"
@@ -62,11 +68,14 @@
 #include "AccelerationStructureBuilderFactory.h"
 #include "TraversalShaderBuilder.h"
 #include "RaytracingProgram.h"
+#include "StateObjectCache.h"
 #include "RaytracingProgramFactory.h"
 #include "FallbackLayer.h"
 
 // Validators
 #include "BVHValidator.h"
+#include "ValidateBVHBindings.h"
+#include "GpuBvhValidator.h"
 
 // Traversal Builders
 #include "BVHTraversalShaderBuilder.h"
@@ -75,6 +84,7 @@
 #include "GetBVHCompactedSizeBindings.h"
 #include "ShaderPass.h"
 #include "BitonicSort.h"
+#include "RadixSort.h"
 #include "SceneAABBCalculator.h"
 #include "MortonCodesCalculator.h"
 #include "RearrangeElementsPass.h"
@@ -82,6 +92,8 @@
 #include "LoadPrimitivesPass.h"
 #include "ConstructHierarchyPass.h"
 #include "ConstructAABBPass.h"
+#include "CollapseWideBVHPass.h"
+#include "CompressTrianglesPass.h"
 #include "PostBuildInfoQuery.h"
 #include "GpuBvh2Copy.h"
 #include "TreeletReorder.h"
@@ -14,6 +14,10 @@
 
 #include "d3d12.h"
 
+#if defined(_M_IX86) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
 #if defined( __cplusplus )
 
 struct CD3DX12_DEFAULT {};
@@ -34,44 +38,34 @@ inline bool operator!=( const D3D12_VIEWPORT& l, const D3D12_VIEWPORT& r )
 struct CD3DX12_RECT : public D3D12_RECT
 {
     CD3DX12_RECT() = default;
-    explicit CD3DX12_RECT( const D3D12_RECT& o ) :
+    explicit constexpr CD3DX12_RECT( const D3D12_RECT& o ) :
         D3D12_RECT( o )
     {}
-    explicit CD3DX12_RECT(
+    explicit constexpr CD3DX12_RECT(
         LONG Left,
         LONG Top,
         LONG Right,
-        LONG Bottom )
-    {
-        left = Left;
-        top = Top;
-        right = Right;
-        bottom = Bottom;
-    }
+        LONG Bottom ) :
+        D3D12_RECT{ Left, Top, Right, Bottom }
+    {}
 };
 
 //------------------------------------------------------------------------------------------------
 struct CD3DX12_VIEWPORT : public D3D12_VIEWPORT
 {
     CD3DX12_VIEWPORT() = default;
-    explicit CD3DX12_VIEWPORT( const D3D12_VIEWPORT& o ) :
+    explicit constexpr CD3DX12_VIEWPORT( const D3D12_VIEWPORT& o ) :
         D3D12_VIEWPORT( o )
     {}
-    explicit CD3DX12_VIEWPORT(
+    explicit constexpr CD3DX12_VIEWPORT(
         FLOAT topLeftX,
         FLOAT topLeftY,
         FLOAT width,
         FLOAT height,
         FLOAT minDepth = D3D12_MIN_DEPTH,
-        FLOAT maxDepth = D3D12_MAX_DEPTH )
-    {
-        TopLeftX = topLeftX;
-        TopLeftY = topLeftY;
-        Width = width;
-        Height = height;
-        MinDepth = minDepth;
-        MaxDepth = maxDepth;
-    }
+        FLOAT maxDepth = D3D12_MAX_DEPTH ) :
+        D3D12_VIEWPORT{ topLeftX, topLeftY, width, height, minDepth, maxDepth }
+    {}
     explicit CD3DX12_VIEWPORT(
         _In_ ID3D12Resource* pResource,
         UINT mipSlice = 0,
@@ -116,48 +110,31 @@ struct CD3DX12_VIEWPORT : public D3D12_VIEWPORT
 struct CD3DX12_BOX : public D3D12_BOX
 {
     CD3DX12_BOX() = default;
-    explicit CD3DX12_BOX( const D3D12_BOX& o ) :
+    explicit constexpr CD3DX12_BOX( const D3D12_BOX& o ) :
         D3D12_BOX( o )
     {}
-    explicit CD3DX12_BOX(
+    explicit constexpr CD3DX12_BOX(
         LONG Left,
-        LONG Right )
-    {
-        left = Left;
-        top = 0;
-        front = 0;
-        right = Right;
-        bottom = 1;
-        back = 1;
-    }
-    explicit CD3DX12_BOX(
+        LONG Right ) :
+        D3D12_BOX{ static_cast<UINT>(Left), 0, 0, static_cast<UINT>(Right), 1, 1 }
+    {}
+    explicit constexpr CD3DX12_BOX(
         LONG Left,
         LONG Top,
         LONG Right,
-        LONG Bottom )
-    {
-        left = Left;
-        top = Top;
-        front = 0;
-        right = Right;
-        bottom = Bottom;
-        back = 1;
-    }
-    explicit CD3DX12_BOX(
+        LONG Bottom ) :
+        D3D12_BOX{ static_cast<UINT>(Left), static_cast<UINT>(Top), 0, static_cast<UINT>(Right), static_cast<UINT>(Bottom), 1 }
+    {}
+    explicit constexpr CD3DX12_BOX(
         LONG Left,
         LONG Top,
         LONG Front,
         LONG Right,
         LONG Bottom,
-        LONG Back )
-    {
-        left = Left;
-        top = Top;
-        front = Front;
-        right = Right;
-        bottom = Bottom;
-        back = Back;
-    }
+        LONG Back ) :
+        D3D12_BOX{ static_cast<UINT>(Left), static_cast<UINT>(Top), static_cast<UINT>(Front),
+            static_cast<UINT>(Right), static_cast<UINT>(Bottom), static_cast<UINT>(Back) }
+    {}
 };
 inline bool operator==( const D3D12_BOX& l, const D3D12_BOX& r )
 {
@@ -171,23 +148,16 @@ inline bool operator!=( const D3D12_BOX& l, const D3D12_BOX& r )
 struct CD3DX12_DEPTH_STENCIL_DESC : public D3D12_DEPTH_STENCIL_DESC
 {
     CD3DX12_DEPTH_STENCIL_DESC() = default;
-    explicit CD3DX12_DEPTH_STENCIL_DESC( const D3D12_DEPTH_STENCIL_DESC& o ) :
+    explicit constexpr CD3DX12_DEPTH_STENCIL_DESC( const D3D12_DEPTH_STENCIL_DESC& o ) :
         D3D12_DEPTH_STENCIL_DESC( o )
     {}
-    explicit CD3DX12_DEPTH_STENCIL_DESC( CD3DX12_DEFAULT )
-    {
-        DepthEnable = TRUE;
-        DepthWriteMask = D3D12_DEPTH_WRITE_MASK_ALL;
-        DepthFunc = D3D12_COMPARISON_FUNC_LESS;
-        StencilEnable = FALSE;
-        StencilReadMask = D3D12_DEFAULT_STENCIL_READ_MASK;
-        StencilWriteMask = D3D12_DEFAULT_STENCIL_WRITE_MASK;
-        const D3D12_DEPTH_STENCILOP_DESC defaultStencilOp =
-        { D3D12_STENCIL_OP_KEEP, D3D12_STENCIL_OP_KEEP, D3D12_STENCIL_OP_KEEP, D3D12_COMPARISON_FUNC_ALWAYS };
-        FrontFace = defaultStencilOp;
-        BackFace = defaultStencilOp;
-    }
-    explicit CD3DX12_DEPTH_STENCIL_DESC(
+    explicit constexpr CD3DX12_DEPTH_STENCIL_DESC( CD3DX12_DEFAULT ) :
+        D3D12_DEPTH_STENCIL_DESC{ TRUE, D3D12_DEPTH_WRITE_MASK_ALL, D3D12_COMPARISON_FUNC_LESS, FALSE,
+            D3D12_DEFAULT_STENCIL_READ_MASK, D3D12_DEFAULT_STENCIL_WRITE_MASK,
+            { D3D12_STENCIL_OP_KEEP, D3D12_STENCIL_OP_KEEP, D3D12_STENCIL_OP_KEEP, D3D12_COMPARISON_FUNC_ALWAYS },
+            { D3D12_STENCIL_OP_KEEP, D3D12_STENCIL_OP_KEEP, D3D12_STENCIL_OP_KEEP, D3D12_COMPARISON_FUNC_ALWAYS } }
+    {}
+    explicit constexpr CD3DX12_DEPTH_STENCIL_DESC(
         BOOL depthEnable,
         D3D12_DEPTH_WRITE_MASK depthWriteMask,
         D3D12_COMPARISON_FUNC depthFunc,
@@ -201,65 +171,32 @@ struct CD3DX12_DEPTH_STENCIL_DESC : public D3D12_DEPTH_STENCIL_DESC
         D3D12_STENCIL_OP backStencilFailOp,
         D3D12_STENCIL_OP backStencilDepthFailOp,
         D3D12_STENCIL_OP backStencilPassOp,
-        D3D12_COMPARISON_FUNC backStencilFunc )
-    {
-        DepthEnable = depthEnable;
-        DepthWriteMask = depthWriteMask;
-        DepthFunc = depthFunc;
-        StencilEnable = stencilEnable;
-        StencilReadMask = stencilReadMask;
-        StencilWriteMask = stencilWriteMask;
-        FrontFace.StencilFailOp = frontStencilFailOp;
-        FrontFace.StencilDepthFailOp = frontStencilDepthFailOp;
-        FrontFace.StencilPassOp = frontStencilPassOp;
-        FrontFace.StencilFunc = frontStencilFunc;
-        BackFace.StencilFailOp = backStencilFailOp;
-        BackFace.StencilDepthFailOp = backStencilDepthFailOp;
-        BackFace.StencilPassOp = backStencilPassOp;
-        BackFace.StencilFunc = backStencilFunc;
-    }
+        D3D12_COMPARISON_FUNC backStencilFunc ) :
+        D3D12_DEPTH_STENCIL_DESC{ depthEnable, depthWriteMask, depthFunc, stencilEnable, stencilReadMask, stencilWriteMask,
+            { frontStencilFailOp, frontStencilDepthFailOp, frontStencilPassOp, frontStencilFunc },
+            { backStencilFailOp, backStencilDepthFailOp, backStencilPassOp, backStencilFunc } }
+    {}
 };
 
 //------------------------------------------------------------------------------------------------
 struct CD3DX12_DEPTH_STENCIL_DESC1 : public D3D12_DEPTH_STENCIL_DESC1
 {
     CD3DX12_DEPTH_STENCIL_DESC1() = default;
-    explicit CD3DX12_DEPTH_STENCIL_DESC1( const D3D12_DEPTH_STENCIL_DESC1& o ) :
+    explicit constexpr CD3DX12_DEPTH_STENCIL_DESC1( const D3D12_DEPTH_STENCIL_DESC1& o ) :
         D3D12_DEPTH_STENCIL_DESC1( o )
     {}
-    explicit CD3DX12_DEPTH_STENCIL_DESC1( const D3D12_DEPTH_STENCIL_DESC& o )
-    {
-        DepthEnable                  = o.DepthEnable;
-        DepthWriteMask               = o.DepthWriteMask;
-        DepthFunc                    = o.DepthFunc;
-        StencilEnable                = o.StencilEnable;
-        StencilReadMask              = o.StencilReadMask;
-        StencilWriteMask             = o.StencilWriteMask;
-        FrontFace.StencilFailOp      = o.FrontFace.StencilFailOp;
-        FrontFace.StencilDepthFailOp = o.FrontFace.StencilDepthFailOp;
-        FrontFace.StencilPassOp      = o.FrontFace.StencilPassOp;
-        FrontFace.StencilFunc        = o.FrontFace.StencilFunc;
-        BackFace.StencilFailOp       = o.BackFace.StencilFailOp;
-        BackFace.StencilDepthFailOp  = o.BackFace.StencilDepthFailOp;
-        BackFace.StencilPassOp       = o.BackFace.StencilPassOp;
-        BackFace.StencilFunc         = o.BackFace.StencilFunc;
-        DepthBoundsTestEnable        = FALSE;
-    }
-    explicit CD3DX12_DEPTH_STENCIL_DESC1( CD3DX12_DEFAULT )
-    {
-        DepthEnable = TRUE;
-        DepthWriteMask = D3D12_DEPTH_WRITE_MASK_ALL;
-        DepthFunc = D3D12_COMPARISON_FUNC_LESS;
-        StencilEnable = FALSE;
-        StencilReadMask = D3D12_DEFAULT_STENCIL_READ_MASK;
-        StencilWriteMask = D3D12_DEFAULT_STENCIL_WRITE_MASK;
-        const D3D12_DEPTH_STENCILOP_DESC defaultStencilOp =
-        { D3D12_STENCIL_OP_KEEP, D3D12_STENCIL_OP_KEEP, D3D12_STENCIL_OP_KEEP, D3D12_COMPARISON_FUNC_ALWAYS };
-        FrontFace = defaultStencilOp;
-        BackFace = defaultStencilOp;
-        DepthBoundsTestEnable = FALSE;
-    }
-    explicit CD3DX12_DEPTH_STENCIL_DESC1(
+    explicit constexpr CD3DX12_DEPTH_STENCIL_DESC1( const D3D12_DEPTH_STENCIL_DESC& o ) :
+        D3D12_DEPTH_STENCIL_DESC1{ o.DepthEnable, o.DepthWriteMask, o.DepthFunc, o.StencilEnable,
+            o.StencilReadMask, o.StencilWriteMask, o.FrontFace, o.BackFace, FALSE }
+    {}
+    explicit constexpr CD3DX12_DEPTH_STENCIL_DESC1( CD3DX12_DEFAULT ) :
+        D3D12_DEPTH_STENCIL_DESC1{ TRUE, D3D12_DEPTH_WRITE_MASK_ALL, D3D12_COMPARISON_FUNC_LESS, FALSE,
+            D3D12_DEFAULT_STENCIL_READ_MASK, D3D12_DEFAULT_STENCIL_WRITE_MASK,
+            { D3D12_STENCIL_OP_KEEP, D3D12_STENCIL_OP_KEEP, D3D12_STENCIL_OP_KEEP, D3D12_COMPARISON_FUNC_ALWAYS },
+            { D3D12_STENCIL_OP_KEEP, D3D12_STENCIL_OP_KEEP, D3D12_STENCIL_OP_KEEP, D3D12_COMPARISON_FUNC_ALWAYS },
+            FALSE }
+    {}
+    explicit constexpr CD3DX12_DEPTH_STENCIL_DESC1(
         BOOL depthEnable,
         D3D12_DEPTH_WRITE_MASK depthWriteMask,
         D3D12_COMPARISON_FUNC depthFunc,
@@ -274,24 +211,12 @@ struct CD3DX12_DEPTH_STENCIL_DESC1 : public D3D12_DEPTH_STENCIL_DESC1
         D3D12_STENCIL_OP backStencilDepthFailOp,
         D3D12_STENCIL_OP backStencilPassOp,
         D3D12_COMPARISON_FUNC backStencilFunc,
-        BOOL depthBoundsTestEnable )
-    {
-        DepthEnable = depthEnable;
-        DepthWriteMask = depthWriteMask;
-        DepthFunc = depthFunc;
-        StencilEnable = stencilEnable;
-        StencilReadMask = stencilReadMask;
-        StencilWriteMask = stencilWriteMask;
-        FrontFace.StencilFailOp = frontStencilFailOp;
-        FrontFace.StencilDepthFailOp = frontStencilDepthFailOp;
-        FrontFace.StencilPassOp = frontStencilPassOp;
-        FrontFace.StencilFunc = frontStencilFunc;
-        BackFace.StencilFailOp = backStencilFailOp;
-        BackFace.StencilDepthFailOp = backStencilDepthFailOp;
-        BackFace.StencilPassOp = backStencilPassOp;
-        BackFace.StencilFunc = backStencilFunc;
-        DepthBoundsTestEnable = depthBoundsTestEnable;
-    }
+        BOOL depthBoundsTestEnable ) :
+        D3D12_DEPTH_STENCIL_DESC1{ depthEnable, depthWriteMask, depthFunc, stencilEnable, stencilReadMask, stencilWriteMask,
+            { frontStencilFailOp, frontStencilDepthFailOp, frontStencilPassOp, frontStencilFunc },
+            { backStencilFailOp, backStencilDepthFailOp, backStencilPassOp, backStencilFunc },
+            depthBoundsTestEnable }
+    {}
     operator D3D12_DEPTH_STENCIL_DESC() const
     {
         D3D12_DEPTH_STENCIL_DESC D;
@@ -317,23 +242,25 @@ struct CD3DX12_DEPTH_STENCIL_DESC1 : public D3D12_DEPTH_STENCIL_DESC1
 struct CD3DX12_BLEND_DESC : public D3D12_BLEND_DESC
 {
     CD3DX12_BLEND_DESC() = default;
-    explicit CD3DX12_BLEND_DESC( const D3D12_BLEND_DESC& o ) :
+    explicit constexpr CD3DX12_BLEND_DESC( const D3D12_BLEND_DESC& o ) :
         D3D12_BLEND_DESC( o )
     {}
-    explicit CD3DX12_BLEND_DESC( CD3DX12_DEFAULT )
+    explicit constexpr CD3DX12_BLEND_DESC( CD3DX12_DEFAULT ) :
+        D3D12_BLEND_DESC{ FALSE, FALSE, {
+            DefaultRenderTarget(), DefaultRenderTarget(), DefaultRenderTarget(), DefaultRenderTarget(),
+            DefaultRenderTarget(), DefaultRenderTarget(), DefaultRenderTarget(), DefaultRenderTarget() } }
     {
-        AlphaToCoverageEnable = FALSE;
-        IndependentBlendEnable = FALSE;
-        const D3D12_RENDER_TARGET_BLEND_DESC defaultRenderTargetBlendDesc =
-        {
+        static_assert(D3D12_SIMULTANEOUS_RENDER_TARGET_COUNT == 8, "Every render target needs a default");
+    }
+    static constexpr D3D12_RENDER_TARGET_BLEND_DESC DefaultRenderTarget()
+    {
+        return {
             FALSE,FALSE,
             D3D12_BLEND_ONE, D3D12_BLEND_ZERO, D3D12_BLEND_OP_ADD,
             D3D12_BLEND_ONE, D3D12_BLEND_ZERO, D3D12_BLEND_OP_ADD,
             D3D12_LOGIC_OP_NOOP,
             D3D12_COLOR_WRITE_ENABLE_ALL,
         };
-        for (UINT i = 0; i < D3D12_SIMULTANEOUS_RENDER_TARGET_COUNT; ++i)
-            RenderTarget[ i ] = defaultRenderTargetBlendDesc;
     }
 };
 
@@ -341,24 +268,15 @@ struct CD3DX12_BLEND_DESC : public D3D12_BLEND_DESC
 struct CD3DX12_RASTERIZER_DESC : public D3D12_RASTERIZER_DESC
 {
     CD3DX12_RASTERIZER_DESC() = default;
-    explicit CD3DX12_RASTERIZER_DESC( const D3D12_RASTERIZER_DESC& o ) :
+    explicit constexpr CD3DX12_RASTERIZER_DESC( const D3D12_RASTERIZER_DESC& o ) :
         D3D12_RASTERIZER_DESC( o )
     {}
-    explicit CD3DX12_RASTERIZER_DESC( CD3DX12_DEFAULT )
-    {
-        FillMode = D3D12_FILL_MODE_SOLID;
-        CullMode = D3D12_CULL_MODE_BACK;
-        FrontCounterClockwise = FALSE;
-        DepthBias = D3D12_DEFAULT_DEPTH_BIAS;
-        DepthBiasClamp = D3D12_DEFAULT_DEPTH_BIAS_CLAMP;
-        SlopeScaledDepthBias = D3D12_DEFAULT_SLOPE_SCALED_DEPTH_BIAS;
-        DepthClipEnable = TRUE;
-        MultisampleEnable = FALSE;
-        AntialiasedLineEnable = FALSE;
-        ForcedSampleCount = 0;
-        ConservativeRaster = D3D12_CONSERVATIVE_RASTERIZATION_MODE_OFF;
-    }
-    explicit CD3DX12_RASTERIZER_DESC(
+    explicit constexpr CD3DX12_RASTERIZER_DESC( CD3DX12_DEFAULT ) :
+        D3D12_RASTERIZER_DESC{ D3D12_FILL_MODE_SOLID, D3D12_CULL_MODE_BACK, FALSE,
+            D3D12_DEFAULT_DEPTH_BIAS, D3D12_DEFAULT_DEPTH_BIAS_CLAMP, D3D12_DEFAULT_SLOPE_SCALED_DEPTH_BIAS,
+            TRUE, FALSE, FALSE, 0, D3D12_CONSERVATIVE_RASTERIZATION_MODE_OFF }
+    {}
+    explicit constexpr CD3DX12_RASTERIZER_DESC(
         D3D12_FILL_MODE fillMode,
         D3D12_CULL_MODE cullMode,
         BOOL frontCounterClockwise,
@@ -369,69 +287,48 @@ struct CD3DX12_RASTERIZER_DESC : public D3D12_RASTERIZER_DESC
         BOOL multisampleEnable,
         BOOL antialiasedLineEnable, 
         UINT forcedSampleCount, 
-        D3D12_CONSERVATIVE_RASTERIZATION_MODE conservativeRaster)
-    {
-        FillMode = fillMode;
-        CullMode = cullMode;
-        FrontCounterClockwise = frontCounterClockwise;
-        DepthBias = depthBias;
-        DepthBiasClamp = depthBiasClamp;
-        SlopeScaledDepthBias = slopeScaledDepthBias;
-        DepthClipEnable = depthClipEnable;
-        MultisampleEnable = multisampleEnable;
-        AntialiasedLineEnable = antialiasedLineEnable;
-        ForcedSampleCount = forcedSampleCount;
-        ConservativeRaster = conservativeRaster;
-    }
+        D3D12_CONSERVATIVE_RASTERIZATION_MODE conservativeRaster) :
+        D3D12_RASTERIZER_DESC{ fillMode, cullMode, frontCounterClockwise, depthBias, depthBiasClamp,
+            slopeScaledDepthBias, depthClipEnable, multisampleEnable, antialiasedLineEnable,
+            forcedSampleCount, conservativeRaster }
+    {}
 };
 
 //------------------------------------------------------------------------------------------------
 struct CD3DX12_RESOURCE_ALLOCATION_INFO : public D3D12_RESOURCE_ALLOCATION_INFO
 {
     CD3DX12_RESOURCE_ALLOCATION_INFO() = default;
-    explicit CD3DX12_RESOURCE_ALLOCATION_INFO( const D3D12_RESOURCE_ALLOCATION_INFO& o ) :
+    explicit constexpr CD3DX12_RESOURCE_ALLOCATION_INFO( const D3D12_RESOURCE_ALLOCATION_INFO& o ) :
         D3D12_RESOURCE_ALLOCATION_INFO( o )
     {}
-    CD3DX12_RESOURCE_ALLOCATION_INFO(
+    constexpr CD3DX12_RESOURCE_ALLOCATION_INFO(
         UINT64 size,
-        UINT64 alignment )
-    {
-        SizeInBytes = size;
-        Alignment = alignment;
-    }
+        UINT64 alignment ) :
+        D3D12_RESOURCE_ALLOCATION_INFO{ size, alignment }
+    {}
 };
 
 //------------------------------------------------------------------------------------------------
 struct CD3DX12_HEAP_PROPERTIES : public D3D12_HEAP_PROPERTIES
 {
     CD3DX12_HEAP_PROPERTIES() = default;
-    explicit CD3DX12_HEAP_PROPERTIES(const D3D12_HEAP_PROPERTIES &o) :
+    explicit constexpr CD3DX12_HEAP_PROPERTIES(const D3D12_HEAP_PROPERTIES &o) :
         D3D12_HEAP_PROPERTIES(o)
     {}
-    CD3DX12_HEAP_PROPERTIES( 
+    constexpr CD3DX12_HEAP_PROPERTIES( 
         D3D12_CPU_PAGE_PROPERTY cpuPageProperty, 
         D3D12_MEMORY_POOL memoryPoolPreference,
         UINT creationNodeMask = 1, 
-        UINT nodeMask = 1 )
-    {
-        Type = D3D12_HEAP_TYPE_CUSTOM;
-        CPUPageProperty = cpuPageProperty;
-        MemoryPoolPreference = memoryPoolPreference;
-        CreationNodeMask = creationNodeMask;
-        VisibleNodeMask = nodeMask;
-    }
-    explicit CD3DX12_HEAP_PROPERTIES( 
+        UINT nodeMask = 1 ) :
+        D3D12_HEAP_PROPERTIES{ D3D12_HEAP_TYPE_CUSTOM, cpuPageProperty, memoryPoolPreference, creationNodeMask, nodeMask }
+    {}
+    explicit constexpr CD3DX12_HEAP_PROPERTIES( 
         D3D12_HEAP_TYPE type, 
         UINT creationNodeMask = 1, 
-        UINT nodeMask = 1 )
-    {
-        Type = type;
-        CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_UNKNOWN;
-        MemoryPoolPreference = D3D12_MEMORY_POOL_UNKNOWN;
-        CreationNodeMask = creationNodeMask;
-        VisibleNodeMask = nodeMask;
-    }
-    bool IsCPUAccessible() const
+        UINT nodeMask = 1 ) :
+        D3D12_HEAP_PROPERTIES{ type, D3D12_CPU_PAGE_PROPERTY_UNKNOWN, D3D12_MEMORY_POOL_UNKNOWN, creationNodeMask, nodeMask }
+    {}
+    constexpr bool IsCPUAccessible() const
     {
         return Type == D3D12_HEAP_TYPE_UPLOAD || Type == D3D12_HEAP_TYPE_READBACK || (Type == D3D12_HEAP_TYPE_CUSTOM &&
             (CPUPageProperty == D3D12_CPU_PAGE_PROPERTY_WRITE_COMBINE || CPUPageProperty == D3D12_CPU_PAGE_PROPERTY_WRITE_BACK));
@@ -451,7 +348,7 @@ inline bool operator!=( const D3D12_HEAP_PROPERTIES& l, const D3D12_HEAP_PROPERT
 struct CD3DX12_HEAP_DESC : public D3D12_HEAP_DESC
 {
     CD3DX12_HEAP_DESC() = default;
-    explicit CD3DX12_HEAP_DESC(const D3D12_HEAP_DESC &o) :
+    explicit constexpr CD3DX12_HEAP_DESC(const D3D12_HEAP_DESC &o) :
         D3D12_HEAP_DESC(o)
     {}
     CD3DX12_HEAP_DESC( 
@@ -536,7 +433,7 @@ inline bool operator!=( const D3D12_HEAP_DESC& l, const D3D12_HEAP_DESC& r )
 struct CD3DX12_CLEAR_VALUE : public D3D12_CLEAR_VALUE
 {
     CD3DX12_CLEAR_VALUE() = default;
-    explicit CD3DX12_CLEAR_VALUE(const D3D12_CLEAR_VALUE &o) :
+    explicit constexpr CD3DX12_CLEAR_VALUE(const D3D12_CLEAR_VALUE &o) :
         D3D12_CLEAR_VALUE(o)
     {}
     CD3DX12_CLEAR_VALUE( 
@@ -562,64 +459,55 @@ struct CD3DX12_CLEAR_VALUE : public D3D12_CLEAR_VALUE
 struct CD3DX12_RANGE : public D3D12_RANGE
 {
     CD3DX12_RANGE() = default;
-    explicit CD3DX12_RANGE(const D3D12_RANGE &o) :
+    explicit constexpr CD3DX12_RANGE(const D3D12_RANGE &o) :
         D3D12_RANGE(o)
     {}
-    CD3DX12_RANGE( 
+    constexpr CD3DX12_RANGE( 
         SIZE_T begin, 
-        SIZE_T end )
-    {
-        Begin = begin;
-        End = end;
-    }
+        SIZE_T end ) :
+        D3D12_RANGE{ begin, end }
+    {}
 };
 
 //------------------------------------------------------------------------------------------------
 struct CD3DX12_RANGE_UINT64 : public D3D12_RANGE_UINT64
 {
     CD3DX12_RANGE_UINT64() = default;
-    explicit CD3DX12_RANGE_UINT64(const D3D12_RANGE_UINT64 &o) :
+    explicit constexpr CD3DX12_RANGE_UINT64(const D3D12_RANGE_UINT64 &o) :
         D3D12_RANGE_UINT64(o)
     {}
-    CD3DX12_RANGE_UINT64( 
+    constexpr CD3DX12_RANGE_UINT64( 
         UINT64 begin, 
-        UINT64 end )
-    {
-        Begin = begin;
-        End = end;
-    }
+        UINT64 end ) :
+        D3D12_RANGE_UINT64{ begin, end }
+    {}
 };
 
 //------------------------------------------------------------------------------------------------
 struct CD3DX12_SUBRESOURCE_RANGE_UINT64 : public D3D12_SUBRESOURCE_RANGE_UINT64
 {
     CD3DX12_SUBRESOURCE_RANGE_UINT64() = default;
-    explicit CD3DX12_SUBRESOURCE_RANGE_UINT64(const D3D12_SUBRESOURCE_RANGE_UINT64 &o) :
+    explicit constexpr CD3DX12_SUBRESOURCE_RANGE_UINT64(const D3D12_SUBRESOURCE_RANGE_UINT64 &o) :
         D3D12_SUBRESOURCE_RANGE_UINT64(o)
     {}
-    CD3DX12_SUBRESOURCE_RANGE_UINT64( 
+    constexpr CD3DX12_SUBRESOURCE_RANGE_UINT64( 
         UINT subresource,
-        const D3D12_RANGE_UINT64& range )
-    {
-        Subresource = subresource;
-        Range = range;
-    }
-    CD3DX12_SUBRESOURCE_RANGE_UINT64( 
+        const D3D12_RANGE_UINT64& range ) :
+        D3D12_SUBRESOURCE_RANGE_UINT64{ subresource, range }
+    {}
+    constexpr CD3DX12_SUBRESOURCE_RANGE_UINT64( 
         UINT subresource,
         UINT64 begin, 
-        UINT64 end )
-    {
-        Subresource = subresource;
-        Range.Begin = begin;
-        Range.End = end;
-    }
+        UINT64 end ) :
+        D3D12_SUBRESOURCE_RANGE_UINT64{ subresource, { begin, end } }
+    {}
 };
 
 //------------------------------------------------------------------------------------------------
 struct CD3DX12_SHADER_BYTECODE : public D3D12_SHADER_BYTECODE
 {
     CD3DX12_SHADER_BYTECODE() = default;
-    explicit CD3DX12_SHADER_BYTECODE(const D3D12_SHADER_BYTECODE &o) :
+    explicit constexpr CD3DX12_SHADER_BYTECODE(const D3D12_SHADER_BYTECODE &o) :
         D3D12_SHADER_BYTECODE(o)
     {}
     CD3DX12_SHADER_BYTECODE(
@@ -628,20 +516,18 @@ struct CD3DX12_SHADER_BYTECODE : public D3D12_SHADER_BYTECODE
         pShaderBytecode = pShaderBlob->GetBufferPointer();
         BytecodeLength = pShaderBlob->GetBufferSize();
     }
-    CD3DX12_SHADER_BYTECODE(
+    constexpr CD3DX12_SHADER_BYTECODE(
         const void* _pShaderBytecode,
-        SIZE_T bytecodeLength )
-    {
-        pShaderBytecode = _pShaderBytecode;
-        BytecodeLength = bytecodeLength;
-    }
+        SIZE_T bytecodeLength ) :
+        D3D12_SHADER_BYTECODE{ _pShaderBytecode, bytecodeLength }
+    {}
 };
 
 //------------------------------------------------------------------------------------------------
 struct CD3DX12_TILED_RESOURCE_COORDINATE : public D3D12_TILED_RESOURCE_COORDINATE
 {
     CD3DX12_TILED_RESOURCE_COORDINATE() = default;
-    explicit CD3DX12_TILED_RESOURCE_COORDINATE(const D3D12_TILED_RESOURCE_COORDINATE &o) :
+    explicit constexpr CD3DX12_TILED_RESOURCE_COORDINATE(const D3D12_TILED_RESOURCE_COORDINATE &o) :
         D3D12_TILED_RESOURCE_COORDINATE(o)
     {}
     CD3DX12_TILED_RESOURCE_COORDINATE( 
@@ -661,7 +547,7 @@ struct CD3DX12_TILED_RESOURCE_COORDINATE : public D3D12_TILED_RESOURCE_COORDINAT
 struct CD3DX12_TILE_REGION_SIZE : public D3D12_TILE_REGION_SIZE
 {
     CD3DX12_TILE_REGION_SIZE() = default;
-    explicit CD3DX12_TILE_REGION_SIZE(const D3D12_TILE_REGION_SIZE &o) :
+    explicit constexpr CD3DX12_TILE_REGION_SIZE(const D3D12_TILE_REGION_SIZE &o) :
         D3D12_TILE_REGION_SIZE(o)
     {}
     CD3DX12_TILE_REGION_SIZE( 
@@ -683,7 +569,7 @@ struct CD3DX12_TILE_REGION_SIZE : public D3D12_TILE_REGION_SIZE
 struct CD3DX12_SUBRESOURCE_TILING : public D3D12_SUBRESOURCE_TILING
 {
     CD3DX12_SUBRESOURCE_TILING() = default;
-    explicit CD3DX12_SUBRESOURCE_TILING(const D3D12_SUBRESOURCE_TILING &o) :
+    explicit constexpr CD3DX12_SUBRESOURCE_TILING(const D3D12_SUBRESOURCE_TILING &o) :
         D3D12_SUBRESOURCE_TILING(o)
     {}
     CD3DX12_SUBRESOURCE_TILING( 
@@ -703,7 +589,7 @@ struct CD3DX12_SUBRESOURCE_TILING : public D3D12_SUBRESOURCE_TILING
 struct CD3DX12_TILE_SHAPE : public D3D12_TILE_SHAPE
 {
     CD3DX12_TILE_SHAPE() = default;
-    explicit CD3DX12_TILE_SHAPE(const D3D12_TILE_SHAPE &o) :
+    explicit constexpr CD3DX12_TILE_SHAPE(const D3D12_TILE_SHAPE &o) :
         D3D12_TILE_SHAPE(o)
     {}
     CD3DX12_TILE_SHAPE( 
@@ -721,7 +607,7 @@ struct CD3DX12_TILE_SHAPE : public D3D12_TILE_SHAPE
 struct CD3DX12_RESOURCE_BARRIER : public D3D12_RESOURCE_BARRIER
 {
     CD3DX12_RESOURCE_BARRIER() = default;
-    explicit CD3DX12_RESOURCE_BARRIER(const D3D12_RESOURCE_BARRIER &o) :
+    explicit constexpr CD3DX12_RESOURCE_BARRIER(const D3D12_RESOURCE_BARRIER &o) :
         D3D12_RESOURCE_BARRIER(o)
     {}
     static inline CD3DX12_RESOURCE_BARRIER Transition(
@@ -767,7 +653,7 @@ struct CD3DX12_RESOURCE_BARRIER : public D3D12_RESOURCE_BARRIER
 struct CD3DX12_PACKED_MIP_INFO : public D3D12_PACKED_MIP_INFO
 {
     CD3DX12_PACKED_MIP_INFO() = default;
-    explicit CD3DX12_PACKED_MIP_INFO(const D3D12_PACKED_MIP_INFO &o) :
+    explicit constexpr CD3DX12_PACKED_MIP_INFO(const D3D12_PACKED_MIP_INFO &o) :
         D3D12_PACKED_MIP_INFO(o)
     {}
     CD3DX12_PACKED_MIP_INFO( 
@@ -787,7 +673,7 @@ struct CD3DX12_PACKED_MIP_INFO : public D3D12_PACKED_MIP_INFO
 struct CD3DX12_SUBRESOURCE_FOOTPRINT : public D3D12_SUBRESOURCE_FOOTPRINT
 {
     CD3DX12_SUBRESOURCE_FOOTPRINT() = default;
-    explicit CD3DX12_SUBRESOURCE_FOOTPRINT(const D3D12_SUBRESOURCE_FOOTPRINT &o) :
+    explicit constexpr CD3DX12_SUBRESOURCE_FOOTPRINT(const D3D12_SUBRESOURCE_FOOTPRINT &o) :
         D3D12_SUBRESOURCE_FOOTPRINT(o)
     {}
     CD3DX12_SUBRESOURCE_FOOTPRINT( 
@@ -819,7 +705,7 @@ struct CD3DX12_SUBRESOURCE_FOOTPRINT : public D3D12_SUBRESOURCE_FOOTPRINT
 struct CD3DX12_TEXTURE_COPY_LOCATION : public D3D12_TEXTURE_COPY_LOCATION
 { 
     CD3DX12_TEXTURE_COPY_LOCATION() = default;
-    explicit CD3DX12_TEXTURE_COPY_LOCATION(const D3D12_TEXTURE_COPY_LOCATION &o) :
+    explicit constexpr CD3DX12_TEXTURE_COPY_LOCATION(const D3D12_TEXTURE_COPY_LOCATION &o) :
         D3D12_TEXTURE_COPY_LOCATION(o)
     {}
     CD3DX12_TEXTURE_COPY_LOCATION(_In_ ID3D12Resource* pRes)
@@ -846,19 +732,18 @@ struct CD3DX12_TEXTURE_COPY_LOCATION : public D3D12_TEXTURE_COPY_LOCATION
 struct CD3DX12_DESCRIPTOR_RANGE : public D3D12_DESCRIPTOR_RANGE
 {
     CD3DX12_DESCRIPTOR_RANGE() = default;
-    explicit CD3DX12_DESCRIPTOR_RANGE(const D3D12_DESCRIPTOR_RANGE &o) :
+    explicit constexpr CD3DX12_DESCRIPTOR_RANGE(const D3D12_DESCRIPTOR_RANGE &o) :
         D3D12_DESCRIPTOR_RANGE(o)
     {}
-    CD3DX12_DESCRIPTOR_RANGE(
+    constexpr CD3DX12_DESCRIPTOR_RANGE(
         D3D12_DESCRIPTOR_RANGE_TYPE rangeType,
         UINT numDescriptors,
         UINT baseShaderRegister,
         UINT registerSpace = 0,
         UINT offsetInDescriptorsFromTableStart =
-        D3D12_DESCRIPTOR_RANGE_OFFSET_APPEND)
-    {
-        Init(rangeType, numDescriptors, baseShaderRegister, registerSpace, offsetInDescriptorsFromTableStart);
-    }
+        D3D12_DESCRIPTOR_RANGE_OFFSET_APPEND) :
+        D3D12_DESCRIPTOR_RANGE{ rangeType, numDescriptors, baseShaderRegister, registerSpace, offsetInDescriptorsFromTableStart }
+    {}
     
     inline void Init(
         D3D12_DESCRIPTOR_RANGE_TYPE rangeType,
@@ -892,15 +777,14 @@ struct CD3DX12_DESCRIPTOR_RANGE : public D3D12_DESCRIPTOR_RANGE
 struct CD3DX12_ROOT_DESCRIPTOR_TABLE : public D3D12_ROOT_DESCRIPTOR_TABLE
 {
     CD3DX12_ROOT_DESCRIPTOR_TABLE() = default;
-    explicit CD3DX12_ROOT_DESCRIPTOR_TABLE(const D3D12_ROOT_DESCRIPTOR_TABLE &o) :
+    explicit constexpr CD3DX12_ROOT_DESCRIPTOR_TABLE(const D3D12_ROOT_DESCRIPTOR_TABLE &o) :
         D3D12_ROOT_DESCRIPTOR_TABLE(o)
     {}
-    CD3DX12_ROOT_DESCRIPTOR_TABLE(
+    constexpr CD3DX12_ROOT_DESCRIPTOR_TABLE(
         UINT numDescriptorRanges,
-        _In_reads_opt_(numDescriptorRanges) const D3D12_DESCRIPTOR_RANGE* _pDescriptorRanges)
-    {
-        Init(numDescriptorRanges, _pDescriptorRanges);
-    }
+        _In_reads_opt_(numDescriptorRanges) const D3D12_DESCRIPTOR_RANGE* _pDescriptorRanges) :
+        D3D12_ROOT_DESCRIPTOR_TABLE{ numDescriptorRanges, _pDescriptorRanges }
+    {}
     
     inline void Init(
         UINT numDescriptorRanges,
@@ -923,16 +807,15 @@ struct CD3DX12_ROOT_DESCRIPTOR_TABLE : public D3D12_ROOT_DESCRIPTOR_TABLE
 struct CD3DX12_ROOT_CONSTANTS : public D3D12_ROOT_CONSTANTS
 {
     CD3DX12_ROOT_CONSTANTS() = default;
-    explicit CD3DX12_ROOT_CONSTANTS(const D3D12_ROOT_CONSTANTS &o) :
+    explicit constexpr CD3DX12_ROOT_CONSTANTS(const D3D12_ROOT_CONSTANTS &o) :
         D3D12_ROOT_CONSTANTS(o)
     {}
-    CD3DX12_ROOT_CONSTANTS(
+    constexpr CD3DX12_ROOT_CONSTANTS(
         UINT num32BitValues,
         UINT shaderRegister,
-        UINT registerSpace = 0)
-    {
-        Init(num32BitValues, shaderRegister, registerSpace);
-    }
+        UINT registerSpace = 0) :
+        D3D12_ROOT_CONSTANTS{ shaderRegister, registerSpace, num32BitValues }
+    {}
     
     inline void Init(
         UINT num32BitValues,
@@ -958,15 +841,14 @@ struct CD3DX12_ROOT_CONSTANTS : public D3D12_ROOT_CONSTANTS
 struct CD3DX12_ROOT_DESCRIPTOR : public D3D12_ROOT_DESCRIPTOR
 {
     CD3DX12_ROOT_DESCRIPTOR() = default;
-    explicit CD3DX12_ROOT_DESCRIPTOR(const D3D12_ROOT_DESCRIPTOR &o) :
+    explicit constexpr CD3DX12_ROOT_DESCRIPTOR(const D3D12_ROOT_DESCRIPTOR &o) :
         D3D12_ROOT_DESCRIPTOR(o)
     {}
-    CD3DX12_ROOT_DESCRIPTOR(
+    constexpr CD3DX12_ROOT_DESCRIPTOR(
         UINT shaderRegister,
-        UINT registerSpace = 0)
-    {
-        Init(shaderRegister, registerSpace);
-    }
+        UINT registerSpace = 0) :
+        D3D12_ROOT_DESCRIPTOR{ shaderRegister, registerSpace }
+    {}
     
     inline void Init(
         UINT shaderRegister,
@@ -986,7 +868,7 @@ struct CD3DX12_ROOT_DESCRIPTOR : public D3D12_ROOT_DESCRIPTOR
 struct CD3DX12_ROOT_PARAMETER : public D3D12_ROOT_PARAMETER
 {
     CD3DX12_ROOT_PARAMETER() = default;
-    explicit CD3DX12_ROOT_PARAMETER(const D3D12_ROOT_PARAMETER &o) :
+    explicit constexpr CD3DX12_ROOT_PARAMETER(const D3D12_ROOT_PARAMETER &o) :
         D3D12_ROOT_PARAMETER(o)
     {}
     
@@ -1092,10 +974,10 @@ struct CD3DX12_ROOT_PARAMETER : public D3D12_ROOT_PARAMETER
 struct CD3DX12_STATIC_SAMPLER_DESC : public D3D12_STATIC_SAMPLER_DESC
 {
     CD3DX12_STATIC_SAMPLER_DESC() = default;
-    explicit CD3DX12_STATIC_SAMPLER_DESC(const D3D12_STATIC_SAMPLER_DESC &o) :
+    explicit constexpr CD3DX12_STATIC_SAMPLER_DESC(const D3D12_STATIC_SAMPLER_DESC &o) :
         D3D12_STATIC_SAMPLER_DESC(o)
     {}
-    CD3DX12_STATIC_SAMPLER_DESC(
+    constexpr CD3DX12_STATIC_SAMPLER_DESC(
          UINT shaderRegister,
          D3D12_FILTER filter = D3D12_FILTER_ANISOTROPIC,
          D3D12_TEXTURE_ADDRESS_MODE addressU = D3D12_TEXTURE_ADDRESS_MODE_WRAP,
@@ -1108,23 +990,10 @@ struct CD3DX12_STATIC_SAMPLER_DESC : public D3D12_STATIC_SAMPLER_DESC
          FLOAT minLOD = 0.f,
          FLOAT maxLOD = D3D12_FLOAT32_MAX,
          D3D12_SHADER_VISIBILITY shaderVisibility = D3D12_SHADER_VISIBILITY_ALL, 
-         UINT registerSpace = 0)
-    {
-        Init(
-            shaderRegister,
-            filter,
-            addressU,
-            addressV,
-            addressW,
-            mipLODBias,
-            maxAnisotropy,
-            comparisonFunc,
-            borderColor,
-            minLOD,
-            maxLOD,
-            shaderVisibility,
-            registerSpace);
-    }
+         UINT registerSpace = 0) :
+        D3D12_STATIC_SAMPLER_DESC{ filter, addressU, addressV, addressW, mipLODBias, maxAnisotropy,
+            comparisonFunc, borderColor, minLOD, maxLOD, shaderRegister, registerSpace, shaderVisibility }
+    {}
     
     static inline void Init(
         _Out_ D3D12_STATIC_SAMPLER_DESC &samplerDesc,
@@ -1194,22 +1063,20 @@ struct CD3DX12_STATIC_SAMPLER_DESC : public D3D12_STATIC_SAMPLER_DESC
 struct CD3DX12_ROOT_SIGNATURE_DESC : public D3D12_ROOT_SIGNATURE_DESC
 {
     CD3DX12_ROOT_SIGNATURE_DESC() = default;
-    explicit CD3DX12_ROOT_SIGNATURE_DESC(const D3D12_ROOT_SIGNATURE_DESC &o) :
+    explicit constexpr CD3DX12_ROOT_SIGNATURE_DESC(const D3D12_ROOT_SIGNATURE_DESC &o) :
         D3D12_ROOT_SIGNATURE_DESC(o)
     {}
-    CD3DX12_ROOT_SIGNATURE_DESC(
+    constexpr CD3DX12_ROOT_SIGNATURE_DESC(
         UINT numParameters,
         _In_reads_opt_(numParameters) const D3D12_ROOT_PARAMETER* _pParameters,
         UINT numStaticSamplers = 0,
         _In_reads_opt_(numStaticSamplers) const D3D12_STATIC_SAMPLER_DESC* _pStaticSamplers = nullptr,
-        D3D12_ROOT_SIGNATURE_FLAGS flags = D3D12_ROOT_SIGNATURE_FLAG_NONE)
-    {
-        Init(numParameters, _pParameters, numStaticSamplers, _pStaticSamplers, flags);
-    }
-    CD3DX12_ROOT_SIGNATURE_DESC(CD3DX12_DEFAULT)
-    {
-        Init(0, nullptr, 0, nullptr, D3D12_ROOT_SIGNATURE_FLAG_NONE);
-    }
+        D3D12_ROOT_SIGNATURE_FLAGS flags = D3D12_ROOT_SIGNATURE_FLAG_NONE) :
+        D3D12_ROOT_SIGNATURE_DESC{ numParameters, _pParameters, numStaticSamplers, _pStaticSamplers, flags }
+    {}
+    constexpr CD3DX12_ROOT_SIGNATURE_DESC(CD3DX12_DEFAULT) :
+        D3D12_ROOT_SIGNATURE_DESC{ 0, nullptr, 0, nullptr, D3D12_ROOT_SIGNATURE_FLAG_NONE }
+    {}
     
     inline void Init(
         UINT numParameters,
@@ -1241,20 +1108,19 @@ struct CD3DX12_ROOT_SIGNATURE_DESC : public D3D12_ROOT_SIGNATURE_DESC
 struct CD3DX12_DESCRIPTOR_RANGE1 : public D3D12_DESCRIPTOR_RANGE1
 {
     CD3DX12_DESCRIPTOR_RANGE1() = default;
-    explicit CD3DX12_DESCRIPTOR_RANGE1(const D3D12_DESCRIPTOR_RANGE1 &o) :
+    explicit constexpr CD3DX12_DESCRIPTOR_RANGE1(const D3D12_DESCRIPTOR_RANGE1 &o) :
         D3D12_DESCRIPTOR_RANGE1(o)
     {}
-    CD3DX12_DESCRIPTOR_RANGE1(
+    constexpr CD3DX12_DESCRIPTOR_RANGE1(
         D3D12_DESCRIPTOR_RANGE_TYPE rangeType,
         UINT numDescriptors,
         UINT baseShaderRegister,
         UINT registerSpace = 0,
         D3D12_DESCRIPTOR_RANGE_FLAGS flags = D3D12_DESCRIPTOR_RANGE_FLAG_NONE,
         UINT offsetInDescriptorsFromTableStart =
-        D3D12_DESCRIPTOR_RANGE_OFFSET_APPEND)
-    {
-        Init(rangeType, numDescriptors, baseShaderRegister, registerSpace, flags, offsetInDescriptorsFromTableStart);
-    }
+        D3D12_DESCRIPTOR_RANGE_OFFSET_APPEND) :
+        D3D12_DESCRIPTOR_RANGE1{ rangeType, numDescriptors, baseShaderRegister, registerSpace, flags, offsetInDescriptorsFromTableStart }
+    {}
     
     inline void Init(
         D3D12_DESCRIPTOR_RANGE_TYPE rangeType,
@@ -1291,15 +1157,14 @@ struct CD3DX12_DESCRIPTOR_RANGE1 : public D3D12_DESCRIPTOR_RANGE1
 struct CD3DX12_ROOT_DESCRIPTOR_TABLE1 : public D3D12_ROOT_DESCRIPTOR_TABLE1
 {
     CD3DX12_ROOT_DESCRIPTOR_TABLE1() = default;
-    explicit CD3DX12_ROOT_DESCRIPTOR_TABLE1(const D3D12_ROOT_DESCRIPTOR_TABLE1 &o) :
+    explicit constexpr CD3DX12_ROOT_DESCRIPTOR_TABLE1(const D3D12_ROOT_DESCRIPTOR_TABLE1 &o) :
         D3D12_ROOT_DESCRIPTOR_TABLE1(o)
     {}
-    CD3DX12_ROOT_DESCRIPTOR_TABLE1(
+    constexpr CD3DX12_ROOT_DESCRIPTOR_TABLE1(
         UINT numDescriptorRanges,
-        _In_reads_opt_(numDescriptorRanges) const D3D12_DESCRIPTOR_RANGE1* _pDescriptorRanges)
-    {
-        Init(numDescriptorRanges, _pDescriptorRanges);
-    }
+        _In_reads_opt_(numDescriptorRanges) const D3D12_DESCRIPTOR_RANGE1* _pDescriptorRanges) :
+        D3D12_ROOT_DESCRIPTOR_TABLE1{ numDescriptorRanges, _pDescriptorRanges }
+    {}
     
     inline void Init(
         UINT numDescriptorRanges,
@@ -1322,16 +1187,15 @@ struct CD3DX12_ROOT_DESCRIPTOR_TABLE1 : public D3D12_ROOT_DESCRIPTOR_TABLE1
 struct CD3DX12_ROOT_DESCRIPTOR1 : public D3D12_ROOT_DESCRIPTOR1
 {
     CD3DX12_ROOT_DESCRIPTOR1() = default;
-    explicit CD3DX12_ROOT_DESCRIPTOR1(const D3D12_ROOT_DESCRIPTOR1 &o) :
+    explicit constexpr CD3DX12_ROOT_DESCRIPTOR1(const D3D12_ROOT_DESCRIPTOR1 &o) :
         D3D12_ROOT_DESCRIPTOR1(o)
     {}
-    CD3DX12_ROOT_DESCRIPTOR1(
+    constexpr CD3DX12_ROOT_DESCRIPTOR1(
         UINT shaderRegister,
         UINT registerSpace = 0,
-        D3D12_ROOT_DESCRIPTOR_FLAGS flags = D3D12_ROOT_DESCRIPTOR_FLAG_NONE)
-    {
-        Init(shaderRegister, registerSpace, flags);
-    }
+        D3D12_ROOT_DESCRIPTOR_FLAGS flags = D3D12_ROOT_DESCRIPTOR_FLAG_NONE) :
+        D3D12_ROOT_DESCRIPTOR1{ shaderRegister, registerSpace, flags }
+    {}
     
     inline void Init(
         UINT shaderRegister,
@@ -1357,7 +1221,7 @@ struct CD3DX12_ROOT_DESCRIPTOR1 : public D3D12_ROOT_DESCRIPTOR1
 struct CD3DX12_ROOT_PARAMETER1 : public D3D12_ROOT_PARAMETER1
 {
     CD3DX12_ROOT_PARAMETER1() = default;
-    explicit CD3DX12_ROOT_PARAMETER1(const D3D12_ROOT_PARAMETER1 &o) :
+    explicit constexpr CD3DX12_ROOT_PARAMETER1(const D3D12_ROOT_PARAMETER1 &o) :
         D3D12_ROOT_PARAMETER1(o)
     {}
     
@@ -1469,7 +1333,7 @@ struct CD3DX12_ROOT_PARAMETER1 : public D3D12_ROOT_PARAMETER1
 struct CD3DX12_VERSIONED_ROOT_SIGNATURE_DESC : public D3D12_VERSIONED_ROOT_SIGNATURE_DESC
 {
     CD3DX12_VERSIONED_ROOT_SIGNATURE_DESC() = default;
-    explicit CD3DX12_VERSIONED_ROOT_SIGNATURE_DESC(const D3D12_VERSIONED_ROOT_SIGNATURE_DESC &o) :
+    explicit constexpr CD3DX12_VERSIONED_ROOT_SIGNATURE_DESC(const D3D12_VERSIONED_ROOT_SIGNATURE_DESC &o) :
         D3D12_VERSIONED_ROOT_SIGNATURE_DESC(o)
     {}
     explicit CD3DX12_VERSIONED_ROOT_SIGNATURE_DESC(const D3D12_ROOT_SIGNATURE_DESC &o)
@@ -1562,7 +1426,7 @@ struct CD3DX12_VERSIONED_ROOT_SIGNATURE_DESC : public D3D12_VERSIONED_ROOT_SIGNA
 struct CD3DX12_CPU_DESCRIPTOR_HANDLE : public D3D12_CPU_DESCRIPTOR_HANDLE
 {
     CD3DX12_CPU_DESCRIPTOR_HANDLE() = default;
-    explicit CD3DX12_CPU_DESCRIPTOR_HANDLE(const D3D12_CPU_DESCRIPTOR_HANDLE &o) :
+    explicit constexpr CD3DX12_CPU_DESCRIPTOR_HANDLE(const D3D12_CPU_DESCRIPTOR_HANDLE &o) :
         D3D12_CPU_DESCRIPTOR_HANDLE(o)
     {}
     CD3DX12_CPU_DESCRIPTOR_HANDLE(CD3DX12_DEFAULT) { ptr = 0; }
@@ -1623,7 +1487,7 @@ struct CD3DX12_CPU_DESCRIPTOR_HANDLE : public D3D12_CPU_DESCRIPTOR_HANDLE
 struct CD3DX12_GPU_DESCRIPTOR_HANDLE : public D3D12_GPU_DESCRIPTOR_HANDLE
 {
     CD3DX12_GPU_DESCRIPTOR_HANDLE() = default;
-    explicit CD3DX12_GPU_DESCRIPTOR_HANDLE(const D3D12_GPU_DESCRIPTOR_HANDLE &o) :
+    explicit constexpr CD3DX12_GPU_DESCRIPTOR_HANDLE(const D3D12_GPU_DESCRIPTOR_HANDLE &o) :
         D3D12_GPU_DESCRIPTOR_HANDLE(o)
     {}
     CD3DX12_GPU_DESCRIPTOR_HANDLE(CD3DX12_DEFAULT) { ptr = 0; }
@@ -1713,10 +1577,10 @@ inline UINT8 D3D12GetFormatPlaneCount(
 struct CD3DX12_RESOURCE_DESC : public D3D12_RESOURCE_DESC
 {
     CD3DX12_RESOURCE_DESC() = default;
-    explicit CD3DX12_RESOURCE_DESC( const D3D12_RESOURCE_DESC& o ) :
+    explicit constexpr CD3DX12_RESOURCE_DESC( const D3D12_RESOURCE_DESC& o ) :
         D3D12_RESOURCE_DESC( o )
     {}
-    CD3DX12_RESOURCE_DESC( 
+    constexpr CD3DX12_RESOURCE_DESC( 
         D3D12_RESOURCE_DIMENSION dimension,
         UINT64 alignment,
         UINT64 width,
@@ -1727,28 +1591,18 @@ struct CD3DX12_RESOURCE_DESC : public D3D12_RESOURCE_DESC
         UINT sampleCount,
         UINT sampleQuality,
         D3D12_TEXTURE_LAYOUT layout,
-        D3D12_RESOURCE_FLAGS flags )
-    {
-        Dimension = dimension;
-        Alignment = alignment;
-        Width = width;
-        Height = height;
-        DepthOrArraySize = depthOrArraySize;
-        MipLevels = mipLevels;
-        Format = format;
-        SampleDesc.Count = sampleCount;
-        SampleDesc.Quality = sampleQuality;
-        Layout = layout;
-        Flags = flags;
-    }
-    static inline CD3DX12_RESOURCE_DESC Buffer( 
+        D3D12_RESOURCE_FLAGS flags ) :
+        D3D12_RESOURCE_DESC{ dimension, alignment, width, height, depthOrArraySize, mipLevels, format,
+            { sampleCount, sampleQuality }, layout, flags }
+    {}
+    static constexpr CD3DX12_RESOURCE_DESC Buffer( 
         const D3D12_RESOURCE_ALLOCATION_INFO& resAllocInfo,
         D3D12_RESOURCE_FLAGS flags = D3D12_RESOURCE_FLAG_NONE )
     {
         return CD3DX12_RESOURCE_DESC( D3D12_RESOURCE_DIMENSION_BUFFER, resAllocInfo.Alignment, resAllocInfo.SizeInBytes, 
             1, 1, 1, DXGI_FORMAT_UNKNOWN, 1, 0, D3D12_TEXTURE_LAYOUT_ROW_MAJOR, flags );
     }
-    static inline CD3DX12_RESOURCE_DESC Buffer( 
+    static constexpr CD3DX12_RESOURCE_DESC Buffer( 
         UINT64 width,
         D3D12_RESOURCE_FLAGS flags = D3D12_RESOURCE_FLAG_NONE,
         UINT64 alignment = 0 )
@@ -1756,7 +1610,7 @@ struct CD3DX12_RESOURCE_DESC : public D3D12_RESOURCE_DESC
         return CD3DX12_RESOURCE_DESC( D3D12_RESOURCE_DIMENSION_BUFFER, alignment, width, 1, 1, 1, 
             DXGI_FORMAT_UNKNOWN, 1, 0, D3D12_TEXTURE_LAYOUT_ROW_MAJOR, flags );
     }
-    static inline CD3DX12_RESOURCE_DESC Tex1D( 
+    static constexpr CD3DX12_RESOURCE_DESC Tex1D( 
         DXGI_FORMAT format,
         UINT64 width,
         UINT16 arraySize = 1,
@@ -1768,7 +1622,7 @@ struct CD3DX12_RESOURCE_DESC : public D3D12_RESOURCE_DESC
         return CD3DX12_RESOURCE_DESC( D3D12_RESOURCE_DIMENSION_TEXTURE1D, alignment, width, 1, arraySize, 
             mipLevels, format, 1, 0, layout, flags );
     }
-    static inline CD3DX12_RESOURCE_DESC Tex2D( 
+    static constexpr CD3DX12_RESOURCE_DESC Tex2D( 
         DXGI_FORMAT format,
         UINT64 width,
         UINT height,
@@ -1783,7 +1637,7 @@ struct CD3DX12_RESOURCE_DESC : public D3D12_RESOURCE_DESC
         return CD3DX12_RESOURCE_DESC( D3D12_RESOURCE_DIMENSION_TEXTURE2D, alignment, width, height, arraySize, 
             mipLevels, format, sampleCount, sampleQuality, layout, flags );
     }
-    static inline CD3DX12_RESOURCE_DESC Tex3D( 
+    static constexpr CD3DX12_RESOURCE_DESC Tex3D( 
         DXGI_FORMAT format,
         UINT64 width,
         UINT height,
@@ -1828,7 +1682,7 @@ inline bool operator!=( const D3D12_RESOURCE_DESC& l, const D3D12_RESOURCE_DESC&
 struct CD3DX12_VIEW_INSTANCING_DESC : public D3D12_VIEW_INSTANCING_DESC
 {
     CD3DX12_VIEW_INSTANCING_DESC() = default;
-    explicit CD3DX12_VIEW_INSTANCING_DESC( const D3D12_VIEW_INSTANCING_DESC& o ) :
+    explicit constexpr CD3DX12_VIEW_INSTANCING_DESC( const D3D12_VIEW_INSTANCING_DESC& o ) :
         D3D12_VIEW_INSTANCING_DESC( o )
     {}
     explicit CD3DX12_VIEW_INSTANCING_DESC( CD3DX12_DEFAULT )
@@ -2009,6 +1863,206 @@ inline UINT64 UpdateSubresources(
     return UpdateSubresources(pCmdList, pDestinationResource, pIntermediate, FirstSubresource, NumSubresources, RequiredSize, Layouts, NumRows, RowSizesInBytes, pSrcData);
 }
 
+//------------------------------------------------------------------------------------------------
+// Copies a row with non-temporal stores when the destination allows it.  Upload heaps are
+// write-combined, so this avoids pulling the destination into the cache.  Call _mm_sfence
+// (or any other fence) before the data is consumed.
+inline void MemcpyRowStreaming(
+    _Out_writes_bytes_(SizeInBytes) void* pDest,
+    _In_reads_bytes_(SizeInBytes) const void* pSrc,
+    SIZE_T SizeInBytes)
+{
+#if defined(_M_IX86) || defined(_M_X64)
+    if ((reinterpret_cast<UINT_PTR>(pDest) & 15) == 0)
+    {
+        __m128i* pDest128 = reinterpret_cast<__m128i*>(pDest);
+        const BYTE* pSrcBytes = reinterpret_cast<const BYTE*>(pSrc);
+        const SIZE_T NumVectors = SizeInBytes / 16;
+        for (SIZE_T i = 0; i < NumVectors; ++i)
+        {
+            _mm_stream_si128(pDest128 + i, _mm_loadu_si128(reinterpret_cast<const __m128i*>(pSrcBytes + i * 16)));
+        }
+        memcpy(pDest128 + NumVectors, pSrcBytes + NumVectors * 16, SizeInBytes - NumVectors * 16);
+        return;
+    }
+#endif
+    memcpy(pDest, pSrc, SizeInBytes);
+}
+
+//------------------------------------------------------------------------------------------------
+// Runs pfnTask for every TaskIndex in [0, NumTasks), possibly on several threads at once, and
+// returns once all of them have finished.  Tasks are independent and may run in any order.
+typedef void (*PFN_D3DX12_PARALLEL_FOR)(
+    UINT NumTasks,
+    _In_ void (*pfnTask)(UINT TaskIndex, void* pContext),
+    _In_ void* pContext,
+    _In_opt_ void* pUserData);
+
+// Subresources are split into tasks of about this many bytes so that a large top mip is spread
+// across threads too
+#define D3DX12_UPDATE_SUBRESOURCES_TASK_SIZE (256 * 1024)
+
+//------------------------------------------------------------------------------------------------
+// Bytes of scratch memory the arena-backed UpdateSubresources needs for NumSubresources
+inline SIZE_T GetUpdateSubresourcesScratchSize(UINT NumSubresources)
+{
+    return (sizeof(D3D12_PLACED_SUBRESOURCE_FOOTPRINT) + sizeof(UINT64) + 2 * sizeof(UINT)) * SIZE_T(NumSubresources) +
+        sizeof(UINT) * (SIZE_T(NumSubresources) + 1);
+}
+
+struct D3DX12_UPDATE_SUBRESOURCES_TASKS
+{
+    BYTE* pData;
+    const D3D12_PLACED_SUBRESOURCE_FOOTPRINT* pLayouts;
+    const UINT64* pRowSizesInBytes;
+    const UINT* pNumRows;
+    const UINT* pRowsPerTask;
+    const UINT* pFirstTask;
+    const D3D12_SUBRESOURCE_DATA* pSrcData;
+    UINT NumSubresources;
+};
+
+//------------------------------------------------------------------------------------------------
+// Copies one task's worth of rows.  Rows of every slice are numbered consecutively.
+inline void UpdateSubresourcesTask(UINT TaskIndex, void* pContext)
+{
+    auto pTasks = reinterpret_cast<const D3DX12_UPDATE_SUBRESOURCES_TASKS*>(pContext);
+
+    // Find the last subresource whose first task is not after this one
+    UINT First = 0;
+    UINT Last = pTasks->NumSubresources;
+    while (Last - First > 1)
+    {
+        UINT Middle = (First + Last) / 2;
+        if (pTasks->pFirstTask[Middle] <= TaskIndex)
+            First = Middle;
+        else
+            Last = Middle;
+    }
+
+    const UINT i = First;
+    const D3D12_PLACED_SUBRESOURCE_FOOTPRINT& Layout = pTasks->pLayouts[i];
+    const D3D12_SUBRESOURCE_DATA& Src = pTasks->pSrcData[i];
+    const UINT NumRows = pTasks->pNumRows[i];
+    const UINT TotalRows = NumRows * Layout.Footprint.Depth;
+    const UINT FirstRow = (TaskIndex - pTasks->pFirstTask[i]) * pTasks->pRowsPerTask[i];
+    const UINT EndRow = (TotalRows - FirstRow < pTasks->pRowsPerTask[i]) ? TotalRows : FirstRow + pTasks->pRowsPerTask[i];
+
+    BYTE* pDestSubresource = pTasks->pData + Layout.Offset;
+    const SIZE_T DestSlicePitch = SIZE_T(Layout.Footprint.RowPitch) * SIZE_T(NumRows);
+    for (UINT Row = FirstRow; Row < EndRow; ++Row)
+    {
+        const UINT z = Row / NumRows;
+        const UINT y = Row % NumRows;
+        MemcpyRowStreaming(
+            pDestSubresource + DestSlicePitch * z + SIZE_T(Layout.Footprint.RowPitch) * y,
+            reinterpret_cast<const BYTE*>(Src.pData) + Src.SlicePitch * z + Src.RowPitch * y,
+            static_cast<SIZE_T>(pTasks->pRowSizesInBytes[i]));
+    }
+
+#if defined(_M_IX86) || defined(_M_X64)
+    _mm_sfence();
+#endif
+}
+
+//------------------------------------------------------------------------------------------------
+// Arena-backed UpdateSubresources implementation.  The layout arrays are carved out of pScratch,
+// which must hold GetUpdateSubresourcesScratchSize(NumSubresources) bytes and be 8-byte aligned,
+// so nothing is allocated.  When pfnParallelFor is provided, the rows are copied through it;
+// otherwise they are copied on this thread.
+inline UINT64 UpdateSubresources(
+    _In_ ID3D12GraphicsCommandList* pCmdList,
+    _In_ ID3D12Resource* pDestinationResource,
+    _In_ ID3D12Resource* pIntermediate,
+    UINT64 IntermediateOffset,
+    _In_range_(0,D3D12_REQ_SUBRESOURCES) UINT FirstSubresource,
+    _In_range_(1,D3D12_REQ_SUBRESOURCES-FirstSubresource) UINT NumSubresources,
+    _In_reads_(NumSubresources) const D3D12_SUBRESOURCE_DATA* pSrcData,
+    _Out_writes_bytes_(ScratchSize) void* pScratch,
+    SIZE_T ScratchSize,
+    _In_opt_ PFN_D3DX12_PARALLEL_FOR pfnParallelFor = nullptr,
+    _In_opt_ void* pParallelForUserData = nullptr)
+{
+    if (NumSubresources == 0 || ScratchSize < GetUpdateSubresourcesScratchSize(NumSubresources) ||
+        (reinterpret_cast<UINT_PTR>(pScratch) & 7) != 0)
+    {
+        return 0;
+    }
+
+    auto pLayouts = reinterpret_cast<D3D12_PLACED_SUBRESOURCE_FOOTPRINT*>(pScratch);
+    UINT64* pRowSizesInBytes = reinterpret_cast<UINT64*>(pLayouts + NumSubresources);
+    UINT* pNumRows = reinterpret_cast<UINT*>(pRowSizesInBytes + NumSubresources);
+    UINT* pRowsPerTask = pNumRows + NumSubresources;
+    UINT* pFirstTask = pRowsPerTask + NumSubresources;
+
+    UINT64 RequiredSize = 0;
+    auto Desc = pDestinationResource->GetDesc();
+    ID3D12Device* pDevice = nullptr;
+    pDestinationResource->GetDevice(__uuidof(*pDevice), reinterpret_cast<void**>(&pDevice));
+    pDevice->GetCopyableFootprints(&Desc, FirstSubresource, NumSubresources, IntermediateOffset, pLayouts, pNumRows, pRowSizesInBytes, &RequiredSize);
+    pDevice->Release();
+
+    // Minor validation
+    auto IntermediateDesc = pIntermediate->GetDesc();
+    if (IntermediateDesc.Dimension != D3D12_RESOURCE_DIMENSION_BUFFER || 
+        IntermediateDesc.Width < RequiredSize + pLayouts[0].Offset || 
+        RequiredSize > SIZE_T(-1) || 
+        (Desc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER && 
+            (FirstSubresource != 0 || NumSubresources != 1)))
+    {
+        return 0;
+    }
+
+    UINT NumTasks = 0;
+    for (UINT i = 0; i < NumSubresources; ++i)
+    {
+        if (pRowSizesInBytes[i] > SIZE_T(-1)) return 0;
+        const UINT64 RowsPerTask = D3DX12_UPDATE_SUBRESOURCES_TASK_SIZE / (pRowSizesInBytes[i] > 0 ? pRowSizesInBytes[i] : 1);
+        const UINT TotalRows = pNumRows[i] * pLayouts[i].Footprint.Depth;
+        pRowsPerTask[i] = RowsPerTask > 0 ? static_cast<UINT>(RowsPerTask < TotalRows ? RowsPerTask : TotalRows) : 1;
+        pFirstTask[i] = NumTasks;
+        NumTasks += pRowsPerTask[i] > 0 ? (TotalRows + pRowsPerTask[i] - 1) / pRowsPerTask[i] : 0;
+    }
+    pFirstTask[NumSubresources] = NumTasks;
+
+    BYTE* pData;
+    HRESULT hr = pIntermediate->Map(0, nullptr, reinterpret_cast<void**>(&pData));
+    if (FAILED(hr))
+    {
+        return 0;
+    }
+
+    D3DX12_UPDATE_SUBRESOURCES_TASKS Tasks = { pData, pLayouts, pRowSizesInBytes, pNumRows, pRowsPerTask, pFirstTask, pSrcData, NumSubresources };
+    if (pfnParallelFor != nullptr && NumTasks > 1)
+    {
+        pfnParallelFor(NumTasks, UpdateSubresourcesTask, &Tasks, pParallelForUserData);
+    }
+    else
+    {
+        for (UINT Task = 0; Task < NumTasks; ++Task)
+        {
+            UpdateSubresourcesTask(Task, &Tasks);
+        }
+    }
+    pIntermediate->Unmap(0, nullptr);
+
+    if (Desc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER)
+    {
+        pCmdList->CopyBufferRegion(
+            pDestinationResource, 0, pIntermediate, pLayouts[0].Offset, pLayouts[0].Footprint.Width);
+    }
+    else
+    {
+        for (UINT i = 0; i < NumSubresources; ++i)
+        {
+            CD3DX12_TEXTURE_COPY_LOCATION Dst(pDestinationResource, i + FirstSubresource);
+            CD3DX12_TEXTURE_COPY_LOCATION Src(pIntermediate, pLayouts[i]);
+            pCmdList->CopyTextureRegion(&Dst, 0, 0, 0, &Src, nullptr);
+        }
+    }
+    return RequiredSize;
+}
+
 //------------------------------------------------------------------------------------------------
 inline bool D3D12IsLayoutOpaque( D3D12_TEXTURE_LAYOUT Layout )
 { return Layout == D3D12_TEXTURE_LAYOUT_UNKNOWN || Layout == D3D12_TEXTURE_LAYOUT_64KB_UNDEFINED_SWIZZLE; }
@@ -78,6 +78,71 @@ void STDMETHODCALLTYPE CD3DX12AffinityCommandQueue::CopyTileMappings(
     }
 }
 
+bool CD3DX12AffinityCommandQueue::PrepareReplication(
+    UINT NumCommandLists,
+    CD3DX12AffinityCommandList* const* ppCommandLists,
+    UINT EffectiveAffinityMask,
+    D3DX12_AFFINITY_REPLICATION_BATCH& Batch,
+    UINT& NumPrepared)
+{
+    NumPrepared = NumCommandLists;
+
+    bool HasAccesses = false;
+    for (UINT c = 0; c < NumCommandLists && !HasAccesses; ++c)
+    {
+        HasAccesses = !static_cast<CD3DX12AffinityGraphicsCommandList*>(ppCommandLists[c])->GetReplicationAccesses().empty();
+    }
+
+    if (!HasAccesses)
+    {
+        return false;
+    }
+
+    for (UINT i = 0; i < D3DX12_MAX_ACTIVE_NODES;i++)
+    {
+        if (mCommandQueues[i] && !mReplicationFences[i])
+        {
+            GetParentDevice()->GetChildObject(0)->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&mReplicationFences[i]));
+        }
+
+        Batch.pNodeFences[i] = mReplicationFences[i];
+        Batch.NodeFenceValues[i] = mReplicationFenceValues[i] + 1;
+    }
+    GetParentDevice()->PrepareReplicationBatch(Batch);
+    Batch.TouchedNodeMask = 0;
+
+    // Walk the accesses in submission order, so that each one sees the state left by the last.
+    for (UINT c = 0; c < NumCommandLists; ++c)
+    {
+        CD3DX12AffinityGraphicsCommandList* AffinityCommandList = static_cast<CD3DX12AffinityGraphicsCommandList*>(ppCommandLists[c]);
+        UINT const ListNodeMask = AffinityCommandList->GetActiveAffinityMask() & EffectiveAffinityMask;
+
+        // A copy of something an earlier list in the batch wrote can't wait for the
+        // write, so the batch ends before this list and the write signals first.
+        for (D3DX12_AFFINITY_REPLICATION_ACCESS const& Access : AffinityCommandList->GetReplicationAccesses())
+        {
+            UINT const NodeMask = Access.NodeMask & ListNodeMask;
+            if (c > 0 && NodeMask != 0 && Access.pResource->ReadsPendingWrite(Access, NodeMask, Batch))
+            {
+                NumPrepared = c;
+                return true;
+            }
+        }
+
+        for (D3DX12_AFFINITY_REPLICATION_ACCESS const& Access : AffinityCommandList->GetReplicationAccesses())
+        {
+            UINT const NodeMask = Access.NodeMask & ListNodeMask;
+            if (NodeMask != 0)
+            {
+                Access.pResource->TrackReplicationAccess(Access, NodeMask, Batch);
+                Batch.TouchedNodeMask |= NodeMask;
+            }
+        }
+    }
+
+    return true;
+}
+
 void STDMETHODCALLTYPE CD3DX12AffinityCommandQueue::ExecuteCommandLists(
     UINT NumCommandLists,
     CD3DX12AffinityCommandList* const* ppCommandLists,
@@ -88,41 +153,89 @@ void STDMETHODCALLTYPE CD3DX12AffinityCommandQueue::ExecuteCommandLists(
     UINT ActiveNodeIndex = GetActiveNodeIndex();
     UINT EffectiveAffinityMask = (AffinityMask == 0) ? GetNodeMask() : AffinityMask & GetNodeMask();
 
-    for (UINT i = 0; i < D3DX12_MAX_ACTIVE_NODES;i++)
+    // Lists are submitted in batches, split wherever a list needs a copy of a write
+    // made by an earlier list.
+    UINT FirstList = 0;
+    while (FirstList < NumCommandLists)
     {
-        if (((1 << i) & EffectiveAffinityMask) != 0)
+        UINT NumBatchLists = NumCommandLists - FirstList;
+
+#if D3DX12_REPLICATE_SIMULTANEOUS_ACCESS_RESOURCES
+        // Held until every node's copies and lists are submitted, so fence values are
+        // signaled in the order they were handed out.
+        std::unique_lock<std::mutex> ReplicationLock(GetParentDevice()->MutexReplication);
+        D3DX12_AFFINITY_REPLICATION_BATCH Batch;
+        bool const Replicating = PrepareReplication(NumBatchLists, ppCommandLists + FirstList, EffectiveAffinityMask, Batch, NumBatchLists);
+        if (!Replicating)
         {
-            {
-                ID3D12CommandQueue* Queue = mCommandQueues[i];
+            ReplicationLock.unlock();
+        }
+#endif
 
-                UINT index = 0;
-                for (UINT c = 0; c < NumCommandLists; ++c)
+        for (UINT i = 0; i < D3DX12_MAX_ACTIVE_NODES;i++)
+        {
+            if (((1 << i) & EffectiveAffinityMask) != 0)
+            {
                 {
-                    CD3DX12AffinityGraphicsCommandList* AffinityCommandList = static_cast<CD3DX12AffinityGraphicsCommandList*>(ppCommandLists[c]);
-                    if (AffinityCommandList->GetActiveAffinityMask() & (1 << i))
+                    ID3D12CommandQueue* Queue = mCommandQueues[i];
+
+                    UINT index = 0;
+                    for (UINT c = FirstList; c < FirstList + NumBatchLists; ++c)
                     {
-                        mCachedCommandLists[index++] = AffinityCommandList->GetChildObject(i);
+                        CD3DX12AffinityGraphicsCommandList* AffinityCommandList = static_cast<CD3DX12AffinityGraphicsCommandList*>(ppCommandLists[c]);
+                        if (AffinityCommandList->GetActiveAffinityMask() & (1 << i))
+                        {
+                            mCachedCommandLists[index++] = AffinityCommandList->GetChildObject(i);
+                        }
                     }
-                }
 
-                Queue->ExecuteCommandLists(index, mCachedCommandLists.data());
+#if D3DX12_REPLICATE_SIMULTANEOUS_ACCESS_RESOURCES
+                    if (Replicating && !Batch.Copies[i].empty())
+                    {
+                        // The copies overwrite this node's copies, so they must wait for work
+                        // already on this queue that may still be reading them.
+                        Batch.CopyWaits[i].push_back(std::make_pair(mReplicationFences[i], mReplicationFenceValues[i]));
+                        GetParentDevice()->ExecuteReplicationCopies(i, Batch);
+                        Queue->Wait(Batch.pCopyFences[i], Batch.CopyFenceValues[i]);
+                    }
+                    if (Replicating)
+                    {
+                        for (std::pair<ID3D12Fence*, UINT64> const& Wait : Batch.QueueWaits[i])
+                        {
+                            Queue->Wait(Wait.first, Wait.second);
+                        }
+                    }
+#endif
+
+                    Queue->ExecuteCommandLists(index, mCachedCommandLists.data());
+
+#if D3DX12_REPLICATE_SIMULTANEOUS_ACCESS_RESOURCES
+                    if (Replicating && (Batch.TouchedNodeMask & (1 << i)) != 0)
+                    {
+                        Queue->Signal(mReplicationFences[i], Batch.NodeFenceValues[i]);
+                        mReplicationFenceValues[i] = Batch.NodeFenceValues[i];
+                    }
+#endif
 
 #ifdef SERIALIZE_COMMNANDLIST_EXECUTION
-                ID3D12Fence* pFence;
-                GetParentDevice()->mDevices[0]->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&pFence));
-                Queue->Signal(pFence, 1);
-                HANDLE hEvent = CreateEvent(nullptr, FALSE, FALSE, nullptr);
-                pFence->SetEventOnCompletion(1, hEvent);
-                WaitForSingleObject(hEvent, INFINITE);
-                CloseHandle(hEvent);
-                pFence->Release();
-                if (FAILED(GetParentDevice()->mDevices[0]->GetDeviceRemovedReason()))
-                {
-                    __debugbreak();
-                }
+                    ID3D12Fence* pFence;
+                    GetParentDevice()->mDevices[0]->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&pFence));
+                    Queue->Signal(pFence, 1);
+                    HANDLE hEvent = CreateEvent(nullptr, FALSE, FALSE, nullptr);
+                    pFence->SetEventOnCompletion(1, hEvent);
+                    WaitForSingleObject(hEvent, INFINITE);
+                    CloseHandle(hEvent);
+                    pFence->Release();
+                    if (FAILED(GetParentDevice()->mDevices[0]->GetDeviceRemovedReason()))
+                    {
+                        __debugbreak();
+                    }
 #endif
+                }
             }
         }
+
+        FirstList += NumBatchLists;
     }
     ReleaseLog(L"D3DX12AffinityLayer: [event] ExecuteCommandLists\n");
 }
@@ -258,6 +371,24 @@ CD3DX12AffinityCommandQueue::CD3DX12AffinityCommandQueue(CD3DX12AffinityDevice*
 #ifdef DEBUG_OBJECT_NAME
     mObjectTypeName = L"CommandQueue";
 #endif
+
+    for (UINT i = 0; i < D3DX12_MAX_ACTIVE_NODES; i++)
+    {
+        mReplicationFences[i] = nullptr;
+        mReplicationFenceValues[i] = 0;
+    }
+}
+
+CD3DX12AffinityCommandQueue::~CD3DX12AffinityCommandQueue()
+{
+    // Replicated subresources hold their own references to these.
+    for (UINT i = 0; i < D3DX12_MAX_ACTIVE_NODES; i++)
+    {
+        if (mReplicationFences[i])
+        {
+            mReplicationFences[i]->Release();
+        }
+    }
 }
 
 ID3D12CommandQueue* CD3DX12AffinityCommandQueue::GetChildObject(UINT AffinityIndex)
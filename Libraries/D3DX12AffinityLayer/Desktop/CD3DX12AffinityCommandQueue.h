@@ -85,8 +85,20 @@ public:
     void WaitForCompletion(UINT AffinityMask = EAffinityMask::AllNodes);
 
     CD3DX12AffinityCommandQueue(CD3DX12AffinityDevice* device, ID3D12CommandQueue** commandQueues, UINT Count);
+    ~CD3DX12AffinityCommandQueue();
 
 private:
+    bool PrepareReplication(
+        UINT NumCommandLists,
+        CD3DX12AffinityCommandList* const* ppCommandLists,
+        UINT EffectiveAffinityMask,
+        D3DX12_AFFINITY_REPLICATION_BATCH& Batch,
+        UINT& NumPrepared);
+
     std::vector<ID3D12CommandList*> mCachedCommandLists;
     ID3D12CommandQueue* mCommandQueues[D3DX12_MAX_ACTIVE_NODES];
+
+    // Signaled on each node after every batch that touches replicated resources.
+    ID3D12Fence* mReplicationFences[D3DX12_MAX_ACTIVE_NODES];
+    UINT64 mReplicationFenceValues[D3DX12_MAX_ACTIVE_NODES];
 };
@@ -806,7 +806,8 @@ HRESULT STDMETHODCALLTYPE CD3DX12AffinityDevice::CreateCommittedResource(
                 }
                 else
                 {
-                    Properties.VisibleNodeMask = nodeMask;
+                    // Replicated resources are copied between nodes, so every node must see every copy.
+                    Properties.VisibleNodeMask = CD3DX12AffinityResource::IsReplicationCandidate(this, *pResourceDesc) ? LDAAllNodeMasks() : nodeMask;
 #if TILE_MAPPING_GPUVA
                     if (GetNodeCount() > 1 &&
                         pResourceDesc->Dimension == D3D12_RESOURCE_DIMENSION_BUFFER)
@@ -1382,11 +1383,90 @@ CD3DX12AffinityDevice::~CD3DX12AffinityDevice()
 {
     for (UINT i = 0; i < GetNodeCount(); i++)
     {
+        for (ReplicationCopyContext& Context : mReplicationCopyContexts[i])
+        {
+            Context.pCommandList->Release();
+            Context.pAllocator->Release();
+        }
+
         mSyncCommandQueues[i]->Release();
         mSyncFences[i]->Release();
     }
 }
 
+void CD3DX12AffinityDevice::PrepareReplicationBatch(D3DX12_AFFINITY_REPLICATION_BATCH& Batch)
+{
+    for (UINT i = 0; i < D3DX12_MAX_ACTIVE_NODES;i++)
+    {
+        Batch.pCopyFences[i] = i < GetNodeCount() ? mSyncFences[i] : nullptr;
+        Batch.CopyFenceValues[i] = mSyncFenceValues[i] + 1;
+    }
+}
+
+HRESULT CD3DX12AffinityDevice::ExecuteReplicationCopies(UINT NodeIndex, D3DX12_AFFINITY_REPLICATION_BATCH const& Batch)
+{
+    ID3D12Fence* CopyFence = mSyncFences[NodeIndex];
+    UINT64 const CompletedValue = CopyFence->GetCompletedValue();
+
+    // Reuse a copy list the GPU has finished with, or add another one.
+    ReplicationCopyContext* Context = nullptr;
+    for (ReplicationCopyContext& Candidate : mReplicationCopyContexts[NodeIndex])
+    {
+        if (Candidate.FenceValue <= CompletedValue)
+        {
+            Context = &Candidate;
+            break;
+        }
+    }
+
+    if (!Context)
+    {
+        ReplicationCopyContext NewContext = {};
+        RETURN_IF_FAILED(mDevices[0]->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_COPY, IID_PPV_ARGS(&NewContext.pAllocator)));
+        RETURN_IF_FAILED(mDevices[0]->CreateCommandList(AffinityIndexToNodeMask(NodeIndex), D3D12_COMMAND_LIST_TYPE_COPY, NewContext.pAllocator, nullptr, IID_PPV_ARGS(&NewContext.pCommandList)));
+        NewContext.pCommandList->Close();
+
+        mReplicationCopyContexts[NodeIndex].push_back(NewContext);
+        Context = &mReplicationCopyContexts[NodeIndex].back();
+    }
+
+    RETURN_IF_FAILED(Context->pAllocator->Reset());
+    RETURN_IF_FAILED(Context->pCommandList->Reset(Context->pAllocator, nullptr));
+
+    for (D3DX12_AFFINITY_REPLICATION_COPY const& Copy : Batch.Copies[NodeIndex])
+    {
+        D3D12_TEXTURE_COPY_LOCATION Dst = {};
+        Dst.pResource = Copy.pResource->mResources[NodeIndex];
+        Dst.Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
+        Dst.SubresourceIndex = Copy.Subresource;
+
+        D3D12_TEXTURE_COPY_LOCATION Src = {};
+        Src.pResource = Copy.pResource->mResources[Copy.SourceNode];
+        Src.Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
+        Src.SubresourceIndex = Copy.Subresource;
+
+        Context->pCommandList->CopyTextureRegion(&Dst, Copy.Region.left, Copy.Region.top, Copy.Region.front, &Src, &Copy.Region);
+    }
+
+    RETURN_IF_FAILED(Context->pCommandList->Close());
+
+    ID3D12CommandQueue* Queue = mSyncCommandQueues[NodeIndex];
+    for (std::pair<ID3D12Fence*, UINT64> const& Wait : Batch.CopyWaits[NodeIndex])
+    {
+        RETURN_IF_FAILED(Queue->Wait(Wait.first, Wait.second));
+    }
+
+    ID3D12CommandList* CommandLists[] = { Context->pCommandList };
+    Queue->ExecuteCommandLists(_countof(CommandLists), CommandLists);
+    RETURN_IF_FAILED(Queue->Signal(CopyFence, Batch.CopyFenceValues[NodeIndex]));
+
+    mSyncFenceValues[NodeIndex] = Batch.CopyFenceValues[NodeIndex];
+    Context->FenceValue = Batch.CopyFenceValues[NodeIndex];
+
+    ReleaseLog(L"D3DX12AffinityLayer: [replication] Copied %u stale subresource regions onto node %u.\n", static_cast<UINT>(Batch.Copies[NodeIndex].size()), NodeIndex);
+    return S_OK;
+}
+
 UINT CD3DX12AffinityDevice::GetDeviceCount()
 {
     return mDeviceCount;
@@ -1546,6 +1626,11 @@ UINT CD3DX12AffinityDevice::GetActiveNodeMask()
 }
 
 void CD3DX12AffinityDevice::SwitchToNextNode()
+{
+    SwitchToNode(g_ActiveNodeIndex + 1);
+}
+
+void CD3DX12AffinityDevice::SwitchToNode(UINT NodeIndex)
 {
 #ifdef SYNC_CROSS_FRAME_RESOURCES
     // Sync all cross frame resources.
@@ -1573,7 +1658,7 @@ void CD3DX12AffinityDevice::SwitchToNextNode()
     }
 #endif
 
-    g_ActiveNodeIndex = (g_ActiveNodeIndex + 1) % GetNodeCount();
+    g_ActiveNodeIndex = NodeIndex % GetNodeCount();
 }
 
 UINT CD3DX12AffinityDevice::g_ActiveNodeIndex = 0;
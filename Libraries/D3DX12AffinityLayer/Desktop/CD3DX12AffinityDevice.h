@@ -301,11 +301,23 @@ public:
     UINT LDAAllNodeMasks();
     UINT GetActiveNodeMask();
     void SwitchToNextNode();
+    // Makes NodeIndex the active node, for apps that don't assign frames to nodes in a
+    // fixed order (see CDXGIAffinitySwapChain::GetNextRenderNode).
+    void SwitchToNode(UINT NodeIndex);
 
     D3D12_CPU_DESCRIPTOR_HANDLE GetCPUHeapPointer(D3D12_CPU_DESCRIPTOR_HANDLE const& Original, UINT const NodeIndex);
     D3D12_GPU_DESCRIPTOR_HANDLE GetGPUHeapPointer(D3D12_GPU_DESCRIPTOR_HANDLE const& Original, UINT const NodeIndex);
     D3D12_GPU_VIRTUAL_ADDRESS GetGPUVirtualAddress(D3D12_GPU_VIRTUAL_ADDRESS const& Original, UINT const NodeIndex);
 
+    // Fills in the copy fences a replication batch will signal. Callers hold MutexReplication
+    // from here until the batch has been submitted.
+    void PrepareReplicationBatch(D3DX12_AFFINITY_REPLICATION_BATCH& Batch);
+
+    // Records the batch's copies onto a node and submits them on that node's sync copy queue.
+    HRESULT ExecuteReplicationCopies(UINT NodeIndex, D3DX12_AFFINITY_REPLICATION_BATCH const& Batch);
+
+    std::mutex MutexReplication;
+
 protected:
     virtual bool IsD3D();
 
@@ -338,6 +350,15 @@ private:
     ID3D12Fence* mSyncFences[D3DX12_MAX_ACTIVE_NODES];
     std::mutex MutexSyncResources;
     std::vector<CD3DX12AffinityResource*> mSyncResources;
+    UINT64 mSyncFenceValues[D3DX12_MAX_ACTIVE_NODES] = {};
+
+    struct ReplicationCopyContext
+    {
+        ID3D12CommandAllocator* pAllocator;
+        ID3D12GraphicsCommandList* pCommandList;
+        UINT64 FenceValue;
+    };
+    std::vector<ReplicationCopyContext> mReplicationCopyContexts[D3DX12_MAX_ACTIVE_NODES];
     ID3D12InfoQueue* InfoQueue = nullptr;
 
 public:
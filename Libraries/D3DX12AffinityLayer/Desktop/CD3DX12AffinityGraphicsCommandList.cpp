@@ -12,6 +12,248 @@
 #include "d3dx12affinity.h"
 #include "Utils.h"
 
+CD3DX12AffinityCommandStream::CD3DX12AffinityCommandStream()
+    : mBlockIndex(0)
+    , mBlockOffset(0)
+    , mNodeMask(0)
+{
+}
+
+void* CD3DX12AffinityCommandStream::Allocate(size_t Size, size_t Alignment)
+{
+    while (mBlockIndex < mBlocks.size())
+    {
+        Block& Current = mBlocks[mBlockIndex];
+        size_t const Offset = (mBlockOffset + Alignment - 1) & ~(Alignment - 1);
+        if (Offset + Size <= Current.Size)
+        {
+            mBlockOffset = Offset + Size;
+            return Current.Data.get() + Offset;
+        }
+
+        // Move on to the next retained block, if there is one.
+        ++mBlockIndex;
+        mBlockOffset = 0;
+    }
+
+    // Oversized allocations get a block of their own.
+    Block NewBlock;
+    NewBlock.Size = (Size + Alignment > BlockSize) ? Size + Alignment : BlockSize;
+    NewBlock.Data.reset(new BYTE[NewBlock.Size]);
+    mBlocks.push_back(std::move(NewBlock));
+
+    return Allocate(Size, Alignment);
+}
+
+void CD3DX12AffinityCommandStream::Replay(UINT NodeIndex, ID3D12GraphicsCommandList* pList) const
+{
+    UINT const NodeBit = 1 << NodeIndex;
+
+    for (Entry const& Command : mEntries)
+    {
+        if ((Command.AffinityMask & NodeBit) != 0)
+        {
+            Command.Replay(Command.pCommand, NodeIndex, pList);
+        }
+    }
+}
+
+void CD3DX12AffinityCommandStream::Clear()
+{
+    mEntries.clear();
+    mBlockIndex = 0;
+    mBlockOffset = 0;
+    mNodeMask = 0;
+}
+
+CD3DX12AffinityStagingDescriptors::CD3DX12AffinityStagingDescriptors()
+{
+    memset(mIncrements, 0, sizeof(mIncrements));
+    Clear();
+}
+
+CD3DX12AffinityStagingDescriptors::~CD3DX12AffinityStagingDescriptors()
+{
+    for (std::vector<Page>& Pages : mPages)
+    {
+        for (Page& Current : Pages)
+        {
+            for (UINT i = 0; i < D3DX12_MAX_ACTIVE_NODES; i++)
+            {
+                if (Current.Heaps[i])
+                {
+                    Current.Heaps[i]->Release();
+                }
+            }
+        }
+    }
+}
+
+bool CD3DX12AffinityStagingDescriptors::AddPage(CD3DX12AffinityDevice* Device, D3D12_DESCRIPTOR_HEAP_TYPE Type)
+{
+    bool const IsLDA = Device->GetAffinityMode() == EAffinityMode::LDA;
+
+    Page NewPage = {};
+    for (UINT i = 0; i < Device->GetNodeCount(); i++)
+    {
+        ID3D12Device* NodeDevice = Device->GetChildObject(i);
+
+        D3D12_DESCRIPTOR_HEAP_DESC Desc = {};
+        Desc.Type = Type;
+        Desc.NumDescriptors = PageSize;
+        Desc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
+        Desc.NodeMask = IsLDA ? Device->AffinityIndexToNodeMask(i) : 0;
+
+        if (S_OK != NodeDevice->CreateDescriptorHeap(&Desc, IID_PPV_ARGS(&NewPage.Heaps[i])))
+        {
+            for (UINT j = 0; j < i; j++)
+            {
+                NewPage.Heaps[j]->Release();
+            }
+            return false;
+        }
+
+        NewPage.Starts[i] = NewPage.Heaps[i]->GetCPUDescriptorHandleForHeapStart();
+        mIncrements[Type][i] = NodeDevice->GetDescriptorHandleIncrementSize(Type);
+    }
+
+    mPages[Type].push_back(NewPage);
+    return true;
+}
+
+CD3DX12AffinityStagingDescriptors::Range CD3DX12AffinityStagingDescriptors::Stage(
+    CD3DX12AffinityDevice* Device,
+    D3D12_DESCRIPTOR_HEAP_TYPE Type,
+    const D3D12_CPU_DESCRIPTOR_HANDLE* pDescriptors,
+    UINT Count,
+    UINT NodeMask)
+{
+    Range Staged = { Type, 0, 0, 0 };
+    if (Count == 0 || Count > PageSize)
+    {
+        return Staged;
+    }
+
+    // A range never straddles two pages, so its slots stay consecutive.
+    if (mPageOffset[Type] + Count > PageSize)
+    {
+        ++mPageIndex[Type];
+        mPageOffset[Type] = 0;
+    }
+
+    if (mPageIndex[Type] == mPages[Type].size() && !AddPage(Device, Type))
+    {
+        DebugLog(L"Failed to create a staging descriptor heap, replay reads the application's descriptors\n");
+        return Staged;
+    }
+
+    Staged.Page = mPageIndex[Type];
+    Staged.Offset = mPageOffset[Type];
+    Staged.Count = Count;
+    mPageOffset[Type] += Count;
+
+    for (UINT i = 0; i < D3DX12_MAX_ACTIVE_NODES; i++)
+    {
+        if (((1 << i) & NodeMask) != 0)
+        {
+            ID3D12Device* NodeDevice = Device->GetChildObject(i);
+            for (UINT r = 0; r < Count; ++r)
+            {
+                D3D12_CPU_DESCRIPTOR_HANDLE Destination = GetHandle(Staged, i);
+                Destination.ptr += r * mIncrements[Type][i];
+                NodeDevice->CopyDescriptorsSimple(1, Destination, Device->GetCPUHeapPointer(pDescriptors[r], i), Type);
+            }
+        }
+    }
+
+    return Staged;
+}
+
+D3D12_CPU_DESCRIPTOR_HANDLE CD3DX12AffinityStagingDescriptors::GetHandle(Range const& Staged, UINT NodeIndex) const
+{
+    D3D12_CPU_DESCRIPTOR_HANDLE Handle = mPages[Staged.Type][Staged.Page].Starts[NodeIndex];
+    Handle.ptr += Staged.Offset * mIncrements[Staged.Type][NodeIndex];
+    return Handle;
+}
+
+void CD3DX12AffinityStagingDescriptors::Clear()
+{
+    for (UINT t = 0; t < D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES; t++)
+    {
+        mPageIndex[t] = 0;
+        mPageOffset[t] = 0;
+    }
+}
+
+// Barriers out of these states end a write, and barriers into the read states begin a read.
+static D3D12_RESOURCE_STATES const ReplicationWriteStates =
+    D3D12_RESOURCE_STATE_RENDER_TARGET |
+    D3D12_RESOURCE_STATE_UNORDERED_ACCESS |
+    D3D12_RESOURCE_STATE_DEPTH_WRITE |
+    D3D12_RESOURCE_STATE_STREAM_OUT |
+    D3D12_RESOURCE_STATE_COPY_DEST |
+    D3D12_RESOURCE_STATE_RESOLVE_DEST;
+
+static D3D12_RESOURCE_STATES const ReplicationReadStates =
+    D3D12_RESOURCE_STATE_GENERIC_READ |
+    D3D12_RESOURCE_STATE_DEPTH_READ |
+    D3D12_RESOURCE_STATE_RESOLVE_SOURCE;
+
+#if D3DX12_REPLICATE_SIMULTANEOUS_ACCESS_RESOURCES
+// Whether a node reads a subresource that another node wrote earlier in the same list.
+// The copy would have to run in the middle of the list, which the queue can't do.
+static bool ReadsWriteFromSameList(std::vector<D3DX12_AFFINITY_REPLICATION_ACCESS> const& Accesses)
+{
+    for (size_t a = 0; a < Accesses.size(); ++a)
+    {
+        D3DX12_AFFINITY_REPLICATION_ACCESS const& Access = Accesses[a];
+        if (Access.Type == D3DX12_AFFINITY_REPLICATION_ACCESS_OVERWRITE)
+        {
+            continue;
+        }
+
+        for (size_t w = a; w-- > 0;)
+        {
+            D3DX12_AFFINITY_REPLICATION_ACCESS const& Write = Accesses[w];
+            bool const AllSubresources = Write.Subresource == D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
+            if (Write.pResource != Access.pResource ||
+                Write.Type == D3DX12_AFFINITY_REPLICATION_ACCESS_READ ||
+                (Write.Subresource != Access.Subresource && !AllSubresources && Access.Subresource != D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES))
+            {
+                continue;
+            }
+
+            if ((Access.NodeMask & ~Write.NodeMask) != 0)
+            {
+                return true;
+            }
+
+            // Anything written before this is current on the nodes that read it.
+            if (Write.Subresource == Access.Subresource || AllSubresources)
+            {
+                break;
+            }
+        }
+    }
+    return false;
+}
+#endif
+
+void CD3DX12AffinityGraphicsCommandList::TrackReplicationAccess(
+    CD3DX12AffinityResource* pResource,
+    UINT Subresource,
+    D3DX12_AFFINITY_REPLICATION_ACCESS_TYPE Type,
+    const D3D12_BOX* pRegion)
+{
+#if D3DX12_REPLICATE_SIMULTANEOUS_ACCESS_RESOURCES
+    if (pResource && pResource->IsReplicated())
+    {
+        D3DX12_AFFINITY_REPLICATION_ACCESS Access = { pResource, Subresource, mAffinityMask, Type, pRegion != nullptr, pRegion ? *pRegion : D3D12_BOX() };
+        mReplicationAccesses.push_back(Access);
+    }
+#endif
+}
+
 void STDMETHODCALLTYPE CD3DX12AffinityGraphicsCommandList::SetAffinity(UINT AffinityMask)
 {
     CD3DX12AffinityObject::SetAffinity(AffinityMask);
@@ -23,8 +265,110 @@ D3D12_COMMAND_LIST_TYPE CD3DX12AffinityGraphicsCommandList::GetType()
     return mGraphicsCommandLists[0]->GetType();
 }
 
+void CD3DX12AffinityGraphicsCommandList::ReplayCommandStream()
+{
+    UINT const NodeMask = mCommandStream.GetNodeMask();
+    bool const Parallel = mCommandStream.GetCommandCount() >= D3DX12_REPLAY_PARALLEL_THRESHOLD;
+
+    // The first node is replayed on this thread, the rest on their own threads.
+    std::future<void> Workers[D3DX12_MAX_ACTIVE_NODES];
+    UINT LocalNode = D3DX12_MAX_ACTIVE_NODES;
+
+    for (UINT i = 0; i < D3DX12_MAX_ACTIVE_NODES;i++)
+    {
+        if (((1 << i) & NodeMask) != 0)
+        {
+            if (LocalNode == D3DX12_MAX_ACTIVE_NODES)
+            {
+                LocalNode = i;
+            }
+            else if (Parallel)
+            {
+                Workers[i] = std::async(std::launch::async, [this, i]()
+                {
+                    mCommandStream.Replay(i, mGraphicsCommandLists[i]);
+                });
+            }
+            else
+            {
+                mCommandStream.Replay(i, mGraphicsCommandLists[i]);
+            }
+        }
+    }
+
+    if (LocalNode != D3DX12_MAX_ACTIVE_NODES)
+    {
+        mCommandStream.Replay(LocalNode, mGraphicsCommandLists[LocalNode]);
+    }
+
+    for (UINT i = 0; i < D3DX12_MAX_ACTIVE_NODES;i++)
+    {
+        if (Workers[i].valid())
+        {
+            Workers[i].get();
+        }
+    }
+
+    mCommandStream.Clear();
+
+    // The node lists have read the staged copies now.
+    mStagingDescriptors.Clear();
+}
+
+CD3DX12AffinityStagingDescriptors::Range CD3DX12AffinityGraphicsCommandList::StageCPUDescriptors(
+    D3D12_DESCRIPTOR_HEAP_TYPE Type,
+    const D3D12_CPU_DESCRIPTOR_HANDLE* pDescriptors,
+    UINT Count,
+    BOOL SingleHandleToDescriptorRange)
+{
+    CD3DX12AffinityStagingDescriptors::Range Staged = { Type, 0, 0, 0 };
+
+#if D3DX12_REPLAY_COMMAND_LISTS
+    if (mRecording && pDescriptors && Count > 0)
+    {
+        CD3DX12AffinityDevice* Device = GetParentDevice();
+
+        // With a single handle, the range is consecutive in the affinity heap.
+        D3D12_CPU_DESCRIPTOR_HANDLE Descriptors[D3D12_SIMULTANEOUS_RENDER_TARGET_COUNT];
+        if (SingleHandleToDescriptorRange && Count > 1)
+        {
+            UINT const Increment = Device->GetDescriptorHandleIncrementSize(Type);
+            Count = min(Count, (UINT)D3D12_SIMULTANEOUS_RENDER_TARGET_COUNT);
+            for (UINT r = 0; r < Count; ++r)
+            {
+                Descriptors[r].ptr = pDescriptors[0].ptr + r * Increment;
+            }
+            pDescriptors = Descriptors;
+        }
+
+        Staged = mStagingDescriptors.Stage(Device, Type, pDescriptors, Count, mAffinityMask);
+    }
+#endif
+
+    return Staged;
+}
+
+D3D12_CPU_DESCRIPTOR_HANDLE CD3DX12AffinityGraphicsCommandList::GetNodeCPUDescriptor(
+    CD3DX12AffinityStagingDescriptors::Range const& Staged,
+    D3D12_CPU_DESCRIPTOR_HANDLE Original,
+    UINT NodeIndex)
+{
+    if (Staged.Count > 0)
+    {
+        return mStagingDescriptors.GetHandle(Staged, NodeIndex);
+    }
+    return GetParentDevice()->GetCPUHeapPointer(Original, NodeIndex);
+}
+
 HRESULT CD3DX12AffinityGraphicsCommandList::Close()
 {
+#if D3DX12_REPLAY_COMMAND_LISTS
+    if (mRecording)
+    {
+        ReplayCommandStream();
+    }
+#endif
+
 #if ALWAYS_RESET_ALL_COMMAND_LISTS
     for (UINT i = 0; i < GetNodeCount(); ++i)
     {
@@ -48,6 +392,14 @@ HRESULT CD3DX12AffinityGraphicsCommandList::Close()
     }
 #endif
 
+#if D3DX12_REPLICATE_SIMULTANEOUS_ACCESS_RESOURCES
+    if (ReadsWriteFromSameList(mReplicationAccesses))
+    {
+        ReleaseLog(L"D3DX12AffinityLayer: [replication] Command list reads a replicated subresource on one node after writing it on another, split it at that point.\n");
+        return E_INVALIDARG;
+    }
+#endif
+
     return S_OK;
 }
 
@@ -61,6 +413,13 @@ HRESULT CD3DX12AffinityGraphicsCommandList::Reset(
         SetAffinity(1 << GetActiveNodeIndex());
     }
 
+#if D3DX12_REPLAY_COMMAND_LISTS
+    mCommandStream.Clear();
+    mStagingDescriptors.Clear();
+    mRecording = GetNodeCount() > 1;
+#endif
+    mReplicationAccesses.clear();
+
 #if ALWAYS_RESET_ALL_COMMAND_LISTS
     for (UINT i = 0; i < GetNodeCount(); ++i)
     {
@@ -91,14 +450,10 @@ void CD3DX12AffinityGraphicsCommandList::ClearState(
 {
     CD3DX12AffinityPipelineState* PipelineState = static_cast<CD3DX12AffinityPipelineState*>(pPipelineState);
 
-    for (UINT i = 0; i < D3DX12_MAX_ACTIVE_NODES;i++)
+    ForEachNode([=](UINT i, ID3D12GraphicsCommandList* List)
     {
-        if (((1 << i) & mAffinityMask) != 0)
-        {
-            ID3D12GraphicsCommandList* List = mGraphicsCommandLists[i];
-            List->ClearState(PipelineState->mPipelineStates[i]);
-        }
-    }
+        List->ClearState(PipelineState->mPipelineStates[i]);
+    });
 }
 
 void CD3DX12AffinityGraphicsCommandList::DrawInstanced(
@@ -107,15 +462,10 @@ void CD3DX12AffinityGraphicsCommandList::DrawInstanced(
     UINT StartVertexLocation,
     UINT StartInstanceLocation)
 {
-    for (UINT i = 0; i < D3DX12_MAX_ACTIVE_NODES;i++)
+    ForEachNode([=](UINT, ID3D12GraphicsCommandList* List)
     {
-        if (((1 << i) & mAffinityMask) != 0)
-        {
-            ID3D12GraphicsCommandList* List = mGraphicsCommandLists[i];
-            
-            List->DrawInstanced(VertexCountPerInstance, InstanceCount, StartVertexLocation, StartInstanceLocation);
-        }
-    }
+        List->DrawInstanced(VertexCountPerInstance, InstanceCount, StartVertexLocation, StartInstanceLocation);
+    });
 }
 
 void CD3DX12AffinityGraphicsCommandList::Dispatch(
@@ -123,14 +473,10 @@ void CD3DX12AffinityGraphicsCommandList::Dispatch(
     UINT ThreadGroupCountY,
     UINT ThreadGroupCountZ)
 {
-    for (UINT i = 0; i < D3DX12_MAX_ACTIVE_NODES;i++)
+    ForEachNode([=](UINT, ID3D12GraphicsCommandList* List)
     {
-        if (((1 << i) & mAffinityMask) != 0)
-        {
-            ID3D12GraphicsCommandList* List = mGraphicsCommandLists[i];
-            List->Dispatch(ThreadGroupCountX, ThreadGroupCountY, ThreadGroupCountZ);
-        }
-    }
+        List->Dispatch(ThreadGroupCountX, ThreadGroupCountY, ThreadGroupCountZ);
+    });
 }
 
 void CD3DX12AffinityGraphicsCommandList::CopyBufferRegion(
@@ -143,15 +489,10 @@ void CD3DX12AffinityGraphicsCommandList::CopyBufferRegion(
     CD3DX12AffinityResource* DstBuffer = static_cast<CD3DX12AffinityResource*>(pDstBuffer);
     CD3DX12AffinityResource* SrcBuffer = static_cast<CD3DX12AffinityResource*>(pSrcBuffer);
 
-    for (UINT i = 0; i < D3DX12_MAX_ACTIVE_NODES;i++)
+    ForEachNode([=](UINT i, ID3D12GraphicsCommandList* List)
     {
-        if (((1 << i) & mAffinityMask) != 0)
-        {
-            ID3D12GraphicsCommandList* List = mGraphicsCommandLists[i];
-            
-            List->CopyBufferRegion(DstBuffer->mResources[i], DstOffset, SrcBuffer->mResources[i], SrcOffset, NumBytes);
-        }
-    }
+        List->CopyBufferRegion(DstBuffer->mResources[i], DstOffset, SrcBuffer->mResources[i], SrcOffset, NumBytes);
+    });
 }
 
 void CD3DX12AffinityGraphicsCommandList::CopyTextureRegion(
@@ -165,35 +506,56 @@ void CD3DX12AffinityGraphicsCommandList::CopyTextureRegion(
     CD3DX12AffinityResource* DstTexture = static_cast<CD3DX12AffinityResource*>(pDst->pResource);
     CD3DX12AffinityResource* SrcTexture = static_cast<CD3DX12AffinityResource*>(pSrc->pResource);
 
-    D3D12_TEXTURE_COPY_LOCATION Dst = pDst->ToD3D12();
-    D3D12_TEXTURE_COPY_LOCATION Src = pSrc->ToD3D12();
+    D3D12_TEXTURE_COPY_LOCATION const Dst = pDst->ToD3D12();
+    D3D12_TEXTURE_COPY_LOCATION const Src = pSrc->ToD3D12();
+    const D3D12_BOX* SrcBox = Capture(pSrcBox, 1);
 
-    for (UINT i = 0; i < D3DX12_MAX_ACTIVE_NODES;i++)
+    if (pSrc->Type == D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX)
     {
-        if (((1 << i) & mAffinityMask) != 0)
+        TrackReplicationAccess(SrcTexture, pSrc->SubresourceIndex, D3DX12_AFFINITY_REPLICATION_ACCESS_READ);
+    }
+    if (pDst->Type == D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX)
+    {
+        // The written region is only known when the copy says how big it is.
+        if (pSrcBox || pSrc->Type == D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT)
         {
-            ID3D12GraphicsCommandList* List = mGraphicsCommandLists[i];
-
-            Dst.pResource = DstTexture->mResources[i];
-            Src.pResource = SrcTexture->mResources[i];
-            List->CopyTextureRegion(&Dst, DstX, DstY, DstZ, &Src, pSrcBox);
+            D3D12_BOX Region;
+            Region.left = DstX;
+            Region.top = DstY;
+            Region.front = DstZ;
+            Region.right = DstX + (pSrcBox ? pSrcBox->right - pSrcBox->left : pSrc->PlacedFootprint.Footprint.Width);
+            Region.bottom = DstY + (pSrcBox ? pSrcBox->bottom - pSrcBox->top : pSrc->PlacedFootprint.Footprint.Height);
+            Region.back = DstZ + (pSrcBox ? pSrcBox->back - pSrcBox->front : pSrc->PlacedFootprint.Footprint.Depth);
+            TrackReplicationAccess(DstTexture, pDst->SubresourceIndex, D3DX12_AFFINITY_REPLICATION_ACCESS_WRITE, &Region);
+        }
+        else
+        {
+            TrackReplicationAccess(DstTexture, pDst->SubresourceIndex, D3DX12_AFFINITY_REPLICATION_ACCESS_WRITE);
         }
     }
+
+    ForEachNode([=](UINT i, ID3D12GraphicsCommandList* List)
+    {
+        D3D12_TEXTURE_COPY_LOCATION NodeDst = Dst;
+        D3D12_TEXTURE_COPY_LOCATION NodeSrc = Src;
+
+        NodeDst.pResource = DstTexture->mResources[i];
+        NodeSrc.pResource = SrcTexture->mResources[i];
+        List->CopyTextureRegion(&NodeDst, DstX, DstY, DstZ, &NodeSrc, SrcBox);
+    });
 }
 
 void CD3DX12AffinityGraphicsCommandList::CopyResource(
     CD3DX12AffinityResource* pDstResource,
     CD3DX12AffinityResource* pSrcResource)
 {
-    for (UINT i = 0; i < D3DX12_MAX_ACTIVE_NODES;i++)
+    TrackReplicationAccess(pSrcResource, D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES, D3DX12_AFFINITY_REPLICATION_ACCESS_READ);
+    TrackReplicationAccess(pDstResource, D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES, D3DX12_AFFINITY_REPLICATION_ACCESS_OVERWRITE);
+
+    ForEachNode([=](UINT i, ID3D12GraphicsCommandList* List)
     {
-        if (((1 << i) & mAffinityMask) != 0)
-        {
-            ID3D12GraphicsCommandList* List = mGraphicsCommandLists[i];
-            
-            List->CopyResource(pDstResource->mResources[i], pSrcResource->mResources[i]);
-        }
-    }
+        List->CopyResource(pDstResource->mResources[i], pSrcResource->mResources[i]);
+    });
 }
 
 void CD3DX12AffinityGraphicsCommandList::CopyTiles(
@@ -204,21 +566,19 @@ void CD3DX12AffinityGraphicsCommandList::CopyTiles(
     UINT64 BufferStartOffsetInBytes,
     D3D12_TILE_COPY_FLAGS Flags)
 {
-    for (UINT i = 0; i < D3DX12_MAX_ACTIVE_NODES;i++)
+    const D3D12_TILED_RESOURCE_COORDINATE* TileRegionStartCoordinate = Capture(pTileRegionStartCoordinate, 1);
+    const D3D12_TILE_REGION_SIZE* TileRegionSize = Capture(pTileRegionSize, 1);
+
+    ForEachNode([=](UINT i, ID3D12GraphicsCommandList* List)
     {
-        if (((1 << i) & mAffinityMask) != 0)
-        {
-            ID3D12GraphicsCommandList* List = mGraphicsCommandLists[i];
-            
-            List->CopyTiles(
-                pTiledResource->mResources[i],
-                pTileRegionStartCoordinate,
-                pTileRegionSize,
-                pBuffer->mResources[i],
-                BufferStartOffsetInBytes,
-                Flags);
-        }
-    }
+        List->CopyTiles(
+            pTiledResource->mResources[i],
+            TileRegionStartCoordinate,
+            TileRegionSize,
+            pBuffer->mResources[i],
+            BufferStartOffsetInBytes,
+            Flags);
+    });
 }
 
 void CD3DX12AffinityGraphicsCommandList::ResolveSubresource(
@@ -228,187 +588,183 @@ void CD3DX12AffinityGraphicsCommandList::ResolveSubresource(
     UINT SrcSubresource,
     DXGI_FORMAT Format)
 {
+    TrackReplicationAccess(pSrcResource, SrcSubresource, D3DX12_AFFINITY_REPLICATION_ACCESS_READ);
+    TrackReplicationAccess(pDstResource, DstSubresource, D3DX12_AFFINITY_REPLICATION_ACCESS_OVERWRITE);
 
-    for (UINT i = 0; i < D3DX12_MAX_ACTIVE_NODES;i++)
+    ForEachNode([=](UINT i, ID3D12GraphicsCommandList* List)
     {
-        if (((1 << i) & mAffinityMask) != 0)
-        {
-            ID3D12GraphicsCommandList* List = mGraphicsCommandLists[i];
-            
-            List->ResolveSubresource(pDstResource->mResources[i], DstSubresource, pSrcResource->mResources[i], SrcSubresource, Format);
-        }
-    }
+        List->ResolveSubresource(pDstResource->mResources[i], DstSubresource, pSrcResource->mResources[i], SrcSubresource, Format);
+    });
 }
 
 void CD3DX12AffinityGraphicsCommandList::IASetPrimitiveTopology(
     D3D12_PRIMITIVE_TOPOLOGY PrimitiveTopology)
 {
-    for (UINT i = 0; i < D3DX12_MAX_ACTIVE_NODES;i++)
+    ForEachNode([=](UINT, ID3D12GraphicsCommandList* List)
     {
-        if (((1 << i) & mAffinityMask) != 0)
-        {
-            ID3D12GraphicsCommandList* List = mGraphicsCommandLists[i];
-            List->IASetPrimitiveTopology(PrimitiveTopology);
-        }
-    }
+        List->IASetPrimitiveTopology(PrimitiveTopology);
+    });
 }
 
 void CD3DX12AffinityGraphicsCommandList::RSSetViewports(
     UINT NumViewports,
     const D3D12_VIEWPORT* pViewports)
 {
-    for (UINT i = 0; i < D3DX12_MAX_ACTIVE_NODES;i++)
+    const D3D12_VIEWPORT* Viewports = Capture(pViewports, NumViewports);
+
+    ForEachNode([=](UINT, ID3D12GraphicsCommandList* List)
     {
-        if (((1 << i) & mAffinityMask) != 0)
-        {
-            ID3D12GraphicsCommandList* List = mGraphicsCommandLists[i];
-            List->RSSetViewports(NumViewports, pViewports);
-        }
-    }
+        List->RSSetViewports(NumViewports, Viewports);
+    });
 }
 
 void CD3DX12AffinityGraphicsCommandList::RSSetScissorRects(
     UINT NumRects,
     const D3D12_RECT* pRects)
 {
-    for (UINT i = 0; i < D3DX12_MAX_ACTIVE_NODES;i++)
+    const D3D12_RECT* Rects = Capture(pRects, NumRects);
+
+    ForEachNode([=](UINT, ID3D12GraphicsCommandList* List)
     {
-        if (((1 << i) & mAffinityMask) != 0)
-        {
-            ID3D12GraphicsCommandList* List = mGraphicsCommandLists[i];
-            List->RSSetScissorRects(NumRects, pRects);
-        }
-    }
+        List->RSSetScissorRects(NumRects, Rects);
+    });
 }
 
 void CD3DX12AffinityGraphicsCommandList::OMSetBlendFactor(
     const FLOAT BlendFactor[4])
 {
-    for (UINT i = 0; i < D3DX12_MAX_ACTIVE_NODES;i++)
+    const FLOAT* Factor = Capture(BlendFactor, 4);
+
+    ForEachNode([=](UINT, ID3D12GraphicsCommandList* List)
     {
-        if (((1 << i) & mAffinityMask) != 0)
-        {
-            ID3D12GraphicsCommandList* List = mGraphicsCommandLists[i];
-            List->OMSetBlendFactor(BlendFactor);
-        }
-    }
+        List->OMSetBlendFactor(Factor);
+    });
 }
 
 void CD3DX12AffinityGraphicsCommandList::OMSetStencilRef(
     UINT StencilRef)
 {
-    for (UINT i = 0; i < D3DX12_MAX_ACTIVE_NODES;i++)
+    ForEachNode([=](UINT, ID3D12GraphicsCommandList* List)
     {
-        if (((1 << i) & mAffinityMask) != 0)
-        {
-            ID3D12GraphicsCommandList* List = mGraphicsCommandLists[i];
-            List->OMSetStencilRef(StencilRef);
-        }
-    }
+        List->OMSetStencilRef(StencilRef);
+    });
 }
 
 void CD3DX12AffinityGraphicsCommandList::ResourceBarrier(
     UINT NumBarriers,
     const D3DX12_AFFINITY_RESOURCE_BARRIER* pBarriers)
 {
-    for (UINT i = 0; i < D3DX12_MAX_ACTIVE_NODES;i++)
+    const D3DX12_AFFINITY_RESOURCE_BARRIER* Barriers = Capture(pBarriers, NumBarriers);
+
+    for (UINT b = 0; b < NumBarriers; ++b)
     {
-        if (((1 << i) & mAffinityMask) != 0)
+        if ((pBarriers[b].Flags & D3D12_RESOURCE_BARRIER_FLAG_END_ONLY) != 0)
         {
-            ID3D12GraphicsCommandList* List = mGraphicsCommandLists[i];
+            continue;
+        }
 
-            mCachedResourceBarriers.resize(NumBarriers);
-            for (UINT b = 0; b < NumBarriers; ++b)
+        if (pBarriers[b].Type == D3D12_RESOURCE_BARRIER_TYPE_TRANSITION)
+        {
+            D3DX12_AFFINITY_RESOURCE_TRANSITION_BARRIER const& Transition = pBarriers[b].Transition;
+            if ((Transition.StateBefore & ReplicationWriteStates) != 0)
+            {
+                TrackReplicationAccess(Transition.pResource, Transition.Subresource, D3DX12_AFFINITY_REPLICATION_ACCESS_WRITE);
+            }
+            if ((Transition.StateAfter & ReplicationReadStates) != 0)
             {
-                D3D12_RESOURCE_BARRIER Use = pBarriers[b].ToD3D12();
+                TrackReplicationAccess(Transition.pResource, Transition.Subresource, D3DX12_AFFINITY_REPLICATION_ACCESS_READ);
+            }
+        }
+        else if (pBarriers[b].Type == D3D12_RESOURCE_BARRIER_TYPE_UAV)
+        {
+            TrackReplicationAccess(pBarriers[b].UAV.pResource, D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES, D3DX12_AFFINITY_REPLICATION_ACCESS_WRITE);
+        }
+    }
 
-                switch (pBarriers[b].Type)
-                {
-                case D3D12_RESOURCE_BARRIER_TYPE_TRANSITION:
+    ForEachNode([=](UINT i, ID3D12GraphicsCommandList* List)
+    {
+        std::vector<D3D12_RESOURCE_BARRIER>& CachedResourceBarriers = mCachedResourceBarriers[i];
+
+        CachedResourceBarriers.resize(NumBarriers);
+        for (UINT b = 0; b < NumBarriers; ++b)
+        {
+            D3D12_RESOURCE_BARRIER Use = Barriers[b].ToD3D12();
+
+            switch (Barriers[b].Type)
+            {
+            case D3D12_RESOURCE_BARRIER_TYPE_TRANSITION:
+            {
+                if (Barriers[b].Transition.pResource)
                 {
-                    if (pBarriers[b].Transition.pResource)
-                    {
-                        Use.Transition.pResource = pBarriers[b].Transition.pResource->mResources[i];
-                    }
-                    break;
+                    Use.Transition.pResource = Barriers[b].Transition.pResource->mResources[i];
                 }
-                case D3D12_RESOURCE_BARRIER_TYPE_ALIASING:
+                break;
+            }
+            case D3D12_RESOURCE_BARRIER_TYPE_ALIASING:
+            {
+                if (Barriers[b].Aliasing.pResourceAfter)
                 {
-                    if (pBarriers[b].Aliasing.pResourceAfter)
-                    {
-                        Use.Aliasing.pResourceAfter = pBarriers[b].Aliasing.pResourceAfter->mResources[i];
-                    }
-                    if (pBarriers[b].Aliasing.pResourceBefore)
-                    {
-                        Use.Aliasing.pResourceBefore = pBarriers[b].Aliasing.pResourceBefore->mResources[i];
-                    }
-                    break;
+                    Use.Aliasing.pResourceAfter = Barriers[b].Aliasing.pResourceAfter->mResources[i];
                 }
-                case D3D12_RESOURCE_BARRIER_TYPE_UAV:
+                if (Barriers[b].Aliasing.pResourceBefore)
                 {
-                    if (pBarriers[b].UAV.pResource)
-                    {
-                        Use.UAV.pResource = pBarriers[b].UAV.pResource->mResources[i];
-                    }
-                    break;
+                    Use.Aliasing.pResourceBefore = Barriers[b].Aliasing.pResourceBefore->mResources[i];
                 }
+                break;
+            }
+            case D3D12_RESOURCE_BARRIER_TYPE_UAV:
+            {
+                if (Barriers[b].UAV.pResource)
+                {
+                    Use.UAV.pResource = Barriers[b].UAV.pResource->mResources[i];
                 }
-
-                mCachedResourceBarriers[b] = Use;
+                break;
+            }
             }
 
-            List->ResourceBarrier(NumBarriers, mCachedResourceBarriers.data());
+            CachedResourceBarriers[b] = Use;
         }
-    }
+
+        List->ResourceBarrier(NumBarriers, CachedResourceBarriers.data());
+    });
 }
 
 void CD3DX12AffinityGraphicsCommandList::ExecuteBundle(
     CD3DX12AffinityGraphicsCommandList* pCommandList)
 {
-    for (UINT i = 0; i < D3DX12_MAX_ACTIVE_NODES;i++)
+    ForEachNode([=](UINT i, ID3D12GraphicsCommandList* List)
     {
-        if (((1 << i) & mAffinityMask) != 0)
-        {
-            ID3D12GraphicsCommandList* List = mGraphicsCommandLists[i];
-
-            List->ExecuteBundle(pCommandList->mGraphicsCommandLists[i]);
-        }
-    }
+        List->ExecuteBundle(pCommandList->mGraphicsCommandLists[i]);
+    });
 }
 
 void CD3DX12AffinityGraphicsCommandList::SetDescriptorHeaps(
     UINT NumDescriptorHeaps,
     CD3DX12AffinityDescriptorHeap** ppDescriptorHeaps)
 {
-    mCachedDescriptorHeaps.resize(NumDescriptorHeaps);
-    for (UINT i = 0; i < D3DX12_MAX_ACTIVE_NODES;i++)
+    CD3DX12AffinityDescriptorHeap* const* DescriptorHeaps = Capture(ppDescriptorHeaps, NumDescriptorHeaps);
+
+    ForEachNode([=](UINT i, ID3D12GraphicsCommandList* List)
     {
-        if (((1 << i) & mAffinityMask) != 0)
-        {
-            ID3D12GraphicsCommandList* List = mGraphicsCommandLists[i];
-            
-            for (UINT h = 0; h < NumDescriptorHeaps; ++h)
-            {
-                mCachedDescriptorHeaps[h] = static_cast<CD3DX12AffinityDescriptorHeap*>(ppDescriptorHeaps[h])->GetChildObject(i);
-            }
+        std::vector<ID3D12DescriptorHeap*>& CachedDescriptorHeaps = mCachedDescriptorHeaps[i];
 
-            List->SetDescriptorHeaps(NumDescriptorHeaps, mCachedDescriptorHeaps.data());
+        CachedDescriptorHeaps.resize(NumDescriptorHeaps);
+        for (UINT h = 0; h < NumDescriptorHeaps; ++h)
+        {
+            CachedDescriptorHeaps[h] = DescriptorHeaps[h]->GetChildObject(i);
         }
-    }
+
+        List->SetDescriptorHeaps(NumDescriptorHeaps, CachedDescriptorHeaps.data());
+    });
 }
 
 void CD3DX12AffinityGraphicsCommandList::SetComputeRootSignature(
     CD3DX12AffinityRootSignature* pRootSignature)
 {
-    for (UINT i = 0; i < D3DX12_MAX_ACTIVE_NODES;i++)
+    ForEachNode([=](UINT i, ID3D12GraphicsCommandList* List)
     {
-        if (((1 << i) & mAffinityMask) != 0)
-        {
-            ID3D12GraphicsCommandList* List = mGraphicsCommandLists[i];
-            
-            List->SetComputeRootSignature(pRootSignature->mRootSignatures[i]);
-        }
-    }
+        List->SetComputeRootSignature(pRootSignature->mRootSignatures[i]);
+    });
 }
 
 void CD3DX12AffinityGraphicsCommandList::SetGraphicsRootSignature(
@@ -416,15 +772,10 @@ void CD3DX12AffinityGraphicsCommandList::SetGraphicsRootSignature(
 {
     CD3DX12AffinityRootSignature* AffinityRootSignature = static_cast<CD3DX12AffinityRootSignature*>(pRootSignature);
 
-    for (UINT i = 0; i < D3DX12_MAX_ACTIVE_NODES;i++)
+    ForEachNode([=](UINT i, ID3D12GraphicsCommandList* List)
     {
-        if (((1 << i) & mAffinityMask) != 0)
-        {
-            ID3D12GraphicsCommandList* List = mGraphicsCommandLists[i];
-            
-            List->SetGraphicsRootSignature(AffinityRootSignature->mRootSignatures[i]);
-        }
-    }
+        List->SetGraphicsRootSignature(AffinityRootSignature->mRootSignatures[i]);
+    });
 }
 
 void CD3DX12AffinityGraphicsCommandList::SetComputeRoot32BitConstant(
@@ -432,15 +783,10 @@ void CD3DX12AffinityGraphicsCommandList::SetComputeRoot32BitConstant(
     UINT SrcData,
     UINT DestOffsetIn32BitValues)
 {
-    for (UINT i = 0; i < D3DX12_MAX_ACTIVE_NODES;i++)
+    ForEachNode([=](UINT, ID3D12GraphicsCommandList* List)
     {
-        if (((1 << i) & mAffinityMask) != 0)
-        {
-            ID3D12GraphicsCommandList* List = mGraphicsCommandLists[i];
-            
-            List->SetComputeRoot32BitConstant(RootParameterIndex, SrcData, DestOffsetIn32BitValues);
-        }
-    }
+        List->SetComputeRoot32BitConstant(RootParameterIndex, SrcData, DestOffsetIn32BitValues);
+    });
 }
 
 void CD3DX12AffinityGraphicsCommandList::SetGraphicsRoot32BitConstant(
@@ -448,15 +794,10 @@ void CD3DX12AffinityGraphicsCommandList::SetGraphicsRoot32BitConstant(
     UINT SrcData,
     UINT DestOffsetIn32BitValues)
 {
-    for (UINT i = 0; i < D3DX12_MAX_ACTIVE_NODES;i++)
+    ForEachNode([=](UINT, ID3D12GraphicsCommandList* List)
     {
-        if (((1 << i) & mAffinityMask) != 0)
-        {
-            ID3D12GraphicsCommandList* List = mGraphicsCommandLists[i];
-            
-            List->SetGraphicsRoot32BitConstant(RootParameterIndex, SrcData, DestOffsetIn32BitValues);
-        }
-    }
+        List->SetGraphicsRoot32BitConstant(RootParameterIndex, SrcData, DestOffsetIn32BitValues);
+    });
 }
 
 void CD3DX12AffinityGraphicsCommandList::SetComputeRoot32BitConstants(
@@ -465,15 +806,12 @@ void CD3DX12AffinityGraphicsCommandList::SetComputeRoot32BitConstants(
     const void* pSrcData,
     UINT DestOffsetIn32BitValues)
 {
-    for (UINT i = 0; i < D3DX12_MAX_ACTIVE_NODES;i++)
+    const UINT* SrcData = Capture(static_cast<const UINT*>(pSrcData), Num32BitValuesToSet);
+
+    ForEachNode([=](UINT, ID3D12GraphicsCommandList* List)
     {
-        if (((1 << i) & mAffinityMask) != 0)
-        {
-            ID3D12GraphicsCommandList* List = mGraphicsCommandLists[i];
-           
-            List->SetComputeRoot32BitConstants(RootParameterIndex, Num32BitValuesToSet, pSrcData, DestOffsetIn32BitValues);
-        }
-    }
+        List->SetComputeRoot32BitConstants(RootParameterIndex, Num32BitValuesToSet, SrcData, DestOffsetIn32BitValues);
+    });
 }
 
 void CD3DX12AffinityGraphicsCommandList::SetGraphicsRoot32BitConstants(
@@ -482,105 +820,84 @@ void CD3DX12AffinityGraphicsCommandList::SetGraphicsRoot32BitConstants(
     const void* pSrcData,
     UINT DestOffsetIn32BitValues)
 {
-    for (UINT i = 0; i < D3DX12_MAX_ACTIVE_NODES;i++)
+    const UINT* SrcData = Capture(static_cast<const UINT*>(pSrcData), Num32BitValuesToSet);
+
+    ForEachNode([=](UINT, ID3D12GraphicsCommandList* List)
     {
-        if (((1 << i) & mAffinityMask) != 0)
-        {
-            ID3D12GraphicsCommandList* List = mGraphicsCommandLists[i];
-            
-            List->SetGraphicsRoot32BitConstants(RootParameterIndex, Num32BitValuesToSet, pSrcData, DestOffsetIn32BitValues);
-        }
-    }
+        List->SetGraphicsRoot32BitConstants(RootParameterIndex, Num32BitValuesToSet, SrcData, DestOffsetIn32BitValues);
+    });
 }
 
 void CD3DX12AffinityGraphicsCommandList::SetComputeRootConstantBufferView(
     UINT RootParameterIndex,
     D3D12_GPU_VIRTUAL_ADDRESS BufferLocation)
 {
-    for (UINT i = 0; i < D3DX12_MAX_ACTIVE_NODES;i++)
+    CD3DX12AffinityDevice* Device = GetParentDevice();
+
+    ForEachNode([=](UINT i, ID3D12GraphicsCommandList* List)
     {
-        if (((1 << i) & mAffinityMask) != 0)
-        {
-            ID3D12GraphicsCommandList* List = mGraphicsCommandLists[i];
-            
-            List->SetComputeRootConstantBufferView(RootParameterIndex, GetParentDevice()->GetGPUVirtualAddress(BufferLocation, i));
-        }
-    }
+        List->SetComputeRootConstantBufferView(RootParameterIndex, Device->GetGPUVirtualAddress(BufferLocation, i));
+    });
 }
 
 void CD3DX12AffinityGraphicsCommandList::SetGraphicsRootConstantBufferView(
     UINT RootParameterIndex,
     D3D12_GPU_VIRTUAL_ADDRESS BufferLocation)
 {
-    for (UINT i = 0; i < D3DX12_MAX_ACTIVE_NODES;i++)
+    CD3DX12AffinityDevice* Device = GetParentDevice();
+
+    ForEachNode([=](UINT i, ID3D12GraphicsCommandList* List)
     {
-        if (((1 << i) & mAffinityMask) != 0)
-        {
-            ID3D12GraphicsCommandList* List = mGraphicsCommandLists[i];
-            
-            List->SetGraphicsRootConstantBufferView(RootParameterIndex, GetParentDevice()->GetGPUVirtualAddress(BufferLocation, i));
-        }
-    }
+        List->SetGraphicsRootConstantBufferView(RootParameterIndex, Device->GetGPUVirtualAddress(BufferLocation, i));
+    });
 }
 
 void CD3DX12AffinityGraphicsCommandList::SetComputeRootShaderResourceView(
     UINT RootParameterIndex,
     D3D12_GPU_VIRTUAL_ADDRESS BufferLocation)
 {
-    for (UINT i = 0; i < D3DX12_MAX_ACTIVE_NODES;i++)
+    CD3DX12AffinityDevice* Device = GetParentDevice();
+
+    ForEachNode([=](UINT i, ID3D12GraphicsCommandList* List)
     {
-        if (((1 << i) & mAffinityMask) != 0)
-        {
-            ID3D12GraphicsCommandList* List = mGraphicsCommandLists[i];
-            
-            List->SetComputeRootShaderResourceView(RootParameterIndex, GetParentDevice()->GetGPUVirtualAddress(BufferLocation, i));
-        }
-    }
+        List->SetComputeRootShaderResourceView(RootParameterIndex, Device->GetGPUVirtualAddress(BufferLocation, i));
+    });
 }
 
 void CD3DX12AffinityGraphicsCommandList::SetGraphicsRootShaderResourceView(
     UINT RootParameterIndex,
     D3D12_GPU_VIRTUAL_ADDRESS BufferLocation)
 {
-    for (UINT i = 0; i < D3DX12_MAX_ACTIVE_NODES;i++)
+    CD3DX12AffinityDevice* Device = GetParentDevice();
+
+    ForEachNode([=](UINT i, ID3D12GraphicsCommandList* List)
     {
-        if (((1 << i) & mAffinityMask) != 0)
-        {
-            ID3D12GraphicsCommandList* List = mGraphicsCommandLists[i];
-            
-            List->SetGraphicsRootShaderResourceView(RootParameterIndex, GetParentDevice()->GetGPUVirtualAddress(BufferLocation, i));
-        }
-    }
+        List->SetGraphicsRootShaderResourceView(RootParameterIndex, Device->GetGPUVirtualAddress(BufferLocation, i));
+    });
 }
 
 void CD3DX12AffinityGraphicsCommandList::SetComputeRootUnorderedAccessView(
     UINT RootParameterIndex,
     D3D12_GPU_VIRTUAL_ADDRESS BufferLocation)
 {
-    for (UINT i = 0; i < D3DX12_MAX_ACTIVE_NODES;i++)
+    CD3DX12AffinityDevice* Device = GetParentDevice();
+
+    ForEachNode([=](UINT i, ID3D12GraphicsCommandList* List)
     {
-        if (((1 << i) & mAffinityMask) != 0)
-        {
-            ID3D12GraphicsCommandList* List = mGraphicsCommandLists[i];
-            
-            List->SetComputeRootUnorderedAccessView(RootParameterIndex, GetParentDevice()->GetGPUVirtualAddress(BufferLocation, i));
-        }
-    }
+        List->SetComputeRootUnorderedAccessView(RootParameterIndex, Device->GetGPUVirtualAddress(BufferLocation, i));
+    });
 }
 
 void CD3DX12AffinityGraphicsCommandList::SetGraphicsRootUnorderedAccessView(
     UINT RootParameterIndex,
     D3D12_GPU_VIRTUAL_ADDRESS BufferLocation)
 {
-    for (UINT i = 0; i < D3DX12_MAX_ACTIVE_NODES;i++)
+    CD3DX12AffinityDevice* Device = GetParentDevice();
+
+    ForEachNode([=](UINT i, ID3D12GraphicsCommandList* List)
     {
-        if (((1 << i) & mAffinityMask) != 0)
-        {
-            ID3D12GraphicsCommandList* List = mGraphicsCommandLists[i];
-            
-            List->SetGraphicsRootUnorderedAccessView(RootParameterIndex, GetParentDevice()->GetGPUVirtualAddress(BufferLocation, i));
-        }
-    }
+        List->SetGraphicsRootUnorderedAccessView(RootParameterIndex, Device->GetGPUVirtualAddress(BufferLocation, i));
+    });
 }
 
 void CD3DX12AffinityGraphicsCommandList::IASetVertexBuffers(
@@ -588,23 +905,22 @@ void CD3DX12AffinityGraphicsCommandList::IASetVertexBuffers(
     UINT NumViews,
     const D3D12_VERTEX_BUFFER_VIEW* pViews)
 {
-    mCachedBufferViews.resize(NumViews);
+    CD3DX12AffinityDevice* Device = GetParentDevice();
+    const D3D12_VERTEX_BUFFER_VIEW* Views = Capture(pViews, NumViews);
 
-    for (UINT i = 0; i < D3DX12_MAX_ACTIVE_NODES;i++)
+    ForEachNode([=](UINT i, ID3D12GraphicsCommandList* List)
     {
-        if (((1 << i) & mAffinityMask) != 0)
-        {
-            ID3D12GraphicsCommandList* List = mGraphicsCommandLists[i];
-            
-            for (UINT v = 0; v < NumViews; ++v)
-            {
-                mCachedBufferViews[v] = pViews[v];
-                mCachedBufferViews[v].BufferLocation = GetParentDevice()->GetGPUVirtualAddress(pViews[v].BufferLocation, i);
-            }
+        std::vector<D3D12_VERTEX_BUFFER_VIEW>& CachedBufferViews = mCachedBufferViews[i];
 
-            List->IASetVertexBuffers(StartSlot, NumViews, mCachedBufferViews.data());
+        CachedBufferViews.resize(NumViews);
+        for (UINT v = 0; v < NumViews; ++v)
+        {
+            CachedBufferViews[v] = Views[v];
+            CachedBufferViews[v].BufferLocation = Device->GetGPUVirtualAddress(Views[v].BufferLocation, i);
         }
-    }
+
+        List->IASetVertexBuffers(StartSlot, NumViews, CachedBufferViews.data());
+    });
 }
 
 void CD3DX12AffinityGraphicsCommandList::SOSetTargets(
@@ -612,24 +928,23 @@ void CD3DX12AffinityGraphicsCommandList::SOSetTargets(
     UINT NumViews,
     const D3D12_STREAM_OUTPUT_BUFFER_VIEW* pViews)
 {
-    mCachedStreamOutBufferViews.resize(NumViews);
+    CD3DX12AffinityDevice* Device = GetParentDevice();
+    const D3D12_STREAM_OUTPUT_BUFFER_VIEW* Views = Capture(pViews, NumViews);
 
-    for (UINT i = 0; i < D3DX12_MAX_ACTIVE_NODES;i++)
+    ForEachNode([=](UINT i, ID3D12GraphicsCommandList* List)
     {
-        if (((1 << i) & mAffinityMask) != 0)
-        {
-            ID3D12GraphicsCommandList* List = mGraphicsCommandLists[i];
-            
-            for (UINT v = 0; v < NumViews; ++v)
-            {
-                mCachedStreamOutBufferViews[v] = pViews[v];
-                mCachedStreamOutBufferViews[v].BufferLocation = GetParentDevice()->GetGPUVirtualAddress(pViews[v].BufferLocation, i);
-                mCachedStreamOutBufferViews[v].BufferFilledSizeLocation = GetParentDevice()->GetGPUVirtualAddress(pViews[v].BufferFilledSizeLocation, i);
-            }
+        std::vector<D3D12_STREAM_OUTPUT_BUFFER_VIEW>& CachedStreamOutBufferViews = mCachedStreamOutBufferViews[i];
 
-            List->SOSetTargets(StartSlot, NumViews, mCachedStreamOutBufferViews.data());
+        CachedStreamOutBufferViews.resize(NumViews);
+        for (UINT v = 0; v < NumViews; ++v)
+        {
+            CachedStreamOutBufferViews[v] = Views[v];
+            CachedStreamOutBufferViews[v].BufferLocation = Device->GetGPUVirtualAddress(Views[v].BufferLocation, i);
+            CachedStreamOutBufferViews[v].BufferFilledSizeLocation = Device->GetGPUVirtualAddress(Views[v].BufferFilledSizeLocation, i);
         }
-    }
+
+        List->SOSetTargets(StartSlot, NumViews, CachedStreamOutBufferViews.data());
+    });
 }
 
 void CD3DX12AffinityGraphicsCommandList::OMSetRenderTargets(
@@ -638,29 +953,47 @@ void CD3DX12AffinityGraphicsCommandList::OMSetRenderTargets(
     BOOL RTsSingleHandleToDescriptorRange,
     const D3D12_CPU_DESCRIPTOR_HANDLE* pDepthStencilDescriptor)
 {
-    for (UINT i = 0; i < D3DX12_MAX_ACTIVE_NODES;i++)
+    CD3DX12AffinityDevice* Device = GetParentDevice();
+    bool const HasDepthStencil = pDepthStencilDescriptor != nullptr;
+    D3D12_CPU_DESCRIPTOR_HANDLE const DepthStencilDescriptor = HasDepthStencil ? *pDepthStencilDescriptor : D3D12_CPU_DESCRIPTOR_HANDLE();
+
+    // When recording, the views are staged as one consecutive range per node.
+    CD3DX12AffinityStagingDescriptors::Range const RenderTargets = StageCPUDescriptors(
+        D3D12_DESCRIPTOR_HEAP_TYPE_RTV, pRenderTargetDescriptors, NumRenderTargetDescriptors, RTsSingleHandleToDescriptorRange);
+    CD3DX12AffinityStagingDescriptors::Range const DepthStencil = StageCPUDescriptors(
+        D3D12_DESCRIPTOR_HEAP_TYPE_DSV, pDepthStencilDescriptor, HasDepthStencil ? 1 : 0, FALSE);
+    const D3D12_CPU_DESCRIPTOR_HANDLE* RenderTargetDescriptors =
+        RenderTargets.Count > 0 ? nullptr : Capture(pRenderTargetDescriptors, NumRenderTargetDescriptors);
+
+    ForEachNode([=](UINT i, ID3D12GraphicsCommandList* List)
     {
-        if (((1 << i) & mAffinityMask) != 0)
+        std::vector<D3D12_CPU_DESCRIPTOR_HANDLE>& CachedRenderTargetViews = mCachedRenderTargetViews[i];
+        BOOL SingleHandleToDescriptorRange = RTsSingleHandleToDescriptorRange;
+
+        if (RenderTargets.Count > 0)
         {
-            ID3D12GraphicsCommandList* List = mGraphicsCommandLists[i];
-            
-            mCachedRenderTargetViews.resize(NumRenderTargetDescriptors);
+            CachedRenderTargetViews.assign(1, mStagingDescriptors.GetHandle(RenderTargets, i));
+            SingleHandleToDescriptorRange = TRUE;
+        }
+        else
+        {
+            CachedRenderTargetViews.resize(NumRenderTargetDescriptors);
             for (UINT r = 0; r < NumRenderTargetDescriptors; ++r)
             {
-                mCachedRenderTargetViews[r] = GetParentDevice()->GetCPUHeapPointer(pRenderTargetDescriptors[r], i);
+                CachedRenderTargetViews[r] = Device->GetCPUHeapPointer(RenderTargetDescriptors[r], i);
             }
+        }
 
-            if (pDepthStencilDescriptor)
-            {
-                D3D12_CPU_DESCRIPTOR_HANDLE ActualDepthStencilDescriptor = GetParentDevice()->GetCPUHeapPointer(*pDepthStencilDescriptor, i);
-                List->OMSetRenderTargets(NumRenderTargetDescriptors, mCachedRenderTargetViews.data(), RTsSingleHandleToDescriptorRange, &ActualDepthStencilDescriptor);
-            }
-            else
-            {
-                List->OMSetRenderTargets(NumRenderTargetDescriptors, mCachedRenderTargetViews.data(), RTsSingleHandleToDescriptorRange, nullptr);
-            }
+        if (HasDepthStencil)
+        {
+            D3D12_CPU_DESCRIPTOR_HANDLE ActualDepthStencilDescriptor = GetNodeCPUDescriptor(DepthStencil, DepthStencilDescriptor, i);
+            List->OMSetRenderTargets(NumRenderTargetDescriptors, CachedRenderTargetViews.data(), SingleHandleToDescriptorRange, &ActualDepthStencilDescriptor);
         }
-    }
+        else
+        {
+            List->OMSetRenderTargets(NumRenderTargetDescriptors, CachedRenderTargetViews.data(), SingleHandleToDescriptorRange, nullptr);
+        }
+    });
 }
 
 void CD3DX12AffinityGraphicsCommandList::ClearDepthStencilView(
@@ -671,16 +1004,13 @@ void CD3DX12AffinityGraphicsCommandList::ClearDepthStencilView(
     UINT NumRects,
     const D3D12_RECT* pRects)
 {
-    for (UINT i = 0; i < D3DX12_MAX_ACTIVE_NODES;i++)
-    {
-        if (((1 << i) & mAffinityMask) != 0)
-        {
+    const D3D12_RECT* Rects = Capture(pRects, NumRects);
+    CD3DX12AffinityStagingDescriptors::Range const Staged = StageCPUDescriptors(D3D12_DESCRIPTOR_HEAP_TYPE_DSV, &DepthStencilView, 1, FALSE);
 
-            ID3D12GraphicsCommandList* List = mGraphicsCommandLists[i];
-            
-            List->ClearDepthStencilView(GetParentDevice()->GetCPUHeapPointer(DepthStencilView, i), ClearFlags, Depth, Stencil, NumRects, pRects);
-        }
-    }
+    ForEachNode([=](UINT i, ID3D12GraphicsCommandList* List)
+    {
+        List->ClearDepthStencilView(GetNodeCPUDescriptor(Staged, DepthStencilView, i), ClearFlags, Depth, Stencil, NumRects, Rects);
+    });
 }
 
 void CD3DX12AffinityGraphicsCommandList::ClearRenderTargetView(
@@ -689,20 +1019,19 @@ void CD3DX12AffinityGraphicsCommandList::ClearRenderTargetView(
     UINT NumRects,
     const D3D12_RECT* pRects)
 {
-    for (UINT i = 0; i < D3DX12_MAX_ACTIVE_NODES;i++)
-    {
-        if (((1 << i) & mAffinityMask) != 0)
-        {
-            ID3D12GraphicsCommandList* List = mGraphicsCommandLists[i];
+    const FLOAT* Color = Capture(ColorRGBA, 4);
+    const D3D12_RECT* Rects = Capture(pRects, NumRects);
+    CD3DX12AffinityStagingDescriptors::Range const Staged = StageCPUDescriptors(D3D12_DESCRIPTOR_HEAP_TYPE_RTV, &RenderTargetView, 1, FALSE);
 
+    ForEachNode([=](UINT i, ID3D12GraphicsCommandList* List)
+    {
 #ifdef D3DX12_DEBUG_CLEAR_WHITE
-            FLOAT White[4] = { 1, 1, 1, 1 };
-            List->ClearRenderTargetView(GetParentDevice()->GetCPUHeapPointer(RenderTargetView, i), White, NumRects, pRects);
+        FLOAT White[4] = { 1, 1, 1, 1 };
+        List->ClearRenderTargetView(GetNodeCPUDescriptor(Staged, RenderTargetView, i), White, NumRects, Rects);
 #else
-            List->ClearRenderTargetView(GetParentDevice()->GetCPUHeapPointer(RenderTargetView, i), ColorRGBA, NumRects, pRects);
+        List->ClearRenderTargetView(GetNodeCPUDescriptor(Staged, RenderTargetView, i), Color, NumRects, Rects);
 #endif
-        }
-    }
+    });
 }
 
 void CD3DX12AffinityGraphicsCommandList::ClearUnorderedAccessViewUint(
@@ -713,18 +1042,21 @@ void CD3DX12AffinityGraphicsCommandList::ClearUnorderedAccessViewUint(
     UINT NumRects,
     const D3D12_RECT* pRects)
 {
-    for (UINT i = 0; i < D3DX12_MAX_ACTIVE_NODES;i++)
+    CD3DX12AffinityDevice* Device = GetParentDevice();
+    const UINT* ClearValues = Capture(Values, 4);
+    const D3D12_RECT* Rects = Capture(pRects, NumRects);
+
+    // The view may cover any part of the resource, so treat it all as written.
+    TrackReplicationAccess(pResource, D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES, D3DX12_AFFINITY_REPLICATION_ACCESS_WRITE);
+    CD3DX12AffinityStagingDescriptors::Range const Staged = StageCPUDescriptors(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, &ViewCPUHandle, 1, FALSE);
+
+    ForEachNode([=](UINT i, ID3D12GraphicsCommandList* List)
     {
-        if (((1 << i) & mAffinityMask) != 0)
-        {
-            ID3D12GraphicsCommandList* List = mGraphicsCommandLists[i];
-            
-            List->ClearUnorderedAccessViewUint(
-                GetParentDevice()->GetGPUHeapPointer(ViewGPUHandleInCurrentHeap, i),
-                GetParentDevice()->GetCPUHeapPointer(ViewCPUHandle, i),
-                pResource->mResources[i], Values, NumRects, pRects);
-        }
-    }
+        List->ClearUnorderedAccessViewUint(
+            Device->GetGPUHeapPointer(ViewGPUHandleInCurrentHeap, i),
+            GetNodeCPUDescriptor(Staged, ViewCPUHandle, i),
+            pResource->mResources[i], ClearValues, NumRects, Rects);
+    });
 }
 
 void CD3DX12AffinityGraphicsCommandList::ClearUnorderedAccessViewFloat(
@@ -735,35 +1067,55 @@ void CD3DX12AffinityGraphicsCommandList::ClearUnorderedAccessViewFloat(
     UINT NumRects,
     const D3D12_RECT* pRects)
 {
-    for (UINT i = 0; i < D3DX12_MAX_ACTIVE_NODES;i++)
+    CD3DX12AffinityDevice* Device = GetParentDevice();
+    const FLOAT* ClearValues = Capture(Values, 4);
+    const D3D12_RECT* Rects = Capture(pRects, NumRects);
+
+    // The view may cover any part of the resource, so treat it all as written.
+    TrackReplicationAccess(pResource, D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES, D3DX12_AFFINITY_REPLICATION_ACCESS_WRITE);
+    CD3DX12AffinityStagingDescriptors::Range const Staged = StageCPUDescriptors(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, &ViewCPUHandle, 1, FALSE);
+
+    ForEachNode([=](UINT i, ID3D12GraphicsCommandList* List)
     {
-        if (((1 << i) & mAffinityMask) != 0)
-        {
-            ID3D12GraphicsCommandList* List = mGraphicsCommandLists[i];
-            
-            List->ClearUnorderedAccessViewFloat(
-                GetParentDevice()->GetGPUHeapPointer(ViewGPUHandleInCurrentHeap, i),
-                GetParentDevice()->GetCPUHeapPointer(ViewCPUHandle, i),
-                pResource->mResources[i], Values, NumRects, pRects);
-        }
-    }
+        List->ClearUnorderedAccessViewFloat(
+            Device->GetGPUHeapPointer(ViewGPUHandleInCurrentHeap, i),
+            GetNodeCPUDescriptor(Staged, ViewCPUHandle, i),
+            pResource->mResources[i], ClearValues, NumRects, Rects);
+    });
 }
 
 void CD3DX12AffinityGraphicsCommandList::DiscardResource(
     CD3DX12AffinityResource* pResource,
     const D3D12_DISCARD_REGION* pRegion)
 {
-    for (UINT i = 0; i < D3DX12_MAX_ACTIVE_NODES;i++)
+    // The region holds a pointer of its own, so it is captured member by member.
+    D3D12_DISCARD_REGION Region = {};
+    bool const HasRegion = pRegion != nullptr;
+    if (HasRegion)
     {
-        if (((1 << i) & mAffinityMask) != 0)
+        Region = *pRegion;
+        Region.pRects = Capture(pRegion->pRects, pRegion->NumRects);
+    }
+
+    // Discarding whole subresources tells replication that their contents will be replaced.
+    if (!HasRegion)
+    {
+        TrackReplicationAccess(pResource, D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES, D3DX12_AFFINITY_REPLICATION_ACCESS_OVERWRITE);
+    }
+    else if (pRegion->NumRects == 0)
+    {
+        for (UINT s = 0; s < pRegion->NumSubresources; ++s)
         {
-            ID3D12GraphicsCommandList* List = mGraphicsCommandLists[i];
-            
-            List->DiscardResource(
-                pResource->mResources[i],
-                pRegion);
+            TrackReplicationAccess(pResource, pRegion->FirstSubresource + s, D3DX12_AFFINITY_REPLICATION_ACCESS_OVERWRITE);
         }
     }
+
+    ForEachNode([=](UINT i, ID3D12GraphicsCommandList* List)
+    {
+        List->DiscardResource(
+            pResource->mResources[i],
+            HasRegion ? &Region : nullptr);
+    });
 }
 
 void CD3DX12AffinityGraphicsCommandList::BeginQuery(
@@ -771,19 +1123,15 @@ void CD3DX12AffinityGraphicsCommandList::BeginQuery(
     D3D12_QUERY_TYPE Type,
     UINT Index)
 {
-    for (UINT i = 0; i < D3DX12_MAX_ACTIVE_NODES;i++)
+    ForEachNode([=](UINT i, ID3D12GraphicsCommandList* List)
     {
-        if (((1 << i) & mAffinityMask) != 0)
-        {
-            ID3D12GraphicsCommandList* List = mGraphicsCommandLists[i];
-            ID3D12QueryHeap* QueryHeap = pQueryHeap->mQueryHeaps[i];
+        ID3D12QueryHeap* QueryHeap = pQueryHeap->mQueryHeaps[i];
 
-            List->BeginQuery(
-                QueryHeap,
-                Type,
-                Index);
-        }
-    }
+        List->BeginQuery(
+            QueryHeap,
+            Type,
+            Index);
+    });
 }
 
 void CD3DX12AffinityGraphicsCommandList::EndQuery(
@@ -791,19 +1139,15 @@ void CD3DX12AffinityGraphicsCommandList::EndQuery(
     D3D12_QUERY_TYPE Type,
     UINT Index)
 {
-    for (UINT i = 0; i < D3DX12_MAX_ACTIVE_NODES;i++)
+    ForEachNode([=](UINT i, ID3D12GraphicsCommandList* List)
     {
-        if (((1 << i) & mAffinityMask) != 0)
-        {
-            ID3D12GraphicsCommandList* List = mGraphicsCommandLists[i];
-            ID3D12QueryHeap* QueryHeap = pQueryHeap->mQueryHeaps[i];
+        ID3D12QueryHeap* QueryHeap = pQueryHeap->mQueryHeaps[i];
 
-            List->EndQuery(
-                QueryHeap,
-                Type,
-                Index);
-        }
-    }
+        List->EndQuery(
+            QueryHeap,
+            Type,
+            Index);
+    });
 }
 
 void CD3DX12AffinityGraphicsCommandList::ResolveQueryData(
@@ -814,23 +1158,19 @@ void CD3DX12AffinityGraphicsCommandList::ResolveQueryData(
     CD3DX12AffinityResource* pDestinationBuffer,
     UINT64 AlignedDestinationBufferOffset)
 {
-    for (UINT i = 0; i < D3DX12_MAX_ACTIVE_NODES;i++)
+    ForEachNode([=](UINT i, ID3D12GraphicsCommandList* List)
     {
-        if (((1 << i) & mAffinityMask) != 0)
-        {
-            ID3D12GraphicsCommandList* List = mGraphicsCommandLists[i];
-            ID3D12QueryHeap* QueryHeap = pQueryHeap->mQueryHeaps[i];
-            ID3D12Resource* DestinationBuffer = pDestinationBuffer->mResources[i];
-
-            List->ResolveQueryData(
-                QueryHeap,
-                Type,
-                StartIndex,
-                NumQueries,
-                DestinationBuffer,
-                AlignedDestinationBufferOffset);
-        }
-    }
+        ID3D12QueryHeap* QueryHeap = pQueryHeap->mQueryHeaps[i];
+        ID3D12Resource* DestinationBuffer = pDestinationBuffer->mResources[i];
+
+        List->ResolveQueryData(
+            QueryHeap,
+            Type,
+            StartIndex,
+            NumQueries,
+            DestinationBuffer,
+            AlignedDestinationBufferOffset);
+    });
 }
 
 void CD3DX12AffinityGraphicsCommandList::SetPredication(
@@ -838,18 +1178,13 @@ void CD3DX12AffinityGraphicsCommandList::SetPredication(
     UINT64 AlignedBufferOffset,
     D3D12_PREDICATION_OP Operation)
 {
-    for (UINT i = 0; i < D3DX12_MAX_ACTIVE_NODES;i++)
+    ForEachNode([=](UINT i, ID3D12GraphicsCommandList* List)
     {
-        if (((1 << i) & mAffinityMask) != 0)
-        {
-            ID3D12GraphicsCommandList* List = mGraphicsCommandLists[i];
-            
-            List->SetPredication(
-                pBuffer->mResources[i],
-                AlignedBufferOffset,
-                Operation);
-        }
-    }
+        List->SetPredication(
+            pBuffer->mResources[i],
+            AlignedBufferOffset,
+            Operation);
+    });
 }
 
 void CD3DX12AffinityGraphicsCommandList::SetMarker(
@@ -857,18 +1192,15 @@ void CD3DX12AffinityGraphicsCommandList::SetMarker(
     const void* pData,
     UINT Size)
 {
-    for (UINT i = 0; i < D3DX12_MAX_ACTIVE_NODES;i++)
-    {
-        if (((1 << i) & mAffinityMask) != 0)
-        {
-            ID3D12GraphicsCommandList* List = mGraphicsCommandLists[i];
+    const BYTE* Data = Capture(static_cast<const BYTE*>(pData), Size);
 
-            List->SetMarker(
-                Metadata,
-                pData,
-                Size);
-        }
-    }
+    ForEachNode([=](UINT, ID3D12GraphicsCommandList* List)
+    {
+        List->SetMarker(
+            Metadata,
+            Data,
+            Size);
+    });
 }
 
 void CD3DX12AffinityGraphicsCommandList::BeginEvent(
@@ -876,31 +1208,23 @@ void CD3DX12AffinityGraphicsCommandList::BeginEvent(
     const void* pData,
     UINT Size)
 {
-    for (UINT i = 0; i < D3DX12_MAX_ACTIVE_NODES;i++)
-    {
-        if (((1 << i) & mAffinityMask) != 0)
-        {
-            ID3D12GraphicsCommandList* List = mGraphicsCommandLists[i];
+    const BYTE* Data = Capture(static_cast<const BYTE*>(pData), Size);
 
-            List->BeginEvent(
-                Metadata,
-                pData,
-                Size);
-        }
-    }
+    ForEachNode([=](UINT, ID3D12GraphicsCommandList* List)
+    {
+        List->BeginEvent(
+            Metadata,
+            Data,
+            Size);
+    });
 }
 
 void CD3DX12AffinityGraphicsCommandList::EndEvent(void)
 {
-    for (UINT i = 0; i < D3DX12_MAX_ACTIVE_NODES;i++)
+    ForEachNode([](UINT, ID3D12GraphicsCommandList* List)
     {
-        if (((1 << i) & mAffinityMask) != 0)
-        {
-            ID3D12GraphicsCommandList* List = mGraphicsCommandLists[i];
-
-            List->EndEvent();
-        }
-    }
+        List->EndEvent();
+    });
 }
 
 void CD3DX12AffinityGraphicsCommandList::ExecuteIndirect(
@@ -911,25 +1235,21 @@ void CD3DX12AffinityGraphicsCommandList::ExecuteIndirect(
     CD3DX12AffinityResource* pCountBuffer,
     UINT64 CountBufferOffset)
 {
-    for (UINT i = 0; i < D3DX12_MAX_ACTIVE_NODES;i++)
+    ForEachNode([=](UINT i, ID3D12GraphicsCommandList* List)
     {
-        if (((1 << i) & mAffinityMask) != 0)
-        {
-            ID3D12GraphicsCommandList* List = mGraphicsCommandLists[i];
-            
-            List->ExecuteIndirect(
-                pCommandSignature->GetChildObject(i),
-                MaxCommandCount,
-                pArgumentBuffer->mResources[i], ArgumentBufferOffset,
-                pCountBuffer ? pCountBuffer->mResources[i] : nullptr, CountBufferOffset);
-        }
-    }
+        List->ExecuteIndirect(
+            pCommandSignature->GetChildObject(i),
+            MaxCommandCount,
+            pArgumentBuffer->mResources[i], ArgumentBufferOffset,
+            pCountBuffer ? pCountBuffer->mResources[i] : nullptr, CountBufferOffset);
+    });
 }
 
 CD3DX12AffinityGraphicsCommandList::CD3DX12AffinityGraphicsCommandList(CD3DX12AffinityDevice* device, ID3D12GraphicsCommandList** graphicsCommandLists, UINT Count, bool UseDeviceActiveMaskOnReset)
     : CD3DX12AffinityCommandList(device, reinterpret_cast<ID3D12CommandList**>(graphicsCommandLists), Count)
     , mUseDeviceActiveMaskOnReset(UseDeviceActiveMaskOnReset)
     , mAccumulatedAffinityMask(0)
+    , mRecording(false)
 {
     for (UINT i = 0; i < D3DX12_MAX_ACTIVE_NODES; i++)
     {
@@ -954,6 +1274,11 @@ CD3DX12AffinityGraphicsCommandList::CD3DX12AffinityGraphicsCommandList(CD3DX12Af
     {
         mAccumulatedAffinityMask = GetNodeMask();
     }
+
+    // Command lists are created open, so recording starts straight away.
+#if D3DX12_REPLAY_COMMAND_LISTS
+    mRecording = GetNodeCount() > 1;
+#endif
 }
 
 void CD3DX12AffinityGraphicsCommandList::SetPipelineState(
@@ -961,75 +1286,61 @@ void CD3DX12AffinityGraphicsCommandList::SetPipelineState(
 {
     CD3DX12AffinityPipelineState* PipelineState = static_cast<CD3DX12AffinityPipelineState*>(pPipelineState);
 
-    for (UINT i = 0; i < D3DX12_MAX_ACTIVE_NODES;i++)
+    ForEachNode([=](UINT i, ID3D12GraphicsCommandList* List)
     {
-        if (((1 << i) & mAffinityMask) != 0)
-        {
-            ID3D12GraphicsCommandList* List = mGraphicsCommandLists[i];
-            
-            List->SetPipelineState(PipelineState->mPipelineStates[i]);
-        }
-    }
+        List->SetPipelineState(PipelineState->mPipelineStates[i]);
+    });
 }
 
 void CD3DX12AffinityGraphicsCommandList::SetComputeRootDescriptorTable(
     UINT RootParameterIndex,
     D3D12_GPU_DESCRIPTOR_HANDLE BaseDescriptor)
 {
-    for (UINT i = 0; i < D3DX12_MAX_ACTIVE_NODES;i++)
+    CD3DX12AffinityDevice* Device = GetParentDevice();
+
+    ForEachNode([=](UINT i, ID3D12GraphicsCommandList* List)
     {
-        if (((1 << i) & mAffinityMask) != 0)
-        {
-            ID3D12GraphicsCommandList* List = mGraphicsCommandLists[i];
-            
-            List->SetComputeRootDescriptorTable(RootParameterIndex, GetParentDevice()->GetGPUHeapPointer(BaseDescriptor, i));
-        }
-    }
+        List->SetComputeRootDescriptorTable(RootParameterIndex, Device->GetGPUHeapPointer(BaseDescriptor, i));
+    });
 }
 
 void CD3DX12AffinityGraphicsCommandList::SetGraphicsRootDescriptorTable(
     UINT RootParameterIndex,
     D3D12_GPU_DESCRIPTOR_HANDLE BaseDescriptor)
 {
-    for (UINT i = 0; i < D3DX12_MAX_ACTIVE_NODES;i++)
+    CD3DX12AffinityDevice* Device = GetParentDevice();
+
+    ForEachNode([=](UINT i, ID3D12GraphicsCommandList* List)
     {
-        if (((1 << i) & mAffinityMask) != 0)
-        {
-            mGraphicsCommandLists[i]->SetGraphicsRootDescriptorTable(
-                RootParameterIndex,
-                GetParentDevice()->GetGPUHeapPointer(BaseDescriptor, i));
-        }
-    }
+        List->SetGraphicsRootDescriptorTable(
+            RootParameterIndex,
+            Device->GetGPUHeapPointer(BaseDescriptor, i));
+    });
 }
 
 void CD3DX12AffinityGraphicsCommandList::IASetIndexBuffer(
     const D3D12_INDEX_BUFFER_VIEW* pView)
 {
+    CD3DX12AffinityDevice* Device = GetParentDevice();
+
     if (pView)
     {
-        D3D12_INDEX_BUFFER_VIEW View = *pView;
+        D3D12_INDEX_BUFFER_VIEW const View = *pView;
 
-        for (UINT i = 0; i < D3DX12_MAX_ACTIVE_NODES;i++)
+        ForEachNode([=](UINT i, ID3D12GraphicsCommandList* List)
         {
-            if (((1 << i) & mAffinityMask) != 0)
-            {
-                ID3D12GraphicsCommandList* List = mGraphicsCommandLists[i];
-                
-                View.BufferLocation = GetParentDevice()->GetGPUVirtualAddress(pView->BufferLocation, i);
-                List->IASetIndexBuffer(&View);
-            }
-        }
+            D3D12_INDEX_BUFFER_VIEW NodeView = View;
+
+            NodeView.BufferLocation = Device->GetGPUVirtualAddress(View.BufferLocation, i);
+            List->IASetIndexBuffer(&NodeView);
+        });
     }
     else
     {
-        for (UINT i = 0; i < D3DX12_MAX_ACTIVE_NODES;i++)
+        ForEachNode([](UINT, ID3D12GraphicsCommandList* List)
         {
-            if (((1 << i) & mAffinityMask) != 0)
-            {
-                ID3D12GraphicsCommandList* List = mGraphicsCommandLists[i];
-                List->IASetIndexBuffer(nullptr);
-            }
-        }
+            List->IASetIndexBuffer(nullptr);
+        });
     }
 }
 
@@ -1040,13 +1351,10 @@ void CD3DX12AffinityGraphicsCommandList::DrawIndexedInstanced(
     INT BaseVertexLocation,
     UINT StartInstanceLocation)
 {
-    for (UINT i = 0; i < D3DX12_MAX_ACTIVE_NODES;i++)
+    ForEachNode([=](UINT, ID3D12GraphicsCommandList* List)
     {
-        if (((1 << i) & mAffinityMask) != 0)
-        {
-            mGraphicsCommandLists[i]->DrawIndexedInstanced(IndexCountPerInstance, InstanceCount, StartIndexLocation, BaseVertexLocation, StartInstanceLocation);
-        }
-    }
+        List->DrawIndexedInstanced(IndexCountPerInstance, InstanceCount, StartIndexLocation, BaseVertexLocation, StartInstanceLocation);
+    });
 }
 
 void CD3DX12AffinityGraphicsCommandList::BroadcastResource(CD3DX12AffinityResource* pResource, UINT NodeIndex, UINT TargetNodeMask)
@@ -1055,23 +1363,34 @@ void CD3DX12AffinityGraphicsCommandList::BroadcastResource(CD3DX12AffinityResour
     DEBUG_ASSERT(mAffinityMask == (1 << NodeIndex));
 
     // Copy is a push operation on the Source node commandlist to a target resource
-    for (UINT i = 0; i < D3DX12_MAX_ACTIVE_NODES;i++)
+    ForEachNode([=](UINT SourceNode, ID3D12GraphicsCommandList* List)
     {
-        if (((1 << i) & TargetNodeMask) != 0)
+        for (UINT i = 0; i < D3DX12_MAX_ACTIVE_NODES;i++)
         {
-            if (NodeIndex != i)
+            if (((1 << i) & TargetNodeMask) != 0)
             {
-                mGraphicsCommandLists[NodeIndex]->CopyResource(
-                    pResource->GetChildObject(i),
-                    pResource->GetChildObject(NodeIndex)
-                    );
+                if (SourceNode != i)
+                {
+                    List->CopyResource(
+                        pResource->GetChildObject(i),
+                        pResource->GetChildObject(SourceNode)
+                        );
+                }
             }
         }
-    }
+    });
 }
 
 ID3D12GraphicsCommandList* CD3DX12AffinityGraphicsCommandList::GetChildObject(UINT AffinityIndex)
 {
+#if D3DX12_REPLAY_COMMAND_LISTS
+    // Anything recorded directly on a child list must land after what has been
+    // recorded through the affinity list so far.
+    if (mRecording && mCommandStream.GetCommandCount() > 0)
+    {
+        ReplayCommandStream();
+    }
+#endif
     return mGraphicsCommandLists[AffinityIndex];
 }
 
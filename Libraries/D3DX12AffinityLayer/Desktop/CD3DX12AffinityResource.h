@@ -14,6 +14,53 @@
 #include "Utils.h"
 #include "CD3DX12AffinityPageable.h"
 
+// How a command list touches a replicated subresource.
+enum D3DX12_AFFINITY_REPLICATION_ACCESS_TYPE
+{
+    D3DX12_AFFINITY_REPLICATION_ACCESS_READ,
+    D3DX12_AFFINITY_REPLICATION_ACCESS_WRITE,       // May leave parts of the subresource untouched.
+    D3DX12_AFFINITY_REPLICATION_ACCESS_OVERWRITE,   // Replaces the whole subresource.
+};
+
+// One access to a replicated resource, recorded by a command list and applied to
+// the resource's replication state when the list is executed.
+struct D3DX12_AFFINITY_REPLICATION_ACCESS
+{
+    CD3DX12AffinityResource* pResource;
+    UINT Subresource;
+    UINT NodeMask;
+    D3DX12_AFFINITY_REPLICATION_ACCESS_TYPE Type;
+    bool HasRegion;
+    D3D12_BOX Region;
+};
+
+// A copy of a stale region from the node that owns a subresource.
+struct D3DX12_AFFINITY_REPLICATION_COPY
+{
+    CD3DX12AffinityResource* pResource;
+    UINT Subresource;
+    UINT SourceNode;
+    D3D12_BOX Region;
+};
+
+// The replication work gathered for one ExecuteCommandLists call.
+struct D3DX12_AFFINITY_REPLICATION_BATCH
+{
+    // Fences the submitting queue signals on each node once the batch is done, and
+    // the values it will signal.
+    ID3D12Fence* pNodeFences[D3DX12_MAX_ACTIVE_NODES];
+    UINT64 NodeFenceValues[D3DX12_MAX_ACTIVE_NODES];
+
+    // Fence and value that each node's copies will signal, if it has any.
+    ID3D12Fence* pCopyFences[D3DX12_MAX_ACTIVE_NODES];
+    UINT64 CopyFenceValues[D3DX12_MAX_ACTIVE_NODES];
+
+    std::vector<D3DX12_AFFINITY_REPLICATION_COPY> Copies[D3DX12_MAX_ACTIVE_NODES];
+    std::vector<std::pair<ID3D12Fence*, UINT64>> CopyWaits[D3DX12_MAX_ACTIVE_NODES];
+    std::vector<std::pair<ID3D12Fence*, UINT64>> QueueWaits[D3DX12_MAX_ACTIVE_NODES];
+    UINT TouchedNodeMask;
+};
+
 class __declspec(uuid("BE1D71C8-88FD-4623-ABFA-D0E546D12FAF")) CD3DX12AffinityResource : public CD3DX12AffinityPageable
 {
 public:
@@ -56,6 +103,25 @@ public:
     ID3D12Resource* GetChildObject(UINT AffinityIndex);
     void SynchronizeAcrossDevices();
 
+    // Resources whose node copies the layer keeps coherent by itself.
+    static bool IsReplicationCandidate(CD3DX12AffinityDevice* pDevice, D3D12_RESOURCE_DESC const& Desc);
+    bool IsReplicated() const { return !mReplication.empty(); }
+
+    // Applies an access made by the nodes in NodeMask, adding any copies those
+    // nodes need before it to the batch.
+    void TrackReplicationAccess(
+        D3DX12_AFFINITY_REPLICATION_ACCESS const& Access,
+        UINT NodeMask,
+        D3DX12_AFFINITY_REPLICATION_BATCH& Batch);
+
+    // Whether the access would need a copy of a write made earlier in the batch. The
+    // owner's fence is only signaled once the batch has executed, so such an access
+    // has to go into the next batch.
+    bool ReadsPendingWrite(
+        D3DX12_AFFINITY_REPLICATION_ACCESS const& Access,
+        UINT NodeMask,
+        D3DX12_AFFINITY_REPLICATION_BATCH const& Batch) const;
+
     static void UpdatePersistentMaps(CD3DX12AffinityDevice* pDevice);
 
 
@@ -70,4 +136,23 @@ public:
 
     ID3D12CommandList* mSyncCommandLists[D3DX12_MAX_ACTIVE_NODES];
     ID3D12CommandAllocator* mSyncCommandAllocators[D3DX12_MAX_ACTIVE_NODES];
+
+private:
+    struct SubresourceReplication
+    {
+        UINT ValidNodeMask;                         // Nodes whose copy is current.
+        UINT OwnerNode;                             // The node that wrote last.
+        ID3D12Fence* pWriteFence;                   // Reaches WriteFenceValue once that write is done.
+        UINT64 WriteFenceValue;
+        ID3D12Fence* pCopyFences[D3DX12_MAX_ACTIVE_NODES];  // Reaches CopyFenceValues[i] once node i's last copy out of it is done.
+        UINT64 CopyFenceValues[D3DX12_MAX_ACTIVE_NODES];
+        D3D12_BOX StaleRegions[D3DX12_MAX_ACTIVE_NODES];
+    };
+
+    void PullSubresource(UINT Subresource, UINT NodeIndex, D3DX12_AFFINITY_REPLICATION_BATCH& Batch);
+    void GetSubresourceRange(UINT Subresource, UINT& FirstSubresource, UINT& NumSubresources) const;
+    D3D12_BOX GetSubresourceBox(UINT Subresource) const;
+
+    std::vector<SubresourceReplication> mReplication;
+    D3D12_RESOURCE_DESC mReplicationDesc;
 };
@@ -59,7 +59,8 @@ HRESULT STDMETHODCALLTYPE CDXGIAffinitySwapChain::Present(
     }
     case EAffinitySwapChainMode::SingleWindow:
     {
-        UINT const i = 0;
+        // The frame is presented from the node it was rendered on.
+        UINT const i = GetActiveNodeIndex() < mDeviceContexts.size() ? GetActiveNodeIndex() : 0;
         DebugLog(L"Presenting contents of backbuffer %d on device %d", mCurrentBackBufferIndex, i);
 
         DebugLog(L" [marshalled]\n");
@@ -98,6 +99,10 @@ HRESULT STDMETHODCALLTYPE CDXGIAffinitySwapChain::Present(
         mDeviceContexts[0].mDisplayCommandQueue->ExecuteCommandLists(_countof(ppCommandLists2), ppCommandLists2);
         mDeviceContexts[0].mDisplayCommandQueue->Signal(Context.mCrossAdapterCopyFenceOnHost, ++Context.mFenceValue);
 
+        SPresentedFrame const Frame = { i, Context.mFenceValue };
+        mPresentQueue.push_back(Frame);
+        mLastRenderNode = i;
+
         mDeviceContexts[0].mDisplayCommandList->Reset(mDeviceContexts[0].mDisplayCommandAllocator, nullptr);
 
         hr = mSwapChains[0]->Present(SyncInterval, Flags);
@@ -771,6 +776,56 @@ UINT CDXGIAffinitySwapChain::GetCurrentBackBufferIndex()
     return mCurrentBackBufferIndex;
 }
 
+UINT CDXGIAffinitySwapChain::GetNextRenderNode()
+{
+    switch (mMode)
+    {
+    case EAffinitySwapChainMode::LDA:
+        return mCurrentBackBufferIndex % GetNodeCount();
+
+    case EAffinitySwapChainMode::SingleWindow:
+    {
+        UINT const NodeCount = static_cast<UINT>(mDeviceContexts.size());
+        if (NodeCount <= 1)
+        {
+            return 0;
+        }
+
+        // Retire the frames that have reached the host. A slow node's frame can still be
+        // in flight after later frames from a faster node have finished.
+        UINT FramesInFlight[D3DX12_MAX_ACTIVE_NODES] = {};
+        for (size_t f = 0; f < mPresentQueue.size();)
+        {
+            SPresentedFrame const& Frame = mPresentQueue[f];
+            if (mDeviceContexts[Frame.mNode].mCrossAdapterCopyFence->GetCompletedValue() >= Frame.mFenceValue)
+            {
+                mPresentQueue.erase(mPresentQueue.begin() + f);
+            }
+            else
+            {
+                ++FramesInFlight[Frame.mNode];
+                ++f;
+            }
+        }
+
+        // Start the search after the last node so that nodes which keep up alternate.
+        UINT BestNode = (mLastRenderNode + 1) % NodeCount;
+        for (UINT n = 1; n < NodeCount; ++n)
+        {
+            UINT const Node = (mLastRenderNode + 1 + n) % NodeCount;
+            if (FramesInFlight[Node] < FramesInFlight[BestNode])
+            {
+                BestNode = Node;
+            }
+        }
+        return BestNode;
+    }
+
+    default:
+        return (GetActiveNodeIndex() + 1) % GetNodeCount();
+    }
+}
+
 HRESULT STDMETHODCALLTYPE CDXGIAffinitySwapChain::CheckColorSpaceSupport(
     DXGI_COLOR_SPACE_TYPE ColorSpace,
     UINT* pColorSpaceSupport,
@@ -831,6 +886,7 @@ HRESULT STDMETHODCALLTYPE CDXGIAffinitySwapChain::ResizeBuffers1(
 
 CDXGIAffinitySwapChain::CDXGIAffinitySwapChain(CD3DX12AffinityDevice* device, CD3DX12AffinityCommandQueue* queue, IDXGISwapChain3** swapChains, UINT Count)
     : CD3DX12AffinityObject(device, reinterpret_cast<IUnknown**>(swapChains), Count)
+    , mLastRenderNode(0)
     , mCurrentBackBufferIndex(0)
 {
     for (UINT i = 0; i < D3DX12_MAX_ACTIVE_NODES; i++)
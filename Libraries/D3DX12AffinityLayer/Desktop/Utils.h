@@ -55,6 +55,23 @@
 
 //#define ALWAYS_RESET_ALL_COMMAND_LISTS 1
 
+// Records each graphics command list once into a compact command stream and
+// replays it onto every node's list at Close, one thread per node, instead of
+// forwarding every call to every node as it is made. Only used when more than
+// one node is present.
+#define D3DX12_REPLAY_COMMAND_LISTS 1
+
+// Keeps the per-node copies of textures created with
+// D3D12_RESOURCE_FLAG_ALLOW_SIMULTANEOUS_ACCESS coherent on LDA devices. Writes
+// are tracked per subresource, and a node that reads a subresource another node
+// wrote pulls just the stale region over on its copy queue, as part of the
+// ExecuteCommandLists that needs it.
+#define D3DX12_REPLICATE_SIMULTANEOUS_ACCESS_RESOURCES 1
+
+// Streams with fewer commands than this are replayed on the closing thread,
+// where handing them to another thread would cost more than it saves.
+#define D3DX12_REPLAY_PARALLEL_THRESHOLD 64
+
 ////////////////////////////
 // DEBUG CONFIG ////////////
 ////////////////////////////
@@ -76,6 +93,9 @@
 #include <map>
 #include <set>
 #include <mutex>
+#include <future>
+#include <memory>
+#include <type_traits>
 #include <cstdio>
 
 struct EAffinityMask
@@ -16,6 +16,126 @@
 #include "CD3DX12AffinityQueryHeap.h"
 #include "CD3DX12AffinityDevice.h"
 
+// A compact, append-only stream of recorded commands. Each command is a small
+// functor that performs the per-node translation and the call itself; the
+// functors and any caller data they point at live in a block arena that is
+// reused across Reset, so recording does not allocate in steady state.
+class CD3DX12AffinityCommandStream
+{
+public:
+    typedef void (*ReplayFunction)(const void* pCommand, UINT NodeIndex, ID3D12GraphicsCommandList* pList);
+
+    template <typename TCommand>
+    void Record(UINT AffinityMask, TCommand const& Command)
+    {
+        static_assert(std::is_trivially_destructible<TCommand>::value, "Recorded commands are never destroyed.");
+
+        void* pStorage = Allocate(sizeof(TCommand), alignof(TCommand));
+        new (pStorage) TCommand(Command);
+
+        Entry NewEntry = { &ReplayCommand<TCommand>, pStorage, AffinityMask };
+        mEntries.push_back(NewEntry);
+        mNodeMask |= AffinityMask;
+    }
+
+    // Copies an array the caller owns into the stream so that a recorded
+    // command can still read it at replay time.
+    template <typename T>
+    const T* Copy(const T* pData, UINT Count)
+    {
+        T* pCopy = static_cast<T*>(Allocate(sizeof(T) * Count, alignof(T)));
+        memcpy(pCopy, pData, sizeof(T) * Count);
+        return pCopy;
+    }
+
+    void Replay(UINT NodeIndex, ID3D12GraphicsCommandList* pList) const;
+    void Clear();
+
+    UINT GetNodeMask() const { return mNodeMask; }
+    size_t GetCommandCount() const { return mEntries.size(); }
+
+    CD3DX12AffinityCommandStream();
+
+private:
+    template <typename TCommand>
+    static void ReplayCommand(const void* pCommand, UINT NodeIndex, ID3D12GraphicsCommandList* pList)
+    {
+        (*static_cast<const TCommand*>(pCommand))(NodeIndex, pList);
+    }
+
+    void* Allocate(size_t Size, size_t Alignment);
+
+    struct Entry
+    {
+        ReplayFunction Replay;
+        const void* pCommand;
+        UINT AffinityMask;
+    };
+
+    struct Block
+    {
+        std::unique_ptr<BYTE[]> Data;
+        size_t Size;
+    };
+
+    static const size_t BlockSize = 64 * 1024;
+
+    std::vector<Entry> mEntries;
+    std::vector<Block> mBlocks;
+    size_t mBlockIndex;
+    size_t mBlockOffset;
+    UINT mNodeMask;
+};
+
+// Copies of the CPU descriptors read by recorded commands. D3D12 reads the CPU
+// descriptors passed to OMSetRenderTargets and the Clear*View calls when the
+// call is made, and the application may overwrite them straight afterwards, so
+// a command replayed at Close reads copies taken when it was recorded. Every
+// node has its own non shader-visible heaps, and the copies are reused across
+// Reset.
+class CD3DX12AffinityStagingDescriptors
+{
+public:
+    struct Range
+    {
+        D3D12_DESCRIPTOR_HEAP_TYPE Type;
+        UINT Page;
+        UINT Offset;
+        UINT Count;     // Zero when nothing was staged.
+    };
+
+    // Copies Count affinity descriptors to consecutive staging slots on every
+    // node in NodeMask.
+    Range Stage(
+        CD3DX12AffinityDevice* Device,
+        D3D12_DESCRIPTOR_HEAP_TYPE Type,
+        const D3D12_CPU_DESCRIPTOR_HANDLE* pDescriptors,
+        UINT Count,
+        UINT NodeMask);
+
+    D3D12_CPU_DESCRIPTOR_HANDLE GetHandle(Range const& Staged, UINT NodeIndex) const;
+    void Clear();
+
+    CD3DX12AffinityStagingDescriptors();
+    ~CD3DX12AffinityStagingDescriptors();
+
+private:
+    bool AddPage(CD3DX12AffinityDevice* Device, D3D12_DESCRIPTOR_HEAP_TYPE Type);
+
+    struct Page
+    {
+        ID3D12DescriptorHeap* Heaps[D3DX12_MAX_ACTIVE_NODES];
+        D3D12_CPU_DESCRIPTOR_HANDLE Starts[D3DX12_MAX_ACTIVE_NODES];
+    };
+
+    static const UINT PageSize = 256;
+
+    std::vector<Page> mPages[D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES];
+    UINT mIncrements[D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES][D3DX12_MAX_ACTIVE_NODES];
+    UINT mPageIndex[D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES];
+    UINT mPageOffset[D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES];
+};
+
 class __declspec(uuid("BE1D71C8-88FD-4623-ABFA-D0E546D12FAF")) CD3DX12AffinityGraphicsCommandList : public CD3DX12AffinityCommandList
 {
 public:
@@ -279,13 +399,79 @@ public:
     ID3D12GraphicsCommandList* GetChildObject(UINT AffinityIndex);
     UINT GetActiveAffinityMask();
 
+    // Accesses to replicated resources recorded since the last Reset.
+    std::vector<D3DX12_AFFINITY_REPLICATION_ACCESS> const& GetReplicationAccesses() const { return mReplicationAccesses; }
+
 private:
+    // Runs Command(NodeIndex, List) for every node in the affinity mask, or records
+    // it once for all of them when the list is being recorded for replay.
+    template <typename TCommand>
+    void ForEachNode(TCommand const& Command)
+    {
+#if D3DX12_REPLAY_COMMAND_LISTS
+        if (mRecording)
+        {
+            mCommandStream.Record(mAffinityMask, Command);
+            return;
+        }
+#endif
+        for (UINT i = 0; i < D3DX12_MAX_ACTIVE_NODES;i++)
+        {
+            if (((1 << i) & mAffinityMask) != 0)
+            {
+                Command(i, mGraphicsCommandLists[i]);
+            }
+        }
+    }
+
+    // Returns a pointer to the caller's data that stays valid until the command is
+    // replayed. Only copies when recording.
+    template <typename T>
+    const T* Capture(const T* pData, UINT Count)
+    {
+#if D3DX12_REPLAY_COMMAND_LISTS
+        if (mRecording && pData && Count > 0)
+        {
+            return mCommandStream.Copy(pData, Count);
+        }
+#endif
+        return pData;
+    }
+
+    // Copies the CPU descriptors a command reads when it is recorded for replay.
+    // Returns an empty range, and leaves the command to translate the
+    // application's descriptors itself, when the call is forwarded straight away.
+    CD3DX12AffinityStagingDescriptors::Range StageCPUDescriptors(
+        D3D12_DESCRIPTOR_HEAP_TYPE Type,
+        const D3D12_CPU_DESCRIPTOR_HANDLE* pDescriptors,
+        UINT Count,
+        BOOL SingleHandleToDescriptorRange);
+
+    D3D12_CPU_DESCRIPTOR_HANDLE GetNodeCPUDescriptor(
+        CD3DX12AffinityStagingDescriptors::Range const& Staged,
+        D3D12_CPU_DESCRIPTOR_HANDLE Original,
+        UINT NodeIndex);
+
+    void ReplayCommandStream();
+
+    void TrackReplicationAccess(
+        CD3DX12AffinityResource* pResource,
+        UINT Subresource,
+        D3DX12_AFFINITY_REPLICATION_ACCESS_TYPE Type,
+        const D3D12_BOX* pRegion = nullptr);
+
     ID3D12GraphicsCommandList* mGraphicsCommandLists[D3DX12_MAX_ACTIVE_NODES];
     UINT mAccumulatedAffinityMask;
     bool mUseDeviceActiveMaskOnReset;
-    std::vector<D3D12_RESOURCE_BARRIER> mCachedResourceBarriers;
-    std::vector<ID3D12DescriptorHeap*> mCachedDescriptorHeaps;
-    std::vector<D3D12_VERTEX_BUFFER_VIEW> mCachedBufferViews;
-    std::vector<D3D12_STREAM_OUTPUT_BUFFER_VIEW> mCachedStreamOutBufferViews;
-    std::vector<D3D12_CPU_DESCRIPTOR_HANDLE> mCachedRenderTargetViews;
+    bool mRecording;
+    CD3DX12AffinityCommandStream mCommandStream;
+    CD3DX12AffinityStagingDescriptors mStagingDescriptors;
+    std::vector<D3DX12_AFFINITY_REPLICATION_ACCESS> mReplicationAccesses;
+
+    // Translation scratch space, one per node so that nodes can be replayed in parallel.
+    std::vector<D3D12_RESOURCE_BARRIER> mCachedResourceBarriers[D3DX12_MAX_ACTIVE_NODES];
+    std::vector<ID3D12DescriptorHeap*> mCachedDescriptorHeaps[D3DX12_MAX_ACTIVE_NODES];
+    std::vector<D3D12_VERTEX_BUFFER_VIEW> mCachedBufferViews[D3DX12_MAX_ACTIVE_NODES];
+    std::vector<D3D12_STREAM_OUTPUT_BUFFER_VIEW> mCachedStreamOutBufferViews[D3DX12_MAX_ACTIVE_NODES];
+    std::vector<D3D12_CPU_DESCRIPTOR_HANDLE> mCachedRenderTargetViews[D3DX12_MAX_ACTIVE_NODES];
 };
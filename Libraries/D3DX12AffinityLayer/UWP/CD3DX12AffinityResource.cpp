@@ -214,6 +214,33 @@ CD3DX12AffinityResource::CD3DX12AffinityResource(CD3DX12AffinityDevice* device,
     mObjectTypeName = L"Resource";
 #endif
     mVirtualAddress = 0;
+
+#if D3DX12_REPLICATE_SIMULTANEOUS_ACCESS_RESOURCES
+    UINT ValidNodeMask = 0;
+    ID3D12Resource* FirstResource = nullptr;
+    for (UINT i = 0; i < D3DX12_MAX_ACTIVE_NODES; i++)
+    {
+        if (mResources[i])
+        {
+            ValidNodeMask |= 1 << i;
+            FirstResource = FirstResource ? FirstResource : mResources[i];
+        }
+    }
+
+    if (FirstResource)
+    {
+        mReplicationDesc = FirstResource->GetDesc();
+        if (IsReplicationCandidate(device, mReplicationDesc))
+        {
+            // Everything starts out undefined, which is the same on every node.
+            SubresourceReplication Initial = {};
+            Initial.ValidNodeMask = ValidNodeMask;
+
+            UINT const ArraySize = mReplicationDesc.Dimension == D3D12_RESOURCE_DIMENSION_TEXTURE3D ? 1 : mReplicationDesc.DepthOrArraySize;
+            mReplication.assign(mReplicationDesc.MipLevels * ArraySize, Initial);
+        }
+    }
+#endif
 }
 
 CD3DX12AffinityResource::~CD3DX12AffinityResource()
@@ -226,6 +253,14 @@ CD3DX12AffinityResource::~CD3DX12AffinityResource()
         GetParentDevice()->GPUVirtualAddresses.erase(mVirtualAddress);
     }
 
+    for (SubresourceReplication& State : mReplication)
+    {
+        if (State.pWriteFence)
+        {
+            State.pWriteFence->Release();
+        }
+    }
+
     for (UINT i = 0; i < GetNodeCount(); i++)
     {
         if (mHeaps[i])
@@ -322,3 +357,209 @@ ID3D12Resource* CD3DX12AffinityResource::GetChildObject(UINT AffinityIndex)
 {
     return mResources[AffinityIndex];
 }
+
+bool CD3DX12AffinityResource::IsReplicationCandidate(CD3DX12AffinityDevice* pDevice, D3D12_RESOURCE_DESC const& Desc)
+{
+    // Simultaneous access textures decay to COMMON between ExecuteCommandLists calls,
+    // so the copy queues can read and write them without knowing their state.
+    // Buffers already share a single GPUVA through TILE_MAPPING_GPUVA.
+    return pDevice->GetAffinityMode() == EAffinityMode::LDA
+        && pDevice->GetNodeCount() > 1
+        && Desc.Dimension != D3D12_RESOURCE_DIMENSION_BUFFER
+        && (Desc.Flags & D3D12_RESOURCE_FLAG_ALLOW_SIMULTANEOUS_ACCESS) != 0;
+}
+
+D3D12_BOX CD3DX12AffinityResource::GetSubresourceBox(UINT Subresource) const
+{
+    UINT const MipLevel = Subresource % mReplicationDesc.MipLevels;
+
+    D3D12_BOX Box = {};
+    Box.right = static_cast<UINT>(max(mReplicationDesc.Width >> MipLevel, 1ull));
+    Box.bottom = max(mReplicationDesc.Height >> MipLevel, 1u);
+    Box.back = mReplicationDesc.Dimension == D3D12_RESOURCE_DIMENSION_TEXTURE3D ? static_cast<UINT>(max(mReplicationDesc.DepthOrArraySize >> MipLevel, 1)) : 1;
+
+    return Box;
+}
+
+static bool IsEmptyBox(D3D12_BOX const& Box)
+{
+    return Box.right <= Box.left || Box.bottom <= Box.top || Box.back <= Box.front;
+}
+
+static D3D12_BOX UnionBox(D3D12_BOX const& A, D3D12_BOX const& B)
+{
+    if (IsEmptyBox(A))
+    {
+        return B;
+    }
+    if (IsEmptyBox(B))
+    {
+        return A;
+    }
+
+    D3D12_BOX Union;
+    Union.left = min(A.left, B.left);
+    Union.top = min(A.top, B.top);
+    Union.front = min(A.front, B.front);
+    Union.right = max(A.right, B.right);
+    Union.bottom = max(A.bottom, B.bottom);
+    Union.back = max(A.back, B.back);
+
+    return Union;
+}
+
+void CD3DX12AffinityResource::PullSubresource(UINT Subresource, UINT NodeIndex, D3DX12_AFFINITY_REPLICATION_BATCH& Batch)
+{
+    SubresourceReplication& State = mReplication[Subresource];
+    UINT const SourceNode = State.OwnerNode;
+
+    // The queue only signals the owner's fence after the whole batch, so a write made
+    // earlier in this same batch cannot be waited on without deadlocking the nodes. The
+    // queue splits batches between command lists and Close rejects lists that do this
+    // within themselves, so this is only reached by executing such a list anyway.
+    if (State.pWriteFence == Batch.pNodeFences[SourceNode] && State.WriteFenceValue == Batch.NodeFenceValues[SourceNode])
+    {
+        ReleaseLog(L"D3DX12AffinityLayer: [replication] Subresource %u read on node %u after being written on node %u in the same command list, its contents are stale.\n", Subresource, NodeIndex, SourceNode);
+        DEBUG_FAIL_MESSAGE(L"Replicated subresource read on one node after being written on another in the same command list.");
+        return;
+    }
+
+    D3DX12_AFFINITY_REPLICATION_COPY Copy = { this, Subresource, SourceNode, State.StaleRegions[NodeIndex] };
+    Batch.Copies[NodeIndex].push_back(Copy);
+    if (State.pWriteFence)
+    {
+        Batch.CopyWaits[NodeIndex].push_back(std::make_pair(State.pWriteFence, State.WriteFenceValue));
+    }
+
+    State.ValidNodeMask |= 1 << NodeIndex;
+    State.StaleRegions[NodeIndex] = D3D12_BOX();
+    State.pCopyFences[NodeIndex] = Batch.pCopyFences[NodeIndex];
+    State.CopyFenceValues[NodeIndex] = Batch.CopyFenceValues[NodeIndex];
+}
+
+void CD3DX12AffinityResource::GetSubresourceRange(UINT Subresource, UINT& FirstSubresource, UINT& NumSubresources) const
+{
+    FirstSubresource = Subresource;
+    NumSubresources = 1;
+    if (Subresource == D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES)
+    {
+        FirstSubresource = 0;
+        NumSubresources = static_cast<UINT>(mReplication.size());
+    }
+}
+
+bool CD3DX12AffinityResource::ReadsPendingWrite(
+    D3DX12_AFFINITY_REPLICATION_ACCESS const& Access,
+    UINT NodeMask,
+    D3DX12_AFFINITY_REPLICATION_BATCH const& Batch) const
+{
+    if (Access.Type == D3DX12_AFFINITY_REPLICATION_ACCESS_OVERWRITE)
+    {
+        return false;
+    }
+
+    UINT FirstSubresource, NumSubresources;
+    GetSubresourceRange(Access.Subresource, FirstSubresource, NumSubresources);
+
+    for (UINT s = FirstSubresource; s < FirstSubresource + NumSubresources; ++s)
+    {
+        SubresourceReplication const& State = mReplication[s];
+        if ((NodeMask & ~State.ValidNodeMask) != 0 &&
+            State.pWriteFence == Batch.pNodeFences[State.OwnerNode] &&
+            State.WriteFenceValue == Batch.NodeFenceValues[State.OwnerNode])
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+void CD3DX12AffinityResource::TrackReplicationAccess(
+    D3DX12_AFFINITY_REPLICATION_ACCESS const& Access,
+    UINT NodeMask,
+    D3DX12_AFFINITY_REPLICATION_BATCH& Batch)
+{
+    UINT FirstSubresource, NumSubresources;
+    GetSubresourceRange(Access.Subresource, FirstSubresource, NumSubresources);
+
+    for (UINT s = FirstSubresource; s < FirstSubresource + NumSubresources; ++s)
+    {
+        SubresourceReplication& State = mReplication[s];
+
+        // Reads, and writes that may leave parts untouched, need the current contents first.
+        if (Access.Type != D3DX12_AFFINITY_REPLICATION_ACCESS_OVERWRITE)
+        {
+            for (UINT i = 0; i < D3DX12_MAX_ACTIVE_NODES;i++)
+            {
+                if (((1 << i) & NodeMask & ~State.ValidNodeMask) != 0)
+                {
+                    PullSubresource(s, i, Batch);
+                }
+            }
+        }
+
+        if (Access.Type == D3DX12_AFFINITY_REPLICATION_ACCESS_READ)
+        {
+            continue;
+        }
+
+        D3D12_BOX const Written = Access.HasRegion ? Access.Region : GetSubresourceBox(s);
+
+        for (UINT i = 0; i < D3DX12_MAX_ACTIVE_NODES;i++)
+        {
+            UINT const NodeBit = 1 << i;
+            if (!mResources[i])
+            {
+                continue;
+            }
+
+            if ((NodeBit & NodeMask) != 0)
+            {
+                State.StaleRegions[i] = D3D12_BOX();
+
+                // Copies still reading this subresource must finish before it is written
+                // again, whichever node they were copying onto.
+                for (UINT n = 0; n < D3DX12_MAX_ACTIVE_NODES; n++)
+                {
+                    if (State.pCopyFences[n])
+                    {
+                        Batch.QueueWaits[i].push_back(std::make_pair(State.pCopyFences[n], State.CopyFenceValues[n]));
+                    }
+                }
+            }
+            else if ((NodeBit & State.ValidNodeMask) != 0)
+            {
+                State.StaleRegions[i] = Written;
+            }
+            else
+            {
+                State.StaleRegions[i] = UnionBox(State.StaleRegions[i], Written);
+            }
+        }
+
+        UINT OwnerNode = 0;
+        while (((1 << OwnerNode) & NodeMask) == 0)
+        {
+            OwnerNode++;
+        }
+
+        State.ValidNodeMask = NodeMask;
+        State.OwnerNode = OwnerNode;
+        for (UINT n = 0; n < D3DX12_MAX_ACTIVE_NODES; n++)
+        {
+            State.pCopyFences[n] = nullptr;
+            State.CopyFenceValues[n] = 0;
+        }
+
+        if (State.pWriteFence != Batch.pNodeFences[OwnerNode])
+        {
+            if (State.pWriteFence)
+            {
+                State.pWriteFence->Release();
+            }
+            State.pWriteFence = Batch.pNodeFences[OwnerNode];
+            State.pWriteFence->AddRef();
+        }
+        State.WriteFenceValue = Batch.NodeFenceValues[OwnerNode];
+    }
+}
@@ -188,6 +188,18 @@ public:
 
     UINT STDMETHODCALLTYPE GetCurrentBackBufferIndex();
 
+    // Affinity layer extension. Returns the node that should render the next frame, for
+    // CD3DX12AffinityDevice::SwitchToNode() after each Present().
+    //
+    // A single window swap chain copies each frame to the host from whichever node rendered
+    // it, in the order the frames were presented, so any node can take the next frame. The
+    // node with the fewest frames still being copied is picked, which lets a faster node run
+    // more frames ahead than a slower one instead of waiting for its turn.
+    //
+    // An LDA swap chain's back buffers are each created on a fixed node and presented in a
+    // fixed order, so the next node is the one that owns the next back buffer.
+    UINT GetNextRenderNode();
+
     HRESULT STDMETHODCALLTYPE CheckColorSpaceSupport(
         _In_  DXGI_COLOR_SPACE_TYPE ColorSpace,
         _Out_  UINT* pColorSpaceSupport,
@@ -252,6 +264,16 @@ public:
     CD3DX12AffinityCommandQueue* mParentQueue;
     std::vector<SDeviceContext> mDeviceContexts;
 
+    // The single window frames that are still being copied to the host, tagged with the
+    // node that rendered them and the copy fence value that completes them.
+    struct SPresentedFrame
+    {
+        UINT mNode;
+        UINT mFenceValue;
+    };
+    std::vector<SPresentedFrame> mPresentQueue;
+    UINT mLastRenderNode;
+
     UINT mCurrentBackBufferIndex;
     UINT mNumBackBuffers;
     UINT mNumRequestedBackBuffers;
@@ -0,0 +1,338 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Developed by Minigraph
+//
+
+#include "pch.h"
+#include "Benchmark.h"
+#include "Camera.h"
+#include "GraphicsCore.h"
+#include <algorithm>
+#include <unordered_map>
+
+using namespace std;
+using namespace Math;
+
+namespace Benchmark
+{
+    enum RunState { kIdle, kRunning, kFinished };
+
+    // The samples of one scope, one per measured frame in which it ran
+    struct ScopeSamples
+    {
+        wstring Path;
+        vector<float> CpuTimes;
+        vector<float> GpuTimes;
+    };
+
+    RunState s_State = kIdle;
+    Settings s_Settings;
+    CameraPath s_CameraPath;
+    uint32_t s_FrameIndex = 0;
+    ScopeSamples s_FrameSamples;
+    vector<ScopeSamples> s_ScopeSamples;                // In the order the scopes first ran
+    unordered_map<wstring, size_t> s_ScopeIndices;
+
+    void RecordSamples( void );
+    bool WriteResults( void );
+}
+
+//=====================================================================================================================
+// CameraPath
+
+bool Benchmark::CameraPath::Load( const wstring& FilePath )
+{
+    m_Keys.clear();
+
+    FILE* PathFile = nullptr;
+    _wfopen_s(&PathFile, FilePath.c_str(), L"rb");
+    if (PathFile == nullptr)
+        return false;
+
+    char Line[256];
+    while (fgets(Line, sizeof(Line), PathFile) != nullptr)
+    {
+        if (Line[0] == '#')
+            continue;
+
+        Key NewKey;
+        if (sscanf_s(Line, "%f %f %f %f %f %f %f", &NewKey.Time, &NewKey.Eye.x, &NewKey.Eye.y, &NewKey.Eye.z,
+            &NewKey.At.x, &NewKey.At.y, &NewKey.At.z) != 7)
+            continue;
+
+        ASSERT(m_Keys.empty() || NewKey.Time >= m_Keys.back().Time, "Camera path keys are out of order");
+        m_Keys.push_back(NewKey);
+    }
+
+    fclose(PathFile);
+    return !m_Keys.empty();
+}
+
+bool Benchmark::CameraPath::Save( const wstring& FilePath ) const
+{
+    FILE* PathFile = nullptr;
+    _wfopen_s(&PathFile, FilePath.c_str(), L"wb");
+    if (PathFile == nullptr)
+        return false;
+
+    fprintf(PathFile, "# time  eye.x eye.y eye.z  at.x at.y at.z\r\n");
+    for (const Key& K : m_Keys)
+    {
+        fprintf(PathFile, "%f  %f %f %f  %f %f %f\r\n", K.Time, K.Eye.x, K.Eye.y, K.Eye.z, K.At.x, K.At.y, K.At.z);
+    }
+
+    fclose(PathFile);
+    return true;
+}
+
+void Benchmark::CameraPath::AddKey( float Time, const Camera& Cam )
+{
+    ASSERT(m_Keys.empty() || Time >= m_Keys.back().Time, "Camera path keys are out of order");
+
+    Key NewKey;
+    NewKey.Time = Time;
+    XMStoreFloat3(&NewKey.Eye, Cam.GetPosition());
+    XMStoreFloat3(&NewKey.At, Cam.GetPosition() + Cam.GetForwardVec());
+    m_Keys.push_back(NewKey);
+}
+
+void Benchmark::CameraPath::Evaluate( float Time, Camera& Cam ) const
+{
+    ASSERT(!m_Keys.empty());
+
+    // Find the segment [i, i + 1] that contains the time
+    size_t Last = m_Keys.size() - 1;
+    size_t i = 0;
+    while (i < Last && m_Keys[i + 1].Time <= Time)
+        ++i;
+
+    Vector3 Eye, At;
+    if (i == Last)
+    {
+        Eye = Vector3(m_Keys[Last].Eye);
+        At = Vector3(m_Keys[Last].At);
+    }
+    else
+    {
+        // The end keys are repeated to pad out the first and last segments
+        const Key& K0 = m_Keys[i == 0 ? 0 : i - 1];
+        const Key& K1 = m_Keys[i];
+        const Key& K2 = m_Keys[i + 1];
+        const Key& K3 = m_Keys[min(i + 2, Last)];
+
+        float Span = K2.Time - K1.Time;
+        float T = Span > 0.0f ? min(max((Time - K1.Time) / Span, 0.0f), 1.0f) : 0.0f;
+
+        Eye = Vector3(XMVectorCatmullRom(XMLoadFloat3(&K0.Eye), XMLoadFloat3(&K1.Eye),
+            XMLoadFloat3(&K2.Eye), XMLoadFloat3(&K3.Eye), T));
+        At = Vector3(XMVectorCatmullRom(XMLoadFloat3(&K0.At), XMLoadFloat3(&K1.At),
+            XMLoadFloat3(&K2.At), XMLoadFloat3(&K3.At), T));
+    }
+
+    Cam.SetEyeAtUp(Eye, At, Vector3(kYUnitVector));
+    Cam.Update();
+}
+
+//=====================================================================================================================
+// Benchmark runs
+
+bool Benchmark::ParseCommandLine( Settings& BenchmarkSettings )
+{
+#if WINAPI_FAMILY_PARTITION(WINAPI_PARTITION_DESKTOP)
+    bool Found = false;
+
+    for (int i = 1; i < __argc; ++i)
+    {
+        const wchar_t* Arg = __wargv[i];
+        const wchar_t* Value = i + 1 < __argc ? __wargv[i + 1] : nullptr;
+
+        if (Value == nullptr)
+            break;
+
+        if (_wcsicmp(Arg, L"-benchmark") == 0)
+        {
+            BenchmarkSettings.CameraPathFile = Value;
+            Found = true;
+        }
+        else if (_wcsicmp(Arg, L"-warmup") == 0)
+            BenchmarkSettings.WarmupFrames = (uint32_t)_wtoi(Value);
+        else if (_wcsicmp(Arg, L"-frames") == 0)
+            BenchmarkSettings.MeasuredFrames = (uint32_t)max(_wtoi(Value), 1);
+        else if (_wcsicmp(Arg, L"-results") == 0)
+            BenchmarkSettings.ResultsFile = Value;
+        else
+            continue;
+
+        ++i;
+    }
+
+    return Found;
+#else
+    (BenchmarkSettings);
+    return false;
+#endif
+}
+
+bool Benchmark::Start( const Settings& BenchmarkSettings )
+{
+    ASSERT(s_State != kRunning, "A benchmark is already running");
+    ASSERT(BenchmarkSettings.MeasuredFrames > 0);
+
+    s_Settings = BenchmarkSettings;
+    s_FrameIndex = 0;
+    s_FrameSamples.Path = L"Frame";
+    s_FrameSamples.CpuTimes.clear();
+    s_FrameSamples.GpuTimes.clear();
+    s_ScopeSamples.clear();
+    s_ScopeIndices.clear();
+
+    if (!s_CameraPath.Load(s_Settings.CameraPathFile))
+    {
+        Utility::Printf(L"Benchmark:  Unable to load the camera path \"%s\"\n", s_Settings.CameraPathFile.c_str());
+        s_State = kFinished;
+        return false;
+    }
+
+    Graphics::s_EnableVSync = false;
+
+    s_FrameSamples.CpuTimes.reserve(s_Settings.MeasuredFrames);
+    s_FrameSamples.GpuTimes.reserve(s_Settings.MeasuredFrames);
+
+    Utility::Printf(L"Benchmark:  %u warm-up and %u measured frames along \"%s\"\n", s_Settings.WarmupFrames,
+        s_Settings.MeasuredFrames, s_Settings.CameraPathFile.c_str());
+
+    s_State = kRunning;
+    return true;
+}
+
+bool Benchmark::IsRunning( void )
+{
+    return s_State == kRunning;
+}
+
+bool Benchmark::IsFinished( void )
+{
+    return s_State == kFinished;
+}
+
+void Benchmark::Update( Camera& Cam )
+{
+    ASSERT(s_State == kRunning);
+
+    // Each measured frame is sampled during the one that follows it
+    if (s_FrameIndex > s_Settings.WarmupFrames)
+        RecordSamples();
+
+    if (s_FrameIndex == s_Settings.WarmupFrames + s_Settings.MeasuredFrames)
+    {
+        if (WriteResults())
+            Utility::Printf(L"Benchmark:  Results written to \"%s\"\n", s_Settings.ResultsFile.c_str());
+        else
+            Utility::Printf(L"Benchmark:  Unable to write \"%s\"\n", s_Settings.ResultsFile.c_str());
+
+        s_State = kFinished;
+        return;
+    }
+
+    // Warm-up frames hold the camera at the start of the path
+    float Time = 0.0f;
+    if (s_FrameIndex >= s_Settings.WarmupFrames && s_Settings.MeasuredFrames > 1)
+    {
+        Time = s_CameraPath.GetDuration() * (float)(s_FrameIndex - s_Settings.WarmupFrames) /
+            (float)(s_Settings.MeasuredFrames - 1);
+    }
+    s_CameraPath.Evaluate(Time, Cam);
+
+    ++s_FrameIndex;
+}
+
+void Benchmark::RecordSamples( void )
+{
+    s_FrameSamples.CpuTimes.push_back(1000.0f * Graphics::GetFrameTime());
+    s_FrameSamples.GpuTimes.push_back(EngineProfiling::GetGpuFrameTime());
+
+    EngineProfiling::ForEachScopeTime([](const wstring& Path, float CpuTime, float GpuTime)
+    {
+        auto Iter = s_ScopeIndices.find(Path);
+        if (Iter == s_ScopeIndices.end())
+        {
+            Iter = s_ScopeIndices.emplace(Path, s_ScopeSamples.size()).first;
+            s_ScopeSamples.emplace_back();
+            s_ScopeSamples.back().Path = Path;
+        }
+
+        ScopeSamples& Samples = s_ScopeSamples[Iter->second];
+        Samples.CpuTimes.push_back(CpuTime);
+        Samples.GpuTimes.push_back(GpuTime);
+    });
+}
+
+namespace Benchmark
+{
+    // Nearest rank percentile of sorted samples
+    float Percentile( const vector<float>& Sorted, float Fraction )
+    {
+        size_t Rank = (size_t)ceil(Fraction * Sorted.size());
+        return Sorted[Rank > 0 ? Rank - 1 : 0];
+    }
+
+    void WriteStats( FILE* File, const char* Name, vector<float>& Times )
+    {
+        sort(Times.begin(), Times.end());
+
+        double Sum = 0.0;
+        for (float T : Times)
+            Sum += T;
+
+        fprintf(File, "\"%s\":{\"avg\":%.4f,\"min\":%.4f,\"p50\":%.4f,\"p95\":%.4f,\"p99\":%.4f,\"max\":%.4f}",
+            Name, Sum / Times.size(), Times.front(), Percentile(Times, 0.5f), Percentile(Times, 0.95f),
+            Percentile(Times, 0.99f), Times.back());
+    }
+
+    void WriteScope( FILE* File, ScopeSamples& Samples )
+    {
+        // Timer names are ASCII in practice, so anything else is replaced rather than encoded
+        string Name;
+        for (wchar_t Ch : Samples.Path)
+        {
+            if (Ch == L'"' || Ch == L'\\')
+                Name.push_back('\\');
+            Name.push_back(Ch >= 0x20 && Ch < 0x7F ? (char)Ch : '?');
+        }
+
+        fprintf(File, "{\"name\":\"%s\",\"samples\":%zu,", Name.c_str(), Samples.CpuTimes.size());
+        WriteStats(File, "cpu_ms", Samples.CpuTimes);
+        fprintf(File, ",");
+        WriteStats(File, "gpu_ms", Samples.GpuTimes);
+        fprintf(File, "}");
+    }
+}
+
+bool Benchmark::WriteResults( void )
+{
+    FILE* File = nullptr;
+    _wfopen_s(&File, s_Settings.ResultsFile.c_str(), L"wb");
+    if (File == nullptr)
+        return false;
+
+    fprintf(File, "{\"warmup_frames\":%u,\"measured_frames\":%u,\n\"frame\":", s_Settings.WarmupFrames,
+        s_Settings.MeasuredFrames);
+    WriteScope(File, s_FrameSamples);
+    fprintf(File, ",\n\"scopes\":[");
+
+    for (size_t i = 0; i < s_ScopeSamples.size(); ++i)
+    {
+        fprintf(File, i == 0 ? "\n" : ",\n");
+        WriteScope(File, s_ScopeSamples[i]);
+    }
+
+    fprintf(File, "\n]}\n");
+    fclose(File);
+    return true;
+}
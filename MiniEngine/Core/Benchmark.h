@@ -0,0 +1,82 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Developed by Minigraph
+//
+// Description:  Reproducible benchmark runs.  The camera follows a recorded path while the timings of
+// every profiled scope are collected, and the percentiles of each are written to a JSON file.
+//
+// Camera position is a function of the frame number rather than of time, so every run renders the same
+// frames no matter how fast they are.  VSync is turned off for the duration of the run.
+//
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace Math
+{
+    class Camera;
+}
+
+namespace Benchmark
+{
+    // A Catmull-Rom spline through camera keys.  The text format has one key per line, "time eye at", e.g.
+    // "2.5  100 20 0  0 20 0", with the time in seconds and the eye and look-at points in world units.
+    // Lines starting with '#' are comments.
+    class CameraPath
+    {
+    public:
+        bool Load( const std::wstring& FilePath );
+        bool Save( const std::wstring& FilePath ) const;
+
+        // Keys must be added in increasing time order
+        void AddKey( float Time, const Math::Camera& Camera );
+        void Clear( void ) { m_Keys.clear(); }
+
+        size_t GetNumKeys( void ) const { return m_Keys.size(); }
+        float GetDuration( void ) const { return m_Keys.empty() ? 0.0f : m_Keys.back().Time; }
+
+        // Places the camera and updates its matrices
+        void Evaluate( float Time, Math::Camera& Camera ) const;
+
+    private:
+        struct Key
+        {
+            float Time;
+            XMFLOAT3 Eye;
+            XMFLOAT3 At;
+        };
+        std::vector<Key> m_Keys;
+    };
+
+    struct Settings
+    {
+        Settings() : ResultsFile(L"Benchmark.json"), WarmupFrames(100), MeasuredFrames(1000) {}
+
+        std::wstring CameraPathFile;
+        std::wstring ResultsFile;
+        uint32_t WarmupFrames;
+        uint32_t MeasuredFrames;
+    };
+
+    // Looks for "-benchmark <camera path> [-warmup <frames>] [-frames <frames>] [-results <file>]" on the
+    // command line.  Returns false when there is no -benchmark argument.
+    bool ParseCommandLine( Settings& BenchmarkSettings );
+
+    bool Start( const Settings& BenchmarkSettings );
+    bool IsRunning( void );
+
+    // True once the results have been written (or the run failed), at which point the app should exit
+    bool IsFinished( void );
+
+    // Call once per frame in place of the camera controller while IsRunning().  This moves the camera to the
+    // frame's place on the path and samples the timings that were read back for the previous frame.
+    void Update( Math::Camera& Camera );
+}
@@ -13,12 +13,14 @@
 
 #include "pch.h"
 #include "BitonicSort.h"
+#include "RadixSort.h"
 #include "RootSignature.h"
 #include "PipelineState.h"
 #include "CommandContext.h"
 #include "ReadbackBuffer.h"
 #include "Math/Common.h"
 #include "Math/Random.h"
+#include "SystemTime.h"
 
 #include "CompiledShaders/BitonicIndirectArgsCS.h"
 #include "CompiledShaders/Bitonic32PreSortCS.h"
@@ -170,33 +172,56 @@ inline void VerifySort(T* List, uint32_t ListLength, bool bAscending)
     ASSERT((List[ListLength - 1] & IndexMask) < ListLength, "Corrupted list index detected");
 }
 
-void TestBitonicSort(uint32_t ListSize, bool b64Bit, bool bAscending)
+enum SortAlgorithm { kBitonicSort, kRadixSort };
+
+void GpuSort(ComputeContext& Ctx, SortAlgorithm Algorithm, GpuBuffer& List, GpuBuffer& Scratch, GpuBuffer& Count, bool bAscending)
+{
+    if (Algorithm == kRadixSort)
+        RadixSort::Sort(Ctx, List, Scratch, Count, 0, bAscending);
+    else
+        BitonicSort::Sort(Ctx, List, Count, 0, false, bAscending);
+}
+
+void* CreateRandomList(uint32_t ListSize, bool b64Bit)
 {
     const uint32_t SizeOfElem = b64Bit ? sizeof(uint64_t) : sizeof(uint32_t);
     const uint32_t IndexMask = Math::AlignPowerOfTwo(ListSize) - 1;
 
     // Allocate memory for list on CPU
-    void* BufferPtr = std::malloc(ListSize * SizeOfElem);
+    void* BufferPtr = std::malloc((size_t)ListSize * SizeOfElem);
 
     // Initialize list with random keys and valid indices
+    Math::RandomNumberGenerator& RNG = Math::GetThreadRNG();
     if (b64Bit)
     {
         uint64_t* BufferPtr64 = (uint64_t*)BufferPtr;
         for (uint32_t i = 0; i < ListSize; ++i)
-            BufferPtr64[i] = ((uint64_t)(uint32_t)Math::g_RNG.NextInt() << 32 | i);
+            BufferPtr64[i] = ((uint64_t)RNG.NextUint() << 32 | i);
     }
     else
     {
         uint32_t* BufferPtr32 = (uint32_t*)BufferPtr;
         for (uint32_t i = 0; i < ListSize; ++i)
-            BufferPtr32[i] = (((uint32_t)Math::g_RNG.NextInt() & ~IndexMask) | i);
+            BufferPtr32[i] = ((RNG.NextUint() & ~IndexMask) | i);
     }
 
+    return BufferPtr;
+}
+
+void TestGpuSort(SortAlgorithm Algorithm, uint32_t ListSize, bool b64Bit, bool bAscending)
+{
+    const uint32_t SizeOfElem = b64Bit ? sizeof(uint64_t) : sizeof(uint32_t);
+
     // Upload list to GPU
+    void* BufferPtr = CreateRandomList(ListSize, b64Bit);
     ByteAddressBuffer RandomListGpu;
     RandomListGpu.Create(L"GPU Sort List", ListSize, SizeOfElem, BufferPtr);
     std::free(BufferPtr);
 
+    ByteAddressBuffer ScratchListGpu;
+    if (Algorithm == kRadixSort)
+        ScratchListGpu.Create(L"GPU Sort Scratch List", ListSize, SizeOfElem);
+
     // Put the list size in GPU memory
     __declspec(align(16)) uint32_t ListCounter[1] = { ListSize };
     ByteAddressBuffer RandomListCount;
@@ -210,9 +235,10 @@ void TestBitonicSort(uint32_t ListSize, bool b64Bit, bool bAscending)
     ReadbackList.Create(L"Random List For Sort", ListSize, SizeOfElem);
 
     // Begin GPU work of sorting.  Then copy results back to CPU.
-    ComputeContext& Ctx = ComputeContext::Begin(L"Bitonic Sort Test");
-    BitonicSort::Sort(Ctx, RandomListGpu, RandomListCount, 0, false, bAscending);
-    Ctx.CopyBuffer(IndirectArgs, BitonicSort::s_DispatchArgs);
+    ComputeContext& Ctx = ComputeContext::Begin(L"GPU Sort Test");
+    GpuSort(Ctx, Algorithm, RandomListGpu, ScratchListGpu, RandomListCount, bAscending);
+    if (Algorithm == kBitonicSort)
+        Ctx.CopyBuffer(IndirectArgs, BitonicSort::s_DispatchArgs);
     Ctx.CopyBuffer(ReadbackList, RandomListGpu);
     Ctx.Finish(true);
 
@@ -232,14 +258,68 @@ void TestBitonicSort(uint32_t ListSize, bool b64Bit, bool bAscending)
     //IndirectArgs.Unmap();
 }
 
+// Returns the average GPU time of one sort in milliseconds.  Each sort runs on the output of the previous
+// one, which doesn't matter because neither algorithm's cost depends on the order of its input.
+float TimeGpuSort(SortAlgorithm Algorithm, GpuBuffer& List, GpuBuffer& Scratch, GpuBuffer& Count)
+{
+    const uint32_t kNumIterations = 8;
+
+    // Warm up, and make sure that the list upload has finished before the timer starts
+    ComputeContext& WarmUp = ComputeContext::Begin(L"GPU Sort Benchmark");
+    GpuSort(WarmUp, Algorithm, List, Scratch, Count, true);
+    WarmUp.Finish(true);
+
+    int64_t StartTick = SystemTime::GetCurrentTick();
+
+    ComputeContext& Ctx = ComputeContext::Begin(L"GPU Sort Benchmark");
+    for (uint32_t i = 0; i < kNumIterations; ++i)
+        GpuSort(Ctx, Algorithm, List, Scratch, Count, true);
+    Ctx.Finish(true);
+
+    return (float)(SystemTime::TimeBetweenTicks(StartTick, SystemTime::GetCurrentTick()) * 1000.0 / kNumIterations);
+}
+
+void BenchmarkGpuSorts(uint32_t ListSize, bool b64Bit)
+{
+    const uint32_t SizeOfElem = b64Bit ? sizeof(uint64_t) : sizeof(uint32_t);
+
+    void* BufferPtr = CreateRandomList(ListSize, b64Bit);
+    ByteAddressBuffer ListGpu;
+    ListGpu.Create(L"GPU Sort List", ListSize, SizeOfElem, BufferPtr);
+    std::free(BufferPtr);
+
+    ByteAddressBuffer ScratchListGpu;
+    ScratchListGpu.Create(L"GPU Sort Scratch List", ListSize, SizeOfElem);
+
+    __declspec(align(16)) uint32_t ListCounter[1] = { ListSize };
+    ByteAddressBuffer ListCount;
+    ListCount.Create(L"GPU List Counter", 1, sizeof(uint32_t), ListCounter);
+
+    float BitonicTime = TimeGpuSort(kBitonicSort, ListGpu, ScratchListGpu, ListCount);
+    float RadixTime = TimeGpuSort(kRadixSort, ListGpu, ScratchListGpu, ListCount);
+
+    Utility::Printf("%u-bit sort of %8u elements:  Bitonic %8.3f ms (%7.1f M/s)  Radix %8.3f ms (%7.1f M/s)\n",
+        SizeOfElem * 8, ListSize, BitonicTime, ListSize / (BitonicTime * 1000.0f), RadixTime, ListSize / (RadixTime * 1000.0f));
+}
+
 void BitonicSort::Test( void )
 {
     for (uint32_t ThreadGroupCount = 1; ThreadGroupCount < 256; ++ThreadGroupCount)
     {
         uint32_t ListSize = 500 * ThreadGroupCount;
-        TestBitonicSort(ListSize, true, true);
-        TestBitonicSort(ListSize, true, false);
-        TestBitonicSort(ListSize, false, true);
-        TestBitonicSort(ListSize, false, false);
+        TestGpuSort(kBitonicSort, ListSize, true, true);
+        TestGpuSort(kBitonicSort, ListSize, true, false);
+        TestGpuSort(kBitonicSort, ListSize, false, true);
+        TestGpuSort(kBitonicSort, ListSize, false, false);
+        TestGpuSort(kRadixSort, ListSize, true, true);
+        TestGpuSort(kRadixSort, ListSize, true, false);
+        TestGpuSort(kRadixSort, ListSize, false, true);
+        TestGpuSort(kRadixSort, ListSize, false, false);
+    }
+
+    for (uint32_t ListSize = 64 * 1024; ListSize <= RadixSort::kMaxElements; ListSize *= 4)
+    {
+        BenchmarkGpuSorts(ListSize, false);
+        BenchmarkGpuSorts(ListSize, true);
     }
 }
@@ -98,6 +98,8 @@ namespace BitonicSort
         bool SortAscending
     );
 
+    // Verify BitonicSort and RadixSort on many list sizes, then print the throughput of both sorts for
+    // lists of 64K to 16M elements.
     void Test( void );
 
 } // namespace BitonicSort
@@ -16,6 +16,8 @@
 #include "GraphicsCore.h"
 #include "CommandListManager.h"
 #include "CommandContext.h"
+#include "GpuMemory.h"
+#include <algorithm>
 
 using namespace Graphics;
 using namespace std;
@@ -71,9 +73,49 @@ BuddyAllocator::BuddyAllocator(kBuddyAllocationStrategy allocationStrategy, D3D1
 
     m_maxOrder = UnitSizeToOrder(SizeToUnitSize(maxBlockSize));
 
+    // Lay out the bitmaps of all orders back to back.  Order N has 2^(maxOrder - N) blocks.
+    m_orderBitmaps.resize(m_maxOrder + 1);
+    size_t wordTotal = 0;
+    size_t summaryTotal = 0;
+    for (UINT order = 0; order <= m_maxOrder; ++order)
+    {
+        OrderBitmap& bitmap = m_orderBitmaps[order];
+        size_t blockCount = OrderToUnitSize(m_maxOrder - order);
+        bitmap.wordOffset = wordTotal;
+        bitmap.wordCount = (blockCount + 63) / 64;
+        bitmap.summaryOffset = summaryTotal;
+        bitmap.summaryCount = (bitmap.wordCount + 63) / 64;
+        wordTotal += bitmap.wordCount;
+        summaryTotal += bitmap.summaryCount;
+    }
+
+    m_freeBits.reset(new std::atomic<uint64_t>[wordTotal]);
+    m_summaryBits.reset(new std::atomic<uint64_t>[summaryTotal]);
+    m_blockTable.reset(new BuddyBlock*[OrderToUnitSize(m_maxOrder)]);
+
     Reset();
 }
 
+void BuddyAllocator::Reset()
+{
+    std::unique_lock<std::shared_timed_mutex> tableLock(m_tableMutex);
+    std::lock_guard<std::mutex> lock(m_mutex);
+    ResetBitmaps();
+}
+
+void BuddyAllocator::ResetBitmaps()
+{
+    const OrderBitmap& last = m_orderBitmaps[m_maxOrder];
+    for (size_t i = 0; i < last.wordOffset + last.wordCount; ++i)
+        m_freeBits[i].store(0, std::memory_order_relaxed);
+    for (size_t i = 0; i < last.summaryOffset + last.summaryCount; ++i)
+        m_summaryBits[i].store(0, std::memory_order_relaxed);
+    std::fill_n(m_blockTable.get(), OrderToUnitSize(m_maxOrder), nullptr);
+
+    // Initialize the pool with a free inner block of max inner block size  
+    ReleaseBlock(0, m_maxOrder);
+}
+
 void BuddyAllocator::Initialize()
 {
     if (m_allocationStrategy == kBuddyAllocationStrategy::kPlacedResourceStrategy)
@@ -87,6 +129,7 @@ void BuddyAllocator::Initialize()
         desc.Flags = D3D12_HEAP_FLAG_ALLOW_ONLY_BUFFERS;
 
         ASSERT_SUCCEEDED(g_Device->CreateHeap(&desc, MY_IID_PPV_ARGS(&m_pBackingHeap)));
+        GpuMemory::Track(m_pBackingHeap, GpuMemory::kHeaps);
     }
     else
     {
@@ -106,62 +149,116 @@ void BuddyAllocator::Destroy()
     }
 }
 
-size_t BuddyAllocator::AllocateBlock(UINT order)
+size_t BuddyAllocator::ClaimFreeBlock(UINT order)
 {
-    size_t offset;
+    // Lock-free.  The summary may have stale bits for words that were emptied by other claims, but it is
+    // never missing a bit for a word that has free blocks because bits are only released under the mutex.
+    const OrderBitmap& bitmap = m_orderBitmaps[order];
 
-    if (order > m_maxOrder)
+    for (size_t s = 0; s < bitmap.summaryCount; ++s)
     {
-        throw(std::bad_alloc()); // Can't allocate a block that large  
+        uint64_t summary = m_summaryBits[bitmap.summaryOffset + s].load(std::memory_order_acquire);
+        unsigned long summaryBit;
+
+        while (_BitScanForward64(&summaryBit, summary))
+        {
+            summary &= summary - 1;
+
+            size_t wordIndex = s * 64 + summaryBit;
+            std::atomic<uint64_t>& word = m_freeBits[bitmap.wordOffset + wordIndex];
+            uint64_t bits = word.load(std::memory_order_relaxed);
+            unsigned long freeBit;
+
+            while (_BitScanForward64(&freeBit, bits))
+            {
+                if (word.compare_exchange_weak(bits, bits & ~(1ull << freeBit), std::memory_order_acquire))
+                    return wordIndex * 64 + freeBit;
+            }
+        }
     }
 
-    auto it = m_freeBlocks[order].begin();
+    return kInvalidBlock;
+}
 
-    if (it == m_freeBlocks[order].end())
-    {
-        // No free nodes in the requested pool.  Try to find a higher-order block and split it.  
-        size_t left = AllocateBlock(order + 1);
+bool BuddyAllocator::ClaimBlock(size_t index, UINT order)
+{
+    const uint64_t mask = 1ull << (index % 64);
+    std::atomic<uint64_t>& word = m_freeBits[m_orderBitmaps[order].wordOffset + index / 64];
+    return (word.fetch_and(~mask, std::memory_order_acquire) & mask) != 0;
+}
+
+void BuddyAllocator::ReleaseBlock(size_t index, UINT order)
+{
+    // Set the free bit before the summary bit so a claimer that sees the summary also sees the block
+    const OrderBitmap& bitmap = m_orderBitmaps[order];
+    size_t wordIndex = index / 64;
+    m_freeBits[bitmap.wordOffset + wordIndex].fetch_or(1ull << (index % 64), std::memory_order_release);
+    m_summaryBits[bitmap.summaryOffset + wordIndex / 64].fetch_or(1ull << (wordIndex % 64), std::memory_order_release);
+}
 
-        size_t size = OrderToUnitSize(order);
+void BuddyAllocator::PruneSummary(UINT order)
+{
+    // Called with the mutex held.  Nobody else can set free bits, so a word that reads empty stays empty.
+    const OrderBitmap& bitmap = m_orderBitmaps[order];
 
-        size_t right = left + size;
+    for (size_t s = 0; s < bitmap.summaryCount; ++s)
+    {
+        uint64_t summary = m_summaryBits[bitmap.summaryOffset + s].load(std::memory_order_relaxed);
+        uint64_t emptyWords = 0;
+        unsigned long summaryBit;
+
+        for (uint64_t pending = summary; _BitScanForward64(&summaryBit, pending); pending &= pending - 1)
+        {
+            if (m_freeBits[bitmap.wordOffset + s * 64 + summaryBit].load(std::memory_order_relaxed) == 0)
+                emptyWords |= 1ull << summaryBit;
+        }
 
-        m_freeBlocks[order].insert(right); // Add the right block to the free pool  
+        if (emptyWords != 0)
+            m_summaryBits[bitmap.summaryOffset + s].fetch_and(~emptyWords, std::memory_order_relaxed);
+    }
+}
 
-        offset = left; // Return the left block  
+size_t BuddyAllocator::AllocateBlock(UINT order)
+{
+    // Called with the mutex held
+    if (order > m_maxOrder)
+    {
+        return kInvalidBlock; // Can't allocate a block that large  
     }
 
-    else
+    size_t index = ClaimFreeBlock(order);
+
+    if (index == kInvalidBlock)
     {
-        offset = *it;
+        PruneSummary(order);
 
-        // Remove the block from the free list  
-        m_freeBlocks[order].erase(it);
-    }
+        // No free nodes in the requested pool.  Try to find a higher-order block and split it.  
+        size_t parent = AllocateBlock(order + 1);
 
-    return offset;
-}
+        if (parent == kInvalidBlock)
+            return kInvalidBlock;
 
-void BuddyAllocator::DeallocateBlock(size_t offset, UINT order)
-{
-    // See if the buddy block is free  
-    size_t size = OrderToUnitSize(order);
+        index = parent * 2;
 
-    size_t buddy = GetBuddyOffset(offset, size);
+        ReleaseBlock(index + 1, order); // Add the right block to the free pool  
+    }
 
-    auto it = m_freeBlocks[order].find(buddy);
+    return index;
+}
 
-    if (it != m_freeBlocks[order].end())
+void BuddyAllocator::DeallocateBlock(size_t index, UINT order)
+{
+    // Called with the mutex held.  Taking the buddy's free bit races only with lock-free claims, and the
+    // atomic clear decides who gets it.
+    if (order < m_maxOrder && ClaimBlock(index ^ 1, order))
     {
         // Deallocate merged blocks  
-        DeallocateBlock(min(offset, buddy), order + 1);
-        // Remove the buddy from the free list  
-        m_freeBlocks[order].erase(it);
+        DeallocateBlock(index >> 1, order + 1);
     }
     else
     {
         // Add the block to the free list  
-        m_freeBlocks[order].insert(offset); // throw(std::bad_alloc) 
+        ReleaseBlock(index, order);
     }
 }
 
@@ -171,53 +268,76 @@ BuddyBlock* BuddyAllocator::Allocate(uint32_t numElements, uint32_t elementSize,
     size_t unitSize = SizeToUnitSize(size);
     UINT order = UnitSizeToOrder(unitSize);
 
-    try
-    {
-        size_t offset = AllocateBlock(order);
-        uint32_t paddedSize = uint32_t(OrderToUnitSize(order) * m_minBlockSize);
-
-        uint32_t blockOffset = uint32_t(m_baseOffset + (offset * m_minBlockSize));
+    if (order > m_maxOrder)
+        return new BuddyBlock();
 
-        INCREASE_BUDDY_COUNTER(m_SpaceUsed, paddedSize);
-        INCREASE_BUDDY_COUNTER(m_InternalFragmentation, (paddedSize - size));
+    // Held until the block is in the table and initialized, so compaction sees every block it has to
+    // move and never moves one whose initial data is still being written
+    std::shared_lock<std::shared_timed_mutex> tableLock(m_tableMutex);
 
-        BuddyBlock* pBlock = new BuddyBlock(blockOffset, //offset
-            paddedSize, //total size (padded to fit a block)
-            numElements * elementSize);
-            
-        if (m_allocationStrategy == kBuddyAllocationStrategy::kPlacedResourceStrategy)
-        {
-            pBlock->InitPlaced(m_pBackingHeap, numElements, elementSize, initialData);
-        }
-        else
-        {
-            //TODO: To be truely thread-safe this operation should be atomic to guard against
-            //      the case in which blocks from this allocator are used on multiple threads 
-            //      (because it's really only 1 resource underneath)
-            pBlock->InitFromResource(&m_BackingResource, numElements, elementSize, initialData);
-        }
+    // Fast path:  a free block of the right size already exists
+    size_t index = ClaimFreeBlock(order);
 
-        return pBlock;
+    if (index == kInvalidBlock)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        index = AllocateBlock(order);
     }
 
-    catch (std::bad_alloc&)
+    if (index == kInvalidBlock)
     {
         // There are no blocks available for the requested size so  
         // return the NULL block type  
         return new BuddyBlock();
     }
+
+    size_t offset = index << order;
+    uint32_t paddedSize = uint32_t(OrderToUnitSize(order) * m_minBlockSize);
+
+    uint32_t blockOffset = uint32_t(m_baseOffset + (offset * m_minBlockSize));
+
+    INCREASE_BUDDY_COUNTER(m_SpaceUsed, paddedSize);
+    INCREASE_BUDDY_COUNTER(m_InternalFragmentation, (paddedSize - size));
+
+    BuddyBlock* pBlock = new BuddyBlock(blockOffset, //offset
+        paddedSize, //total size (padded to fit a block)
+        numElements * elementSize);
+
+    m_blockTable[offset] = pBlock;
+
+    if (m_allocationStrategy == kBuddyAllocationStrategy::kPlacedResourceStrategy)
+    {
+        pBlock->InitPlaced(m_pBackingHeap, numElements, elementSize, initialData);
+    }
+    else
+    {
+        //TODO: To be truely thread-safe this operation should be atomic to guard against
+        //      the case in which blocks from this allocator are used on multiple threads 
+        //      (because it's really only 1 resource underneath)
+        pBlock->InitFromResource(&m_BackingResource, numElements, elementSize, initialData);
+    }
+
+    return pBlock;
 }
 
-/*
 void BuddyAllocator::Deallocate(BuddyBlock* pBlock)
 {
-    pBlock->m_fenceValue = g_CommandManager.GetNextFenceValue();
+    if (pBlock->GetSize() == 0)
+    {
+        // Failed allocations own no space
+        delete(pBlock);
+        return;
+    }
+
+    pBlock->m_fenceValue = g_CommandManager.GetGraphicsQueue().GetNextFenceValue();
+
+    std::lock_guard<std::mutex> lock(m_deletionMutex);
     m_deferredDeletionQueue.push(pBlock);
 }
-*/
 
 void BuddyAllocator::DeallocateInternal(BuddyBlock* pBlock)
 {
+    // Called with the mutex held
     ASSERT(IsOwner(*pBlock));
 
     size_t offset = SizeToUnitSize(pBlock->GetOffset() - m_baseOffset);
@@ -226,39 +346,122 @@ void BuddyAllocator::DeallocateInternal(BuddyBlock* pBlock)
 
     UINT order = UnitSizeToOrder(size);
 
-    try
-    {
-        DeallocateBlock(offset, order); // throw(std::bad_alloc)
+    ASSERT(m_blockTable[offset] == pBlock);
+    m_blockTable[offset] = nullptr;
 
-        DECREASE_BUDDY_COUNTER(m_SpaceUsed, size);
-        DECREASE_BUDDY_COUNTER(m_InternalFragmentation, (size - pBlock->m_unpaddedSize));
-        
-        if (m_allocationStrategy == kBuddyAllocationStrategy::kPlacedResourceStrategy)
-        {
-            // Release the resource
-            pBlock->Destroy();
-        }
-        delete(pBlock);
-    }
+    DeallocateBlock(offset >> order, order);
+
+    DECREASE_BUDDY_COUNTER(m_SpaceUsed, pBlock->GetSize());
+    DECREASE_BUDDY_COUNTER(m_InternalFragmentation, (pBlock->GetSize() - pBlock->m_unpaddedSize));
 
-    catch (std::bad_alloc&)
+    if (m_allocationStrategy == kBuddyAllocationStrategy::kPlacedResourceStrategy)
     {
-        // Deallocate failed trying to add the free block to the pool  
-        // resulting in a leak.  Unfortunately there is not much we can do.  
-        // Fortunately this is expected to be extremely rare as the storage  
-        // needed for each deallocate is very small.  
+        // Release the resource
+        pBlock->Destroy();
     }
+    delete(pBlock);
 };
 
-/*
 void BuddyAllocator::CleanUpAllocations()
 {
-    while (m_deferredDeletionQueue.empty() == false &&
-        g_CommandManager.IsFenceComplete(m_deferredDeletionQueue.front()->m_fenceValue))
+    // Pull every retired block off the queue first, then merge them all under one lock
+    std::vector<BuddyBlock*> retiredBlocks;
+
     {
-        BuddyBlock* pBlock = m_deferredDeletionQueue.front();
-        m_deferredDeletionQueue.pop();
+        std::lock_guard<std::mutex> lock(m_deletionMutex);
+
+        while (m_deferredDeletionQueue.empty() == false &&
+            g_CommandManager.IsFenceComplete(m_deferredDeletionQueue.front()->m_fenceValue))
+        {
+            retiredBlocks.push_back(m_deferredDeletionQueue.front());
+            m_deferredDeletionQueue.pop();
+        }
+    }
+
+    if (retiredBlocks.empty())
+        return;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
 
+    for (BuddyBlock* pBlock : retiredBlocks)
         DeallocateInternal(pBlock);
+}
+
+size_t BuddyAllocator::Compact(void)
+{
+    // Placed resources would need new resources and aliasing barriers to move
+    ASSERT(m_allocationStrategy == kBuddyAllocationStrategy::kManualSubAllocationStrategy,
+        "Only manually sub-allocated pools can be compacted");
+
+    // Waits for allocations in flight and holds off new ones until the blocks have been moved
+    std::unique_lock<std::shared_timed_mutex> tableLock(m_tableMutex);
+
+    g_CommandManager.IdleGPU();
+    CleanUpAllocations();
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    const size_t unitCount = OrderToUnitSize(m_maxOrder);
+    std::vector<BuddyBlock*> liveBlocks;
+    for (size_t unit = 0; unit < unitCount; ++unit)
+    {
+        if (m_blockTable[unit] != nullptr)
+            liveBlocks.push_back(m_blockTable[unit]);
+    }
+
+    // Placing the largest blocks first packs a buddy heap without gaps
+    std::stable_sort(liveBlocks.begin(), liveBlocks.end(),
+        [](const BuddyBlock* a, const BuddyBlock* b) { return a->GetSize() > b->GetSize(); });
+
+    ResetBitmaps();
+
+    struct BlockMove
+    {
+        BuddyBlock* pBlock;
+        size_t oldOffset;
+    };
+    std::vector<BlockMove> moves;
+    size_t bytesMoved = 0;
+
+    for (BuddyBlock* pBlock : liveBlocks)
+    {
+        UINT order = UnitSizeToOrder(SizeToUnitSize(pBlock->GetSize()));
+        size_t index = AllocateBlock(order);
+        ASSERT(index != kInvalidBlock, "Compaction cannot run out of space");
+
+        size_t offset = index << order;
+        size_t blockOffset = m_baseOffset + offset * m_minBlockSize;
+        m_blockTable[offset] = pBlock;
+
+        if (blockOffset != pBlock->m_offset)
+        {
+            moves.push_back({ pBlock, pBlock->m_offset });
+            pBlock->m_offset = blockOffset;
+            bytesMoved += pBlock->m_unpaddedSize;
+        }
     }
-}*/
+
+    if (moves.empty())
+        return 0;
+
+    // Source and destination ranges can overlap, so stage the moved blocks through a scratch buffer
+    ByteAddressBuffer scratch;
+    scratch.Create(L"Buddy Allocator Compaction Scratch", uint32_t(m_maxBlockSize), 1);
+
+    CommandContext& Context = CommandContext::Begin(L"Buddy Allocator Compaction");
+
+    Context.TransitionResource(m_BackingResource, D3D12_RESOURCE_STATE_COPY_SOURCE);
+    for (const BlockMove& move : moves)
+        Context.CopyBufferRegion(scratch, move.oldOffset - m_baseOffset, m_BackingResource, move.oldOffset, move.pBlock->m_unpaddedSize);
+
+    Context.TransitionResource(scratch, D3D12_RESOURCE_STATE_COPY_SOURCE);
+    for (const BlockMove& move : moves)
+        Context.CopyBufferRegion(m_BackingResource, move.pBlock->m_offset, scratch, move.oldOffset - m_baseOffset, move.pBlock->m_unpaddedSize);
+
+    Context.TransitionResource(m_BackingResource, D3D12_RESOURCE_STATE_GENERIC_READ, true);
+    Context.Finish(true);
+
+    scratch.Destroy();
+
+    return bytesMoved;
+}
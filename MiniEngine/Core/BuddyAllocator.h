@@ -16,6 +16,12 @@
 // When a block is de-allocated an attempt is made to merge it with it's 
 // neighbour (buddy) if it is contiguous and free.
 // Based on reference implementation by Bill Kristiansen
+//
+// Free blocks are tracked with one bit per block and order, plus a summary bit per 64-bit word of
+// free bits, so finding a free block is a couple of bit scans.  Claiming a free block of the
+// requested order is lock-free; splitting larger blocks and merging buddies on free take a mutex.
+// Allocations share a reader lock that Compact() and Reset() take exclusively, so they never see
+// a claim that hasn't been published to the block table yet.
 //  
 
 #pragma once
@@ -24,14 +30,16 @@
 #include <vector>
 #include <queue>
 #include <mutex>
-#include <set>
+#include <shared_mutex>
+#include <atomic>
+#include <memory>
 
 // Unfortunately the api restricts the minimum size of a placed buffer resource to 64k
 #define MIN_PLACED_BUFFER_SIZE (64 * 1024)
 
 #if defined(PROFILE) || defined(_DEBUG)
-#define INCREASE_BUDDY_COUNTER(A, B) (A = A + B);
-#define DECREASE_BUDDY_COUNTER(A, B) (A = A - B);
+#define INCREASE_BUDDY_COUNTER(A, B) (A += B);
+#define DECREASE_BUDDY_COUNTER(A, B) (A -= B);
 #else
 #define INCREASE_BUDDY_COUNTER(A, B)
 #define DECREASE_BUDDY_COUNTER(A, B)
@@ -85,8 +93,10 @@ public:
 
     void Destroy();
 
+    // Safe to call from multiple threads.  Returns an empty block (null buffer) when out of space.
     BuddyBlock* Allocate(uint32_t numElements, uint32_t elementSize, const void* initialData = nullptr);
 
+    // Queues the block for release once the GPU has finished with it.  See CleanUpAllocations().
     void Deallocate(BuddyBlock* pBlock);
 
     inline bool IsOwner(const BuddyBlock &block)
@@ -94,18 +104,18 @@ public:
         return block.GetOffset() >= m_baseOffset && block.GetSize() <= m_maxBlockSize;
     }
 
-    inline void Reset()
-    {
-        // Clear the free blocks collection  
-        m_freeBlocks.clear();
-
-        // Initialize the pool with a free inner block of max inner block size  
-        m_freeBlocks.resize(m_maxOrder + 1);
-        m_freeBlocks[m_maxOrder].insert((size_t)0);
-    }
+    // Marks the whole range free.  Outstanding blocks are abandoned, not released.
+    void Reset();
 
+    // Releases every deferred block whose fence has completed.
     void CleanUpAllocations();
 
+    // Moves the live blocks of a manually sub-allocated pool to the front of the backing buffer with
+    // CopyBufferRegion, which coalesces the free space.  Waits for the GPU to go idle, and for
+    // allocations in flight on other threads, which block until it finishes.  Block offsets change, so
+    // views of moved blocks need rebuilding.  Returns the number of bytes moved.
+    size_t Compact(void);
+
 private:
     ID3D12Heap* m_pBackingHeap;
     ByteAddressBuffer m_BackingResource;
@@ -113,7 +123,26 @@ private:
     const D3D12_HEAP_TYPE m_heapType;
 
     std::queue<BuddyBlock*> m_deferredDeletionQueue;
-    std::vector<std::set<size_t>> m_freeBlocks;
+    std::mutex m_deletionMutex;
+
+    // Where the free bits and summary bits of one order start in the shared arrays
+    struct OrderBitmap
+    {
+        size_t wordOffset;
+        size_t wordCount;
+        size_t summaryOffset;
+        size_t summaryCount;
+    };
+
+    std::vector<OrderBitmap> m_orderBitmaps;
+    std::unique_ptr<std::atomic<uint64_t>[]> m_freeBits;
+    std::unique_ptr<std::atomic<uint64_t>[]> m_summaryBits;
+    // Live block starting at each unit, used by Compact().  Only the owner of a unit writes its slot.
+    std::unique_ptr<BuddyBlock*[]> m_blockTable;
+    std::mutex m_mutex;
+    // Shared from claiming a block until it is in the table and initialized, exclusive while the
+    // bitmaps and the table are rebuilt
+    std::shared_timed_mutex m_tableMutex;
     UINT m_maxOrder;
     const size_t m_baseOffset;
     const size_t m_maxBlockSize;
@@ -138,12 +167,20 @@ private:
 
     void DeallocateInternal(BuddyBlock* pBlock);
 
+    static const size_t kInvalidBlock = ~(size_t)0;
+
     size_t OrderToUnitSize(UINT order) const { return ((size_t)1) << order; }
+    // Block indices are in units of the order's block size
+    size_t ClaimFreeBlock(UINT order);
+    bool ClaimBlock(size_t index, UINT order);
+    void ReleaseBlock(size_t index, UINT order);
+    void PruneSummary(UINT order);
+    void ResetBitmaps();
     size_t AllocateBlock(UINT order);
-    void DeallocateBlock(size_t offset, UINT order);
+    void DeallocateBlock(size_t index, UINT order);
 
 #if defined(PROFILE) || defined(_DEBUG)
-    size_t m_SpaceUsed;
-    size_t m_InternalFragmentation;
+    std::atomic<size_t> m_SpaceUsed;
+    std::atomic<size_t> m_InternalFragmentation;
 #endif
 };
@@ -16,24 +16,32 @@
 #include "GraphicsCore.h"
 #include "CommandContext.h"
 #include "EsramAllocator.h"
+#include "TransientHeap.h"
 #include "TemporalEffects.h"
+#include "HiZ.h"
 
 namespace Graphics
 {
     DepthBuffer g_SceneDepthBuffer;
     ColorBuffer g_SceneColorBuffer;
+    DepthBuffer g_SceneDepthBufferMSAA;
+    ColorBuffer g_SceneColorBufferMSAA;
     ColorBuffer g_PostEffectsBuffer;
     ColorBuffer g_VelocityBuffer;
+    ColorBuffer g_VelocityTileMax;
     ColorBuffer g_OverlayBuffer;
     ColorBuffer g_HorizontalBuffer;
 
     ShadowBuffer g_ShadowBuffer;
 
     ColorBuffer g_SSAOFullScreen(Color(1.0f, 1.0f, 1.0f));
+    ColorBuffer g_SSAOHistory[2];
     ColorBuffer g_LinearDepth[2];
     ColorBuffer g_MinMaxDepth8;
     ColorBuffer g_MinMaxDepth16;
     ColorBuffer g_MinMaxDepth32;
+    ColorBuffer g_HiZMinDepth;
+    ColorBuffer g_HiZMaxDepth;
     ColorBuffer g_DepthDownsize1;
     ColorBuffer g_DepthDownsize2;
     ColorBuffer g_DepthDownsize3;
@@ -53,17 +61,19 @@ namespace Graphics
     ColorBuffer g_AOHighQuality2;
     ColorBuffer g_AOHighQuality3;
     ColorBuffer g_AOHighQuality4;
+    ColorBuffer g_AOUnresolved;
 
     ColorBuffer g_DoFTileClass[2];
     ColorBuffer g_DoFPresortBuffer;
     ColorBuffer g_DoFPrefilter;
     ColorBuffer g_DoFBlurColor[2];
     ColorBuffer g_DoFBlurAlpha[2];
-    StructuredBuffer g_DoFWorkQueue;
-    StructuredBuffer g_DoFFastQueue;
+    StructuredBuffer g_DoFWorkQueue[3];
+    StructuredBuffer g_DoFFastQueue[3];
     StructuredBuffer g_DoFFixupQueue;
 
     ColorBuffer g_MotionPrepBuffer;
+    StructuredBuffer g_MotionBlurTileQueue;
     ColorBuffer g_LumaBuffer;
     ColorBuffer g_TemporalColor[2];
     ColorBuffer g_aBloomUAV1[2];    // 640x384 (1/3)
@@ -76,16 +86,21 @@ namespace Graphics
     ByteAddressBuffer g_FXAAWorkCounters;
     ByteAddressBuffer g_FXAAWorkQueue;
     TypedBuffer g_FXAAColorQueue(DXGI_FORMAT_R11G11B10_FLOAT);
+    StructuredBuffer g_FXAATileQueue;
 
     // For testing GenerateMipMaps()
     ColorBuffer g_GenMipsBuffer;
 
     DXGI_FORMAT DefaultHdrColorFormat = DXGI_FORMAT_R11G11B10_FLOAT;
+
+    TransientHeap s_TransientHeap;
+    EsramAllocator s_Esram;
 }
 
 #define T2X_COLOR_FORMAT DXGI_FORMAT_R10G10B10A2_UNORM
 #define HDR_MOTION_FORMAT DXGI_FORMAT_R16G16B16A16_FLOAT
 #define DSV_FORMAT DXGI_FORMAT_D32_FLOAT
+#define SCENE_MSAA_SAMPLES 4
 
 void Graphics::InitializeRenderingBuffers( uint32_t bufferWidth, uint32_t bufferHeight )
 {
@@ -104,12 +119,17 @@ void Graphics::InitializeRenderingBuffers( uint32_t bufferWidth, uint32_t buffer
     const uint32_t bufferHeight5 = (bufferHeight + 31) / 32;
     const uint32_t bufferHeight6 = (bufferHeight + 63) / 64;
 
-    EsramAllocator esram;
+    EsramAllocator& esram = s_Esram;
+
+    // Recreating the buffers for a new resolution starts the heaps over
+    s_TransientHeap.Destroy();
+    esram.Destroy();
 
     esram.PushStack();
 
         g_SceneColorBuffer.Create( L"Main Color Buffer", bufferWidth, bufferHeight, 1, DefaultHdrColorFormat, esram );
         g_VelocityBuffer.Create( L"Motion Vectors", bufferWidth, bufferHeight, 1, DXGI_FORMAT_R32_UINT );
+        g_VelocityTileMax.Create( L"Velocity Tile Max", bufferWidth4, bufferHeight4, 1, DXGI_FORMAT_R16_FLOAT );
         g_PostEffectsBuffer.Create( L"Post Effects Buffer", bufferWidth, bufferHeight, 1, DXGI_FORMAT_R32_UINT );
 
         esram.PushStack();    // Render HDR image
@@ -122,50 +142,73 @@ void Graphics::InitializeRenderingBuffers( uint32_t bufferWidth, uint32_t buffer
 
             g_SceneDepthBuffer.Create( L"Scene Depth Buffer", bufferWidth, bufferHeight, DSV_FORMAT, esram );
 
+            // Forward rendering targets of MSAAResolve::Enable.  They are too large for ESRAM.
+            g_SceneDepthBufferMSAA.Create( L"Scene Depth Buffer MSAA", bufferWidth, bufferHeight, SCENE_MSAA_SAMPLES, DSV_FORMAT );
+            g_SceneColorBufferMSAA.SetMsaaMode(SCENE_MSAA_SAMPLES, SCENE_MSAA_SAMPLES);
+            g_SceneColorBufferMSAA.Create( L"Main Color Buffer MSAA", bufferWidth, bufferHeight, 1, DefaultHdrColorFormat );
+
+            // The pyramids outlive the frame (culling reads last frame's), so they don't share memory
+            const uint32_t HiZMipCount = HiZ::ComputeMipCount(bufferWidth1, bufferHeight1);
+            g_HiZMinDepth.Create( L"Hi-Z Min Depth", bufferWidth1, bufferHeight1, HiZMipCount, DXGI_FORMAT_R32_FLOAT );
+            g_HiZMaxDepth.Create( L"Hi-Z Max Depth", bufferWidth1, bufferHeight1, HiZMipCount, DXGI_FORMAT_R32_FLOAT );
+
             esram.PushStack(); // Begin opaque geometry
 
                 esram.PushStack();    // Begin Shading
 
                     g_SSAOFullScreen.Create( L"SSAO Full Res", bufferWidth, bufferHeight, 1, DXGI_FORMAT_R8_UNORM );
+                    g_SSAOHistory[0].Create( L"SSAO History 0", bufferWidth, bufferHeight, 1, DXGI_FORMAT_R8_UNORM );
+                    g_SSAOHistory[1].Create( L"SSAO History 1", bufferWidth, bufferHeight, 1, DXGI_FORMAT_R8_UNORM );
 
                     esram.PushStack();    // Begin generating SSAO
-                        g_DepthDownsize1.Create( L"Depth Down-Sized 1", bufferWidth1, bufferHeight1, 1, DXGI_FORMAT_R32_FLOAT, esram );
-                        g_DepthDownsize2.Create( L"Depth Down-Sized 2", bufferWidth2, bufferHeight2, 1, DXGI_FORMAT_R32_FLOAT, esram );
-                        g_DepthDownsize3.Create( L"Depth Down-Sized 3", bufferWidth3, bufferHeight3, 1, DXGI_FORMAT_R32_FLOAT, esram );
-                        g_DepthDownsize4.Create( L"Depth Down-Sized 4", bufferWidth4, bufferHeight4, 1, DXGI_FORMAT_R32_FLOAT, esram );
-                        g_DepthTiled1.CreateArray( L"Depth De-Interleaved 1", bufferWidth3, bufferHeight3, 16, DXGI_FORMAT_R16_FLOAT, esram );
-                        g_DepthTiled2.CreateArray( L"Depth De-Interleaved 2", bufferWidth4, bufferHeight4, 16, DXGI_FORMAT_R16_FLOAT, esram );
-                        g_DepthTiled3.CreateArray( L"Depth De-Interleaved 3", bufferWidth5, bufferHeight5, 16, DXGI_FORMAT_R16_FLOAT, esram );
-                        g_DepthTiled4.CreateArray( L"Depth De-Interleaved 4", bufferWidth6, bufferHeight6, 16, DXGI_FORMAT_R16_FLOAT, esram );
-                        g_AOMerged1.Create( L"AO Re-Interleaved 1", bufferWidth1, bufferHeight1, 1, DXGI_FORMAT_R8_UNORM, esram );
-                        g_AOMerged2.Create( L"AO Re-Interleaved 2", bufferWidth2, bufferHeight2, 1, DXGI_FORMAT_R8_UNORM, esram );
-                        g_AOMerged3.Create( L"AO Re-Interleaved 3", bufferWidth3, bufferHeight3, 1, DXGI_FORMAT_R8_UNORM, esram );
-                        g_AOMerged4.Create( L"AO Re-Interleaved 4", bufferWidth4, bufferHeight4, 1, DXGI_FORMAT_R8_UNORM, esram );
-                        g_AOSmooth1.Create( L"AO Smoothed 1", bufferWidth1, bufferHeight1, 1, DXGI_FORMAT_R8_UNORM, esram );
-                        g_AOSmooth2.Create( L"AO Smoothed 2", bufferWidth2, bufferHeight2, 1, DXGI_FORMAT_R8_UNORM, esram );
-                        g_AOSmooth3.Create( L"AO Smoothed 3", bufferWidth3, bufferHeight3, 1, DXGI_FORMAT_R8_UNORM, esram );
-                        g_AOHighQuality1.Create( L"AO High Quality 1", bufferWidth1, bufferHeight1, 1, DXGI_FORMAT_R8_UNORM, esram );
-                        g_AOHighQuality2.Create( L"AO High Quality 2", bufferWidth2, bufferHeight2, 1, DXGI_FORMAT_R8_UNORM, esram );
-                        g_AOHighQuality3.Create( L"AO High Quality 3", bufferWidth3, bufferHeight3, 1, DXGI_FORMAT_R8_UNORM, esram );
-                        g_AOHighQuality4.Create( L"AO High Quality 4", bufferWidth4, bufferHeight4, 1, DXGI_FORMAT_R8_UNORM, esram );
+                    s_TransientHeap.BeginGroup(kTransientSSAO);
+                        g_DepthDownsize1.Create( L"Depth Down-Sized 1", bufferWidth1, bufferHeight1, 1, DXGI_FORMAT_R32_FLOAT, s_TransientHeap );
+                        g_DepthDownsize2.Create( L"Depth Down-Sized 2", bufferWidth2, bufferHeight2, 1, DXGI_FORMAT_R32_FLOAT, s_TransientHeap );
+                        g_DepthDownsize3.Create( L"Depth Down-Sized 3", bufferWidth3, bufferHeight3, 1, DXGI_FORMAT_R32_FLOAT, s_TransientHeap );
+                        g_DepthDownsize4.Create( L"Depth Down-Sized 4", bufferWidth4, bufferHeight4, 1, DXGI_FORMAT_R32_FLOAT, s_TransientHeap );
+                        g_DepthTiled1.CreateArray( L"Depth De-Interleaved 1", bufferWidth3, bufferHeight3, 16, DXGI_FORMAT_R16_FLOAT, s_TransientHeap );
+                        g_DepthTiled2.CreateArray( L"Depth De-Interleaved 2", bufferWidth4, bufferHeight4, 16, DXGI_FORMAT_R16_FLOAT, s_TransientHeap );
+                        g_DepthTiled3.CreateArray( L"Depth De-Interleaved 3", bufferWidth5, bufferHeight5, 16, DXGI_FORMAT_R16_FLOAT, s_TransientHeap );
+                        g_DepthTiled4.CreateArray( L"Depth De-Interleaved 4", bufferWidth6, bufferHeight6, 16, DXGI_FORMAT_R16_FLOAT, s_TransientHeap );
+                        g_AOMerged1.Create( L"AO Re-Interleaved 1", bufferWidth1, bufferHeight1, 1, DXGI_FORMAT_R8_UNORM, s_TransientHeap );
+                        g_AOMerged2.Create( L"AO Re-Interleaved 2", bufferWidth2, bufferHeight2, 1, DXGI_FORMAT_R8_UNORM, s_TransientHeap );
+                        g_AOMerged3.Create( L"AO Re-Interleaved 3", bufferWidth3, bufferHeight3, 1, DXGI_FORMAT_R8_UNORM, s_TransientHeap );
+                        g_AOMerged4.Create( L"AO Re-Interleaved 4", bufferWidth4, bufferHeight4, 1, DXGI_FORMAT_R8_UNORM, s_TransientHeap );
+                        g_AOSmooth1.Create( L"AO Smoothed 1", bufferWidth1, bufferHeight1, 1, DXGI_FORMAT_R8_UNORM, s_TransientHeap );
+                        g_AOSmooth2.Create( L"AO Smoothed 2", bufferWidth2, bufferHeight2, 1, DXGI_FORMAT_R8_UNORM, s_TransientHeap );
+                        g_AOSmooth3.Create( L"AO Smoothed 3", bufferWidth3, bufferHeight3, 1, DXGI_FORMAT_R8_UNORM, s_TransientHeap );
+                        g_AOHighQuality1.Create( L"AO High Quality 1", bufferWidth1, bufferHeight1, 1, DXGI_FORMAT_R8_UNORM, s_TransientHeap );
+                        g_AOHighQuality2.Create( L"AO High Quality 2", bufferWidth2, bufferHeight2, 1, DXGI_FORMAT_R8_UNORM, s_TransientHeap );
+                        g_AOHighQuality3.Create( L"AO High Quality 3", bufferWidth3, bufferHeight3, 1, DXGI_FORMAT_R8_UNORM, s_TransientHeap );
+                        g_AOHighQuality4.Create( L"AO High Quality 4", bufferWidth4, bufferHeight4, 1, DXGI_FORMAT_R8_UNORM, s_TransientHeap );
+                        g_AOUnresolved.Create( L"AO Unresolved", bufferWidth, bufferHeight, 1, DXGI_FORMAT_R8_UNORM, s_TransientHeap );
+                    s_TransientHeap.EndGroup();
                     esram.PopStack();    // End generating SSAO
 
                     g_ShadowBuffer.Create( L"Shadow Map", 2048, 2048, esram );
 
                 esram.PopStack();    // End Shading
 
-                esram.PushStack();    // Begin depth of field
-                    g_DoFTileClass[0].Create(L"DoF Tile Classification Buffer 0", bufferWidth4, bufferHeight4, 1, DXGI_FORMAT_R11G11B10_FLOAT);
-                    g_DoFTileClass[1].Create(L"DoF Tile Classification Buffer 1", bufferWidth4, bufferHeight4, 1, DXGI_FORMAT_R11G11B10_FLOAT);
-
-                    g_DoFPresortBuffer.Create(L"DoF Presort Buffer", bufferWidth1, bufferHeight1, 1, DXGI_FORMAT_R11G11B10_FLOAT, esram );
-                    g_DoFPrefilter.Create(L"DoF PreFilter Buffer", bufferWidth1, bufferHeight1, 1, DXGI_FORMAT_R11G11B10_FLOAT, esram );
-                    g_DoFBlurColor[0].Create(L"DoF Blur Color", bufferWidth1, bufferHeight1, 1, DXGI_FORMAT_R11G11B10_FLOAT, esram );
-                    g_DoFBlurColor[1].Create(L"DoF Blur Color", bufferWidth1, bufferHeight1, 1, DXGI_FORMAT_R11G11B10_FLOAT, esram );
-                    g_DoFBlurAlpha[0].Create(L"DoF FG Alpha", bufferWidth1, bufferHeight1, 1, DXGI_FORMAT_R8_UNORM, esram );
-                    g_DoFBlurAlpha[1].Create(L"DoF FG Alpha", bufferWidth1, bufferHeight1, 1, DXGI_FORMAT_R8_UNORM, esram );
-                    g_DoFWorkQueue.Create(L"DoF Work Queue", bufferWidth4 * bufferHeight4, 4, esram );
-                    g_DoFFastQueue.Create(L"DoF Fast Queue", bufferWidth4 * bufferHeight4, 4, esram );
+                esram.PushStack(kTransientDepthOfField);    // Begin depth of field
+                    s_TransientHeap.BeginGroup(kTransientDepthOfField);
+                    g_DoFTileClass[0].Create(L"DoF Tile Classification Buffer 0", bufferWidth4, bufferHeight4, 1, DXGI_FORMAT_R11G11B10_FLOAT, s_TransientHeap);
+                    g_DoFTileClass[1].Create(L"DoF Tile Classification Buffer 1", bufferWidth4, bufferHeight4, 1, DXGI_FORMAT_R11G11B10_FLOAT, s_TransientHeap);
+
+                    g_DoFPresortBuffer.Create(L"DoF Presort Buffer", bufferWidth1, bufferHeight1, 1, DXGI_FORMAT_R11G11B10_FLOAT, s_TransientHeap );
+                    g_DoFPrefilter.Create(L"DoF PreFilter Buffer", bufferWidth1, bufferHeight1, 1, DXGI_FORMAT_R11G11B10_FLOAT, s_TransientHeap );
+                    g_DoFBlurColor[0].Create(L"DoF Blur Color", bufferWidth1, bufferHeight1, 1, DXGI_FORMAT_R11G11B10_FLOAT, s_TransientHeap );
+                    g_DoFBlurColor[1].Create(L"DoF Blur Color", bufferWidth1, bufferHeight1, 1, DXGI_FORMAT_R11G11B10_FLOAT, s_TransientHeap );
+                    g_DoFBlurAlpha[0].Create(L"DoF FG Alpha", bufferWidth1, bufferHeight1, 1, DXGI_FORMAT_R8_UNORM, s_TransientHeap );
+                    g_DoFBlurAlpha[1].Create(L"DoF FG Alpha", bufferWidth1, bufferHeight1, 1, DXGI_FORMAT_R8_UNORM, s_TransientHeap );
+                    s_TransientHeap.EndGroup();
+
+                    // The work queues are buffers, which can't share a heap with render targets on every device
+                    g_DoFWorkQueue[0].Create(L"DoF Work Queue 1", bufferWidth4 * bufferHeight4, 4, esram );
+                    g_DoFWorkQueue[1].Create(L"DoF Work Queue 2", bufferWidth4 * bufferHeight4, 4, esram );
+                    g_DoFWorkQueue[2].Create(L"DoF Work Queue 3", bufferWidth4 * bufferHeight4, 4, esram );
+                    g_DoFFastQueue[0].Create(L"DoF Fast Queue 1", bufferWidth4 * bufferHeight4, 4, esram );
+                    g_DoFFastQueue[1].Create(L"DoF Fast Queue 2", bufferWidth4 * bufferHeight4, 4, esram );
+                    g_DoFFastQueue[2].Create(L"DoF Fast Queue 3", bufferWidth4 * bufferHeight4, 4, esram );
                     g_DoFFixupQueue.Create(L"DoF Fixup Queue", bufferWidth4 * bufferHeight4, 4, esram );
                 esram.PopStack();    // End depth of field
 
@@ -173,15 +216,19 @@ void Graphics::InitializeRenderingBuffers( uint32_t bufferWidth, uint32_t buffer
                 g_TemporalColor[1].Create( L"Temporal Color 1", bufferWidth, bufferHeight, 1, DXGI_FORMAT_R16G16B16A16_FLOAT);
                 TemporalEffects::ClearHistory(InitContext);
 
-                esram.PushStack();    // Begin motion blur
-                    g_MotionPrepBuffer.Create( L"Motion Blur Prep", bufferWidth1, bufferHeight1, 1, HDR_MOTION_FORMAT, esram );
+                esram.PushStack(kTransientMotionBlur);    // Begin motion blur
+                    s_TransientHeap.BeginGroup(kTransientMotionBlur);
+                    g_MotionPrepBuffer.Create( L"Motion Blur Prep", bufferWidth1, bufferHeight1, 1, HDR_MOTION_FORMAT, s_TransientHeap );
+                    s_TransientHeap.EndGroup();
+
+                    g_MotionBlurTileQueue.Create(L"Motion Blur Tile Queue", bufferWidth4 * bufferHeight4, 4, esram );
                 esram.PopStack();    // End motion blur
 
             esram.PopStack();    // End opaque geometry
 
         esram.PopStack();    // End HDR image
 
-        esram.PushStack();    // Begin post processing
+        esram.PushStack(kTransientBloom);    // Begin post processing
 
             // This is useful for storing per-pixel weights such as motion strength or pixel luminance
             g_LumaBuffer.Create( L"Luminance", bufferWidth, bufferHeight, 1, DXGI_FORMAT_R8_UNORM, esram );
@@ -195,24 +242,28 @@ void Graphics::InitializeRenderingBuffers( uint32_t bufferWidth, uint32_t buffer
             uint32_t kBloomHeight = bufferHeight > 1440 ? 768 : 384;
 
             esram.PushStack();    // Begin bloom and tone mapping
-                g_LumaLR.Create( L"Luma Buffer", kBloomWidth, kBloomHeight, 1, DXGI_FORMAT_R8_UINT, esram );
-                g_aBloomUAV1[0].Create( L"Bloom Buffer 1a", kBloomWidth,    kBloomHeight,    1, DefaultHdrColorFormat, esram );
-                g_aBloomUAV1[1].Create( L"Bloom Buffer 1b", kBloomWidth,    kBloomHeight,    1, DefaultHdrColorFormat, esram);
-                g_aBloomUAV2[0].Create( L"Bloom Buffer 2a", kBloomWidth/2,  kBloomHeight/2,  1, DefaultHdrColorFormat, esram );
-                g_aBloomUAV2[1].Create( L"Bloom Buffer 2b", kBloomWidth/2,  kBloomHeight/2,  1, DefaultHdrColorFormat, esram );
-                g_aBloomUAV3[0].Create( L"Bloom Buffer 3a", kBloomWidth/4,  kBloomHeight/4,  1, DefaultHdrColorFormat, esram );
-                g_aBloomUAV3[1].Create( L"Bloom Buffer 3b", kBloomWidth/4,  kBloomHeight/4,  1, DefaultHdrColorFormat, esram );
-                g_aBloomUAV4[0].Create( L"Bloom Buffer 4a", kBloomWidth/8,  kBloomHeight/8,  1, DefaultHdrColorFormat, esram );
-                g_aBloomUAV4[1].Create( L"Bloom Buffer 4b", kBloomWidth/8,  kBloomHeight/8,  1, DefaultHdrColorFormat, esram );
-                g_aBloomUAV5[0].Create( L"Bloom Buffer 5a", kBloomWidth/16, kBloomHeight/16, 1, DefaultHdrColorFormat, esram );
-                g_aBloomUAV5[1].Create( L"Bloom Buffer 5b", kBloomWidth/16, kBloomHeight/16, 1, DefaultHdrColorFormat, esram );
+                s_TransientHeap.BeginGroup(kTransientBloom);
+                g_LumaLR.Create( L"Luma Buffer", kBloomWidth, kBloomHeight, 1, DXGI_FORMAT_R8_UINT, s_TransientHeap );
+                g_aBloomUAV1[0].Create( L"Bloom Buffer 1a", kBloomWidth,    kBloomHeight,    1, DefaultHdrColorFormat, s_TransientHeap );
+                g_aBloomUAV1[1].Create( L"Bloom Buffer 1b", kBloomWidth,    kBloomHeight,    1, DefaultHdrColorFormat, s_TransientHeap);
+                g_aBloomUAV2[0].Create( L"Bloom Buffer 2a", kBloomWidth/2,  kBloomHeight/2,  1, DefaultHdrColorFormat, s_TransientHeap );
+                g_aBloomUAV2[1].Create( L"Bloom Buffer 2b", kBloomWidth/2,  kBloomHeight/2,  1, DefaultHdrColorFormat, s_TransientHeap );
+                g_aBloomUAV3[0].Create( L"Bloom Buffer 3a", kBloomWidth/4,  kBloomHeight/4,  1, DefaultHdrColorFormat, s_TransientHeap );
+                g_aBloomUAV3[1].Create( L"Bloom Buffer 3b", kBloomWidth/4,  kBloomHeight/4,  1, DefaultHdrColorFormat, s_TransientHeap );
+                g_aBloomUAV4[0].Create( L"Bloom Buffer 4a", kBloomWidth/8,  kBloomHeight/8,  1, DefaultHdrColorFormat, s_TransientHeap );
+                g_aBloomUAV4[1].Create( L"Bloom Buffer 4b", kBloomWidth/8,  kBloomHeight/8,  1, DefaultHdrColorFormat, s_TransientHeap );
+                g_aBloomUAV5[0].Create( L"Bloom Buffer 5a", kBloomWidth/16, kBloomHeight/16, 1, DefaultHdrColorFormat, s_TransientHeap );
+                g_aBloomUAV5[1].Create( L"Bloom Buffer 5b", kBloomWidth/16, kBloomHeight/16, 1, DefaultHdrColorFormat, s_TransientHeap );
+                s_TransientHeap.EndGroup();
             esram.PopStack();    // End tone mapping
 
-            esram.PushStack();    // Begin antialiasing
+            esram.PushStack(kTransientBloom);    // Begin antialiasing
                 const uint32_t kFXAAWorkSize = bufferWidth * bufferHeight / 4 + 128;
                 g_FXAAWorkQueue.Create( L"FXAA Work Queue", kFXAAWorkSize, sizeof(uint32_t), esram );
                 g_FXAAColorQueue.Create( L"FXAA Color Queue", kFXAAWorkSize, sizeof(uint32_t), esram );
                 g_FXAAWorkCounters.Create(L"FXAA Work Counters", 2, sizeof(uint32_t));
+                const uint32_t kFXAATileCount = ((bufferWidth / 2 + 7) / 8) * ((bufferHeight / 2 + 7) / 8);
+                g_FXAATileQueue.Create( L"FXAA Tile Queue", kFXAATileCount, sizeof(uint32_t), esram );
                 InitContext.ClearUAV(g_FXAAWorkCounters);
             esram.PopStack();    // End antialiasing
 
@@ -227,9 +278,18 @@ void Graphics::InitializeRenderingBuffers( uint32_t bufferWidth, uint32_t buffer
 
     esram.PopStack(); // End final image
 
+    s_TransientHeap.Finalize(L"Transient Rendering Buffers");
+    esram.Finalize(L"ESRAM Rendering Buffers");
+
     InitContext.Finish();
 }
 
+void Graphics::AcquireTransientBuffers( CommandContext& Context, TransientBufferGroup Group )
+{
+    s_TransientHeap.Acquire(Context, Group);
+    s_Esram.Acquire(Context, Group);
+}
+
 void Graphics::ResizeDisplayDependentBuffers(uint32_t /*NativeWidth*/, uint32_t NativeHeight)
 {
     g_OverlayBuffer.Create( L"UI Overlay", g_DisplayWidth, g_DisplayHeight, 1, DXGI_FORMAT_R8G8B8A8_UNORM );
@@ -240,7 +300,10 @@ void Graphics::DestroyRenderingBuffers()
 {
     g_SceneDepthBuffer.Destroy();
     g_SceneColorBuffer.Destroy();
+    g_SceneDepthBufferMSAA.Destroy();
+    g_SceneColorBufferMSAA.Destroy();
     g_VelocityBuffer.Destroy();
+    g_VelocityTileMax.Destroy();
     g_OverlayBuffer.Destroy();
     g_HorizontalBuffer.Destroy();
     g_PostEffectsBuffer.Destroy();
@@ -248,11 +311,15 @@ void Graphics::DestroyRenderingBuffers()
     g_ShadowBuffer.Destroy();
 
     g_SSAOFullScreen.Destroy();
+    g_SSAOHistory[0].Destroy();
+    g_SSAOHistory[1].Destroy();
     g_LinearDepth[0].Destroy();
     g_LinearDepth[1].Destroy();
     g_MinMaxDepth8.Destroy();
     g_MinMaxDepth16.Destroy();
     g_MinMaxDepth32.Destroy();
+    g_HiZMinDepth.Destroy();
+    g_HiZMaxDepth.Destroy();
     g_DepthDownsize1.Destroy();
     g_DepthDownsize2.Destroy();
     g_DepthDownsize3.Destroy();
@@ -272,6 +339,7 @@ void Graphics::DestroyRenderingBuffers()
     g_AOHighQuality2.Destroy();
     g_AOHighQuality3.Destroy();
     g_AOHighQuality4.Destroy();
+    g_AOUnresolved.Destroy();
 
     g_DoFTileClass[0].Destroy();
     g_DoFTileClass[1].Destroy();
@@ -281,11 +349,16 @@ void Graphics::DestroyRenderingBuffers()
     g_DoFBlurColor[1].Destroy();
     g_DoFBlurAlpha[0].Destroy();
     g_DoFBlurAlpha[1].Destroy();
-    g_DoFWorkQueue.Destroy();
-    g_DoFFastQueue.Destroy();
+    g_DoFWorkQueue[0].Destroy();
+    g_DoFWorkQueue[1].Destroy();
+    g_DoFWorkQueue[2].Destroy();
+    g_DoFFastQueue[0].Destroy();
+    g_DoFFastQueue[1].Destroy();
+    g_DoFFastQueue[2].Destroy();
     g_DoFFixupQueue.Destroy();
 
     g_MotionPrepBuffer.Destroy();
+    g_MotionBlurTileQueue.Destroy();
     g_LumaBuffer.Destroy();
     g_TemporalColor[0].Destroy();
     g_TemporalColor[1].Destroy();
@@ -304,6 +377,10 @@ void Graphics::DestroyRenderingBuffers()
     g_FXAAWorkCounters.Destroy();
     g_FXAAWorkQueue.Destroy();
     g_FXAAColorQueue.Destroy();
+    g_FXAATileQueue.Destroy();
 
     g_GenMipsBuffer.Destroy();
+
+    s_TransientHeap.Destroy();
+    s_Esram.Destroy();
 }
@@ -19,22 +19,30 @@
 #include "GpuBuffer.h"
 #include "GraphicsCore.h"
 
+class CommandContext;
+
 namespace Graphics
 {
     extern DepthBuffer g_SceneDepthBuffer;    // D32_FLOAT_S8_UINT
     extern ColorBuffer g_SceneColorBuffer;    // R11G11B10_FLOAT
+    extern DepthBuffer g_SceneDepthBufferMSAA;    // 4x MSAA, resolved into g_SceneDepthBuffer (see MSAAResolve.h)
+    extern ColorBuffer g_SceneColorBufferMSAA;    // 4x MSAA, resolved into g_SceneColorBuffer
     extern ColorBuffer g_PostEffectsBuffer;    // R32_UINT (to support Read-Modify-Write with a UAV)
     extern ColorBuffer g_OverlayBuffer;        // R8G8B8A8_UNORM
     extern ColorBuffer g_HorizontalBuffer;    // For separable (bicubic) upsampling
 
     extern ColorBuffer g_VelocityBuffer;    // R10G10B10  (3D velocity)
+    extern ColorBuffer g_VelocityTileMax;    // R16_FLOAT  Fastest speed of each 16x16 tile (see MotionBlur::IsVelocityDilated)
     extern ShadowBuffer g_ShadowBuffer;
 
     extern ColorBuffer g_SSAOFullScreen;    // R8_UNORM
+    extern ColorBuffer g_SSAOHistory[2];    // R8_UNORM
     extern ColorBuffer g_LinearDepth[2];    // Normalized planar distance (0 at eye, 1 at far plane) computed from the SceneDepthBuffer
     extern ColorBuffer g_MinMaxDepth8;        // Min and max depth values of 8x8 tiles
     extern ColorBuffer g_MinMaxDepth16;        // Min and max depth values of 16x16 tiles
     extern ColorBuffer g_MinMaxDepth32;        // Min and max depth values of 16x16 tiles
+    extern ColorBuffer g_HiZMinDepth;        // R32_FLOAT  Half resolution min depth pyramid (see HiZ.h)
+    extern ColorBuffer g_HiZMaxDepth;        // R32_FLOAT  Half resolution max depth pyramid
     extern ColorBuffer g_DepthDownsize1;
     extern ColorBuffer g_DepthDownsize2;
     extern ColorBuffer g_DepthDownsize3;
@@ -54,17 +62,19 @@ namespace Graphics
     extern ColorBuffer g_AOHighQuality2;
     extern ColorBuffer g_AOHighQuality3;
     extern ColorBuffer g_AOHighQuality4;
+    extern ColorBuffer g_AOUnresolved;
 
     extern ColorBuffer g_DoFTileClass[2];
     extern ColorBuffer g_DoFPresortBuffer;
     extern ColorBuffer g_DoFPrefilter;
     extern ColorBuffer g_DoFBlurColor[2];
     extern ColorBuffer g_DoFBlurAlpha[2];
-    extern StructuredBuffer g_DoFWorkQueue;
-    extern StructuredBuffer g_DoFFastQueue;
+    extern StructuredBuffer g_DoFWorkQueue[3];    // Indexed by the number of gather rings minus one
+    extern StructuredBuffer g_DoFFastQueue[3];
     extern StructuredBuffer g_DoFFixupQueue;
 
     extern ColorBuffer g_MotionPrepBuffer;        // R10G10B10A2
+    extern StructuredBuffer g_MotionBlurTileQueue;
     extern ColorBuffer g_LumaBuffer;
     extern ColorBuffer g_TemporalColor[2];
 
@@ -78,6 +88,22 @@ namespace Graphics
     extern ByteAddressBuffer g_FXAAWorkCounters;
     extern ByteAddressBuffer g_FXAAWorkQueue;
     extern TypedBuffer g_FXAAColorQueue;
+    extern StructuredBuffer g_FXAATileQueue;
+
+    // The scratch buffers of these passes only live for the duration of the pass, so they share one heap.
+    // A pass must acquire its group before it touches any of the buffers, and must not expect them to
+    // keep their contents from one frame to the next.  The groups double as phases of the ESRAM stack,
+    // whose buffers (in brackets) are acquired along with them.
+    enum TransientBufferGroup
+    {
+        kTransientSSAO,             // g_DepthDownsize*, g_DepthTiled*, g_AOMerged*, g_AOSmooth*, g_AOHighQuality*, g_AOUnresolved
+        kTransientDepthOfField,     // g_DoFTileClass, g_DoFPresortBuffer, g_DoFPrefilter, g_DoFBlurColor, g_DoFBlurAlpha [g_DoF*Queue]
+        kTransientMotionBlur,       // g_MotionPrepBuffer [g_MotionBlurTileQueue]
+        kTransientBloom,            // g_aBloomUAV*, g_LumaLR [g_LumaBuffer, g_Histogram, g_FXAA*Queue]
+        kNumTransientBufferGroups
+    };
+
+    void AcquireTransientBuffers( CommandContext& Context, TransientBufferGroup Group );
 
     void InitializeRenderingBuffers(uint32_t NativeWidth, uint32_t NativeHeight );
     void ResizeDisplayDependentBuffers(uint32_t NativeWidth, uint32_t NativeHeight);
@@ -40,11 +40,21 @@ void BaseCamera::Update()
 {
     m_PreviousViewProjMatrix = m_ViewProjMatrix;
 
+    // Fold the camera's offset into the origin, in double precision, so that the view matrix has no translation
+    if (m_CameraRelative)
+    {
+        m_WorldOrigin = m_WorldOrigin + GetPosition();
+        m_CameraToWorld.SetTranslation(Vector3(kZero));
+    }
+    m_OriginShift = m_WorldOrigin - m_PreviousWorldOrigin;
+    m_PreviousWorldOrigin = m_WorldOrigin;
+
+    // A point p of render space was at p + m_OriginShift in the previous frame's render space
     m_ViewMatrix = Matrix4(~m_CameraToWorld);
     m_ViewProjMatrix = m_ProjMatrix * m_ViewMatrix;
-    m_ReprojectMatrix = m_PreviousViewProjMatrix * Invert(GetViewProjMatrix());
+    m_ReprojectMatrix = m_PreviousViewProjMatrix * Matrix4(AffineTransform(m_OriginShift)) * Invert(GetViewProjMatrix());
 
-    m_FrustumVS = Frustum( m_ProjMatrix );
+    m_FrustumVS = Frustum( m_ProjMatrix, m_FarCornerDist );
     m_FrustumWS = m_CameraToWorld * m_FrustumVS;
 }
 
@@ -60,7 +70,14 @@ void Camera::UpdateProjMatrix( void )
     // actually a great idea with F32 depth buffers to redistribute precision more evenly across
     // the entire range.  It requires clearing Z to 0.0f and using a GREATER variant depth test.
     // Some care must also be done to properly reconstruct linear W in a pixel shader from hyperbolic Z.
-    if (m_ReverseZ)
+    // In the limit of an infinite far plane, depth is just NearClip / W.  Reversed, the precision of float depth
+    // hardly suffers for it.
+    if (m_ReverseZ && m_InfiniteZ)
+    {
+        Q1 = 0.0f;
+        Q2 = m_NearClip;
+    }
+    else if (m_ReverseZ)
     {
         Q1 = m_NearClip / (m_FarClip - m_NearClip);
         Q2 = Q1 * m_FarClip;
@@ -77,4 +94,6 @@ void Camera::UpdateProjMatrix( void )
         Vector4( 0.0f, 0.0f, Q1, -1.0f ),
         Vector4( 0.0f, 0.0f, Q2, 0.0f )
         ) );
+
+    m_FarCornerDist = m_FarClip;
 }
@@ -15,6 +15,7 @@
 
 #include "VectorMath.h"
 #include "Math/Frustum.h"
+#include "Math/WorldPosition.h"
 
 namespace Math
 {
@@ -41,6 +42,22 @@ namespace Math
         const Vector3 GetForwardVec() const { return -m_Basis.GetZ(); }
         const Vector3 GetPosition() const { return m_CameraToWorld.GetTranslation(); }
 
+        // Camera-relative rendering for worlds too large for float positions.  When enabled, Update() moves a double
+        // precision world origin to the camera, which leaves the camera at the origin of render space: world space
+        // translated by -GetWorldOrigin().  Every matrix, frustum and position the camera returns is in render space,
+        // and GetReprojectionMatrix() accounts for the origin moving.  Place objects with ToRenderSpace(), or many
+        // at once with RebasePoints() in Math/BatchTransform.h.  Disabled, the origin stays where it is.
+        void SetCameraRelative( bool enable ) { m_CameraRelative = enable; }
+        bool IsCameraRelative() const { return m_CameraRelative; }
+        void SetWorldPosition( const WorldPosition& worldPos );
+        WorldPosition GetWorldPosition() const { return m_WorldOrigin + GetPosition(); }
+        const WorldPosition& GetWorldOrigin() const { return m_WorldOrigin; }
+        Vector3 ToRenderSpace( const WorldPosition& worldPos ) const { return worldPos - m_WorldOrigin; }
+
+        // How far the origin moved in the last Update().  Render space positions and matrices kept from the
+        // previous frame are off by this much.
+        Vector3 GetOriginShift() const { return m_OriginShift; }
+
         // Accessors for reading the various matrices and frusta
         const Matrix4& GetViewMatrix() const { return m_ViewMatrix; }
         const Matrix4& GetProjMatrix() const { return m_ProjMatrix; }
@@ -51,7 +68,7 @@ namespace Math
 
     protected:
 
-        BaseCamera() : m_CameraToWorld(kIdentity), m_Basis(kIdentity) {}
+        BaseCamera() : m_CameraToWorld(kIdentity), m_Basis(kIdentity), m_FarCornerDist(1000.0f), m_CameraRelative(false), m_OriginShift(kZero) {}
 
         void SetProjMatrix( const Matrix4& ProjMat ) { m_ProjMatrix = ProjMat; }
 
@@ -82,7 +99,13 @@ namespace Math
 
         Frustum m_FrustumVS;        // View-space view frustum
         Frustum m_FrustumWS;        // World-space view frustum
+        float m_FarCornerDist;      // Where the frusta end if the projection has no far plane
 
+        // Render space is world space relative to m_WorldOrigin
+        bool m_CameraRelative;
+        WorldPosition m_WorldOrigin;
+        WorldPosition m_PreviousWorldOrigin;
+        Vector3 m_OriginShift;
     };
 
     class Camera : public BaseCamera
@@ -97,6 +120,13 @@ namespace Math
         void SetZRange( float nearZ, float farZ) { m_NearClip = nearZ; m_FarClip = farZ; UpdateProjMatrix(); }
         void ReverseZ( bool enable ) { m_ReverseZ = enable; UpdateProjMatrix(); }
 
+        // Moves the far plane to infinity when Z is reversed.  Nothing is clipped or frustum culled by distance,
+        // but the far clip distance remains the range that linear depth, shadows and the frusta's far corners are
+        // scaled to.  Depth linearization in the shaders assumes a finite far plane, so it is only approximate
+        // near that distance.
+        void InfiniteZ( bool enable ) { m_InfiniteZ = enable; UpdateProjMatrix(); }
+        bool HasInfiniteFarPlane() const { return m_ReverseZ && m_InfiniteZ; }
+
         float GetFOV() const { return m_VerticalFOV; }
         float GetNearClip() const { return m_NearClip; }
         float GetFarClip() const { return m_FarClip; }
@@ -111,6 +141,7 @@ namespace Math
         float m_NearClip;
         float m_FarClip;
         bool m_ReverseZ;                // Invert near and far clip distances so that Z=0 is the far plane
+        bool m_InfiniteZ;               // With m_ReverseZ, put the far plane at infinity
     };
 
     inline void BaseCamera::SetEyeAtUp( Vector3 eye, Vector3 at, Vector3 up )
@@ -124,6 +155,20 @@ namespace Math
         m_CameraToWorld.SetTranslation( worldPos );
     }
 
+    inline void BaseCamera::SetWorldPosition( const WorldPosition& worldPos )
+    {
+        // Moving the origin directly avoids a large float offset from the old one
+        if (m_CameraRelative)
+        {
+            m_WorldOrigin = worldPos;
+            m_CameraToWorld.SetTranslation( Vector3(kZero) );
+        }
+        else
+        {
+            m_CameraToWorld.SetTranslation( worldPos - m_WorldOrigin );
+        }
+    }
+
     inline void BaseCamera::SetTransform( const AffineTransform& xform )
     {
         // By using these functions, we rederive an orthogonal transform.
@@ -137,7 +182,7 @@ namespace Math
         m_Basis = Matrix3(m_CameraToWorld.GetRotation());
     }
 
-    inline Camera::Camera() : m_ReverseZ(true)
+    inline Camera::Camera() : m_ReverseZ(true), m_InfiniteZ(false)
     {
         SetPerspectiveMatrix( XM_PIDIV4, 9.0f / 16.0f, 1.0f, 1000.0f );
     }
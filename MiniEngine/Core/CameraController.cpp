@@ -116,6 +116,22 @@ void CameraController::Update( float deltaTime )
     m_TargetCamera.Update();
 }
 
+Matrix4 CameraController::GetLateLatchedViewProj( void ) const
+{
+    float yaw, pitch;
+    GameInput::GetLatestMouseMotion(yaw, pitch);
+
+    float currentPitch = m_CurrentPitch + pitch * m_MouseSensitivityY;
+    currentPitch = XMMin( XM_PIDIV2, currentPitch);
+    currentPitch = XMMax(-XM_PIDIV2, currentPitch);
+
+    float currentHeading = m_CurrentHeading - yaw * m_MouseSensitivityX;
+
+    Matrix3 orientation = Matrix3(m_WorldEast, m_WorldUp, -m_WorldNorth) * Matrix3::MakeYRotation( currentHeading ) * Matrix3::MakeXRotation( currentPitch );
+    OrthogonalTransform cameraToWorld( orientation, m_TargetCamera.GetPosition() );
+    return m_TargetCamera.GetProjMatrix() * Matrix4(~cameraToWorld);
+}
+
 void CameraController::ApplyMomentum( float& oldValue, float& newValue, float deltaTime )
 {
     float blendedValue;
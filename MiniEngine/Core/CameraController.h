@@ -33,6 +33,10 @@ namespace GameCore
 
         void Update( float dt );
 
+        // The camera's view-projection matrix with the mouse motion that arrived since Update() applied, for
+        // late latching.  The camera is unchanged, because the next Update() applies the same motion to it.
+        Matrix4 GetLateLatchedViewProj( void ) const;
+
         void SlowMovement( bool enable ) { m_FineMovement = enable; }
         void SlowRotation( bool enable ) { m_FineRotation = enable; }
 
@@ -13,6 +13,8 @@
 
 #include "pch.h"
 #include "Color.h"
+#include <algorithm>
+#include <intrin.h>
 
 using DirectX::XMVECTORU32;
 
@@ -150,3 +152,275 @@ uint32_t Color::R9G9B9E5() const
 
 #endif
 }
+
+namespace
+{
+    // The packing kernels are written once against these.  Colors are transposed on load so that each register
+    // holds one channel of kWidth colors.
+    struct AVX2Lanes
+    {
+        typedef __m256 Reg;
+        typedef __m256i IReg;
+        enum { kWidth = 8 };
+
+        static void LoadRGB( const float* Src, Reg& R, Reg& G, Reg& B )
+        {
+            // Colors 0-3 go in the low halves and 4-7 in the high halves, so the in-lane transpose keeps them in order
+            Reg C04 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(Src + 0)), _mm_loadu_ps(Src + 16), 1);
+            Reg C15 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(Src + 4)), _mm_loadu_ps(Src + 20), 1);
+            Reg C26 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(Src + 8)), _mm_loadu_ps(Src + 24), 1);
+            Reg C37 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(Src + 12)), _mm_loadu_ps(Src + 28), 1);
+            __m256d RG01 = _mm256_castps_pd(_mm256_unpacklo_ps(C04, C15));
+            __m256d RG23 = _mm256_castps_pd(_mm256_unpacklo_ps(C26, C37));
+            __m256d BA01 = _mm256_castps_pd(_mm256_unpackhi_ps(C04, C15));
+            __m256d BA23 = _mm256_castps_pd(_mm256_unpackhi_ps(C26, C37));
+            R = _mm256_castpd_ps(_mm256_unpacklo_pd(RG01, RG23));
+            G = _mm256_castpd_ps(_mm256_unpackhi_pd(RG01, RG23));
+            B = _mm256_castpd_ps(_mm256_unpacklo_pd(BA01, BA23));
+        }
+
+        static void Store( uint32_t* Dest, IReg Value ) { _mm256_storeu_si256((__m256i*)Dest, Value); }
+        static Reg Splat( float Value ) { return _mm256_set1_ps(Value); }
+        static IReg Splat( uint32_t Value ) { return _mm256_set1_epi32((int)Value); }
+        static Reg Add( Reg A, Reg B ) { return _mm256_add_ps(A, B); }
+        static Reg Mul( Reg A, Reg B ) { return _mm256_mul_ps(A, B); }
+        static Reg Min( Reg A, Reg B ) { return _mm256_min_ps(A, B); }
+        static Reg Max( Reg A, Reg B ) { return _mm256_max_ps(A, B); }
+        static IReg Add( IReg A, IReg B ) { return _mm256_add_epi32(A, B); }
+        static IReg And( IReg A, IReg B ) { return _mm256_and_si256(A, B); }
+        static IReg Or( IReg A, IReg B ) { return _mm256_or_si256(A, B); }
+        static IReg ShiftLeft( IReg A, int Bits ) { return _mm256_slli_epi32(A, Bits); }
+        static IReg ShiftRight( IReg A, int Bits ) { return _mm256_srli_epi32(A, Bits); }
+        static IReg AsInt( Reg A ) { return _mm256_castps_si256(A); }
+        static Reg AsFloat( IReg A ) { return _mm256_castsi256_ps(A); }
+    };
+
+    struct SSELanes
+    {
+        typedef __m128 Reg;
+        typedef __m128i IReg;
+        enum { kWidth = 4 };
+
+        static void LoadRGB( const float* Src, Reg& R, Reg& G, Reg& B )
+        {
+            Reg RG01 = _mm_unpacklo_ps(_mm_loadu_ps(Src + 0), _mm_loadu_ps(Src + 4));
+            Reg RG23 = _mm_unpacklo_ps(_mm_loadu_ps(Src + 8), _mm_loadu_ps(Src + 12));
+            Reg BA01 = _mm_unpackhi_ps(_mm_loadu_ps(Src + 0), _mm_loadu_ps(Src + 4));
+            Reg BA23 = _mm_unpackhi_ps(_mm_loadu_ps(Src + 8), _mm_loadu_ps(Src + 12));
+            R = _mm_movelh_ps(RG01, RG23);
+            G = _mm_movehl_ps(RG23, RG01);
+            B = _mm_movelh_ps(BA01, BA23);
+        }
+
+        static void Store( uint32_t* Dest, IReg Value ) { _mm_storeu_si128((__m128i*)Dest, Value); }
+        static Reg Splat( float Value ) { return _mm_set1_ps(Value); }
+        static IReg Splat( uint32_t Value ) { return _mm_set1_epi32((int)Value); }
+        static Reg Add( Reg A, Reg B ) { return _mm_add_ps(A, B); }
+        static Reg Mul( Reg A, Reg B ) { return _mm_mul_ps(A, B); }
+        static Reg Min( Reg A, Reg B ) { return _mm_min_ps(A, B); }
+        static Reg Max( Reg A, Reg B ) { return _mm_max_ps(A, B); }
+        static IReg Add( IReg A, IReg B ) { return _mm_add_epi32(A, B); }
+        static IReg And( IReg A, IReg B ) { return _mm_and_si128(A, B); }
+        static IReg Or( IReg A, IReg B ) { return _mm_or_si128(A, B); }
+        static IReg ShiftLeft( IReg A, int Bits ) { return _mm_slli_epi32(A, Bits); }
+        static IReg ShiftRight( IReg A, int Bits ) { return _mm_srli_epi32(A, Bits); }
+        static IReg AsInt( Reg A ) { return _mm_castps_si128(A); }
+        static Reg AsFloat( IReg A ) { return _mm_castsi128_ps(A); }
+    };
+
+    // Each kernel packs whole blocks of Lanes::kWidth colors starting at First and returns the index of the
+    // first color left over.  They are the scalar versions of R11G11B10F() and R9G9B9E5() with one channel per
+    // register.
+    template <typename Lanes>
+    size_t PackR11G11B10FBlocks( const Color* Colors, uint32_t* Packed, size_t Count, bool RoundToEven, size_t First )
+    {
+        typedef typename Lanes::Reg Reg;
+        typedef typename Lanes::IReg IReg;
+
+        const Reg Zero = Lanes::Splat(0.0f);
+        const Reg MaxVal = Lanes::Splat(float(1 << 16));
+        const Reg F32toF16 = Lanes::Splat(float((1.0 / (1ull << 56)) * (1.0 / (1ull << 56))));
+        const IReg One = Lanes::Splat(1u);
+
+        size_t i = First;
+        for (; i + Lanes::kWidth <= Count; i += Lanes::kWidth)
+        {
+            Reg R, G, B;
+            Lanes::LoadRGB((const float*)(Colors + i), R, G, B);
+
+            IReg Ri = Lanes::AsInt(Lanes::Mul(Lanes::Min(Lanes::Max(R, Zero), MaxVal), F32toF16));
+            IReg Gi = Lanes::AsInt(Lanes::Mul(Lanes::Min(Lanes::Max(G, Zero), MaxVal), F32toF16));
+            IReg Bi = Lanes::AsInt(Lanes::Mul(Lanes::Min(Lanes::Max(B, Zero), MaxVal), F32toF16));
+
+            if (RoundToEven)
+            {
+                Ri = Lanes::Add(Ri, Lanes::Add(Lanes::Splat(0x0FFFFu), Lanes::And(Lanes::ShiftRight(Ri, 16), One)));
+                Gi = Lanes::Add(Gi, Lanes::Add(Lanes::Splat(0x0FFFFu), Lanes::And(Lanes::ShiftRight(Gi, 16), One)));
+                Bi = Lanes::Add(Bi, Lanes::Add(Lanes::Splat(0x1FFFFu), Lanes::And(Lanes::ShiftRight(Bi, 17), One)));
+            }
+            else
+            {
+                Ri = Lanes::Add(Ri, Lanes::Splat(0x00010000u));
+                Gi = Lanes::Add(Gi, Lanes::Splat(0x00010000u));
+                Bi = Lanes::Add(Bi, Lanes::Splat(0x00020000u));
+            }
+
+            Ri = Lanes::And(Ri, Lanes::Splat(0x0FFE0000u));
+            Gi = Lanes::And(Gi, Lanes::Splat(0x0FFE0000u));
+            Bi = Lanes::And(Bi, Lanes::Splat(0x0FFC0000u));
+
+            Lanes::Store(Packed + i, Lanes::Or(Lanes::Or(Lanes::ShiftRight(Ri, 17), Lanes::ShiftRight(Gi, 6)), Lanes::ShiftLeft(Bi, 4)));
+        }
+
+        return i;
+    }
+
+    template <typename Lanes>
+    size_t PackR9G9B9E5Blocks( const Color* Colors, uint32_t* Packed, size_t Count, size_t First )
+    {
+        typedef typename Lanes::Reg Reg;
+        typedef typename Lanes::IReg IReg;
+
+        const Reg Zero = Lanes::Splat(0.0f);
+        const Reg MaxVal = Lanes::Splat(float(0x1FF << 7));
+        const Reg MinVal = Lanes::Splat(float(1.f / (1 << 16)));
+
+        size_t i = First;
+        for (; i + Lanes::kWidth <= Count; i += Lanes::kWidth)
+        {
+            Reg R, G, B;
+            Lanes::LoadRGB((const float*)(Colors + i), R, G, B);
+
+            R = Lanes::Min(Lanes::Max(R, Zero), MaxVal);
+            G = Lanes::Min(Lanes::Max(G, Zero), MaxVal);
+            B = Lanes::Min(Lanes::Max(B, Zero), MaxVal);
+
+            Reg MaxChannel = Lanes::Max(Lanes::Max(R, G), Lanes::Max(B, MinVal));
+
+            IReg Bias = Lanes::And(Lanes::Add(Lanes::AsInt(MaxChannel), Lanes::Splat(0x07804000u)), Lanes::Splat(0x7F800000u));
+
+            IReg Ri = Lanes::AsInt(Lanes::Add(R, Lanes::AsFloat(Bias)));
+            IReg Gi = Lanes::AsInt(Lanes::Add(G, Lanes::AsFloat(Bias)));
+            IReg Bi = Lanes::AsInt(Lanes::Add(B, Lanes::AsFloat(Bias)));
+
+            IReg Exp = Lanes::Add(Lanes::ShiftLeft(Bias, 4), Lanes::Splat(0x10000000u));
+
+            Lanes::Store(Packed + i, Lanes::Or(Lanes::Or(Exp, Lanes::ShiftLeft(Bi, 18)),
+                Lanes::Or(Lanes::ShiftLeft(Gi, 9), Lanes::And(Ri, Lanes::Splat(511u)))));
+        }
+
+        return i;
+    }
+}
+
+void PackR11G11B10F( const Color* Colors, uint32_t* Packed, size_t Count, bool RoundToEven )
+{
+    size_t i = 0;
+    if (HasAVX2())
+    {
+        i = PackR11G11B10FBlocks<AVX2Lanes>(Colors, Packed, Count, RoundToEven, i);
+        _mm256_zeroupper();
+    }
+    i = PackR11G11B10FBlocks<SSELanes>(Colors, Packed, Count, RoundToEven, i);
+    for (; i < Count; ++i)
+        Packed[i] = Colors[i].R11G11B10F(RoundToEven);
+}
+
+void PackR9G9B9E5( const Color* Colors, uint32_t* Packed, size_t Count )
+{
+    size_t i = 0;
+    if (HasAVX2())
+    {
+        i = PackR9G9B9E5Blocks<AVX2Lanes>(Colors, Packed, Count, i);
+        _mm256_zeroupper();
+    }
+    i = PackR9G9B9E5Blocks<SSELanes>(Colors, Packed, Count, i);
+    for (; i < Count; ++i)
+        Packed[i] = Colors[i].R9G9B9E5();
+}
+
+// The swizzles are byte shuffles.  A 16-byte load holds four BGRA8 pixels, or four BGR8 pixels and a third of
+// the next ones, so BGR8 blocks stop early enough not to read past the end.  AVX2 shuffles within 128-bit
+// halves, so each half gets its own pixels.
+
+void ConvertBGR8ToRGBA8( const uint8_t* Source, uint32_t* Dest, size_t NumPixels )
+{
+    size_t i = 0;
+
+    if (HasAVX2())
+    {
+        const __m256i Shuffle = _mm256_setr_epi8(2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1,
+            2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1);
+        const __m256i Alpha = _mm256_set1_epi32((int)0xFF000000);
+
+        for (; i + 10 <= NumPixels; i += 8)
+        {
+            const uint8_t* Src = Source + i * 3;
+            __m256i BGR = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i*)Src)),
+                _mm_loadu_si128((const __m128i*)(Src + 12)), 1);
+            _mm256_storeu_si256((__m256i*)(Dest + i), _mm256_or_si256(_mm256_shuffle_epi8(BGR, Shuffle), Alpha));
+        }
+
+        _mm256_zeroupper();
+    }
+
+    const __m128i Shuffle = _mm_setr_epi8(2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1);
+    const __m128i Alpha = _mm_set1_epi32((int)0xFF000000);
+
+    for (; i + 6 <= NumPixels; i += 4)
+    {
+        __m128i BGR = _mm_loadu_si128((const __m128i*)(Source + i * 3));
+        _mm_storeu_si128((__m128i*)(Dest + i), _mm_or_si128(_mm_shuffle_epi8(BGR, Shuffle), Alpha));
+    }
+
+    for (const uint8_t* Src = Source + i * 3; i < NumPixels; ++i, Src += 3)
+        Dest[i] = 0xff000000 | Src[0] << 16 | Src[1] << 8 | Src[2];
+}
+
+uint8_t ConvertBGRA8ToRGBA8( const uint8_t* Source, uint32_t* Dest, size_t NumPixels )
+{
+    size_t i = 0;
+
+    // Color bytes are set before taking the minimum, so only the alpha bytes can go below 0xFF
+    __m128i MinAlpha = _mm_set1_epi32(-1);
+
+    if (HasAVX2())
+    {
+        const __m256i Shuffle = _mm256_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15,
+            2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+        const __m256i NotAlpha = _mm256_set1_epi32(0x00FFFFFF);
+        __m256i MinAlpha8 = _mm256_set1_epi32(-1);
+
+        for (; i + 8 <= NumPixels; i += 8)
+        {
+            __m256i BGRA = _mm256_loadu_si256((const __m256i*)(Source + i * 4));
+            _mm256_storeu_si256((__m256i*)(Dest + i), _mm256_shuffle_epi8(BGRA, Shuffle));
+            MinAlpha8 = _mm256_min_epu8(MinAlpha8, _mm256_or_si256(BGRA, NotAlpha));
+        }
+
+        MinAlpha = _mm_min_epu8(_mm256_castsi256_si128(MinAlpha8), _mm256_extracti128_si256(MinAlpha8, 1));
+        _mm256_zeroupper();
+    }
+
+    const __m128i Shuffle = _mm_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+    const __m128i NotAlpha = _mm_set1_epi32(0x00FFFFFF);
+
+    for (; i + 4 <= NumPixels; i += 4)
+    {
+        __m128i BGRA = _mm_loadu_si128((const __m128i*)(Source + i * 4));
+        _mm_storeu_si128((__m128i*)(Dest + i), _mm_shuffle_epi8(BGRA, Shuffle));
+        MinAlpha = _mm_min_epu8(MinAlpha, _mm_or_si128(BGRA, NotAlpha));
+    }
+
+    MinAlpha = _mm_min_epu8(MinAlpha, _mm_srli_si128(MinAlpha, 8));
+    MinAlpha = _mm_min_epu8(MinAlpha, _mm_srli_si128(MinAlpha, 4));
+    uint8_t Result = (uint8_t)((uint32_t)_mm_cvtsi128_si32(MinAlpha) >> 24);
+
+    for (const uint8_t* Src = Source + i * 4; i < NumPixels; ++i, Src += 4)
+    {
+        Dest[i] = Src[3] << 24 | Src[0] << 16 | Src[1] << 8 | Src[2];
+        Result = std::min(Result, Src[3]);
+    }
+
+    return Result;
+}
@@ -68,6 +68,19 @@ INLINE Color Max( Color a, Color b ) { return Color(XMVectorMax(a, b)); }
 INLINE Color Min( Color a, Color b ) { return Color(XMVectorMin(a, b)); }
 INLINE Color Clamp( Color x, Color a, Color b ) { return Color(XMVectorClamp(x, a, b)); }
 
+// Batched conversions for CPU-side image processing.  They work on eight pixels at a time with AVX2 when the CPU
+// has it, four at a time with SSE otherwise, and finish the remainder one at a time.  Results are identical to
+// converting each pixel on its own.
+
+// Color::R11G11B10F() and Color::R9G9B9E5() of each color
+void PackR11G11B10F( const Color* Colors, uint32_t* Packed, size_t Count, bool RoundToEven = false );
+void PackR9G9B9E5( const Color* Colors, uint32_t* Packed, size_t Count );
+
+// Reorder the BGR8 or BGRA8 pixels stored by TGA files to RGBA8.  BGR8 pixels become opaque, and the BGRA8
+// version returns the smallest alpha.
+void ConvertBGR8ToRGBA8( const uint8_t* Source, uint32_t* Dest, size_t NumPixels );
+uint8_t ConvertBGRA8ToRGBA8( const uint8_t* Source, uint32_t* Dest, size_t NumPixels );
+
 
 inline Color::Color( FXMVECTOR vec )
 {
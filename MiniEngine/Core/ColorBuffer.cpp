@@ -16,6 +16,8 @@
 #include "GraphicsCore.h"
 #include "CommandContext.h"
 #include "EsramAllocator.h"
+#include "TransientHeap.h"
+#include "GpuBuffer.h"
 
 using namespace Graphics;
 
@@ -133,9 +135,24 @@ void ColorBuffer::Create(const std::wstring& Name, uint32_t Width, uint32_t Heig
 }
 
 void ColorBuffer::Create(const std::wstring& Name, uint32_t Width, uint32_t Height, uint32_t NumMips,
-    DXGI_FORMAT Format, EsramAllocator&)
+    DXGI_FORMAT Format, EsramAllocator& Allocator)
 {
-    Create(Name, Width, Height, NumMips, Format);
+    NumMips = (NumMips == 0 ? ComputeNumMips(Width, Height) : NumMips);
+    D3D12_RESOURCE_FLAGS Flags = CombineResourceFlags();
+    D3D12_RESOURCE_DESC ResourceDesc = DescribeTex2D(Width, Height, 1, NumMips, Format, Flags);
+
+    ResourceDesc.SampleDesc.Count = m_FragmentCount;
+    ResourceDesc.SampleDesc.Quality = 0;
+
+    D3D12_CLEAR_VALUE ClearValue = {};
+    ClearValue.Format = Format;
+    ClearValue.Color[0] = m_ClearColor.R();
+    ClearValue.Color[1] = m_ClearColor.G();
+    ClearValue.Color[2] = m_ClearColor.B();
+    ClearValue.Color[3] = m_ClearColor.A();
+
+    if (!Allocator.Place(*this, ResourceDesc, ClearValue, Name, 1, NumMips))
+        Create(Name, Width, Height, NumMips, Format);
 }
 
 void ColorBuffer::CreateArray( const std::wstring& Name, uint32_t Width, uint32_t Height, uint32_t ArrayCount,
@@ -156,9 +173,63 @@ void ColorBuffer::CreateArray( const std::wstring& Name, uint32_t Width, uint32_
 }
 
 void ColorBuffer::CreateArray( const std::wstring& Name, uint32_t Width, uint32_t Height, uint32_t ArrayCount,
-    DXGI_FORMAT Format, EsramAllocator& )
+    DXGI_FORMAT Format, EsramAllocator& Allocator )
+{
+    D3D12_RESOURCE_FLAGS Flags = CombineResourceFlags();
+    D3D12_RESOURCE_DESC ResourceDesc = DescribeTex2D(Width, Height, ArrayCount, 1, Format, Flags);
+
+    D3D12_CLEAR_VALUE ClearValue = {};
+    ClearValue.Format = Format;
+    ClearValue.Color[0] = m_ClearColor.R();
+    ClearValue.Color[1] = m_ClearColor.G();
+    ClearValue.Color[2] = m_ClearColor.B();
+    ClearValue.Color[3] = m_ClearColor.A();
+
+    if (!Allocator.Place(*this, ResourceDesc, ClearValue, Name, ArrayCount, 1))
+        CreateArray(Name, Width, Height, ArrayCount, Format);
+}
+
+void ColorBuffer::Create( const std::wstring& Name, uint32_t Width, uint32_t Height, uint32_t NumMips,
+    DXGI_FORMAT Format, TransientHeap& Heap )
+{
+    NumMips = (NumMips == 0 ? ComputeNumMips(Width, Height) : NumMips);
+    D3D12_RESOURCE_FLAGS Flags = CombineResourceFlags();
+    D3D12_RESOURCE_DESC ResourceDesc = DescribeTex2D(Width, Height, 1, NumMips, Format, Flags);
+
+    ResourceDesc.SampleDesc.Count = m_FragmentCount;
+    ResourceDesc.SampleDesc.Quality = 0;
+
+    D3D12_CLEAR_VALUE ClearValue = {};
+    ClearValue.Format = Format;
+    ClearValue.Color[0] = m_ClearColor.R();
+    ClearValue.Color[1] = m_ClearColor.G();
+    ClearValue.Color[2] = m_ClearColor.B();
+    ClearValue.Color[3] = m_ClearColor.A();
+
+    Heap.Place(*this, ResourceDesc, ClearValue, Name, 1, NumMips);
+}
+
+void ColorBuffer::CreateArray( const std::wstring& Name, uint32_t Width, uint32_t Height, uint32_t ArrayCount,
+    DXGI_FORMAT Format, TransientHeap& Heap )
 {
-    CreateArray(Name, Width, Height, ArrayCount, Format);
+    D3D12_RESOURCE_FLAGS Flags = CombineResourceFlags();
+    D3D12_RESOURCE_DESC ResourceDesc = DescribeTex2D(Width, Height, ArrayCount, 1, Format, Flags);
+
+    D3D12_CLEAR_VALUE ClearValue = {};
+    ClearValue.Format = Format;
+    ClearValue.Color[0] = m_ClearColor.R();
+    ClearValue.Color[1] = m_ClearColor.G();
+    ClearValue.Color[2] = m_ClearColor.B();
+    ClearValue.Color[3] = m_ClearColor.A();
+
+    Heap.Place(*this, ResourceDesc, ClearValue, Name, ArrayCount, 1);
+}
+
+void ColorBuffer::CreatePlaced( ID3D12Heap* Heap, uint64_t HeapOffset, const D3D12_RESOURCE_DESC& ResourceDesc,
+    const D3D12_CLEAR_VALUE& ClearValue, const std::wstring& Name, uint32_t ArraySize, uint32_t NumMips )
+{
+    CreateTextureResource(Graphics::g_Device, Name, ResourceDesc, ClearValue, Heap, HeapOffset);
+    CreateDerivedViews(Graphics::g_Device, m_Format, ArraySize, NumMips);
 }
 
 void ColorBuffer::GenerateMipMaps(CommandContext& BaseContext)
@@ -168,12 +239,63 @@ void ColorBuffer::GenerateMipMaps(CommandContext& BaseContext)
 
     ComputeContext& Context = BaseContext.GetComputeContext();
 
-    Context.SetRootSignature(Graphics::g_GenerateMipsRS);
-
     Context.TransitionResource(*this, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
-    Context.SetDynamicDescriptor(1, 0, m_SRVHandle);
 
-    for (uint32_t TopMip = 0; TopMip < m_NumMipMaps; )
+    uint32_t TopMip = 0;
+
+    // Power-of-two textures get every mip that halves exactly in both dimensions from a single dispatch.
+    // The scratch buffer and counter are shared, so this must not overlap with another single pass dispatch.
+    if (Math::IsPowerOfTwo(m_Width) && Math::IsPowerOfTwo(m_Height) && m_Width <= 4096 && m_Height <= 4096)
+    {
+        uint32_t NumMips;
+        _BitScanForward((unsigned long*)&NumMips, m_Width < m_Height ? m_Width : m_Height);
+        if (NumMips > m_NumMipMaps)
+            NumMips = m_NumMipMaps;
+
+        if (NumMips > 0)
+        {
+            // Each group reduces a 64x64 tile of mip 0
+            uint32_t GroupsX = Math::DivideByMultiple(m_Width, 64);
+            uint32_t GroupsY = Math::DivideByMultiple(m_Height, 64);
+
+            Context.SetRootSignature(Graphics::g_GenerateMipsSinglePassRS);
+            if (m_Format == DXGI_FORMAT_R8G8B8A8_UNORM_SRGB)
+                Context.SetPipelineState(Graphics::g_GenerateMipsSinglePassGammaPSO);
+            else
+                Context.SetPipelineState(Graphics::g_GenerateMipsSinglePassLinearPSO);
+
+            Context.TransitionResource(Graphics::g_GenerateMipsScratch, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+            Context.TransitionResource(Graphics::g_GenerateMipsCounter, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+
+            D3D12_CPU_DESCRIPTOR_HANDLE ScratchUAVs[2] =
+            {
+                Graphics::g_GenerateMipsScratch.GetUAV(),
+                Graphics::g_GenerateMipsCounter.GetUAV()
+            };
+
+            Context.SetConstants(0, NumMips, GroupsX * GroupsY, 2.0f / m_Width, 2.0f / m_Height);
+            Context.SetDynamicDescriptor(1, 0, m_SRVHandle);
+            Context.SetDynamicDescriptors(2, 0, NumMips, m_UAVHandle + 1);
+            Context.SetDynamicDescriptors(3, 0, 2, ScratchUAVs);
+            Context.Dispatch(GroupsX, GroupsY, 1);
+
+            Context.InsertUAVBarrier(*this);
+            Context.InsertUAVBarrier(Graphics::g_GenerateMipsScratch);
+            Context.InsertUAVBarrier(Graphics::g_GenerateMipsCounter);
+
+            TopMip = NumMips;
+        }
+    }
+
+    // Everything else, including the mips of a rectangular texture below its smaller dimension, uses the
+    // multi-pass shaders
+    if (TopMip < m_NumMipMaps)
+    {
+        Context.SetRootSignature(Graphics::g_GenerateMipsRS);
+        Context.SetDynamicDescriptor(1, 0, m_SRVHandle);
+    }
+
+    while (TopMip < m_NumMipMaps)
     {
         uint32_t SrcWidth = m_Width >> TopMip;
         uint32_t SrcHeight = m_Height >> TopMip;
@@ -17,6 +17,7 @@
 #include "Color.h"
 
 class EsramAllocator;
+class TransientHeap;
 
 class ColorBuffer : public PixelBuffer
 {
@@ -38,8 +39,8 @@ public:
     void Create(const std::wstring& Name, uint32_t Width, uint32_t Height, uint32_t NumMips,
         DXGI_FORMAT Format, D3D12_GPU_VIRTUAL_ADDRESS VidMemPtr = D3D12_GPU_VIRTUAL_ADDRESS_UNKNOWN);
     
-    // Create a color buffer.  Memory will be allocated in ESRAM (on Xbox One).  On Windows,
-    // this functions the same as Create() without a video address.
+    // Create a color buffer on the allocator's stack.  Outside of a phase, or when the buffer can't be
+    // placed, this functions the same as Create() without a video address.
     void Create(const std::wstring& Name, uint32_t Width, uint32_t Height, uint32_t NumMips,
         DXGI_FORMAT Format, EsramAllocator& Allocator);
 
@@ -49,15 +50,22 @@ public:
     void CreateArray(const std::wstring& Name, uint32_t Width, uint32_t Height, uint32_t ArrayCount,
         DXGI_FORMAT Format, D3D12_GPU_VIRTUAL_ADDRESS VidMemPtr = D3D12_GPU_VIRTUAL_ADDRESS_UNKNOWN);
     
-    // Create a color buffer.  Memory will be allocated in ESRAM (on Xbox One).  On Windows,
-    // this functions the same as Create() without a video address.
+    // Create a color buffer on the allocator's stack.  Outside of a phase, or when the buffer can't be
+    // placed, this functions the same as CreateArray() without a video address.
     void CreateArray(const std::wstring& Name, uint32_t Width, uint32_t Height, uint32_t ArrayCount,
         DXGI_FORMAT Format, EsramAllocator& Allocator);
 
+    // Create a color buffer that shares memory with the other groups of a transient heap.  The resource
+    // and its views don't exist until the heap is finalized.
+    void Create(const std::wstring& Name, uint32_t Width, uint32_t Height, uint32_t NumMips,
+        DXGI_FORMAT Format, TransientHeap& Heap);
+    void CreateArray(const std::wstring& Name, uint32_t Width, uint32_t Height, uint32_t ArrayCount,
+        DXGI_FORMAT Format, TransientHeap& Heap);
+
     // Get pre-created CPU-visible descriptor handles
     const D3D12_CPU_DESCRIPTOR_HANDLE& GetSRV(void) const { return m_SRVHandle; }
     const D3D12_CPU_DESCRIPTOR_HANDLE& GetRTV(void) const { return m_RTVHandle; }
-    const D3D12_CPU_DESCRIPTOR_HANDLE& GetUAV(void) const { return m_UAVHandle[0]; }
+    const D3D12_CPU_DESCRIPTOR_HANDLE& GetUAV(uint32_t MipLevel = 0) const { ASSERT(MipLevel <= m_NumMipMaps); return m_UAVHandle[MipLevel]; }
 
     void SetClearColor( Color ClearColor ) { m_ClearColor = ClearColor; }
 
@@ -70,6 +78,9 @@ public:
 
     Color GetClearColor(void) const { return m_ClearColor; }
 
+    // Greater than one for MSAA, whose SRV is a Texture2DMS and which has no UAVs
+    uint32_t GetFragmentCount(void) const { return m_FragmentCount; }
+
     // This will work for all texture sizes, but it's recommended for speed and quality
     // that you use dimensions with powers of two (but not necessarily square.)  Pass
     // 0 for ArrayCount to reserve space for mips at creation time.
@@ -77,6 +88,12 @@ public:
 
 protected:
 
+    friend class TransientHeap;
+    friend class EsramAllocator;
+
+    void CreatePlaced(ID3D12Heap* Heap, uint64_t HeapOffset, const D3D12_RESOURCE_DESC& ResourceDesc,
+        const D3D12_CLEAR_VALUE& ClearValue, const std::wstring& Name, uint32_t ArraySize, uint32_t NumMips);
+
     D3D12_RESOURCE_FLAGS CombineResourceFlags( void ) const
     {
         D3D12_RESOURCE_FLAGS Flags = D3D12_RESOURCE_FLAG_NONE;
@@ -14,10 +14,32 @@
 #include "pch.h"
 #include "CommandAllocatorPool.h"
 
+namespace
+{
+    // Allocators discarded by this thread, oldest first.  Fence values are in submission order, so only the
+    // oldest needs to be tested.
+    struct AllocatorRing
+    {
+        enum { kCapacity = 8 };
+
+        uint32_t Generation;
+        uint32_t First;
+        uint32_t Count;
+        uint64_t FenceValues[kCapacity];
+        ID3D12CommandAllocator* Allocators[kCapacity];
+    };
+
+    // Indexed by command list type
+    thread_local AllocatorRing t_AllocatorRings[D3D12_COMMAND_LIST_TYPE_COPY + 1];
+}
+
 CommandAllocatorPool::CommandAllocatorPool(D3D12_COMMAND_LIST_TYPE Type) :
     m_cCommandListType(Type),
+    m_Generation(1),
+    m_NumLocalHits(0),
     m_Device(nullptr)
 {
+    ASSERT(Type < _countof(t_AllocatorRings));
 }
 
 CommandAllocatorPool::~CommandAllocatorPool()
@@ -32,14 +54,44 @@ void CommandAllocatorPool::Create(ID3D12Device * pDevice)
 
 void CommandAllocatorPool::Shutdown()
 {
+    m_Generation.fetch_add(1, std::memory_order_release);
+
     for (size_t i = 0; i < m_AllocatorPool.size(); ++i)
         m_AllocatorPool[i]->Release();
 
     m_AllocatorPool.clear();
+    m_ReadyAllocators = std::queue<std::pair<uint64_t, ID3D12CommandAllocator*>>();
+}
+
+static AllocatorRing& GetAllocatorRing(D3D12_COMMAND_LIST_TYPE Type, uint32_t Generation)
+{
+    AllocatorRing& Ring = t_AllocatorRings[Type];
+
+    // Allocators cached before the last Shutdown() no longer exist
+    if (Ring.Generation != Generation)
+    {
+        Ring.Generation = Generation;
+        Ring.First = 0;
+        Ring.Count = 0;
+    }
+    return Ring;
 }
 
 ID3D12CommandAllocator * CommandAllocatorPool::RequestAllocator(uint64_t CompletedFenceValue)
 {
+    AllocatorRing& Ring = GetAllocatorRing(m_cCommandListType, m_Generation.load(std::memory_order_acquire));
+
+    if (Ring.Count > 0 && Ring.FenceValues[Ring.First] <= CompletedFenceValue)
+    {
+        ID3D12CommandAllocator* pAllocator = Ring.Allocators[Ring.First];
+        Ring.First = (Ring.First + 1) % AllocatorRing::kCapacity;
+        --Ring.Count;
+
+        ASSERT_SUCCEEDED(pAllocator->Reset());
+        m_NumLocalHits.fetch_add(1, std::memory_order_relaxed);
+        return pAllocator;
+    }
+
     std::lock_guard<std::mutex> LockGuard(m_AllocatorMutex);
 
     ID3D12CommandAllocator* pAllocator = nullptr;
@@ -71,6 +123,17 @@ ID3D12CommandAllocator * CommandAllocatorPool::RequestAllocator(uint64_t Complet
 
 void CommandAllocatorPool::DiscardAllocator(uint64_t FenceValue, ID3D12CommandAllocator * Allocator)
 {
+    AllocatorRing& Ring = GetAllocatorRing(m_cCommandListType, m_Generation.load(std::memory_order_acquire));
+
+    if (Ring.Count < AllocatorRing::kCapacity)
+    {
+        uint32_t Last = (Ring.First + Ring.Count) % AllocatorRing::kCapacity;
+        Ring.FenceValues[Last] = FenceValue;
+        Ring.Allocators[Last] = Allocator;
+        ++Ring.Count;
+        return;
+    }
+
     std::lock_guard<std::mutex> LockGuard(m_AllocatorMutex);
 
     // That fence value indicates we are free to reset the allocator
@@ -16,6 +16,7 @@
 #include <vector>
 #include <queue>
 #include <mutex>
+#include <atomic>
 #include <stdint.h>
 
 class CommandAllocatorPool
@@ -27,14 +28,22 @@ public:
     void Create(ID3D12Device* pDevice);
     void Shutdown();
 
+    // Allocators are discarded into a small ring owned by the calling thread and reused from it once their
+    // fence has passed, so most requests never take the mutex.  Only a full ring spills to the shared queue.
     ID3D12CommandAllocator* RequestAllocator(uint64_t CompletedFenceValue);
     void DiscardAllocator(uint64_t FenceValue, ID3D12CommandAllocator* Allocator);
 
     inline size_t Size() { return m_AllocatorPool.size(); }
 
+    uint64_t GetNumLocalHits(void) const { return m_NumLocalHits.load(std::memory_order_relaxed); }
+
 private:
     const D3D12_COMMAND_LIST_TYPE m_cCommandListType;
 
+    // Bumped by Shutdown() so that threads drop allocators cached in their rings
+    std::atomic<uint32_t> m_Generation;
+    std::atomic<uint64_t> m_NumLocalHits;
+
     ID3D12Device* m_Device;
     std::vector<ID3D12CommandAllocator*> m_AllocatorPool;
     std::queue<std::pair<uint64_t, ID3D12CommandAllocator*>> m_ReadyAllocators;
@@ -18,6 +18,8 @@
 #include "GraphicsCore.h"
 #include "DescriptorHeap.h"
 #include "EngineProfiling.h"
+#include "UploadManager.h"
+#include "ReadbackManager.h"
 
 #ifndef RELEASE
     #include <d3d11_2.h>
@@ -26,6 +28,9 @@
 
 using namespace Graphics;
 
+std::mutex CommandContext::sm_SubmissionMutex;
+std::map<std::wstring, std::vector<CommandContext::PlannedTransition>> CommandContext::sm_TransitionPlans;
+std::mutex CommandContext::sm_TransitionPlanMutex;
 
 void ContextManager::DestroyAllContexts(void)
 {
@@ -94,15 +99,62 @@ ComputeContext& ComputeContext::Begin(const std::wstring& ID, bool Async)
 
 uint64_t CommandContext::Flush(bool WaitForCompletion)
 {
+    EndDeferredTransitions(false);
     FlushResourceBarriers();
 
     ASSERT(m_CurrentAllocator != nullptr);
 
-    uint64_t FenceValue = g_CommandManager.GetQueue(m_Type).ExecuteCommandList(m_CommandList);
+    uint64_t FenceValue = Submit(nullptr, 0);
 
     if (WaitForCompletion)
         g_CommandManager.WaitForFence(FenceValue);
 
+    RestoreCommandListState();
+
+    return FenceValue;
+}
+
+uint64_t CommandContext::FlushAndJoin( CommandContext* const* Contexts, uint32_t NumContexts, bool WaitForCompletion )
+{
+    ASSERT(NumContexts < 64, "Exceeded arbitrary limit on joined contexts");
+
+    EndDeferredTransitions(false);
+    FlushResourceBarriers();
+
+    ASSERT(m_CurrentAllocator != nullptr);
+
+    for (uint32_t i = 0; i < NumContexts; ++i)
+    {
+        CommandContext& Context = *Contexts[i];
+
+        ASSERT(Context.m_Type == m_Type, "Joined contexts must be executed on the same queue");
+        ASSERT(Context.m_CurrentAllocator != nullptr);
+
+        Context.EndDeferredTransitions(true);
+        Context.FlushResourceBarriers();
+
+        if (Context.m_ID.length() > 0)
+            EngineProfiling::EndBlock(&Context);
+    }
+
+    uint64_t FenceValue = Submit(Contexts, NumContexts);
+
+    for (uint32_t i = 0; i < NumContexts; ++i)
+    {
+        Contexts[i]->RetireResources(FenceValue);
+        g_ContextManager.FreeContext(Contexts[i]);
+    }
+
+    if (WaitForCompletion)
+        g_CommandManager.WaitForFence(FenceValue);
+
+    RestoreCommandListState();
+
+    return FenceValue;
+}
+
+void CommandContext::RestoreCommandListState( void )
+{
     //
     // Reset the command list and restore previous state
     //
@@ -121,14 +173,14 @@ uint64_t CommandContext::Flush(bool WaitForCompletion)
     }
 
     BindDescriptorHeaps();
-
-    return FenceValue;
 }
 
 uint64_t CommandContext::Finish( bool WaitForCompletion )
 {
-    ASSERT(m_Type == D3D12_COMMAND_LIST_TYPE_DIRECT || m_Type == D3D12_COMMAND_LIST_TYPE_COMPUTE);
+    ASSERT(m_Type == D3D12_COMMAND_LIST_TYPE_DIRECT || m_Type == D3D12_COMMAND_LIST_TYPE_COMPUTE ||
+        m_Type == D3D12_COMMAND_LIST_TYPE_COPY);
 
+    EndDeferredTransitions(true);
     FlushResourceBarriers();
 
     if (m_ID.length() > 0)
@@ -136,23 +188,162 @@ uint64_t CommandContext::Finish( bool WaitForCompletion )
 
     ASSERT(m_CurrentAllocator != nullptr);
 
+    // The command list isn't reused until this context is, so it can wait in the queue's batch
+    uint64_t FenceValue = Submit(nullptr, 0, true);
+    RetireResources(FenceValue);
+
+    if (WaitForCompletion)
+        g_CommandManager.WaitForFence(FenceValue);
+
+    g_ContextManager.FreeContext(this);
+
+    return FenceValue;
+}
+
+uint64_t CommandContext::Submit( CommandContext* const* Joined, uint32_t NumJoined, bool Batch )
+{
+    ID3D12CommandList* CommandLists[128];
+    CommandContext* Patches[64];
+    UINT NumLists = 0;
+    UINT NumPatches = 0;
+
+    // Patches are resolved against the global states left by earlier submissions, so resolving and
+    // executing must not interleave with another submission
+    std::lock_guard<std::mutex> LockGuard(sm_SubmissionMutex);
+
+    for (uint32_t i = 0; i <= NumJoined; ++i)
+    {
+        CommandContext& Context = i == 0 ? *this : *Joined[i - 1];
+
+        if (Context.NeedsStatePatch())
+        {
+            ASSERT(NumPatches < _countof(Patches));
+            CommandContext* Patch = g_ContextManager.AllocateContext(m_Type);
+            Context.PublishTrackedStates(Patch);
+            Patch->FlushResourceBarriers();
+            Patches[NumPatches++] = Patch;
+            CommandLists[NumLists++] = Patch->m_CommandList;
+        }
+        else
+        {
+            Context.PublishTrackedStates(nullptr);
+        }
+
+        CommandLists[NumLists++] = Context.m_CommandList;
+    }
+
+    UploadManager::StallForJoinedUploads(m_Type);
     CommandQueue& Queue = g_CommandManager.GetQueue(m_Type);
+    uint64_t FenceValue = Batch ? Queue.QueueCommandLists(NumLists, CommandLists) :
+        Queue.ExecuteCommandLists(NumLists, CommandLists);
 
-    uint64_t FenceValue = Queue.ExecuteCommandList(m_CommandList);
-    Queue.DiscardAllocator(FenceValue, m_CurrentAllocator);
+    m_LastSubmitFence = FenceValue;
+    for (uint32_t i = 0; i < NumJoined; ++i)
+        Joined[i]->m_LastSubmitFence = FenceValue;
+
+    for (UINT i = 0; i < NumPatches; ++i)
+    {
+        Patches[i]->m_LastSubmitFence = FenceValue;
+        Patches[i]->RetireResources(FenceValue);
+        g_ContextManager.FreeContext(Patches[i]);
+    }
+
+    return FenceValue;
+}
+
+void CommandContext::TrackStatesLocally( void )
+{
+    ASSERT(m_NumBarriersToFlush == 0, "Local state tracking must start before any barriers are recorded");
+    ASSERT(!m_DeferTransitions, "Locally tracked contexts can't split barriers");
+    m_TrackStatesLocally = true;
+}
+
+void CommandContext::DeferTransitions( void )
+{
+    ASSERT(m_ID.length() > 0, "Deferred transitions are planned per context ID");
+    ASSERT(m_NumBarriersToFlush == 0, "Deferred transitions must start before any barriers are recorded");
+    ASSERT(!m_TrackStatesLocally, "Locally tracked contexts can't split barriers");
+    m_DeferTransitions = true;
+    m_PassIndex = 0;
+
+    // Contexts recorded at the same time under one ID share a plan, so only the first of them gets it
+    std::lock_guard<std::mutex> LockGuard(sm_TransitionPlanMutex);
+    auto Iter = sm_TransitionPlans.find(m_ID);
+    if (Iter != sm_TransitionPlans.end())
+        m_LastPlan.swap(Iter->second);
+}
+
+D3D12_RESOURCE_STATES CommandContext::GetUsageState( const GpuResource& Resource ) const
+{
+    for (const TrackedState& Tracked : m_TrackedStates)
+    {
+        if (Tracked.Resource == &Resource)
+            return Tracked.State;
+    }
+    return Resource.m_UsageState;
+}
+
+CommandContext::TrackedState* CommandContext::FindTrackedState( const GpuResource& Resource )
+{
+    // Contexts touch few resources, so a linear search beats hashing
+    for (TrackedState& Tracked : m_TrackedStates)
+    {
+        if (Tracked.Resource == &Resource)
+            return &Tracked;
+    }
+    return nullptr;
+}
+
+bool CommandContext::NeedsStatePatch( void ) const
+{
+    for (const TrackedState& Tracked : m_TrackedStates)
+    {
+        // Staying in the UAV state across lists still needs a UAV barrier, as it would within one list
+        const GpuResource& Resource = *Tracked.Resource;
+        if (Resource.m_UsageState != Tracked.InitialState ||
+            Tracked.InitialState == D3D12_RESOURCE_STATE_UNORDERED_ACCESS ||
+            Resource.m_TransitioningState != (D3D12_RESOURCE_STATES)-1)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+void CommandContext::PublishTrackedStates( CommandContext* Patch )
+{
+    for (TrackedState& Tracked : m_TrackedStates)
+    {
+        GpuResource& Resource = *Tracked.Resource;
+
+        if (Patch != nullptr)
+        {
+            // Finish a split barrier begun by another context before moving on
+            if (Resource.m_TransitioningState != (D3D12_RESOURCE_STATES)-1 &&
+                Resource.m_TransitioningState != Tracked.InitialState)
+            {
+                Patch->TransitionResource(Resource, Resource.m_TransitioningState);
+            }
+            Patch->TransitionResource(Resource, Tracked.InitialState);
+        }
+
+        Resource.m_UsageState = Tracked.State;
+    }
+
+    m_TrackedStates.clear();
+}
+
+void CommandContext::RetireResources( uint64_t FenceValue )
+{
+    ReadbackManager::SubmitRequests(*this, FenceValue);
+
+    g_CommandManager.GetQueue(m_Type).DiscardAllocator(FenceValue, m_CurrentAllocator);
     m_CurrentAllocator = nullptr;
 
     m_CpuLinearAllocator.CleanupUsedPages(FenceValue);
     m_GpuLinearAllocator.CleanupUsedPages(FenceValue);
     m_DynamicViewDescriptorHeap.CleanupUsedHeaps(FenceValue);
     m_DynamicSamplerDescriptorHeap.CleanupUsedHeaps(FenceValue);
-
-    if (WaitForCompletion)
-        g_CommandManager.WaitForFence(FenceValue);
-
-    g_ContextManager.FreeContext(this);
-
-    return FenceValue;
 }
 
 CommandContext::CommandContext(D3D12_COMMAND_LIST_TYPE Type) :
@@ -164,6 +355,7 @@ CommandContext::CommandContext(D3D12_COMMAND_LIST_TYPE Type) :
 {
     m_OwningManager = nullptr;
     m_CommandList = nullptr;
+    m_CommandList1 = nullptr;
     m_CurrentAllocator = nullptr;
     ZeroMemory(m_CurrentDescriptorHeaps, sizeof(m_CurrentDescriptorHeaps));
 
@@ -172,10 +364,17 @@ CommandContext::CommandContext(D3D12_COMMAND_LIST_TYPE Type) :
     m_CurComputeRootSignature = nullptr;
     m_CurComputePipelineState = nullptr;
     m_NumBarriersToFlush = 0;
+    ZeroMemory(&m_BarrierStats, sizeof(m_BarrierStats));
+    m_TrackStatesLocally = false;
+    m_DeferTransitions = false;
+    m_PassIndex = 0;
+    m_LastSubmitFence = 0;
 }
 
 CommandContext::~CommandContext( void )
 {
+    if (m_CommandList1 != nullptr)
+        m_CommandList1->Release();
     if (m_CommandList != nullptr)
         m_CommandList->Release();
 }
@@ -183,6 +382,9 @@ CommandContext::~CommandContext( void )
 void CommandContext::Initialize(void)
 {
     g_CommandManager.CreateNewCommandList(m_Type, &m_CommandList, &m_CurrentAllocator);
+
+    if (g_bDepthBoundsTestSupported && m_Type == D3D12_COMMAND_LIST_TYPE_DIRECT)
+        ASSERT_SUCCEEDED(m_CommandList->QueryInterface(MY_IID_PPV_ARGS(&m_CommandList1)));
 }
 
 void CommandContext::Reset( void )
@@ -190,7 +392,9 @@ void CommandContext::Reset( void )
     // We only call Reset() on previously freed contexts.  The command list persists, but we must
     // request a new allocator.
     ASSERT(m_CommandList != nullptr && m_CurrentAllocator == nullptr);
-    m_CurrentAllocator = g_CommandManager.GetQueue(m_Type).RequestAllocator();
+    CommandQueue& Queue = g_CommandManager.GetQueue(m_Type);
+    Queue.FlushBatchFor(m_LastSubmitFence);
+    m_CurrentAllocator = Queue.RequestAllocator();
     m_CommandList->Reset(m_CurrentAllocator, nullptr);
 
     m_CurGraphicsRootSignature = nullptr;
@@ -198,6 +402,12 @@ void CommandContext::Reset( void )
     m_CurComputeRootSignature = nullptr;
     m_CurComputePipelineState = nullptr;
     m_NumBarriersToFlush = 0;
+    m_TrackStatesLocally = false;
+    ASSERT(m_TrackedStates.empty());
+    m_DeferTransitions = false;
+    m_DeferredUses.clear();
+    m_LastPlan.clear();
+    m_Plan.clear();
 
     BindDescriptorHeaps();
 }
@@ -311,6 +521,13 @@ void GraphicsContext::SetViewportAndScissor( const D3D12_VIEWPORT& vp, const D3D
     m_CommandList->RSSetScissorRects( 1, &rect );
 }
 
+void GraphicsContext::SetViewportsAndScissors( UINT Count, const D3D12_VIEWPORT* vps, const D3D12_RECT* rects )
+{
+    ASSERT(Count <= D3D12_VIEWPORT_AND_SCISSORRECT_OBJECT_COUNT_PER_PIPELINE);
+    m_CommandList->RSSetViewports( Count, vps );
+    m_CommandList->RSSetScissorRects( Count, rects );
+}
+
 void GraphicsContext::SetViewport( const D3D12_VIEWPORT& vp )
 {
     m_CommandList->RSSetViewports( 1, &vp );
@@ -336,7 +553,29 @@ void GraphicsContext::SetScissor( const D3D12_RECT& rect )
 
 void CommandContext::TransitionResource(GpuResource& Resource, D3D12_RESOURCE_STATES NewState, bool FlushImmediate)
 {
-    D3D12_RESOURCE_STATES OldState = Resource.m_UsageState;
+    if (m_DeferTransitions)
+        NoteDeferredUse(Resource, NewState);
+
+    // Locally tracked contexts only know the states they have set themselves.  The first transition of a
+    // resource is left to the patch list that is resolved at submission.
+    TrackedState* Tracked = nullptr;
+    if (m_TrackStatesLocally)
+    {
+        Tracked = FindTrackedState(Resource);
+        if (Tracked == nullptr)
+        {
+            m_TrackedStates.push_back({ &Resource, NewState, NewState });
+            if (FlushImmediate)
+                FlushResourceBarriers();
+            return;
+        }
+    }
+
+    D3D12_RESOURCE_STATES& UsageState = Tracked ? Tracked->State : Resource.m_UsageState;
+    D3D12_RESOURCE_STATES OldState = UsageState;
+
+    // Split barriers are begun against the global state, so locally tracked contexts never end them
+    D3D12_RESOURCE_STATES TransitioningState = Tracked ? (D3D12_RESOURCE_STATES)-1 : Resource.m_TransitioningState;
 
     if (m_Type == D3D12_COMMAND_LIST_TYPE_COMPUTE)
     {
@@ -346,25 +585,72 @@ void CommandContext::TransitionResource(GpuResource& Resource, D3D12_RESOURCE_ST
 
     if (OldState != NewState)
     {
-        ASSERT(m_NumBarriersToFlush < 16, "Exceeded arbitrary limit on buffered barriers");
-        D3D12_RESOURCE_BARRIER& BarrierDesc = m_ResourceBarrierBuffer[m_NumBarriersToFlush++];
-
-        BarrierDesc.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
-        BarrierDesc.Transition.pResource = Resource.GetResource();
-        BarrierDesc.Transition.Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
-        BarrierDesc.Transition.StateBefore = OldState;
-        BarrierDesc.Transition.StateAfter = NewState;
-
-        // Check to see if we already started the transition
-        if (NewState == Resource.m_TransitioningState)
+        const D3D12_RESOURCE_STATES DepthStates = D3D12_RESOURCE_STATE_DEPTH_WRITE | D3D12_RESOURCE_STATE_DEPTH_READ;
+        if ((OldState & DepthStates) != 0 && (NewState & DepthStates) == 0)
+            m_BarrierStats.DepthExits++;
+
+        // A transition buffered since the last command can absorb this one, because nothing used the
+        // resource in between.  Split barrier halves are left alone.
+        int Pending = FindPendingBarrier(Resource.GetResource(), D3D12_RESOURCE_BARRIER_TYPE_TRANSITION);
+        if (Pending >= 0 && NewState != TransitioningState &&
+            m_ResourceBarrierBuffer[Pending].Flags == D3D12_RESOURCE_BARRIER_FLAG_NONE)
         {
-            BarrierDesc.Flags = D3D12_RESOURCE_BARRIER_FLAG_END_ONLY;
-            Resource.m_TransitioningState = (D3D12_RESOURCE_STATES)-1;
+            if (m_ResourceBarrierBuffer[Pending].Transition.StateBefore == NewState)
+            {
+                // A round trip out of and back into the UAV state still has to order the writes around it
+                if (NewState == D3D12_RESOURCE_STATE_UNORDERED_ACCESS)
+                {
+                    D3D12_RESOURCE_BARRIER& BarrierDesc = m_ResourceBarrierBuffer[Pending];
+                    BarrierDesc.Type = D3D12_RESOURCE_BARRIER_TYPE_UAV;
+                    BarrierDesc.Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
+                    BarrierDesc.UAV.pResource = Resource.GetResource();
+                    m_BarrierStats.Eliminated++;
+                }
+                else
+                {
+                    RemovePendingBarrier(Pending);
+                    m_BarrierStats.Eliminated += 2;
+                }
+            }
+            else
+            {
+                m_ResourceBarrierBuffer[Pending].Transition.StateAfter = NewState;
+                m_BarrierStats.Eliminated++;
+            }
+
+            UsageState = NewState;
         }
         else
-            BarrierDesc.Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
-
-        Resource.m_UsageState = NewState;
+        {
+            // Leaving the UAV state waits for outstanding writes, so a buffered UAV barrier is redundant
+            int PendingUAV = FindPendingBarrier(Resource.GetResource(), D3D12_RESOURCE_BARRIER_TYPE_UAV);
+            if (PendingUAV >= 0)
+            {
+                RemovePendingBarrier(PendingUAV);
+                m_BarrierStats.Eliminated++;
+            }
+
+            ASSERT(m_NumBarriersToFlush < 16, "Exceeded arbitrary limit on buffered barriers");
+            D3D12_RESOURCE_BARRIER& BarrierDesc = m_ResourceBarrierBuffer[m_NumBarriersToFlush++];
+
+            BarrierDesc.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
+            BarrierDesc.Transition.pResource = Resource.GetResource();
+            BarrierDesc.Transition.Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
+            BarrierDesc.Transition.StateBefore = OldState;
+            BarrierDesc.Transition.StateAfter = NewState;
+
+            // Check to see if we already started the transition
+            if (NewState == TransitioningState)
+            {
+                BarrierDesc.Flags = D3D12_RESOURCE_BARRIER_FLAG_END_ONLY;
+                Resource.m_TransitioningState = (D3D12_RESOURCE_STATES)-1;
+                m_BarrierStats.Split++;
+            }
+            else
+                BarrierDesc.Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
+
+            UsageState = NewState;
+        }
     }
     else if (NewState == D3D12_RESOURCE_STATE_UNORDERED_ACCESS)
         InsertUAVBarrier(Resource, FlushImmediate);
@@ -373,8 +659,24 @@ void CommandContext::TransitionResource(GpuResource& Resource, D3D12_RESOURCE_ST
         FlushResourceBarriers();
 }
 
+void CommandContext::TransitionDepthToReadOnly(DepthBuffer& Depth, bool FlushImmediate)
+{
+    D3D12_RESOURCE_STATES ReadState = D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE;
+    if (m_Type != D3D12_COMMAND_LIST_TYPE_COMPUTE)
+        ReadState |= D3D12_RESOURCE_STATE_DEPTH_READ | D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE;
+
+    TransitionResource(Depth, ReadState, FlushImmediate);
+}
+
 void CommandContext::BeginResourceTransition(GpuResource& Resource, D3D12_RESOURCE_STATES NewState, bool FlushImmediate)
 {
+    // The split would have to be ended against the global state, so transition right away instead
+    if (m_TrackStatesLocally)
+    {
+        TransitionResource(Resource, NewState, FlushImmediate);
+        return;
+    }
+
     // If it's already transitioning, finish that transition
     if (Resource.m_TransitioningState != (D3D12_RESOURCE_STATES)-1)
         TransitionResource(Resource, Resource.m_TransitioningState);
@@ -395,36 +697,212 @@ void CommandContext::BeginResourceTransition(GpuResource& Resource, D3D12_RESOUR
         BarrierDesc.Flags = D3D12_RESOURCE_BARRIER_FLAG_BEGIN_ONLY;
 
         Resource.m_TransitioningState = NewState;
+        m_BarrierStats.Split++;
     }
 
     if (FlushImmediate || m_NumBarriersToFlush == 16)
         FlushResourceBarriers();
 }
 
+void CommandContext::NoteDeferredUse( GpuResource& Resource, D3D12_RESOURCE_STATES NewState )
+{
+    DeferredUse* Use = nullptr;
+    for (DeferredUse& Iter : m_DeferredUses)
+    {
+        if (Iter.Resource == &Resource)
+        {
+            Use = &Iter;
+            break;
+        }
+    }
+    if (Use == nullptr)
+    {
+        m_DeferredUses.push_back({ &Resource, Resource.m_UsageState, 0, m_PassIndex, false });
+        Use = &m_DeferredUses.back();
+    }
+
+    if (Use->Begun)
+    {
+        // Unless the plan was right and something was recorded since the begin, TransitionResource() can't
+        // end the split itself
+        int Pending = FindPendingBarrier(Resource.GetResource(), D3D12_RESOURCE_BARRIER_TYPE_TRANSITION);
+        if (NewState != Resource.m_TransitioningState ||
+            (Pending >= 0 && m_ResourceBarrierBuffer[Pending].Flags == D3D12_RESOURCE_BARRIER_FLAG_BEGIN_ONLY))
+        {
+            EndSplitTransition(Resource);
+        }
+        Use->Begun = false;
+    }
+
+    // The plan follows the states asked for, whatever barriers they ended up needing
+    if (NewState != Use->State)
+    {
+        m_Plan.push_back({ Resource.GetResource(), Use->Segment, Use->LastPass, NewState });
+        Use->State = NewState;
+        Use->Segment++;
+    }
+    Use->LastPass = m_PassIndex;
+}
+
+void CommandContext::BeginPlannedTransitions( void )
+{
+    // Begin moving the resources this pass was the last to use in their current states, as they were moved
+    // the last time
+    for (const PlannedTransition& Planned : m_LastPlan)
+    {
+        if (Planned.LastPass != m_PassIndex)
+            continue;
+
+        for (DeferredUse& Use : m_DeferredUses)
+        {
+            GpuResource& Resource = *Use.Resource;
+            if (Resource.GetResource() != Planned.Resource)
+                continue;
+
+            if (!Use.Begun && Use.Segment == Planned.Segment && Use.LastPass == m_PassIndex &&
+                Use.State == Resource.m_UsageState && Use.State != Planned.NextState &&
+                Resource.m_TransitioningState == (D3D12_RESOURCE_STATES)-1 &&
+                FindPendingBarrier(Resource.GetResource(), D3D12_RESOURCE_BARRIER_TYPE_TRANSITION) < 0 &&
+                (m_Type != D3D12_COMMAND_LIST_TYPE_COMPUTE ||
+                (Planned.NextState & VALID_COMPUTE_QUEUE_RESOURCE_STATES) == Planned.NextState))
+            {
+                BeginResourceTransition(Resource, Planned.NextState);
+                Use.Begun = true;
+            }
+            break;
+        }
+    }
+
+    ++m_PassIndex;
+}
+
+void CommandContext::EndSplitTransition( GpuResource& Resource )
+{
+    ASSERT(Resource.m_TransitioningState != (D3D12_RESOURCE_STATES)-1);
+
+    // Nothing was recorded since the begin, so it can become a full transition
+    int Pending = FindPendingBarrier(Resource.GetResource(), D3D12_RESOURCE_BARRIER_TYPE_TRANSITION);
+    if (Pending >= 0 && m_ResourceBarrierBuffer[Pending].Flags == D3D12_RESOURCE_BARRIER_FLAG_BEGIN_ONLY)
+    {
+        m_ResourceBarrierBuffer[Pending].Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
+        m_BarrierStats.Split--;
+    }
+    else
+    {
+        ASSERT(m_NumBarriersToFlush < 16, "Exceeded arbitrary limit on buffered barriers");
+        D3D12_RESOURCE_BARRIER& BarrierDesc = m_ResourceBarrierBuffer[m_NumBarriersToFlush++];
+
+        BarrierDesc.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
+        BarrierDesc.Flags = D3D12_RESOURCE_BARRIER_FLAG_END_ONLY;
+        BarrierDesc.Transition.pResource = Resource.GetResource();
+        BarrierDesc.Transition.Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
+        BarrierDesc.Transition.StateBefore = Resource.m_UsageState;
+        BarrierDesc.Transition.StateAfter = Resource.m_TransitioningState;
+        m_BarrierStats.Split++;
+    }
+
+    Resource.m_UsageState = Resource.m_TransitioningState;
+    Resource.m_TransitioningState = (D3D12_RESOURCE_STATES)-1;
+
+    if (m_NumBarriersToFlush == 16)
+        FlushResourceBarriers();
+}
+
+void CommandContext::EndDeferredTransitions( bool FinishRecording )
+{
+    if (!m_DeferTransitions)
+        return;
+
+    for (DeferredUse& Use : m_DeferredUses)
+    {
+        if (Use.Begun)
+        {
+            EndSplitTransition(*Use.Resource);
+            Use.Begun = false;
+        }
+    }
+
+    if (FinishRecording)
+    {
+        std::lock_guard<std::mutex> LockGuard(sm_TransitionPlanMutex);
+        sm_TransitionPlans[m_ID].swap(m_Plan);
+        m_DeferTransitions = false;
+    }
+}
+
 void CommandContext::InsertUAVBarrier(GpuResource& Resource, bool FlushImmediate)
+{
+    // Nothing can have written the resource since a buffered UAV barrier or full transition
+    int PendingTransition = FindPendingBarrier(Resource.GetResource(), D3D12_RESOURCE_BARRIER_TYPE_TRANSITION);
+    if (FindPendingBarrier(Resource.GetResource(), D3D12_RESOURCE_BARRIER_TYPE_UAV) >= 0 ||
+        (PendingTransition >= 0 && m_ResourceBarrierBuffer[PendingTransition].Flags == D3D12_RESOURCE_BARRIER_FLAG_NONE))
+    {
+        m_BarrierStats.Eliminated++;
+    }
+    else
+    {
+        ASSERT(m_NumBarriersToFlush < 16, "Exceeded arbitrary limit on buffered barriers");
+        D3D12_RESOURCE_BARRIER& BarrierDesc = m_ResourceBarrierBuffer[m_NumBarriersToFlush++];
+
+        BarrierDesc.Type = D3D12_RESOURCE_BARRIER_TYPE_UAV;
+        BarrierDesc.Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
+        BarrierDesc.UAV.pResource = Resource.GetResource();
+    }
+
+    if (FlushImmediate || m_NumBarriersToFlush == 16)
+        FlushResourceBarriers();
+}
+
+int CommandContext::FindPendingBarrier( ID3D12Resource* Resource, D3D12_RESOURCE_BARRIER_TYPE Type ) const
+{
+    for (UINT i = 0; i < m_NumBarriersToFlush; ++i)
+    {
+        const D3D12_RESOURCE_BARRIER& Barrier = m_ResourceBarrierBuffer[i];
+        if (Barrier.Type != Type)
+            continue;
+
+        if (Type == D3D12_RESOURCE_BARRIER_TYPE_TRANSITION && Barrier.Transition.pResource == Resource)
+            return (int)i;
+        if (Type == D3D12_RESOURCE_BARRIER_TYPE_UAV && Barrier.UAV.pResource == Resource)
+            return (int)i;
+    }
+    return -1;
+}
+
+void CommandContext::RemovePendingBarrier( int Index )
+{
+    // Aliasing barriers must stay in order relative to each other, so shift rather than swap
+    ASSERT(Index >= 0 && (UINT)Index < m_NumBarriersToFlush);
+    for (UINT i = (UINT)Index + 1; i < m_NumBarriersToFlush; ++i)
+        m_ResourceBarrierBuffer[i - 1] = m_ResourceBarrierBuffer[i];
+    --m_NumBarriersToFlush;
+}
+
+void CommandContext::InsertAliasBarrier(GpuResource& Before, GpuResource& After, bool FlushImmediate)
 {
     ASSERT(m_NumBarriersToFlush < 16, "Exceeded arbitrary limit on buffered barriers");
     D3D12_RESOURCE_BARRIER& BarrierDesc = m_ResourceBarrierBuffer[m_NumBarriersToFlush++];
 
-    BarrierDesc.Type = D3D12_RESOURCE_BARRIER_TYPE_UAV;
+    BarrierDesc.Type = D3D12_RESOURCE_BARRIER_TYPE_ALIASING;
     BarrierDesc.Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
-    BarrierDesc.UAV.pResource = Resource.GetResource();
+    BarrierDesc.Aliasing.pResourceBefore = Before.GetResource();
+    BarrierDesc.Aliasing.pResourceAfter = After.GetResource();
 
-    if (FlushImmediate)
+    if (FlushImmediate || m_NumBarriersToFlush == 16)
         FlushResourceBarriers();
 }
 
-void CommandContext::InsertAliasBarrier(GpuResource& Before, GpuResource& After, bool FlushImmediate)
+void CommandContext::InsertAliasBarrier(GpuResource& After, bool FlushImmediate)
 {
     ASSERT(m_NumBarriersToFlush < 16, "Exceeded arbitrary limit on buffered barriers");
     D3D12_RESOURCE_BARRIER& BarrierDesc = m_ResourceBarrierBuffer[m_NumBarriersToFlush++];
 
     BarrierDesc.Type = D3D12_RESOURCE_BARRIER_TYPE_ALIASING;
     BarrierDesc.Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
-    BarrierDesc.Aliasing.pResourceBefore = Before.GetResource();
+    BarrierDesc.Aliasing.pResourceBefore = nullptr;
     BarrierDesc.Aliasing.pResourceAfter = After.GetResource();
 
-    if (FlushImmediate)
+    if (FlushImmediate || m_NumBarriersToFlush == 16)
         FlushResourceBarriers();
 }
 
@@ -446,6 +924,14 @@ void CommandContext::FillBuffer( GpuResource& Dest, size_t DestOffset, DWParam V
 
 void CommandContext::InitializeTexture( GpuResource& Dest, UINT NumSubresources, D3D12_SUBRESOURCE_DATA SubData[] )
 {
+    // Textures in the common state are batched onto the copy queue without waiting.  Every later graphics or
+    // compute submission waits on the GPU for the copy to land.
+    if (UploadManager::IsReady() && Dest.m_UsageState == D3D12_RESOURCE_STATE_COMMON)
+    {
+        UploadManager::JoinNextSubmission(UploadManager::UploadTexture(Dest, 0, NumSubresources, SubData));
+        return;
+    }
+
     UINT64 uploadBufferSize = GetRequiredIntermediateSize(Dest.GetResource(), 0, NumSubresources);
 
     CommandContext& InitContext = CommandContext::Begin();
@@ -459,6 +945,33 @@ void CommandContext::InitializeTexture( GpuResource& Dest, UINT NumSubresources,
     InitContext.Finish(true);
 }
 
+uint64_t CommandContext::InitializeTextureAsync( GpuResource& Dest, UINT FirstSubresource, UINT NumSubresources,
+    const D3D12_SUBRESOURCE_DATA SubData[] )
+{
+    UINT64 uploadBufferSize = GetRequiredIntermediateSize(Dest.GetResource(), FirstSubresource, NumSubresources);
+
+    CommandContext& CopyContext = *g_ContextManager.AllocateContext(D3D12_COMMAND_LIST_TYPE_COPY);
+
+    // The texture is implicitly promoted to the copy destination state and decays back to the common state
+    // when the copy completes, so no barriers are required on either queue.
+    DynAlloc mem = CopyContext.ReserveUploadMemory(uploadBufferSize);
+    UpdateSubresources(CopyContext.m_CommandList, Dest.GetResource(), mem.Buffer.GetResource(), mem.Offset,
+        FirstSubresource, NumSubresources, const_cast<D3D12_SUBRESOURCE_DATA*>(SubData));
+
+    // The upload memory is retired with the fence, so there is no need to wait here
+    return CopyContext.Finish(false);
+}
+
+uint64_t CommandContext::InitializeBufferAsync( GpuResource& Dest, ID3D12Resource* Src, size_t SrcOffset, size_t NumBytes )
+{
+    CommandContext& CopyContext = *g_ContextManager.AllocateContext(D3D12_COMMAND_LIST_TYPE_COPY);
+
+    // Buffers are implicitly promoted to the copy states and decay back to common afterwards
+    CopyContext.m_CommandList->CopyBufferRegion(Dest.GetResource(), 0, Src, SrcOffset, NumBytes);
+
+    return CopyContext.Finish(false);
+}
+
 void CommandContext::CopySubresource(GpuResource& Dest, UINT DestSubIndex, GpuResource& Src, UINT SrcSubIndex)
 {
     FlushResourceBarriers();
@@ -480,6 +993,15 @@ void CommandContext::CopySubresource(GpuResource& Dest, UINT DestSubIndex, GpuRe
     m_CommandList->CopyTextureRegion(&DestLocation, 0, 0, 0, &SrcLocation, nullptr);
 }
 
+void CommandContext::CopyTextureToBuffer(GpuResource& Dest, const D3D12_PLACED_SUBRESOURCE_FOOTPRINT& Footprint, GpuResource& Src, UINT SrcSubIndex)
+{
+    FlushResourceBarriers();
+
+    m_CommandList->CopyTextureRegion(
+        &CD3DX12_TEXTURE_COPY_LOCATION(Dest.GetResource(), Footprint), 0, 0, 0,
+        &CD3DX12_TEXTURE_COPY_LOCATION(Src.GetResource(), SrcSubIndex), nullptr);
+}
+
 void CommandContext::InitializeTextureArraySlice(GpuResource& Dest, UINT SliceIndex, GpuResource& Src)
 {
     CommandContext& Context = CommandContext::Begin();
@@ -543,10 +1065,17 @@ void CommandContext::ReadbackTexture2D(GpuResource& ReadbackBuffer, PixelBuffer&
 
 void CommandContext::InitializeBuffer( GpuResource& Dest, const void* BufferData, size_t NumBytes, size_t Offset)
 {
+    // Same as InitializeTexture().  Buffers in any other state are still uploaded synchronously.
+    if (UploadManager::IsReady() && Dest.m_UsageState == D3D12_RESOURCE_STATE_COMMON)
+    {
+        UploadManager::JoinNextSubmission(UploadManager::UploadBuffer(Dest, Offset, BufferData, NumBytes));
+        return;
+    }
+
     CommandContext& InitContext = CommandContext::Begin();
 
     DynAlloc mem = InitContext.ReserveUploadMemory(NumBytes);
-    SIMDMemCopy(mem.DataPtr, BufferData, Math::DivideByMultiple(NumBytes, 16));
+    SIMDMemCopyParallel(mem.DataPtr, BufferData, Math::DivideByMultiple(NumBytes, 16));
 
     // copy data to the intermediate upload heap and then schedule a copy from the upload heap to the default texture
     InitContext.TransitionResource(Dest, D3D12_RESOURCE_STATE_COPY_DEST, true);
@@ -559,6 +1088,9 @@ void CommandContext::InitializeBuffer( GpuResource& Dest, const void* BufferData
 
 void CommandContext::PIXBeginEvent(const wchar_t* label)
 {
+    if (m_DeferTransitions)
+        BeginPlannedTransitions();
+
 #ifdef RELEASE
     (label);
 #else
@@ -568,6 +1100,9 @@ void CommandContext::PIXBeginEvent(const wchar_t* label)
 
 void CommandContext::PIXEndEvent(void)
 {
+    if (m_DeferTransitions)
+        BeginPlannedTransitions();
+
 #ifndef RELEASE
     ::PIXEndEvent(m_CommandList);
 #endif
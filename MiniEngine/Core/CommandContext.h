@@ -26,6 +26,7 @@
 #include "CommandSignature.h"
 #include "GraphicsCore.h"
 #include <vector>
+#include <map>
 
 class ColorBuffer;
 class DepthBuffer;
@@ -54,6 +55,7 @@ struct DWParam
 #define VALID_COMPUTE_QUEUE_RESOURCE_STATES \
     ( D3D12_RESOURCE_STATE_UNORDERED_ACCESS \
     | D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE \
+    | D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT \
     | D3D12_RESOURCE_STATE_COPY_DEST \
     | D3D12_RESOURCE_STATE_COPY_SOURCE )
 
@@ -102,6 +104,11 @@ public:
     // Flush existing commands and release the current context
     uint64_t Finish( bool WaitForCompletion = false );
 
+    // Flush existing commands followed by the commands of each of the given contexts, in order, as one
+    // submission.  The joined contexts are released, but this context stays alive.  This is how work
+    // recorded on other threads is stitched back into the frame.
+    uint64_t FlushAndJoin( CommandContext* const* Contexts, uint32_t NumContexts, bool WaitForCompletion = false );
+
     // Prepare to render by reserving a command list and command allocator
     void Initialize(void);
 
@@ -118,9 +125,14 @@ public:
         return m_CommandList;
     }
 
+    D3D12_COMMAND_LIST_TYPE GetType() const {
+        return m_Type;
+    }
+
     void CopyBuffer( GpuResource& Dest, GpuResource& Src );
     void CopyBufferRegion( GpuResource& Dest, size_t DestOffset, GpuResource& Src, size_t SrcOffset, size_t NumBytes );
     void CopySubresource(GpuResource& Dest, UINT DestSubIndex, GpuResource& Src, UINT SrcSubIndex);
+    void CopyTextureToBuffer(GpuResource& Dest, const D3D12_PLACED_SUBRESOURCE_FOOTPRINT& Footprint, GpuResource& Src, UINT SrcSubIndex);
     void CopyCounter(GpuResource& Dest, size_t DestOffset, StructuredBuffer& Src);
     void ResetCounter(StructuredBuffer& Buf, uint32_t Value = 0);
 
@@ -129,20 +141,75 @@ public:
         return m_CpuLinearAllocator.Allocate(SizeInBytes);
     }
 
+    // Resources in the common state are uploaded through the UploadManager and do not block.  Anything else
+    // is uploaded on the graphics queue and waited for.
     static void InitializeTexture( GpuResource& Dest, UINT NumSubresources, D3D12_SUBRESOURCE_DATA SubData[] );
+
+    // Upload a range of subresources on the copy queue without waiting.  The texture must be in the common
+    // state.  Returns the fence value that signals completion.
+    static uint64_t InitializeTextureAsync( GpuResource& Dest, UINT FirstSubresource, UINT NumSubresources,
+        const D3D12_SUBRESOURCE_DATA SubData[] );
     static void InitializeBuffer( GpuResource& Dest, const void* Data, size_t NumBytes, size_t Offset = 0);
+
+    // Copy a range of an existing buffer (e.g. one placed in a CPU-visible heap) on the copy queue without
+    // waiting.  Both buffers must be in the common state.  Returns the fence value that signals completion.
+    static uint64_t InitializeBufferAsync( GpuResource& Dest, ID3D12Resource* Src, size_t SrcOffset, size_t NumBytes );
     static void InitializeTextureArraySlice(GpuResource& Dest, UINT SliceIndex, GpuResource& Src);
     static void ReadbackTexture2D(GpuResource& ReadbackBuffer, PixelBuffer& SrcBuffer);
 
     void WriteBuffer( GpuResource& Dest, size_t DestOffset, const void* Data, size_t NumBytes );
     void FillBuffer( GpuResource& Dest, size_t DestOffset, DWParam Value, size_t NumBytes );
 
+    // Record this context without reading or writing the global resource states, so that it can be recorded
+    // in parallel with others.  The first transition of a resource records no barrier.  Instead, when the
+    // context is submitted, a patch list that moves each resource from its global state into the state the
+    // context first needs is executed ahead of it, and the context's final states become the global ones.
+    // Must be called before the context transitions anything.
+    void TrackStatesLocally(void);
+
+    // Turn this context's transitions into split barriers without changing the code that records it.  Passes
+    // are the spans between profiling events on the context.  The context remembers, from its last recording
+    // under the same ID, the pass that last transitioned each resource before the resource moved to another
+    // state.  When that pass ends, the move is begun, and the transition that asks for the new state ends it,
+    // so the GPU can overlap the move with the passes in between.  A wrong guess, such as the resource being
+    // transitioned again to the state it was in, ends the split early and costs a barrier.  This relies on every
+    // pass transitioning the resources it uses, even those already in the right state, because a resource that
+    // is only bound would be used in the middle of its move.  Split barriers still outstanding are ended when
+    // the context flushes.  Needs an ID and must be called before the context transitions anything.
+    void DeferTransitions(void);
+
+    // The state of the resource as seen by this context's commands
+    D3D12_RESOURCE_STATES GetUsageState(const GpuResource& Resource) const;
+
     void TransitionResource(GpuResource& Resource, D3D12_RESOURCE_STATES NewState, bool FlushImmediate = false);
+
+    // Make a depth buffer readable by shaders and, except on the compute queue, which can't use the depth states,
+    // as a read-only depth target.  Every reader asks for the same state, so they need no barriers between them,
+    // and staying in DEPTH_READ keeps hardware that compresses depth from decompressing it to leave the depth states.
+    void TransitionDepthToReadOnly(DepthBuffer& Depth, bool FlushImmediate = false);
+
     void BeginResourceTransition(GpuResource& Resource, D3D12_RESOURCE_STATES NewState, bool FlushImmediate = false);
     void InsertUAVBarrier(GpuResource& Resource, bool FlushImmediate = false);
     void InsertAliasBarrier(GpuResource& Before, GpuResource& After, bool FlushImmediate = false);
+
+    // Alias in a placed resource without naming the one it replaces
+    void InsertAliasBarrier(GpuResource& After, bool FlushImmediate = false);
     inline void FlushResourceBarriers(void);
 
+    // Barriers are buffered until the next command that needs them.  While buffered, a transition of a
+    // resource that already has one pending is folded into it (A->B, B->C becomes A->C), a round trip back
+    // to the original state cancels out, and UAV barriers that a pending transition or UAV barrier already
+    // provides are dropped.  These counters cover the context's lifetime and are sampled per profiling block.
+    struct BarrierStats
+    {
+        uint32_t Submitted;     // Barriers passed to ResourceBarrier()
+        uint32_t Batches;       // Calls to ResourceBarrier()
+        uint32_t Eliminated;    // Barriers folded, cancelled or dropped before submission
+        uint32_t Split;         // Begin-only and end-only halves of split barriers
+        uint32_t DepthExits;    // Transitions out of the depth states, which may decompress depth
+    };
+    const BarrierStats& GetBarrierStats(void) const { return m_BarrierStats; }
+
     void InsertTimeStamp( ID3D12QueryHeap* pQueryHeap, uint32_t QueryIdx );
     void ResolveTimeStamps( ID3D12Resource* pReadbackHeap, ID3D12QueryHeap* pQueryHeap, uint32_t NumQueries );
     void PIXBeginEvent(const wchar_t* label);
@@ -158,8 +225,57 @@ protected:
 
     void BindDescriptorHeaps( void );
 
+    // Reset the command list after it was executed and restore the root signatures and PSOs
+    void RestoreCommandListState( void );
+
+    // Schedule the allocator, upload pages, and descriptor heaps for reuse once the fence is reached
+    void RetireResources( uint64_t FenceValue );
+
+    // Execute this context's commands, followed by those of the joined contexts, as one submission.  Patch
+    // lists for locally tracked contexts are resolved and inserted here, in submission order.  A batched
+    // submission is gathered by the queue and executed with other contexts' lists (see QueueCommandLists).
+    uint64_t Submit( CommandContext* const* Joined, uint32_t NumJoined, bool Batch = false );
+
+    struct TrackedState
+    {
+        GpuResource* Resource;
+        D3D12_RESOURCE_STATES InitialState;     // Needed at the start of the list
+        D3D12_RESOURCE_STATES State;            // At the current point of recording
+    };
+    TrackedState* FindTrackedState( const GpuResource& Resource );
+    bool NeedsStatePatch( void ) const;
+    void PublishTrackedStates( CommandContext* Patch );
+
+    // A resource's use by a context with deferred transitions.  A segment is the span of its use in one state.
+    struct DeferredUse
+    {
+        GpuResource* Resource;
+        D3D12_RESOURCE_STATES State;            // As last requested by the caller
+        uint32_t Segment;
+        uint32_t LastPass;                      // The last pass that transitioned it in this segment
+        bool Begun;                             // Its next transition was begun from the plan
+    };
+    struct PlannedTransition
+    {
+        ID3D12Resource* Resource;
+        uint32_t Segment;
+        uint32_t LastPass;
+        D3D12_RESOURCE_STATES NextState;
+    };
+    void NoteDeferredUse( GpuResource& Resource, D3D12_RESOURCE_STATES NewState );
+    void BeginPlannedTransitions( void );
+    void EndSplitTransition( GpuResource& Resource );
+
+    // End the outstanding split barriers.  When the recording is finished, its plan is kept for the next one.
+    void EndDeferredTransitions( bool FinishRecording );
+
+    // Index of the buffered barrier of this type for the resource, or -1
+    int FindPendingBarrier( ID3D12Resource* Resource, D3D12_RESOURCE_BARRIER_TYPE Type ) const;
+    void RemovePendingBarrier( int Index );
+
     CommandListManager* m_OwningManager;
     ID3D12GraphicsCommandList* m_CommandList;
+    ID3D12GraphicsCommandList1* m_CommandList1;     // Only when the depth bounds test is supported
     ID3D12CommandAllocator* m_CurrentAllocator;
 
     ID3D12RootSignature* m_CurGraphicsRootSignature;
@@ -172,6 +288,22 @@ protected:
 
     D3D12_RESOURCE_BARRIER m_ResourceBarrierBuffer[16];
     UINT m_NumBarriersToFlush;
+    BarrierStats m_BarrierStats;
+
+    bool m_TrackStatesLocally;
+
+    bool m_DeferTransitions;
+    uint32_t m_PassIndex;
+    std::vector<DeferredUse> m_DeferredUses;
+    std::vector<PlannedTransition> m_LastPlan;      // Recorded the last time a context with this ID finished
+    std::vector<PlannedTransition> m_Plan;          // Recorded so far by this context
+    static std::map<std::wstring, std::vector<PlannedTransition>> sm_TransitionPlans;
+    static std::mutex sm_TransitionPlanMutex;
+
+    // The command list can't be reset until the batch holding it has been submitted
+    uint64_t m_LastSubmitFence;
+    std::vector<TrackedState> m_TrackedStates;
+    static std::mutex sm_SubmissionMutex;
 
     ID3D12DescriptorHeap* m_CurrentDescriptorHeaps[D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES];
 
@@ -218,8 +350,13 @@ public:
     void SetScissor( UINT left, UINT top, UINT right, UINT bottom );
     void SetViewportAndScissor( const D3D12_VIEWPORT& vp, const D3D12_RECT& rect );
     void SetViewportAndScissor( UINT x, UINT y, UINT w, UINT h );
+    // One viewport and scissor rectangle for each SV_ViewportArrayIndex
+    void SetViewportsAndScissors( UINT Count, const D3D12_VIEWPORT* vps, const D3D12_RECT* rects );
     void SetStencilRef( UINT StencilRef );
     void SetBlendFactor( Color BlendFactor );
+    // PSOs with the depth bounds test enabled discard pixels whose depth buffer value lies outside [Min, Max].
+    // The bounds reset to [0, 1] with every command list and are ignored without hardware support.
+    void SetDepthBounds( float Min, float Max );
     void SetPrimitiveTopology( D3D12_PRIMITIVE_TOPOLOGY Topology );
 
     void SetPipelineState( const GraphicsPSO& PSO );
@@ -254,6 +391,9 @@ public:
     void DrawIndexedInstanced(UINT IndexCountPerInstance, UINT InstanceCount, UINT StartIndexLocation,
         INT BaseVertexLocation, UINT StartInstanceLocation);
     void DrawIndirect( GpuBuffer& ArgumentBuffer, uint64_t ArgumentBufferOffset = 0 );
+    // Submits the number of packed D3D12_DRAW_INDEXED_ARGUMENTS found at CountBufferOffset, up to MaxCount
+    void MultiDrawIndexedIndirect( GpuBuffer& ArgumentBuffer, uint64_t ArgumentBufferOffset, uint32_t MaxCount,
+        GpuBuffer& CountBuffer, uint64_t CountBufferOffset = 0 );
     void ExecuteIndirect(CommandSignature& CommandSig, GpuBuffer& ArgumentBuffer, uint64_t ArgumentStartOffset = 0,
         uint32_t MaxCommands = 1, GpuBuffer* CommandCounterBuffer = nullptr, uint64_t CounterOffset = 0);
 
@@ -306,6 +446,8 @@ inline void CommandContext::FlushResourceBarriers( void )
     if (m_NumBarriersToFlush > 0)
     {
         m_CommandList->ResourceBarrier(m_NumBarriersToFlush, m_ResourceBarrierBuffer);
+        m_BarrierStats.Submitted += m_NumBarriersToFlush;
+        m_BarrierStats.Batches++;
         m_NumBarriersToFlush = 0;
     }
 }
@@ -335,6 +477,8 @@ inline void ComputeContext::SetRootSignature( const RootSignature& RootSig )
 inline void GraphicsContext::SetPipelineState( const GraphicsPSO& PSO )
 {
     ID3D12PipelineState* PipelineState = PSO.GetPipelineStateObject();
+    if (PipelineState == nullptr)
+        PipelineState = PSO.GetFallbackPipelineStateObject();
     if (PipelineState == m_CurGraphicsPipelineState)
         return;
 
@@ -345,6 +489,8 @@ inline void GraphicsContext::SetPipelineState( const GraphicsPSO& PSO )
 inline void ComputeContext::SetPipelineState( const ComputePSO& PSO )
 {
     ID3D12PipelineState* PipelineState = PSO.GetPipelineStateObject();
+    if (PipelineState == nullptr)
+        PipelineState = PSO.GetFallbackPipelineStateObject();
     if (PipelineState == m_CurComputePipelineState)
         return;
 
@@ -373,6 +519,13 @@ inline void GraphicsContext::SetBlendFactor( Color BlendFactor )
     m_CommandList->OMSetBlendFactor( BlendFactor.GetPtr() );
 }
 
+inline void GraphicsContext::SetDepthBounds( float Min, float Max )
+{
+    ASSERT(0.0f <= Min && Min <= Max && Max <= 1.0f, "Depth bounds must be an ordered range within [0, 1]");
+    if (m_CommandList1 != nullptr)
+        m_CommandList1->OMSetDepthBounds( Min, Max );
+}
+
 inline void GraphicsContext::SetPrimitiveTopology( D3D12_PRIMITIVE_TOPOLOGY Topology )
 {
     m_CommandList->IASetPrimitiveTopology(Topology);
@@ -464,8 +617,7 @@ inline void GraphicsContext::SetDynamicConstantBufferView( UINT RootIndex, size_
 {
     ASSERT(BufferData != nullptr && Math::IsAligned(BufferData, 16));
     DynAlloc cb = m_CpuLinearAllocator.Allocate(BufferSize);
-    //SIMDMemCopy(cb.DataPtr, BufferData, Math::AlignUp(BufferSize, 16) >> 4);
-    memcpy(cb.DataPtr, BufferData, BufferSize);
+    SIMDMemCopy(cb.DataPtr, BufferData, Math::AlignUp(BufferSize, 16) >> 4);
     m_CommandList->SetGraphicsRootConstantBufferView(RootIndex, cb.GpuAddress);
 }
 
@@ -473,8 +625,7 @@ inline void ComputeContext::SetDynamicConstantBufferView( UINT RootIndex, size_t
 {
     ASSERT(BufferData != nullptr && Math::IsAligned(BufferData, 16));
     DynAlloc cb = m_CpuLinearAllocator.Allocate(BufferSize);
-    //SIMDMemCopy(cb.DataPtr, BufferData, Math::AlignUp(BufferSize, 16) >> 4);
-    memcpy(cb.DataPtr, BufferData, BufferSize);
+    SIMDMemCopy(cb.DataPtr, BufferData, Math::AlignUp(BufferSize, 16) >> 4);
     m_CommandList->SetComputeRootConstantBufferView(RootIndex, cb.GpuAddress);
 }
 
@@ -530,25 +681,25 @@ inline void ComputeContext::SetDynamicSRV(UINT RootIndex, size_t BufferSize, con
 
 inline void GraphicsContext::SetBufferSRV( UINT RootIndex, const GpuBuffer& SRV, UINT64 Offset)
 {
-    ASSERT((SRV.m_UsageState & (D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE | D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE)) != 0);
+    ASSERT((GetUsageState(SRV) & (D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE | D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE)) != 0);
     m_CommandList->SetGraphicsRootShaderResourceView(RootIndex, SRV.GetGpuVirtualAddress() + Offset);
 }
 
 inline void ComputeContext::SetBufferSRV( UINT RootIndex, const GpuBuffer& SRV, UINT64 Offset)
 {
-    ASSERT((SRV.m_UsageState & D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE) != 0);
+    ASSERT((GetUsageState(SRV) & D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE) != 0);
     m_CommandList->SetComputeRootShaderResourceView(RootIndex, SRV.GetGpuVirtualAddress() + Offset);
 }
 
 inline void GraphicsContext::SetBufferUAV( UINT RootIndex, const GpuBuffer& UAV, UINT64 Offset)
 {
-    ASSERT((UAV.m_UsageState & D3D12_RESOURCE_STATE_UNORDERED_ACCESS) != 0);
+    ASSERT((GetUsageState(UAV) & D3D12_RESOURCE_STATE_UNORDERED_ACCESS) != 0);
     m_CommandList->SetGraphicsRootUnorderedAccessView(RootIndex, UAV.GetGpuVirtualAddress() + Offset);
 }
 
 inline void ComputeContext::SetBufferUAV( UINT RootIndex, const GpuBuffer& UAV, UINT64 Offset)
 {
-    ASSERT((UAV.m_UsageState & D3D12_RESOURCE_STATE_UNORDERED_ACCESS) != 0);
+    ASSERT((GetUsageState(UAV) & D3D12_RESOURCE_STATE_UNORDERED_ACCESS) != 0);
     m_CommandList->SetComputeRootUnorderedAccessView(RootIndex, UAV.GetGpuVirtualAddress() + Offset);
 }
 
@@ -721,6 +872,13 @@ inline void GraphicsContext::DrawIndirect(GpuBuffer& ArgumentBuffer, uint64_t Ar
     ExecuteIndirect(Graphics::DrawIndirectCommandSignature, ArgumentBuffer, ArgumentBufferOffset);
 }
 
+inline void GraphicsContext::MultiDrawIndexedIndirect(GpuBuffer& ArgumentBuffer, uint64_t ArgumentBufferOffset,
+    uint32_t MaxCount, GpuBuffer& CountBuffer, uint64_t CountBufferOffset)
+{
+    ExecuteIndirect(Graphics::DrawIndexedIndirectCommandSignature, ArgumentBuffer, ArgumentBufferOffset,
+        MaxCount, &CountBuffer, CountBufferOffset);
+}
+
 inline void ComputeContext::ExecuteIndirect(CommandSignature& CommandSig,
     GpuBuffer& ArgumentBuffer, uint64_t ArgumentStartOffset,
     uint32_t MaxCommands, GpuBuffer* CommandCounterBuffer, uint64_t CounterOffset)
@@ -13,6 +13,16 @@
 
 #include "pch.h"
 #include "CommandListManager.h"
+#include "EngineTuning.h"
+#include "LateLatch.h"
+
+namespace
+{
+    // Gathering more lists than this per submission gains little and delays the GPU
+    const size_t kMaxBatchedLists = 32;
+
+    BoolVar s_BatchSubmissions("Graphics/Batch Submissions", true);
+}
 
 CommandQueue::CommandQueue(D3D12_COMMAND_LIST_TYPE Type) :
     m_Type(Type),
@@ -34,6 +44,7 @@ void CommandQueue::Shutdown()
     if (m_CommandQueue == nullptr)
         return;
 
+    ASSERT(m_BatchedLists.empty(), "Command lists were gathered but never submitted");
     m_AllocatorPool.Shutdown();
 
     CloseHandle(m_FenceEventHandle);
@@ -71,6 +82,10 @@ void CommandQueue::Create(ID3D12Device* pDevice)
     ASSERT(!IsReady());
     ASSERT(m_AllocatorPool.Size() == 0);
 
+    // A queue recreated after device removal starts over.  The removed fence reported every value as complete.
+    m_NextFenceValue = (uint64_t)m_Type << 56 | 1;
+    m_LastCompletedFenceValue = (uint64_t)m_Type << 56;
+
     D3D12_COMMAND_QUEUE_DESC QueueDesc = {};
     QueueDesc.Type = m_Type;
     QueueDesc.NodeMask = 1;
@@ -116,13 +131,31 @@ void CommandListManager::CreateNewCommandList( D3D12_COMMAND_LIST_TYPE Type, ID3
 }
 
 uint64_t CommandQueue::ExecuteCommandList( ID3D12CommandList* List )
+{
+    return ExecuteCommandLists(1, &List);
+}
+
+uint64_t CommandQueue::ExecuteCommandLists( UINT NumLists, ID3D12CommandList* const* Lists )
 {
     std::lock_guard<std::mutex> LockGuard(m_FenceMutex);
 
-    ASSERT_SUCCEEDED(((ID3D12GraphicsCommandList*)List)->Close());
+    for (UINT i = 0; i < NumLists; ++i)
+        ASSERT_SUCCEEDED(((ID3D12GraphicsCommandList*)Lists[i])->Close());
+
+    // Lists gathered earlier go first so that submission order is preserved
+    if (!m_BatchedLists.empty())
+    {
+        m_BatchedLists.insert(m_BatchedLists.end(), Lists, Lists + NumLists);
+        uint64_t FenceValue = m_NextFenceValue;
+        SubmitBatch();
+        return FenceValue;
+    }
 
-    // Kickoff the command list
-    m_CommandQueue->ExecuteCommandLists(1, &List);
+    if (m_Type == D3D12_COMMAND_LIST_TYPE_DIRECT)
+        LateLatch::Latch();
+
+    // Kickoff the command lists.  They execute in the order given, and they all share one fence value.
+    m_CommandQueue->ExecuteCommandLists(NumLists, Lists);
 
     // Signal the next fence value (with the GPU)
     m_CommandQueue->Signal(m_pFence, m_NextFenceValue);
@@ -131,22 +164,74 @@ uint64_t CommandQueue::ExecuteCommandList( ID3D12CommandList* List )
     return m_NextFenceValue++;
 }
 
+uint64_t CommandQueue::QueueCommandLists( UINT NumLists, ID3D12CommandList* const* Lists )
+{
+    std::lock_guard<std::mutex> LockGuard(m_FenceMutex);
+
+    for (UINT i = 0; i < NumLists; ++i)
+        ASSERT_SUCCEEDED(((ID3D12GraphicsCommandList*)Lists[i])->Close());
+
+    m_BatchedLists.insert(m_BatchedLists.end(), Lists, Lists + NumLists);
+
+    uint64_t FenceValue = m_NextFenceValue;
+    if (!s_BatchSubmissions || m_BatchedLists.size() >= kMaxBatchedLists)
+        SubmitBatch();
+    return FenceValue;
+}
+
+void CommandQueue::SubmitBatch( void )
+{
+    if (m_BatchedLists.empty())
+        return;
+
+    if (m_Type == D3D12_COMMAND_LIST_TYPE_DIRECT)
+        LateLatch::Latch();
+
+    m_CommandQueue->ExecuteCommandLists((UINT)m_BatchedLists.size(), m_BatchedLists.data());
+    m_CommandQueue->Signal(m_pFence, m_NextFenceValue);
+    m_NextFenceValue++;
+    m_BatchedLists.clear();
+}
+
+void CommandQueue::FlushBatch( void )
+{
+    std::lock_guard<std::mutex> LockGuard(m_FenceMutex);
+    SubmitBatch();
+}
+
+void CommandQueue::FlushBatchFor( uint64_t FenceValue )
+{
+    std::lock_guard<std::mutex> LockGuard(m_FenceMutex);
+    if (FenceValue >= m_NextFenceValue)
+        SubmitBatch();
+}
+
 uint64_t CommandQueue::IncrementFence(void)
 {
     std::lock_guard<std::mutex> LockGuard(m_FenceMutex);
+
+    // Signaling the batch's fence value before its lists would break the fence contract
+    SubmitBatch();
+
     m_CommandQueue->Signal(m_pFence, m_NextFenceValue);
     return m_NextFenceValue++;
 }
 
-bool CommandQueue::IsFenceComplete(uint64_t FenceValue)
+uint64_t CommandQueue::UpdateCompletedFence(void)
 {
-    // Avoid querying the fence value by testing against the last one seen.
-    // The max() is to protect against an unlikely race condition that could cause the last
-    // completed fence value to regress.
-    if (FenceValue > m_LastCompletedFenceValue)
-        m_LastCompletedFenceValue = std::max(m_LastCompletedFenceValue, m_pFence->GetCompletedValue());
+    return PublishCompletedFence(m_pFence->GetCompletedValue());
+}
 
-    return FenceValue <= m_LastCompletedFenceValue;
+uint64_t CommandQueue::PublishCompletedFence(uint64_t FenceValue)
+{
+    // Threads can publish out of order, so only ever move the value forward
+    uint64_t LastCompleted = m_LastCompletedFenceValue.load(std::memory_order_relaxed);
+    while (FenceValue > LastCompleted)
+    {
+        if (m_LastCompletedFenceValue.compare_exchange_weak(LastCompleted, FenceValue, std::memory_order_release, std::memory_order_relaxed))
+            return FenceValue;
+    }
+    return LastCompleted;
 }
 
 namespace Graphics
@@ -157,20 +242,25 @@ namespace Graphics
 void CommandQueue::StallForFence(uint64_t FenceValue)
 {
     CommandQueue& Producer = Graphics::g_CommandManager.GetQueue((D3D12_COMMAND_LIST_TYPE)(FenceValue >> 56));
+    Producer.FlushBatchFor(FenceValue);
     m_CommandQueue->Wait(Producer.m_pFence, FenceValue);
 }
 
 void CommandQueue::StallForProducer(CommandQueue& Producer)
 {
+    // The producer's gathered lists count as submitted work
+    Producer.FlushBatch();
     ASSERT(Producer.m_NextFenceValue > 0);
     m_CommandQueue->Wait(Producer.m_pFence, Producer.m_NextFenceValue - 1);
 }
 
 void CommandQueue::WaitForFence(uint64_t FenceValue)
 {
-    if (IsFenceComplete(FenceValue))
+    if (IsFenceComplete(FenceValue) || UpdateCompletedFence() >= FenceValue)
         return;
 
+    FlushBatchFor(FenceValue);
+
     // TODO:  Think about how this might affect a multi-threaded situation.  Suppose thread A
     // wants to wait for fence 100, then thread B comes along and wants to wait for 99.  If
     // the fence can only have one event set on completion, then thread B has to wait for 
@@ -180,7 +270,7 @@ void CommandQueue::WaitForFence(uint64_t FenceValue)
 
         m_pFence->SetEventOnCompletion(FenceValue, m_FenceEventHandle);
         WaitForSingleObject(m_FenceEventHandle, INFINITE);
-        m_LastCompletedFenceValue = FenceValue;
+        PublishCompletedFence(FenceValue);
     }
 }
 
@@ -192,7 +282,8 @@ void CommandListManager::WaitForFence(uint64_t FenceValue)
 
 ID3D12CommandAllocator* CommandQueue::RequestAllocator()
 {
-    uint64_t CompletedFence = m_pFence->GetCompletedValue();
+    // Beginning a context is frequent enough to keep the cached value fresh between frames
+    uint64_t CompletedFence = UpdateCompletedFence();
 
     return m_AllocatorPool.RequestAllocator(CompletedFence);
 }
@@ -16,6 +16,7 @@
 #include <vector>
 #include <queue>
 #include <mutex>
+#include <atomic>
 #include <stdint.h>
 #include "CommandAllocatorPool.h"
 
@@ -37,12 +38,29 @@ public:
     }
 
     uint64_t IncrementFence(void);
-    bool IsFenceComplete(uint64_t FenceValue);
+
+    // Tests against the completed value last read from the fence, without touching the fence itself.  The
+    // value is refreshed once per frame by CommandListManager::UpdateCompletedFences(), when a context begins,
+    // and after every CPU wait, so retire queues can poll this as often as they like.
+    bool IsFenceComplete(uint64_t FenceValue)
+    {
+        return FenceValue <= m_LastCompletedFenceValue.load(std::memory_order_acquire);
+    }
+
+    // Read the fence and publish its completed value to IsFenceComplete()
+    uint64_t UpdateCompletedFence(void);
+
     void StallForFence(uint64_t FenceValue);
     void StallForProducer(CommandQueue& Producer);
     void WaitForFence(uint64_t FenceValue);
     void WaitForIdle(void) { WaitForFence(IncrementFence()); }
 
+    // Submit the command lists gathered by QueueCommandLists(), if there are any
+    void FlushBatch(void);
+
+    // Submit the gathered command lists if the fence value belongs to them
+    void FlushBatchFor(uint64_t FenceValue);
+
     ID3D12CommandQueue* GetCommandQueue() { return m_CommandQueue; }
 
     uint64_t GetNextFenceValue() { return m_NextFenceValue; }
@@ -50,6 +68,19 @@ public:
 private:
 
     uint64_t ExecuteCommandList(ID3D12CommandList* List);
+    uint64_t ExecuteCommandLists(UINT NumLists, ID3D12CommandList* const* Lists);
+
+    // Close the lists and gather them, so that many contexts' lists go out in one ExecuteCommandLists()
+    // call with one fence signal.  Returns the fence value that will signal their completion, which is the
+    // next fence value until the batch is submitted.  The batch is submitted when it is full, by any direct
+    // submission, and whenever something needs its fence:  a CPU wait, a queue waiting on this one, or a
+    // fence increment.  Lists must not be reset before their batch is submitted.
+    uint64_t QueueCommandLists(UINT NumLists, ID3D12CommandList* const* Lists);
+
+    // Called with m_FenceMutex held
+    void SubmitBatch(void);
+
+    uint64_t PublishCompletedFence(uint64_t FenceValue);
     ID3D12CommandAllocator* RequestAllocator(void);
     void DiscardAllocator(uint64_t FenceValueForReset, ID3D12CommandAllocator* Allocator);
 
@@ -64,9 +95,11 @@ private:
     // Lifetime of these objects is managed by the descriptor cache
     ID3D12Fence* m_pFence;
     uint64_t m_NextFenceValue;
-    uint64_t m_LastCompletedFenceValue;
+    std::atomic<uint64_t> m_LastCompletedFenceValue;
     HANDLE m_FenceEventHandle;
 
+    std::vector<ID3D12CommandList*> m_BatchedLists;
+
 };
 
 class CommandListManager
@@ -113,6 +146,22 @@ public:
     // The CPU will wait for a fence to reach a specified value
     void WaitForFence(uint64_t FenceValue);
 
+    // Read every queue's fence once, so that every retire queue sees the frame's progress
+    void UpdateCompletedFences(void)
+    {
+        m_GraphicsQueue.UpdateCompletedFence();
+        m_ComputeQueue.UpdateCompletedFence();
+        m_CopyQueue.UpdateCompletedFence();
+    }
+
+    // Submit the gathered command lists of every queue.  Called once per frame before presenting.
+    void FlushBatches(void)
+    {
+        m_GraphicsQueue.FlushBatch();
+        m_ComputeQueue.FlushBatch();
+        m_CopyQueue.FlushBatch();
+    }
+
     // The CPU will wait for all command queues to empty (so that the GPU is idle)
     void IdleGPU(void)
     {
@@ -15,8 +15,23 @@
 #include "CommandSignature.h"
 #include "RootSignature.h"
 #include "GraphicsCore.h"
+#include "Hash.h"
+#include <map>
+#include <mutex>
 
 using namespace Graphics;
+using namespace std;
+using Microsoft::WRL::ComPtr;
+
+// Signatures with the same arguments, stride and root signature are created once and shared
+static map< size_t, ComPtr<ID3D12CommandSignature> > s_CommandSignatureHashMap;
+static mutex s_HashMapMutex;
+
+void CommandSignature::DestroyAll( void )
+{
+    lock_guard<mutex> CS(s_HashMapMutex);
+    s_CommandSignatureHashMap.clear();
+}
 
 void CommandSignature::Finalize( const RootSignature* RootSignature )
 {
@@ -26,9 +41,17 @@ void CommandSignature::Finalize( const RootSignature* RootSignature )
     UINT ByteStride = 0;
     bool RequiresRootSignature = false;
 
+    // Only the members used by each argument type are copied so that the layout hashes consistently
+    std::unique_ptr<D3D12_INDIRECT_ARGUMENT_DESC[]> ArgumentDescs(new D3D12_INDIRECT_ARGUMENT_DESC[m_NumParameters]);
+    ZeroMemory(ArgumentDescs.get(), m_NumParameters * sizeof(D3D12_INDIRECT_ARGUMENT_DESC));
+
     for (UINT i = 0; i < m_NumParameters; ++i)
     {
-        switch (m_ParamArray[i].GetDesc().Type)
+        const D3D12_INDIRECT_ARGUMENT_DESC& Desc = m_ParamArray[i].GetDesc();
+        D3D12_INDIRECT_ARGUMENT_DESC& Key = ArgumentDescs[i];
+        Key.Type = Desc.Type;
+
+        switch (Desc.Type)
         {
             case D3D12_INDIRECT_ARGUMENT_TYPE_DRAW:
                 ByteStride += sizeof(D3D12_DRAW_ARGUMENTS);
@@ -40,10 +63,12 @@ void CommandSignature::Finalize( const RootSignature* RootSignature )
                 ByteStride += sizeof(D3D12_DISPATCH_ARGUMENTS);
                 break;
             case D3D12_INDIRECT_ARGUMENT_TYPE_CONSTANT:
-                ByteStride += m_ParamArray[i].GetDesc().Constant.Num32BitValuesToSet * 4;
+                Key.Constant = Desc.Constant;
+                ByteStride += Desc.Constant.Num32BitValuesToSet * 4;
                 RequiresRootSignature = true;
                 break;
             case D3D12_INDIRECT_ARGUMENT_TYPE_VERTEX_BUFFER_VIEW:
+                Key.VertexBuffer = Desc.VertexBuffer;
                 ByteStride += sizeof(D3D12_VERTEX_BUFFER_VIEW);
                 break;
             case D3D12_INDIRECT_ARGUMENT_TYPE_INDEX_BUFFER_VIEW:
@@ -52,6 +77,8 @@ void CommandSignature::Finalize( const RootSignature* RootSignature )
             case D3D12_INDIRECT_ARGUMENT_TYPE_CONSTANT_BUFFER_VIEW:
             case D3D12_INDIRECT_ARGUMENT_TYPE_SHADER_RESOURCE_VIEW:
             case D3D12_INDIRECT_ARGUMENT_TYPE_UNORDERED_ACCESS_VIEW:
+                // The three views share the layout of their root parameter index
+                Key.ConstantBufferView = Desc.ConstantBufferView;
                 ByteStride += 8;
                 RequiresRootSignature = true;
                 break;
@@ -61,11 +88,9 @@ void CommandSignature::Finalize( const RootSignature* RootSignature )
     D3D12_COMMAND_SIGNATURE_DESC CommandSignatureDesc;
     CommandSignatureDesc.ByteStride = ByteStride;
     CommandSignatureDesc.NumArgumentDescs = m_NumParameters;
-    CommandSignatureDesc.pArgumentDescs = (const D3D12_INDIRECT_ARGUMENT_DESC*)m_ParamArray.get();
+    CommandSignatureDesc.pArgumentDescs = ArgumentDescs.get();
     CommandSignatureDesc.NodeMask = 1;
 
-    Microsoft::WRL::ComPtr<ID3DBlob> pOutBlob, pErrorBlob;
-
     ID3D12RootSignature* pRootSig = RootSignature ? RootSignature->GetSignature() : nullptr;
     if (RequiresRootSignature)
     {
@@ -76,10 +101,21 @@ void CommandSignature::Finalize( const RootSignature* RootSignature )
         pRootSig = nullptr;
     }
 
-    ASSERT_SUCCEEDED( g_Device->CreateCommandSignature(&CommandSignatureDesc, pRootSig,
-        MY_IID_PPV_ARGS(&m_Signature)) );
+    size_t HashCode = Utility::HashState(ArgumentDescs.get(), m_NumParameters);
+    HashCode = Utility::HashState(&ByteStride, 1, HashCode);
+    HashCode = Utility::HashState(&pRootSig, 1, HashCode);
+
+    lock_guard<mutex> CS(s_HashMapMutex);
+    ComPtr<ID3D12CommandSignature>& CachedSignature = s_CommandSignatureHashMap[HashCode];
 
-    m_Signature->SetName(L"CommandSignature");
+    if (CachedSignature == nullptr)
+    {
+        ASSERT_SUCCEEDED( g_Device->CreateCommandSignature(&CommandSignatureDesc, pRootSig,
+            MY_IID_PPV_ARGS(&CachedSignature)) );
+
+        CachedSignature->SetName(L"CommandSignature");
+    }
 
+    m_Signature = CachedSignature;
     m_Finalized = TRUE;
 }
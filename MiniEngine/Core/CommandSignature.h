@@ -124,8 +124,11 @@ public:
         return m_ParamArray.get()[EntryIndex];
     }
 
+    // Signatures are cached by layout, so finalizing the same arguments again is cheap and shares the object
     void Finalize( const RootSignature* RootSignature = nullptr );
 
+    static void DestroyAll( void );
+
     ID3D12CommandSignature* GetSignature() const { return m_Signature.Get(); }
 
 protected:
@@ -0,0 +1,59 @@
+dxc.exe /D_WAVE_OP /Zi /E"main" /Vn"g_pGenerateHistogramCS_SM6" /Tcs_6_0 /Fh"GenerateHistogramCS_SM6.h" /nologo Shaders/GenerateHistogramCS.hlsl
+
+copy GenerateHistogramCS_SM6.h ..\Build_VS15\x64\Debug\Output\Core\CompiledShaders
+copy GenerateHistogramCS_SM6.h ..\Build_VS15\x64\Profile\Output\Core\CompiledShaders
+copy GenerateHistogramCS_SM6.h ..\Build_VS15\x64\Release\Output\Core\CompiledShaders
+
+dxc.exe /D_WAVE_OP /Zi /E"main" /Vn"g_pDownsampleBloomCS_SM6" /Tcs_6_0 /Fh"DownsampleBloomCS_SM6.h" /nologo Shaders/DownsampleBloomCS.hlsl
+
+copy DownsampleBloomCS_SM6.h ..\Build_VS15\x64\Debug\Output\Core\CompiledShaders
+copy DownsampleBloomCS_SM6.h ..\Build_VS15\x64\Profile\Output\Core\CompiledShaders
+copy DownsampleBloomCS_SM6.h ..\Build_VS15\x64\Release\Output\Core\CompiledShaders
+
+dxc.exe /D_WAVE_OP /Zi /E"main" /Vn"g_pDownsampleBloomAllCS_SM6" /Tcs_6_0 /Fh"DownsampleBloomAllCS_SM6.h" /nologo Shaders/DownsampleBloomAllCS.hlsl
+
+copy DownsampleBloomAllCS_SM6.h ..\Build_VS15\x64\Debug\Output\Core\CompiledShaders
+copy DownsampleBloomAllCS_SM6.h ..\Build_VS15\x64\Profile\Output\Core\CompiledShaders
+copy DownsampleBloomAllCS_SM6.h ..\Build_VS15\x64\Release\Output\Core\CompiledShaders
+
+dxc.exe /D_WAVE_OP /Zi /E"main" /Vn"g_pAverageLumaCS_SM6" /Tcs_6_0 /Fh"AverageLumaCS_SM6.h" /nologo Shaders/AverageLumaCS.hlsl
+
+copy AverageLumaCS_SM6.h ..\Build_VS15\x64\Debug\Output\Core\CompiledShaders
+copy AverageLumaCS_SM6.h ..\Build_VS15\x64\Profile\Output\Core\CompiledShaders
+copy AverageLumaCS_SM6.h ..\Build_VS15\x64\Release\Output\Core\CompiledShaders
+
+dxc.exe /D_WAVE_OP /Zi /E"main" /Vn"g_pParticleUpdateCS_SM6" /Tcs_6_0 /Fh"ParticleUpdateCS_SM6.h" /nologo Shaders/ParticleUpdateCS.hlsl
+
+copy ParticleUpdateCS_SM6.h ..\Build_VS15\x64\Debug\Output\Core\CompiledShaders
+copy ParticleUpdateCS_SM6.h ..\Build_VS15\x64\Profile\Output\Core\CompiledShaders
+copy ParticleUpdateCS_SM6.h ..\Build_VS15\x64\Release\Output\Core\CompiledShaders
+
+dxc.exe /D_WAVE_OP /Zi /E"main" /Vn"g_pParticleTileCullingCS_SM6" /Tcs_6_0 /Fh"ParticleTileCullingCS_SM6.h" /nologo Shaders/ParticleTileCullingCS.hlsl
+
+copy ParticleTileCullingCS_SM6.h ..\Build_VS15\x64\Debug\Output\Core\CompiledShaders
+copy ParticleTileCullingCS_SM6.h ..\Build_VS15\x64\Profile\Output\Core\CompiledShaders
+copy ParticleTileCullingCS_SM6.h ..\Build_VS15\x64\Release\Output\Core\CompiledShaders
+
+dxc.exe /D_WAVE_OP /Zi /E"main" /Vn"g_pGenerateMipsSinglePassLinearCS_SM6" /Tcs_6_0 /Fh"GenerateMipsSinglePassLinearCS_SM6.h" /nologo Shaders/GenerateMipsSinglePassLinearCS.hlsl
+
+copy GenerateMipsSinglePassLinearCS_SM6.h ..\Build_VS15\x64\Debug\Output\Core\CompiledShaders
+copy GenerateMipsSinglePassLinearCS_SM6.h ..\Build_VS15\x64\Profile\Output\Core\CompiledShaders
+copy GenerateMipsSinglePassLinearCS_SM6.h ..\Build_VS15\x64\Release\Output\Core\CompiledShaders
+
+dxc.exe /D_WAVE_OP /Zi /E"main" /Vn"g_pGenerateMipsSinglePassGammaCS_SM6" /Tcs_6_0 /Fh"GenerateMipsSinglePassGammaCS_SM6.h" /nologo Shaders/GenerateMipsSinglePassGammaCS.hlsl
+
+copy GenerateMipsSinglePassGammaCS_SM6.h ..\Build_VS15\x64\Debug\Output\Core\CompiledShaders
+copy GenerateMipsSinglePassGammaCS_SM6.h ..\Build_VS15\x64\Profile\Output\Core\CompiledShaders
+copy GenerateMipsSinglePassGammaCS_SM6.h ..\Build_VS15\x64\Release\Output\Core\CompiledShaders
+
+dxc.exe /D_WAVE_OP /Zi /E"main" /Vn"g_pBloomExtractAndHistogramHdrCS_SM6" /Tcs_6_0 /Fh"BloomExtractAndHistogramHdrCS_SM6.h" /nologo Shaders/BloomExtractAndHistogramHdrCS.hlsl
+
+copy BloomExtractAndHistogramHdrCS_SM6.h ..\Build_VS15\x64\Debug\Output\Core\CompiledShaders
+copy BloomExtractAndHistogramHdrCS_SM6.h ..\Build_VS15\x64\Profile\Output\Core\CompiledShaders
+copy BloomExtractAndHistogramHdrCS_SM6.h ..\Build_VS15\x64\Release\Output\Core\CompiledShaders
+
+dxc.exe /D_WAVE_OP /Zi /E"main" /Vn"g_pExtractLumaHistogramCS_SM6" /Tcs_6_0 /Fh"ExtractLumaHistogramCS_SM6.h" /nologo Shaders/ExtractLumaHistogramCS.hlsl
+
+copy ExtractLumaHistogramCS_SM6.h ..\Build_VS15\x64\Debug\Output\Core\CompiledShaders
+copy ExtractLumaHistogramCS_SM6.h ..\Build_VS15\x64\Profile\Output\Core\CompiledShaders
+copy ExtractLumaHistogramCS_SM6.h ..\Build_VS15\x64\Release\Output\Core\CompiledShaders
@@ -26,6 +26,7 @@
 #include "GpuResource.h"
 #include "GraphicsCore.h"
 #include "CommandContext.h"
+#include "PlacedResourceAllocator.h"
 #include "Utility.h"
 
 struct handle_closer { void operator()(HANDLE h) { if (h) CloseHandle(h); } };
@@ -783,6 +784,26 @@ static HRESULT FillInitData( _In_ size_t width,
 }
 
 
+//--------------------------------------------------------------------------------------
+// Textures are placed in shared heaps when possible, where small ones only take 4KB
+// instead of a 64KB page each
+static HRESULT CreateTextureResource( _In_ ID3D12Device* d3dDevice,
+                                      _In_ const D3D12_HEAP_PROPERTIES& HeapProps,
+                                      _In_ const D3D12_RESOURCE_DESC& ResourceDesc,
+                                      _In_ D3D12_RESOURCE_STATES initialState,
+                                      _Outptr_ ID3D12Resource** texture )
+{
+    if ( d3dDevice == Graphics::g_Device &&
+        PlacedResourceAllocator::CreateResource( ResourceDesc, initialState, nullptr, texture ) )
+    {
+        return S_OK;
+    }
+
+    return d3dDevice->CreateCommittedResource( &HeapProps, D3D12_HEAP_FLAG_NONE, &ResourceDesc,
+        initialState, nullptr, MY_IID_PPV_ARGS(texture));
+}
+
+
 //--------------------------------------------------------------------------------------
 static HRESULT CreateD3DResources( _In_ ID3D12Device* d3dDevice,
                                    _In_ uint32_t resDim,
@@ -795,7 +816,9 @@ static HRESULT CreateD3DResources( _In_ ID3D12Device* d3dDevice,
                                    _In_ bool forceSRGB,
                                    _In_ bool isCubeMap,
                                    _Outptr_opt_ ID3D12Resource** texture,
-                                   _In_ D3D12_CPU_DESCRIPTOR_HANDLE textureView )
+                                   _In_ D3D12_CPU_DESCRIPTOR_HANDLE textureView,
+                                   _In_ D3D12_RESOURCE_STATES initialState = D3D12_RESOURCE_STATE_COPY_DEST,
+                                   _Out_opt_ D3D12_SHADER_RESOURCE_VIEW_DESC* srvDesc = nullptr )
 {
     if ( !d3dDevice )
         return E_POINTER;
@@ -833,8 +856,7 @@ static HRESULT CreateD3DResources( _In_ ID3D12Device* d3dDevice,
                 ResourceDesc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE1D;
 
                 ID3D12Resource* tex = nullptr;
-                hr = d3dDevice->CreateCommittedResource( &HeapProps, D3D12_HEAP_FLAG_NONE, &ResourceDesc,
-                    D3D12_RESOURCE_STATE_COPY_DEST, nullptr, MY_IID_PPV_ARGS(&tex));
+                hr = CreateTextureResource( d3dDevice, HeapProps, ResourceDesc, initialState, &tex );
 
                 if (SUCCEEDED( hr ) && tex != nullptr)
                 {
@@ -854,7 +876,10 @@ static HRESULT CreateD3DResources( _In_ ID3D12Device* d3dDevice,
                         SRVDesc.Texture1D.MipLevels = (!mipCount) ? -1 : ResourceDesc.MipLevels;
                     }
 
-                    d3dDevice->CreateShaderResourceView( tex, &SRVDesc, textureView );
+                    if (textureView.ptr != 0)
+                        d3dDevice->CreateShaderResourceView( tex, &SRVDesc, textureView );
+                    if (srvDesc != nullptr)
+                        *srvDesc = SRVDesc;
 
                     if (texture != nullptr)
                     {
@@ -874,8 +899,7 @@ static HRESULT CreateD3DResources( _In_ ID3D12Device* d3dDevice,
                 ResourceDesc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
 
                 ID3D12Resource* tex = nullptr;
-                hr = d3dDevice->CreateCommittedResource( &HeapProps, D3D12_HEAP_FLAG_NONE, &ResourceDesc,
-                    D3D12_RESOURCE_STATE_COPY_DEST, nullptr, MY_IID_PPV_ARGS(&tex));
+                hr = CreateTextureResource( d3dDevice, HeapProps, ResourceDesc, initialState, &tex );
 
                 if (SUCCEEDED( hr ) && tex != 0)
                 {
@@ -912,7 +936,10 @@ static HRESULT CreateD3DResources( _In_ ID3D12Device* d3dDevice,
                         SRVDesc.Texture2D.MostDetailedMip = 0;
                     }
 
-                    d3dDevice->CreateShaderResourceView( tex, &SRVDesc, textureView );
+                    if (textureView.ptr != 0)
+                        d3dDevice->CreateShaderResourceView( tex, &SRVDesc, textureView );
+                    if (srvDesc != nullptr)
+                        *srvDesc = SRVDesc;
 
                     if (texture != nullptr)
                     {
@@ -933,8 +960,7 @@ static HRESULT CreateD3DResources( _In_ ID3D12Device* d3dDevice,
                 ResourceDesc.DepthOrArraySize = static_cast<UINT16>( depth );
 
                 ID3D12Resource* tex = nullptr;
-                hr = d3dDevice->CreateCommittedResource( &HeapProps, D3D12_HEAP_FLAG_NONE, &ResourceDesc,
-                    D3D12_RESOURCE_STATE_COPY_DEST, nullptr, MY_IID_PPV_ARGS(&tex));
+                hr = CreateTextureResource( d3dDevice, HeapProps, ResourceDesc, initialState, &tex );
 
                 if (SUCCEEDED( hr ) && tex != nullptr)
                 {
@@ -946,7 +972,10 @@ static HRESULT CreateD3DResources( _In_ ID3D12Device* d3dDevice,
                     SRVDesc.Texture3D.MipLevels = (!mipCount) ? -1 : ResourceDesc.MipLevels;
                     SRVDesc.Texture3D.MostDetailedMip = 0;
 
-                    d3dDevice->CreateShaderResourceView( tex, &SRVDesc, textureView );
+                    if (textureView.ptr != 0)
+                        d3dDevice->CreateShaderResourceView( tex, &SRVDesc, textureView );
+                    if (srvDesc != nullptr)
+                        *srvDesc = SRVDesc;
 
                     if (texture != nullptr)
                     {
@@ -966,27 +995,27 @@ static HRESULT CreateD3DResources( _In_ ID3D12Device* d3dDevice,
 }
 
 //--------------------------------------------------------------------------------------
-static HRESULT CreateTextureFromDDS( _In_ ID3D12Device* d3dDevice,
-                                     _In_ const DDS_HEADER* header,
-                                     _In_reads_bytes_(bitSize) const uint8_t* bitData,
-                                     _In_ size_t bitSize,
-                                     _In_ size_t maxsize,
-                                     _In_ bool forceSRGB,
-                                     _Outptr_opt_ ID3D12Resource** texture,
-                                     _In_ D3D12_CPU_DESCRIPTOR_HANDLE textureView )
+// Reads the layout of a texture from its headers and checks it against the D3D12 limits
+static HRESULT ParseDDSHeader( _In_ const DDS_HEADER* header,
+                               _Out_ UINT& width,
+                               _Out_ UINT& height,
+                               _Out_ UINT& depth,
+                               _Out_ size_t& mipCount,
+                               _Out_ UINT& arraySize,
+                               _Out_ DXGI_FORMAT& format,
+                               _Out_ uint32_t& resDim,
+                               _Out_ bool& isCubeMap )
 {
-    HRESULT hr = S_OK;
+    width = header->width;
+    height = header->height;
+    depth = header->depth;
 
-    UINT width = header->width;
-    UINT height = header->height;
-    UINT depth = header->depth;
+    resDim = D3D12_RESOURCE_DIMENSION_UNKNOWN;
+    arraySize = 1;
+    format = DXGI_FORMAT_UNKNOWN;
+    isCubeMap = false;
 
-    uint32_t resDim = D3D12_RESOURCE_DIMENSION_UNKNOWN;
-    UINT arraySize = 1;
-    DXGI_FORMAT format = DXGI_FORMAT_UNKNOWN;
-    bool isCubeMap = false;
-
-    size_t mipCount = header->mipMapCount;
+    mipCount = header->mipMapCount;
     if (0 == mipCount)
     {
         mipCount = 1;
@@ -1142,6 +1171,38 @@ static HRESULT CreateTextureFromDDS( _In_ ID3D12Device* d3dDevice,
         return HRESULT_FROM_WIN32( ERROR_NOT_SUPPORTED );
     }
 
+    return S_OK;
+}
+
+//--------------------------------------------------------------------------------------
+static HRESULT CreateTextureFromDDS( _In_ ID3D12Device* d3dDevice,
+                                     _In_ const DDS_HEADER* header,
+                                     _In_reads_bytes_(bitSize) const uint8_t* bitData,
+                                     _In_ size_t bitSize,
+                                     _In_ size_t maxsize,
+                                     _In_ bool forceSRGB,
+                                     _Outptr_opt_ ID3D12Resource** texture,
+                                     _In_ D3D12_CPU_DESCRIPTOR_HANDLE textureView,
+                                     _Out_opt_ std::vector<D3D12_SUBRESOURCE_DATA>* deferredData = nullptr,
+                                     _Out_opt_ D3D12_SHADER_RESOURCE_VIEW_DESC* srvDesc = nullptr )
+{
+    HRESULT hr = S_OK;
+
+    // Deferred textures are created in the common state so they can be filled from the copy queue
+    const D3D12_RESOURCE_STATES initialState = deferredData ? D3D12_RESOURCE_STATE_COMMON : D3D12_RESOURCE_STATE_COPY_DEST;
+
+    UINT width, height, depth, arraySize;
+    size_t mipCount;
+    DXGI_FORMAT format;
+    uint32_t resDim;
+    bool isCubeMap;
+
+    hr = ParseDDSHeader( header, width, height, depth, mipCount, arraySize, format, resDim, isCubeMap );
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+
     {
         // Create the texture
         UINT subresourceCount = static_cast<UINT>(mipCount) * arraySize;
@@ -1162,7 +1223,7 @@ static HRESULT CreateTextureFromDDS( _In_ ID3D12Device* d3dDevice,
         {
             hr = CreateD3DResources( d3dDevice, resDim, twidth, theight, tdepth, mipCount - skipMip, arraySize,
                                      format, forceSRGB,
-                                     isCubeMap, texture, textureView );
+                                     isCubeMap, texture, textureView, initialState, srvDesc );
 
             if ( FAILED(hr) && !maxsize && (mipCount > 1) )
             {
@@ -1177,12 +1238,18 @@ static HRESULT CreateTextureFromDDS( _In_ ID3D12Device* d3dDevice,
                 {
                     hr = CreateD3DResources( d3dDevice, resDim, twidth, theight, tdepth, mipCount - skipMip, arraySize,
                                              format, forceSRGB,
-                                             isCubeMap, texture, textureView );
+                                             isCubeMap, texture, textureView, initialState, srvDesc );
                 }
             }
         }
 
-        if (SUCCEEDED(hr))
+        if (SUCCEEDED(hr) && deferredData)
+        {
+            // FillInitData only fills in the subresources that survived the mip skip
+            subresourceCount = static_cast<UINT>(mipCount - skipMip) * arraySize;
+            deferredData->assign(initData.get(), initData.get() + subresourceCount);
+        }
+        else if (SUCCEEDED(hr))
         {
             GpuResource DestTexture(*texture, D3D12_RESOURCE_STATE_COPY_DEST);
             CommandContext::InitializeTexture(DestTexture, subresourceCount, initData.get());
@@ -1222,33 +1289,13 @@ static DDS_ALPHA_MODE GetAlphaMode( _In_ const DDS_HEADER* header )
 }
 
 
-_Use_decl_annotations_
-HRESULT CreateDDSTextureFromMemory(
-    ID3D12Device* d3dDevice,
-    const uint8_t* ddsData,
-    size_t ddsDataSize,
-    size_t maxsize,
-    bool forceSRGB,
-    ID3D12Resource** texture,
-    D3D12_CPU_DESCRIPTOR_HANDLE textureView,
-    DDS_ALPHA_MODE* alphaMode )
+//--------------------------------------------------------------------------------------
+// Checks the magic number and headers at the start of a DDS file and finds where its data begins
+static HRESULT ValidateDDSHeaders( _In_reads_bytes_(ddsDataSize) const uint8_t* ddsData,
+                                   _In_ size_t ddsDataSize,
+                                   _Outptr_ const DDS_HEADER** header,
+                                   _Out_ size_t* offset )
 {
-    if ( texture )
-    {
-        *texture = nullptr;
-    }
-
-    if ( alphaMode )
-    {
-        *alphaMode = DDS_ALPHA_MODE_UNKNOWN;
-    }
-
-    if (!d3dDevice || !ddsData)
-    {
-        return E_INVALIDARG;
-    }
-
-    // Validate DDS file in memory
     if (ddsDataSize < (sizeof(uint32_t) + sizeof(DDS_HEADER)))
     {
         return E_FAIL;
@@ -1260,31 +1307,72 @@ HRESULT CreateDDSTextureFromMemory(
         return E_FAIL;
     }
 
-    auto header = reinterpret_cast<const DDS_HEADER*>( ddsData + sizeof( uint32_t ) );
+    auto hdr = reinterpret_cast<const DDS_HEADER*>( ddsData + sizeof( uint32_t ) );
 
     // Verify header to validate DDS file
-    if (header->size != sizeof(DDS_HEADER) ||
-        header->ddspf.size != sizeof(DDS_PIXELFORMAT))
+    if (hdr->size != sizeof(DDS_HEADER) ||
+        hdr->ddspf.size != sizeof(DDS_PIXELFORMAT))
     {
         return E_FAIL;
     }
 
-    size_t offset = sizeof(DDS_HEADER) + sizeof(uint32_t);
+    size_t dataOffset = sizeof(DDS_HEADER) + sizeof(uint32_t);
 
     // Check for extensions
-    if (header->ddspf.flags & DDS_FOURCC)
+    if (hdr->ddspf.flags & DDS_FOURCC)
     {
-        if (MAKEFOURCC( 'D', 'X', '1', '0' ) == header->ddspf.fourCC)
-            offset += sizeof(DDS_HEADER_DXT10);
+        if (MAKEFOURCC( 'D', 'X', '1', '0' ) == hdr->ddspf.fourCC)
+            dataOffset += sizeof(DDS_HEADER_DXT10);
     }
 
     // Must be long enough for all headers and magic value
-    if (ddsDataSize < offset)
+    if (ddsDataSize < dataOffset)
         return E_FAIL;
 
-    HRESULT hr = CreateTextureFromDDS( d3dDevice,
-                                       header, ddsData + offset, ddsDataSize - offset, maxsize,
-                                       forceSRGB, texture, textureView );
+    *header = hdr;
+    *offset = dataOffset;
+    return S_OK;
+}
+
+
+static HRESULT CreateDDSTextureFromMemoryImpl(
+    ID3D12Device* d3dDevice,
+    const uint8_t* ddsData,
+    size_t ddsDataSize,
+    size_t maxsize,
+    bool forceSRGB,
+    ID3D12Resource** texture,
+    D3D12_CPU_DESCRIPTOR_HANDLE textureView,
+    DDS_ALPHA_MODE* alphaMode,
+    std::vector<D3D12_SUBRESOURCE_DATA>* deferredData,
+    D3D12_SHADER_RESOURCE_VIEW_DESC* srvDesc )
+{
+    if ( texture )
+    {
+        *texture = nullptr;
+    }
+
+    if ( alphaMode )
+    {
+        *alphaMode = DDS_ALPHA_MODE_UNKNOWN;
+    }
+
+    if (!d3dDevice || !ddsData)
+    {
+        return E_INVALIDARG;
+    }
+
+    const DDS_HEADER* header = nullptr;
+    size_t offset = 0;
+    HRESULT hr = ValidateDDSHeaders( ddsData, ddsDataSize, &header, &offset );
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+
+    hr = CreateTextureFromDDS( d3dDevice,
+                               header, ddsData + offset, ddsDataSize - offset, maxsize,
+                               forceSRGB, texture, textureView, deferredData, srvDesc );
     if ( SUCCEEDED(hr) )
     {
         if (texture != nullptr && *texture != nullptr)
@@ -1300,6 +1388,40 @@ HRESULT CreateDDSTextureFromMemory(
 }
 
 
+_Use_decl_annotations_
+HRESULT CreateDDSTextureFromMemory(
+    ID3D12Device* d3dDevice,
+    const uint8_t* ddsData,
+    size_t ddsDataSize,
+    size_t maxsize,
+    bool forceSRGB,
+    ID3D12Resource** texture,
+    D3D12_CPU_DESCRIPTOR_HANDLE textureView,
+    DDS_ALPHA_MODE* alphaMode )
+{
+    return CreateDDSTextureFromMemoryImpl( d3dDevice, ddsData, ddsDataSize, maxsize, forceSRGB,
+                                           texture, textureView, alphaMode, nullptr, nullptr );
+}
+
+_Use_decl_annotations_
+HRESULT CreateDDSTextureFromMemoryDeferred(
+    ID3D12Device* d3dDevice,
+    const uint8_t* ddsData,
+    size_t ddsDataSize,
+    size_t maxsize,
+    bool forceSRGB,
+    ID3D12Resource** texture,
+    std::vector<D3D12_SUBRESOURCE_DATA>& subresources,
+    D3D12_SHADER_RESOURCE_VIEW_DESC& srvDesc,
+    DDS_ALPHA_MODE* alphaMode )
+{
+    D3D12_CPU_DESCRIPTOR_HANDLE NoView = {};
+    subresources.clear();
+    return CreateDDSTextureFromMemoryImpl( d3dDevice, ddsData, ddsDataSize, maxsize, forceSRGB,
+                                           texture, NoView, alphaMode, &subresources, &srvDesc );
+}
+
+
 _Use_decl_annotations_
 HRESULT CreateDDSTextureFromFile(
     ID3D12Device* d3dDevice,
@@ -1345,3 +1467,231 @@ HRESULT CreateDDSTextureFromFile(
 
     return hr;
 }
+
+
+//--------------------------------------------------------------------------------------
+static HRESULT FillFileIndex( _In_ const DDS_HEADER* header,
+                              _In_ size_t dataOffset,
+                              _In_ uint64_t fileSize,
+                              _Out_ DDSFileIndex& index )
+{
+    UINT width, height, depth, arraySize;
+    size_t mipCount;
+    DXGI_FORMAT format;
+    uint32_t resDim;
+    bool isCubeMap;
+
+    HRESULT hr = ParseDDSHeader( header, width, height, depth, mipCount, arraySize, format, resDim, isCubeMap );
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+
+    index.dimension = static_cast<D3D12_RESOURCE_DIMENSION>( resDim );
+    index.format = format;
+    index.width = width;
+    index.height = height;
+    index.depth = depth;
+    index.mipCount = static_cast<UINT>( mipCount );
+    index.arraySize = arraySize;
+    index.isCubeMap = isCubeMap;
+    index.subresources.clear();
+    index.subresources.reserve( mipCount * arraySize );
+
+    // Same walk as FillInitData, except that it records file offsets instead of pointers
+    uint64_t fileOffset = dataOffset;
+    for( size_t j = 0; j < arraySize; j++ )
+    {
+        size_t w = width;
+        size_t h = height;
+        size_t d = depth;
+        for( size_t i = 0; i < mipCount; i++ )
+        {
+            size_t NumBytes = 0;
+            size_t RowBytes = 0;
+            GetSurfaceInfo( w, h, format, &NumBytes, &RowBytes, nullptr );
+
+            DDSFileIndex::Subresource subresource;
+            subresource.offset = fileOffset;
+            subresource.rowPitch = static_cast<UINT>( RowBytes );
+            subresource.slicePitch = static_cast<UINT>( NumBytes );
+            subresource.size = NumBytes * d;
+
+            fileOffset += subresource.size;
+            if (fileOffset > fileSize)
+            {
+                return HRESULT_FROM_WIN32( ERROR_HANDLE_EOF );
+            }
+
+            index.subresources.push_back( subresource );
+
+            w = std::max<size_t>( w >> 1, 1 );
+            h = std::max<size_t>( h >> 1, 1 );
+            d = std::max<size_t>( d >> 1, 1 );
+        }
+    }
+
+    return S_OK;
+}
+
+
+_Use_decl_annotations_
+HRESULT CreateDDSIndexFromMemory(
+    const uint8_t* headerData,
+    size_t headerDataSize,
+    uint64_t fileSize,
+    DDSFileIndex& index )
+{
+    if (!headerData || fileSize < headerDataSize)
+    {
+        return E_INVALIDARG;
+    }
+
+    const DDS_HEADER* header = nullptr;
+    size_t offset = 0;
+    HRESULT hr = ValidateDDSHeaders( headerData, headerDataSize, &header, &offset );
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+
+    return FillFileIndex( header, offset, fileSize, index );
+}
+
+
+_Use_decl_annotations_
+HRESULT CreateDDSIndexFromFile(
+    const wchar_t* fileName,
+    DDSFileIndex& index )
+{
+    static_assert( DDS_MAX_HEADER_SIZE == sizeof(uint32_t) + sizeof(DDS_HEADER) + sizeof(DDS_HEADER_DXT10),
+        "DDS_MAX_HEADER_SIZE does not match the DDS headers" );
+
+    if (!fileName)
+    {
+        return E_INVALIDARG;
+    }
+
+#if (_WIN32_WINNT >= _WIN32_WINNT_WIN8)
+    ScopedHandle hFile( safe_handle( CreateFile2( fileName,
+                                                  GENERIC_READ,
+                                                  FILE_SHARE_READ,
+                                                  OPEN_EXISTING,
+                                                  nullptr ) ) );
+#else
+    ScopedHandle hFile( safe_handle( CreateFileW( fileName,
+                                                  GENERIC_READ,
+                                                  FILE_SHARE_READ,
+                                                  nullptr,
+                                                  OPEN_EXISTING,
+                                                  FILE_ATTRIBUTE_NORMAL,
+                                                  nullptr ) ) );
+#endif
+
+    if ( !hFile )
+    {
+        return HRESULT_FROM_WIN32( GetLastError() );
+    }
+
+    LARGE_INTEGER FileSize = { 0 };
+    if ( !GetFileSizeEx( hFile.get(), &FileSize ) )
+    {
+        return HRESULT_FROM_WIN32( GetLastError() );
+    }
+
+    // Only the headers are read.  The file may be larger than the largest allocation.
+    uint8_t headerData[DDS_MAX_HEADER_SIZE];
+    DWORD BytesToRead = static_cast<DWORD>( std::min<LONGLONG>( FileSize.QuadPart, sizeof(headerData) ) );
+    DWORD BytesRead = 0;
+    if (!ReadFile( hFile.get(), headerData, BytesToRead, &BytesRead, nullptr ))
+    {
+        return HRESULT_FROM_WIN32( GetLastError() );
+    }
+
+    if (BytesRead < BytesToRead)
+    {
+        return E_FAIL;
+    }
+
+    return CreateDDSIndexFromMemory( headerData, BytesRead, static_cast<uint64_t>( FileSize.QuadPart ), index );
+}
+
+
+//--------------------------------------------------------------------------------------
+// Counts the leading mips of the first array slice that exceed maxsize, the way FillInitData does
+static size_t CountSkippedMips( _In_ const DDSFileIndex& index, _In_ size_t maxsize )
+{
+    size_t skipMip = 0;
+    size_t w = index.width;
+    size_t h = index.height;
+    size_t d = index.depth;
+
+    while ( maxsize && skipMip + 1 < index.mipCount && (w > maxsize || h > maxsize || d > maxsize) )
+    {
+        ++skipMip;
+        w = std::max<size_t>( w >> 1, 1 );
+        h = std::max<size_t>( h >> 1, 1 );
+        d = std::max<size_t>( d >> 1, 1 );
+    }
+
+    return skipMip;
+}
+
+
+_Use_decl_annotations_
+HRESULT CreateDDSTextureFromIndex(
+    ID3D12Device* d3dDevice,
+    const DDSFileIndex& index,
+    size_t maxsize,
+    bool forceSRGB,
+    ID3D12Resource** texture,
+    D3D12_SHADER_RESOURCE_VIEW_DESC& srvDesc,
+    UINT& firstMip )
+{
+    if ( texture )
+    {
+        *texture = nullptr;
+    }
+
+    firstMip = 0;
+
+    if (!d3dDevice || !texture || index.subresources.empty())
+    {
+        return E_INVALIDARG;
+    }
+
+    D3D12_CPU_DESCRIPTOR_HANDLE NoView = {};
+    size_t skipMip = CountSkippedMips( index, maxsize );
+
+    HRESULT hr = CreateD3DResources( d3dDevice, index.dimension,
+                                     std::max<size_t>( index.width >> skipMip, 1 ),
+                                     std::max<size_t>( index.height >> skipMip, 1 ),
+                                     std::max<size_t>( index.depth >> skipMip, 1 ),
+                                     index.mipCount - skipMip, index.arraySize, index.format, forceSRGB,
+                                     index.isCubeMap, texture, NoView, D3D12_RESOURCE_STATE_COMMON, &srvDesc );
+
+    if ( FAILED(hr) && !maxsize && (index.mipCount > 1) )
+    {
+        // Retry with a maxsize determined by feature level
+        maxsize = (index.dimension == D3D12_RESOURCE_DIMENSION_TEXTURE3D)
+                    ? 2048 /*D3D10_REQ_TEXTURE3D_U_V_OR_W_DIMENSION*/
+                    : 8192 /*D3D10_REQ_TEXTURE2D_U_OR_V_DIMENSION*/;
+
+        skipMip = CountSkippedMips( index, maxsize );
+
+        hr = CreateD3DResources( d3dDevice, index.dimension,
+                                 std::max<size_t>( index.width >> skipMip, 1 ),
+                                 std::max<size_t>( index.height >> skipMip, 1 ),
+                                 std::max<size_t>( index.depth >> skipMip, 1 ),
+                                 index.mipCount - skipMip, index.arraySize, index.format, forceSRGB,
+                                 index.isCubeMap, texture, NoView, D3D12_RESOURCE_STATE_COMMON, &srvDesc );
+    }
+
+    if ( SUCCEEDED(hr) )
+    {
+        (*texture)->SetName(L"DDSTextureLoader");
+        firstMip = static_cast<UINT>( skipMip );
+    }
+
+    return hr;
+}
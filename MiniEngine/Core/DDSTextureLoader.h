@@ -21,6 +21,7 @@
 #pragma once
 
 #include <d3d12.h>
+#include <vector>
 
 #pragma warning(push)
 #pragma warning(disable : 4005)
@@ -46,6 +47,20 @@ HRESULT __cdecl CreateDDSTextureFromMemory( _In_ ID3D12Device* d3dDevice,
                                                 _Out_opt_ DDS_ALPHA_MODE* alphaMode = nullptr
                                             );
 
+// Creates the texture in the common state without uploading it or creating a view.  The subresource
+// data points into ddsData, which must remain valid until the caller has uploaded it.  The returned
+// view description covers every mip level.
+HRESULT __cdecl CreateDDSTextureFromMemoryDeferred( _In_ ID3D12Device* d3dDevice,
+                                                _In_reads_bytes_(ddsDataSize) const uint8_t* ddsData,
+                                                _In_ size_t ddsDataSize,
+                                                _In_ size_t maxsize,
+                                                _In_ bool forceSRGB,
+                                                _Outptr_ ID3D12Resource** texture,
+                                                _Out_ std::vector<D3D12_SUBRESOURCE_DATA>& subresources,
+                                                _Out_ D3D12_SHADER_RESOURCE_VIEW_DESC& srvDesc,
+                                                _Out_opt_ DDS_ALPHA_MODE* alphaMode = nullptr
+                                            );
+
 HRESULT __cdecl CreateDDSTextureFromFile( _In_ ID3D12Device* d3dDevice,
                                             _In_z_ const wchar_t* szFileName,
                                             _In_ size_t maxsize,
@@ -55,4 +70,55 @@ HRESULT __cdecl CreateDDSTextureFromFile( _In_ ID3D12Device* d3dDevice,
                                             _Out_opt_ DDS_ALPHA_MODE* alphaMode = nullptr
                                             );
 
+// The headers of a DDS file never take more than this: the magic number, DDS_HEADER and DDS_HEADER_DXT10
+const size_t DDS_MAX_HEADER_SIZE = 4 + 124 + 20;
+
+// Where each subresource of a DDS file is stored, worked out from the headers alone so that mips can be read
+// from disk as they are needed instead of loading the whole file.  Subresources are in D3D12 order: every mip
+// of the first array slice (or cube face), then every mip of the next.
+struct DDSFileIndex
+{
+    struct Subresource
+    {
+        uint64_t offset;    // From the start of the file
+        UINT rowPitch;
+        UINT slicePitch;
+        size_t size;        // slicePitch times the mip's depth
+    };
+
+    D3D12_RESOURCE_DIMENSION dimension;
+    DXGI_FORMAT format;
+    UINT width;
+    UINT height;
+    UINT depth;
+    UINT mipCount;
+    UINT arraySize;         // Six per cube
+    bool isCubeMap;
+    std::vector<Subresource> subresources;
+};
+
+// headerData holds the first DDS_MAX_HEADER_SIZE bytes of a file of fileSize bytes, or all of it when the file
+// is smaller.  Fails if the file is too short for the subresources its headers describe.
+HRESULT __cdecl CreateDDSIndexFromMemory( _In_reads_bytes_(headerDataSize) const uint8_t* headerData,
+                                            _In_ size_t headerDataSize,
+                                            _In_ uint64_t fileSize,
+                                            _Out_ DDSFileIndex& index
+                                            );
+
+// Reads only the headers of the file
+HRESULT __cdecl CreateDDSIndexFromFile( _In_z_ const wchar_t* szFileName,
+                                            _Out_ DDSFileIndex& index
+                                            );
+
+// Creates the indexed texture in the common state without uploading it or creating a view, leaving out the
+// mips larger than maxsize.  Mip firstMip of the file becomes mip 0 of the texture.
+HRESULT __cdecl CreateDDSTextureFromIndex( _In_ ID3D12Device* d3dDevice,
+                                            _In_ const DDSFileIndex& index,
+                                            _In_ size_t maxsize,
+                                            _In_ bool forceSRGB,
+                                            _Outptr_ ID3D12Resource** texture,
+                                            _Out_ D3D12_SHADER_RESOURCE_VIEW_DESC& srvDesc,
+                                            _Out_ UINT& firstMip
+                                            );
+
 size_t BitsPerPixel(_In_ DXGI_FORMAT fmt);
@@ -19,13 +19,23 @@
 
 using namespace Graphics;
 
+// Clears are only fast when they match the optimized clear value of the resource
+D3D12_CLEAR_VALUE DepthBuffer::DescribeClearValue( DXGI_FORMAT Format ) const
+{
+    D3D12_CLEAR_VALUE ClearValue = {};
+    ClearValue.Format = Format;
+    ClearValue.DepthStencil.Depth = m_ClearDepth;
+    ClearValue.DepthStencil.Stencil = m_ClearStencil;
+    return ClearValue;
+}
+
 void DepthBuffer::Create( const std::wstring& Name, uint32_t Width, uint32_t Height, DXGI_FORMAT Format, D3D12_GPU_VIRTUAL_ADDRESS VidMemPtr )
 {
     D3D12_RESOURCE_DESC ResourceDesc = DescribeTex2D(Width, Height, 1, 1, Format, D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL);
 
-    D3D12_CLEAR_VALUE ClearValue = {};
-    ClearValue.Format = Format;
+    D3D12_CLEAR_VALUE ClearValue = DescribeClearValue(Format);
     CreateTextureResource(Graphics::g_Device, Name, ResourceDesc, ClearValue, VidMemPtr);
+    m_SampleCount = 1;
     CreateDerivedViews(Graphics::g_Device, Format);
 }
 
@@ -34,9 +44,9 @@ void DepthBuffer::Create( const std::wstring& Name, uint32_t Width, uint32_t Hei
     D3D12_RESOURCE_DESC ResourceDesc = DescribeTex2D(Width, Height, 1, 1, Format, D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL);
     ResourceDesc.SampleDesc.Count = Samples;
 
-    D3D12_CLEAR_VALUE ClearValue = {};
-    ClearValue.Format = Format;
+    D3D12_CLEAR_VALUE ClearValue = DescribeClearValue(Format);
     CreateTextureResource(Graphics::g_Device, Name, ResourceDesc, ClearValue, VidMemPtr);
+    m_SampleCount = Samples;
     CreateDerivedViews(Graphics::g_Device, Format);
 }
 
@@ -50,13 +60,31 @@ void DepthBuffer::Create( const std::wstring& Name, uint32_t Width, uint32_t Hei
     Create(Name, Width, Height, Samples, Format);
 }
 
-void DepthBuffer::CreateDerivedViews( ID3D12Device* Device, DXGI_FORMAT Format )
+void DepthBuffer::CreateArray( const std::wstring& Name, uint32_t Width, uint32_t Height, uint32_t ArrayCount, DXGI_FORMAT Format, D3D12_GPU_VIRTUAL_ADDRESS VidMemPtr )
+{
+    D3D12_RESOURCE_DESC ResourceDesc = DescribeTex2D(Width, Height, ArrayCount, 1, Format, D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL);
+
+    D3D12_CLEAR_VALUE ClearValue = DescribeClearValue(Format);
+    CreateTextureResource(Graphics::g_Device, Name, ResourceDesc, ClearValue, VidMemPtr);
+    m_SampleCount = 1;
+    CreateDerivedViews(Graphics::g_Device, Format, ArrayCount);
+}
+
+void DepthBuffer::CreateDerivedViews( ID3D12Device* Device, DXGI_FORMAT Format, uint32_t ArraySize )
 {
     ID3D12Resource* Resource = m_pResource.Get();
 
     D3D12_DEPTH_STENCIL_VIEW_DESC dsvDesc;
     dsvDesc.Format = GetDSVFormat(Format);
-    if (Resource->GetDesc().SampleDesc.Count == 1)
+    if (ArraySize > 1)
+    {
+        ASSERT(Resource->GetDesc().SampleDesc.Count == 1, "We don't support MSAA depth buffer arrays");
+        dsvDesc.ViewDimension = D3D12_DSV_DIMENSION_TEXTURE2DARRAY;
+        dsvDesc.Texture2DArray.MipSlice = 0;
+        dsvDesc.Texture2DArray.FirstArraySlice = 0;
+        dsvDesc.Texture2DArray.ArraySize = ArraySize;
+    }
+    else if (Resource->GetDesc().SampleDesc.Count == 1)
     {
         dsvDesc.ViewDimension = D3D12_DSV_DIMENSION_TEXTURE2D;
         dsvDesc.Texture2D.MipSlice = 0;
@@ -99,13 +127,40 @@ void DepthBuffer::CreateDerivedViews( ID3D12Device* Device, DXGI_FORMAT Format )
         m_hDSV[3] = m_hDSV[1];
     }
 
+    if (ArraySize > 1)
+    {
+        if (m_hSliceDSV.size() != ArraySize)
+        {
+            m_hSliceDSV.resize(ArraySize);
+            for (uint32_t i = 0; i < ArraySize; ++i)
+                m_hSliceDSV[i] = Graphics::AllocateDescriptor(D3D12_DESCRIPTOR_HEAP_TYPE_DSV);
+        }
+
+        D3D12_DEPTH_STENCIL_VIEW_DESC sliceDesc = dsvDesc;
+        sliceDesc.Flags = D3D12_DSV_FLAG_NONE;
+        sliceDesc.Texture2DArray.ArraySize = 1;
+
+        for (uint32_t i = 0; i < ArraySize; ++i)
+        {
+            sliceDesc.Texture2DArray.FirstArraySlice = i;
+            Device->CreateDepthStencilView(Resource, &sliceDesc, m_hSliceDSV[i]);
+        }
+    }
+
     if (m_hDepthSRV.ptr == D3D12_GPU_VIRTUAL_ADDRESS_UNKNOWN)
         m_hDepthSRV = Graphics::AllocateDescriptor(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
 
     // Create the shader resource view
     D3D12_SHADER_RESOURCE_VIEW_DESC SRVDesc = {};
     SRVDesc.Format = GetDepthFormat(Format);
-    if (dsvDesc.ViewDimension == D3D12_DSV_DIMENSION_TEXTURE2D)
+    if (dsvDesc.ViewDimension == D3D12_DSV_DIMENSION_TEXTURE2DARRAY)
+    {
+        SRVDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2DARRAY;
+        SRVDesc.Texture2DArray.MipLevels = 1;
+        SRVDesc.Texture2DArray.FirstArraySlice = 0;
+        SRVDesc.Texture2DArray.ArraySize = ArraySize;
+    }
+    else if (dsvDesc.ViewDimension == D3D12_DSV_DIMENSION_TEXTURE2D)
     {
         SRVDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
         SRVDesc.Texture2D.MipLevels = 1;
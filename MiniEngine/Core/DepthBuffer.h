@@ -21,7 +21,7 @@ class DepthBuffer : public PixelBuffer
 {
 public:
     DepthBuffer( float ClearDepth = 0.0f, uint8_t ClearStencil = 0 )
-        : m_ClearDepth(ClearDepth), m_ClearStencil(ClearStencil) 
+        : m_ClearDepth(ClearDepth), m_ClearStencil(ClearStencil), m_SampleCount(1)
     {
         m_hDSV[0].ptr = D3D12_GPU_VIRTUAL_ADDRESS_UNKNOWN;
         m_hDSV[1].ptr = D3D12_GPU_VIRTUAL_ADDRESS_UNKNOWN;
@@ -47,6 +47,11 @@ public:
     void Create( const std::wstring& Name, uint32_t Width, uint32_t Height, uint32_t NumSamples, DXGI_FORMAT Format,
         EsramAllocator& Allocator );
 
+    // Create a depth buffer array.  GetDSV() and the SRVs cover every slice, and GetSliceDSV() selects
+    // a single slice to render to.
+    void CreateArray( const std::wstring& Name, uint32_t Width, uint32_t Height, uint32_t ArrayCount, DXGI_FORMAT Format,
+        D3D12_GPU_VIRTUAL_ADDRESS VidMemPtr = D3D12_GPU_VIRTUAL_ADDRESS_UNKNOWN );
+
     // Get pre-created CPU-visible descriptor handles
     const D3D12_CPU_DESCRIPTOR_HANDLE& GetDSV() const { return m_hDSV[0]; }
     const D3D12_CPU_DESCRIPTOR_HANDLE& GetDSV_DepthReadOnly() const { return m_hDSV[1]; }
@@ -54,17 +59,33 @@ public:
     const D3D12_CPU_DESCRIPTOR_HANDLE& GetDSV_ReadOnly() const { return m_hDSV[3]; }
     const D3D12_CPU_DESCRIPTOR_HANDLE& GetDepthSRV() const { return m_hDepthSRV; }
     const D3D12_CPU_DESCRIPTOR_HANDLE& GetStencilSRV() const { return m_hStencilSRV; }
+    const D3D12_CPU_DESCRIPTOR_HANDLE& GetSliceDSV( uint32_t Slice ) const
+    {
+        if (m_hSliceDSV.empty())
+        {
+            ASSERT(Slice == 0);
+            return m_hDSV[0];
+        }
+        ASSERT(Slice < m_hSliceDSV.size());
+        return m_hSliceDSV[Slice];
+    }
 
     float GetClearDepth() const { return m_ClearDepth; }
     uint8_t GetClearStencil() const { return m_ClearStencil; }
 
+    // Greater than one for MSAA, whose depth SRV is a Texture2DMS
+    uint32_t GetSampleCount() const { return m_SampleCount; }
+
 private:
 
-    void CreateDerivedViews( ID3D12Device* Device, DXGI_FORMAT Format );
+    void CreateDerivedViews( ID3D12Device* Device, DXGI_FORMAT Format, uint32_t ArraySize = 1 );
+    D3D12_CLEAR_VALUE DescribeClearValue( DXGI_FORMAT Format ) const;
 
     float m_ClearDepth;
     uint8_t m_ClearStencil;
+    uint32_t m_SampleCount;
     D3D12_CPU_DESCRIPTOR_HANDLE m_hDSV[4];
     D3D12_CPU_DESCRIPTOR_HANDLE m_hDepthSRV;
     D3D12_CPU_DESCRIPTOR_HANDLE m_hStencilSRV;
+    std::vector<D3D12_CPU_DESCRIPTOR_HANDLE> m_hSliceDSV;
 };
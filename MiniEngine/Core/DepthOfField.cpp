@@ -25,7 +25,11 @@
 #include "CompiledShaders/DoFPreFilterFastCS.h"
 #include "CompiledShaders/DoFPreFilterFixupCS.h"
 #include "CompiledShaders/DoFPass2CS.h"
+#include "CompiledShaders/DoFPass2Ring1CS.h"
+#include "CompiledShaders/DoFPass2Ring2CS.h"
 #include "CompiledShaders/DoFPass2FastCS.h"
+#include "CompiledShaders/DoFPass2FastRing1CS.h"
+#include "CompiledShaders/DoFPass2FastRing2CS.h"
 #include "CompiledShaders/DoFPass2FixupCS.h"
 #include "CompiledShaders/DoFPass2DebugCS.h"
 #include "CompiledShaders/DoFMedianFilterCS.h"
@@ -67,8 +71,12 @@ namespace DepthOfField
     ComputePSO s_DoFPreFilterFastCS;        // Pre-filter assuming near-constant focus
     ComputePSO s_DoFPreFilterFixupCS;        // Pass through colors for completely in focus tile
 
-    ComputePSO s_DoFPass2CS;                // Perform full CoC convolution pass
-    ComputePSO s_DoFPass2FastCS;            // Perform color-only convolution for near-constant focus
+    // Tiles are queued by the number of rings the convolution needs to cover their max CoC, and each queue is
+    // dispatched with a shader that only gathers that many rings.
+    const uint32_t kNumRingBuckets = 3;
+
+    ComputePSO s_DoFPass2CS[kNumRingBuckets];        // Perform full CoC convolution pass
+    ComputePSO s_DoFPass2FastCS[kNumRingBuckets];    // Perform color-only convolution for near-constant focus
     ComputePSO s_DoFPass2FixupCS;            // Pass through colors again
     ComputePSO s_DoFPass2DebugCS;            // Full pass 2 shader with options for debugging
 
@@ -82,7 +90,12 @@ namespace DepthOfField
     ComputePSO s_DoFDebugGreenCS;            // Output green to entire tile for debugging
     ComputePSO s_DoFDebugBlueCS;            // Output blue to entire tile for debugging
 
+    // Dispatch arguments for each bucket of the work queue, then each bucket of the fast queue, then the fixup queue
     IndirectArgsBuffer s_IndirectParameters;
+
+    inline uint32_t WorkArgsOffset( uint32_t Bucket ) { return Bucket * sizeof(D3D12_DISPATCH_ARGUMENTS); }
+    inline uint32_t FastArgsOffset( uint32_t Bucket ) { return (kNumRingBuckets + Bucket) * sizeof(D3D12_DISPATCH_ARGUMENTS); }
+    const uint32_t kFixupArgsOffset = 2 * kNumRingBuckets * sizeof(D3D12_DISPATCH_ARGUMENTS);
 }
 
 void DepthOfField::Initialize( void )
@@ -93,7 +106,7 @@ void DepthOfField::Initialize( void )
     s_RootSignature.InitStaticSampler(2, SamplerLinearClampDesc);
     s_RootSignature[0].InitAsConstantBuffer(0);
     s_RootSignature[1].InitAsDescriptorRange(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 0, 6);
-    s_RootSignature[2].InitAsDescriptorRange(D3D12_DESCRIPTOR_RANGE_TYPE_UAV, 0, 3);
+    s_RootSignature[2].InitAsDescriptorRange(D3D12_DESCRIPTOR_RANGE_TYPE_UAV, 0, 7);
     s_RootSignature[3].InitAsConstants(1, 1);
     s_RootSignature.Finalize(L"Depth of Field");
 
@@ -108,8 +121,12 @@ void DepthOfField::Initialize( void )
     CreatePSO( s_DoFPreFilterCS, g_pDoFPreFilterCS);
     CreatePSO( s_DoFPreFilterFastCS, g_pDoFPreFilterFastCS);
     CreatePSO( s_DoFPreFilterFixupCS, g_pDoFPreFilterFixupCS);
-    CreatePSO( s_DoFPass2CS, g_pDoFPass2CS);
-    CreatePSO( s_DoFPass2FastCS, g_pDoFPass2FastCS);
+    CreatePSO( s_DoFPass2CS[0], g_pDoFPass2Ring1CS);
+    CreatePSO( s_DoFPass2CS[1], g_pDoFPass2Ring2CS);
+    CreatePSO( s_DoFPass2CS[2], g_pDoFPass2CS);
+    CreatePSO( s_DoFPass2FastCS[0], g_pDoFPass2FastRing1CS);
+    CreatePSO( s_DoFPass2FastCS[1], g_pDoFPass2FastRing2CS);
+    CreatePSO( s_DoFPass2FastCS[2], g_pDoFPass2FastCS);
     CreatePSO( s_DoFPass2FixupCS, g_pDoFPass2FixupCS);
     CreatePSO( s_DoFPass2DebugCS, g_pDoFPass2DebugCS);
     CreatePSO( s_DoFMedianFilterCS, g_pDoFMedianFilterCS );
@@ -131,8 +148,13 @@ void DepthOfField::Initialize( void )
 
 #undef CreatePSO
 
-    __declspec(align(16)) const uint32_t initArgs[9] = { 0, 1, 1, 0, 1, 1, 0, 1, 1 };
-    s_IndirectParameters.Create(L"DoF Indirect Parameters", 3, sizeof(D3D12_DISPATCH_ARGUMENTS), initArgs);
+    __declspec(align(16)) const uint32_t initArgs[21] =
+    {
+        0, 1, 1, 0, 1, 1, 0, 1, 1,    // Work queues
+        0, 1, 1, 0, 1, 1, 0, 1, 1,    // Fast queues
+        0, 1, 1                       // Fixup queue
+    };
+    s_IndirectParameters.Create(L"DoF Indirect Parameters", 2 * kNumRingBuckets + 1, sizeof(D3D12_DISPATCH_ARGUMENTS), initArgs);
 }
 
 void DepthOfField::Shutdown( void )
@@ -152,6 +174,7 @@ void DepthOfField::Render( CommandContext& BaseContext, float /*NearClipDist*/,
 
     ComputeContext& Context = BaseContext.GetComputeContext();
     Context.SetRootSignature(s_RootSignature);
+    AcquireTransientBuffers(Context, kTransientDepthOfField);
 
     ColorBuffer& LinearDepth = g_LinearDepth[ Graphics::GetFrameCount() % 2 ];
 
@@ -197,20 +220,26 @@ void DepthOfField::Render( CommandContext& BaseContext, float /*NearClipDist*/,
         Context.SetDynamicDescriptor(2, 0, g_DoFTileClass[0].GetUAV());
         Context.Dispatch2D(BufferWidth, BufferHeight, 16, 16);
 
-        Context.ResetCounter(g_DoFWorkQueue);
-        Context.ResetCounter(g_DoFFastQueue);
+        for (uint32_t Bucket = 0; Bucket < kNumRingBuckets; ++Bucket)
+        {
+            Context.ResetCounter(g_DoFWorkQueue[Bucket]);
+            Context.ResetCounter(g_DoFFastQueue[Bucket]);
+        }
         Context.ResetCounter(g_DoFFixupQueue);
 
-        // 3x3 filter to spread max CoC and closest depth to neighboring tiles
+        // 3x3 filter to spread max CoC and closest depth to neighboring tiles, which are then queued by ring count
         Context.TransitionResource(g_DoFTileClass[0], D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
         Context.TransitionResource(g_DoFTileClass[1], D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
-        Context.TransitionResource(g_DoFWorkQueue, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
-        Context.TransitionResource(g_DoFFastQueue, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
         Context.SetPipelineState(s_DoFTilePassCS);
         Context.SetDynamicDescriptor(1, 0, g_DoFTileClass[0].GetSRV());
         Context.SetDynamicDescriptor(2, 0, g_DoFTileClass[1].GetUAV());
-        Context.SetDynamicDescriptor(2, 1, g_DoFWorkQueue.GetUAV());
-        Context.SetDynamicDescriptor(2, 2, g_DoFFastQueue.GetUAV());
+        for (uint32_t Bucket = 0; Bucket < kNumRingBuckets; ++Bucket)
+        {
+            Context.TransitionResource(g_DoFWorkQueue[Bucket], D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+            Context.TransitionResource(g_DoFFastQueue[Bucket], D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+            Context.SetDynamicDescriptor(2, 1 + Bucket, g_DoFWorkQueue[Bucket].GetUAV());
+            Context.SetDynamicDescriptor(2, 1 + kNumRingBuckets + Bucket, g_DoFFastQueue[Bucket].GetUAV());
+        }
         Context.Dispatch2D(TiledWidth, TiledHeight);
 
         Context.TransitionResource(g_DoFTileClass[1], D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
@@ -220,14 +249,17 @@ void DepthOfField::Render( CommandContext& BaseContext, float /*NearClipDist*/,
         Context.SetDynamicDescriptor(2, 0, g_DoFFixupQueue.GetUAV());
         Context.Dispatch2D(TiledWidth, TiledHeight);
 
-        Context.TransitionResource(g_DoFWorkQueue, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
-        Context.CopyCounter(s_IndirectParameters, 0, g_DoFWorkQueue);
+        for (uint32_t Bucket = 0; Bucket < kNumRingBuckets; ++Bucket)
+        {
+            Context.TransitionResource(g_DoFWorkQueue[Bucket], D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+            Context.CopyCounter(s_IndirectParameters, WorkArgsOffset(Bucket), g_DoFWorkQueue[Bucket]);
 
-        Context.TransitionResource(g_DoFFastQueue, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
-        Context.CopyCounter(s_IndirectParameters, 12, g_DoFFastQueue);
+            Context.TransitionResource(g_DoFFastQueue[Bucket], D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+            Context.CopyCounter(s_IndirectParameters, FastArgsOffset(Bucket), g_DoFFastQueue[Bucket]);
+        }
 
         Context.TransitionResource(g_DoFFixupQueue, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
-        Context.CopyCounter(s_IndirectParameters, 24, g_DoFFixupQueue);
+        Context.CopyCounter(s_IndirectParameters, kFixupArgsOffset, g_DoFFixupQueue);
 
         Context.TransitionResource(s_IndirectParameters, D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT);
     }
@@ -245,19 +277,25 @@ void DepthOfField::Render( CommandContext& BaseContext, float /*NearClipDist*/,
         Context.SetDynamicDescriptor(1, 0, LinearDepth.GetSRV());
         Context.SetDynamicDescriptor(1, 1, g_DoFTileClass[1].GetSRV());
         Context.SetDynamicDescriptor(1, 2, g_SceneColorBuffer.GetSRV());
-        Context.SetDynamicDescriptor(1, 3, g_DoFWorkQueue.GetSRV());
         Context.SetDynamicDescriptor(2, 0, g_DoFPresortBuffer.GetUAV());
         Context.SetDynamicDescriptor(2, 1, g_DoFPrefilter.GetUAV());
-        Context.DispatchIndirect(s_IndirectParameters, 0);
+        for (uint32_t Bucket = 0; Bucket < kNumRingBuckets; ++Bucket)
+        {
+            Context.SetDynamicDescriptor(1, 3, g_DoFWorkQueue[Bucket].GetSRV());
+            Context.DispatchIndirect(s_IndirectParameters, WorkArgsOffset(Bucket));
+        }
 
         if (!ForceSlow && !DebugMode)
             Context.SetPipelineState(s_DoFPreFilterFastCS);
-        Context.SetDynamicDescriptor(1, 3, g_DoFFastQueue.GetSRV());
-        Context.DispatchIndirect(s_IndirectParameters, 12);
+        for (uint32_t Bucket = 0; Bucket < kNumRingBuckets; ++Bucket)
+        {
+            Context.SetDynamicDescriptor(1, 3, g_DoFFastQueue[Bucket].GetSRV());
+            Context.DispatchIndirect(s_IndirectParameters, FastArgsOffset(Bucket));
+        }
 
         Context.SetPipelineState(s_DoFPreFilterFixupCS);
         Context.SetDynamicDescriptor(1, 3, g_DoFFixupQueue.GetSRV());
-        Context.DispatchIndirect(s_IndirectParameters, 24);
+        Context.DispatchIndirect(s_IndirectParameters, kFixupArgsOffset);
     }
 
     {
@@ -266,26 +304,36 @@ void DepthOfField::Render( CommandContext& BaseContext, float /*NearClipDist*/,
         Context.TransitionResource(g_DoFPrefilter, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
         Context.TransitionResource(g_DoFBlurColor[0], D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
         Context.TransitionResource(g_DoFBlurAlpha[0], D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
-        if (ForceFast && !DebugMode)
-            Context.SetPipelineState(s_DoFPass2FastCS);
-        else
-            Context.SetPipelineState(DebugMode > 0 ? s_DoFPass2DebugCS : s_DoFPass2CS);
         Context.SetDynamicDescriptor(1, 0, g_DoFPrefilter.GetSRV());
         Context.SetDynamicDescriptor(1, 1, g_DoFPresortBuffer.GetSRV());
         Context.SetDynamicDescriptor(1, 2, g_DoFTileClass[1].GetSRV());
-        Context.SetDynamicDescriptor(1, 3, g_DoFWorkQueue.GetSRV());
         Context.SetDynamicDescriptor(2, 0, g_DoFBlurColor[0].GetUAV());
         Context.SetDynamicDescriptor(2, 1, g_DoFBlurAlpha[0].GetUAV());
-        Context.DispatchIndirect(s_IndirectParameters, 0);
 
-        if (!ForceSlow && !DebugMode)
-            Context.SetPipelineState(s_DoFPass2FastCS);
-        Context.SetDynamicDescriptor(1, 3, g_DoFFastQueue.GetSRV());
-        Context.DispatchIndirect(s_IndirectParameters, 12);
+        // The debug shader always handles every ring
+        for (uint32_t Bucket = 0; Bucket < kNumRingBuckets; ++Bucket)
+        {
+            if (ForceFast && !DebugMode)
+                Context.SetPipelineState(s_DoFPass2FastCS[Bucket]);
+            else
+                Context.SetPipelineState(DebugMode > 0 ? s_DoFPass2DebugCS : s_DoFPass2CS[Bucket]);
+            Context.SetDynamicDescriptor(1, 3, g_DoFWorkQueue[Bucket].GetSRV());
+            Context.DispatchIndirect(s_IndirectParameters, WorkArgsOffset(Bucket));
+        }
+
+        for (uint32_t Bucket = 0; Bucket < kNumRingBuckets; ++Bucket)
+        {
+            if (!ForceSlow && !DebugMode)
+                Context.SetPipelineState(s_DoFPass2FastCS[Bucket]);
+            else
+                Context.SetPipelineState(DebugMode > 0 ? s_DoFPass2DebugCS : s_DoFPass2CS[Bucket]);
+            Context.SetDynamicDescriptor(1, 3, g_DoFFastQueue[Bucket].GetSRV());
+            Context.DispatchIndirect(s_IndirectParameters, FastArgsOffset(Bucket));
+        }
 
         Context.SetPipelineState(s_DoFPass2FixupCS);
         Context.SetDynamicDescriptor(1, 3, g_DoFFixupQueue.GetSRV());
-        Context.DispatchIndirect(s_IndirectParameters, 24);
+        Context.DispatchIndirect(s_IndirectParameters, kFixupArgsOffset);
     }
 
     {
@@ -300,17 +348,20 @@ void DepthOfField::Render( CommandContext& BaseContext, float /*NearClipDist*/,
             Context.SetPipelineState(MedianAlpha ? s_DoFMedianFilterSepAlphaCS : s_DoFMedianFilterCS);
             Context.SetDynamicDescriptor(1, 0, g_DoFBlurColor[0].GetSRV());
             Context.SetDynamicDescriptor(1, 1, g_DoFBlurAlpha[0].GetSRV());
-            Context.SetDynamicDescriptor(1, 2, g_DoFWorkQueue.GetSRV());
             Context.SetDynamicDescriptor(2, 0, g_DoFBlurColor[1].GetUAV());
             Context.SetDynamicDescriptor(2, 1, g_DoFBlurAlpha[1].GetUAV());
-            Context.DispatchIndirect(s_IndirectParameters, 0);
+            for (uint32_t Bucket = 0; Bucket < kNumRingBuckets; ++Bucket)
+            {
+                Context.SetDynamicDescriptor(1, 2, g_DoFWorkQueue[Bucket].GetSRV());
+                Context.DispatchIndirect(s_IndirectParameters, WorkArgsOffset(Bucket));
 
-            Context.SetDynamicDescriptor(1, 2, g_DoFFastQueue.GetSRV());
-            Context.DispatchIndirect(s_IndirectParameters, 12);
+                Context.SetDynamicDescriptor(1, 2, g_DoFFastQueue[Bucket].GetSRV());
+                Context.DispatchIndirect(s_IndirectParameters, FastArgsOffset(Bucket));
+            }
 
             Context.SetPipelineState(s_DoFMedianFilterFixupCS);
             Context.SetDynamicDescriptor(1, 2, g_DoFFixupQueue.GetSRV());
-            Context.DispatchIndirect(s_IndirectParameters, 24);
+            Context.DispatchIndirect(s_IndirectParameters, kFixupArgsOffset);
 
             Context.TransitionResource(g_DoFBlurColor[1], D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
             Context.TransitionResource(g_DoFBlurAlpha[1], D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
@@ -323,18 +374,25 @@ void DepthOfField::Render( CommandContext& BaseContext, float /*NearClipDist*/,
 
         if (DebugTiles)
         {
-            Context.SetPipelineState(s_DoFDebugRedCS);
-            Context.SetDynamicDescriptor(1, 5, g_DoFWorkQueue.GetSRV());
             Context.SetDynamicDescriptor(2, 0, g_SceneColorBuffer.GetUAV());
-            Context.DispatchIndirect(s_IndirectParameters, 0);
+
+            Context.SetPipelineState(s_DoFDebugRedCS);
+            for (uint32_t Bucket = 0; Bucket < kNumRingBuckets; ++Bucket)
+            {
+                Context.SetDynamicDescriptor(1, 5, g_DoFWorkQueue[Bucket].GetSRV());
+                Context.DispatchIndirect(s_IndirectParameters, WorkArgsOffset(Bucket));
+            }
 
             Context.SetPipelineState(s_DoFDebugGreenCS);
-            Context.SetDynamicDescriptor(1, 5, g_DoFFastQueue.GetSRV());
-            Context.DispatchIndirect(s_IndirectParameters, 12);
+            for (uint32_t Bucket = 0; Bucket < kNumRingBuckets; ++Bucket)
+            {
+                Context.SetDynamicDescriptor(1, 5, g_DoFFastQueue[Bucket].GetSRV());
+                Context.DispatchIndirect(s_IndirectParameters, FastArgsOffset(Bucket));
+            }
 
             Context.SetPipelineState(s_DoFDebugBlueCS);
             Context.SetDynamicDescriptor(1, 5, g_DoFFixupQueue.GetSRV());
-            Context.DispatchIndirect(s_IndirectParameters, 24);
+            Context.DispatchIndirect(s_IndirectParameters, kFixupArgsOffset);
         }
         else
         {
@@ -343,13 +401,19 @@ void DepthOfField::Render( CommandContext& BaseContext, float /*NearClipDist*/,
             Context.SetDynamicDescriptor(1, 1, g_DoFBlurAlpha[MedianFilter ? 1 : 0].GetSRV());
             Context.SetDynamicDescriptor(1, 2, g_DoFTileClass[1].GetSRV());
             Context.SetDynamicDescriptor(1, 3, LinearDepth.GetSRV());
-            Context.SetDynamicDescriptor(1, 4, g_DoFWorkQueue.GetSRV());
             Context.SetDynamicDescriptor(2, 0, g_SceneColorBuffer.GetUAV());
-            Context.DispatchIndirect(s_IndirectParameters, 0);
+            for (uint32_t Bucket = 0; Bucket < kNumRingBuckets; ++Bucket)
+            {
+                Context.SetDynamicDescriptor(1, 4, g_DoFWorkQueue[Bucket].GetSRV());
+                Context.DispatchIndirect(s_IndirectParameters, WorkArgsOffset(Bucket));
+            }
 
             Context.SetPipelineState(s_DoFCombineFastCS);
-            Context.SetDynamicDescriptor(1, 4, g_DoFFastQueue.GetSRV());
-            Context.DispatchIndirect(s_IndirectParameters, 12);
+            for (uint32_t Bucket = 0; Bucket < kNumRingBuckets; ++Bucket)
+            {
+                Context.SetDynamicDescriptor(1, 4, g_DoFFastQueue[Bucket].GetSRV());
+                Context.DispatchIndirect(s_IndirectParameters, FastArgsOffset(Bucket));
+            }
         }
 
         Context.InsertUAVBarrier(g_SceneColorBuffer);
@@ -24,15 +24,36 @@ using namespace Graphics;
 std::mutex DescriptorAllocator::sm_AllocationMutex;
 std::vector<Microsoft::WRL::ComPtr<ID3D12DescriptorHeap>> DescriptorAllocator::sm_DescriptorHeapPool;
 
+namespace
+{
+    inline uint32_t SizeClass( uint32_t Count )
+    {
+        unsigned long MSB;
+        _BitScanReverse(&MSB, Count);
+        return MSB;
+    }
+}
+
 void DescriptorAllocator::DestroyAll(void)
 {
     sm_DescriptorHeapPool.clear();
 }
 
-ID3D12DescriptorHeap* DescriptorAllocator::RequestNewHeap(D3D12_DESCRIPTOR_HEAP_TYPE Type)
+void DescriptorAllocator::Reset(void)
 {
     std::lock_guard<std::mutex> LockGuard(sm_AllocationMutex);
 
+    m_Pages.clear();
+    for (uint32_t i = 0; i < kNumSizeClasses; ++i)
+        m_FreeLists[i].clear();
+    m_DescriptorSize = 0;
+    m_NumAllocated = 0;
+    m_NumFree = 0;
+}
+
+// Called with sm_AllocationMutex held
+ID3D12DescriptorHeap* DescriptorAllocator::RequestNewHeap(D3D12_DESCRIPTOR_HEAP_TYPE Type)
+{
     D3D12_DESCRIPTOR_HEAP_DESC Desc;
     Desc.Type = Type;
     Desc.NumDescriptors = sm_NumDescriptorsPerHeap;
@@ -45,24 +66,161 @@ ID3D12DescriptorHeap* DescriptorAllocator::RequestNewHeap(D3D12_DESCRIPTOR_HEAP_
     return pHeap.Get();
 }
 
+// Called with sm_AllocationMutex held
+void DescriptorAllocator::ReleaseHeap( ID3D12DescriptorHeap* Heap )
+{
+    for (auto iter = sm_DescriptorHeapPool.begin(); iter != sm_DescriptorHeapPool.end(); ++iter)
+    {
+        if (iter->Get() == Heap)
+        {
+            sm_DescriptorHeapPool.erase(iter);
+            return;
+        }
+    }
+}
+
+void DescriptorAllocator::AddFreeRange( HeapPage& Page, uint32_t Offset, uint32_t Count )
+{
+    Page.FreeRanges[Offset] = Count;
+    m_FreeLists[SizeClass(Count)].insert(FreeRangeKey(&Page, Offset));
+}
+
+void DescriptorAllocator::RemoveFreeRange( HeapPage& Page, std::map<uint32_t, uint32_t>::iterator Range )
+{
+    m_FreeLists[SizeClass(Range->second)].erase(FreeRangeKey(&Page, Range->first));
+    Page.FreeRanges.erase(Range);
+}
+
 D3D12_CPU_DESCRIPTOR_HANDLE DescriptorAllocator::Allocate( uint32_t Count )
 {
-    if (m_CurrentHeap == nullptr || m_RemainingFreeHandles < Count)
+    ASSERT(Count > 0 && Count <= sm_NumDescriptorsPerHeap, "Invalid descriptor count");
+
+    std::lock_guard<std::mutex> LockGuard(sm_AllocationMutex);
+
+    // Every range in a larger size class fits, but ranges in Count's own class might not
+    HeapPage* Page = nullptr;
+    std::map<uint32_t, uint32_t>::iterator Range;
+    for (uint32_t SizeIdx = SizeClass(Count); Page == nullptr && SizeIdx < kNumSizeClasses; ++SizeIdx)
     {
-        m_CurrentHeap = RequestNewHeap(m_Type);
-        m_CurrentHandle = m_CurrentHeap->GetCPUDescriptorHandleForHeapStart();
-        m_RemainingFreeHandles = sm_NumDescriptorsPerHeap;
+        for (const FreeRangeKey& Key : m_FreeLists[SizeIdx])
+        {
+            auto Candidate = Key.first->FreeRanges.find(Key.second);
+            if (Candidate->second >= Count)
+            {
+                Page = Key.first;
+                Range = Candidate;
+                break;
+            }
+        }
+    }
+
+    if (Page == nullptr)
+    {
+        ID3D12DescriptorHeap* Heap = RequestNewHeap(m_Type);
 
         if (m_DescriptorSize == 0)
             m_DescriptorSize = Graphics::g_Device->GetDescriptorHandleIncrementSize(m_Type);
+
+        std::unique_ptr<HeapPage> NewPage(new HeapPage);
+        NewPage->Heap = Heap;
+        NewPage->NumAllocated = 0;
+        Page = NewPage.get();
+        m_Pages[Heap->GetCPUDescriptorHandleForHeapStart().ptr] = std::move(NewPage);
+
+        AddFreeRange(*Page, 0, sm_NumDescriptorsPerHeap);
+        m_NumFree += sm_NumDescriptorsPerHeap;
+        Range = Page->FreeRanges.begin();
     }
 
-    D3D12_CPU_DESCRIPTOR_HANDLE ret = m_CurrentHandle;
-    m_CurrentHandle.ptr += Count * m_DescriptorSize;
-    m_RemainingFreeHandles -= Count;
+    const uint32_t Offset = Range->first;
+    const uint32_t RangeSize = Range->second;
+    RemoveFreeRange(*Page, Range);
+    if (RangeSize > Count)
+        AddFreeRange(*Page, Offset + Count, RangeSize - Count);
+
+    Page->NumAllocated += Count;
+    m_NumAllocated += Count;
+    m_NumFree -= Count;
+
+    D3D12_CPU_DESCRIPTOR_HANDLE ret = Page->Heap->GetCPUDescriptorHandleForHeapStart();
+    ret.ptr += Offset * m_DescriptorSize;
     return ret;
 }
 
+void DescriptorAllocator::Free( D3D12_CPU_DESCRIPTOR_HANDLE Handle, uint32_t Count )
+{
+    if (Handle.ptr == 0 || Handle.ptr == D3D12_GPU_VIRTUAL_ADDRESS_UNKNOWN)
+        return;
+
+    std::lock_guard<std::mutex> LockGuard(sm_AllocationMutex);
+
+    auto PageIter = m_Pages.upper_bound(Handle.ptr);
+    ASSERT(PageIter != m_Pages.begin(), "Descriptor was not allocated by this allocator");
+    --PageIter;
+
+    HeapPage& Page = *PageIter->second;
+    uint32_t Offset = (uint32_t)((Handle.ptr - PageIter->first) / m_DescriptorSize);
+    ASSERT(Offset + Count <= sm_NumDescriptorsPerHeap, "Descriptor was not allocated by this allocator");
+    ASSERT(Page.NumAllocated >= Count);
+
+    Page.NumAllocated -= Count;
+    m_NumAllocated -= Count;
+    m_NumFree += Count;
+
+    // Merge with the free neighbors
+    auto Next = Page.FreeRanges.lower_bound(Offset);
+    ASSERT(Next == Page.FreeRanges.end() || Next->first >= Offset + Count, "Descriptors freed twice");
+    if (Next != Page.FreeRanges.begin())
+    {
+        auto Prev = std::prev(Next);
+        ASSERT(Prev->first + Prev->second <= Offset, "Descriptors freed twice");
+        if (Prev->first + Prev->second == Offset)
+        {
+            Offset = Prev->first;
+            Count += Prev->second;
+            RemoveFreeRange(Page, Prev);
+        }
+    }
+    if (Next != Page.FreeRanges.end() && Next->first == Offset + Count)
+    {
+        Count += Next->second;
+        RemoveFreeRange(Page, Next);
+    }
+
+    // Give back heaps that are no longer used, but keep the last one to avoid churn
+    if (Page.NumAllocated == 0 && m_Pages.size() > 1)
+    {
+        ASSERT(Page.FreeRanges.empty() && Offset == 0 && Count == sm_NumDescriptorsPerHeap);
+        m_NumFree -= sm_NumDescriptorsPerHeap;
+        ReleaseHeap(Page.Heap);
+        m_Pages.erase(PageIter);
+        return;
+    }
+
+    AddFreeRange(Page, Offset, Count);
+}
+
+DescriptorAllocator::Stats DescriptorAllocator::GetStats( void ) const
+{
+    std::lock_guard<std::mutex> LockGuard(sm_AllocationMutex);
+
+    Stats Result;
+    Result.NumHeaps = (uint32_t)m_Pages.size();
+    Result.NumAllocated = m_NumAllocated;
+    Result.NumFree = m_NumFree;
+    Result.LargestFreeRange = 0;
+
+    // The largest range is in the highest non-empty size class
+    for (uint32_t SizeIdx = kNumSizeClasses; SizeIdx > 0 && Result.LargestFreeRange == 0; --SizeIdx)
+    {
+        for (const FreeRangeKey& Key : m_FreeLists[SizeIdx - 1])
+            Result.LargestFreeRange = std::max(Result.LargestFreeRange, Key.first->FreeRanges.find(Key.second)->second);
+    }
+
+    Result.Fragmentation = m_NumFree == 0 ? 0.0f : 1.0f - (float)Result.LargestFreeRange / m_NumFree;
+    return Result;
+}
+
 //
 // UserDescriptorHeap implementation
 //
@@ -87,6 +245,7 @@ DescriptorHandle UserDescriptorHeap::Alloc( uint32_t Count )
     ASSERT(HasAvailableSpace(Count), "Descriptor Heap out of space.  Increase heap size.");
     DescriptorHandle ret = m_NextFreeHandle;
     m_NextFreeHandle += Count * m_DescriptorSize;
+    m_NumFreeDescriptors -= Count;
     return ret;
 }
 
@@ -17,32 +17,73 @@
 #include <vector>
 #include <queue>
 #include <string>
+#include <map>
+#include <set>
 
 
 // This is an unbounded resource descriptor allocator.  It is intended to provide space for CPU-visible resource descriptors
 // as resources are created.  For those that need to be made shader-visible, they will need to be copied to a UserDescriptorHeap
 // or a DynamicDescriptorHeap.
+//
+// Descriptors can be given back with Free().  Freed ranges are merged with their free neighbors and kept in free lists
+// by size class, and a heap whose descriptors have all been freed is released, so that streaming resources in and out
+// does not grow the descriptor heaps without bound.  Since these heaps are never shader-visible, a descriptor can be
+// freed as soon as it has been copied or bound, even if the GPU has not executed those commands yet.
 class DescriptorAllocator
 {
 public:
-    DescriptorAllocator(D3D12_DESCRIPTOR_HEAP_TYPE Type) : m_Type(Type), m_CurrentHeap(nullptr) {}
+    DescriptorAllocator(D3D12_DESCRIPTOR_HEAP_TYPE Type) : m_Type(Type), m_DescriptorSize(0), m_NumAllocated(0), m_NumFree(0) {}
 
     D3D12_CPU_DESCRIPTOR_HANDLE Allocate( uint32_t Count );
 
+    // Count must match the size of the original allocation
+    void Free( D3D12_CPU_DESCRIPTOR_HANDLE Handle, uint32_t Count );
+
+    struct Stats
+    {
+        uint32_t NumHeaps;
+        uint32_t NumAllocated;        // Descriptors handed out and not yet freed
+        uint32_t NumFree;            // Descriptors available in the heaps already created
+        uint32_t LargestFreeRange;
+        float Fragmentation;        // 0 when the free descriptors are contiguous, approaching 1 as they scatter
+    };
+    Stats GetStats( void ) const;
+
+    // Release every heap.  The allocators can't be used afterward until they are Reset().
     static void DestroyAll(void);
 
+    // Forget the pages of the destroyed heaps so that the allocator can serve a new device.  Descriptors
+    // allocated before must not be freed afterward.
+    void Reset(void);
+
 protected:
 
     static const uint32_t sm_NumDescriptorsPerHeap = 256;
     static std::mutex sm_AllocationMutex;
     static std::vector<Microsoft::WRL::ComPtr<ID3D12DescriptorHeap>> sm_DescriptorHeapPool;
     static ID3D12DescriptorHeap* RequestNewHeap( D3D12_DESCRIPTOR_HEAP_TYPE Type );
+    static void ReleaseHeap( ID3D12DescriptorHeap* Heap );
+
+    struct HeapPage
+    {
+        ID3D12DescriptorHeap* Heap;
+        uint32_t NumAllocated;
+        std::map<uint32_t, uint32_t> FreeRanges;    // Offset -> count, never adjacent to each other
+    };
+
+    // Free lists for ranges of 1, 2-3, 4-7, ... 256 descriptors
+    static const uint32_t kNumSizeClasses = 9;
+    typedef std::pair<HeapPage*, uint32_t> FreeRangeKey;
+
+    void AddFreeRange( HeapPage& Page, uint32_t Offset, uint32_t Count );
+    void RemoveFreeRange( HeapPage& Page, std::map<uint32_t, uint32_t>::iterator Range );
 
     D3D12_DESCRIPTOR_HEAP_TYPE m_Type;
-    ID3D12DescriptorHeap* m_CurrentHeap;
-    D3D12_CPU_DESCRIPTOR_HANDLE m_CurrentHandle;
     uint32_t m_DescriptorSize;
-    uint32_t m_RemainingFreeHandles;
+    uint32_t m_NumAllocated;
+    uint32_t m_NumFree;
+    std::map<SIZE_T, std::unique_ptr<HeapPage>> m_Pages;    // Keyed by the heap's first CPU handle
+    std::set<FreeRangeKey> m_FreeLists[kNumSizeClasses];
 };
 
 
@@ -106,6 +147,7 @@ public:
     }
 
     void Create( const std::wstring& DebugHeapName );
+    void Destroy( void ) { m_Heap = nullptr; }
 
     bool HasAvailableSpace( uint32_t Count ) const { return Count <= m_NumFreeDescriptors; }
     DescriptorHandle Alloc( uint32_t Count = 1 );
@@ -14,6 +14,7 @@
 #include "pch.h"
 #include "GraphicsCore.h"
 #include "DynamicUploadBuffer.h"
+#include "GpuMemory.h"
 
 using namespace Graphics;
 
@@ -43,6 +44,7 @@ void DynamicUploadBuffer::Create(const std::wstring& name, uint32_t NumElements,
         D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, MY_IID_PPV_ARGS(&m_pResource)) );
 
     m_pResource->SetName(name.c_str());
+    GpuMemory::Track(m_pResource.Get(), GpuMemory::kDynamic);
 
     m_GpuVirtualAddress = m_pResource->GetGPUVirtualAddress();
     m_CpuVirtualAddress = nullptr;
@@ -22,6 +22,9 @@
 #include <vector>
 #include <unordered_map>
 #include <array>
+#include <atomic>
+#include <mutex>
+#include <memory>
 
 using namespace Graphics;
 using namespace GraphRenderer;
@@ -32,6 +35,7 @@ using namespace std;
 namespace EngineProfiling
 {
     bool Paused = false;
+    vector<pair<wstring, uint32_t>> s_Counters;
 }
 
 class StatHistory
@@ -158,6 +162,119 @@ private:
     vector<StatGraph> m_Graphs;
 };
 
+// Records completed scopes from any thread.  Slots are claimed with an atomic increment, and the oldest events are
+// overwritten once the ring wraps.  Names point at strings owned by the timing tree, which are never freed.
+class ProfileCapture
+{
+public:
+    static void Start( void )
+    {
+        if (sm_Events.empty())
+            sm_Events.resize(kCapacity);
+        sm_NextEvent = 0;
+        sm_Recording = true;
+    }
+
+    static void Stop( void ) { sm_Recording = false; }
+    static bool IsRecording( void ) { return sm_Recording; }
+
+    static void RecordCpuScope( const wstring& Name, int64_t StartTick, int64_t EndTick )
+    {
+        Record(Name, StartTick, EndTick, GetCurrentThreadId());
+    }
+
+    static void RecordCpuScope( const wstring& Name, int64_t StartTick, int64_t EndTick, uint32_t ThreadId )
+    {
+        Record(Name, StartTick, EndTick, ThreadId);
+    }
+
+    static void RecordGpuScope( const wstring& Name, int64_t StartTick, int64_t EndTick )
+    {
+        Record(Name, StartTick, EndTick, kGpuThreadId);
+    }
+
+    static bool Save( const wstring& FilePath );
+
+private:
+    struct Event
+    {
+        const wstring* Name;
+        int64_t StartTick;
+        int64_t EndTick;
+        uint32_t ThreadId;
+    };
+
+    static void Record( const wstring& Name, int64_t StartTick, int64_t EndTick, uint32_t ThreadId )
+    {
+        if (!sm_Recording)
+            return;
+
+        Event& E = sm_Events[sm_NextEvent.fetch_add(1) % kCapacity];
+        E.Name = &Name;
+        E.StartTick = StartTick;
+        E.EndTick = EndTick;
+        E.ThreadId = ThreadId;
+    }
+
+    static const uint32_t kCapacity = 1 << 18;
+    static const uint32_t kGpuThreadId = 0xFFFFFFFF;
+
+    static vector<Event> sm_Events;
+    static atomic<uint64_t> sm_NextEvent;
+    static atomic<bool> sm_Recording;
+};
+
+vector<ProfileCapture::Event> ProfileCapture::sm_Events;
+atomic<uint64_t> ProfileCapture::sm_NextEvent(0);
+atomic<bool> ProfileCapture::sm_Recording(false);
+
+bool ProfileCapture::Save( const wstring& FilePath )
+{
+    // Events still being written by other threads would be torn
+    ASSERT(!sm_Recording, "Stop the capture before saving it");
+
+    FILE* TraceFile = nullptr;
+    _wfopen_s(&TraceFile, FilePath.c_str(), L"wb");
+    if (TraceFile == nullptr)
+        return false;
+
+    uint64_t NumEvents = min<uint64_t>(sm_NextEvent, kCapacity);
+    uint64_t FirstEvent = sm_NextEvent - NumEvents;
+
+    int64_t BaseTick = INT64_MAX;
+    for (uint64_t i = FirstEvent; i < FirstEvent + NumEvents; ++i)
+        BaseTick = min(BaseTick, sm_Events[i % kCapacity].StartTick);
+
+    fprintf(TraceFile, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    fprintf(TraceFile, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"CPU\"}},\n");
+    fprintf(TraceFile, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":2,\"args\":{\"name\":\"GPU\"}}");
+
+    string Name;
+    for (uint64_t i = FirstEvent; i < FirstEvent + NumEvents; ++i)
+    {
+        const Event& E = sm_Events[i % kCapacity];
+
+        // Timer names are ASCII in practice, so anything else is replaced rather than encoded
+        Name.clear();
+        for (wchar_t Ch : *E.Name)
+        {
+            if (Ch == L'"' || Ch == L'\\')
+                Name.push_back('\\');
+            Name.push_back(Ch >= 0x20 && Ch < 0x7F ? (char)Ch : '?');
+        }
+
+        bool IsGpu = E.ThreadId == kGpuThreadId;
+        fprintf(TraceFile, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":%u,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+            Name.c_str(), IsGpu ? 2 : 1, IsGpu ? 0 : E.ThreadId,
+            1000000.0 * SystemTime::TicksToSeconds(E.StartTick - BaseTick),
+            1000000.0 * SystemTime::TicksToSeconds(E.EndTick - E.StartTick));
+    }
+
+    fprintf(TraceFile, "\n]}\n");
+    fclose(TraceFile);
+    return true;
+}
+
 class GpuTimer
 {
 public:
@@ -195,7 +312,9 @@ class NestedTimingTree
 {
 public:
     NestedTimingTree( const wstring& name, NestedTimingTree* parent = nullptr )
-        : m_Name(name), m_Parent(parent), m_IsExpanded(false), m_IsGraphed(false), m_GraphHandle(PERF_GRAPH_ERROR) {}
+        : m_Name(name), m_Parent(parent), m_IsExpanded(false), m_IsGraphed(false), m_GraphHandle(PERF_GRAPH_ERROR),
+        m_BarrierStart(), m_FrameBarriers(0), m_FrameEliminatedBarriers(0), m_FrameSplitBarriers(0), m_FrameDepthExits(0),
+        m_Barriers(0), m_EliminatedBarriers(0), m_SplitBarriers(0), m_DepthExits(0) {}
 
     NestedTimingTree* GetChild( const wstring& name )
     {
@@ -288,6 +407,7 @@ public:
             return;
 
         m_GpuTimer.Start(*Context);
+        m_BarrierStart = Context->GetBarrierStats();
 
         Context->PIXBeginEvent(m_Name.c_str());
     }
@@ -300,6 +420,13 @@ public:
 
         m_GpuTimer.Stop(*Context);
 
+        // Barriers still buffered at the end of a block are counted by the block that flushes them
+        const CommandContext::BarrierStats& Stats = Context->GetBarrierStats();
+        m_FrameBarriers += Stats.Submitted - m_BarrierStart.Submitted;
+        m_FrameEliminatedBarriers += Stats.Eliminated - m_BarrierStart.Eliminated;
+        m_FrameSplitBarriers += Stats.Split - m_BarrierStart.Split;
+        m_FrameDepthExits += Stats.DepthExits - m_BarrierStart.DepthExits;
+
         Context->PIXEndEvent();
     }
 
@@ -317,6 +444,21 @@ public:
         }
         m_CpuTime.RecordStat(FrameIndex, 1000.0f * (float)SystemTime::TimeBetweenTicks(m_StartTick, m_EndTick));
         m_GpuTime.RecordStat(FrameIndex, 1000.0f * m_GpuTimer.GetTime());
+        m_Barriers = m_FrameBarriers;
+        m_EliminatedBarriers = m_FrameEliminatedBarriers;
+        m_SplitBarriers = m_FrameSplitBarriers;
+        m_DepthExits = m_FrameDepthExits;
+        m_FrameBarriers = 0;
+        m_FrameEliminatedBarriers = 0;
+        m_FrameSplitBarriers = 0;
+        m_FrameDepthExits = 0;
+
+        int64_t GpuStartTick, GpuEndTick;
+        if (ProfileCapture::IsRecording() && this != &sm_RootScope &&
+            GpuTimeManager::GetTimeStamps(m_GpuTimer.GetTimerIndex(), GpuStartTick, GpuEndTick))
+        {
+            ProfileCapture::RecordGpuScope(m_Name, GpuStartTick, GpuEndTick);
+        }
 
         for (auto node : m_Children)
             node->GatherTimes(FrameIndex);
@@ -325,12 +467,30 @@ public:
         m_EndTick = 0;
     }
 
+    // Scopes merged from the thread-local event rings only have a CPU time, which is summed over every thread
+    // that ran them during the frame
+    void SetCpuTicks( int64_t Ticks )
+    {
+        m_StartTick = 0;
+        m_EndTick = Ticks;
+    }
+
+    // Worker thread scopes are grouped under their own node, which is left out of the frame's CPU total
+    static NestedTimingTree* GetThreadScopes( void )
+    {
+        if (sm_ThreadScopes == nullptr)
+            sm_ThreadScopes = sm_RootScope.GetChild(L"Thread Scopes");
+        return sm_ThreadScopes;
+    }
+
     void SumInclusiveTimes(float& cpuTime, float& gpuTime)
     {
         cpuTime = 0.0f;
         gpuTime = 0.0f;
         for (auto iter = m_Children.begin(); iter != m_Children.end(); ++iter)
         {
+            if (*iter == sm_ThreadScopes)
+                continue;
             cpuTime += (*iter)->m_CpuTime.GetLast();
             gpuTime += (*iter)->m_GpuTime.GetLast();
         }
@@ -356,9 +516,17 @@ public:
         GraphRenderer::Update(XMFLOAT2(TotalCpuTime, TotalGpuTime), 0, GraphType::Global);
     }
 
+    static void VisitLastTimes( const EngineProfiling::ScopeTimeVisitor& Visitor )
+    {
+        for (auto node : sm_RootScope.m_Children)
+            node->VisitLastTimes(node->m_Name, Visitor);
+    }
+
     static float GetTotalCpuTime(void) { return s_TotalCpuTime.GetAvg(); }
     static float GetTotalGpuTime(void) { return s_TotalGpuTime.GetAvg(); }
     static float GetFrameDelta(void) { return s_FrameDelta.GetAvg(); }
+    static float GetLastGpuTime(void) { return s_TotalGpuTime.GetLast(); }
+    static float GetLastFrameDelta(void) { return s_FrameDelta.GetLast(); }
 
     static void Display( TextContext& Text, float x )
     {
@@ -382,6 +550,12 @@ private:
 
     void DisplayNode( TextContext& Text, float x, float indent );
     void StoreToGraph(void);
+    void VisitLastTimes( const wstring& Path, const EngineProfiling::ScopeTimeVisitor& Visitor ) const
+    {
+        Visitor(Path, m_CpuTime.GetLast(), m_GpuTime.GetLast());
+        for (auto node : m_Children)
+            node->VisitLastTimes(Path + L"/" + node->m_Name, Visitor);
+    }
     void DeleteChildren( void )
     {
         for (auto node : m_Children)
@@ -397,6 +571,15 @@ private:
     int64_t m_EndTick;
     StatHistory m_CpuTime;
     StatHistory m_GpuTime;
+    CommandContext::BarrierStats m_BarrierStart;
+    uint32_t m_FrameBarriers;
+    uint32_t m_FrameEliminatedBarriers;
+    uint32_t m_FrameSplitBarriers;
+    uint32_t m_FrameDepthExits;
+    uint32_t m_Barriers;                // Submitted during the last frame
+    uint32_t m_EliminatedBarriers;      // Removed by barrier batching during the last frame
+    uint32_t m_SplitBarriers;           // Halves of split barriers recorded during the last frame
+    uint32_t m_DepthExits;              // Depth buffers moved out of the depth states during the last frame
     bool m_IsExpanded;
     GpuTimer m_GpuTimer;
     bool m_IsGraphed;
@@ -407,6 +590,7 @@ private:
     static NestedTimingTree sm_RootScope;
     static NestedTimingTree* sm_CurrentNode;
     static NestedTimingTree* sm_SelectedScope;
+    static NestedTimingTree* sm_ThreadScopes;
 
     static bool sm_CursorOnGraph;
 
@@ -418,13 +602,215 @@ StatHistory NestedTimingTree::s_FrameDelta;
 NestedTimingTree NestedTimingTree::sm_RootScope(L"");
 NestedTimingTree* NestedTimingTree::sm_CurrentNode = &NestedTimingTree::sm_RootScope;
 NestedTimingTree* NestedTimingTree::sm_SelectedScope = &NestedTimingTree::sm_RootScope;
+NestedTimingTree* NestedTimingTree::sm_ThreadScopes = nullptr;
 bool NestedTimingTree::sm_CursorOnGraph = false;
+
+// The fast scope path.  Every thread appends begin and end events to its own ring, which only that thread writes
+// and only the main thread reads, so recording a scope is a clock read and two stores with no locks or atomic
+// read-modify-writes.  Scope names are interned up front so that events carry a small id instead of a string.
+// Once per frame the rings are drained, begin and end events are paired up, and the times are summed by name.
+class ThreadScopes
+{
+public:
+    static uint32_t RegisterName( const wchar_t* Name )
+    {
+        lock_guard<mutex> Guard(sm_Mutex);
+
+        auto iter = sm_NameLUT.find(Name);
+        if (iter != sm_NameLUT.end())
+            return iter->second;
+
+        uint32_t NameId = sm_NumNames;
+        ASSERT(NameId < kMaxNames, "Too many profiling scope names");
+        sm_Names[NameId] = Name;
+        sm_NameLUT[Name] = NameId;
+        sm_NumNames = NameId + 1;
+        return NameId;
+    }
+
+    static void Begin( uint32_t NameId )
+    {
+        EventRing& Ring = GetRing();
+
+        // Every open scope has space reserved for its end event, so a scope is either dropped whole or not at
+        // all.  Once one is dropped, everything nested inside it is too.
+        uint32_t WriteIdx = Ring.WriteIdx.load(memory_order_relaxed);
+        if (Ring.DroppedDepth > 0 ||
+            WriteIdx - Ring.ReadIdx.load(memory_order_acquire) + Ring.OpenScopes + 2 > kRingSize)
+        {
+            ++Ring.DroppedDepth;
+            return;
+        }
+
+        ++Ring.OpenScopes;
+        Ring.Events[WriteIdx % kRingSize] = { SystemTime::GetCurrentTick(), NameId, 1 };
+        Ring.WriteIdx.store(WriteIdx + 1, memory_order_release);
+    }
+
+    static void End( void )
+    {
+        int64_t Tick = SystemTime::GetCurrentTick();
+        EventRing& Ring = GetRing();
+
+        if (Ring.DroppedDepth > 0)
+        {
+            --Ring.DroppedDepth;
+            return;
+        }
+
+        ASSERT(Ring.OpenScopes > 0, "Unbalanced profiling scopes");
+        --Ring.OpenScopes;
+        uint32_t WriteIdx = Ring.WriteIdx.load(memory_order_relaxed);
+        Ring.Events[WriteIdx % kRingSize] = { Tick, 0, 0 };
+        Ring.WriteIdx.store(WriteIdx + 1, memory_order_release);
+    }
+
+    // Called once per frame on the main thread, before the timing tree gathers its times
+    static void Merge( void )
+    {
+        {
+            lock_guard<mutex> Guard(sm_Mutex);
+            for (size_t i = sm_Consumers.size(); i < sm_Rings.size(); ++i)
+                sm_Consumers.push_back({ sm_Rings[i].get() });
+        }
+
+        for (Consumer& C : sm_Consumers)
+        {
+            EventRing& Ring = *C.Ring;
+            vector<ScopeEvent>& OpenScopes = C.OpenScopes;
+
+            uint32_t ReadIdx = Ring.ReadIdx.load(memory_order_relaxed);
+            uint32_t WriteIdx = Ring.WriteIdx.load(memory_order_acquire);
+
+            for (; ReadIdx != WriteIdx; ++ReadIdx)
+            {
+                const ScopeEvent& E = Ring.Events[ReadIdx % kRingSize];
+                if (E.IsBegin)
+                {
+                    OpenScopes.push_back(E);
+                    continue;
+                }
+
+                ASSERT(!OpenScopes.empty(), "Corrupted profiling event ring");
+                const ScopeEvent& BeginEvent = OpenScopes.back();
+                if (BeginEvent.NameId >= sm_FrameTicks.size())
+                {
+                    sm_FrameTicks.resize(BeginEvent.NameId + 1, 0);
+                    sm_Nodes.resize(BeginEvent.NameId + 1, nullptr);
+                }
+                sm_FrameTicks[BeginEvent.NameId] += E.Tick - BeginEvent.Tick;
+                ProfileCapture::RecordCpuScope(sm_Names[BeginEvent.NameId], BeginEvent.Tick, E.Tick, Ring.ThreadId);
+                OpenScopes.pop_back();
+            }
+
+            Ring.ReadIdx.store(ReadIdx, memory_order_release);
+        }
+
+        if (sm_FrameTicks.empty())
+            return;
+
+        NestedTimingTree* Parent = NestedTimingTree::GetThreadScopes();
+        int64_t TotalTicks = 0;
+
+        for (uint32_t NameId = 0; NameId < sm_FrameTicks.size(); ++NameId)
+        {
+            if (sm_Nodes[NameId] == nullptr)
+            {
+                if (sm_FrameTicks[NameId] == 0)
+                    continue;
+                sm_Nodes[NameId] = Parent->GetChild(sm_Names[NameId]);
+            }
+
+            sm_Nodes[NameId]->SetCpuTicks(sm_FrameTicks[NameId]);
+            TotalTicks += sm_FrameTicks[NameId];
+            sm_FrameTicks[NameId] = 0;
+        }
+
+        Parent->SetCpuTicks(TotalTicks);
+    }
+
+private:
+    struct ScopeEvent
+    {
+        int64_t Tick;
+        uint32_t NameId;
+        uint32_t IsBegin;
+    };
+
+    static const uint32_t kRingSize = 1 << 14;
+    static const uint32_t kMaxNames = 4096;
+
+    struct EventRing
+    {
+        ScopeEvent Events[kRingSize];
+        atomic<uint32_t> WriteIdx;
+        atomic<uint32_t> ReadIdx;
+        uint32_t ThreadId;
+
+        // Only touched by the owning thread
+        uint32_t OpenScopes;
+        uint32_t DroppedDepth;
+    };
+
+    // Scopes can stay open across frames, so their begin events are kept until the matching end arrives
+    struct Consumer
+    {
+        EventRing* Ring;
+        vector<ScopeEvent> OpenScopes;
+    };
+
+    // Rings are never freed, because a thread can exit with events that have not been merged yet
+    static EventRing& GetRing( void )
+    {
+        static thread_local EventRing* s_Ring = nullptr;
+        if (s_Ring == nullptr)
+        {
+            s_Ring = new EventRing;
+            s_Ring->WriteIdx = 0;
+            s_Ring->ReadIdx = 0;
+            s_Ring->ThreadId = GetCurrentThreadId();
+            s_Ring->OpenScopes = 0;
+            s_Ring->DroppedDepth = 0;
+
+            lock_guard<mutex> Guard(sm_Mutex);
+            sm_Rings.push_back(unique_ptr<EventRing>(s_Ring));
+        }
+        return *s_Ring;
+    }
+
+    static mutex sm_Mutex;
+    static vector<unique_ptr<EventRing>> sm_Rings;
+    static wstring sm_Names[kMaxNames];
+    static unordered_map<wstring, uint32_t> sm_NameLUT;
+    static uint32_t sm_NumNames;
+
+    // Main thread only
+    static vector<Consumer> sm_Consumers;
+    static vector<int64_t> sm_FrameTicks;
+    static vector<NestedTimingTree*> sm_Nodes;
+};
+
+mutex ThreadScopes::sm_Mutex;
+vector<unique_ptr<ThreadScopes::EventRing>> ThreadScopes::sm_Rings;
+wstring ThreadScopes::sm_Names[ThreadScopes::kMaxNames];
+unordered_map<wstring, uint32_t> ThreadScopes::sm_NameLUT;
+uint32_t ThreadScopes::sm_NumNames = 0;
+vector<ThreadScopes::Consumer> ThreadScopes::sm_Consumers;
+vector<int64_t> ThreadScopes::sm_FrameTicks;
+vector<NestedTimingTree*> ThreadScopes::sm_Nodes;
 namespace EngineProfiling
 {
     BoolVar DrawFrameRate("Display Frame Rate", true);
     BoolVar DrawProfiler("Display Profiler", false);
     //BoolVar DrawPerfGraph("Display Performance Graph", false);
     const bool DrawPerfGraph = false;
+
+    CallbackTrigger StartCaptureTrigger("Profile Capture/Start", [](void*) { StartCapture(); });
+    CallbackTrigger SaveCaptureTrigger("Profile Capture/Stop and Save", [](void*)
+    {
+        StopCapture();
+        SaveCapture(L"ProfileCapture.json");
+    });
     
     void Update( void )
     {
@@ -433,7 +819,15 @@ namespace EngineProfiling
         {
             Paused = !Paused;
         }
+        ThreadScopes::Merge();
         NestedTimingTree::UpdateTimes();
+
+        // Frames show up as their own scope so that hitches are easy to find
+        static const wstring s_FrameName(L"Frame");
+        static int64_t s_FrameStartTick = SystemTime::GetCurrentTick();
+        int64_t FrameEndTick = SystemTime::GetCurrentTick();
+        ProfileCapture::RecordCpuScope(s_FrameName, s_FrameStartTick, FrameEndTick);
+        s_FrameStartTick = FrameEndTick;
     }
 
     void BeginBlock(const wstring& name, CommandContext* Context)
@@ -446,11 +840,71 @@ namespace EngineProfiling
         NestedTimingTree::PopProfilingMarker(Context);
     }
 
+    uint32_t RegisterScopeName(const wchar_t* Name)
+    {
+        return ThreadScopes::RegisterName(Name);
+    }
+
+    void BeginScope(uint32_t NameId)
+    {
+        ThreadScopes::Begin(NameId);
+    }
+
+    void EndScope()
+    {
+        ThreadScopes::End();
+    }
+
     bool IsPaused()
     {
         return Paused;
     }
 
+    float GetGpuFrameTime()
+    {
+        // Without timed scopes (e.g. in release builds) fall back on the interval between frames on the GPU
+        float GpuTime = NestedTimingTree::GetLastGpuTime();
+        return GpuTime > 0.0f ? GpuTime : 1000.0f * NestedTimingTree::GetLastFrameDelta();
+    }
+
+    void ForEachScopeTime(const ScopeTimeVisitor& Visitor)
+    {
+        NestedTimingTree::VisitLastTimes(Visitor);
+    }
+
+    void SetCounter(const wchar_t* Name, uint32_t Value)
+    {
+        for (auto& Counter : s_Counters)
+        {
+            if (Counter.first == Name)
+            {
+                Counter.second = Value;
+                return;
+            }
+        }
+        s_Counters.emplace_back(Name, Value);
+    }
+
+    void StartCapture()
+    {
+        ProfileCapture::Start();
+    }
+
+    void StopCapture()
+    {
+        ProfileCapture::Stop();
+    }
+
+    bool IsCapturing()
+    {
+        return ProfileCapture::IsRecording();
+    }
+
+    bool SaveCapture( const wstring& FilePath )
+    {
+        return ProfileCapture::Save(FilePath);
+    }
+
     void DisplayFrameRate( TextContext& Text )
     {
         if (!DrawFrameRate)
@@ -460,8 +914,14 @@ namespace EngineProfiling
         float gpuTime = NestedTimingTree::GetTotalGpuTime();
         float frameRate = 1.0f / NestedTimingTree::GetFrameDelta();
 
-        Text.DrawFormattedString( "CPU %7.3f ms, GPU %7.3f ms, %3u Hz\n",
+        Text.DrawFormattedString( "CPU %7.3f ms, GPU %7.3f ms, %3u Hz",
             cpuTime, gpuTime, (uint32_t)(frameRate + 0.5f));
+
+        float latency = Graphics::GetPresentLatency();
+        if (latency > 0.0f)
+            Text.DrawFormattedString( ", Latency %7.3f ms", latency * 1000.0f );
+
+        Text.DrawString( "\n" );
     }
 
     void DisplayPerfGraph( GraphicsContext& Context )
@@ -484,15 +944,34 @@ namespace EngineProfiling
             Text.DrawString("Engine Profiling");
             Text.SetColor(Color(0.8f, 0.8f, 0.8f));
             Text.SetTextSize(20.0f);
-            Text.DrawString("           CPU    GPU");
+            Text.DrawString("           CPU    GPU  Barriers (Merged) (Split) (Depth Exits)");
             Text.SetTextSize(24.0f);
             Text.NewLine();
             Text.SetTextSize(20.0f);
             Text.SetColor( Color(1.0f, 1.0f, 1.0f) );
 
             NestedTimingTree::Display( Text, x );
+
+            if (!s_Counters.empty())
+            {
+                Text.SetLeftMargin(x);
+                Text.SetCursorX(x);
+                Text.NewLine();
+                Text.SetColor( Color(0.5f, 1.0f, 1.0f) );
+                Text.DrawString("Counters\n");
+                Text.SetColor( Color(1.0f, 1.0f, 1.0f) );
+
+                for (auto& Counter : s_Counters)
+                {
+                    Text.DrawString("  ");
+                    Text.DrawString(Counter.first);
+                    Text.SetCursorX(x + 300.0f);
+                    Text.DrawFormattedString("%8u\n", Counter.second);
+                }
+            }
         }
 
+        Text.Flush();
         Text.GetCommandContext().SetScissor(0, 0, g_DisplayWidth, g_DisplayHeight);
     }
 
@@ -507,6 +986,7 @@ void NestedTimingTree::PushProfilingMarker( const wstring& name, CommandContext*
 void NestedTimingTree::PopProfilingMarker( CommandContext* Context )
 {
     sm_CurrentNode->StopTiming(Context);
+    ProfileCapture::RecordCpuScope(sm_CurrentNode->m_Name, sm_CurrentNode->m_StartTick, sm_CurrentNode->m_EndTick);
     sm_CurrentNode = sm_CurrentNode->m_Parent;
 }
 
@@ -585,7 +1065,8 @@ void NestedTimingTree::DisplayNode( TextContext& Text, float leftMargin, float i
 
         Text.DrawString(m_Name.c_str());
         Text.SetCursorX(leftMargin + 300.0f);
-        Text.DrawFormattedString("%6.3f %6.3f   ", m_CpuTime.GetAvg(), m_GpuTime.GetAvg());
+        Text.DrawFormattedString("%6.3f %6.3f %4u %4u %4u %4u   ", m_CpuTime.GetAvg(), m_GpuTime.GetAvg(),
+            m_Barriers, m_EliminatedBarriers, m_SplitBarriers, m_DepthExits);
 
         if (IsGraphed())
         {
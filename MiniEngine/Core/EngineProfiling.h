@@ -14,6 +14,7 @@
 #pragma once
 
 #include <string>
+#include <functional>
 #include "TextRenderer.h"
 
 class CommandContext;
@@ -25,10 +26,48 @@ namespace EngineProfiling
     void BeginBlock(const std::wstring& name, CommandContext* Context = nullptr);
     void EndBlock(CommandContext* Context = nullptr);
 
+    // BeginBlock() and EndBlock() build the nested timing tree and must be called from the main thread.  The
+    // scope functions below are a CPU-only path that is cheap enough for hot loops and safe on any thread.
+    // Events go into a per-thread ring and are merged once per frame by Update().  Names are interned once,
+    // usually through a function-local static (see PROFILE_SCOPE).
+    uint32_t RegisterScopeName(const wchar_t* Name);
+    void BeginScope(uint32_t NameId);
+    void EndScope();
+
+    class ScopeName
+    {
+    public:
+        explicit ScopeName(const wchar_t* Name) : m_NameId(RegisterScopeName(Name)) {}
+        uint32_t GetId() const { return m_NameId; }
+
+    private:
+        uint32_t m_NameId;
+    };
+
     void DisplayFrameRate(TextContext& Text);
     void DisplayPerfGraph(GraphicsContext& Text);
     void Display(TextContext& Text, float x, float y, float w, float h);
     bool IsPaused();
+
+    // The GPU time of the last frame read back, in milliseconds, summed over the timed scopes
+    float GetGpuFrameTime();
+
+    // Visits every timed scope with its CPU and GPU times of the last frame read back, in milliseconds.  Paths
+    // join the names of nested scopes with '/', e.g. "Render Scene/Main Render/Render Color".
+    typedef std::function<void (const std::wstring& Path, float CpuTime, float GpuTime)> ScopeTimeVisitor;
+    void ForEachScopeTime(const ScopeTimeVisitor& Visitor);
+
+    // Counters, such as the occupancy of GPU work queues, are listed below the timings in the order they were first
+    // set.  Values read back from the GPU are usually a few frames old.  Must be called from the main thread.
+    void SetCounter(const wchar_t* Name, uint32_t Value);
+
+    // Capture mode records every timed scope (CPU from all threads, and GPU) into a ring buffer, so that frame
+    // hitches can be analyzed offline.  The capture is saved in the Chrome trace event format, which opens in
+    // chrome://tracing and Perfetto and converts to a Tracy capture with Tracy's import-chrome tool.
+    void StartCapture();
+    void StopCapture();
+    bool IsCapturing();
+    bool SaveCapture(const std::wstring& FilePath);
 }
 
 #ifdef RELEASE
@@ -37,25 +76,43 @@ class ScopedTimer
 public:
     ScopedTimer(const std::wstring&) {}
     ScopedTimer(const std::wstring&, CommandContext&) {}
+    ScopedTimer(const EngineProfiling::ScopeName&) {}
 };
+
+#define PROFILE_SCOPE(Name)
 #else
 class ScopedTimer
 {
 public:
-    ScopedTimer( const std::wstring& name ) : m_Context(nullptr)
+    ScopedTimer( const std::wstring& name ) : m_Context(nullptr), m_IsThreadScope(false)
     {
         EngineProfiling::BeginBlock(name);
     }
-    ScopedTimer( const std::wstring& name, CommandContext& Context ) : m_Context(&Context)
+    ScopedTimer( const std::wstring& name, CommandContext& Context ) : m_Context(&Context), m_IsThreadScope(false)
     {
         EngineProfiling::BeginBlock(name, m_Context);
     }
+    ScopedTimer( const EngineProfiling::ScopeName& name ) : m_Context(nullptr), m_IsThreadScope(true)
+    {
+        EngineProfiling::BeginScope(name.GetId());
+    }
     ~ScopedTimer()
     {
-        EngineProfiling::EndBlock(m_Context);
+        if (m_IsThreadScope)
+            EngineProfiling::EndScope();
+        else
+            EngineProfiling::EndBlock(m_Context);
     }
 
 private:
     CommandContext* m_Context;
+    bool m_IsThreadScope;
 };
+
+// Times the rest of the enclosing block on the lock-free path, e.g. PROFILE_SCOPE(L"Sort Particles");
+#define PROFILE_SCOPE_CONCAT_(a, b) a##b
+#define PROFILE_SCOPE_CONCAT(a, b) PROFILE_SCOPE_CONCAT_(a, b)
+#define PROFILE_SCOPE(Name) \
+    static const EngineProfiling::ScopeName PROFILE_SCOPE_CONCAT(s_ScopeName, __LINE__)(Name); \
+    ScopedTimer PROFILE_SCOPE_CONCAT(ScopeTimer, __LINE__)(PROFILE_SCOPE_CONCAT(s_ScopeName, __LINE__))
 #endif
@@ -19,6 +19,8 @@
 #include "GraphicsCore.h"
 #include "CommandContext.h"
 #include "GraphRenderer.h"
+#include "EngineProfiling.h"
+#include "GpuMemory.h"
 
 using namespace std;
 using namespace Math;
@@ -43,6 +45,26 @@ namespace EngineTuning
 
     EngineVar* sm_SelectedVariable = nullptr;
     bool sm_IsVisible = false;
+
+    // Sweep state.  Like the rest of the registry, this is only touched from the main thread.
+    struct SweepState
+    {
+        EngineVar* Variable = nullptr;
+        FILE* CsvFile = nullptr;
+        string OriginalValue;
+        uint32_t FramesPerStep = 0;
+        uint32_t WarmupFrames = 0;
+        uint32_t FrameInStep = 0;
+        uint32_t NumSamples = 0;
+        float GpuSum, GpuMin, GpuMax, CpuSum;
+    };
+    SweepState s_Sweep;
+
+    IntVar SweepFramesPerStep("Engine Tuning/Sweep/Frames Per Step", 60, 1, 1000, 10);
+    IntVar SweepWarmupFrames("Engine Tuning/Sweep/Warmup Frames", 10, 0, 1000, 5);
+
+    void UpdateSweep( float frameTime );
+    void FinishSweep( void );
 }
 
 // Not open to the public.  Groups are auto-created when a tweaker's path includes the group name.
@@ -51,6 +73,16 @@ class VariableGroup : public EngineVar
 public:
     VariableGroup() : m_IsExpanded(false) {}
 
+    const string* FindChildName( const EngineVar* child ) const
+    {
+        for (auto iter = m_Children.begin(); iter != m_Children.end(); ++iter)
+        {
+            if (iter->second == child)
+                return &iter->first;
+        }
+        return nullptr;
+    }
+
     EngineVar* FindChild( const string& name )
     {
         auto iter = m_Children.find(name);
@@ -257,15 +289,37 @@ EngineVar* VariableGroup::PrevVariable( EngineVar* curVar )
 //=====================================================================================================================
 // EngineVar implementations
 
-EngineVar::EngineVar( void ) : m_GroupPtr(nullptr)
+EngineVar::EngineVar( void ) : m_GroupPtr(nullptr), m_ChangeCount(0)
 {
 }
 
-EngineVar::EngineVar( const std::string& path ) : m_GroupPtr(nullptr)
+EngineVar::EngineVar( const std::string& path ) : m_GroupPtr(nullptr), m_ChangeCount(0)
 {
     EngineTuning::RegisterVariable(path, *this);
 }
 
+void EngineVar::NotifyChanged( void )
+{
+    ++m_ChangeCount;
+    for (auto& Callback : m_ChangeCallbacks)
+        Callback(*this);
+}
+
+std::string EngineVar::GetPath( void ) const
+{
+    // Until EngineTuning::Initialize() places a variable in the graph, the path is unknown
+    std::string path;
+    const EngineVar* node = this;
+    while (node->m_GroupPtr != nullptr)
+    {
+        const std::string* name = node->m_GroupPtr->FindChildName(node);
+        ASSERT(name != nullptr);
+        path = path.empty() ? *name : *name + "/" + path;
+        node = node->m_GroupPtr;
+    }
+    return path;
+}
+
 
 EngineVar* EngineVar::NextVar( void )
 {
@@ -317,13 +371,19 @@ void BoolVar::SetValue(FILE* file, const std::string& setting)
     fscanf_s(file, pattern.c_str(), valstr, _countof(valstr));
 
     // Look for one of the many affirmations
-    m_Flag = (
+    Change(
         0 == _stricmp(valstr, "1") ||
         0 == _stricmp(valstr, "on") ||
         0 == _stricmp(valstr, "yes") ||
         0 == _stricmp(valstr, "true") );
 }
 
+bool BoolVar::SetFromString( const std::string& value )
+{
+    Change(value == "on");
+    return value == "on" || value == "off";
+}
+
 NumVar::NumVar( const std::string& path, float val, float minVal, float maxVal, float stepSize )
     : EngineVar(path)
 {
@@ -356,6 +416,31 @@ void NumVar::SetValue(FILE* file, const std::string& setting)
         *this = valueRead; 
 }
 
+bool NumVar::SetFromString( const std::string& value )
+{
+    float valueRead;
+    if (sscanf_s(value.c_str(), "%f", &valueRead) != 1)
+        return false;
+    *this = valueRead;
+    return true;
+}
+
+bool NumVar::SweepFirst( void )
+{
+    if (m_MinValue <= -FLT_MAX || m_MaxValue >= FLT_MAX || m_StepSize <= 0.0f)
+        return false;
+    Change(m_MinValue);
+    return true;
+}
+
+bool NumVar::SweepNext( void )
+{
+    if (m_Value >= m_MaxValue)
+        return false;
+    Increment();
+    return true;
+}
+
 #if _MSC_VER < 1800
 __forceinline float log2( float x ) { return log(x) / log(2.0f); }
 __forceinline float exp2( float x ) { return pow(2.0f, x); }
@@ -368,7 +453,7 @@ ExpVar::ExpVar( const std::string& path, float val, float minExp, float maxExp,
 
 ExpVar& ExpVar::operator=( float val )
 {
-    m_Value = Clamp(log2(val));
+    Change(Clamp(log2(val)));
     return *this;
 }
 
@@ -399,6 +484,15 @@ void ExpVar::SetValue(FILE* file, const std::string& setting)
         *this = valueRead;
 }
 
+bool ExpVar::SetFromString( const std::string& value )
+{
+    float valueRead;
+    if (sscanf_s(value.c_str(), "%f", &valueRead) != 1)
+        return false;
+    *this = valueRead;
+    return true;
+}
+
 IntVar::IntVar( const std::string& path, int32_t val, int32_t minVal, int32_t maxVal, int32_t stepSize )
     : EngineVar(path)
 {
@@ -430,6 +524,15 @@ void IntVar::SetValue(FILE* file, const std::string& setting)
         *this = valueRead;
 }
 
+bool IntVar::SetFromString( const std::string& value )
+{
+    int32_t valueRead;
+    if (sscanf_s(value.c_str(), "%d", &valueRead) != 1)
+        return false;
+    *this = valueRead;
+    return true;
+}
+
 
 EnumVar::EnumVar( const std::string& path, int32_t initialVal, int32_t listLength, const char** listLabels )
     : EngineVar(path)
@@ -465,7 +568,7 @@ void EnumVar::SetValue(FILE* file, const std::string& setting)
         {
             if (m_EnumLabels[i] == valueReadStr)
             {
-                m_Value = i;
+                Change(i);
                 break;
             }
         }
@@ -473,6 +576,19 @@ void EnumVar::SetValue(FILE* file, const std::string& setting)
 
 }
 
+bool EnumVar::SetFromString( const std::string& value )
+{
+    for (int32_t i = 0; i < m_EnumLength; ++i)
+    {
+        if (m_EnumLabels[i] == value)
+        {
+            Change(i);
+            return true;
+        }
+    }
+    return false;
+}
+
 CallbackTrigger::CallbackTrigger( const std::string& path, std::function<void (void*)> callback, void* args )
     : EngineVar(path)
 {
@@ -540,6 +656,8 @@ void HandleDigitalButtonPress( GameInput::DigitalInput button, float timeDelta,
 
 void EngineTuning::Update( float frameTime )
 {
+    UpdateSweep(frameTime);
+
     if (GameInput::IsFirstPressed( GameInput::kBackButton )
         || GameInput::IsFirstPressed( GameInput::kKey_back ))
         sm_IsVisible = !sm_IsVisible;
@@ -569,6 +687,115 @@ void EngineTuning::Update( float frameTime )
     {
         sm_SelectedVariable->Bang();
     }
+
+    if (GameInput::IsFirstPressed( GameInput::kYButton )
+        || GameInput::IsFirstPressed( GameInput::kKey_f5 ))
+    {
+        if (IsSweeping())
+            CancelSweep();
+        else
+            StartSweep(*sm_SelectedVariable, "EngineTuningSweep.csv", SweepFramesPerStep, SweepWarmupFrames);
+    }
+}
+
+bool EngineTuning::StartSweep( EngineVar& Var, const std::string& CsvFileName, uint32_t FramesPerStep, uint32_t WarmupFrames )
+{
+    if (IsSweeping() || dynamic_cast<VariableGroup*>(&Var) != nullptr)
+        return false;
+
+    ASSERT(FramesPerStep > 0);
+
+    string OriginalValue = Var.ToString();
+    if (!Var.SweepFirst())
+    {
+        Utility::Printf("Engine Tuning: \"%s\" can't be swept\n", Var.GetPath().c_str());
+        return false;
+    }
+
+    FILE* CsvFile = nullptr;
+    fopen_s(&CsvFile, CsvFileName.c_str(), "wb");
+    if (CsvFile == nullptr)
+    {
+        Var.SetFromString(OriginalValue);
+        Utility::Printf("Engine Tuning: unable to open \"%s\"\n", CsvFileName.c_str());
+        return false;
+    }
+
+    fprintf(CsvFile, "\"%s\",gpu_avg_ms,gpu_min_ms,gpu_max_ms,frame_avg_ms\r\n", Var.GetPath().c_str());
+
+    s_Sweep.Variable = &Var;
+    s_Sweep.CsvFile = CsvFile;
+    s_Sweep.OriginalValue = OriginalValue;
+    s_Sweep.FramesPerStep = FramesPerStep;
+    s_Sweep.WarmupFrames = WarmupFrames;
+    s_Sweep.FrameInStep = 0;
+    s_Sweep.NumSamples = 0;
+
+    Utility::Printf("Engine Tuning: sweeping \"%s\" into %s\n", Var.GetPath().c_str(), CsvFileName.c_str());
+    return true;
+}
+
+void EngineTuning::CancelSweep( void )
+{
+    if (IsSweeping())
+    {
+        Utility::Printf("Engine Tuning: sweep cancelled\n");
+        FinishSweep();
+    }
+}
+
+bool EngineTuning::IsSweeping( void )
+{
+    return s_Sweep.Variable != nullptr;
+}
+
+void EngineTuning::UpdateSweep( float frameTime )
+{
+    if (!IsSweeping())
+        return;
+
+    // The GPU time lags the CPU by a few frames, which the warmup also covers
+    if (s_Sweep.FrameInStep++ >= s_Sweep.WarmupFrames)
+    {
+        float GpuTime = EngineProfiling::GetGpuFrameTime();
+        float CpuTime = frameTime * 1000.0f;
+
+        if (s_Sweep.NumSamples++ == 0)
+        {
+            s_Sweep.GpuSum = s_Sweep.GpuMin = s_Sweep.GpuMax = GpuTime;
+            s_Sweep.CpuSum = CpuTime;
+        }
+        else
+        {
+            s_Sweep.GpuSum += GpuTime;
+            s_Sweep.GpuMin = min(s_Sweep.GpuMin, GpuTime);
+            s_Sweep.GpuMax = max(s_Sweep.GpuMax, GpuTime);
+            s_Sweep.CpuSum += CpuTime;
+        }
+    }
+
+    if (s_Sweep.NumSamples < s_Sweep.FramesPerStep)
+        return;
+
+    fprintf(s_Sweep.CsvFile, "\"%s\",%f,%f,%f,%f\r\n", s_Sweep.Variable->ToString().c_str(),
+        s_Sweep.GpuSum / s_Sweep.NumSamples, s_Sweep.GpuMin, s_Sweep.GpuMax, s_Sweep.CpuSum / s_Sweep.NumSamples);
+
+    s_Sweep.FrameInStep = 0;
+    s_Sweep.NumSamples = 0;
+
+    if (!s_Sweep.Variable->SweepNext())
+    {
+        Utility::Printf("Engine Tuning: sweep complete\n");
+        FinishSweep();
+    }
+}
+
+void EngineTuning::FinishSweep( void )
+{
+    fclose(s_Sweep.CsvFile);
+    s_Sweep.Variable->SetFromString(s_Sweep.OriginalValue);
+    s_Sweep.Variable = nullptr;
+    s_Sweep.CsvFile = nullptr;
 }
 
 void StartSave(void*)
@@ -606,6 +833,7 @@ void EngineTuning::Display( GraphicsContext& Context, float x, float y, float w,
     Text.Begin();
 
     EngineProfiling::DisplayFrameRate(Text);
+    GpuMemory::Display(Text);
 
     Text.ResetCursor( x, y );
 
@@ -621,6 +849,7 @@ void EngineTuning::Display( GraphicsContext& Context, float x, float y, float w,
     float hScale = g_DisplayWidth / 1920.0f;
     float vScale = g_DisplayHeight / 1080.0f;
 
+    Text.Flush();
     Context.SetScissor((uint32_t)Floor(x * hScale), (uint32_t)Floor(y * vScale), 
         (uint32_t)Ceiling((x + w) * hScale), (uint32_t)Ceiling((y + h) * vScale));
 
@@ -631,6 +860,7 @@ void EngineTuning::Display( GraphicsContext& Context, float x, float y, float w,
 
     VariableGroup::sm_RootGroup.Display( Text, x, sm_SelectedVariable );
     
+    Text.Flush();
     EngineProfiling::DisplayPerfGraph(Context);
 
     Text.End();
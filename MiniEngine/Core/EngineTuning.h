@@ -18,6 +18,8 @@
 #include <float.h>
 #include <map>
 #include <set>
+#include <vector>
+#include <functional>
 
 class VariableGroup;
 class TextContext;
@@ -36,34 +38,61 @@ public:
     virtual std::string ToString( void ) const { return ""; }
     virtual void SetValue( FILE* file, const std::string& setting) = 0; //set value read from file
 
+    // Parses the format written by ToString().  Returns false if the string is not a valid value.
+    virtual bool SetFromString( const std::string& ) { return false; }
+
+    // Sweeping steps a variable through its whole range (see EngineTuning::StartSweep).  SweepFirst() sets
+    // the minimum and returns false if the variable can't be swept.  SweepNext() returns false at the end.
+    virtual bool SweepFirst( void ) { return false; }
+    virtual bool SweepNext( void ) { return false; }
+
     EngineVar* NextVar( void );
     EngineVar* PrevVar( void );
 
+    // Callbacks run on the thread that changed the value, right after the change.  Readers that poll can
+    // compare change counts instead.
+    typedef std::function<void (EngineVar&)> ChangeCallback;
+    void AddChangeCallback( const ChangeCallback& Callback ) { m_ChangeCallbacks.push_back(Callback); }
+    uint32_t GetChangeCount( void ) const { return m_ChangeCount; }
+
+    // The path the variable was registered with, e.g. "Graphics/Display/Enable VSync"
+    std::string GetPath( void ) const;
+
 protected:
     EngineVar( void );
     EngineVar( const std::string& path );
 
+    void NotifyChanged( void );
+
 private:
     friend class VariableGroup;
     VariableGroup* m_GroupPtr;
+    uint32_t m_ChangeCount;
+    std::vector<ChangeCallback> m_ChangeCallbacks;
 };
 
 class BoolVar : public EngineVar
 {
 public:
     BoolVar( const std::string& path, bool val );
-    BoolVar& operator=( bool val ) { m_Flag = val; return *this; }
+    BoolVar& operator=( bool val ) { Change(val); return *this; }
     operator bool() const { return m_Flag; }
 
-    virtual void Increment( void ) override { m_Flag = true; }
-    virtual void Decrement( void ) override { m_Flag = false; }
-    virtual void Bang( void ) override { m_Flag = !m_Flag; }
+    virtual void Increment( void ) override { Change(true); }
+    virtual void Decrement( void ) override { Change(false); }
+    virtual void Bang( void ) override { Change(!m_Flag); }
 
     virtual void DisplayValue( TextContext& Text ) const override;
     virtual std::string ToString( void ) const override;
     virtual void SetValue( FILE* file, const std::string& setting) override;
+    virtual bool SetFromString( const std::string& value ) override;
+
+    virtual bool SweepFirst( void ) override { Change(false); return true; }
+    virtual bool SweepNext( void ) override { if (m_Flag) return false; Change(true); return true; }
 
 private:
+    void Change( bool val ) { if (val != m_Flag) { m_Flag = val; NotifyChanged(); } }
+
     bool m_Flag;
 };
 
@@ -71,18 +100,24 @@ class NumVar : public EngineVar
 {
 public:
     NumVar( const std::string& path, float val, float minValue = -FLT_MAX, float maxValue = FLT_MAX, float stepSize = 1.0f );
-    NumVar& operator=( float val ) { m_Value = Clamp(val); return *this; }
+    NumVar& operator=( float val ) { Change(Clamp(val)); return *this; }
     operator float() const { return m_Value; }
 
-    virtual void Increment( void ) override { m_Value = Clamp(m_Value + m_StepSize); }
-    virtual void Decrement( void ) override { m_Value = Clamp(m_Value - m_StepSize); }
+    virtual void Increment( void ) override { Change(Clamp(m_Value + m_StepSize)); }
+    virtual void Decrement( void ) override { Change(Clamp(m_Value - m_StepSize)); }
 
     virtual void DisplayValue( TextContext& Text ) const override;
     virtual std::string ToString( void ) const override;
     virtual void SetValue( FILE* file, const std::string& setting)  override;
+    virtual bool SetFromString( const std::string& value ) override;
+
+    // Unbounded ranges can't be swept
+    virtual bool SweepFirst( void ) override;
+    virtual bool SweepNext( void ) override;
 
 protected:
     float Clamp( float val ) { return val > m_MaxValue ? m_MaxValue : val < m_MinValue ? m_MinValue : val; }
+    void Change( float val ) { if (val != m_Value) { m_Value = val; NotifyChanged(); } }
 
     float m_Value;
     float m_MinValue;
@@ -100,6 +135,7 @@ public:
     virtual void DisplayValue( TextContext& Text ) const override;
     virtual std::string ToString( void ) const override;
     virtual void SetValue( FILE* file, const std::string& setting ) override;
+    virtual bool SetFromString( const std::string& value ) override;
 
 };
 
@@ -107,18 +143,23 @@ class IntVar : public EngineVar
 {
 public:
     IntVar( const std::string& path, int32_t val, int32_t minValue = 0, int32_t maxValue = (1 << 24) - 1, int32_t stepSize = 1 );
-    IntVar& operator=( int32_t val ) { m_Value = Clamp(val); return *this; }
+    IntVar& operator=( int32_t val ) { Change(Clamp(val)); return *this; }
     operator int32_t() const { return m_Value; }
 
-    virtual void Increment( void ) override { m_Value = Clamp(m_Value + m_StepSize); }
-    virtual void Decrement( void ) override { m_Value = Clamp(m_Value - m_StepSize); }
+    virtual void Increment( void ) override { Change(Clamp(m_Value + m_StepSize)); }
+    virtual void Decrement( void ) override { Change(Clamp(m_Value - m_StepSize)); }
 
     virtual void DisplayValue( TextContext& Text ) const override;
     virtual std::string ToString( void ) const override;
     virtual void SetValue( FILE* file, const std::string& setting ) override;
+    virtual bool SetFromString( const std::string& value ) override;
+
+    virtual bool SweepFirst( void ) override { Change(m_MinValue); return true; }
+    virtual bool SweepNext( void ) override { if (m_Value >= m_MaxValue) return false; Increment(); return true; }
 
 protected:
     int32_t Clamp( int32_t val ) { return val > m_MaxValue ? m_MaxValue : val < m_MinValue ? m_MinValue : val; }
+    void Change( int32_t val ) { if (val != m_Value) { m_Value = val; NotifyChanged(); } }
 
     int32_t m_Value;
     int32_t m_MinValue;
@@ -130,20 +171,25 @@ class EnumVar : public EngineVar
 {
 public:
     EnumVar( const std::string& path, int32_t initialVal, int32_t listLength, const char** listLabels );
-    EnumVar& operator=( int32_t val ) { m_Value = Clamp(val); return *this; }
+    EnumVar& operator=( int32_t val ) { Change(Clamp(val)); return *this; }
     operator int32_t() const { return m_Value; }
 
-    virtual void Increment( void ) override { m_Value = (m_Value + 1) % m_EnumLength; }
-    virtual void Decrement( void ) override { m_Value = (m_Value + m_EnumLength - 1) % m_EnumLength; }
+    virtual void Increment( void ) override { Change((m_Value + 1) % m_EnumLength); }
+    virtual void Decrement( void ) override { Change((m_Value + m_EnumLength - 1) % m_EnumLength); }
 
     virtual void DisplayValue( TextContext& Text ) const override;
     virtual std::string ToString( void ) const override;
     virtual void SetValue( FILE* file, const std::string& setting ) override;
+    virtual bool SetFromString( const std::string& value ) override;
 
-    void SetListLength(int32_t listLength) { m_EnumLength = listLength; m_Value = Clamp(m_Value); }
+    virtual bool SweepFirst( void ) override { Change(0); return true; }
+    virtual bool SweepNext( void ) override { if (m_Value + 1 >= m_EnumLength) return false; Increment(); return true; }
+
+    void SetListLength(int32_t listLength) { m_EnumLength = listLength; Change(Clamp(m_Value)); }
 
 private:
     int32_t Clamp( int32_t val ) { return val < 0 ? 0 : val >= m_EnumLength ? m_EnumLength - 1 : val; }
+    void Change( int32_t val ) { if (val != m_Value) { m_Value = val; NotifyChanged(); } }
 
     int32_t m_Value;
     int32_t m_EnumLength;
@@ -175,4 +221,14 @@ namespace EngineTuning
     void Display( GraphicsContext& Context, float x, float y, float w, float h );
     bool IsFocused( void );
 
+    // Step a variable through its range, holding each value for FramesPerStep frames after WarmupFrames
+    // frames to settle.  The GPU and CPU frame times of every step are written to CsvFileName, and the
+    // variable is restored when done.  In the tuning menu, F5 or the Y button sweeps the selected variable
+    // or cancels the sweep in progress.
+    bool StartSweep( EngineVar& Var, const std::string& CsvFileName = "EngineTuningSweep.csv",
+        uint32_t FramesPerStep = 60, uint32_t WarmupFrames = 10 );
+    void CancelSweep( void );
+    bool IsSweeping( void );
+
+
 } // namespace EngineTuning
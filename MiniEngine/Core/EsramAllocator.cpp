@@ -0,0 +1,201 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Developed by Minigraph
+//
+
+#include "pch.h"
+#include "EsramAllocator.h"
+#include "ColorBuffer.h"
+#include "GpuBuffer.h"
+#include "CommandContext.h"
+#include "GraphicsCore.h"
+#include "GpuMemory.h"
+
+using namespace Graphics;
+
+void EsramAllocator::PushStack( uint32_t Phase )
+{
+    ASSERT(m_Heaps[kBufferHeap] == nullptr && m_Heaps[kTargetHeap] == nullptr, "Destroy the heaps before declaring new buffers");
+
+    Mark M;
+    M.Top[kBufferHeap] = m_Top[kBufferHeap];
+    M.Top[kTargetHeap] = m_Top[kTargetHeap];
+    M.Phase = m_Phase;
+    m_Stack.push_back(M);
+
+    m_Phase = Phase;
+}
+
+void EsramAllocator::PopStack( void )
+{
+    ASSERT(!m_Stack.empty(), "Unbalanced PopStack()");
+
+    const Mark& M = m_Stack.back();
+    m_Top[kBufferHeap] = M.Top[kBufferHeap];
+    m_Top[kTargetHeap] = M.Top[kTargetHeap];
+    m_Phase = M.Phase;
+    m_Stack.pop_back();
+}
+
+bool EsramAllocator::Place( Placement& P )
+{
+    if (m_Phase == kNoPhase)
+        return false;
+
+    if (P.Desc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER)
+        P.Heap = kBufferHeap;
+    else if (P.Desc.Flags & (D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET | D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL))
+        P.Heap = kTargetHeap;
+    else
+        return false;
+
+    // Don't leave the old resource around to be used by mistake before the heaps are finalized
+    P.Resource->Destroy();
+
+    D3D12_RESOURCE_ALLOCATION_INFO Info = g_Device->GetResourceAllocationInfo(0, 1, &P.Desc);
+
+    P.Phase = m_Phase;
+    P.Begin = Math::AlignUp(m_Top[P.Heap], (size_t)Info.Alignment);
+    P.End = P.Begin + Info.SizeInBytes;
+    P.Resident = false;
+
+#ifndef RELEASE
+    // Sibling scopes of one phase would be resident together while sharing memory
+    for (const Placement& Other : m_Placements)
+    {
+        ASSERT(Other.Phase != P.Phase || Other.Heap != P.Heap || Other.End <= P.Begin || P.End <= Other.Begin,
+            "Two scopes of the same phase overlap");
+    }
+#endif
+
+    m_Placements.push_back(P);
+
+    m_Top[P.Heap] = P.End;
+    m_PeakSize[P.Heap] = std::max(m_PeakSize[P.Heap], P.End);
+    m_UnaliasedSize += Info.SizeInBytes;
+    return true;
+}
+
+bool EsramAllocator::Place( ColorBuffer& Buffer, const D3D12_RESOURCE_DESC& Desc, const D3D12_CLEAR_VALUE& ClearValue,
+    const std::wstring& Name, uint32_t ArraySize, uint32_t NumMips )
+{
+    // Multisampled targets need a larger alignment than the heaps are created with
+    if (Desc.SampleDesc.Count > 1)
+        return false;
+
+    Placement P = {};
+    P.Resource = &Buffer;
+    P.Color = &Buffer;
+    P.Desc = Desc;
+    P.ClearValue = ClearValue;
+    P.Name = Name;
+    P.ArraySize = ArraySize;
+    P.NumMips = NumMips;
+    return Place(P);
+}
+
+bool EsramAllocator::Place( GpuBuffer& Buffer, const D3D12_RESOURCE_DESC& Desc, const std::wstring& Name,
+    uint32_t NumElements, uint32_t ElementSize )
+{
+    Placement P = {};
+    P.Resource = &Buffer;
+    P.Buffer = &Buffer;
+    P.Desc = Desc;
+    P.Name = Name;
+    P.ArraySize = NumElements;
+    P.NumMips = ElementSize;
+    return Place(P);
+}
+
+void EsramAllocator::Finalize( const std::wstring& Name )
+{
+    ASSERT(m_Stack.empty(), "Unbalanced PushStack()");
+
+    static const D3D12_HEAP_FLAGS kHeapFlags[kNumHeaps] =
+    {
+        D3D12_HEAP_FLAG_ALLOW_ONLY_BUFFERS,
+        D3D12_HEAP_FLAG_ALLOW_ONLY_RT_DS_TEXTURES
+    };
+
+    for (uint32_t i = 0; i < kNumHeaps; ++i)
+    {
+        ASSERT(m_Heaps[i] == nullptr);
+
+        if (m_PeakSize[i] == 0)
+            continue;
+
+        D3D12_HEAP_DESC HeapDesc = {};
+        HeapDesc.SizeInBytes = Math::AlignUp(m_PeakSize[i], D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT);
+        HeapDesc.Properties.Type = D3D12_HEAP_TYPE_DEFAULT;
+        HeapDesc.Alignment = D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
+        HeapDesc.Flags = kHeapFlags[i];
+
+        ASSERT_SUCCEEDED(g_Device->CreateHeap(&HeapDesc, MY_IID_PPV_ARGS(m_Heaps[i].ReleaseAndGetAddressOf())));
+        GpuMemory::Track(m_Heaps[i].Get(), GpuMemory::kHeaps);
+
+#ifndef RELEASE
+        m_Heaps[i]->SetName((Name + (i == kBufferHeap ? L" (Buffers)" : L" (Targets)")).c_str());
+#else
+        (Name);
+#endif
+    }
+
+    for (Placement& P : m_Placements)
+    {
+        ID3D12Heap* Heap = m_Heaps[P.Heap].Get();
+        if (P.Color != nullptr)
+            P.Color->CreatePlaced(Heap, P.Begin, P.Desc, P.ClearValue, P.Name, P.ArraySize, P.NumMips);
+        else
+            P.Buffer->CreatePlaced(P.Name, Heap, (uint32_t)P.Begin, P.ArraySize, P.NumMips);
+        P.Resident = false;
+    }
+}
+
+void EsramAllocator::Destroy( void )
+{
+    for (const Placement& P : m_Placements)
+        P.Resource->Destroy();
+
+    m_Placements.clear();
+    m_Stack.clear();
+    for (uint32_t i = 0; i < kNumHeaps; ++i)
+    {
+        m_Heaps[i] = nullptr;
+        m_Top[i] = 0;
+        m_PeakSize[i] = 0;
+    }
+    m_UnaliasedSize = 0;
+    m_Phase = kNoPhase;
+}
+
+void EsramAllocator::Acquire( CommandContext& Context, uint32_t Phase )
+{
+    for (Placement& P : m_Placements)
+    {
+        if (P.Phase != Phase || P.Resident)
+            continue;
+
+        // Nested scopes never overlap their parents, so this only evicts other phases
+        for (Placement& Other : m_Placements)
+        {
+            if (Other.Heap == P.Heap && Other.Begin < P.End && P.Begin < Other.End)
+                Other.Resident = false;
+        }
+        P.Resident = true;
+
+        Context.InsertAliasBarrier(*P.Resource);
+
+        // Newly aliased render targets have to be cleared, copied to, or discarded before anything else
+        if (P.Color != nullptr)
+        {
+            Context.TransitionResource(*P.Color, D3D12_RESOURCE_STATE_UNORDERED_ACCESS, true);
+            Context.GetCommandList()->DiscardResource(P.Color->GetResource(), nullptr);
+        }
+    }
+}
@@ -10,28 +10,96 @@
 //
 // Author:  James Stanard 
 //
+// Description:  A stack allocator for buffers that are scoped to a phase of the frame, in the manner of ESRAM
+// on Xbox One.  PushStack() marks the top of the stack and PopStack() returns to the mark, so scopes that are
+// siblings start at the same offset and share memory, while a nested scope lives above its parent.
+//
+// On PC the stack is carved out of placed heaps: one for buffers and one for render and depth targets, as
+// resource heap tier 1 requires.  Only scopes that name a phase are placed.  Everything else, and anything the
+// heaps can't hold, falls back on committed memory, which is the right place for buffers whose contents have
+// to outlive a phase.  Placements are recorded as buffers are created, and the heaps and resources are created
+// by Finalize() at exactly the peak depth of each stack.
+//
+// Acquire() aliases a phase's buffers back in before a pass touches them.  Their contents are undefined, and
+// whatever else occupied their memory is lost.  It costs nothing while the phase is already resident.
+//
 
 #pragma once
 
 #include "pch.h"
+#include <vector>
+
+class GpuResource;
+class ColorBuffer;
+class GpuBuffer;
+class CommandContext;
 
 class EsramAllocator
 {
 public:
-    EsramAllocator() {}
+    static const uint32_t kNoPhase = 0xFFFFFFFF;
+
+    EsramAllocator() : m_Phase(kNoPhase) { Destroy(); }
+    ~EsramAllocator() { Destroy(); }
+
+    // Scopes nest.  A scope that names a phase places its buffers, and nested scopes may name the same phase.
+    void PushStack( uint32_t Phase = kNoPhase );
+    void PopStack( void );
 
-    void PushStack() {}
-    void PopStack() {}
+    // Creates the heaps and every buffer that was placed.  The stack must be empty.
+    void Finalize( const std::wstring& Name );
 
-    D3D12_GPU_VIRTUAL_ADDRESS Alloc( size_t size, size_t align, const std::wstring& bufferName )
+    // Releases the heaps and every buffer placed in them
+    void Destroy( void );
+
+    // Make the phase's buffers the current occupants of their memory.  Color buffers are left in the unordered
+    // access state and discarded; buffers keep their state.
+    void Acquire( CommandContext& Context, uint32_t Phase );
+
+    // Returns false when the buffer should get committed memory instead.  The resource and its views don't
+    // exist until Finalize().
+    bool Place( ColorBuffer& Buffer, const D3D12_RESOURCE_DESC& Desc, const D3D12_CLEAR_VALUE& ClearValue,
+        const std::wstring& Name, uint32_t ArraySize, uint32_t NumMips );
+    bool Place( GpuBuffer& Buffer, const D3D12_RESOURCE_DESC& Desc, const std::wstring& Name,
+        uint32_t NumElements, uint32_t ElementSize );
+
+    // Total size of the heaps, and what the same buffers would have taken as committed resources
+    uint64_t GetHeapSize( void ) const { return m_PeakSize[kBufferHeap] + m_PeakSize[kTargetHeap]; }
+    uint64_t GetUnaliasedSize( void ) const { return m_UnaliasedSize; }
+
+private:
+    enum { kBufferHeap, kTargetHeap, kNumHeaps };
+
+    struct Placement
     {
-        (size); (align); (bufferName);
-        return D3D12_GPU_VIRTUAL_ADDRESS_UNKNOWN;
-    }
+        GpuResource* Resource;
+        ColorBuffer* Color;     // Exactly one of Color and Buffer is set
+        GpuBuffer* Buffer;
+        uint32_t Phase;
+        uint32_t Heap;
+        uint64_t Begin;
+        uint64_t End;
+        bool Resident;
+        D3D12_RESOURCE_DESC Desc;
+        D3D12_CLEAR_VALUE ClearValue;
+        std::wstring Name;
+        uint32_t ArraySize;     // Or the element count of a buffer
+        uint32_t NumMips;       // Or the element size of a buffer
+    };
 
-    intptr_t SizeOfFreeSpace( void ) const
+    struct Mark
     {
-        return 0;
-    }
+        uint64_t Top[kNumHeaps];
+        uint32_t Phase;
+    };
+
+    bool Place( Placement& P );
 
+    Microsoft::WRL::ComPtr<ID3D12Heap> m_Heaps[kNumHeaps];
+    std::vector<Placement> m_Placements;
+    std::vector<Mark> m_Stack;
+    uint64_t m_Top[kNumHeaps];
+    uint64_t m_PeakSize[kNumHeaps];
+    uint64_t m_UnaliasedSize;
+    uint32_t m_Phase;
 };
@@ -16,6 +16,10 @@
 #include "GraphicsCore.h"
 #include "BufferManager.h"
 #include "CommandContext.h"
+#include "CommandListManager.h"
+#include "ReadbackManager.h"
+#include "EngineProfiling.h"
+#include <atomic>
 
 #include "CompiledShaders/FXAAPass1_RGB_CS.h"
 #include "CompiledShaders/FXAAPass1_Luma_CS.h"
@@ -32,6 +36,9 @@
 #include "CompiledShaders/FXAAPass2HDebug2CS.h"
 #include "CompiledShaders/FXAAPass2VDebug2CS.h"
 
+#include "CompiledShaders/FXAAPass1_LumaTiled_CS.h"
+#include "CompiledShaders/FXAAPass1_LumaTiled2_CS.h"
+#include "CompiledShaders/FXAATileClassifyCS.h"
 #include "CompiledShaders/FXAAResolveWorkQueueCS.h"
 
 
@@ -42,6 +49,8 @@ namespace FXAA
     RootSignature RootSig;
     ComputePSO Pass1HdrCS;
     ComputePSO Pass1LdrCS;
+    ComputePSO Pass1HdrTiledCS;
+    ComputePSO TileClassifyCS;
     ComputePSO ResolveWorkCS;
     ComputePSO Pass2HCS;
     ComputePSO Pass2VCS;
@@ -61,13 +70,28 @@ namespace FXAA
     // This is for testing the performance of computing luma on the fly rather than reusing
     // the luma buffer output of tone mapping.
     BoolVar ForceOffPreComputedLuma("Graphics/AA/FXAA/Always Recompute Log-Luma", false);
+
+    // Run pass 1 only on the 8x8 tiles whose luma range reaches the contrast threshold.  This needs the luma
+    // buffer up front, because pass 2 reads luma well outside of the tiles holding edges.
+    BoolVar SkipFlatTiles("Graphics/AA/FXAA/Skip Flat Tiles", true);
+
+    // Report the number of queued tiles and edge pixels to the profiler.  Each frame reads back
+    // [ queued tiles, horizontal pixels, vertical pixels ] per screen quarter, and a worker totals them once
+    // the GPU has finished.  The next frame hands the totals to the profiler.
+    BoolVar ProfileQueues("Graphics/AA/FXAA/Profile Queues", false);
+    const uint32_t kStatSize = 4 * 3 * sizeof(uint32_t);
+    std::atomic<uint32_t> StatQueuedTiles, StatPixelsH, StatPixelsV;
+    std::atomic<bool> StatsReady(false);
+
+    void ReadQueueStats( const void* Data, size_t NumBytes );
+    void PublishQueueStats( void );
 }
 
 void FXAA::Initialize( void )
 {
     RootSig.Reset(3, 1);
     RootSig.InitStaticSampler(0, SamplerLinearClampDesc);
-    RootSig[0].InitAsConstants(0, 7);
+    RootSig[0].InitAsConstants(0, 8);
     RootSig[1].InitAsDescriptorRange(D3D12_DESCRIPTOR_RANGE_TYPE_UAV, 0, 5);
     RootSig[2].InitAsDescriptorRange(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 0, 6);
     RootSig.Finalize(L"FXAA");
@@ -78,10 +102,12 @@ void FXAA::Initialize( void )
     ObjName.Finalize();
 
     CreatePSO(ResolveWorkCS, g_pFXAAResolveWorkQueueCS);
+    CreatePSO(TileClassifyCS, g_pFXAATileClassifyCS);
     if (g_bTypedUAVLoadSupport_R11G11B10_FLOAT)
     {
         CreatePSO(Pass1LdrCS, g_pFXAAPass1_RGB2_CS);    // Use RGB and recompute log-luma; pre-computed luma is unavailable
         CreatePSO(Pass1HdrCS, g_pFXAAPass1_Luma2_CS);   // Use pre-computed luma
+        CreatePSO(Pass1HdrTiledCS, g_pFXAAPass1_LumaTiled2_CS);
         CreatePSO(Pass2HCS, g_pFXAAPass2H2CS);
         CreatePSO(Pass2VCS, g_pFXAAPass2V2CS);
         CreatePSO(Pass2HDebugCS, g_pFXAAPass2HDebug2CS);
@@ -91,6 +117,7 @@ void FXAA::Initialize( void )
     {
         CreatePSO(Pass1LdrCS, g_pFXAAPass1_RGB_CS);     // Use RGB and recompute log-luma; pre-computed luma is unavailable
         CreatePSO(Pass1HdrCS, g_pFXAAPass1_Luma_CS);    // Use pre-computed luma
+        CreatePSO(Pass1HdrTiledCS, g_pFXAAPass1_LumaTiled_CS);
         CreatePSO(Pass2HCS, g_pFXAAPass2HCS);
         CreatePSO(Pass2VCS, g_pFXAAPass2VCS);
         CreatePSO(Pass2HDebugCS, g_pFXAAPass2HDebugCS);
@@ -98,8 +125,9 @@ void FXAA::Initialize( void )
     }
 #undef CreatePSO
 
-    __declspec(align(16)) const uint32_t initArgs[6] = { 0, 1, 1, 0, 1, 1 };
-    IndirectParameters.Create(L"FXAA Indirect Parameters", 2, sizeof(D3D12_DISPATCH_ARGUMENTS), initArgs);
+    // Horizontal edges, vertical edges and tiles for pass 1
+    __declspec(align(16)) const uint32_t initArgs[9] = { 0, 1, 1, 0, 1, 1, 0, 1, 1 };
+    IndirectParameters.Create(L"FXAA Indirect Parameters", 3, sizeof(D3D12_DISPATCH_ARGUMENTS), initArgs);
 }
 
 void FXAA::Shutdown(void)
@@ -107,6 +135,35 @@ void FXAA::Shutdown(void)
     IndirectParameters.Destroy();
 }
 
+void FXAA::ReadQueueStats( const void* Data, size_t NumBytes )
+{
+    ASSERT(NumBytes == kStatSize);
+
+    const uint32_t* Stats = (const uint32_t*)Data;
+    uint32_t QueuedTiles = 0, PixelsH = 0, PixelsV = 0;
+    for (uint32_t Block = 0; Block < 4; ++Block, Stats += 3)
+    {
+        QueuedTiles += Stats[0];
+        PixelsH += Stats[1];
+        PixelsV += Stats[2];
+    }
+
+    StatQueuedTiles = QueuedTiles;
+    StatPixelsH = PixelsH;
+    StatPixelsV = PixelsV;
+    StatsReady.store(true, std::memory_order_release);
+}
+
+void FXAA::PublishQueueStats( void )
+{
+    if (!StatsReady.exchange(false, std::memory_order_acquire))
+        return;
+
+    EngineProfiling::SetCounter(L"FXAA Queued Tiles", StatQueuedTiles);
+    EngineProfiling::SetCounter(L"FXAA Horizontal Edge Pixels", StatPixelsH);
+    EngineProfiling::SetCounter(L"FXAA Vertical Edge Pixels", StatPixelsV);
+}
+
 void FXAA::Render( ComputeContext& Context, bool bUsePreComputedLuma )
 {
     ScopedTimer _prof(L"FXAA", Context);
@@ -114,6 +171,15 @@ void FXAA::Render( ComputeContext& Context, bool bUsePreComputedLuma )
     if (ForceOffPreComputedLuma)
         bUsePreComputedLuma = false;
 
+    PublishQueueStats();
+
+    // Skip profiling this frame if the readback ring is full
+    GpuResource* QueueStats = nullptr;
+    size_t StatOffset = 0;
+    bool bProfileQueues = ProfileQueues &&
+        ReadbackManager::Allocate(Context, kStatSize, &ReadQueueStats, QueueStats, StatOffset);
+    size_t StatEnd = StatOffset + kStatSize;
+
     ColorBuffer& Target = g_bTypedUAVLoadSupport_R11G11B10_FLOAT ? g_SceneColorBuffer : g_PostEffectsBuffer;
 
     Context.SetRootSignature(RootSig);
@@ -123,6 +189,9 @@ void FXAA::Render( ComputeContext& Context, bool bUsePreComputedLuma )
     // Apply algorithm to each quarter of the screen separately to reduce maximum size of work buffers.
     uint32_t BlockWidth = Target.GetWidth() / 2;
     uint32_t BlockHeight = Target.GetHeight() / 2;
+    uint32_t TilesX = Math::DivideByMultiple(BlockWidth, 8);
+    uint32_t TilesY = Math::DivideByMultiple(BlockHeight, 8);
+    Context.SetConstant(0, TilesX | TilesY << 16, 7);
 
     for (uint32_t x = 0; x < Target.GetWidth(); x += BlockWidth)
     {
@@ -132,6 +201,9 @@ void FXAA::Render( ComputeContext& Context, bool bUsePreComputedLuma )
             Context.SetConstant(0, x, 5);
             Context.SetConstant(0, y, 6);
 
+            // Odd sizes add a one pixel wide block at the edge, which is left out of the stats
+            bool bRecordStats = bProfileQueues && StatOffset < StatEnd;
+
             // Begin by analysing the luminance buffer and setting aside high-contrast pixels in
             // work queues to be processed later.  There are horizontal edge and vertical edge work
             // queues so that the shader logic is simpler for each type of edge.
@@ -155,22 +227,59 @@ void FXAA::Render( ComputeContext& Context, bool bUsePreComputedLuma )
                 g_LumaBuffer.GetSRV()
             };
 
-            if (bUsePreComputedLuma)
+            if (bUsePreComputedLuma && SkipFlatTiles)
             {
-                Context.SetPipelineState(Pass1HdrCS);
+                // Find the tiles with enough contrast and launch one pass 1 group for each of them.  A block
+                // without edges just gets an empty dispatch.
+                Context.SetPipelineState(TileClassifyCS);
                 Context.TransitionResource(g_LumaBuffer, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
-                Context.SetDynamicDescriptors(1, 0, _countof(Pass1UAVs) - 1, Pass1UAVs);
+                Context.TransitionResource(g_FXAATileQueue, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+                Context.ResetCounter(g_FXAATileQueue);
+                Context.SetDynamicDescriptor(1, 0, g_FXAATileQueue.GetUAV());
                 Context.SetDynamicDescriptors(2, 0, _countof(Pass1SRVs), Pass1SRVs);
+                Context.Dispatch2D(TilesX, TilesY);
+
+                Context.CopyCounter(IndirectParameters, 24, g_FXAATileQueue);
+                if (bRecordStats)
+                    Context.CopyCounter(*QueueStats, StatOffset, g_FXAATileQueue);
+                Context.TransitionResource(IndirectParameters, D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT);
+                Context.TransitionResource(g_FXAATileQueue, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+
+                Context.SetPipelineState(Pass1HdrTiledCS);
+                Context.SetDynamicDescriptors(1, 0, _countof(Pass1UAVs) - 1, Pass1UAVs);
+                Context.SetDynamicDescriptor(2, 2, g_FXAATileQueue.GetSRV());
+                Context.DispatchIndirect(IndirectParameters, 24);
             }
             else
             {
-                Context.SetPipelineState(Pass1LdrCS);
-                Context.TransitionResource(g_LumaBuffer, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
-                Context.SetDynamicDescriptors(1, 0, _countof(Pass1UAVs), Pass1UAVs);
-                Context.SetDynamicDescriptors(2, 0, _countof(Pass1SRVs) - 1, Pass1SRVs);
+                if (bUsePreComputedLuma)
+                {
+                    Context.SetPipelineState(Pass1HdrCS);
+                    Context.TransitionResource(g_LumaBuffer, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+                    Context.SetDynamicDescriptors(1, 0, _countof(Pass1UAVs) - 1, Pass1UAVs);
+                    Context.SetDynamicDescriptors(2, 0, _countof(Pass1SRVs), Pass1SRVs);
+                }
+                else
+                {
+                    Context.SetPipelineState(Pass1LdrCS);
+                    Context.TransitionResource(g_LumaBuffer, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+                    Context.SetDynamicDescriptors(1, 0, _countof(Pass1UAVs), Pass1UAVs);
+                    Context.SetDynamicDescriptors(2, 0, _countof(Pass1SRVs) - 1, Pass1SRVs);
+                }
+
+                Context.Dispatch2D(BlockWidth, BlockHeight);
+
+                if (bRecordStats)
+                    Context.FillBuffer(*QueueStats, StatOffset, TilesX * TilesY, sizeof(uint32_t));
             }
 
-            Context.Dispatch2D(BlockWidth, BlockHeight);
+            if (bRecordStats)
+            {
+                Context.TransitionResource(g_FXAAWorkCounters, D3D12_RESOURCE_STATE_COPY_SOURCE);
+                Context.CopyBufferRegion(*QueueStats, StatOffset + 4, g_FXAAWorkCounters, 0, 8);
+                Context.TransitionResource(g_FXAAWorkCounters, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+                StatOffset += 12;
+            }
 
             // Pass 2
 
@@ -15,6 +15,10 @@
 #include "FileUtility.h"
 #include <fstream>
 #include <mutex>
+#include <thread>
+#include <deque>
+#include <algorithm>
+#include <condition_variable>
 #include <zlib.h> // From NuGet package 
 
 using namespace std;
@@ -131,8 +135,390 @@ ByteArray Utility::ReadFileSync( const wstring& fileName)
     return ReadFileHelperEx(make_shared<wstring>(fileName));
 }
 
-task<ByteArray> Utility::ReadFileAsync(const wstring& fileName)
+task<ByteArray> Utility::ReadFileAsync(const wstring& fileName, FileIOPriority Priority)
 {
-    shared_ptr<wstring> SharedPtr = make_shared<wstring>(fileName);
-    return create_task( [=] { return ReadFileHelperEx(SharedPtr); } );
+    // Same preference for the zipped file as ReadFileHelperEx()
+    struct _stat64 fileStat;
+    wstring FilePath = fileName + L".gz";
+    const bool IsZipped = _wstat64(FilePath.c_str(), &fileStat) != -1;
+    if (!IsZipped)
+    {
+        FilePath = fileName;
+        if (_wstat64(FilePath.c_str(), &fileStat) == -1)
+            return task_from_result(NullFile);
+    }
+
+    ByteArray Contents = make_shared<vector<byte> >( (size_t)fileStat.st_size );
+    FileRange Range = { 0, Contents->size(), Contents->data() };
+
+    task_completion_event<bool> ReadDone;
+    ReadFileRangesAsync(FilePath, &Range, 1, Priority, [ReadDone](bool Succeeded) { ReadDone.set(Succeeded); });
+
+    return create_task(ReadDone).then([Contents, IsZipped, FilePath](bool Succeeded)
+    {
+        if (!Succeeded)
+            return NullFile;
+
+        if (!IsZipped)
+            return Contents;
+
+        int error;
+        ByteArray DecompressedFile = Inflate(Contents, error);
+        if (DecompressedFile->size() == 0)
+            Utility::Printf(L"Couldn't unzip file %s:  Error = %d\n", FilePath.c_str(), error);
+        return DecompressedFile;
+    });
+}
+
+namespace
+{
+    const size_t kMaxQueuedRequests = 256;
+    const size_t kMaxReadsInFlight = 32;
+
+    struct FileRead;
+
+    // One overlapped ReadFile().  The OVERLAPPED comes first so that a completion packet leads back to it.
+    struct RangeRead
+    {
+        OVERLAPPED Overlapped;
+        FileRead* Request;
+        size_t Range;
+    };
+
+    struct FileRead
+    {
+        FileIORequest Id;
+        wstring FileName;
+        vector<FileRange> Ranges;
+        vector<RangeRead> Reads;
+        FileIOCallback Callback;
+        HANDLE File;
+        size_t NextRange;       // The next one to issue
+        size_t NumInFlight;
+        bool Failed;            // Reads that haven't been issued never will be
+
+        bool IsDone(void) const { return NumInFlight == 0 && (Failed || NextRange == Ranges.size()); }
+    };
+
+    typedef vector< unique_ptr<FileRead> > FileReadList;
+
+    // All guarded by s_IOMutex
+    mutex s_IOMutex;
+    condition_variable s_QueueNotFull;
+    deque< unique_ptr<FileRead> > s_QueuedReads[kNumIOPriorities];
+    size_t s_NumQueuedReads = 0;
+    FileReadList s_ActiveReads;     // Started, with reads in flight or still to issue
+    size_t s_NumReadsInFlight = 0;
+    FileIORequest s_NextRequestId = 1;
+    bool s_IOStopping = false;
+
+    HANDLE s_CompletionPort = nullptr;
+    thread s_IOThread;
+    thread::id s_IOThreadId;
+
+    void RunCallbacks( FileReadList& Finished )
+    {
+        for (unique_ptr<FileRead>& Request : Finished)
+            Request->Callback(!Request->Failed);
+        Finished.clear();
+    }
+
+    void FinishActiveRead( FileRead* Request, FileReadList& Finished )
+    {
+        if (Request->File != INVALID_HANDLE_VALUE)
+            CloseHandle(Request->File);
+
+        auto Iter = find_if(s_ActiveReads.begin(), s_ActiveReads.end(),
+            [Request](const unique_ptr<FileRead>& Active) { return Active.get() == Request; });
+        ASSERT(Iter != s_ActiveReads.end());
+
+        Finished.push_back(move(*Iter));
+        s_ActiveReads.erase(Iter);
+    }
+
+    // Open the file of the most urgent queued request.  Returns null if there is none or it can't be opened.
+    FileRead* StartQueuedRead( FileReadList& Finished )
+    {
+        for (auto& Queue : s_QueuedReads)
+        {
+            if (Queue.empty())
+                continue;
+
+            s_ActiveReads.push_back(move(Queue.front()));
+            Queue.pop_front();
+            --s_NumQueuedReads;
+            s_QueueNotFull.notify_one();
+
+            FileRead* Request = s_ActiveReads.back().get();
+
+            CREATEFILE2_EXTENDED_PARAMETERS Params = { sizeof(Params) };
+            Params.dwFileAttributes = FILE_ATTRIBUTE_NORMAL;
+            Params.dwFileFlags = FILE_FLAG_OVERLAPPED;
+            Request->File = CreateFile2(Request->FileName.c_str(), GENERIC_READ, FILE_SHARE_READ, OPEN_EXISTING, &Params);
+
+            if (Request->File == INVALID_HANDLE_VALUE ||
+                CreateIoCompletionPort(Request->File, s_CompletionPort, 0, 0) == nullptr)
+            {
+                Request->Failed = true;
+                FinishActiveRead(Request, Finished);
+                return nullptr;
+            }
+
+            if (Request->IsDone())
+            {
+                FinishActiveRead(Request, Finished);
+                return nullptr;
+            }
+
+            return Request;
+        }
+
+        return nullptr;
+    }
+
+    // Keep as many reads in flight as allowed, finishing the requests oldest first
+    void IssueReads( FileReadList& Finished )
+    {
+        while (s_NumReadsInFlight < kMaxReadsInFlight)
+        {
+            auto Iter = find_if(s_ActiveReads.begin(), s_ActiveReads.end(), [](const unique_ptr<FileRead>& Request)
+                { return !Request->Failed && Request->NextRange < Request->Ranges.size(); });
+
+            FileRead* Request = nullptr;
+            if (Iter != s_ActiveReads.end())
+                Request = Iter->get();
+            else if (s_NumQueuedReads > 0 && !s_IOStopping)
+                Request = StartQueuedRead(Finished);
+            else
+                break;
+
+            if (Request == nullptr)
+                continue;
+
+            const size_t Index = Request->NextRange++;
+            const FileRange& Range = Request->Ranges[Index];
+            ASSERT(Range.Size <= MAXDWORD, "Ranges of 4GB or more must be split");
+
+            RangeRead& Read = Request->Reads[Index];
+            ZeroMemory(&Read.Overlapped, sizeof(OVERLAPPED));
+            Read.Overlapped.Offset = (DWORD)Range.Offset;
+            Read.Overlapped.OffsetHigh = (DWORD)(Range.Offset >> 32);
+            Read.Request = Request;
+            Read.Range = Index;
+
+            // Even reads that complete right away post a completion packet
+            if (ReadFile(Request->File, Range.Dest, (DWORD)Range.Size, nullptr, &Read.Overlapped) ||
+                GetLastError() == ERROR_IO_PENDING)
+            {
+                ++Request->NumInFlight;
+                ++s_NumReadsInFlight;
+            }
+            else
+            {
+                Request->Failed = true;
+                if (Request->IsDone())
+                    FinishActiveRead(Request, Finished);
+            }
+        }
+    }
+
+    void IOThreadMain( void )
+    {
+        FileReadList Finished;
+
+        while (true)
+        {
+            {
+                lock_guard<mutex> Guard(s_IOMutex);
+                if (s_IOStopping && s_ActiveReads.empty())
+                    return;
+
+                IssueReads(Finished);
+            }
+
+            RunCallbacks(Finished);
+
+            DWORD BytesRead = 0;
+            ULONG_PTR Key = 0;
+            OVERLAPPED* Overlapped = nullptr;
+            BOOL Succeeded = GetQueuedCompletionStatus(s_CompletionPort, &BytesRead, &Key, &Overlapped, INFINITE);
+
+            // Posted to wake the thread for new requests, cancellation or shutdown
+            if (Overlapped == nullptr)
+                continue;
+
+            RangeRead* Read = reinterpret_cast<RangeRead*>(Overlapped);
+            FileRead* Request = Read->Request;
+
+            lock_guard<mutex> Guard(s_IOMutex);
+
+            --Request->NumInFlight;
+            --s_NumReadsInFlight;
+
+            if (!Succeeded || BytesRead != Request->Ranges[Read->Range].Size)
+                Request->Failed = true;
+
+            if (Request->IsDone())
+                FinishActiveRead(Request, Finished);
+        }
+    }
+
+    void WakeIOThread( void )
+    {
+        PostQueuedCompletionStatus(s_CompletionPort, 0, 0, nullptr);
+    }
+}
+
+void Utility::InitializeFileIO( void )
+{
+    ASSERT(s_CompletionPort == nullptr, "File I/O is already running");
+
+    s_CompletionPort = CreateIoCompletionPort(INVALID_HANDLE_VALUE, nullptr, 0, 1);
+    ASSERT(s_CompletionPort != nullptr);
+
+    // The I/O thread takes the lock before anything else, so its callbacks see its ID
+    lock_guard<mutex> Guard(s_IOMutex);
+    s_IOStopping = false;
+    s_IOThread = thread(IOThreadMain);
+    s_IOThreadId = s_IOThread.get_id();
+}
+
+void Utility::ShutdownFileIO( void )
+{
+    if (s_CompletionPort == nullptr)
+        return;
+
+    FileReadList Cancelled;
+    {
+        lock_guard<mutex> Guard(s_IOMutex);
+        s_IOStopping = true;
+
+        for (auto& Queue : s_QueuedReads)
+        {
+            for (unique_ptr<FileRead>& Request : Queue)
+            {
+                Request->Failed = true;
+                Cancelled.push_back(move(Request));
+            }
+            Queue.clear();
+        }
+        s_NumQueuedReads = 0;
+
+        // Reads in flight still complete, with errors, and the I/O thread finishes their requests
+        for (size_t i = s_ActiveReads.size(); i-- > 0; )
+        {
+            FileRead* Request = s_ActiveReads[i].get();
+            Request->Failed = true;
+            if (Request->IsDone())
+                FinishActiveRead(Request, Cancelled);
+            else
+                CancelIoEx(Request->File, nullptr);
+        }
+    }
+
+    s_QueueNotFull.notify_all();
+    RunCallbacks(Cancelled);
+
+    WakeIOThread();
+    s_IOThread.join();
+    s_IOThreadId = thread::id();
+
+    CloseHandle(s_CompletionPort);
+    s_CompletionPort = nullptr;
+}
+
+FileIORequest Utility::ReadFileRangesAsync(const wstring& fileName, const FileRange* Ranges, size_t RangeCount,
+    FileIOPriority Priority, const FileIOCallback& Callback)
+{
+    ASSERT(Priority < kNumIOPriorities);
+
+    unique_ptr<FileRead> Request(new FileRead);
+    Request->FileName = fileName;
+    Request->Ranges.assign(Ranges, Ranges + RangeCount);
+    Request->Reads.resize(RangeCount);
+    Request->Callback = Callback;
+    Request->File = INVALID_HANDLE_VALUE;
+    Request->NextRange = 0;
+    Request->NumInFlight = 0;
+    Request->Failed = false;
+
+    unique_lock<mutex> Lock(s_IOMutex);
+
+    // Callbacks may queue follow-up reads, and the I/O thread must never wait on itself
+    if (this_thread::get_id() != s_IOThreadId)
+        s_QueueNotFull.wait(Lock, [] { return s_NumQueuedReads < kMaxQueuedRequests || s_IOStopping; });
+
+    if (s_CompletionPort == nullptr || s_IOStopping)
+    {
+        Lock.unlock();
+        Callback(false);
+        return 0;
+    }
+
+    const FileIORequest Id = s_NextRequestId++;
+    Request->Id = Id;
+    s_QueuedReads[Priority].push_back(move(Request));
+    ++s_NumQueuedReads;
+
+    Lock.unlock();
+    WakeIOThread();
+
+    return Id;
+}
+
+void Utility::CancelFileRead(FileIORequest Id)
+{
+    FileReadList Cancelled;
+    {
+        lock_guard<mutex> Guard(s_IOMutex);
+
+        for (auto& Queue : s_QueuedReads)
+        {
+            auto Iter = find_if(Queue.begin(), Queue.end(),
+                [Id](const unique_ptr<FileRead>& Request) { return Request->Id == Id; });
+            if (Iter == Queue.end())
+                continue;
+
+            (*Iter)->Failed = true;
+            Cancelled.push_back(move(*Iter));
+            Queue.erase(Iter);
+            --s_NumQueuedReads;
+            s_QueueNotFull.notify_one();
+            break;
+        }
+
+        auto Iter = find_if(s_ActiveReads.begin(), s_ActiveReads.end(),
+            [Id](const unique_ptr<FileRead>& Request) { return Request->Id == Id; });
+        if (Iter != s_ActiveReads.end())
+        {
+            FileRead* Request = Iter->get();
+            Request->Failed = true;
+            if (Request->IsDone())
+                FinishActiveRead(Request, Cancelled);
+            else
+                CancelIoEx(Request->File, nullptr);
+        }
+    }
+
+    RunCallbacks(Cancelled);
+}
+
+bool Utility::ReadFileRanges(const wstring& fileName, const FileRange* Ranges, size_t RangeCount,
+    FileIOPriority Priority)
+{
+    ASSERT(this_thread::get_id() != s_IOThreadId, "Blocking reads would deadlock the I/O thread");
+
+    HANDLE ReadDone = CreateEvent(nullptr, FALSE, FALSE, nullptr);
+    bool Succeeded = false;
+
+    ReadFileRangesAsync(fileName, Ranges, RangeCount, Priority, [&Succeeded, ReadDone](bool Result)
+    {
+        Succeeded = Result;
+        SetEvent(ReadDone);
+    });
+
+    WaitForSingleObject(ReadDone, INFINITE);
+    CloseHandle(ReadDone);
+
+    return Succeeded;
 }
@@ -16,6 +16,7 @@
 #include "pch.h"
 #include <vector>
 #include <string>
+#include <functional>
 #include <ppl.h>
 
 namespace Utility
@@ -26,12 +27,59 @@ namespace Utility
     typedef shared_ptr<vector<byte> > ByteArray;
     extern ByteArray NullFile;
 
+    // Asynchronous reads are serviced by a single I/O thread.  It keeps up to 32 overlapped reads in flight on a
+    // completion port and starts queued requests by priority, then in the order they were made.  Once 256 requests
+    // are waiting, further ones block the caller until one starts.  Callbacks run on the I/O thread, where they
+    // may queue more reads without blocking, but they must otherwise be short.
+    void InitializeFileIO(void);
+
+    // Cancels everything that hasn't been read yet and waits for the I/O thread to finish
+    void ShutdownFileIO(void);
+
+    enum FileIOPriority
+    {
+        kIOPriorityHigh,
+        kIOPriorityNormal,
+        kIOPriorityLow,
+        kNumIOPriorities
+    };
+
+    typedef uint64_t FileIORequest;
+
+    // Receives whether every range of the request was read in full
+    typedef function<void(bool)> FileIOCallback;
+
     // Reads the entire contents of a binary file.  If the file with the same name except with an additional
     // ".gz" suffix exists, it will be loaded and decompressed instead.
     // This operation blocks until the entire file is read.
     ByteArray ReadFileSync(const wstring& fileName);
 
-    // Same as previous except that it does not block but instead returns a task.
-    task<ByteArray> ReadFileAsync(const wstring& fileName);
+    // Same as previous except that it does not block but instead returns a task.  The file is read by the I/O
+    // thread and decompressed on the thread pool.
+    task<ByteArray> ReadFileAsync(const wstring& fileName, FileIOPriority Priority = kIOPriorityNormal);
+
+    // A byte range of a file and where to read it to
+    struct FileRange
+    {
+        uint64_t Offset;
+        size_t Size;
+        void* Dest;
+    };
+
+    // Reads several ranges of one file straight into caller memory, which may be a mapped upload heap, and calls
+    // back when they have all arrived.  The ranges are copied, but their destinations must stay valid until the
+    // callback runs.  There is no ".gz" fallback because compressed files can't be read in pieces.  A request
+    // that can't start, because the file can't be opened or the I/O thread isn't running, calls back with false.
+    FileIORequest ReadFileRangesAsync(const wstring& fileName, const FileRange* Ranges, size_t RangeCount,
+        FileIOPriority Priority, const FileIOCallback& Callback);
+
+    // Drops a queued request or aborts its reads in flight.  Either way its callback receives false, unless it
+    // has already run.
+    void CancelFileRead(FileIORequest Request);
+
+    // Same as ReadFileRangesAsync() except that it blocks until every read completes and returns whether they
+    // all succeeded.  Not to be called from an I/O callback.
+    bool ReadFileRanges(const wstring& fileName, const FileRange* Ranges, size_t RangeCount,
+        FileIOPriority Priority = kIOPriorityNormal);
 
 } // namespace Utility
@@ -19,6 +19,10 @@
 #include "BufferManager.h"
 #include "CommandContext.h"
 #include "PostEffects.h"
+#include "TextureManager.h"
+#include "JobSystem.h"
+#include "ShaderHotReload.h"
+#include "FileUtility.h"
 
 #if WINAPI_FAMILY_PARTITION(WINAPI_PARTITION_DESKTOP)
     #pragma comment(lib, "runtimeobject.lib")
@@ -31,6 +35,7 @@
     using Windows::ApplicationModel::Core::CoreApplicationView;
     using Windows::ApplicationModel::Activation::IActivatedEventArgs;
     using Windows::Foundation::TypedEventHandler;
+    using Windows::Foundation::EventHandler;
 #endif
 
 namespace Graphics
@@ -43,8 +48,50 @@ namespace GameCore
     using namespace Graphics;
     const bool TestGenerateMips = false;
 
+    // Frame pacing:  in low latency mode with VSync, the swap chain releases the CPU right after a vertical
+    // blank, but a frame that only needs part of the refresh interval would then wait for the next one with
+    // its input already old.  Instead, sleep until just enough time remains for the predicted CPU and GPU
+    // work of the frame.  The prediction rises with any slow frame and decays slowly, and the margin covers
+    // scheduler wake-up jitter.
+    BoolVar s_EnableFramePacing("Timing/Low Latency/Frame Pacing", true);
+    NumVar s_FramePacingMargin("Timing/Low Latency/Pacing Margin (ms)", 2.0f, 0.0f, 8.0f, 0.5f);
+    float s_PredictedFrameWork = 0.0f;
+
+    void PaceFrame( void )
+    {
+        Graphics::WaitForSwapChain();
+
+        if (!s_LowLatencyMode || !s_EnableFramePacing || !s_EnableVSync)
+            return;
+
+        float Slack = Graphics::GetFrameTime() - s_PredictedFrameWork - s_FramePacingMargin * 0.001f;
+        if (Slack <= 0.0f)
+            return;
+
+        // Sleep() is coarse, so sleep most of the way and spin the rest
+        int64_t WakeTick = SystemTime::GetCurrentTick();
+        if (Slack > 0.002f)
+            Sleep((DWORD)((Slack - 0.002f) * 1000.0f));
+        float Remaining = Slack - (float)SystemTime::TimeBetweenTicks(WakeTick, SystemTime::GetCurrentTick());
+        if (Remaining > 0.0f)
+            SystemTime::BusyLoopSleep(Remaining);
+    }
+
+    void UpdateFramePrediction( int64_t FrameStartTick )
+    {
+        float CpuTime = (float)SystemTime::TimeBetweenTicks(FrameStartTick, SystemTime::GetCurrentTick());
+        float FrameWork = CpuTime + EngineProfiling::GetGpuFrameTime() * 0.001f;
+
+        if (FrameWork > s_PredictedFrameWork)
+            s_PredictedFrameWork = FrameWork;
+        else
+            s_PredictedFrameWork += (FrameWork - s_PredictedFrameWork) * 0.05f;
+    }
+
     void InitializeApplication( IGameApp& game )
     {
+        Utility::InitializeFileIO();
+        JobSystem::Initialize();
         Graphics::Initialize();
         SystemTime::Initialize();
         GameInput::Initialize();
@@ -53,16 +100,47 @@ namespace GameCore
         game.Startup();
     }
 
+    // Recreate the device and everything that lives on it after the device was removed.  PSOs and root
+    // signatures come back from their disk caches without compiling, and the application reloads its
+    // resources from their files in Startup(), which the OS file cache has generally kept in memory.
+    void RecoverFromDeviceRemoval( IGameApp& game )
+    {
+        int64_t StartTick = SystemTime::GetCurrentTick();
+
+        Graphics::Terminate();
+        game.Cleanup();
+        ShaderHotReload::Shutdown();
+        Graphics::Shutdown();
+
+        Graphics::Initialize();
+        game.Startup();
+
+        Utility::Printf("Recovered from device removal in %.1f ms\n",
+            SystemTime::TimeBetweenTicks(StartTick, SystemTime::GetCurrentTick()) * 1000.0);
+    }
+
     void TerminateApplication( IGameApp& game )
     {
         game.Cleanup();
 
+        ShaderHotReload::Shutdown();
+
         GameInput::Shutdown();
+        JobSystem::Shutdown();
+        Utility::ShutdownFileIO();
     }
 
     bool UpdateApplication( IGameApp& game )
     {
+        PaceFrame();
+        JobSystem::RunMainThreadJobs();
+        ShaderHotReload::Update();
+
+        int64_t FrameStartTick = SystemTime::GetCurrentTick();
+        Graphics::BeginFrame();
+
         EngineProfiling::Update();
+        TextureManager::Update();
 
         float DeltaTime = Graphics::GetFrameTime();
     
@@ -76,6 +154,9 @@ namespace GameCore
 
         if (TestGenerateMips)
         {
+            if (PostEffects::AsyncCompute)
+                g_CommandManager.GetGraphicsQueue().StallForProducer(g_CommandManager.GetComputeQueue());
+
             GraphicsContext& MipsContext = GraphicsContext::Begin();
 
             // Exclude from timings this copy necessary to setup the test
@@ -101,8 +182,17 @@ namespace GameCore
 
         UiContext.Finish();
 
+        // Presenting reads the scene buffer, so this is the last moment to wait for async post processing
+        if (PostEffects::AsyncCompute)
+            g_CommandManager.GetGraphicsQueue().StallForProducer(g_CommandManager.GetComputeQueue());
+
         Graphics::Present();
 
+        if (Graphics::IsDeviceRemoved())
+            RecoverFromDeviceRemoval(game);
+        else
+            UpdateFramePrediction(FrameStartTick);
+
         return !game.IsDone();
     }
 
@@ -165,6 +255,8 @@ namespace GameCore
     void MyApplicationView::Initialize(CoreApplicationView^ applicationView)
     {
         applicationView->Activated += ref new TypedEventHandler<CoreApplicationView^, IActivatedEventArgs^>(this, &MyApplicationView::OnActivated);
+        CoreApplication::Suspending += ref new EventHandler<SuspendingEventArgs^>(this, &MyApplicationView::OnSuspending);
+        CoreApplication::Resuming += ref new EventHandler<Platform::Object^>(this, &MyApplicationView::OnResuming);
     }
 
     // Called when we are provided a window.
@@ -226,8 +318,19 @@ namespace GameCore
         g_window->Activate();
     }
 
-    void MyApplicationView::OnSuspending(Platform::Object^ sender, SuspendingEventArgs^ args) {}
-    void MyApplicationView::OnResuming(Platform::Object^ sender, Platform::Object^ args) {}
+    // Both are raised on this thread from ProcessEvents(), so no frame is in flight on the CPU.  The process may
+    // be terminated while suspended, which is why the caches are written now.
+    void MyApplicationView::OnSuspending(Platform::Object^ sender, SuspendingEventArgs^ args)
+    {
+        SuspendingDeferral^ Deferral = args->SuspendingOperation->GetDeferral();
+        Graphics::Suspend();
+        Deferral->Complete();
+    }
+
+    void MyApplicationView::OnResuming(Platform::Object^ sender, Platform::Object^ args)
+    {
+        Graphics::Resume();
+    }
 
 #if !WINAPI_FAMILY_PARTITION(WINAPI_PARTITION_TV_TITLE)
     void MyApplicationView::OnWindowSizeChanged(CoreWindow^ sender, WindowSizeChangedEventArgs^ args)
@@ -27,6 +27,12 @@
 #pragma comment(lib, "dinput8.lib")
 #pragma comment(lib, "dxguid.lib")
 
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <timeapi.h>
+#pragma comment(lib, "winmm.lib")
+
 namespace GameCore
 {
     extern HWND g_hWnd;
@@ -64,6 +70,18 @@ namespace
 
     DIMOUSESTATE2 s_MouseState;
     unsigned char s_Keybuffer[256];
+
+    // Mouse units to kAnalogMouseX and kAnalogMouseY
+    const float kMouseScale = .0018f;
+
+#if WINAPI_FAMILY_PARTITION(WINAPI_PARTITION_DESKTOP)
+    // The mouse is sampled about once a millisecond on its own thread rather than once per frame.  The motion
+    // accumulates until Update() takes it, and buttons stay down until then so that short clicks are not lost.
+    std::thread s_MouseThread;
+    std::atomic<bool> s_StopMouseThread;
+    std::mutex s_MouseMutex;
+    DIMOUSESTATE2 s_PendingMouseState;
+#endif
     unsigned char s_DXKeyMapping[GameInput::kNumKeys]; // map DigitalInput enum to DX key codes 
 
 #endif
@@ -321,6 +339,40 @@ namespace
         memset(s_Keybuffer, 0, sizeof(s_Keybuffer));
     }
 
+#if WINAPI_FAMILY_PARTITION(WINAPI_PARTITION_DESKTOP)
+    bool KbmHasFocus()
+    {
+        HWND foreground = GetForegroundWindow();
+        return foreground == GameCore::g_hWnd // wouldn't be able to acquire
+            && IsWindowVisible(foreground) != 0;
+    }
+
+    void MouseThreadMain()
+    {
+        // Without this, Sleep(1) lasts a whole scheduler tick
+        timeBeginPeriod(1);
+
+        while (!s_StopMouseThread.load(std::memory_order_relaxed))
+        {
+            DIMOUSESTATE2 State;
+            if (KbmHasFocus() && SUCCEEDED(s_Mouse->Acquire()) &&
+                SUCCEEDED(s_Mouse->GetDeviceState(sizeof(DIMOUSESTATE2), &State)))
+            {
+                std::lock_guard<std::mutex> Lock(s_MouseMutex);
+                s_PendingMouseState.lX += State.lX;
+                s_PendingMouseState.lY += State.lY;
+                s_PendingMouseState.lZ += State.lZ;
+                for (uint32_t i = 0; i < 8; ++i)
+                    s_PendingMouseState.rgbButtons[i] |= State.rgbButtons[i];
+            }
+
+            Sleep(1);
+        }
+
+        timeEndPeriod(1);
+    }
+#endif
+
     void KbmInitialize()
     {
         KbmBuildKeyMapping();
@@ -354,11 +406,24 @@ namespace
 #endif
 
         KbmZeroInputs();
+
+#if WINAPI_FAMILY_PARTITION(WINAPI_PARTITION_DESKTOP)
+        memset(&s_PendingMouseState, 0, sizeof(DIMOUSESTATE2));
+        s_StopMouseThread = false;
+        s_MouseThread = std::thread(MouseThreadMain);
+        SetThreadPriority(s_MouseThread.native_handle(), THREAD_PRIORITY_ABOVE_NORMAL);
+#endif
     }
 
     void KbmShutdown()
     {
 #if WINAPI_FAMILY_PARTITION(WINAPI_PARTITION_DESKTOP)
+        if (s_MouseThread.joinable())
+        {
+            s_StopMouseThread = true;
+            s_MouseThread.join();
+        }
+
         if (s_Keyboard)
         {
             s_Keyboard->Unacquire();
@@ -382,18 +447,18 @@ namespace
     void KbmUpdate()
     {
 #if WINAPI_FAMILY_PARTITION(WINAPI_PARTITION_DESKTOP)
-        HWND foreground = GetForegroundWindow();
-        bool visible = IsWindowVisible(foreground) != 0;
+        {
+            std::lock_guard<std::mutex> Lock(s_MouseMutex);
+            s_MouseState = s_PendingMouseState;
+            memset(&s_PendingMouseState, 0, sizeof(DIMOUSESTATE2));
+        }
 
-        if (foreground != GameCore::g_hWnd // wouldn't be able to acquire
-            || !visible)
+        if (!KbmHasFocus())
         {
             KbmZeroInputs();
         }
         else
         {
-            s_Mouse->Acquire();
-            s_Mouse->GetDeviceState(sizeof(DIMOUSESTATE2), &s_MouseState);
             s_Keyboard->Acquire();
             s_Keyboard->GetDeviceState(sizeof(s_Keybuffer), s_Keybuffer);
         }
@@ -512,8 +577,8 @@ void GameInput::Update( float frameDelta )
         if (s_MouseState.rgbButtons[i] > 0) s_Buttons[0][kMouse0 + i] = true;
     }
 
-    s_Analogs[kAnalogMouseX] = (float)s_MouseState.lX * .0018f;
-    s_Analogs[kAnalogMouseY] = (float)s_MouseState.lY * -.0018f;
+    s_Analogs[kAnalogMouseX] = (float)s_MouseState.lX * kMouseScale;
+    s_Analogs[kAnalogMouseY] = (float)s_MouseState.lY * -kMouseScale;
 
     if (s_MouseState.lZ > 0)
         s_Analogs[kAnalogMouseScroll] = 1.0f;
@@ -579,3 +644,15 @@ float GameInput::GetTimeCorrectedAnalogInput( AnalogInput ai )
 {
     return s_AnalogsTC[ai];
 }
+
+void GameInput::GetLatestMouseMotion( float& DeltaX, float& DeltaY )
+{
+#if defined(USE_KEYBOARD_MOUSE) && WINAPI_FAMILY_PARTITION(WINAPI_PARTITION_DESKTOP)
+    std::lock_guard<std::mutex> Lock(s_MouseMutex);
+    DeltaX = (float)s_PendingMouseState.lX * kMouseScale;
+    DeltaY = (float)s_PendingMouseState.lY * -kMouseScale;
+#else
+    DeltaX = 0.0f;
+    DeltaY = 0.0f;
+#endif
+}
@@ -189,6 +189,10 @@ namespace GameInput
     float GetAnalogInput( AnalogInput ai );
     float GetTimeCorrectedAnalogInput( AnalogInput ai );
 
+    // The mouse motion that arrived since the last Update(), in the units of kAnalogMouseX and kAnalogMouseY.
+    // Update() still reports it next frame.  This can be called from any thread.
+    void GetLatestMouseMotion( float& DeltaX, float& DeltaY );
+
 #if !WINAPI_FAMILY_PARTITION(WINAPI_PARTITION_TV_TITLE | WINAPI_PARTITION_DESKTOP)
     void SetKeyState(Windows::System::VirtualKey key, bool IsDown);
 #endif
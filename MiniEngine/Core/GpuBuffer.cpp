@@ -17,6 +17,8 @@
 #include "EsramAllocator.h"
 #include "CommandContext.h"
 #include "BufferManager.h"
+#include "GpuMemory.h"
+#include "PlacedResourceAllocator.h"
 
 using namespace Graphics;
 
@@ -39,9 +41,16 @@ void GpuBuffer::Create( const std::wstring& name, uint32_t NumElements, uint32_t
     HeapProps.CreationNodeMask = 1;
     HeapProps.VisibleNodeMask = 1;
 
-    ASSERT_SUCCEEDED( 
-        g_Device->CreateCommittedResource( &HeapProps, D3D12_HEAP_FLAG_NONE,
-        &ResourceDesc, m_UsageState, nullptr, MY_IID_PPV_ARGS(&m_pResource)) );
+    // Only buffers whose contents are fully written here can be placed, because reused heap memory isn't zeroed
+    if (initialData == nullptr ||
+        !PlacedResourceAllocator::CreateResource(ResourceDesc, m_UsageState, nullptr, m_pResource.ReleaseAndGetAddressOf()))
+    {
+        ASSERT_SUCCEEDED( 
+            g_Device->CreateCommittedResource( &HeapProps, D3D12_HEAP_FLAG_NONE,
+            &ResourceDesc, m_UsageState, nullptr, MY_IID_PPV_ARGS(&m_pResource)) );
+    }
+
+    GpuMemory::Track(m_pResource.Get(), GpuMemory::kBuffers);
 
     m_GpuVirtualAddress = m_pResource->GetGPUVirtualAddress();
 
@@ -87,8 +96,19 @@ void GpuBuffer::CreatePlaced(const std::wstring& name, ID3D12Heap* pBackingHeap,
 }
 
 void GpuBuffer::Create(const std::wstring& name, uint32_t NumElements, uint32_t ElementSize,
-    EsramAllocator&, const void* initialData)
+    EsramAllocator& Allocator, const void* initialData)
 {
+    // Placed memory is aliased and never holds initial data for long
+    if (initialData == nullptr)
+    {
+        m_ElementCount = NumElements;
+        m_ElementSize = ElementSize;
+        m_BufferSize = NumElements * ElementSize;
+
+        if (Allocator.Place(*this, DescribeBuffer(), name, NumElements, ElementSize))
+            return;
+    }
+
     Create(name, NumElements, ElementSize, initialData);
 }
 
@@ -28,7 +28,8 @@ public:
     void Create( const std::wstring& name, uint32_t NumElements, uint32_t ElementSize,
         const void* initialData = nullptr );
 
-    // Create a buffer in ESRAM.  On Windows, ESRAM is not used.
+    // Create a buffer on the allocator's stack.  Outside of a phase, or with initial data, the buffer gets
+    // committed memory as with Create() above.  A placed buffer doesn't exist until the allocator is finalized.
     void Create( const std::wstring& name, uint32_t NumElements, uint32_t ElementSize,
         EsramAllocator& Allocator, const void* initialData = nullptr);
 
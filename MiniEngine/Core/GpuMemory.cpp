@@ -0,0 +1,431 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Developed by Minigraph
+//
+
+#include "pch.h"
+#include "GpuMemory.h"
+#include "GraphicsCore.h"
+#include "TextRenderer.h"
+#include "PlacedResourceAllocator.h"
+#include "CommandListManager.h"
+#include <dxgi1_4.h>
+#include <atomic>
+#include <mutex>
+
+using namespace std;
+using Microsoft::WRL::ComPtr;
+
+namespace GpuMemory
+{
+    // {1E3AF4EF-157E-44ED-9A8C-8A71804CB93F}
+    const GUID kTrackerGuid = { 0x1e3af4ef, 0x157e, 0x44ed, { 0x9a, 0x8c, 0x8a, 0x71, 0x80, 0x4c, 0xb9, 0x3f } };
+
+    const char* s_CategoryNames[kNumCategories] =
+    {
+        "Render Targets",
+        "Textures",
+        "Geometry",
+        "Buffers",
+        "Particles",
+        "Dynamic",
+        "Upload",
+        "Heaps",
+        "Profiling",
+    };
+
+    // Budgets in MB, where zero means unlimited
+    NumVar s_Budgets[kNumCategories] =
+    {
+        { "Graphics/Memory/Budget MB/Render Targets", 0.0f, 0.0f, 65536.0f, 64.0f },
+        { "Graphics/Memory/Budget MB/Textures", 0.0f, 0.0f, 65536.0f, 64.0f },
+        { "Graphics/Memory/Budget MB/Geometry", 0.0f, 0.0f, 65536.0f, 64.0f },
+        { "Graphics/Memory/Budget MB/Buffers", 0.0f, 0.0f, 65536.0f, 64.0f },
+        { "Graphics/Memory/Budget MB/Particles", 0.0f, 0.0f, 65536.0f, 64.0f },
+        { "Graphics/Memory/Budget MB/Dynamic", 0.0f, 0.0f, 65536.0f, 64.0f },
+        { "Graphics/Memory/Budget MB/Upload", 0.0f, 0.0f, 65536.0f, 64.0f },
+        { "Graphics/Memory/Budget MB/Heaps", 0.0f, 0.0f, 65536.0f, 64.0f },
+        { "Graphics/Memory/Budget MB/Profiling", 0.0f, 0.0f, 65536.0f, 64.0f },
+    };
+
+    BoolVar s_ShowUsage("Graphics/Memory/Show Usage", false);
+    CallbackTrigger s_DumpUsage("Graphics/Memory/Dump Usage", [](void*) { Dump(); });
+
+    struct CategoryCounters
+    {
+        atomic<uint64_t> LocalBytes;
+        atomic<uint64_t> NonLocalBytes;
+        atomic<uint32_t> NumAllocations;
+    };
+    CategoryCounters s_Counters[kNumCategories];
+
+    bool s_OverBudget[kNumCategories];
+    bool s_OverOSBudget = false;
+
+    ComPtr<IDXGIAdapter3> s_Adapter;
+    DXGI_QUERY_VIDEO_MEMORY_INFO s_LocalInfo = {};
+    DXGI_QUERY_VIDEO_MEMORY_INFO s_NonLocalInfo = {};
+
+    thread_local Category t_ScopedCategory = kNumCategories;
+
+    class AllocationToken;
+
+    // The tokens of objects that can be evicted on their own, in lists by category
+    mutex s_PageableMutex;
+    AllocationToken* s_Pageables[kNumCategories];
+
+    // EvictAll() holds references to the placed resource heaps until RestoreResidency()
+    vector<ComPtr<ID3D12Pageable>> s_EvictedHeaps;
+    bool s_IsEvicted = false;
+
+    ComPtr<ID3D12Fence> s_ResidencyFence;
+    uint64_t s_ResidencyFenceValue = 0;
+
+    // Attached to a tracked object as private data, so the runtime drops the last reference when the object
+    // is destroyed
+    class AllocationToken : public IUnknown
+    {
+    public:
+        // Pageable is null when the object is placed in a heap that pages as a whole.  It isn't referenced,
+        // because the token dies with the object.
+        AllocationToken( Category Cat, uint64_t Bytes, bool IsLocal, ID3D12Pageable* Pageable )
+            : m_RefCount(1), m_Category(Cat), m_Bytes(Bytes), m_IsLocal(IsLocal), m_Pageable(Pageable),
+            m_IsEvicted(false), m_Prev(nullptr), m_Next(nullptr)
+        {
+            CategoryCounters& Counters = s_Counters[m_Category];
+            (m_IsLocal ? Counters.LocalBytes : Counters.NonLocalBytes) += m_Bytes;
+            ++Counters.NumAllocations;
+
+            // Upload and readback memory already lives in system memory
+            if (m_Pageable != nullptr && m_IsLocal)
+            {
+                lock_guard<mutex> Guard(s_PageableMutex);
+                m_Next = s_Pageables[m_Category];
+                if (m_Next != nullptr)
+                    m_Next->m_Prev = this;
+                s_Pageables[m_Category] = this;
+            }
+        }
+
+        virtual HRESULT STDMETHODCALLTYPE QueryInterface( REFIID Riid, void** ppvObject ) override
+        {
+            if (ppvObject == nullptr)
+                return E_POINTER;
+
+            if (Riid != __uuidof(IUnknown))
+            {
+                *ppvObject = nullptr;
+                return E_NOINTERFACE;
+            }
+
+            *ppvObject = this;
+            AddRef();
+            return S_OK;
+        }
+
+        virtual ULONG STDMETHODCALLTYPE AddRef( void ) override { return ++m_RefCount; }
+
+        virtual ULONG STDMETHODCALLTYPE Release( void ) override
+        {
+            ULONG RefCount = --m_RefCount;
+            if (RefCount == 0)
+                delete this;
+            return RefCount;
+        }
+
+        // Called with s_PageableMutex held
+        static void GatherPageables( Category Cat, bool Evicted, vector<ID3D12Pageable*>& Pageables )
+        {
+            for (AllocationToken* Token = s_Pageables[Cat]; Token != nullptr; Token = Token->m_Next)
+            {
+                if (Token->m_IsEvicted == Evicted)
+                    continue;
+
+                Token->m_IsEvicted = Evicted;
+                Pageables.push_back(Token->m_Pageable);
+            }
+        }
+
+    private:
+        ~AllocationToken()
+        {
+            CategoryCounters& Counters = s_Counters[m_Category];
+            (m_IsLocal ? Counters.LocalBytes : Counters.NonLocalBytes) -= m_Bytes;
+            --Counters.NumAllocations;
+
+            if (m_Pageable != nullptr && m_IsLocal)
+            {
+                lock_guard<mutex> Guard(s_PageableMutex);
+                (m_Prev != nullptr ? m_Prev->m_Next : s_Pageables[m_Category]) = m_Next;
+                if (m_Next != nullptr)
+                    m_Next->m_Prev = m_Prev;
+            }
+        }
+
+        atomic<ULONG> m_RefCount;
+        Category m_Category;
+        uint64_t m_Bytes;
+        bool m_IsLocal;
+        ID3D12Pageable* m_Pageable;
+        bool m_IsEvicted;
+        AllocationToken* m_Prev;
+        AllocationToken* m_Next;
+    };
+
+    bool IsLocalHeap( const D3D12_HEAP_PROPERTIES& Properties )
+    {
+        switch (Properties.Type)
+        {
+        case D3D12_HEAP_TYPE_UPLOAD:
+        case D3D12_HEAP_TYPE_READBACK:
+            return false;
+        case D3D12_HEAP_TYPE_CUSTOM:
+            return Properties.MemoryPoolPreference != D3D12_MEMORY_POOL_L0;
+        default:
+            return true;
+        }
+    }
+
+    void AttachToken( ID3D12Object* Object, Category Cat, uint64_t Bytes, bool IsLocal, ID3D12Pageable* Pageable )
+    {
+        if (t_ScopedCategory != kNumCategories)
+            Cat = t_ScopedCategory;
+
+        // Tracking an object again replaces, and so releases, its previous token
+        AllocationToken* Token = new AllocationToken(Cat, Bytes, IsLocal, Pageable);
+        ASSERT_SUCCEEDED(Object->SetPrivateDataInterface(kTrackerGuid, Token));
+        Token->Release();
+    }
+
+    float ToMB( uint64_t Bytes ) { return (float)((double)Bytes / (1024.0 * 1024.0)); }
+}
+
+const char* GpuMemory::GetCategoryName( Category Cat )
+{
+    ASSERT(Cat < kNumCategories);
+    return s_CategoryNames[Cat];
+}
+
+GpuMemory::ScopedCategory::ScopedCategory( Category Cat ) : m_PrevCategory(t_ScopedCategory)
+{
+    t_ScopedCategory = Cat;
+}
+
+GpuMemory::ScopedCategory::~ScopedCategory()
+{
+    t_ScopedCategory = m_PrevCategory;
+}
+
+void GpuMemory::Track( ID3D12Resource* Resource, Category DefaultCategory )
+{
+    if (Resource == nullptr)
+        return;
+
+    D3D12_HEAP_PROPERTIES Properties;
+    if (FAILED(Resource->GetHeapProperties(&Properties, nullptr)))
+        return;     // Reserved resources have no memory of their own
+
+    D3D12_RESOURCE_DESC Desc = Resource->GetDesc();
+    D3D12_RESOURCE_ALLOCATION_INFO Info = Graphics::g_Device->GetResourceAllocationInfo(1, 1, &Desc);
+    AttachToken(Resource, DefaultCategory, Info.SizeInBytes, IsLocalHeap(Properties),
+        PlacedResourceAllocator::IsPlaced(Resource) ? nullptr : Resource);
+}
+
+void GpuMemory::Track( ID3D12Heap* Heap, Category DefaultCategory )
+{
+    if (Heap == nullptr)
+        return;
+
+    D3D12_HEAP_DESC Desc = Heap->GetDesc();
+    AttachToken(Heap, DefaultCategory, Desc.SizeInBytes, IsLocalHeap(Desc.Properties), Heap);
+}
+
+GpuMemory::CategoryUsage GpuMemory::GetUsage( Category Cat )
+{
+    ASSERT(Cat < kNumCategories);
+
+    CategoryUsage Usage;
+    Usage.LocalBytes = s_Counters[Cat].LocalBytes;
+    Usage.NonLocalBytes = s_Counters[Cat].NonLocalBytes;
+    Usage.NumAllocations = s_Counters[Cat].NumAllocations;
+    return Usage;
+}
+
+void GpuMemory::Update( void )
+{
+    for (uint32_t i = 0; i < kNumCategories; ++i)
+    {
+        CategoryUsage Usage = GetUsage((Category)i);
+        float UsedMB = ToMB(Usage.LocalBytes + Usage.NonLocalBytes);
+        bool OverBudget = s_Budgets[i] > 0.0f && UsedMB > s_Budgets[i];
+
+        if (OverBudget && !s_OverBudget[i])
+        {
+            Utility::Printf("GPU memory:  %s is over budget (%.1f MB of %.1f MB)\n", s_CategoryNames[i],
+                UsedMB, (float)s_Budgets[i]);
+        }
+        s_OverBudget[i] = OverBudget;
+    }
+
+    // The OS budget changes slowly, so it is polled twice a second at 60 Hz
+    if (Graphics::GetFrameCount() % 30 != 0)
+        return;
+
+    if (s_Adapter == nullptr)
+    {
+        ComPtr<IDXGIFactory4> Factory;
+        if (FAILED(CreateDXGIFactory2(0, MY_IID_PPV_ARGS(&Factory))) ||
+            FAILED(Factory->EnumAdapterByLuid(Graphics::g_Device->GetAdapterLuid(), MY_IID_PPV_ARGS(&s_Adapter))))
+            return;
+    }
+
+    s_Adapter->QueryVideoMemoryInfo(0, DXGI_MEMORY_SEGMENT_GROUP_LOCAL, &s_LocalInfo);
+    s_Adapter->QueryVideoMemoryInfo(0, DXGI_MEMORY_SEGMENT_GROUP_NON_LOCAL, &s_NonLocalInfo);
+
+    bool OverOSBudget = s_LocalInfo.CurrentUsage > s_LocalInfo.Budget;
+    if (OverOSBudget && !s_OverOSBudget)
+    {
+        Utility::Printf("GPU memory:  Over the OS budget (%.1f MB of %.1f MB), expect paging\n",
+            ToMB(s_LocalInfo.CurrentUsage), ToMB(s_LocalInfo.Budget));
+    }
+    s_OverOSBudget = OverOSBudget;
+}
+
+void GpuMemory::EvictAll( void )
+{
+    if (s_IsEvicted)
+        return;
+
+    vector<ID3D12Pageable*> Pageables;
+    PlacedResourceAllocator::GetHeaps(s_EvictedHeaps);
+    for (auto& Heap : s_EvictedHeaps)
+        Pageables.push_back(Heap.Get());
+
+    {
+        lock_guard<mutex> Guard(s_PageableMutex);
+        for (uint32_t i = 0; i < kNumCategories; ++i)
+            AllocationToken::GatherPageables((Category)i, true, Pageables);
+
+        if (!Pageables.empty())
+            ASSERT_SUCCEEDED(Graphics::g_Device->Evict((UINT)Pageables.size(), Pageables.data()));
+    }
+
+    s_IsEvicted = true;
+}
+
+void GpuMemory::RestoreResidency( void )
+{
+    if (!s_IsEvicted)
+        return;
+
+    // Render targets and buffers are small and every pass touches them.  Textures come last, because they
+    // are the bulk of the memory.
+    static const Category kRestoreOrder[] =
+        { kRenderTargets, kBuffers, kGeometry, kHeaps, kParticles, kDynamic, kUpload, kProfiling, kTextures };
+    static_assert(_countof(kRestoreOrder) == kNumCategories, "Every category must be restored");
+
+    ComPtr<ID3D12Device3> Device3;
+    if (SUCCEEDED(Graphics::g_Device->QueryInterface(MY_IID_PPV_ARGS(&Device3))) && s_ResidencyFence == nullptr)
+        ASSERT_SUCCEEDED(Graphics::g_Device->CreateFence(0, D3D12_FENCE_FLAG_NONE, MY_IID_PPV_ARGS(&s_ResidencyFence)));
+
+    lock_guard<mutex> Guard(s_PageableMutex);
+
+    vector<ID3D12Pageable*> Pageables;
+    for (uint32_t i = 0; i < kNumCategories; ++i)
+    {
+        Pageables.clear();
+        AllocationToken::GatherPageables(kRestoreOrder[i], false, Pageables);
+
+        // Placed resources go with the heaps that hold them
+        if (kRestoreOrder[i] == kTextures)
+        {
+            for (auto& Heap : s_EvictedHeaps)
+                Pageables.push_back(Heap.Get());
+        }
+
+        if (Pageables.empty())
+            continue;
+
+        if (Device3 != nullptr)
+        {
+            ASSERT_SUCCEEDED(Device3->EnqueueMakeResident(D3D12_RESIDENCY_FLAG_NONE, (UINT)Pageables.size(),
+                Pageables.data(), s_ResidencyFence.Get(), ++s_ResidencyFenceValue));
+        }
+        else
+        {
+            ASSERT_SUCCEEDED(Graphics::g_Device->MakeResident((UINT)Pageables.size(), Pageables.data()));
+        }
+    }
+
+    // No queue may touch the memory before all of it is resident
+    if (Device3 != nullptr)
+    {
+        Graphics::g_CommandManager.GetGraphicsQueue().GetCommandQueue()->Wait(s_ResidencyFence.Get(), s_ResidencyFenceValue);
+        Graphics::g_CommandManager.GetComputeQueue().GetCommandQueue()->Wait(s_ResidencyFence.Get(), s_ResidencyFenceValue);
+        Graphics::g_CommandManager.GetCopyQueue().GetCommandQueue()->Wait(s_ResidencyFence.Get(), s_ResidencyFenceValue);
+    }
+
+    s_EvictedHeaps.clear();
+    s_IsEvicted = false;
+}
+
+void GpuMemory::Shutdown( void )
+{
+    s_Adapter = nullptr;
+    s_ResidencyFence = nullptr;
+    s_ResidencyFenceValue = 0;
+    s_EvictedHeaps.clear();
+    s_IsEvicted = false;
+}
+
+void GpuMemory::Display( TextContext& Text )
+{
+    if (!s_ShowUsage)
+        return;
+
+    Text.ResetCursor(1400.0f, 40.0f);
+    Text.SetColor(Color(0.5f, 1.0f, 1.0f));
+    Text.DrawFormattedString("GPU Memory     Local MB  System MB  Count\n");
+
+    uint64_t TrackedLocal = 0;
+    for (uint32_t i = 0; i < kNumCategories; ++i)
+    {
+        CategoryUsage Usage = GetUsage((Category)i);
+        TrackedLocal += Usage.LocalBytes;
+
+        Text.SetColor(s_OverBudget[i] ? Color(1.0f, 0.25f, 0.25f) : Color(1.0f, 1.0f, 1.0f));
+        Text.DrawFormattedString("%-14s %8.1f  %9.1f  %5u\n", s_CategoryNames[i], ToMB(Usage.LocalBytes),
+            ToMB(Usage.NonLocalBytes), Usage.NumAllocations);
+    }
+
+    Text.SetColor(s_OverOSBudget ? Color(1.0f, 0.25f, 0.25f) : Color(1.0f, 1.0f, 1.0f));
+    Text.DrawFormattedString("Tracked %.1f of %.1f MB used, budget %.1f MB\n", ToMB(TrackedLocal),
+        ToMB(s_LocalInfo.CurrentUsage), ToMB(s_LocalInfo.Budget));
+}
+
+void GpuMemory::Dump( void )
+{
+    Utility::Printf("GPU memory by subsystem:\n");
+    Utility::Printf("  %-14s %10s %10s %10s %7s\n", "Subsystem", "Local MB", "System MB", "Budget MB", "Count");
+
+    uint64_t TrackedLocal = 0, TrackedNonLocal = 0;
+    for (uint32_t i = 0; i < kNumCategories; ++i)
+    {
+        CategoryUsage Usage = GetUsage((Category)i);
+        TrackedLocal += Usage.LocalBytes;
+        TrackedNonLocal += Usage.NonLocalBytes;
+
+        Utility::Printf("  %-14s %10.1f %10.1f %10.1f %7u%s\n", s_CategoryNames[i], ToMB(Usage.LocalBytes),
+            ToMB(Usage.NonLocalBytes), (float)s_Budgets[i], Usage.NumAllocations, s_OverBudget[i] ? "  OVER" : "");
+    }
+
+    Utility::Printf("  %-14s %10.1f %10.1f\n", "Tracked", ToMB(TrackedLocal), ToMB(TrackedNonLocal));
+    Utility::Printf("  %-14s %10.1f %10.1f\n", "OS usage", ToMB(s_LocalInfo.CurrentUsage), ToMB(s_NonLocalInfo.CurrentUsage));
+    Utility::Printf("  %-14s %10.1f %10.1f\n", "OS budget", ToMB(s_LocalInfo.Budget), ToMB(s_NonLocalInfo.Budget));
+}
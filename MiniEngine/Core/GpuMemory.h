@@ -0,0 +1,86 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Developed by Minigraph
+//
+// Description:  Accounts for GPU memory by subsystem and checks it against per-subsystem budgets and the
+// budget the OS grants the process (IDXGIAdapter3::QueryVideoMemoryInfo).
+//
+// Tracking a resource or heap attaches a small COM object to it as private data.  The runtime releases
+// the object when the resource is destroyed, however that happens, which returns its bytes to the
+// subsystem.  Placed resources and their heaps must not both be tracked.  Heaps that hold a fixed set of
+// buffers are tracked as a whole, while the shared heaps of PlacedResourceAllocator are left to the
+// resources placed in them.
+//
+
+#pragma once
+
+#include <cstdint>
+
+class TextContext;
+
+namespace GpuMemory
+{
+    enum Category
+    {
+        kRenderTargets,     // Render targets, depth buffers, and other UAV textures
+        kTextures,          // Textures loaded from disk
+        kGeometry,          // Model vertex and index buffers
+        kBuffers,           // Other default heap buffers
+        kParticles,
+        kDynamic,           // Linear allocator pages and dynamic upload buffers
+        kUpload,            // Upload and readback staging
+        kHeaps,             // Placed resource heaps
+        kProfiling,
+
+        kNumCategories
+    };
+
+    const char* GetCategoryName( Category Cat );
+
+    // Resources and heaps created by this thread while a scope is alive are charged to its category instead
+    // of the default of the creation path, e.g. buffers created by the particle system are kParticles.
+    class ScopedCategory
+    {
+    public:
+        explicit ScopedCategory( Category Cat );
+        ~ScopedCategory();
+
+    private:
+        Category m_PrevCategory;
+    };
+
+    void Track( ID3D12Resource* Resource, Category DefaultCategory );
+    void Track( ID3D12Heap* Heap, Category DefaultCategory );
+
+    struct CategoryUsage
+    {
+        uint64_t LocalBytes;        // Default heaps, which live in video memory on discrete GPUs
+        uint64_t NonLocalBytes;     // Upload and readback heaps, which live in system memory
+        uint32_t NumAllocations;
+    };
+    CategoryUsage GetUsage( Category Cat );
+
+    // Refreshes the OS budget and reports subsystems that are over budget.  Called once per frame.
+    void Update( void );
+
+    // Evicts all tracked video memory, e.g. while the process is suspended.  The GPU must be idle.  Resources
+    // placed by PlacedResourceAllocator go with their heaps.
+    void EvictAll( void );
+
+    // Makes what EvictAll() evicted resident again, the categories the next frame depends on most first.
+    // When the device can enqueue residency changes, the queues wait for them on the GPU instead of blocking
+    // the CPU.
+    void RestoreResidency( void );
+
+    // Releases the adapter queried for the OS budget.  The device may be recreated on another one.
+    void Shutdown( void );
+
+    void Display( TextContext& Text );
+    void Dump( void );
+}
@@ -16,25 +16,80 @@
 #include "GraphicsCore.h"
 #include "CommandContext.h"
 #include "CommandListManager.h"
+#include "SystemTime.h"
+#include "GpuMemory.h"
 
 namespace
 {
-    ID3D12QueryHeap* sm_QueryHeap = nullptr;
-    ID3D12Resource* sm_ReadBackBuffer = nullptr;
-    uint64_t* sm_TimeStampBuffer = nullptr;
-    uint64_t sm_Fence = 0;
+    // Every queue type records into its own query heap.  Time stamps from different queues may tick at different
+    // rates, and copy queues need a dedicated heap type.
+    struct QueueTimeStamps
+    {
+        D3D12_COMMAND_LIST_TYPE Type;
+        ID3D12QueryHeap* QueryHeap;
+        ID3D12Resource* ReadBackBuffer;
+        uint64_t* TimeStampBuffer;
+        uint64_t Fence;
+        uint64_t ValidTimeStart;
+        uint64_t ValidTimeEnd;
+        double GpuTickDelta;
+        double GpuToCpuTicks;
+
+        // A simultaneous sample of the queue's clock and the CPU clock, refreshed every read back to limit drift
+        uint64_t GpuCalibrationTick;
+        uint64_t CpuCalibrationTick;
+    };
+
+    enum { kGraphicsQueue, kComputeQueue, kCopyQueue, kNumQueues };
+
+    QueueTimeStamps sm_Queues[kNumQueues] =
+    {
+        { D3D12_COMMAND_LIST_TYPE_DIRECT },
+        { D3D12_COMMAND_LIST_TYPE_COMPUTE },
+        { D3D12_COMMAND_LIST_TYPE_COPY },
+    };
+
+    // The queue each timer last ran on, which decides where its time stamps are read from
+    std::vector<uint8_t> sm_TimerQueues;
     uint32_t sm_MaxNumTimers = 0;
     uint32_t sm_NumTimers = 1;
-    uint64_t sm_ValidTimeStart = 0;
-    uint64_t sm_ValidTimeEnd = 0;
-    double sm_GpuTickDelta = 0.0;
+
+    uint32_t GetQueueIndex(D3D12_COMMAND_LIST_TYPE Type)
+    {
+        switch (Type)
+        {
+        case D3D12_COMMAND_LIST_TYPE_COMPUTE: return kComputeQueue;
+        case D3D12_COMMAND_LIST_TYPE_COPY: return kCopyQueue;
+        default: return kGraphicsQueue;
+        }
+    }
+
+    int64_t GpuTickToCpuTick(const QueueTimeStamps& Queue, uint64_t GpuTick)
+    {
+        return (int64_t)Queue.CpuCalibrationTick +
+            (int64_t)((double)(int64_t)(GpuTick - Queue.GpuCalibrationTick) * Queue.GpuToCpuTicks);
+    }
+
+    // Returns false if the time stamps are not from the frame being read back
+    bool GetValidTimeStamps(uint32_t TimerIdx, const QueueTimeStamps*& Queue, uint64_t& TimeStamp1, uint64_t& TimeStamp2)
+    {
+        ASSERT(TimerIdx < sm_NumTimers, "Invalid GPU timer index");
+
+        Queue = &sm_Queues[sm_TimerQueues[TimerIdx]];
+        ASSERT(Queue->TimeStampBuffer != nullptr, "Time stamp readback buffer is not mapped");
+
+        TimeStamp1 = Queue->TimeStampBuffer[TimerIdx * 2];
+        TimeStamp2 = Queue->TimeStampBuffer[TimerIdx * 2 + 1];
+
+        return TimeStamp1 >= Queue->ValidTimeStart && TimeStamp2 <= Queue->ValidTimeEnd && TimeStamp2 > TimeStamp1;
+    }
 }
 
 void GpuTimeManager::Initialize(uint32_t MaxNumTimers)
 {
-    uint64_t GpuFrequency;
-    Graphics::g_CommandManager.GetCommandQueue()->GetTimestampFrequency(&GpuFrequency);
-    sm_GpuTickDelta = 1.0 / static_cast<double>(GpuFrequency);
+    D3D12_FEATURE_DATA_D3D12_OPTIONS3 Options3 = {};
+    bool CopyQueueTimeStamps = SUCCEEDED(Graphics::g_Device->CheckFeatureSupport(
+        D3D12_FEATURE_D3D12_OPTIONS3, &Options3, sizeof(Options3))) && Options3.CopyQueueTimestampQueriesSupported;
 
     D3D12_HEAP_PROPERTIES HeapProps;
     HeapProps.Type = D3D12_HEAP_TYPE_READBACK;
@@ -56,27 +111,48 @@ void GpuTimeManager::Initialize(uint32_t MaxNumTimers)
     BufferDesc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
     BufferDesc.Flags = D3D12_RESOURCE_FLAG_NONE;
 
-    ASSERT_SUCCEEDED(Graphics::g_Device->CreateCommittedResource( &HeapProps, D3D12_HEAP_FLAG_NONE, &BufferDesc,
-        D3D12_RESOURCE_STATE_COPY_DEST, nullptr, MY_IID_PPV_ARGS(&sm_ReadBackBuffer) ));
-    sm_ReadBackBuffer->SetName(L"GpuTimeStamp Buffer");
-
-    D3D12_QUERY_HEAP_DESC QueryHeapDesc;
-    QueryHeapDesc.Count = MaxNumTimers * 2;
-    QueryHeapDesc.NodeMask = 1;
-    QueryHeapDesc.Type = D3D12_QUERY_HEAP_TYPE_TIMESTAMP;
-    ASSERT_SUCCEEDED(Graphics::g_Device->CreateQueryHeap(&QueryHeapDesc, MY_IID_PPV_ARGS(&sm_QueryHeap)));
-    sm_QueryHeap->SetName(L"GpuTimeStamp QueryHeap");
+    for (QueueTimeStamps& Queue : sm_Queues)
+    {
+        // Timers started on a copy context are ignored when the device can't time copy queues
+        if (Queue.Type == D3D12_COMMAND_LIST_TYPE_COPY && !CopyQueueTimeStamps)
+            continue;
+
+        uint64_t GpuFrequency;
+        Graphics::g_CommandManager.GetQueue(Queue.Type).GetCommandQueue()->GetTimestampFrequency(&GpuFrequency);
+        Queue.GpuTickDelta = 1.0 / static_cast<double>(GpuFrequency);
+        Queue.GpuToCpuTicks = Queue.GpuTickDelta / SystemTime::TicksToSeconds(1);
+
+        ASSERT_SUCCEEDED(Graphics::g_Device->CreateCommittedResource( &HeapProps, D3D12_HEAP_FLAG_NONE, &BufferDesc,
+            D3D12_RESOURCE_STATE_COPY_DEST, nullptr, MY_IID_PPV_ARGS(&Queue.ReadBackBuffer) ));
+        Queue.ReadBackBuffer->SetName(L"GpuTimeStamp Buffer");
+        GpuMemory::Track(Queue.ReadBackBuffer, GpuMemory::kProfiling);
+
+        D3D12_QUERY_HEAP_DESC QueryHeapDesc;
+        QueryHeapDesc.Count = MaxNumTimers * 2;
+        QueryHeapDesc.NodeMask = 1;
+        QueryHeapDesc.Type = Queue.Type == D3D12_COMMAND_LIST_TYPE_COPY ?
+            D3D12_QUERY_HEAP_TYPE_COPY_QUEUE_TIMESTAMP : D3D12_QUERY_HEAP_TYPE_TIMESTAMP;
+        ASSERT_SUCCEEDED(Graphics::g_Device->CreateQueryHeap(&QueryHeapDesc, MY_IID_PPV_ARGS(&Queue.QueryHeap)));
+        Queue.QueryHeap->SetName(L"GpuTimeStamp QueryHeap");
+    }
 
     sm_MaxNumTimers = (uint32_t)MaxNumTimers;
+    sm_TimerQueues.assign(MaxNumTimers, (uint8_t)kGraphicsQueue);
 }
 
 void GpuTimeManager::Shutdown()
 {
-    if (sm_ReadBackBuffer != nullptr)
-        sm_ReadBackBuffer->Release();
+    for (QueueTimeStamps& Queue : sm_Queues)
+    {
+        if (Queue.ReadBackBuffer != nullptr)
+            Queue.ReadBackBuffer->Release();
+
+        if (Queue.QueryHeap != nullptr)
+            Queue.QueryHeap->Release();
 
-    if (sm_QueryHeap != nullptr)
-        sm_QueryHeap->Release();
+        Queue.ReadBackBuffer = nullptr;
+        Queue.QueryHeap = nullptr;
+    }
 }
 
 uint32_t GpuTimeManager::NewTimer(void)
@@ -86,58 +162,92 @@ uint32_t GpuTimeManager::NewTimer(void)
 
 void GpuTimeManager::StartTimer(CommandContext& Context, uint32_t TimerIdx)
 {
-    Context.InsertTimeStamp(sm_QueryHeap, TimerIdx * 2);
+    uint32_t QueueIdx = GetQueueIndex(Context.GetType());
+    if (sm_Queues[QueueIdx].QueryHeap == nullptr)
+        return;
+
+    sm_TimerQueues[TimerIdx] = (uint8_t)QueueIdx;
+    Context.InsertTimeStamp(sm_Queues[QueueIdx].QueryHeap, TimerIdx * 2);
 }
 
 void GpuTimeManager::StopTimer(CommandContext& Context, uint32_t TimerIdx)
 {
-    Context.InsertTimeStamp(sm_QueryHeap, TimerIdx * 2 + 1);
+    uint32_t QueueIdx = GetQueueIndex(Context.GetType());
+    if (sm_Queues[QueueIdx].QueryHeap == nullptr)
+        return;
+
+    ASSERT(sm_TimerQueues[TimerIdx] == QueueIdx, "GPU timer stopped on a different queue than it was started on");
+    Context.InsertTimeStamp(sm_Queues[QueueIdx].QueryHeap, TimerIdx * 2 + 1);
 }
 
 void GpuTimeManager::BeginReadBack(void)
 {
-    Graphics::g_CommandManager.WaitForFence(sm_Fence);
+    for (QueueTimeStamps& Queue : sm_Queues)
+    {
+        if (Queue.QueryHeap == nullptr)
+            continue;
 
-    D3D12_RANGE Range;
-    Range.Begin = 0;
-    Range.End = (sm_NumTimers * 2) * sizeof(uint64_t);
-    ASSERT_SUCCEEDED(sm_ReadBackBuffer->Map(0, &Range, reinterpret_cast<void**>(&sm_TimeStampBuffer)));
+        Graphics::g_CommandManager.WaitForFence(Queue.Fence);
 
-    sm_ValidTimeStart = sm_TimeStampBuffer[0];
-    sm_ValidTimeEnd = sm_TimeStampBuffer[1];
+        D3D12_RANGE Range;
+        Range.Begin = 0;
+        Range.End = (sm_NumTimers * 2) * sizeof(uint64_t);
+        ASSERT_SUCCEEDED(Queue.ReadBackBuffer->Map(0, &Range, reinterpret_cast<void**>(&Queue.TimeStampBuffer)));
 
-    // On the first frame, with random values in the timestamp query heap, we can avoid a misstart.
-    if (sm_ValidTimeEnd < sm_ValidTimeStart)
-    {
-        sm_ValidTimeStart = 0ull;
-        sm_ValidTimeEnd = 0ull;
+        Queue.ValidTimeStart = Queue.TimeStampBuffer[0];
+        Queue.ValidTimeEnd = Queue.TimeStampBuffer[1];
+
+        // On the first frame, with random values in the timestamp query heap, we can avoid a misstart.
+        if (Queue.ValidTimeEnd < Queue.ValidTimeStart)
+        {
+            Queue.ValidTimeStart = 0ull;
+            Queue.ValidTimeEnd = 0ull;
+        }
+
+        Graphics::g_CommandManager.GetQueue(Queue.Type).GetCommandQueue()->GetClockCalibration(
+            &Queue.GpuCalibrationTick, &Queue.CpuCalibrationTick);
     }
 }
 
 void GpuTimeManager::EndReadBack(void)
 {
-    // Unmap with an empty range to indicate nothing was written by the CPU
-    D3D12_RANGE EmptyRange = {};
-    sm_ReadBackBuffer->Unmap(0, &EmptyRange);
-    sm_TimeStampBuffer = nullptr;
-
-    CommandContext& Context = CommandContext::Begin();
-    Context.InsertTimeStamp(sm_QueryHeap, 1);
-    Context.ResolveTimeStamps(sm_ReadBackBuffer, sm_QueryHeap, sm_NumTimers * 2);
-    Context.InsertTimeStamp(sm_QueryHeap, 0);
-    sm_Fence = Context.Finish();
+    for (QueueTimeStamps& Queue : sm_Queues)
+    {
+        if (Queue.QueryHeap == nullptr)
+            continue;
+
+        // Unmap with an empty range to indicate nothing was written by the CPU
+        D3D12_RANGE EmptyRange = {};
+        Queue.ReadBackBuffer->Unmap(0, &EmptyRange);
+        Queue.TimeStampBuffer = nullptr;
+
+        // Each queue brackets its own frame of time stamps and resolves them itself
+        CommandContext& Context = *Graphics::g_ContextManager.AllocateContext(Queue.Type);
+        Context.InsertTimeStamp(Queue.QueryHeap, 1);
+        Context.ResolveTimeStamps(Queue.ReadBackBuffer, Queue.QueryHeap, sm_NumTimers * 2);
+        Context.InsertTimeStamp(Queue.QueryHeap, 0);
+        Queue.Fence = Context.Finish();
+    }
 }
 
 float GpuTimeManager::GetTime(uint32_t TimerIdx)
 {
-    ASSERT(sm_TimeStampBuffer != nullptr, "Time stamp readback buffer is not mapped");
-    ASSERT(TimerIdx < sm_NumTimers, "Invalid GPU timer index");
-
-    uint64_t TimeStamp1 = sm_TimeStampBuffer[TimerIdx * 2];
-    uint64_t TimeStamp2 = sm_TimeStampBuffer[TimerIdx * 2 + 1];
-
-    if (TimeStamp1 < sm_ValidTimeStart || TimeStamp2 > sm_ValidTimeEnd || TimeStamp2 <= TimeStamp1 )
+    const QueueTimeStamps* Queue;
+    uint64_t TimeStamp1, TimeStamp2;
+    if (!GetValidTimeStamps(TimerIdx, Queue, TimeStamp1, TimeStamp2))
         return 0.0f;
 
-    return static_cast<float>(sm_GpuTickDelta * (TimeStamp2 - TimeStamp1));
+    return static_cast<float>(Queue->GpuTickDelta * (TimeStamp2 - TimeStamp1));
+}
+
+bool GpuTimeManager::GetTimeStamps(uint32_t TimerIdx, int64_t& StartTick, int64_t& StopTick)
+{
+    const QueueTimeStamps* Queue;
+    uint64_t TimeStamp1, TimeStamp2;
+    if (!GetValidTimeStamps(TimerIdx, Queue, TimeStamp1, TimeStamp2))
+        return false;
+
+    StartTick = GpuTickToCpuTick(*Queue, TimeStamp1);
+    StopTick = GpuTickToCpuTick(*Queue, TimeStamp2);
+    return true;
 }
@@ -36,4 +36,8 @@ namespace GpuTimeManager
 
     // Returns the time in milliseconds between start and stop queries
     float GetTime(uint32_t TimerIdx);
+
+    // Returns the start and stop queries converted to CPU ticks (see SystemTime) so that GPU work can be placed
+    // on the CPU timeline.  Returns false if the timer did not run during the frame being read back.
+    bool GetTimeStamps(uint32_t TimerIdx, int64_t& StartTick, int64_t& StopTick);
 }
@@ -38,12 +38,33 @@ using namespace std;
 using namespace GraphRenderer;
 using namespace Math;
 
-__declspec(align(16)) struct CBGraph
-{    
+// Matches GraphInstance in PerfGraphRS.hlsli
+__declspec(align(16)) struct GraphInstance
+{
+    float Rect[4];          // Left, bottom, right and top in clip space
     float RGB[3];
-    float RcpXScale;
+    float RcpYScale;
+    uint32_t FirstNode;     // The graph's oldest sample in the node buffer
     uint32_t NodeCount;
-    uint32_t FrameID;
+};
+
+// Collects the backgrounds and line strips of all graphs so that each kind is drawn with one instanced draw,
+// instead of one draw and one viewport per graph.
+class GraphBatch
+{
+public:
+    void AddBackground( const D3D12_VIEWPORT& viewport );
+    void AddLine( const D3D12_VIEWPORT& viewport, Color color, const float* ringBuffer, uint32_t nodeCount,
+        uint32_t frameID, float maxValue );
+    void Render( GraphicsContext& Context );
+
+private:
+    static GraphInstance MakeInstance( const D3D12_VIEWPORT& viewport );
+
+    vector<GraphInstance> m_Backgrounds;
+    vector<GraphInstance> m_Lines;
+    vector<float> m_Nodes;
+    uint32_t m_NodeCount = 0;
 };
 
 class GraphVector;
@@ -74,21 +95,12 @@ public:
             m_PerfTimesCPUBuffer[i][frameID % m_NodeCount] = timeStamps[i];
     }     
 
-    //RenderGraph renders both graph backgrounds and line graphs 
-    //
-    //To render backgrounds, set s_GraphBackgroundPSO, set primitive topology to triangle strip, 
-    //call RenderGraph without an object and with MaxArray = nullptr.  
-    //
-    //To render line graph, set s_RenderPerfGraphPSO, set primitive topology to line strip,
-    //call RenderGraph on an associated PerfGraph object, and pass in MaxArray
-    static void RenderGraph( GraphicsContext& Context, uint32_t vertexCount, D3D12_VIEWPORT& viewport,
-        uint32_t debugVarCount, float topMargin);
-
-    void RenderGraph(GraphicsContext& Context, uint32_t vertexCount, D3D12_VIEWPORT& viewport,
-        uint32_t debugVarCount, float topMargin, float MaxValue, uint32_t frameID);
+    //AddBackgrounds and AddLines add one background or line strip per debug variable to the batch.
+    //Each variable's graph is stacked below the previous one, separated by topMargin.
+    static void AddBackgrounds( GraphBatch& Batch, D3D12_VIEWPORT viewport, uint32_t debugVarCount, float topMargin );
 
-    void RenderGraph(GraphicsContext& Context, uint32_t vertexCount, D3D12_VIEWPORT& viewport,
-        uint32_t debugVarCount, float topMargin, const float* MaxArray, uint32_t frameID);
+    void AddLines( GraphBatch& Batch, D3D12_VIEWPORT viewport, uint32_t debugVarCount, float topMargin,
+        const float* MaxArray, uint32_t frameID );
 
 private:
     std::vector<std::unique_ptr<float[]>> m_PerfTimesCPUBuffer;
@@ -272,6 +284,7 @@ namespace
     GraphVector ProfileGraphs = GraphVector(MAX_ACTIVE_PROFILE_GRAPHS, PROFILE_DEBUG_VAR_COUNT);
     uint32_t s_NumStamps = 0;
     uint32_t s_SelectedTimerIndex;
+    GraphBatch s_Batch;
 } // {anonymous} namespace
 
 
@@ -288,11 +301,9 @@ static void DrawGraphHeaders(TextContext& Text, float leftMargin, float topMargi
 
 void GraphRenderer::Initialize( void )
 {
-    s_RootSignature.Reset(4);
-    s_RootSignature[0].InitAsConstantBuffer(0);
-    s_RootSignature[1].InitAsDescriptorRange(D3D12_DESCRIPTOR_RANGE_TYPE_UAV, 0, 2);
-    s_RootSignature[2].InitAsBufferSRV(0, D3D12_SHADER_VISIBILITY_VERTEX);
-    s_RootSignature[3].InitAsConstants(1, 3);
+    s_RootSignature.Reset(2);
+    s_RootSignature[0].InitAsBufferSRV(0, D3D12_SHADER_VISIBILITY_VERTEX);
+    s_RootSignature[1].InitAsBufferSRV(1, D3D12_SHADER_VISIBILITY_VERTEX);
     s_RootSignature.Finalize(L"Graph Renderer");
 
     s_RenderPerfGraphPSO.SetRootSignature(s_RootSignature);
@@ -453,25 +464,17 @@ void GraphRenderer::RenderGraphs(GraphicsContext& Context, GraphType Type)
         DrawGraphHeaders(Text, (viewport.TopLeftX),  blankSpace, 0.0f, (viewport.Height + blankSpace), ProfileGraphs.GetMin(), 
             ProfileGraphs.GetMax(), ProfileGraphs.GetPresetMax(), false, PROFILE_DEBUG_VAR_COUNT, graphTitles);
         
-        Context.SetRootSignature(s_RootSignature);
-        Context.TransitionResource(g_OverlayBuffer, D3D12_RESOURCE_STATE_RENDER_TARGET);
-        Context.SetRenderTarget(g_OverlayBuffer.GetRTV());
-        Context.SetPipelineState(s_GraphBackgroundPSO);
-        Context.SetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP);
-
-        // Render backgrounds
-        PerfGraph::RenderGraph(Context, 4, viewport, PROFILE_DEBUG_VAR_COUNT, blankSpace);
-        Context.SetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_LINESTRIP);
-        viewport.TopLeftY = 0.0f;
+        // Backgrounds
+        PerfGraph::AddBackgrounds(s_Batch, viewport, PROFILE_DEBUG_VAR_COUNT, blankSpace);
     
         for (auto iter = ProfileGraphs.m_Graphs.begin(); iter != ProfileGraphs.m_Graphs.end(); ++iter)
         {
             if ((*iter)->IsGraphed())
-            {
-                (*iter)->RenderGraph(Context, 256, viewport, PROFILE_DEBUG_VAR_COUNT, blankSpace, ProfileGraphs.GetPresetMax(), s_FrameID);
-                viewport.TopLeftY = 0.0f;
-            }
+                (*iter)->AddLines(s_Batch, viewport, PROFILE_DEBUG_VAR_COUNT, blankSpace, ProfileGraphs.GetPresetMax(), s_FrameID);
         }
+
+        Text.Flush();
+        s_Batch.Render(Context);
     }
     else if (Type == GraphType::Global)
     {
@@ -489,21 +492,17 @@ void GraphRenderer::RenderGraphs(GraphicsContext& Context, GraphType Type)
         DrawGraphHeaders( Text, (viewport.TopLeftX), blankSpace,  (viewport.TopLeftY - blankSpace - textSpace.y), (viewport.Height + blankSpace), 
                                         GlobalGraphs.GetMinAbs(), GlobalGraphs.GetMaxAbs(), GlobalGraphs.GetPresetMax(), true, 1, graphTitles);
 
-        Context.SetRootSignature(s_RootSignature);
-        Context.TransitionResource(g_OverlayBuffer, D3D12_RESOURCE_STATE_RENDER_TARGET);
-        Context.SetRenderTarget(g_OverlayBuffer.GetRTV());
-        Context.SetPipelineState(s_GraphBackgroundPSO);
-        Context.SetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP);
-        
-        // Render background
-        PerfGraph::RenderGraph(Context, 4, viewport, 1, 0.0f);
+        // Background
+        PerfGraph::AddBackgrounds(s_Batch, viewport, 1, 0.0f);
     
-        // Render graphs
-        Context.SetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_LINESTRIP);
+        // Graphs
         for (auto iter = GlobalGraphs.m_Graphs.begin(); iter != GlobalGraphs.m_Graphs.end(); ++iter)
         {
-            (*iter)->RenderGraph(Context, 512, viewport, 1, 0.0f, GlobalGraphs.GetPresetMax(), s_FrameID);
+            (*iter)->AddLines(s_Batch, viewport, 1, 0.0f, GlobalGraphs.GetPresetMax(), s_FrameID);
         }
+
+        Text.Flush();
+        s_Batch.Render(Context);
     }
     s_FrameID++;
     Text.End();
@@ -521,68 +520,105 @@ void GraphRenderer::SetSelectedIndex(uint32_t selectedIndex)
 //
 //---------------------------------------------------------------------
 
-void PerfGraph::RenderGraph(GraphicsContext& Context, uint32_t vertexCount, D3D12_VIEWPORT& viewport, uint32_t debugVarCount, float topMargin)
+void PerfGraph::AddBackgrounds( GraphBatch& Batch, D3D12_VIEWPORT viewport, uint32_t debugVarCount, float topMargin )
 {
     viewport.TopLeftY += topMargin;
 
-    Context.SetConstants(3, 0, 20.0f);
-
     for (uint32_t i = 0; i < debugVarCount; ++i)
     {
-        Context.SetViewport(viewport);
-        Context.Draw(vertexCount);
-        if (debugVarCount > 1)
-            viewport.TopLeftY += viewport.Height + topMargin;
+        Batch.AddBackground(viewport);
+        viewport.TopLeftY += viewport.Height + topMargin;
     }
 }
 
-void PerfGraph::RenderGraph(GraphicsContext& Context, uint32_t vertexCount, D3D12_VIEWPORT& viewport, uint32_t debugVarCount, float topMargin, float YScale, uint32_t frameID)
+void PerfGraph::AddLines( GraphBatch& Batch, D3D12_VIEWPORT viewport, uint32_t debugVarCount, float topMargin,
+    const float* MaxArray, uint32_t frameID )
 {
+    ASSERT(MaxArray != nullptr);
     viewport.TopLeftY += topMargin;
 
-    CBGraph graphConstants;
-    graphConstants.RGB[0] = m_Color.R();
-    graphConstants.RGB[1] = m_Color.G();
-    graphConstants.RGB[2] = m_Color.B();
-    graphConstants.RcpXScale = 2.0f / m_NodeCount;
-    graphConstants.NodeCount = m_NodeCount;
-    graphConstants.FrameID = frameID;
-    Context.SetDynamicConstantBufferView(0, sizeof(CBGraph), &graphConstants);
-    Context.SetPipelineState(s_RenderPerfGraphPSO);
-
     for (uint32_t i = 0; i < debugVarCount; ++i)
     {
-        Context.SetDynamicSRV(2, sizeof(float) * m_NodeCount, m_PerfTimesCPUBuffer[i].get());
-        Context.SetConstants(3, i, 1.0f / YScale);
-        Context.SetViewport(viewport);
-        Context.Draw(vertexCount);
-        if (debugVarCount > 1)
-            viewport.TopLeftY += viewport.Height + topMargin;
+        Batch.AddLine(viewport, m_Color, m_PerfTimesCPUBuffer[i].get(), m_NodeCount, frameID, MaxArray[i]);
+        viewport.TopLeftY += viewport.Height + topMargin;
     }
 }
 
-void PerfGraph::RenderGraph( GraphicsContext& Context, uint32_t vertexCount, D3D12_VIEWPORT& viewport, uint32_t debugVarCount, float topMargin, const float* MaxArray, uint32_t frameID)
+//---------------------------------------------------------------------
+//
+//    GraphBatch Methods
+//
+//---------------------------------------------------------------------
+
+GraphInstance GraphBatch::MakeInstance( const D3D12_VIEWPORT& viewport )
+{
+    // Viewports are in pixels from the top left of the overlay buffer
+    const float RcpWidth = 2.0f / g_OverlayBuffer.GetWidth();
+    const float RcpHeight = 2.0f / g_OverlayBuffer.GetHeight();
+
+    GraphInstance instance = {};
+    instance.Rect[0] = viewport.TopLeftX * RcpWidth - 1.0f;
+    instance.Rect[1] = 1.0f - (viewport.TopLeftY + viewport.Height) * RcpHeight;
+    instance.Rect[2] = (viewport.TopLeftX + viewport.Width) * RcpWidth - 1.0f;
+    instance.Rect[3] = 1.0f - viewport.TopLeftY * RcpHeight;
+    return instance;
+}
+
+void GraphBatch::AddBackground( const D3D12_VIEWPORT& viewport )
 {
-    ASSERT(MaxArray != nullptr);
-    viewport.TopLeftY += topMargin;
+    m_Backgrounds.push_back(MakeInstance(viewport));
+}
 
-    CBGraph graphConstants;
-    graphConstants.RGB[0] = m_Color.R();
-    graphConstants.RGB[1] = m_Color.G();
-    graphConstants.RGB[2] = m_Color.B();
-    graphConstants.RcpXScale = 2.0f / m_NodeCount;
-    graphConstants.NodeCount = m_NodeCount;
-    graphConstants.FrameID = frameID;
-    Context.SetDynamicConstantBufferView(0, sizeof(CBGraph), &graphConstants);
-    Context.SetPipelineState(s_RenderPerfGraphPSO);
-    
-    for (uint32_t i = 0; i < debugVarCount; ++i)
+void GraphBatch::AddLine( const D3D12_VIEWPORT& viewport, Color color, const float* ringBuffer, uint32_t nodeCount,
+    uint32_t frameID, float maxValue )
+{
+    // Every line strip of a batch is drawn with the same vertex count
+    ASSERT(m_Lines.empty() || nodeCount == m_NodeCount);
+    ASSERT(Math::IsPowerOfTwo(nodeCount));
+    m_NodeCount = nodeCount;
+
+    GraphInstance instance = MakeInstance(viewport);
+    instance.RGB[0] = color.R();
+    instance.RGB[1] = color.G();
+    instance.RGB[2] = color.B();
+    instance.RcpYScale = 1.0f / maxValue;
+    instance.FirstNode = (uint32_t)m_Nodes.size();
+    instance.NodeCount = nodeCount;
+    m_Lines.push_back(instance);
+
+    // Unroll the ring buffer so that the shader reads the samples in order
+    for (uint32_t i = 0; i < nodeCount; ++i)
+        m_Nodes.push_back(ringBuffer[(frameID + i) & (nodeCount - 1)]);
+}
+
+void GraphBatch::Render( GraphicsContext& Context )
+{
+    if (m_Backgrounds.empty() && m_Lines.empty())
+        return;
+
+    Context.SetRootSignature(s_RootSignature);
+    Context.TransitionResource(g_OverlayBuffer, D3D12_RESOURCE_STATE_RENDER_TARGET);
+    Context.SetRenderTarget(g_OverlayBuffer.GetRTV());
+    Context.SetViewport(0.0f, 0.0f, (float)g_OverlayBuffer.GetWidth(), (float)g_OverlayBuffer.GetHeight());
+
+    if (!m_Backgrounds.empty())
     {
-        Context.SetDynamicSRV(2, sizeof(float) * m_NodeCount, m_PerfTimesCPUBuffer[i].get());
-        Context.SetConstants(3, i, 1.0f / MaxArray[i]);
-        Context.SetViewport(viewport);
-        Context.Draw(vertexCount);
-        if (debugVarCount > 1)
-            viewport.TopLeftY += viewport.Height + topMargin;
+        Context.SetPipelineState(s_GraphBackgroundPSO);
+        Context.SetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP);
+        Context.SetDynamicSRV(0, sizeof(GraphInstance) * m_Backgrounds.size(), m_Backgrounds.data());
+        Context.DrawInstanced(4, (UINT)m_Backgrounds.size());
+    }
+
+    if (!m_Lines.empty())
+    {
+        Context.SetPipelineState(s_RenderPerfGraphPSO);
+        Context.SetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_LINESTRIP);
+        Context.SetDynamicSRV(0, sizeof(GraphInstance) * m_Lines.size(), m_Lines.data());
+        Context.SetDynamicSRV(1, sizeof(float) * m_Nodes.size(), m_Nodes.data());
+        Context.DrawInstanced(m_NodeCount, (UINT)m_Lines.size());
     }
+
+    m_Backgrounds.clear();
+    m_Lines.clear();
+    m_Nodes.clear();
 }
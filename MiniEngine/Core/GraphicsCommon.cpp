@@ -62,6 +62,7 @@ namespace Graphics
 
     CommandSignature DispatchIndirectCommandSignature(1);
     CommandSignature DrawIndirectCommandSignature(1);
+    CommandSignature DrawIndexedIndirectCommandSignature(1);
 }
 
 namespace BitonicSort
@@ -70,6 +71,12 @@ namespace BitonicSort
     void Shutdown(void);
 }
 
+namespace RadixSort
+{
+    void Initialize(void);
+    void Shutdown(void);
+}
+
 void Graphics::InitializeCommonState(void)
 {
     SamplerLinearWrapDesc.Filter = D3D12_FILTER_MIN_MAG_MIP_LINEAR;
@@ -203,13 +210,19 @@ void Graphics::InitializeCommonState(void)
     DrawIndirectCommandSignature[0].Draw();
     DrawIndirectCommandSignature.Finalize();
 
+    DrawIndexedIndirectCommandSignature[0].DrawIndexed();
+    DrawIndexedIndirectCommandSignature.Finalize();
+
     BitonicSort::Initialize();
+    RadixSort::Initialize();
 }
 
 void Graphics::DestroyCommonState(void)
 {
     DispatchIndirectCommandSignature.Destroy();
     DrawIndirectCommandSignature.Destroy();
+    DrawIndexedIndirectCommandSignature.Destroy();
     
     BitonicSort::Shutdown();
+    RadixSort::Shutdown();
 }
@@ -61,6 +61,7 @@ namespace Graphics
 
     extern CommandSignature DispatchIndirectCommandSignature;
     extern CommandSignature DrawIndirectCommandSignature;
+    extern CommandSignature DrawIndexedIndirectCommandSignature;
 
     void InitializeCommonState(void);
     void DestroyCommonState(void);
@@ -18,6 +18,10 @@
 #include "GpuTimeManager.h"
 #include "PostEffects.h"
 #include "SSAO.h"
+#include "HiZ.h"
+#include "MSAAResolve.h"
+#include "TextureCompressor.h"
+#include "MeshStreamDecoder.h"
 #include "TextRenderer.h"
 #include "ColorBuffer.h"
 #include "SystemTime.h"
@@ -30,6 +34,12 @@
 #include "ParticleEffectManager.h"
 #include "GraphRenderer.h"
 #include "TemporalEffects.h"
+#include "TextureManager.h"
+#include "UploadManager.h"
+#include "ReadbackManager.h"
+#include "EngineProfiling.h"
+#include "GpuMemory.h"
+#include "PlacedResourceAllocator.h"
 
 // This macro determines whether to detect if there is an HDR display and enable HDR10 output.
 // Currently, with HDR display enabled, the pixel magnfication functionality is broken.
@@ -66,6 +76,14 @@
 #include "CompiledShaders/GenerateMipsGammaOddCS.h"
 #include "CompiledShaders/GenerateMipsGammaOddXCS.h"
 #include "CompiledShaders/GenerateMipsGammaOddYCS.h"
+#include "CompiledShaders/GenerateMipsSinglePassLinearCS.h"
+#include "CompiledShaders/GenerateMipsSinglePassGammaCS.h"
+
+//#define _WAVE_OP
+#ifdef _WAVE_OP
+#include "CompiledShaders/GenerateMipsSinglePassLinearCS_SM6.h"
+#include "CompiledShaders/GenerateMipsSinglePassGammaCS_SM6.h"
+#endif
 
 #define SWAP_CHAIN_BUFFER_COUNT 3
 
@@ -92,14 +110,29 @@ namespace
     uint64_t s_FrameIndex = 0;
     int64_t s_FrameStartTick = 0;
 
+    // Present latency is measured from the tick at which a frame sampled input to the vertical blank at
+    // which DXGI reports it was shown.  Frames are matched to the statistics by their present count.
+    struct PresentRecord
+    {
+        UINT PresentCount;
+        int64_t InputTick;
+    };
+    const uint32_t kPresentHistory = 16;
+    PresentRecord s_PresentHistory[kPresentHistory] = {};
+    int64_t s_InputTick = 0;
+    float s_PresentLatency = 0.0f;
+
     BoolVar s_LimitTo30Hz("Timing/Limit To 30Hz", false);
     BoolVar s_DropRandomFrames("Timing/Drop Random Frames", false);
+
+    bool s_DeviceRemoved = false;
 }
 
 namespace Graphics
 {
     void PreparePresentLDR();
     void PreparePresentHDR();
+    void UpdatePresentLatency();
     void CompositeOverlays( GraphicsContext& Context );
 
 #ifndef RELEASE
@@ -113,9 +146,31 @@ namespace Graphics
     const char* ResolutionLabels[] = { "1280x720", "1600x900", "1920x1080", "2560x1440", "3200x1800", "3840x2160" };
     EnumVar TargetResolution("Graphics/Display/Native Resolution", k1080p, kNumPredefinedResolutions, ResolutionLabels);
 
+    // Dynamic resolution scales the native resolution down from the target above whenever the GPU cannot keep
+    // up with the target frame rate.  Changing resolution recreates the render targets, which idles the GPU, so
+    // the scale moves in coarse steps with hysteresis rather than every frame.
+    BoolVar s_EnableDynamicResolution("Graphics/Display/Dynamic Resolution/Enable", false);
+    NumVar s_DynamicResolutionTargetRate("Graphics/Display/Dynamic Resolution/Target Rate (Hz)", 60.0f, 30.0f, 120.0f, 30.0f);
+    NumVar s_DynamicResolutionMinScale("Graphics/Display/Dynamic Resolution/Minimum Scale", 0.5f, 0.25f, 1.0f, 0.05f);
+    float s_DynamicResolutionScale = 1.0f;
+
     BoolVar s_EnableVSync("Timing/VSync", true);
 
+    // Low latency mode limits the swap chain to one queued frame, so the CPU starts a frame only once the
+    // previous one has been handed to the display.  With VSync off, presents tear when the display allows it,
+    // which is also what lets variable refresh rate displays follow the frame rate.
+    BoolVar s_LowLatencyMode("Timing/Low Latency/Enable", false);
+
+    // How many frames the CPU may record ahead of the GPU, independent of the number of back buffers.  Each
+    // frame waits for the GPU to finish the frame this many presents earlier, so fewer frames in flight trade
+    // throughput for latency.  The swap chain is allowed to queue as many frames, except in low latency mode.
+    const uint32_t kMaxFramesInFlight = 4;
+    IntVar s_FramesInFlight("Timing/Frames In Flight", SWAP_CHAIN_BUFFER_COUNT - 1, 1, kMaxFramesInFlight);
+    uint64_t s_FrameFences[kMaxFramesInFlight] = {};
+    BoolVar s_AllowTearing("Timing/Allow Tearing", true);
+
     bool g_bTypedUAVLoadSupport_R11G11B10_FLOAT = false;
+    bool g_bDepthBoundsTestSupported = false;
     bool g_bTypedUAVLoadSupport_R16G16B16A16_FLOAT = false;
     bool g_bEnableHDROutput = false;
     NumVar g_HDRPaperWhite("Graphics/Display/Paper White (nits)", 200.0f, 100.0f, 500.0f, 50.0f);
@@ -129,6 +184,49 @@ namespace Graphics
     uint32_t g_DisplayHeight = 1080;
     ColorBuffer g_PreDisplayBuffer;
 
+    void UpdateDynamicResolution(void)
+    {
+        const uint32_t kFramesBetweenChanges = 30;
+        const float kScaleStep = 0.05f;
+
+        static float s_SmoothedGpuTime = 0.0f;
+        static uint32_t s_FramesSinceChange = 0;
+
+        if (!s_EnableDynamicResolution)
+        {
+            s_DynamicResolutionScale = 1.0f;
+            s_SmoothedGpuTime = 0.0f;
+            return;
+        }
+
+        float GpuTime = EngineProfiling::GetGpuFrameTime();
+        if (GpuTime <= 0.0f)
+            return;
+
+        s_SmoothedGpuTime = s_SmoothedGpuTime == 0.0f ? GpuTime : s_SmoothedGpuTime + (GpuTime - s_SmoothedGpuTime) * 0.1f;
+
+        if (++s_FramesSinceChange < kFramesBetweenChanges)
+            return;
+
+        // Aim for 90% of the frame budget.  GPU time is roughly proportional to the pixel count, so the scale
+        // on each axis goes with the square root of the time ratio.  Scaling up waits for clear headroom, so
+        // that the resolution does not oscillate around the budget.
+        float Budget = 1000.0f / (float)s_DynamicResolutionTargetRate;
+        if (s_SmoothedGpuTime < Budget && s_SmoothedGpuTime > 0.75f * Budget)
+            return;
+
+        float IdealScale = s_DynamicResolutionScale * sqrtf(0.9f * Budget / s_SmoothedGpuTime);
+        float NewScale = floorf(IdealScale / kScaleStep) * kScaleStep;
+        NewScale = std::max(std::min(NewScale, 1.0f), std::max((float)s_DynamicResolutionMinScale, kScaleStep));
+
+        if (fabsf(NewScale - s_DynamicResolutionScale) < 0.5f * kScaleStep)
+            return;
+
+        s_DynamicResolutionScale = NewScale;
+        s_SmoothedGpuTime = 0.0f;
+        s_FramesSinceChange = 0;
+    }
+
     void SetNativeResolution(void)
     {
         uint32_t NativeWidth, NativeHeight;
@@ -162,6 +260,12 @@ namespace Graphics
             break;
         }
 
+        if (s_DynamicResolutionScale < 1.0f)
+        {
+            NativeWidth = (uint32_t)(NativeWidth * s_DynamicResolutionScale) & ~7u;
+            NativeHeight = (uint32_t)(NativeHeight * s_DynamicResolutionScale) & ~7u;
+        }
+
         if (g_NativeWidth == NativeWidth && g_NativeHeight == NativeHeight)
             return;
 
@@ -186,6 +290,31 @@ namespace Graphics
     UINT g_CurrentBuffer = 0;
 
     IDXGISwapChain1* s_SwapChain1 = nullptr;
+    HANDLE s_FrameLatencyWaitable = nullptr;
+    UINT s_SwapChainFlags = 0;
+    UINT s_MaxFrameLatency = 0;
+    bool s_TearingSupported = false;
+
+    UINT GetMaxFrameLatency( void )
+    {
+        return s_LowLatencyMode ? 1 : (UINT)s_FramesInFlight;
+    }
+
+    // Removes the device to test recovery.  Without ID3D12Device5, the next Present() only acts as if it had
+    // found the device removed.
+    void SimulateDeviceRemoval( void* )
+    {
+#if defined(NTDDI_WIN10_RS5) && (NTDDI_VERSION >= NTDDI_WIN10_RS5)
+        ComPtr<ID3D12Device5> Device5;
+        if (SUCCEEDED(g_Device->QueryInterface(MY_IID_PPV_ARGS(&Device5))))
+        {
+            Device5->RemoveDevice();
+            return;
+        }
+#endif
+        s_DeviceRemoved = true;
+    }
+    CallbackTrigger s_SimulateDeviceRemoval("Graphics/Simulate Device Removal", SimulateDeviceRemoval);
 
     DescriptorAllocator g_DescriptorAllocator[D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES] =
     {
@@ -208,6 +337,11 @@ namespace Graphics
     RootSignature g_GenerateMipsRS;
     ComputePSO g_GenerateMipsLinearPSO[4];
     ComputePSO g_GenerateMipsGammaPSO[4];
+    RootSignature g_GenerateMipsSinglePassRS;
+    ComputePSO g_GenerateMipsSinglePassLinearPSO;
+    ComputePSO g_GenerateMipsSinglePassGammaPSO;
+    StructuredBuffer g_GenerateMipsScratch;
+    ByteAddressBuffer g_GenerateMipsCounter;
 
     enum { kBilinear, kBicubic, kSharpening, kFilterCount };
     const char* FilterLabels[] = { "Bilinear", "Bicubic", "Sharpening" };
@@ -246,7 +380,7 @@ void Graphics::Resize(uint32_t width, uint32_t height)
     for (uint32_t i = 0; i < SWAP_CHAIN_BUFFER_COUNT; ++i)
         g_DisplayPlane[i].Destroy();
 
-    ASSERT_SUCCEEDED(s_SwapChain1->ResizeBuffers(SWAP_CHAIN_BUFFER_COUNT, width, height, SwapChainFormat, 0));
+    ASSERT_SUCCEEDED(s_SwapChain1->ResizeBuffers(SWAP_CHAIN_BUFFER_COUNT, width, height, SwapChainFormat, s_SwapChainFlags));
 
     for (uint32_t i = 0; i < SWAP_CHAIN_BUFFER_COUNT; ++i)
     {
@@ -459,7 +593,35 @@ void Graphics::Initialize(void)
         }
     }
 
+    // Depth bounds test PSOs are created from a pipeline state stream, which requires ID3D12Device2
+    D3D12_FEATURE_DATA_D3D12_OPTIONS2 Options2 = {};
+    ComPtr<ID3D12Device2> Device2;
+    if (SUCCEEDED(g_Device->CheckFeatureSupport(D3D12_FEATURE_D3D12_OPTIONS2, &Options2, sizeof(Options2))) &&
+        Options2.DepthBoundsTestSupported && SUCCEEDED(g_Device->QueryInterface(MY_IID_PPV_ARGS(&Device2))))
+    {
+        g_bDepthBoundsTestSupported = true;
+    }
+
     g_CommandManager.Create(g_Device);
+    PlacedResourceAllocator::Initialize();
+    UploadManager::Initialize();
+    ReadbackManager::Initialize();
+
+#if defined(NTDDI_WIN10_RS2) && (NTDDI_VERSION >= NTDDI_WIN10_RS2)
+    {
+        ComPtr<IDXGIFactory5> dxgiFactory5;
+        BOOL allowTearing = FALSE;
+        if (SUCCEEDED(dxgiFactory.As(&dxgiFactory5)) &&
+            SUCCEEDED(dxgiFactory5->CheckFeatureSupport(DXGI_FEATURE_PRESENT_ALLOW_TEARING, &allowTearing, sizeof(allowTearing))))
+        {
+            s_TearingSupported = allowTearing == TRUE;
+        }
+    }
+#endif
+
+    s_SwapChainFlags = DXGI_SWAP_CHAIN_FLAG_ALLOW_MODE_SWITCH | DXGI_SWAP_CHAIN_FLAG_FRAME_LATENCY_WAITABLE_OBJECT;
+    if (s_TearingSupported)
+        s_SwapChainFlags |= DXGI_SWAP_CHAIN_FLAG_ALLOW_TEARING;
 
     DXGI_SWAP_CHAIN_DESC1 swapChainDesc = {};
     swapChainDesc.Width = g_DisplayWidth;
@@ -470,7 +632,7 @@ void Graphics::Initialize(void)
     swapChainDesc.SampleDesc.Count = 1;
     swapChainDesc.BufferUsage = DXGI_USAGE_RENDER_TARGET_OUTPUT;
     swapChainDesc.BufferCount = SWAP_CHAIN_BUFFER_COUNT;
-    swapChainDesc.Flags = DXGI_SWAP_CHAIN_FLAG_ALLOW_MODE_SWITCH;
+    swapChainDesc.Flags = s_SwapChainFlags;
     swapChainDesc.SwapEffect = DXGI_SWAP_EFFECT_FLIP_SEQUENTIAL;
 
 #if WINAPI_FAMILY_PARTITION(WINAPI_PARTITION_DESKTOP) // Win32
@@ -479,6 +641,14 @@ void Graphics::Initialize(void)
     ASSERT_SUCCEEDED(dxgiFactory->CreateSwapChainForCoreWindow(g_CommandManager.GetCommandQueue(), (IUnknown*)GameCore::g_window.Get(), &swapChainDesc, nullptr, &s_SwapChain1));
 #endif
 
+    {
+        ComPtr<IDXGISwapChain2> swapChain2;
+        ASSERT_SUCCEEDED(s_SwapChain1->QueryInterface(MY_IID_PPV_ARGS(&swapChain2)));
+        s_MaxFrameLatency = GetMaxFrameLatency();
+        ASSERT_SUCCEEDED(swapChain2->SetMaximumFrameLatency(s_MaxFrameLatency));
+        s_FrameLatencyWaitable = swapChain2->GetFrameLatencyWaitableObject();
+    }
+
 #if CONDITIONALLY_ENABLE_HDR_OUTPUT && defined(NTDDI_WIN10_RS2) && (NTDDI_VERSION >= NTDDI_WIN10_RS2)
     {
         IDXGISwapChain4* swapChain = (IDXGISwapChain4*)s_SwapChain1;
@@ -581,6 +751,36 @@ void Graphics::Initialize(void)
     CreatePSO(g_GenerateMipsGammaPSO[2], g_pGenerateMipsGammaOddYCS);
     CreatePSO(g_GenerateMipsGammaPSO[3], g_pGenerateMipsGammaOddCS);
 
+    g_GenerateMipsSinglePassRS.Reset(4, 1);
+    g_GenerateMipsSinglePassRS[0].InitAsConstants(0, 4);
+    g_GenerateMipsSinglePassRS[1].InitAsDescriptorRange(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 0, 1);
+    g_GenerateMipsSinglePassRS[2].InitAsDescriptorRange(D3D12_DESCRIPTOR_RANGE_TYPE_UAV, 0, 12);
+    g_GenerateMipsSinglePassRS[3].InitAsDescriptorRange(D3D12_DESCRIPTOR_RANGE_TYPE_UAV, 12, 2);
+    g_GenerateMipsSinglePassRS.InitStaticSampler(0, SamplerLinearClampDesc);
+    g_GenerateMipsSinglePassRS.Finalize(L"Generate Mips Single Pass");
+
+#undef CreatePSO
+#define CreatePSO(ObjName, ShaderByteCode ) \
+    ObjName.SetRootSignature(g_GenerateMipsSinglePassRS); \
+    ObjName.SetComputeShader(ShaderByteCode, sizeof(ShaderByteCode) ); \
+    ObjName.Finalize();
+
+#ifdef _WAVE_OP
+    CreatePSO(g_GenerateMipsSinglePassLinearPSO, g_pGenerateMipsSinglePassLinearCS_SM6);
+    CreatePSO(g_GenerateMipsSinglePassGammaPSO, g_pGenerateMipsSinglePassGammaCS_SM6);
+#else
+    CreatePSO(g_GenerateMipsSinglePassLinearPSO, g_pGenerateMipsSinglePassLinearCS);
+    CreatePSO(g_GenerateMipsSinglePassGammaPSO, g_pGenerateMipsSinglePassGammaCS);
+#endif
+
+#undef CreatePSO
+
+    // One mip 6 texel per 64x64 tile of a 4096x4096 texture.  The counter starts at zero and every dispatch
+    // leaves it at zero.
+    const uint32_t ZeroCount = 0;
+    g_GenerateMipsScratch.Create(L"Generate Mips Scratch", 64 * 64, sizeof(float) * 4);
+    g_GenerateMipsCounter.Create(L"Generate Mips Counter", 1, sizeof(uint32_t), &ZeroCount);
+
     g_PreDisplayBuffer.Create(L"PreDisplay Buffer", g_DisplayWidth, g_DisplayHeight, 1, SwapChainFormat);
 
     GpuTimeManager::Initialize(4096);
@@ -588,6 +788,10 @@ void Graphics::Initialize(void)
     TemporalEffects::Initialize();
     PostEffects::Initialize();
     SSAO::Initialize();
+    HiZ::Initialize();
+    MSAAResolve::Initialize();
+    TextureCompressor::Initialize();
+    MeshStreamDecoder::Initialize();
     TextRenderer::Initialize();
     GraphRenderer::Initialize();
     ParticleEffects::Initialize(kMaxNativeWidth, kMaxNativeHeight);
@@ -595,27 +799,53 @@ void Graphics::Initialize(void)
 
 void Graphics::Terminate( void )
 {
+    TextureManager::StopStreaming();
     g_CommandManager.IdleGPU();
 #if WINAPI_FAMILY_PARTITION(WINAPI_PARTITION_DESKTOP)
     s_SwapChain1->SetFullscreenState(FALSE, nullptr);
 #endif
 }
 
+void Graphics::Suspend( void )
+{
+    g_CommandManager.IdleGPU();
+
+    PSO::SaveCache();
+    RootSignature::SaveCache();
+
+    // D3D12 devices don't implement IDXGIDevice3::Trim().  Releasing memory is up to the app, which owns all of it.
+    GpuMemory::EvictAll();
+}
+
+void Graphics::Resume( void )
+{
+    GpuMemory::RestoreResidency();
+}
+
 void Graphics::Shutdown( void )
 {
+    ReadbackManager::Shutdown();
+    UploadManager::Shutdown();
     CommandContext::DestroyAllContexts();
     g_CommandManager.Shutdown();
     GpuTimeManager::Shutdown();
+    CloseHandle(s_FrameLatencyWaitable);
+    s_FrameLatencyWaitable = nullptr;
     s_SwapChain1->Release();
+    s_SwapChain1 = nullptr;
     PSO::DestroyAll();
+    CommandSignature::DestroyAll();
     RootSignature::DestroyAll();
     DescriptorAllocator::DestroyAll();
+    SamplerManager::Shutdown();
 
     DestroyCommonState();
     DestroyRenderingBuffers();
     TemporalEffects::Shutdown();
     PostEffects::Shutdown();
     SSAO::Shutdown();
+    HiZ::Shutdown();
+    MSAAResolve::Shutdown();
     TextRenderer::Shutdown();
     GraphRenderer::Shutdown();
     ParticleEffects::Shutdown();
@@ -625,6 +855,21 @@ void Graphics::Shutdown( void )
         g_DisplayPlane[i].Destroy();
 
     g_PreDisplayBuffer.Destroy();
+    g_GenerateMipsScratch.Destroy();
+    g_GenerateMipsCounter.Destroy();
+
+    PlacedResourceAllocator::Shutdown();
+    GpuMemory::Shutdown();
+
+    // Leave nothing behind that would keep Initialize() from recreating everything, e.g. after device removal
+    for (uint32_t i = 0; i < D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES; ++i)
+        g_DescriptorAllocator[i].Reset();
+    g_NativeWidth = 0;
+    g_NativeHeight = 0;
+    g_CurrentBuffer = 0;
+    s_DeviceRemoved = false;
+    ZeroMemory(s_PresentHistory, sizeof(s_PresentHistory));
+    ZeroMemory(s_FrameFences, sizeof(s_FrameFences));
 
 #if defined(_DEBUG)
     ID3D12DebugDevice* debugInterface;
@@ -788,7 +1033,35 @@ void Graphics::Present(void)
 
     UINT PresentInterval = s_EnableVSync ? std::min(4, (int)Round(s_FrameTime * 60.0f)) : 0;
 
-    s_SwapChain1->Present(PresentInterval, 0);
+    // Tearing is not allowed in exclusive full screen, where an interval of zero already tears
+    UINT PresentFlags = 0;
+    BOOL IsFullscreen = FALSE;
+    if (PresentInterval == 0 && s_TearingSupported && s_AllowTearing &&
+        SUCCEEDED(s_SwapChain1->GetFullscreenState(&IsFullscreen, nullptr)) && !IsFullscreen)
+    {
+        PresentFlags |= DXGI_PRESENT_ALLOW_TEARING;
+    }
+
+    // Everything the frame finished must reach the GPU before the flip is queued behind it
+    g_CommandManager.FlushBatches();
+
+    HRESULT hr = s_SwapChain1->Present(PresentInterval, PresentFlags);
+    if (hr == DXGI_ERROR_DEVICE_REMOVED || hr == DXGI_ERROR_DEVICE_RESET || s_DeviceRemoved)
+    {
+        // The frame bookkeeping below is moot.  Everything is recreated before the next frame.
+        Utility::Printf("Device removed (reason 0x%08X)\n", (uint32_t)g_Device->GetDeviceRemovedReason());
+        s_DeviceRemoved = true;
+        return;
+    }
+
+    // Marks the end of this frame's GPU work for the frames in flight limit
+    s_FrameFences[s_FrameIndex % kMaxFramesInFlight] = g_CommandManager.GetGraphicsQueue().IncrementFence();
+
+    g_CommandManager.UpdateCompletedFences();
+    UpdatePresentLatency();
+    GpuMemory::Update();
+    PlacedResourceAllocator::RetireFrees();
+    ReadbackManager::Update();
 
     // Test robustness to handle spikes in CPU time
     //if (s_DropRandomFrames)
@@ -824,9 +1097,63 @@ void Graphics::Present(void)
     ++s_FrameIndex;
     TemporalEffects::Update((uint32_t)s_FrameIndex);
 
+    UpdateDynamicResolution();
     SetNativeResolution();
 }
 
+void Graphics::WaitForSwapChain(void)
+{
+    UINT MaxFrameLatency = GetMaxFrameLatency();
+    if (MaxFrameLatency != s_MaxFrameLatency)
+    {
+        ComPtr<IDXGISwapChain2> swapChain2;
+        if (SUCCEEDED(s_SwapChain1->QueryInterface(MY_IID_PPV_ARGS(&swapChain2))) &&
+            SUCCEEDED(swapChain2->SetMaximumFrameLatency(MaxFrameLatency)))
+        {
+            s_MaxFrameLatency = MaxFrameLatency;
+        }
+    }
+
+    // Signaled when the swap chain can queue another frame.  The timeout keeps a lost display from hanging us.
+    WaitForSingleObjectEx(s_FrameLatencyWaitable, 1000, TRUE);
+
+    // The display may release us before the GPU has caught up with the frames in flight
+    uint32_t FramesInFlight = (uint32_t)s_FramesInFlight;
+    if (s_FrameIndex >= FramesInFlight)
+        g_CommandManager.WaitForFence(s_FrameFences[(s_FrameIndex - FramesInFlight) % kMaxFramesInFlight]);
+}
+
+void Graphics::BeginFrame(void)
+{
+    s_InputTick = SystemTime::GetCurrentTick();
+}
+
+bool Graphics::IsDeviceRemoved(void)
+{
+    return s_DeviceRemoved;
+}
+
+void Graphics::UpdatePresentLatency(void)
+{
+    UINT PresentCount;
+    if (SUCCEEDED(s_SwapChain1->GetLastPresentCount(&PresentCount)))
+        s_PresentHistory[PresentCount % kPresentHistory] = { PresentCount, s_InputTick };
+
+    // Statistics are unavailable while the window is composed in some modes.  Keep the last measurement.
+    DXGI_FRAME_STATISTICS Stats;
+    if (FAILED(s_SwapChain1->GetFrameStatistics(&Stats)))
+        return;
+
+    const PresentRecord& Record = s_PresentHistory[Stats.PresentCount % kPresentHistory];
+    if (Record.PresentCount == Stats.PresentCount && Record.InputTick != 0 && Stats.SyncQPCTime.QuadPart > Record.InputTick)
+        s_PresentLatency = (float)SystemTime::TimeBetweenTicks(Record.InputTick, Stats.SyncQPCTime.QuadPart);
+}
+
+float Graphics::GetPresentLatency(void)
+{
+    return s_PresentLatency;
+}
+
 uint64_t Graphics::GetFrameCount(void)
 {
     return s_FrameIndex;
@@ -25,6 +25,8 @@ class GraphicsPSO;
 class CommandContext;
 class CommandListManager;
 class CommandSignature;
+class StructuredBuffer;
+class ByteAddressBuffer;
 class ContextManager;
 
 namespace Graphics
@@ -41,6 +43,25 @@ namespace Graphics
     void Shutdown(void);
     void Present(void);
 
+    // Prepares for the process to be suspended, and possibly terminated without notice:  waits for the GPU,
+    // writes the PSO and root signature caches, and evicts video memory so that the OS can reclaim it.
+    void Suspend(void);
+
+    // Undoes Suspend().  The queues wait on the GPU for the memory to become resident, so the next frame can
+    // be recorded right away.
+    void Resume(void);
+
+    // Blocks until the swap chain can accept another frame.  Called before a frame starts so that the CPU
+    // never runs further ahead of the display than the maximum frame latency.
+    void WaitForSwapChain(void);
+
+    // Marks the moment the frame samples input.  Present latency is measured from here.
+    void BeginFrame(void);
+
+    // True once Present() has found the device removed or reset.  Nothing rendered reaches the display until
+    // the device is recreated with Shutdown() and Initialize(), which GameCore does between frames.
+    bool IsDeviceRemoved(void);
+
     extern uint32_t g_DisplayWidth;
     extern uint32_t g_DisplayHeight;
 
@@ -55,12 +76,17 @@ namespace Graphics
     // The total number of frames per second
     float GetFrameRate(void);
 
+    // Seconds from input sampling to the frame reaching the display, as reported by the swap chain's frame
+    // statistics.  Zero until the first statistics are available.
+    float GetPresentLatency(void);
+
     extern ID3D12Device* g_Device;
     extern CommandListManager g_CommandManager;
     extern ContextManager g_ContextManager;
 
     extern D3D_FEATURE_LEVEL g_D3DFeatureLevel;
     extern bool g_bTypedUAVLoadSupport_R11G11B10_FLOAT;
+    extern bool g_bDepthBoundsTestSupported;
     extern bool g_bEnableHDROutput;
 
     extern DescriptorAllocator g_DescriptorAllocator[];
@@ -68,14 +94,24 @@ namespace Graphics
     {
         return g_DescriptorAllocator[Type].Allocate(Count);
     }
+    inline void FreeDescriptor( D3D12_DESCRIPTOR_HEAP_TYPE Type, D3D12_CPU_DESCRIPTOR_HANDLE Handle, UINT Count = 1 )
+    {
+        g_DescriptorAllocator[Type].Free(Handle, Count);
+    }
 
     extern RootSignature g_GenerateMipsRS;
     extern ComputePSO g_GenerateMipsLinearPSO[4];
     extern ComputePSO g_GenerateMipsGammaPSO[4];
+    extern RootSignature g_GenerateMipsSinglePassRS;
+    extern ComputePSO g_GenerateMipsSinglePassLinearPSO;
+    extern ComputePSO g_GenerateMipsSinglePassGammaPSO;
+    extern StructuredBuffer g_GenerateMipsScratch;
+    extern ByteAddressBuffer g_GenerateMipsCounter;
 
     enum eResolution { k720p, k900p, k1080p, k1440p, k1800p, k2160p };
 
     extern BoolVar s_EnableVSync;
+    extern BoolVar s_LowLatencyMode;
     extern EnumVar TargetResolution;
     extern uint32_t g_DisplayWidth;
     extern uint32_t g_DisplayHeight;
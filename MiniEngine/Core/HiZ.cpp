@@ -0,0 +1,141 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Developed by Minigraph
+//
+
+#include "pch.h"
+#include "HiZ.h"
+#include "BufferManager.h"
+#include "GraphicsCore.h"
+#include "CommandContext.h"
+#include "Camera.h"
+#include "EngineProfiling.h"
+
+#include "CompiledShaders/HiZInitCS.h"
+#include "CompiledShaders/HiZInitMSAACS.h"
+#include "CompiledShaders/HiZDownsampleCS.h"
+
+using namespace Graphics;
+using namespace Math;
+
+namespace
+{
+    RootSignature s_RootSignature;
+    ComputePSO s_InitCS;
+    ComputePSO s_InitMSAACS;
+    ComputePSO s_DownsampleCS;
+
+    uint64_t s_LastBuildFrame = ~0ull;
+    ID3D12Resource* s_BuiltResource = nullptr;    // g_HiZMinDepth when it was last built
+    Matrix4 s_ViewProj;
+}
+
+void HiZ::Initialize( void )
+{
+    s_RootSignature.Reset(3, 0);
+    s_RootSignature[0].InitAsConstants(0, 4);
+    s_RootSignature[1].InitAsDescriptorRange(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 0, 1);
+    s_RootSignature[2].InitAsDescriptorRange(D3D12_DESCRIPTOR_RANGE_TYPE_UAV, 0, 4);
+    s_RootSignature.Finalize(L"HiZ");
+
+#define CreatePSO( ObjName, ShaderByteCode ) \
+    ObjName.SetRootSignature(s_RootSignature); \
+    ObjName.SetComputeShader(ShaderByteCode, sizeof(ShaderByteCode) ); \
+    ObjName.Finalize();
+
+    CreatePSO( s_InitCS, g_pHiZInitCS );
+    CreatePSO( s_InitMSAACS, g_pHiZInitMSAACS );
+    CreatePSO( s_DownsampleCS, g_pHiZDownsampleCS );
+
+#undef CreatePSO
+}
+
+void HiZ::Shutdown( void )
+{
+    s_BuiltResource = nullptr;
+}
+
+uint32_t HiZ::ComputeMipCount( uint32_t Width, uint32_t Height )
+{
+    uint32_t MipCount = 1;
+    while (((Width | Height) >> MipCount) != 0 && MipCount < kMaxMips)
+        ++MipCount;
+    return MipCount;
+}
+
+bool HiZ::IsValid( void )
+{
+    return s_BuiltResource != nullptr && s_BuiltResource == g_HiZMinDepth.GetResource();
+}
+
+const Matrix4& HiZ::GetViewProjMatrix( void )
+{
+    return s_ViewProj;
+}
+
+void HiZ::Build( ComputeContext& Context, DepthBuffer& Depth, const BaseCamera& Camera )
+{
+    if (s_LastBuildFrame == Graphics::GetFrameCount() && IsValid())
+        return;
+
+    // Mip 0 always covers the whole depth buffer, rounding up
+    ASSERT(g_HiZMinDepth.GetWidth() == (Depth.GetWidth() + 1) / 2 && g_HiZMinDepth.GetHeight() == (Depth.GetHeight() + 1) / 2);
+
+    ScopedTimer _prof(L"Build Hi-Z", Context);
+
+    const uint32_t MipCount = ComputeMipCount(g_HiZMinDepth.GetWidth(), g_HiZMinDepth.GetHeight());
+
+    uint32_t SrcWidth = Depth.GetWidth();
+    uint32_t SrcHeight = Depth.GetHeight();
+    uint32_t DstWidth = g_HiZMinDepth.GetWidth();
+    uint32_t DstHeight = g_HiZMinDepth.GetHeight();
+
+    Context.SetRootSignature(s_RootSignature);
+    Context.SetPipelineState(Depth.GetSampleCount() > 1 ? s_InitMSAACS : s_InitCS);
+
+    Context.TransitionDepthToReadOnly(Depth);
+    Context.TransitionResource(g_HiZMinDepth, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+    Context.TransitionResource(g_HiZMaxDepth, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+
+    Context.SetConstants(0, SrcWidth, SrcHeight, DstWidth, DstHeight);
+    Context.SetDynamicDescriptor(1, 0, Depth.GetDepthSRV());
+    Context.SetDynamicDescriptor(2, 2, g_HiZMinDepth.GetUAV(0));
+    Context.SetDynamicDescriptor(2, 3, g_HiZMaxDepth.GetUAV(0));
+    Context.Dispatch2D(DstWidth, DstHeight);
+
+    Context.SetPipelineState(s_DownsampleCS);
+
+    for (uint32_t Mip = 1; Mip < MipCount; ++Mip)
+    {
+        Context.InsertUAVBarrier(g_HiZMinDepth);
+        Context.InsertUAVBarrier(g_HiZMaxDepth);
+
+        SrcWidth = DstWidth;
+        SrcHeight = DstHeight;
+        DstWidth = std::max(SrcWidth / 2, 1u);
+        DstHeight = std::max(SrcHeight / 2, 1u);
+
+        D3D12_CPU_DESCRIPTOR_HANDLE MipUAVs[4] =
+        {
+            g_HiZMinDepth.GetUAV(Mip - 1), g_HiZMaxDepth.GetUAV(Mip - 1),
+            g_HiZMinDepth.GetUAV(Mip), g_HiZMaxDepth.GetUAV(Mip)
+        };
+
+        Context.SetConstants(0, SrcWidth, SrcHeight, DstWidth, DstHeight);
+        Context.SetDynamicDescriptors(2, 0, 4, MipUAVs);
+        Context.Dispatch2D(DstWidth, DstHeight);
+    }
+
+    Context.TransitionResource(g_HiZMinDepth, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+    Context.TransitionResource(g_HiZMaxDepth, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+
+    s_LastBuildFrame = Graphics::GetFrameCount();
+    s_BuiltResource = g_HiZMinDepth.GetResource();
+    s_ViewProj = Camera.GetViewProjMatrix();
+}
@@ -0,0 +1,46 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Developed by Minigraph
+//
+
+#pragma once
+
+#include <cstdint>
+
+class ComputeContext;
+class DepthBuffer;
+namespace Math { class BaseCamera; class Matrix4; }
+
+// Builds the hierarchical depth pyramids g_HiZMinDepth and g_HiZMaxDepth (see BufferManager.h) from a depth
+// buffer.  Mip 0 is half the depth buffer resolution, and every texel holds the smallest and largest depth
+// of the texels it covers.  With reversed Z, the min pyramid is the farthest depth (for occlusion tests) and
+// the max pyramid is the nearest (for ray marching and tile rejection).  With an infinite far plane the clear
+// depth of 0 is infinitely far away, so uncovered texels occlude nothing.
+namespace HiZ
+{
+    enum { kMaxMips = 12 };
+
+    void Initialize( void );
+    void Shutdown( void );
+
+    // Only the first call in a frame reduces the depth buffer; later calls return immediately, so every
+    // consumer can call it before reading the pyramids.  The camera is the one Depth was rendered with.
+    // An MSAA depth buffer is resolved to min/max of its samples as mip 0 is built, which also reduces
+    // the samples of edge pixels that a single-sample resolve would have lost.
+    void Build( ComputeContext& Context, DepthBuffer& Depth, const Math::BaseCamera& Camera );
+
+    // False until Build() has filled the pyramids since they were last (re)created
+    bool IsValid( void );
+
+    // The view-projection matrix of the camera passed to the last Build()
+    const Math::Matrix4& GetViewProjMatrix( void );
+
+    // Mips in a pyramid whose mip 0 is Width x Height, down to 1x1 or kMaxMips
+    uint32_t ComputeMipCount( uint32_t Width, uint32_t Height );
+}
@@ -0,0 +1,313 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Developed by Minigraph
+//
+
+#include "pch.h"
+#include "JobSystem.h"
+#include <thread>
+#include <deque>
+#include <condition_variable>
+
+using namespace std;
+
+namespace JobSystem
+{
+    // Each queue is guarded by its own lock, which is only contended when a thief shows up.  The owner
+    // pushes and pops at the back, thieves take from the front.
+    struct WorkQueue
+    {
+        mutex Mutex;
+        deque<Job> Jobs;
+    };
+
+    class Scheduler
+    {
+    public:
+        static void Submit( Job& job );
+        static void Push( Job& job );
+        static void Finish( Job& job );
+        static bool TryRunJob( uint32_t ThreadIndex );
+        static bool TryRunMainThreadJob( void );
+        static void RunAfter( Counter& Dependency, Job& job );
+        static void Wait( Counter& counter );
+        static void WorkerMain( uint32_t ThreadIndex );
+    };
+
+    vector<thread> s_Workers;
+    unique_ptr<WorkQueue[]> s_Queues;
+    uint32_t s_ThreadCount = 0;
+    WorkQueue s_MainThreadQueue;
+    atomic<uint32_t> s_NextQueue(0);
+    atomic<bool> s_Quit(false);
+
+    // Idle workers sleep until a job is queued.  Pushing only takes the sleep lock when a worker sleeps.
+    mutex s_SleepMutex;
+    condition_variable s_WakeCondition;
+    atomic<int32_t> s_QueuedJobs(0);
+    atomic<uint32_t> s_SleepingWorkers(0);
+
+    __declspec(thread) uint32_t s_ThreadIndex = ~0u;
+}
+
+using namespace JobSystem;
+
+void Scheduler::Submit( Job& job )
+{
+    if (job.pCounter != nullptr)
+        job.pCounter->m_Pending++;
+
+    Push(job);
+}
+
+void Scheduler::Push( Job& job )
+{
+    if (job.Flags & kMainThread)
+    {
+        lock_guard<mutex> LockGuard(s_MainThreadQueue.Mutex);
+        s_MainThreadQueue.Jobs.push_back(move(job));
+        return;
+    }
+
+    // Worker threads keep their jobs.  Other threads spread theirs round robin.
+    uint32_t QueueIndex = s_ThreadIndex < s_ThreadCount ? s_ThreadIndex : s_NextQueue++ % s_ThreadCount;
+
+    {
+        lock_guard<mutex> LockGuard(s_Queues[QueueIndex].Mutex);
+        s_Queues[QueueIndex].Jobs.push_back(move(job));
+    }
+
+    // A worker that went to sleep before the increment is woken.  One that checks afterwards sees the job.
+    s_QueuedJobs++;
+    if (s_SleepingWorkers > 0)
+    {
+        { lock_guard<mutex> SleepLock(s_SleepMutex); }
+        s_WakeCondition.notify_one();
+    }
+}
+
+void Scheduler::Finish( Job& job )
+{
+    Counter* pCounter = job.pCounter;
+    if (pCounter == nullptr)
+        return;
+
+    // The counter lock is held across the decrement so that Wait() can't return, and the counter can't be
+    // destroyed, while the continuations are being moved out.
+    vector<Job> Continuations;
+    {
+        lock_guard<mutex> LockGuard(pCounter->m_Mutex);
+        if (pCounter->m_Pending.fetch_sub(1, memory_order_acq_rel) == 1)
+            Continuations.swap(pCounter->m_Continuations);
+    }
+
+    for (Job& Continuation : Continuations)
+        Push(Continuation);
+}
+
+bool Scheduler::TryRunJob( uint32_t ThreadIndex )
+{
+    Job job;
+    bool Found = false;
+
+    {
+        WorkQueue& Queue = s_Queues[ThreadIndex];
+        lock_guard<mutex> LockGuard(Queue.Mutex);
+        if (!Queue.Jobs.empty())
+        {
+            job = move(Queue.Jobs.back());
+            Queue.Jobs.pop_back();
+            Found = true;
+        }
+    }
+
+    for (uint32_t i = 1; !Found && i < s_ThreadCount; ++i)
+    {
+        WorkQueue& Victim = s_Queues[(ThreadIndex + i) % s_ThreadCount];
+        lock_guard<mutex> LockGuard(Victim.Mutex);
+        if (!Victim.Jobs.empty())
+        {
+            job = move(Victim.Jobs.front());
+            Victim.Jobs.pop_front();
+            Found = true;
+        }
+    }
+
+    if (!Found)
+        return false;
+
+    s_QueuedJobs--;
+    job.Func();
+    Finish(job);
+    return true;
+}
+
+bool Scheduler::TryRunMainThreadJob( void )
+{
+    Job job;
+
+    {
+        lock_guard<mutex> LockGuard(s_MainThreadQueue.Mutex);
+        if (s_MainThreadQueue.Jobs.empty())
+            return false;
+        job = move(s_MainThreadQueue.Jobs.front());
+        s_MainThreadQueue.Jobs.pop_front();
+    }
+
+    job.Func();
+    Finish(job);
+    return true;
+}
+
+void Scheduler::RunAfter( Counter& Dependency, Job& job )
+{
+    if (job.pCounter != nullptr)
+        job.pCounter->m_Pending++;
+
+    {
+        lock_guard<mutex> LockGuard(Dependency.m_Mutex);
+        if (!Dependency.IsDone())
+        {
+            Dependency.m_Continuations.push_back(move(job));
+            return;
+        }
+    }
+
+    Push(job);
+}
+
+void Scheduler::Wait( Counter& counter )
+{
+    const uint32_t ThreadIndex = s_ThreadIndex;
+
+    while (!counter.IsDone())
+    {
+        if (ThreadIndex == 0 && TryRunMainThreadJob())
+            continue;
+
+        // Threads outside the scheduler can't run jobs, because jobs assume a worker's thread index
+        if (ThreadIndex < s_ThreadCount && TryRunJob(ThreadIndex))
+            continue;
+
+        this_thread::yield();
+    }
+
+    // Let the thread that finished the last job release the counter
+    lock_guard<mutex> LockGuard(counter.m_Mutex);
+}
+
+void Scheduler::WorkerMain( uint32_t ThreadIndex )
+{
+    s_ThreadIndex = ThreadIndex;
+
+    while (!s_Quit)
+    {
+        if (TryRunJob(ThreadIndex))
+            continue;
+
+        unique_lock<mutex> SleepLock(s_SleepMutex);
+        s_SleepingWorkers++;
+        s_WakeCondition.wait(SleepLock, [] { return s_Quit || s_QueuedJobs > 0; });
+        s_SleepingWorkers--;
+    }
+}
+
+void JobSystem::Initialize( uint32_t NumWorkers )
+{
+    ASSERT(s_ThreadCount == 0, "The job system has already been initialized");
+
+    if (NumWorkers == 0)
+        NumWorkers = max(thread::hardware_concurrency(), 2u) - 1;
+
+    s_ThreadCount = NumWorkers + 1;
+    s_Queues.reset(new WorkQueue[s_ThreadCount]);
+    s_ThreadIndex = 0;
+    s_Quit = false;
+
+    for (uint32_t i = 1; i < s_ThreadCount; ++i)
+        s_Workers.push_back(thread(Scheduler::WorkerMain, i));
+}
+
+void JobSystem::Shutdown( void )
+{
+    {
+        lock_guard<mutex> LockGuard(s_SleepMutex);
+        s_Quit = true;
+    }
+    s_WakeCondition.notify_all();
+
+    for (thread& Worker : s_Workers)
+        Worker.join();
+
+    s_Workers.clear();
+    s_Queues.reset();
+    s_ThreadCount = 0;
+}
+
+uint32_t JobSystem::GetThreadCount( void )
+{
+    return s_ThreadCount;
+}
+
+uint32_t JobSystem::GetThreadIndex( void )
+{
+    return s_ThreadIndex;
+}
+
+void JobSystem::Run( const JobFunc& Func, Counter* pCounter, uint32_t Flags )
+{
+    ASSERT(s_ThreadCount > 0, "The job system is not initialized");
+
+    Job job = { Func, pCounter, Flags };
+    Scheduler::Submit(job);
+}
+
+void JobSystem::RunAfter( Counter& Dependency, const JobFunc& Func, Counter* pCounter, uint32_t Flags )
+{
+    Job job = { Func, pCounter, Flags };
+    Scheduler::RunAfter(Dependency, job);
+}
+
+void JobSystem::Wait( Counter& counter )
+{
+    Scheduler::Wait(counter);
+}
+
+void JobSystem::ParallelFor( uint32_t Begin, uint32_t End, uint32_t Grain, const function<void(uint32_t)>& Func )
+{
+    if (End <= Begin)
+        return;
+
+    Grain = max(Grain, 1u);
+
+    // The calling thread takes the first chunk itself rather than waiting idle for it
+    Counter Chunks;
+    for (uint32_t ChunkBegin = Begin + Grain; ChunkBegin < End; ChunkBegin += Grain)
+    {
+        uint32_t ChunkEnd = min(ChunkBegin + Grain, End);
+        Run([&Func, ChunkBegin, ChunkEnd]
+        {
+            for (uint32_t i = ChunkBegin; i < ChunkEnd; ++i)
+                Func(i);
+        }, &Chunks);
+    }
+
+    for (uint32_t i = Begin; i < min(Begin + Grain, End); ++i)
+        Func(i);
+
+    Wait(Chunks);
+}
+
+void JobSystem::RunMainThreadJobs( void )
+{
+    ASSERT(s_ThreadIndex == 0, "Main thread jobs must run on the main thread");
+
+    while (Scheduler::TryRunMainThreadJob())
+        ;
+}
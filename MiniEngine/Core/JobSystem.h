@@ -0,0 +1,93 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Developed by Minigraph
+//
+// Description:  A work-stealing job scheduler.  Each worker thread owns a queue of jobs.  It runs the newest
+// job of its own queue first, which keeps recently touched data in cache.  When that queue is empty it steals
+// the oldest job of another worker.  The main thread counts as worker zero.
+//
+// Jobs are lightweight closures, not fibers, so a job that waits on a counter runs other jobs on its own
+// stack until the counter reaches zero.  Counters track outstanding jobs, and jobs can be made to start
+// only once a counter reaches zero.  Jobs that must run on the main thread (e.g. those that touch the window
+// or the immediate command context) have main thread affinity.  They run when the main thread waits and
+// once per frame in GameCore.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include <functional>
+
+namespace JobSystem
+{
+    typedef std::function<void(void)> JobFunc;
+
+    enum JobFlags
+    {
+        kAnyThread = 0,
+        kMainThread = 1,
+    };
+
+    class Counter;
+    class Scheduler;
+
+    struct Job
+    {
+        JobFunc Func;
+        Counter* pCounter;
+        uint32_t Flags;
+    };
+
+    // Counts the unfinished jobs that were given it.  A counter must outlive its jobs, which Wait() ensures.
+    class Counter
+    {
+        friend class Scheduler;
+
+    public:
+        Counter() : m_Pending(0) {}
+        Counter( const Counter& ) = delete;
+        Counter& operator=( const Counter& ) = delete;
+
+        bool IsDone( void ) const { return m_Pending.load(std::memory_order_acquire) == 0; }
+
+    private:
+        std::atomic<uint32_t> m_Pending;
+        std::mutex m_Mutex;
+        std::vector<Job> m_Continuations;
+    };
+
+    // NumWorkers excludes the main thread.  Zero uses one worker per remaining hardware thread.
+    void Initialize( uint32_t NumWorkers = 0 );
+    void Shutdown( void );
+
+    // Includes the main thread
+    uint32_t GetThreadCount( void );
+
+    // Index of the calling thread, from zero for the main thread to GetThreadCount() - 1.  Threads outside
+    // the scheduler get ~0u.
+    uint32_t GetThreadIndex( void );
+
+    // Queue a job.  If given, the counter is incremented now and decremented when the job finishes.
+    void Run( const JobFunc& Func, Counter* pCounter = nullptr, uint32_t Flags = kAnyThread );
+
+    // Queue a job that starts once Dependency reaches zero.  Dependency must not gain new jobs in between.
+    void RunAfter( Counter& Dependency, const JobFunc& Func, Counter* pCounter = nullptr, uint32_t Flags = kAnyThread );
+
+    // Run other jobs until the counter reaches zero
+    void Wait( Counter& counter );
+
+    // Split [Begin, End) into chunks of Grain indices, run them in parallel and wait for all of them
+    void ParallelFor( uint32_t Begin, uint32_t End, uint32_t Grain, const std::function<void(uint32_t)>& Func );
+
+    // Run the queued main thread jobs.  Called by GameCore at the start of every frame.
+    void RunMainThreadJobs( void );
+}
@@ -0,0 +1,52 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Developed by Minigraph
+//
+
+#include "pch.h"
+#include "LateLatch.h"
+#include "CommandContext.h"
+#include <mutex>
+
+namespace LateLatch
+{
+    struct Reservation
+    {
+        void* DataPtr;
+        std::function<void(void*)> Writer;
+    };
+
+    std::mutex s_Mutex;
+    std::vector<Reservation> s_Pending;
+    std::vector<Reservation> s_Latching;
+}
+
+D3D12_GPU_VIRTUAL_ADDRESS LateLatch::Reserve( CommandContext& Context, size_t SizeInBytes, std::function<void(void*)> Writer )
+{
+    DynAlloc Alloc = Context.ReserveUploadMemory(SizeInBytes);
+
+    std::lock_guard<std::mutex> Lock(s_Mutex);
+    s_Pending.push_back({ Alloc.DataPtr, std::move(Writer) });
+    return Alloc.GpuAddress;
+}
+
+void LateLatch::Latch( void )
+{
+    // Submissions are serialized by their queue, so only Reserve() can race with this
+    {
+        std::lock_guard<std::mutex> Lock(s_Mutex);
+        if (s_Pending.empty())
+            return;
+        s_Latching.swap(s_Pending);
+    }
+
+    for (Reservation& R : s_Latching)
+        R.Writer(R.DataPtr);
+    s_Latching.clear();
+}
@@ -0,0 +1,30 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Developed by Minigraph
+//
+
+#pragma once
+
+#include <functional>
+
+class CommandContext;
+
+// Constant data that is written when the command lists are submitted rather than when the commands that read it
+// are recorded.  Recording a frame takes most of a frame, so data that tracks input, such as the main view's
+// camera, would otherwise be that much older than the input by the time the GPU reads it.
+namespace LateLatch
+{
+    // Reserve upload memory on Context, to be bound by the returned GPU address.  Writer fills it in just
+    // before the next submission to the graphics queue, so every command list that reads it must be submitted
+    // to the graphics queue after this call.
+    D3D12_GPU_VIRTUAL_ADDRESS Reserve( CommandContext& Context, size_t SizeInBytes, std::function<void(void*)> Writer );
+
+    // Run the writers of every reservation.  Called by the graphics queue before it submits command lists.
+    void Latch( void );
+}
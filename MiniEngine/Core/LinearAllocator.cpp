@@ -16,6 +16,7 @@
 #include "LinearAllocator.h"
 #include "GraphicsCore.h"
 #include "CommandListManager.h"
+#include "GpuMemory.h"
 #include <thread>
 
 using namespace Graphics;
@@ -23,7 +24,32 @@ using namespace std;
 
 LinearAllocatorType LinearAllocatorPageManager::sm_AutoType = kGpuExclusive;
 
-LinearAllocatorPageManager::LinearAllocatorPageManager()
+namespace
+{
+    // A small per-thread cache of pages whose fences are known to have completed.  Most requests are
+    // satisfied from here without touching any shared state.
+    struct PageMagazine
+    {
+        enum { kCapacity = 4 };
+
+        uint32_t Generation;
+        uint32_t Count;
+        LinearAllocationPage* Pages[kCapacity];
+    };
+
+    thread_local PageMagazine t_PageMagazines[kNumAllocatorTypes];
+}
+
+LinearAllocatorPageManager::LinearAllocatorPageManager() :
+    m_RetiredPages(nullptr),
+    m_Generation(1),
+    m_NumPendingDeletions(0),
+    m_NumPagesRequested(0),
+    m_NumMagazineHits(0),
+    m_NumRetiredListScans(0),
+    m_NumContendedPushes(0),
+    m_NumLockAcquisitions(0),
+    m_NumPagesCreated(0)
 {
     m_AllocationType = sm_AutoType;
     sm_AutoType = (LinearAllocatorType)(sm_AutoType + 1);
@@ -34,39 +60,109 @@ LinearAllocatorPageManager LinearAllocator::sm_PageManager[2];
 
 LinearAllocationPage* LinearAllocatorPageManager::RequestPage()
 {
-    lock_guard<mutex> LockGuard(m_Mutex);
+    m_NumPagesRequested.fetch_add(1, memory_order_relaxed);
+
+    PageMagazine& Magazine = t_PageMagazines[m_AllocationType];
 
-    while (!m_RetiredPages.empty() && g_CommandManager.IsFenceComplete(m_RetiredPages.front().first))
+    // Pages cached before the last Destroy() no longer exist
+    const uint32_t Generation = m_Generation.load(memory_order_acquire);
+    if (Magazine.Generation != Generation)
     {
-        m_AvailablePages.push(m_RetiredPages.front().second);
-        m_RetiredPages.pop();
+        Magazine.Generation = Generation;
+        Magazine.Count = 0;
     }
 
-    LinearAllocationPage* PagePtr = nullptr;
-
-    if (!m_AvailablePages.empty())
+    if (Magazine.Count > 0)
     {
-        PagePtr = m_AvailablePages.front();
-        m_AvailablePages.pop();
+        m_NumMagazineHits.fetch_add(1, memory_order_relaxed);
+        return Magazine.Pages[--Magazine.Count];
     }
-    else
+
+    // Claim the entire retired list.  Taking every node at once (rather than popping the head) keeps the
+    // list free of ABA problems, and no other thread can observe the nodes while we sort through them.
+    LinearAllocationPage* RetiredList = m_RetiredPages.exchange(nullptr, memory_order_acquire);
+
+    if (RetiredList != nullptr)
     {
-        PagePtr = CreateNewPage();
-        m_PagePool.emplace_back(PagePtr);
+        m_NumRetiredListScans.fetch_add(1, memory_order_relaxed);
+
+        LinearAllocationPage* KeepFirst = nullptr;
+        LinearAllocationPage* KeepLast = nullptr;
+
+        while (RetiredList != nullptr)
+        {
+            LinearAllocationPage* Page = RetiredList;
+            RetiredList = Page->m_NextRetiredPage;
+
+            if (Magazine.Count < PageMagazine::kCapacity && g_CommandManager.IsFenceComplete(Page->m_RetiredFenceValue))
+            {
+                Page->m_NextRetiredPage = nullptr;
+                Magazine.Pages[Magazine.Count++] = Page;
+            }
+            else
+            {
+                Page->m_NextRetiredPage = KeepFirst;
+                KeepFirst = Page;
+                if (KeepLast == nullptr)
+                    KeepLast = Page;
+            }
+        }
+
+        // Give back whatever is still in flight (or didn't fit)
+        if (KeepFirst != nullptr)
+            PushRetiredPages(KeepFirst, KeepLast);
+
+        if (Magazine.Count > 0)
+            return Magazine.Pages[--Magazine.Count];
     }
 
+    LinearAllocationPage* PagePtr = CreateNewPage();
+
+    m_NumLockAcquisitions.fetch_add(1, memory_order_relaxed);
+    m_NumPagesCreated.fetch_add(1, memory_order_relaxed);
+
+    lock_guard<mutex> LockGuard(m_Mutex);
+    m_PagePool.emplace_back(PagePtr);
+
     return PagePtr;
 }
 
+void LinearAllocatorPageManager::PushRetiredPages( LinearAllocationPage* First, LinearAllocationPage* Last )
+{
+    LinearAllocationPage* Head = m_RetiredPages.load(memory_order_relaxed);
+    do
+    {
+        Last->m_NextRetiredPage = Head;
+        if (m_RetiredPages.compare_exchange_weak(Head, First, memory_order_release, memory_order_relaxed))
+            break;
+        m_NumContendedPushes.fetch_add(1, memory_order_relaxed);
+    }
+    while (true);
+}
+
 void LinearAllocatorPageManager::DiscardPages( uint64_t FenceValue, const vector<LinearAllocationPage*>& UsedPages )
 {
-    lock_guard<mutex> LockGuard(m_Mutex);
-    for (auto iter = UsedPages.begin(); iter != UsedPages.end(); ++iter)
-        m_RetiredPages.push(make_pair(FenceValue, *iter));
+    if (UsedPages.empty())
+        return;
+
+    // Link the pages into a chain so they can be published with a single compare-and-swap
+    for (size_t i = 0; i < UsedPages.size(); ++i)
+    {
+        UsedPages[i]->m_RetiredFenceValue = FenceValue;
+        UsedPages[i]->m_NextRetiredPage = i + 1 < UsedPages.size() ? UsedPages[i + 1] : nullptr;
+    }
+
+    PushRetiredPages(UsedPages.front(), UsedPages.back());
 }
 
 void LinearAllocatorPageManager::FreeLargePages( uint64_t FenceValue, const vector<LinearAllocationPage*>& LargePages )
 {
+    // Nothing to queue and nothing waiting to be deleted
+    if (LargePages.empty() && m_NumPendingDeletions.load(memory_order_relaxed) == 0)
+        return;
+
+    m_NumLockAcquisitions.fetch_add(1, memory_order_relaxed);
+
     lock_guard<mutex> LockGuard(m_Mutex);
 
     while (!m_DeletionQueue.empty() && g_CommandManager.IsFenceComplete(m_DeletionQueue.front().first))
@@ -80,6 +176,38 @@ void LinearAllocatorPageManager::FreeLargePages( uint64_t FenceValue, const vect
         (*iter)->Unmap();
         m_DeletionQueue.push(make_pair(FenceValue, *iter));
     }
+
+    m_NumPendingDeletions.store((uint32_t)m_DeletionQueue.size(), memory_order_relaxed);
+}
+
+void LinearAllocatorPageManager::Destroy( void )
+{
+#ifndef RELEASE
+    Statistics Stats = GetStatistics();
+    DEBUGPRINT("LinearAllocator[%s]: %llu page requests, %llu magazine hits, %llu retired list scans, "
+        "%llu contended pushes, %llu lock acquisitions, %llu pages created",
+        m_AllocationType == kGpuExclusive ? "GPU" : "CPU", Stats.PagesRequested, Stats.MagazineHits,
+        Stats.RetiredListScans, Stats.ContendedPushes, Stats.LockAcquisitions, Stats.PagesCreated);
+#endif
+
+    lock_guard<mutex> LockGuard(m_Mutex);
+
+    // Invalidate every thread's magazine before releasing the pages they might reference
+    m_Generation.fetch_add(1, memory_order_release);
+    m_RetiredPages.store(nullptr, memory_order_relaxed);
+    m_PagePool.clear();
+}
+
+LinearAllocatorPageManager::Statistics LinearAllocatorPageManager::GetStatistics( void ) const
+{
+    Statistics Stats;
+    Stats.PagesRequested = m_NumPagesRequested.load(memory_order_relaxed);
+    Stats.MagazineHits = m_NumMagazineHits.load(memory_order_relaxed);
+    Stats.RetiredListScans = m_NumRetiredListScans.load(memory_order_relaxed);
+    Stats.ContendedPushes = m_NumContendedPushes.load(memory_order_relaxed);
+    Stats.LockAcquisitions = m_NumLockAcquisitions.load(memory_order_relaxed);
+    Stats.PagesCreated = m_NumPagesCreated.load(memory_order_relaxed);
+    return Stats;
 }
 
 LinearAllocationPage* LinearAllocatorPageManager::CreateNewPage( size_t PageSize  )
@@ -123,6 +251,7 @@ LinearAllocationPage* LinearAllocatorPageManager::CreateNewPage( size_t PageSize
         &ResourceDesc, DefaultUsage, nullptr, MY_IID_PPV_ARGS(&pBuffer)) );
 
     pBuffer->SetName(L"LinearAllocator Page");
+    GpuMemory::Track(pBuffer, GpuMemory::kDynamic);
 
     return new LinearAllocationPage(pBuffer, DefaultUsage);
 }
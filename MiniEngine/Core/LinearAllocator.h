@@ -13,8 +13,10 @@
 // Description:  This is a dynamic graphics memory allocator for DX12.  It's designed to work in concert
 // with the CommandContext class and to do so in a thread-safe manner.  There may be many command contexts,
 // each with its own linear allocators.  They act as windows into a global memory pool by reserving a
-// context-local memory page.  Requesting a new page is done in a thread-safe manner by guarding accesses
-// with a mutex lock.
+// context-local memory page.  Requesting a new page is done in a thread-safe manner without taking a lock:
+// each thread keeps a small magazine of reusable pages, and retired pages are published to a lock-free list
+// tagged with the fence value that must be reached before they can be reused.  Only the creation of new pages
+// and the deletion of large pages are guarded by a mutex.
 //
 // When a command context is finished, it will receive a fence ID that indicates when it's safe to reclaim
 // used resources.  The CleanupUsedPages() method must be invoked at this time so that the used pages can be
@@ -26,6 +28,7 @@
 #include <vector>
 #include <queue>
 #include <mutex>
+#include <atomic>
 
 // Constant blocks must be multiples of 16 constants @ 16 bytes each
 #define DEFAULT_ALIGN 256
@@ -46,7 +49,8 @@ struct DynAlloc
 class LinearAllocationPage : public GpuResource
 {
 public:
-    LinearAllocationPage(ID3D12Resource* pResource, D3D12_RESOURCE_STATES Usage) : GpuResource()
+    LinearAllocationPage(ID3D12Resource* pResource, D3D12_RESOURCE_STATES Usage) : GpuResource(),
+        m_NextRetiredPage(nullptr), m_RetiredFenceValue(0)
     {
         m_pResource.Attach(pResource);
         m_UsageState = Usage;
@@ -78,6 +82,10 @@ public:
 
     void* m_CpuVirtualAddress;
     D3D12_GPU_VIRTUAL_ADDRESS m_GpuVirtualAddress;
+
+    // Intrusive link for the page manager's lock-free list of retired pages
+    LinearAllocationPage* m_NextRetiredPage;
+    uint64_t m_RetiredFenceValue;
 };
 
 enum LinearAllocatorType
@@ -100,6 +108,17 @@ class LinearAllocatorPageManager
 {
 public:
 
+    // Counters for tracking how often page requests had to touch shared state
+    struct Statistics
+    {
+        uint64_t PagesRequested;        // Calls to RequestPage()
+        uint64_t MagazineHits;          // Requests satisfied by the calling thread's magazine
+        uint64_t RetiredListScans;      // Times the retired list was claimed to refill a magazine
+        uint64_t ContendedPushes;       // Failed compare-and-swaps while publishing retired pages
+        uint64_t LockAcquisitions;      // Times the mutex was taken (page creation, large page deletion)
+        uint64_t PagesCreated;          // Fixed size pages created
+    };
+
     LinearAllocatorPageManager();
     LinearAllocationPage* RequestPage( void );
     LinearAllocationPage* CreateNewPage( size_t PageSize = 0 );
@@ -111,18 +130,36 @@ public:
     // "large" pages.
     void FreeLargePages( uint64_t FenceID, const std::vector<LinearAllocationPage*>& Pages );
 
-    void Destroy( void ) { m_PagePool.clear(); }
+    void Destroy( void );
+
+    Statistics GetStatistics( void ) const;
 
 private:
 
+    // Publish a chain of retired pages, linked through m_NextRetiredPage, to the retired list
+    void PushRetiredPages( LinearAllocationPage* First, LinearAllocationPage* Last );
+
     static LinearAllocatorType sm_AutoType;
 
     LinearAllocatorType m_AllocationType;
     std::vector<std::unique_ptr<LinearAllocationPage> > m_PagePool;
-    std::queue<std::pair<uint64_t, LinearAllocationPage*> > m_RetiredPages;
     std::queue<std::pair<uint64_t, LinearAllocationPage*> > m_DeletionQueue;
-    std::queue<LinearAllocationPage*> m_AvailablePages;
     std::mutex m_Mutex;
+
+    // Retired pages waiting on their fence.  Consumers claim the whole list at once, so there is no ABA hazard.
+    std::atomic<LinearAllocationPage*> m_RetiredPages;
+
+    // Bumped by Destroy() to invalidate pages cached in thread-local magazines
+    std::atomic<uint32_t> m_Generation;
+
+    std::atomic<uint32_t> m_NumPendingDeletions;
+
+    std::atomic<uint64_t> m_NumPagesRequested;
+    std::atomic<uint64_t> m_NumMagazineHits;
+    std::atomic<uint64_t> m_NumRetiredListScans;
+    std::atomic<uint64_t> m_NumContendedPushes;
+    std::atomic<uint64_t> m_NumLockAcquisitions;
+    std::atomic<uint64_t> m_NumPagesCreated;
 };
 
 class LinearAllocator
@@ -145,6 +182,11 @@ public:
         sm_PageManager[1].Destroy();
     }
 
+    static LinearAllocatorPageManager::Statistics GetPageStatistics( LinearAllocatorType Type )
+    {
+        return sm_PageManager[Type].GetStatistics();
+    }
+
 private:
 
     DynAlloc AllocateLargePage( size_t SizeInBytes );
@@ -0,0 +1,109 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Developed by Minigraph
+//
+
+#include "pch.h"
+#include "MSAAResolve.h"
+#include "BufferManager.h"
+#include "GraphicsCore.h"
+#include "CommandContext.h"
+#include "PostEffects.h"
+#include "EngineProfiling.h"
+
+#include "CompiledShaders/ScreenQuadVS.h"
+#include "CompiledShaders/MSAAResolveDepthPS.h"
+#include "CompiledShaders/MSAAResolveColorCS.h"
+
+using namespace Graphics;
+
+namespace MSAAResolve
+{
+    BoolVar Enable("Graphics/AA/MSAA/Enable", false);
+    BoolVar TonemapWeighted("Graphics/AA/MSAA/Tonemap Weighted Resolve", true);
+
+    RootSignature s_RootSignature;
+    GraphicsPSO s_ResolveDepthPS;
+    ComputePSO s_ResolveColorCS;
+}
+
+void MSAAResolve::Initialize( void )
+{
+    s_RootSignature.Reset(3, 0);
+    s_RootSignature[0].InitAsConstants(0, 4);
+    s_RootSignature[1].InitAsDescriptorRange(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 0, 2);
+    s_RootSignature[2].InitAsDescriptorRange(D3D12_DESCRIPTOR_RANGE_TYPE_UAV, 0, 1);
+    s_RootSignature.Finalize(L"MSAA Resolve");
+
+    // Every pixel is written, whatever the destination held before
+    D3D12_DEPTH_STENCIL_DESC DepthStateAlways = DepthStateReadWrite;
+    DepthStateAlways.DepthFunc = D3D12_COMPARISON_FUNC_ALWAYS;
+
+    s_ResolveDepthPS.SetRootSignature(s_RootSignature);
+    s_ResolveDepthPS.SetRasterizerState(RasterizerTwoSided);
+    s_ResolveDepthPS.SetBlendState(BlendNoColorWrite);
+    s_ResolveDepthPS.SetDepthStencilState(DepthStateAlways);
+    s_ResolveDepthPS.SetSampleMask(0xFFFFFFFF);
+    s_ResolveDepthPS.SetInputLayout(0, nullptr);
+    s_ResolveDepthPS.SetPrimitiveTopologyType(D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE);
+    s_ResolveDepthPS.SetVertexShader(g_pScreenQuadVS, sizeof(g_pScreenQuadVS));
+    s_ResolveDepthPS.SetPixelShader(g_pMSAAResolveDepthPS, sizeof(g_pMSAAResolveDepthPS));
+    s_ResolveDepthPS.SetRenderTargetFormats(0, nullptr, g_SceneDepthBuffer.GetFormat());
+    s_ResolveDepthPS.Finalize();
+
+    s_ResolveColorCS.SetRootSignature(s_RootSignature);
+    s_ResolveColorCS.SetComputeShader(g_pMSAAResolveColorCS, sizeof(g_pMSAAResolveColorCS));
+    s_ResolveColorCS.Finalize();
+}
+
+void MSAAResolve::Shutdown( void )
+{
+}
+
+void MSAAResolve::ResolveDepth( GraphicsContext& Context, DepthBuffer& Src, DepthBuffer& Dst )
+{
+    ASSERT(Src.GetSampleCount() > 1 && Dst.GetSampleCount() == 1);
+    ASSERT(Src.GetWidth() == Dst.GetWidth() && Src.GetHeight() == Dst.GetHeight());
+
+    ScopedTimer _prof(L"Resolve MSAA Depth", Context);
+
+    Context.TransitionDepthToReadOnly(Src);
+    Context.TransitionResource(Dst, D3D12_RESOURCE_STATE_DEPTH_WRITE, true);
+
+    Context.SetRootSignature(s_RootSignature);
+    Context.SetPipelineState(s_ResolveDepthPS);
+    Context.SetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+    Context.SetDynamicDescriptor(1, 0, Src.GetDepthSRV());
+    Context.SetDepthStencilTarget(Dst.GetDSV());
+    Context.SetViewportAndScissor(0, 0, Dst.GetWidth(), Dst.GetHeight());
+    Context.Draw(3);
+}
+
+void MSAAResolve::ResolveColor( ComputeContext& Context, ColorBuffer& Src, ColorBuffer& Dst )
+{
+    ASSERT(Src.GetFragmentCount() > 1 && Dst.GetFragmentCount() == 1);
+    ASSERT(Src.GetWidth() == Dst.GetWidth() && Src.GetHeight() == Dst.GetHeight());
+
+    ScopedTimer _prof(L"Resolve MSAA Color", Context);
+
+    StructuredBuffer& Exposure = PostEffects::GetExposureBuffer();
+
+    Context.TransitionResource(Src, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+    Context.TransitionResource(Exposure, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+    Context.TransitionResource(Dst, D3D12_RESOURCE_STATE_UNORDERED_ACCESS, true);
+
+    Context.SetRootSignature(s_RootSignature);
+    Context.SetPipelineState(s_ResolveColorCS);
+    Context.SetConstants(0, Dst.GetWidth(), Dst.GetHeight(), Src.GetFragmentCount(), TonemapWeighted ? 1u : 0u);
+
+    D3D12_CPU_DESCRIPTOR_HANDLE SRVs[2] = { Src.GetSRV(), Exposure.GetSRV() };
+    Context.SetDynamicDescriptors(1, 0, 2, SRVs);
+    Context.SetDynamicDescriptor(2, 0, Dst.GetUAV());
+    Context.Dispatch2D(Dst.GetWidth(), Dst.GetHeight());
+}
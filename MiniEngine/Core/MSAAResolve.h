@@ -0,0 +1,42 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Developed by Minigraph
+//
+
+#pragma once
+
+#include "EngineTuning.h"
+
+class GraphicsContext;
+class ComputeContext;
+class ColorBuffer;
+class DepthBuffer;
+
+// Custom resolves of the MSAA scene buffers (g_SceneColorBufferMSAA and g_SceneDepthBufferMSAA).  Each target
+// is resolved by one pass that writes the single-sample buffer the rest of the frame reads, in place of a
+// ResolveSubresource() followed by a pass over the result:
+//
+//  - Depth resolves to the nearest sample, which is what SSAO, lighting and the temporal effects expect of
+//    g_SceneDepthBuffer.  HiZ::Build() resolves the MSAA depth to min/max itself.
+//  - Color resolves straight into g_SceneColorBuffer, the input of TAA, with every sample weighted by the
+//    inverse of its tone mapped luminance.  Averaging in (approximately) tone mapped space keeps a bright
+//    sample from overwhelming an edge, which would otherwise undo the antialiasing after tone mapping.
+namespace MSAAResolve
+{
+    extern BoolVar Enable;
+    extern BoolVar TonemapWeighted;
+
+    void Initialize( void );
+    void Shutdown( void );
+
+    // Dst is left in DEPTH_WRITE and Src readable by shaders
+    void ResolveDepth( GraphicsContext& Context, DepthBuffer& Src, DepthBuffer& Dst );
+
+    void ResolveColor( ComputeContext& Context, ColorBuffer& Src, ColorBuffer& Dst );
+}
@@ -0,0 +1,396 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Developed by Minigraph
+//
+// Author:  James Stanard 
+//
+
+#include "pch.h"
+#include "BatchTransform.h"
+#include "Random.h"
+#include "SystemTime.h"
+#include "Utility.h"
+#include <vector>
+#include <algorithm>
+#include <math.h>
+#include <intrin.h>
+
+using namespace Math;
+
+namespace
+{
+    // The kernels are written once against these.  AVX2 and SSE process full blocks; Scalar finishes the rest.
+    struct AVX2Lanes
+    {
+        typedef __m256 Reg;
+        enum { kWidth = 8 };
+        static Reg Load( const float* Src ) { return _mm256_loadu_ps(Src); }
+        static void Store( float* Dest, Reg Value ) { _mm256_storeu_ps(Dest, Value); }
+        static Reg Splat( float Value ) { return _mm256_set1_ps(Value); }
+        static Reg Add( Reg A, Reg B ) { return _mm256_add_ps(A, B); }
+        static Reg Sub( Reg A, Reg B ) { return _mm256_sub_ps(A, B); }
+        static Reg Mul( Reg A, Reg B ) { return _mm256_mul_ps(A, B); }
+    };
+
+    struct SSELanes
+    {
+        typedef __m128 Reg;
+        enum { kWidth = 4 };
+        static Reg Load( const float* Src ) { return _mm_loadu_ps(Src); }
+        static void Store( float* Dest, Reg Value ) { _mm_storeu_ps(Dest, Value); }
+        static Reg Splat( float Value ) { return _mm_set1_ps(Value); }
+        static Reg Add( Reg A, Reg B ) { return _mm_add_ps(A, B); }
+        static Reg Sub( Reg A, Reg B ) { return _mm_sub_ps(A, B); }
+        static Reg Mul( Reg A, Reg B ) { return _mm_mul_ps(A, B); }
+    };
+
+    struct ScalarLanes
+    {
+        typedef float Reg;
+        enum { kWidth = 1 };
+        static Reg Load( const float* Src ) { return *Src; }
+        static void Store( float* Dest, Reg Value ) { *Dest = Value; }
+        static Reg Splat( float Value ) { return Value; }
+        static Reg Add( Reg A, Reg B ) { return A + B; }
+        static Reg Sub( Reg A, Reg B ) { return A - B; }
+        static Reg Mul( Reg A, Reg B ) { return A * B; }
+    };
+
+    // The rows of the 3x4 matrix, each element splatted.  Abs holds the absolute values of the linear part,
+    // which map a box's half extents to those of its bound.
+    template <typename Lanes>
+    struct SplatRows
+    {
+        typedef typename Lanes::Reg Reg;
+
+        Reg M[3][4];
+        Reg Abs[3][3];
+
+        SplatRows( const AffineTransform& Xform )
+        {
+            XMFLOAT4 Rows[3];
+            XMMATRIX Transposed = XMMatrixTranspose((XMMATRIX)Xform);
+            XMStoreFloat4(&Rows[0], Transposed.r[0]);
+            XMStoreFloat4(&Rows[1], Transposed.r[1]);
+            XMStoreFloat4(&Rows[2], Transposed.r[2]);
+
+            for (int r = 0; r < 3; ++r)
+            {
+                const float* Row = &Rows[r].x;
+                for (int c = 0; c < 4; ++c)
+                    M[r][c] = Lanes::Splat(Row[c]);
+                for (int c = 0; c < 3; ++c)
+                    Abs[r][c] = Lanes::Splat(fabsf(Row[c]));
+            }
+        }
+
+        Reg Point( int r, Reg X, Reg Y, Reg Z ) const
+        {
+            return Lanes::Add(Lanes::Add(Lanes::Mul(M[r][0], X), Lanes::Mul(M[r][1], Y)), Lanes::Add(Lanes::Mul(M[r][2], Z), M[r][3]));
+        }
+
+        Reg Extent( int r, Reg X, Reg Y, Reg Z ) const
+        {
+            return Lanes::Add(Lanes::Add(Lanes::Mul(Abs[r][0], X), Lanes::Mul(Abs[r][1], Y)), Lanes::Mul(Abs[r][2], Z));
+        }
+    };
+
+    // Each kernel transforms whole blocks of Lanes::kWidth elements starting at First and returns the index of
+    // the first element left over.  Every input of a block is loaded before any output is stored.
+    template <typename Lanes>
+    uint32_t TransformPointBlocks( const AffineTransform& Xform, const PointSOA& Points, float* const Out[3], uint32_t First )
+    {
+        const SplatRows<Lanes> M(Xform);
+
+        uint32_t i = First;
+        for (; i + Lanes::kWidth <= Points.Count; i += Lanes::kWidth)
+        {
+            typename Lanes::Reg X = Lanes::Load(Points.X + i);
+            typename Lanes::Reg Y = Lanes::Load(Points.Y + i);
+            typename Lanes::Reg Z = Lanes::Load(Points.Z + i);
+            Lanes::Store(Out[0] + i, M.Point(0, X, Y, Z));
+            Lanes::Store(Out[1] + i, M.Point(1, X, Y, Z));
+            Lanes::Store(Out[2] + i, M.Point(2, X, Y, Z));
+        }
+        return i;
+    }
+
+    // The center is transformed as a point and the half extents by the absolute values of the basis (Arvo)
+    template <typename Lanes>
+    uint32_t TransformBoxBlocks( const AffineTransform& Xform, const BoundingBoxSOA& Boxes, float* const Out[6], uint32_t First )
+    {
+        typedef typename Lanes::Reg Reg;
+
+        const SplatRows<Lanes> M(Xform);
+        const Reg Half = Lanes::Splat(0.5f);
+
+        uint32_t i = First;
+        for (; i + Lanes::kWidth <= Boxes.Count; i += Lanes::kWidth)
+        {
+            Reg MinX = Lanes::Load(Boxes.MinX + i), MaxX = Lanes::Load(Boxes.MaxX + i);
+            Reg MinY = Lanes::Load(Boxes.MinY + i), MaxY = Lanes::Load(Boxes.MaxY + i);
+            Reg MinZ = Lanes::Load(Boxes.MinZ + i), MaxZ = Lanes::Load(Boxes.MaxZ + i);
+
+            Reg CenterX = Lanes::Mul(Lanes::Add(MinX, MaxX), Half);
+            Reg CenterY = Lanes::Mul(Lanes::Add(MinY, MaxY), Half);
+            Reg CenterZ = Lanes::Mul(Lanes::Add(MinZ, MaxZ), Half);
+            Reg ExtentX = Lanes::Mul(Lanes::Sub(MaxX, MinX), Half);
+            Reg ExtentY = Lanes::Mul(Lanes::Sub(MaxY, MinY), Half);
+            Reg ExtentZ = Lanes::Mul(Lanes::Sub(MaxZ, MinZ), Half);
+
+            for (int r = 0; r < 3; ++r)
+            {
+                Reg Center = M.Point(r, CenterX, CenterY, CenterZ);
+                Reg Extent = M.Extent(r, ExtentX, ExtentY, ExtentZ);
+                Lanes::Store(Out[r] + i, Lanes::Sub(Center, Extent));
+                Lanes::Store(Out[r + 3] + i, Lanes::Add(Center, Extent));
+            }
+        }
+        return i;
+    }
+
+    // Row j of Xform * B (in XMMATRIX terms) is the sum of Xform's rows weighted by the components of B's row j.
+    // Each 256-bit register holds two rows of B, and the in-lane permutes splat their components.
+    inline __m256 CombineRows( const __m256 A[4], __m256 B )
+    {
+        return _mm256_add_ps(
+            _mm256_add_ps(_mm256_mul_ps(A[0], _mm256_permute_ps(B, 0x00)), _mm256_mul_ps(A[1], _mm256_permute_ps(B, 0x55))),
+            _mm256_add_ps(_mm256_mul_ps(A[2], _mm256_permute_ps(B, 0xAA)), _mm256_mul_ps(A[3], _mm256_permute_ps(B, 0xFF))));
+    }
+
+    void MultiplyMatricesAVX2( const Matrix4& Xform, const Matrix4* Matrices, Matrix4* Out, uint32_t Count )
+    {
+        const XMMATRIX A = (XMMATRIX)Xform;
+        const __m256 ARows[4] =
+        {
+            _mm256_broadcast_ps(&A.r[0]), _mm256_broadcast_ps(&A.r[1]),
+            _mm256_broadcast_ps(&A.r[2]), _mm256_broadcast_ps(&A.r[3])
+        };
+
+        for (uint32_t i = 0; i < Count; ++i)
+        {
+            const float* Src = (const float*)(Matrices + i);
+            const __m256 B01 = _mm256_loadu_ps(Src);
+            const __m256 B23 = _mm256_loadu_ps(Src + 8);
+
+            float* Dest = (float*)(Out + i);
+            _mm256_storeu_ps(Dest, CombineRows(ARows, B01));
+            _mm256_storeu_ps(Dest + 8, CombineRows(ARows, B23));
+        }
+    }
+
+    // Four doubles convert to one __m128 of floats
+    uint32_t RebasePointsAVX( const WorldPosition& Origin, const WorldPointSOA& Points, float* const Out[3] )
+    {
+        const __m256d OriginX = _mm256_set1_pd(Origin.X);
+        const __m256d OriginY = _mm256_set1_pd(Origin.Y);
+        const __m256d OriginZ = _mm256_set1_pd(Origin.Z);
+
+        uint32_t i = 0;
+        for (; i + 4 <= Points.Count; i += 4)
+        {
+            __m128 X = _mm256_cvtpd_ps(_mm256_sub_pd(_mm256_loadu_pd(Points.X + i), OriginX));
+            __m128 Y = _mm256_cvtpd_ps(_mm256_sub_pd(_mm256_loadu_pd(Points.Y + i), OriginY));
+            __m128 Z = _mm256_cvtpd_ps(_mm256_sub_pd(_mm256_loadu_pd(Points.Z + i), OriginZ));
+            _mm_storeu_ps(Out[0] + i, X);
+            _mm_storeu_ps(Out[1] + i, Y);
+            _mm_storeu_ps(Out[2] + i, Z);
+        }
+        return i;
+    }
+
+    // Two doubles convert to the low half of an __m128
+    uint32_t RebasePointsSSE2( const WorldPosition& Origin, const WorldPointSOA& Points, float* const Out[3], uint32_t First )
+    {
+        const __m128d OriginX = _mm_set1_pd(Origin.X);
+        const __m128d OriginY = _mm_set1_pd(Origin.Y);
+        const __m128d OriginZ = _mm_set1_pd(Origin.Z);
+
+        uint32_t i = First;
+        for (; i + 2 <= Points.Count; i += 2)
+        {
+            __m128 X = _mm_cvtpd_ps(_mm_sub_pd(_mm_loadu_pd(Points.X + i), OriginX));
+            __m128 Y = _mm_cvtpd_ps(_mm_sub_pd(_mm_loadu_pd(Points.Y + i), OriginY));
+            __m128 Z = _mm_cvtpd_ps(_mm_sub_pd(_mm_loadu_pd(Points.Z + i), OriginZ));
+            _mm_storel_pi((__m64*)(Out[0] + i), X);
+            _mm_storel_pi((__m64*)(Out[1] + i), Y);
+            _mm_storel_pi((__m64*)(Out[2] + i), Z);
+        }
+        return i;
+    }
+
+    // The fastest of several runs, in milliseconds
+    template <typename Function>
+    double TimeRuns( Function Run )
+    {
+        double Best = 1e30;
+        for (int Trial = 0; Trial < 8; ++Trial)
+        {
+            int64_t Start = SystemTime::GetCurrentTick();
+            Run();
+            Best = std::min(Best, SystemTime::TimeBetweenTicks(Start, SystemTime::GetCurrentTick()) * 1000.0);
+        }
+        return Best;
+    }
+
+    float MaxDifference( const std::vector<float>& A, const std::vector<float>& B )
+    {
+        float Result = 0.0f;
+        for (size_t i = 0; i < A.size(); ++i)
+            Result = std::max(Result, fabsf(A[i] - B[i]));
+        return Result;
+    }
+}
+
+void Math::TransformPoints( const AffineTransform& Xform, const PointSOA& Points, float* const Out[3] )
+{
+    uint32_t i = 0;
+    if (HasAVX2())
+    {
+        i = TransformPointBlocks<AVX2Lanes>(Xform, Points, Out, i);
+        _mm256_zeroupper();
+    }
+    i = TransformPointBlocks<SSELanes>(Xform, Points, Out, i);
+    TransformPointBlocks<ScalarLanes>(Xform, Points, Out, i);
+}
+
+void Math::TransformBoundingBoxes( const AffineTransform& Xform, const BoundingBoxSOA& Boxes, float* const Out[6] )
+{
+    uint32_t i = 0;
+    if (HasAVX2())
+    {
+        i = TransformBoxBlocks<AVX2Lanes>(Xform, Boxes, Out, i);
+        _mm256_zeroupper();
+    }
+    i = TransformBoxBlocks<SSELanes>(Xform, Boxes, Out, i);
+    TransformBoxBlocks<ScalarLanes>(Xform, Boxes, Out, i);
+}
+
+void Math::MultiplyMatrices( const Matrix4& Xform, const Matrix4* Matrices, Matrix4* Out, uint32_t Count )
+{
+    if (HasAVX2())
+    {
+        MultiplyMatricesAVX2(Xform, Matrices, Out, Count);
+        _mm256_zeroupper();
+        return;
+    }
+
+    for (uint32_t i = 0; i < Count; ++i)
+        Out[i] = Xform * Matrices[i];
+}
+
+void Math::RebasePoints( const WorldPosition& Origin, const WorldPointSOA& Points, float* const Out[3] )
+{
+    uint32_t i = 0;
+    if (HasAVX2())
+    {
+        i = RebasePointsAVX(Origin, Points, Out);
+        _mm256_zeroupper();
+    }
+    i = RebasePointsSSE2(Origin, Points, Out, i);
+    for (; i < Points.Count; ++i)
+    {
+        Out[0][i] = (float)(Points.X[i] - Origin.X);
+        Out[1][i] = (float)(Points.Y[i] - Origin.Y);
+        Out[2][i] = (float)(Points.Z[i] - Origin.Z);
+    }
+}
+
+void Math::BenchmarkBatchTransforms( uint32_t Count )
+{
+    RandomNumberGenerator RNG(1);
+    const AffineTransform Xform(Matrix3::MakeYRotation(0.7f) * Matrix3::MakeXRotation(0.3f) * Matrix3::MakeScale(1.5f),
+        Vector3(10.0f, -20.0f, 30.0f));
+
+    // Points and boxes share one set of arrays: the points are the box minimums
+    std::vector<float> Input(6 * Count);
+    RNG.FillFloats(Input.data(), Input.size(), -100.0f, 100.0f);
+    for (uint32_t i = 0; i < 3 * Count; ++i)
+        Input[3 * Count + i] = Input[i] + fabsf(Input[3 * Count + i]);
+
+    const float* In[6];
+    for (int c = 0; c < 6; ++c)
+        In[c] = Input.data() + c * Count;
+
+    std::vector<float> Batch(6 * Count), Single(6 * Count);
+    float* BatchOut[6];
+    float* SingleOut[6];
+    for (int c = 0; c < 6; ++c)
+    {
+        BatchOut[c] = Batch.data() + c * Count;
+        SingleOut[c] = Single.data() + c * Count;
+    }
+
+    Utility::Printf("Batch transforms of %u elements (%s):\n", Count, HasAVX2() ? "AVX2" : "SSE");
+
+    const PointSOA Points = { In[0], In[1], In[2], Count };
+    double BatchTime = TimeRuns([&] { TransformPoints(Xform, Points, BatchOut); });
+    double SingleTime = TimeRuns([&]
+    {
+        for (uint32_t i = 0; i < Count; ++i)
+        {
+            Vector3 P = Xform * Vector3(In[0][i], In[1][i], In[2][i]);
+            SingleOut[0][i] = P.GetX();
+            SingleOut[1][i] = P.GetY();
+            SingleOut[2][i] = P.GetZ();
+        }
+    });
+    Utility::Printf("    TransformPoints: %.3f ms, single: %.3f ms, max difference %g\n", BatchTime, SingleTime,
+        MaxDifference(Batch, Single));
+
+    const BoundingBoxSOA Boxes = { In[0], In[1], In[2], In[3], In[4], In[5], Count };
+    BatchTime = TimeRuns([&] { TransformBoundingBoxes(Xform, Boxes, BatchOut); });
+    SingleTime = TimeRuns([&]
+    {
+        const Matrix3& Basis = Xform.GetBasis();
+        const Matrix3 AbsBasis(Abs(Basis.GetX()), Abs(Basis.GetY()), Abs(Basis.GetZ()));
+        for (uint32_t i = 0; i < Count; ++i)
+        {
+            Vector3 Min(In[0][i], In[1][i], In[2][i]);
+            Vector3 Max(In[3][i], In[4][i], In[5][i]);
+            Vector3 Center = Xform * ((Min + Max) * 0.5f);
+            Vector3 Extent = AbsBasis * ((Max - Min) * 0.5f);
+            Vector3 NewMin = Center - Extent;
+            Vector3 NewMax = Center + Extent;
+            SingleOut[0][i] = NewMin.GetX();
+            SingleOut[1][i] = NewMin.GetY();
+            SingleOut[2][i] = NewMin.GetZ();
+            SingleOut[3][i] = NewMax.GetX();
+            SingleOut[4][i] = NewMax.GetY();
+            SingleOut[5][i] = NewMax.GetZ();
+        }
+    });
+    Utility::Printf("    TransformBoundingBoxes: %.3f ms, single: %.3f ms, max difference %g\n", BatchTime, SingleTime,
+        MaxDifference(Batch, Single));
+
+    // Matrices made of the same random numbers
+    const uint32_t MatrixCount = (uint32_t)(Input.size() / 16);
+    std::vector<Matrix4> Matrices(MatrixCount), BatchMatrices(MatrixCount), SingleMatrices(MatrixCount);
+    for (uint32_t i = 0; i < MatrixCount; ++i)
+        Matrices[i] = Matrix4(XMLoadFloat4x4((const XMFLOAT4X4*)(Input.data() + 16 * i)));
+
+    const Matrix4 Xform4(Xform);
+    BatchTime = TimeRuns([&] { MultiplyMatrices(Xform4, Matrices.data(), BatchMatrices.data(), MatrixCount); });
+    SingleTime = TimeRuns([&]
+    {
+        for (uint32_t i = 0; i < MatrixCount; ++i)
+            SingleMatrices[i] = Xform4 * Matrices[i];
+    });
+
+    float MatrixDifference = 0.0f;
+    for (uint32_t i = 0; i < MatrixCount; ++i)
+    {
+        const float* A = (const float*)&BatchMatrices[i];
+        const float* B = (const float*)&SingleMatrices[i];
+        for (int e = 0; e < 16; ++e)
+            MatrixDifference = std::max(MatrixDifference, fabsf(A[e] - B[e]));
+    }
+    Utility::Printf("    MultiplyMatrices (%u): %.3f ms, single: %.3f ms, max difference %g\n", MatrixCount, BatchTime,
+        SingleTime, MatrixDifference);
+}
@@ -0,0 +1,61 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Developed by Minigraph
+//
+// Author:  James Stanard 
+//
+// Batch versions of the single operations in Matrix4.h and Transform.h, for transforming many points, boxes
+// or matrices by one transform.  Points and boxes are structure-of-arrays, so the kernels work on eight
+// elements at a time with AVX2 when the CPU has it, four at a time with SSE otherwise, and finish the remainder
+// one at a time.  No array needs to be aligned or padded, and the outputs may be the input arrays themselves.
+//
+
+#pragma once
+
+#include "VectorMath.h"
+#include "Frustum.h"
+#include "WorldPosition.h"
+
+namespace Math
+{
+    struct PointSOA
+    {
+        const float* X;
+        const float* Y;
+        const float* Z;
+        uint32_t Count;
+    };
+
+    // Out[0], Out[1] and Out[2] receive the transformed X, Y and Z of each point
+    void TransformPoints( const AffineTransform& Xform, const PointSOA& Points, float* const Out[3] );
+
+    // The axis-aligned boxes that bound the transformed boxes.  Out[0] through Out[5] receive MinX, MinY, MinZ,
+    // MaxX, MaxY and MaxZ, the order of the BoundingBoxSOA members.
+    void TransformBoundingBoxes( const AffineTransform& Xform, const BoundingBoxSOA& Boxes, float* const Out[6] );
+
+    // Out[i] = Xform * Matrices[i]
+    void MultiplyMatrices( const Matrix4& Xform, const Matrix4* Matrices, Matrix4* Out, uint32_t Count );
+
+    struct WorldPointSOA
+    {
+        const double* X;
+        const double* Y;
+        const double* Z;
+        uint32_t Count;
+    };
+
+    // Out[0], Out[1] and Out[2] receive each point minus Origin, subtracted in double precision and rounded to
+    // float.  With the camera's world origin, this gives render space positions for camera-relative rendering;
+    // translations made this way can then be combined with the view matrix by MultiplyMatrices.
+    void RebasePoints( const WorldPosition& Origin, const WorldPointSOA& Points, float* const Out[3] );
+
+    // A microbenchmark.  Times each batch kernel against a loop of the single operations on Count random
+    // elements, checks that they agree, and prints the results.
+    void BenchmarkBatchTransforms( uint32_t Count );
+}
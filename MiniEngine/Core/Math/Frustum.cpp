@@ -17,7 +17,7 @@
 
 using namespace Math;
 
-void Frustum::ConstructPerspectiveFrustum( float HTan, float VTan, float NearClip, float FarClip )
+void Frustum::ConstructPerspectiveFrustum( float HTan, float VTan, float NearClip, float FarClip, bool InfiniteFar )
 {
     const float NearX = HTan * NearClip;
     const float NearY = VTan * NearClip;
@@ -41,7 +41,7 @@ void Frustum::ConstructPerspectiveFrustum( float HTan, float VTan, float NearCli
 
     // Define the bounding planes
     m_FrustumPlanes[kNearPlane]        = BoundingPlane( 0.0f, 0.0f, -1.0f, -NearClip );
-    m_FrustumPlanes[kFarPlane]        = BoundingPlane( 0.0f, 0.0f,  1.0f,   FarClip );
+    m_FrustumPlanes[kFarPlane]        = InfiniteFar ? BoundingPlane( 0.0f, 0.0f, 0.0f, 1.0f ) : BoundingPlane( 0.0f, 0.0f,  1.0f,   FarClip );
     m_FrustumPlanes[kLeftPlane]        = BoundingPlane(  NHx, 0.0f,   NHz,      0.0f );
     m_FrustumPlanes[kRightPlane]    = BoundingPlane( -NHx, 0.0f,   NHz,      0.0f );
     m_FrustumPlanes[kTopPlane]        = BoundingPlane( 0.0f, -NVy,   NVz,      0.0f );
@@ -65,12 +65,12 @@ void Frustum::ConstructOrthographicFrustum( float Left, float Right, float Top,
     m_FrustumPlanes[kFarPlane]        = BoundingPlane(  0.0f,  0.0f,  1.0f,   Back );
     m_FrustumPlanes[kLeftPlane]        = BoundingPlane(  1.0f,  0.0f,  0.0f,  -Left );
     m_FrustumPlanes[kRightPlane]    = BoundingPlane( -1.0f,  0.0f,  0.0f,  Right );
-    m_FrustumPlanes[kTopPlane]        = BoundingPlane(  0.0f, -1.0f,  0.0f, Bottom );
-    m_FrustumPlanes[kBottomPlane]    = BoundingPlane(  0.0f,  1.0f,  0.0f,   -Top );
+    m_FrustumPlanes[kTopPlane]        = BoundingPlane(  0.0f, -1.0f,  0.0f,    Top );
+    m_FrustumPlanes[kBottomPlane]    = BoundingPlane(  0.0f,  1.0f,  0.0f, -Bottom );
 }
 
 
-Frustum::Frustum( const Matrix4& ProjMat )
+Frustum::Frustum( const Matrix4& ProjMat, float FarCornerDist )
 {
     const float* ProjMatF = (const float*)&ProjMat;
 
@@ -89,18 +89,26 @@ Frustum::Frustum( const Matrix4& ProjMat )
         float Front     = ( 0.0f - ProjMatF[14]) * RcpZZ;
         float Back   = ( 1.0f - ProjMatF[14]) * RcpZZ;
 
-        // Check for reverse Z here.  The bounding planes need to point into the frustum.
-        if (Front < Back)
-            ConstructOrthographicFrustum( Left, Right, Top, Bottom, Front, Back );
+        // Front and Back are the view space Z values that map to depths 0 and 1, but the frustum is
+        // constructed from distances along -Z.  Check for reverse Z here.  The bounding planes need to
+        // point into the frustum.
+        if (Front > Back)
+            ConstructOrthographicFrustum( Left, Right, Top, Bottom, -Front, -Back );
         else
-            ConstructOrthographicFrustum( Left, Right, Top, Bottom, Back, Front );
+            ConstructOrthographicFrustum( Left, Right, Top, Bottom, -Back, -Front );
     }
     else
     {
         // Perspective
         float NearClip, FarClip;
 
-        if (RcpZZ > 0.0f)    // Reverse Z
+        if (ProjMatF[10] == 0.0f)    // Reverse Z with an infinite far plane:  depth = NearClip / distance
+        {
+            NearClip = ProjMatF[14];
+            ConstructPerspectiveFrustum( RcpXX, RcpYY, NearClip, FarCornerDist, true );
+            return;
+        }
+        else if (RcpZZ > 0.0f)    // Reverse Z
         {
             FarClip = ProjMatF[14] * RcpZZ;
             NearClip = FarClip / (RcpZZ + 1.0f);
@@ -114,3 +122,189 @@ Frustum::Frustum( const Matrix4& ProjMat )
         ConstructPerspectiveFrustum( RcpXX, RcpYY, NearClip, FarClip );
     }
 }
+
+namespace
+{
+    // Each plane component replicated across the four lanes
+    struct SplatPlanes
+    {
+        __m128 Nx[6], Ny[6], Nz[6], D[6];
+        __m128 AbsNx[6], AbsNy[6], AbsNz[6];
+    };
+
+    void SplatFrustumPlanes( const Frustum& frustum, SplatPlanes& Out )
+    {
+        const __m128 AbsMask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+
+        for (int i = 0; i < 6; ++i)
+        {
+            __m128 Plane = Vector4(frustum.GetFrustumPlane((Frustum::PlaneID)i));
+            Out.Nx[i] = _mm_shuffle_ps(Plane, Plane, _MM_SHUFFLE(0, 0, 0, 0));
+            Out.Ny[i] = _mm_shuffle_ps(Plane, Plane, _MM_SHUFFLE(1, 1, 1, 1));
+            Out.Nz[i] = _mm_shuffle_ps(Plane, Plane, _MM_SHUFFLE(2, 2, 2, 2));
+            Out.D[i]  = _mm_shuffle_ps(Plane, Plane, _MM_SHUFFLE(3, 3, 3, 3));
+            Out.AbsNx[i] = _mm_and_ps(Out.Nx[i], AbsMask);
+            Out.AbsNy[i] = _mm_and_ps(Out.Ny[i], AbsMask);
+            Out.AbsNz[i] = _mm_and_ps(Out.Nz[i], AbsMask);
+        }
+    }
+
+    // Loads up to four floats, filling missing lanes with zero
+    inline __m128 LoadPartial( const float* Src, uint32_t Num )
+    {
+        if (Num >= 4)
+            return _mm_loadu_ps(Src);
+
+        __declspec(align(16)) float Temp[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+        for (uint32_t i = 0; i < Num; ++i)
+            Temp[i] = Src[i];
+        return _mm_load_ps(Temp);
+    }
+
+    inline __m128 PlaneDot( const SplatPlanes& P, int i, __m128 X, __m128 Y, __m128 Z )
+    {
+        return _mm_add_ps(_mm_add_ps(_mm_mul_ps(P.Nx[i], X), _mm_mul_ps(P.Ny[i], Y)), _mm_add_ps(_mm_mul_ps(P.Nz[i], Z), P.D[i]));
+    }
+
+    struct SphereBlock
+    {
+        __m128 X, Y, Z, R;
+
+        void Load( const BoundingSphereSOA& Spheres, uint32_t Base, uint32_t Num )
+        {
+            X = LoadPartial(Spheres.CenterX + Base, Num);
+            Y = LoadPartial(Spheres.CenterY + Base, Num);
+            Z = LoadPartial(Spheres.CenterZ + Base, Num);
+            R = LoadPartial(Spheres.Radius + Base, Num);
+        }
+
+        // Signed distance from the plane to the point of each sphere farthest inside it
+        __m128 FarthestDistance( const SplatPlanes& P, int i ) const
+        {
+            return _mm_add_ps(PlaneDot(P, i, X, Y, Z), R);
+        }
+    };
+
+    struct BoxBlock
+    {
+        __m128 CenterX, CenterY, CenterZ;
+        __m128 ExtentX, ExtentY, ExtentZ;
+
+        void Load( const BoundingBoxSOA& Boxes, uint32_t Base, uint32_t Num )
+        {
+            const __m128 Half = _mm_set1_ps(0.5f);
+            __m128 MinX = LoadPartial(Boxes.MinX + Base, Num);
+            __m128 MinY = LoadPartial(Boxes.MinY + Base, Num);
+            __m128 MinZ = LoadPartial(Boxes.MinZ + Base, Num);
+            __m128 MaxX = LoadPartial(Boxes.MaxX + Base, Num);
+            __m128 MaxY = LoadPartial(Boxes.MaxY + Base, Num);
+            __m128 MaxZ = LoadPartial(Boxes.MaxZ + Base, Num);
+            CenterX = _mm_mul_ps(_mm_add_ps(MinX, MaxX), Half);
+            CenterY = _mm_mul_ps(_mm_add_ps(MinY, MaxY), Half);
+            CenterZ = _mm_mul_ps(_mm_add_ps(MinZ, MaxZ), Half);
+            ExtentX = _mm_mul_ps(_mm_sub_ps(MaxX, MinX), Half);
+            ExtentY = _mm_mul_ps(_mm_sub_ps(MaxY, MinY), Half);
+            ExtentZ = _mm_mul_ps(_mm_sub_ps(MaxZ, MinZ), Half);
+        }
+
+        // Signed distance from the plane to the corner of each box farthest inside it.  This is the same
+        // corner that IntersectBoundingBox() selects, expressed without a per-plane branch.
+        __m128 FarthestDistance( const SplatPlanes& P, int i ) const
+        {
+            __m128 Projection = _mm_add_ps(_mm_add_ps(_mm_mul_ps(P.AbsNx[i], ExtentX), _mm_mul_ps(P.AbsNy[i], ExtentY)),
+                _mm_mul_ps(P.AbsNz[i], ExtentZ));
+            return _mm_add_ps(PlaneDot(P, i, CenterX, CenterY, CenterZ), Projection);
+        }
+    };
+
+    template <typename BlockType, typename VolumeArrays>
+    void CullBatch( const Frustum* const Frusta[], uint32_t NumFrusta, const VolumeArrays& Volumes, uint32_t* const VisibilityMasks[] )
+    {
+        ASSERT(NumFrusta <= Frustum::kMaxBatchFrusta);
+
+        SplatPlanes Planes[Frustum::kMaxBatchFrusta];
+        for (uint32_t f = 0; f < NumFrusta; ++f)
+            SplatFrustumPlanes(*Frusta[f], Planes[f]);
+
+        const __m128 Zero = _mm_setzero_ps();
+
+        for (uint32_t Base = 0; Base < Volumes.Count; Base += 4)
+        {
+            const uint32_t Num = std::min(Volumes.Count - Base, 4u);
+            const uint32_t LaneMask = (1u << Num) - 1;
+
+            BlockType Block;
+            Block.Load(Volumes, Base, Num);
+
+            for (uint32_t f = 0; f < NumFrusta; ++f)
+            {
+                __m128 Inside = _mm_cmpge_ps(Block.FarthestDistance(Planes[f], 0), Zero);
+                for (int i = 1; i < 6; ++i)
+                    Inside = _mm_and_ps(Inside, _mm_cmpge_ps(Block.FarthestDistance(Planes[f], i), Zero));
+
+                uint32_t& Word = VisibilityMasks[f][Base / 32];
+                if ((Base & 31) == 0)
+                    Word = 0;
+                Word |= ((uint32_t)_mm_movemask_ps(Inside) & LaneMask) << (Base & 31);
+            }
+        }
+    }
+}
+
+void Frustum::IntersectSpheres( const BoundingSphereSOA& Spheres, uint32_t* VisibilityMask ) const
+{
+    const Frustum* Self = this;
+    CullBatch<SphereBlock>(&Self, 1, Spheres, &VisibilityMask);
+}
+
+void Frustum::IntersectBoundingBoxes( const BoundingBoxSOA& Boxes, uint32_t* VisibilityMask ) const
+{
+    const Frustum* Self = this;
+    CullBatch<BoxBlock>(&Self, 1, Boxes, &VisibilityMask);
+}
+
+void Frustum::IntersectSweptBoundingBoxes( const BoundingBoxSOA& Boxes, Vector3 Direction, uint32_t* VisibilityMask ) const
+{
+    SplatPlanes Planes;
+    SplatFrustumPlanes(*this, Planes);
+
+    // The sweep eventually crosses any plane it moves toward the inside of
+    bool PlaneCanReject[6];
+    for (int i = 0; i < 6; ++i)
+        PlaneCanReject[i] = Dot(m_FrustumPlanes[i].GetNormal(), Direction) <= 0.0f;
+
+    const __m128 Zero = _mm_setzero_ps();
+
+    for (uint32_t Base = 0; Base < Boxes.Count; Base += 4)
+    {
+        const uint32_t Num = std::min(Boxes.Count - Base, 4u);
+        const uint32_t LaneMask = (1u << Num) - 1;
+
+        BoxBlock Block;
+        Block.Load(Boxes, Base, Num);
+
+        __m128 Inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+        for (int i = 0; i < 6; ++i)
+        {
+            if (PlaneCanReject[i])
+                Inside = _mm_and_ps(Inside, _mm_cmpge_ps(Block.FarthestDistance(Planes, i), Zero));
+        }
+
+        uint32_t& Word = VisibilityMask[Base / 32];
+        if ((Base & 31) == 0)
+            Word = 0;
+        Word |= ((uint32_t)_mm_movemask_ps(Inside) & LaneMask) << (Base & 31);
+    }
+}
+
+void Frustum::IntersectSpheres( const Frustum* const Frusta[], uint32_t NumFrusta,
+    const BoundingSphereSOA& Spheres, uint32_t* const VisibilityMasks[] )
+{
+    CullBatch<SphereBlock>(Frusta, NumFrusta, Spheres, VisibilityMasks);
+}
+
+void Frustum::IntersectBoundingBoxes( const Frustum* const Frusta[], uint32_t NumFrusta,
+    const BoundingBoxSOA& Boxes, uint32_t* const VisibilityMasks[] )
+{
+    CullBatch<BoxBlock>(Frusta, NumFrusta, Boxes, VisibilityMasks);
+}
@@ -18,12 +18,36 @@
 
 namespace Math
 {
+    // Structure-of-arrays views of many bounding volumes, for the batch tests below.  The arrays need
+    // not be aligned or padded.
+    struct BoundingSphereSOA
+    {
+        const float* CenterX;
+        const float* CenterY;
+        const float* CenterZ;
+        const float* Radius;
+        uint32_t Count;
+    };
+
+    struct BoundingBoxSOA
+    {
+        const float* MinX;
+        const float* MinY;
+        const float* MinZ;
+        const float* MaxX;
+        const float* MaxY;
+        const float* MaxZ;
+        uint32_t Count;
+    };
+
     class Frustum
     {
     public:
         Frustum() {}
 
-        Frustum( const Matrix4& ProjectionMatrix );
+        // An infinite perspective projection has no far corners, so they are placed FarCornerDist from the eye
+        // instead.  Its far plane is (0, 0, 0, 1), which everything is in front of.
+        Frustum( const Matrix4& ProjectionMatrix, float FarCornerDist = 1000.0f );
 
         enum CornerID
         {
@@ -47,6 +71,25 @@ namespace Math
         // simple struct in the Model project.)
         bool IntersectBoundingBox(const Vector3 minBound, const Vector3 maxBound) const;
 
+        // Batch versions of the above that test four volumes at a time with SSE.  Bit (i % 32) of
+        // VisibilityMask[i / 32] is set when volume i intersects the frustum, so the mask must hold
+        // (Count + 31) / 32 words.  Unused bits of the last word are cleared.
+        void IntersectSpheres( const BoundingSphereSOA& Spheres, uint32_t* VisibilityMask ) const;
+        void IntersectBoundingBoxes( const BoundingBoxSOA& Boxes, uint32_t* VisibilityMask ) const;
+
+        // Test one batch against several frusta, such as the main view and each shadow cascade, loading
+        // every volume only once.  VisibilityMasks[i] receives the results for Frusta[i].
+        enum { kMaxBatchFrusta = 8 };
+        static void IntersectSpheres( const Frustum* const Frusta[], uint32_t NumFrusta,
+            const BoundingSphereSOA& Spheres, uint32_t* const VisibilityMasks[] );
+        static void IntersectBoundingBoxes( const Frustum* const Frusta[], uint32_t NumFrusta,
+            const BoundingBoxSOA& Boxes, uint32_t* const VisibilityMasks[] );
+
+        // Like IntersectBoundingBoxes(), but each box is swept to infinity along Direction, such as the volume
+        // a shadow caster darkens.  A box is only rejected by a plane that the sweep moves it away from, so the
+        // test is conservative.
+        void IntersectSweptBoundingBoxes( const BoundingBoxSOA& Boxes, Vector3 Direction, uint32_t* VisibilityMask ) const;
+
         friend Frustum  operator* ( const OrthogonalTransform& xform, const Frustum& frustum );    // Fast
         friend Frustum  operator* ( const AffineTransform& xform, const Frustum& frustum );        // Slow
         friend Frustum  operator* ( const Matrix4& xform, const Frustum& frustum );                // Slowest (and most general)
@@ -54,7 +97,7 @@ namespace Math
     private:
 
         // Perspective frustum constructor (for pyramid-shaped frusta)
-        void ConstructPerspectiveFrustum( float HTan, float VTan, float NearClip, float FarClip );
+        void ConstructPerspectiveFrustum( float HTan, float VTan, float NearClip, float FarClip, bool InfiniteFar = false );
 
         // Orthographic frustum constructor (for box-shaped frusta)
         void ConstructOrthographicFrustum( float Left, float Right, float Top, float Bottom, float NearClip, float FarClip );
@@ -13,8 +13,90 @@
 
 #include "pch.h"
 #include "Random.h"
+#include <random>
+
+using namespace Math;
+
+namespace
+{
+    // Expands a seed into well mixed, nonzero generator state
+    uint64_t SplitMix64( uint64_t& x )
+    {
+        uint64_t z = (x += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+}
 
 namespace Math
 {
     RandomNumberGenerator g_RNG;
 }
+
+RandomNumberGenerator::RandomNumberGenerator()
+{
+    std::random_device rd;
+    SetSeed(rd());
+}
+
+void RandomNumberGenerator::SetSeed( uint32_t Seed )
+{
+    uint64_t x = Seed;
+
+    __declspec(align(16)) uint32_t Words[20];
+    for (uint32_t i = 0; i < 20; i += 2)
+    {
+        uint64_t r = SplitMix64(x);
+        Words[i] = (uint32_t)r;
+        Words[i + 1] = (uint32_t)(r >> 32);
+    }
+
+    for (uint32_t i = 0; i < 4; ++i)
+    {
+        m_Lanes[i] = _mm_load_si128((const __m128i*)&Words[i * 4]);
+        m_State[i] = Words[16 + i];
+    }
+}
+
+void RandomNumberGenerator::FillFloats( float* Dest, size_t Count, float MinVal, float MaxVal )
+{
+    const __m128 Scale = _mm_set1_ps((MaxVal - MinVal) * (1.0f / 16777216.0f));
+    const __m128 Bias = _mm_set1_ps(MinVal);
+
+    __m128i s0 = m_Lanes[0];
+    __m128i s1 = m_Lanes[1];
+    __m128i s2 = m_Lanes[2];
+    __m128i s3 = m_Lanes[3];
+
+    size_t i = 0;
+    for (; i + 4 <= Count; i += 4)
+    {
+        // xoshiro128+ as in NextBits() and Advance(), one stream per lane
+        __m128i Result = _mm_add_epi32(s0, s3);
+        __m128i t = _mm_slli_epi32(s1, 9);
+        s2 = _mm_xor_si128(s2, s0);
+        s3 = _mm_xor_si128(s3, s1);
+        s1 = _mm_xor_si128(s1, s2);
+        s0 = _mm_xor_si128(s0, s3);
+        s2 = _mm_xor_si128(s2, t);
+        s3 = _mm_or_si128(_mm_slli_epi32(s3, 11), _mm_srli_epi32(s3, 21));
+
+        __m128 Unit = _mm_cvtepi32_ps(_mm_srli_epi32(Result, 8));
+        _mm_storeu_ps(Dest + i, _mm_add_ps(_mm_mul_ps(Unit, Scale), Bias));
+    }
+
+    m_Lanes[0] = s0;
+    m_Lanes[1] = s1;
+    m_Lanes[2] = s2;
+    m_Lanes[3] = s3;
+
+    for (; i < Count; ++i)
+        Dest[i] = NextFloat(MinVal, MaxVal);
+}
+
+RandomNumberGenerator& Math::GetThreadRNG( void )
+{
+    thread_local RandomNumberGenerator t_RNG;
+    return t_RNG;
+}
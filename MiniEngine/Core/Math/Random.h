@@ -14,54 +14,101 @@
 #pragma once
 
 #include "Common.h"
-#include <random>
 
 namespace Math
 {
+    // xoshiro128** for integers and xoshiro128+ for floats, which only use the upper bits.  Both step the same
+    // 128-bit state.  FillFloats() runs four more streams side by side in SSE registers.  A generator is not
+    // thread safe, so threads that need random numbers use GetThreadRNG() rather than sharing one.
     class RandomNumberGenerator
     {
     public:
-        RandomNumberGenerator() : m_gen(m_rd())
+        // Seeded from std::random_device
+        RandomNumberGenerator();
+
+        explicit RandomNumberGenerator( uint32_t Seed )
         {
+            SetSeed(Seed);
+        }
+
+        uint32_t NextUint( void )
+        {
+            uint32_t Result = Rotl(m_State[1] * 5, 7) * 9;
+            Advance();
+            return Result;
         }
 
         // Default int range is [MIN_INT, MAX_INT].  Max value is included.
         int32_t NextInt( void )
         {
-            return std::uniform_int_distribution<int32_t>(0x80000000, 0x7FFFFFFF)(m_gen);
+            return (int32_t)NextUint();
         }
 
         int32_t NextInt( int32_t MaxVal )
         {
-            return std::uniform_int_distribution<int32_t>(0, MaxVal)(m_gen);
+            return NextInt(0, MaxVal);
         }
 
         int32_t NextInt( int32_t MinVal, int32_t MaxVal )
         {
-            return std::uniform_int_distribution<int32_t>(MinVal, MaxVal)(m_gen);
+            // Multiply-shift maps 32 random bits onto the range with negligible bias and no division
+            uint64_t Range = (uint64_t)((int64_t)MaxVal - MinVal) + 1;
+            return (int32_t)(MinVal + (int64_t)((NextUint() * Range) >> 32));
         }
 
         // Default float range is [0.0f, 1.0f).  Max value is excluded.
         float NextFloat( float MaxVal = 1.0f )
         {
-            return std::uniform_real_distribution<float>(0.0f, MaxVal)(m_gen);
+            return ToUnitFloat(NextBits()) * MaxVal;
         }
 
         float NextFloat( float MinVal, float MaxVal )
         {
-            return std::uniform_real_distribution<float>(MinVal, MaxVal)(m_gen);
+            return MinVal + ToUnitFloat(NextBits()) * (MaxVal - MinVal);
         }
 
-        void SetSeed( UINT s )
+        // Writes Count floats in [MinVal, MaxVal), four at a time
+        void FillFloats( float* Dest, size_t Count, float MinVal = 0.0f, float MaxVal = 1.0f );
+
+        void SetSeed( uint32_t Seed );
+
+    private:
+
+        static uint32_t Rotl( uint32_t x, int k )
         {
-            m_gen.seed(s);
+            return (x << k) | (x >> (32 - k));
         }
 
-    private:
+        // The top 24 bits are exactly representable
+        static float ToUnitFloat( uint32_t Bits )
+        {
+            return (float)(Bits >> 8) * (1.0f / 16777216.0f);
+        }
+
+        uint32_t NextBits( void )
+        {
+            uint32_t Result = m_State[0] + m_State[3];
+            Advance();
+            return Result;
+        }
 
-        std::random_device m_rd;
-        std::minstd_rand m_gen;
+        void Advance( void )
+        {
+            uint32_t t = m_State[1] << 9;
+            m_State[2] ^= m_State[0];
+            m_State[3] ^= m_State[1];
+            m_State[1] ^= m_State[2];
+            m_State[0] ^= m_State[3];
+            m_State[2] ^= t;
+            m_State[3] = Rotl(m_State[3], 11);
+        }
+
+        __m128i m_Lanes[4];     // Word i of each of the four FillFloats() streams
+        uint32_t m_State[4];
     };
 
     extern RandomNumberGenerator g_RNG;
+
+    // A generator owned by the calling thread.  Each thread's is seeded separately.
+    RandomNumberGenerator& GetThreadRNG( void );
 };
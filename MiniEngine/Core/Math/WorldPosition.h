@@ -0,0 +1,42 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Developed by Minigraph
+//
+// Author:  James Stanard 
+//
+
+#pragma once
+
+#include "Vector.h"
+
+namespace Math
+{
+    // A position in a world too large for float coordinates.  Rendering subtracts a nearby origin in double
+    // precision and continues in float, so that positions close to the origin keep full float precision however
+    // far the origin is from zero (see BaseCamera::SetCameraRelative).
+    struct WorldPosition
+    {
+        double X, Y, Z;
+
+        WorldPosition() : X(0.0), Y(0.0), Z(0.0) {}
+        WorldPosition( double x, double y, double z ) : X(x), Y(y), Z(z) {}
+        explicit WorldPosition( Vector3 v ) : X((float)v.GetX()), Y((float)v.GetY()), Z((float)v.GetZ()) {}
+
+        WorldPosition operator+( Vector3 offset ) const
+        {
+            return WorldPosition(X + (float)offset.GetX(), Y + (float)offset.GetY(), Z + (float)offset.GetZ());
+        }
+
+        // The offset from origin, rounded to float
+        Vector3 operator-( const WorldPosition& origin ) const
+        {
+            return Vector3((float)(X - origin.X), (float)(Y - origin.Y), (float)(Z - origin.Z));
+        }
+    };
+}
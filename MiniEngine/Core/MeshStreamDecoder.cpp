@@ -0,0 +1,79 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Developed by Minigraph
+//
+
+#include "pch.h"
+#include "MeshStreamDecoder.h"
+#include "GraphicsCore.h"
+#include "CommandContext.h"
+#include "GpuBuffer.h"
+#include "EngineProfiling.h"
+
+#include "CompiledShaders/MeshDecodeVertexCS.h"
+#include "CompiledShaders/MeshDecodeIndexCS.h"
+
+using namespace Graphics;
+
+namespace
+{
+    RootSignature s_RootSignature;
+    ComputePSO s_DecodeVertexCS;
+    ComputePSO s_DecodeIndexCS;
+
+    const uint32_t kMaxGroupsPerRow = D3D12_CS_DISPATCH_MAX_THREAD_GROUPS_PER_DIMENSION;
+}
+
+void MeshStreamDecoder::Initialize( void )
+{
+    s_RootSignature.Reset(4, 0);
+    s_RootSignature[0].InitAsConstants(0, 2);
+    s_RootSignature[1].InitAsBufferSRV(0);
+    s_RootSignature[2].InitAsBufferSRV(1);
+    s_RootSignature[3].InitAsBufferUAV(0);
+    s_RootSignature.Finalize(L"Mesh Stream Decoder");
+
+#define CreatePSO( ObjName, ShaderByteCode ) \
+    ObjName.SetRootSignature(s_RootSignature); \
+    ObjName.SetComputeShader(ShaderByteCode, sizeof(ShaderByteCode) ); \
+    ObjName.Finalize();
+
+    CreatePSO( s_DecodeVertexCS, g_pMeshDecodeVertexCS );
+    CreatePSO( s_DecodeIndexCS, g_pMeshDecodeIndexCS );
+
+#undef CreatePSO
+}
+
+void MeshStreamDecoder::Decode( ComputeContext& Context, GpuBuffer& Encoded, GpuBuffer& Dest, const Block* Blocks, uint32_t BlockCount )
+{
+    if (BlockCount == 0)
+        return;
+
+    const bool IsIndexStream = Blocks[0].Stride == 0;
+
+    ScopedTimer _prof(L"Decode Mesh Stream", Context);
+
+    // The shaders merge bytes into the destination with atomic ORs
+    Context.TransitionResource(Dest, D3D12_RESOURCE_STATE_UNORDERED_ACCESS, true);
+    Context.ClearUAV(Dest);
+    Context.InsertUAVBarrier(Dest);
+    Context.TransitionResource(Encoded, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, true);
+
+    const uint32_t GroupsPerRow = std::min(BlockCount, kMaxGroupsPerRow);
+
+    Context.SetRootSignature(s_RootSignature);
+    Context.SetPipelineState(IsIndexStream ? s_DecodeIndexCS : s_DecodeVertexCS);
+    Context.SetConstants(0, BlockCount, GroupsPerRow);
+    Context.SetDynamicSRV(1, sizeof(Block) * BlockCount, Blocks);
+    Context.SetBufferSRV(2, Encoded);
+    Context.SetBufferUAV(3, Dest);
+    Context.Dispatch(GroupsPerRow, Math::DivideByMultiple(BlockCount, GroupsPerRow));
+
+    Context.TransitionResource(Dest, D3D12_RESOURCE_STATE_GENERIC_READ);
+}
@@ -0,0 +1,39 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Developed by Minigraph
+//
+
+#pragma once
+
+#include <cstdint>
+
+class ComputeContext;
+class GpuBuffer;
+
+// Decodes blocks of MeshCodec vertex and index streams (see Model/MeshCodec.h) with compute shaders, so that
+// compressed geometry can be copied to the GPU as it is stored and never decoded by the CPU.  Each block is
+// decoded by one group of 256 threads.
+namespace MeshStreamDecoder
+{
+    struct Block
+    {
+        uint32_t RawOffset;         // Where the decoded block goes in the destination, in bytes
+        uint32_t Count;             // At most 256 vertices or 4096 indices
+        uint32_t Stride;            // The vertex stride, or zero for a block of 16-bit indices
+        uint32_t PayloadBegin;      // The block's encoded bytes, as offsets into the encoded buffer
+        uint32_t PayloadEnd;
+    };
+
+    void Initialize( void );
+
+    // Decode blocks that are either all vertex blocks or all index blocks from Encoded into Dest.  Dest is
+    // cleared first and left in the generic read state.  The block ranges must have been checked against both
+    // buffers.  The payloads need not be, because the shaders never read outside them.
+    void Decode( ComputeContext& Context, GpuBuffer& Encoded, GpuBuffer& Dest, const Block* Blocks, uint32_t BlockCount );
+}
@@ -25,7 +25,10 @@
 #include "CompiledShaders/CameraMotionBlurPrePassCS.h"
 #include "CompiledShaders/CameraMotionBlurPrePassLinearZCS.h"
 #include "CompiledShaders/MotionBlurPrePassCS.h"
+#include "CompiledShaders/MotionBlurPrePassTileMaxCS.h"
+#include "CompiledShaders/TemporalPrepassCS.h"
 #include "CompiledShaders/MotionBlurFinalPassCS.h"
+#include "CompiledShaders/MotionBlurFinalPassTiledCS.h"
 #include "CompiledShaders/MotionBlurFinalPassPS.h"
 #include "CompiledShaders/CameraVelocityCS.h"
 #include "CompiledShaders/TemporalBlendCS.h"
@@ -37,13 +40,25 @@ using namespace Math;
 namespace MotionBlur
 {
     BoolVar Enable("Graphics/Motion Blur/Enable", false);
+    BoolVar SkipStaticTiles("Graphics/Motion Blur/Skip Static Tiles", true);
+    BoolVar SharedTemporalPrepass("Graphics/Motion Blur/Shared Temporal Prepass", true);
 
     RootSignature s_RootSignature;
     ComputePSO s_CameraMotionBlurPrePassCS[2];
     ComputePSO s_MotionBlurPrePassCS;
+    ComputePSO s_MotionBlurPrePassTileMaxCS;    // Queues tiles using the shared prepass's tile speeds
     ComputePSO s_MotionBlurFinalPassCS;
+    ComputePSO s_MotionBlurFinalPassTiledCS;    // Only blurs the tiles the prepass queued
     GraphicsPSO s_MotionBlurFinalPassPS;
     ComputePSO s_CameraVelocityCS[2];
+    ComputePSO s_TemporalPrepassCS;             // Velocity, dilation, and tile speeds for TAA and motion blur
+
+    bool s_VelocityIsDilated = false;
+
+    IndirectArgsBuffer s_IndirectParameters;
+
+    void ResetTileQueue( ComputeContext& Context );
+    void BlurQueuedTiles( ComputeContext& Context, uint32_t Width, uint32_t Height );
 }
 
 void MotionBlur::Initialize( void )
@@ -64,6 +79,7 @@ void MotionBlur::Initialize( void )
     if (g_bTypedUAVLoadSupport_R11G11B10_FLOAT)
     {
         CreatePSO(s_MotionBlurFinalPassCS, g_pMotionBlurFinalPassCS);
+        CreatePSO(s_MotionBlurFinalPassTiledCS, g_pMotionBlurFinalPassTiledCS);
     }
     else
     {
@@ -83,14 +99,53 @@ void MotionBlur::Initialize( void )
     CreatePSO( s_CameraMotionBlurPrePassCS[0], g_pCameraMotionBlurPrePassCS );
     CreatePSO( s_CameraMotionBlurPrePassCS[1], g_pCameraMotionBlurPrePassLinearZCS );
     CreatePSO( s_MotionBlurPrePassCS, g_pMotionBlurPrePassCS );
+    CreatePSO( s_MotionBlurPrePassTileMaxCS, g_pMotionBlurPrePassTileMaxCS );
     CreatePSO( s_CameraVelocityCS[0], g_pCameraVelocityCS );
     CreatePSO( s_CameraVelocityCS[1], g_pCameraVelocityCS );
+    CreatePSO( s_TemporalPrepassCS, g_pTemporalPrepassCS );
 
 #undef CreatePSO
+
+    // The prepass writes the tile count to X.  Each tile is four 8x8 groups.
+    __declspec(align(16)) const uint32_t initArgs[3] = { 0, 4, 1 };
+    s_IndirectParameters.Create(L"Motion Blur Indirect Parameters", 1, sizeof(D3D12_DISPATCH_ARGUMENTS), initArgs);
 }
 
 void MotionBlur::Shutdown( void )
 {
+    s_IndirectParameters.Destroy();
+}
+
+bool MotionBlur::IsVelocityDilated( void )
+{
+    return s_VelocityIsDilated;
+}
+
+void MotionBlur::ResetTileQueue( ComputeContext& Context )
+{
+    Context.ResetCounter(g_MotionBlurTileQueue);
+    Context.TransitionResource(g_MotionBlurTileQueue, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+    Context.SetDynamicDescriptor(2, 2, g_MotionBlurTileQueue.GetUAV());
+}
+
+// Expects the final pass PSO inputs other than the tile queue to be bound
+void MotionBlur::BlurQueuedTiles( ComputeContext& Context, uint32_t Width, uint32_t Height )
+{
+    if (SkipStaticTiles)
+    {
+        Context.TransitionResource(g_MotionBlurTileQueue, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+        Context.CopyCounter(s_IndirectParameters, 0, g_MotionBlurTileQueue);
+        Context.TransitionResource(s_IndirectParameters, D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT);
+
+        Context.SetPipelineState(s_MotionBlurFinalPassTiledCS);
+        Context.SetDynamicDescriptor(3, 2, g_MotionBlurTileQueue.GetSRV());
+        Context.DispatchIndirect(s_IndirectParameters, 0);
+    }
+    else
+    {
+        Context.SetPipelineState(s_MotionBlurFinalPassCS);
+        Context.Dispatch2D(Width, Height);
+    }
 }
 
 // Linear Z ends up being faster since we haven't officially decompressed the depth buffer.  You 
@@ -141,12 +196,28 @@ void MotionBlur::GenerateCameraVelocityBuffer( CommandContext& BaseContext, cons
     if (UseLinearZ)
         Context.TransitionResource(LinearDepth, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
     else
-        Context.TransitionResource(g_SceneDepthBuffer, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+        Context.TransitionDepthToReadOnly(g_SceneDepthBuffer);
 
-    Context.SetPipelineState(s_CameraVelocityCS[UseLinearZ ? 1 : 0]);
-    Context.SetDynamicDescriptor(3, 0, UseLinearZ ? LinearDepth.GetSRV() : g_SceneDepthBuffer.GetDepthSRV());
-    Context.SetDynamicDescriptor(2, 0, g_VelocityBuffer.GetUAV());
-    Context.Dispatch2D(Width, Height);
+    // The shared prepass searches the depth neighborhood once for TAA and finds the tile speeds once for motion
+    // blur.  Its closest depth search needs linear Z.
+    s_VelocityIsDilated = SharedTemporalPrepass && UseLinearZ;
+
+    if (s_VelocityIsDilated)
+    {
+        Context.TransitionResource(g_VelocityTileMax, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+        Context.SetPipelineState(s_TemporalPrepassCS);
+        Context.SetDynamicDescriptor(3, 0, LinearDepth.GetSRV());
+        Context.SetDynamicDescriptor(2, 0, g_VelocityBuffer.GetUAV());
+        Context.SetDynamicDescriptor(2, 1, g_VelocityTileMax.GetUAV());
+        Context.Dispatch2D(Width, Height, 16, 16);
+    }
+    else
+    {
+        Context.SetPipelineState(s_CameraVelocityCS[UseLinearZ ? 1 : 0]);
+        Context.SetDynamicDescriptor(3, 0, UseLinearZ ? LinearDepth.GetSRV() : g_SceneDepthBuffer.GetDepthSRV());
+        Context.SetDynamicDescriptor(2, 0, g_VelocityBuffer.GetUAV());
+        Context.Dispatch2D(Width, Height);
+    }
 }
 
 
@@ -194,10 +265,14 @@ void MotionBlur::RenderCameraBlur( CommandContext& BaseContext, const Matrix4& r
     if (UseLinearZ)
         Context.TransitionResource(LinearDepth, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
     else
-        Context.TransitionResource(g_SceneDepthBuffer, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+        Context.TransitionDepthToReadOnly(g_SceneDepthBuffer);
+
+    // The camera blur prepass writes its own velocities, which are not dilated
+    s_VelocityIsDilated = false;
 
     if (Enable)
     {
+        AcquireTransientBuffers(Context, kTransientMotionBlur);
         Context.TransitionResource(g_VelocityBuffer, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
         Context.TransitionResource(g_MotionPrepBuffer, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
         Context.TransitionResource(g_SceneColorBuffer, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
@@ -207,11 +282,11 @@ void MotionBlur::RenderCameraBlur( CommandContext& BaseContext, const Matrix4& r
         Context.SetDynamicDescriptor(3, 1, UseLinearZ ? LinearDepth.GetSRV() : g_SceneDepthBuffer.GetDepthSRV());
         Context.SetDynamicDescriptor(2, 0, g_MotionPrepBuffer.GetUAV());
         Context.SetDynamicDescriptor(2, 1, g_VelocityBuffer.GetUAV());
+        ResetTileQueue(Context);
         Context.Dispatch2D(g_MotionPrepBuffer.GetWidth(), g_MotionPrepBuffer.GetHeight());
 
         if (g_bTypedUAVLoadSupport_R11G11B10_FLOAT)
         {
-            Context.SetPipelineState(s_MotionBlurFinalPassCS);
             Context.SetConstants(0, 1.0f / Width, 1.0f / Height);
 
             Context.TransitionResource(g_SceneColorBuffer, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
@@ -221,7 +296,7 @@ void MotionBlur::RenderCameraBlur( CommandContext& BaseContext, const Matrix4& r
             Context.SetDynamicDescriptor(3, 0, g_VelocityBuffer.GetSRV());
             Context.SetDynamicDescriptor(3, 1, g_MotionPrepBuffer.GetSRV());
 
-            Context.Dispatch2D(Width, Height);
+            BlurQueuedTiles(Context, Width, Height);
 
             Context.InsertUAVBarrier(g_SceneColorBuffer);
         }
@@ -271,14 +346,23 @@ void MotionBlur::RenderObjectBlur( CommandContext& BaseContext, ColorBuffer& vel
     Context.SetDynamicDescriptor(2, 0, g_MotionPrepBuffer.GetUAV());
     Context.SetDynamicDescriptor(3, 0, g_SceneColorBuffer.GetSRV());
     Context.SetDynamicDescriptor(3, 1, velocityBuffer.GetSRV());
+    ResetTileQueue(Context);
 
-    Context.SetPipelineState(s_MotionBlurPrePassCS);
+    // Reuse the tile speeds when the velocity buffer came from the shared prepass
+    if (&velocityBuffer == &g_VelocityBuffer && s_VelocityIsDilated)
+    {
+        Context.TransitionResource(g_VelocityTileMax, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+        Context.SetDynamicDescriptor(3, 2, g_VelocityTileMax.GetSRV());
+        Context.SetPipelineState(s_MotionBlurPrePassTileMaxCS);
+    }
+    else
+    {
+        Context.SetPipelineState(s_MotionBlurPrePassCS);
+    }
     Context.Dispatch2D(g_MotionPrepBuffer.GetWidth(), g_MotionPrepBuffer.GetHeight());
 
     if (g_bTypedUAVLoadSupport_R11G11B10_FLOAT)
     {
-        Context.SetPipelineState(s_MotionBlurFinalPassCS);
-
         Context.TransitionResource(g_SceneColorBuffer, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
         Context.TransitionResource(velocityBuffer, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
         Context.TransitionResource(g_MotionPrepBuffer, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
@@ -288,7 +372,7 @@ void MotionBlur::RenderObjectBlur( CommandContext& BaseContext, ColorBuffer& vel
         Context.SetDynamicDescriptor(3, 1, g_MotionPrepBuffer.GetSRV());
         Context.SetConstants(0, 1.0f / Width, 1.0f / Height);
 
-        Context.Dispatch2D(Width, Height);
+        BlurQueuedTiles(Context, Width, Height);
 
         Context.InsertUAVBarrier(g_SceneColorBuffer);
     }
@@ -30,6 +30,10 @@ namespace MotionBlur
     void GenerateCameraVelocityBuffer( CommandContext& Context, const Math::Camera& camera, bool UseLinearZ = true );
     void GenerateCameraVelocityBuffer( CommandContext& Context, const Math::Matrix4& reprojectionMatrix, float nearClip, float farClip, bool UseLinearZ = true);
 
+    // True when the velocity buffer came from the shared temporal prepass.  Its velocities are then dilated to
+    // the closest pixel of each '+' neighborhood, and g_VelocityTileMax holds the fastest speed of each tile.
+    bool IsVelocityDilated( void );
+
     // Generate motion blur only associated with the camera.  Does not handle fast-moving objects well, but
     // does not require a full screen velocity buffer.
     void RenderCameraBlur( CommandContext& Context, const Math::Camera& camera, bool UseLinearZ = true );
@@ -26,10 +26,9 @@ using namespace ParticleEffects;
 
 namespace ParticleEffects
 {
-    extern ComputePSO s_ParticleSpawnCS;
-    extern ComputePSO s_ParticleUpdateCS;
-    extern ComputePSO s_ParticleDispatchIndirectArgsCS;
-    extern StructuredBuffer SpriteVertexBuffer;
+    extern StructuredBuffer SpawnDataPool;
+    extern StructuredBuffer EffectPropertyPool;
+    extern ByteAddressBuffer EffectCounters;
     extern RandomNumberGenerator s_RNG;
 }
 
@@ -39,28 +38,34 @@ ParticleEffect::ParticleEffect(ParticleEffectProperties& effectProperties)
     m_EffectProperties = effectProperties;
 }
 
-inline static Color RandColor( Color c0, Color c1 )
+// Maps a uniform random number in [0, 1) onto [a, b)
+inline static float RandRange( float u, float a, float b )
+{
+    return a + (b - a) * u;
+}
+
+inline static Color RandColor( const float* u, Color c0, Color c1 )
 {
     // We might want to find min and max of each channel rather than assuming c0 <= c1
     return Color(
-        s_RNG.NextFloat( c0.R(), c1.R()),
-        s_RNG.NextFloat( c0.G(), c1.G()),
-        s_RNG.NextFloat( c0.B(), c1.B()),
-        s_RNG.NextFloat( c0.A(), c1.A())
+        RandRange(u[0], c0.R(), c1.R()),
+        RandRange(u[1], c0.G(), c1.G()),
+        RandRange(u[2], c0.B(), c1.B()),
+        RandRange(u[3], c0.A(), c1.A())
         );
 }
 
-inline static XMFLOAT3 RandSpread( const XMFLOAT3& s )
+inline static XMFLOAT3 RandSpread( const float* u, const XMFLOAT3& s )
 {
     // We might want to find min and max of each channel rather than assuming c0 <= c1
     return XMFLOAT3(
-        s_RNG.NextFloat(-s.x, s.x),
-        s_RNG.NextFloat(-s.y, s.y), 
-        s_RNG.NextFloat(-s.z, s.z)
+        RandRange(u[0], -s.x, s.x),
+        RandRange(u[1], -s.y, s.y),
+        RandRange(u[2], -s.z, s.z)
         );
 }
 
-void ParticleEffect::LoadDeviceResources(ID3D12Device* device)
+void ParticleEffect::LoadDeviceResources(ID3D12Device* device, uint32_t ParticleOffset, uint32_t EffectSlot)
 {
     (device); // Currently unused.  May be useful with multi-adapter support.
 
@@ -68,42 +73,56 @@ void ParticleEffect::LoadDeviceResources(ID3D12Device* device)
     
     //Fill particle spawn data buffer
     ParticleSpawnData* pSpawnData = (ParticleSpawnData*)_malloca(m_EffectProperties.EmitProperties.MaxParticles * sizeof(ParticleSpawnData));
+
+    // Draw every particle's random numbers in one batch
+    const UINT kRandomsPerParticle = 20;
+    std::vector<float> Randoms((size_t)m_EffectProperties.EmitProperties.MaxParticles * kRandomsPerParticle);
+    s_RNG.FillFloats(Randoms.data(), Randoms.size());
     
     for (UINT i = 0; i < m_EffectProperties.EmitProperties.MaxParticles; i++)
     {
+        const float* u = &Randoms[(size_t)i * kRandomsPerParticle];
+
         ParticleSpawnData& SpawnData = pSpawnData[i];
-        SpawnData.AgeRate = 1.0f / s_RNG.NextFloat( m_EffectProperties.LifeMinMax.x, m_EffectProperties.LifeMinMax.y );
-        float horizontalAngle = s_RNG.NextFloat(XM_2PI);
-        float horizontalVelocity = s_RNG.NextFloat( m_EffectProperties.Velocity.GetX(), m_EffectProperties.Velocity.GetY() );
+        SpawnData.AgeRate = 1.0f / RandRange( u[0], m_EffectProperties.LifeMinMax.x, m_EffectProperties.LifeMinMax.y );
+        float horizontalAngle = u[1] * XM_2PI;
+        float horizontalVelocity = RandRange( u[2], m_EffectProperties.Velocity.GetX(), m_EffectProperties.Velocity.GetY() );
         SpawnData.Velocity.x = horizontalVelocity * cos(horizontalAngle);
-        SpawnData.Velocity.y = s_RNG.NextFloat( m_EffectProperties.Velocity.GetZ(), m_EffectProperties.Velocity.GetW() );
+        SpawnData.Velocity.y = RandRange( u[3], m_EffectProperties.Velocity.GetZ(), m_EffectProperties.Velocity.GetW() );
         SpawnData.Velocity.z = horizontalVelocity * sin(horizontalAngle);
 
-        SpawnData.SpreadOffset = RandSpread(m_EffectProperties.Spread ) ;
+        SpawnData.SpreadOffset = RandSpread( u + 4, m_EffectProperties.Spread );
 
-        SpawnData.StartSize = s_RNG.NextFloat( m_EffectProperties.Size.GetX(), m_EffectProperties.Size.GetY() );
-        SpawnData.EndSize = s_RNG.NextFloat( m_EffectProperties.Size.GetZ(), m_EffectProperties.Size.GetW() );
-        SpawnData.StartColor = RandColor( m_EffectProperties.MinStartColor, m_EffectProperties.MaxStartColor );
-        SpawnData.EndColor = RandColor( m_EffectProperties.MinEndColor, m_EffectProperties.MaxEndColor );
-        SpawnData.Mass = s_RNG.NextFloat( m_EffectProperties.MassMinMax.x, m_EffectProperties.MassMinMax.y );
-        SpawnData.RotationSpeed = s_RNG.NextFloat(); //todo
-        SpawnData.Random = s_RNG.NextFloat();
+        SpawnData.StartSize = RandRange( u[7], m_EffectProperties.Size.GetX(), m_EffectProperties.Size.GetY() );
+        SpawnData.EndSize = RandRange( u[8], m_EffectProperties.Size.GetZ(), m_EffectProperties.Size.GetW() );
+        SpawnData.StartColor = RandColor( u + 9, m_EffectProperties.MinStartColor, m_EffectProperties.MaxStartColor );
+        SpawnData.EndColor = RandColor( u + 13, m_EffectProperties.MinEndColor, m_EffectProperties.MaxEndColor );
+        SpawnData.Mass = RandRange( u[17], m_EffectProperties.MassMinMax.x, m_EffectProperties.MassMinMax.y );
+        SpawnData.RotationSpeed = u[18]; //todo
+        SpawnData.Random = u[19];
     }
     
-    m_RandomStateBuffer.Create(L"ParticleSystem::SpawnDataBuffer", m_EffectProperties.EmitProperties.MaxParticles, sizeof(ParticleSpawnData), pSpawnData);
+    CommandContext::InitializeBuffer(SpawnDataPool, pSpawnData, m_EffectProperties.EmitProperties.MaxParticles * sizeof(ParticleSpawnData),
+        ParticleOffset * sizeof(ParticleSpawnData));
     _freea(pSpawnData);
 
-    m_StateBuffers[0].Create(L"ParticleSystem::Buffer0", m_EffectProperties.EmitProperties.MaxParticles, sizeof(ParticleMotion));
-    m_StateBuffers[1].Create(L"ParticleSystem::Buffer1", m_EffectProperties.EmitProperties.MaxParticles, sizeof(ParticleMotion));
-    m_CurrentStateBuffer = 0;
+    // The emitter does not move, so its last position is always its current one
+    EffectPropertyBlock PropertyBlock = {};
+    PropertyBlock.EmitProperties = m_EffectProperties.EmitProperties;
+    PropertyBlock.EmitProperties.LastEmitPosW = PropertyBlock.EmitProperties.EmitPosW;
+    PropertyBlock.ParticleOffset = ParticleOffset;
+    CommandContext::InitializeBuffer(EffectPropertyPool, &PropertyBlock, sizeof(EffectPropertyBlock), EffectSlot * sizeof(EffectPropertyBlock));
 
-    //DispatchIndirect args buffer / number of thread groups
-    __declspec(align(16)) UINT DispatchIndirectData[3] = { 0, 1, 1 };
-    m_DispatchIndirectArgs.Create(L"ParticleSystem::DispatchIndirectArgs", 1, sizeof(D3D12_DISPATCH_ARGUMENTS), DispatchIndirectData);
+    // Both sides of the ping-pong start out empty
+    __declspec(align(16)) UINT InitialCounts[4] = { 0, 0, 0, 0 };
+    CommandContext::InitializeBuffer(EffectCounters, InitialCounts, 2 * sizeof(UINT), EffectSlot * 2 * sizeof(UINT));
 
+    m_ParticleOffset = ParticleOffset;
+    m_EffectSlot = EffectSlot;
+    m_CurrentStateBuffer = 0;
 }
 
-void ParticleEffect::Update(ComputeContext& CompContext,  float timeDelta)
+void ParticleEffect::Update(ParticleEffectEntry& Entry, float timeDelta)
 {
 
     m_ElapsedTime += timeDelta;
@@ -115,46 +134,11 @@ void ParticleEffect::Update(ComputeContext& CompContext,  float timeDelta)
     //m_EffectProperties.EmitProperties.EmitPosW.z += m_EffectProperties.DirectionIncrement.z;
 
 
-    //CPU side random num gen
-    for (uint32_t i = 0; i < 64; i++)
-    {
-        UINT random = (UINT)s_RNG.NextInt(m_EffectProperties.EmitProperties.MaxParticles - 1);
-        m_EffectProperties.EmitProperties.RandIndex[i].x = random;
-    }
-    CompContext.SetDynamicConstantBufferView(2, sizeof(EmissionProperties), &m_EffectProperties.EmitProperties);    
-
-    CompContext.TransitionResource(m_StateBuffers[m_CurrentStateBuffer], D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
-    CompContext.SetDynamicDescriptor(4, 0, m_RandomStateBuffer.GetSRV());
-    CompContext.SetDynamicDescriptor(4, 1, m_StateBuffers[m_CurrentStateBuffer].GetSRV());
+    Entry.EffectSlot = m_EffectSlot;
+    Entry.CounterIndex = m_EffectSlot * 2 + m_CurrentStateBuffer;
+    Entry.SpawnCount = std::min((UINT)(m_EffectProperties.EmitRate * timeDelta), m_EffectProperties.EmitProperties.MaxParticles);
 
     m_CurrentStateBuffer ^= 1;
-
-    CompContext.ResetCounter(m_StateBuffers[m_CurrentStateBuffer]);
-
-    CompContext.SetPipelineState(s_ParticleUpdateCS);
-    CompContext.TransitionResource(m_StateBuffers[m_CurrentStateBuffer], D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
-    CompContext.TransitionResource(m_DispatchIndirectArgs, D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT);
-    CompContext.SetDynamicDescriptor(3, 2, m_StateBuffers[m_CurrentStateBuffer].GetUAV());
-    CompContext.DispatchIndirect(m_DispatchIndirectArgs, 0);
-
-    // Why need a barrier here so long as we are artificially clamping particle count.  This allows living
-    // particles to take precedence over new particles.  The current system always spawns a multiple of 64
-    // particles (To Be Fixed) until the total particle count reaches maximum.
-    CompContext.InsertUAVBarrier(m_StateBuffers[m_CurrentStateBuffer]);
-    
-    // Spawn to replace dead ones 
-    CompContext.SetPipelineState(s_ParticleSpawnCS);
-    CompContext.SetDynamicDescriptor(4, 0, m_RandomStateBuffer.GetSRV());
-    UINT NumSpawnThreads = (UINT)(m_EffectProperties.EmitRate * timeDelta);
-    CompContext.Dispatch((NumSpawnThreads + 63) / 64, 1, 1);
-
-    // Output number of thread groups into m_DispatchIndirectArgs    
-    CompContext.SetPipelineState(s_ParticleDispatchIndirectArgsCS);
-    CompContext.TransitionResource(m_DispatchIndirectArgs, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
-    CompContext.TransitionResource(m_StateBuffers[m_CurrentStateBuffer], D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
-    CompContext.SetDynamicDescriptor(4, 0, m_StateBuffers[m_CurrentStateBuffer].GetCounterSRV(CompContext));
-    CompContext.SetDynamicDescriptor(3, 1, m_DispatchIndirectArgs.GetUAV());
-    CompContext.Dispatch(1, 1, 1);
 }
 
 
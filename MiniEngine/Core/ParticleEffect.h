@@ -21,19 +21,20 @@ class ParticleEffect
 {
 public:
     ParticleEffect(ParticleEffectProperties& effectProperties);
-    void LoadDeviceResources(ID3D12Device* device);
-    void Update(ComputeContext& CompContext, float timeDelta);
+    // ParticleOffset is the effect's range of the shared particle pools, and EffectSlot picks its live counters.
+    void LoadDeviceResources(ID3D12Device* device, uint32_t ParticleOffset, uint32_t EffectSlot);
+    // Advances the effect and fills in its entry of the frame's effect table (except FirstSpawnGroup).
+    void Update(ParticleEffectEntry& Entry, float timeDelta);
+    uint32_t GetMaxParticles(){ return m_EffectProperties.EmitProperties.MaxParticles; }
     float GetLifetime(){ return m_EffectProperties.TotalActiveLifetime; }
     float GetElapsedTime(){ return m_ElapsedTime; }
     void Reset();
 
 private:
 
-    StructuredBuffer m_StateBuffers[2];
+    uint32_t m_ParticleOffset;
+    uint32_t m_EffectSlot;
     uint32_t m_CurrentStateBuffer;
-    StructuredBuffer m_RandomStateBuffer; 
-    IndirectArgsBuffer m_DispatchIndirectArgs;
-    IndirectArgsBuffer m_DrawIndirectArgs;
 
     ParticleEffectProperties m_EffectProperties;
     ParticleEffectProperties m_OriginalEffectProperties;
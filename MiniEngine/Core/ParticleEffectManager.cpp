@@ -25,7 +25,10 @@
 #include "ParticleEffect.h"
 #include "ParticleEffectProperties.h"
 #include "TextureManager.h"
+#include "GpuMemory.h"
+#include "ShaderPermutation.h"
 #include <mutex>
+#include <algorithm>
 
 #include "CompiledShaders/ParticleSpawnCS.h"
 #include "CompiledShaders/ParticleUpdateCS.h"
@@ -34,23 +37,19 @@
 #include "CompiledShaders/ParticleLargeBinCullingCS.h"
 #include "CompiledShaders/ParticleBinCullingCS.h"
 
-#include "CompiledShaders/ParticleTileRenderCS.h"
-#include "CompiledShaders/ParticleTileRenderFastCS.h"
-#include "CompiledShaders/ParticleTileRenderSlowDynamicCS.h"
-#include "CompiledShaders/ParticleTileRenderFastDynamicCS.h"
-#include "CompiledShaders/ParticleTileRenderSlowLowResCS.h"
-#include "CompiledShaders/ParticleTileRenderFastLowResCS.h"
-
-#include "CompiledShaders/ParticleTileRender2CS.h"
-#include "CompiledShaders/ParticleTileRenderFast2CS.h"
-#include "CompiledShaders/ParticleTileRenderSlowDynamic2CS.h"
-#include "CompiledShaders/ParticleTileRenderFastDynamic2CS.h"
-#include "CompiledShaders/ParticleTileRenderSlowLowRes2CS.h"
-#include "CompiledShaders/ParticleTileRenderFastLowRes2CS.h"
+#include "CompiledShaders/ParticleTileRenderCS_Permutations.h"
 
 #include "CompiledShaders/ParticleTileCullingCS.h"
 #include "CompiledShaders/ParticleDepthBoundsCS.h"
 
+// To use the wave intrinsic versions of the compaction shaders, uncomment this macro and #define DXIL in
+// Core/GraphicsCore.cpp.  Run CompileSM6Test.bat to compile them with DXC.
+//#define _WAVE_OP
+#ifdef _WAVE_OP
+#include "CompiledShaders/ParticleUpdateCS_SM6.h"
+#include "CompiledShaders/ParticleTileCullingCS_SM6.h"
+#endif
+
 #include "CompiledShaders/ParticleSortIndirectArgsCS.h"
 #include "CompiledShaders/ParticlePreSortCS.h"
 #include "CompiledShaders/ParticlePS.h"
@@ -79,17 +78,26 @@ namespace ParticleEffects
     BoolVar Enable("Graphics/Particle Effects/Enable", true);
     BoolVar EnableSpriteSort("Graphics/Particle Effects/Sort Sprites", true);
     BoolVar EnableTiledRendering("Graphics/Particle Effects/Tiled Rendering", true);
+    BoolVar EnableBinDepthCulling("Graphics/Particle Effects/Depth Cull Bins", true);
     BoolVar PauseSim("Graphics/Particle Effects/Pause Simulation", false);
+    BoolVar AsyncCompute("Graphics/Particle Effects/Async Compute", true);
     const char* ResolutionLabels[] = { "High-Res", "Low-Res", "Dynamic" };
     EnumVar TiledRes("Graphics/Particle Effects/Tiled Sample Rate", 2, 3, ResolutionLabels);
     NumVar DynamicResLevel("Graphics/Particle Effects/Dynamic Resolution Cutoff", 0.0f, -4.0f, 4.0f, 0.5f);
     NumVar MipBias("Graphics/Particle Effects/Mip Bias", 0.0f, -4.0f, 4.0f, 0.5f);
+    IntVar ParticleBudget("Graphics/Particle Effects/Particle Budget", MAX_TOTAL_PARTICLES, 0, MAX_TOTAL_PARTICLES, 4096);
     
     ComputePSO s_ParticleSpawnCS;
     ComputePSO s_ParticleUpdateCS;
     ComputePSO s_ParticleDispatchIndirectArgsCS;
 
     StructuredBuffer SpriteVertexBuffer;
+
+    // Every effect simulates out of these, so all active effects update in one batched dispatch
+    StructuredBuffer ParticleStatePool;
+    StructuredBuffer SpawnDataPool;
+    StructuredBuffer EffectPropertyPool;
+    ByteAddressBuffer EffectCounters;
     
     UINT s_ReproFrame = 0;//201;
     RandomNumberGenerator s_RNG;
@@ -122,8 +130,7 @@ namespace
     ComputePSO s_ParticleLargeBinCullingCS; 
     ComputePSO s_ParticleBinCullingCS; 
     ComputePSO s_ParticleTileCullingCS; 
-    ComputePSO s_ParticleTileRenderSlowCS[3];    // High-Res, Low-Res, Dynamic-Res
-    ComputePSO s_ParticleTileRenderFastCS[3];     // High-Res, Low-Res, Dynamic-Res (disable depth tests)
+    ComputePSOPermutations s_ParticleTileRenderCS;
     ComputePSO s_ParticleDepthBoundsCS;
     GraphicsPSO s_NoTileRasterizationPSO[2];
     ComputePSO s_ParticleSortIndirectArgsCS;
@@ -139,6 +146,7 @@ namespace
     StructuredBuffer VisibleParticleBuffer;
     StructuredBuffer BinParticles[2];
     ByteAddressBuffer BinCounters[2];
+    ByteAddressBuffer LargeBinMaxDepth;
     StructuredBuffer TileCounters;
     ByteAddressBuffer TileHitMasks;
 
@@ -146,6 +154,10 @@ namespace
     StructuredBuffer TileFastDrawPackets;
     IndirectArgsBuffer TileDrawDispatchIndirectArgs;
 
+    IndirectArgsBuffer UpdateDispatchArgs;
+    StructuredBuffer UpdateGroupOffsets;
+    uint32_t s_AllocatedParticles = 0;
+
     CBChangesPerView s_ChangesPerView;
 
     GpuResource TextureArray;
@@ -158,20 +170,62 @@ namespace
     static bool s_InitComplete = false; 
     UINT TotalElapsedFrames;
 
+    // Compute queue fence of this frame's async simulation, until the graphics queue has waited for it
+    uint64_t s_AsyncUpdateFence = 0;
+
     void SetFinalBuffers(ComputeContext& CompContext)
     {
         CompContext.SetPipelineState(s_ParticleFinalDispatchIndirectArgsCS);
+        CompContext.SetConstants(0, (uint32_t)(int32_t)ParticleBudget);
 
-        CompContext.TransitionResource(SpriteVertexBuffer, D3D12_RESOURCE_STATE_GENERIC_READ);
+        // Rendering transitions the sprites again, so only use a state that is valid on the compute queue
+        CompContext.TransitionResource(SpriteVertexBuffer, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
         CompContext.TransitionResource(FinalDispatchIndirectArgs, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
         CompContext.TransitionResource(DrawIndirectArgs, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
         CompContext.SetDynamicDescriptor(3, 0, FinalDispatchIndirectArgs.GetUAV());
         CompContext.SetDynamicDescriptor(3, 1, DrawIndirectArgs.GetUAV());
-        CompContext.SetDynamicDescriptor(4, 0, SpriteVertexBuffer.GetCounterSRV(CompContext));
+        CompContext.SetDynamicDescriptor(3, 2, SpriteVertexBuffer.GetCounterUAV(CompContext));
 
         CompContext.Dispatch( 1, 1, 1 );
     }
 
+    // Simulates up to MAX_EFFECTS_PER_BATCH effects of the frame's effect table with one update dispatch
+    void UpdateBatch(ComputeContext& CompContext, D3D12_GPU_VIRTUAL_ADDRESS EffectTable, uint32_t NumEffects, float timeDelta)
+    {
+        CompContext.SetConstantBuffer(2, EffectTable);
+        CompContext.SetConstants(0, timeDelta, NumEffects, (uint32_t)s_RNG.NextInt());
+
+        // Size the update from the live particle counts left on the GPU by last frame
+        CompContext.SetPipelineState(s_ParticleDispatchIndirectArgsCS);
+        CompContext.TransitionResource(UpdateDispatchArgs, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+        CompContext.TransitionResource(UpdateGroupOffsets, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+        CompContext.SetDynamicDescriptor(3, 1, UpdateDispatchArgs.GetUAV());
+        CompContext.SetDynamicDescriptor(3, 5, UpdateGroupOffsets.GetUAV());
+        CompContext.Dispatch(1, 1, 1);
+
+        CompContext.InsertUAVBarrier(EffectCounters);
+
+        CompContext.SetPipelineState(s_ParticleUpdateCS);
+        CompContext.TransitionResource(UpdateDispatchArgs, D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT);
+        CompContext.TransitionResource(UpdateGroupOffsets, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+        CompContext.SetDynamicDescriptor(4, 1, UpdateGroupOffsets.GetSRV());
+        CompContext.DispatchIndirect(UpdateDispatchArgs);
+    }
+
+    // Reserves MaxParticles spawn records and 2 * MaxParticles states in the shared pools
+    uint32_t AllocateParticles(uint32_t MaxParticles)
+    {
+        static std::mutex s_AllocationMutex;
+        std::lock_guard<std::mutex> Guard(s_AllocationMutex);
+
+        if (MaxParticles == 0 || s_AllocatedParticles + MaxParticles > MAX_TOTAL_PARTICLES)
+            return EFFECTS_ERROR;
+
+        uint32_t ParticleOffset = s_AllocatedParticles;
+        s_AllocatedParticles += MaxParticles;
+        return ParticleOffset;
+    }
+
     void MaintainTextureList(ParticleEffectProperties& effectProperties)
     {
         std::wstring name = effectProperties.TexturePath;
@@ -189,10 +243,11 @@ namespace
         UINT TextureID = (UINT)(TextureNameArray.size() - 1);
         effectProperties.EmitProperties.TextureID = TextureID;
 
-        const ManagedTexture* managedTex = TextureManager::LoadDDSFromFile(name.c_str(), true);
+        // The texture is copied into the array, so it doesn't need to stay loaded
+        TextureRef managedTex = TextureManager::LoadDDSFromFile(name.c_str(), true);
         managedTex->WaitForLoad();
 
-        GpuResource& ParticleTexture = *const_cast<ManagedTexture*>(managedTex);
+        GpuResource& ParticleTexture = *const_cast<ManagedTexture*>(managedTex.Get());
         CommandContext::InitializeTextureArraySlice(TextureArray, TextureID, ParticleTexture);
     }
 
@@ -214,9 +269,11 @@ namespace
             CompContext.TransitionResource(g_MinMaxDepth8, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
             CompContext.TransitionResource(g_MinMaxDepth16, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
             CompContext.TransitionResource(g_MinMaxDepth32, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+            CompContext.TransitionResource(LargeBinMaxDepth, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
             CompContext.SetDynamicDescriptor(3, 0, g_MinMaxDepth8.GetUAV());
             CompContext.SetDynamicDescriptor(3, 1, g_MinMaxDepth16.GetUAV());
             CompContext.SetDynamicDescriptor(3, 2, g_MinMaxDepth32.GetUAV());
+            CompContext.SetDynamicDescriptor(3, 3, LargeBinMaxDepth.GetUAV());
             CompContext.SetDynamicDescriptor(4, 0, LinearDepth.GetSRV());
 
             CompContext.Dispatch2D(ScreenWidth, ScreenHeight, 32, 32);
@@ -228,28 +285,32 @@ namespace
             CompContext.ResetCounter(VisibleParticleBuffer);
 
             // The first step inserts each particle into all of the large bins it intersects.  Large bins
-            // are 512x256.
+            // are 512x256.  Particles behind the farthest depth of a bin are left out of it, and particles
+            // left out of every bin are dropped before any sorting happens.
             CompContext.SetPipelineState(s_ParticleLargeBinCullingCS);
-            CompContext.SetConstants(0, 5, 4);
+            CompContext.SetConstants(0, 5, 4, (uint32_t)(bool)EnableBinDepthCulling);
 
             CompContext.TransitionResource(SpriteVertexBuffer, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
             CompContext.TransitionResource(FinalDispatchIndirectArgs, D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT);
             CompContext.TransitionResource(BinParticles[0], D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
             CompContext.TransitionResource(BinCounters[0], D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
             CompContext.TransitionResource(VisibleParticleBuffer, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+            CompContext.TransitionResource(LargeBinMaxDepth, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+            CompContext.TransitionResource(g_MinMaxDepth32, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
 
             CompContext.SetDynamicDescriptor(3, 0, BinParticles[0].GetUAV());
             CompContext.SetDynamicDescriptor(3, 1, BinCounters[0].GetUAV());
             CompContext.SetDynamicDescriptor(3, 2, VisibleParticleBuffer.GetUAV());
             CompContext.SetDynamicDescriptor(4, 0, SpriteVertexBuffer.GetSRV());
             CompContext.SetDynamicDescriptor(4, 1, SpriteVertexBuffer.GetCounterSRV(CompContext));
+            CompContext.SetDynamicDescriptor(4, 2, LargeBinMaxDepth.GetSRV());
 
             CompContext.DispatchIndirect(FinalDispatchIndirectArgs);
 
             // The second step refines the binning by inserting particles into the appropriate small bins.
-            // Small bins are 128x64.
+            // Small bins are 128x64, and each is depth tested again with its own farthest depth.
             CompContext.SetPipelineState(s_ParticleBinCullingCS);
-            CompContext.SetConstants(0, 3, 2);
+            CompContext.SetConstants(0, 3, 2, (uint32_t)(bool)EnableBinDepthCulling);
 
             CompContext.TransitionResource(VisibleParticleBuffer, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
             CompContext.TransitionResource(BinParticles[0], D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
@@ -262,6 +323,7 @@ namespace
             CompContext.SetDynamicDescriptor(4, 0, VisibleParticleBuffer.GetSRV());
             CompContext.SetDynamicDescriptor(4, 1, BinParticles[0].GetSRV());
             CompContext.SetDynamicDescriptor(4, 2, BinCounters[0].GetSRV());
+            CompContext.SetDynamicDescriptor(4, 3, g_MinMaxDepth32.GetSRV());
 
             CompContext.Dispatch2D(ScreenWidth, ScreenHeight, 4 * BIN_SIZE_X, 4 * BIN_SIZE_Y);
 
@@ -328,10 +390,17 @@ namespace
 
             CompContext.SetConstants(0, (float)DynamicResLevel, (float)MipBias);
 
-            CompContext.SetPipelineState(s_ParticleTileRenderSlowCS[TiledRes]);
+            // High-Res, Low-Res, Dynamic-Res
+            static const uint32_t kResolutionFeatures[3] = { 0, PERMUTATION_LOW_RESOLUTION, PERMUTATION_DYNAMIC_RESOLUTION };
+            uint32_t Features = kResolutionFeatures[TiledRes];
+            if (g_bTypedUAVLoadSupport_R11G11B10_FLOAT)
+                Features |= PERMUTATION_TYPED_UAV_LOADS;
+
+            CompContext.SetPipelineState(s_ParticleTileRenderCS.Get(Features));
             CompContext.DispatchIndirect(TileDrawDispatchIndirectArgs, 0);
 
-            CompContext.SetPipelineState(s_ParticleTileRenderFastCS[TiledRes]);
+            // Tiles fully in front of the scene skip the depth tests
+            CompContext.SetPipelineState(s_ParticleTileRenderCS.Get(Features | PERMUTATION_NO_DEPTH_TESTS));
             CompContext.DispatchIndirect(TileDrawDispatchIndirectArgs, 12);
         }
     }
@@ -397,7 +466,7 @@ namespace
         GrContext.SetDynamicDescriptor(4, 3, SpriteIndexBuffer.GetSRV());
         GrContext.SetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP);
         GrContext.TransitionResource(ColorTarget, D3D12_RESOURCE_STATE_RENDER_TARGET);
-        GrContext.TransitionResource(DepthTarget, D3D12_RESOURCE_STATE_DEPTH_READ);
+        GrContext.TransitionDepthToReadOnly(DepthTarget);
         GrContext.SetRenderTarget(ColorTarget.GetRTV(), DepthTarget.GetDSV_DepthReadOnly());
         GrContext.SetViewportAndScissor(viewport, scissor);
         GrContext.DrawIndirect(DrawIndirectArgs);
@@ -413,6 +482,8 @@ namespace
 
 void ParticleEffects::Initialize( uint32_t MaxDisplayWidth, uint32_t MaxDisplayHeight )
 {    
+    GpuMemory::ScopedCategory MemoryCategory(GpuMemory::kParticles);
+
     D3D12_SAMPLER_DESC SamplerBilinearBorderDesc = SamplerPointBorderDesc;
     SamplerBilinearBorderDesc.Filter = D3D12_FILTER_COMPARISON_MIN_MAG_LINEAR_MIP_POINT;
 
@@ -432,31 +503,24 @@ void ParticleEffects::Initialize( uint32_t MaxDisplayWidth, uint32_t MaxDisplayH
     ObjName.SetComputeShader(ShaderByteCode, sizeof(ShaderByteCode) ); \
     ObjName.Finalize();
     CreatePSO(s_ParticleSpawnCS, g_pParticleSpawnCS);
+#ifdef _WAVE_OP
+    CreatePSO(s_ParticleUpdateCS, g_pParticleUpdateCS_SM6);
+#else
     CreatePSO(s_ParticleUpdateCS, g_pParticleUpdateCS);
+#endif
     CreatePSO(s_ParticleDispatchIndirectArgsCS, g_pParticleDispatchIndirectArgsCS);
     CreatePSO(s_ParticleFinalDispatchIndirectArgsCS, g_pParticleFinalDispatchIndirectArgsCS);
 
     CreatePSO(s_ParticleLargeBinCullingCS, g_pParticleLargeBinCullingCS);
     CreatePSO(s_ParticleBinCullingCS, g_pParticleBinCullingCS);
+#ifdef _WAVE_OP
+    CreatePSO(s_ParticleTileCullingCS, g_pParticleTileCullingCS_SM6);
+#else
     CreatePSO(s_ParticleTileCullingCS, g_pParticleTileCullingCS);
-    if (g_bTypedUAVLoadSupport_R11G11B10_FLOAT)
-    {
-        CreatePSO(s_ParticleTileRenderSlowCS[0], g_pParticleTileRender2CS);
-        CreatePSO(s_ParticleTileRenderFastCS[0], g_pParticleTileRenderFast2CS);
-        CreatePSO(s_ParticleTileRenderSlowCS[1], g_pParticleTileRenderSlowLowRes2CS);
-        CreatePSO(s_ParticleTileRenderFastCS[1], g_pParticleTileRenderFastLowRes2CS);
-        CreatePSO(s_ParticleTileRenderSlowCS[2], g_pParticleTileRenderSlowDynamic2CS);
-        CreatePSO(s_ParticleTileRenderFastCS[2], g_pParticleTileRenderFastDynamic2CS);
-    }
-    else
-    {
-        CreatePSO(s_ParticleTileRenderSlowCS[0], g_pParticleTileRenderCS);
-        CreatePSO(s_ParticleTileRenderFastCS[0], g_pParticleTileRenderFastCS);
-        CreatePSO(s_ParticleTileRenderSlowCS[1], g_pParticleTileRenderSlowLowResCS);
-        CreatePSO(s_ParticleTileRenderFastCS[1], g_pParticleTileRenderFastLowResCS);
-        CreatePSO(s_ParticleTileRenderSlowCS[2], g_pParticleTileRenderSlowDynamicCS);
-        CreatePSO(s_ParticleTileRenderFastCS[2], g_pParticleTileRenderFastDynamicCS);
-    }
+#endif
+    // Typed UAV load support is fixed for the device, so only compile the permutations that can be used
+    s_ParticleTileRenderCS.Create(RootSig, g_pParticleTileRenderCS_Permutations, PERMUTATION_TYPED_UAV_LOADS,
+        g_bTypedUAVLoadSupport_R11G11B10_FLOAT ? PERMUTATION_TYPED_UAV_LOADS : 0);
     CreatePSO(s_ParticleDepthBoundsCS, g_pParticleDepthBoundsCS);
     CreatePSO(s_ParticleSortIndirectArgsCS, g_pParticleSortIndirectArgsCS);
     CreatePSO(s_ParticlePreSortCS, g_pParticlePreSortCS);
@@ -488,6 +552,12 @@ void ParticleEffects::Initialize( uint32_t MaxDisplayWidth, uint32_t MaxDisplayH
     SpriteIndexBuffer.Create(L"ParticleEffects::SpriteIndexBuffer", MAX_TOTAL_PARTICLES, sizeof(UINT));    
     SortIndirectArgs.Create(L"ParticleEffects::SortIndirectArgs", 1, sizeof(D3D12_DISPATCH_ARGUMENTS));
     TileDrawDispatchIndirectArgs.Create(L"ParticleEffects::DrawPackets_IArgs", 2, sizeof(D3D12_DISPATCH_ARGUMENTS), InitialDispatchIndirectArgs);
+    UpdateDispatchArgs.Create(L"ParticleEffects::UpdateDispatchArgs", 1, sizeof(D3D12_DISPATCH_ARGUMENTS), InitialDispatchIndirectArgs);
+    UpdateGroupOffsets.Create(L"ParticleEffects::UpdateGroupOffsets", MAX_EFFECTS_PER_BATCH, sizeof(UINT));
+    ParticleStatePool.Create(L"ParticleEffects::ParticleStatePool", 2 * MAX_TOTAL_PARTICLES, sizeof(ParticleMotion));
+    SpawnDataPool.Create(L"ParticleEffects::SpawnDataPool", MAX_TOTAL_PARTICLES, sizeof(ParticleSpawnData));
+    EffectPropertyPool.Create(L"ParticleEffects::EffectPropertyPool", MAX_EFFECTS, sizeof(EffectPropertyBlock));
+    EffectCounters.Create(L"ParticleEffects::EffectCounters", 2 * MAX_EFFECTS, sizeof(UINT));
 
     const uint32_t LargeBinsPerRow = DivideByMultiple(MaxDisplayWidth, 4 * BIN_SIZE_X);
     const uint32_t LargeBinsPerCol = DivideByMultiple(MaxDisplayHeight, 4 * BIN_SIZE_Y);
@@ -506,6 +576,7 @@ void ParticleEffects::Initialize( uint32_t MaxDisplayWidth, uint32_t MaxDisplayH
     BinParticles[1].Create(L"ParticleEffects::BinParticles[1]", ParticleBinCapacity, sizeof(UINT));
     BinCounters[0].Create(L"ParticleEffects::LargeBinCounters", LargeBinsPerRow * LargeBinsPerCol, sizeof(UINT));
     BinCounters[1].Create(L"ParticleEffects::BinCounters", BinsPerRow * BinsPerCol, sizeof(UINT));
+    LargeBinMaxDepth.Create(L"ParticleEffects::LargeBinMaxDepth", LargeBinsPerRow * LargeBinsPerCol, sizeof(UINT));
     TileCounters.Create(L"ParticleEffects::TileCounters", PaddedTilesPerRow * PaddedTilesPerCol, sizeof(UINT));
     TileHitMasks.Create(L"ParticleEffects::TileHitMasks", PaddedTilesPerRow * PaddedTilesPerCol, MAX_PARTICLES_PER_BIN / 8);
     TileDrawPackets.Create(L"ParticleEffects::DrawPackets", TilesPerRow * TilesPerCol, sizeof(UINT));
@@ -532,6 +603,7 @@ void ParticleEffects::Initialize( uint32_t MaxDisplayWidth, uint32_t MaxDisplayH
     ASSERT_SUCCEEDED( g_Device->CreateCommittedResource( &HeapProps, D3D12_HEAP_FLAG_NONE,
         &TexDesc, D3D12_RESOURCE_STATE_COPY_DEST, nullptr, MY_IID_PPV_ARGS(&tex)) );
     tex->SetName(L"Particle TexArray");
+    GpuMemory::Track(tex, GpuMemory::kParticles);
     TextureArray = GpuResource(tex, D3D12_RESOURCE_STATE_COPY_DEST);
     tex->Release();
 
@@ -564,11 +636,18 @@ void ParticleEffects::Shutdown( void )
     SpriteIndexBuffer.Destroy();
     SortIndirectArgs.Destroy();
     TileDrawDispatchIndirectArgs.Destroy();
+    UpdateDispatchArgs.Destroy();
+    UpdateGroupOffsets.Destroy();
+    ParticleStatePool.Destroy();
+    SpawnDataPool.Destroy();
+    EffectPropertyPool.Destroy();
+    EffectCounters.Destroy();
 
     BinParticles[0].Destroy();
     BinParticles[1].Destroy();
     BinCounters[0].Destroy();
     BinCounters[1].Destroy();
+    LargeBinMaxDepth.Destroy();
     TileCounters.Destroy();
     TileHitMasks.Destroy();
     TileDrawPackets.Destroy();
@@ -582,14 +661,18 @@ EffectHandle ParticleEffects::PreLoadEffectResources( ParticleEffectProperties&
     if (!s_InitComplete)
         return EFFECTS_ERROR;
 
+    uint32_t ParticleOffset = AllocateParticles(effectProperties.EmitProperties.MaxParticles);
+    if (ParticleOffset == EFFECTS_ERROR || ParticleEffectsPool.size() >= MAX_EFFECTS)
+        return EFFECTS_ERROR;
+
     static std::mutex s_TextureMutex;
     s_TextureMutex.lock();
     MaintainTextureList(effectProperties);
     ParticleEffectsPool.emplace_back(new ParticleEffect(effectProperties));
+    EffectHandle index = (EffectHandle)ParticleEffectsPool.size() - 1;
     s_TextureMutex.unlock();
 
-    EffectHandle index = (EffectHandle)ParticleEffectsPool.size() - 1;
-    ParticleEffectsPool[index]->LoadDeviceResources(Graphics::g_Device);
+    ParticleEffectsPool[index]->LoadDeviceResources(Graphics::g_Device, ParticleOffset, index);
     return index;
 }
 
@@ -621,16 +704,21 @@ EffectHandle ParticleEffects::InstantiateEffect( ParticleEffectProperties& effec
     if (!s_InitComplete)
         return EFFECTS_ERROR;
 
+    uint32_t ParticleOffset = AllocateParticles(effectProperties.EmitProperties.MaxParticles);
+    if (ParticleOffset == EFFECTS_ERROR || ParticleEffectsPool.size() >= MAX_EFFECTS)
+        return EFFECTS_ERROR;
+
     static std::mutex s_InstantiateNewEffectMutex;
     s_InstantiateNewEffectMutex.lock();
     MaintainTextureList(effectProperties);
     ParticleEffect* newEffect = new ParticleEffect(effectProperties);
     ParticleEffectsPool.emplace_back(newEffect);
+    uint32_t EffectSlot = (uint32_t)ParticleEffectsPool.size() - 1;
+    newEffect->LoadDeviceResources(Graphics::g_Device, ParticleOffset, EffectSlot);
     ParticleEffectsActive.push_back(newEffect);
+    EffectHandle index = (EffectHandle)ParticleEffectsActive.size() - 1;
     s_InstantiateNewEffectMutex.unlock();
 
-    EffectHandle index = (EffectHandle)ParticleEffectsActive.size() - 1;
-    ParticleEffectsActive[index]->LoadDeviceResources(Graphics::g_Device);
     return index;    
 }
 
@@ -640,47 +728,131 @@ EffectHandle ParticleEffects::InstantiateEffect( ParticleEffectProperties& effec
 //
 //---------------------------------------------------------------------
 
-void ParticleEffects::Update(ComputeContext& Context, float timeDelta )
+// Spawns and updates every active effect, and sizes the frame's culling and draws from the results
+static void SimulateEffects(ComputeContext& Context, float timeDelta)
 {
-    if (!Enable || !s_InitComplete || ParticleEffectsActive.size() == 0)
-        return;
-
     ScopedTimer _prof(L"Particle Update", Context);
 
-    if (++TotalElapsedFrames == s_ReproFrame)
-        PauseSim = true;
-
-    if (PauseSim)
-        return;
-
     Context.ResetCounter(SpriteVertexBuffer);
 
     if (ParticleEffectsActive.size() == 0)
         return;
 
     Context.SetRootSignature(RootSig);
-    Context.SetConstants(0, timeDelta);
     Context.TransitionResource(SpriteVertexBuffer, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+    Context.TransitionResource(ParticleStatePool, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+    Context.TransitionResource(EffectCounters, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+    Context.TransitionResource(SpawnDataPool, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+    Context.TransitionResource(EffectPropertyPool, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
     Context.SetDynamicDescriptor(3, 0, SpriteVertexBuffer.GetUAV());
+    Context.SetDynamicDescriptor(3, 2, ParticleStatePool.GetUAV());
+    Context.SetDynamicDescriptor(3, 3, EffectCounters.GetUAV());
+    Context.SetDynamicDescriptor(3, 4, SpriteVertexBuffer.GetCounterUAV(Context));
+    Context.SetDynamicDescriptor(4, 0, SpawnDataPool.GetSRV());
+    Context.SetDynamicDescriptor(4, 2, EffectPropertyPool.GetSRV());
+
+    // The effect table must fit in one constant buffer.  Only pooled effects can be active, so this only trips
+    // when an effect is instantiated more than once at a time.
+    ASSERT(ParticleEffectsActive.size() <= MAX_EFFECTS, "Too many active particle effects");
+    const uint32_t NumActive = std::min((uint32_t)ParticleEffectsActive.size(), (uint32_t)MAX_EFFECTS);
+
+    // Write the frame's effect table straight to upload memory.  The property blocks are already on the GPU,
+    // so each effect only contributes its counters and spawn range.
+    DynAlloc EffectTable = Context.ReserveUploadMemory(NumActive * sizeof(ParticleEffectEntry));
+    ParticleEffectEntry* Entries = (ParticleEffectEntry*)EffectTable.DataPtr;
+    uint32_t NumSpawnGroups = 0;
+    for (uint32_t i = 0; i < NumActive; ++i)
+    {
+        ParticleEffectEntry Entry;
+        ParticleEffectsActive[i]->Update(Entry, timeDelta);
+        Entry.FirstSpawnGroup = NumSpawnGroups;
+        NumSpawnGroups += DivideByMultiple(Entry.SpawnCount, 64);
+        Entries[i] = Entry;
+    }
 
-    for (UINT i = 0; i < ParticleEffectsActive.size(); ++i)
-    {    
-        ParticleEffectsActive[i]->Update(Context, timeDelta);
+    // Batches start on multiples of MAX_EFFECTS_PER_BATCH entries, which keeps their CBVs 256-byte aligned
+    for (uint32_t First = 0; First < NumActive; First += MAX_EFFECTS_PER_BATCH)
+    {
+        UpdateBatch(Context, EffectTable.GpuAddress + First * sizeof(ParticleEffectEntry),
+            std::min(NumActive - First, (uint32_t)MAX_EFFECTS_PER_BATCH), timeDelta);
+    }
 
-        if (ParticleEffectsActive[i]->GetLifetime() <= ParticleEffectsActive[i]->GetElapsedTime())
-        {
-            //Erase from vector
-            auto iter = ParticleEffectsActive.begin() + i;
-            static std::mutex s_EraseEffectMutex;
-            s_EraseEffectMutex.lock();
-            ParticleEffectsActive.erase(iter);
-            s_EraseEffectMutex.unlock();
-        }
+    // Every effect spawns in one dispatch after all of them have updated.  Living particles take precedence over
+    // new ones, so they have to be appended before spawning.
+    if (NumSpawnGroups > 0)
+    {
+        Context.InsertUAVBarrier(EffectCounters);
+
+        Context.SetPipelineState(s_ParticleSpawnCS);
+        Context.SetConstantBuffer(2, EffectTable.GpuAddress);
+        Context.SetConstants(0, timeDelta, NumActive, (uint32_t)s_RNG.NextInt());
+        Context.Dispatch(NumSpawnGroups, 1, 1);
     }
 
+    // Next frame's update reads the counts this one appended
+    Context.InsertUAVBarrier(EffectCounters);
+
+    static std::mutex s_EraseEffectMutex;
+    s_EraseEffectMutex.lock();
+    ParticleEffectsActive.erase(std::remove_if(ParticleEffectsActive.begin(), ParticleEffectsActive.end(),
+        [](ParticleEffect* effect) { return effect->GetLifetime() <= effect->GetElapsedTime(); }), ParticleEffectsActive.end());
+    s_EraseEffectMutex.unlock();
+
     SetFinalBuffers(Context);
 }
 
+// Makes the graphics queue wait for the async simulation.  Everything already recorded in Context is submitted
+// first so that it still overlaps the simulation.
+static void WaitForAsyncUpdate(CommandContext& Context)
+{
+    if (s_AsyncUpdateFence == 0)
+        return;
+
+    Context.Flush();
+    g_CommandManager.GetGraphicsQueue().StallForFence(s_AsyncUpdateFence);
+    s_AsyncUpdateFence = 0;
+}
+
+void ParticleEffects::Update(CommandContext& Context, float timeDelta )
+{
+    // Last frame's simulation is normally waited for by Render(), unless it was skipped
+    WaitForAsyncUpdate(Context);
+
+    if (!Enable || !s_InitComplete || ParticleEffectsActive.size() == 0)
+        return;
+
+    if (++TotalElapsedFrames == s_ReproFrame)
+        PauseSim = true;
+
+    if (PauseSim)
+        return;
+
+    if (!AsyncCompute)
+    {
+        SimulateEffects(Context.GetComputeContext(), timeDelta);
+        return;
+    }
+
+    // Rendering and effect creation leave the simulation buffers in graphics states, which compute command
+    // lists can't transition from.  Move them into the simulation's starting states here, then submit them so
+    // the compute queue waits for last frame's particle rendering but none of this frame's work.
+    Context.TransitionResource(SpriteVertexBuffer, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+    Context.TransitionResource(SpriteVertexBuffer.GetCounterBuffer(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+    Context.TransitionResource(ParticleStatePool, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+    Context.TransitionResource(EffectCounters, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+    Context.TransitionResource(SpawnDataPool, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+    Context.TransitionResource(EffectPropertyPool, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+    Context.TransitionResource(UpdateDispatchArgs, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+    Context.TransitionResource(UpdateGroupOffsets, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+    Context.TransitionResource(FinalDispatchIndirectArgs, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+    Context.TransitionResource(DrawIndirectArgs, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+    g_CommandManager.GetComputeQueue().StallForFence(Context.Flush());
+
+    ComputeContext& CompContext = ComputeContext::Begin(L"Async Particle Update", true);
+    SimulateEffects(CompContext, timeDelta);
+    s_AsyncUpdateFence = CompContext.Finish();
+}
+
 
 //---------------------------------------------------------------------
 //
@@ -690,6 +862,8 @@ void ParticleEffects::Update(ComputeContext& Context, float timeDelta )
 
 void ParticleEffects::Render( CommandContext& Context, const Camera& Camera, ColorBuffer& ColorTarget, DepthBuffer& DepthTarget, ColorBuffer& LinearDepth)
 {
+    WaitForAsyncUpdate(Context);
+
     if (!Enable || !s_InitComplete || ParticleEffectsActive.size() == 0)
         return;
 
@@ -736,10 +910,12 @@ void ParticleEffects::Render( CommandContext& Context, const Camera& Camera, Col
         ComputeContext& CompContext = Context.GetComputeContext();
         CompContext.TransitionResource(ColorTarget, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
         CompContext.TransitionResource(BinCounters[0], D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
-        CompContext.TransitionResource(BinCounters[1], D3D12_RESOURCE_STATE_UNORDERED_ACCESS, true);
+        CompContext.TransitionResource(BinCounters[1], D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+        CompContext.TransitionResource(LargeBinMaxDepth, D3D12_RESOURCE_STATE_UNORDERED_ACCESS, true);
 
         CompContext.ClearUAV(BinCounters[0]);
         CompContext.ClearUAV(BinCounters[1]);
+        CompContext.ClearUAV(LargeBinMaxDepth);
         CompContext.SetRootSignature(RootSig);
         CompContext.SetDynamicConstantBufferView(1, sizeof(CBChangesPerView), &s_ChangesPerView);
 
@@ -770,6 +946,7 @@ void ParticleEffects::ClearAll()
     ParticleEffectsActive.clear();
     ParticleEffectsPool.clear();
     TextureNameArray.clear();
+    s_AllocatedParticles = 0;
 }
 
 void ParticleEffects::ResetEffect(EffectHandle EffectID)
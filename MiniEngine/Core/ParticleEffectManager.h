@@ -33,13 +33,15 @@ namespace ParticleEffects
     EffectHandle PreLoadEffectResources( ParticleEffectProperties& effectProperties );
     EffectHandle InstantiateEffect( EffectHandle effectHandle );
     EffectHandle InstantiateEffect( ParticleEffectProperties& effectProperties );
-    void Update(ComputeContext& Context, float timeDelta );
+    // Simulates on the async compute queue when AsyncCompute is set.  Render() waits for it.
+    void Update(CommandContext& Context, float timeDelta );
     void Render(CommandContext& Context, const Camera& Camera, ColorBuffer& ColorTarget, DepthBuffer& DepthTarget, ColorBuffer& LinearDepth);
     void ResetEffect(EffectHandle EffectID);
     float GetCurrentLife(EffectHandle EffectID);
 
     extern BoolVar Enable;
     extern BoolVar PauseSim;
+    extern BoolVar AsyncCompute;
     extern BoolVar EnableTiledRendering;
     extern bool Reproducible; //If you want to repro set to true. When true, effect uses the same set of random numbers each run
     extern UINT ReproFrame;
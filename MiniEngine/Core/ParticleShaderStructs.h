@@ -33,11 +33,38 @@ __declspec(align(16)) struct EmissionProperties
     UINT TextureID;
     XMFLOAT3 EmissiveColor;
     float pad1;    
-    XMUINT4 RandIndex[64];
 };
 
 EmissionProperties* CreateEmissionProperties();
 
+// The parts of an effect that do not change from frame to frame.  One block per effect slot is uploaded to a
+// persistent buffer when the effect is loaded.  The effect owns MaxParticles spawn records at ParticleOffset and
+// 2 * MaxParticles states at 2 * ParticleOffset (one half per side of the ping-pong).
+__declspec(align(16)) struct EffectPropertyBlock
+{
+    EmissionProperties EmitProperties;
+    UINT ParticleOffset;
+    UINT pad[3];
+};
+
+// All active effects are simulated by batched dispatches and spawned by one dispatch, which read this per-frame
+// table.  EffectSlot picks the effect's property block and CounterIndex selects the live count of the side being
+// read.
+__declspec(align(16)) struct ParticleEffectEntry
+{
+    UINT EffectSlot;
+    UINT CounterIndex;
+    UINT SpawnCount;
+    UINT FirstSpawnGroup;
+};
+
+// Effects that can be loaded at once (each has two live counters).  Also the size of the effect table in
+// ParticleUpdateCommon.hlsli, which fills 64 KB of constants.
+#define MAX_EFFECTS 4096
+
+// Effects sized by one update dispatch.  Matches ParticleUpdateCommon.hlsli.
+#define MAX_EFFECTS_PER_BATCH 512
+
 struct ParticleSpawnData
 {
     float AgeRate;
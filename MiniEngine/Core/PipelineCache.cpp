@@ -0,0 +1,374 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Developed by Minigraph
+//
+
+#include "PipelineCache.h"
+#include <dxgi1_4.h>
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <cwchar>
+
+#pragma comment(lib, "d3d12.lib")
+#pragma comment(lib, "dxgi.lib")
+
+using Microsoft::WRL::ComPtr;
+using namespace std;
+
+namespace
+{
+    const uint32_t kFileMagic = 0x4D505343;     // "CSPM"
+    const uint32_t kFileVersion = 1;
+    const uint64_t kFnvPrime = 1099511628211ull;
+
+    uint64_t HashString( const char* String, uint64_t Hash )
+    {
+        return String == nullptr ? Hash : PipelineCache::HashBytes(String, strlen(String) + 1, Hash);
+    }
+
+    uint64_t HashShaderBytecode( const D3D12_SHADER_BYTECODE& Bytecode, uint64_t Hash )
+    {
+        Hash = PipelineCache::HashBytes(&Bytecode.BytecodeLength, sizeof(Bytecode.BytecodeLength), Hash);
+        return Bytecode.pShaderBytecode == nullptr ? Hash : PipelineCache::HashBytes(Bytecode.pShaderBytecode, Bytecode.BytecodeLength, Hash);
+    }
+
+    // Identifies the adapter and driver.  Drivers that don't report a user mode driver version through
+    // CheckInterfaceSupport() leave it at zero and rely on the pipeline library's own validation.
+    bool GetAdapterIdentity( ID3D12Device* Device, uint32_t& VendorId, uint32_t& DeviceId, uint32_t& SubSysId,
+        uint32_t& Revision, uint64_t& DriverVersion )
+    {
+        ComPtr<IDXGIFactory4> Factory;
+        ComPtr<IDXGIAdapter1> Adapter;
+        if (FAILED(CreateDXGIFactory1(IID_PPV_ARGS(&Factory))) ||
+            FAILED(Factory->EnumAdapterByLuid(Device->GetAdapterLuid(), IID_PPV_ARGS(&Adapter))))
+            return false;
+
+        DXGI_ADAPTER_DESC1 Desc;
+        if (FAILED(Adapter->GetDesc1(&Desc)))
+            return false;
+
+        LARGE_INTEGER UmdVersion = {};
+        if (FAILED(Adapter->CheckInterfaceSupport(__uuidof(IDXGIDevice), &UmdVersion)))
+            UmdVersion.QuadPart = 0;
+
+        VendorId = Desc.VendorId;
+        DeviceId = Desc.DeviceId;
+        SubSysId = Desc.SubSysId;
+        Revision = Desc.Revision;
+        DriverVersion = (uint64_t)UmdVersion.QuadPart;
+        return true;
+    }
+}
+
+PipelineCache::PipelineCache() : m_File(INVALID_HANDLE_VALUE), m_Mapping(nullptr), m_MappedData(nullptr),
+    m_MappedSize(0), m_Index(nullptr), m_IndexCount(0), m_Opened(false), m_Dirty(false)
+{
+    memset(&m_Header, 0, sizeof(m_Header));
+}
+
+PipelineCache::~PipelineCache()
+{
+    m_Library = nullptr;
+    Unmap();
+}
+
+bool PipelineCache::Open( ID3D12Device* Device, const wchar_t* FileName )
+{
+    lock_guard<mutex> CS(m_Mutex);
+
+    if (m_Opened)
+        return m_Library != nullptr;
+
+    m_Opened = true;
+    m_FileName = FileName;
+
+    // Pipeline libraries require ID3D12Device1 and a WDDM 2.1 driver
+    ComPtr<ID3D12Device1> Device1;
+    if (FAILED(Device->QueryInterface(IID_PPV_ARGS(&Device1))))
+        return false;
+
+    memset(&m_Header, 0, sizeof(m_Header));
+    m_Header.Magic = kFileMagic;
+    m_Header.Version = kFileVersion;
+    GetAdapterIdentity(Device, m_Header.VendorId, m_Header.DeviceId, m_Header.SubSysId, m_Header.Revision, m_Header.DriverVersion);
+
+    const void* LibraryData = nullptr;
+    size_t LibrarySize = 0;
+
+    if (MapFile())
+    {
+        // Everything up to the index must match this adapter and driver
+        const FileHeader* Header = (const FileHeader*)m_MappedData;
+        const size_t FixedSize = offsetof(FileHeader, IndexCount);
+
+        if (m_MappedSize >= sizeof(FileHeader) && memcmp(Header, &m_Header, FixedSize) == 0 &&
+            Header->IndexCount <= (m_MappedSize - sizeof(FileHeader)) / sizeof(IndexEntry) &&
+            Header->LibrarySize == m_MappedSize - sizeof(FileHeader) - Header->IndexCount * sizeof(IndexEntry))
+        {
+            m_Index = (const IndexEntry*)(Header + 1);
+            m_IndexCount = (size_t)Header->IndexCount;
+            LibraryData = m_Index + m_IndexCount;
+            LibrarySize = (size_t)Header->LibrarySize;
+        }
+        else
+        {
+            Unmap();
+        }
+    }
+
+    HRESULT hr = Device1->CreatePipelineLibrary(LibraryData, LibrarySize, IID_PPV_ARGS(&m_Library));
+
+    // The driver can still reject the library, e.g. when it is corrupt.  Start over with an empty one.
+    if (FAILED(hr) && hr != DXGI_ERROR_UNSUPPORTED && LibraryData != nullptr)
+    {
+        Unmap();
+        hr = Device1->CreatePipelineLibrary(nullptr, 0, IID_PPV_ARGS(&m_Library));
+    }
+
+    // The driver doesn't support pipeline libraries
+    if (FAILED(hr))
+    {
+        Unmap();
+        m_Library = nullptr;
+        return false;
+    }
+
+    m_Library->SetName(L"Pipeline Cache Library");
+    return true;
+}
+
+bool PipelineCache::Close( void )
+{
+    lock_guard<mutex> CS(m_Mutex);
+
+    bool Written = true;
+
+    if (m_Library != nullptr && m_Dirty)
+    {
+        Written = false;
+
+        // Serialize to memory first.  The library references the mapped file, which we are about to overwrite.
+        vector<uint8_t> Blob(m_Library->GetSerializedSize());
+        if (!Blob.empty() && SUCCEEDED(m_Library->Serialize(Blob.data(), Blob.size())))
+        {
+            vector<IndexEntry> Index(m_Index, m_Index + m_IndexCount);
+            Index.insert(Index.end(), m_NewEntries.begin(), m_NewEntries.end());
+            sort(Index.begin(), Index.end());
+            Index.erase(unique(Index.begin(), Index.end()), Index.end());
+
+            m_Library = nullptr;
+            Unmap();
+
+            FileHeader Header = m_Header;
+            Header.IndexCount = Index.size();
+            Header.LibrarySize = Blob.size();
+
+            HANDLE File = CreateFile2(m_FileName.c_str(), GENERIC_WRITE, 0, CREATE_ALWAYS, nullptr);
+            if (File != INVALID_HANDLE_VALUE)
+            {
+                const DWORD IndexSize = (DWORD)(Index.size() * sizeof(IndexEntry));
+                DWORD BytesWritten = 0;
+                Written = WriteFile(File, &Header, sizeof(Header), &BytesWritten, nullptr) && BytesWritten == sizeof(Header);
+                Written = Written && (IndexSize == 0 || (WriteFile(File, Index.data(), IndexSize, &BytesWritten, nullptr) && BytesWritten == IndexSize));
+                Written = Written && WriteFile(File, Blob.data(), (DWORD)Blob.size(), &BytesWritten, nullptr) && BytesWritten == Blob.size();
+                CloseHandle(File);
+
+                // A truncated file would fail the size check anyway, but don't leave it around
+                if (!Written)
+                    DeleteFile(m_FileName.c_str());
+            }
+        }
+    }
+
+    m_Library = nullptr;
+    Unmap();
+    m_NewEntries.clear();
+    m_Opened = false;
+    m_Dirty = false;
+
+    return Written;
+}
+
+void PipelineCache::GetPipelineName( uint64_t Key, PipelineType Type, wchar_t (&Name)[kNameLength] )
+{
+    static const wchar_t* kTypePrefix[] = { L"GFX", L"CS", L"STM" };
+    swprintf_s(Name, L"%s%016llX", kTypePrefix[Type], (unsigned long long)Key);
+}
+
+bool PipelineCache::FindPipeline( uint64_t Key, PipelineType Type, wchar_t (&Name)[kNameLength] )
+{
+    if (m_Library == nullptr)
+        return false;
+
+    const IndexEntry Entry = { Key, Type, 0 };
+
+    // The mapped index doesn't change while the cache is open
+    if (!binary_search(m_Index, m_Index + m_IndexCount, Entry))
+    {
+        lock_guard<mutex> CS(m_Mutex);
+        if (find(m_NewEntries.begin(), m_NewEntries.end(), Entry) == m_NewEntries.end())
+            return false;
+    }
+
+    GetPipelineName(Key, Type, Name);
+    return true;
+}
+
+bool PipelineCache::LoadGraphicsPipeline( uint64_t Key, const D3D12_GRAPHICS_PIPELINE_STATE_DESC& Desc, ID3D12PipelineState** PSO )
+{
+    wchar_t Name[kNameLength];
+    if (!FindPipeline(Key, kGraphics, Name))
+        return false;
+
+    return SUCCEEDED(m_Library->LoadGraphicsPipeline(Name, &Desc, IID_PPV_ARGS(PSO)));
+}
+
+bool PipelineCache::LoadComputePipeline( uint64_t Key, const D3D12_COMPUTE_PIPELINE_STATE_DESC& Desc, ID3D12PipelineState** PSO )
+{
+    wchar_t Name[kNameLength];
+    if (!FindPipeline(Key, kCompute, Name))
+        return false;
+
+    return SUCCEEDED(m_Library->LoadComputePipeline(Name, &Desc, IID_PPV_ARGS(PSO)));
+}
+
+// Stream descriptions can only be loaded through ID3D12PipelineLibrary1
+bool PipelineCache::LoadStreamPipeline( uint64_t Key, const D3D12_PIPELINE_STATE_STREAM_DESC& Desc, ID3D12PipelineState** PSO )
+{
+    wchar_t Name[kNameLength];
+    ComPtr<ID3D12PipelineLibrary1> Library1;
+    if (!FindPipeline(Key, kStream, Name) || FAILED(m_Library.As(&Library1)))
+        return false;
+
+    return SUCCEEDED(Library1->LoadPipeline(Name, &Desc, IID_PPV_ARGS(PSO)));
+}
+
+void PipelineCache::StorePipeline( uint64_t Key, PipelineType Type, ID3D12PipelineState* PSO )
+{
+    if (m_Library == nullptr)
+        return;
+
+    wchar_t Name[kNameLength];
+    GetPipelineName(Key, Type, Name);
+
+    // E_INVALIDARG means the name already exists with a different description.  That would only happen
+    // with a hash collision and is harmless, because the PSO was compiled anyway.
+    if (FAILED(m_Library->StorePipeline(Name, PSO)))
+        return;
+
+    lock_guard<mutex> CS(m_Mutex);
+    const IndexEntry Entry = { Key, Type, 0 };
+    m_NewEntries.push_back(Entry);
+    m_Dirty = true;
+}
+
+uint64_t PipelineCache::HashBytes( const void* Data, size_t Size, uint64_t Hash )
+{
+    // FNV-1a
+    const uint8_t* Bytes = (const uint8_t*)Data;
+    for (size_t i = 0; i < Size; ++i)
+        Hash = (Hash ^ Bytes[i]) * kFnvPrime;
+    return Hash;
+}
+
+uint64_t PipelineCache::HashGraphicsDesc( const D3D12_GRAPHICS_PIPELINE_STATE_DESC& Desc, uint64_t RootSignatureHash )
+{
+    // Clear the pointers and hash what they refer to instead
+    D3D12_GRAPHICS_PIPELINE_STATE_DESC KeyDesc = Desc;
+    KeyDesc.pRootSignature = nullptr;
+    KeyDesc.VS = KeyDesc.PS = KeyDesc.DS = KeyDesc.HS = KeyDesc.GS = D3D12_SHADER_BYTECODE{};
+    KeyDesc.StreamOutput.pSODeclaration = nullptr;
+    KeyDesc.StreamOutput.pBufferStrides = nullptr;
+    KeyDesc.InputLayout.pInputElementDescs = nullptr;
+    KeyDesc.CachedPSO = D3D12_CACHED_PIPELINE_STATE{};
+
+    uint64_t Hash = HashBytes(&KeyDesc, sizeof(KeyDesc));
+    Hash = HashBytes(&RootSignatureHash, sizeof(RootSignatureHash), Hash);
+    Hash = HashShaderBytecode(Desc.VS, Hash);
+    Hash = HashShaderBytecode(Desc.PS, Hash);
+    Hash = HashShaderBytecode(Desc.DS, Hash);
+    Hash = HashShaderBytecode(Desc.HS, Hash);
+    Hash = HashShaderBytecode(Desc.GS, Hash);
+
+    for (UINT i = 0; i < Desc.InputLayout.NumElements; ++i)
+    {
+        D3D12_INPUT_ELEMENT_DESC Element = Desc.InputLayout.pInputElementDescs[i];
+        Hash = HashString(Element.SemanticName, Hash);
+        Element.SemanticName = nullptr;
+        Hash = HashBytes(&Element, sizeof(Element), Hash);
+    }
+
+    for (UINT i = 0; i < Desc.StreamOutput.NumEntries; ++i)
+    {
+        D3D12_SO_DECLARATION_ENTRY Entry = Desc.StreamOutput.pSODeclaration[i];
+        Hash = HashString(Entry.SemanticName, Hash);
+        Entry.SemanticName = nullptr;
+        Hash = HashBytes(&Entry, sizeof(Entry), Hash);
+    }
+
+    if (Desc.StreamOutput.pBufferStrides != nullptr)
+        Hash = HashBytes(Desc.StreamOutput.pBufferStrides, Desc.StreamOutput.NumStrides * sizeof(UINT), Hash);
+
+    return Hash;
+}
+
+uint64_t PipelineCache::HashComputeDesc( const D3D12_COMPUTE_PIPELINE_STATE_DESC& Desc, uint64_t RootSignatureHash )
+{
+    D3D12_COMPUTE_PIPELINE_STATE_DESC KeyDesc = Desc;
+    KeyDesc.pRootSignature = nullptr;
+    KeyDesc.CS = D3D12_SHADER_BYTECODE{};
+    KeyDesc.CachedPSO = D3D12_CACHED_PIPELINE_STATE{};
+
+    uint64_t Hash = HashBytes(&KeyDesc, sizeof(KeyDesc));
+    Hash = HashBytes(&RootSignatureHash, sizeof(RootSignatureHash), Hash);
+    return HashShaderBytecode(Desc.CS, Hash);
+}
+
+bool PipelineCache::MapFile( void )
+{
+    m_File = CreateFile2(m_FileName.c_str(), GENERIC_READ, FILE_SHARE_READ, OPEN_EXISTING, nullptr);
+    if (m_File == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER FileSize = {};
+    if (GetFileSizeEx(m_File, &FileSize) && FileSize.HighPart == 0 && FileSize.LowPart > 0)
+    {
+        m_Mapping = CreateFileMapping(m_File, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (m_Mapping != nullptr)
+        {
+            m_MappedData = MapViewOfFile(m_Mapping, FILE_MAP_READ, 0, 0, 0);
+            if (m_MappedData != nullptr)
+            {
+                m_MappedSize = FileSize.LowPart;
+                return true;
+            }
+        }
+    }
+
+    Unmap();
+    return false;
+}
+
+void PipelineCache::Unmap( void )
+{
+    if (m_MappedData != nullptr)
+        UnmapViewOfFile(m_MappedData);
+    if (m_Mapping != nullptr)
+        CloseHandle(m_Mapping);
+    if (m_File != INVALID_HANDLE_VALUE)
+        CloseHandle(m_File);
+
+    m_MappedData = nullptr;
+    m_MappedSize = 0;
+    m_Mapping = nullptr;
+    m_File = INVALID_HANDLE_VALUE;
+    m_Index = nullptr;
+    m_IndexCount = 0;
+}
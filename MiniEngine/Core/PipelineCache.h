@@ -0,0 +1,114 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Developed by Minigraph
+//
+
+#pragma once
+
+#include <windows.h>
+#include <d3d12.h>
+#include <wrl/client.h>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// A persistent cache of compiled pipeline state objects.  It depends on nothing but Direct3D 12, DXGI and
+// the standard library, so any D3D12 project can compile it in (it doesn't use MiniEngine's precompiled
+// header).
+//
+// PSOs are keyed by a content hash of their full description: shader bytecode, input layouts and stream
+// output declarations are hashed by what they contain rather than by address, so keys are stable across
+// launches.  The cache file holds
+//   - a header naming the adapter and user mode driver that wrote it.  A file written on any other adapter
+//     or driver is discarded without being handed to the driver.
+//   - a sorted index of the stored keys, so that misses never go through the pipeline library.
+//   - the serialized ID3D12PipelineLibrary holding the PSOs.
+// The file stays memory-mapped while the cache is open because the library references it.
+class PipelineCache
+{
+public:
+    enum PipelineType : uint32_t
+    {
+        kGraphics,
+        kCompute,
+        kStream         // Created from a pipeline state stream
+    };
+
+    static const uint64_t kHashSeed = 14695981039346656037ull;
+
+    PipelineCache();
+    ~PipelineCache();
+
+    // Map the cache file for this device.  Only the first call opens it; later ones return its result.
+    // Returns false when the device or driver doesn't support pipeline libraries.
+    bool Open( ID3D12Device* Device, const wchar_t* FileName );
+
+    // Write PSOs stored since Open() back to the file and release the library.  Returns false if the file
+    // could not be written.
+    bool Close( void );
+
+    // The library synchronizes internally.  The only requirement is that two threads don't load the same
+    // pipeline at once.
+    bool LoadGraphicsPipeline( uint64_t Key, const D3D12_GRAPHICS_PIPELINE_STATE_DESC& Desc, ID3D12PipelineState** PSO );
+    bool LoadComputePipeline( uint64_t Key, const D3D12_COMPUTE_PIPELINE_STATE_DESC& Desc, ID3D12PipelineState** PSO );
+    bool LoadStreamPipeline( uint64_t Key, const D3D12_PIPELINE_STATE_STREAM_DESC& Desc, ID3D12PipelineState** PSO );
+    void StorePipeline( uint64_t Key, PipelineType Type, ID3D12PipelineState* PSO );
+
+    // Content hashes.  Root signatures are only referenced by the descriptions, so pass a stable hash of
+    // the root signature, such as a hash of its serialized blob.
+    static uint64_t HashBytes( const void* Data, size_t Size, uint64_t Hash = kHashSeed );
+    static uint64_t HashGraphicsDesc( const D3D12_GRAPHICS_PIPELINE_STATE_DESC& Desc, uint64_t RootSignatureHash );
+    static uint64_t HashComputeDesc( const D3D12_COMPUTE_PIPELINE_STATE_DESC& Desc, uint64_t RootSignatureHash );
+
+private:
+    struct FileHeader
+    {
+        uint32_t Magic;
+        uint32_t Version;
+        uint32_t VendorId;
+        uint32_t DeviceId;
+        uint32_t SubSysId;
+        uint32_t Revision;
+        uint64_t DriverVersion;
+        uint64_t IndexCount;
+        uint64_t LibrarySize;
+    };
+
+    struct IndexEntry
+    {
+        uint64_t Key;
+        uint32_t Type;
+        uint32_t Reserved;
+
+        bool operator<( const IndexEntry& Rhs ) const { return Key < Rhs.Key || (Key == Rhs.Key && Type < Rhs.Type); }
+        bool operator==( const IndexEntry& Rhs ) const { return Key == Rhs.Key && Type == Rhs.Type; }
+    };
+
+    static const uint32_t kNameLength = 24;
+
+    static void GetPipelineName( uint64_t Key, PipelineType Type, wchar_t (&Name)[kNameLength] );
+    bool FindPipeline( uint64_t Key, PipelineType Type, wchar_t (&Name)[kNameLength] );
+    bool MapFile( void );
+    void Unmap( void );
+
+    Microsoft::WRL::ComPtr<ID3D12PipelineLibrary> m_Library;
+    std::wstring m_FileName;
+    FileHeader m_Header;
+    HANDLE m_File;
+    HANDLE m_Mapping;
+    void* m_MappedData;
+    size_t m_MappedSize;
+    const IndexEntry* m_Index;              // Points into the mapped file
+    size_t m_IndexCount;
+    std::vector<IndexEntry> m_NewEntries;   // Stored since Open()
+    bool m_Opened;
+    bool m_Dirty;
+    std::mutex m_Mutex;
+};
@@ -14,10 +14,12 @@
 #include "GraphicsCore.h"
 #include "PipelineState.h"
 #include "RootSignature.h"
+#include "PipelineCache.h"
 #include "Hash.h"
 #include <map>
 #include <thread>
 #include <mutex>
+#include <atomic>
 
 using Math::IsAligned;
 using namespace Graphics;
@@ -27,12 +29,122 @@ using namespace std;
 static map< size_t, ComPtr<ID3D12PipelineState> > s_GraphicsPSOHashMap;
 static map< size_t, ComPtr<ID3D12PipelineState> > s_ComputePSOHashMap;
 
+namespace
+{
+    // Compiled PSOs are stored in a PipelineCache that is written to disk at shutdown and memory-mapped on
+    // the next launch, letting previously seen PSOs skip driver compilation.
+    const wchar_t* kPipelineCacheFileName = L"PipelineLibrary.bin";
+
+    PipelineCache s_PipelineCache;
+}
+
+// The in-memory hash covers pointers to shader bytecode and root signatures, which change from run to run.
+// The persistent key hashes what those pointers refer to instead.
+static ID3D12PipelineState* CompileGraphicsPipeline( const D3D12_GRAPHICS_PIPELINE_STATE_DESC& Desc, size_t RootSignatureHash,
+    bool DepthBoundsTest )
+{
+    s_PipelineCache.Open(g_Device, kPipelineCacheFileName);
+
+    uint64_t PersistentKey = PipelineCache::HashGraphicsDesc(Desc, RootSignatureHash);
+
+    ID3D12PipelineState* PSO = nullptr;
+
+    // The depth bounds test is only part of the DEPTH_STENCIL1 subobject of a pipeline state stream
+    if (DepthBoundsTest)
+    {
+        const uint32_t DepthBoundsTestKey = 1;
+        PersistentKey = PipelineCache::HashBytes(&DepthBoundsTestKey, sizeof(DepthBoundsTestKey), PersistentKey);
+
+        CD3DX12_DEPTH_STENCIL_DESC1 DepthStencilDesc(Desc.DepthStencilState);
+        DepthStencilDesc.DepthBoundsTestEnable = TRUE;
+
+        CD3DX12_PIPELINE_STATE_STREAM1 Stream(Desc);
+        Stream.DepthStencilState = DepthStencilDesc;
+        const D3D12_PIPELINE_STATE_STREAM_DESC StreamDesc = { sizeof(Stream), &Stream };
+
+        if (!s_PipelineCache.LoadStreamPipeline(PersistentKey, StreamDesc, &PSO))
+        {
+            ComPtr<ID3D12Device2> Device2;
+            ASSERT_SUCCEEDED( g_Device->QueryInterface(MY_IID_PPV_ARGS(&Device2)) );
+            ASSERT_SUCCEEDED( Device2->CreatePipelineState(&StreamDesc, MY_IID_PPV_ARGS(&PSO)) );
+            s_PipelineCache.StorePipeline(PersistentKey, PipelineCache::kStream, PSO);
+        }
+        return PSO;
+    }
+
+    if (!s_PipelineCache.LoadGraphicsPipeline(PersistentKey, Desc, &PSO))
+    {
+        ASSERT_SUCCEEDED( g_Device->CreateGraphicsPipelineState(&Desc, MY_IID_PPV_ARGS(&PSO)) );
+        s_PipelineCache.StorePipeline(PersistentKey, PipelineCache::kGraphics, PSO);
+    }
+    return PSO;
+}
+
+static ID3D12PipelineState* CompileComputePipeline( const D3D12_COMPUTE_PIPELINE_STATE_DESC& Desc, size_t RootSignatureHash )
+{
+    s_PipelineCache.Open(g_Device, kPipelineCacheFileName);
+
+    const uint64_t PersistentKey = PipelineCache::HashComputeDesc(Desc, RootSignatureHash);
+
+    ID3D12PipelineState* PSO = nullptr;
+    if (!s_PipelineCache.LoadComputePipeline(PersistentKey, Desc, &PSO))
+    {
+        ASSERT_SUCCEEDED( g_Device->CreateComputePipelineState(&Desc, MY_IID_PPV_ARGS(&PSO)) );
+        s_PipelineCache.StorePipeline(PersistentKey, PipelineCache::kCompute, PSO);
+    }
+    return PSO;
+}
+
+// Hash map slots are reserved (null) until the compiling thread publishes its PSO, which the map then owns.
+// Other threads poll the slot, so publish with a full barrier.
+static void PublishPipeline( ID3D12PipelineState** PSORef, ID3D12PipelineState* PSO )
+{
+    InterlockedExchangePointer((void**)PSORef, PSO);
+}
+
+static atomic<uint32_t> s_NumPendingCompiles(0);
+
 void PSO::DestroyAll(void)
 {
+    // Async compiles write into the hash maps, so let them drain first
+    while (s_NumPendingCompiles > 0)
+        this_thread::yield();
+
+    if (!s_PipelineCache.Close())
+        Utility::Print("Failed to write pipeline cache\n");
     s_GraphicsPSOHashMap.clear();
     s_ComputePSOHashMap.clear();
 }
 
+void PSO::SaveCache( void )
+{
+    while (s_NumPendingCompiles > 0)
+        this_thread::yield();
+
+    if (!s_PipelineCache.Close())
+        Utility::Print("Failed to write pipeline cache\n");
+}
+
+void PSO::WaitForCompletion( void ) const
+{
+    while (GetPipelineStateObject() == nullptr)
+        this_thread::yield();
+}
+
+ID3D12PipelineState* PSO::GetFallbackPipelineStateObject( void ) const
+{
+    if (m_FallbackPSO != nullptr)
+    {
+        ID3D12PipelineState* Fallback = m_FallbackPSO->GetPipelineStateObject();
+        ASSERT(Fallback != nullptr, "Fallback PSOs must be finalized synchronously");
+        return Fallback;
+    }
+
+    // Without a fallback there is nothing to draw with, so block until the compile finishes
+    WaitForCompletion();
+    return GetPipelineStateObject();
+}
+
 
 GraphicsPSO::GraphicsPSO()
 {
@@ -41,6 +153,7 @@ GraphicsPSO::GraphicsPSO()
     m_PSODesc.SampleMask = 0xFFFFFFFFu;
     m_PSODesc.SampleDesc.Count = 1;
     m_PSODesc.InputLayout.NumElements = 0;
+    m_DepthBoundsTestEnable = false;
 }
 
 void GraphicsPSO::SetBlendState( const D3D12_BLEND_DESC& BlendDesc )
@@ -107,6 +220,54 @@ void GraphicsPSO::SetInputLayout( UINT NumElements, const D3D12_INPUT_ELEMENT_DE
 }
 
 void GraphicsPSO::Finalize()
+{
+    ID3D12PipelineState** PSORef = nullptr;
+    if (ReserveHashMapSlot(PSORef))
+    {
+        m_PSO = CompileGraphicsPipeline(m_PSODesc, m_RootSignature->GetHashCode(), UseDepthBoundsTest());
+        PublishPipeline(PSORef, m_PSO);
+    }
+    else
+    {
+        while (*PSORef == nullptr)
+            this_thread::yield();
+        m_PSO = *PSORef;
+    }
+}
+
+void GraphicsPSO::FinalizeAsync( const GraphicsPSO* Fallback )
+{
+    ASSERT(Fallback == nullptr || Fallback->GetRootSignature().GetSignature() == m_RootSignature->GetSignature(),
+        "Fallback PSO must share the root signature of the PSO it stands in for");
+
+    ID3D12PipelineState** PSORef = nullptr;
+    if (ReserveHashMapSlot(PSORef))
+    {
+        // Capture the description by value.  The input layout is kept alive by the shared pointer.
+        D3D12_GRAPHICS_PIPELINE_STATE_DESC Desc = m_PSODesc;
+        shared_ptr<const D3D12_INPUT_ELEMENT_DESC> InputLayouts = m_InputLayouts;
+        size_t RootSignatureHash = m_RootSignature->GetHashCode();
+        bool DepthBoundsTest = UseDepthBoundsTest();
+
+        ++s_NumPendingCompiles;
+        Concurrency::create_task([Desc, InputLayouts, RootSignatureHash, DepthBoundsTest, PSORef]
+        {
+            PublishPipeline(PSORef, CompileGraphicsPipeline(Desc, RootSignatureHash, DepthBoundsTest));
+            --s_NumPendingCompiles;
+        });
+    }
+
+    m_PSO = nullptr;
+    m_PendingPSO = PSORef;
+    m_FallbackPSO = Fallback;
+}
+
+bool GraphicsPSO::UseDepthBoundsTest( void ) const
+{
+    return m_DepthBoundsTestEnable && g_bDepthBoundsTestSupported;
+}
+
+bool GraphicsPSO::ReserveHashMapSlot( ID3D12PipelineState**& PSORef )
 {
     // Make sure the root signature is finalized first
     m_PSODesc.pRootSignature = m_RootSignature->GetSignature();
@@ -116,28 +277,40 @@ void GraphicsPSO::Finalize()
     size_t HashCode = Utility::HashState(&m_PSODesc);
     HashCode = Utility::HashState(m_InputLayouts.get(), m_PSODesc.InputLayout.NumElements, HashCode);
     m_PSODesc.InputLayout.pInputElementDescs = m_InputLayouts.get();
-
-    ID3D12PipelineState** PSORef = nullptr;
-    bool firstCompile = false;
+    if (UseDepthBoundsTest())
     {
-        static mutex s_HashMapMutex;
-        lock_guard<mutex> CS(s_HashMapMutex);
-        auto iter = s_GraphicsPSOHashMap.find(HashCode);
+        const uint32_t DepthBoundsTestKey = 1;
+        HashCode = Utility::HashState(&DepthBoundsTestKey, 1, HashCode);
+    }
 
-        // Reserve space so the next inquiry will find that someone got here first.
-        if (iter == s_GraphicsPSOHashMap.end())
-        {
-            firstCompile = true;
-            PSORef = s_GraphicsPSOHashMap[HashCode].GetAddressOf();
-        }
-        else
-            PSORef = iter->second.GetAddressOf();
+    // A previous FinalizeAsync() no longer applies
+    m_PendingPSO = nullptr;
+    m_FallbackPSO = nullptr;
+
+    static mutex s_HashMapMutex;
+    lock_guard<mutex> CS(s_HashMapMutex);
+    auto iter = s_GraphicsPSOHashMap.find(HashCode);
+
+    // Reserve space so the next inquiry will find that someone got here first.
+    if (iter == s_GraphicsPSOHashMap.end())
+    {
+        PSORef = s_GraphicsPSOHashMap[HashCode].GetAddressOf();
+        return true;
     }
+    else
+    {
+        PSORef = iter->second.GetAddressOf();
+        return false;
+    }
+}
 
-    if (firstCompile)
+void ComputePSO::Finalize()
+{
+    ID3D12PipelineState** PSORef = nullptr;
+    if (ReserveHashMapSlot(PSORef))
     {
-        ASSERT_SUCCEEDED( g_Device->CreateGraphicsPipelineState(&m_PSODesc, MY_IID_PPV_ARGS(&m_PSO)) );
-        s_GraphicsPSOHashMap[HashCode].Attach(m_PSO);
+        m_PSO = CompileComputePipeline(m_PSODesc, m_RootSignature->GetHashCode());
+        PublishPipeline(PSORef, m_PSO);
     }
     else
     {
@@ -147,7 +320,31 @@ void GraphicsPSO::Finalize()
     }
 }
 
-void ComputePSO::Finalize()
+void ComputePSO::FinalizeAsync( const ComputePSO* Fallback )
+{
+    ASSERT(Fallback == nullptr || Fallback->GetRootSignature().GetSignature() == m_RootSignature->GetSignature(),
+        "Fallback PSO must share the root signature of the PSO it stands in for");
+
+    ID3D12PipelineState** PSORef = nullptr;
+    if (ReserveHashMapSlot(PSORef))
+    {
+        D3D12_COMPUTE_PIPELINE_STATE_DESC Desc = m_PSODesc;
+        size_t RootSignatureHash = m_RootSignature->GetHashCode();
+
+        ++s_NumPendingCompiles;
+        Concurrency::create_task([Desc, RootSignatureHash, PSORef]
+        {
+            PublishPipeline(PSORef, CompileComputePipeline(Desc, RootSignatureHash));
+            --s_NumPendingCompiles;
+        });
+    }
+
+    m_PSO = nullptr;
+    m_PendingPSO = PSORef;
+    m_FallbackPSO = Fallback;
+}
+
+bool ComputePSO::ReserveHashMapSlot( ID3D12PipelineState**& PSORef )
 {
     // Make sure the root signature is finalized first
     m_PSODesc.pRootSignature = m_RootSignature->GetSignature();
@@ -155,33 +352,24 @@ void ComputePSO::Finalize()
 
     size_t HashCode = Utility::HashState(&m_PSODesc);
 
-    ID3D12PipelineState** PSORef = nullptr;
-    bool firstCompile = false;
-    {
-        static mutex s_HashMapMutex;
-        lock_guard<mutex> CS(s_HashMapMutex);
-        auto iter = s_ComputePSOHashMap.find(HashCode);
+    // A previous FinalizeAsync() no longer applies
+    m_PendingPSO = nullptr;
+    m_FallbackPSO = nullptr;
 
-        // Reserve space so the next inquiry will find that someone got here first.
-        if (iter == s_ComputePSOHashMap.end())
-        {
-            firstCompile = true;
-            PSORef = s_ComputePSOHashMap[HashCode].GetAddressOf();
-        }
-        else
-            PSORef = iter->second.GetAddressOf();
-    }
+    static mutex s_HashMapMutex;
+    lock_guard<mutex> CS(s_HashMapMutex);
+    auto iter = s_ComputePSOHashMap.find(HashCode);
 
-    if (firstCompile)
+    // Reserve space so the next inquiry will find that someone got here first.
+    if (iter == s_ComputePSOHashMap.end())
     {
-        ASSERT_SUCCEEDED( g_Device->CreateComputePipelineState(&m_PSODesc, MY_IID_PPV_ARGS(&m_PSO)) );
-        s_ComputePSOHashMap[HashCode].Attach(m_PSO);
+        PSORef = s_ComputePSOHashMap[HashCode].GetAddressOf();
+        return true;
     }
     else
     {
-        while (*PSORef == nullptr)
-            this_thread::yield();
-        m_PSO = *PSORef;
+        PSORef = iter->second.GetAddressOf();
+        return false;
     }
 }
 
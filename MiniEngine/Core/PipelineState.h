@@ -28,10 +28,14 @@ class PSO
 {
 public:
 
-    PSO() : m_RootSignature(nullptr) {}
+    PSO() : m_RootSignature(nullptr), m_PSO(nullptr), m_PendingPSO(nullptr), m_FallbackPSO(nullptr) {}
 
     static void DestroyAll( void );
 
+    // Write the PSOs compiled so far to the disk cache, e.g. before the process is suspended and possibly
+    // terminated.  The cache is reopened on the next compile.
+    static void SaveCache( void );
+
     void SetRootSignature( const RootSignature& BindMappings )
     {
         m_RootSignature = &BindMappings;
@@ -43,13 +47,24 @@ public:
         return *m_RootSignature;
     }
 
-    ID3D12PipelineState* GetPipelineStateObject( void ) const { return m_PSO; }
+    // Returns null while a FinalizeAsync() compile is still in flight
+    ID3D12PipelineState* GetPipelineStateObject( void ) const { return m_PendingPSO != nullptr ? *m_PendingPSO : m_PSO; }
+
+    bool IsReady( void ) const { return GetPipelineStateObject() != nullptr; }
+    void WaitForCompletion( void ) const;
+
+    // The PSO to bind until an async compile completes.  Blocks on the compile if there is no fallback.
+    ID3D12PipelineState* GetFallbackPipelineStateObject( void ) const;
 
 protected:
 
     const RootSignature* m_RootSignature;
 
     ID3D12PipelineState* m_PSO;
+
+    // Set by FinalizeAsync().  Points at the hash map slot the compiling thread will fill in.
+    ID3D12PipelineState* const volatile* m_PendingPSO;
+    const PSO* m_FallbackPSO;
 };
 
 class GraphicsPSO : public PSO
@@ -71,6 +86,10 @@ public:
     void SetInputLayout( UINT NumElements, const D3D12_INPUT_ELEMENT_DESC* pInputElementDescs );
     void SetPrimitiveRestart( D3D12_INDEX_BUFFER_STRIP_CUT_VALUE IBProps );
 
+    // Discard pixels whose depth buffer value is outside GraphicsContext::SetDepthBounds().  Ignored when the
+    // hardware lacks support, so the PSO must produce the same image without it.
+    void SetDepthBoundsTestEnable( bool Enable ) { m_DepthBoundsTestEnable = Enable; }
+
     // These const_casts shouldn't be necessary, but we need to fix the API to accept "const void* pShaderBytecode"
     void SetVertexShader( const void* Binary, size_t Size ) { m_PSODesc.VS = CD3DX12_SHADER_BYTECODE(const_cast<void*>(Binary), Size); }
     void SetPixelShader( const void* Binary, size_t Size ) { m_PSODesc.PS = CD3DX12_SHADER_BYTECODE(const_cast<void*>(Binary), Size); }
@@ -87,10 +106,19 @@ public:
     // Perform validation and compute a hash value for fast state block comparisons
     void Finalize();
 
+    // Compile on a worker thread and return immediately.  Until the compile finishes, SetPipelineState()
+    // binds the fallback, which must already be finalized and use the same root signature.  Without a
+    // fallback, the first SetPipelineState() waits for the compile.
+    void FinalizeAsync( const GraphicsPSO* Fallback = nullptr );
+
 private:
 
+    bool ReserveHashMapSlot( ID3D12PipelineState**& PSORef );
+    bool UseDepthBoundsTest( void ) const;
+
     D3D12_GRAPHICS_PIPELINE_STATE_DESC m_PSODesc;
     std::shared_ptr<const D3D12_INPUT_ELEMENT_DESC> m_InputLayouts;
+    bool m_DepthBoundsTestEnable;
 };
 
 
@@ -105,8 +133,11 @@ public:
     void SetComputeShader( const D3D12_SHADER_BYTECODE& Binary ) { m_PSODesc.CS = Binary; }
 
     void Finalize();
+    void FinalizeAsync( const ComputePSO* Fallback = nullptr );
 
 private:
 
+    bool ReserveHashMapSlot( ID3D12PipelineState**& PSORef );
+
     D3D12_COMPUTE_PIPELINE_STATE_DESC m_PSODesc;
 };
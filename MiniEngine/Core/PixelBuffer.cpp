@@ -18,6 +18,8 @@
 #include "BufferManager.h"
 #include "CommandContext.h"
 #include "ReadbackBuffer.h"
+#include "ReadbackManager.h"
+#include "GpuMemory.h"
 #include <fstream>
 
 using namespace Graphics;
@@ -362,6 +364,8 @@ void PixelBuffer::CreateTextureResource( ID3D12Device* Device, const std::wstrin
     ASSERT_SUCCEEDED( Device->CreateCommittedResource( &HeapProps, D3D12_HEAP_FLAG_NONE,
         &ResourceDesc, D3D12_RESOURCE_STATE_COMMON, &ClearValue, MY_IID_PPV_ARGS(&m_pResource) ));
 
+    GpuMemory::Track(m_pResource.Get(), GpuMemory::kRenderTargets);
+
     m_UsageState = D3D12_RESOURCE_STATE_COMMON;
     m_GpuVirtualAddress = D3D12_GPU_VIRTUAL_ADDRESS_NULL;
 
@@ -378,6 +382,24 @@ void PixelBuffer::CreateTextureResource( ID3D12Device* Device, const std::wstrin
     CreateTextureResource(Device, Name, ResourceDesc, ClearValue);
 }
 
+void PixelBuffer::CreateTextureResource( ID3D12Device* Device, const std::wstring& Name,
+    const D3D12_RESOURCE_DESC& ResourceDesc, D3D12_CLEAR_VALUE ClearValue, ID3D12Heap* Heap, uint64_t HeapOffset )
+{
+    Destroy();
+
+    ASSERT_SUCCEEDED( Device->CreatePlacedResource( Heap, HeapOffset, &ResourceDesc,
+        D3D12_RESOURCE_STATE_COMMON, &ClearValue, MY_IID_PPV_ARGS(&m_pResource) ));
+
+    m_UsageState = D3D12_RESOURCE_STATE_COMMON;
+    m_GpuVirtualAddress = D3D12_GPU_VIRTUAL_ADDRESS_NULL;
+
+#ifndef RELEASE
+    m_pResource->SetName(Name.c_str());
+#else
+    (Name);
+#endif
+}
+
 void PixelBuffer::ExportToFile( const std::wstring& FilePath )
 {
     // Create the buffer.  We will release it after all is done.
@@ -401,3 +423,23 @@ void PixelBuffer::ExportToFile( const std::wstring& FilePath )
     // No values were written to the buffer, so use a null range when unmapping.
     TempBuffer.Unmap();
 }
+
+bool PixelBuffer::ExportToFileAsync( CommandContext& Context, const std::wstring& FilePath )
+{
+    const DXGI_FORMAT Format = m_Format;
+    const uint32_t BytesPerTexel = (uint32_t)BytesPerPixel(m_Format);
+
+    return ReadbackManager::ReadTexture2D(Context, *this,
+        [=](const void* Data, uint32_t RowPitch, uint32_t Width, uint32_t Height)
+        {
+            // Rows keep the copy's padding, which the pitch in the header accounts for
+            const uint32_t Pitch = RowPitch / BytesPerTexel;
+
+            std::ofstream OutFile(FilePath, std::ios::out | std::ios::binary);
+            OutFile.write((const char*)&Format, 4);
+            OutFile.write((const char*)&Pitch, 4);
+            OutFile.write((const char*)&Width, 4);
+            OutFile.write((const char*)&Height, 4);
+            OutFile.write((const char*)Data, (std::streamsize)RowPitch * Height);
+        });
+}
@@ -16,6 +16,7 @@
 #include "GpuResource.h"
 
 class EsramAllocator;
+class CommandContext;
 
 class PixelBuffer : public GpuResource
 {
@@ -34,6 +35,10 @@ public:
     // Note that data is preceded by a 16-byte header:  { DXGI_FORMAT, Pitch (in pixels), Width (in pixels), Height }
     void ExportToFile( const std::wstring& FilePath );
 
+    // The same without waiting for the GPU.  The texel data is copied on Context, and a worker thread writes
+    // the file once the copy has finished.  Returns false if the readback could not be queued.
+    bool ExportToFileAsync( CommandContext& Context, const std::wstring& FilePath );
+
 protected:
 
     D3D12_RESOURCE_DESC DescribeTex2D(uint32_t Width, uint32_t Height, uint32_t DepthOrArraySize, uint32_t NumMips, DXGI_FORMAT Format, UINT Flags);
@@ -46,6 +51,10 @@ protected:
     void CreateTextureResource( ID3D12Device* Device, const std::wstring& Name, const D3D12_RESOURCE_DESC& ResourceDesc,
         D3D12_CLEAR_VALUE ClearValue, EsramAllocator& Allocator );
 
+    // Place the texture in a heap rather than giving it memory of its own
+    void CreateTextureResource( ID3D12Device* Device, const std::wstring& Name, const D3D12_RESOURCE_DESC& ResourceDesc,
+        D3D12_CLEAR_VALUE ClearValue, ID3D12Heap* Heap, uint64_t HeapOffset );
+
     static DXGI_FORMAT GetBaseFormat( DXGI_FORMAT Format );
     static DXGI_FORMAT GetUAVFormat( DXGI_FORMAT Format );
     static DXGI_FORMAT GetDSVFormat( DXGI_FORMAT Format );
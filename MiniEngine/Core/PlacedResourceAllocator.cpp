@@ -0,0 +1,495 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Developed by Minigraph
+//
+
+#include "pch.h"
+#include "PlacedResourceAllocator.h"
+#include "GraphicsCore.h"
+#include "CommandListManager.h"
+#include <map>
+#include <mutex>
+#include <atomic>
+#include <algorithm>
+
+using namespace std;
+using namespace Graphics;
+using Microsoft::WRL::ComPtr;
+
+namespace PlacedResourceAllocator
+{
+    BoolVar Enable("Graphics/Memory/Placed Resources", true);
+
+    // Creating a heap costs about as much as creating a committed resource, so each one should hold many
+    const uint64_t kHeapSize = 64 * 1024 * 1024;
+
+    // Small texture heaps used less than this are emptied into fuller ones when their textures are relocated
+    const uint64_t kSparseHeapBytes = kHeapSize / 2;
+
+    enum PoolType { kBufferPool, kSmallTexturePool, kTexturePool, kTargetPool, kNumPools };
+
+    const D3D12_HEAP_FLAGS s_PoolFlags[kNumPools] =
+    {
+        D3D12_HEAP_FLAG_ALLOW_ONLY_BUFFERS,
+        D3D12_HEAP_FLAG_ALLOW_ONLY_NON_RT_DS_TEXTURES,
+        D3D12_HEAP_FLAG_ALLOW_ONLY_NON_RT_DS_TEXTURES,
+        D3D12_HEAP_FLAG_ALLOW_ONLY_RT_DS_TEXTURES,
+    };
+
+    struct HeapBlock
+    {
+        ComPtr<ID3D12Heap> Heap;
+        map<uint64_t, uint64_t> FreeRanges;     // Offset to size, with neighbours always merged
+        uint64_t AllocatedBytes;
+        uint32_t NumAllocations;
+    };
+
+    struct Pool
+    {
+        mutex Mutex;
+        vector<unique_ptr<HeapBlock>> Heaps;
+    };
+
+    struct PendingFree
+    {
+        Pool* Owner;
+        HeapBlock* Block;
+        uint64_t Offset;
+        uint64_t Size;
+        uint64_t FenceValues[3];
+    };
+
+    Pool s_Pools[kNumPools];
+    mutex s_PendingMutex;
+    vector<PendingFree> s_PendingFrees;
+
+    // Resources can outlive Shutdown(), e.g. globals destroyed on exit, and must not touch the pools then
+    atomic<bool> s_IsShutdown(false);
+    atomic<uint32_t> s_NumRelocations(0);
+
+    void QueueFree( Pool* Owner, HeapBlock* Block, uint64_t Offset, uint64_t Size )
+    {
+        if (s_IsShutdown)
+            return;
+
+        // The next fence value of a queue covers its unsubmitted batch as well
+        PendingFree Free = { Owner, Block, Offset, Size,
+        {
+            g_CommandManager.GetGraphicsQueue().GetNextFenceValue(),
+            g_CommandManager.GetComputeQueue().GetNextFenceValue(),
+            g_CommandManager.GetCopyQueue().GetNextFenceValue()
+        } };
+
+        lock_guard<mutex> Guard(s_PendingMutex);
+        s_PendingFrees.push_back(Free);
+    }
+
+    // Attached to a placed resource as private data so that its range is freed however the resource dies
+    class AllocationToken : public IUnknown
+    {
+    public:
+        AllocationToken( Pool* Owner, HeapBlock* Block, uint64_t Offset, uint64_t Size )
+            : m_RefCount(1), m_Owner(Owner), m_Block(Block), m_Offset(Offset), m_Size(Size) {}
+
+        virtual HRESULT STDMETHODCALLTYPE QueryInterface( REFIID Riid, void** ppvObject ) override
+        {
+            if (ppvObject == nullptr)
+                return E_POINTER;
+
+            if (Riid != __uuidof(IUnknown))
+            {
+                *ppvObject = nullptr;
+                return E_NOINTERFACE;
+            }
+
+            *ppvObject = this;
+            AddRef();
+            return S_OK;
+        }
+
+        virtual ULONG STDMETHODCALLTYPE AddRef( void ) override { return ++m_RefCount; }
+
+        virtual ULONG STDMETHODCALLTYPE Release( void ) override
+        {
+            ULONG RefCount = --m_RefCount;
+            if (RefCount == 0)
+            {
+                QueueFree(m_Owner, m_Block, m_Offset, m_Size);
+                delete this;
+            }
+            return RefCount;
+        }
+
+        Pool* GetOwner( void ) const { return m_Owner; }
+        HeapBlock* GetBlock( void ) const { return m_Block; }
+        uint64_t GetSize( void ) const { return m_Size; }
+
+    private:
+        atomic<ULONG> m_RefCount;
+        Pool* m_Owner;
+        HeapBlock* m_Block;
+        uint64_t m_Offset;
+        uint64_t m_Size;
+    };
+
+    // {6A1D2B7C-3E0F-4C55-9B1E-2D4A7F8C9E01}
+    const GUID kAllocationGuid = { 0x6a1d2b7c, 0x3e0f, 0x4c55, { 0x9b, 0x1e, 0x2d, 0x4a, 0x7f, 0x8c, 0x9e, 0x01 } };
+
+    // First fit.  Called with the pool's mutex held.
+    bool AllocateRange( HeapBlock& Block, uint64_t Size, uint64_t Alignment, uint64_t& Offset )
+    {
+        for (auto Iter = Block.FreeRanges.begin(); Iter != Block.FreeRanges.end(); ++Iter)
+        {
+            uint64_t RangeStart = Iter->first;
+            uint64_t RangeEnd = RangeStart + Iter->second;
+            uint64_t AlignedStart = Math::AlignUp(RangeStart, (size_t)Alignment);
+            if (AlignedStart + Size > RangeEnd)
+                continue;
+
+            Block.FreeRanges.erase(Iter);
+            if (AlignedStart > RangeStart)
+                Block.FreeRanges[RangeStart] = AlignedStart - RangeStart;
+            if (AlignedStart + Size < RangeEnd)
+                Block.FreeRanges[AlignedStart + Size] = RangeEnd - (AlignedStart + Size);
+
+            Block.AllocatedBytes += Size;
+            ++Block.NumAllocations;
+            Offset = AlignedStart;
+            return true;
+        }
+        return false;
+    }
+
+    // Called with the pool's mutex held
+    void FreeRange( HeapBlock& Block, uint64_t Offset, uint64_t Size )
+    {
+        ASSERT(Block.AllocatedBytes >= Size && Block.NumAllocations > 0);
+        Block.AllocatedBytes -= Size;
+        --Block.NumAllocations;
+
+        auto Next = Block.FreeRanges.lower_bound(Offset);
+        ASSERT(Next == Block.FreeRanges.end() || Next->first >= Offset + Size, "Freed range overlaps a free range");
+
+        if (Next != Block.FreeRanges.end() && Next->first == Offset + Size)
+        {
+            Size += Next->second;
+            Next = Block.FreeRanges.erase(Next);
+        }
+
+        if (Next != Block.FreeRanges.begin())
+        {
+            auto Prev = Next;
+            --Prev;
+            ASSERT(Prev->first + Prev->second <= Offset, "Freed range overlaps a free range");
+            if (Prev->first + Prev->second == Offset)
+            {
+                Prev->second += Size;
+                return;
+            }
+        }
+
+        Block.FreeRanges[Offset] = Size;
+    }
+
+    HeapBlock* CreateHeapBlock( PoolType Type )
+    {
+        D3D12_HEAP_DESC HeapDesc = {};
+        HeapDesc.SizeInBytes = kHeapSize;
+        HeapDesc.Properties.Type = D3D12_HEAP_TYPE_DEFAULT;
+        HeapDesc.Alignment = D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
+        HeapDesc.Flags = s_PoolFlags[Type];
+
+        // Resources placed here are tracked by GpuMemory themselves, so the heap is not
+        unique_ptr<HeapBlock> Block(new HeapBlock);
+        if (FAILED(g_Device->CreateHeap(&HeapDesc, MY_IID_PPV_ARGS(&Block->Heap))))
+            return nullptr;
+
+#ifndef RELEASE
+        static const wchar_t* s_HeapNames[kNumPools] =
+            { L"Placed Buffer Heap", L"Placed Small Texture Heap", L"Placed Texture Heap", L"Placed Render Target Heap" };
+        Block->Heap->SetName(s_HeapNames[Type]);
+#endif
+
+        Block->FreeRanges[0] = kHeapSize;
+        Block->AllocatedBytes = 0;
+        Block->NumAllocations = 0;
+
+        s_Pools[Type].Heaps.push_back(move(Block));
+        return s_Pools[Type].Heaps.back().get();
+    }
+
+    // Creates the resource in a range allocated from the block and ties the range's lifetime to the resource
+    bool PlaceResource( Pool& ThePool, HeapBlock* Block, uint64_t Offset, uint64_t Size, const D3D12_RESOURCE_DESC& Desc,
+        D3D12_RESOURCE_STATES InitialState, const D3D12_CLEAR_VALUE* ClearValue, ID3D12Resource** ppResource )
+    {
+        HRESULT hr = g_Device->CreatePlacedResource(Block->Heap.Get(), Offset, &Desc, InitialState, ClearValue,
+            MY_IID_PPV_ARGS(ppResource));
+        if (FAILED(hr))
+        {
+            lock_guard<mutex> Guard(ThePool.Mutex);
+            FreeRange(*Block, Offset, Size);
+            return false;
+        }
+
+        AllocationToken* Token = new AllocationToken(&ThePool, Block, Offset, Size);
+        ASSERT_SUCCEEDED((*ppResource)->SetPrivateDataInterface(kAllocationGuid, Token));
+        Token->Release();
+
+        return true;
+    }
+}
+
+bool PlacedResourceAllocator::CreateResource( const D3D12_RESOURCE_DESC& Desc, D3D12_RESOURCE_STATES InitialState,
+    const D3D12_CLEAR_VALUE* ClearValue, ID3D12Resource** ppResource )
+{
+    ASSERT(ppResource != nullptr);
+    *ppResource = nullptr;
+
+    if (!Enable || s_IsShutdown || Desc.SampleDesc.Count > 1)
+        return false;
+
+    PoolType Type;
+    if (Desc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER)
+        Type = kBufferPool;
+    else if (Desc.Flags & (D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET | D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL))
+        Type = kTargetPool;
+    else
+        Type = kTexturePool;
+
+    // Textures whose most detailed mip fits in 64KB can be aligned to 4KB, which the runtime confirms by
+    // returning the small alignment.  They go to heaps of their own.
+    D3D12_RESOURCE_DESC PlacedDesc = Desc;
+    D3D12_RESOURCE_ALLOCATION_INFO Info;
+    PlacedDesc.Alignment = Type == kTexturePool ? D3D12_SMALL_RESOURCE_PLACEMENT_ALIGNMENT : 0;
+    Info = g_Device->GetResourceAllocationInfo(1, 1, &PlacedDesc);
+    if (PlacedDesc.Alignment != 0 && Info.Alignment != D3D12_SMALL_RESOURCE_PLACEMENT_ALIGNMENT)
+    {
+        PlacedDesc.Alignment = 0;
+        Info = g_Device->GetResourceAllocationInfo(1, 1, &PlacedDesc);
+    }
+    else if (PlacedDesc.Alignment != 0)
+        Type = kSmallTexturePool;
+
+    if (Info.SizeInBytes == UINT64_MAX || Info.SizeInBytes > kHeapSize)
+        return false;
+
+    RetireFrees();
+
+    Pool& ThePool = s_Pools[Type];
+    HeapBlock* Block = nullptr;
+    uint64_t Offset = 0;
+    {
+        lock_guard<mutex> Guard(ThePool.Mutex);
+
+        for (auto& Candidate : ThePool.Heaps)
+        {
+            if (AllocateRange(*Candidate, Info.SizeInBytes, Info.Alignment, Offset))
+            {
+                Block = Candidate.get();
+                break;
+            }
+        }
+
+        if (Block == nullptr)
+        {
+            Block = CreateHeapBlock(Type);
+            if (Block == nullptr || !AllocateRange(*Block, Info.SizeInBytes, Info.Alignment, Offset))
+                return false;
+        }
+    }
+
+    return PlaceResource(ThePool, Block, Offset, Info.SizeInBytes, PlacedDesc, InitialState, ClearValue, ppResource);
+}
+
+bool PlacedResourceAllocator::NeedsDefragment( void )
+{
+    if (!Enable || s_IsShutdown)
+        return false;
+
+    Pool& ThePool = s_Pools[kSmallTexturePool];
+    lock_guard<mutex> Guard(ThePool.Mutex);
+
+    if (ThePool.Heaps.size() < 2)
+        return false;
+
+    // Sparse heaps can only be emptied if the other heaps have room for what they hold
+    uint64_t TotalFreeBytes = 0;
+    uint64_t SparsestBytes = kHeapSize;
+    for (auto& Block : ThePool.Heaps)
+    {
+        TotalFreeBytes += kHeapSize - Block->AllocatedBytes;
+        SparsestBytes = min(SparsestBytes, Block->AllocatedBytes);
+    }
+
+    return SparsestBytes < kSparseHeapBytes && TotalFreeBytes - (kHeapSize - SparsestBytes) >= SparsestBytes;
+}
+
+bool PlacedResourceAllocator::Relocate( ID3D12Resource* pResource, D3D12_RESOURCE_STATES InitialState,
+    ID3D12Resource** ppNewResource )
+{
+    ASSERT(pResource != nullptr && ppNewResource != nullptr);
+    *ppNewResource = nullptr;
+
+    if (!Enable || s_IsShutdown)
+        return false;
+
+    ComPtr<IUnknown> Data;
+    UINT DataSize = sizeof(IUnknown*);
+    if (FAILED(pResource->GetPrivateData(kAllocationGuid, &DataSize, Data.GetAddressOf())))
+        return false;
+
+    AllocationToken* Token = static_cast<AllocationToken*>(Data.Get());
+    Pool& ThePool = s_Pools[kSmallTexturePool];
+    if (Token->GetOwner() != &ThePool)
+        return false;
+
+    const D3D12_RESOURCE_DESC Desc = pResource->GetDesc();
+    HeapBlock* Block = nullptr;
+    uint64_t Offset = 0;
+    {
+        lock_guard<mutex> Guard(ThePool.Mutex);
+
+        HeapBlock* Source = Token->GetBlock();
+        if (Source->AllocatedBytes >= kSparseHeapBytes)
+            return false;
+
+        // Fill the fullest heaps first.  Moving only into heaps fuller than the source means textures never
+        // move back and forth between two sparse heaps.
+        vector<HeapBlock*> Targets;
+        for (auto& Candidate : ThePool.Heaps)
+        {
+            if (Candidate.get() != Source && Candidate->AllocatedBytes >= Source->AllocatedBytes)
+                Targets.push_back(Candidate.get());
+        }
+        sort(Targets.begin(), Targets.end(), [](HeapBlock* A, HeapBlock* B) { return A->AllocatedBytes > B->AllocatedBytes; });
+
+        for (HeapBlock* Target : Targets)
+        {
+            if (AllocateRange(*Target, Token->GetSize(), Desc.Alignment, Offset))
+            {
+                Block = Target;
+                break;
+            }
+        }
+
+        if (Block == nullptr)
+            return false;
+    }
+
+    if (!PlaceResource(ThePool, Block, Offset, Token->GetSize(), Desc, InitialState, nullptr, ppNewResource))
+        return false;
+
+    ++s_NumRelocations;
+    return true;
+}
+
+void PlacedResourceAllocator::RetireFrees( void )
+{
+    vector<PendingFree> Retired;
+    {
+        lock_guard<mutex> Guard(s_PendingMutex);
+
+        // Frees are queued in submission order, but compacting the whole list keeps this simple
+        size_t NumPending = 0;
+        for (PendingFree& Free : s_PendingFrees)
+        {
+            if (g_CommandManager.GetGraphicsQueue().IsFenceComplete(Free.FenceValues[0]) &&
+                g_CommandManager.GetComputeQueue().IsFenceComplete(Free.FenceValues[1]) &&
+                g_CommandManager.GetCopyQueue().IsFenceComplete(Free.FenceValues[2]))
+                Retired.push_back(Free);
+            else
+                s_PendingFrees[NumPending++] = Free;
+        }
+        s_PendingFrees.resize(NumPending);
+    }
+
+    for (PendingFree& Free : Retired)
+    {
+        lock_guard<mutex> Guard(Free.Owner->Mutex);
+        FreeRange(*Free.Block, Free.Offset, Free.Size);
+
+        // Keep one heap per pool around so that a resource created and destroyed every few frames doesn't
+        // create a heap each time
+        if (Free.Block->NumAllocations == 0 && Free.Owner->Heaps.size() > 1)
+        {
+            auto& Heaps = Free.Owner->Heaps;
+            for (auto Iter = Heaps.begin(); Iter != Heaps.end(); ++Iter)
+            {
+                if (Iter->get() == Free.Block)
+                {
+                    Heaps.erase(Iter);
+                    break;
+                }
+            }
+        }
+    }
+}
+
+bool PlacedResourceAllocator::IsPlaced( ID3D12Resource* pResource )
+{
+    UINT Size = 0;
+    return SUCCEEDED(pResource->GetPrivateData(kAllocationGuid, &Size, nullptr));
+}
+
+void PlacedResourceAllocator::GetHeaps( std::vector<ComPtr<ID3D12Pageable>>& Heaps )
+{
+    for (Pool& ThePool : s_Pools)
+    {
+        lock_guard<mutex> Guard(ThePool.Mutex);
+        for (auto& Block : ThePool.Heaps)
+            Heaps.push_back(Block->Heap);
+    }
+}
+
+void PlacedResourceAllocator::Initialize( void )
+{
+    s_IsShutdown = false;
+}
+
+void PlacedResourceAllocator::Shutdown( void )
+{
+    s_IsShutdown = true;
+
+    {
+        lock_guard<mutex> Guard(s_PendingMutex);
+        s_PendingFrees.clear();
+    }
+
+    // Resources still placed in the heaps keep them alive
+    for (Pool& ThePool : s_Pools)
+    {
+        lock_guard<mutex> Guard(ThePool.Mutex);
+        ThePool.Heaps.clear();
+    }
+}
+
+PlacedResourceAllocator::Stats PlacedResourceAllocator::GetStats( void )
+{
+    Stats Result = {};
+
+    for (Pool& ThePool : s_Pools)
+    {
+        lock_guard<mutex> Guard(ThePool.Mutex);
+        if (&ThePool == &s_Pools[kSmallTexturePool])
+            Result.NumSmallTextureHeaps = (uint32_t)ThePool.Heaps.size();
+
+        for (auto& Block : ThePool.Heaps)
+        {
+            ++Result.NumHeaps;
+            Result.HeapBytes += kHeapSize;
+            Result.AllocatedBytes += Block->AllocatedBytes;
+            Result.NumAllocations += Block->NumAllocations;
+        }
+    }
+
+    lock_guard<mutex> Guard(s_PendingMutex);
+    Result.NumPendingFrees = (uint32_t)s_PendingFrees.size();
+    Result.NumRelocations = s_NumRelocations;
+    return Result;
+}
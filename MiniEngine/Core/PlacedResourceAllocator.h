@@ -0,0 +1,78 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Developed by Minigraph
+//
+// Description:  Places resources in large shared heaps instead of giving each one a committed resource,
+// which saves a kernel allocation per resource and lets small textures use 4KB alignment instead of 64KB
+// (see the D3D12SmallResources sample).
+//
+// Heaps are kept apart for buffers, textures, and render targets, as resource heap tier 1 requires, and
+// textures are further split by alignment class so that 4KB-aligned textures pack densely instead of being
+// interleaved with 64KB-aligned ones.  The range of a resource is returned to its heap when the resource is
+// destroyed, but it isn't reused until the GPU has finished all work submitted up to that point.
+//
+// Small textures come and go with levels and UI screens, which leaves their heaps sparsely used.  Relocate()
+// lets the owner of such a texture move it into a fuller heap so that the sparse ones empty out and are freed.
+//
+// Placed memory is not zeroed when it is reused, so only resources whose contents are fully written on
+// creation should be placed.
+//
+
+#pragma once
+
+#include <cstdint>
+
+class BoolVar;
+
+namespace PlacedResourceAllocator
+{
+    extern BoolVar Enable;
+
+    // Creates a placed resource, or returns false when the resource isn't suited to placement (it is
+    // multisampled, larger than a heap, or placement is disabled) so the caller can fall back on a committed
+    // resource.  Safe to call from any thread.
+    bool CreateResource( const D3D12_RESOURCE_DESC& Desc, D3D12_RESOURCE_STATES InitialState,
+        const D3D12_CLEAR_VALUE* ClearValue, ID3D12Resource** ppResource );
+
+    // True when a small texture heap is used sparsely enough that moving its textures out would free it.
+    // Cheap enough to check every frame before looking for textures to Relocate().
+    bool NeedsDefragment( void );
+
+    // Creates a copy of a small texture's placement in a fuller heap, provided the texture lives in a sparsely
+    // used heap, and returns false otherwise.  The new resource is created in the given state and holds no
+    // data: the caller copies the contents, switches its views over, and releases the old resource once the
+    // GPU is done with it.  Never creates a heap.
+    bool Relocate( ID3D12Resource* pResource, D3D12_RESOURCE_STATES InitialState, ID3D12Resource** ppNewResource );
+
+    // Returns the ranges of destroyed resources whose GPU work is done to their heaps, and releases heaps that
+    // became empty.  Called once per frame.
+    void RetireFrees( void );
+
+    // Placed resources can't change residency on their own, only with their heaps
+    bool IsPlaced( ID3D12Resource* pResource );
+
+    // Adds a reference to every heap, for residency changes
+    void GetHeaps( std::vector<Microsoft::WRL::ComPtr<ID3D12Pageable>>& Heaps );
+
+    // Pools are created on demand.  Initialize() only needs to be called to use them again after Shutdown().
+    void Initialize( void );
+    void Shutdown( void );
+
+    struct Stats
+    {
+        uint32_t NumHeaps;
+        uint64_t HeapBytes;
+        uint64_t AllocatedBytes;
+        uint32_t NumAllocations;
+        uint32_t NumPendingFrees;
+        uint32_t NumSmallTextureHeaps;
+        uint32_t NumRelocations;
+    };
+    Stats GetStats( void );
+}
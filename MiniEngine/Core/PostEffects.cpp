@@ -44,9 +44,23 @@
 #include "CompiledShaders/BloomExtractAndDownsampleHdrCS.h"
 #include "CompiledShaders/BloomExtractAndDownsampleLdrCS.h"
 #include "CompiledShaders/ExtractLumaCS.h"
+#include "CompiledShaders/BloomExtractAndHistogramHdrCS.h"
+#include "CompiledShaders/ExtractLumaHistogramCS.h"
 #include "CompiledShaders/AverageLumaCS.h"
 #include "CompiledShaders/CopyBackPostBufferCS.h"
 
+// To use the wave intrinsic versions of the reduction shaders, uncomment this macro and #define DXIL in
+// Core/GraphicsCore.cpp.  Run CompileSM6Test.bat to compile them with DXC.
+//#define _WAVE_OP
+#ifdef _WAVE_OP
+#include "CompiledShaders/GenerateHistogramCS_SM6.h"
+#include "CompiledShaders/DownsampleBloomCS_SM6.h"
+#include "CompiledShaders/DownsampleBloomAllCS_SM6.h"
+#include "CompiledShaders/AverageLumaCS_SM6.h"
+#include "CompiledShaders/BloomExtractAndHistogramHdrCS_SM6.h"
+#include "CompiledShaders/ExtractLumaHistogramCS_SM6.h"
+#endif
+
 using namespace Graphics;
 
 namespace SSAO
@@ -79,12 +93,17 @@ namespace PostEffects
     ExpVar Exposure("Graphics/HDR/Exposure", 2.0f, -8.0f, 8.0f, 0.25f);
     BoolVar DrawHistogram("Graphics/HDR/Draw Histogram", false);
 
+    // Bin luminance into the histogram while extracting it rather than writing and re-reading a luma buffer
+    BoolVar FusedHistogram("Graphics/HDR/Fused Histogram", true);
+
     BoolVar BloomEnable("Graphics/Bloom/Enable", true);
     NumVar BloomThreshold("Graphics/Bloom/Threshold", 4.0f, 0.0f, 8.0f, 0.1f);        // The threshold luminance above which a pixel will start to bloom
     NumVar BloomStrength("Graphics/Bloom/Strength", 0.1f, 0.0f, 2.0f, 0.05f);        // A modulator controlling how much bloom is added back into the image
     NumVar BloomUpsampleFactor("Graphics/Bloom/Scatter", 0.65f, 0.0f, 1.0f, 0.05f);    // Controls the "focus" of the blur.  High values spread out more causing a haze.
     BoolVar HighQualityBloom("Graphics/Bloom/High Quality", true);                    // High quality blurs 5 octaves of bloom; low quality only blurs 3.
 
+    BoolVar AsyncCompute("Graphics/Post Effects/Async Compute", false);
+
     RootSignature PostEffectsRS;
     ComputePSO ToneMapCS;
     ComputePSO ToneMapHDRCS;
@@ -101,11 +120,14 @@ namespace PostEffects
     ComputePSO BloomExtractAndDownsampleHdrCS;
     ComputePSO BloomExtractAndDownsampleLdrCS;
     ComputePSO ExtractLumaCS;
+    ComputePSO BloomExtractAndHistogramHdrCS;
+    ComputePSO ExtractLumaHistogramCS;
     ComputePSO AverageLumaCS;
     ComputePSO CopyBackPostBufferCS;
 
     StructuredBuffer g_Exposure;
 
+    bool UseFusedHistogram(void);
     void UpdateExposure(ComputeContext&);
     void BlurBuffer(ComputeContext&, ColorBuffer buffer[2], const ColorBuffer& lowerResBuf, float upsampleBlendFactor );
     void GenerateBloom(ComputeContext&);
@@ -146,17 +168,28 @@ void PostEffects::Initialize( void )
         CreatePSO(DebugLuminanceHdrCS, g_pDebugLuminanceHdrCS);
         CreatePSO(DebugLuminanceLdrCS, g_pDebugLuminanceLdrCS);
     }
+#ifdef _WAVE_OP
+    CreatePSO( GenerateHistogramCS, g_pGenerateHistogramCS_SM6 );
+    CreatePSO( DownsampleBloom2CS, g_pDownsampleBloomCS_SM6 );
+    CreatePSO( DownsampleBloom4CS, g_pDownsampleBloomAllCS_SM6 );
+    CreatePSO( AverageLumaCS, g_pAverageLumaCS_SM6 );
+    CreatePSO( BloomExtractAndHistogramHdrCS, g_pBloomExtractAndHistogramHdrCS_SM6 );
+    CreatePSO( ExtractLumaHistogramCS, g_pExtractLumaHistogramCS_SM6 );
+#else
     CreatePSO( GenerateHistogramCS, g_pGenerateHistogramCS );
-    CreatePSO( DrawHistogramCS, g_pDebugDrawHistogramCS );
-    CreatePSO( AdaptExposureCS, g_pAdaptExposureCS );
     CreatePSO( DownsampleBloom2CS, g_pDownsampleBloomCS );
     CreatePSO( DownsampleBloom4CS, g_pDownsampleBloomAllCS );
+    CreatePSO( AverageLumaCS, g_pAverageLumaCS );
+    CreatePSO( BloomExtractAndHistogramHdrCS, g_pBloomExtractAndHistogramHdrCS );
+    CreatePSO( ExtractLumaHistogramCS, g_pExtractLumaHistogramCS );
+#endif
+    CreatePSO( DrawHistogramCS, g_pDebugDrawHistogramCS );
+    CreatePSO( AdaptExposureCS, g_pAdaptExposureCS );
     CreatePSO( UpsampleAndBlurCS, g_pUpsampleAndBlurCS );
     CreatePSO( BlurCS, g_pBlurCS );
     CreatePSO( BloomExtractAndDownsampleHdrCS, g_pBloomExtractAndDownsampleHdrCS );
     CreatePSO( BloomExtractAndDownsampleLdrCS, g_pBloomExtractAndDownsampleLdrCS );
     CreatePSO( ExtractLumaCS, g_pExtractLumaCS );
-    CreatePSO( AverageLumaCS, g_pAverageLumaCS );
     CreatePSO( CopyBackPostBufferCS, g_pCopyBackPostBufferCS );
 
 
@@ -183,6 +216,17 @@ void PostEffects::Shutdown( void )
     DepthOfField::Shutdown();
 }
 
+StructuredBuffer& PostEffects::GetExposureBuffer( void )
+{
+    return g_Exposure;
+}
+
+// The histogram only feeds exposure adaptation, which only runs on the HDR path
+bool PostEffects::UseFusedHistogram( void )
+{
+    return FusedHistogram && EnableHDR && EnableAdaptation;
+}
+
 void PostEffects::BlurBuffer( ComputeContext& Context, ColorBuffer buffer[2], const ColorBuffer& lowerResBuf, float upsampleBlendFactor )
 {
     // Set the shader constants
@@ -227,18 +271,29 @@ void PostEffects::GenerateBloom( ComputeContext& Context )
 
     Context.SetConstants(0, 1.0f / kBloomWidth, 1.0f / kBloomHeight, (float)BloomThreshold );
     Context.TransitionResource(g_aBloomUAV1[0], D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
-    Context.TransitionResource(g_LumaLR, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
     Context.TransitionResource(g_SceneColorBuffer, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
     Context.TransitionResource(g_Exposure, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
 
     {
 
         Context.SetDynamicDescriptor(1, 0, g_aBloomUAV1[0].GetUAV());
-        Context.SetDynamicDescriptor(1, 1, g_LumaLR.GetUAV());
         Context.SetDynamicDescriptor(2, 0, g_SceneColorBuffer.GetSRV());
         Context.SetDynamicDescriptor(2, 1, g_Exposure.GetSRV());
 
-        Context.SetPipelineState(EnableHDR ? BloomExtractAndDownsampleHdrCS : BloomExtractAndDownsampleLdrCS);
+        if (UseFusedHistogram())
+        {
+            Context.TransitionResource(g_Histogram, D3D12_RESOURCE_STATE_UNORDERED_ACCESS, true);
+            Context.ClearUAV(g_Histogram);
+            Context.SetDynamicDescriptor(1, 1, g_Histogram.GetUAV());
+            Context.SetPipelineState(BloomExtractAndHistogramHdrCS);
+        }
+        else
+        {
+            Context.TransitionResource(g_LumaLR, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+            Context.SetDynamicDescriptor(1, 1, g_LumaLR.GetUAV());
+            Context.SetPipelineState(EnableHDR ? BloomExtractAndDownsampleHdrCS : BloomExtractAndDownsampleLdrCS);
+        }
+
         Context.Dispatch2D(kBloomWidth, kBloomHeight);
     }
 
@@ -306,13 +361,25 @@ void PostEffects::ExtractLuma( ComputeContext& Context )
 {
     ScopedTimer _prof(L"Extract Luma", Context);
 
-    Context.TransitionResource(g_LumaLR, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
     Context.TransitionResource(g_Exposure, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
     Context.SetConstants(0, 1.0f / g_LumaLR.GetWidth(), 1.0f / g_LumaLR.GetHeight());
-    Context.SetDynamicDescriptor(1, 0, g_LumaLR.GetUAV());
     Context.SetDynamicDescriptor(2, 0, g_SceneColorBuffer.GetSRV());
     Context.SetDynamicDescriptor(2, 1, g_Exposure.GetSRV());
-    Context.SetPipelineState(ExtractLumaCS);
+
+    if (UseFusedHistogram())
+    {
+        Context.TransitionResource(g_Histogram, D3D12_RESOURCE_STATE_UNORDERED_ACCESS, true);
+        Context.ClearUAV(g_Histogram);
+        Context.SetDynamicDescriptor(1, 0, g_Histogram.GetUAV());
+        Context.SetPipelineState(ExtractLumaHistogramCS);
+    }
+    else
+    {
+        Context.TransitionResource(g_LumaLR, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+        Context.SetDynamicDescriptor(1, 0, g_LumaLR.GetUAV());
+        Context.SetPipelineState(ExtractLumaCS);
+    }
+
     Context.Dispatch2D(g_LumaLR.GetWidth(), g_LumaLR.GetHeight());
 }
 
@@ -333,14 +400,17 @@ void PostEffects::UpdateExposure( ComputeContext& Context )
         return;
     }
     
-    // Generate an HDR histogram
-    Context.TransitionResource(g_Histogram, D3D12_RESOURCE_STATE_UNORDERED_ACCESS, true);
-    Context.ClearUAV(g_Histogram);
-    Context.TransitionResource(g_LumaLR, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
-    Context.SetDynamicDescriptor(1, 0, g_Histogram.GetUAV() );
-    Context.SetDynamicDescriptor(2, 0, g_LumaLR.GetSRV() );
-    Context.SetPipelineState(GenerateHistogramCS);
-    Context.Dispatch2D(g_LumaLR.GetWidth(), g_LumaLR.GetHeight(), 16, 384);
+    // Generate an HDR histogram, unless luma extraction already did
+    if (!UseFusedHistogram())
+    {
+        Context.TransitionResource(g_Histogram, D3D12_RESOURCE_STATE_UNORDERED_ACCESS, true);
+        Context.ClearUAV(g_Histogram);
+        Context.TransitionResource(g_LumaLR, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+        Context.SetDynamicDescriptor(1, 0, g_Histogram.GetUAV() );
+        Context.SetDynamicDescriptor(2, 0, g_LumaLR.GetSRV() );
+        Context.SetPipelineState(GenerateHistogramCS);
+        Context.Dispatch2D(g_LumaLR.GetWidth(), g_LumaLR.GetHeight(), 16, 384);
+    }
 
     __declspec(align(16)) struct
     {
@@ -468,11 +538,25 @@ void PostEffects::CopyBackPostBuffer( ComputeContext& Context )
 
 void PostEffects::Render( void )
 {
-    ComputeContext& Context = ComputeContext::Begin(L"Post Effects");
+    if (AsyncCompute)
+    {
+        // Compute command lists can't transition out of graphics-only states such as RENDER_TARGET, so the
+        // scene buffer is handed over in a state the compute queue understands.  Then make the compute
+        // queue wait for the scene to finish rendering.
+        GraphicsContext& Handoff = GraphicsContext::Begin(L"Post Effects Handoff");
+        Handoff.TransitionResource(g_SceneColorBuffer, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+        g_CommandManager.GetComputeQueue().StallForFence(Handoff.Finish());
+    }
+
+    ComputeContext& Context = ComputeContext::Begin(L"Post Effects", AsyncCompute);
 
     Context.SetRootSignature(PostEffectsRS);
+    AcquireTransientBuffers(Context, kTransientBloom);
 
-    Context.TransitionResource(g_SceneColorBuffer, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE | D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+    if (AsyncCompute)
+        Context.TransitionResource(g_SceneColorBuffer, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+    else
+        Context.TransitionResource(g_SceneColorBuffer, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE | D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
 
     if (EnableHDR && !SSAO::DebugDraw && !(DepthOfField::Enable && DepthOfField::DebugMode >= 3))
         ProcessHDR(Context);
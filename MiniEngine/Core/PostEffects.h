@@ -17,6 +17,7 @@
 #include "EngineTuning.h"
 
 class ComputeContext;
+class StructuredBuffer;
 
 namespace PostEffects
 {
@@ -39,10 +40,17 @@ namespace PostEffects
 
     extern BoolVar EnableFXAA;
 
+    // Record post processing on the compute queue.  The graphics queue does not wait for it until the
+    // scene buffer is presented, so the UI overlay renders in parallel.
+    extern BoolVar AsyncCompute;
+
     void Initialize( void );
     void Shutdown( void );
     void Render( void );
 
     // Copy the contents of the post effects buffer onto the main scene buffer
     void CopyBackPostBuffer( ComputeContext& Context );
+
+    // Element 0 is the exposure that tone mapping applies, which adaptation updates on the GPU
+    StructuredBuffer& GetExposureBuffer( void );
 }
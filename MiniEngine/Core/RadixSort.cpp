@@ -0,0 +1,148 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Developed by Minigraph
+//
+
+#include "pch.h"
+#include "RadixSort.h"
+#include "RootSignature.h"
+#include "PipelineState.h"
+#include "CommandContext.h"
+
+#include "CompiledShaders/RadixSortIndirectArgsCS.h"
+#include "CompiledShaders/RadixSortScanCS.h"
+#include "CompiledShaders/Radix32CountCS.h"
+#include "CompiledShaders/Radix32ScatterCS.h"
+#include "CompiledShaders/Radix64CountCS.h"
+#include "CompiledShaders/Radix64ScatterCS.h"
+
+namespace RadixSort
+{
+    const uint32_t kRadixBits = 4;
+    const uint32_t kNumBins = 1 << kRadixBits;
+    const uint32_t kBlockSize = 1024;
+
+    IndirectArgsBuffer s_DispatchArgs;
+    ByteAddressBuffer s_Histograms;
+
+    RootSignature s_RootSignature;
+    ComputePSO s_RadixSortIndirectArgsCS;
+    ComputePSO s_RadixSortScanCS;
+    ComputePSO s_Radix32CountCS;
+    ComputePSO s_Radix32ScatterCS;
+    ComputePSO s_Radix64CountCS;
+    ComputePSO s_Radix64ScatterCS;
+
+    // Called once by Core to initialize shaders
+    void Initialize(void);
+    void Shutdown(void);
+}
+
+void RadixSort::Initialize( void )
+{
+    s_DispatchArgs.Create(L"Radix sort dispatch args", 1, 12);
+    s_Histograms.Create(L"Radix sort histograms", kNumBins * kMaxElements / kBlockSize, 4);
+
+    s_RootSignature.Reset(3, 0);
+    s_RootSignature[0].InitAsConstants(0, 4);
+    s_RootSignature[1].InitAsDescriptorRange(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 0, 2);
+    s_RootSignature[2].InitAsDescriptorRange(D3D12_DESCRIPTOR_RANGE_TYPE_UAV, 0, 2);
+    s_RootSignature.Finalize(L"Radix Sort");
+
+#define CreatePSO( ObjName, ShaderByteCode ) \
+    ObjName.SetRootSignature(s_RootSignature); \
+    ObjName.SetComputeShader(ShaderByteCode, sizeof(ShaderByteCode) ); \
+    ObjName.Finalize();
+
+    CreatePSO(s_RadixSortIndirectArgsCS, g_pRadixSortIndirectArgsCS);
+    CreatePSO(s_RadixSortScanCS,         g_pRadixSortScanCS);
+    CreatePSO(s_Radix32CountCS,          g_pRadix32CountCS);
+    CreatePSO(s_Radix32ScatterCS,        g_pRadix32ScatterCS);
+    CreatePSO(s_Radix64CountCS,          g_pRadix64CountCS);
+    CreatePSO(s_Radix64ScatterCS,        g_pRadix64ScatterCS);
+
+#undef CreatePSO
+}
+
+void RadixSort::Shutdown( void )
+{
+    s_DispatchArgs.Destroy();
+    s_Histograms.Destroy();
+}
+
+void RadixSort::Sort(
+    ComputeContext& Context,
+    GpuBuffer& KeyIndexList,
+    GpuBuffer& ScratchList,
+    GpuBuffer& CounterBuffer,
+    uint32_t CounterOffset,
+    bool SortAscending
+)
+{
+    const uint32_t ElementSizeBytes = KeyIndexList.GetElementSize();
+
+    ASSERT(ElementSizeBytes == 4 || ElementSizeBytes == 8, "Invalid key-index list for radix sort");
+    ASSERT(ScratchList.GetElementSize() == ElementSizeBytes &&
+        ScratchList.GetElementCount() >= KeyIndexList.GetElementCount(), "Radix sort scratch list is too small");
+    ASSERT(KeyIndexList.GetElementCount() <= kMaxElements, "List is too long for radix sort");
+
+    const uint32_t KeyFlip = SortAscending ? 0 : 0xffffffff;
+
+    Context.SetRootSignature(s_RootSignature);
+
+    // Generate execute indirect arguments
+    Context.SetPipelineState(s_RadixSortIndirectArgsCS);
+    Context.TransitionResource(CounterBuffer, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+    Context.TransitionResource(s_DispatchArgs, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+    Context.SetConstants(0, CounterOffset, 0, 0, KeyFlip);
+    Context.SetDynamicDescriptor(1, 0, CounterBuffer.GetSRV());
+    Context.SetDynamicDescriptor(2, 0, s_DispatchArgs.GetUAV());
+    Context.Dispatch(1, 1, 1);
+
+    Context.TransitionResource(s_DispatchArgs, D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT);
+    Context.TransitionResource(s_Histograms, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+
+    const ComputePSO& CountPSO = ElementSizeBytes == 4 ? s_Radix32CountCS : s_Radix64CountCS;
+    const ComputePSO& ScatterPSO = ElementSizeBytes == 4 ? s_Radix32ScatterCS : s_Radix64ScatterCS;
+
+    // An even number of passes, so the last one writes back into KeyIndexList
+    const uint32_t NumPasses = ElementSizeBytes * 8 / kRadixBits;
+
+    GpuBuffer* Src = &KeyIndexList;
+    GpuBuffer* Dst = &ScratchList;
+
+    for (uint32_t Pass = 0; Pass < NumPasses; ++Pass)
+    {
+        const uint32_t FirstBit = Pass * kRadixBits;
+        Context.SetConstants(0, CounterOffset, FirstBit % 32, FirstBit / 32, KeyFlip);
+
+        Context.TransitionResource(*Src, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+        Context.TransitionResource(*Dst, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+        Context.SetDynamicDescriptor(1, 1, Src->GetSRV());
+        Context.SetDynamicDescriptor(2, 0, s_Histograms.GetUAV());
+        Context.SetDynamicDescriptor(2, 1, Dst->GetUAV());
+
+        Context.SetPipelineState(CountPSO);
+        Context.DispatchIndirect(s_DispatchArgs, 0);
+        Context.InsertUAVBarrier(s_Histograms);
+
+        Context.SetPipelineState(s_RadixSortScanCS);
+        Context.Dispatch(1, 1, 1);
+        Context.InsertUAVBarrier(s_Histograms);
+
+        Context.SetPipelineState(ScatterPSO);
+        Context.DispatchIndirect(s_DispatchArgs, 0);
+        Context.InsertUAVBarrier(s_Histograms);
+
+        std::swap(Src, Dst);
+    }
+
+    // Leave the list in the same state as BitonicSort::Sort()
+    Context.TransitionResource(KeyIndexList, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+}
@@ -0,0 +1,69 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Developed by Minigraph
+//
+// Radix Sort is a stable, linear-time alternative to BitonicSort for large
+// lists.  It is a least-significant-digit radix sort with 4-bit digits, so
+// each pass orders the list by the next 4 bits while preserving the order
+// established by the previous passes.  A pass has three steps:
+//
+//   1. Count:    Each thread group histograms the digits of a block of 1024
+//                elements.
+//   2. Scan:     An exclusive prefix sum over the histograms, arranged
+//                digit-major, yields where each block writes each digit.
+//   3. Scatter:  Each thread group ranks its elements by digit in LDS and
+//                writes them to their final place for this pass.
+//
+// The work per pass is O(N), and a sort takes 32 / 4 = 8 passes for 4-byte
+// elements and 16 passes for 8-byte elements, regardless of list size.
+// BitonicSort wins on small lists because it sorts 2048 elements per group
+// in LDS, but radix sort pulls ahead as lists grow into the hundreds of
+// thousands.
+//
+// The interface mirrors BitonicSort::Sort().  The item count is read from a
+// GPU buffer, and indirect dispatch arguments are generated on the GPU, so the
+// list can be produced without CPU intervention.  Unlike bitonic sort, radix
+// sort does not work in place, so the caller provides a scratch list of the
+// same size.  The sorted result always ends up back in KeyIndexList.
+//
+// Every bit of each element is sorted.  With 4-byte elements, the key should
+// be packed into the most significant bits with the index below it.  With
+// 8-byte elements, the key is the upper 4 bytes (uint2.y) or the whole 64-bit
+// value, and the index must be in the low bits to break ties.
+
+#pragma once
+
+#include "GpuBuffer.h"
+
+namespace RadixSort
+{
+    // The histograms are allocated up front for this many elements
+    static const uint32_t kMaxElements = 16 * 1024 * 1024;
+
+    void Sort(
+        // An existing compute context
+        ComputeContext& Context,
+
+        // List to be sorted, with 4- or 8-byte elements and raw (byte address) views
+        GpuBuffer& KeyIndexList,
+
+        // A list of the same size and element size used as the other half of a double buffer
+        GpuBuffer& ScratchList,
+
+        // A buffer containing the count of items to be sorted.
+        GpuBuffer& CountBuffer,
+
+        // Offset into counter buffer to find count for this list.  Must be a multiple of 4 bytes.
+        uint32_t CounterOffset,
+
+        // True to sort in ascending order (smallest to largest).  False to sort in descending order.
+        bool SortAscending
+    );
+
+} // namespace RadixSort
@@ -14,6 +14,7 @@
 #include "pch.h"
 #include "ReadbackBuffer.h"
 #include "GraphicsCore.h"
+#include "GpuMemory.h"
 
 using namespace Graphics;
 
@@ -50,6 +51,8 @@ void ReadbackBuffer::Create( const std::wstring& name, uint32_t NumElements, uin
     ASSERT_SUCCEEDED( g_Device->CreateCommittedResource(&HeapProps, D3D12_HEAP_FLAG_NONE, &ResourceDesc,
         D3D12_RESOURCE_STATE_COPY_DEST, nullptr, MY_IID_PPV_ARGS(&m_pResource)) );
 
+    GpuMemory::Track(m_pResource.Get(), GpuMemory::kUpload);
+
     m_GpuVirtualAddress = m_pResource->GetGPUVirtualAddress();
 
 #ifdef RELEASE
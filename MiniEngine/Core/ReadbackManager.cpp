@@ -0,0 +1,204 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Developed by Minigraph
+//
+
+#include "pch.h"
+#include "ReadbackManager.h"
+#include "ReadbackBuffer.h"
+#include "PixelBuffer.h"
+#include "GraphicsCore.h"
+#include "CommandContext.h"
+#include "CommandListManager.h"
+#include "JobSystem.h"
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <atomic>
+
+using namespace Graphics;
+
+namespace ReadbackManager
+{
+    struct Request
+    {
+        const CommandContext* Owner;    // Until the owner submits the copies
+        uint64_t FenceValue;
+        uint64_t RingBegin;
+        uint64_t RingEnd;
+        Callback Func;
+        bool Dispatched;
+        std::atomic<bool> Delivered;
+    };
+
+    ::ReadbackBuffer s_Ring;
+    const uint8_t* s_RingData = nullptr;
+    uint64_t s_RingSize = 0;
+
+    // Monotonic offsets into the ring.  Requests are allocated at the head and retire in allocation order
+    // from the tail, so the memory between the two is in use.
+    uint64_t s_RingHead = 0;
+    uint64_t s_RingTail = 0;
+
+    std::deque<std::unique_ptr<Request>> s_Requests;
+    std::mutex s_Mutex;
+    JobSystem::Counter s_Callbacks;
+
+    Request* AllocateRequest( const CommandContext& Context, size_t NumBytes, size_t Alignment, const Callback& Func );
+}
+
+void ReadbackManager::Initialize( size_t RingBufferSize )
+{
+    s_RingSize = RingBufferSize;
+    s_Ring.Create(L"Readback Ring", (uint32_t)RingBufferSize, 1);
+
+    // Readback heaps may stay mapped.  Every read is of memory whose copies the fence says are complete.
+    s_RingData = (const uint8_t*)s_Ring.Map();
+    s_RingHead = 0;
+    s_RingTail = 0;
+}
+
+void ReadbackManager::Shutdown( void )
+{
+    if (s_RingData == nullptr)
+        return;
+
+    // The GPU is idle, so every submitted request can be delivered now
+    Update();
+    JobSystem::Wait(s_Callbacks);
+
+    s_Requests.clear();
+    s_Ring.Unmap();
+    s_Ring.Destroy();
+    s_RingData = nullptr;
+}
+
+ReadbackManager::Request* ReadbackManager::AllocateRequest( const CommandContext& Context, size_t NumBytes,
+    size_t Alignment, const Callback& Func )
+{
+    ASSERT(s_RingData != nullptr, "ReadbackManager is not initialized");
+
+    // A request never wraps around the end of the ring
+    uint64_t Begin = Math::AlignUp(s_RingHead, Alignment);
+    if (Begin % s_RingSize + NumBytes > s_RingSize)
+        Begin = (Begin / s_RingSize + 1) * s_RingSize;
+
+    if (Begin + NumBytes - s_RingTail > s_RingSize)
+        return nullptr;
+
+    std::unique_ptr<Request> NewRequest(new Request);
+    NewRequest->Owner = &Context;
+    NewRequest->FenceValue = 0;
+    NewRequest->RingBegin = Begin;
+    NewRequest->RingEnd = Begin + NumBytes;
+    NewRequest->Func = Func;
+    NewRequest->Dispatched = false;
+    NewRequest->Delivered = false;
+
+    s_RingHead = NewRequest->RingEnd;
+    s_Requests.push_back(std::move(NewRequest));
+    return s_Requests.back().get();
+}
+
+bool ReadbackManager::Allocate( CommandContext& Context, size_t NumBytes, const Callback& Func,
+    GpuResource*& Buffer, size_t& Offset )
+{
+    std::lock_guard<std::mutex> Lock(s_Mutex);
+
+    Request* NewRequest = AllocateRequest(Context, NumBytes, 16, Func);
+    if (NewRequest == nullptr)
+        return false;
+
+    Buffer = &s_Ring;
+    Offset = (size_t)(NewRequest->RingBegin % s_RingSize);
+    return true;
+}
+
+bool ReadbackManager::ReadBuffer( CommandContext& Context, GpuResource& Src, size_t SrcOffset, size_t NumBytes,
+    const Callback& Func )
+{
+    GpuResource* Buffer;
+    size_t Offset;
+    if (!Allocate(Context, NumBytes, Func, Buffer, Offset))
+        return false;
+
+    Context.TransitionResource(Src, D3D12_RESOURCE_STATE_COPY_SOURCE);
+    Context.CopyBufferRegion(*Buffer, Offset, Src, SrcOffset, NumBytes);
+    return true;
+}
+
+bool ReadbackManager::ReadTexture2D( CommandContext& Context, PixelBuffer& Src, const TextureCallback& Func )
+{
+    D3D12_PLACED_SUBRESOURCE_FOOTPRINT Footprint;
+    g_Device->GetCopyableFootprints(&Src.GetResource()->GetDesc(), 0, 1, 0, &Footprint, nullptr, nullptr, nullptr);
+
+    // The last row is not padded, but callbacks may treat every row as RowPitch bytes long
+    const uint32_t RowPitch = Footprint.Footprint.RowPitch;
+    const uint32_t Width = Footprint.Footprint.Width;
+    const uint32_t Height = Footprint.Footprint.Height;
+    const size_t NumBytes = (size_t)RowPitch * Height;
+
+    {
+        std::lock_guard<std::mutex> Lock(s_Mutex);
+
+        Request* NewRequest = AllocateRequest(Context, NumBytes, D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT,
+            [=](const void* Data, size_t) { Func(Data, RowPitch, Width, Height); });
+        if (NewRequest == nullptr)
+            return false;
+
+        Footprint.Offset = NewRequest->RingBegin % s_RingSize;
+    }
+
+    Context.TransitionResource(Src, D3D12_RESOURCE_STATE_COPY_SOURCE, true);
+    Context.CopyTextureToBuffer(s_Ring, Footprint, Src, 0);
+    return true;
+}
+
+void ReadbackManager::SubmitRequests( const CommandContext& Context, uint64_t FenceValue )
+{
+    std::lock_guard<std::mutex> Lock(s_Mutex);
+
+    for (auto& Pending : s_Requests)
+    {
+        if (Pending->Owner == &Context)
+        {
+            Pending->Owner = nullptr;
+            Pending->FenceValue = FenceValue;
+        }
+    }
+}
+
+void ReadbackManager::Update( void )
+{
+    if (s_RingData == nullptr)
+        return;
+
+    std::lock_guard<std::mutex> Lock(s_Mutex);
+
+    // Requests on different queues can complete out of order, so every one is checked
+    for (auto& Pending : s_Requests)
+    {
+        if (Pending->Dispatched || Pending->FenceValue == 0 || !g_CommandManager.IsFenceComplete(Pending->FenceValue))
+            continue;
+
+        Pending->Dispatched = true;
+        Request* Ready = Pending.get();
+        JobSystem::Run([Ready]()
+        {
+            Ready->Func(s_RingData + Ready->RingBegin % s_RingSize, (size_t)(Ready->RingEnd - Ready->RingBegin));
+            Ready->Delivered.store(true, std::memory_order_release);
+        }, &s_Callbacks);
+    }
+
+    while (!s_Requests.empty() && s_Requests.front()->Delivered.load(std::memory_order_acquire))
+    {
+        s_RingTail = s_Requests.front()->RingEnd;
+        s_Requests.pop_front();
+    }
+}
@@ -0,0 +1,53 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Developed by Minigraph
+//
+// Description:  Reads GPU data back to the CPU without stalling the CPU.  Copies are recorded into a region of
+// a persistent, persistently mapped readback ring buffer.  Each request is tagged with the fence value of the
+// submission that carries its copies, and once a later frame finds the fence complete, the request's callback
+// runs on a job system worker.  The ring space is reclaimed when the callback returns.
+//
+// The data pointer passed to a callback is only valid during the call.  Callbacks may run concurrently with
+// each other and with rendering, so they must only touch thread-safe state.  Requests are dropped, and the
+// callback never runs, when the ring has no room; readbacks are for results that can be missed.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+
+class GpuResource;
+class PixelBuffer;
+class CommandContext;
+
+namespace ReadbackManager
+{
+    typedef std::function<void(const void* Data, size_t NumBytes)> Callback;
+    typedef std::function<void(const void* Data, uint32_t RowPitch, uint32_t Width, uint32_t Height)> TextureCallback;
+
+    void Initialize( size_t RingBufferSize = 16 * 1024 * 1024 );
+    void Shutdown( void );
+
+    // Reserve NumBytes of the ring for copies that the caller records on Context, starting at Offset in Buffer.
+    // Returns false if the ring is full.
+    bool Allocate( CommandContext& Context, size_t NumBytes, const Callback& Func, GpuResource*& Buffer, size_t& Offset );
+
+    // Copy a range of a buffer, which must be in the copy source state or able to transition to it, and deliver it
+    bool ReadBuffer( CommandContext& Context, GpuResource& Src, size_t SrcOffset, size_t NumBytes, const Callback& Func );
+
+    // Copy the top mip of a texture and deliver its rows, RowPitch bytes apart
+    bool ReadTexture2D( CommandContext& Context, PixelBuffer& Src, const TextureCallback& Func );
+
+    // Called by CommandContext when it submits.  Tags the context's untagged requests with the fence value.
+    void SubmitRequests( const CommandContext& Context, uint64_t FenceValue );
+
+    // Called once per frame.  Hands the completed requests to the job system and reclaims retired ring space.
+    void Update( void );
+}
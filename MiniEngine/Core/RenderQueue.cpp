@@ -0,0 +1,58 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Developed by Minigraph
+//
+
+#include "pch.h"
+#include "RenderQueue.h"
+
+void RenderQueue::Sort( void )
+{
+    const uint32_t Count = GetCount();
+    if (Count < 2)
+        return;
+
+    // One pass over the keys builds the histograms of all eight bytes
+    uint32_t Histograms[8][256] = {};
+    for (uint64_t Key : m_Keys)
+    {
+        for (uint32_t Byte = 0; Byte < 8; ++Byte)
+            ++Histograms[Byte][(Key >> (Byte * 8)) & 0xFF];
+    }
+
+    m_SortedKeys.resize(Count);
+    m_SortedPayloads.resize(Count);
+
+    for (uint32_t Byte = 0; Byte < 8; ++Byte)
+    {
+        const uint32_t Shift = Byte * 8;
+        uint32_t* Offsets = Histograms[Byte];
+
+        if (Offsets[(m_Keys[0] >> Shift) & 0xFF] == Count)
+            continue;
+
+        uint32_t Offset = 0;
+        for (uint32_t Bucket = 0; Bucket < 256; ++Bucket)
+        {
+            const uint32_t BucketSize = Offsets[Bucket];
+            Offsets[Bucket] = Offset;
+            Offset += BucketSize;
+        }
+
+        for (uint32_t i = 0; i < Count; ++i)
+        {
+            const uint32_t Dest = Offsets[(m_Keys[i] >> Shift) & 0xFF]++;
+            m_SortedKeys[Dest] = m_Keys[i];
+            m_SortedPayloads[Dest] = m_Payloads[i];
+        }
+
+        m_Keys.swap(m_SortedKeys);
+        m_Payloads.swap(m_SortedPayloads);
+    }
+}
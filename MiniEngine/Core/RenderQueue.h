@@ -0,0 +1,72 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Developed by Minigraph
+//
+// Description:  Draws to be recorded in state order.  Each draw is a 64-bit sort key and a 32-bit payload that
+// the caller uses to find the draw again.  From the most significant bits, a key holds the pass, the PSO, the
+// material and the depth, so sorting groups draws by state and orders each state's draws by depth.  A recorder
+// only has to rebind what changed between consecutive keys.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+class RenderQueue
+{
+public:
+    enum { kPassBits = 4, kPSOBits = 8, kMaterialBits = 20 };
+    enum { kMaterialShift = 32, kPSOShift = 52, kPassShift = 60 };
+
+    // Depth may be any float.  Use the negated depth to sort back to front.
+    static uint64_t MakeKey( uint32_t Pass, uint32_t PSO, uint32_t Material, float Depth )
+    {
+        ASSERT(Pass < (1u << kPassBits) && PSO < (1u << kPSOBits) && Material < (1u << kMaterialBits));
+
+        // Flip negative floats entirely and positive ones only in the sign bit, so that the bits sort like the floats
+        uint32_t DepthBits;
+        memcpy(&DepthBits, &Depth, sizeof(DepthBits));
+        DepthBits ^= (DepthBits & 0x80000000u) ? 0xFFFFFFFFu : 0x80000000u;
+
+        return (uint64_t)Pass << kPassShift | (uint64_t)PSO << kPSOShift | (uint64_t)Material << kMaterialShift | DepthBits;
+    }
+
+    static uint32_t GetPass( uint64_t Key ) { return (uint32_t)(Key >> kPassShift); }
+    static uint32_t GetPSO( uint64_t Key ) { return (uint32_t)(Key >> kPSOShift) & ((1u << kPSOBits) - 1); }
+    static uint32_t GetMaterial( uint64_t Key ) { return (uint32_t)(Key >> kMaterialShift) & ((1u << kMaterialBits) - 1); }
+
+    void Clear( void )
+    {
+        m_Keys.clear();
+        m_Payloads.clear();
+    }
+
+    void Add( uint64_t Key, uint32_t Payload )
+    {
+        m_Keys.push_back(Key);
+        m_Payloads.push_back(Payload);
+    }
+
+    // A stable LSD radix sort, one byte per pass.  Bytes that every key shares are skipped.
+    void Sort( void );
+
+    uint32_t GetCount( void ) const { return (uint32_t)m_Keys.size(); }
+    uint64_t GetKey( uint32_t Index ) const { return m_Keys[Index]; }
+    uint32_t GetPayload( uint32_t Index ) const { return m_Payloads[Index]; }
+
+private:
+    std::vector<uint64_t> m_Keys;
+    std::vector<uint32_t> m_Payloads;
+
+    // Reused by every sort
+    std::vector<uint64_t> m_SortedKeys;
+    std::vector<uint32_t> m_SortedPayloads;
+};
@@ -18,16 +18,226 @@
 #include <map>
 #include <thread>
 #include <mutex>
+#include <atomic>
 
 using namespace Graphics;
 using namespace std;
 using Microsoft::WRL::ComPtr;
 
-static std::map< size_t, ComPtr<ID3D12RootSignature> > s_RootSignatureHashMap;
+namespace
+{
+    // Open addressing with linear probing.  A slot is claimed by swapping its key in, and the signature is
+    // published once created.  Slots are never removed (until DestroyAll), so lookups need no locks.
+    // Applications create at most a few dozen root signatures.
+    struct RootSignatureSlot
+    {
+        atomic<size_t> Key;
+        atomic<ID3D12RootSignature*> Signature;
+    };
+
+    const size_t kRootSignatureTableSize = 1024;
+    RootSignatureSlot s_RootSignatureTable[kRootSignatureTableSize];
+    atomic<uint32_t> s_NumRootSignatures(0);
+
+    atomic<uint32_t> s_NumHits(0);
+    atomic<uint32_t> s_NumMisses(0);
+    atomic<uint32_t> s_NumDiskHits(0);
+    atomic<uint32_t> s_NumDiskMisses(0);
+
+    // Returns true when the caller claimed the slot and must create the signature
+    bool FindOrClaimSlot( size_t HashCode, RootSignatureSlot*& Slot )
+    {
+        // Zero marks an empty slot
+        if (HashCode == 0)
+            HashCode = 1;
+
+        for (size_t Probe = 0; Probe < kRootSignatureTableSize; ++Probe)
+        {
+            Slot = &s_RootSignatureTable[(HashCode + Probe) % kRootSignatureTableSize];
+
+            size_t Key = Slot->Key.load(memory_order_acquire);
+            if (Key == 0 && Slot->Key.compare_exchange_strong(Key, HashCode, memory_order_acq_rel))
+            {
+                s_NumRootSignatures.fetch_add(1, memory_order_relaxed);
+                return true;
+            }
+            if (Key == HashCode)
+                return false;
+        }
+
+        // Still create the signature, but it can't be shared and will never be released
+        ASSERT(false, "Root signature table is full");
+        Slot = nullptr;
+        return true;
+    }
+
+    // Serialized root signatures are written to disk at shutdown, next to the PSO cache, and read back on the
+    // next launch.  The file is a header followed by (hash, size, blob) records.
+    class RootSignatureDiskCache
+    {
+    public:
+        RootSignatureDiskCache() : m_Loaded(false), m_Dirty(false) {}
+
+        // Returns false when the blob was not cached
+        bool Find( size_t HashCode, vector<uint8_t>& Blob );
+        void Store( size_t HashCode, const void* Data, size_t Size );
+        void Shutdown( void );
+
+    private:
+        void Load( void );
+
+        struct FileHeader
+        {
+            uint32_t Magic;
+            uint32_t Version;
+            uint32_t NumEntries;
+        };
+
+        static const uint32_t kMagic = 0x4D495253;   // "SRIM"
+        static const uint32_t kVersion = 1;
+
+        map<uint64_t, vector<uint8_t>> m_Blobs;
+        bool m_Loaded;
+        bool m_Dirty;
+        mutex m_Mutex;
+    };
+
+    const wchar_t* kRootSignatureCacheFileName = L"RootSignatureCache.bin";
+
+    RootSignatureDiskCache s_DiskCache;
+}
+
+void RootSignatureDiskCache::Load( void )
+{
+    m_Loaded = true;
+
+    HANDLE File = CreateFile2(kRootSignatureCacheFileName, GENERIC_READ, FILE_SHARE_READ, OPEN_EXISTING, nullptr);
+    if (File == INVALID_HANDLE_VALUE)
+        return;
+
+    LARGE_INTEGER FileSize = {};
+    vector<uint8_t> Contents;
+    if (GetFileSizeEx(File, &FileSize) && FileSize.HighPart == 0 && FileSize.LowPart >= sizeof(FileHeader))
+    {
+        Contents.resize(FileSize.LowPart);
+        DWORD BytesRead = 0;
+        if (!ReadFile(File, Contents.data(), FileSize.LowPart, &BytesRead, nullptr) || BytesRead != FileSize.LowPart)
+            Contents.clear();
+    }
+    CloseHandle(File);
+
+    if (Contents.empty())
+        return;
+
+    const FileHeader& Header = *(const FileHeader*)Contents.data();
+    if (Header.Magic != kMagic || Header.Version != kVersion)
+        return;
+
+    // A truncated or corrupt file keeps the records read so far.  They were written whole.
+    size_t Offset = sizeof(FileHeader);
+    for (uint32_t i = 0; i < Header.NumEntries; ++i)
+    {
+        uint64_t HashCode;
+        uint32_t Size;
+        if (Offset + sizeof(HashCode) + sizeof(Size) > Contents.size())
+            break;
+        memcpy(&HashCode, &Contents[Offset], sizeof(HashCode));
+        memcpy(&Size, &Contents[Offset + sizeof(HashCode)], sizeof(Size));
+        Offset += sizeof(HashCode) + sizeof(Size);
+        if (Offset + Size > Contents.size())
+            break;
+        m_Blobs[HashCode].assign(&Contents[Offset], &Contents[Offset] + Size);
+        Offset += Size;
+    }
+}
+
+bool RootSignatureDiskCache::Find( size_t HashCode, vector<uint8_t>& Blob )
+{
+    lock_guard<mutex> CS(m_Mutex);
+
+    if (!m_Loaded)
+        Load();
+
+    auto Iter = m_Blobs.find(HashCode);
+    if (Iter == m_Blobs.end())
+        return false;
+
+    Blob = Iter->second;
+    return true;
+}
+
+void RootSignatureDiskCache::Store( size_t HashCode, const void* Data, size_t Size )
+{
+    lock_guard<mutex> CS(m_Mutex);
+    m_Blobs[HashCode].assign((const uint8_t*)Data, (const uint8_t*)Data + Size);
+    m_Dirty = true;
+}
+
+void RootSignatureDiskCache::Shutdown( void )
+{
+    lock_guard<mutex> CS(m_Mutex);
+
+    if (m_Dirty)
+    {
+        HANDLE File = CreateFile2(kRootSignatureCacheFileName, GENERIC_WRITE, 0, CREATE_ALWAYS, nullptr);
+        if (File != INVALID_HANDLE_VALUE)
+        {
+            vector<uint8_t> Contents(sizeof(FileHeader));
+            FileHeader& Header = *(FileHeader*)Contents.data();
+            Header.Magic = kMagic;
+            Header.Version = kVersion;
+            Header.NumEntries = (uint32_t)m_Blobs.size();
+
+            for (auto& Entry : m_Blobs)
+            {
+                uint32_t Size = (uint32_t)Entry.second.size();
+                const uint8_t* Key = (const uint8_t*)&Entry.first;
+                Contents.insert(Contents.end(), Key, Key + sizeof(Entry.first));
+                Contents.insert(Contents.end(), (const uint8_t*)&Size, (const uint8_t*)&Size + sizeof(Size));
+                Contents.insert(Contents.end(), Entry.second.begin(), Entry.second.end());
+            }
+
+            DWORD BytesWritten = 0;
+            if (!WriteFile(File, Contents.data(), (DWORD)Contents.size(), &BytesWritten, nullptr) || BytesWritten != Contents.size())
+                Utility::Printf("Failed to write root signature cache (error %u)\n", GetLastError());
+            CloseHandle(File);
+        }
+    }
+
+    m_Blobs.clear();
+    m_Loaded = false;
+    m_Dirty = false;
+}
+
+void RootSignature::SaveCache(void)
+{
+    // Shutting the disk cache down writes it, and the next lookup loads it again
+    s_DiskCache.Shutdown();
+}
 
 void RootSignature::DestroyAll(void)
 {
-    s_RootSignatureHashMap.clear();
+    s_DiskCache.Shutdown();
+
+    for (RootSignatureSlot& Slot : s_RootSignatureTable)
+    {
+        ID3D12RootSignature* Signature = Slot.Signature.exchange(nullptr);
+        if (Signature != nullptr)
+            Signature->Release();
+        Slot.Key = 0;
+    }
+    s_NumRootSignatures = 0;
+}
+
+RootSignature::CacheStats RootSignature::GetCacheStats( void )
+{
+    CacheStats Stats;
+    Stats.NumSignatures = s_NumRootSignatures.load(memory_order_relaxed);
+    Stats.Hits = s_NumHits.load(memory_order_relaxed);
+    Stats.Misses = s_NumMisses.load(memory_order_relaxed);
+    Stats.DiskHits = s_NumDiskHits.load(memory_order_relaxed);
+    Stats.DiskMisses = s_NumDiskMisses.load(memory_order_relaxed);
+    return Stats;
 }
 
 void RootSignature::InitStaticSampler(
@@ -118,6 +328,9 @@ void RootSignature::Finalize(const std::wstring& name, D3D12_ROOT_SIGNATURE_FLAG
             HashCode = Utility::HashState( RootParam.DescriptorTable.pDescriptorRanges,
                 RootParam.DescriptorTable.NumDescriptorRanges, HashCode );
 
+            // The range pointer can't be hashed, but the table's visibility must be
+            HashCode = Utility::HashState( &RootParam.ShaderVisibility, 1, HashCode );
+
             // We keep track of sampler descriptor tables separately from CBV_SRV_UAV descriptor tables
             if (RootParam.DescriptorTable.pDescriptorRanges->RangeType == D3D12_DESCRIPTOR_RANGE_TYPE_SAMPLER)
                 m_SamplerTableBitMap |= (1 << Param);
@@ -131,44 +344,48 @@ void RootSignature::Finalize(const std::wstring& name, D3D12_ROOT_SIGNATURE_FLAG
             HashCode = Utility::HashState( &RootParam, 1, HashCode );
     }
 
-    ID3D12RootSignature** RSRef = nullptr;
-    bool firstCompile = false;
+    RootSignatureSlot* Slot = nullptr;
+    if (FindOrClaimSlot(HashCode, Slot))
     {
-        static mutex s_HashMapMutex;
-        lock_guard<mutex> CS(s_HashMapMutex);
-        auto iter = s_RootSignatureHashMap.find(HashCode);
+        s_NumMisses.fetch_add(1, memory_order_relaxed);
 
-        // Reserve space so the next inquiry will find that someone got here first.
-        if (iter == s_RootSignatureHashMap.end())
+        // A cached blob that the device rejects (e.g. a stale file) is replaced by a fresh one
+        m_Signature = nullptr;
+        vector<uint8_t> CachedBlob;
+        if (s_DiskCache.Find(HashCode, CachedBlob) && SUCCEEDED(g_Device->CreateRootSignature(1,
+            CachedBlob.data(), CachedBlob.size(), MY_IID_PPV_ARGS(&m_Signature))))
         {
-            RSRef = s_RootSignatureHashMap[HashCode].GetAddressOf();
-            firstCompile = true;
+            s_NumDiskHits.fetch_add(1, memory_order_relaxed);
         }
         else
-            RSRef = iter->second.GetAddressOf();
-    }
+        {
+            s_NumDiskMisses.fetch_add(1, memory_order_relaxed);
 
-    if (firstCompile)
-    {
-        ComPtr<ID3DBlob> pOutBlob, pErrorBlob;
+            ComPtr<ID3DBlob> pOutBlob, pErrorBlob;
+
+            ASSERT_SUCCEEDED( D3D12SerializeRootSignature(&RootDesc, D3D_ROOT_SIGNATURE_VERSION_1,
+                pOutBlob.GetAddressOf(), pErrorBlob.GetAddressOf()));
 
-        ASSERT_SUCCEEDED( D3D12SerializeRootSignature(&RootDesc, D3D_ROOT_SIGNATURE_VERSION_1,
-            pOutBlob.GetAddressOf(), pErrorBlob.GetAddressOf()));
+            ASSERT_SUCCEEDED( g_Device->CreateRootSignature(1, pOutBlob->GetBufferPointer(), pOutBlob->GetBufferSize(),
+                MY_IID_PPV_ARGS(&m_Signature)) );
 
-        ASSERT_SUCCEEDED( g_Device->CreateRootSignature(1, pOutBlob->GetBufferPointer(), pOutBlob->GetBufferSize(),
-            MY_IID_PPV_ARGS(&m_Signature)) );
+            s_DiskCache.Store(HashCode, pOutBlob->GetBufferPointer(), pOutBlob->GetBufferSize());
+        }
 
         m_Signature->SetName(name.c_str());
 
-        s_RootSignatureHashMap[HashCode].Attach(m_Signature);
-        ASSERT(*RSRef == m_Signature);
+        // The table owns the reference
+        if (Slot != nullptr)
+            Slot->Signature.store(m_Signature, memory_order_release);
     }
     else
     {
-        while (*RSRef == nullptr)
+        s_NumHits.fetch_add(1, memory_order_relaxed);
+
+        while ((m_Signature = Slot->Signature.load(memory_order_acquire)) == nullptr)
             this_thread::yield();
-        m_Signature = *RSRef;
     }
 
+    m_HashCode = HashCode;
     m_Finalized = TRUE;
 }
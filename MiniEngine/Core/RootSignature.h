@@ -127,6 +127,20 @@ public:
 
     static void DestroyAll(void);
 
+    // Write the serialized root signatures to the disk cache without destroying anything
+    static void SaveCache(void);
+
+    // Finalize() deduplicates identical root signatures in memory and caches their serialized form on disk
+    struct CacheStats
+    {
+        uint32_t NumSignatures;     // Distinct root signatures created
+        uint32_t Hits;              // Finalize() calls that reused an existing signature
+        uint32_t Misses;            // Finalize() calls that created one
+        uint32_t DiskHits;          // Creations from a blob read from the disk cache
+        uint32_t DiskMisses;        // Creations that had to serialize
+    };
+    static CacheStats GetCacheStats( void );
+
     void Reset( UINT NumRootParams, UINT NumStaticSamplers = 0 )
     {
         if (NumRootParams > 0)
@@ -141,6 +155,10 @@ public:
             m_SamplerArray = nullptr;
         m_NumSamplers = NumStaticSamplers;
         m_NumInitializedStaticSamplers = 0;
+
+        // A root signature described again, e.g. for a recreated device, has to be finalized again
+        m_Finalized = FALSE;
+        m_Signature = nullptr;
     }
 
     RootParameter& operator[] ( size_t EntryIndex )
@@ -162,6 +180,9 @@ public:
 
     ID3D12RootSignature* GetSignature() const { return m_Signature; }
 
+    // Hash of the root signature contents (not its address), stable across runs
+    size_t GetHashCode() const { ASSERT(m_Finalized); return m_HashCode; }
+
 protected:
 
     BOOL m_Finalized;
@@ -174,4 +195,5 @@ protected:
     std::unique_ptr<RootParameter[]> m_ParamArray;
     std::unique_ptr<D3D12_STATIC_SAMPLER_DESC[]> m_SamplerArray;
     ID3D12RootSignature* m_Signature;
+    size_t m_HashCode;
 };
@@ -0,0 +1,185 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Developed by Minigraph
+//
+// Description:  A compile-time description of a root signature.  The layout initializes the RootSignature,
+// and a RootBinder checks at compile time that each binding matches the kind and size of its root parameter.
+// Every setter is inlined down to the one command list call of the untyped variant, with no lookups at run
+// time.  For example:
+//
+//    typedef RootLayout::Layout<
+//        RootLayout::CBV<0, D3D12_SHADER_VISIBILITY_VERTEX>,
+//        RootLayout::Constants<1, 4, D3D12_SHADER_VISIBILITY_VERTEX>
+//    > MyLayout;
+//
+//    MyLayout::Initialize(RootSig);
+//    RootBinder<MyLayout> Binder(gfxContext);
+//    Binder.SetConstants<1>(MyFloat4);
+//
+
+#pragma once
+
+#include "RootSignature.h"
+#include "CommandContext.h"
+#include <tuple>
+
+namespace RootLayout
+{
+    enum ParamKind
+    {
+        kConstants,
+        kCBV,
+        kSRV,
+        kUAV,
+        kTable
+    };
+
+    template <UINT Register, UINT NumDwords, D3D12_SHADER_VISIBILITY Visibility = D3D12_SHADER_VISIBILITY_ALL>
+    struct Constants
+    {
+        static const ParamKind kKind = kConstants;
+        static const UINT kNumDwords = NumDwords;
+        static void Init( RootParameter& Param ) { Param.InitAsConstants(Register, NumDwords, Visibility); }
+    };
+
+    template <UINT Register, D3D12_SHADER_VISIBILITY Visibility = D3D12_SHADER_VISIBILITY_ALL>
+    struct CBV
+    {
+        static const ParamKind kKind = kCBV;
+        static void Init( RootParameter& Param ) { Param.InitAsConstantBuffer(Register, Visibility); }
+    };
+
+    template <UINT Register, D3D12_SHADER_VISIBILITY Visibility = D3D12_SHADER_VISIBILITY_ALL>
+    struct SRV
+    {
+        static const ParamKind kKind = kSRV;
+        static void Init( RootParameter& Param ) { Param.InitAsBufferSRV(Register, Visibility); }
+    };
+
+    template <UINT Register, D3D12_SHADER_VISIBILITY Visibility = D3D12_SHADER_VISIBILITY_ALL>
+    struct UAV
+    {
+        static const ParamKind kKind = kUAV;
+        static void Init( RootParameter& Param ) { Param.InitAsBufferUAV(Register, Visibility); }
+    };
+
+    // A descriptor table with a single range
+    template <D3D12_DESCRIPTOR_RANGE_TYPE RangeType, UINT Register, UINT Count, D3D12_SHADER_VISIBILITY Visibility = D3D12_SHADER_VISIBILITY_ALL>
+    struct Table
+    {
+        static const ParamKind kKind = kTable;
+        static const UINT kCount = Count;
+        static const bool kIsSampler = RangeType == D3D12_DESCRIPTOR_RANGE_TYPE_SAMPLER;
+        static void Init( RootParameter& Param ) { Param.InitAsDescriptorRange(RangeType, Register, Count, Visibility); }
+    };
+
+    template <typename... Params>
+    struct Layout
+    {
+        static const UINT kNumParams = sizeof...(Params);
+
+        template <UINT Index>
+        using Param = typename std::tuple_element<Index, std::tuple<Params...>>::type;
+
+        // Static samplers are not part of the layout, so they are initialized afterwards as usual
+        static void Initialize( RootSignature& Sig, UINT NumStaticSamplers = 0 )
+        {
+            Sig.Reset(kNumParams, NumStaticSamplers);
+            UINT Index = 0;
+            int Expand[] = { 0, (Params::Init(Sig[Index++]), 0)... };
+            (void)Expand;
+        }
+    };
+}
+
+// Sets the root parameters of a layout at compile-time indices.  ContextT is GraphicsContext or ComputeContext.
+template <typename LayoutT, typename ContextT = GraphicsContext>
+class RootBinder
+{
+public:
+    explicit RootBinder( ContextT& Context ) : m_Context(Context) {}
+
+    template <UINT Index, typename T>
+    void SetConstants( const T& Data )
+    {
+        typedef typename LayoutT::template Param<Index> ParamT;
+        static_assert(ParamT::kKind == RootLayout::kConstants, "Root parameter is not a set of constants");
+        static_assert(sizeof(T) == ParamT::kNumDwords * 4, "Data does not match the number of root constants");
+        m_Context.SetConstantArray(Index, ParamT::kNumDwords, &Data);
+    }
+
+    template <UINT Index>
+    void SetConstant( DWParam Val, UINT Offset = 0 )
+    {
+        typedef typename LayoutT::template Param<Index> ParamT;
+        static_assert(ParamT::kKind == RootLayout::kConstants, "Root parameter is not a set of constants");
+        ASSERT(Offset < ParamT::kNumDwords);
+        m_Context.SetConstant(Index, Val, Offset);
+    }
+
+    template <UINT Index>
+    void SetConstantBuffer( D3D12_GPU_VIRTUAL_ADDRESS CBV )
+    {
+        static_assert(LayoutT::template Param<Index>::kKind == RootLayout::kCBV, "Root parameter is not a CBV");
+        m_Context.SetConstantBuffer(Index, CBV);
+    }
+
+    template <UINT Index, typename T>
+    void SetDynamicConstantBufferView( const T& Data )
+    {
+        static_assert(LayoutT::template Param<Index>::kKind == RootLayout::kCBV, "Root parameter is not a CBV");
+        m_Context.SetDynamicConstantBufferView(Index, sizeof(T), &Data);
+    }
+
+    template <UINT Index>
+    void SetBufferSRV( const GpuBuffer& SRV, UINT64 Offset = 0 )
+    {
+        static_assert(LayoutT::template Param<Index>::kKind == RootLayout::kSRV, "Root parameter is not an SRV");
+        m_Context.SetBufferSRV(Index, SRV, Offset);
+    }
+
+    template <UINT Index>
+    void SetBufferUAV( const GpuBuffer& UAV, UINT64 Offset = 0 )
+    {
+        static_assert(LayoutT::template Param<Index>::kKind == RootLayout::kUAV, "Root parameter is not a UAV");
+        m_Context.SetBufferUAV(Index, UAV, Offset);
+    }
+
+    // Tables that already live in a shader-visible heap are bound directly, bypassing the dynamic descriptor
+    // heap's staging.
+    template <UINT Index>
+    void SetDescriptorTable( D3D12_GPU_DESCRIPTOR_HANDLE FirstHandle )
+    {
+        static_assert(LayoutT::template Param<Index>::kKind == RootLayout::kTable, "Root parameter is not a descriptor table");
+        m_Context.SetDescriptorTable(Index, FirstHandle);
+    }
+
+    template <UINT Index>
+    void SetDynamicDescriptors( UINT Offset, UINT Count, const D3D12_CPU_DESCRIPTOR_HANDLE Handles[] )
+    {
+        typedef typename LayoutT::template Param<Index> ParamT;
+        static_assert(ParamT::kKind == RootLayout::kTable && !ParamT::kIsSampler, "Root parameter is not a view table");
+        ASSERT(Offset + Count <= ParamT::kCount);
+        m_Context.SetDynamicDescriptors(Index, Offset, Count, Handles);
+    }
+
+    template <UINT Index>
+    void SetDynamicSamplers( UINT Offset, UINT Count, const D3D12_CPU_DESCRIPTOR_HANDLE Handles[] )
+    {
+        typedef typename LayoutT::template Param<Index> ParamT;
+        static_assert(ParamT::kKind == RootLayout::kTable && ParamT::kIsSampler, "Root parameter is not a sampler table");
+        ASSERT(Offset + Count <= ParamT::kCount);
+        m_Context.SetDynamicSamplers(Index, Offset, Count, Handles);
+    }
+
+    ContextT& GetContext( void ) { return m_Context; }
+
+private:
+    ContextT& m_Context;
+};
@@ -18,6 +18,7 @@
 #include "CommandContext.h"
 #include "Camera.h"
 #include "TemporalEffects.h"
+#include "MotionBlur.h"
 
 #include "CompiledShaders/AoPrepareDepthBuffers1CS.h"
 #include "CompiledShaders/AoPrepareDepthBuffers2CS.h"
@@ -29,6 +30,7 @@
 #include "CompiledShaders/AoBlurUpsamplePreMinBlendOutCS.h"
 #include "CompiledShaders/AoBlurUpsampleCS.h"
 #include "CompiledShaders/AoBlurUpsamplePreMinCS.h"
+#include "CompiledShaders/AoTemporalResolveCS.h"
 
 using namespace Graphics;
 using namespace Math;
@@ -65,6 +67,13 @@ namespace SSAO
     NumVar Accentuation("Graphics/SSAO/Accentuation", 0.1f, 0.0f, 1.0f, 0.1f);
 
     IntVar HierarchyDepth("Graphics/SSAO/Hierarchy Depth", 3, 1, 4);
+
+    // Temporal accumulation splits the samples into subsets and tests one subset per frame.  The result is blended
+    // with last frame's, reprojected with the camera velocity, except where the depth says it saw another surface.
+    BoolVar TemporalAccumulation("Graphics/SSAO/Temporal/Enable", false);
+    IntVar TemporalSampleSubsets("Graphics/SSAO/Temporal/Sample Subsets", 2, 1, 4);
+    NumVar TemporalHistoryWeight("Graphics/SSAO/Temporal/History Weight", 0.8f, 0.0f, 0.95f, 0.05f);
+    NumVar TemporalDepthTolerance("Graphics/SSAO/Temporal/Depth Tolerance", 0.05f, 0.0f, 0.5f, 0.01f);
 }
 
 namespace
@@ -78,8 +87,18 @@ namespace
     ComputePSO s_BlurUpsampleFinal[2];    // Don't blend the result, just upsample it
     ComputePSO s_LinearizeDepthCS;
     ComputePSO s_DebugSSAOCS;
+    ComputePSO s_TemporalResolveCS;
 
     float SampleThickness[12];    // Pre-computed sample thicknesses
+
+    uint32_t s_SampleSubset = 0;        // The subset of samples to test this frame
+    uint32_t s_SampleSubsetCount = 1;   // 1 tests every sample
+
+    // The history is only usable when it was resolved last frame at the same resolution
+    bool s_HistoryValid = false;
+    uint64_t s_HistoryFrame = 0;
+    uint32_t s_HistoryWidth = 0;
+    uint32_t s_HistoryHeight = 0;
 }
 
 void SSAO::Initialize( void )
@@ -110,6 +129,7 @@ void SSAO::Initialize( void )
     CreatePSO( s_BlurUpsampleBlend[1], g_pAoBlurUpsamplePreMinBlendOutCS );
     CreatePSO( s_BlurUpsampleFinal[0], g_pAoBlurUpsampleCS );
     CreatePSO( s_BlurUpsampleFinal[1], g_pAoBlurUpsamplePreMinCS );
+    CreatePSO( s_TemporalResolveCS, g_pAoTemporalResolveCS );
 
     SampleThickness[ 0] = sqrt(1.0f - 0.2f * 0.2f);
     SampleThickness[ 1] = sqrt(1.0f - 0.4f * 0.4f);
@@ -206,6 +226,18 @@ namespace SSAO
         SsaoCB[17] = 0.0f;
         SsaoCB[19] = 0.0f;
         SsaoCB[21] = 0.0f;
+
+        // Temporal accumulation deals the remaining samples round-robin (in shader order) into subsets and only
+        // keeps this frame's.  Each subset is normalized on its own below.
+        if (s_SampleSubsetCount > 1)
+        {
+            const int CheckerSamples[] = { 13, 15, 16, 20, 23, 18, 22 };
+            for (uint32_t i = 0; i < _countof(CheckerSamples); ++i)
+            {
+                if (i % s_SampleSubsetCount != s_SampleSubset)
+                    SsaoCB[CheckerSamples[i]] = 0.0f;
+            }
+        }
     #endif
 
         // Normalize the weights by dividing by the sum of all weights
@@ -291,13 +323,23 @@ namespace SSAO
 void SSAO::Render( GraphicsContext& GfxContext, const Camera& camera )
 {
     const float* pProjMat = reinterpret_cast<const float*>(&camera.GetProjMatrix());
-    Render(GfxContext, pProjMat, camera.GetNearClip(), camera.GetFarClip() );
+    Render(GfxContext, pProjMat, camera.GetNearClip(), camera.GetFarClip(), &camera.GetReprojectionMatrix() );
 }
 
-void SSAO::Render( GraphicsContext& GfxContext, const float* ProjMat, float NearClipDist, float FarClipDist )
+void SSAO::Render( GraphicsContext& GfxContext, const float* ProjMat, float NearClipDist, float FarClipDist,
+    const Matrix4* ReprojectionMatrix )
 {
     uint32_t FrameIndex = TemporalEffects::GetFrameIndexMod2();
 
+    // Reprojecting the history needs to know how the camera moved
+    const bool Temporal = Enable && TemporalAccumulation && ReprojectionMatrix != nullptr;
+    const uint64_t FrameCount = Graphics::GetFrameCount();
+    s_SampleSubsetCount = Temporal ? (uint32_t)TemporalSampleSubsets : 1;
+    s_SampleSubset = (uint32_t)(FrameCount % s_SampleSubsetCount);
+
+    if (!Temporal)
+        s_HistoryValid = false;
+
     ColorBuffer& LinearDepth = g_LinearDepth[FrameIndex];
 
     const float zMagic = (FarClipDist - NearClipDist) / NearClipDist;
@@ -316,7 +358,7 @@ void SSAO::Render( GraphicsContext& GfxContext, const float* ProjMat, float Near
         ComputeContext& Context = GfxContext.GetComputeContext();
         Context.SetRootSignature(s_RootSignature);
 
-        Context.TransitionResource(g_SceneDepthBuffer, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+        Context.TransitionDepthToReadOnly(g_SceneDepthBuffer);
         Context.SetConstants(0, zMagic);
         Context.SetDynamicDescriptor(3, 0, g_SceneDepthBuffer.GetDepthSRV());
 
@@ -338,7 +380,11 @@ void SSAO::Render( GraphicsContext& GfxContext, const float* ProjMat, float Near
         return;
     }
 
-    GfxContext.TransitionResource(g_SceneDepthBuffer, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+    // The compute queue can only read depth outside of the depth states
+    if (AsyncCompute)
+        GfxContext.TransitionResource(g_SceneDepthBuffer, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+    else
+        GfxContext.TransitionDepthToReadOnly(g_SceneDepthBuffer);
     GfxContext.TransitionResource(g_SSAOFullScreen, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
 
     if (AsyncCompute)
@@ -353,6 +399,7 @@ void SSAO::Render( GraphicsContext& GfxContext, const float* ProjMat, float Near
 
     ComputeContext& Context = AsyncCompute ? ComputeContext::Begin(L"Async SSAO", true) : GfxContext.GetComputeContext();
     Context.SetRootSignature(s_RootSignature);
+    AcquireTransientBuffers(Context, kTransientSSAO);
 
     { ScopedTimer _prof(L"Decompress and downsample", Context);
 
@@ -495,11 +542,54 @@ void SSAO::Render( GraphicsContext& GfxContext, const float* ProjMat, float Near
         NextSRV = &g_AOMerged1;
 
     // 960 x 540 -> 1920 x 1080
-    BlurAndUpsample( Context, g_SSAOFullScreen, LinearDepth, g_DepthDownsize1, NextSRV,
+    BlurAndUpsample( Context, Temporal ? g_AOUnresolved : g_SSAOFullScreen, LinearDepth, g_DepthDownsize1, NextSRV,
         g_QualityLevel >= kSsaoQualityVeryHigh ? &g_AOHighQuality1 : nullptr, nullptr );
 
     } // End blur and upsample
 
+    if (Temporal)
+    {
+        ScopedTimer _prof(L"Temporal resolve", Context);
+
+        // This runs before the frame's own velocity pass, so generate the camera velocity here
+        MotionBlur::GenerateCameraVelocityBuffer(Context, *ReprojectionMatrix, NearClipDist, FarClipDist, true);
+        Context.SetRootSignature(s_RootSignature);
+
+        const uint32_t Width = g_SSAOFullScreen.GetWidth();
+        const uint32_t Height = g_SSAOFullScreen.GetHeight();
+
+        if (s_HistoryValid && (s_HistoryFrame + 1 != FrameCount || s_HistoryWidth != Width || s_HistoryHeight != Height))
+            s_HistoryValid = false;
+
+        ColorBuffer& PrevHistory = g_SSAOHistory[FrameIndex ^ 1];
+        ColorBuffer& CurHistory = g_SSAOHistory[FrameIndex];
+        ColorBuffer& PrevLinearDepth = g_LinearDepth[FrameIndex ^ 1];
+
+        Context.TransitionResource(g_AOUnresolved, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+        Context.TransitionResource(PrevHistory, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+        Context.TransitionResource(g_VelocityBuffer, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+        Context.TransitionResource(LinearDepth, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+        Context.TransitionResource(PrevLinearDepth, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+        Context.TransitionResource(g_SSAOFullScreen, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+        Context.TransitionResource(CurHistory, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+
+        D3D12_CPU_DESCRIPTOR_HANDLE ResolveSRVs[5] = { g_AOUnresolved.GetSRV(), PrevHistory.GetSRV(),
+            g_VelocityBuffer.GetSRV(), LinearDepth.GetSRV(), PrevLinearDepth.GetSRV() };
+        D3D12_CPU_DESCRIPTOR_HANDLE ResolveUAVs[2] = { g_SSAOFullScreen.GetUAV(), CurHistory.GetUAV() };
+        Context.SetDynamicDescriptors(3, 0, 5, ResolveSRVs);
+        Context.SetDynamicDescriptors(2, 0, 2, ResolveUAVs);
+
+        Context.SetConstants(0, 1.0f / Width, 1.0f / Height,
+            s_HistoryValid ? (float)TemporalHistoryWeight : 0.0f, (float)TemporalDepthTolerance);
+        Context.SetPipelineState(s_TemporalResolveCS);
+        Context.Dispatch2D(Width, Height);
+
+        s_HistoryValid = true;
+        s_HistoryFrame = FrameCount;
+        s_HistoryWidth = Width;
+        s_HistoryHeight = Height;
+    }
+
     if (AsyncCompute)
         Context.Finish();
     else
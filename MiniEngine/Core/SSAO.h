@@ -13,17 +13,20 @@
 
 #pragma once
 
-namespace Math { class Camera;  }
+namespace Math { class Camera; class Matrix4; }
 
 namespace SSAO
 {
     void Initialize( void );
     void Shutdown( void );
-    void Render(GraphicsContext& Context, const float* ProjMat, float NearClipDist, float FarClipDist );
+    // Temporal accumulation needs the reprojection matrix and is skipped without one
+    void Render(GraphicsContext& Context, const float* ProjMat, float NearClipDist, float FarClipDist,
+        const Math::Matrix4* ReprojectionMatrix = nullptr );
     void Render(GraphicsContext& Context, const Math::Camera& camera );
 
     extern BoolVar Enable;
     extern BoolVar DebugDraw;
     extern BoolVar AsyncCompute;
     extern BoolVar ComputeLinearZ;
+    extern BoolVar TemporalAccumulation;
 }
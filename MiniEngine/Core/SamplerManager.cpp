@@ -15,32 +15,99 @@
 #include "pch.h"
 #include "SamplerManager.h"
 #include "GraphicsCore.h"
+#include "CommandContext.h"
+#include "DescriptorHeap.h"
 #include "Hash.h"
 #include <map>
+#include <mutex>
 
 using namespace std;
 using namespace Graphics;
 
 namespace
 {
-    map< size_t, D3D12_CPU_DESCRIPTOR_HANDLE > s_SamplerCache;
-}
+    struct CachedSampler
+    {
+        D3D12_CPU_DESCRIPTOR_HANDLE Handle;
+        uint32_t BindlessIndex;
+    };
 
-D3D12_CPU_DESCRIPTOR_HANDLE SamplerDesc::CreateDescriptor()
-{
-    size_t hashValue = Utility::HashState(this);
-    auto iter = s_SamplerCache.find(hashValue);
-    if (iter != s_SamplerCache.end())
+    map< size_t, CachedSampler > s_SamplerCache;
+    mutex s_SamplerMutex;
+
+    UserDescriptorHeap s_BindlessHeap(D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER, SamplerManager::kMaxBindlessSamplers);
+    bool s_BindlessHeapCreated = false;
+    uint32_t s_NumBindlessSamplers = 0;
+
+    const CachedSampler& FindOrCreateSampler( const D3D12_SAMPLER_DESC& Desc )
     {
-        return iter->second;
+        size_t hashValue = Utility::HashState(&Desc);
+        auto iter = s_SamplerCache.find(hashValue);
+        if (iter != s_SamplerCache.end())
+            return iter->second;
+
+        if (!s_BindlessHeapCreated)
+        {
+            s_BindlessHeap.Create(L"Bindless Sampler Heap");
+            s_BindlessHeapCreated = true;
+        }
+
+        ASSERT(s_NumBindlessSamplers < SamplerManager::kMaxBindlessSamplers, "Too many unique samplers");
+
+        CachedSampler& Sampler = s_SamplerCache[hashValue];
+        Sampler.Handle = AllocateDescriptor(D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER);
+        Sampler.BindlessIndex = s_NumBindlessSamplers++;
+        g_Device->CreateSampler(&Desc, Sampler.Handle);
+        g_Device->CreateSampler(&Desc, s_BindlessHeap.Alloc().GetCpuHandle());
+        return Sampler;
     }
+}
 
-    D3D12_CPU_DESCRIPTOR_HANDLE Handle = AllocateDescriptor(D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER);
-    g_Device->CreateSampler(this, Handle);
-    return Handle;
+D3D12_CPU_DESCRIPTOR_HANDLE SamplerDesc::CreateDescriptor()
+{
+    lock_guard<mutex> Guard(s_SamplerMutex);
+    return FindOrCreateSampler(*this).Handle;
 }
 
 void SamplerDesc::CreateDescriptor( D3D12_CPU_DESCRIPTOR_HANDLE& Handle )
 {
     g_Device->CreateSampler(this, Handle);
 }
+
+uint32_t SamplerDesc::GetBindlessIndex( void )
+{
+    lock_guard<mutex> Guard(s_SamplerMutex);
+    return FindOrCreateSampler(*this).BindlessIndex;
+}
+
+bool SamplerManager::IsBindlessSupported( void )
+{
+    D3D12_FEATURE_DATA_D3D12_OPTIONS FeatureData = {};
+    if (FAILED(g_Device->CheckFeatureSupport(D3D12_FEATURE_D3D12_OPTIONS, &FeatureData, sizeof(FeatureData))))
+        return false;
+
+    return FeatureData.ResourceBindingTier >= D3D12_RESOURCE_BINDING_TIER_2;
+}
+
+void SamplerManager::SetBindlessTable( GraphicsContext& Context, UINT RootIndex )
+{
+    ASSERT(s_BindlessHeapCreated, "No samplers have been created");
+    Context.SetDescriptorHeap(D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER, s_BindlessHeap.GetHeapPointer());
+    Context.SetDescriptorTable(RootIndex, s_BindlessHeap.GetHandleAtOffset(0).GetGpuHandle());
+}
+
+void SamplerManager::SetBindlessTable( ComputeContext& Context, UINT RootIndex )
+{
+    ASSERT(s_BindlessHeapCreated, "No samplers have been created");
+    Context.SetDescriptorHeap(D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER, s_BindlessHeap.GetHeapPointer());
+    Context.SetDescriptorTable(RootIndex, s_BindlessHeap.GetHandleAtOffset(0).GetGpuHandle());
+}
+
+void SamplerManager::Shutdown( void )
+{
+    lock_guard<mutex> Guard(s_SamplerMutex);
+    s_SamplerCache.clear();
+    s_BindlessHeap.Destroy();
+    s_BindlessHeapCreated = false;
+    s_NumBindlessSamplers = 0;
+}
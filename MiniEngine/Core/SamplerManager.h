@@ -16,6 +16,9 @@
 #include "pch.h"
 #include "Color.h"
 
+class GraphicsContext;
+class ComputeContext;
+
 class SamplerDesc : public D3D12_SAMPLER_DESC
 {
 public:
@@ -59,4 +62,30 @@ public:
 
     // Create descriptor in place (no deduplication)
     void CreateDescriptor( D3D12_CPU_DESCRIPTOR_HANDLE& Handle );
+
+    // Index of this sampler in the bindless sampler heap, creating it as needed.  Identical descriptions
+    // share an index.
+    uint32_t GetBindlessIndex( void );
 };
+
+// Every unique sampler made by CreateDescriptor() or GetBindlessIndex() also gets a slot in one persistent,
+// shader-visible sampler heap.  A pass binds the heap and one table covering all of it, and shaders pick
+// samplers by index (see BindlessSamplers.hlsli), so sampler tables no longer change from draw to draw.
+//
+// Binding dynamic samplers on a context switches it to the dynamic sampler heap, after which the bindless
+// table has to be bound again.
+namespace SamplerManager
+{
+    // Fits in the 2048 samplers a shader-visible heap may hold
+    const uint32_t kMaxBindlessSamplers = 2048;
+
+    // Tables of more than 16 samplers need resource binding tier 2
+    bool IsBindlessSupported( void );
+
+    // Binds the sampler heap and sets the table at RootIndex to cover every sampler
+    void SetBindlessTable( GraphicsContext& Context, UINT RootIndex );
+    void SetBindlessTable( ComputeContext& Context, UINT RootIndex );
+
+    // Forgets every sampler.  Descriptors handed out earlier must not be used again.
+    void Shutdown( void );
+}
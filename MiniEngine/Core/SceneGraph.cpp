@@ -0,0 +1,187 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Developed by Minigraph
+//
+
+#include "pch.h"
+#include "SceneGraph.h"
+#include "JobSystem.h"
+
+using namespace Math;
+using namespace DirectX;
+using namespace std;
+
+SceneGraph::SceneGraph() : m_NeedsSort(false)
+{
+}
+
+SceneGraph::NodeHandle SceneGraph::CreateNode( NodeHandle Parent, const AffineTransform& Local )
+{
+    ASSERT(Parent == kInvalidNode || Parent < m_HandleToIndex.size(), "Parent node does not exist");
+
+    const NodeHandle Handle = (NodeHandle)m_HandleToIndex.size();
+    const uint32_t Index = (uint32_t)m_Parent.size();
+    const uint32_t ParentIndex = Parent == kInvalidNode ? kNoParent : m_HandleToIndex[Parent];
+    const uint32_t Depth = ParentIndex == kNoParent ? 0 : m_Depth[ParentIndex] + 1;
+
+    // Appending keeps the order unless the new node is shallower than the last one
+    if (Index > 0 && Depth < m_Depth.back())
+        m_NeedsSort = true;
+
+    XMFLOAT4X3 LocalMatrix;
+    XMStoreFloat4x3(&LocalMatrix, (XMMATRIX)Local);
+
+    m_Parent.push_back(ParentIndex);
+    m_Depth.push_back(Depth);
+    m_Local.push_back(LocalMatrix);
+    m_World.push_back(LocalMatrix);
+    m_LocalDirty.push_back(1);
+    m_WorldChanged.push_back(0);
+    m_Handle.push_back(Handle);
+    m_HandleToIndex.push_back(Index);
+    m_LevelStart.clear();
+
+    return Handle;
+}
+
+void SceneGraph::Clear( void )
+{
+    m_Parent.clear();
+    m_Depth.clear();
+    m_Local.clear();
+    m_World.clear();
+    m_LocalDirty.clear();
+    m_WorldChanged.clear();
+    m_Handle.clear();
+    m_HandleToIndex.clear();
+    m_LevelStart.clear();
+    m_NeedsSort = false;
+}
+
+void SceneGraph::SetLocalTransform( NodeHandle Node, const AffineTransform& Local )
+{
+    const uint32_t Index = m_HandleToIndex[Node];
+    XMStoreFloat4x3(&m_Local[Index], (XMMATRIX)Local);
+    m_LocalDirty[Index] = 1;
+}
+
+AffineTransform SceneGraph::GetLocalTransform( NodeHandle Node ) const
+{
+    return AffineTransform(XMLoadFloat4x3(&m_Local[m_HandleToIndex[Node]]));
+}
+
+AffineTransform SceneGraph::GetWorldTransform( NodeHandle Node ) const
+{
+    return AffineTransform(XMLoadFloat4x3(&m_World[m_HandleToIndex[Node]]));
+}
+
+// A stable counting sort by depth.  Parents are shallower than their children, so they stay ahead of them.
+void SceneGraph::SortByDepth( void )
+{
+    const uint32_t NodeCount = GetNodeCount();
+
+    uint32_t MaxDepth = 0;
+    for (uint32_t Depth : m_Depth)
+        MaxDepth = max(MaxDepth, Depth);
+
+    vector<uint32_t> Offsets(MaxDepth + 2, 0);
+    for (uint32_t Depth : m_Depth)
+        ++Offsets[Depth + 1];
+    for (uint32_t i = 1; i < Offsets.size(); ++i)
+        Offsets[i] += Offsets[i - 1];
+
+    vector<uint32_t> NewIndex(NodeCount);
+    for (uint32_t i = 0; i < NodeCount; ++i)
+        NewIndex[i] = Offsets[m_Depth[i]]++;
+
+    auto Permute = [&]( auto& Array )
+    {
+        typename remove_reference<decltype(Array)>::type Sorted(Array.size());
+        for (uint32_t i = 0; i < NodeCount; ++i)
+            Sorted[NewIndex[i]] = Array[i];
+        Array.swap(Sorted);
+    };
+
+    for (uint32_t& Parent : m_Parent)
+    {
+        if (Parent != kNoParent)
+            Parent = NewIndex[Parent];
+    }
+
+    Permute(m_Parent);
+    Permute(m_Depth);
+    Permute(m_Local);
+    Permute(m_World);
+    Permute(m_LocalDirty);
+    Permute(m_WorldChanged);
+    Permute(m_Handle);
+
+    for (uint32_t i = 0; i < NodeCount; ++i)
+        m_HandleToIndex[m_Handle[i]] = i;
+
+    m_NeedsSort = false;
+}
+
+// Nodes of one level only read their parents, which the previous level has finished
+void SceneGraph::UpdateRange( uint32_t Begin, uint32_t End )
+{
+    for (uint32_t i = Begin; i < End; ++i)
+    {
+        const uint32_t Parent = m_Parent[i];
+        const bool Changed = m_LocalDirty[i] || (Parent != kNoParent && m_WorldChanged[Parent]);
+        m_WorldChanged[i] = Changed ? 1 : 0;
+
+        if (!Changed)
+            continue;
+
+        m_LocalDirty[i] = 0;
+
+        XMMATRIX World = XMLoadFloat4x3(&m_Local[i]);
+        if (Parent != kNoParent)
+            World = XMMatrixMultiply(World, XMLoadFloat4x3(&m_World[Parent]));
+        XMStoreFloat4x3(&m_World[i], World);
+    }
+}
+
+void SceneGraph::Update( void )
+{
+    if (m_NeedsSort)
+        SortByDepth();
+
+    const uint32_t NodeCount = GetNodeCount();
+
+    if (m_LevelStart.empty())
+    {
+        for (uint32_t i = 0; i < NodeCount; ++i)
+        {
+            if (i == 0 || m_Depth[i] != m_Depth[i - 1])
+                m_LevelStart.push_back(i);
+        }
+        m_LevelStart.push_back(NodeCount);
+    }
+
+    for (uint32_t Level = 0; Level + 1 < m_LevelStart.size(); ++Level)
+    {
+        const uint32_t Begin = m_LevelStart[Level];
+        const uint32_t End = m_LevelStart[Level + 1];
+        const uint32_t NumJobs = (End - Begin + kNodesPerJob - 1) / kNodesPerJob;
+
+        if (NumJobs <= 1)
+        {
+            UpdateRange(Begin, End);
+            continue;
+        }
+
+        JobSystem::ParallelFor(0, NumJobs, 1, [this, Begin, End]( uint32_t Job )
+        {
+            const uint32_t JobBegin = Begin + Job * kNodesPerJob;
+            UpdateRange(JobBegin, min(JobBegin + kNodesPerJob, End));
+        });
+    }
+}
@@ -0,0 +1,78 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Developed by Minigraph
+//
+// Description:  A transform hierarchy stored as a structure of arrays.  Nodes are kept sorted by depth, so that
+// every level of the hierarchy is one contiguous range of the arrays and parents precede their children.
+// Update() walks the levels from the roots down and computes each level's world transforms in parallel on the
+// job system.  Only nodes whose local transform was set, or that descend from one, are recomputed.
+//
+// World transforms are stored as 4x3 matrices (a row_major float4x3 in HLSL), so that culling and instance
+// buffers can copy them as they are.  Storage order only changes when Update() has to re-sort, i.e. after a node
+// was created at a shallower depth than the last one.
+//
+
+#pragma once
+
+#include "VectorMath.h"
+#include <vector>
+
+class SceneGraph
+{
+public:
+    // Handles stay valid when nodes are re-sorted
+    typedef uint32_t NodeHandle;
+    static const NodeHandle kInvalidNode = ~0u;
+
+    SceneGraph();
+
+    // The parent must already exist, so a hierarchy is built from the roots down
+    NodeHandle CreateNode( NodeHandle Parent = kInvalidNode, const Math::AffineTransform& Local = Math::AffineTransform(Math::kIdentity) );
+    void Clear( void );
+
+    void SetLocalTransform( NodeHandle Node, const Math::AffineTransform& Local );
+    Math::AffineTransform GetLocalTransform( NodeHandle Node ) const;
+
+    // As of the last Update()
+    Math::AffineTransform GetWorldTransform( NodeHandle Node ) const;
+
+    // Recompute the world transforms of changed nodes and their descendants.  Must not overlap any other call.
+    void Update( void );
+
+    // Flat access in storage order, valid until the next CreateNode() or Update()
+    uint32_t GetNodeCount( void ) const { return (uint32_t)m_Parent.size(); }
+    uint32_t GetStorageIndex( NodeHandle Node ) const { return m_HandleToIndex[Node]; }
+    NodeHandle GetNodeHandle( uint32_t Index ) const { return m_Handle[Index]; }
+    const DirectX::XMFLOAT4X3* GetWorldTransforms( void ) const { return m_World.data(); }
+
+    // Nonzero for the nodes whose world transform the last Update() recomputed
+    const uint8_t* GetChangedFlags( void ) const { return m_WorldChanged.data(); }
+
+private:
+    static const uint32_t kNoParent = ~0u;
+
+    // Nodes per job.  Levels smaller than this are updated on the calling thread.
+    static const uint32_t kNodesPerJob = 1024;
+
+    void SortByDepth( void );
+    void UpdateRange( uint32_t Begin, uint32_t End );
+
+    // Indexed by storage index
+    std::vector<uint32_t> m_Parent;             // Storage index of the parent, or kNoParent
+    std::vector<uint32_t> m_Depth;
+    std::vector<DirectX::XMFLOAT4X3> m_Local;
+    std::vector<DirectX::XMFLOAT4X3> m_World;
+    std::vector<uint8_t> m_LocalDirty;
+    std::vector<uint8_t> m_WorldChanged;
+    std::vector<NodeHandle> m_Handle;
+
+    std::vector<uint32_t> m_HandleToIndex;
+    std::vector<uint32_t> m_LevelStart;         // Storage index of each level's first node, plus the node count
+    bool m_NeedsSort;
+};
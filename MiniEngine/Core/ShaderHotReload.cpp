@@ -0,0 +1,464 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Developed by Minigraph
+//
+
+#include "pch.h"
+#include "ShaderHotReload.h"
+#include "PipelineState.h"
+#include "EngineTuning.h"
+#include "Utility.h"
+#include <dxcapi.h>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <algorithm>
+
+using namespace std;
+using Microsoft::WRL::ComPtr;
+
+namespace ShaderHotReload
+{
+    BoolVar Enable("Shaders/Hot Reload", false);
+
+    struct Registration
+    {
+        GraphicsPSO* Graphics;
+        ComputePSO* Compute;
+        ShaderStage Stage;
+        wstring SourceFile;
+        wstring EntryPoint;
+        wstring Profile;
+
+        // Lower case file names of the source and everything it included when last compiled
+        vector<wstring> Dependencies;
+
+        // Bytecode must stay alive while a PSO refers to it.  The PSO hash map is keyed by bytecode address,
+        // so freeing old bytecode could let a new compile alias a stale entry.  Reloads are rare enough to
+        // keep every version.
+        vector<ComPtr<IDxcBlob>> Bytecode;
+
+        // The state before the last reload, bound while the new PSO compiles
+        unique_ptr<GraphicsPSO> GraphicsFallback;
+        unique_ptr<ComputePSO> ComputeFallback;
+    };
+
+    struct CompiledShader
+    {
+        Registration* Reg;
+        ComPtr<IDxcBlob> Bytecode;
+        vector<wstring> Dependencies;
+    };
+
+    vector<wstring> s_SourceDirectories;
+    vector<unique_ptr<Registration>> s_Registrations;
+    vector<CompiledShader> s_CompiledShaders;
+    mutex s_Mutex;
+
+    thread s_WatchThread;
+    HANDLE s_StopEvent = nullptr;
+
+    HMODULE s_DxcModule = nullptr;
+    DxcCreateInstanceProc s_DxcCreateInstance = nullptr;
+
+    wstring GetLowerCaseFileName( const wstring& Path )
+    {
+        size_t Slash = Path.find_last_of(L"/\\");
+        wstring Name = Slash == wstring::npos ? Path : Path.substr(Slash + 1);
+        transform(Name.begin(), Name.end(), Name.begin(), towlower);
+        return Name;
+    }
+
+    const wchar_t* GetDefaultProfile( ShaderStage Stage )
+    {
+        switch (Stage)
+        {
+        case kVertex: return L"vs_6_0";
+        case kPixel: return L"ps_6_0";
+        case kGeometry: return L"gs_6_0";
+        case kHull: return L"hs_6_0";
+        case kDomain: return L"ds_6_0";
+        default: return L"cs_6_0";
+        }
+    }
+
+    // Forwards to DXC's default include handler and records every file it opens
+    class DependencyTracker : public IDxcIncludeHandler
+    {
+    public:
+        DependencyTracker( IDxcIncludeHandler* DefaultHandler, vector<wstring>& Dependencies ) :
+            m_DefaultHandler(DefaultHandler), m_Dependencies(Dependencies) {}
+
+        HRESULT STDMETHODCALLTYPE LoadSource( LPCWSTR pFilename, IDxcBlob** ppIncludeSource ) override
+        {
+            HRESULT hr = m_DefaultHandler->LoadSource(pFilename, ppIncludeSource);
+            if (SUCCEEDED(hr))
+                m_Dependencies.push_back(GetLowerCaseFileName(pFilename));
+            return hr;
+        }
+
+        // Lives on the stack for the duration of one compile, so reference counting is a formality
+        HRESULT STDMETHODCALLTYPE QueryInterface( REFIID riid, void** ppvObject ) override
+        {
+            if (riid == __uuidof(IDxcIncludeHandler) || riid == __uuidof(IUnknown))
+            {
+                *ppvObject = static_cast<IDxcIncludeHandler*>(this);
+                return S_OK;
+            }
+            *ppvObject = nullptr;
+            return E_NOINTERFACE;
+        }
+        ULONG STDMETHODCALLTYPE AddRef( void ) override { return 1; }
+        ULONG STDMETHODCALLTYPE Release( void ) override { return 1; }
+
+    private:
+        IDxcIncludeHandler* m_DefaultHandler;
+        vector<wstring>& m_Dependencies;
+    };
+
+    bool LoadCompiler( void )
+    {
+        if (s_DxcCreateInstance != nullptr)
+            return true;
+
+        s_DxcModule = LoadLibrary(L"dxcompiler.dll");
+        if (s_DxcModule != nullptr)
+            s_DxcCreateInstance = (DxcCreateInstanceProc)GetProcAddress(s_DxcModule, "DxcCreateInstance");
+
+        if (s_DxcCreateInstance == nullptr)
+            Utility::Printf("Shader hot reload requires dxcompiler.dll\n");
+
+        return s_DxcCreateInstance != nullptr;
+    }
+
+    // Returns the bytecode, or null after printing the compiler's errors
+    ComPtr<IDxcBlob> CompileShader( const Registration& Reg, vector<wstring>& Dependencies )
+    {
+        ComPtr<IDxcLibrary> Library;
+        ComPtr<IDxcCompiler> Compiler;
+        ComPtr<IDxcIncludeHandler> DefaultHandler;
+        if (FAILED(s_DxcCreateInstance(CLSID_DxcLibrary, MY_IID_PPV_ARGS(&Library))) ||
+            FAILED(s_DxcCreateInstance(CLSID_DxcCompiler, MY_IID_PPV_ARGS(&Compiler))) ||
+            FAILED(Library->CreateIncludeHandler(&DefaultHandler)))
+        {
+            return nullptr;
+        }
+
+        // Find the source in the first directory that has it
+        wstring SourcePath;
+        ComPtr<IDxcBlobEncoding> Source;
+        for (const wstring& Directory : s_SourceDirectories)
+        {
+            SourcePath = Directory + L"/" + Reg.SourceFile;
+            if (SUCCEEDED(Library->CreateBlobFromFile(SourcePath.c_str(), nullptr, &Source)))
+                break;
+        }
+        if (Source == nullptr)
+        {
+            Utility::Printf(L"Shader hot reload could not find %s\n", Reg.SourceFile.c_str());
+            return nullptr;
+        }
+
+        vector<wstring> IncludeArgs;
+        for (const wstring& Directory : s_SourceDirectories)
+            IncludeArgs.push_back(L"-I" + Directory);
+
+        vector<LPCWSTR> Arguments;
+        for (const wstring& Arg : IncludeArgs)
+            Arguments.push_back(Arg.c_str());
+
+        Dependencies.clear();
+        Dependencies.push_back(GetLowerCaseFileName(Reg.SourceFile));
+        DependencyTracker Tracker(DefaultHandler.Get(), Dependencies);
+
+        const wstring& Profile = Reg.Profile.empty() ? GetDefaultProfile(Reg.Stage) : Reg.Profile;
+
+        ComPtr<IDxcOperationResult> Result;
+        HRESULT Status = E_FAIL;
+        if (SUCCEEDED(Compiler->Compile(Source.Get(), SourcePath.c_str(), Reg.EntryPoint.c_str(), Profile.c_str(),
+            Arguments.data(), (UINT32)Arguments.size(), nullptr, 0, &Tracker, &Result)))
+        {
+            Result->GetStatus(&Status);
+        }
+
+        if (FAILED(Status))
+        {
+            ComPtr<IDxcBlobEncoding> Errors;
+            if (Result != nullptr && SUCCEEDED(Result->GetErrorBuffer(&Errors)) && Errors->GetBufferSize() > 0)
+                Utility::Printf("%.*s\n", (int)Errors->GetBufferSize(), (const char*)Errors->GetBufferPointer());
+            Utility::Printf(L"Failed to recompile %s\n", Reg.SourceFile.c_str());
+            return nullptr;
+        }
+
+        ComPtr<IDxcBlob> Bytecode;
+        Result->GetResult(&Bytecode);
+        Utility::Printf(L"Recompiled %s\n", Reg.SourceFile.c_str());
+        return Bytecode;
+    }
+
+    void RecompileChangedShaders( const vector<wstring>& ChangedFiles )
+    {
+        // Copy the work out so that compiling doesn't hold the lock
+        vector<Registration*> Affected;
+        {
+            lock_guard<mutex> Lock(s_Mutex);
+            for (auto& Reg : s_Registrations)
+            {
+                for (const wstring& Changed : ChangedFiles)
+                {
+                    if (find(Reg->Dependencies.begin(), Reg->Dependencies.end(), Changed) != Reg->Dependencies.end())
+                    {
+                        Affected.push_back(Reg.get());
+                        break;
+                    }
+                }
+            }
+        }
+
+        // Registrations are never removed while the watcher runs, and only this thread reads their
+        // source description after registration
+        for (Registration* Reg : Affected)
+        {
+            CompiledShader Compiled;
+            Compiled.Reg = Reg;
+            Compiled.Bytecode = CompileShader(*Reg, Compiled.Dependencies);
+
+            lock_guard<mutex> Lock(s_Mutex);
+            if (Compiled.Bytecode != nullptr)
+                s_CompiledShaders.push_back(move(Compiled));
+        }
+    }
+
+    void WatchDirectories( void )
+    {
+        struct Watch
+        {
+            HANDLE Directory;
+            OVERLAPPED Overlapped;
+            DWORD Buffer[4096];
+        };
+
+        vector<unique_ptr<Watch>> Watches;
+        vector<HANDLE> Events;
+
+        for (const wstring& Path : s_SourceDirectories)
+        {
+            unique_ptr<Watch> W(new Watch);
+            W->Directory = CreateFile(Path.c_str(), FILE_LIST_DIRECTORY, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                nullptr, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, nullptr);
+            if (W->Directory == INVALID_HANDLE_VALUE)
+            {
+                Utility::Printf(L"Shader hot reload could not watch %s\n", Path.c_str());
+                continue;
+            }
+            ZeroMemory(&W->Overlapped, sizeof(W->Overlapped));
+            W->Overlapped.hEvent = CreateEvent(nullptr, FALSE, FALSE, nullptr);
+            Events.push_back(W->Overlapped.hEvent);
+            Watches.push_back(move(W));
+        }
+        Events.push_back(s_StopEvent);
+
+        auto IssueRead = [](Watch& W)
+        {
+            ReadDirectoryChangesW(W.Directory, W.Buffer, sizeof(W.Buffer), TRUE,
+                FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME, nullptr, &W.Overlapped, nullptr);
+        };
+        for (auto& W : Watches)
+            IssueRead(*W);
+
+        vector<wstring> ChangedFiles;
+
+        while (true)
+        {
+            // Editors often write a file more than once when saving, so gather changes until things settle
+            DWORD Timeout = ChangedFiles.empty() ? INFINITE : 100;
+            DWORD Signaled = WaitForMultipleObjects((DWORD)Events.size(), Events.data(), FALSE, Timeout);
+
+            if (Signaled == WAIT_TIMEOUT)
+            {
+                RecompileChangedShaders(ChangedFiles);
+                ChangedFiles.clear();
+                continue;
+            }
+
+            size_t Index = Signaled - WAIT_OBJECT_0;
+            if (Index >= Watches.size())
+                break;
+
+            Watch& W = *Watches[Index];
+            DWORD BytesReturned = 0;
+            if (GetOverlappedResult(W.Directory, &W.Overlapped, &BytesReturned, FALSE) && BytesReturned > 0)
+            {
+                const uint8_t* Entry = (const uint8_t*)W.Buffer;
+                while (true)
+                {
+                    const FILE_NOTIFY_INFORMATION& Info = *(const FILE_NOTIFY_INFORMATION*)Entry;
+                    wstring Name = GetLowerCaseFileName(wstring(Info.FileName, Info.FileNameLength / sizeof(WCHAR)));
+                    if (find(ChangedFiles.begin(), ChangedFiles.end(), Name) == ChangedFiles.end())
+                        ChangedFiles.push_back(Name);
+                    if (Info.NextEntryOffset == 0)
+                        break;
+                    Entry += Info.NextEntryOffset;
+                }
+            }
+            IssueRead(W);
+        }
+
+        for (auto& W : Watches)
+        {
+            CancelIoEx(W->Directory, &W->Overlapped);
+            DWORD BytesReturned = 0;
+            GetOverlappedResult(W->Directory, &W->Overlapped, &BytesReturned, TRUE);
+            CloseHandle(W->Overlapped.hEvent);
+            CloseHandle(W->Directory);
+        }
+    }
+
+    void StartWatching( void )
+    {
+        if (!LoadCompiler())
+        {
+            Enable = false;
+            return;
+        }
+
+        s_StopEvent = CreateEvent(nullptr, TRUE, FALSE, nullptr);
+        s_WatchThread = thread(WatchDirectories);
+    }
+
+    void StopWatching( void )
+    {
+        SetEvent(s_StopEvent);
+        s_WatchThread.join();
+        CloseHandle(s_StopEvent);
+        s_StopEvent = nullptr;
+    }
+
+    void AddRegistration( GraphicsPSO* Graphics, ComputePSO* Compute, ShaderStage Stage,
+        const wstring& SourceFile, const wstring& EntryPoint, const wstring& Profile )
+    {
+        unique_ptr<Registration> Reg(new Registration);
+        Reg->Graphics = Graphics;
+        Reg->Compute = Compute;
+        Reg->Stage = Stage;
+        Reg->SourceFile = SourceFile;
+        Reg->EntryPoint = EntryPoint;
+        Reg->Profile = Profile;
+
+        // Includes are discovered by the first recompile.  Until then only the source itself is known.
+        Reg->Dependencies.push_back(GetLowerCaseFileName(SourceFile));
+
+        lock_guard<mutex> Lock(s_Mutex);
+        s_Registrations.push_back(move(Reg));
+    }
+
+    // Returns false if the PSO is still compiling a previous reload, in which case it must be retried
+    bool ApplyShader( CompiledShader& Compiled )
+    {
+        Registration& Reg = *Compiled.Reg;
+        IDxcBlob* Blob = Compiled.Bytecode.Get();
+
+        if (Reg.Compute != nullptr)
+        {
+            if (!Reg.Compute->IsReady())
+                return false;
+
+            unique_ptr<ComputePSO> Fallback(new ComputePSO(*Reg.Compute));
+            Reg.Compute->SetComputeShader(Blob->GetBufferPointer(), Blob->GetBufferSize());
+            Reg.Compute->FinalizeAsync(Fallback.get());
+            Reg.ComputeFallback = move(Fallback);
+        }
+        else
+        {
+            if (!Reg.Graphics->IsReady())
+                return false;
+
+            unique_ptr<GraphicsPSO> Fallback(new GraphicsPSO(*Reg.Graphics));
+            switch (Reg.Stage)
+            {
+            case kVertex: Reg.Graphics->SetVertexShader(Blob->GetBufferPointer(), Blob->GetBufferSize()); break;
+            case kPixel: Reg.Graphics->SetPixelShader(Blob->GetBufferPointer(), Blob->GetBufferSize()); break;
+            case kGeometry: Reg.Graphics->SetGeometryShader(Blob->GetBufferPointer(), Blob->GetBufferSize()); break;
+            case kHull: Reg.Graphics->SetHullShader(Blob->GetBufferPointer(), Blob->GetBufferSize()); break;
+            case kDomain: Reg.Graphics->SetDomainShader(Blob->GetBufferPointer(), Blob->GetBufferSize()); break;
+            default: ASSERT(false, "Compute shader registered with a graphics PSO"); break;
+            }
+            Reg.Graphics->FinalizeAsync(Fallback.get());
+            Reg.GraphicsFallback = move(Fallback);
+        }
+
+        Reg.Dependencies = move(Compiled.Dependencies);
+        Reg.Bytecode.push_back(move(Compiled.Bytecode));
+        return true;
+    }
+}
+
+void ShaderHotReload::Initialize( const vector<wstring>& SourceDirectories )
+{
+    ASSERT(!s_WatchThread.joinable(), "Shader hot reload is already running");
+    s_SourceDirectories = SourceDirectories;
+}
+
+void ShaderHotReload::Shutdown( void )
+{
+    if (s_WatchThread.joinable())
+        StopWatching();
+
+    // Wait for reloads in flight, because their fallbacks are about to be destroyed
+    for (auto& Reg : s_Registrations)
+    {
+        if (Reg->Graphics != nullptr)
+            Reg->Graphics->WaitForCompletion();
+        if (Reg->Compute != nullptr)
+            Reg->Compute->WaitForCompletion();
+    }
+
+    s_Registrations.clear();
+    s_CompiledShaders.clear();
+    s_SourceDirectories.clear();
+
+    if (s_DxcModule != nullptr)
+    {
+        FreeLibrary(s_DxcModule);
+        s_DxcModule = nullptr;
+        s_DxcCreateInstance = nullptr;
+    }
+}
+
+void ShaderHotReload::Register( GraphicsPSO& PSO, ShaderStage Stage, const wstring& SourceFile,
+    const wstring& EntryPoint, const wstring& Profile )
+{
+    ASSERT(Stage != kCompute, "Compute shaders are registered with a ComputePSO");
+    AddRegistration(&PSO, nullptr, Stage, SourceFile, EntryPoint, Profile);
+}
+
+void ShaderHotReload::Register( ComputePSO& PSO, const wstring& SourceFile,
+    const wstring& EntryPoint, const wstring& Profile )
+{
+    AddRegistration(nullptr, &PSO, kCompute, SourceFile, EntryPoint, Profile);
+}
+
+void ShaderHotReload::Update( void )
+{
+    if (Enable && !s_WatchThread.joinable())
+        StartWatching();
+    else if (!Enable && s_WatchThread.joinable())
+        StopWatching();
+
+    lock_guard<mutex> Lock(s_Mutex);
+
+    // Keep the shaders whose PSOs are still busy for the next frame
+    size_t NumPending = 0;
+    for (size_t i = 0; i < s_CompiledShaders.size(); ++i)
+    {
+        if (!ApplyShader(s_CompiledShaders[i]))
+            s_CompiledShaders[NumPending++] = move(s_CompiledShaders[i]);
+    }
+    s_CompiledShaders.resize(NumPending);
+}
@@ -0,0 +1,59 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Developed by Minigraph
+//
+// Description:  Recompiles shaders at run time when their HLSL sources change.  This is a development aid
+// for iterating on shaders without relinking; shipping builds keep using the precompiled bytecode.
+//
+// A background thread watches the source directories.  When a registered shader's source, or a file it
+// includes, is written, DXC recompiles just that shader.  At the start of the next frame the new bytecode
+// is set on the PSO, which is finalized asynchronously with a copy of its previous state as the fallback,
+// so rendering continues with the old shader until the new PSO is ready.
+//
+// dxcompiler.dll is loaded on demand.  Without it, hot reload reports an error and does nothing.
+//
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+class BoolVar;
+class GraphicsPSO;
+class ComputePSO;
+
+namespace ShaderHotReload
+{
+    enum ShaderStage
+    {
+        kVertex,
+        kPixel,
+        kGeometry,
+        kHull,
+        kDomain,
+        kCompute
+    };
+
+    extern BoolVar Enable;
+
+    // Directories to watch, in include search order.  Sources are registered relative to these.
+    void Initialize( const std::vector<std::wstring>& SourceDirectories );
+    void Shutdown( void );
+
+    // The PSO must outlive the registration, i.e. until Shutdown().  An empty profile picks the shader
+    // model 6.0 profile for the stage.
+    void Register( GraphicsPSO& PSO, ShaderStage Stage, const std::wstring& SourceFile,
+        const std::wstring& EntryPoint = L"main", const std::wstring& Profile = L"" );
+    void Register( ComputePSO& PSO, const std::wstring& SourceFile,
+        const std::wstring& EntryPoint = L"main", const std::wstring& Profile = L"" );
+
+    // Starts or stops watching as Enable changes, and applies shaders that finished compiling.  Called once
+    // per frame while no other thread is recording with the registered PSOs.
+    void Update( void );
+}
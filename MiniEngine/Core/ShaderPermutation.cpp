@@ -0,0 +1,55 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Developed by Minigraph
+//
+
+#include "pch.h"
+#include "ShaderPermutation.h"
+#include "RootSignature.h"
+
+void ComputePSOPermutations::Create( const RootSignature& RootSig, const ShaderPermutation* Permutations, size_t Count,
+    uint32_t FixedMask, uint32_t FixedFeatures )
+{
+    ASSERT((FixedFeatures & ~FixedMask) == 0);
+
+    m_Features.clear();
+    m_PSOs.clear();
+
+    for (size_t i = 0; i < Count; ++i)
+    {
+        if ((Permutations[i].Features & FixedMask) == FixedFeatures)
+            m_Features.push_back(Permutations[i].Features);
+    }
+
+    // The PSOs don't move once their compiles have started
+    m_PSOs.resize(m_Features.size());
+
+    for (size_t i = 0, n = 0; i < Count; ++i)
+    {
+        if ((Permutations[i].Features & FixedMask) != FixedFeatures)
+            continue;
+
+        ComputePSO& PSO = m_PSOs[n++];
+        PSO.SetRootSignature(RootSig);
+        PSO.SetComputeShader(Permutations[i].Bytecode, Permutations[i].Size);
+        PSO.FinalizeAsync();
+    }
+}
+
+const ComputePSO& ComputePSOPermutations::Get( uint32_t Features ) const
+{
+    for (size_t i = 0; i < m_Features.size(); ++i)
+    {
+        if (m_Features[i] == Features)
+            return m_PSOs[i];
+    }
+
+    ERROR("Shader permutation 0x%X wasn't created.  Is its mask listed in the project, or fixed to other features?", Features);
+    return m_PSOs[0];
+}
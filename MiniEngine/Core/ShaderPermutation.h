@@ -0,0 +1,53 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Developed by Minigraph
+//
+
+#pragma once
+
+#include "PipelineState.h"
+#include "Shaders/PermutationFeatures.hlsli"
+#include <vector>
+
+class RootSignature;
+
+// One compiled permutation of a shader.  CompiledShaders/<Name>_Permutations.h lists every permutation of a
+// ShaderPermutation item in a g_p<Name>_Permutations table of these.
+struct ShaderPermutation
+{
+    uint32_t Features;          // PERMUTATION_* bits
+    const BYTE* Bytecode;
+    size_t Size;
+};
+
+// The compute PSOs of a permuted shader, selected by feature mask.  Features fixed for the device, such as
+// typed UAV load support, should be passed to Create() so that permutations that can never be selected aren't
+// compiled.
+class ComputePSOPermutations
+{
+public:
+    // Compile every permutation whose FixedMask bits are FixedFeatures, in parallel on the PSO workers.  Each
+    // goes through the PSO cache, like any other PSO.
+    void Create( const RootSignature& RootSig, const ShaderPermutation* Permutations, size_t Count,
+        uint32_t FixedMask = 0, uint32_t FixedFeatures = 0 );
+
+    template <size_t Count>
+    void Create( const RootSignature& RootSig, const ShaderPermutation (&Permutations)[Count],
+        uint32_t FixedMask = 0, uint32_t FixedFeatures = 0 )
+    {
+        Create(RootSig, Permutations, Count, FixedMask, FixedFeatures);
+    }
+
+    // The PSO for exactly these features.  They must be one of the masks compiled for the shader.
+    const ComputePSO& Get( uint32_t Features ) const;
+
+private:
+    std::vector<uint32_t> m_Features;
+    std::vector<ComputePSO> m_PSOs;
+};
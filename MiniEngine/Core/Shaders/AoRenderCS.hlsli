@@ -99,6 +99,15 @@ float TestSamples( uint centerIdx, uint x, uint y, float invDepth, float invThic
     }
 }
 
+// Temporal accumulation zeroes the weights of the samples it skips this frame.  The weights are uniform across
+// the dispatch, so the branch is coherent.
+void AccumulateSamples( inout float ao, float weight, uint centerIdx, uint x, uint y, float invDepth, float invThickness )
+{
+    [branch]
+    if (weight != 0.0)
+        ao += weight * TestSamples(centerIdx, x, y, invDepth, invThickness);
+}
+
 [RootSignature(SSAO_RootSig)]
 #if WIDE_SAMPLING
 [numthreads( 16, 16, 1 )]
@@ -154,13 +163,13 @@ void main( uint3 Gid : SV_GroupID, uint GI : SV_GroupIndex, uint3 GTid : SV_Grou
     ao += gSampleWeightTable[2].z * TestSamples(thisIdx, 2, 4, invThisDepth, gInvThicknessTable[2].z);
 #else // SAMPLE_CHECKER
     // 36 samples:  sample every-other cell in a checker board pattern
-    ao += gSampleWeightTable[0].y * TestSamples(thisIdx, 2, 0, invThisDepth, gInvThicknessTable[0].y);
-    ao += gSampleWeightTable[0].w * TestSamples(thisIdx, 4, 0, invThisDepth, gInvThicknessTable[0].w);
-    ao += gSampleWeightTable[1].x * TestSamples(thisIdx, 1, 1, invThisDepth, gInvThicknessTable[1].x);
-    ao += gSampleWeightTable[2].x * TestSamples(thisIdx, 2, 2, invThisDepth, gInvThicknessTable[2].x);
-    ao += gSampleWeightTable[2].w * TestSamples(thisIdx, 3, 3, invThisDepth, gInvThicknessTable[2].w);
-    ao += gSampleWeightTable[1].z * TestSamples(thisIdx, 1, 3, invThisDepth, gInvThicknessTable[1].z);
-    ao += gSampleWeightTable[2].z * TestSamples(thisIdx, 2, 4, invThisDepth, gInvThicknessTable[2].z);
+    AccumulateSamples(ao, gSampleWeightTable[0].y, thisIdx, 2, 0, invThisDepth, gInvThicknessTable[0].y);
+    AccumulateSamples(ao, gSampleWeightTable[0].w, thisIdx, 4, 0, invThisDepth, gInvThicknessTable[0].w);
+    AccumulateSamples(ao, gSampleWeightTable[1].x, thisIdx, 1, 1, invThisDepth, gInvThicknessTable[1].x);
+    AccumulateSamples(ao, gSampleWeightTable[2].x, thisIdx, 2, 2, invThisDepth, gInvThicknessTable[2].x);
+    AccumulateSamples(ao, gSampleWeightTable[2].w, thisIdx, 3, 3, invThisDepth, gInvThicknessTable[2].w);
+    AccumulateSamples(ao, gSampleWeightTable[1].z, thisIdx, 1, 3, invThisDepth, gInvThicknessTable[1].z);
+    AccumulateSamples(ao, gSampleWeightTable[2].z, thisIdx, 2, 4, invThisDepth, gInvThicknessTable[2].z);
 #endif
 
 #ifdef INTERLEAVE_RESULT
@@ -0,0 +1,58 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Developed by Minigraph
+//
+
+#include "SSAORS.hlsli"
+#include "PixelPacking_Velocity.hlsli"
+
+// Blends this frame's AO, which only tested a subset of the samples, with last frame's result.  The history is
+// reprojected with the camera velocity and dropped where last frame's depth belongs to a different surface.
+
+Texture2D<float> CurrentAO : register(t0);
+Texture2D<float> HistoryAO : register(t1);
+Texture2D<packed_velocity_t> VelocityBuffer : register(t2);
+Texture2D<float> CurDepth : register(t3);
+Texture2D<float> PrevDepth : register(t4);
+RWTexture2D<float> OutAO : register(u0);
+RWTexture2D<float> OutHistory : register(u1);
+SamplerState LinearSampler : register(s0);
+
+cbuffer CB0 : register(b0)
+{
+    float2 RcpBufferDim;    // 1 / width, 1 / height
+    float HistoryWeight;    // 0 when the history is stale
+    float DepthTolerance;   // Largest depth difference relative to depth that still counts as the same surface
+}
+
+[RootSignature(SSAO_RootSig)]
+[numthreads( 8, 8, 1 )]
+void main( uint3 DTid : SV_DispatchThreadID )
+{
+    uint2 st = DTid.xy;
+    float AO = CurrentAO[st];
+
+    // Camera velocity is relative to the linear depth buffer, so Z is the change in linear depth
+    float3 Velocity = UnpackVelocity(VelocityBuffer[st]);
+    float2 PrevUV = (st + 0.5 + Velocity.xy) * RcpBufferDim;
+    float ExpectedDepth = CurDepth[st] + Velocity.z;
+
+    // The history is only as good as the closest of the four texels it filters
+    float4 DepthError = abs(PrevDepth.Gather(LinearSampler, PrevUV) - ExpectedDepth);
+    float MinError = min(min(DepthError.x, DepthError.y), min(DepthError.z, DepthError.w));
+
+    float Weight = HistoryWeight;
+    if (any(PrevUV != saturate(PrevUV)) || MinError > DepthTolerance * ExpectedDepth)
+        Weight = 0.0;
+
+    AO = lerp(AO, HistoryAO.SampleLevel(LinearSampler, PrevUV, 0), Weight);
+
+    OutAO[st] = AO;
+    OutHistory[st] = AO;
+}
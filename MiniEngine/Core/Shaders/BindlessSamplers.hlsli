@@ -0,0 +1,38 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Developed by Minigraph
+//
+// Access to the bindless sampler heap (see SamplerManager.h).  Add BINDLESS_SAMPLER_TABLE to the root
+// signature, bind it with SamplerManager::SetBindlessTable(), and select samplers with the indices returned by
+// SamplerDesc::GetBindlessIndex().  Requires resource binding tier 2.
+//
+
+#ifndef __BINDLESS_SAMPLERS_HLSLI__
+#define __BINDLESS_SAMPLERS_HLSLI__
+
+// Both ranges cover the whole heap, so every sampler can be used either way
+#define BINDLESS_SAMPLER_TABLE \
+    "DescriptorTable(Sampler(s0, space = 1, numDescriptors = 2048)," \
+                    "Sampler(s0, space = 2, numDescriptors = 2048, offset = 0))"
+
+SamplerState g_BindlessSamplers[2048] : register(s0, space1);
+SamplerComparisonState g_BindlessComparisonSamplers[2048] : register(s0, space2);
+
+// Use NonUniformResourceIndex() around the index when it can differ between lanes of a wave
+SamplerState GetBindlessSampler( uint Index )
+{
+    return g_BindlessSamplers[Index];
+}
+
+SamplerComparisonState GetBindlessComparisonSampler( uint Index )
+{
+    return g_BindlessComparisonSamplers[Index];
+}
+
+#endif // __BINDLESS_SAMPLERS_HLSLI__
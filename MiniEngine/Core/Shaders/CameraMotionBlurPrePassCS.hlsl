@@ -13,6 +13,7 @@
 
 #include "MotionBlurRS.hlsli"
 #include "PixelPacking_Velocity.hlsli"
+#include "MotionBlurTileQueue.hlsli"
 
 // We can use the original depth buffer or a linearized one.  In this case, we use linear Z because
 // we have discarded the 32-bit depth buffer but still retain a 16-bit linear buffer (previously
@@ -31,7 +32,7 @@ cbuffer CB1 : register(b1)
     matrix CurToPrevXForm;
 }
 
-float4 GetSampleData( uint2 st )
+float4 GetSampleData( uint2 st, inout float MaxSpeed )
 {
     float2 CurPixel = st + 0.5;
     float Depth = DepthBuffer[st];
@@ -50,7 +51,11 @@ float4 GetSampleData( uint2 st )
 
     float3 Velocity = PrevHPos.xyz - float3(CurPixel, Depth);
 
-    VelocityBuffer[st] = PackVelocity(Velocity);
+    packed_velocity_t PackedVelocity = PackVelocity(Velocity);
+    VelocityBuffer[st] = PackedVelocity;
+
+    // Classify with the velocity the final pass will read back
+    MaxSpeed = max(MaxSpeed, length(UnpackVelocity(PackedVelocity).xy));
 
     // Clamp speed at 4 pixels and normalize it.
     return float4(ColorBuffer[st], 1.0) * saturate(length(Velocity.xy) / 4);
@@ -61,12 +66,15 @@ float4 GetSampleData( uint2 st )
 void main( uint3 Gid : SV_GroupID, uint GI : SV_GroupIndex, uint3 GTid : SV_GroupThreadID, uint3 DTid : SV_DispatchThreadID )
 {
     uint2 corner = DTid.xy << 1;
-    float4 sample0 = GetSampleData( corner + uint2(0, 0) );
-    float4 sample1 = GetSampleData( corner + uint2(1, 0) );
-    float4 sample2 = GetSampleData( corner + uint2(0, 1) );
-    float4 sample3 = GetSampleData( corner + uint2(1, 1) );
+    float MaxSpeed = 0.0;
+    float4 sample0 = GetSampleData( corner + uint2(0, 0), MaxSpeed );
+    float4 sample1 = GetSampleData( corner + uint2(1, 0), MaxSpeed );
+    float4 sample2 = GetSampleData( corner + uint2(0, 1), MaxSpeed );
+    float4 sample3 = GetSampleData( corner + uint2(1, 1), MaxSpeed );
 
     float combinedMotionWeight = sample0.a + sample1.a + sample2.a + sample3.a;
     PrepBuffer[DTid.xy] = floor(0.25 * combinedMotionWeight * 3.0) / 3.0 * float4(
         (sample0.rgb + sample1.rgb + sample2.rgb + sample3.rgb) / combinedMotionWeight, 1.0 );
+
+    QueueMovingTile( MaxSpeed, GI, Gid.xy );
 }
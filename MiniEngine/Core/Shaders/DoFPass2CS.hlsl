@@ -13,6 +13,11 @@
 
 #include "DoFCommon.hlsli"
 
+// Tiles are queued by how many rings they need, so the variants for the smaller buckets compile the outer rings out
+#ifndef MAX_RINGS
+#define MAX_RINGS 3
+#endif
+
 Texture2D<float3> ColorBuffer : register(t0);
 Texture2D<float3> PresortBuffer : register(t1);
 Texture2D<float3> TileClass : register(t2);
@@ -120,10 +125,10 @@ void main( uint3 Gid : SV_GroupID, uint3 GTid : SV_GroupThreadID )
 
     AccumulateOneRing(ldsIdx, Background, Foreground);
 
-    if (RingCount > 1.0)
+    if (MAX_RINGS > 1 && RingCount > 1.0)
         AccumulateTwoRings(ldsIdx, Background, Foreground);
 
-    if (RingCount > 2.0)
+    if (MAX_RINGS > 2 && RingCount > 2.0)
         AccumulateThreeRings(ldsIdx, Background, Foreground);
 
     Background.rgb /= (Background.a + 0.00001);
@@ -13,6 +13,11 @@
 
 #include "DoFCommon.hlsli"
 
+// Tiles are queued by how many rings they need, so the variants for the smaller buckets compile the outer rings out
+#ifndef MAX_RINGS
+#define MAX_RINGS 3
+#endif
+
 Texture2D<float3> ColorBuffer : register(t0);
 Texture2D<float3> TileClass : register(t2);
 StructuredBuffer<uint> WorkQueue : register(t3);
@@ -94,10 +99,10 @@ void main( uint3 Gid : SV_GroupID, uint3 GTid : SV_GroupThreadID )
 
     Foreground += saturate(RingCount) * AccumulateOneRing(ldsIdx);
 
-    if (RingCount > 1.0)
+    if (MAX_RINGS > 1 && RingCount > 1.0)
         Foreground += saturate(RingCount - 1.0) * AccumulateTwoRings(ldsIdx);
 
-    if (RingCount > 2.0)
+    if (MAX_RINGS > 2 && RingCount > 2.0)
         Foreground += saturate(RingCount - 2.0) * AccumulateThreeRings(ldsIdx);
 
     OutputColor[st] = Foreground.rgb / Foreground.w;
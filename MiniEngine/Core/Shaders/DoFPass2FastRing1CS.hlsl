@@ -9,6 +9,7 @@
 // Developed by Minigraph
 //
 // Author:  James Stanard 
+//
 
-#define LOW_RESOLUTION
-#include "ParticleTileRenderCS.hlsl"
+#define MAX_RINGS 1
+#include "DoFPass2FastCS.hlsl"
@@ -9,6 +9,7 @@
 // Developed by Minigraph
 //
 // Author:  James Stanard 
+//
 
-#define DYNAMIC_RESOLUTION
-#include "ParticleTileRenderCS.hlsl"
+#define MAX_RINGS 2
+#include "DoFPass2FastCS.hlsl"
@@ -9,6 +9,7 @@
 // Developed by Minigraph
 //
 // Author:  James Stanard 
+//
 
-#define DISABLE_DEPTH_TESTS
-#include "ParticleTileRenderCS.hlsl"
+#define MAX_RINGS 1
+#include "DoFPass2CS.hlsl"
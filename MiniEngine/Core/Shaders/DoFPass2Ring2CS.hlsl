@@ -9,6 +9,7 @@
 // Developed by Minigraph
 //
 // Author:  James Stanard 
+//
 
-#define SUPPORT_TYPED_UAV_LOADS 1
-#include "ParticleTileRenderCS.hlsl"
+#define MAX_RINGS 2
+#include "DoFPass2CS.hlsl"
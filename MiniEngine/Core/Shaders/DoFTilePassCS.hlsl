@@ -15,13 +15,42 @@
 
 Texture2D<float3> InputClass : register(t0);
 RWTexture2D<float3> TileClass : register(u0);
-RWStructuredBuffer<uint> WorkQueue : register(u1);
-RWStructuredBuffer<uint> FastQueue : register(u2);
+
+// One queue per number of rings the main pass has to gather, so that each can be dispatched with a shader that
+// does exactly that much work
+RWStructuredBuffer<uint> WorkQueue1 : register(u1);
+RWStructuredBuffer<uint> WorkQueue2 : register(u2);
+RWStructuredBuffer<uint> WorkQueue3 : register(u3);
+RWStructuredBuffer<uint> FastQueue1 : register(u4);
+RWStructuredBuffer<uint> FastQueue2 : register(u5);
+RWStructuredBuffer<uint> FastQueue3 : register(u6);
 
 groupshared float gs_MaxCoC[100];
 groupshared float gs_MinDepth[100];
 groupshared float gs_MaxDepth[100];
 
+void QueueTile( uint TileCoord, float MaxCoC, bool NeedsFullPass )
+{
+    if (NeedsFullPass)
+    {
+        if (MaxCoC > RING3_THRESHOLD)
+            WorkQueue3[WorkQueue3.IncrementCounter()] = TileCoord;
+        else if (MaxCoC > RING2_THRESHOLD)
+            WorkQueue2[WorkQueue2.IncrementCounter()] = TileCoord;
+        else
+            WorkQueue1[WorkQueue1.IncrementCounter()] = TileCoord;
+    }
+    else
+    {
+        if (MaxCoC > RING3_THRESHOLD)
+            FastQueue3[FastQueue3.IncrementCounter()] = TileCoord;
+        else if (MaxCoC > RING2_THRESHOLD)
+            FastQueue2[FastQueue2.IncrementCounter()] = TileCoord;
+        else
+            FastQueue1[FastQueue1.IncrementCounter()] = TileCoord;
+    }
+}
+
 [RootSignature(DoF_RootSig)]
 [numthreads( 8, 8, 1 )]
 void main( uint3 Gid : SV_GroupID, uint GI : SV_GroupIndex, uint3 GTid : SV_GroupThreadID, uint3 DTid : SV_DispatchThreadID )
@@ -76,10 +105,5 @@ void main( uint3 Gid : SV_GroupID, uint GI : SV_GroupIndex, uint3 GTid : SV_Grou
     TileClass[DTid.xy] = float3(FinalMaxCoC, FinalMinDepth, FgAlphaNormalizationTerm);
 
     if (FinalMaxCoC >= 1.0)
-    {
-        if (FinalMaxDepth - FinalMinDepth > ForegroundRange)
-            WorkQueue[WorkQueue.IncrementCounter()] = DTid.x | DTid.y << 16;
-        else
-            FastQueue[FastQueue.IncrementCounter()] = DTid.x | DTid.y << 16;
-    }
+        QueueTile(DTid.x | DTid.y << 16, FinalMaxCoC, FinalMaxDepth - FinalMinDepth > ForegroundRange);
 }
@@ -13,6 +13,7 @@
 // The CS for downsampling 16x16 blocks of pixels down to 8x8, 4x4, 2x2, and 1x1 blocks.
 
 #include "PostEffectsRS.hlsli"
+#include "WaveUtility.hlsli"
 
 Texture2D<float3> BloomBuf : register( t0 );
 RWTexture2D<float3> Result1 : register( u0 );
@@ -30,8 +31,45 @@ groupshared float3 g_Tile[64];    // 8x8 input pixels
 
 [RootSignature(PostEffects_RootSig)]
 [numthreads( 8, 8, 1 )]
-void main( uint GI : SV_GroupIndex, uint3 DTid : SV_DispatchThreadID )
+void main( uint GI : SV_GroupIndex, uint3 Gid : SV_GroupID, uint3 DTid : SV_DispatchThreadID )
 {
+#ifdef _WAVE_OP
+    // Threads are laid out in Morton order so that each 2x2 quad is reduced within a wave.  Only the sixteen quad
+    // averages go through group shared memory.
+    uint2 Pixel = Gid.xy * 8 + MortonDecode8x8(GI);
+
+    // Downsample and store the 8x8 block
+    float2 centerUV = (float2(Pixel) * 2.0f + 1.0f) * g_inverseDimensions;
+    float3 avgPixel = BloomBuf.SampleLevel(BiLinearClamp, centerUV, 0.0f);
+    Result1[Pixel] = avgPixel;
+
+    // Downsample and store the 4x4 block
+    avgPixel = 0.25f * WaveClusterSum(avgPixel, 4);
+    if ((GI & 3) == 0)
+    {
+        g_Tile[GI >> 2] = avgPixel;
+        Result2[Pixel >> 1] = avgPixel;
+    }
+
+    GroupMemoryBarrierWithGroupSync();
+
+    // Downsample and store the 2x2 block
+    if ((GI & 15) == 0)
+    {
+        uint Quad = GI >> 2;
+        avgPixel = 0.25f * (g_Tile[Quad] + g_Tile[Quad + 1] + g_Tile[Quad + 2] + g_Tile[Quad + 3]);
+        Result3[Pixel >> 2] = avgPixel;
+    }
+
+    // Downsample and store the 1x1 block
+    if (GI == 0)
+    {
+        avgPixel = 0.0f;
+        for (uint i = 0; i < 16; ++i)
+            avgPixel += g_Tile[i];
+        Result4[Gid.xy] = 0.0625f * avgPixel;
+    }
+#else
     // You can tell if both x and y are divisible by a power of two with this value
     uint parity = DTid.x | DTid.y;
 
@@ -69,4 +107,5 @@ void main( uint GI : SV_GroupIndex, uint3 DTid : SV_DispatchThreadID )
         avgPixel = 0.25f * (avgPixel + g_Tile[GI+4] + g_Tile[GI+32] + g_Tile[GI+36]);
         Result4[DTid.xy >> 3] = avgPixel;
     }
+#endif
 }
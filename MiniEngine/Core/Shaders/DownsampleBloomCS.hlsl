@@ -13,6 +13,7 @@
 // The CS for downsampling 16x16 blocks of pixels down to 4x4 and 1x1 blocks.
 
 #include "PostEffectsRS.hlsli"
+#include "WaveUtility.hlsli"
 
 Texture2D<float3> BloomBuf : register( t0 );
 RWTexture2D<float3> Result1 : register( u0 );
@@ -28,8 +29,32 @@ groupshared float3 g_Tile[64];    // 8x8 input pixels
 
 [RootSignature(PostEffects_RootSig)]
 [numthreads( 8, 8, 1 )]
-void main( uint GI : SV_GroupIndex, uint3 Did : SV_DispatchThreadID )
+void main( uint GI : SV_GroupIndex, uint3 Gid : SV_GroupID, uint3 Did : SV_DispatchThreadID )
 {
+#ifdef _WAVE_OP
+    // Threads are laid out in Morton order so that each 2x2 quad is reduced within a wave.  Only the sixteen quad
+    // averages go through group shared memory.
+    uint2 Pixel = Gid.xy * 8 + MortonDecode8x8(GI);
+
+    float2 centerUV = (float2(Pixel) * 2.0f + 1.0f) * g_inverseDimensions;
+    float3 avgPixel = 0.25f * WaveClusterSum(BloomBuf.SampleLevel(BiLinearClamp, centerUV, 0.0f), 4);
+
+    if ((GI & 3) == 0)
+    {
+        g_Tile[GI >> 2] = avgPixel;
+        Result1[Pixel >> 1] = avgPixel;
+    }
+
+    GroupMemoryBarrierWithGroupSync();
+
+    if (GI == 0)
+    {
+        avgPixel = 0.0f;
+        for (uint i = 0; i < 16; ++i)
+            avgPixel += g_Tile[i];
+        Result2[Gid.xy] = 0.0625f * avgPixel;
+    }
+#else
     // You can tell if both x and y are divisible by a power of two with this value
     uint parity = Did.x | Did.y;
 
@@ -62,4 +87,5 @@ void main( uint GI : SV_GroupIndex, uint3 Did : SV_DispatchThreadID )
         avgPixel = 0.0625f * (avgPixel + g_Tile[GI+4] + g_Tile[GI+32] + g_Tile[GI+36]);
         Result2[Did.xy >> 3] = avgPixel;
     }
+#endif
 }
@@ -19,7 +19,12 @@
 SamplerState BiLinearClamp : register( s0 );
 Texture2D<float3> SourceTex : register( t0 );
 StructuredBuffer<float> Exposure : register( t1 );
+#ifdef BUILD_HISTOGRAM
+#include "LumaHistogram.hlsli"
+RWByteAddressBuffer Histogram : register( u0 );
+#else
 RWTexture2D<uint> LumaResult : register( u0 );
+#endif
 
 cbuffer cb0
 {
@@ -28,8 +33,12 @@ cbuffer cb0
 
 [RootSignature(PostEffects_RootSig)]
 [numthreads( 8, 8, 1 )]
-void main( uint3 DTid : SV_DispatchThreadID )
+void main( uint GI : SV_GroupIndex, uint3 DTid : SV_DispatchThreadID )
 {
+#ifdef BUILD_HISTOGRAM
+    ClearGroupHistogram(GI);
+#endif
+
     // We need the scale factor and the size of one pixel so that our four samples are right in the middle
     // of the quadrant they are covering.
     float2 uv = DTid.xy * g_inverseOutputSize;
@@ -45,15 +54,19 @@ void main( uint3 DTid : SV_DispatchThreadID )
     float luma = RGBToLuminance(color1 + color2 + color3 + color4) * 0.25;
 
     // Prevent log(0) and put only pure black pixels in Histogram[0]
-    if (luma == 0.0)
-    {
-        LumaResult[DTid.xy] = 0;
-    }
-    else
+    uint QuantizedLogLuma = 0;
+    if (luma != 0.0)
     {
         const float MinLog = Exposure[4];
         const float RcpLogRange = Exposure[7];
         float logLuma = saturate((log2(luma) - MinLog) * RcpLogRange);    // Rescale to [0.0, 1.0]
-        LumaResult[DTid.xy] = logLuma * 254.0 + 1.0;                    // Rescale to [1, 255]
+        QuantizedLogLuma = logLuma * 254.0 + 1.0;                        // Rescale to [1, 255]
     }
+
+#ifdef BUILD_HISTOGRAM
+    AddToGroupHistogram(QuantizedLogLuma);
+    FlushGroupHistogram(GI, Histogram);
+#else
+    LumaResult[DTid.xy] = QuantizedLogLuma;
+#endif
 }
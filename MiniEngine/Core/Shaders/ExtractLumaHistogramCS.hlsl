@@ -8,8 +8,7 @@
 //
 // Developed by Minigraph
 //
-// Author:  James Stanard 
+// Same as ExtractLumaCS, but bins luminance straight into the histogram.
 
-#define DYNAMIC_RESOLUTION
-#define DISABLE_DEPTH_TESTS
-#include "ParticleTileRenderCS.hlsl"
+#define BUILD_HISTOGRAM
+#include "ExtractLumaCS.hlsl"
@@ -83,6 +83,11 @@ groupshared float gs_LumaCache[ROW_WIDTH * ROW_WIDTH];
     RWTexture2D<float> Luma : register(u3);
 #endif
 
+// Only the tiles that FXAATileClassifyCS found to have some contrast, one per group: x | y << 16
+#ifdef USE_TILE_QUEUE
+    StructuredBuffer<uint> TileQueue : register(t2);
+#endif
+
 //
 // Helper functions
 //
@@ -96,7 +101,12 @@ float RGBToLogLuminance( float3 LinearRGB )
 [numthreads( 8, 8, 1 )]
 void main( uint3 Gid : SV_GroupID, uint GI : SV_GroupIndex, uint3 GTid : SV_GroupThreadID, uint3 DTid : SV_DispatchThreadID )
 {
+#ifdef USE_TILE_QUEUE
+    uint PackedTile = TileQueue[Gid.x];
+    uint2 PixelCoord = StartPixel + uint2(PackedTile & 0xFFFF, PackedTile >> 16) * 8 + GTid.xy;
+#else
     uint2 PixelCoord = DTid.xy + StartPixel;
+#endif
 
 #ifdef USE_LUMA_INPUT_BUFFER
     // Load 4 lumas per thread into LDS (but only those needed to fill our pixel cache)
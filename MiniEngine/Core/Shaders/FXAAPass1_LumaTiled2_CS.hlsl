@@ -8,8 +8,8 @@
 //
 // Developed by Minigraph
 //
-// Author:  James Stanard 
 
-#define LOW_RESOLUTION
+#define USE_LUMA_INPUT_BUFFER
+#define USE_TILE_QUEUE
 #define SUPPORT_TYPED_UAV_LOADS 1
-#include "ParticleTileRenderCS.hlsl"
+#include "FXAAPass1CS.hlsli"
@@ -13,7 +13,7 @@
 
 #define FXAA_RootSig \
     "RootFlags(0), " \
-    "RootConstants(b0, num32BitConstants=7), " \
+    "RootConstants(b0, num32BitConstants=8), " \
     "DescriptorTable(UAV(u0, numDescriptors = 5))," \
     "DescriptorTable(SRV(t0, numDescriptors = 6))," \
     "StaticSampler(s0," \
@@ -29,4 +29,5 @@ cbuffer CB0 : register(b0)
     float SubpixelRemoval;        // default = 0.75, lower blurs less
     uint LastQueueIndex;
     uint2 StartPixel;
+    uint TileCount;             // Tiles of 8x8 pixels in the current block: x | y << 16
 }
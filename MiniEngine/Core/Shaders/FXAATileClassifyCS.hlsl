@@ -0,0 +1,48 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Developed by Minigraph
+//
+// Used with FXAA to find the 8x8 tiles of the pre-computed luma buffer that pass 1 needs to look at.  A pixel
+// can only pass the contrast threshold test if the luma range of its tile, including the one pixel boundary that
+// pass 1 caches, also does.  Each thread classifies a whole tile, so flat regions cost a few gathers per tile.
+//
+
+#include "FXAARootSignature.hlsli"
+
+RWStructuredBuffer<uint> TileQueue : register(u0);
+Texture2D<float> Luma : register(t1);
+SamplerState LinearSampler : register(s0);
+
+[RootSignature(FXAA_RootSig)]
+[numthreads( 8, 8, 1 )]
+void main( uint3 DTid : SV_DispatchThreadID )
+{
+    if (DTid.x >= (TileCount & 0xFFFF) || DTid.y >= (TileCount >> 16))
+        return;
+
+    // Gathering at the corner between two texels returns both of them, so this starts one pixel up and to the left
+    float2 TileUL = StartPixel + DTid.xy * 8;
+    float rangeMax = 0.0;
+    float rangeMin = 1e10;
+
+    [unroll]
+    for (uint y = 0; y < 10; y += 2)
+    {
+        [unroll]
+        for (uint x = 0; x < 10; x += 2)
+        {
+            float4 Luma4 = Luma.Gather(LinearSampler, (TileUL + float2(x, y)) * RcpTextureSize);
+            rangeMax = max(rangeMax, max(max(Luma4.x, Luma4.y), max(Luma4.z, Luma4.w)));
+            rangeMin = min(rangeMin, min(min(Luma4.x, Luma4.y), min(Luma4.z, Luma4.w)));
+        }
+    }
+
+    if (rangeMax - rangeMin >= ContrastThreshold)
+        TileQueue[TileQueue.IncrementCounter()] = DTid.x | DTid.y << 16;
+}
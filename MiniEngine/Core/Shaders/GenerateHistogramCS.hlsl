@@ -16,6 +16,7 @@
 // where the exposure would range from 2^-4 up to 2^4.
 
 #include "PostEffectsRS.hlsli"
+#include "WaveUtility.hlsli"
 
 Texture2D<uint> LumaBuf : register( t0 );
 RWByteAddressBuffer Histogram : register( u0 );
@@ -34,7 +35,12 @@ void main( uint GI : SV_GroupIndex, uint3 DTid : SV_DispatchThreadID )
     for (uint TopY = 0; TopY < 384; TopY += 16)
     {
         uint QuantizedLogLuma = LumaBuf[DTid.xy + uint2(0, TopY)];
-        InterlockedAdd( g_TileHistogram[QuantizedLogLuma], 1 );
+
+        // Neighboring pixels tend to share a bin, so lanes with the same bin add to it once
+        bool IsLeader;
+        uint BinCount = WaveMatchCount(QuantizedLogLuma, IsLeader);
+        if (IsLeader)
+            InterlockedAdd( g_TileHistogram[QuantizedLogLuma], BinCount );
     }
 
     GroupMemoryBarrierWithGroupSync();
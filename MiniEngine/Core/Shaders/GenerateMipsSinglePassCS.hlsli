@@ -0,0 +1,246 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Developed by Minigraph
+//
+// Generates up to twelve mips of a power-of-two texture with one dispatch.  Each group reduces a 64x64 tile of
+// mip 0 down to one texel of mip 6 and stores it in a scratch buffer.  The last group to finish, found with a
+// global atomic counter, then reduces the (at most 64x64) mip 6 down to mip 12.  Within a group, threads are laid
+// out in Morton order so that each level only combines neighboring threads, which wave operations can do without
+// going through LDS.
+//
+// Only in-range texels are guaranteed to be correct, so every generated level must still be exactly half the
+// size of the one above it in both dimensions.  The CPU falls back to the multi-pass shaders for the rest.
+//
+
+#define RootSig \
+    "RootFlags(0), " \
+    "RootConstants(b0, num32BitConstants = 4), " \
+    "DescriptorTable(SRV(t0, numDescriptors = 1))," \
+    "DescriptorTable(UAV(u0, numDescriptors = 12))," \
+    "DescriptorTable(UAV(u12, numDescriptors = 2))," \
+    "StaticSampler(s0," \
+        "addressU = TEXTURE_ADDRESS_CLAMP," \
+        "addressV = TEXTURE_ADDRESS_CLAMP," \
+        "addressW = TEXTURE_ADDRESS_CLAMP," \
+        "filter = FILTER_MIN_MAG_MIP_LINEAR)"
+
+RWTexture2D<float4> OutMip1 : register(u0);
+RWTexture2D<float4> OutMip2 : register(u1);
+RWTexture2D<float4> OutMip3 : register(u2);
+RWTexture2D<float4> OutMip4 : register(u3);
+RWTexture2D<float4> OutMip5 : register(u4);
+RWTexture2D<float4> OutMip6 : register(u5);
+RWTexture2D<float4> OutMip7 : register(u6);
+RWTexture2D<float4> OutMip8 : register(u7);
+RWTexture2D<float4> OutMip9 : register(u8);
+RWTexture2D<float4> OutMip10 : register(u9);
+RWTexture2D<float4> OutMip11 : register(u10);
+RWTexture2D<float4> OutMip12 : register(u11);
+
+// Mip 6 in linear color, 64 texels per row.  Other groups write it, so it has to bypass non-coherent caches.
+globallycoherent RWStructuredBuffer<float4> Mip6Scratch : register(u12);
+// Counts the groups that have finished mip 6.  The last group resets it for the next dispatch.
+globallycoherent RWByteAddressBuffer GroupCounter : register(u13);
+
+Texture2D<float4> SrcMip : register(t0);
+SamplerState BilinearClamp : register(s0);
+
+cbuffer CB0 : register(b0)
+{
+    uint NumMipLevels;    // Number of OutMips to write: [1, 12]
+    uint NumGroups;       // Number of groups in the dispatch
+    float2 TexelSize;     // 1.0 / OutMip1.Dimensions
+}
+
+// The reason for separating channels is to reduce bank conflicts in the
+// local data memory controller.  A large stride will cause more threads
+// to collide on the same memory bank.
+groupshared float gs_R[256];
+groupshared float gs_G[256];
+groupshared float gs_B[256];
+groupshared float gs_A[256];
+groupshared uint gs_IsLastGroup;
+
+void StoreColor( uint Index, float4 Color )
+{
+    gs_R[Index] = Color.r;
+    gs_G[Index] = Color.g;
+    gs_B[Index] = Color.b;
+    gs_A[Index] = Color.a;
+}
+
+float4 LoadColor( uint Index )
+{
+    return float4( gs_R[Index], gs_G[Index], gs_B[Index], gs_A[Index]);
+}
+
+float3 ApplySRGBCurve(float3 x)
+{
+    // This is cheaper but nearly equivalent to the exact sRGB curve
+    return x < 0.0031308 ? 12.92 * x : 1.13005 * sqrt(abs(x - 0.00228)) - 0.13448 * x + 0.005719;
+}
+
+float4 PackColor(float4 Linear)
+{
+#ifdef CONVERT_TO_SRGB
+    return float4(ApplySRGBCurve(Linear.rgb), Linear.a);
+#else
+    return Linear;
+#endif
+}
+
+void WriteMip( uint Mip, uint2 Coord, float4 Color )
+{
+    Color = PackColor(Color);
+
+    switch (Mip)
+    {
+    case 1: OutMip1[Coord] = Color; break;
+    case 2: OutMip2[Coord] = Color; break;
+    case 3: OutMip3[Coord] = Color; break;
+    case 4: OutMip4[Coord] = Color; break;
+    case 5: OutMip5[Coord] = Color; break;
+    case 6: OutMip6[Coord] = Color; break;
+    case 7: OutMip7[Coord] = Color; break;
+    case 8: OutMip8[Coord] = Color; break;
+    case 9: OutMip9[Coord] = Color; break;
+    case 10: OutMip10[Coord] = Color; break;
+    case 11: OutMip11[Coord] = Color; break;
+    case 12: OutMip12[Coord] = Color; break;
+    }
+}
+
+// Thread i of the group holds texel MortonDecode16x16(i) of a 16x16 block, so each aligned 2x2, 4x4 and 8x8
+// block of texels belongs to 4, 16 and 64 consecutive threads.
+uint2 MortonDecode16x16( uint i )
+{
+    uint2 Coord = uint2(i, i >> 1) & 0x55;
+    Coord = (Coord | (Coord >> 1)) & 0x33;
+    return (Coord | (Coord >> 2)) & 0x0F;
+}
+
+// Average the four threads whose indices only differ in the two bits above Stride - 1.  Every one of them receives
+// the average.  Must be called by the whole group.
+float4 ReduceQuad( float4 Color, uint GI, uint Stride )
+{
+#ifdef _WAVE_OP
+    // This relies on lanes holding consecutive group indices, which is how current hardware assigns them.
+    if (Stride * 4 <= WaveGetLaneCount())
+    {
+        uint Lane = WaveGetLaneIndex();
+        return 0.25 * (Color + WaveReadLaneAt(Color, Lane ^ Stride) +
+            WaveReadLaneAt(Color, Lane ^ (Stride * 2)) + WaveReadLaneAt(Color, Lane ^ (Stride * 3)));
+    }
+#endif
+
+    GroupMemoryBarrierWithGroupSync();
+    StoreColor(GI, Color);
+    GroupMemoryBarrierWithGroupSync();
+
+    return 0.25 * (LoadColor(GI) + LoadColor(GI ^ Stride) + LoadColor(GI ^ (Stride * 2)) + LoadColor(GI ^ (Stride * 3)));
+}
+
+// Each thread holds one texel of a 16x16 block of TopMip that starts at BlockOrigin.  Writes the four levels
+// below it, down to the block's single texel, which is returned.
+float4 DownsampleBlock( float4 Color, uint GI, uint2 BlockOrigin, uint TopMip )
+{
+    uint2 Coord = BlockOrigin + MortonDecode16x16(GI);
+
+    [unroll]
+    for (uint Level = 1; Level <= 4; ++Level)
+    {
+        // A scalar (constant) branch can exit all threads coherently.
+        if (TopMip + Level > NumMipLevels)
+            break;
+
+        Color = ReduceQuad(Color, GI, 1 << (2 * (Level - 1)));
+
+        if ((GI & ((1 << (2 * Level)) - 1)) == 0)
+            WriteMip(TopMip + Level, Coord >> Level, Color);
+    }
+
+    return Color;
+}
+
+float4 LoadMip6( uint2 Coord )
+{
+    return Mip6Scratch[Coord.y * 64 + Coord.x];
+}
+
+[RootSignature(RootSig)]
+[numthreads( 256, 1, 1 )]
+void main( uint GI : SV_GroupIndex, uint3 Gid : SV_GroupID )
+{
+    // Every thread downsamples a 4x4 block of mip 0 to 2x2 texels of mip 1 and one texel of mip 2
+    uint2 Mip2Coord = Gid.xy * 16 + MortonDecode16x16(GI);
+    float4 Sum = 0.0;
+
+    [unroll]
+    for (uint i = 0; i < 4; ++i)
+    {
+        uint2 Mip1Coord = Mip2Coord * 2 + uint2(i & 1, i >> 1);
+        float4 Color = SrcMip.SampleLevel(BilinearClamp, TexelSize * (Mip1Coord + 0.5), 0);
+        WriteMip(1, Mip1Coord, Color);
+        Sum += Color;
+    }
+
+    if (NumMipLevels == 1)
+        return;
+
+    float4 Color = 0.25 * Sum;
+    WriteMip(2, Mip2Coord, Color);
+
+    // Mips 3 through 6 of this group's tile
+    Color = DownsampleBlock(Color, GI, Gid.xy * 16, 2);
+
+    if (NumMipLevels <= 6)
+        return;
+
+    // Publish this tile's mip 6 texel and find out whether every other group has done the same
+    if (GI == 0)
+    {
+        Mip6Scratch[Gid.y * 64 + Gid.x] = Color;
+        DeviceMemoryBarrier();
+
+        uint FinishedGroups;
+        GroupCounter.InterlockedAdd(0, 1, FinishedGroups);
+        gs_IsLastGroup = FinishedGroups == NumGroups - 1 ? 1 : 0;
+        if (gs_IsLastGroup)
+            GroupCounter.Store(0, 0);
+    }
+
+    GroupMemoryBarrierWithGroupSync();
+
+    if (gs_IsLastGroup == 0)
+        return;
+
+    // The last group downsamples mip 6 the same way the groups downsampled their tiles of mip 0
+    uint2 Mip8Coord = MortonDecode16x16(GI);
+    Sum = 0.0;
+
+    [unroll]
+    for (uint j = 0; j < 4; ++j)
+    {
+        uint2 Mip7Coord = Mip8Coord * 2 + uint2(j & 1, j >> 1);
+        uint2 Mip6Coord = Mip7Coord * 2;
+        Color = 0.25 * (LoadMip6(Mip6Coord) + LoadMip6(Mip6Coord + uint2(1, 0)) +
+            LoadMip6(Mip6Coord + uint2(0, 1)) + LoadMip6(Mip6Coord + uint2(1, 1)));
+        WriteMip(7, Mip7Coord, Color);
+        Sum += Color;
+    }
+
+    if (NumMipLevels == 7)
+        return;
+
+    Color = 0.25 * Sum;
+    WriteMip(8, Mip8Coord, Color);
+
+    // Mips 9 through 12
+    DownsampleBlock(Color, GI, uint2(0, 0), 8);
+}
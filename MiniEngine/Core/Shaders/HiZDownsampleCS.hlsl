@@ -0,0 +1,20 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Developed by Minigraph
+//
+
+RWTexture2D<float> SrcMin : register(u0);
+RWTexture2D<float> SrcMax : register(u1);
+
+float2 LoadSrc( uint2 st )
+{
+    return float2(SrcMin[st], SrcMax[st]);
+}
+
+#include "HiZDownsampleCS.hlsli"
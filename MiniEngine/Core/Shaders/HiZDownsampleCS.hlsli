@@ -0,0 +1,55 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Developed by Minigraph
+//
+// Reduces a 2:1 footprint of the source to one texel of each pyramid, keeping the smallest depth in DstMin
+// and the largest in DstMax.  The includer declares LoadSrc(), which returns the footprint texel's (min, max).
+//
+
+#define HiZ_RootSig \
+    "RootFlags(0), " \
+    "RootConstants(b0, num32BitConstants = 4), " \
+    "DescriptorTable(SRV(t0, numDescriptors = 1))," \
+    "DescriptorTable(UAV(u0, numDescriptors = 4))"
+
+cbuffer CB0 : register(b0)
+{
+    uint2 SrcSize;
+    uint2 DstSize;
+};
+
+RWTexture2D<float> DstMin : register(u2);
+RWTexture2D<float> DstMax : register(u3);
+
+[RootSignature(HiZ_RootSig)]
+[numthreads(8, 8, 1)]
+void main( uint3 DTid : SV_DispatchThreadID )
+{
+    if (any(DTid.xy >= DstSize))
+        return;
+
+    // With an odd source dimension, the last texel also covers the leftover row or column
+    uint2 First = DTid.xy * 2;
+    uint2 Last = DTid.xy == DstSize - 1 ? SrcSize - 1 : First + 1;
+
+    float MinZ = 1.0;
+    float MaxZ = 0.0;
+    for (uint y = First.y; y <= Last.y; ++y)
+    {
+        for (uint x = First.x; x <= Last.x; ++x)
+        {
+            float2 Z = LoadSrc(uint2(x, y));
+            MinZ = min(MinZ, Z.x);
+            MaxZ = max(MaxZ, Z.y);
+        }
+    }
+
+    DstMin[DTid.xy] = MinZ;
+    DstMax[DTid.xy] = MaxZ;
+}
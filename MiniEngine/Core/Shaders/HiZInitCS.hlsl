@@ -8,8 +8,12 @@
 //
 // Developed by Minigraph
 //
-// Author:  James Stanard 
 
-#define DISABLE_DEPTH_TESTS
-#define SUPPORT_TYPED_UAV_LOADS 1
-#include "ParticleTileRenderCS.hlsl"
+Texture2D<float> SrcDepth : register(t0);
+
+float2 LoadSrc( uint2 st )
+{
+    return SrcDepth[st].xx;
+}
+
+#include "HiZDownsampleCS.hlsli"
@@ -0,0 +1,30 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Developed by Minigraph
+//
+
+Texture2DMS<float> SrcDepth : register(t0);
+
+// The min/max resolve of the depth samples.  A pixel on an edge keeps both the farthest and the nearest
+// surface that covers part of it, so the pyramids stay conservative for either use.
+float2 LoadSrc( uint2 st )
+{
+    uint Width, Height, SampleCount;
+    SrcDepth.GetDimensions(Width, Height, SampleCount);
+
+    float2 Z = SrcDepth.Load(st, 0).xx;
+    for (uint i = 1; i < SampleCount; ++i)
+    {
+        float SampleZ = SrcDepth.Load(st, i);
+        Z = float2(min(Z.x, SampleZ), max(Z.y, SampleZ));
+    }
+    return Z;
+}
+
+#include "HiZDownsampleCS.hlsli"
@@ -0,0 +1,49 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Developed by Minigraph
+//
+// Lets a pass that computes quantized log luminance add it straight to the histogram, rather than writing a luma
+// buffer for GenerateHistogramCS to read back.  Each 8x8 group accumulates its pixels in group shared memory and
+// then adds the bins it touched to the global histogram.
+//
+
+#include "WaveUtility.hlsli"
+
+groupshared uint gs_GroupHistogram[256];
+
+// Must be called by the whole group
+void ClearGroupHistogram( uint GI )
+{
+    for (uint Bin = GI; Bin < 256; Bin += 64)
+        gs_GroupHistogram[Bin] = 0;
+
+    GroupMemoryBarrierWithGroupSync();
+}
+
+void AddToGroupHistogram( uint QuantizedLogLuma )
+{
+    // Neighboring pixels tend to share a bin, so lanes with the same bin add to it once
+    bool IsLeader;
+    uint BinCount = WaveMatchCount(QuantizedLogLuma, IsLeader);
+    if (IsLeader)
+        InterlockedAdd(gs_GroupHistogram[QuantizedLogLuma], BinCount);
+}
+
+// Must be called by the whole group
+void FlushGroupHistogram( uint GI, RWByteAddressBuffer Histogram )
+{
+    GroupMemoryBarrierWithGroupSync();
+
+    for (uint Bin = GI; Bin < 256; Bin += 64)
+    {
+        uint Count = gs_GroupHistogram[Bin];
+        if (Count > 0)
+            Histogram.InterlockedAdd(Bin * 4, Count);
+    }
+}
@@ -0,0 +1,51 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Developed by Minigraph
+//
+// Resolves MSAA color into the single-sample scene buffer that TAA reads.  Each sample is weighted by
+// 1 / (1 + exposed luminance), as a Reinhard tone map would scale it, which approximates averaging the samples
+// after tone mapping while leaving the result in linear HDR.
+//
+
+#include "ShaderUtility.hlsli"
+#include "MSAAResolveRS.hlsli"
+
+Texture2DMS<float3> SrcColor : register(t0);
+StructuredBuffer<float> Exposure : register(t1);
+RWTexture2D<float3> DstColor : register(u0);
+
+cbuffer CB0 : register(b0)
+{
+    uint2 DstSize;
+    uint SampleCount;
+    uint TonemapWeighted;
+}
+
+[RootSignature(MSAAResolve_RootSig)]
+[numthreads(8, 8, 1)]
+void main( uint3 DTid : SV_DispatchThreadID )
+{
+    if (any(DTid.xy >= DstSize))
+        return;
+
+    // Without weighting, this is the box filter of ResolveSubresource()
+    float LumaScale = TonemapWeighted ? Exposure[0] : 0.0;
+
+    float3 ColorSum = 0.0;
+    float WeightSum = 0.0;
+    for (uint i = 0; i < SampleCount; ++i)
+    {
+        float3 Color = SrcColor.Load(DTid.xy, i);
+        float Weight = rcp(1.0 + RGBToLuminance(Color) * LumaScale);
+        ColorSum += Color * Weight;
+        WeightSum += Weight;
+    }
+
+    DstColor[DTid.xy] = ColorSum / WeightSum;
+}
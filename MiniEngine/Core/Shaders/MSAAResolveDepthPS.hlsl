@@ -0,0 +1,33 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Developed by Minigraph
+//
+// Resolves MSAA depth to the nearest sample of each pixel.  Depth can't be written through a UAV, so unlike the
+// color resolve this is a full screen pass that exports SV_Depth.
+//
+
+#include "MSAAResolveRS.hlsli"
+
+Texture2DMS<float> SrcDepth : register(t0);
+
+[RootSignature(MSAAResolve_RootSig)]
+float main( float4 Position : SV_Position ) : SV_Depth
+{
+    uint2 st = uint2(Position.xy);
+
+    uint Width, Height, SampleCount;
+    SrcDepth.GetDimensions(Width, Height, SampleCount);
+
+    // Reversed Z, so the nearest sample is the largest
+    float Depth = SrcDepth.Load(st, 0);
+    for (uint i = 1; i < SampleCount; ++i)
+        Depth = max(Depth, SrcDepth.Load(st, i));
+
+    return Depth;
+}
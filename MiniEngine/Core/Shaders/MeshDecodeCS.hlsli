@@ -0,0 +1,179 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Developed by Minigraph
+//
+// Decodes one MeshCodec block (see Model/MeshCodec.cpp for the format) per group.  The output buffer must be
+// cleared first, because bytes are merged into it with atomic ORs: blocks are not aligned to 32-bit words,
+// and neighboring blocks may share one.
+//
+// Reads are kept within the block's payload and writes within its raw range, which the CPU has checked
+// against the buffers, so corrupt payloads decode to garbage but never touch memory outside them.
+//
+
+#define WAVE_UTILITY_GROUP_SIZE 256
+#include "WaveUtility.hlsli"
+
+struct Block
+{
+    uint RawOffset;
+    uint Count;
+    uint Stride;
+    uint PayloadBegin;
+    uint PayloadEnd;
+};
+
+StructuredBuffer<Block> Blocks : register(t0);
+ByteAddressBuffer Encoded : register(t1);
+RWByteAddressBuffer Output : register(u0);
+
+cbuffer CB0 : register(b0)
+{
+    uint BlockCount;
+    uint GroupsPerRow;      // Large streams need a 2D dispatch
+}
+
+// Bytes past the end of the payload read as zero
+uint LoadByte( uint Address, uint End )
+{
+    if (Address >= End)
+        return 0;
+    return (Encoded.Load(Address & ~3) >> ((Address & 3) * 8)) & 0xFF;
+}
+
+int UnZigZag( uint Value )
+{
+    return (int)(Value >> 1) ^ -(int)(Value & 1);
+}
+
+#ifdef DECODE_INDICES
+
+// The payload is a LEB128 varint per index, holding the zigzagged difference to the previous index.  Every
+// pass looks at 256 bytes of it.  Each thread holding the last byte of a varint reads back to its first byte,
+// then prefix sums over the group give the index its position and its value.
+void DecodeBlock( Block b, uint GI )
+{
+    uint FirstIndex = 0;
+    uint PreviousIndex = 0;
+
+    for (uint ChunkStart = b.PayloadBegin; ChunkStart < b.PayloadEnd; ChunkStart += 256)
+    {
+        uint Address = ChunkStart + GI;
+        uint Byte = Address < b.PayloadEnd ? LoadByte(Address, b.PayloadEnd) : 0x80;
+        bool IsLast = (Byte & 0x80) == 0;
+
+        uint Delta = 0;
+        if (IsLast)
+        {
+            // At most four bytes, like the CPU decoder
+            uint Value = Byte;
+            for (uint i = 1; i < 4 && Address >= b.PayloadBegin + i; ++i)
+            {
+                uint Previous = LoadByte(Address - i, b.PayloadEnd);
+                if ((Previous & 0x80) == 0)
+                    break;
+                Value = (Value << 7) | (Previous & 0x7F);
+            }
+            Delta = (uint)UnZigZag(Value);
+        }
+
+        uint ChunkIndices;
+        uint Ordinal = GroupCompactIndex(IsLast, GI, ChunkIndices);
+        uint ChunkDelta;
+        uint DeltaPrefix = GroupPrefixSum(Delta, GI, ChunkDelta);
+
+        uint Index = FirstIndex + Ordinal;
+        if (IsLast && Index < b.Count)
+        {
+            uint Value = (PreviousIndex + DeltaPrefix + Delta) & 0xFFFF;
+            uint OutAddress = b.RawOffset + Index * 2;
+            Output.InterlockedOr(OutAddress & ~3, Value << ((OutAddress & 2) * 8));
+        }
+
+        FirstIndex += ChunkIndices;
+        PreviousIndex += ChunkDelta;
+    }
+}
+
+#else // !DECODE_INDICES
+
+// The payload holds a plane per byte of the vertex.  A plane starts with two mode bits per group of 16
+// vertices, then the groups' zigzagged byte deltas with 0, 2, 4 or 8 bits each.  Thread i decodes vertex i,
+// and the deltas become bytes through a prefix sum over the group.
+uint GetGroupBits( uint PlaneStart, uint Group, uint End )
+{
+    uint Mode = (LoadByte(PlaneStart + Group / 4, End) >> (Group % 4 * 2)) & 3;
+    return Mode == 0 ? 0 : 1u << Mode;
+}
+
+void DecodeBlock( Block b, uint GI )
+{
+    const uint GroupCount = (b.Count + 15) / 16;
+    const uint HeaderSize = (GroupCount + 3) / 4;
+    const uint Group = GI / 16;
+
+    // The bytes of the vertex are merged into one 32-bit word of the output at a time
+    uint WordAddress = ~0u;
+    uint Word = 0;
+
+    uint PlaneStart = b.PayloadBegin;
+    for (uint Byte = 0; Byte < b.Stride; ++Byte)
+    {
+        // Every thread walks the (at most 16) groups, which is cheaper than sharing their sizes
+        uint GroupStart = PlaneStart + HeaderSize;
+        uint PlaneEnd = GroupStart;
+        for (uint g = 0; g < GroupCount; ++g)
+        {
+            uint Size = GetGroupBits(PlaneStart, g, b.PayloadEnd) * 2;
+            GroupStart += g < Group ? Size : 0;
+            PlaneEnd += Size;
+        }
+
+        uint Value = 0;
+        uint Bits = Group < GroupCount ? GetGroupBits(PlaneStart, Group, b.PayloadEnd) : 0;
+        if (Bits > 0)
+        {
+            uint BitOffset = GI % 16 * Bits;
+            Value = (LoadByte(GroupStart + BitOffset / 8, b.PayloadEnd) >> (BitOffset % 8)) & ((1u << Bits) - 1);
+        }
+
+        uint Delta = GI < b.Count ? (uint)UnZigZag(Value) : 0;
+        uint Total;
+        uint Decoded = (GroupPrefixSum(Delta, GI, Total) + Delta) & 0xFF;
+
+        if (GI < b.Count)
+        {
+            uint Address = b.RawOffset + GI * b.Stride + Byte;
+            if ((Address & ~3) != WordAddress)
+            {
+                if (Word != 0)
+                    Output.InterlockedOr(WordAddress, Word);
+                WordAddress = Address & ~3;
+                Word = 0;
+            }
+            Word |= Decoded << ((Address & 3) * 8);
+        }
+
+        PlaneStart = PlaneEnd;
+    }
+
+    if (Word != 0)
+        Output.InterlockedOr(WordAddress, Word);
+}
+
+#endif // DECODE_INDICES
+
+[numthreads( 256, 1, 1 )]
+void main( uint GI : SV_GroupIndex, uint3 Gid : SV_GroupID )
+{
+    uint BlockIndex = Gid.y * GroupsPerRow + Gid.x;
+    if (BlockIndex >= BlockCount)
+        return;
+
+    DecodeBlock(Blocks[BlockIndex], GI);
+}
@@ -22,6 +22,11 @@ Texture2D<float4> PrepBuffer : register(t1);        // 1/4 resolution pre-weight
 RWTexture2D<float3> DstColor : register(u0);        // final output color (blurred and temporally blended)
 SamplerState LinearSampler : register(s0);
 
+#ifdef USE_TILE_QUEUE
+// 16x16 tiles queued by the prepass.  Each tile gets four groups, one per 8x8 quadrant.
+StructuredBuffer<uint> TileQueue : register(t2);
+#endif
+
 cbuffer c0 : register(b0)
 {
     float2 RcpBufferDim;    // 1 / width, 1 / height
@@ -31,7 +36,12 @@ cbuffer c0 : register(b0)
 [numthreads( 8, 8, 1 )]
 void main( uint3 Gid : SV_GroupID, uint GI : SV_GroupIndex, uint3 GTid : SV_GroupThreadID, uint3 DTid : SV_DispatchThreadID )
 {
+#ifdef USE_TILE_QUEUE
+    uint TileCoord = TileQueue[Gid.x];
+    uint2 st = uint2(TileCoord & 0xFFFF, TileCoord >> 16) * 16 + uint2(Gid.y & 1, Gid.y >> 1) * 8 + GTid.xy;
+#else
     uint2 st = DTid.xy;
+#endif
     float2 position = st + 0.5;
     float2 uv = position * RcpBufferDim;
 
@@ -13,14 +13,19 @@
 
 #include "MotionBlurRS.hlsli"
 #include "PixelPacking_Velocity.hlsli"
+#include "MotionBlurTileQueue.hlsli"
 
 Texture2D<float3> ColorBuffer : register(t0);
 Texture2D<packed_velocity_t> VelocityBuffer : register(t1);
 RWTexture2D<float4> PrepBuffer : register(u0);
+#ifdef USE_TILE_MAX_VELOCITY
+Texture2D<float> TileMaxVelocity : register(t2);
+#endif
 
-float4 GetSampleData( uint2 st )
+float4 GetSampleData( uint2 st, inout float MaxSpeed )
 {
     float Speed = length(UnpackVelocity(VelocityBuffer[st]).xy);
+    MaxSpeed = max(MaxSpeed, Speed);
     return float4(ColorBuffer[st], 1.0) * saturate(Speed * 32.0 / 4.0);
 }
 
@@ -29,12 +34,20 @@ float4 GetSampleData( uint2 st )
 void main( uint3 Gid : SV_GroupID, uint GI : SV_GroupIndex, uint3 GTid : SV_GroupThreadID, uint3 DTid : SV_DispatchThreadID )
 {
     uint2 corner = DTid.xy << 1;
-    float4 sample0 = GetSampleData( corner + uint2(0, 0) );
-    float4 sample1 = GetSampleData( corner + uint2(1, 0) );
-    float4 sample2 = GetSampleData( corner + uint2(0, 1) );
-    float4 sample3 = GetSampleData( corner + uint2(1, 1) );
+    float MaxSpeed = 0.0;
+    float4 sample0 = GetSampleData( corner + uint2(0, 0), MaxSpeed );
+    float4 sample1 = GetSampleData( corner + uint2(1, 0), MaxSpeed );
+    float4 sample2 = GetSampleData( corner + uint2(0, 1), MaxSpeed );
+    float4 sample3 = GetSampleData( corner + uint2(1, 1), MaxSpeed );
 
     float combinedMotionWeight = sample0.a + sample1.a + sample2.a + sample3.a + 0.0001;
     PrepBuffer[DTid.xy] = floor(0.25 * combinedMotionWeight * 3.0) / 3.0 * float4(
         (sample0.rgb + sample1.rgb + sample2.rgb + sample3.rgb) / combinedMotionWeight, 1.0 );
+
+#ifdef USE_TILE_MAX_VELOCITY
+    if (GI == 0)
+        QueueMovingTile( TileMaxVelocity[Gid.xy], Gid.xy );
+#else
+    QueueMovingTile( MaxSpeed, GI, Gid.xy );
+#endif
 }
@@ -9,8 +9,8 @@
 // Developed by Minigraph
 //
 // Author:  James Stanard 
+//
 
-#define DYNAMIC_RESOLUTION
-#define DISABLE_DEPTH_TESTS
-#define SUPPORT_TYPED_UAV_LOADS 1
-#include "ParticleTileRenderCS.hlsl"
+// Queues moving tiles with the tile speeds written by TemporalPrepassCS
+#define USE_TILE_MAX_VELOCITY
+#include "MotionBlurPrePassCS.hlsl"
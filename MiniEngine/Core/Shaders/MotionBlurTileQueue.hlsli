@@ -0,0 +1,38 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Developed by Minigraph
+//
+// The motion blur prepasses give each 8x8 group a 16x16 tile of full resolution pixels.  While they are there,
+// they find the fastest pixel of the tile and queue the tile for the final pass if anything in it will blur.
+// Tiles that stay out of the queue are left untouched, which is most of the screen when only objects move.
+//
+
+#define WAVE_UTILITY_GROUP_SIZE 64
+#include "WaveUtility.hlsli"
+
+// Must match the threshold in MotionBlurFinalPassCS
+#define MIN_BLUR_SPEED 4.0
+
+RWStructuredBuffer<uint> TileQueue : register(u2);
+
+// Must be called by every thread of the group
+void QueueMovingTile( float MaxSpeed, uint GI, uint2 Tile )
+{
+    MaxSpeed = GroupReduceMax(MaxSpeed, GI);
+
+    if (GI == 0 && MaxSpeed >= MIN_BLUR_SPEED)
+        TileQueue[TileQueue.IncrementCounter()] = Tile.x | Tile.y << 16;
+}
+
+// For when the tile's fastest speed is already known.  Must be called by one thread of the group.
+void QueueMovingTile( float TileMaxSpeed, uint2 Tile )
+{
+    if (TileMaxSpeed >= MIN_BLUR_SPEED)
+        TileQueue[TileQueue.IncrementCounter()] = Tile.x | Tile.y << 16;
+}
@@ -19,14 +19,21 @@
 StructuredBuffer<ParticleScreenData> g_VisibleParticles : register( t0 );
 StructuredBuffer<uint> g_LargeBinParticles : register( t1 );
 ByteAddressBuffer g_LargeBinCounters : register( t2 );
+Texture2D<uint> g_DepthBounds32 : register( t3 );
 RWStructuredBuffer<uint> g_BinParticles : register( u0 );
 RWByteAddressBuffer g_BinCounters : register( u1 );
 
+// Each bin is covered by this many texels of the 32x32 depth bounds
+#define DEPTH_TEXELS_X (BIN_SIZE_X / 32)
+#define DEPTH_TEXELS_Y (BIN_SIZE_Y / 32)
+
 groupshared uint gs_BinCounters[16];
+groupshared uint gs_BinMaxDepth[16];
 
 cbuffer CB0 : register(b0)
 {
     uint2 LogTilesPerBin;
+    uint EnableDepthCulling;
 };
 
 [RootSignature(Particle_RootSig)]
@@ -44,7 +51,22 @@ void main( uint3 Gid : SV_GroupID, uint GI : SV_GroupIndex, uint3 GTid : SV_Grou
     uint2 FirstBin = Gid.xy * 4;
 
     if (GI < 16)
+    {
         gs_BinCounters[GI] = 0;
+        gs_BinMaxDepth[GI] = 0;
+    }
+
+    GroupMemoryBarrierWithGroupSync();
+
+    // Refine the large bin's farthest depth to each of its 16 bins
+    if (GI < 16 * DEPTH_TEXELS_X * DEPTH_TEXELS_Y)
+    {
+        uint BinIdx = GI % 16;
+        uint TexelIdx = GI / 16;
+        uint2 Bin = FirstBin + uint2(BinIdx & 3, BinIdx >> 2);
+        uint2 Texel = Bin * uint2(DEPTH_TEXELS_X, DEPTH_TEXELS_Y) + uint2(TexelIdx % DEPTH_TEXELS_X, TexelIdx / DEPTH_TEXELS_X);
+        InterlockedMax(gs_BinMaxDepth[BinIdx], g_DepthBounds32[Texel] >> 16);
+    }
 
     GroupMemoryBarrierWithGroupSync();
 
@@ -64,6 +86,11 @@ void main( uint3 Gid : SV_GroupID, uint GI : SV_GroupIndex, uint3 GTid : SV_Grou
             for (uint x = MinBin.x; x <= MaxBin.x; ++x)
             {
                 uint CounterIdx = (x & 3) | (y & 3) << 2;
+
+                // Skip bins where the particle is behind the farthest opaque surface
+                if (EnableDepthCulling != 0 && (SortKey >> 18) > gs_BinMaxDepth[CounterIdx])
+                    continue;
+
                 uint BinOffset = (x + y * gBinsPerRow) * MAX_PARTICLES_PER_BIN;
                 uint AllocIdx;
                 InterlockedAdd(gs_BinCounters[CounterIdx], 1, AllocIdx);
@@ -18,6 +18,7 @@ Texture2D<float> g_Input : register(t0);
 RWTexture2D<uint> g_Output8 : register(u0);
 RWTexture2D<uint> g_Output16 : register(u1);
 RWTexture2D<uint> g_Output32 : register(u2);
+RWByteAddressBuffer g_LargeBinMaxDepth : register(u3);
 
 groupshared uint gs_Buffer[128];
 
@@ -97,5 +98,13 @@ void main( uint3 Gid : SV_GroupID, uint GI : SV_GroupIndex, uint3 DTid : SV_Disp
     Max4(This, 4);
 
     if (This == 0)
-        g_Output32[Gid.xy] = PackMinMax(This);
+    {
+        uint MinMax = PackMinMax(This);
+        g_Output32[Gid.xy] = MinMax;
+
+        // Also reduce the farthest depth of each large bin so that particles can be rejected while binning
+        uint2 LargeBin = Gid.xy * 32 / uint2(4 * BIN_SIZE_X, 4 * BIN_SIZE_Y);
+        uint LargeBinsPerRow = (gBinsPerRow + 3) / 4;
+        g_LargeBinMaxDepth.InterlockedMax((LargeBin.y * LargeBinsPerRow + LargeBin.x) * 4, MinMax >> 16);
+    }
 }
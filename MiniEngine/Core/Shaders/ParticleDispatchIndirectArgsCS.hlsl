@@ -11,15 +11,50 @@
 // Author:  Julia Careaga 
 //
 
-#include "ParticleRS.hlsli"
+#include "ParticleUpdateCommon.hlsli"
+#include "ParticleUtility.hlsli"
 
-ByteAddressBuffer g_ParticleInstance : register( t0 );
+StructuredBuffer< EffectPropertyBlock > g_EffectProperties : register( t2 );
 RWByteAddressBuffer g_NumThreadGroups : register( u1 );
+RWByteAddressBuffer g_EffectCounters : register( u3 );
+RWStructuredBuffer< uint > g_UpdateGroupOffsets : register( u5 );
 
+groupshared uint gs_GroupCounts[MAX_EFFECTS_PER_BATCH];
+
+// One thread per effect of the batch.  Sizes the single update dispatch from the live particle counts and
+// records where each effect's groups begin.
 [RootSignature(Particle_RootSig)]
-[numthreads(1, 1, 1)]
-void main( uint3 DTid : SV_DispatchThreadID )
+[numthreads(MAX_EFFECTS_PER_BATCH, 1, 1)]
+void main( uint GI : SV_GroupIndex )
 {
-    g_NumThreadGroups.Store(0, ( g_ParticleInstance.Load(0) + 63) / 64);
+    uint NumGroups = 0;
+    if (GI < gNumEffects)
+    {
+        ParticleEffectEntry Effect = g_Effects[GI];
+        uint MaxParticles = g_EffectProperties[Effect.EffectSlot].Emit.MaxParticles;
+        uint CounterIndex = Effect.CounterIndex;
+        NumGroups = (min(g_EffectCounters.Load(CounterIndex * 4), MaxParticles) + 63) / 64;
+
+        // Survivors and new particles are appended to the other side
+        g_EffectCounters.Store((CounterIndex ^ 1) * 4, 0);
+    }
+    gs_GroupCounts[GI] = NumGroups;
+
+    GroupMemoryBarrierWithGroupSync();
+
+    // Inclusive prefix sum
+    [unroll]
+    for (uint Offset = 1; Offset < MAX_EFFECTS_PER_BATCH; Offset *= 2)
+    {
+        uint Sum = GI >= Offset ? gs_GroupCounts[GI - Offset] : 0;
+        GroupMemoryBarrierWithGroupSync();
+        gs_GroupCounts[GI] += Sum;
+        GroupMemoryBarrierWithGroupSync();
+    }
+
+    if (GI < gNumEffects)
+        g_UpdateGroupOffsets[GI] = gs_GroupCounts[GI] - NumGroups;
 
+    if (GI == MAX_EFFECTS_PER_BATCH - 1)
+        g_NumThreadGroups.Store3(0, uint3(gs_GroupCounts[GI], 1, 1));
 }
@@ -13,15 +13,22 @@
 
 #include "ParticleUtility.hlsli"
 
-ByteAddressBuffer g_FinalInstanceCounter : register( t0 );
+cbuffer CB0 : register(b0)
+{
+    uint gParticleBudget;
+};
+
 RWByteAddressBuffer g_NumThreadGroups : register( u0 );
 RWByteAddressBuffer g_DrawIndirectArgs : register ( u1 );
+RWByteAddressBuffer g_FinalInstanceCounter : register( u2 );
 
 [RootSignature(Particle_RootSig)]
 [numthreads(1, 1, 1)]
 void main( uint3 DTid : SV_DispatchThreadID )
 {
-    uint particleCount = g_FinalInstanceCounter.Load(0);
+    // Clamping the counter itself enforces the budget in every pass that reads it (binning, sorting, drawing)
+    uint particleCount = min(g_FinalInstanceCounter.Load(0), gParticleBudget);
+    g_FinalInstanceCounter.Store(0, particleCount);
     g_NumThreadGroups.Store3(0, uint3((particleCount + 63) / 64, 1, 1));
     g_DrawIndirectArgs.Store(4, particleCount);
 }
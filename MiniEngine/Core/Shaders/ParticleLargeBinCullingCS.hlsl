@@ -18,6 +18,7 @@
 
 StructuredBuffer<ParticleVertex> g_VertexBuffer : register(t0);
 ByteAddressBuffer g_VertexCount : register(t1);
+ByteAddressBuffer g_LargeBinMaxDepth : register(t2);
 RWStructuredBuffer<uint> g_LargeBinParticles : register(u0);
 RWByteAddressBuffer g_LargeBinCounters : register(u1);
 RWStructuredBuffer<ParticleScreenData> g_VisibleParticles : register( u2 );
@@ -25,8 +26,16 @@ RWStructuredBuffer<ParticleScreenData> g_VisibleParticles : register( u2 );
 cbuffer CB0 : register(b0)
 {
     uint2 LogTilesPerLargeBin;
+    uint EnableDepthCulling;
 };
 
+// A particle is hidden in a bin when it is behind the farthest opaque surface there.  Depths are 16-bit floats,
+// which sort like integers because they are never negative.
+bool IsVisibleInLargeBin( uint DepthKey, uint LargeBinIndex )
+{
+    return EnableDepthCulling == 0 || DepthKey <= g_LargeBinMaxDepth.Load(LargeBinIndex * 4);
+}
+
 [RootSignature(Particle_RootSig)]
 [numthreads(64, 1, 1)]
 void main( uint3 DTid : SV_DispatchThreadID )
@@ -78,6 +87,25 @@ void main( uint3 DTid : SV_DispatchThreadID )
     uint2 MaxTile = min(EdgeTile, uint2(BottomRight) / TILE_SIZE);
     Particle.Bounds = MinTile.x | MinTile.y << 8 | MaxTile.x << 16 | MaxTile.y << 24;
 
+    uint LargeBinsPerRow = (gBinsPerRow + 3) / 4;
+    uint2 MinLargeBin = MinTile >> LogTilesPerLargeBin;
+    uint2 MaxLargeBin = MaxTile >> LogTilesPerLargeBin;
+    uint DepthKey = f32tof16(Particle.Depth);
+
+    // A particle hidden in every large bin it touches never reaches the per-bin sort
+    uint VisibleBinCount = 0;
+    for (uint y0 = MinLargeBin.y; y0 <= MaxLargeBin.y; y0++)
+    {
+        for (uint x0 = MinLargeBin.x; x0 <= MaxLargeBin.x; x0++)
+        {
+            if (IsVisibleInLargeBin(DepthKey, y0 * LargeBinsPerRow + x0))
+                VisibleBinCount++;
+        }
+    }
+
+    if (VisibleBinCount == 0)
+        return;
+
     uint GlobalIdx = g_VisibleParticles.IncrementCounter();
 
     g_VisibleParticles[GlobalIdx] = Particle;
@@ -86,17 +114,16 @@ void main( uint3 DTid : SV_DispatchThreadID )
     // Insert the particle into all large bins it occupies
     //
 
-    uint LargeBinsPerRow = (gBinsPerRow + 3) / 4;
-    uint2 MinLargeBin = MinTile >> LogTilesPerLargeBin;
-    uint2 MaxLargeBin = MaxTile >> LogTilesPerLargeBin;
-
-    uint SortKey = f32tof16(Particle.Depth) << 18 | GlobalIdx;
+    uint SortKey = DepthKey << 18 | GlobalIdx;
 
     for (uint y = MinLargeBin.y; y <= MaxLargeBin.y; y++)
     {
         for (uint x = MinLargeBin.x; x <= MaxLargeBin.x; x++)
         {
             uint LargeBinIndex = y * LargeBinsPerRow + x;
+            if (!IsVisibleInLargeBin(DepthKey, LargeBinIndex))
+                continue;
+
             uint AllocIdx;
             g_LargeBinCounters.InterlockedAdd(LargeBinIndex * 4, 1, AllocIdx);
             AllocIdx = min(AllocIdx, MAX_PARTICLES_PER_LARGE_BIN - 1);
@@ -16,30 +16,76 @@
 #include "ParticleUtility.hlsli"
 
 StructuredBuffer< ParticleSpawnData > g_ResetData : register( t0 );
-RWStructuredBuffer< ParticleMotion > g_OutputBuffer : register( u2 );
+StructuredBuffer< EffectPropertyBlock > g_EffectProperties : register( t2 );
+RWStructuredBuffer< ParticleMotion > g_StatePool : register( u2 );
+RWByteAddressBuffer g_EffectCounters : register( u3 );
+
+groupshared uint gs_SpawnBase;
+
+// Spawn groups are laid out effect after effect starting at FirstSpawnGroup
+uint FindSpawningEffect( uint GroupID )
+{
+    uint First = 0;
+    uint Count = gNumEffects;
+    while (Count > 1)
+    {
+        uint Half = Count / 2;
+        if (g_Effects[First + Half].FirstSpawnGroup <= GroupID)
+            First += Half;
+        Count -= Half;
+    }
+    return First;
+}
+
+// Replaces the table of random spawn indices the CPU used to upload for every effect
+uint WangHash( uint Seed )
+{
+    Seed = (Seed ^ 61) ^ (Seed >> 16);
+    Seed *= 9;
+    Seed = Seed ^ (Seed >> 4);
+    Seed *= 0x27d4eb2d;
+    Seed = Seed ^ (Seed >> 15);
+    return Seed;
+}
 
 [RootSignature(Particle_RootSig)]
 [numthreads(64, 1, 1)]
-void main( uint3 DTid : SV_DispatchThreadID )
+void main( uint3 Gid : SV_GroupID, uint GI : SV_GroupIndex )
 {
-    uint index = g_OutputBuffer.IncrementCounter();
-    if (index >= MaxParticles)
+    uint EffectIndex = FindSpawningEffect(Gid.x);
+    ParticleEffectEntry Effect = g_Effects[EffectIndex];
+    EffectPropertyBlock Props = g_EffectProperties[Effect.EffectSlot];
+    uint SpawnIndex = (Gid.x - Effect.FirstSpawnGroup) * 64 + GI;
+
+    // Only the last group of an effect is partially filled, and its spawning threads come first
+    if (GI == 0)
+    {
+        uint SpawnBase;
+        g_EffectCounters.InterlockedAdd((Effect.CounterIndex ^ 1) * 4, min(Effect.SpawnCount - SpawnIndex, 64), SpawnBase);
+        gs_SpawnBase = SpawnBase;
+    }
+
+    GroupMemoryBarrierWithGroupSync();
+
+    uint MaxParticles = Props.Emit.MaxParticles;
+    uint index = gs_SpawnBase + GI;
+    if (SpawnIndex >= Effect.SpawnCount || index >= MaxParticles)
         return;
     
-    uint ResetDataIndex = RandIndex[DTid.x].x; 
-    ParticleSpawnData rd  = g_ResetData[ResetDataIndex];
+    uint ResetDataIndex = WangHash(gRandomSeed ^ WangHash(Props.ParticleOffset + SpawnIndex)) % MaxParticles;
+    ParticleSpawnData rd  = g_ResetData[Props.ParticleOffset + ResetDataIndex];
         
-    float3 emitterVelocity = EmitPosW - LastEmitPosW; 
-    float3 randDir = rd.Velocity.x * EmitRightW + rd.Velocity.y * EmitUpW + rd.Velocity.z * EmitDirW;
-    float3 newVelocity = emitterVelocity * EmitterVelocitySensitivity + randDir;
-    float3 adjustedPosition = EmitPosW - emitterVelocity * rd.Random + rd.SpreadOffset;
+    float3 emitterVelocity = Props.Emit.EmitPosW - Props.Emit.LastEmitPosW; 
+    float3 randDir = rd.Velocity.x * Props.Emit.EmitRightW + rd.Velocity.y * Props.Emit.EmitUpW + rd.Velocity.z * Props.Emit.EmitDirW;
+    float3 newVelocity = emitterVelocity * Props.Emit.EmitterVelocitySensitivity + randDir;
+    float3 adjustedPosition = Props.Emit.EmitPosW - emitterVelocity * rd.Random + rd.SpreadOffset;
 
     ParticleMotion newParticle;
     newParticle.Position = adjustedPosition;
     newParticle.Rotation = 0.0;
-    newParticle.Velocity = newVelocity + EmitDirW * EmitSpeed; 
+    newParticle.Velocity = newVelocity + Props.Emit.EmitDirW * Props.Emit.EmitSpeed; 
     newParticle.Mass = rd.Mass; 
     newParticle.Age = 0.0;
     newParticle.ResetDataIndex = ResetDataIndex; 
-    g_OutputBuffer[index] = newParticle;
+    g_StatePool[Props.ParticleOffset * 2 + (~Effect.CounterIndex & 1) * MaxParticles + index] = newParticle;
 }
@@ -13,6 +13,7 @@
 //
 
 #include "ParticleUtility.hlsli"
+#include "WaveUtility.hlsli"
 
 StructuredBuffer<uint> g_BinParticles : register(t0);
 ByteAddressBuffer g_BinCounters : register(t1);
@@ -205,21 +206,17 @@ void main( uint3 Gid : SV_GroupID, uint GI : SV_GroupIndex, uint3 GTid : SV_Grou
         return;
 
     uint ParticleCountInThisThreadsTile = gs_TileParticleCounts[GI];
-    if (ParticleCountInThisThreadsTile > 0)
-    {
-        uint SlowParticlesInThisThreadsTile = gs_SlowTileParticleCounts[GI];
-        uint Packet = TileCoord.x << 16 | TileCoord.y << 24 | ParticleCountInThisThreadsTile;
-
-        uint NewPacketIndex;
-        if (SlowParticlesInThisThreadsTile > 0)
-        {
-            g_DrawPacketCount.InterlockedAdd(0, 1, NewPacketIndex);
-            g_DrawPackets[NewPacketIndex] = Packet;
-        }
-        else
-        {
-            g_DrawPacketCount.InterlockedAdd(12, 1, NewPacketIndex);
-            g_FastDrawPackets[NewPacketIndex] = Packet;
-        }
-    }
+    uint SlowParticlesInThisThreadsTile = gs_SlowTileParticleCounts[GI];
+    uint Packet = TileCoord.x << 16 | TileCoord.y << 24 | ParticleCountInThisThreadsTile;
+
+    // Packets are appended with one atomic per wave and packet list
+    bool IsSlow = ParticleCountInThisThreadsTile > 0 && SlowParticlesInThisThreadsTile > 0;
+    bool IsFast = ParticleCountInThisThreadsTile > 0 && SlowParticlesInThisThreadsTile == 0;
+    uint SlowPacketIndex = WaveAppendIndex(g_DrawPacketCount, 0, IsSlow);
+    uint FastPacketIndex = WaveAppendIndex(g_DrawPacketCount, 12, IsFast);
+
+    if (IsSlow)
+        g_DrawPackets[SlowPacketIndex] = Packet;
+    else if (IsFast)
+        g_FastDrawPackets[FastPacketIndex] = Packet;
 }
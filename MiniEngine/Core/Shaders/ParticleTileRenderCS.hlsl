@@ -15,6 +15,7 @@
 
 #include "ParticleUtility.hlsli"
 #include "PixelPacking.hlsli"
+#include "PermutationFeatures.hlsli"
 
 //#define DEBUG_LOW_RES
 
@@ -26,7 +27,7 @@ cbuffer CB0 : register(b0)
     float gMipBias;
 };
 
-#if SUPPORT_TYPED_UAV_LOADS
+#if HAS_PERMUTATION_FEATURE(PERMUTATION_TYPED_UAV_LOADS)
 RWTexture2D<float3> g_OutputColorBuffer : register(u0);
 #else
 RWTexture2D<uint> g_OutputColorBuffer : register(u0);
@@ -36,7 +37,7 @@ StructuredBuffer<ParticleScreenData> g_VisibleParticles : register(t0);
 ByteAddressBuffer g_HitMask : register(t1);
 Texture2DArray<float4> g_TexArray : register(t2);
 StructuredBuffer<uint> g_SortedParticles : register(t4);
-#ifndef DISABLE_DEPTH_TESTS
+#if !HAS_PERMUTATION_FEATURE(PERMUTATION_NO_DEPTH_TESTS)
 Texture2D<float> g_InputDepthBuffer : register(t3);
 StructuredBuffer<uint> g_DrawPackets : register(t5);
 Texture2D<uint> g_TileDepthBounds : register(t7);
@@ -68,7 +69,7 @@ void BlendHighRes( inout float4x4 Quad, ParticleScreenData Particle, float2 Pixe
     float2 UV1 = UV - dUV;
     float2 UV2 = UV + dUV;
 
-#if defined(DYNAMIC_RESOLUTION)
+#if HAS_PERMUTATION_FEATURE(PERMUTATION_DYNAMIC_RESOLUTION)
     // Use point sampling for high-res rendering because this implies we're not rendering
     // with the most detailed mip level anyway.
     SamplerState Sampler = gSampPointBorder;
@@ -99,7 +100,7 @@ void BlendLowRes( inout float4x4 Quad, ParticleScreenData Particle, float2 Pixel
 
 void WriteBlendedColor( uint2 ST, float4 Color )
 {
-#if SUPPORT_TYPED_UAV_LOADS
+#if HAS_PERMUTATION_FEATURE(PERMUTATION_TYPED_UAV_LOADS)
     float3 DestColor = g_OutputColorBuffer[ST];
     g_OutputColorBuffer[ST] = Color.rgb + DestColor * (1.0 - Color.a);
 #else
@@ -118,7 +119,7 @@ void WriteBlendedQuad( uint2 ST, float4x4 Quad )
 
 float4x4 RenderParticles( uint2 TileCoord, uint2 ST, uint NumParticles, uint HitMaskStart, uint BinStart )
 {
-#ifndef DISABLE_DEPTH_TESTS
+#if !HAS_PERMUTATION_FEATURE(PERMUTATION_NO_DEPTH_TESTS)
     const uint TileNearZ = g_TileDepthBounds[TileCoord] << 18;
     float4 Depths = g_InputDepthBuffer.Gather(gSampPointClamp, (ST + 1) * gRcpBufferDim);
 #endif
@@ -142,9 +143,9 @@ float4x4 RenderParticles( uint2 TileCoord, uint2 ST, uint NumParticles, uint Hit
             uint ParticleIdx = SortKey & 0x3FFFF;
             ParticleScreenData Particle = g_VisibleParticles[ParticleIdx];
 
-#if defined(DYNAMIC_RESOLUTION)
+#if HAS_PERMUTATION_FEATURE(PERMUTATION_DYNAMIC_RESOLUTION)
             bool DoFullRes = (Particle.TextureLevel > gDynamicResLevel);
-#elif defined(LOW_RESOLUTION)
+#elif HAS_PERMUTATION_FEATURE(PERMUTATION_LOW_RESOLUTION)
             static const bool DoFullRes = false;
 #else
             static const bool DoFullRes = true;
@@ -152,7 +153,7 @@ float4x4 RenderParticles( uint2 TileCoord, uint2 ST, uint NumParticles, uint Hit
 
             if (DoFullRes)
             {
-#ifndef DISABLE_DEPTH_TESTS
+#if !HAS_PERMUTATION_FEATURE(PERMUTATION_NO_DEPTH_TESTS)
                 if (SortKey > TileNearZ)
                 {
                     float4 DepthMask = saturate(1000.0 * (Depths - Particle.Depth));
@@ -166,7 +167,7 @@ float4x4 RenderParticles( uint2 TileCoord, uint2 ST, uint NumParticles, uint Hit
             }
             else
             {
-#ifndef DISABLE_DEPTH_TESTS
+#if !HAS_PERMUTATION_FEATURE(PERMUTATION_NO_DEPTH_TESTS)
                 if (SortKey > TileNearZ)
                 {
                     float4 DepthMask = saturate(1000.0 * (Depths - Particle.Depth));
@@ -15,53 +15,103 @@
 #include "ParticleUpdateCommon.hlsli"
 #include "ParticleUtility.hlsli"
 
-cbuffer CB0 : register(b0)
-{
-    float gElapsedTime;
-};
+#define WAVE_UTILITY_GROUP_SIZE 64
+#include "WaveUtility.hlsli"
 
 StructuredBuffer< ParticleSpawnData > g_ResetData : register( t0 );
-StructuredBuffer< ParticleMotion > g_InputBuffer : register( t1 );
+StructuredBuffer< uint > g_UpdateGroupOffsets : register( t1 );
+StructuredBuffer< EffectPropertyBlock > g_EffectProperties : register( t2 );
 RWStructuredBuffer< ParticleVertex > g_VertexBuffer : register( u0 );
-RWStructuredBuffer< ParticleMotion > g_OutputBuffer : register( u2 );
+RWStructuredBuffer< ParticleMotion > g_StatePool : register( u2 );
+RWByteAddressBuffer g_EffectCounters : register( u3 );
+RWByteAddressBuffer g_VertexCounter : register( u4 );
+
+groupshared uint gs_SurvivorBase;
+groupshared uint gs_SpriteBase;
+
+// Every group belongs to one effect.  Find the last effect whose first group is not after this one.  Effects
+// without live particles share their offset with the next effect, so they are never chosen.
+uint FindEffect( uint GroupID )
+{
+    uint First = 0;
+    uint Count = gNumEffects;
+    while (Count > 1)
+    {
+        uint Half = Count / 2;
+        if (g_UpdateGroupOffsets[First + Half] <= GroupID)
+            First += Half;
+        Count -= Half;
+    }
+    return First;
+}
 
 [RootSignature(Particle_RootSig)]
 [numthreads(64, 1, 1)]
-void main( uint3 DTid : SV_DispatchThreadID )
+void main( uint3 Gid : SV_GroupID, uint GI : SV_GroupIndex )
 {
-    if (DTid.x >= MaxParticles)
-        return;
+    uint EffectIndex = FindEffect(Gid.x);
+    ParticleEffectEntry Effect = g_Effects[EffectIndex];
+    EffectPropertyBlock Props = g_EffectProperties[Effect.EffectSlot];
+    uint MaxParticles = Props.Emit.MaxParticles;
+    uint LiveCount = min(g_EffectCounters.Load(Effect.CounterIndex * 4), MaxParticles);
+    uint ParticleIndex = (Gid.x - g_UpdateGroupOffsets[EffectIndex]) * 64 + GI;
+    uint InputBase = Props.ParticleOffset * 2 + (Effect.CounterIndex & 1) * MaxParticles;
+    uint OutputBase = Props.ParticleOffset * 2 + (~Effect.CounterIndex & 1) * MaxParticles;
+
+    ParticleMotion ParticleState = (ParticleMotion)0;
+    ParticleSpawnData rd = (ParticleSpawnData)0;
+    bool IsAlive = false;
+
+    if (ParticleIndex < LiveCount)
+    {
+        ParticleState = g_StatePool[InputBase + ParticleIndex];
+        rd = g_ResetData[Props.ParticleOffset + ParticleState.ResetDataIndex];
 
-    ParticleMotion ParticleState = g_InputBuffer[ DTid.x ];
-    ParticleSpawnData rd = g_ResetData[ ParticleState.ResetDataIndex ];
+        // Update age.  If normalized age exceeds 1, the particle does not renew its lease on life.
+        ParticleState.Age += gElapsedTime * rd.AgeRate;
+        IsAlive = ParticleState.Age < 1.0;
+    }
 
-    // Update age.  If normalized age exceeds 1, the particle does not renew its lease on life.
-    ParticleState.Age += gElapsedTime * rd.AgeRate;
-    if (ParticleState.Age >= 1.0)
-        return;
+    if (IsAlive)
+    {
+        // Update position.  Compute two deltas to support rebounding off the ground plane.
+        float StepSize = (ParticleState.Position.y > 0.0 && ParticleState.Velocity.y < 0.0) ?
+            min(gElapsedTime, ParticleState.Position.y / -ParticleState.Velocity.y) : gElapsedTime;
 
-    // Update position.  Compute two deltas to support rebounding off the ground plane.
-    float StepSize = (ParticleState.Position.y > 0.0 && ParticleState.Velocity.y < 0.0) ?
-        min(gElapsedTime, ParticleState.Position.y / -ParticleState.Velocity.y) : gElapsedTime;
+        ParticleState.Position += ParticleState.Velocity * StepSize;
+        ParticleState.Velocity += Props.Emit.Gravity * ParticleState.Mass * StepSize;
+
+        // Rebound off the ground if we didn't consume all of the elapsed time
+        StepSize = gElapsedTime - StepSize;
+        if (StepSize > 0.0)
+        {
+            ParticleState.Velocity = reflect(ParticleState.Velocity, float3(0, 1, 0)) * Props.Emit.Restitution;
+            ParticleState.Position += ParticleState.Velocity * StepSize;
+            ParticleState.Velocity += Props.Emit.Gravity * ParticleState.Mass * StepSize;
+        }
+    }
 
-    ParticleState.Position += ParticleState.Velocity * StepSize;
-    ParticleState.Velocity += Gravity * ParticleState.Mass * StepSize;
+    // Compact the survivors.  They are counted across the group first so that the effect's live count and the
+    // sprite count are each bumped with one atomic per group rather than one per particle.
+    uint SurvivorCount;
+    uint LocalIndex = GroupCompactIndex(IsAlive, GI, SurvivorCount);
 
-    // Rebound off the ground if we didn't consume all of the elapsed time
-    StepSize = gElapsedTime - StepSize;
-    if (StepSize > 0.0)
+    if (GI == 0 && SurvivorCount > 0)
     {
-        ParticleState.Velocity = reflect(ParticleState.Velocity, float3(0, 1, 0)) * Restitution;
-        ParticleState.Position += ParticleState.Velocity * StepSize;
-        ParticleState.Velocity += Gravity * ParticleState.Mass * StepSize;
+        uint SurvivorBase, SpriteBase;
+        g_EffectCounters.InterlockedAdd((Effect.CounterIndex ^ 1) * 4, SurvivorCount, SurvivorBase);
+        g_VertexCounter.InterlockedAdd(0, SurvivorCount, SpriteBase);
+        gs_SurvivorBase = SurvivorBase;
+        gs_SpriteBase = SpriteBase;
     }
 
-    // The spawn dispatch will be simultaneously adding particles as well.  It's possible to overflow.
-    uint index = g_OutputBuffer.IncrementCounter();    
-    if (index >= MaxParticles)
+    GroupMemoryBarrierWithGroupSync();
+
+    // The other side was emptied before this pass and spawning happens afterward, so survivors always fit.
+    if (!IsAlive)
         return;
 
-    g_OutputBuffer[index] = ParticleState;
+    g_StatePool[OutputBase + gs_SurvivorBase + LocalIndex] = ParticleState;
 
     //
     // Generate a sprite vertex
@@ -70,7 +120,7 @@ void main( uint3 DTid : SV_DispatchThreadID )
     ParticleVertex Sprite;
 
     Sprite.Position = ParticleState.Position;
-    Sprite.TextureID = TextureID;
+    Sprite.TextureID = Props.Emit.TextureID;
 
     // Update size and color
     Sprite.Size = lerp(rd.StartSize, rd.EndSize, ParticleState.Age);
@@ -80,5 +130,5 @@ void main( uint3 DTid : SV_DispatchThreadID )
     // Use a trinomial to smoothly fade in a particle at birth and fade it out at death.
     Sprite.Color *= ParticleState.Age * (1.0 - ParticleState.Age) * (1.0 - ParticleState.Age) * 6.7;
 
-    g_VertexBuffer[ g_VertexBuffer.IncrementCounter() ] = Sprite;
+    g_VertexBuffer[ gs_SpriteBase + LocalIndex ] = Sprite;
 }
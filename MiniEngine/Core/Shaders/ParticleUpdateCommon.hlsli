@@ -12,7 +12,7 @@
 //              James Stanard
 //
 
-cbuffer EmissionProperties : register(b2)
+struct EmissionProperties
 {    
     float3 LastEmitPosW;
     float EmitSpeed;
@@ -28,7 +28,39 @@ cbuffer EmissionProperties : register(b2)
     uint TextureID;
     float3 EmissiveColor;
     float pad;
-    uint4 RandIndex[64];
+};
+
+// See ParticleShaderStructs.h
+struct EffectPropertyBlock
+{
+    EmissionProperties Emit;
+    uint ParticleOffset;
+    uint3 pad;
+};
+
+struct ParticleEffectEntry
+{
+    uint EffectSlot;
+    uint CounterIndex;
+    uint SpawnCount;
+    uint FirstSpawnGroup;
+};
+
+#define MAX_EFFECTS 4096
+#define MAX_EFFECTS_PER_BATCH 512
+
+// The update passes see one batch of the frame's table, and the spawn pass sees all of it
+cbuffer EffectTable : register(b2)
+{
+    ParticleEffectEntry g_Effects[MAX_EFFECTS];
+};
+
+// Shared by the batched update passes
+cbuffer CB0 : register(b0)
+{
+    float gElapsedTime;
+    uint gNumEffects;
+    uint gRandomSeed;
 };
 
 struct ParticleSpawnData
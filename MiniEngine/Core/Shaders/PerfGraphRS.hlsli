@@ -13,7 +13,17 @@
 
 #define PerfGraph_RootSig \
     "RootFlags(0), " \
-    "CBV(b0)," \
-    "DescriptorTable(UAV(u0, numDescriptors = 2))," \
     "SRV(t0, visibility = SHADER_VISIBILITY_VERTEX)," \
-    "RootConstants(b1, num32BitConstants = 3)"
+    "SRV(t1, visibility = SHADER_VISIBILITY_VERTEX)"
+
+// Every background and every line strip is one instance, so that each kind takes a single draw
+struct GraphInstance
+{
+    float4 Rect;        // Left, bottom, right and top in clip space
+    float3 Color;
+    float RcpYScale;
+    uint FirstNode;     // The graph's oldest sample in PerfTimes
+    uint NodeCount;
+};
+
+StructuredBuffer<GraphInstance> Graphs : register(t0);
@@ -13,41 +13,25 @@
 
 #include "PerfGraphRS.hlsli"
 
-cbuffer CBGraphColor : register(b0)
-{
-    float3 Color;
-    float RcpXScale;
-    uint NodeCount;
-    uint FrameID;
-};
-
-cbuffer constants : register(b1)
-{
-    uint Instance;
-    float RcpYScale;
-}
-
 struct VSOutput
 {
     float4 pos : SV_POSITION;
     float3 col : COLOR;
 };
 
-StructuredBuffer<float> PerfTimes : register(t0);
+// The samples of every graph in chronological order
+StructuredBuffer<float> PerfTimes : register(t1);
 
 [RootSignature(PerfGraph_RootSig)]
-VSOutput main( uint VertexID : SV_VertexID )
+VSOutput main( uint VertexID : SV_VertexID, uint InstanceID : SV_InstanceID )
 {
-    // Assume NodeCount is a power of 2
-    uint offset = (FrameID + VertexID) & (NodeCount - 1);
-        
-    // TODO:  Stop interleaving data
-    float perfTime = saturate(PerfTimes[offset] * RcpYScale) * 2.0 - 1.0;
-    float frame = VertexID * RcpXScale - 1.0; 
+    GraphInstance Graph = Graphs[InstanceID];
+
+    float perfTime = saturate(PerfTimes[Graph.FirstNode + VertexID] * Graph.RcpYScale);
+    float frame = (float)VertexID / Graph.NodeCount;
 
     VSOutput output;
-    output.pos = float4(frame, perfTime, 1, 1);
-    output.col = Color;
+    output.pos = float4(lerp(Graph.Rect.xy, Graph.Rect.zw, float2(frame, perfTime)), 1, 1);
+    output.col = Graph.Color;
     return output;
-
 }
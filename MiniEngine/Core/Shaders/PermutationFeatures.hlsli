@@ -0,0 +1,34 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Developed by Minigraph
+//
+// Feature bits of shaders compiled once for each combination they need.  Such shaders are ShaderPermutation
+// items in the project, listing the feature masks to compile, and each mask is compiled with PERMUTATION_BITS
+// defined to it (see PropertySheets\ShaderPermutations.targets).  At run time, ComputePSOPermutations picks the
+// PSO by the same mask.
+//
+// This file is also included by C++, so it must only contain macros.
+//
+
+#ifndef PERMUTATION_FEATURES_HLSLI
+#define PERMUTATION_FEATURES_HLSLI
+
+#define PERMUTATION_TYPED_UAV_LOADS         0x1     // Read-modify-write of R11G11B10_FLOAT UAVs
+#define PERMUTATION_NO_DEPTH_TESTS          0x2     // Everything drawn is known to be in front of the depth buffer
+#define PERMUTATION_LOW_RESOLUTION          0x4     // Sample at a quarter of the rate
+#define PERMUTATION_DYNAMIC_RESOLUTION      0x8     // Pick the sampling rate per draw
+
+// Shaders compiled outside of a ShaderPermutation item get the permutation with no features
+#ifndef PERMUTATION_BITS
+#define PERMUTATION_BITS 0
+#endif
+
+#define HAS_PERMUTATION_FEATURE( Feature ) ((PERMUTATION_BITS & (Feature)) != 0)
+
+#endif // PERMUTATION_FEATURES_HLSLI
@@ -0,0 +1,49 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Developed by Minigraph
+//
+
+// Histogram the current digit of one block of the list.  The histograms are stored digit-major,
+// g_Histograms[Digit * NumBlocks + Block], so that one exclusive scan over all of them yields the
+// first output location of each digit in each block.
+
+#include "RadixSortCommon.hlsli"
+
+ByteAddressBuffer g_SrcList : register(t1);
+RWByteAddressBuffer g_Histograms : register(u0);
+
+groupshared uint gs_Bins[NUM_BINS];
+
+[RootSignature(RadixSort_RootSig)]
+[numthreads(GROUP_SIZE, 1, 1)]
+void main( uint GI : SV_GroupIndex, uint3 Gid : SV_GroupID )
+{
+    const uint ListCount = GetListCount();
+    const uint NumBlocks = GetNumBlocks(ListCount);
+
+    if (GI < NUM_BINS)
+        gs_Bins[GI] = 0;
+
+    GroupMemoryBarrierWithGroupSync();
+
+    const uint BlockStart = Gid.x * BLOCK_SIZE;
+
+    [unroll]
+    for (uint i = 0; i < ELEMENTS_PER_THREAD; ++i)
+    {
+        uint Index = BlockStart + i * GROUP_SIZE + GI;
+        if (Index < ListCount)
+            InterlockedAdd(gs_Bins[GetDigit(LoadElement(g_SrcList, Index))], 1);
+    }
+
+    GroupMemoryBarrierWithGroupSync();
+
+    if (GI < NUM_BINS)
+        g_Histograms.Store((GI * NumBlocks + Gid.x) * 4, gs_Bins[GI]);
+}
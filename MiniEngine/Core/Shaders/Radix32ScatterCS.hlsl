@@ -0,0 +1,125 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Developed by Minigraph
+//
+
+// Write each element of one block to its place for this pass.  The block is processed in chunks of
+// GROUP_SIZE elements.  Each chunk is stably sorted by digit in LDS with four 1-bit splits, which gives
+// every element its rank among the elements of the chunk with the same digit.  Adding the running
+// output location of that digit for this block gives the destination.
+
+#include "RadixSortCommon.hlsli"
+
+ByteAddressBuffer g_SrcList : register(t1);
+RWByteAddressBuffer g_Histograms : register(u0);
+RWByteAddressBuffer g_DstList : register(u1);
+
+// Bit 4 of a local key marks elements past the end of the list.  They start at the end of the chunk
+// and the splits are stable, so they stay behind the valid elements and never disturb their ranks.
+#define INVALID_KEY NUM_BINS
+
+groupshared uint gs_Output[NUM_BINS];
+groupshared uint gs_Count[NUM_BINS];
+groupshared uint gs_DigitStart[NUM_BINS];
+groupshared uint gs_Scan[GROUP_SIZE];
+groupshared uint gs_Keys[GROUP_SIZE];
+groupshared Element gs_Elements[GROUP_SIZE];
+
+// Returns the number of zeros before this thread and sets TotalZeros
+uint CountZerosBefore( uint GI, uint IsZero, out uint TotalZeros )
+{
+    gs_Scan[GI] = IsZero;
+    GroupMemoryBarrierWithGroupSync();
+
+    [unroll]
+    for (uint Offset = 1; Offset < GROUP_SIZE; Offset *= 2)
+    {
+        uint Addend = GI >= Offset ? gs_Scan[GI - Offset] : 0;
+        GroupMemoryBarrierWithGroupSync();
+        gs_Scan[GI] += Addend;
+        GroupMemoryBarrierWithGroupSync();
+    }
+
+    TotalZeros = gs_Scan[GROUP_SIZE - 1];
+    uint Result = gs_Scan[GI] - IsZero;
+    GroupMemoryBarrierWithGroupSync();
+    return Result;
+}
+
+[RootSignature(RadixSort_RootSig)]
+[numthreads(GROUP_SIZE, 1, 1)]
+void main( uint GI : SV_GroupIndex, uint3 Gid : SV_GroupID )
+{
+    const uint ListCount = GetListCount();
+    const uint NumBlocks = GetNumBlocks(ListCount);
+
+    if (GI < NUM_BINS)
+    {
+        gs_Output[GI] = g_Histograms.Load((GI * NumBlocks + Gid.x) * 4);
+        gs_Count[GI] = 0;
+    }
+
+    const uint BlockStart = Gid.x * BLOCK_SIZE;
+
+    for (uint Chunk = 0; Chunk < ELEMENTS_PER_THREAD; ++Chunk)
+    {
+        const uint Index = BlockStart + Chunk * GROUP_SIZE + GI;
+
+        Element Value = (Element)0;
+        uint Key = INVALID_KEY | (NUM_BINS - 1);
+        if (Index < ListCount)
+        {
+            Value = LoadElement(g_SrcList, Index);
+            Key = GetDigit(Value);
+        }
+
+        GroupMemoryBarrierWithGroupSync();
+
+        if (Key < NUM_BINS)
+            InterlockedAdd(gs_Count[Key], 1);
+
+        // Stable split on each bit of the digit, moving the keys and elements through LDS
+        [unroll]
+        for (uint Bit = 0; Bit < RADIX_BITS; ++Bit)
+        {
+            uint IsZero = (Key >> Bit & 1) ^ 1;
+            uint TotalZeros;
+            uint ZerosBefore = CountZerosBefore(GI, IsZero, TotalZeros);
+            uint NewPos = IsZero ? ZerosBefore : TotalZeros + GI - ZerosBefore;
+
+            gs_Keys[NewPos] = Key;
+            gs_Elements[NewPos] = Value;
+            GroupMemoryBarrierWithGroupSync();
+
+            Key = gs_Keys[GI];
+            Value = gs_Elements[GI];
+            GroupMemoryBarrierWithGroupSync();
+        }
+
+        // Thread GI now holds the element of rank GI.  Find where each digit's run starts.
+        gs_Keys[GI] = Key;
+        GroupMemoryBarrierWithGroupSync();
+
+        if (Key < NUM_BINS && (GI == 0 || gs_Keys[GI - 1] != Key))
+            gs_DigitStart[Key] = GI;
+
+        GroupMemoryBarrierWithGroupSync();
+
+        if (Key < NUM_BINS)
+            StoreElement(g_DstList, gs_Output[Key] + GI - gs_DigitStart[Key], Value);
+
+        GroupMemoryBarrierWithGroupSync();
+
+        if (GI < NUM_BINS)
+        {
+            gs_Output[GI] += gs_Count[GI];
+            gs_Count[GI] = 0;
+        }
+    }
+}
@@ -0,0 +1,65 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Developed by Minigraph
+//
+
+#define RadixSort_RootSig \
+    "RootFlags(0), " \
+    "RootConstants(b0, num32BitConstants = 4)," \
+    "DescriptorTable(SRV(t0, numDescriptors = 2))," \
+    "DescriptorTable(UAV(u0, numDescriptors = 2))"
+
+#define RADIX_BITS 4
+#define NUM_BINS 16
+#define GROUP_SIZE 256
+#define ELEMENTS_PER_THREAD 4
+#define BLOCK_SIZE (GROUP_SIZE * ELEMENTS_PER_THREAD)
+
+ByteAddressBuffer g_CounterBuffer : register(t0);
+
+cbuffer Constants : register(b0)
+{
+    // Offset into counter buffer where this list's item count is stored
+    uint CounterOffset;
+
+    // Location of this pass's digit:  the shift within a 32-bit word and which word of an element
+    uint DigitShift;
+    uint DigitWord;
+
+    // 0 to sort ascending, 0xffffffff to sort descending.  Inverting the key reverses the order.
+    uint KeyFlip;
+}
+
+#ifdef RADIXSORT_64BIT
+
+#define Element uint2
+
+Element LoadElement( ByteAddressBuffer List, uint Index ) { return List.Load2(Index * 8); }
+void StoreElement( RWByteAddressBuffer List, uint Index, Element Value ) { List.Store2(Index * 8, Value); }
+uint GetDigit( Element Value ) { return ((DigitWord == 0 ? Value.x : Value.y) ^ KeyFlip) >> DigitShift & (NUM_BINS - 1); }
+
+#else
+
+#define Element uint
+
+Element LoadElement( ByteAddressBuffer List, uint Index ) { return List.Load(Index * 4); }
+void StoreElement( RWByteAddressBuffer List, uint Index, Element Value ) { List.Store(Index * 4, Value); }
+uint GetDigit( Element Value ) { return (Value ^ KeyFlip) >> DigitShift & (NUM_BINS - 1); }
+
+#endif
+
+uint GetListCount( void )
+{
+    return g_CounterBuffer.Load(CounterOffset);
+}
+
+uint GetNumBlocks( uint ListCount )
+{
+    return (ListCount + BLOCK_SIZE - 1) / BLOCK_SIZE;
+}
@@ -0,0 +1,22 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Developed by Minigraph
+//
+
+#include "RadixSortCommon.hlsli"
+
+RWByteAddressBuffer g_IndirectArgsBuffer : register(u0);
+
+// The count and scatter passes both run one thread group per block of the list
+[RootSignature(RadixSort_RootSig)]
+[numthreads(1, 1, 1)]
+void main( void )
+{
+    g_IndirectArgsBuffer.Store3(0, uint3(GetNumBlocks(GetListCount()), 1, 1));
+}
@@ -0,0 +1,57 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Developed by Minigraph
+//
+
+// Replace the block histograms with their exclusive prefix sum in place.  There are at most
+// NUM_BINS * kMaxElements / BLOCK_SIZE of them, so a single thread group scans them:  each thread
+// sums a contiguous run, the run totals are scanned in LDS, and then each thread writes out its run.
+
+#include "RadixSortCommon.hlsli"
+
+RWByteAddressBuffer g_Histograms : register(u0);
+
+#define SCAN_GROUP_SIZE 1024
+
+groupshared uint gs_Sums[SCAN_GROUP_SIZE];
+
+[RootSignature(RadixSort_RootSig)]
+[numthreads(SCAN_GROUP_SIZE, 1, 1)]
+void main( uint GI : SV_GroupIndex )
+{
+    const uint NumEntries = NUM_BINS * GetNumBlocks(GetListCount());
+    const uint RunLength = (NumEntries + SCAN_GROUP_SIZE - 1) / SCAN_GROUP_SIZE;
+    const uint RunStart = min(GI * RunLength, NumEntries);
+    const uint RunEnd = min(RunStart + RunLength, NumEntries);
+
+    uint RunTotal = 0;
+    for (uint i = RunStart; i < RunEnd; ++i)
+        RunTotal += g_Histograms.Load(i * 4);
+
+    gs_Sums[GI] = RunTotal;
+    GroupMemoryBarrierWithGroupSync();
+
+    // Inclusive scan of the run totals
+    [unroll]
+    for (uint Offset = 1; Offset < SCAN_GROUP_SIZE; Offset *= 2)
+    {
+        uint Addend = GI >= Offset ? gs_Sums[GI - Offset] : 0;
+        GroupMemoryBarrierWithGroupSync();
+        gs_Sums[GI] += Addend;
+        GroupMemoryBarrierWithGroupSync();
+    }
+
+    uint Prefix = gs_Sums[GI] - RunTotal;
+    for (uint j = RunStart; j < RunEnd; ++j)
+    {
+        uint Count = g_Histograms.Load(j * 4);
+        g_Histograms.Store(j * 4, Prefix);
+        Prefix += Count;
+    }
+}
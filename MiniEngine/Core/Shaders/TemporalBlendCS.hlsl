@@ -115,12 +115,18 @@ void ApplyTemporalBlend(uint2 ST, uint ldsIdx, float3 BoxMin, float3 BoxMax)
 {
     float3 CurrentColor = LoadRGB(ldsIdx);
 
+#ifdef USE_DILATED_VELOCITY
+    // The prepass already took the velocity of the closest pixel in the '+' formation and rebased its Z here
+    float3 Velocity = UnpackVelocity(VelocityBuffer[ST]);
+    float CompareDepth = CurDepth[ST] + Velocity.z;
+#else
     float CompareDepth;
 
     // Get the velocity of the closest pixel in the '+' formation
     float3 Velocity = UnpackVelocity(VelocityBuffer[ST + GetClosestPixel(ldsIdx, CompareDepth)]);
 
     CompareDepth += Velocity.z;
+#endif
 
     // The temporal depth is the actual depth of the pixel found at the same reprojected location.
     float TemporalDepth = MaxOf(PreDepth.Gather(LinearSampler, STtoUV(ST + Velocity.xy + ViewportJitter))) + 1e-3;
@@ -174,11 +180,13 @@ void main(uint3 DTid : SV_DispatchThreadID, uint GI : SV_GroupIndex, uint3 GTid
         int2 TopLeftST = Gid.xy * uint2(8, 8) - 1 + uint2(X / 2, Y);
         float2 UV = RcpBufferDim * (TopLeftST * float2(2, 1) + float2(2, 1));
 
+#ifndef USE_DILATED_VELOCITY
         float4 Depths = CurDepth.Gather(LinearSampler, UV);
         ldsDepth[TopLeftIdx + 0] = Depths.w;
         ldsDepth[TopLeftIdx + 1] = Depths.z;
         ldsDepth[TopLeftIdx + kLdsPitch] = Depths.x;
         ldsDepth[TopLeftIdx + 1 + kLdsPitch] = Depths.y;
+#endif
 
         float4 R4 = InColor.GatherRed(LinearSampler, UV);
         float4 G4 = InColor.GatherGreen(LinearSampler, UV);
@@ -0,0 +1,124 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Developed by Minigraph
+//
+// Author:  James Stanard 
+//
+// The velocity prepass shared by TAA and motion blur.  Each group generates camera velocity for a 16x16 tile
+// (plus a one pixel border) from linear Z and then:
+//
+//   1) Dilates it.  Every pixel takes the velocity of the closest pixel in its '+' neighborhood, which is the
+//      search TemporalBlendCS would otherwise repeat on its own.  Z is rebased to the center pixel, so the
+//      closest pixel's depth last frame is still CurDepth[st] + Velocity.z.  Motion blur only reads XY.
+//   2) Writes the fastest speed of the tile for the motion blur tile queue.
+//
+
+#include "MotionBlurRS.hlsli"
+#include "PixelPacking_Velocity.hlsli"
+
+#define WAVE_UTILITY_GROUP_SIZE 64
+#include "WaveUtility.hlsli"
+
+Texture2D<float> DepthBuffer : register(t0);
+RWTexture2D<packed_velocity_t> VelocityBuffer : register(u0);
+RWTexture2D<float> TileMaxVelocity : register(u1);
+
+cbuffer CBuffer : register(b1)
+{
+    matrix CurToPrevXForm;
+}
+
+static const uint kLdsPitch = 18;
+static const uint kLdsSize = kLdsPitch * kLdsPitch;
+
+groupshared float ldsDepth[kLdsSize];
+groupshared float ldsVelX[kLdsSize];
+groupshared float ldsVelY[kLdsSize];
+groupshared float ldsVelZ[kLdsSize];
+
+// Same as CameraVelocityCS with USE_LINEAR_Z
+float3 ComputeVelocity( uint2 st, float Depth )
+{
+    float2 CurPixel = st + 0.5;
+    float4 HPos = float4( CurPixel * Depth, 1.0, Depth );
+    float4 PrevHPos = mul( CurToPrevXForm, HPos );
+    PrevHPos.xy /= PrevHPos.w;
+    return float3(PrevHPos.xy, PrevHPos.w) - float3(CurPixel, Depth);
+}
+
+// Matches the tie breaking of GetClosestPixel() in TemporalBlendCS
+uint GetClosestIdx( uint Idx )
+{
+    float DepthO = ldsDepth[Idx];
+    float DepthW = ldsDepth[Idx - 1];
+    float DepthE = ldsDepth[Idx + 1];
+    float DepthN = ldsDepth[Idx - kLdsPitch];
+    float DepthS = ldsDepth[Idx + kLdsPitch];
+
+    float ClosestDepth = min(DepthO, min(min(DepthW, DepthE), min(DepthN, DepthS)));
+
+    if (DepthN == ClosestDepth)
+        return Idx - kLdsPitch;
+    else if (DepthS == ClosestDepth)
+        return Idx + kLdsPitch;
+    else if (DepthW == ClosestDepth)
+        return Idx - 1;
+    else if (DepthE == ClosestDepth)
+        return Idx + 1;
+
+    return Idx;
+}
+
+[RootSignature(MotionBlur_RootSig)]
+[numthreads( 8, 8, 1 )]
+void main( uint3 Gid : SV_GroupID, uint GI : SV_GroupIndex, uint3 GTid : SV_GroupThreadID )
+{
+    uint2 Dim;
+    DepthBuffer.GetDimensions(Dim.x, Dim.y);
+
+    // Border pixels off the screen repeat the edge so that they never win the closest depth search
+    int2 TileOrigin = Gid.xy * 16 - 1;
+    for (uint i = GI; i < kLdsSize; i += 64)
+    {
+        uint2 st = clamp(TileOrigin + int2(i % kLdsPitch, i / kLdsPitch), 0, int2(Dim) - 1);
+        float Depth = DepthBuffer[st];
+        float3 Velocity = ComputeVelocity(st, Depth);
+        ldsDepth[i] = Depth;
+        ldsVelX[i] = Velocity.x;
+        ldsVelY[i] = Velocity.y;
+        ldsVelZ[i] = Velocity.z;
+    }
+
+    GroupMemoryBarrierWithGroupSync();
+
+    // Each thread dilates a 2x2 quad of the tile
+    float MaxSpeed = 0.0;
+
+    [unroll]
+    for (uint j = 0; j < 4; ++j)
+    {
+        uint2 Local = GTid.xy * 2 + uint2(j & 1, j >> 1);
+        uint Idx = (Local.y + 1) * kLdsPitch + Local.x + 1;
+        uint ClosestIdx = GetClosestIdx(Idx);
+
+        float3 Velocity = float3(ldsVelX[ClosestIdx], ldsVelY[ClosestIdx],
+            ldsVelZ[ClosestIdx] + ldsDepth[ClosestIdx] - ldsDepth[Idx]);
+
+        packed_velocity_t PackedVelocity = PackVelocity(Velocity);
+        VelocityBuffer[Gid.xy * 16 + Local] = PackedVelocity;
+
+        // Classify with the velocity the final pass will read back
+        MaxSpeed = max(MaxSpeed, length(UnpackVelocity(PackedVelocity).xy));
+    }
+
+    MaxSpeed = GroupReduceMax(MaxSpeed, GI);
+
+    if (GI == 0)
+        TileMaxVelocity[Gid.xy] = MaxSpeed;
+}
@@ -15,11 +15,9 @@
 
 cbuffer cbFontParams : register(b0)
 {
-    float4 Color;
     float2 ShadowOffset;
     float ShadowHardness;
     float ShadowOpacity;
-    float HeightRange;    // The range of the signed distance field.
 }
 
 Texture2D<float> SignedDistanceFieldTex : register( t0 );
@@ -29,15 +27,17 @@ struct PS_INPUT
 {
     float4 pos : SV_POSITION;
     float2 uv : TEXCOORD0;
+    nointerpolation float4 Color : COLOR;
+    nointerpolation float HeightRange : TEXCOORD1;    // The range of the signed distance field.
 };
 
-float GetAlpha( float2 uv )
+float GetAlpha( float2 uv, float range )
 {
-    return saturate(SignedDistanceFieldTex.Sample(LinearSampler, uv) * HeightRange + 0.5);
+    return saturate(SignedDistanceFieldTex.Sample(LinearSampler, uv) * range + 0.5);
 }
 
 [RootSignature(Text_RootSig)]
 float4 main( PS_INPUT Input ) : SV_Target
 {
-    return float4(Color.rgb, 1) * GetAlpha(Input.uv) * Color.a;
+    return float4(Input.Color.rgb, 1) * GetAlpha(Input.uv, Input.HeightRange) * Input.Color.a;
 }
@@ -18,29 +18,34 @@ cbuffer cbFontParams : register(b0)
     float2 Scale;            // Scale and offset for transforming coordinates
     float2 Offset;
     float2 InvTexDim;        // Normalizes texture coordinates
-    float TextSize;            // Height of text in destination pixels
-    float TextScale;        // TextSize / FontHeight
-    float DstBorder;        // Extra space around a glyph measured in screen space coordinates
+    float RcpFontHeight;    // Converts text size to the scale of texels
+    float AntialiasRange;    // Scales text size to the range of the signed distance field
     uint SrcBorder;            // Extra spacing around glyphs to avoid sampling neighboring glyphs
 }
 
 struct VS_INPUT
 {
     float2 ScreenPos : POSITION;    // Upper-left position in screen pixel coordinates
-    uint4  Glyph : TEXCOORD;        // X, Y, Width, Height in texel space
+    uint4  Glyph : TEXCOORD0;        // X, Y, Width, Height in texel space
+    float TextSize : TEXCOORD1;        // Height of text in destination pixels
+    float4 Color : COLOR;
 };
 
 struct VS_OUTPUT
 {
     float4 Pos : SV_POSITION;    // Upper-left and lower-right coordinates in clip space
     float2 Tex : TEXCOORD0;        // Upper-left and lower-right normalized UVs
+    nointerpolation float4 Color : COLOR;
+    nointerpolation float HeightRange : TEXCOORD1;    // The range of the signed distance field
 };
 
 [RootSignature(Text_RootSig)]
 VS_OUTPUT main( VS_INPUT input, uint VertID : SV_VertexID )
 {
+    const float TextScale = input.TextSize * RcpFontHeight;
+    const float DstBorder = SrcBorder * TextScale;    // Extra space around a glyph measured in screen space coordinates
     const float2 xy0 = input.ScreenPos - DstBorder;
-    const float2 xy1 = input.ScreenPos + DstBorder + float2(TextScale * input.Glyph.z, TextSize);
+    const float2 xy1 = input.ScreenPos + DstBorder + float2(TextScale * input.Glyph.z, input.TextSize);
     const uint2 uv0 = input.Glyph.xy - SrcBorder;
     const uint2 uv1 = input.Glyph.xy + SrcBorder + input.Glyph.zw;
 
@@ -49,5 +54,7 @@ VS_OUTPUT main( VS_INPUT input, uint VertID : SV_VertexID )
     VS_OUTPUT output;
     output.Pos = float4( lerp(xy0, xy1, uv) * Scale + Offset, 0, 1 );
     output.Tex = lerp(uv0, uv1, uv) * InvTexDim;
+    output.Color = input.Color;
+    output.HeightRange = max(1.0, input.TextSize * AntialiasRange);
     return output;
 }
@@ -0,0 +1,256 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Developed by Minigraph
+//
+// Encodes an RGBA8 image into BC1, BC3 or BC7 blocks, one 4x4 block per thread.  The endpoints are the corners of
+// the block's bounding box, and every texel takes the step along the line between them nearest to its projection.
+// That is close to what offline encoders find for smooth blocks and cheap enough to run at load time, but blocks
+// holding several unrelated colors come out worse.  BC7 only uses mode 6: one subset with 7-bit RGBA endpoints,
+// a shared low bit per endpoint and 4-bit indices.
+//
+// The blocks are written in rows of RowPitch bytes, the layout a texture upload needs, so the buffer can be copied
+// straight into a BC texture or read back and saved.
+//
+// BC_FORMAT must be 1, 3 or 7.
+//
+
+Texture2D<float4> Source : register(t0);
+RWByteAddressBuffer Output : register(u0);
+
+cbuffer CB0 : register(b0)
+{
+    uint2 BlockCount;
+    uint RowPitch;      // In bytes
+}
+
+// The palette entries in order from the first endpoint to the second
+static const uint kColorIndexOrder[4] = { 0, 2, 3, 1 };
+static const uint kAlphaIndexOrder[8] = { 0, 2, 3, 4, 5, 6, 7, 1 };
+
+void LoadBlock( uint2 Block, out float4 Texels[16] )
+{
+    [unroll]
+    for (uint i = 0; i < 16; ++i)
+        Texels[i] = Source[Block * 4 + uint2(i & 3, i >> 2)];
+}
+
+// The corners of the block's bounding box, moved in by a sixteenth of its size.  A plain range fit spends
+// precision on extremes that only one or two texels reach.
+void FindEndpoints( float4 Texels[16], out float4 MinColor, out float4 MaxColor )
+{
+    MinColor = Texels[0];
+    MaxColor = Texels[0];
+
+    [unroll]
+    for (uint i = 1; i < 16; ++i)
+    {
+        MinColor = min(MinColor, Texels[i]);
+        MaxColor = max(MaxColor, Texels[i]);
+    }
+
+    float4 Inset = (MaxColor - MinColor) / 16.0;
+    MinColor = saturate(MinColor + Inset);
+    MaxColor = saturate(MaxColor - Inset);
+}
+
+// How far Color is along the line from E0 to E1, in [0, 1]
+float Project( float4 Color, float4 E0, float4 E1 )
+{
+    float4 Dir = E1 - E0;
+    float LengthSq = dot(Dir, Dir);
+    return LengthSq > 0.0 ? saturate(dot(Color - E0, Dir) / LengthSq) : 0.0;
+}
+
+uint PackRGB565( float3 Color )
+{
+    uint3 Q = (uint3)round(saturate(Color) * float3(31, 63, 31));
+    return Q.r << 11 | Q.g << 5 | Q.b;
+}
+
+float3 UnpackRGB565( uint Packed )
+{
+    return float3(Packed >> 11, (Packed >> 5) & 63, Packed & 31) / float3(31, 63, 31);
+}
+
+// A four-color BC1 block, which BC3 also uses for its color.  BC1 decoders only use four colors when color 0 is
+// the larger.
+uint2 EncodeColorBlock( float4 Texels[16] )
+{
+    float4 MinColor, MaxColor;
+    FindEndpoints(Texels, MinColor, MaxColor);
+
+    uint Color0 = PackRGB565(MaxColor.rgb);
+    uint Color1 = PackRGB565(MinColor.rgb);
+    if (Color0 < Color1)
+    {
+        uint Temp = Color0;
+        Color0 = Color1;
+        Color1 = Temp;
+    }
+
+    uint2 Block = uint2(Color0 | Color1 << 16, 0);
+    if (Color0 == Color1)
+        return Block;
+
+    // Project onto the endpoints that the decoder will see
+    float4 E0 = float4(UnpackRGB565(Color0), 0.0);
+    float4 E1 = float4(UnpackRGB565(Color1), 0.0);
+
+    [unroll]
+    for (uint i = 0; i < 16; ++i)
+    {
+        uint Step = (uint)round(Project(float4(Texels[i].rgb, 0.0), E0, E1) * 3.0);
+        Block.y |= kColorIndexOrder[Step] << (2 * i);
+    }
+
+    return Block;
+}
+
+// A BC3 alpha block with alpha 0 the larger, which selects six interpolated values between them
+uint2 EncodeAlphaBlock( float4 Texels[16] )
+{
+    float MinAlpha = Texels[0].a;
+    float MaxAlpha = Texels[0].a;
+
+    [unroll]
+    for (uint i = 1; i < 16; ++i)
+    {
+        MinAlpha = min(MinAlpha, Texels[i].a);
+        MaxAlpha = max(MaxAlpha, Texels[i].a);
+    }
+
+    uint Alpha0 = (uint)round(MaxAlpha * 255.0);
+    uint Alpha1 = (uint)round(MinAlpha * 255.0);
+
+    uint2 Block = uint2(Alpha0 | Alpha1 << 8, 0);
+    if (Alpha0 == Alpha1)
+        return Block;
+
+    float A0 = Alpha0 / 255.0;
+    float A1 = Alpha1 / 255.0;
+
+    // Three bits per texel, starting after the two endpoints
+    [unroll]
+    for (uint j = 0; j < 16; ++j)
+    {
+        uint Step = (uint)round(saturate((Texels[j].a - A0) / (A1 - A0)) * 7.0);
+        uint Index = kAlphaIndexOrder[Step];
+        uint Bit = 16 + 3 * j;
+
+        if (Bit < 32)
+            Block.x |= Index << Bit;
+        if (Bit > 29)
+            Block.y |= Bit < 32 ? Index >> (32 - Bit) : Index << (Bit - 32);
+    }
+
+    return Block;
+}
+
+void PutBits( inout uint Bits[4], inout uint Offset, uint Value, uint Count )
+{
+    uint Word = Offset / 32;
+    uint Shift = Offset % 32;
+
+    Bits[Word] |= Value << Shift;
+    if (Shift + Count > 32)
+        Bits[Word + 1] |= Value >> (32 - Shift);
+
+    Offset += Count;
+}
+
+// An endpoint in 7 bits per channel plus a low bit shared by its channels, choosing the shared bit that
+// reproduces it best
+uint4 QuantizeBC7Endpoint( float4 Color, out uint PBit )
+{
+    float4 Value = saturate(Color) * 255.0;
+    float4 Q0 = clamp(round(Value / 2.0), 0.0, 127.0);
+    float4 Q1 = clamp(round((Value - 1.0) / 2.0), 0.0, 127.0);
+    float4 Error0 = Q0 * 2.0 - Value;
+    float4 Error1 = Q1 * 2.0 + 1.0 - Value;
+
+    PBit = dot(Error1, Error1) < dot(Error0, Error0) ? 1 : 0;
+    return (uint4)(PBit ? Q1 : Q0);
+}
+
+uint4 EncodeBC7Block( float4 Texels[16] )
+{
+    float4 MinColor, MaxColor;
+    FindEndpoints(Texels, MinColor, MaxColor);
+
+    uint P0, P1;
+    uint4 Q0 = QuantizeBC7Endpoint(MinColor, P0);
+    uint4 Q1 = QuantizeBC7Endpoint(MaxColor, P1);
+
+    // The 4-bit interpolation weights are nearly i / 15, so the nearest step is nearly the nearest weight
+    float4 E0 = (Q0 * 2 + P0) / 255.0;
+    float4 E1 = (Q1 * 2 + P1) / 255.0;
+
+    uint Indices[16];
+    [unroll]
+    for (uint i = 0; i < 16; ++i)
+        Indices[i] = (uint)round(Project(Texels[i], E0, E1) * 15.0);
+
+    // The first texel's index drops its top bit, so it must be in the lower half.  The weights are
+    // symmetric, so swapping the endpoints mirrors every index.
+    if (Indices[0] > 7)
+    {
+        uint4 TempQ = Q0;
+        Q0 = Q1;
+        Q1 = TempQ;
+
+        uint TempP = P0;
+        P0 = P1;
+        P1 = TempP;
+
+        [unroll]
+        for (uint j = 0; j < 16; ++j)
+            Indices[j] = 15 - Indices[j];
+    }
+
+    uint Bits[4] = { 0, 0, 0, 0 };
+    uint Offset = 0;
+
+    // Mode 6 is six zero bits followed by a one
+    PutBits(Bits, Offset, 1 << 6, 7);
+
+    [unroll]
+    for (uint c = 0; c < 4; ++c)
+    {
+        PutBits(Bits, Offset, Q0[c], 7);
+        PutBits(Bits, Offset, Q1[c], 7);
+    }
+
+    PutBits(Bits, Offset, P0, 1);
+    PutBits(Bits, Offset, P1, 1);
+    PutBits(Bits, Offset, Indices[0], 3);
+
+    [unroll]
+    for (uint k = 1; k < 16; ++k)
+        PutBits(Bits, Offset, Indices[k], 4);
+
+    return uint4(Bits[0], Bits[1], Bits[2], Bits[3]);
+}
+
+[numthreads( 8, 8, 1 )]
+void main( uint3 DTid : SV_DispatchThreadID )
+{
+    if (any(DTid.xy >= BlockCount))
+        return;
+
+    float4 Texels[16];
+    LoadBlock(DTid.xy, Texels);
+
+#if BC_FORMAT == 1
+    Output.Store2(DTid.y * RowPitch + DTid.x * 8, EncodeColorBlock(Texels));
+#elif BC_FORMAT == 3
+    Output.Store4(DTid.y * RowPitch + DTid.x * 16, uint4(EncodeAlphaBlock(Texels), EncodeColorBlock(Texels)));
+#else
+    Output.Store4(DTid.y * RowPitch + DTid.x * 16, EncodeBC7Block(Texels));
+#endif
+}
@@ -0,0 +1,217 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Developed by Minigraph
+//
+// Reductions, scans and stream compaction built on wave intrinsics.  Shaders compiled with DXC for SM 6.0 define
+// _WAVE_OP (see CompileSM6Test.bat) and get the wave versions.  Everything else falls back to group shared memory
+// or to one thread at a time, with the same results.
+//
+// Wave functions may be called from divergent control flow; they only combine the lanes that call them.
+//
+// Group functions need WAVE_UTILITY_GROUP_SIZE, a power of two equal to the thread group size, defined before
+// this file is included.  They must be called by every thread of the group from uniform control flow, and they
+// return the same total to every thread.  They share one scratch array that they synchronize themselves, so they
+// can be called back to back.
+//
+
+#ifndef __WAVE_UTILITY_HLSLI__
+#define __WAVE_UTILITY_HLSLI__
+
+// Reserve one element per lane where Append is true in a buffer whose counter is at Counter[Offset].  Returns the
+// reserved index, which is only meaningful where Append is true.  The wave version issues one atomic per wave.
+uint WaveAppendIndex( RWByteAddressBuffer Counter, uint Offset, bool Append )
+{
+#ifdef _WAVE_OP
+    uint AppendCount = WaveActiveCountBits(Append);
+    uint FirstIndex = 0;
+    if (WaveIsFirstLane() && AppendCount > 0)
+        Counter.InterlockedAdd(Offset, AppendCount, FirstIndex);
+    return WaveReadLaneFirst(FirstIndex) + WavePrefixCountBits(Append);
+#else
+    uint Index = 0;
+    if (Append)
+        Counter.InterlockedAdd(Offset, 1, Index);
+    return Index;
+#endif
+}
+
+// Count the active lanes holding the same key as this one.  Exactly one lane per distinct key is the leader, so
+// an atomic add of the count by the leader replaces one atomic per lane.  Without wave ops every lane leads.
+uint WaveMatchCount( uint Key, out bool IsLeader )
+{
+    uint MatchCount = 1;
+    IsLeader = true;
+
+#ifdef _WAVE_OP
+    // Each iteration retires the lanes holding the first remaining lane's key
+    [loop]
+    while (true)
+    {
+        if (WaveReadLaneFirst(Key) == Key)
+        {
+            MatchCount = WaveActiveCountBits(true);
+            IsLeader = WaveIsFirstLane();
+            break;
+        }
+    }
+#endif
+
+    return MatchCount;
+}
+
+// The thread layout the wave-based downsamplers use.  Group index i holds pixel MortonDecode8x8(i) of an 8x8 tile,
+// so every aligned 2x2 block is four consecutive indices and every aligned 4x4 block is sixteen.
+uint2 MortonDecode8x8( uint i )
+{
+    return uint2((i & 1) | (i >> 1 & 2) | (i >> 2 & 4), (i >> 1 & 1) | (i >> 2 & 2) | (i >> 3 & 4));
+}
+
+#ifdef _WAVE_OP
+
+// Sum across each aligned cluster of ClusterSize lanes, a power of two no larger than the wave.  Every lane of a
+// cluster receives the sum.  To map clusters onto pixels, this relies on lanes holding consecutive group indices;
+// current hardware assigns them that way.
+float3 WaveClusterSum( float3 Value, uint ClusterSize )
+{
+    uint Lane = WaveGetLaneIndex();
+    for (uint Offset = 1; Offset < ClusterSize; Offset <<= 1)
+        Value += WaveReadLaneAt(Value, Lane ^ Offset);
+    return Value;
+}
+
+#endif // _WAVE_OP
+
+#ifdef WAVE_UTILITY_GROUP_SIZE
+
+groupshared uint gs_WaveUtilityScratch[WAVE_UTILITY_GROUP_SIZE];
+
+float WaveUtilityOp_Add( float A, float B ) { return A + B; }
+uint WaveUtilityOp_Add( uint A, uint B ) { return A + B; }
+float WaveUtilityOp_Max( float A, float B ) { return max(A, B); }
+uint WaveUtilityOp_Max( uint A, uint B ) { return max(A, B); }
+
+#ifdef _WAVE_OP
+
+// Each wave stores its partial result.  Then every wave combines all of the partials itself, so the total needs
+// no second barrier to reach every thread.
+#define DEFINE_GROUP_REDUCE( Name, Type, AsType, Identity, WaveOp, Op ) \
+    Type Name( Type Value, uint GI ) \
+    { \
+        uint LaneCount = WaveGetLaneCount(); \
+        uint WaveCount = (WAVE_UTILITY_GROUP_SIZE + LaneCount - 1) / LaneCount; \
+        Type WaveResult = WaveOp(Value); \
+        GroupMemoryBarrierWithGroupSync(); \
+        if (WaveIsFirstLane()) \
+            gs_WaveUtilityScratch[GI / LaneCount] = asuint(WaveResult); \
+        GroupMemoryBarrierWithGroupSync(); \
+        Type Partial = Identity; \
+        for (uint i = WaveGetLaneIndex(); i < WaveCount; i += LaneCount) \
+            Partial = Op(Partial, AsType(gs_WaveUtilityScratch[i])); \
+        return WaveOp(Partial); \
+    }
+
+DEFINE_GROUP_REDUCE( GroupReduceSum, float, asfloat, 0.0, WaveActiveSum, WaveUtilityOp_Add )
+DEFINE_GROUP_REDUCE( GroupReduceSum, uint, asuint, 0, WaveActiveSum, WaveUtilityOp_Add )
+DEFINE_GROUP_REDUCE( GroupReduceMax, float, asfloat, -3.402823466e+38, WaveActiveMax, WaveUtilityOp_Max )
+DEFINE_GROUP_REDUCE( GroupReduceMax, uint, asuint, 0, WaveActiveMax, WaveUtilityOp_Max )
+
+#undef DEFINE_GROUP_REDUCE
+
+// Turn per-wave prefixes and totals into group-wide ones
+uint WaveUtilityCombineWaves( uint WavePrefix, uint WaveTotal, uint GI, out uint GroupTotal )
+{
+    uint LaneCount = WaveGetLaneCount();
+    uint WaveIndex = GI / LaneCount;
+    uint WaveCount = (WAVE_UTILITY_GROUP_SIZE + LaneCount - 1) / LaneCount;
+
+    GroupMemoryBarrierWithGroupSync();
+    if (WaveIsFirstLane())
+        gs_WaveUtilityScratch[WaveIndex] = WaveTotal;
+    GroupMemoryBarrierWithGroupSync();
+
+    uint Preceding = 0;
+    uint All = 0;
+    for (uint i = WaveGetLaneIndex(); i < WaveCount; i += LaneCount)
+    {
+        uint Total = gs_WaveUtilityScratch[i];
+        Preceding += i < WaveIndex ? Total : 0;
+        All += Total;
+    }
+
+    GroupTotal = WaveActiveSum(All);
+    return WaveActiveSum(Preceding) + WavePrefix;
+}
+
+// Exclusive prefix sum over the group in thread order
+uint GroupPrefixSum( uint Value, uint GI, out uint GroupTotal )
+{
+    return WaveUtilityCombineWaves(WavePrefixSum(Value), WaveActiveSum(Value), GI, GroupTotal);
+}
+
+// Index of this thread among the threads keeping their element, and how many keep one
+uint GroupCompactIndex( bool Keep, uint GI, out uint KeepCount )
+{
+    return WaveUtilityCombineWaves(WavePrefixCountBits(Keep), WaveActiveCountBits(Keep), GI, KeepCount);
+}
+
+#else // !_WAVE_OP
+
+#define DEFINE_GROUP_REDUCE( Name, Type, AsType, Identity, WaveOp, Op ) \
+    Type Name( Type Value, uint GI ) \
+    { \
+        GroupMemoryBarrierWithGroupSync(); \
+        gs_WaveUtilityScratch[GI] = asuint(Value); \
+        GroupMemoryBarrierWithGroupSync(); \
+        [unroll] \
+        for (uint Stride = WAVE_UTILITY_GROUP_SIZE / 2; Stride > 0; Stride >>= 1) \
+        { \
+            if (GI < Stride) \
+                gs_WaveUtilityScratch[GI] = asuint(Op(AsType(gs_WaveUtilityScratch[GI]), AsType(gs_WaveUtilityScratch[GI + Stride]))); \
+            GroupMemoryBarrierWithGroupSync(); \
+        } \
+        return AsType(gs_WaveUtilityScratch[0]); \
+    }
+
+DEFINE_GROUP_REDUCE( GroupReduceSum, float, asfloat, 0.0, WaveActiveSum, WaveUtilityOp_Add )
+DEFINE_GROUP_REDUCE( GroupReduceSum, uint, asuint, 0, WaveActiveSum, WaveUtilityOp_Add )
+DEFINE_GROUP_REDUCE( GroupReduceMax, float, asfloat, -3.402823466e+38, WaveActiveMax, WaveUtilityOp_Max )
+DEFINE_GROUP_REDUCE( GroupReduceMax, uint, asuint, 0, WaveActiveMax, WaveUtilityOp_Max )
+
+#undef DEFINE_GROUP_REDUCE
+
+// Hillis-Steele scan in group shared memory
+uint GroupPrefixSum( uint Value, uint GI, out uint GroupTotal )
+{
+    GroupMemoryBarrierWithGroupSync();
+    gs_WaveUtilityScratch[GI] = Value;
+    GroupMemoryBarrierWithGroupSync();
+
+    [unroll]
+    for (uint Stride = 1; Stride < WAVE_UTILITY_GROUP_SIZE; Stride <<= 1)
+    {
+        uint Preceding = GI >= Stride ? gs_WaveUtilityScratch[GI - Stride] : 0;
+        GroupMemoryBarrierWithGroupSync();
+        gs_WaveUtilityScratch[GI] += Preceding;
+        GroupMemoryBarrierWithGroupSync();
+    }
+
+    GroupTotal = gs_WaveUtilityScratch[WAVE_UTILITY_GROUP_SIZE - 1];
+    return gs_WaveUtilityScratch[GI] - Value;
+}
+
+uint GroupCompactIndex( bool Keep, uint GI, out uint KeepCount )
+{
+    return GroupPrefixSum(Keep ? 1 : 0, GI, KeepCount);
+}
+
+#endif // _WAVE_OP
+
+#endif // WAVE_UTILITY_GROUP_SIZE
+
+#endif // __WAVE_UTILITY_HLSLI__
@@ -20,24 +20,24 @@ void ShadowBuffer::Create( const std::wstring& Name, uint32_t Width, uint32_t He
 {
     DepthBuffer::Create( Name, Width, Height, DXGI_FORMAT_D16_UNORM, VidMemPtr );
 
-    m_Viewport.TopLeftX = 0.0f;
-    m_Viewport.TopLeftY = 0.0f;
-    m_Viewport.Width = (float)Width;
-    m_Viewport.Height = (float)Height;
-    m_Viewport.MinDepth = 0.0f;
-    m_Viewport.MaxDepth = 1.0f;
-
-    // Prevent drawing to the boundary pixels so that we don't have to worry about shadows stretching
-    m_Scissor.left = 1;
-    m_Scissor.top = 1;
-    m_Scissor.right = (LONG)Width - 2;
-    m_Scissor.bottom = (LONG)Height - 2;
+    InitViewportAndScissor(Width, Height);
 }
 
 void ShadowBuffer::Create( const std::wstring& Name, uint32_t Width, uint32_t Height, EsramAllocator& Allocator )
 {
     DepthBuffer::Create( Name, Width, Height, DXGI_FORMAT_D16_UNORM, Allocator );
 
+    InitViewportAndScissor(Width, Height);
+}
+
+void ShadowBuffer::CreateArray( const std::wstring& Name, uint32_t Width, uint32_t Height, uint32_t ArrayCount )
+{
+    DepthBuffer::CreateArray( Name, Width, Height, ArrayCount, DXGI_FORMAT_D16_UNORM );
+    InitViewportAndScissor(Width, Height);
+}
+
+void ShadowBuffer::InitViewportAndScissor( uint32_t Width, uint32_t Height )
+{
     m_Viewport.TopLeftX = 0.0f;
     m_Viewport.TopLeftY = 0.0f;
     m_Viewport.Width = (float)Width;
@@ -62,5 +62,5 @@ void ShadowBuffer::BeginRendering( GraphicsContext& Context )
 
 void ShadowBuffer::EndRendering( GraphicsContext& Context )
 {
-    Context.TransitionResource(*this, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+    Context.TransitionDepthToReadOnly(*this);
 }
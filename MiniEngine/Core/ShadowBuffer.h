@@ -28,12 +28,21 @@ public:
         D3D12_GPU_VIRTUAL_ADDRESS VidMemPtr = D3D12_GPU_VIRTUAL_ADDRESS_UNKNOWN );
     void Create( const std::wstring& Name, uint32_t Width, uint32_t Height, EsramAllocator& Allocator );
 
+    // Create an array of shadow maps, e.g. one per shadow cascade.  BeginRendering() clears every slice.
+    void CreateArray( const std::wstring& Name, uint32_t Width, uint32_t Height, uint32_t ArrayCount );
+
     D3D12_CPU_DESCRIPTOR_HANDLE GetSRV() const { return GetDepthSRV(); }
 
+    // The viewport and scissor used by BeginRendering().  Contexts recording in parallel need to bind them too.
+    const D3D12_VIEWPORT& GetViewport() const { return m_Viewport; }
+    const D3D12_RECT& GetScissor() const { return m_Scissor; }
+
     void BeginRendering( GraphicsContext& context );
     void EndRendering( GraphicsContext& context );
 
 private:
+    void InitViewportAndScissor( uint32_t Width, uint32_t Height );
+
     D3D12_VIEWPORT m_Viewport;
     D3D12_RECT m_Scissor;
 };
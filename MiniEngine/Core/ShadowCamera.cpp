@@ -13,6 +13,7 @@
 
 #include "pch.h"
 #include "ShadowCamera.h"
+#include <cmath>
 
 using namespace Math;
 
@@ -46,3 +47,46 @@ void GameCore::ShadowCamera::UpdateMatrix(
     // Transform from clip space to texture space
     m_ShadowMatrix =  Matrix4( AffineTransform( Matrix3::MakeScale( 0.5f, -0.5f, 1.0f ), Vector3(0.5f, 0.5f, 0.0f) ) ) * m_ViewProjMatrix;
 }
+
+void GameCore::CascadedShadowCamera::UpdateMatrices(
+    const Camera& ViewCamera, Vector3 LightDirection, uint32_t NumCascades, float MaxDistance, float SplitLambda,
+    float CasterDistance, uint32_t BufferWidth, uint32_t BufferHeight, uint32_t BufferPrecision )
+{
+    ASSERT(NumCascades > 0 && NumCascades <= kMaxCascades);
+    m_NumCascades = NumCascades;
+
+    const float NearClip = ViewCamera.GetNearClip();
+    const float FarClip = std::min(MaxDistance, ViewCamera.GetFarClip());
+
+    // Squared tangent of the angle between the view direction and the frustum's corner rays
+    const Vector3 FarCorner = ViewCamera.GetViewSpaceFrustum().GetFrustumCorner(Frustum::kFarUpperRight);
+    const float TanSq = (FarCorner.GetX() * FarCorner.GetX() + FarCorner.GetY() * FarCorner.GetY()) /
+        (FarCorner.GetZ() * FarCorner.GetZ());
+
+    float SliceNear = NearClip;
+
+    for (uint32_t i = 0; i < NumCascades; ++i)
+    {
+        // Practical split scheme:  blend the logarithmic and uniform split distances
+        const float t = (float)(i + 1) / NumCascades;
+        const float LogSplit = NearClip * std::pow(FarClip / NearClip, t);
+        const float UniformSplit = NearClip + (FarClip - NearClip) * t;
+        const float SliceFar = SplitLambda * LogSplit + (1.0f - SplitLambda) * UniformSplit;
+        m_SplitDistances[i] = SliceFar;
+
+        // The smallest sphere around the slice is centered on the view axis, equidistant from the near and
+        // far corner rings, unless that would put it beyond the far plane.
+        const float CenterDist = std::min(SliceFar, 0.5f * (SliceFar + SliceNear) * (1.0f + TanSq));
+        const float FarOffset = SliceFar - CenterDist;
+        const float Radius = std::sqrt(FarOffset * FarOffset + SliceFar * SliceFar * TanSq);
+
+        const Vector3 SliceCenter = ViewCamera.GetPosition() + ViewCamera.GetForwardVec() * CenterDist;
+
+        // The shadow camera sits on the side of the sphere facing away from the light and looks down the light direction
+        m_Cascades[i].UpdateMatrix(LightDirection, SliceCenter + Normalize(LightDirection) * Radius,
+            Vector3(2.0f * Radius, 2.0f * Radius, 2.0f * Radius + CasterDistance),
+            BufferWidth, BufferHeight, BufferPrecision);
+
+        SliceNear = SliceFar;
+    }
+}
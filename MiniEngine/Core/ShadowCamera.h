@@ -42,4 +42,40 @@ namespace GameCore
         Matrix4 m_ShadowMatrix;
     };
 
+    // Splits the view of a camera into cascades by distance and fits a ShadowCamera to each one.  Each
+    // cascade covers the bounding sphere of its slice of the view frustum, so its size only changes with
+    // the camera's projection, and together with texel snapping this keeps shadow edges from shimmering.
+    class CascadedShadowCamera
+    {
+    public:
+
+        enum { kMaxCascades = 4 };
+
+        CascadedShadowCamera() : m_NumCascades(0) {}
+
+        void UpdateMatrices(
+            const Camera& ViewCamera,    // The camera whose view is covered by the cascades
+            Vector3 LightDirection,        // Direction parallel to light, in direction of travel
+            uint32_t NumCascades,        // Number of cascades, at most kMaxCascades
+            float MaxDistance,            // View distance covered by the last cascade
+            float SplitLambda,            // Blend between uniform (0) and logarithmic (1) split distances
+            float CasterDistance,        // Distance toward the light beyond each cascade to capture occluders
+            uint32_t BufferWidth,        // Shadow buffer width
+            uint32_t BufferHeight,        // Shadow buffer height--usually same as width
+            uint32_t BufferPrecision    // Bit depth of shadow buffer--usually 16 or 24
+            );
+
+        uint32_t GetNumCascades() const { return m_NumCascades; }
+        const ShadowCamera& GetCascade( uint32_t Index ) const { ASSERT(Index < m_NumCascades); return m_Cascades[Index]; }
+
+        // The view distance where cascade Index ends
+        float GetSplitDistance( uint32_t Index ) const { ASSERT(Index < m_NumCascades); return m_SplitDistances[Index]; }
+
+    private:
+
+        uint32_t m_NumCascades;
+        ShadowCamera m_Cascades[kMaxCascades];
+        float m_SplitDistances[kMaxCascades];
+    };
+
 }
@@ -18,8 +18,10 @@
 #include "CommandContext.h"
 #include "SystemTime.h"
 #include "PostEffects.h"
+#include "MotionBlur.h"
 
 #include "CompiledShaders/TemporalBlendCS.h"
+#include "CompiledShaders/TemporalBlendDilatedCS.h"
 #include "CompiledShaders/BoundNeighborhoodCS.h"
 #include "CompiledShaders/ResolveTAACS.h"
 #include "CompiledShaders/SharpenTAACS.h"
@@ -39,6 +41,7 @@ namespace TemporalEffects
     RootSignature s_RootSignature;
 
     ComputePSO s_TemporalBlendCS;
+    ComputePSO s_TemporalBlendDilatedCS;    // When the shared temporal prepass already dilated the velocity
     ComputePSO s_BoundNeighborhoodCS;
     ComputePSO s_SharpenTAACS;
     ComputePSO s_ResolveTAACS;
@@ -71,6 +74,7 @@ void TemporalEffects::Initialize( void )
     ObjName.Finalize();
 
     CreatePSO( s_TemporalBlendCS, g_pTemporalBlendCS );
+    CreatePSO( s_TemporalBlendDilatedCS, g_pTemporalBlendDilatedCS );
     CreatePSO( s_BoundNeighborhoodCS, g_pBoundNeighborhoodCS );
     CreatePSO( s_SharpenTAACS, g_pSharpenTAACS );
     CreatePSO( s_ResolveTAACS, g_pResolveTAACS );
@@ -171,7 +175,7 @@ void TemporalEffects::ApplyTemporalAA(ComputeContext& Context)
     uint32_t Dst = Src ^ 1;
 
     Context.SetRootSignature(s_RootSignature);
-    Context.SetPipelineState(s_TemporalBlendCS);
+    Context.SetPipelineState(MotionBlur::IsVelocityDilated() ? s_TemporalBlendDilatedCS : s_TemporalBlendCS);
 
     __declspec(align(16)) struct ConstantBuffer
     {
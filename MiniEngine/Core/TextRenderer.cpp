@@ -150,6 +150,9 @@ namespace TextRenderer
         // The pixel alpha should range from 0 to 1 over the height range 0.5 +/- 0.5 * aaRange.
         float GetAntialiasRange( float size ) const { return Max( 1.0f, size * m_AntialiasRange ); }
 
+        // The same range per unit of font size.  The text shader applies it to each glyph's size.
+        float GetAntialiasRangeScale( void ) const { return m_AntialiasRange; }
+
     private:
         float m_NormalizeXCoord;
         float m_NormalizeYCoord;
@@ -199,8 +202,10 @@ void TextRenderer::Initialize( void )
     // The glyph vertex description.  One vertex will correspond to a single character.
     D3D12_INPUT_ELEMENT_DESC vertElem[] =
     {
-        { "POSITION", 0, DXGI_FORMAT_R32G32_FLOAT     , 0, 0, D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA, 1 },
-        { "TEXCOORD", 0, DXGI_FORMAT_R16G16B16A16_UINT, 0, 8, D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA, 1 }
+        { "POSITION", 0, DXGI_FORMAT_R32G32_FLOAT     , 0, 0,  D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA, 1 },
+        { "TEXCOORD", 0, DXGI_FORMAT_R16G16B16A16_UINT, 0, 8,  D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA, 1 },
+        { "TEXCOORD", 1, DXGI_FORMAT_R32_FLOAT        , 0, 16, D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA, 1 },
+        { "COLOR",    0, DXGI_FORMAT_R8G8B8A8_UNORM   , 0, 20, D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA, 1 }
     };
 
     s_TextPSO[0].SetRootSignature(s_RootSignature);
@@ -237,6 +242,10 @@ TextContext::TextContext( GraphicsContext& CmdContext, float ViewWidth, float Vi
 {
     m_HDR = FALSE;
     m_CurrentFont = nullptr;
+    m_BatchVerts = nullptr;
+    m_BatchGpuAddress = 0;
+    m_BatchStart = kBatchCapacity;     // Full, so the first glyph reserves a block
+    m_BatchEnd = kBatchCapacity;
     m_ViewWidth = ViewWidth;
     m_ViewHeight = ViewHeight;
 
@@ -254,19 +263,22 @@ TextContext::TextContext( GraphicsContext& CmdContext, float ViewWidth, float Vi
     ResetSettings();
 }
 
+TextContext::~TextContext()
+{
+    Flush();
+}
+
 void TextContext::ResetSettings( void )
 {
+    Flush();
+
     m_EnableShadow = true;
     ResetCursor(0.0f, 0.0f);
     m_ShadowOffsetX = 0.05f;
     m_ShadowOffsetY = 0.05f;
     m_PSParams.ShadowHardness = 0.5f;
     m_PSParams.ShadowOpacity = 1.0f;
-    m_PSParams.TextColor = Color(1.0f, 1.0f, 1.0f, 1.0f);
-
-    m_VSConstantBufferIsStale = true;
-    m_PSConstantBufferIsStale = true;
-    m_TextureIsStale = true;
+    m_TextColor = Color(1.0f, 1.0f, 1.0f, 1.0f).R8G8B8A8();
 
     SetFont( L"default", 24.0f );
 }
@@ -292,31 +304,29 @@ void TextContext::EnableDropShadow(bool enable)
     if (m_EnableShadow == enable)
         return;
 
+    Flush();
     m_EnableShadow = enable;
-
-    m_Context.SetPipelineState( m_EnableShadow ? TextRenderer::s_ShadowPSO[m_HDR] : TextRenderer::s_TextPSO[m_HDR] );
 }
 
 void TextContext::SetShadowOffset(float xPercent, float yPercent)
 {
+    Flush();
     m_ShadowOffsetX = xPercent;
     m_ShadowOffsetY = yPercent;
     m_PSParams.ShadowOffsetX = m_CurrentFont->GetHeight() * m_ShadowOffsetX * m_VSParams.NormalizeX;
     m_PSParams.ShadowOffsetY = m_CurrentFont->GetHeight() * m_ShadowOffsetY * m_VSParams.NormalizeY;
-    m_PSConstantBufferIsStale = true;
 }
 
 void TextContext::SetShadowParams(float opacity, float width)
 {
+    Flush();
     m_PSParams.ShadowHardness = 1.0f / width;
     m_PSParams.ShadowOpacity = opacity;
-    m_PSConstantBufferIsStale = true;
 }
 
 void TextContext::SetColor( Color c )
 {
-    m_PSParams.TextColor = c;
-    m_PSConstantBufferIsStale = true;
+    m_TextColor = c.R8G8B8A8();
 }
 
 float TextContext::GetVerticalSpacing( void )
@@ -329,10 +339,6 @@ void TextContext::Begin( bool EnableHDR )
     ResetSettings();
 
     m_HDR = (BOOL)EnableHDR;
-
-    m_Context.SetRootSignature(TextRenderer::s_RootSignature);
-    m_Context.SetPipelineState(TextRenderer::s_ShadowPSO[m_HDR]);
-    m_Context.SetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP);
 }
 
 void TextContext::SetFont( const wstring& fontName, float size )
@@ -347,41 +353,37 @@ void TextContext::SetFont( const wstring& fontName, float size )
         return;
     }
 
+    // The batch is drawn with a single font texture
+    Flush();
+
     m_CurrentFont = NextFont;
 
     // Check to see if a new size was specified
     if (size > 0.0f)
-        m_VSParams.TextSize = size;
+        m_TextSize = size;
 
     // Update constants directly tied to the font or the font size
-    m_LineHeight = NextFont->GetVerticalSpacing( m_VSParams.TextSize );
+    m_LineHeight = NextFont->GetVerticalSpacing( m_TextSize );
+    m_TextScale = m_TextSize / m_CurrentFont->GetHeight();
     m_VSParams.NormalizeX = m_CurrentFont->GetXNormalizationFactor();
     m_VSParams.NormalizeY = m_CurrentFont->GetYNormalizationFactor();
-    m_VSParams.Scale = m_VSParams.TextSize / m_CurrentFont->GetHeight();
-    m_VSParams.DstBorder = m_CurrentFont->GetBorderSize() * m_VSParams.Scale;
+    m_VSParams.RcpFontHeight = 1.0f / m_CurrentFont->GetHeight();
+    m_VSParams.AntialiasRange = m_CurrentFont->GetAntialiasRangeScale();
     m_VSParams.SrcBorder = m_CurrentFont->GetBorderSize();
     m_PSParams.ShadowOffsetX = m_CurrentFont->GetHeight() * m_ShadowOffsetX * m_VSParams.NormalizeX;
     m_PSParams.ShadowOffsetY = m_CurrentFont->GetHeight() * m_ShadowOffsetY * m_VSParams.NormalizeY;
-    m_PSParams.HeightRange = m_CurrentFont->GetAntialiasRange( m_VSParams.TextSize );
-    m_VSConstantBufferIsStale = true;
-    m_PSConstantBufferIsStale = true;
-    m_TextureIsStale = true;
 }
 
 void TextContext::SetTextSize( float size )
 {
-    if (m_VSParams.TextSize == size)
+    if (m_TextSize == size)
         return;
 
-    m_VSParams.TextSize = size;
-    m_VSConstantBufferIsStale = true;
+    m_TextSize = size;
 
     if (m_CurrentFont != nullptr)
     {
-        m_PSParams.HeightRange = m_CurrentFont->GetAntialiasRange( m_VSParams.TextSize );
-        m_VSParams.Scale = m_VSParams.TextSize / m_CurrentFont->GetHeight();
-        m_VSParams.DstBorder = m_CurrentFont->GetBorderSize() * m_VSParams.Scale;
-        m_PSConstantBufferIsStale = true;
+        m_TextScale = m_TextSize / m_CurrentFont->GetHeight();
         m_LineHeight = m_CurrentFont->GetVerticalSpacing( size );
     }
     else
@@ -390,6 +392,8 @@ void TextContext::SetTextSize( float size )
 
 void TextContext::SetViewSize( float ViewWidth, float ViewHeight )
 {
+    Flush();
+
     m_ViewWidth = ViewWidth;
     m_ViewHeight = ViewHeight;
 
@@ -400,45 +404,42 @@ void TextContext::SetViewSize( float ViewWidth, float ViewHeight )
 
     // Essentially transform from screen coordinates to to clip space with W = 1.
     m_VSParams.ViewportTransform = Vector4(twoDivW, -twoDivH, -vpX * twoDivW - 1.0f, vpY * twoDivH + 1.0f);
-    m_VSConstantBufferIsStale = true;
 }
 
 void TextContext::End( void )
 {
-    m_VSConstantBufferIsStale = true;
-    m_PSConstantBufferIsStale = true;
-    m_TextureIsStale = true;
+    Flush();
 }
 
-void TextContext::SetRenderState( void )
+void TextContext::Flush( void )
 {
-    WARN_ONCE_IF(nullptr == m_CurrentFont, "Attempted to draw text without a font");
-
-    if (m_VSConstantBufferIsStale)
-    {
-        m_Context.SetDynamicConstantBufferView(0, sizeof(m_VSParams), &m_VSParams);
-        m_VSConstantBufferIsStale = false;
-    }
+    if (m_BatchStart == m_BatchEnd)
+        return;
 
-    if (m_PSConstantBufferIsStale)
-    {
-        m_Context.SetDynamicConstantBufferView(1, sizeof(m_PSParams), &m_PSParams);
-        m_PSConstantBufferIsStale = false;
-    }
+    WARN_ONCE_IF(nullptr == m_CurrentFont, "Attempted to draw text without a font");
 
-    if (m_TextureIsStale)
-    {
-        m_Context.SetDynamicDescriptors(2, 0, 1, &m_CurrentFont->GetTexture().GetSRV());
-        m_TextureIsStale = false;
-    }
+    // Other renderers may have used the context since the last batch, so all of the state is set again
+    m_Context.SetRootSignature(TextRenderer::s_RootSignature);
+    m_Context.SetPipelineState( m_EnableShadow ? TextRenderer::s_ShadowPSO[m_HDR] : TextRenderer::s_TextPSO[m_HDR] );
+    m_Context.SetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP);
+    m_Context.SetDynamicConstantBufferView(0, sizeof(m_VSParams), &m_VSParams);
+    m_Context.SetDynamicConstantBufferView(1, sizeof(m_PSParams), &m_PSParams);
+    m_Context.SetDynamicDescriptors(2, 0, 1, &m_CurrentFont->GetTexture().GetSRV());
+
+    D3D12_VERTEX_BUFFER_VIEW VBView;
+    VBView.BufferLocation = m_BatchGpuAddress;
+    VBView.SizeInBytes = kBatchCapacity * sizeof(TextVert);
+    VBView.StrideInBytes = sizeof(TextVert);
+    m_Context.SetVertexBuffer(0, VBView);
+
+    m_Context.DrawInstanced(4, m_BatchEnd - m_BatchStart, 0, m_BatchStart);
+    m_BatchStart = m_BatchEnd;
 }
 
 // These are made with templates to handle char and wchar_t simultaneously.
-UINT TextContext::FillVertexBuffer( TextVert volatile* verts, const char* str, size_t stride, size_t slen )
+void TextContext::FillVertexBuffer( const char* str, size_t stride, size_t slen )
 {
-    UINT charsDrawn = 0;
-
-    const float UVtoPixel = m_VSParams.Scale;
+    const float UVtoPixel = m_TextScale;
 
     float curX = m_TextPosX;
     float curY = m_TextPosY;
@@ -469,57 +470,44 @@ UINT TextContext::FillVertexBuffer( TextVert volatile* verts, const char* str, s
         if (nullptr == gi)
             continue;
 
-        verts->X = curX + (float)gi->bearing * UVtoPixel;
-        verts->Y = curY;
-        verts->U = gi->x;
-        verts->V = gi->y;
-        verts->W = gi->w;
-        verts->H = texelHeight;
-        ++verts;
+        if (m_BatchEnd == kBatchCapacity)
+        {
+            Flush();
+
+            DynAlloc Block = m_Context.ReserveUploadMemory(kBatchCapacity * sizeof(TextVert));
+            m_BatchVerts = (TextVert*)Block.DataPtr;
+            m_BatchGpuAddress = Block.GpuAddress;
+            m_BatchStart = 0;
+            m_BatchEnd = 0;
+        }
+
+        // Upload memory is write-combined, so every field is written once and in order
+        TextVert& vert = m_BatchVerts[m_BatchEnd++];
+        vert.X = curX + (float)gi->bearing * UVtoPixel;
+        vert.Y = curY;
+        vert.U = gi->x;
+        vert.V = gi->y;
+        vert.W = gi->w;
+        vert.H = texelHeight;
+        vert.TextSize = m_TextSize;
+        vert.Color = m_TextColor;
 
         // Advance the cursor position
         curX += (float)gi->advance * UVtoPixel;
-        ++charsDrawn;
     }
 
     m_TextPosX = curX;
     m_TextPosY = curY;
-
-    return charsDrawn;
 }
 
 void TextContext::DrawString( const std::wstring& str )
 {
-    SetRenderState();
-
-    void* stackMem = _malloca((str.size() + 1) * 16);
-    TextVert* vbPtr = Math::AlignUp((TextVert*)stackMem, 16);
-    UINT primCount = FillVertexBuffer(vbPtr, (char*)str.c_str(), 2, str.size());
-
-    if (primCount > 0)
-    {
-        m_Context.SetDynamicVB(0, primCount, sizeof(TextVert), vbPtr);
-        m_Context.DrawInstanced( 4, primCount );
-    }
-
-    _freea(stackMem);
+    FillVertexBuffer((char*)str.c_str(), 2, str.size());
 }
 
 void TextContext::DrawString( const std::string& str )
 {
-    SetRenderState();
-
-    void* stackMem = _malloca((str.size() + 1) * 16);
-    TextVert* vbPtr = Math::AlignUp((TextVert*)stackMem, 16);
-    UINT primCount = FillVertexBuffer(vbPtr, (char*)str.c_str(), 1, str.size());
-
-    if (primCount > 0)
-    {
-        m_Context.SetDynamicVB(0, primCount, sizeof(TextVert), vbPtr);
-        m_Context.DrawInstanced( 4, primCount );
-    }
-
-    _freea(stackMem);
+    FillVertexBuffer((char*)str.c_str(), 1, str.size());
 }
 
 void TextContext::DrawFormattedString( const wchar_t* format, ... )
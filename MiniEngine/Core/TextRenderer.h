@@ -33,10 +33,13 @@ namespace TextRenderer
     class Font;
 }
 
+// Glyphs are written straight into upload memory and drawn in batches, with one instanced draw for every run of
+// strings that share a font, drop shadow settings and view size.  Color and text size can change freely.
 class TextContext
 {
 public:
     TextContext( GraphicsContext& CmdContext, float CanvasWidth = 1920.0f, float CanvasHeight = 1080.0f );
+    ~TextContext();
 
     GraphicsContext& GetCommandContext() const { return m_Context; }
 
@@ -90,6 +93,10 @@ public:
     void Begin( bool EnableHDR = false );
     void End( void );
 
+    // Draw the glyphs batched so far.  Call this before changing the state of the command context (e.g. the
+    // scissor rectangle) between strings.  End() and the destructor also flush.
+    void Flush( void );
+
     // Draw a string
     void DrawString( const std::wstring& str );
     void DrawString( const std::string& str );
@@ -104,40 +111,44 @@ private:
     __declspec(align(16)) struct VertexShaderParams
     {
         Math::Vector4 ViewportTransform;
-        float NormalizeX, NormalizeY, TextSize;
-        float Scale, DstBorder;
+        float NormalizeX, NormalizeY;
+        float RcpFontHeight;        // Converts text size to the scale of texels
+        float AntialiasRange;       // Scales text size to the range of the signed distance field
         uint32_t SrcBorder;
     };
 
     __declspec(align(16)) struct PixelShaderParams
     {
-        Color TextColor;
         float ShadowOffsetX, ShadowOffsetY;
         float ShadowHardness;        // More than 1 will cause aliasing
         float ShadowOpacity;        // Should make less opaque when making softer
-        float HeightRange;
     };
 
-    void SetRenderState(void);
-
-    // 16 Byte structure to represent an entire glyph in the text vertex buffer
-    __declspec(align(16)) struct TextVert
+    // 24 Byte structure to represent an entire glyph in the text vertex buffer
+    struct TextVert
     {
         float X, Y;                // Upper-left glyph position in screen space
         uint16_t U, V, W, H;    // Upper-left glyph UV and the width in texture space
+        float TextSize;         // Height of the text in screen space
+        uint32_t Color;         // R8G8B8A8_UNORM
     };
 
-    UINT FillVertexBuffer( TextVert volatile* verts, const char* str, size_t stride, size_t slen );
-    void DrawStringInternal( const std::string& str );
-    void DrawStringInternal( const std::wstring& str );
+    // Glyphs per block of upload memory.  A full block is flushed and replaced.
+    static const uint32_t kBatchCapacity = 4096;
+
+    void FillVertexBuffer( const char* str, size_t stride, size_t slen );
 
     GraphicsContext& m_Context;
     const TextRenderer::Font* m_CurrentFont;
     VertexShaderParams m_VSParams;
     PixelShaderParams m_PSParams;
-    bool m_VSConstantBufferIsStale;    // Tracks when the CB needs updating
-    bool m_PSConstantBufferIsStale;    // Tracks when the CB needs updating
-    bool m_TextureIsStale;
+    TextVert* m_BatchVerts;             // The current block of upload memory
+    uint64_t m_BatchGpuAddress;
+    uint32_t m_BatchStart;              // The first glyph in the block that has not been drawn
+    uint32_t m_BatchEnd;                // The number of glyphs written to the block
+    uint32_t m_TextColor;
+    float m_TextSize;
+    float m_TextScale;                  // TextSize / FontHeight
     bool m_EnableShadow;
     float m_LeftMargin;
     float m_TextPosX;
@@ -0,0 +1,218 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Developed by Minigraph
+//
+
+#include "pch.h"
+#include "TextureCompressor.h"
+#include "TextureManager.h"
+#include "GraphicsCore.h"
+#include "CommandContext.h"
+#include "GpuBuffer.h"
+#include "ReadbackBuffer.h"
+#include "PlacedResourceAllocator.h"
+#include "dds.h"
+
+#include "CompiledShaders/TextureCompressBC1CS.h"
+#include "CompiledShaders/TextureCompressBC3CS.h"
+#include "CompiledShaders/TextureCompressBC7CS.h"
+
+using namespace Graphics;
+
+namespace
+{
+    const char* s_TranscodeLabels[] = { "Off", "BC1/BC3", "BC7" };
+    EnumVar s_TranscodeMode("Graphics/Textures/Transcode", 1, _countof(s_TranscodeLabels), s_TranscodeLabels);
+
+    RootSignature s_RootSignature;
+    ComputePSO s_CompressCS[3];         // Indexed by Format - 1
+
+    DXGI_FORMAT GetDXGIFormat( TextureCompressor::Format Format, bool sRGB )
+    {
+        switch (Format)
+        {
+        case TextureCompressor::kBC1: return sRGB ? DXGI_FORMAT_BC1_UNORM_SRGB : DXGI_FORMAT_BC1_UNORM;
+        case TextureCompressor::kBC3: return sRGB ? DXGI_FORMAT_BC3_UNORM_SRGB : DXGI_FORMAT_BC3_UNORM;
+        default:                      return sRGB ? DXGI_FORMAT_BC7_UNORM_SRGB : DXGI_FORMAT_BC7_UNORM;
+        }
+    }
+
+    // One mip of blocks in rows of RowSize bytes, behind a DX10 header that records the exact format
+    bool SaveDDS( const wchar_t* FilePath, DXGI_FORMAT Format, uint32_t Width, uint32_t Height, const uint8_t* Blocks,
+        uint32_t RowPitch, uint32_t RowSize, uint32_t RowCount )
+    {
+        using namespace DirectX;
+
+        DDS_HEADER Header = {};
+        Header.size = sizeof(DDS_HEADER);
+        Header.flags = DDS_HEADER_FLAGS_TEXTURE | DDS_HEADER_FLAGS_LINEARSIZE;
+        Header.height = Height;
+        Header.width = Width;
+        Header.pitchOrLinearSize = RowSize * RowCount;
+        Header.mipMapCount = 1;
+        Header.ddspf.size = sizeof(DDS_PIXELFORMAT);
+        Header.ddspf.flags = DDS_FOURCC;
+        Header.ddspf.fourCC = MAKEFOURCC('D', 'X', '1', '0');
+        Header.caps = DDS_SURFACE_FLAGS_TEXTURE;
+
+        DDS_HEADER_DXT10 Extension = {};
+        Extension.dxgiFormat = Format;
+        Extension.resourceDimension = DDS_DIMENSION_TEXTURE2D;
+        Extension.arraySize = 1;
+
+        FILE* File = nullptr;
+        _wfopen_s(&File, FilePath, L"wb");
+        if (File == nullptr)
+            return false;
+
+        bool Succeeded = fwrite(&DDS_MAGIC, sizeof(DDS_MAGIC), 1, File) == 1 &&
+            fwrite(&Header, sizeof(Header), 1, File) == 1 && fwrite(&Extension, sizeof(Extension), 1, File) == 1;
+
+        for (uint32_t Row = 0; Succeeded && Row < RowCount; ++Row)
+            Succeeded = fwrite(Blocks + Row * RowPitch, RowSize, 1, File) == 1;
+
+        fclose(File);
+
+        // Don't leave a truncated file for the next run to trip over
+        if (!Succeeded)
+            _wremove(FilePath);
+
+        return Succeeded;
+    }
+}
+
+void TextureCompressor::Initialize( void )
+{
+    s_RootSignature.Reset(3, 0);
+    s_RootSignature[0].InitAsConstants(0, 3);
+    s_RootSignature[1].InitAsDescriptorRange(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 0, 1);
+    s_RootSignature[2].InitAsDescriptorRange(D3D12_DESCRIPTOR_RANGE_TYPE_UAV, 0, 1);
+    s_RootSignature.Finalize(L"Texture Compressor");
+
+#define CreatePSO( ObjName, ShaderByteCode ) \
+    ObjName.SetRootSignature(s_RootSignature); \
+    ObjName.SetComputeShader(ShaderByteCode, sizeof(ShaderByteCode) ); \
+    ObjName.Finalize();
+
+    CreatePSO( s_CompressCS[kBC1 - 1], g_pTextureCompressBC1CS );
+    CreatePSO( s_CompressCS[kBC3 - 1], g_pTextureCompressBC3CS );
+    CreatePSO( s_CompressCS[kBC7 - 1], g_pTextureCompressBC7CS );
+
+#undef CreatePSO
+}
+
+TextureCompressor::Format TextureCompressor::ChooseFormat( uint32_t Width, uint32_t Height, bool HasAlpha )
+{
+    // The top mip of a BC texture must be whole blocks
+    if (s_TranscodeMode == 0 || Width % 4 != 0 || Height % 4 != 0)
+        return kNone;
+
+    if (s_TranscodeMode == 2)
+        return kBC7;
+
+    return HasAlpha ? kBC3 : kBC1;
+}
+
+bool TextureCompressor::Compress( Format Format, uint32_t Width, uint32_t Height, const uint32_t* Pixels, bool sRGB,
+    ID3D12Resource** Resource, const wchar_t* CachePath )
+{
+    ASSERT(Format != kNone && Width % 4 == 0 && Height % 4 == 0);
+
+    const DXGI_FORMAT CompressedFormat = GetDXGIFormat(Format, sRGB);
+    const uint32_t BlocksWide = Width / 4;
+    const uint32_t BlocksHigh = Height / 4;
+    const uint32_t RowSize = BlocksWide * (Format == kBC1 ? 8 : 16);
+    const uint32_t RowPitch = (uint32_t)Math::AlignUp(RowSize, D3D12_TEXTURE_DATA_PITCH_ALIGNMENT);
+    const uint32_t BufferSize = RowPitch * BlocksHigh;
+
+    D3D12_RESOURCE_DESC TexDesc = {};
+    TexDesc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+    TexDesc.Width = Width;
+    TexDesc.Height = Height;
+    TexDesc.DepthOrArraySize = 1;
+    TexDesc.MipLevels = 1;
+    TexDesc.Format = CompressedFormat;
+    TexDesc.SampleDesc.Count = 1;
+    TexDesc.Layout = D3D12_TEXTURE_LAYOUT_UNKNOWN;
+    TexDesc.Flags = D3D12_RESOURCE_FLAG_NONE;
+
+    if (!PlacedResourceAllocator::CreateResource(TexDesc, D3D12_RESOURCE_STATE_COPY_DEST, nullptr, Resource))
+    {
+        D3D12_HEAP_PROPERTIES HeapProps = {};
+        HeapProps.Type = D3D12_HEAP_TYPE_DEFAULT;
+        HeapProps.CreationNodeMask = 1;
+        HeapProps.VisibleNodeMask = 1;
+
+        if (FAILED(g_Device->CreateCommittedResource(&HeapProps, D3D12_HEAP_FLAG_NONE, &TexDesc,
+            D3D12_RESOURCE_STATE_COPY_DEST, nullptr, MY_IID_PPV_ARGS(Resource))))
+            return false;
+    }
+
+    Texture Source;
+    Source.Create(Width, Height, DXGI_FORMAT_R8G8B8A8_UNORM, Pixels);
+
+    ByteAddressBuffer Blocks;
+    Blocks.Create(L"Texture Compressor Blocks", BufferSize / 4, 4);
+
+    ReadbackBuffer Readback;
+    if (CachePath != nullptr)
+        Readback.Create(L"Texture Compressor Readback", BufferSize / 4, 4);
+
+    ComputeContext& Context = ComputeContext::Begin(L"Compress Texture");
+
+    Context.SetRootSignature(s_RootSignature);
+    Context.SetPipelineState(s_CompressCS[Format - 1]);
+    Context.TransitionResource(Source, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+    Context.TransitionResource(Blocks, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+    Context.SetConstants(0, BlocksWide, BlocksHigh, RowPitch);
+    Context.SetDynamicDescriptor(1, 0, Source.GetSRV());
+    Context.SetDynamicDescriptor(2, 0, Blocks.GetUAV());
+    Context.Dispatch2D(BlocksWide, BlocksHigh);
+
+    // The blocks are laid out like upload data, so the texture takes them with a footprint copy
+    Context.TransitionResource(Blocks, D3D12_RESOURCE_STATE_COPY_SOURCE, true);
+
+    D3D12_TEXTURE_COPY_LOCATION Dest = {};
+    Dest.pResource = *Resource;
+    Dest.Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
+    Dest.SubresourceIndex = 0;
+
+    D3D12_TEXTURE_COPY_LOCATION Src = {};
+    Src.pResource = Blocks.GetResource();
+    Src.Type = D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT;
+    Src.PlacedFootprint.Offset = 0;
+    Src.PlacedFootprint.Footprint.Format = CompressedFormat;
+    Src.PlacedFootprint.Footprint.Width = Width;
+    Src.PlacedFootprint.Footprint.Height = Height;
+    Src.PlacedFootprint.Footprint.Depth = 1;
+    Src.PlacedFootprint.Footprint.RowPitch = RowPitch;
+
+    Context.GetCommandList()->CopyTextureRegion(&Dest, 0, 0, 0, &Src, nullptr);
+
+    GpuResource Compressed(*Resource, D3D12_RESOURCE_STATE_COPY_DEST);
+    Context.TransitionResource(Compressed, D3D12_RESOURCE_STATE_GENERIC_READ, true);
+
+    if (CachePath != nullptr)
+        Context.CopyBuffer(Readback, Blocks);
+
+    Context.Finish(true);
+
+    if (CachePath != nullptr)
+    {
+        const uint8_t* Data = (const uint8_t*)Readback.Map();
+        if (!SaveDDS(CachePath, CompressedFormat, Width, Height, Data, RowPitch, RowSize, BlocksHigh))
+            Utility::Printf(L"Failed to save transcoded texture %s\n", CachePath);
+        Readback.Unmap();
+    }
+
+    Source.Destroy();
+    Blocks.Destroy();
+
+    return true;
+}
@@ -0,0 +1,35 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Developed by Minigraph
+//
+
+#pragma once
+
+#include <cstdint>
+
+struct ID3D12Resource;
+
+// Block-compresses uncompressed images with compute shaders when they are loaded, so that they take an eighth
+// (BC1) or a quarter (BC3, BC7) of the memory and bandwidth of RGBA8.  The encoders (see TextureCompressCS.hlsli)
+// favor speed over the quality of offline tools.
+namespace TextureCompressor
+{
+    enum Format { kNone, kBC1, kBC3, kBC7 };
+
+    void Initialize( void );
+
+    // The format "Graphics/Textures/Transcode" selects for an image, or kNone if it is off or the image isn't made
+    // of whole 4x4 blocks
+    Format ChooseFormat( uint32_t Width, uint32_t Height, bool HasAlpha );
+
+    // Encode a Width x Height RGBA8 image into a new single-mip texture, left in the generic read state.  If
+    // CachePath isn't null, the blocks are also saved there as a DDS file.  Waits for the GPU to finish.
+    bool Compress( Format Format, uint32_t Width, uint32_t Height, const uint32_t* Pixels, bool sRGB,
+        ID3D12Resource** Resource, const wchar_t* CachePath = nullptr );
+}
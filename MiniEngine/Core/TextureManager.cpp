@@ -18,8 +18,18 @@
 #include "DDSTextureLoader.h"
 #include "GraphicsCore.h"
 #include "CommandContext.h"
-#include <map>
+#include "CommandListManager.h"
+#include "UploadManager.h"
+#include "GpuMemory.h"
+#include "PlacedResourceAllocator.h"
+#include "TextureCompressor.h"
+#include "Hash.h"
+#include <unordered_map>
+#include <deque>
 #include <thread>
+#include <atomic>
+#include <algorithm>
+#include <sys/stat.h>
 
 using namespace std;
 using namespace Graphics;
@@ -31,7 +41,8 @@ static UINT BytesPerPixel( DXGI_FORMAT Format )
 
 void Texture::Create( size_t Pitch, size_t Width, size_t Height, DXGI_FORMAT Format, const void* InitialData )
 {
-    m_UsageState = D3D12_RESOURCE_STATE_COPY_DEST;
+    // Created in the common state so that the initial data goes through the copy queue
+    m_UsageState = D3D12_RESOURCE_STATE_COMMON;
 
     D3D12_RESOURCE_DESC texDesc = {};
     texDesc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
@@ -52,8 +63,13 @@ void Texture::Create( size_t Pitch, size_t Width, size_t Height, DXGI_FORMAT For
     HeapProps.CreationNodeMask = 1;
     HeapProps.VisibleNodeMask = 1;
 
-    ASSERT_SUCCEEDED(g_Device->CreateCommittedResource(&HeapProps, D3D12_HEAP_FLAG_NONE, &texDesc,
-        m_UsageState, nullptr, MY_IID_PPV_ARGS(m_pResource.ReleaseAndGetAddressOf())));
+    if (!PlacedResourceAllocator::CreateResource(texDesc, m_UsageState, nullptr, m_pResource.ReleaseAndGetAddressOf()))
+    {
+        ASSERT_SUCCEEDED(g_Device->CreateCommittedResource(&HeapProps, D3D12_HEAP_FLAG_NONE, &texDesc,
+            m_UsageState, nullptr, MY_IID_PPV_ARGS(m_pResource.ReleaseAndGetAddressOf())));
+    }
+
+    GpuMemory::Track(m_pResource.Get(), GpuMemory::kTextures);
 
     m_pResource->SetName(L"Texture");
 
@@ -64,12 +80,29 @@ void Texture::Create( size_t Pitch, size_t Width, size_t Height, DXGI_FORMAT For
 
     CommandContext::InitializeTexture(*this, 1, &texResource);
 
-    if (m_hCpuDescriptorHandle.ptr == D3D12_GPU_VIRTUAL_ADDRESS_UNKNOWN)
-        m_hCpuDescriptorHandle = AllocateDescriptor(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+    AllocateSRV();
+    g_Device->CreateShaderResourceView(m_pResource.Get(), nullptr, m_hCpuDescriptorHandle);
+}
+
+bool Texture::CreateCompressed( size_t Width, size_t Height, const uint32_t* Pixels, bool sRGB, bool HasAlpha,
+    const wchar_t* CachePath )
+{
+    TextureCompressor::Format Format = TextureCompressor::ChooseFormat((uint32_t)Width, (uint32_t)Height, HasAlpha);
+    if (Format == TextureCompressor::kNone || !TextureCompressor::Compress(Format, (uint32_t)Width, (uint32_t)Height,
+        Pixels, sRGB, m_pResource.ReleaseAndGetAddressOf(), CachePath))
+        return false;
+
+    m_UsageState = D3D12_RESOURCE_STATE_GENERIC_READ;
+    GpuMemory::Track(m_pResource.Get(), GpuMemory::kTextures);
+
+    m_pResource->SetName(L"Texture");
+
+    AllocateSRV();
     g_Device->CreateShaderResourceView(m_pResource.Get(), nullptr, m_hCpuDescriptorHandle);
+    return true;
 }
 
-void Texture::CreateTGAFromMemory( const void* _filePtr, size_t, bool sRGB )
+void Texture::CreateTGAFromMemory( const void* _filePtr, size_t, bool sRGB, const wchar_t* CachePath )
 {
     const uint8_t* filePtr = (const uint8_t*)_filePtr;
 
@@ -91,44 +124,58 @@ void Texture::CreateTGAFromMemory( const void* _filePtr, size_t, bool sRGB )
     filePtr++;
 
     uint32_t* formattedData = new uint32_t[imageWidth * imageHeight];
-    uint32_t* iter = formattedData;
 
     uint8_t numChannels = bitCount / 8;
-    uint32_t numBytes = imageWidth * imageHeight * numChannels;
+    uint32_t numPixels = imageWidth * imageHeight;
+    uint8_t minAlpha = 0xff;
 
     switch (numChannels)
     {
     default:
         break;
     case 3:
-        for (uint32_t byteIdx = 0; byteIdx < numBytes; byteIdx += 3)
-        {
-            *iter++ = 0xff000000 | filePtr[0] << 16 | filePtr[1] << 8 | filePtr[2];
-            filePtr += 3;
-        }
+        ConvertBGR8ToRGBA8(filePtr, formattedData, numPixels);
         break;
     case 4:
-        for (uint32_t byteIdx = 0; byteIdx < numBytes; byteIdx += 4)
-        {
-            *iter++ = filePtr[3] << 24 | filePtr[0] << 16 | filePtr[1] << 8 | filePtr[2];
-            filePtr += 4;
-        }
+        minAlpha = ConvertBGRA8ToRGBA8(filePtr, formattedData, numPixels);
         break;
     }
 
-    Create( imageWidth, imageHeight, sRGB ? DXGI_FORMAT_R8G8B8A8_UNORM_SRGB : DXGI_FORMAT_R8G8B8A8_UNORM, formattedData );
+    if (!CreateCompressed(imageWidth, imageHeight, formattedData, sRGB, minAlpha < 0xff, CachePath))
+        Create( imageWidth, imageHeight, sRGB ? DXGI_FORMAT_R8G8B8A8_UNORM_SRGB : DXGI_FORMAT_R8G8B8A8_UNORM, formattedData );
 
     delete [] formattedData;
 }
 
-bool Texture::CreateDDSFromMemory( const void* filePtr, size_t fileSize, bool sRGB )
+void Texture::AllocateSRV( void )
 {
     if (m_hCpuDescriptorHandle.ptr == D3D12_GPU_VIRTUAL_ADDRESS_UNKNOWN)
+    {
         m_hCpuDescriptorHandle = AllocateDescriptor(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+        m_OwnsDescriptor = true;
+    }
+}
+
+void Texture::Destroy( void )
+{
+    GpuResource::Destroy();
+
+    if (m_OwnsDescriptor)
+        FreeDescriptor(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, m_hCpuDescriptorHandle);
+    m_OwnsDescriptor = false;
+    m_hCpuDescriptorHandle.ptr = 0;
+}
+
+bool Texture::CreateDDSFromMemory( const void* filePtr, size_t fileSize, bool sRGB )
+{
+    AllocateSRV();
 
     HRESULT hr = CreateDDSTextureFromMemory( Graphics::g_Device,
         (const uint8_t*)filePtr, fileSize, 0, sRGB, &m_pResource, m_hCpuDescriptorHandle );
 
+    if (SUCCEEDED(hr))
+        GpuMemory::Track(m_pResource.Get(), GpuMemory::kTextures);
+
     return SUCCEEDED(hr);
 }
 
@@ -146,37 +193,589 @@ void Texture::CreatePIXImageFromMemory( const void* memBuffer, size_t fileSize )
     ASSERT(fileSize >= header.Pitch * BytesPerPixel(header.Format) * header.Height + sizeof(Header),
         "Raw PIX image dump has an invalid file size");
 
+    // Only tightly packed RGBA8 dumps can be handed to the compressor.  Their alpha isn't checked, so they get a
+    // format with alpha.
+    const uint32_t* Pixels = (const uint32_t*)((uint8_t*)memBuffer + sizeof(Header));
+    if (header.Pitch == header.Width && (header.Format == DXGI_FORMAT_R8G8B8A8_UNORM || header.Format == DXGI_FORMAT_R8G8B8A8_UNORM_SRGB) &&
+        CreateCompressed(header.Width, header.Height, Pixels, header.Format == DXGI_FORMAT_R8G8B8A8_UNORM_SRGB, true, nullptr))
+        return;
+
     Create(header.Pitch, header.Width, header.Height, header.Format, (uint8_t*)memBuffer + sizeof(Header));
 }
 
 namespace TextureManager
 {
     wstring s_RootPath = L"";
-    map< wstring, unique_ptr<ManagedTexture> > s_TextureCache;
+
+    // The cache is split into shards, each with its own lock, so that loaders working on different textures
+    // rarely contend.  A path is hashed once.  The top bits of the hash pick the shard, and the whole hash buckets
+    // the path within it.
+    struct PathKey
+    {
+        size_t Hash;
+        wstring Path;
+
+        bool operator== ( const PathKey& Rhs ) const { return Hash == Rhs.Hash && Path == Rhs.Path; }
+    };
+
+    struct PathKeyHasher
+    {
+        size_t operator() ( const PathKey& Key ) const { return Key.Hash; }
+    };
+
+    struct CacheShard
+    {
+        mutex Mutex;
+        unordered_map< PathKey, unique_ptr<ManagedTexture>, PathKeyHasher > Textures;
+    };
+
+    const uint32_t kNumCacheShards = 32;
+    CacheShard s_CacheShards[kNumCacheShards];
+
+    size_t HashPath( const wstring& Path )
+    {
+        const uint32_t* Begin = (const uint32_t*)Path.data();
+        size_t Hash = Utility::HashRange(Begin, Begin + Path.size() / 2, 2166136261U);
+        if (Path.size() & 1)
+        {
+            const uint32_t Last = Path.back();
+            Hash = Utility::HashRange(&Last, &Last + 1, Hash);
+        }
+        return Hash;
+    }
+
+    CacheShard& GetCacheShard( size_t PathHash )
+    {
+        return s_CacheShards[(uint32_t)PathHash >> 27];
+    }
+
+    // Textures whose last reference has been dropped, waiting for Update() to unload them
+    mutex s_UnloadMutex;
+    vector< unique_ptr<ManagedTexture> > s_UnloadedTextures;
+
+    // The default textures hold on to themselves so that they are never unloaded
+    TextureRef s_BlackTexture;
+    TextureRef s_WhiteTexture;
+    TextureRef s_MagentaTexture;
+
+    BoolVar s_AsyncStreaming("Graphics/Textures/Async Streaming", true);
+    BoolVar s_Defragment("Graphics/Textures/Defragment", true);
+    BoolVar s_CacheTranscoded("Graphics/Textures/Cache Transcoded", false);
+    IntVar s_DefragmentMovesPerFrame("Graphics/Textures/Defragment Moves", 16, 1, 256);
+
+    // Streamed textures are first created without mips larger than this, and only get them once
+    // ManagedTexture::RequestResolution() asks for them
+    BoolVar s_OnDemandResidency("Graphics/Textures/On-Demand Residency", true);
+    IntVar s_InitialResolution("Graphics/Textures/Initial Resolution", 256, 16, 16384);
+
+    // Mips no larger than this are uploaded together as soon as the file has been read
+    const UINT kMipTailSize = 64;
+
+    struct StreamingTexture
+    {
+        ManagedTexture* Texture;
+        wstring Name;
+        bool sRGB;
+        Utility::ByteArray FileData;        // The subresource data points into this.  Kept until nothing more can be requested.
+        Microsoft::WRL::ComPtr<ID3D12Resource> Resource;    // Receives uploads until every mip has been submitted
+        vector<D3D12_SUBRESOURCE_DATA> Subresources;
+        UINT SubresourceCount;              // Of the resource
+
+        // Without FileData, mips are read from FilePath as they are submitted
+        wstring FilePath;
+        DDSFileIndex Index;
+        UINT SkipMip;                       // The file's mip that is the resource's mip 0
+
+        D3D12_SHADER_RESOURCE_VIEW_DESC ViewDesc;
+        UINT Width;
+        UINT Height;
+        UINT NextMip;                       // This mip and smaller ones have been submitted
+        UINT Resolution;                    // The larger dimension of the resource's top mip
+        UINT FullResolution;                // The larger dimension of the file's top mip
+
+        // Guarded by s_StreamingMutex
+        UINT RequestedResolution;
+        bool Queued;                        // Waiting for or undergoing refinement
+    };
+
+    struct PendingView
+    {
+        ManagedTexture* Texture;
+        Microsoft::WRL::ComPtr<ID3D12Resource> Resource;
+        D3D12_SHADER_RESOURCE_VIEW_DESC ViewDesc;
+        UploadManager::UploadToken Upload;
+        bool LoadFailed;
+    };
+
+    // Textures moved by defragmentation.  Frames recorded until the next Update() may still use descriptors
+    // copied before the move, so the fence is only taken then.
+    struct RetiredResource
+    {
+        Microsoft::WRL::ComPtr<ID3D12Resource> Resource;
+        uint64_t FenceValue;        // Zero until the next Update()
+    };
+
+    vector<RetiredResource> s_RetiredResources;
+    uint32_t s_StalledAllocationCount = UINT32_MAX;
+
+    mutex s_StreamingMutex;
+    vector< shared_ptr<StreamingTexture> > s_RefineQueue;
+    deque<PendingView> s_PendingViews;
+    bool s_RefineWorkerActive = false;
+    uint32_t s_DescriptorVersion = 0;
+    atomic<uint32_t> s_NumActiveReads(0);
+    atomic<bool> s_StreamingStopped(false);
+
+    const Texture& GetMagentaTex2D(void);
+    void RefineStreamingTextures(void);
+
+    // The larger dimension of the top mip stored in a DDS file
+    UINT GetDDSResolution( const Utility::ByteArray& Data )
+    {
+        // The magic number and the header's size and flags come ahead of its height and width
+        uint32_t Dimensions[2] = {};
+        if (Data->size() >= 20)
+            memcpy(Dimensions, Data->data() + 12, sizeof(Dimensions));
+        return max(Dimensions[0], Dimensions[1]);
+    }
+
+    // Create a resource for the mips of the file no larger than MaxSize, or for all of them if it is zero.  Tex
+    // is left alone if that fails.
+    bool CreateStreamingResource( StreamingTexture& Tex, UINT MaxSize )
+    {
+        Microsoft::WRL::ComPtr<ID3D12Resource> Resource;
+        vector<D3D12_SUBRESOURCE_DATA> Subresources;
+        D3D12_SHADER_RESOURCE_VIEW_DESC ViewDesc;
+        UINT SkipMip = 0;
+        UINT SubresourceCount;
+
+        if (Tex.FileData != nullptr)
+        {
+            HRESULT hr = CreateDDSTextureFromMemoryDeferred(g_Device, Tex.FileData->data(), Tex.FileData->size(), MaxSize,
+                Tex.sRGB, Resource.GetAddressOf(), Subresources, ViewDesc);
+            if (FAILED(hr))
+                return false;
+
+            SubresourceCount = (UINT)Subresources.size();
+        }
+        else
+        {
+            HRESULT hr = CreateDDSTextureFromIndex(g_Device, Tex.Index, MaxSize, Tex.sRGB, Resource.GetAddressOf(),
+                ViewDesc, SkipMip);
+            if (FAILED(hr))
+                return false;
+
+            SubresourceCount = (Tex.Index.mipCount - SkipMip) * Tex.Index.arraySize;
+        }
+
+        Resource->SetName(Tex.Name.c_str());
+        GpuMemory::Track(Resource.Get(), GpuMemory::kTextures);
+
+        const D3D12_RESOURCE_DESC Desc = Resource->GetDesc();
+        Tex.Resource = Resource;
+        Tex.Subresources.swap(Subresources);
+        Tex.SubresourceCount = SubresourceCount;
+        Tex.SkipMip = SkipMip;
+        Tex.ViewDesc = ViewDesc;
+        Tex.Width = (UINT)Desc.Width;
+        Tex.Height = Desc.Height;
+        Tex.NextMip = SubresourceCount;
+        Tex.Resolution = max(Tex.Width, Tex.Height);
+        return true;
+    }
+
+    // The first mip of a 2D texture that fits within MaxWidth x MaxHeight.  The smallest mip is always included.
+    UINT FindFirstMip( const StreamingTexture& Tex, UINT MaxWidth, UINT MaxHeight )
+    {
+        UINT FirstMip = Tex.NextMip - 1;
+        while (FirstMip > 0 && (Tex.Width >> (FirstMip - 1)) <= MaxWidth && (Tex.Height >> (FirstMip - 1)) <= MaxHeight)
+            --FirstMip;
+        return FirstMip;
+    }
+
+    // The larger dimension of the most detailed mip submitted so far
+    UINT GetSubmittedResolution( const StreamingTexture& Tex )
+    {
+        return Tex.Resolution >> Tex.NextMip;
+    }
+
+    // Read subresources [First, First + Count) of the resource from the file.  They are all requested at once,
+    // each straight from its offset in the file.
+    bool ReadSubresources( const StreamingTexture& Tex, UINT First, UINT Count,
+        vector<D3D12_SUBRESOURCE_DATA>& SubData, unique_ptr<uint8_t[]>& Buffer )
+    {
+        const UINT FileMips = Tex.Index.mipCount;
+        const UINT ResourceMips = FileMips - Tex.SkipMip;
+
+        vector<const DDSFileIndex::Subresource*> Sources(Count);
+        size_t TotalSize = 0;
+        for (UINT i = 0; i < Count; ++i)
+        {
+            const UINT Slice = (First + i) / ResourceMips;
+            const UINT Mip = (First + i) % ResourceMips;
+            Sources[i] = &Tex.Index.subresources[Slice * FileMips + Tex.SkipMip + Mip];
+            TotalSize += Sources[i]->size;
+        }
+
+        Buffer.reset(new (std::nothrow) uint8_t[TotalSize]);
+        if (Buffer == nullptr)
+            return false;
+
+        vector<Utility::FileRange> Ranges(Count);
+        SubData.resize(Count);
+
+        uint8_t* Dest = Buffer.get();
+        for (UINT i = 0; i < Count; ++i)
+        {
+            Ranges[i] = { Sources[i]->offset, Sources[i]->size, Dest };
+            SubData[i] = { Dest, Sources[i]->rowPitch, Sources[i]->slicePitch };
+            Dest += Sources[i]->size;
+        }
+
+        // The first upload to a resource is what replaces the placeholder or the previous resource
+        const Utility::FileIOPriority Priority = First + Count == Tex.SubresourceCount ?
+            Utility::kIOPriorityHigh : Utility::kIOPriorityNormal;
+
+        return Utility::ReadFileRanges(Tex.FilePath, Ranges.data(), Count, Priority);
+    }
+
+    // Upload mips [FirstMip, NextMip) and queue a view that exposes them once the copy completes.  Only fails
+    // if they had to be read from the file and couldn't be, in which case refinement stops where it is.
+    bool UploadMips( StreamingTexture& Tex, UINT FirstMip )
+    {
+        ASSERT(FirstMip < Tex.NextMip);
+
+        const UINT NumSubresources = Tex.NextMip - FirstMip;
+        const D3D12_SUBRESOURCE_DATA* SubData = Tex.Subresources.data() + FirstMip;
+
+        vector<D3D12_SUBRESOURCE_DATA> ReadData;
+        unique_ptr<uint8_t[]> ReadBuffer;
+        if (Tex.FileData == nullptr)
+        {
+            if (!ReadSubresources(Tex, FirstMip, NumSubresources, ReadData, ReadBuffer))
+            {
+                Utility::Printf(L"Couldn't read mips of %s\n", Tex.FilePath.c_str());
+                Tex.NextMip = 0;
+                Tex.Resource = nullptr;
+                Tex.FullResolution = Tex.Resolution;
+                return false;
+            }
+
+            SubData = ReadData.data();
+        }
+
+        // The data is copied to upload memory before this returns
+        GpuResource Dest(Tex.Resource.Get(), D3D12_RESOURCE_STATE_COMMON);
+        UploadManager::UploadToken Upload = UploadManager::UploadTexture(Dest, FirstMip, NumSubresources, SubData);
+
+        Tex.NextMip = FirstMip;
+
+        // Only simple 2D textures are refined a mip at a time.  Anything else is uploaded in one go.
+        PendingView View = { Tex.Texture, Tex.Resource, Tex.ViewDesc, Upload, false };
+        if (Tex.ViewDesc.ViewDimension == D3D12_SRV_DIMENSION_TEXTURE2D)
+        {
+            View.ViewDesc.Texture2D.MostDetailedMip = FirstMip;
+            View.ViewDesc.Texture2D.MipLevels = Tex.SubresourceCount - FirstMip;
+        }
+
+        // The view holds on to the resource from here.  The texture may still get relocated or promoted.
+        if (Tex.NextMip == 0)
+            Tex.Resource = nullptr;
+
+        lock_guard<mutex> Guard(s_StreamingMutex);
+        s_PendingViews.push_back(View);
+        return true;
+    }
+
+    // Recreate the texture from its file with larger mips.  The new resource first receives every mip the old
+    // one had in one upload, so it replaces the old one without looking any blurrier.
+    void PromoteStreamingTexture( StreamingTexture& Tex )
+    {
+        UINT MaxSize;
+        {
+            lock_guard<mutex> Guard(s_StreamingMutex);
+            MaxSize = Tex.RequestedResolution;
+        }
+
+        // Even odd-sized textures have to gain a mip, or the request would never be met
+        MaxSize = max(MaxSize, Tex.Resolution * 2 + 1);
+
+        const UINT OldWidth = Tex.Width;
+        const UINT OldHeight = Tex.Height;
+        if (!CreateStreamingResource(Tex, MaxSize >= Tex.FullResolution ? 0 : MaxSize))
+        {
+            // Probably out of memory, so settle for what is resident
+            Tex.FullResolution = Tex.Resolution;
+            return;
+        }
+
+        if (Tex.ViewDesc.ViewDimension != D3D12_SRV_DIMENSION_TEXTURE2D)
+            UploadMips(Tex, 0);
+        else
+            UploadMips(Tex, FindFirstMip(Tex, OldWidth, OldHeight));
+    }
+
+    // Queue Tex if it has mips left to submit or has been asked for larger ones than it has.  Otherwise it is
+    // done until the next request, and once nothing more can be requested, its file is released.  Call with
+    // s_StreamingMutex held and Tex not already queued.
+    void ScheduleRefinement( const shared_ptr<StreamingTexture>& Tex )
+    {
+        if (Tex->NextMip > 0 || (Tex->Resolution < Tex->FullResolution && Tex->RequestedResolution > Tex->Resolution))
+        {
+            Tex->Queued = true;
+            s_RefineQueue.push_back(Tex);
+
+            if (!s_RefineWorkerActive)
+            {
+                s_RefineWorkerActive = true;
+                Concurrency::create_task(RefineStreamingTextures);
+            }
+        }
+        else
+        {
+            Tex->Queued = false;
+
+            if (Tex->Resolution >= Tex->FullResolution)
+            {
+                Tex->FileData.reset();
+                Tex->Subresources.clear();
+                Tex->Index.subresources.clear();
+            }
+        }
+    }
+
+    // Adds one mip at a time, always to whichever texture is currently the blurriest, so that every
+    // texture becomes usable before any of them receives its top mip.  Textures asked for larger mips than
+    // they have are recreated with them once everything they have is resident.
+    void RefineStreamingTextures( void )
+    {
+        while (true)
+        {
+            shared_ptr<StreamingTexture> Tex;
+            {
+                lock_guard<mutex> Guard(s_StreamingMutex);
+                if (s_RefineQueue.empty() || s_StreamingStopped)
+                {
+                    s_RefineWorkerActive = false;
+                    return;
+                }
+
+                auto Blurriest = min_element(s_RefineQueue.begin(), s_RefineQueue.end(),
+                    [](const shared_ptr<StreamingTexture>& A, const shared_ptr<StreamingTexture>& B)
+                    { return GetSubmittedResolution(*A) < GetSubmittedResolution(*B); } );
+
+                Tex = *Blurriest;
+                s_RefineQueue.erase(Blurriest);
+            }
+
+            if (Tex->NextMip > 0)
+                UploadMips(*Tex, Tex->NextMip - 1);
+            else
+                PromoteStreamingTexture(*Tex);
+
+            lock_guard<mutex> Guard(s_StreamingMutex);
+            ScheduleRefinement(Tex);
+        }
+    }
+
+    void QueueLoadFailure( ManagedTexture* Texture )
+    {
+        PendingView View = {};
+        View.Texture = Texture;
+        View.LoadFailed = true;
+
+        lock_guard<mutex> Guard(s_StreamingMutex);
+        s_PendingViews.push_back(View);
+    }
+
+    void ReleaseRetiredResources( void )
+    {
+        CommandQueue& GraphicsQueue = g_CommandManager.GetGraphicsQueue();
+
+        size_t NumRetired = 0;
+        for (RetiredResource& Retired : s_RetiredResources)
+        {
+            if (Retired.FenceValue == 0)
+                Retired.FenceValue = GraphicsQueue.GetNextFenceValue();
+            else if (GraphicsQueue.IsFenceComplete(Retired.FenceValue))
+                continue;
+
+            s_RetiredResources[NumRetired++] = move(Retired);
+        }
+        s_RetiredResources.resize(NumRetired);
+    }
+
+    void ReleaseUnloadedTextures( void )
+    {
+        lock_guard<mutex> Guard(s_UnloadMutex);
+
+        size_t NumPending = 0;
+        for (unique_ptr<ManagedTexture>& Tex : s_UnloadedTextures)
+        {
+            if (!Tex->Unload())
+                s_UnloadedTextures[NumPending++] = move(Tex);
+        }
+        s_UnloadedTextures.resize(NumPending);
+    }
+
+    // Small textures that outlive the ones loaded alongside them leave their heaps mostly empty.  Moving them
+    // into fuller heaps frees the sparse ones.
+    void DefragmentTextures( void )
+    {
+        if (!s_Defragment || !PlacedResourceAllocator::NeedsDefragment())
+            return;
+
+        // The sparse heaps may hold textures that can't move.  A pass that moves nothing isn't repeated until
+        // resources come or go.
+        const uint32_t NumAllocations = PlacedResourceAllocator::GetStats().NumAllocations;
+        if (NumAllocations == s_StalledAllocationCount)
+            return;
+
+        // Streaming writes views of its own and may swap in new resources, so leave textures alone until it has
+        // settled
+        {
+            lock_guard<mutex> Guard(s_StreamingMutex);
+            if (s_NumActiveReads > 0 || s_RefineWorkerActive || !s_RefineQueue.empty() || !s_PendingViews.empty())
+                return;
+        }
+
+        CommandContext* Context = nullptr;
+        int32_t NumMoves = 0;
+        for (uint32_t i = 0; i < kNumCacheShards && NumMoves < s_DefragmentMovesPerFrame; ++i)
+        {
+            lock_guard<mutex> Guard(s_CacheShards[i].Mutex);
+            for (auto& Entry : s_CacheShards[i].Textures)
+            {
+                ManagedTexture& Tex = *Entry.second;
+                if (!Tex.IsValid() || Tex.GetResource() == nullptr)
+                    continue;
+
+                if (Context == nullptr)
+                    Context = &CommandContext::Begin(L"Texture Defragmentation");
+
+                if (Tex.Relocate(*Context) && ++NumMoves == s_DefragmentMovesPerFrame)
+                    break;
+            }
+        }
+
+        if (Context != nullptr)
+            Context->Finish();
+
+        if (NumMoves > 0)
+            ++s_DescriptorVersion;
+        else
+            s_StalledAllocationCount = NumAllocations;
+    }
+
+    void Update( void )
+    {
+        // Everything the loaders uploaded since the last frame goes to the copy queue as one batch
+        UploadManager::Flush();
+
+        ReleaseRetiredResources();
+        ReleaseUnloadedTextures();
+        DefragmentTextures();
+
+        lock_guard<mutex> Guard(s_StreamingMutex);
+
+        // Views for a given texture are queued in submission order, and a queue's fences complete in order,
+        // so publishing every completed view in list order never replaces a view with a blurrier one.
+        bool Published = false;
+        for (auto iter = s_PendingViews.begin(); iter != s_PendingViews.end(); )
+        {
+            if (iter->LoadFailed)
+            {
+                g_Device->CopyDescriptorsSimple(1, iter->Texture->GetSRV(), GetMagentaTex2D().GetSRV(),
+                    D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+                iter = s_PendingViews.erase(iter);
+                Published = true;
+            }
+            else if (UploadManager::IsComplete(iter->Upload))
+            {
+                iter->Texture->PublishView(iter->Resource.Get(), iter->ViewDesc);
+                iter = s_PendingViews.erase(iter);
+                Published = true;
+            }
+            else
+                ++iter;
+        }
+
+        if (Published)
+            ++s_DescriptorVersion;
+    }
+
+    uint32_t GetDescriptorVersion( void )
+    {
+        return s_DescriptorVersion;
+    }
+
+    void StopStreaming( void )
+    {
+        s_StreamingStopped = true;
+
+        while (s_NumActiveReads > 0)
+            this_thread::yield();
+
+        while (true)
+        {
+            {
+                lock_guard<mutex> Guard(s_StreamingMutex);
+                if (!s_RefineWorkerActive)
+                    break;
+            }
+            this_thread::yield();
+        }
+
+        // What was waiting for refinement may be unloaded now
+        for (const shared_ptr<StreamingTexture>& Tex : s_RefineQueue)
+            Tex->Queued = false;
+
+        s_RefineQueue.clear();
+        s_PendingViews.clear();
+    }
 
     void Initialize( const std::wstring& TextureLibRoot )
     {
         s_RootPath = TextureLibRoot;
+
+        // Streaming was stopped if the textures were shut down for a new device
+        s_StreamingStopped = false;
     }
 
     void Shutdown( void )
     {
-        s_TextureCache.clear();
+        StopStreaming();
+
+        s_BlackTexture = nullptr;
+        s_WhiteTexture = nullptr;
+        s_MagentaTexture = nullptr;
+
+        for (CacheShard& Shard : s_CacheShards)
+            Shard.Textures.clear();
+        s_UnloadedTextures.clear();
+        s_RetiredResources.clear();
     }
 
-    pair<ManagedTexture*, bool> FindOrLoadTexture( const wstring& fileName )
+    // Ref receives a reference to the texture, taken while it can't be unloaded
+    pair<ManagedTexture*, bool> FindOrLoadTexture( const wstring& fileName, TextureRef& Ref )
     {
-        static mutex s_Mutex;
-        lock_guard<mutex> Guard(s_Mutex);
+        PathKey Key = { HashPath(fileName), fileName };
+        CacheShard& Shard = GetCacheShard(Key.Hash);
 
-        auto iter = s_TextureCache.find(fileName);
+        lock_guard<mutex> Guard(Shard.Mutex);
+
+        auto iter = Shard.Textures.find(Key);
 
         // If it's found, it has already been loaded or the load process has begun
-        if (iter != s_TextureCache.end())
+        if (iter != Shard.Textures.end())
+        {
+            Ref = iter->second.get();
             return make_pair(iter->second.get(), false);
+        }
 
-        ManagedTexture* NewTexture = new ManagedTexture(fileName);
-        s_TextureCache[fileName].reset( NewTexture );
+        ManagedTexture* NewTexture = new ManagedTexture(fileName, Key.Hash);
+        Shard.Textures[move(Key)].reset( NewTexture );
+        Ref = NewTexture;
 
         // This was the first time it was requested, so indicate that the caller must read the file
         return make_pair(NewTexture, true);
@@ -184,7 +783,8 @@ namespace TextureManager
 
     const Texture& GetBlackTex2D(void)
     {
-        auto ManagedTex = FindOrLoadTexture(L"DefaultBlackTexture");
+        TextureRef Ref;
+        auto ManagedTex = FindOrLoadTexture(L"DefaultBlackTexture", Ref);
 
         ManagedTexture* ManTex = ManagedTex.first;
         const bool RequestsLoad = ManagedTex.second;
@@ -197,12 +797,14 @@ namespace TextureManager
 
         uint32_t BlackPixel = 0;
         ManTex->Create(1, 1, DXGI_FORMAT_R8G8B8A8_UNORM, &BlackPixel);
+        s_BlackTexture = Ref;
         return *ManTex;
     }
 
     const Texture& GetWhiteTex2D(void)
     {
-        auto ManagedTex = FindOrLoadTexture(L"DefaultWhiteTexture");
+        TextureRef Ref;
+        auto ManagedTex = FindOrLoadTexture(L"DefaultWhiteTexture", Ref);
 
         ManagedTexture* ManTex = ManagedTex.first;
         const bool RequestsLoad = ManagedTex.second;
@@ -215,12 +817,14 @@ namespace TextureManager
 
         uint32_t WhitePixel = 0xFFFFFFFFul;
         ManTex->Create(1, 1, DXGI_FORMAT_R8G8B8A8_UNORM, &WhitePixel);
+        s_WhiteTexture = Ref;
         return *ManTex;
     }
 
     const Texture& GetMagentaTex2D(void)
     {
-        auto ManagedTex = FindOrLoadTexture(L"DefaultMagentaTexture");
+        TextureRef Ref;
+        auto ManagedTex = FindOrLoadTexture(L"DefaultMagentaTexture", Ref);
 
         ManagedTexture* ManTex = ManagedTex.first;
         const bool RequestsLoad = ManagedTex.second;
@@ -233,6 +837,7 @@ namespace TextureManager
 
         uint32_t MagentaPixel = 0x00FF00FF;
         ManTex->Create(1, 1, DXGI_FORMAT_R8G8B8A8_UNORM, &MagentaPixel);
+        s_MagentaTexture = Ref;
         return *ManTex;
     }
 
@@ -246,26 +851,257 @@ void ManagedTexture::WaitForLoad( void ) const
         this_thread::yield();
 }
 
+void ManagedTexture::Release( void ) const
+{
+    using namespace TextureManager;
+
+    // Only the last reference needs the lock, which keeps a lookup from handing out the texture while it leaves
+    // the cache
+    uint32_t RefCount = m_RefCount;
+    while (RefCount > 1)
+    {
+        if (m_RefCount.compare_exchange_weak(RefCount, RefCount - 1))
+            return;
+    }
+
+    unique_ptr<ManagedTexture> Unloaded;
+    {
+        CacheShard& Shard = GetCacheShard(m_PathHash);
+        lock_guard<mutex> Guard(Shard.Mutex);
+
+        if (--m_RefCount > 0)
+            return;
+
+        auto iter = Shard.Textures.find(PathKey{ m_PathHash, m_MapKey });
+        ASSERT(iter != Shard.Textures.end() && iter->second.get() == this);
+        Unloaded = move(iter->second);
+        Shard.Textures.erase(iter);
+    }
+
+    lock_guard<mutex> Guard(s_UnloadMutex);
+    s_UnloadedTextures.push_back(move(Unloaded));
+}
+
+bool ManagedTexture::Unload( void )
+{
+    using namespace TextureManager;
+
+    if (m_ReadPending)
+        return false;
+
+    {
+        lock_guard<mutex> Guard(s_StreamingMutex);
+
+        if (m_Streaming != nullptr && m_Streaming->Queued)
+            return false;
+
+        for (const PendingView& View : s_PendingViews)
+        {
+            if (View.Texture == this)
+                return false;
+        }
+
+        // Refinement may have stopped short, leaving the next resource behind
+        if (m_Streaming != nullptr && m_Streaming->Resource != nullptr)
+        {
+            RetiredResource Retired = { m_Streaming->Resource, 0 };
+            s_RetiredResources.push_back(Retired);
+        }
+        m_Streaming = nullptr;
+    }
+
+    if (m_pResource != nullptr)
+    {
+        RetiredResource Retired = { m_pResource, 0 };
+        s_RetiredResources.push_back(Retired);
+    }
+
+    // The GPU only ever sees copies of the descriptor, so it can be reused right away
+    Destroy();
+    return true;
+}
+
 void ManagedTexture::SetToInvalidTexture( void )
 {
+    if (m_OwnsDescriptor)
+        FreeDescriptor(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, m_hCpuDescriptorHandle);
+    m_OwnsDescriptor = false;
     m_hCpuDescriptorHandle = TextureManager::GetMagentaTex2D().GetSRV();
     m_IsValid = false;
 }
 
-const ManagedTexture* TextureManager::LoadFromFile( const std::wstring& fileName, bool sRGB )
+bool ManagedTexture::Relocate( CommandContext& Context )
+{
+    // The view is rebuilt from the resource alone, which only gives the right view for plain 2D textures
+    const D3D12_RESOURCE_DESC Desc = m_pResource->GetDesc();
+    if (!m_OwnsDescriptor || Desc.Dimension != D3D12_RESOURCE_DIMENSION_TEXTURE2D || Desc.DepthOrArraySize != 1)
+        return false;
+
+    Microsoft::WRL::ComPtr<ID3D12Resource> NewResource;
+    if (!PlacedResourceAllocator::Relocate(m_pResource.Get(), D3D12_RESOURCE_STATE_COPY_DEST, NewResource.GetAddressOf()))
+        return false;
+
+    NewResource->SetName(m_MapKey.c_str());
+    GpuMemory::Track(NewResource.Get(), GpuMemory::kTextures);
+
+    // Loaded textures are either in the common state, which promotes to a copy source, or in a read state
+    // that includes it, so the source needs no barrier
+    GpuResource Source(m_pResource.Get(), D3D12_RESOURCE_STATE_COPY_SOURCE);
+    GpuResource Dest(NewResource.Get(), D3D12_RESOURCE_STATE_COPY_DEST);
+    Context.CopyBuffer(Dest, Source);
+    Context.TransitionResource(Dest, m_UsageState);
+
+    TextureManager::RetiredResource Retired = { m_pResource, 0 };
+    TextureManager::s_RetiredResources.push_back(Retired);
+
+    m_pResource = NewResource;
+    g_Device->CreateShaderResourceView(m_pResource.Get(), nullptr, m_hCpuDescriptorHandle);
+    return true;
+}
+
+void ManagedTexture::PublishView( ID3D12Resource* Resource, const D3D12_SHADER_RESOURCE_VIEW_DESC& ViewDesc )
+{
+    if (Resource != m_pResource.Get())
+    {
+        if (m_pResource != nullptr)
+        {
+            TextureManager::RetiredResource Retired = { m_pResource, 0 };
+            TextureManager::s_RetiredResources.push_back(Retired);
+        }
+        m_pResource = Resource;
+    }
+
+    g_Device->CreateShaderResourceView(Resource, &ViewDesc, m_hCpuDescriptorHandle);
+}
+
+void ManagedTexture::RequestResolution( uint32_t MaxDimension ) const
+{
+    using namespace TextureManager;
+
+    // Round up to a power of two, so that something slowly coming closer isn't recreated every few frames
+    uint32_t Resolution = 1;
+    while (Resolution < MaxDimension && Resolution < D3D12_REQ_TEXTURE2D_U_OR_V_DIMENSION)
+        Resolution <<= 1;
+
+    lock_guard<mutex> Guard(s_StreamingMutex);
+
+    if (m_Streaming == nullptr || Resolution <= m_Streaming->RequestedResolution)
+        return;
+
+    m_Streaming->RequestedResolution = Resolution;
+    if (!m_Streaming->Queued)
+        ScheduleRefinement(m_Streaming);
+}
+
+void ManagedTexture::StreamDDSFromFile( const std::wstring& FilePath, bool sRGB )
+{
+    // Hand out a real descriptor right away so that callers can cache it.  It will be rewritten in place
+    // as mips arrive.
+    D3D12_CPU_DESCRIPTOR_HANDLE Handle = AllocateDescriptor(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+    g_Device->CopyDescriptorsSimple(1, Handle, TextureManager::GetBlackTex2D().GetSRV(), D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+    m_OwnsDescriptor = true;
+    m_hCpuDescriptorHandle = Handle;
+
+    ++TextureManager::s_NumActiveReads;
+    m_ReadPending = true;
+
+    // A zipped file has to be read and inflated in full.  It takes precedence, as with every other file.
+    struct _stat64 fileStat;
+    if (_wstat64((FilePath + L".gz").c_str(), &fileStat) == -1)
+    {
+        Concurrency::create_task([this, FilePath, sRGB]
+        {
+            if (TextureManager::s_StreamingStopped || !StreamDDSFromIndex(FilePath, sRGB))
+                TextureManager::QueueLoadFailure(this);
+
+            // The texture may be unloaded from here on
+            m_ReadPending = false;
+            --TextureManager::s_NumActiveReads;
+        });
+        return;
+    }
+
+    Utility::ReadFileAsync(FilePath).then([this, sRGB](Utility::ByteArray ba)
+    {
+        if (TextureManager::s_StreamingStopped || ba->size() == 0 || !StreamDDSFromMemory(ba, sRGB))
+            TextureManager::QueueLoadFailure(this);
+
+        // The texture may be unloaded from here on
+        m_ReadPending = false;
+        --TextureManager::s_NumActiveReads;
+    });
+}
+
+bool ManagedTexture::StreamDDSFromMemory( const Utility::ByteArray& Data, bool sRGB )
+{
+    using namespace TextureManager;
+
+    shared_ptr<StreamingTexture> Tex = make_shared<StreamingTexture>();
+    Tex->FileData = Data;
+    Tex->FullResolution = GetDDSResolution(Data);
+
+    return BeginStreaming(Tex, sRGB);
+}
+
+// Only the headers are read here.  Every mip is read when it is first submitted.
+bool ManagedTexture::StreamDDSFromIndex( const std::wstring& FilePath, bool sRGB )
+{
+    using namespace TextureManager;
+
+    shared_ptr<StreamingTexture> Tex = make_shared<StreamingTexture>();
+    if (FAILED(CreateDDSIndexFromFile(FilePath.c_str(), Tex->Index)))
+        return false;
+
+    Tex->FilePath = FilePath;
+    Tex->FullResolution = max(Tex->Index.width, Tex->Index.height);
+
+    return BeginStreaming(Tex, sRGB);
+}
+
+bool ManagedTexture::BeginStreaming( const std::shared_ptr<TextureManager::StreamingTexture>& Tex, bool sRGB )
+{
+    using namespace TextureManager;
+
+    Tex->Texture = this;
+    Tex->Name = m_MapKey;
+    Tex->sRGB = sRGB;
+    Tex->RequestedResolution = 0;
+    Tex->Queued = false;
+
+    // The resource replaces the placeholder when its first view is published
+    if (!CreateStreamingResource(*Tex, s_OnDemandResidency ? (UINT)(int32_t)s_InitialResolution : 0))
+        return false;
+
+    // Upload the mip tail first so there is something to sample from, then refine in the background
+    UINT FirstMip = 0;
+    if (Tex->ViewDesc.ViewDimension == D3D12_SRV_DIMENSION_TEXTURE2D)
+        FirstMip = FindFirstMip(*Tex, kMipTailSize, kMipTailSize);
+
+    if (!UploadMips(*Tex, FirstMip))
+        return false;
+
+    lock_guard<mutex> Guard(s_StreamingMutex);
+    m_Streaming = Tex;
+    ScheduleRefinement(Tex);
+
+    return true;
+}
+
+TextureRef TextureManager::LoadFromFile( const std::wstring& fileName, bool sRGB )
 {
     std::wstring CatPath = fileName;
 
-    const ManagedTexture* Tex = LoadDDSFromFile( CatPath + L".dds", sRGB );
+    TextureRef Tex = LoadDDSFromFile( CatPath + L".dds", sRGB );
     if (!Tex->IsValid())
         Tex = LoadTGAFromFile( CatPath + L".tga", sRGB );
 
     return Tex;
 }
 
-const ManagedTexture* TextureManager::LoadDDSFromFile( const std::wstring& fileName, bool sRGB )
+TextureRef TextureManager::LoadDDSFromFile( const std::wstring& fileName, bool sRGB )
 {
-    auto ManagedTex = FindOrLoadTexture(fileName);
+    TextureRef Ref;
+    auto ManagedTex = FindOrLoadTexture(fileName, Ref);
 
     ManagedTexture* ManTex = ManagedTex.first;
     const bool RequestsLoad = ManagedTex.second;
@@ -273,7 +1109,20 @@ const ManagedTexture* TextureManager::LoadDDSFromFile( const std::wstring& fileN
     if (!RequestsLoad)
     {
         ManTex->WaitForLoad();
-        return ManTex;
+        return Ref;
+    }
+
+    if (s_AsyncStreaming && !s_StreamingStopped)
+    {
+        // Check that the file exists up front so that LoadFromFile() can still fall back to other formats
+        const wstring FilePath = s_RootPath + fileName;
+        struct _stat64 fileStat;
+        if (_wstat64(FilePath.c_str(), &fileStat) == -1 && _wstat64((FilePath + L".gz").c_str(), &fileStat) == -1)
+            ManTex->SetToInvalidTexture();
+        else
+            ManTex->StreamDDSFromFile(FilePath, sRGB);
+
+        return Ref;
     }
 
     Utility::ByteArray ba = Utility::ReadFileSync( s_RootPath + fileName );
@@ -282,12 +1131,13 @@ const ManagedTexture* TextureManager::LoadDDSFromFile( const std::wstring& fileN
     else
         ManTex->GetResource()->SetName(fileName.c_str());
 
-    return ManTex;
+    return Ref;
 }
 
-const ManagedTexture* TextureManager::LoadTGAFromFile( const std::wstring& fileName, bool sRGB )
+TextureRef TextureManager::LoadTGAFromFile( const std::wstring& fileName, bool sRGB )
 {
-    auto ManagedTex = FindOrLoadTexture(fileName);
+    TextureRef Ref;
+    auto ManagedTex = FindOrLoadTexture(fileName, Ref);
 
     ManagedTexture* ManTex = ManagedTex.first;
     const bool RequestsLoad = ManagedTex.second;
@@ -295,25 +1145,32 @@ const ManagedTexture* TextureManager::LoadTGAFromFile( const std::wstring& fileN
     if (!RequestsLoad)
     {
         ManTex->WaitForLoad();
-        return ManTex;
+        return Ref;
     }
 
+    // Transcoded images can be saved where LoadFromFile() looks for a DDS first.  Delete them to pick up changes
+    // to the source.
+    wstring CachePath;
+    if (s_CacheTranscoded && fileName.size() > 4 && fileName.compare(fileName.size() - 4, 4, L".tga") == 0)
+        CachePath = s_RootPath + fileName.substr(0, fileName.size() - 4) + L".dds";
+
     Utility::ByteArray ba = Utility::ReadFileSync( s_RootPath + fileName );
     if (ba->size() > 0)
     {
-        ManTex->CreateTGAFromMemory( ba->data(), ba->size(), sRGB );
+        ManTex->CreateTGAFromMemory( ba->data(), ba->size(), sRGB, CachePath.empty() ? nullptr : CachePath.c_str() );
         ManTex->GetResource()->SetName(fileName.c_str());
     }
     else
         ManTex->SetToInvalidTexture();
 
-    return ManTex;
+    return Ref;
 }
 
 
-const ManagedTexture* TextureManager::LoadPIXImageFromFile( const std::wstring& fileName )
+TextureRef TextureManager::LoadPIXImageFromFile( const std::wstring& fileName )
 {
-    auto ManagedTex = FindOrLoadTexture(fileName);
+    TextureRef Ref;
+    auto ManagedTex = FindOrLoadTexture(fileName, Ref);
 
     ManagedTexture* ManTex = ManagedTex.first;
     const bool RequestsLoad = ManagedTex.second;
@@ -321,7 +1178,7 @@ const ManagedTexture* TextureManager::LoadPIXImageFromFile( const std::wstring&
     if (!RequestsLoad)
     {
         ManTex->WaitForLoad();
-        return ManTex;
+        return Ref;
     }
 
     Utility::ByteArray ba = Utility::ReadFileSync( s_RootPath + fileName );
@@ -333,5 +1190,5 @@ const ManagedTexture* TextureManager::LoadPIXImageFromFile( const std::wstring&
     else
         ManTex->SetToInvalidTexture();
 
-    return ManTex;
+    return Ref;
 }
@@ -17,6 +17,16 @@
 #include "pch.h"
 #include "GpuResource.h"
 #include "Utility.h"
+#include "FileUtility.h"
+#include <atomic>
+
+class CommandContext;
+
+namespace TextureManager
+{
+    struct StreamingTexture;
+    void Update(void);
+}
 
 class Texture : public GpuResource
 {
@@ -24,8 +34,8 @@ class Texture : public GpuResource
 
 public:
 
-    Texture() { m_hCpuDescriptorHandle.ptr = D3D12_GPU_VIRTUAL_ADDRESS_UNKNOWN; }
-    Texture(D3D12_CPU_DESCRIPTOR_HANDLE Handle) : m_hCpuDescriptorHandle(Handle) {}
+    Texture() : m_OwnsDescriptor(false) { m_hCpuDescriptorHandle.ptr = D3D12_GPU_VIRTUAL_ADDRESS_UNKNOWN; }
+    Texture(D3D12_CPU_DESCRIPTOR_HANDLE Handle) : m_hCpuDescriptorHandle(Handle), m_OwnsDescriptor(false) {}
 
     // Create a 1-level 2D texture
     void Create(size_t Pitch, size_t Width, size_t Height, DXGI_FORMAT Format, const void* InitData );
@@ -34,16 +44,14 @@ public:
         Create(Width, Width, Height, Format, InitData);
     }
 
-    void CreateTGAFromMemory( const void* memBuffer, size_t fileSize, bool sRGB );
+    // Uncompressed images are block compressed on the GPU when "Graphics/Textures/Transcode" allows it.  The
+    // result is also saved to CachePath as a DDS file, if it isn't null.
+    void CreateTGAFromMemory( const void* memBuffer, size_t fileSize, bool sRGB, const wchar_t* CachePath = nullptr );
     bool CreateDDSFromMemory( const void* memBuffer, size_t fileSize, bool sRGB );
     void CreatePIXImageFromMemory( const void* memBuffer, size_t fileSize );
 
-    virtual void Destroy() override
-    {
-        GpuResource::Destroy();
-        // This leaks descriptor handles.  We should really give it back to be reused.
-        m_hCpuDescriptorHandle.ptr = 0;
-    }
+    // Also gives back the SRV descriptor if the texture allocated it
+    virtual void Destroy() override;
 
     const D3D12_CPU_DESCRIPTOR_HANDLE& GetSRV() const { return m_hCpuDescriptorHandle; }
 
@@ -51,25 +59,90 @@ public:
 
 protected:
 
+    void AllocateSRV( void );
+
+    // Returns false, creating nothing, if the image isn't to be compressed
+    bool CreateCompressed( size_t Width, size_t Height, const uint32_t* Pixels, bool sRGB, bool HasAlpha,
+        const wchar_t* CachePath );
+
     D3D12_CPU_DESCRIPTOR_HANDLE m_hCpuDescriptorHandle;
+    bool m_OwnsDescriptor;
 };
 
 class ManagedTexture : public Texture
 {
 public:
-    ManagedTexture( const std::wstring& FileName ) : m_MapKey(FileName), m_IsValid(true) {}
+    ManagedTexture( const std::wstring& FileName, size_t PathHash ) : m_MapKey(FileName), m_PathHash(PathHash),
+        m_IsValid(true), m_RefCount(0), m_ReadPending(false) {}
 
     void operator= ( const Texture& Texture );
 
     void WaitForLoad(void) const;
-    void Unload(void);
 
     void SetToInvalidTexture(void);
     bool IsValid(void) const { return m_IsValid; }
 
+    // Read and upload the texture in the background.  The SRV handle is valid immediately and shows a
+    // placeholder until the smallest mips arrive, then sharpens as TextureManager::Update() publishes
+    // larger mips.  Uncompressed files are read a few mips at a time as they are needed.
+    void StreamDDSFromFile( const std::wstring& FilePath, bool sRGB );
+
+    // Streamed textures start out with no mips larger than "Graphics/Textures/Initial Resolution".  This asks
+    // for mips up to at least MaxDimension texels across, or the whole texture if it is smaller.  Requests only
+    // grow, and the new mips arrive in the background like the first ones.
+    void RequestResolution( uint32_t MaxDimension ) const;
+
+    // Move the texture out of a sparsely used small texture heap, recording the copy on the context.  Returns
+    // false if it doesn't need to move.  The old resource is released once the GPU is done with it.
+    bool Relocate( CommandContext& Context );
+
 private:
+    friend class TextureRef;
+    friend void TextureManager::Update( void );
+
+    // Counted by TextureRef.  Dropping the last reference takes the texture out of the cache and hands it to
+    // TextureManager::Update() to unload.
+    void AddRef( void ) const { ++m_RefCount; }
+    void Release( void ) const;
+
+    // Release the resource once the GPU is done with it, and the descriptor.  Returns false, doing nothing,
+    // while a read, upload or view of the texture is still in flight.
+    bool Unload( void );
+
+    bool StreamDDSFromMemory( const Utility::ByteArray& Data, bool sRGB );
+    bool StreamDDSFromIndex( const std::wstring& FilePath, bool sRGB );
+    bool BeginStreaming( const std::shared_ptr<TextureManager::StreamingTexture>& Tex, bool sRGB );
+
+    // Point the SRV at Resource.  If that isn't the texture's resource, it replaces it, and the old one is
+    // released once the GPU is done with it.
+    void PublishView( ID3D12Resource* Resource, const D3D12_SHADER_RESOURCE_VIEW_DESC& ViewDesc );
+
     std::wstring m_MapKey;        // For deleting from the map later
+    size_t m_PathHash;            // Of m_MapKey, which also picks its cache shard
     bool m_IsValid;
+    std::shared_ptr<TextureManager::StreamingTexture> m_Streaming;    // Guarded by the streaming mutex
+    mutable std::atomic<uint32_t> m_RefCount;
+    std::atomic<bool> m_ReadPending;    // The file is still being read in the background
+};
+
+// A counted reference to a managed texture.  The loaders return one, and the texture stays loaded for as long as
+// any reference to it is held.
+class TextureRef
+{
+public:
+    TextureRef( const ManagedTexture* Texture = nullptr ) : m_Ref(Texture) { if (m_Ref != nullptr) m_Ref->AddRef(); }
+    TextureRef( const TextureRef& Ref ) : TextureRef(Ref.m_Ref) {}
+    TextureRef( TextureRef&& Ref ) : m_Ref(Ref.m_Ref) { Ref.m_Ref = nullptr; }
+    ~TextureRef() { if (m_Ref != nullptr) m_Ref->Release(); }
+
+    TextureRef& operator= ( TextureRef Ref ) { std::swap(m_Ref, Ref.m_Ref); return *this; }
+
+    const ManagedTexture* Get( void ) const { return m_Ref; }
+    const ManagedTexture* operator-> ( void ) const { return m_Ref; }
+    explicit operator bool( void ) const { return m_Ref != nullptr; }
+
+private:
+    const ManagedTexture* m_Ref;
 };
 
 namespace TextureManager
@@ -77,27 +150,41 @@ namespace TextureManager
     void Initialize( const std::wstring& TextureLibRoot );
     void Shutdown(void);
 
-    const ManagedTexture* LoadFromFile( const std::wstring& fileName, bool sRGB = false );
-    const ManagedTexture* LoadDDSFromFile( const std::wstring& fileName, bool sRGB = false );
-    const ManagedTexture* LoadTGAFromFile( const std::wstring& fileName, bool sRGB = false );
-    const ManagedTexture* LoadPIXImageFromFile( const std::wstring& fileName );
+    // Publish views for streamed mips whose uploads have completed, and move a few small textures out of
+    // sparsely used heaps when nothing is streaming.  Call once per frame on the main thread.
+    void Update(void);
+
+    // Incremented whenever Update() rewrites texture descriptors.  Anything that keeps its own copies of
+    // texture descriptors, such as a shader-visible heap, must refresh them when this changes.
+    uint32_t GetDescriptorVersion(void);
+
+    // Abandon pending mip refinement and wait for in-flight reads and uploads
+    void StopStreaming(void);
+
+    // Textures are cached by path, so loading one again while a reference to it is held returns the same texture.
+    // Lookups of different paths rarely contend.  Once the last reference is dropped, Update() unloads it as soon
+    // as nothing in flight refers to it.
+    TextureRef LoadFromFile( const std::wstring& fileName, bool sRGB = false );
+    TextureRef LoadDDSFromFile( const std::wstring& fileName, bool sRGB = false );
+    TextureRef LoadTGAFromFile( const std::wstring& fileName, bool sRGB = false );
+    TextureRef LoadPIXImageFromFile( const std::wstring& fileName );
 
-    inline const ManagedTexture* LoadFromFile( const std::string& fileName, bool sRGB = false )
+    inline TextureRef LoadFromFile( const std::string& fileName, bool sRGB = false )
     {
         return LoadFromFile(MakeWStr(fileName), sRGB);
     }
 
-    inline const ManagedTexture* LoadDDSFromFile( const std::string& fileName, bool sRGB = false )
+    inline TextureRef LoadDDSFromFile( const std::string& fileName, bool sRGB = false )
     {
         return LoadDDSFromFile(MakeWStr(fileName), sRGB);
     }
 
-    inline const ManagedTexture* LoadTGAFromFile( const std::string& fileName, bool sRGB = false )
+    inline TextureRef LoadTGAFromFile( const std::string& fileName, bool sRGB = false )
     {
         return LoadTGAFromFile(MakeWStr(fileName), sRGB);
     }
 
-    inline const ManagedTexture* LoadPIXImageFromFile( const std::string& fileName )
+    inline TextureRef LoadPIXImageFromFile( const std::string& fileName )
     {
         return LoadPIXImageFromFile(MakeWStr(fileName));
     }
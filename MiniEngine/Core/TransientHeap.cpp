@@ -0,0 +1,138 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Developed by Minigraph
+//
+
+#include "pch.h"
+#include "TransientHeap.h"
+#include "ColorBuffer.h"
+#include "CommandContext.h"
+#include "GraphicsCore.h"
+#include "GpuMemory.h"
+
+using namespace Graphics;
+
+void TransientHeap::BeginGroup( uint32_t Group )
+{
+    ASSERT(m_OpenGroup == kNoGroup, "Transient groups cannot be nested");
+    ASSERT(m_Heap == nullptr, "Destroy the heap before declaring new buffers");
+
+    if (Group >= m_GroupSizes.size())
+        m_GroupSizes.resize(Group + 1, 0);
+
+    m_OpenGroup = Group;
+}
+
+void TransientHeap::EndGroup( void )
+{
+    ASSERT(m_OpenGroup != kNoGroup);
+    m_OpenGroup = kNoGroup;
+}
+
+void TransientHeap::Place( ColorBuffer& Buffer, const D3D12_RESOURCE_DESC& Desc, const D3D12_CLEAR_VALUE& ClearValue,
+    const std::wstring& Name, uint32_t ArraySize, uint32_t NumMips )
+{
+    ASSERT(m_OpenGroup != kNoGroup, "Transient buffers must be created inside a group");
+    ASSERT(Desc.Flags & D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS, "Transient buffers are initialized as UAVs");
+
+    // Don't leave the old resource around to be used by mistake before the heap is finalized
+    Buffer.Destroy();
+
+    D3D12_RESOURCE_ALLOCATION_INFO Info = g_Device->GetResourceAllocationInfo(0, 1, &Desc);
+
+    uint64_t& GroupSize = m_GroupSizes[m_OpenGroup];
+
+    Placement P;
+    P.Buffer = &Buffer;
+    P.Group = m_OpenGroup;
+    P.HeapOffset = Math::AlignUp(GroupSize, (size_t)Info.Alignment);
+    P.Desc = Desc;
+    P.ClearValue = ClearValue;
+    P.Name = Name;
+    P.ArraySize = ArraySize;
+    P.NumMips = NumMips;
+    m_Placements.push_back(P);
+
+    GroupSize = P.HeapOffset + Info.SizeInBytes;
+    m_UnaliasedSize += Info.SizeInBytes;
+}
+
+void TransientHeap::Finalize( const std::wstring& Name )
+{
+    ASSERT(m_OpenGroup == kNoGroup);
+    ASSERT(m_Heap == nullptr);
+
+    m_HeapSize = 0;
+    for (uint64_t GroupSize : m_GroupSizes)
+        m_HeapSize = std::max(m_HeapSize, GroupSize);
+
+    if (m_HeapSize == 0)
+        return;
+
+    // Every placed buffer is a render target, which keeps this working on resource heap tier 1
+    D3D12_HEAP_DESC HeapDesc = {};
+    HeapDesc.SizeInBytes = Math::AlignUp(m_HeapSize, D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT);
+    HeapDesc.Properties.Type = D3D12_HEAP_TYPE_DEFAULT;
+    HeapDesc.Alignment = D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
+    HeapDesc.Flags = D3D12_HEAP_FLAG_ALLOW_ONLY_RT_DS_TEXTURES;
+
+    ASSERT_SUCCEEDED(g_Device->CreateHeap(&HeapDesc, MY_IID_PPV_ARGS(m_Heap.ReleaseAndGetAddressOf())));
+    GpuMemory::Track(m_Heap.Get(), GpuMemory::kHeaps);
+
+#ifndef RELEASE
+    m_Heap->SetName(Name.c_str());
+#else
+    (Name);
+#endif
+
+    for (const Placement& P : m_Placements)
+        P.Buffer->CreatePlaced(m_Heap.Get(), P.HeapOffset, P.Desc, P.ClearValue, P.Name, P.ArraySize, P.NumMips);
+
+    m_CurrentGroup = kNoGroup;
+}
+
+void TransientHeap::Destroy( void )
+{
+    for (const Placement& P : m_Placements)
+        P.Buffer->Destroy();
+
+    m_Placements.clear();
+    m_GroupSizes.clear();
+    m_Heap = nullptr;
+    m_OpenGroup = kNoGroup;
+    m_CurrentGroup = kNoGroup;
+    m_HeapSize = 0;
+    m_UnaliasedSize = 0;
+}
+
+void TransientHeap::Acquire( CommandContext& Context, uint32_t Group )
+{
+    ASSERT(m_Heap != nullptr && Group < m_GroupSizes.size());
+
+    if (Group == m_CurrentGroup)
+        return;
+
+    m_CurrentGroup = Group;
+
+    for (const Placement& P : m_Placements)
+    {
+        if (P.Group != Group)
+            continue;
+
+        Context.InsertAliasBarrier(*P.Buffer);
+        Context.TransitionResource(*P.Buffer, D3D12_RESOURCE_STATE_UNORDERED_ACCESS, true);
+    }
+
+    // Newly aliased render targets have to be cleared, copied to, or discarded before anything else
+    for (const Placement& P : m_Placements)
+    {
+        if (P.Group == Group)
+            Context.GetCommandList()->DiscardResource(P.Buffer->GetResource(), nullptr);
+    }
+}
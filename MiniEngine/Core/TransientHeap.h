@@ -0,0 +1,81 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Developed by Minigraph
+//
+// Description:  Places color buffers that are never alive at the same time into one shared heap.  Buffers
+// are declared into numbered groups, and every group starts at the bottom of the heap, so the heap is only
+// as large as the largest group.  At most one group holds valid data at a time.  A pass acquires its group
+// before touching its buffers, which aliases them in and discards whatever was there before.  The group
+// stays current until another group is acquired, so a group that is used every frame while the others are
+// disabled does not pay for any barriers.
+//
+// Acquisition is tracked in recording order.  Work on other queues that uses a group must already be
+// ordered against its neighbours with fences, as it would be for any other shared resource.
+//
+
+#pragma once
+
+#include "pch.h"
+#include <vector>
+
+class ColorBuffer;
+class CommandContext;
+
+class TransientHeap
+{
+public:
+    TransientHeap() : m_OpenGroup(kNoGroup), m_CurrentGroup(kNoGroup), m_HeapSize(0), m_UnaliasedSize(0) {}
+    ~TransientHeap() { Destroy(); }
+
+    // Buffers created with this heap between BeginGroup() and EndGroup() belong to the group.  They don't
+    // get any memory or views until Finalize() is called.
+    void BeginGroup( uint32_t Group );
+    void EndGroup( void );
+    void Finalize( const std::wstring& Name );
+
+    // Releases the heap and every buffer placed in it
+    void Destroy( void );
+
+    // Make the group's buffers the current occupants of the heap.  Their contents are undefined and they are
+    // left in the unordered access state.
+    void Acquire( CommandContext& Context, uint32_t Group );
+
+    uint64_t GetHeapSize( void ) const { return m_HeapSize; }
+
+    // What the same buffers would have taken as committed resources
+    uint64_t GetUnaliasedSize( void ) const { return m_UnaliasedSize; }
+
+private:
+    friend class ColorBuffer;
+
+    struct Placement
+    {
+        ColorBuffer* Buffer;
+        uint32_t Group;
+        uint64_t HeapOffset;
+        D3D12_RESOURCE_DESC Desc;
+        D3D12_CLEAR_VALUE ClearValue;
+        std::wstring Name;
+        uint32_t ArraySize;
+        uint32_t NumMips;
+    };
+
+    void Place( ColorBuffer& Buffer, const D3D12_RESOURCE_DESC& Desc, const D3D12_CLEAR_VALUE& ClearValue,
+        const std::wstring& Name, uint32_t ArraySize, uint32_t NumMips );
+
+    static const uint32_t kNoGroup = 0xFFFFFFFF;
+
+    Microsoft::WRL::ComPtr<ID3D12Heap> m_Heap;
+    std::vector<Placement> m_Placements;
+    std::vector<uint64_t> m_GroupSizes;
+    uint32_t m_OpenGroup;
+    uint32_t m_CurrentGroup;
+    uint64_t m_HeapSize;
+    uint64_t m_UnaliasedSize;
+};
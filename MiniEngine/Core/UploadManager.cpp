@@ -0,0 +1,382 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Developed by Minigraph
+//
+
+#include "pch.h"
+#include "UploadManager.h"
+#include "GraphicsCore.h"
+#include "CommandContext.h"
+#include "CommandListManager.h"
+#include "GpuMemory.h"
+#include <deque>
+#include <atomic>
+
+using namespace Graphics;
+using Microsoft::WRL::ComPtr;
+
+namespace UploadManager
+{
+    struct SubmittedBatch
+    {
+        UploadToken Token;
+        uint64_t FenceValue;
+        uint64_t RingEnd;       // Staging memory up to here is free once the fence is reached
+        std::vector< ComPtr<ID3D12Resource> > Resources;
+    };
+
+    std::mutex s_Mutex;
+
+    // Ring offsets increase monotonically.  The physical offset is the ring offset modulo the ring size.
+    ComPtr<ID3D12Resource> s_RingBuffer;
+    uint8_t* s_RingCpuAddress = nullptr;
+    uint64_t s_RingSize = 0;
+    uint64_t s_RingHead = 0;
+    uint64_t s_RingTail = 0;
+
+    CommandContext* s_BatchContext = nullptr;
+    std::vector< ComPtr<ID3D12Resource> > s_BatchResources;
+    uint64_t s_BatchBytes = 0;
+    UploadToken s_OpenToken = 1;
+
+    // Tokens of in-flight batches are consecutive, oldest first
+    std::deque<SubmittedBatch> s_InFlight;
+
+    std::atomic<UploadToken> s_JoinToken(0);
+    std::atomic<UploadToken> s_JoinedToken[2];
+
+    ID3D12Resource* CreateUploadBuffer( uint64_t SizeInBytes, const wchar_t* Name )
+    {
+        D3D12_HEAP_PROPERTIES HeapProps;
+        HeapProps.Type = D3D12_HEAP_TYPE_UPLOAD;
+        HeapProps.CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_UNKNOWN;
+        HeapProps.MemoryPoolPreference = D3D12_MEMORY_POOL_UNKNOWN;
+        HeapProps.CreationNodeMask = 1;
+        HeapProps.VisibleNodeMask = 1;
+
+        D3D12_RESOURCE_DESC ResourceDesc = CD3DX12_RESOURCE_DESC::Buffer(SizeInBytes);
+
+        ID3D12Resource* pBuffer;
+        ASSERT_SUCCEEDED( g_Device->CreateCommittedResource(&HeapProps, D3D12_HEAP_FLAG_NONE,
+            &ResourceDesc, D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, MY_IID_PPV_ARGS(&pBuffer)) );
+
+        pBuffer->SetName(Name);
+        GpuMemory::Track(pBuffer, GpuMemory::kUpload);
+
+        return pBuffer;
+    }
+
+    // All of the following expect s_Mutex to be held
+
+    void RetireCompletedBatches( void )
+    {
+        while (!s_InFlight.empty() && g_CommandManager.IsFenceComplete(s_InFlight.front().FenceValue))
+        {
+            s_RingTail = s_InFlight.front().RingEnd;
+            s_InFlight.pop_front();
+        }
+    }
+
+    void SubmitBatch( void )
+    {
+        ASSERT(s_BatchContext != nullptr);
+
+        SubmittedBatch Batch;
+        Batch.Token = s_OpenToken++;
+        Batch.FenceValue = s_BatchContext->Finish(false);
+        Batch.RingEnd = s_RingHead;
+        Batch.Resources.swap(s_BatchResources);
+        s_InFlight.push_back(std::move(Batch));
+
+        s_BatchContext = nullptr;
+        s_BatchBytes = 0;
+    }
+
+    ID3D12GraphicsCommandList* OpenBatch( GpuResource& Dest )
+    {
+        if (s_BatchContext == nullptr)
+            s_BatchContext = g_ContextManager.AllocateContext(D3D12_COMMAND_LIST_TYPE_COPY);
+
+        s_BatchResources.push_back(Dest.GetResource());
+        return s_BatchContext->GetCommandList();
+    }
+
+    // Returns the CPU address of the staging memory along with the buffer and offset the copy should read from
+    uint8_t* AllocateStaging( uint64_t NumBytes, uint64_t Alignment, ID3D12Resource*& Buffer, uint64_t& Offset )
+    {
+        s_BatchBytes += NumBytes;
+
+        // Anything that would hog the ring gets a staging buffer of its own that retires with the batch
+        if (NumBytes > s_RingSize / 2)
+        {
+            Buffer = CreateUploadBuffer(NumBytes, L"UploadManager Staging Buffer");
+            s_BatchResources.emplace_back();
+            s_BatchResources.back().Attach(Buffer);
+            Offset = 0;
+
+            void* CpuAddress;
+            ASSERT_SUCCEEDED(Buffer->Map(0, nullptr, &CpuAddress));
+            return (uint8_t*)CpuAddress;
+        }
+
+        while (true)
+        {
+            RetireCompletedBatches();
+
+            // Never let an allocation straddle the end of the ring
+            uint64_t Start = Math::AlignUp(s_RingHead, (size_t)Alignment);
+            if (Start % s_RingSize + NumBytes > s_RingSize)
+                Start = (Start / s_RingSize + 1) * s_RingSize;
+
+            if (Start + NumBytes - s_RingTail <= s_RingSize)
+            {
+                s_RingHead = Start + NumBytes;
+                Buffer = s_RingBuffer.Get();
+                Offset = Start % s_RingSize;
+                return s_RingCpuAddress + Offset;
+            }
+
+            // The ring is full of copies that haven't finished.  Submit what we have and wait for the oldest.
+            if (s_BatchContext != nullptr)
+                SubmitBatch();
+
+            ASSERT(!s_InFlight.empty());
+            g_CommandManager.WaitForFence(s_InFlight.front().FenceValue);
+        }
+    }
+
+    // Does what UpdateSubresources() does, but streams into the mapped staging memory.  A subresource laid out
+    // like its footprint is copied in one piece, which lets large mips be split across the job system.
+    void StageTexture( ID3D12GraphicsCommandList* CmdList, ID3D12Resource* Dest, UINT FirstSubresource, UINT NumSubresources,
+        const D3D12_SUBRESOURCE_DATA SubData[], ID3D12Resource* Staging, uint64_t StagingOffset, uint8_t* CpuAddress )
+    {
+        D3D12_RESOURCE_DESC Desc = Dest->GetDesc();
+        ASSERT(Desc.Dimension != D3D12_RESOURCE_DIMENSION_BUFFER);
+
+        std::vector<D3D12_PLACED_SUBRESOURCE_FOOTPRINT> Layouts(NumSubresources);
+        std::vector<UINT> NumRows(NumSubresources);
+        std::vector<UINT64> RowSizes(NumSubresources);
+        g_Device->GetCopyableFootprints(&Desc, FirstSubresource, NumSubresources, StagingOffset,
+            Layouts.data(), NumRows.data(), RowSizes.data(), nullptr);
+
+        for (UINT i = 0; i < NumSubresources; ++i)
+        {
+            const D3D12_SUBRESOURCE_DATA& Src = SubData[i];
+            const D3D12_SUBRESOURCE_FOOTPRINT& Footprint = Layouts[i].Footprint;
+
+            const uint8_t* SrcData = (const uint8_t*)Src.pData;
+            uint8_t* DestData = CpuAddress + (Layouts[i].Offset - StagingOffset);
+            size_t RowSize = (size_t)RowSizes[i];
+            size_t TotalRows = (size_t)NumRows[i] * Footprint.Depth;
+            size_t DestSlicePitch = (size_t)Footprint.RowPitch * NumRows[i];
+
+            // Rounding rows up to whole quadwords reads no further than the aligned quadword holding the last
+            // byte, and the 256-byte footprint pitch leaves room for the extra bytes written.
+            bool SrcAligned = Math::IsAligned(SrcData, 16) && Math::IsAligned(Src.RowPitch, 16) &&
+                (Footprint.Depth == 1 || Math::IsAligned(Src.SlicePitch, 16));
+
+            if (SrcAligned && (size_t)Src.RowPitch == Footprint.RowPitch &&
+                (Footprint.Depth == 1 || (size_t)Src.SlicePitch == DestSlicePitch))
+            {
+                size_t NumBytes = (TotalRows - 1) * Footprint.RowPitch + RowSize;
+                SIMDMemCopyParallel(DestData, SrcData, Math::DivideByMultiple(NumBytes, 16));
+            }
+            else
+            {
+                for (UINT z = 0; z < Footprint.Depth; ++z)
+                {
+                    for (UINT y = 0; y < NumRows[i]; ++y)
+                    {
+                        uint8_t* DestRow = DestData + DestSlicePitch * z + (size_t)Footprint.RowPitch * y;
+                        const uint8_t* SrcRow = SrcData + Src.SlicePitch * z + Src.RowPitch * y;
+                        if (SrcAligned)
+                            SIMDMemCopy(DestRow, SrcRow, Math::DivideByMultiple(RowSize, 16));
+                        else
+                            memcpy(DestRow, SrcRow, RowSize);
+                    }
+                }
+            }
+
+            CmdList->CopyTextureRegion(&CD3DX12_TEXTURE_COPY_LOCATION(Dest, FirstSubresource + i), 0, 0, 0,
+                &CD3DX12_TEXTURE_COPY_LOCATION(Staging, Layouts[i]), nullptr);
+        }
+    }
+
+    UploadToken CloseUpload( void )
+    {
+        UploadToken Token = s_OpenToken;
+        if (s_BatchBytes >= s_RingSize / 4)
+            SubmitBatch();
+        return Token;
+    }
+
+    uint64_t GetFenceValueLocked( UploadToken Token )
+    {
+        ASSERT(Token > 0 && Token <= s_OpenToken, "Invalid upload token");
+
+        if (Token == s_OpenToken)
+        {
+            if (s_BatchContext == nullptr)
+                return 0;
+            SubmitBatch();
+        }
+
+        RetireCompletedBatches();
+
+        if (s_InFlight.empty() || Token < s_InFlight.front().Token)
+            return 0;
+
+        return s_InFlight[(size_t)(Token - s_InFlight.front().Token)].FenceValue;
+    }
+}
+
+void UploadManager::Initialize( size_t RingBufferSize )
+{
+    std::lock_guard<std::mutex> Guard(s_Mutex);
+
+    ASSERT(s_RingBuffer == nullptr);
+
+    s_RingSize = Math::AlignUp(RingBufferSize, D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT);
+    s_RingBuffer.Attach(CreateUploadBuffer(s_RingSize, L"UploadManager Ring Buffer"));
+    ASSERT_SUCCEEDED(s_RingBuffer->Map(0, nullptr, (void**)&s_RingCpuAddress));
+
+    s_RingHead = 0;
+    s_RingTail = 0;
+    s_JoinedToken[0] = 0;
+    s_JoinedToken[1] = 0;
+}
+
+void UploadManager::Shutdown( void )
+{
+    std::lock_guard<std::mutex> Guard(s_Mutex);
+
+    if (s_RingBuffer == nullptr)
+        return;
+
+    if (s_BatchContext != nullptr)
+        SubmitBatch();
+
+    if (!s_InFlight.empty())
+        g_CommandManager.WaitForFence(s_InFlight.back().FenceValue);
+    s_InFlight.clear();
+
+    s_RingBuffer->Unmap(0, nullptr);
+    s_RingBuffer = nullptr;
+    s_RingCpuAddress = nullptr;
+}
+
+bool UploadManager::IsReady( void )
+{
+    return s_RingCpuAddress != nullptr;
+}
+
+UploadManager::UploadToken UploadManager::UploadBuffer( GpuResource& Dest, size_t DestOffset, const void* Data, size_t NumBytes )
+{
+    ASSERT(Data != nullptr && NumBytes > 0);
+
+    std::lock_guard<std::mutex> Guard(s_Mutex);
+
+    ID3D12Resource* Staging;
+    uint64_t StagingOffset;
+    uint8_t* CpuAddress = AllocateStaging(NumBytes, 16, Staging, StagingOffset);
+
+    // Staging allocations are 16-byte aligned and padded to whole quadwords
+    if (Math::IsAligned(Data, 16))
+        SIMDMemCopyParallel(CpuAddress, Data, Math::DivideByMultiple(NumBytes, 16));
+    else
+        memcpy(CpuAddress, Data, NumBytes);
+
+    ID3D12GraphicsCommandList* CmdList = OpenBatch(Dest);
+    CmdList->CopyBufferRegion(Dest.GetResource(), DestOffset, Staging, StagingOffset, NumBytes);
+
+    return CloseUpload();
+}
+
+UploadManager::UploadToken UploadManager::UploadTexture( GpuResource& Dest, UINT FirstSubresource, UINT NumSubresources,
+    const D3D12_SUBRESOURCE_DATA SubData[] )
+{
+    ASSERT(NumSubresources > 0);
+
+    UINT64 NumBytes = GetRequiredIntermediateSize(Dest.GetResource(), FirstSubresource, NumSubresources);
+
+    std::lock_guard<std::mutex> Guard(s_Mutex);
+
+    ID3D12Resource* Staging;
+    uint64_t StagingOffset;
+    uint8_t* CpuAddress = AllocateStaging(NumBytes, D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT, Staging, StagingOffset);
+
+    ID3D12GraphicsCommandList* CmdList = OpenBatch(Dest);
+    StageTexture(CmdList, Dest.GetResource(), FirstSubresource, NumSubresources, SubData, Staging, StagingOffset, CpuAddress);
+
+    return CloseUpload();
+}
+
+void UploadManager::Flush( void )
+{
+    std::lock_guard<std::mutex> Guard(s_Mutex);
+
+    if (s_BatchContext != nullptr)
+        SubmitBatch();
+}
+
+uint64_t UploadManager::GetFenceValue( UploadToken Token )
+{
+    std::lock_guard<std::mutex> Guard(s_Mutex);
+    return GetFenceValueLocked(Token);
+}
+
+bool UploadManager::IsComplete( UploadToken Token )
+{
+    std::lock_guard<std::mutex> Guard(s_Mutex);
+
+    ASSERT(Token > 0 && Token <= s_OpenToken, "Invalid upload token");
+
+    if (Token == s_OpenToken)
+        return s_BatchContext == nullptr;
+
+    RetireCompletedBatches();
+    return s_InFlight.empty() || Token < s_InFlight.front().Token;
+}
+
+void UploadManager::StallForUpload( CommandQueue& Consumer, UploadToken Token )
+{
+    uint64_t FenceValue = GetFenceValue(Token);
+    if (FenceValue != 0)
+        Consumer.StallForFence(FenceValue);
+}
+
+void UploadManager::WaitForUpload( UploadToken Token )
+{
+    uint64_t FenceValue = GetFenceValue(Token);
+    if (FenceValue != 0)
+        g_CommandManager.WaitForFence(FenceValue);
+}
+
+void UploadManager::JoinNextSubmission( UploadToken Token )
+{
+    UploadToken Joined = s_JoinToken;
+    while (Joined < Token && !s_JoinToken.compare_exchange_weak(Joined, Token))
+        ;
+}
+
+void UploadManager::StallForJoinedUploads( D3D12_COMMAND_LIST_TYPE Type )
+{
+    // The copy queue never waits, which also keeps the batch submission below from recursing
+    if (Type == D3D12_COMMAND_LIST_TYPE_COPY)
+        return;
+
+    std::atomic<UploadToken>& Joined = s_JoinedToken[Type == D3D12_COMMAND_LIST_TYPE_COMPUTE ? 1 : 0];
+
+    UploadToken Token = s_JoinToken;
+    if (Token <= Joined)
+        return;
+
+    StallForUpload(g_CommandManager.GetQueue(Type), Token);
+    Joined = Token;
+}
@@ -0,0 +1,64 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Developed by Minigraph
+//
+// Description:  Uploads initial resource data on the copy queue without stalling the CPU.  Source data is
+// copied into a persistent, persistently mapped staging ring buffer, and the copies are recorded into a
+// single copy-queue command list that is submitted as one batch.  Each upload returns a token that names
+// its batch.  A token can be turned into a copy queue fence value, waited on by another queue on the GPU, or
+// (as a last resort) waited on by the CPU.  Staging memory is reclaimed as batches retire, so the CPU only
+// ever blocks when the ring is full of copies the GPU has not finished yet.
+//
+// The destination resources must be in the common state.  They are implicitly promoted for the copy and
+// decay back to the common state when it completes.  They are kept alive until their batch retires.
+//
+
+#pragma once
+
+#include <cstdint>
+
+class GpuResource;
+class CommandQueue;
+
+namespace UploadManager
+{
+    typedef uint64_t UploadToken;
+
+    void Initialize( size_t RingBufferSize = 32 * 1024 * 1024 );
+    void Shutdown( void );
+    bool IsReady( void );
+
+    UploadToken UploadBuffer( GpuResource& Dest, size_t DestOffset, const void* Data, size_t NumBytes );
+    UploadToken UploadTexture( GpuResource& Dest, UINT FirstSubresource, UINT NumSubresources,
+        const D3D12_SUBRESOURCE_DATA SubData[] );
+
+    // Submit the batch being recorded, if there is one.  Uploads are otherwise submitted when the batch has
+    // used a quarter of the ring or when somebody needs a fence value for them.
+    void Flush( void );
+
+    // Returns the copy queue fence value that signals the upload, submitting its batch if necessary.
+    // Returns 0 if the upload has already retired.
+    uint64_t GetFenceValue( UploadToken Token );
+
+    // Does not submit anything, so an upload still being batched is never complete
+    bool IsComplete( UploadToken Token );
+
+    // Make a queue wait on the GPU for the upload to finish
+    void StallForUpload( CommandQueue& Consumer, UploadToken Token );
+
+    // Make the CPU wait for the upload to finish
+    void WaitForUpload( UploadToken Token );
+
+    // Make every graphics and compute queue submission from now on wait for this upload.  This is how the
+    // fire-and-forget CommandContext::InitializeBuffer() and InitializeTexture() stay correct.
+    void JoinNextSubmission( UploadToken Token );
+
+    // Called by CommandContext before submitting to a queue
+    void StallForJoinedUploads( D3D12_COMMAND_LIST_TYPE Type );
+}
@@ -139,4 +139,10 @@ namespace Utility
 void SIMDMemCopy( void* __restrict Dest, const void* __restrict Source, size_t NumQuadwords );
 void SIMDMemFill( void* __restrict Dest, __m128 FillVector, size_t NumQuadwords );
 
+// Splits copies of a megabyte or more across the job system, otherwise the same as SIMDMemCopy()
+void SIMDMemCopyParallel( void* __restrict Dest, const void* __restrict Source, size_t NumQuadwords );
+
+// Whether the CPU and OS support AVX2, for code that picks its own SIMD paths
+bool HasAVX2( void );
+
 std::wstring MakeWStr( const std::string& str );
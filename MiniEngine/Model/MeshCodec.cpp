@@ -0,0 +1,269 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Developed by Minigraph
+//
+
+#include "MeshCodec.h"
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <ppl.h>
+
+namespace
+{
+    enum { kGroupSize = 16 };
+
+    inline uint8_t ZigZag8( uint8_t Delta ) { return (uint8_t)((Delta << 1) ^ (uint8_t)((int8_t)Delta >> 7)); }
+    inline uint8_t UnZigZag8( uint8_t Value ) { return (uint8_t)((Value >> 1) ^ (uint8_t)-(int)(Value & 1)); }
+    inline uint32_t ZigZag32( int32_t Delta ) { return ((uint32_t)Delta << 1) ^ (uint32_t)(Delta >> 31); }
+    inline int32_t UnZigZag32( uint32_t Value ) { return (int32_t)(Value >> 1) ^ -(int32_t)(Value & 1); }
+
+    // Bits per value for group mode 0-3
+    const uint32_t kModeBits[4] = { 0, 2, 4, 8 };
+
+    void EncodeVertexBlock( const uint8_t* Vertices, uint32_t Count, uint32_t Stride, std::vector<uint8_t>& Out )
+    {
+        const uint32_t GroupCount = (Count + kGroupSize - 1) / kGroupSize;
+
+        uint8_t Deltas[MeshCodec::kVertexBlockSize];
+        for (uint32_t Byte = 0; Byte < Stride; ++Byte)
+        {
+            uint8_t Previous = 0;
+            for (uint32_t i = 0; i < Count; ++i)
+            {
+                uint8_t Value = Vertices[i * Stride + Byte];
+                Deltas[i] = ZigZag8((uint8_t)(Value - Previous));
+                Previous = Value;
+            }
+            for (uint32_t i = Count; i < GroupCount * kGroupSize; ++i)
+                Deltas[i] = 0;
+
+            // Two mode bits per group, then the packed groups
+            size_t HeaderStart = Out.size();
+            Out.resize(HeaderStart + (GroupCount + 3) / 4, 0);
+
+            for (uint32_t Group = 0; Group < GroupCount; ++Group)
+            {
+                const uint8_t* Values = Deltas + Group * kGroupSize;
+                uint8_t MaxValue = *std::max_element(Values, Values + kGroupSize);
+                uint32_t Mode = MaxValue == 0 ? 0 : MaxValue < 4 ? 1 : MaxValue < 16 ? 2 : 3;
+                Out[HeaderStart + Group / 4] |= (uint8_t)(Mode << (Group % 4 * 2));
+
+                const uint32_t Bits = kModeBits[Mode];
+                if (Bits == 8)
+                {
+                    Out.insert(Out.end(), Values, Values + kGroupSize);
+                }
+                else if (Bits > 0)
+                {
+                    const uint32_t PerByte = 8 / Bits;
+                    for (uint32_t i = 0; i < kGroupSize; i += PerByte)
+                    {
+                        uint8_t Packed = 0;
+                        for (uint32_t j = 0; j < PerByte; ++j)
+                            Packed |= (uint8_t)(Values[i + j] << (j * Bits));
+                        Out.push_back(Packed);
+                    }
+                }
+            }
+        }
+    }
+
+    bool DecodeVertexBlock( const uint8_t*& Src, const uint8_t* SrcEnd, uint8_t* Vertices, uint32_t Count, uint32_t Stride )
+    {
+        const uint32_t GroupCount = (Count + kGroupSize - 1) / kGroupSize;
+
+        uint8_t Deltas[MeshCodec::kVertexBlockSize];
+        for (uint32_t Byte = 0; Byte < Stride; ++Byte)
+        {
+            const uint8_t* Header = Src;
+            Src += (GroupCount + 3) / 4;
+            if (Src > SrcEnd)
+                return false;
+
+            for (uint32_t Group = 0; Group < GroupCount; ++Group)
+            {
+                uint8_t* Values = Deltas + Group * kGroupSize;
+                const uint32_t Bits = kModeBits[(Header[Group / 4] >> (Group % 4 * 2)) & 3];
+                if (Bits == 0)
+                {
+                    memset(Values, 0, kGroupSize);
+                    continue;
+                }
+
+                if (Src + kGroupSize * Bits / 8 > SrcEnd)
+                    return false;
+
+                if (Bits == 8)
+                {
+                    memcpy(Values, Src, kGroupSize);
+                    Src += kGroupSize;
+                }
+                else
+                {
+                    const uint32_t PerByte = 8 / Bits;
+                    const uint8_t Mask = (uint8_t)((1 << Bits) - 1);
+                    for (uint32_t i = 0; i < kGroupSize; i += PerByte)
+                    {
+                        uint8_t Packed = *Src++;
+                        for (uint32_t j = 0; j < PerByte; ++j)
+                            Values[i + j] = (Packed >> (j * Bits)) & Mask;
+                    }
+                }
+            }
+
+            uint8_t Previous = 0;
+            for (uint32_t i = 0; i < Count; ++i)
+            {
+                Previous = (uint8_t)(Previous + UnZigZag8(Deltas[i]));
+                Vertices[i * Stride + Byte] = Previous;
+            }
+        }
+        return true;
+    }
+
+    void EncodeIndexBlock( const uint16_t* Indices, uint32_t Count, std::vector<uint8_t>& Out )
+    {
+        int32_t Previous = 0;
+        for (uint32_t i = 0; i < Count; ++i)
+        {
+            uint32_t Value = ZigZag32((int32_t)Indices[i] - Previous);
+            Previous = Indices[i];
+
+            while (Value >= 0x80)
+            {
+                Out.push_back((uint8_t)(Value | 0x80));
+                Value >>= 7;
+            }
+            Out.push_back((uint8_t)Value);
+        }
+    }
+
+    bool DecodeIndexBlock( const uint8_t*& Src, const uint8_t* SrcEnd, uint16_t* Indices, uint32_t Count )
+    {
+        int32_t Previous = 0;
+        for (uint32_t i = 0; i < Count; ++i)
+        {
+            uint32_t Value = 0;
+            for (uint32_t Shift = 0; ; Shift += 7)
+            {
+                if (Src == SrcEnd || Shift > 21)
+                    return false;
+                uint8_t Byte = *Src++;
+                Value |= (uint32_t)(Byte & 0x7F) << Shift;
+                if ((Byte & 0x80) == 0)
+                    break;
+            }
+
+            Previous += UnZigZag32(Value);
+            Indices[i] = (uint16_t)Previous;
+        }
+        return true;
+    }
+}
+
+void MeshCodec::AppendVertexBlocks( std::vector<Block>& Blocks, uint32_t ByteOffset, uint32_t VertexCount, uint32_t Stride )
+{
+    for (uint32_t First = 0; First < VertexCount; First += kVertexBlockSize)
+    {
+        Block NewBlock = { ByteOffset + First * Stride, std::min<uint32_t>(kVertexBlockSize, VertexCount - First), Stride };
+        Blocks.push_back(NewBlock);
+    }
+}
+
+void MeshCodec::AppendIndexBlocks( std::vector<Block>& Blocks, uint32_t ByteOffset, uint32_t IndexCount )
+{
+    for (uint32_t First = 0; First < IndexCount; First += kIndexBlockSize)
+    {
+        Block NewBlock = { ByteOffset + First * (uint32_t)sizeof(uint16_t), std::min<uint32_t>(kIndexBlockSize, IndexCount - First), 0 };
+        Blocks.push_back(NewBlock);
+    }
+}
+
+void MeshCodec::EncodeStream( const uint8_t* Raw, const std::vector<Block>& Blocks, std::vector<uint8_t>& Encoded )
+{
+    const uint32_t BlockCount = (uint32_t)Blocks.size();
+
+    std::vector<std::vector<uint8_t>> Payloads(BlockCount);
+    concurrency::parallel_for(0u, BlockCount, [&](uint32_t i)
+    {
+        const Block& b = Blocks[i];
+        if (b.stride == 0)
+            EncodeIndexBlock((const uint16_t*)(Raw + b.byteOffset), b.count, Payloads[i]);
+        else
+            EncodeVertexBlock(Raw + b.byteOffset, b.count, b.stride, Payloads[i]);
+    });
+
+    std::vector<uint32_t> Table(BlockCount + 1);
+    Table[0] = BlockCount;
+    uint32_t PayloadEnd = 0;
+    for (uint32_t i = 0; i < BlockCount; ++i)
+    {
+        PayloadEnd += (uint32_t)Payloads[i].size();
+        Table[i + 1] = PayloadEnd;
+    }
+
+    Encoded.clear();
+    Encoded.reserve(Table.size() * sizeof(uint32_t) + PayloadEnd);
+    Encoded.insert(Encoded.end(), (const uint8_t*)Table.data(), (const uint8_t*)(Table.data() + Table.size()));
+    for (const std::vector<uint8_t>& Payload : Payloads)
+        Encoded.insert(Encoded.end(), Payload.begin(), Payload.end());
+}
+
+bool MeshCodec::ReadBlockTable( const uint8_t* Encoded, size_t EncodedSize, const std::vector<Block>& Blocks,
+    size_t RawSize, std::vector<uint32_t>& PayloadOffsets )
+{
+    const uint32_t BlockCount = (uint32_t)Blocks.size();
+    const size_t TableSize = (BlockCount + 1) * sizeof(uint32_t);
+    if (EncodedSize < TableSize)
+        return false;
+
+    const uint32_t* Table = (const uint32_t*)Encoded;
+    if (Table[0] != BlockCount || TableSize + (BlockCount > 0 ? Table[BlockCount] : 0) > EncodedSize)
+        return false;
+
+    PayloadOffsets.resize(BlockCount + 1);
+    PayloadOffsets[0] = (uint32_t)TableSize;
+    for (uint32_t i = 0; i < BlockCount; ++i)
+    {
+        const Block& b = Blocks[i];
+        const size_t RawBytes = (size_t)b.count * (b.stride == 0 ? sizeof(uint16_t) : b.stride);
+        if (Table[i + 1] < PayloadOffsets[i] - TableSize || (size_t)b.byteOffset + RawBytes > RawSize)
+            return false;
+
+        PayloadOffsets[i + 1] = (uint32_t)TableSize + Table[i + 1];
+    }
+
+    return true;
+}
+
+bool MeshCodec::DecodeStream( const uint8_t* Encoded, size_t EncodedSize, const std::vector<Block>& Blocks,
+    uint8_t* Raw, size_t RawSize )
+{
+    std::vector<uint32_t> PayloadOffsets;
+    if (!ReadBlockTable(Encoded, EncodedSize, Blocks, RawSize, PayloadOffsets))
+        return false;
+
+    memset(Raw, 0, RawSize);
+
+    std::atomic<bool> Failed(false);
+    concurrency::parallel_for(0u, (uint32_t)Blocks.size(), [&](uint32_t i)
+    {
+        const Block& b = Blocks[i];
+        const uint8_t* Src = Encoded + PayloadOffsets[i];
+        const uint8_t* End = Encoded + PayloadOffsets[i + 1];
+        bool ok = b.stride == 0 ?
+            DecodeIndexBlock(Src, End, (uint16_t*)(Raw + b.byteOffset), b.count) :
+            DecodeVertexBlock(Src, End, Raw + b.byteOffset, b.count, b.stride);
+        if (!ok || Src != End)
+            Failed = true;
+    });
+
+    return !Failed;
+}
@@ -0,0 +1,58 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Developed by Minigraph
+//
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+// Lossless codecs for the H3D vertex and index streams.  A stream is cut into blocks that are coded
+// independently, so both directions run one block per task.
+//
+// Vertex blocks are transposed into byte planes, one per byte of the vertex.  Each byte is replaced by the
+// zigzagged difference to the same byte of the previous vertex, and groups of 16 differences are packed with
+// 0, 2, 4 or 8 bits each.  Neighboring vertices after the pre-transform reorder share most of their high
+// bytes, which then cost nothing.
+//
+// Index blocks store the zigzagged difference to the previous index as a LEB128 varint, which is usually a
+// single byte after the post-transform reorder.
+//
+// An encoded stream starts with the block count and the end offset of every block's payload.
+namespace MeshCodec
+{
+    enum { kVertexBlockSize = 256 };
+    enum { kIndexBlockSize = 4096 };
+
+    struct Block
+    {
+        uint32_t byteOffset; // in the raw stream
+        uint32_t count; // vertices or indices
+        uint32_t stride; // vertex stride, 0 for a block of 16-bit indices
+    };
+
+    // Split a mesh's range of the raw stream into blocks
+    void AppendVertexBlocks( std::vector<Block>& Blocks, uint32_t ByteOffset, uint32_t VertexCount, uint32_t Stride );
+    void AppendIndexBlocks( std::vector<Block>& Blocks, uint32_t ByteOffset, uint32_t IndexCount );
+
+    void EncodeStream( const uint8_t* Raw, const std::vector<Block>& Blocks, std::vector<uint8_t>& Encoded );
+
+    // Check the block table at the start of an encoded stream against the blocks and RawSize without looking at
+    // the payloads, and find where each block's payload begins, from the start of Encoded.  PayloadOffsets gets
+    // one more entry, the end of the last payload.  Enough to decode the stream somewhere else, e.g. on the GPU.
+    bool ReadBlockTable( const uint8_t* Encoded, size_t EncodedSize, const std::vector<Block>& Blocks,
+        size_t RawSize, std::vector<uint32_t>& PayloadOffsets );
+
+    // Returns false if the encoded data is truncated or does not match the blocks.  Raw receives RawSize
+    // bytes; anything not covered by a block is zeroed.
+    bool DecodeStream( const uint8_t* Encoded, size_t EncodedSize, const std::vector<Block>& Blocks,
+        uint8_t* Raw, size_t RawSize );
+}
@@ -14,15 +14,27 @@
 #include "Model.h"
 #include <string.h>
 #include <float.h>
+#include <ppl.h>
 
 Model::Model()
     : m_pMesh(nullptr)
+    , m_pMeshBounds(nullptr)
     , m_pMaterial(nullptr)
     , m_pVertexData(nullptr)
     , m_pIndexData(nullptr)
     , m_pVertexDataDepth(nullptr)
     , m_pIndexDataDepth(nullptr)
+    , m_pMeshletRanges(nullptr)
+    , m_pMeshlets(nullptr)
+    , m_pMeshletVertices(nullptr)
+    , m_pMeshletTriangles(nullptr)
+    , m_pMeshLods(nullptr)
+    , m_pLodIndices(nullptr)
+    , m_pBones(nullptr)
+    , m_pAnimationClips(nullptr)
+    , m_pAnimationKeys(nullptr)
     , m_SRVs(nullptr)
+    , m_Textures(nullptr)
 {
     Clear();
 }
@@ -40,7 +52,9 @@ void Model::Clear()
     m_IndexBufferDepth.Destroy();
 
     delete [] m_pMesh;
+    delete [] m_pMeshBounds;
     m_pMesh = nullptr;
+    m_pMeshBounds = nullptr;
     m_Header.meshCount = 0;
 
     delete [] m_pMaterial;
@@ -60,35 +74,96 @@ void Model::Clear()
     m_Header.vertexDataByteSizeDepth = 0;
     m_pIndexDataDepth = nullptr;
 
+    m_MeshletBuffer.Destroy();
+    m_MeshletVertexBuffer.Destroy();
+    m_MeshletTriangleBuffer.Destroy();
+
+    delete [] m_pMeshletRanges;
+    delete [] m_pMeshlets;
+    delete [] m_pMeshletVertices;
+    delete [] m_pMeshletTriangles;
+
+    m_pMeshletRanges = nullptr;
+    m_pMeshlets = nullptr;
+    m_MeshletCount = 0;
+    m_pMeshletVertices = nullptr;
+    m_MeshletVertexCount = 0;
+    m_pMeshletTriangles = nullptr;
+    m_MeshletTriangleCount = 0;
+
+    delete [] m_pMeshLods;
+    delete [] m_pLodIndices;
+
+    m_pMeshLods = nullptr;
+    m_LodCount = 0;
+    m_pLodIndices = nullptr;
+    m_LodIndexCount = 0;
+
+    m_BoneBuffer.Destroy();
+    m_AnimationKeyBuffer.Destroy();
+
+    delete [] m_pBones;
+    delete [] m_pAnimationClips;
+    delete [] m_pAnimationKeys;
+
+    m_pBones = nullptr;
+    m_BoneCount = 0;
+    m_pAnimationClips = nullptr;
+    m_AnimationClipCount = 0;
+    m_pAnimationKeys = nullptr;
+    m_AnimationKeyCount = 0;
+
     ReleaseTextures();
 
     m_Header.boundingBox.min = Vector3(0.0f);
     m_Header.boundingBox.max = Vector3(0.0f);
 }
 
-// assuming at least 3 floats for position
+namespace
+{
+    // assuming at least 3 floats for position
+    INLINE XMVECTOR LoadPosition(const unsigned char *positions, unsigned int vertexStride, unsigned int vertexIndex)
+    {
+        return XMLoadFloat3((const XMFLOAT3*)(positions + vertexIndex * vertexStride));
+    }
+}
+
 void Model::ComputeMeshBoundingBox(unsigned int meshIndex, BoundingBox &bbox) const
 {
     const Mesh *mesh = m_pMesh + meshIndex;
 
     if (mesh->vertexCount > 0)
     {
-        unsigned int vertexStride = mesh->vertexStride;
-
-        const float *p = (float*)(m_pVertexData + mesh->vertexDataByteOffset + mesh->attrib[attrib_position].offset);
-        const float *pEnd = (float*)(m_pVertexData + mesh->vertexDataByteOffset + mesh->vertexCount * mesh->vertexStride + mesh->attrib[attrib_position].offset);
-        bbox.min = Scalar(FLT_MAX);
-        bbox.max = Scalar(-FLT_MAX);
+        const unsigned int vertexStride = mesh->vertexStride;
+        const unsigned char *positions = m_pVertexData + mesh->vertexDataByteOffset + mesh->attrib[attrib_position].offset;
 
-        while (p < pEnd)
+        // Four vertices per iteration into separate accumulators, so the min and max chains don't serialize
+        XMVECTOR vMin[4], vMax[4];
+        for (int n = 0; n < 4; n++)
         {
-            Vector3 pos(*(p + 0), *(p + 1), *(p + 2));
-
-            bbox.min = Min(bbox.min, pos);
-            bbox.max = Max(bbox.max, pos);
+            vMin[n] = XMVectorReplicate(FLT_MAX);
+            vMax[n] = XMVectorReplicate(-FLT_MAX);
+        }
 
-            (*(uint8_t**)&p) += vertexStride;
+        unsigned int v = 0;
+        for (; v + 4 <= mesh->vertexCount; v += 4)
+        {
+            for (unsigned int n = 0; n < 4; n++)
+            {
+                XMVECTOR pos = LoadPosition(positions, vertexStride, v + n);
+                vMin[n] = XMVectorMin(vMin[n], pos);
+                vMax[n] = XMVectorMax(vMax[n], pos);
+            }
+        }
+        for (; v < mesh->vertexCount; v++)
+        {
+            XMVECTOR pos = LoadPosition(positions, vertexStride, v);
+            vMin[0] = XMVectorMin(vMin[0], pos);
+            vMax[0] = XMVectorMax(vMax[0], pos);
         }
+
+        bbox.min = Vector3(XMVectorMin(XMVectorMin(vMin[0], vMin[1]), XMVectorMin(vMin[2], vMin[3])));
+        bbox.max = Vector3(XMVectorMax(XMVectorMax(vMax[0], vMax[1]), XMVectorMax(vMax[2], vMax[3])));
     }
     else
     {
@@ -97,6 +172,72 @@ void Model::ComputeMeshBoundingBox(unsigned int meshIndex, BoundingBox &bbox) co
     }
 }
 
+// Needs the mesh's bounding box.  The sphere is centered on the box, and the cone is the one BuildMeshlets
+// makes for a meshlet: the average triangle normal, as wide as the normal farthest from it.
+void Model::ComputeMeshBounds(unsigned int meshIndex, MeshBounds &bounds) const
+{
+    const Mesh *mesh = m_pMesh + meshIndex;
+    const unsigned int vertexStride = mesh->vertexStride;
+    const unsigned char *positions = m_pVertexData + mesh->vertexDataByteOffset + mesh->attrib[attrib_position].offset;
+    const uint16_t *indices = (const uint16_t*)(m_pIndexData + mesh->indexDataByteOffset);
+
+    XMVECTOR center = XMVectorScale(XMVectorAdd(mesh->boundingBox.min, mesh->boundingBox.max), 0.5f);
+
+    XMVECTOR radiusSq[4] = { XMVectorZero(), XMVectorZero(), XMVectorZero(), XMVectorZero() };
+    unsigned int v = 0;
+    for (; v + 4 <= mesh->vertexCount; v += 4)
+    {
+        for (unsigned int n = 0; n < 4; n++)
+            radiusSq[n] = XMVectorMax(radiusSq[n], XMVector3LengthSq(XMVectorSubtract(LoadPosition(positions, vertexStride, v + n), center)));
+    }
+    for (; v < mesh->vertexCount; v++)
+        radiusSq[0] = XMVectorMax(radiusSq[0], XMVector3LengthSq(XMVectorSubtract(LoadPosition(positions, vertexStride, v), center)));
+
+    XMStoreFloat3((XMFLOAT3*)bounds.boundingSphere, center);
+    bounds.boundingSphere[3] = sqrtf(XMVectorGetX(XMVectorMax(XMVectorMax(radiusSq[0], radiusSq[1]), XMVectorMax(radiusSq[2], radiusSq[3]))));
+
+    // The normals are cheap enough to compute twice rather than store
+    auto TriangleNormal = [&](unsigned int i, XMVECTOR &normal)
+    {
+        XMVECTOR p0 = LoadPosition(positions, vertexStride, indices[i + 0]);
+        XMVECTOR p1 = LoadPosition(positions, vertexStride, indices[i + 1]);
+        XMVECTOR p2 = LoadPosition(positions, vertexStride, indices[i + 2]);
+        normal = XMVector3Cross(XMVectorSubtract(p1, p0), XMVectorSubtract(p2, p0));
+
+        XMVECTOR lengthSq = XMVector3LengthSq(normal);
+        if (XMVectorGetX(lengthSq) == 0.0f)
+            return false;
+        normal = XMVectorMultiply(normal, XMVectorReciprocalSqrt(lengthSq));
+        return true;
+    };
+
+    XMVECTOR axis = XMVectorZero();
+    XMVECTOR normal;
+    for (unsigned int i = 0; i + 3 <= mesh->indexCount; i += 3)
+    {
+        if (TriangleNormal(i, normal))
+            axis = XMVectorAdd(axis, normal);
+    }
+
+    float minDot = -1.0f;
+    if (XMVectorGetX(XMVector3LengthSq(axis)) > 0.0f)
+    {
+        axis = XMVector3Normalize(axis);
+        XMVECTOR vMinDot = XMVectorSplatOne();
+        for (unsigned int i = 0; i + 3 <= mesh->indexCount; i += 3)
+        {
+            if (TriangleNormal(i, normal))
+                vMinDot = XMVectorMin(vMinDot, XMVector3Dot(normal, axis));
+        }
+        minDot = XMVectorGetX(vMinDot);
+    }
+
+    XMStoreFloat3((XMFLOAT3*)bounds.coneAxis, axis);
+
+    // A cutoff of one is never passed, so cones that are nearly a hemisphere or wider are never culled
+    bounds.coneCutoff = minDot <= 0.1f ? 1.0f : sqrtf(1.0f - minDot * minDot);
+}
+
 void Model::ComputeGlobalBoundingBox(BoundingBox &bbox) const
 {
     if (m_Header.meshCount > 0)
@@ -120,10 +261,34 @@ void Model::ComputeGlobalBoundingBox(BoundingBox &bbox) const
 
 void Model::ComputeAllBoundingBoxes()
 {
-    for (unsigned int meshIndex = 0; meshIndex < m_Header.meshCount; meshIndex++)
+    delete [] m_pMeshBounds;
+    m_pMeshBounds = new MeshBounds[m_Header.meshCount];
+
+    // Meshes are independent, and large models have hundreds of them
+    concurrency::parallel_for(0u, m_Header.meshCount, [&](unsigned int meshIndex)
     {
         Mesh *mesh = m_pMesh + meshIndex;
         ComputeMeshBoundingBox(meshIndex, mesh->boundingBox);
-    }
+        ComputeMeshBounds(meshIndex, m_pMeshBounds[meshIndex]);
+    });
     ComputeGlobalBoundingBox(m_Header.boundingBox);
 }
+
+void Model::ComputeMeshBoundsFromBoxes()
+{
+    delete [] m_pMeshBounds;
+    m_pMeshBounds = new MeshBounds[m_Header.meshCount];
+
+    for (unsigned int meshIndex = 0; meshIndex < m_Header.meshCount; meshIndex++)
+    {
+        const BoundingBox &bbox = m_pMesh[meshIndex].boundingBox;
+        MeshBounds &bounds = m_pMeshBounds[meshIndex];
+
+        XMStoreFloat3((XMFLOAT3*)bounds.boundingSphere, (bbox.min + bbox.max) * 0.5f);
+        bounds.boundingSphere[3] = Length(bbox.max - bbox.min) * 0.5f;
+        bounds.coneAxis[0] = 0.0f;
+        bounds.coneAxis[1] = 0.0f;
+        bounds.coneAxis[2] = 1.0f;
+        bounds.coneCutoff = 1.0f;
+    }
+}
@@ -54,6 +54,8 @@ public:
         attrib_mask_normal = attrib_mask_2,
         attrib_mask_tangent = attrib_mask_3,
         attrib_mask_bitangent = attrib_mask_4,
+        attrib_mask_blendindices = attrib_mask_5,
+        attrib_mask_blendweights = attrib_mask_6,
     };
 
     enum
@@ -81,6 +83,8 @@ public:
         attrib_normal = attrib_2,
         attrib_tangent = attrib_3,
         attrib_bitangent = attrib_4,
+        attrib_blendindices = attrib_5, // four bone indices, ubyte
+        attrib_blendweights = attrib_6, // four weights, unorm ubyte summing to one
 
         maxAttribs = 16
     };
@@ -93,6 +97,7 @@ public:
         attrib_format_ushort,
         attrib_format_short,
         attrib_format_float,
+        attrib_format_half,
 
         attrib_formats
     };
@@ -114,6 +119,54 @@ public:
     };
     Header m_Header;
 
+    // SaveH3D() writes this ahead of the Header and places each data stream at an aligned file offset,
+    // so LoadH3D() can map the file and let the copy queue read the streams straight from the mapping.
+    // Files in the original layout start with the Header and are still loaded with buffered reads.
+    struct SectionTable
+    {
+        uint32_t magic;
+        uint32_t version;
+        uint64_t vertexDataOffset;
+        uint64_t indexDataOffset;
+        uint64_t vertexDataOffsetDepth;
+        uint64_t indexDataOffsetDepth;
+        uint64_t fileSize;
+
+        // Version 2: meshlet section (see Meshlet)
+        uint64_t meshletDataOffset;
+        uint32_t meshletCount;
+        uint32_t meshletVertexCount;
+        uint32_t meshletTriangleCount;
+
+        // Version 3: was reserved (and zero) in version 2
+        uint32_t flags;
+
+        // Version 4: level of detail section (see MeshLod)
+        uint64_t lodDataOffset;
+        uint32_t lodCount;
+        uint32_t lodIndexCount;
+
+        // Version 5: skeleton section (see Bone)
+        uint64_t skeletonDataOffset;
+        uint32_t boneCount;
+        uint32_t animationClipCount;
+        uint32_t animationKeyCount;
+        uint32_t reserved;
+
+        // Version 6: mesh bounds section (see MeshBounds)
+        uint64_t meshBoundsDataOffset;
+    };
+    enum { kSectionTableMagic = 0x41443348 /* "H3DA" */ };
+    enum { kSectionTableVersion = 6 };
+    // The vertex and index streams are encoded with MeshCodec and decoded on load.  The meshlet section is
+    // never encoded.
+    enum { kSectionFlagCompressedStreams = 0x1 };
+    enum { kSectionTableSizeV1 = offsetof(SectionTable, meshletDataOffset) };
+    enum { kSectionTableSizeV3 = offsetof(SectionTable, lodDataOffset) };
+    enum { kSectionTableSizeV4 = offsetof(SectionTable, skeletonDataOffset) };
+    enum { kSectionTableSizeV5 = offsetof(SectionTable, meshBoundsDataOffset) };
+    enum { kSectionAlignment = D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT };
+
     struct Attrib
     {
         uint16_t offset; // byte offset from the start of the vertex
@@ -144,6 +197,124 @@ public:
     };
     Mesh *m_pMesh;
 
+    // A bounding sphere and normal cone per mesh for CPU culling, in the same form as Meshlet.  The converter
+    // computes them with the bounding boxes and saves them; files without them get spheres around the boxes
+    // and cones that never cull.
+    struct MeshBounds
+    {
+        float boundingSphere[4]; // center and radius
+        float coneAxis[3];
+        float coneCutoff;
+    };
+    MeshBounds *m_pMeshBounds;
+
+    // Meshlets split the meshes into clusters of at most kMaxMeshletVertices vertices and kMaxMeshletTriangles
+    // triangles, small enough to cull individually and to feed a mesh shader.  Meshlet vertices are indices
+    // relative to the mesh's first vertex, like the index buffer.  Meshlet triangles pack three 8-bit indices
+    // into the meshlet's vertex list per uint32_t.  Only the full vertex stream has meshlets.
+    enum { kMaxMeshletVertices = 64 };
+    enum { kMaxMeshletTriangles = 126 };
+
+    struct Meshlet
+    {
+        float boundingSphere[4]; // center and radius
+        float coneAxis[3];
+        // the meshlet faces away from the eye if dot(center - eye, coneAxis) >= coneCutoff * length(center - eye) + radius
+        float coneCutoff;
+        uint32_t vertexOffset;
+        uint32_t vertexCount;
+        uint32_t triangleOffset;
+        uint32_t triangleCount;
+    };
+
+    struct MeshletRange
+    {
+        uint32_t meshletOffset;
+        uint32_t meshletCount;
+    };
+
+    // Resident for culling; null when the file has no meshlets
+    MeshletRange *m_pMeshletRanges;
+    Meshlet *m_pMeshlets;
+    uint32_t m_MeshletCount;
+    StructuredBuffer m_MeshletBuffer;
+    StructuredBuffer m_MeshletVertexBuffer;
+    StructuredBuffer m_MeshletTriangleBuffer;
+
+    // Only kept on the CPU while building and saving
+    uint32_t *m_pMeshletVertices;
+    uint32_t *m_pMeshletTriangles;
+    uint32_t m_MeshletVertexCount;
+    uint32_t m_MeshletTriangleCount;
+
+    // ModelConverter simplifies each mesh into up to kMaxLods - 1 coarser levels that index the same
+    // vertices.  Level 0 is the mesh itself, and level n > 0 of a mesh is m_pMeshLods[meshIndex * m_LodCount
+    // + n - 1].  Their indices follow the mesh indices in m_IndexBuffer, and the error grows with the level.
+    enum { kMaxLods = 4 };
+
+    struct MeshLod
+    {
+        uint32_t indexDataByteOffset; // into m_IndexBuffer, past the indexDataByteSize bytes of mesh indices
+        uint32_t indexCount;
+        float error; // the largest distance from the full mesh, in model units
+        uint32_t reserved;
+    };
+
+    // Resident for LOD selection; null when the file has no levels of detail
+    MeshLod *m_pMeshLods;
+    uint32_t m_LodCount;
+
+    // Only kept on the CPU while building and saving
+    uint16_t *m_pLodIndices;
+    uint32_t m_LodIndexCount;
+
+    // Skinned models add blend indices and weights to every full vertex; meshes that no bone moves get zero
+    // weights.  Skinning transforms a vertex from mesh space by the sum of the weighted skin matrices, where a
+    // bone's skin matrix is its animated model space transform times inverseBind.  Parents precede their
+    // children, so a bone's depth is one more than its parent's, and the roots are at depth zero.
+    enum { kMaxBones = 256 };
+
+    struct Bone
+    {
+        float inverseBind[12]; // the top three rows of a 4x4 matrix that transforms column vectors
+        int32_t parent; // -1 for a root
+        uint32_t depth;
+        uint32_t reserved[2];
+    };
+
+    // Clips are sampled at a fixed rate.  Sample s of a clip holds one key per bone, from
+    // m_pAnimationKeys[firstKey + s * m_BoneCount].  A clip with one sample is a still pose.
+    struct AnimationClip
+    {
+        enum { maxClipName = 64 };
+        char name[maxClipName];
+        float duration; // in seconds, (sampleCount - 1) / sampleRate
+        float sampleRate; // samples per second
+        uint32_t sampleCount;
+        uint32_t firstKey;
+    };
+
+    // The bone's transform relative to its parent: scale, then rotate, then translate
+    struct AnimationKey
+    {
+        float rotation[4]; // quaternion, xyzw
+        float translation[3];
+        float scale[3];
+        float reserved[2];
+    };
+
+    // Resident for animation; null when the model is not skinned
+    Bone *m_pBones;
+    uint32_t m_BoneCount;
+    AnimationClip *m_pAnimationClips;
+    uint32_t m_AnimationClipCount;
+    StructuredBuffer m_BoneBuffer;
+    StructuredBuffer m_AnimationKeyBuffer;
+
+    // Only kept on the CPU while building and saving
+    AnimationKey *m_pAnimationKeys;
+    uint32_t m_AnimationKeyCount;
+
     struct Material
     {
         Vector3 diffuse;
@@ -192,21 +363,55 @@ public:
         return m_Header.boundingBox;
     }
 
+    const MeshBounds& GetMeshBounds( uint32_t meshIndex ) const
+    {
+        return m_pMeshBounds[meshIndex];
+    }
+
+    // Quantized vertices store 16-bit UNORM positions relative to each mesh's bounding box, half precision
+    // texture coordinates, and octahedral 16-bit SNORM normals, tangents and bitangents.  The depth-only
+    // stream always stays float.
+    bool HasQuantizedVertices() const
+    {
+        return m_Header.meshCount > 0 && m_pMesh[0].attrib[attrib_position].format == attrib_format_ushort;
+    }
+
+    // Skinned vertices stay float (see VertexFormats::SkinnedVertex)
+    bool IsSkinned() const
+    {
+        return m_BoneCount > 0;
+    }
+
     D3D12_CPU_DESCRIPTOR_HANDLE* GetSRVs( uint32_t materialIdx ) const
     {
         return m_SRVs + materialIdx * 6;
     }
 
+    // Raise Resolutions[material] to the number of pixels that the material's meshes span when seen from ViewPos,
+    // in model space.  Assuming each mesh's textures span it once, that gives about one texel per pixel.
+    // PixelsPerUnit is the number of pixels that one unit covers at a distance of one unit.
+    void ComputeTextureResolutions( Vector3 ViewPos, float PixelsPerUnit, uint32_t* Resolutions ) const;
+
+    // Ask for streamed texture mips up to Resolutions[material] texels across
+    void RequestTextureResolutions( const uint32_t* Resolutions ) const;
+
 protected:
 
     bool LoadH3D(const char *filename);
-    bool SaveH3D(const char *filename) const;
+    bool LoadH3DMapped(const char *filename);
+    bool SaveH3D(const char *filename, bool compressStreams = false) const;
+    void ReadVertexStrides();
 
     void ComputeMeshBoundingBox(unsigned int meshIndex, BoundingBox &bbox) const;
+    void ComputeMeshBounds(unsigned int meshIndex, MeshBounds &bounds) const;
     void ComputeGlobalBoundingBox(BoundingBox &bbox) const;
+    // Computes every mesh's box, sphere and cone from the CPU copy of the vertices and indices, in parallel
     void ComputeAllBoundingBoxes();
+    // Stand-in bounds for files that don't store them, derived from the mesh boxes alone
+    void ComputeMeshBoundsFromBoxes();
 
     void ReleaseTextures();
     void LoadTextures();
     D3D12_CPU_DESCRIPTOR_HANDLE* m_SRVs;
+    TextureRef* m_Textures;                 // Material::texCount per material, kept loaded until released
 };
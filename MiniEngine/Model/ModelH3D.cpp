@@ -17,26 +17,69 @@
 #include "GraphicsCore.h"
 #include "DescriptorHeap.h"
 #include "CommandContext.h"
+#include "CommandListManager.h"
+#include "MeshCodec.h"
+#include "MeshStreamDecoder.h"
+#include "VertexFormats.h"
+#include "GpuMemory.h"
+#include "EngineTuning.h"
 #include <stdio.h>
+#include <algorithm>
 
-bool Model::LoadH3D(const char *filename)
-{
-    FILE *file = nullptr;
-    if (0 != fopen_s(&file, filename, "rb"))
-        return false;
+using Microsoft::WRL::ComPtr;
+using namespace Graphics;
 
-    bool ok = false;
+// Copy compressed streams to the GPU as they are stored and decode them there
+static BoolVar s_GpuDecompression("Graphics/Geometry/GPU Decompression", true);
 
-    if (1 != fread(&m_Header, sizeof(Header), 1, file)) goto h3d_load_fail;
+// The streams MeshCodec can encode, in file order
+enum { kVertexStream, kIndexStream, kVertexStreamDepth, kIndexStreamDepth, kCodecStreamCount };
 
-    m_pMesh = new Mesh [m_Header.meshCount];
-    m_pMaterial = new Material [m_Header.materialCount];
+// Each mesh's part of a stream is coded in blocks of its own, so a block never spans two vertex strides.  The
+// index stream is followed by the level of detail indices, which need m_pMeshLods.
+static void GetStreamBlocks(const Model& model, int stream, std::vector<MeshCodec::Block>& blocks)
+{
+    for (uint32_t meshIndex = 0; meshIndex < model.m_Header.meshCount; ++meshIndex)
+    {
+        const Model::Mesh& mesh = model.m_pMesh[meshIndex];
+        switch (stream)
+        {
+        case kVertexStream:
+            MeshCodec::AppendVertexBlocks(blocks, mesh.vertexDataByteOffset, mesh.vertexCount, mesh.vertexStride);
+            break;
+        case kVertexStreamDepth:
+            MeshCodec::AppendVertexBlocks(blocks, mesh.vertexDataByteOffsetDepth, mesh.vertexCountDepth, mesh.vertexStrideDepth);
+            break;
+        default:
+            MeshCodec::AppendIndexBlocks(blocks, mesh.indexDataByteOffset, mesh.indexCount);
+            break;
+        }
+    }
 
-    if (m_Header.meshCount > 0)
-        if (1 != fread(m_pMesh, sizeof(Mesh) * m_Header.meshCount, 1, file)) goto h3d_load_fail;
-    if (m_Header.materialCount > 0)
-        if (1 != fread(m_pMaterial, sizeof(Material) * m_Header.materialCount, 1, file)) goto h3d_load_fail;
+    if (stream == kIndexStream)
+    {
+        for (uint32_t lodIndex = 0; lodIndex < model.m_Header.meshCount * model.m_LodCount; ++lodIndex)
+        {
+            const Model::MeshLod& lod = model.m_pMeshLods[lodIndex];
+            MeshCodec::AppendIndexBlocks(blocks, lod.indexDataByteOffset, lod.indexCount);
+        }
+    }
+}
+
+// The size of an encoded stream is in its block table.  Returns UINT64_MAX if the table is out of bounds.
+static uint64_t GetEncodedStreamSize(const uint8_t* pView, uint64_t fileSize, uint64_t offset)
+{
+    if (offset + sizeof(uint32_t) > fileSize)
+        return UINT64_MAX;
+    uint64_t blockCount = *(const uint32_t*)(pView + offset);
+    uint64_t tableSize = (blockCount + 1) * sizeof(uint32_t);
+    if (offset + tableSize > fileSize)
+        return UINT64_MAX;
+    return tableSize + ((const uint32_t*)(pView + offset))[blockCount];
+}
 
+void Model::ReadVertexStrides()
+{
     m_VertexStride = m_pMesh[0].vertexStride;
     m_VertexStrideDepth = m_pMesh[0].vertexStrideDepth;
 #if _DEBUG
@@ -50,19 +93,45 @@ bool Model::LoadH3D(const char *filename)
     {
         const Mesh& mesh = m_pMesh[meshIndex];
 
-        ASSERT( mesh.attribsEnabled ==
-            (attrib_mask_position | attrib_mask_texcoord0 | attrib_mask_normal | attrib_mask_tangent | attrib_mask_bitangent) );
-        ASSERT(mesh.attrib[0].components == 3 && mesh.attrib[0].format == Model::attrib_format_float); // position
-        ASSERT(mesh.attrib[1].components == 2 && mesh.attrib[1].format == Model::attrib_format_float); // texcoord0
-        ASSERT(mesh.attrib[2].components == 3 && mesh.attrib[2].format == Model::attrib_format_float); // normal
-        ASSERT(mesh.attrib[3].components == 3 && mesh.attrib[3].format == Model::attrib_format_float); // tangent
-        ASSERT(mesh.attrib[4].components == 3 && mesh.attrib[4].format == Model::attrib_format_float); // bitangent
+        ASSERT(IsSkinned() ? VertexFormats::MeshUsesFormat<VertexFormats::SkinnedVertex>(mesh) :
+            HasQuantizedVertices() ? VertexFormats::MeshUsesFormat<VertexFormats::QuantizedVertex>(mesh) :
+            VertexFormats::MeshUsesFormat<VertexFormats::FloatVertex>(mesh));
 
         ASSERT( mesh.attribsEnabledDepth ==
             (attrib_mask_position) );
-        ASSERT(mesh.attrib[0].components == 3 && mesh.attrib[0].format == Model::attrib_format_float); // position
+        ASSERT(mesh.attribDepth[0].components == 3 && mesh.attribDepth[0].format == Model::attrib_format_float); // position
     }
 #endif
+}
+
+bool Model::LoadH3D(const char *filename)
+{
+    FILE *file = nullptr;
+    if (0 != fopen_s(&file, filename, "rb"))
+        return false;
+
+    bool ok = false;
+
+    // Files with a section table are loaded through a file mapping
+    uint32_t magic = 0;
+    if (1 == fread(&magic, sizeof(magic), 1, file) && magic == kSectionTableMagic)
+    {
+        fclose(file);
+        return LoadH3DMapped(filename);
+    }
+    rewind(file);
+
+    if (1 != fread(&m_Header, sizeof(Header), 1, file)) goto h3d_load_fail;
+
+    m_pMesh = new Mesh [m_Header.meshCount];
+    m_pMaterial = new Material [m_Header.materialCount];
+
+    if (m_Header.meshCount > 0)
+        if (1 != fread(m_pMesh, sizeof(Mesh) * m_Header.meshCount, 1, file)) goto h3d_load_fail;
+    if (m_Header.materialCount > 0)
+        if (1 != fread(m_pMaterial, sizeof(Material) * m_Header.materialCount, 1, file)) goto h3d_load_fail;
+
+    ReadVertexStrides();
 
     m_pVertexData = new unsigned char[ m_Header.vertexDataByteSize ];
     m_pIndexData = new unsigned char[ m_Header.indexDataByteSize ];
@@ -79,20 +148,25 @@ bool Model::LoadH3D(const char *filename)
     if (m_Header.indexDataByteSize > 0)
         if (1 != fread(m_pIndexDataDepth, m_Header.indexDataByteSize, 1, file)) goto h3d_load_fail;
 
-    m_VertexBuffer.Create(L"VertexBuffer", m_Header.vertexDataByteSize / m_VertexStride, m_VertexStride, m_pVertexData);
-    m_IndexBuffer.Create(L"IndexBuffer", m_Header.indexDataByteSize / sizeof(uint16_t), sizeof(uint16_t), m_pIndexData);
+    {
+        GpuMemory::ScopedCategory MemoryCategory(GpuMemory::kGeometry);
+        m_VertexBuffer.Create(L"VertexBuffer", m_Header.vertexDataByteSize / m_VertexStride, m_VertexStride, m_pVertexData);
+        m_IndexBuffer.Create(L"IndexBuffer", m_Header.indexDataByteSize / sizeof(uint16_t), sizeof(uint16_t), m_pIndexData);
+        m_VertexBufferDepth.Create(L"VertexBufferDepth", m_Header.vertexDataByteSizeDepth / m_VertexStrideDepth, m_VertexStrideDepth, m_pVertexDataDepth);
+        m_IndexBufferDepth.Create(L"IndexBufferDepth", m_Header.indexDataByteSize / sizeof(uint16_t), sizeof(uint16_t), m_pIndexDataDepth);
+    }
     delete [] m_pVertexData;
     m_pVertexData = nullptr;
     delete [] m_pIndexData;
     m_pIndexData = nullptr;
 
-    m_VertexBufferDepth.Create(L"VertexBufferDepth", m_Header.vertexDataByteSizeDepth / m_VertexStrideDepth, m_VertexStrideDepth, m_pVertexDataDepth);
-    m_IndexBufferDepth.Create(L"IndexBufferDepth", m_Header.indexDataByteSize / sizeof(uint16_t), sizeof(uint16_t), m_pIndexDataDepth);
     delete [] m_pVertexDataDepth;
     m_pVertexDataDepth = nullptr;
     delete [] m_pIndexDataDepth;
     m_pIndexDataDepth = nullptr;
 
+    ComputeMeshBoundsFromBoxes();
+
     LoadTextures();
 
     ok = true;
@@ -105,7 +179,383 @@ h3d_load_fail:
     return ok;
 }
 
-bool Model::SaveH3D(const char *filename) const
+bool Model::LoadH3DMapped(const char *filename)
+{
+    HANDLE hFile = CreateFile2(MakeWStr(filename).c_str(), GENERIC_READ, FILE_SHARE_READ, OPEN_EXISTING, nullptr);
+    if (hFile == INVALID_HANDLE_VALUE)
+        return false;
+
+    bool ok = false;
+    HANDLE hMapping = nullptr;
+    const uint8_t* pView = nullptr;
+    SectionTable sections = {};
+    uint64_t sectionTableSize = 0;
+    LARGE_INTEGER fileSize = {};
+    uint64_t metadataEnd = 0;
+    uint64_t meshletDataEnd = 0;
+    uint64_t lodDataEnd = 0;
+    uint64_t skeletonDataEnd = 0;
+    uint64_t meshBoundsDataEnd = 0;
+    uint64_t streamOffsets[kCodecStreamCount] = {};
+    uint64_t streamSizes[kCodecStreamCount] = {};
+    uint32_t rawSizes[kCodecStreamCount] = {};
+    std::vector<uint8_t> decodedStreams[kCodecStreamCount];
+    std::vector<MeshStreamDecoder::Block> gpuBlocks[kCodecStreamCount];
+    bool compressed = false;
+    bool gpuDecode = false;
+    ByteAddressBuffer encodedStreams;
+
+    ComPtr<ID3D12Device3> device3;
+    ComPtr<ID3D12Heap> fileHeap;
+    ComPtr<ID3D12Resource> fileBuffer;
+
+    struct Stream
+    {
+        GpuBuffer* buffer;
+        uint64_t offset;
+        uint32_t size;
+        const uint8_t* decoded; // uploaded instead of the file bytes when not null
+        const std::vector<MeshStreamDecoder::Block>* gpuBlocks; // decoded from encodedStreams when not null
+    };
+
+    if (!GetFileSizeEx(hFile, &fileSize) || (uint64_t)fileSize.QuadPart < kSectionTableSizeV1 + sizeof(Header))
+        goto h3d_map_fail;
+
+    hMapping = CreateFileMapping(hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (hMapping == nullptr)
+        goto h3d_map_fail;
+
+    pView = (const uint8_t*)MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0);
+    if (pView == nullptr)
+        goto h3d_map_fail;
+
+    // Older tables end before the fields of later sections, which then read as zero
+    memcpy(&sections, pView, kSectionTableSizeV1);
+    if (sections.version < 1 || sections.version > kSectionTableVersion)
+        goto h3d_map_fail;
+    sectionTableSize = sections.version == 1 ? kSectionTableSizeV1 : sections.version < 4 ? kSectionTableSizeV3 :
+        sections.version < 5 ? kSectionTableSizeV4 : sections.version < 6 ? kSectionTableSizeV5 : sizeof(SectionTable);
+    memcpy(&sections, pView, (size_t)sectionTableSize);
+    if (sections.fileSize != (uint64_t)fileSize.QuadPart)
+        goto h3d_map_fail;
+
+    memcpy(&m_Header, pView + sectionTableSize, sizeof(Header));
+
+    metadataEnd = sectionTableSize + sizeof(Header) +
+        (uint64_t)m_Header.meshCount * sizeof(Mesh) + (uint64_t)m_Header.materialCount * sizeof(Material);
+    if (m_Header.meshCount == 0 || metadataEnd > sections.vertexDataOffset ||
+        sections.lodCount >= kMaxLods || sections.lodIndexCount > (UINT32_MAX - m_Header.indexDataByteSize) / sizeof(uint16_t))
+        goto h3d_map_fail;
+
+    // Encoded streams are smaller than the raw sizes in the header
+    compressed = sections.version >= 3 && (sections.flags & kSectionFlagCompressedStreams) != 0;
+    streamOffsets[kVertexStream] = sections.vertexDataOffset;
+    streamOffsets[kIndexStream] = sections.indexDataOffset;
+    streamOffsets[kVertexStreamDepth] = sections.vertexDataOffsetDepth;
+    streamOffsets[kIndexStreamDepth] = sections.indexDataOffsetDepth;
+    rawSizes[kVertexStream] = m_Header.vertexDataByteSize;
+    rawSizes[kIndexStream] = m_Header.indexDataByteSize + sections.lodIndexCount * (uint32_t)sizeof(uint16_t);
+    rawSizes[kVertexStreamDepth] = m_Header.vertexDataByteSizeDepth;
+    rawSizes[kIndexStreamDepth] = m_Header.indexDataByteSize;
+    for (int stream = 0; stream < kCodecStreamCount; ++stream)
+    {
+        streamSizes[stream] = compressed ? GetEncodedStreamSize(pView, sections.fileSize, streamOffsets[stream]) : rawSizes[stream];
+        uint64_t streamEnd = stream + 1 < kCodecStreamCount ? streamOffsets[stream + 1] : sections.fileSize;
+        if (streamSizes[stream] == UINT64_MAX || streamOffsets[stream] + streamSizes[stream] > streamEnd)
+            goto h3d_map_fail;
+    }
+
+    if (sections.meshletCount > 0)
+    {
+        meshletDataEnd = sections.meshletDataOffset + (uint64_t)m_Header.meshCount * sizeof(MeshletRange) +
+            (uint64_t)sections.meshletCount * sizeof(Meshlet) +
+            ((uint64_t)sections.meshletVertexCount + sections.meshletTriangleCount) * sizeof(uint32_t);
+        if (sections.meshletDataOffset < sections.indexDataOffsetDepth + streamSizes[kIndexStreamDepth] ||
+            meshletDataEnd > sections.fileSize)
+            goto h3d_map_fail;
+    }
+
+    if (sections.lodCount > 0)
+    {
+        lodDataEnd = sections.lodDataOffset + (uint64_t)m_Header.meshCount * sections.lodCount * sizeof(MeshLod);
+        if (sections.lodDataOffset < std::max(sections.indexDataOffsetDepth + streamSizes[kIndexStreamDepth], meshletDataEnd) ||
+            lodDataEnd > sections.fileSize)
+            goto h3d_map_fail;
+
+        // Needed to decode the index stream, and stays resident for LOD selection
+        m_LodCount = sections.lodCount;
+        m_pMeshLods = new MeshLod [m_Header.meshCount * m_LodCount];
+        memcpy(m_pMeshLods, pView + sections.lodDataOffset, sizeof(MeshLod) * m_Header.meshCount * m_LodCount);
+        for (uint32_t lodIndex = 0; lodIndex < m_Header.meshCount * m_LodCount; ++lodIndex)
+        {
+            const MeshLod& lod = m_pMeshLods[lodIndex];
+            if (lod.indexDataByteOffset < m_Header.indexDataByteSize ||
+                lod.indexDataByteOffset + (uint64_t)lod.indexCount * sizeof(uint16_t) > rawSizes[kIndexStream])
+                goto h3d_map_fail;
+        }
+    }
+
+    if (sections.boneCount > 0)
+    {
+        skeletonDataEnd = sections.skeletonDataOffset + (uint64_t)sections.boneCount * sizeof(Bone) +
+            (uint64_t)sections.animationClipCount * sizeof(AnimationClip) + (uint64_t)sections.animationKeyCount * sizeof(AnimationKey);
+        if (sections.boneCount > kMaxBones || sections.animationClipCount == 0 ||
+            sections.skeletonDataOffset < std::max(std::max(sections.indexDataOffsetDepth + streamSizes[kIndexStreamDepth], meshletDataEnd), lodDataEnd) ||
+            skeletonDataEnd > sections.fileSize)
+            goto h3d_map_fail;
+
+        // The bones and clips stay resident for animation.  Skinning resolves a bone after its parent.
+        m_BoneCount = sections.boneCount;
+        m_pBones = new Bone [m_BoneCount];
+        memcpy(m_pBones, pView + sections.skeletonDataOffset, sizeof(Bone) * m_BoneCount);
+        for (uint32_t boneIndex = 0; boneIndex < m_BoneCount; ++boneIndex)
+        {
+            const Bone& bone = m_pBones[boneIndex];
+            if (bone.parent >= (int32_t)boneIndex || bone.parent < -1 ||
+                bone.depth != (bone.parent < 0 ? 0 : m_pBones[bone.parent].depth + 1))
+                goto h3d_map_fail;
+        }
+
+        m_AnimationClipCount = sections.animationClipCount;
+        m_pAnimationClips = new AnimationClip [m_AnimationClipCount];
+        memcpy(m_pAnimationClips, pView + sections.skeletonDataOffset + sizeof(Bone) * m_BoneCount,
+            sizeof(AnimationClip) * m_AnimationClipCount);
+        for (uint32_t clipIndex = 0; clipIndex < m_AnimationClipCount; ++clipIndex)
+        {
+            AnimationClip& clip = m_pAnimationClips[clipIndex];
+            clip.name[AnimationClip::maxClipName - 1] = 0;
+            if (clip.sampleCount == 0 || !(clip.sampleRate > 0.0f) ||
+                clip.firstKey + (uint64_t)clip.sampleCount * m_BoneCount > sections.animationKeyCount)
+                goto h3d_map_fail;
+        }
+    }
+
+    if (sections.meshBoundsDataOffset > 0)
+    {
+        meshBoundsDataEnd = sections.meshBoundsDataOffset + (uint64_t)m_Header.meshCount * sizeof(MeshBounds);
+        if (sections.meshBoundsDataOffset < std::max(std::max(std::max(sections.indexDataOffsetDepth + streamSizes[kIndexStreamDepth],
+                meshletDataEnd), lodDataEnd), skeletonDataEnd) ||
+            meshBoundsDataEnd > sections.fileSize)
+            goto h3d_map_fail;
+    }
+
+    // The mesh and material tables are small and stay resident, so copy them out of the view
+    m_pMesh = new Mesh [m_Header.meshCount];
+    m_pMaterial = new Material [m_Header.materialCount];
+    memcpy(m_pMesh, pView + sectionTableSize + sizeof(Header), sizeof(Mesh) * m_Header.meshCount);
+    memcpy(m_pMaterial, pView + sectionTableSize + sizeof(Header) + sizeof(Mesh) * m_Header.meshCount,
+        sizeof(Material) * m_Header.materialCount);
+
+    // Files from before the mesh bounds were saved get stand-ins from the boxes
+    if (sections.meshBoundsDataOffset > 0)
+    {
+        m_pMeshBounds = new MeshBounds [m_Header.meshCount];
+        memcpy(m_pMeshBounds, pView + sections.meshBoundsDataOffset, sizeof(MeshBounds) * m_Header.meshCount);
+    }
+    else
+    {
+        ComputeMeshBoundsFromBoxes();
+    }
+
+    if (IsSkinned() && !VertexFormats::ModelUsesFormat<VertexFormats::SkinnedVertex>(*this))
+        goto h3d_map_fail;
+
+    ReadVertexStrides();
+
+    // Decode on the CPU before any copies are queued, so a corrupt stream fails the load cleanly.  The GPU
+    // decoder only needs the block tables, which are checked against the buffers the blocks are decoded into.
+    // The encoded streams are contiguous, and their payload offsets must fit in 32 bits.
+    gpuDecode = compressed && s_GpuDecompression &&
+        streamOffsets[kIndexStreamDepth] + streamSizes[kIndexStreamDepth] - streamOffsets[kVertexStream] <= UINT32_MAX;
+    if (compressed)
+    {
+        auto bufferSize = [&](int stream) -> size_t
+        {
+            uint32_t elementSize = stream == kVertexStream ? m_VertexStride :
+                stream == kVertexStreamDepth ? m_VertexStrideDepth : (uint32_t)sizeof(uint16_t);
+            return rawSizes[stream] / elementSize * elementSize;
+        };
+
+        for (int stream = 0; stream < kCodecStreamCount; ++stream)
+        {
+            std::vector<MeshCodec::Block> blocks;
+            GetStreamBlocks(*this, stream, blocks);
+
+            if (gpuDecode)
+            {
+                std::vector<uint32_t> payloadOffsets;
+                if (!MeshCodec::ReadBlockTable(pView + streamOffsets[stream], (size_t)streamSizes[stream], blocks,
+                    bufferSize(stream), payloadOffsets))
+                    goto h3d_map_fail;
+
+                const uint32_t streamBase = (uint32_t)(streamOffsets[stream] - streamOffsets[kVertexStream]);
+                for (size_t i = 0; i < blocks.size(); ++i)
+                {
+                    MeshStreamDecoder::Block block = { blocks[i].byteOffset, blocks[i].count, blocks[i].stride,
+                        streamBase + payloadOffsets[i], streamBase + payloadOffsets[i + 1] };
+                    gpuBlocks[stream].push_back(block);
+                }
+                continue;
+            }
+
+            decodedStreams[stream].resize(rawSizes[stream]);
+            if (!MeshCodec::DecodeStream(pView + streamOffsets[stream], (size_t)streamSizes[stream], blocks,
+                decodedStreams[stream].data(), decodedStreams[stream].size()))
+                goto h3d_map_fail;
+        }
+    }
+
+    // So are the meshlet descriptions, for culling
+    if (sections.meshletCount > 0)
+    {
+        m_MeshletCount = sections.meshletCount;
+        m_pMeshletRanges = new MeshletRange [m_Header.meshCount];
+        m_pMeshlets = new Meshlet [m_MeshletCount];
+        memcpy(m_pMeshletRanges, pView + sections.meshletDataOffset, sizeof(MeshletRange) * m_Header.meshCount);
+        memcpy(m_pMeshlets, pView + sections.meshletDataOffset + sizeof(MeshletRange) * m_Header.meshCount,
+            sizeof(Meshlet) * m_MeshletCount);
+
+        GpuMemory::ScopedCategory MemoryCategory(GpuMemory::kGeometry);
+        m_MeshletBuffer.Create(L"Meshlets", m_MeshletCount, sizeof(Meshlet));
+        m_MeshletVertexBuffer.Create(L"MeshletVertices", sections.meshletVertexCount, sizeof(uint32_t));
+        m_MeshletTriangleBuffer.Create(L"MeshletTriangles", sections.meshletTriangleCount, sizeof(uint32_t));
+    }
+
+    if (m_BoneCount > 0)
+    {
+        GpuMemory::ScopedCategory MemoryCategory(GpuMemory::kGeometry);
+        m_BoneBuffer.Create(L"Bones", m_BoneCount, sizeof(Bone));
+        m_AnimationKeyBuffer.Create(L"AnimationKeys", sections.animationKeyCount, sizeof(AnimationKey));
+    }
+
+    {
+        GpuMemory::ScopedCategory MemoryCategory(GpuMemory::kGeometry);
+        m_VertexBuffer.Create(L"VertexBuffer", m_Header.vertexDataByteSize / m_VertexStride, m_VertexStride);
+        m_IndexBuffer.Create(L"IndexBuffer", rawSizes[kIndexStream] / sizeof(uint16_t), sizeof(uint16_t));
+        m_VertexBufferDepth.Create(L"VertexBufferDepth", m_Header.vertexDataByteSizeDepth / m_VertexStrideDepth, m_VertexStrideDepth);
+        m_IndexBufferDepth.Create(L"IndexBufferDepth", m_Header.indexDataByteSize / sizeof(uint16_t), sizeof(uint16_t));
+    }
+
+    {
+        uint64_t meshletOffset = sections.meshletDataOffset + sizeof(MeshletRange) * m_Header.meshCount;
+        uint64_t meshletVertexOffset = meshletOffset + sizeof(Meshlet) * (uint64_t)sections.meshletCount;
+        uint64_t meshletTriangleOffset = meshletVertexOffset + sizeof(uint32_t) * (uint64_t)sections.meshletVertexCount;
+        uint64_t animationKeyOffset = sections.skeletonDataOffset + sizeof(Bone) * (uint64_t)sections.boneCount +
+            sizeof(AnimationClip) * (uint64_t)sections.animationClipCount;
+
+        auto decoded = [&](int stream) { return compressed && !gpuDecode ? decodedStreams[stream].data() : nullptr; };
+        auto gpu = [&](int stream) { return gpuDecode ? &gpuBlocks[stream] : nullptr; };
+
+        const Stream streams[] =
+        {
+            { &m_VertexBuffer, sections.vertexDataOffset, m_Header.vertexDataByteSize, decoded(kVertexStream), gpu(kVertexStream) },
+            { &m_IndexBuffer, sections.indexDataOffset, rawSizes[kIndexStream], decoded(kIndexStream), gpu(kIndexStream) },
+            { &m_VertexBufferDepth, sections.vertexDataOffsetDepth, m_Header.vertexDataByteSizeDepth, decoded(kVertexStreamDepth), gpu(kVertexStreamDepth) },
+            { &m_IndexBufferDepth, sections.indexDataOffsetDepth, m_Header.indexDataByteSize, decoded(kIndexStreamDepth), gpu(kIndexStreamDepth) },
+            { &m_MeshletBuffer, meshletOffset, (uint32_t)sizeof(Meshlet) * sections.meshletCount, nullptr, nullptr },
+            { &m_MeshletVertexBuffer, meshletVertexOffset, (uint32_t)sizeof(uint32_t) * sections.meshletVertexCount, nullptr, nullptr },
+            { &m_MeshletTriangleBuffer, meshletTriangleOffset, (uint32_t)sizeof(uint32_t) * sections.meshletTriangleCount, nullptr, nullptr },
+            { &m_BoneBuffer, sections.skeletonDataOffset, (uint32_t)sizeof(Bone) * sections.boneCount, nullptr, nullptr },
+            { &m_AnimationKeyBuffer, animationKeyOffset, (uint32_t)sizeof(AnimationKey) * sections.animationKeyCount, nullptr, nullptr },
+        };
+
+        // Wrap the file mapping in a heap so the copy queue can read the streams in place.  This needs
+        // ID3D12Device3; otherwise fall back to staging the mapped bytes through upload memory.
+        if (SUCCEEDED(g_Device->QueryInterface(MY_IID_PPV_ARGS(&device3))) &&
+            SUCCEEDED(device3->OpenExistingHeapFromFileMapping(hMapping, MY_IID_PPV_ARGS(&fileHeap))))
+        {
+            D3D12_RESOURCE_DESC desc = CD3DX12_RESOURCE_DESC::Buffer(fileHeap->GetDesc().SizeInBytes,
+                D3D12_RESOURCE_FLAG_ALLOW_CROSS_ADAPTER);
+            if (FAILED(g_Device->CreatePlacedResource(fileHeap.Get(), 0, &desc, D3D12_RESOURCE_STATE_COMMON,
+                nullptr, MY_IID_PPV_ARGS(&fileBuffer))))
+                fileBuffer = nullptr;
+        }
+
+        uint64_t fenceValue = 0;
+
+        // One copy brings every encoded stream to the GPU
+        if (gpuDecode)
+        {
+            const uint64_t encodedBegin = streamOffsets[kVertexStream];
+            const size_t encodedSize = (size_t)(streamOffsets[kIndexStreamDepth] + streamSizes[kIndexStreamDepth] - encodedBegin);
+            encodedStreams.Create(L"Encoded Mesh Streams", (uint32_t)Math::DivideByMultiple(encodedSize, 4), 4);
+
+            if (fileBuffer != nullptr)
+                fenceValue = CommandContext::InitializeBufferAsync(encodedStreams, fileBuffer.Get(), (size_t)encodedBegin, encodedSize);
+            else
+                CommandContext::InitializeBuffer(encodedStreams, pView + encodedBegin, encodedSize);
+        }
+
+        for (const Stream& stream : streams)
+        {
+            if (stream.size == 0 || stream.gpuBlocks != nullptr)
+                continue;
+
+            if (stream.decoded != nullptr)
+                CommandContext::InitializeBuffer(*stream.buffer, stream.decoded, stream.size);
+            else if (fileBuffer != nullptr)
+                fenceValue = CommandContext::InitializeBufferAsync(*stream.buffer, fileBuffer.Get(), stream.offset, stream.size);
+            else
+                CommandContext::InitializeBuffer(*stream.buffer, pView + stream.offset, stream.size);
+        }
+
+        // The graphics queue waits for the copies, whichever queue made them, then decodes into the buffers
+        if (gpuDecode)
+        {
+            if (fenceValue != 0)
+                g_CommandManager.GetGraphicsQueue().StallForFence(fenceValue);
+
+            ComputeContext& decodeContext = ComputeContext::Begin(L"Decode Mesh Streams");
+            for (const Stream& stream : streams)
+            {
+                if (stream.gpuBlocks != nullptr)
+                    MeshStreamDecoder::Decode(decodeContext, encodedStreams, *stream.buffer,
+                        stream.gpuBlocks->data(), (uint32_t)stream.gpuBlocks->size());
+            }
+            decodeContext.Finish(true);
+            encodedStreams.Destroy();
+        }
+
+        // The mapping must outlive the copies.  Copy queue fences complete in order, so the last one covers all.
+        if (fenceValue != 0)
+            g_CommandManager.WaitForFence(fenceValue);
+    }
+
+    LoadTextures();
+
+    ok = true;
+
+h3d_map_fail:
+
+    fileBuffer = nullptr;
+    fileHeap = nullptr;
+    if (pView != nullptr)
+        UnmapViewOfFile(pView);
+    if (hMapping != nullptr)
+        CloseHandle(hMapping);
+    CloseHandle(hFile);
+
+    return ok;
+}
+
+static bool WritePadding(FILE *file, uint64_t &offset, uint64_t alignment)
+{
+    static const unsigned char zeros[4096] = {};
+
+    uint64_t padding = Math::AlignUp(offset, (size_t)alignment) - offset;
+    offset += padding;
+
+    while (padding > 0)
+    {
+        size_t chunk = (size_t)(padding < sizeof(zeros) ? padding : sizeof(zeros));
+        if (1 != fwrite(zeros, chunk, 1, file))
+            return false;
+        padding -= chunk;
+    }
+    return true;
+}
+
+bool Model::SaveH3D(const char *filename, bool compressStreams) const
 {
     FILE *file = nullptr;
     if (0 != fopen_s(&file, filename, "wb"))
@@ -113,6 +563,85 @@ bool Model::SaveH3D(const char *filename) const
 
     bool ok = false;
 
+    const unsigned char* streamData[kCodecStreamCount] = { m_pVertexData, m_pIndexData, m_pVertexDataDepth, m_pIndexDataDepth };
+    uint64_t streamSizes[kCodecStreamCount] =
+        { m_Header.vertexDataByteSize, m_Header.indexDataByteSize, m_Header.vertexDataByteSizeDepth, m_Header.indexDataByteSize };
+    std::vector<uint8_t> encodedStreams[kCodecStreamCount];
+    std::vector<uint8_t> indexStream;
+
+    // Lay out every data stream at an aligned offset (see SectionTable)
+    SectionTable sections = {};
+    sections.magic = kSectionTableMagic;
+    sections.version = kSectionTableVersion;
+
+    // The level of detail indices are stored at the end of the index stream
+    if (m_LodCount > 0)
+    {
+        indexStream.assign(m_pIndexData, m_pIndexData + m_Header.indexDataByteSize);
+        indexStream.insert(indexStream.end(), (const uint8_t*)m_pLodIndices, (const uint8_t*)(m_pLodIndices + m_LodIndexCount));
+        streamData[kIndexStream] = indexStream.data();
+        streamSizes[kIndexStream] = indexStream.size();
+    }
+
+    if (compressStreams)
+    {
+        sections.flags |= kSectionFlagCompressedStreams;
+        for (int stream = 0; stream < kCodecStreamCount; ++stream)
+        {
+            std::vector<MeshCodec::Block> blocks;
+            GetStreamBlocks(*this, stream, blocks);
+            MeshCodec::EncodeStream(streamData[stream], blocks, encodedStreams[stream]);
+            streamData[stream] = encodedStreams[stream].data();
+            streamSizes[stream] = encodedStreams[stream].size();
+        }
+    }
+
+    uint64_t offset = sizeof(SectionTable) + sizeof(Header) +
+        (uint64_t)m_Header.meshCount * sizeof(Mesh) + (uint64_t)m_Header.materialCount * sizeof(Material);
+    sections.vertexDataOffset = Math::AlignUp(offset, kSectionAlignment);
+    sections.indexDataOffset = Math::AlignUp(sections.vertexDataOffset + streamSizes[kVertexStream], kSectionAlignment);
+    sections.vertexDataOffsetDepth = Math::AlignUp(sections.indexDataOffset + streamSizes[kIndexStream], kSectionAlignment);
+    sections.indexDataOffsetDepth = Math::AlignUp(sections.vertexDataOffsetDepth + streamSizes[kVertexStreamDepth], kSectionAlignment);
+    sections.fileSize = Math::AlignUp(sections.indexDataOffsetDepth + streamSizes[kIndexStreamDepth], kSectionAlignment);
+
+    // The meshlet section holds the per-mesh ranges, the meshlets, their vertices and their triangles
+    if (m_MeshletCount > 0)
+    {
+        sections.meshletDataOffset = sections.fileSize;
+        sections.meshletCount = m_MeshletCount;
+        sections.meshletVertexCount = m_MeshletVertexCount;
+        sections.meshletTriangleCount = m_MeshletTriangleCount;
+        sections.fileSize = Math::AlignUp(sections.meshletDataOffset + m_Header.meshCount * sizeof(MeshletRange) +
+            m_MeshletCount * sizeof(Meshlet) + (m_MeshletVertexCount + m_MeshletTriangleCount) * sizeof(uint32_t), kSectionAlignment);
+    }
+
+    if (m_LodCount > 0)
+    {
+        sections.lodDataOffset = sections.fileSize;
+        sections.lodCount = m_LodCount;
+        sections.lodIndexCount = m_LodIndexCount;
+        sections.fileSize = Math::AlignUp(sections.lodDataOffset + m_Header.meshCount * m_LodCount * sizeof(MeshLod), kSectionAlignment);
+    }
+
+    // The skeleton section holds the bones, the clips and their keys
+    if (m_BoneCount > 0)
+    {
+        sections.skeletonDataOffset = sections.fileSize;
+        sections.boneCount = m_BoneCount;
+        sections.animationClipCount = m_AnimationClipCount;
+        sections.animationKeyCount = m_AnimationKeyCount;
+        sections.fileSize = Math::AlignUp(sections.skeletonDataOffset + m_BoneCount * sizeof(Bone) +
+            m_AnimationClipCount * sizeof(AnimationClip) + m_AnimationKeyCount * sizeof(AnimationKey), kSectionAlignment);
+    }
+
+    // Spheres and cones per mesh, so that they aren't recomputed at load
+    if (m_pMeshBounds != nullptr)
+    {
+        sections.meshBoundsDataOffset = sections.fileSize;
+        sections.fileSize = Math::AlignUp(sections.meshBoundsDataOffset + m_Header.meshCount * sizeof(MeshBounds), kSectionAlignment);
+    }
+
+    if (1 != fwrite(&sections, sizeof(SectionTable), 1, file)) goto h3d_save_fail;
     if (1 != fwrite(&m_Header, sizeof(Header), 1, file)) goto h3d_save_fail;
 
     if (m_Header.meshCount > 0)
@@ -120,15 +649,51 @@ bool Model::SaveH3D(const char *filename) const
     if (m_Header.materialCount > 0)
         if (1 != fwrite(m_pMaterial, sizeof(Material) * m_Header.materialCount, 1, file)) goto h3d_save_fail;
 
-    if (m_Header.vertexDataByteSize > 0)
-        if (1 != fwrite(m_pVertexData, m_Header.vertexDataByteSize, 1, file)) goto h3d_save_fail;
-    if (m_Header.indexDataByteSize > 0)
-        if (1 != fwrite(m_pIndexData, m_Header.indexDataByteSize, 1, file)) goto h3d_save_fail;
+    for (int stream = 0; stream < kCodecStreamCount; ++stream)
+    {
+        if (!WritePadding(file, offset, kSectionAlignment)) goto h3d_save_fail;
+        if (streamSizes[stream] > 0)
+            if (1 != fwrite(streamData[stream], (size_t)streamSizes[stream], 1, file)) goto h3d_save_fail;
+        offset += streamSizes[stream];
+    }
 
-    if (m_Header.vertexDataByteSizeDepth > 0)
-        if (1 != fwrite(m_pVertexDataDepth, m_Header.vertexDataByteSizeDepth, 1, file)) goto h3d_save_fail;
-    if (m_Header.indexDataByteSize > 0)
-        if (1 != fwrite(m_pIndexDataDepth, m_Header.indexDataByteSize, 1, file)) goto h3d_save_fail;
+    if (m_MeshletCount > 0)
+    {
+        if (!WritePadding(file, offset, kSectionAlignment)) goto h3d_save_fail;
+        if (1 != fwrite(m_pMeshletRanges, sizeof(MeshletRange) * m_Header.meshCount, 1, file)) goto h3d_save_fail;
+        if (1 != fwrite(m_pMeshlets, sizeof(Meshlet) * m_MeshletCount, 1, file)) goto h3d_save_fail;
+        if (1 != fwrite(m_pMeshletVertices, sizeof(uint32_t) * m_MeshletVertexCount, 1, file)) goto h3d_save_fail;
+        if (1 != fwrite(m_pMeshletTriangles, sizeof(uint32_t) * m_MeshletTriangleCount, 1, file)) goto h3d_save_fail;
+        offset += m_Header.meshCount * sizeof(MeshletRange) + m_MeshletCount * sizeof(Meshlet) +
+            (m_MeshletVertexCount + m_MeshletTriangleCount) * sizeof(uint32_t);
+    }
+
+    if (m_LodCount > 0)
+    {
+        if (!WritePadding(file, offset, kSectionAlignment)) goto h3d_save_fail;
+        if (1 != fwrite(m_pMeshLods, sizeof(MeshLod) * m_Header.meshCount * m_LodCount, 1, file)) goto h3d_save_fail;
+        offset += m_Header.meshCount * m_LodCount * sizeof(MeshLod);
+    }
+
+    if (m_BoneCount > 0)
+    {
+        if (!WritePadding(file, offset, kSectionAlignment)) goto h3d_save_fail;
+        if (1 != fwrite(m_pBones, sizeof(Bone) * m_BoneCount, 1, file)) goto h3d_save_fail;
+        if (1 != fwrite(m_pAnimationClips, sizeof(AnimationClip) * m_AnimationClipCount, 1, file)) goto h3d_save_fail;
+        if (1 != fwrite(m_pAnimationKeys, sizeof(AnimationKey) * m_AnimationKeyCount, 1, file)) goto h3d_save_fail;
+        offset += m_BoneCount * sizeof(Bone) + m_AnimationClipCount * sizeof(AnimationClip) + m_AnimationKeyCount * sizeof(AnimationKey);
+    }
+
+    if (m_pMeshBounds != nullptr)
+    {
+        if (!WritePadding(file, offset, kSectionAlignment)) goto h3d_save_fail;
+        if (1 != fwrite(m_pMeshBounds, sizeof(MeshBounds) * m_Header.meshCount, 1, file)) goto h3d_save_fail;
+        offset += m_Header.meshCount * sizeof(MeshBounds);
+    }
+
+    // Pad the end too, so that a whole-file mapping covers every section
+    if (!WritePadding(file, offset, kSectionAlignment)) goto h3d_save_fail;
+    ASSERT(offset == sections.fileSize);
 
     ok = true;
 
@@ -142,21 +707,9 @@ h3d_save_fail:
 
 void Model::ReleaseTextures()
 {
-    /*
-    if (m_Textures != nullptr)
-    {
-        for (uint32_t materialIdx = 0; materialIdx < m_Header.materialCount; ++materialIdx)
-        {
-            for (int n = 0; n < Material::texCount; n++)
-            {
-                if (m_Textures[materialIdx * Material::texCount + n])
-                    m_Textures[materialIdx * Material::texCount + n]->Release();
-                m_Textures[materialIdx * Material::texCount + n] = nullptr;
-            }
-        }
-        delete [] m_Textures;
-    }
-    */
+    // Textures no other model refers to are unloaded
+    delete [] m_Textures;
+    m_Textures = nullptr;
 }
 
 void Model::LoadTextures(void)
@@ -164,8 +717,9 @@ void Model::LoadTextures(void)
     ReleaseTextures();
 
     m_SRVs = new D3D12_CPU_DESCRIPTOR_HANDLE[m_Header.materialCount * 6];
+    m_Textures = new TextureRef[m_Header.materialCount * Material::texCount];
 
-    const ManagedTexture* MatTextures[6] = {};
+    TextureRef MatTextures[6];
 
     for (uint32_t materialIdx = 0; materialIdx < m_Header.materialCount; ++materialIdx)
     {
@@ -209,5 +763,43 @@ void Model::LoadTextures(void)
         m_SRVs[materialIdx * 6 + 3] = MatTextures[3]->GetSRV();
         m_SRVs[materialIdx * 6 + 4] = MatTextures[0]->GetSRV();
         m_SRVs[materialIdx * 6 + 5] = MatTextures[0]->GetSRV();
+
+        for (int n = 0; n < Material::texCount; n++)
+            m_Textures[materialIdx * Material::texCount + n] = MatTextures[n];
+    }
+}
+
+void Model::ComputeTextureResolutions( Vector3 ViewPos, float PixelsPerUnit, uint32_t* Resolutions ) const
+{
+    for (uint32_t meshIndex = 0; meshIndex < m_Header.meshCount; ++meshIndex)
+    {
+        const Mesh& mesh = m_pMesh[meshIndex];
+
+        // The whole extent of the mesh at the distance of its nearest point, so that nothing of it is short of
+        // texels.  From inside the box, it needs everything.
+        const float Distance = Length(ViewPos - Clamp(ViewPos, mesh.boundingBox.min, mesh.boundingBox.max));
+        const float Pixels = Length(mesh.boundingBox.max - mesh.boundingBox.min) * PixelsPerUnit;
+
+        uint32_t Resolution = D3D12_REQ_TEXTURE2D_U_OR_V_DIMENSION;
+        if (Pixels < Distance * Resolution)
+            Resolution = (uint32_t)(Pixels / Distance);
+
+        uint32_t& MaterialResolution = Resolutions[mesh.materialIndex];
+        MaterialResolution = std::max(MaterialResolution, Resolution);
+    }
+}
+
+void Model::RequestTextureResolutions( const uint32_t* Resolutions ) const
+{
+    if (m_Textures == nullptr)
+        return;
+
+    for (uint32_t materialIdx = 0; materialIdx < m_Header.materialCount; ++materialIdx)
+    {
+        for (int n = 0; n < Material::texCount; n++)
+        {
+            if (const ManagedTexture* Tex = m_Textures[materialIdx * Material::texCount + n].Get())
+                Tex->RequestResolution(Resolutions[materialIdx]);
+        }
     }
 }
@@ -0,0 +1,193 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Developed by Minigraph
+//
+// The vertex formats that ModelConverter writes, known at compile time.  Each gets a vertex structure, the
+// input layout that reads it, and the Model::Attrib descriptors a mesh carries when it uses the format.  The
+// layouts and descriptors take their offsets from the structures and are checked against each other here, so
+// they cannot drift apart.  Code that knows a model's format can use sizeof(Vertex) as a constant stride.
+//
+
+#pragma once
+
+#include "Model.h"
+#include <stddef.h>
+
+namespace VertexFormats
+{
+    // What AssimpModel imports: everything stored as float
+    struct FloatVertex
+    {
+        float position[3];
+        float texcoord0[2];
+        float normal[3];
+        float tangent[3];
+        float bitangent[3];
+    };
+
+    // What AssimpModel::QuantizeVertices() writes
+    struct QuantizedVertex
+    {
+        uint16_t position[4];   // unorm in the mesh bounding box, w unused (DXGI has no three component 16-bit format)
+        uint16_t texcoord0[2];  // half
+        int16_t normal[2];      // octahedral snorm
+        int16_t tangent[2];
+        int16_t bitangent[2];
+    };
+
+    // What AssimpModel imports for a model with bones: a FloatVertex followed by its bone influences.  The
+    // skinning pass writes the same layout, so a skinned vertex buffer can replace the model's.
+    struct SkinnedVertex
+    {
+        float position[3];
+        float texcoord0[2];
+        float normal[3];
+        float tangent[3];
+        float bitangent[3];
+        uint8_t blendIndices[4];
+        uint8_t blendWeights[4];    // unorm, summing to 255, or all zero when no bone moves the vertex
+    };
+
+    // Existing .h3d files depend on these sizes
+    static_assert(sizeof(FloatVertex) == 56, "FloatVertex must not be padded");
+    static_assert(sizeof(QuantizedVertex) == 24, "QuantizedVertex must not be padded");
+    static_assert(sizeof(SkinnedVertex) == 64, "SkinnedVertex must not be padded");
+
+    // Position, texcoord0, normal, tangent and bitangent, in Model::attrib_* order.  These are all the shaders
+    // read, so the input layouts have no more elements.
+    enum { kInputElementCount = 5 };
+
+    // Followed by the blend indices and weights
+    enum { kSkinnedAttribCount = 7 };
+
+#define VERTEX_ELEMENT( Semantic, Format, Vertex, Member ) \
+    { Semantic, 0, Format, 0, offsetof(Vertex, Member), D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 }
+
+    constexpr D3D12_INPUT_ELEMENT_DESC kFloatInputLayout[kInputElementCount] =
+    {
+        VERTEX_ELEMENT( "POSITION", DXGI_FORMAT_R32G32B32_FLOAT, FloatVertex, position ),
+        VERTEX_ELEMENT( "TEXCOORD", DXGI_FORMAT_R32G32_FLOAT, FloatVertex, texcoord0 ),
+        VERTEX_ELEMENT( "NORMAL", DXGI_FORMAT_R32G32B32_FLOAT, FloatVertex, normal ),
+        VERTEX_ELEMENT( "TANGENT", DXGI_FORMAT_R32G32B32_FLOAT, FloatVertex, tangent ),
+        VERTEX_ELEMENT( "BITANGENT", DXGI_FORMAT_R32G32B32_FLOAT, FloatVertex, bitangent ),
+    };
+
+    constexpr D3D12_INPUT_ELEMENT_DESC kQuantizedInputLayout[kInputElementCount] =
+    {
+        VERTEX_ELEMENT( "POSITION", DXGI_FORMAT_R16G16B16A16_UNORM, QuantizedVertex, position ),
+        VERTEX_ELEMENT( "TEXCOORD", DXGI_FORMAT_R16G16_FLOAT, QuantizedVertex, texcoord0 ),
+        VERTEX_ELEMENT( "NORMAL", DXGI_FORMAT_R16G16_SNORM, QuantizedVertex, normal ),
+        VERTEX_ELEMENT( "TANGENT", DXGI_FORMAT_R16G16_SNORM, QuantizedVertex, tangent ),
+        VERTEX_ELEMENT( "BITANGENT", DXGI_FORMAT_R16G16_SNORM, QuantizedVertex, bitangent ),
+    };
+
+    constexpr D3D12_INPUT_ELEMENT_DESC kSkinnedInputLayout[kInputElementCount] =
+    {
+        VERTEX_ELEMENT( "POSITION", DXGI_FORMAT_R32G32B32_FLOAT, SkinnedVertex, position ),
+        VERTEX_ELEMENT( "TEXCOORD", DXGI_FORMAT_R32G32_FLOAT, SkinnedVertex, texcoord0 ),
+        VERTEX_ELEMENT( "NORMAL", DXGI_FORMAT_R32G32B32_FLOAT, SkinnedVertex, normal ),
+        VERTEX_ELEMENT( "TANGENT", DXGI_FORMAT_R32G32B32_FLOAT, SkinnedVertex, tangent ),
+        VERTEX_ELEMENT( "BITANGENT", DXGI_FORMAT_R32G32B32_FLOAT, SkinnedVertex, bitangent ),
+    };
+
+#undef VERTEX_ELEMENT
+
+    // Offset, normalized, components and format, as ModelConverter fills them in
+    constexpr Model::Attrib kFloatAttribs[kInputElementCount] =
+    {
+        { offsetof(FloatVertex, position), 0, 3, Model::attrib_format_float },
+        { offsetof(FloatVertex, texcoord0), 0, 2, Model::attrib_format_float },
+        { offsetof(FloatVertex, normal), 0, 3, Model::attrib_format_float },
+        { offsetof(FloatVertex, tangent), 0, 3, Model::attrib_format_float },
+        { offsetof(FloatVertex, bitangent), 0, 3, Model::attrib_format_float },
+    };
+
+    constexpr Model::Attrib kQuantizedAttribs[kInputElementCount] =
+    {
+        { offsetof(QuantizedVertex, position), 1, 3, Model::attrib_format_ushort },
+        { offsetof(QuantizedVertex, texcoord0), 0, 2, Model::attrib_format_half },
+        { offsetof(QuantizedVertex, normal), 1, 2, Model::attrib_format_short },
+        { offsetof(QuantizedVertex, tangent), 1, 2, Model::attrib_format_short },
+        { offsetof(QuantizedVertex, bitangent), 1, 2, Model::attrib_format_short },
+    };
+
+    constexpr Model::Attrib kSkinnedAttribs[kSkinnedAttribCount] =
+    {
+        { offsetof(SkinnedVertex, position), 0, 3, Model::attrib_format_float },
+        { offsetof(SkinnedVertex, texcoord0), 0, 2, Model::attrib_format_float },
+        { offsetof(SkinnedVertex, normal), 0, 3, Model::attrib_format_float },
+        { offsetof(SkinnedVertex, tangent), 0, 3, Model::attrib_format_float },
+        { offsetof(SkinnedVertex, bitangent), 0, 3, Model::attrib_format_float },
+        { offsetof(SkinnedVertex, blendIndices), 0, 4, Model::attrib_format_ubyte },
+        { offsetof(SkinnedVertex, blendWeights), 1, 4, Model::attrib_format_ubyte },
+    };
+
+    constexpr bool LayoutMatchesAttribs( const D3D12_INPUT_ELEMENT_DESC* Layout, const Model::Attrib* Attribs, uint32_t Count )
+    {
+        return Count == 0 || (Layout->AlignedByteOffset == Attribs->offset && LayoutMatchesAttribs(Layout + 1, Attribs + 1, Count - 1));
+    }
+
+    static_assert(LayoutMatchesAttribs(kFloatInputLayout, kFloatAttribs, kInputElementCount), "Float layout and attributes differ");
+    static_assert(LayoutMatchesAttribs(kQuantizedInputLayout, kQuantizedAttribs, kInputElementCount), "Quantized layout and attributes differ");
+    static_assert(LayoutMatchesAttribs(kSkinnedInputLayout, kSkinnedAttribs, kInputElementCount), "Skinned layout and attributes differ");
+
+    template <typename Vertex> struct Format;
+
+    template <> struct Format<FloatVertex>
+    {
+        enum { kAttribCount = kInputElementCount };
+        static const D3D12_INPUT_ELEMENT_DESC* InputLayout() { return kFloatInputLayout; }
+        static const Model::Attrib* Attribs() { return kFloatAttribs; }
+    };
+
+    template <> struct Format<QuantizedVertex>
+    {
+        enum { kAttribCount = kInputElementCount };
+        static const D3D12_INPUT_ELEMENT_DESC* InputLayout() { return kQuantizedInputLayout; }
+        static const Model::Attrib* Attribs() { return kQuantizedAttribs; }
+    };
+
+    template <> struct Format<SkinnedVertex>
+    {
+        enum { kAttribCount = kSkinnedAttribCount };
+        static const D3D12_INPUT_ELEMENT_DESC* InputLayout() { return kSkinnedInputLayout; }
+        static const Model::Attrib* Attribs() { return kSkinnedAttribs; }
+    };
+
+    // Whether the mesh's vertices are laid out exactly as Vertex.  The normalized flags are not compared because
+    // the input layout formats decide how the shaders see each attribute.
+    template <typename Vertex>
+    bool MeshUsesFormat( const Model::Mesh& mesh )
+    {
+        // The attributes of every format are the first ones, in order
+        const uint32_t AllAttribs = (1 << Format<Vertex>::kAttribCount) - 1;
+        if (mesh.vertexStride != sizeof(Vertex) || mesh.attribsEnabled != AllAttribs)
+            return false;
+
+        const Model::Attrib* Expected = Format<Vertex>::Attribs();
+        for (uint32_t i = 0; i < Format<Vertex>::kAttribCount; ++i)
+        {
+            if (mesh.attrib[i].offset != Expected[i].offset || mesh.attrib[i].components != Expected[i].components ||
+                mesh.attrib[i].format != Expected[i].format)
+                return false;
+        }
+        return true;
+    }
+
+    template <typename Vertex>
+    bool ModelUsesFormat( const Model& model )
+    {
+        for (uint32_t meshIndex = 0; meshIndex < model.m_Header.meshCount; ++meshIndex)
+        {
+            if (!MeshUsesFormat<Vertex>(model.m_pMesh[meshIndex]))
+                return false;
+        }
+        return true;
+    }
+}
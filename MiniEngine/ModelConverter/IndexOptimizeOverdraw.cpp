@@ -0,0 +1,274 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Developed by Minigraph
+//
+
+//-----------------------------------------------------------------------------
+//  The overdraw pass follows "Fast Triangle Reordering for Vertex Locality
+//  and Reduced Overdraw" by Sander, Nehab and Barczak (SIGGRAPH 2007),
+//  with the view-independent cluster sort from that paper.
+//-----------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <assert.h>
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+#include <vector>
+
+#include "IndexOptimizeOverdraw.h"
+
+namespace
+{
+    // A simulated cache with least recently used replacement.  Entries are kept in order of use, most recent
+    // first.  The caches simulated here are small, so a linear search is fast enough.
+    class LRUCache
+    {
+    public:
+        LRUCache(uint16_t size) : m_Size(size), m_Count(0)
+        {
+            assert(size > 0 && size <= kMaxSize);
+        }
+
+        void Clear() { m_Count = 0; }
+
+        // Returns true on a miss
+        bool Access(uint32_t tag)
+        {
+            uint32_t pos = 0;
+            while (pos < m_Count && m_Entries[pos] != tag)
+                pos++;
+
+            bool miss = pos == m_Count;
+            if (miss)
+            {
+                if (m_Count < m_Size)
+                    m_Count++;
+                pos = m_Count - 1;
+            }
+
+            for (; pos > 0; pos--)
+                m_Entries[pos] = m_Entries[pos - 1];
+            m_Entries[0] = tag;
+
+            return miss;
+        }
+
+    private:
+        enum { kMaxSize = 64 };
+        uint32_t m_Entries[kMaxSize];
+        uint32_t m_Size;
+        uint32_t m_Count;
+    };
+
+    template <typename IndexType>
+    uint32_t AccessTriangle(LRUCache& cache, const IndexType* triangle)
+    {
+        return (uint32_t)cache.Access(triangle[0]) + (uint32_t)cache.Access(triangle[1]) + (uint32_t)cache.Access(triangle[2]);
+    }
+
+    const float* GetPosition(const float* positions, uint32_t positionStride, uint32_t index)
+    {
+        return (const float*)((const uint8_t*)positions + index * positionStride);
+    }
+
+    // Returns the (unnormalized) triangle normal, whose length is twice the area, and the centroid
+    template <typename IndexType>
+    void GetTriangleNormalAndCentroid(const float* positions, uint32_t positionStride, const IndexType* triangle,
+        float normal[3], float centroid[3])
+    {
+        const float* p0 = GetPosition(positions, positionStride, triangle[0]);
+        const float* p1 = GetPosition(positions, positionStride, triangle[1]);
+        const float* p2 = GetPosition(positions, positionStride, triangle[2]);
+
+        float e1[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+        float e2[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+
+        normal[0] = e1[1] * e2[2] - e1[2] * e2[1];
+        normal[1] = e1[2] * e2[0] - e1[0] * e2[2];
+        normal[2] = e1[0] * e2[1] - e1[1] * e2[0];
+
+        for (int n = 0; n < 3; n++)
+            centroid[n] = (p0[n] + p1[n] + p2[n]) / 3.0f;
+    }
+
+    struct Cluster
+    {
+        uint32_t firstTriangle;
+        uint32_t triangleCount;
+        float sortKey;
+    };
+}
+
+template <typename IndexType>
+void OptimizeOverdraw(const IndexType* indexList, uint32_t indexCount, const float* positions, uint32_t positionStride,
+    IndexType* newIndexList, uint16_t lruCacheSize, float threshold)
+{
+    const uint32_t kMinClusterSize = 8;
+
+    uint32_t triangleCount = indexCount / 3;
+    if (triangleCount == 0)
+    {
+        memcpy(newIndexList, indexList, sizeof(IndexType) * indexCount);
+        return;
+    }
+
+    LRUCache cache(lruCacheSize);
+
+    // Hard boundaries are triangles whose vertices all miss the cache.  Drawing starts over there anyway, so
+    // moving what follows elsewhere costs nothing.
+    std::vector<uint32_t> hardBoundaries;
+    std::vector<uint8_t> triangleMisses(triangleCount);
+    for (uint32_t t = 0; t < triangleCount; t++)
+    {
+        triangleMisses[t] = (uint8_t)AccessTriangle(cache, indexList + t * 3);
+        if (triangleMisses[t] == 3)
+            hardBoundaries.push_back(t);
+    }
+    hardBoundaries.push_back(triangleCount);
+
+    // Soft boundaries split the hard clusters further wherever the ACMR from the start of the current cluster
+    // is within the threshold of the ACMR of the whole hard cluster
+    std::vector<Cluster> clusters;
+    for (size_t h = 0; h + 1 < hardBoundaries.size(); h++)
+    {
+        uint32_t start = hardBoundaries[h];
+        uint32_t end = hardBoundaries[h + 1];
+
+        uint32_t hardMisses = 0;
+        for (uint32_t t = start; t < end; t++)
+            hardMisses += triangleMisses[t];
+        float missLimit = threshold * (float)hardMisses / (float)(end - start);
+
+        cache.Clear();
+        uint32_t clusterStart = start;
+        uint32_t clusterMisses = 0;
+        for (uint32_t t = start; t < end; t++)
+        {
+            clusterMisses += AccessTriangle(cache, indexList + t * 3);
+
+            uint32_t clusterSize = t + 1 - clusterStart;
+            if (t + 1 == end || (clusterSize >= kMinClusterSize && (float)clusterMisses <= missLimit * clusterSize))
+            {
+                Cluster cluster = { clusterStart, clusterSize, 0.0f };
+                clusters.push_back(cluster);
+
+                clusterStart = t + 1;
+                clusterMisses = 0;
+                cache.Clear();
+            }
+        }
+    }
+
+    // Area weighted centroid of the mesh
+    float meshCentroid[3] = { 0.0f, 0.0f, 0.0f };
+    float meshArea = 0.0f;
+    for (uint32_t t = 0; t < triangleCount; t++)
+    {
+        float normal[3], centroid[3];
+        GetTriangleNormalAndCentroid(positions, positionStride, indexList + t * 3, normal, centroid);
+
+        float area = sqrtf(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+        for (int n = 0; n < 3; n++)
+            meshCentroid[n] += centroid[n] * area;
+        meshArea += area;
+    }
+    if (meshArea > 0.0f)
+    {
+        for (int n = 0; n < 3; n++)
+            meshCentroid[n] /= meshArea;
+    }
+
+    // Clusters that face away from the centroid are likely to occlude the rest of the mesh from most
+    // directions, so they are drawn first
+    for (Cluster& cluster : clusters)
+    {
+        float clusterNormal[3] = { 0.0f, 0.0f, 0.0f };
+        float clusterCentroid[3] = { 0.0f, 0.0f, 0.0f };
+        float clusterArea = 0.0f;
+
+        for (uint32_t t = cluster.firstTriangle; t < cluster.firstTriangle + cluster.triangleCount; t++)
+        {
+            float normal[3], centroid[3];
+            GetTriangleNormalAndCentroid(positions, positionStride, indexList + t * 3, normal, centroid);
+
+            float area = sqrtf(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+            for (int n = 0; n < 3; n++)
+            {
+                clusterNormal[n] += normal[n];
+                clusterCentroid[n] += centroid[n] * area;
+            }
+            clusterArea += area;
+        }
+
+        float normalLength = sqrtf(clusterNormal[0] * clusterNormal[0] + clusterNormal[1] * clusterNormal[1] + clusterNormal[2] * clusterNormal[2]);
+        if (clusterArea > 0.0f && normalLength > 0.0f)
+        {
+            float key = 0.0f;
+            for (int n = 0; n < 3; n++)
+                key += (clusterCentroid[n] / clusterArea - meshCentroid[n]) * clusterNormal[n];
+            cluster.sortKey = key / normalLength;
+        }
+    }
+
+    std::stable_sort(clusters.begin(), clusters.end(),
+        [](const Cluster& a, const Cluster& b) { return a.sortKey > b.sortKey; });
+
+    IndexType* dst = newIndexList;
+    for (const Cluster& cluster : clusters)
+    {
+        memcpy(dst, indexList + cluster.firstTriangle * 3, sizeof(IndexType) * cluster.triangleCount * 3);
+        dst += cluster.triangleCount * 3;
+    }
+
+    // Copy any trailing indices that do not form a triangle
+    memcpy(dst, indexList + triangleCount * 3, sizeof(IndexType) * (indexCount - triangleCount * 3));
+}
+
+template <typename IndexType>
+uint32_t AnalyzeVertexCache(const IndexType* indexList, uint32_t indexCount, uint16_t lruCacheSize)
+{
+    LRUCache cache(lruCacheSize);
+
+    uint32_t transformCount = 0;
+    for (uint32_t n = 0; n < indexCount; n++)
+        transformCount += (uint32_t)cache.Access(indexList[n]);
+
+    return transformCount;
+}
+
+template <typename IndexType>
+uint32_t AnalyzeVertexFetch(const IndexType* indexList, uint32_t indexCount, uint32_t vertexStride)
+{
+    const uint32_t kCacheLineSize = 64;
+    const uint16_t kCacheLineCount = 64;
+
+    LRUCache cache(kCacheLineCount);
+
+    uint32_t bytesFetched = 0;
+    for (uint32_t n = 0; n < indexCount; n++)
+    {
+        uint32_t firstLine = indexList[n] * vertexStride / kCacheLineSize;
+        uint32_t lastLine = (indexList[n] * vertexStride + vertexStride - 1) / kCacheLineSize;
+        for (uint32_t line = firstLine; line <= lastLine; line++)
+        {
+            if (cache.Access(line))
+                bytesFetched += kCacheLineSize;
+        }
+    }
+
+    return bytesFetched;
+}
+
+template void OptimizeOverdraw<uint16_t>(const uint16_t* indexList, uint32_t indexCount, const float* positions, uint32_t positionStride, uint16_t* newIndexList, uint16_t lruCacheSize, float threshold);
+template void OptimizeOverdraw<uint32_t>(const uint32_t* indexList, uint32_t indexCount, const float* positions, uint32_t positionStride, uint32_t* newIndexList, uint16_t lruCacheSize, float threshold);
+template uint32_t AnalyzeVertexCache<uint16_t>(const uint16_t* indexList, uint32_t indexCount, uint16_t lruCacheSize);
+template uint32_t AnalyzeVertexCache<uint32_t>(const uint32_t* indexList, uint32_t indexCount, uint16_t lruCacheSize);
+template uint32_t AnalyzeVertexFetch<uint16_t>(const uint16_t* indexList, uint32_t indexCount, uint32_t vertexStride);
+template uint32_t AnalyzeVertexFetch<uint32_t>(const uint32_t* indexList, uint32_t indexCount, uint32_t vertexStride);
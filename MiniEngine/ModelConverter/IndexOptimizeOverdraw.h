@@ -0,0 +1,60 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Developed by Minigraph
+//
+
+#pragma once
+
+#include <stdint.h>
+
+//-----------------------------------------------------------------------------
+//  OptimizeOverdraw
+//-----------------------------------------------------------------------------
+//  Reorders the triangles of an index list that has already been optimized
+//  for the post-transform cache, so that outward facing parts of the mesh
+//  tend to be drawn before the parts they occlude.  The list is cut into
+//  clusters wherever that costs little vertex cache efficiency, and the
+//  clusters are sorted by how far they face away from the mesh centroid.
+//
+//  Parameters:
+//      indexList
+//          input index list
+//      indexCount
+//          the number of indices in the list
+//      positions
+//          the first vertex position (three floats)
+//      positionStride
+//          the byte stride between vertex positions
+//      newIndexList
+//          a pointer to a preallocated buffer the same size as indexList to
+//          hold the reordered index list
+//      lruCacheSize
+//          the size of the simulated post-transform cache (max:64)
+//      threshold
+//          how much worse than the input the ACMR of a cluster may become,
+//          e.g. 1.05 allows a 5% increase in vertex transforms
+//-----------------------------------------------------------------------------
+template <typename IndexType>
+void OptimizeOverdraw(const IndexType* indexList, uint32_t indexCount, const float* positions, uint32_t positionStride,
+    IndexType* newIndexList, uint16_t lruCacheSize, float threshold);
+
+//-----------------------------------------------------------------------------
+//  AnalyzeVertexCache / AnalyzeVertexFetch
+//-----------------------------------------------------------------------------
+//  Simulate an LRU post-transform cache of lruCacheSize entries and return
+//  the number of vertices transformed, and simulate a cache of 64 byte lines
+//  in front of the vertex buffer and return the number of bytes fetched.
+//  ACMR is transforms per triangle, ATVR is transforms per unique vertex, and
+//  overfetch is bytes fetched per byte of vertex data.
+//-----------------------------------------------------------------------------
+template <typename IndexType>
+uint32_t AnalyzeVertexCache(const IndexType* indexList, uint32_t indexCount, uint16_t lruCacheSize);
+
+template <typename IndexType>
+uint32_t AnalyzeVertexFetch(const IndexType* indexList, uint32_t indexCount, uint32_t vertexStride);
@@ -16,6 +16,9 @@
 //-----------------------------------------------------------------------------
 //  OptimizeFaces
 //-----------------------------------------------------------------------------
+//  Reorders triangles for the post-transform cache in time linear in the
+//  number of indices (Tipsify)
+//
 //  Parameters:
 //      indexList
 //          input index list
@@ -25,10 +28,26 @@
 //          a pointer to a preallocated buffer the same size as indexList to
 //          hold the optimized index list
 //      lruCacheSize
-//          the size of the simulated post-transform cache (max:64)
+//          the size of the simulated post-transform cache
 //-----------------------------------------------------------------------------
 template <typename IndexType>
 void OptimizeFaces(const IndexType* indexList, uint32_t indexCount, IndexType* newIndexList, uint16_t lruCacheSize);
 
 template void OptimizeFaces<uint16_t>(const uint16_t* indexList, uint32_t indexCount, uint16_t* newIndexList, uint16_t lruCacheSize);
 template void OptimizeFaces<uint32_t>(const uint32_t* indexList, uint32_t indexCount, uint32_t* newIndexList, uint16_t lruCacheSize);
+
+//-----------------------------------------------------------------------------
+//  OptimizeFacesForsyth
+//-----------------------------------------------------------------------------
+//  Tom Forsyth's "Linear-Speed Vertex Cache Optimization", which scores
+//  vertices against a simulated LRU cache.  Its cost grows superlinearly
+//  with mesh size, and it is kept for comparison (see
+//  AssimpModel::SetBenchmarkPostTransform).
+//
+//  Parameters are those of OptimizeFaces, but lruCacheSize is at most 64.
+//-----------------------------------------------------------------------------
+template <typename IndexType>
+void OptimizeFacesForsyth(const IndexType* indexList, uint32_t indexCount, IndexType* newIndexList, uint16_t lruCacheSize);
+
+template void OptimizeFacesForsyth<uint16_t>(const uint16_t* indexList, uint32_t indexCount, uint16_t* newIndexList, uint16_t lruCacheSize);
+template void OptimizeFacesForsyth<uint32_t>(const uint32_t* indexList, uint32_t indexCount, uint32_t* newIndexList, uint16_t lruCacheSize);
@@ -0,0 +1,275 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Developed by Minigraph
+//
+
+#include <stdint.h>
+#include <math.h>
+#include <algorithm>
+#include <queue>
+#include <unordered_map>
+#include <vector>
+
+#include "MeshSimplify.h"
+
+namespace
+{
+    struct Vec3
+    {
+        double x, y, z;
+    };
+
+    Vec3 Sub(const Vec3& a, const Vec3& b) { Vec3 r = { a.x - b.x, a.y - b.y, a.z - b.z }; return r; }
+    Vec3 Cross(const Vec3& a, const Vec3& b) { Vec3 r = { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x }; return r; }
+    double Dot(const Vec3& a, const Vec3& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+
+    // The symmetric 4x4 matrix that sums the squared distances to a set of planes
+    struct Quadric
+    {
+        double a00, a01, a02, a03, a11, a12, a13, a22, a23, a33;
+
+        void AddPlane(const Vec3& n, double d)
+        {
+            a00 += n.x * n.x; a01 += n.x * n.y; a02 += n.x * n.z; a03 += n.x * d;
+            a11 += n.y * n.y; a12 += n.y * n.z; a13 += n.y * d;
+            a22 += n.z * n.z; a23 += n.z * d;
+            a33 += d * d;
+        }
+
+        void Add(const Quadric& q)
+        {
+            a00 += q.a00; a01 += q.a01; a02 += q.a02; a03 += q.a03;
+            a11 += q.a11; a12 += q.a12; a13 += q.a13;
+            a22 += q.a22; a23 += q.a23;
+            a33 += q.a33;
+        }
+
+        double Evaluate(const Vec3& v) const
+        {
+            double result =
+                v.x * (a00 * v.x + 2.0 * (a01 * v.y + a02 * v.z + a03)) +
+                v.y * (a11 * v.y + 2.0 * (a12 * v.z + a13)) +
+                v.z * (a22 * v.z + 2.0 * a23) +
+                a33;
+            return std::max(result, 0.0);
+        }
+    };
+
+    struct Collapse
+    {
+        double cost;
+        uint32_t from;
+        uint32_t to;
+
+        bool operator>(const Collapse& rhs) const { return cost > rhs.cost; }
+    };
+}
+
+template <typename IndexType>
+uint32_t SimplifyMesh(const IndexType* indexList, uint32_t indexCount, const float* positions, uint32_t positionStride,
+    uint32_t vertexCount, uint32_t targetIndexCount, IndexType* newIndexList, float& error)
+{
+    const uint32_t triangleCount = indexCount / 3;
+    error = 0.0f;
+
+    std::vector<Vec3> vertexPositions(vertexCount);
+    for (uint32_t v = 0; v < vertexCount; v++)
+    {
+        const float* p = (const float*)((const uint8_t*)positions + v * positionStride);
+        vertexPositions[v].x = p[0];
+        vertexPositions[v].y = p[1];
+        vertexPositions[v].z = p[2];
+    }
+
+    std::vector<uint32_t> triangles(indexList, indexList + triangleCount * 3);
+    std::vector<bool> triangleAlive(triangleCount, true);
+    std::vector<std::vector<uint32_t>> vertexTriangles(vertexCount);
+    std::vector<Quadric> quadrics(vertexCount, Quadric());
+    std::vector<bool> vertexAlive(vertexCount, true);
+    std::vector<bool> vertexLocked(vertexCount, false);
+
+    // Every vertex starts with the planes of its triangles
+    for (uint32_t t = 0; t < triangleCount; t++)
+    {
+        const uint32_t* tri = &triangles[t * 3];
+        Vec3 normal = Cross(Sub(vertexPositions[tri[1]], vertexPositions[tri[0]]), Sub(vertexPositions[tri[2]], vertexPositions[tri[0]]));
+        double length = sqrt(Dot(normal, normal));
+        if (length > 0.0)
+        {
+            normal.x /= length; normal.y /= length; normal.z /= length;
+        }
+        double d = -Dot(normal, vertexPositions[tri[0]]);
+
+        for (int n = 0; n < 3; n++)
+        {
+            quadrics[tri[n]].AddPlane(normal, d);
+            vertexTriangles[tri[n]].push_back(t);
+        }
+    }
+
+    // Lock the ends of edges that are not shared by exactly two triangles
+    std::unordered_map<uint64_t, uint32_t> edgeUses(triangleCount * 3);
+    for (uint32_t t = 0; t < triangleCount; t++)
+    {
+        for (int n = 0; n < 3; n++)
+        {
+            uint32_t a = triangles[t * 3 + n];
+            uint32_t b = triangles[t * 3 + (n + 1) % 3];
+            edgeUses[(uint64_t)std::min(a, b) << 32 | std::max(a, b)]++;
+        }
+    }
+    for (const auto& edge : edgeUses)
+    {
+        if (edge.second != 2)
+        {
+            vertexLocked[(uint32_t)(edge.first >> 32)] = true;
+            vertexLocked[(uint32_t)edge.first] = true;
+        }
+    }
+
+    std::priority_queue<Collapse, std::vector<Collapse>, std::greater<Collapse>> queue;
+    auto pushCollapse = [&](uint32_t from, uint32_t to)
+    {
+        if (vertexLocked[from])
+            return;
+        Quadric q = quadrics[from];
+        q.Add(quadrics[to]);
+        Collapse collapse = { q.Evaluate(vertexPositions[to]), from, to };
+        queue.push(collapse);
+    };
+
+    for (uint32_t t = 0; t < triangleCount; t++)
+    {
+        for (int n = 0; n < 3; n++)
+        {
+            uint32_t a = triangles[t * 3 + n];
+            uint32_t b = triangles[t * 3 + (n + 1) % 3];
+            pushCollapse(a, b);
+            pushCollapse(b, a);
+        }
+    }
+
+    uint32_t liveIndexCount = triangleCount * 3;
+    double maxCost = 0.0;
+
+    while (liveIndexCount > targetIndexCount && !queue.empty())
+    {
+        Collapse collapse = queue.top();
+        queue.pop();
+
+        const uint32_t from = collapse.from;
+        const uint32_t to = collapse.to;
+        if (!vertexAlive[from] || !vertexAlive[to])
+            continue;
+
+        // Quadrics only grow, so a stale entry is too cheap.  Requeue it at its current cost.
+        Quadric q = quadrics[from];
+        q.Add(quadrics[to]);
+        double cost = q.Evaluate(vertexPositions[to]);
+        if (cost > collapse.cost * (1.0 + 1e-6) + 1e-12)
+        {
+            collapse.cost = cost;
+            queue.push(collapse);
+            continue;
+        }
+
+        // The edge must still exist, and no remaining triangle may flip over
+        bool connected = false;
+        bool flips = false;
+        for (uint32_t t : vertexTriangles[from])
+        {
+            if (!triangleAlive[t])
+                continue;
+
+            const uint32_t* tri = &triangles[t * 3];
+            if (tri[0] == to || tri[1] == to || tri[2] == to)
+            {
+                connected = true;
+                continue;
+            }
+
+            Vec3 corners[3];
+            for (int n = 0; n < 3; n++)
+                corners[n] = vertexPositions[tri[n]];
+            Vec3 before = Cross(Sub(corners[1], corners[0]), Sub(corners[2], corners[0]));
+            for (int n = 0; n < 3; n++)
+            {
+                if (tri[n] == from)
+                    corners[n] = vertexPositions[to];
+            }
+            Vec3 after = Cross(Sub(corners[1], corners[0]), Sub(corners[2], corners[0]));
+            if (Dot(before, after) <= 0.0)
+            {
+                flips = true;
+                break;
+            }
+        }
+        if (!connected || flips)
+            continue;
+
+        for (uint32_t t : vertexTriangles[from])
+        {
+            if (!triangleAlive[t])
+                continue;
+
+            uint32_t* tri = &triangles[t * 3];
+            if (tri[0] == to || tri[1] == to || tri[2] == to)
+            {
+                triangleAlive[t] = false;
+                liveIndexCount -= 3;
+            }
+            else
+            {
+                for (int n = 0; n < 3; n++)
+                {
+                    if (tri[n] == from)
+                        tri[n] = to;
+                }
+                vertexTriangles[to].push_back(t);
+            }
+        }
+
+        quadrics[to] = q;
+        vertexAlive[from] = false;
+        vertexTriangles[from].clear();
+        maxCost = std::max(maxCost, cost);
+
+        // Drop the collapsed triangles and queue the collapses around the merged vertex
+        std::vector<uint32_t>& adjacent = vertexTriangles[to];
+        adjacent.erase(std::remove_if(adjacent.begin(), adjacent.end(), [&](uint32_t t) { return !triangleAlive[t]; }), adjacent.end());
+        for (uint32_t t : adjacent)
+        {
+            for (int n = 0; n < 3; n++)
+            {
+                uint32_t other = triangles[t * 3 + n];
+                if (other != to)
+                {
+                    pushCollapse(other, to);
+                    pushCollapse(to, other);
+                }
+            }
+        }
+    }
+
+    uint32_t newIndexCount = 0;
+    for (uint32_t t = 0; t < triangleCount; t++)
+    {
+        if (!triangleAlive[t])
+            continue;
+        for (int n = 0; n < 3; n++)
+            newIndexList[newIndexCount++] = (IndexType)triangles[t * 3 + n];
+    }
+
+    // The quadric sums squared distances to many planes, so its root bounds the distance to any one of them
+    error = (float)sqrt(maxCost);
+    return newIndexCount;
+}
+
+template uint32_t SimplifyMesh<uint16_t>(const uint16_t* indexList, uint32_t indexCount, const float* positions, uint32_t positionStride, uint32_t vertexCount, uint32_t targetIndexCount, uint16_t* newIndexList, float& error);
+template uint32_t SimplifyMesh<uint32_t>(const uint32_t* indexList, uint32_t indexCount, const float* positions, uint32_t positionStride, uint32_t vertexCount, uint32_t targetIndexCount, uint32_t* newIndexList, float& error);
@@ -0,0 +1,49 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Developed by Minigraph
+//
+
+#pragma once
+
+#include <stdint.h>
+
+//-----------------------------------------------------------------------------
+//  SimplifyMesh
+//-----------------------------------------------------------------------------
+//  Reduces a triangle list by collapsing edges in order of quadric error
+//  (Garland and Heckbert, "Surface Simplification Using Quadric Error
+//  Metrics", SIGGRAPH 1997).  Every collapse moves a vertex onto one of its
+//  neighbors, so the result indexes the original vertices and shares their
+//  buffer.  Vertices on open or non-manifold edges never move, which keeps
+//  mesh borders and the UV and normal seams where vertices are split.
+//
+//  Parameters:
+//      indexList
+//          input index list
+//      indexCount
+//          the number of indices in the list
+//      positions
+//          the first vertex position (three floats)
+//      positionStride
+//          the byte stride between vertex positions
+//      vertexCount
+//          the number of vertices the list references
+//      targetIndexCount
+//          stop once the list is this short
+//      newIndexList
+//          the simplified list, with room for indexCount indices
+//      error
+//          receives an upper bound of the distance between the two surfaces,
+//          in position units
+//
+//  Returns the number of indices written to newIndexList.
+//-----------------------------------------------------------------------------
+template <typename IndexType>
+uint32_t SimplifyMesh(const IndexType* indexList, uint32_t indexCount, const float* positions, uint32_t positionStride,
+    uint32_t vertexCount, uint32_t targetIndexCount, IndexType* newIndexList, float& error);
@@ -0,0 +1,179 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Developed by Minigraph
+//
+
+#include "MeshletBuilder.h"
+
+#include <assert.h>
+#include <math.h>
+#include <float.h>
+#include <algorithm>
+
+namespace
+{
+    const uint8_t kUnassigned = 0xFF;
+
+    const float* GetPosition(const float* positions, uint32_t positionStride, uint32_t index)
+    {
+        return (const float*)((const uint8_t*)positions + index * positionStride);
+    }
+
+    // Fills in the bounding sphere and normal cone of a meshlet from its vertices and triangles
+    void ComputeMeshletBounds(Model::Meshlet& meshlet, const float* positions, uint32_t positionStride,
+        const uint32_t* vertices, const uint32_t* triangles)
+    {
+        // The sphere is centered on the bounding box, which is not minimal but is close for compact clusters
+        float boxMin[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+        float boxMax[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+        for (uint32_t v = 0; v < meshlet.vertexCount; v++)
+        {
+            const float* p = GetPosition(positions, positionStride, vertices[v]);
+            for (int n = 0; n < 3; n++)
+            {
+                boxMin[n] = std::min(boxMin[n], p[n]);
+                boxMax[n] = std::max(boxMax[n], p[n]);
+            }
+        }
+
+        float center[3];
+        for (int n = 0; n < 3; n++)
+            center[n] = 0.5f * (boxMin[n] + boxMax[n]);
+
+        float radiusSq = 0.0f;
+        for (uint32_t v = 0; v < meshlet.vertexCount; v++)
+        {
+            const float* p = GetPosition(positions, positionStride, vertices[v]);
+            float d[3] = { p[0] - center[0], p[1] - center[1], p[2] - center[2] };
+            radiusSq = std::max(radiusSq, d[0] * d[0] + d[1] * d[1] + d[2] * d[2]);
+        }
+
+        for (int n = 0; n < 3; n++)
+            meshlet.boundingSphere[n] = center[n];
+        meshlet.boundingSphere[3] = sqrtf(radiusSq);
+
+        // The cone axis is the average of the triangle normals, and the cone is as wide as the normal farthest
+        // from it
+        std::vector<float> normals;
+        normals.reserve(meshlet.triangleCount * 3);
+        float axis[3] = { 0.0f, 0.0f, 0.0f };
+        for (uint32_t t = 0; t < meshlet.triangleCount; t++)
+        {
+            uint32_t packed = triangles[t];
+            const float* p0 = GetPosition(positions, positionStride, vertices[packed & 0xFF]);
+            const float* p1 = GetPosition(positions, positionStride, vertices[(packed >> 8) & 0xFF]);
+            const float* p2 = GetPosition(positions, positionStride, vertices[(packed >> 16) & 0xFF]);
+
+            float e1[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+            float e2[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+            float normal[3] =
+            {
+                e1[1] * e2[2] - e1[2] * e2[1],
+                e1[2] * e2[0] - e1[0] * e2[2],
+                e1[0] * e2[1] - e1[1] * e2[0]
+            };
+
+            float length = sqrtf(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+            if (length == 0.0f)
+                continue;
+
+            for (int n = 0; n < 3; n++)
+            {
+                normals.push_back(normal[n] / length);
+                axis[n] += normal[n] / length;
+            }
+        }
+
+        float axisLength = sqrtf(axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2]);
+        float minDot = 1.0f;
+        if (axisLength > 0.0f)
+        {
+            for (int n = 0; n < 3; n++)
+                axis[n] /= axisLength;
+            for (size_t t = 0; t < normals.size(); t += 3)
+                minDot = std::min(minDot, normals[t] * axis[0] + normals[t + 1] * axis[1] + normals[t + 2] * axis[2]);
+        }
+        else
+        {
+            minDot = -1.0f;
+        }
+
+        for (int n = 0; n < 3; n++)
+            meshlet.coneAxis[n] = axis[n];
+
+        // A cutoff of one is never passed, so cones that are nearly a hemisphere or wider are never culled
+        meshlet.coneCutoff = minDot <= 0.1f ? 1.0f : sqrtf(1.0f - minDot * minDot);
+    }
+}
+
+void BuildMeshlets(const uint16_t* indexList, uint32_t indexCount, const float* positions, uint32_t positionStride,
+    uint32_t maxVertices, uint32_t maxTriangles, std::vector<Model::Meshlet>& meshlets,
+    std::vector<uint32_t>& meshletVertices, std::vector<uint32_t>& meshletTriangles)
+{
+    assert(maxVertices >= 3 && maxVertices < 256 && maxTriangles > 0);
+
+    uint32_t vertexCount = 0;
+    for (uint32_t n = 0; n < indexCount; n++)
+        vertexCount = std::max(vertexCount, (uint32_t)indexList[n] + 1);
+
+    // Position of each vertex in the current meshlet's vertex list
+    std::vector<uint8_t> localIndex(vertexCount, kUnassigned);
+
+    Model::Meshlet meshlet = {};
+    meshlet.vertexOffset = (uint32_t)meshletVertices.size();
+    meshlet.triangleOffset = (uint32_t)meshletTriangles.size();
+
+    auto finishMeshlet = [&]()
+    {
+        if (meshlet.triangleCount == 0)
+            return;
+
+        ComputeMeshletBounds(meshlet, positions, positionStride,
+            meshletVertices.data() + meshlet.vertexOffset, meshletTriangles.data() + meshlet.triangleOffset);
+        meshlets.push_back(meshlet);
+
+        for (uint32_t v = 0; v < meshlet.vertexCount; v++)
+            localIndex[meshletVertices[meshlet.vertexOffset + v]] = kUnassigned;
+
+        meshlet = Model::Meshlet();
+        meshlet.vertexOffset = (uint32_t)meshletVertices.size();
+        meshlet.triangleOffset = (uint32_t)meshletTriangles.size();
+    };
+
+    for (uint32_t n = 0; n + 2 < indexCount; n += 3)
+    {
+        uint32_t a = indexList[n];
+        uint32_t b = indexList[n + 1];
+        uint32_t c = indexList[n + 2];
+
+        uint32_t newVertices = (localIndex[a] == kUnassigned) +
+            (localIndex[b] == kUnassigned && b != a) +
+            (localIndex[c] == kUnassigned && c != a && c != b);
+
+        if (meshlet.vertexCount + newVertices > maxVertices || meshlet.triangleCount == maxTriangles)
+            finishMeshlet();
+
+        uint32_t triangle[3] = { a, b, c };
+        uint32_t packed = 0;
+        for (int v = 0; v < 3; v++)
+        {
+            if (localIndex[triangle[v]] == kUnassigned)
+            {
+                localIndex[triangle[v]] = (uint8_t)meshlet.vertexCount++;
+                meshletVertices.push_back(triangle[v]);
+            }
+            packed |= (uint32_t)localIndex[triangle[v]] << (v * 8);
+        }
+
+        meshletTriangles.push_back(packed);
+        meshlet.triangleCount++;
+    }
+
+    finishMeshlet();
+}
@@ -0,0 +1,41 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Developed by Minigraph
+//
+
+#pragma once
+
+#include "Model.h"
+
+#include <vector>
+
+//-----------------------------------------------------------------------------
+//  BuildMeshlets
+//-----------------------------------------------------------------------------
+//  Splits an index list into meshlets (see Model::Meshlet) by adding
+//  triangles in order until the next one would exceed either limit, so the
+//  list should already be optimized for vertex locality.  Meshlets, their
+//  vertices and their triangles are appended to the output arrays, and the
+//  offsets in each meshlet are relative to the arrays' previous sizes.
+//
+//  Parameters:
+//      indexList
+//          input index list
+//      indexCount
+//          the number of indices in the list
+//      positions
+//          the first vertex position (three floats)
+//      positionStride
+//          the byte stride between vertex positions
+//      maxVertices, maxTriangles
+//          meshlet limits (max: 255 vertices)
+//-----------------------------------------------------------------------------
+void BuildMeshlets(const uint16_t* indexList, uint32_t indexCount, const float* positions, uint32_t positionStride,
+    uint32_t maxVertices, uint32_t maxTriangles, std::vector<Model::Meshlet>& meshlets,
+    std::vector<uint32_t>& meshletVertices, std::vector<uint32_t>& meshletTriangles);
@@ -16,6 +16,13 @@
 #include <assimp/Importer.hpp>
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
+#include <algorithm>
+#include <set>
+#include <stdio.h>
+#include <math.h>
+
+// Imported clips are resampled at this rate, in samples per second
+static const float kAnimationSampleRate = 30.0f;
 
 const char* AssimpModel::s_FormatString[] =
 {
@@ -79,7 +86,7 @@ bool AssimpModel::Save(const char *filename) const
         break;
 
     case format_h3d:
-        rval = SaveH3D(filename);
+        rval = SaveH3D(filename, m_CompressStreams);
         break;
     }
 
@@ -109,6 +116,7 @@ bool AssimpModel::LoadAssimp(const char *filename)
         aiProcess_RemoveComponent |
         aiProcess_GenSmoothNormals |
         aiProcess_SplitLargeMeshes |
+        aiProcess_LimitBoneWeights |
         aiProcess_ValidateDataStructure |
         //aiProcess_ImproveCacheLocality | // handled by optimizePostTransform()
         aiProcess_RemoveRedundantMaterials |
@@ -127,10 +135,9 @@ bool AssimpModel::LoadAssimp(const char *filename)
         // embedded textures...
     }
 
-    if (scene->HasAnimations())
-    {
-        // todo
-    }
+    // The skeleton decides whether the vertices carry bone influences
+    std::map<std::string, uint32_t> boneIndices;
+    LoadSkeleton(scene, boneIndices);
 
     m_Header.materialCount = scene->mNumMaterials;
     m_pMaterial = new Material [m_Header.materialCount];
@@ -264,6 +271,24 @@ bool AssimpModel::LoadAssimp(const char *filename)
         dstMesh->attrib[attrib_bitangent].format = attrib_format_float;
         dstMesh->vertexStride += sizeof(float) * 3;
 
+        // every mesh of a skinned model carries them, so that all vertices have the same format
+        if (IsSkinned())
+        {
+            dstMesh->attribsEnabled |= attrib_mask_blendindices;
+            dstMesh->attrib[attrib_blendindices].offset = dstMesh->vertexStride;
+            dstMesh->attrib[attrib_blendindices].normalized = 0;
+            dstMesh->attrib[attrib_blendindices].components = 4;
+            dstMesh->attrib[attrib_blendindices].format = attrib_format_ubyte;
+            dstMesh->vertexStride += sizeof(uint8_t) * 4;
+
+            dstMesh->attribsEnabled |= attrib_mask_blendweights;
+            dstMesh->attrib[attrib_blendweights].offset = dstMesh->vertexStride;
+            dstMesh->attrib[attrib_blendweights].normalized = 1;
+            dstMesh->attrib[attrib_blendweights].components = 4;
+            dstMesh->attrib[attrib_blendweights].format = attrib_format_ubyte;
+            dstMesh->vertexStride += sizeof(uint8_t) * 4;
+        }
+
         // depth-only
         dstMesh->attribsEnabledDepth |= attrib_mask_position;
         dstMesh->attribDepth[attrib_position].offset = dstMesh->vertexStrideDepth;
@@ -384,6 +409,71 @@ bool AssimpModel::LoadAssimp(const char *filename)
             dstBitangent = (float*)((unsigned char*)dstBitangent + dstMesh->vertexStride);
         }
 
+        if (IsSkinned())
+        {
+            // Keep the four largest weights of each vertex, largest first.  Vertices that no bone of the
+            // skeleton moves keep zero weights.
+            std::vector<float> weights(dstMesh->vertexCount * 4, 0.0f);
+            std::vector<uint8_t> indices(dstMesh->vertexCount * 4, 0);
+            for (unsigned int b = 0; b < srcMesh->mNumBones; b++)
+            {
+                const aiBone *srcBone = srcMesh->mBones[b];
+                auto boneIndex = boneIndices.find(srcBone->mName.C_Str());
+                if (boneIndex == boneIndices.end())
+                    continue;
+
+                for (unsigned int w = 0; w < srcBone->mNumWeights; w++)
+                {
+                    const aiVertexWeight &weight = srcBone->mWeights[w];
+                    float *vertexWeights = &weights[weight.mVertexId * 4];
+                    uint8_t *vertexIndices = &indices[weight.mVertexId * 4];
+                    for (int slot = 0; slot < 4; slot++)
+                    {
+                        if (weight.mWeight > vertexWeights[slot])
+                        {
+                            for (int k = 3; k > slot; k--)
+                            {
+                                vertexWeights[k] = vertexWeights[k - 1];
+                                vertexIndices[k] = vertexIndices[k - 1];
+                            }
+                            vertexWeights[slot] = weight.mWeight;
+                            vertexIndices[slot] = (uint8_t)boneIndex->second;
+                            break;
+                        }
+                    }
+                }
+            }
+
+            // Quantize the weights so that they sum to exactly 255.  The largest one absorbs the rounding.
+            unsigned char *dstIndices = m_pVertexData + dstMesh->vertexDataByteOffset + dstMesh->attrib[attrib_blendindices].offset;
+            unsigned char *dstWeights = m_pVertexData + dstMesh->vertexDataByteOffset + dstMesh->attrib[attrib_blendweights].offset;
+            for (unsigned int v = 0; v < dstMesh->vertexCount; v++)
+            {
+                const float *vertexWeights = &weights[v * 4];
+                float sum = vertexWeights[0] + vertexWeights[1] + vertexWeights[2] + vertexWeights[3];
+
+                int quantized[4] = {};
+                if (sum > 0.0f)
+                {
+                    int total = 0;
+                    for (int k = 0; k < 4; k++)
+                    {
+                        quantized[k] = (int)(vertexWeights[k] / sum * 255.0f + 0.5f);
+                        total += quantized[k];
+                    }
+                    quantized[0] += 255 - total;
+                }
+
+                for (int k = 0; k < 4; k++)
+                {
+                    dstIndices[k] = indices[v * 4 + k];
+                    dstWeights[k] = (unsigned char)quantized[k];
+                }
+                dstIndices += dstMesh->vertexStride;
+                dstWeights += dstMesh->vertexStride;
+            }
+        }
+
         uint16_t *dstIndex = (uint16_t*)(m_pIndexData + dstMesh->indexDataByteOffset);
         uint16_t *dstIndexDepth = (uint16_t*)(m_pIndexDataDepth + dstMesh->indexDataByteOffset);
         for (unsigned int f = 0; f < srcMesh->mNumFaces; f++)
@@ -404,3 +494,218 @@ bool AssimpModel::LoadAssimp(const char *filename)
 
     return true;
 }
+
+// Find the nodes that move vertices and their ancestors, which move them too.  Returns whether node is one.
+static bool FindSkeletonNodes(const aiNode *node, const std::map<std::string, const aiMatrix4x4*> &inverseBinds,
+    std::set<const aiNode*> &skeleton)
+{
+    bool inSkeleton = inverseBinds.count(node->mName.C_Str()) > 0;
+    for (unsigned int n = 0; n < node->mNumChildren; n++)
+        inSkeleton |= FindSkeletonNodes(node->mChildren[n], inverseBinds, skeleton);
+
+    if (inSkeleton)
+        skeleton.insert(node);
+    return inSkeleton;
+}
+
+// List the skeleton nodes from node down in preorder, which puts parents ahead of their children
+static void ListSkeletonNodes(const aiNode *node, int32_t parent, const std::set<const aiNode*> &skeleton,
+    std::vector<const aiNode*> &nodes, std::vector<int32_t> &parents)
+{
+    if (skeleton.count(node) == 0)
+        return;
+
+    int32_t index = (int32_t)nodes.size();
+    nodes.push_back(node);
+    parents.push_back(parent);
+    for (unsigned int n = 0; n < node->mNumChildren; n++)
+        ListSkeletonNodes(node->mChildren[n], index, skeleton, nodes, parents);
+}
+
+void AssimpModel::LoadSkeleton(const aiScene *scene, std::map<std::string, uint32_t> &boneIndices)
+{
+    // The inverse bind matrix of each bone that moves vertices, by node name
+    std::map<std::string, const aiMatrix4x4*> inverseBinds;
+    for (unsigned int meshIndex = 0; meshIndex < scene->mNumMeshes; meshIndex++)
+    {
+        const aiMesh *srcMesh = scene->mMeshes[meshIndex];
+        for (unsigned int b = 0; b < srcMesh->mNumBones; b++)
+            inverseBinds.emplace(srcMesh->mBones[b]->mName.C_Str(), &srcMesh->mBones[b]->mOffsetMatrix);
+    }
+    if (inverseBinds.empty())
+        return;
+
+    std::set<const aiNode*> skeleton;
+    std::vector<const aiNode*> nodes;
+    std::vector<int32_t> parents;
+    FindSkeletonNodes(scene->mRootNode, inverseBinds, skeleton);
+    ListSkeletonNodes(scene->mRootNode, -1, skeleton, nodes, parents);
+
+    if (nodes.size() > kMaxBones)
+    {
+        printf("skipping skinning: %u bones, at most %u are supported\n", (unsigned int)nodes.size(), (unsigned int)kMaxBones);
+        return;
+    }
+
+    m_BoneCount = (uint32_t)nodes.size();
+    m_pBones = new Bone [m_BoneCount];
+    memset(m_pBones, 0, sizeof(Bone) * m_BoneCount);
+    for (uint32_t boneIndex = 0; boneIndex < m_BoneCount; boneIndex++)
+    {
+        Bone *dstBone = m_pBones + boneIndex;
+        dstBone->parent = parents[boneIndex];
+        dstBone->depth = dstBone->parent < 0 ? 0 : m_pBones[dstBone->parent].depth + 1;
+
+        // ancestors that move no vertices themselves never have their skin matrix used
+        auto inverseBind = inverseBinds.find(nodes[boneIndex]->mName.C_Str());
+        aiMatrix4x4 matrix = inverseBind != inverseBinds.end() ? *inverseBind->second : aiMatrix4x4();
+        memcpy(dstBone->inverseBind, &matrix.a1, sizeof(dstBone->inverseBind)); // rows a, b and c
+
+        boneIndices.emplace(nodes[boneIndex]->mName.C_Str(), boneIndex);
+    }
+
+    LoadAnimations(scene, nodes);
+}
+
+// The last key at or before time, and how far time is towards the next one
+template <typename Key>
+static unsigned int FindKey(const Key *keys, unsigned int keyCount, double time, float &factor)
+{
+    unsigned int k = 0;
+    while (k + 1 < keyCount && keys[k + 1].mTime <= time)
+        k++;
+
+    factor = 0.0f;
+    if (k + 1 < keyCount && keys[k + 1].mTime > keys[k].mTime)
+        factor = (float)std::max(0.0, (time - keys[k].mTime) / (keys[k + 1].mTime - keys[k].mTime));
+    return k;
+}
+
+static aiVector3D SampleKeys(const aiVectorKey *keys, unsigned int keyCount, double time)
+{
+    float factor;
+    unsigned int k = FindKey(keys, keyCount, time, factor);
+    if (factor == 0.0f)
+        return keys[k].mValue;
+    return keys[k].mValue + (keys[k + 1].mValue - keys[k].mValue) * factor;
+}
+
+static aiQuaternion SampleKeys(const aiQuatKey *keys, unsigned int keyCount, double time)
+{
+    float factor;
+    unsigned int k = FindKey(keys, keyCount, time, factor);
+    if (factor == 0.0f)
+        return keys[k].mValue;
+
+    aiQuaternion rotation;
+    aiQuaternion::Interpolate(rotation, keys[k].mValue, keys[k + 1].mValue, factor);
+    return rotation.Normalize();
+}
+
+static void SetAnimationKey(Model::AnimationKey &key, const aiVector3D &scale, const aiQuaternion &rotation, const aiVector3D &translation)
+{
+    memset(&key, 0, sizeof(key));
+    key.rotation[0] = rotation.x;
+    key.rotation[1] = rotation.y;
+    key.rotation[2] = rotation.z;
+    key.rotation[3] = rotation.w;
+    key.translation[0] = translation.x;
+    key.translation[1] = translation.y;
+    key.translation[2] = translation.z;
+    key.scale[0] = scale.x;
+    key.scale[1] = scale.y;
+    key.scale[2] = scale.z;
+}
+
+void AssimpModel::LoadAnimations(const aiScene *scene, const std::vector<const aiNode*> &boneNodes)
+{
+    // Bones that a clip does not animate keep the transforms of their nodes
+    std::vector<aiVector3D> restScales(m_BoneCount);
+    std::vector<aiQuaternion> restRotations(m_BoneCount);
+    std::vector<aiVector3D> restTranslations(m_BoneCount);
+    std::map<std::string, uint32_t> boneIndices;
+    for (uint32_t boneIndex = 0; boneIndex < m_BoneCount; boneIndex++)
+    {
+        boneNodes[boneIndex]->mTransformation.Decompose(restScales[boneIndex], restRotations[boneIndex], restTranslations[boneIndex]);
+        boneIndices.emplace(boneNodes[boneIndex]->mName.C_Str(), boneIndex);
+    }
+
+    std::vector<AnimationClip> clips;
+    std::vector<AnimationKey> keys;
+
+    for (unsigned int animIndex = 0; animIndex < scene->mNumAnimations; animIndex++)
+    {
+        const aiAnimation *srcAnim = scene->mAnimations[animIndex];
+
+        // zero ticks per second means unspecified, which Assimp's viewer plays at 25
+        double ticksPerSecond = srcAnim->mTicksPerSecond != 0.0 ? srcAnim->mTicksPerSecond : 25.0;
+        double duration = std::max(srcAnim->mDuration, 0.0) / ticksPerSecond;
+
+        AnimationClip clip = {};
+        strncpy_s(clip.name, srcAnim->mName.C_Str(), AnimationClip::maxClipName - 1);
+        clip.sampleCount = (uint32_t)ceil(duration * kAnimationSampleRate) + 1;
+        clip.sampleRate = clip.sampleCount > 1 ? (float)((clip.sampleCount - 1) / duration) : kAnimationSampleRate;
+        clip.duration = (float)duration;
+        clip.firstKey = (uint32_t)keys.size();
+
+        std::vector<const aiNodeAnim*> channels(m_BoneCount, nullptr);
+        for (unsigned int c = 0; c < srcAnim->mNumChannels; c++)
+        {
+            auto boneIndex = boneIndices.find(srcAnim->mChannels[c]->mNodeName.C_Str());
+            if (boneIndex != boneIndices.end())
+                channels[boneIndex->second] = srcAnim->mChannels[c];
+        }
+
+        for (uint32_t s = 0; s < clip.sampleCount; s++)
+        {
+            double time = std::min(s / (double)clip.sampleRate * ticksPerSecond, srcAnim->mDuration);
+            for (uint32_t boneIndex = 0; boneIndex < m_BoneCount; boneIndex++)
+            {
+                aiVector3D scale = restScales[boneIndex];
+                aiQuaternion rotation = restRotations[boneIndex];
+                aiVector3D translation = restTranslations[boneIndex];
+
+                if (const aiNodeAnim *channel = channels[boneIndex])
+                {
+                    if (channel->mNumScalingKeys > 0)
+                        scale = SampleKeys(channel->mScalingKeys, channel->mNumScalingKeys, time);
+                    if (channel->mNumRotationKeys > 0)
+                        rotation = SampleKeys(channel->mRotationKeys, channel->mNumRotationKeys, time);
+                    if (channel->mNumPositionKeys > 0)
+                        translation = SampleKeys(channel->mPositionKeys, channel->mNumPositionKeys, time);
+                }
+
+                AnimationKey key;
+                SetAnimationKey(key, scale, rotation, translation);
+                keys.push_back(key);
+            }
+        }
+
+        clips.push_back(clip);
+    }
+
+    // Without animations, the one clip is the pose the skeleton's nodes are in
+    if (clips.empty())
+    {
+        AnimationClip clip = {};
+        strncpy_s(clip.name, "bind pose", AnimationClip::maxClipName - 1);
+        clip.sampleRate = kAnimationSampleRate;
+        clip.sampleCount = 1;
+        clips.push_back(clip);
+
+        for (uint32_t boneIndex = 0; boneIndex < m_BoneCount; boneIndex++)
+        {
+            AnimationKey key;
+            SetAnimationKey(key, restScales[boneIndex], restRotations[boneIndex], restTranslations[boneIndex]);
+            keys.push_back(key);
+        }
+    }
+
+    m_AnimationClipCount = (uint32_t)clips.size();
+    m_pAnimationClips = new AnimationClip [m_AnimationClipCount];
+    memcpy(m_pAnimationClips, clips.data(), sizeof(AnimationClip) * m_AnimationClipCount);
+
+    m_AnimationKeyCount = (uint32_t)keys.size();
+    m_pAnimationKeys = new AnimationKey [m_AnimationKeyCount];
+    memcpy(m_pAnimationKeys, keys.data(), sizeof(AnimationKey) * m_AnimationKeyCount);
+}
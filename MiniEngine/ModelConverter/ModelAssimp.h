@@ -12,6 +12,12 @@
 #pragma once
 
 #include "Model.h"
+#include <map>
+#include <string>
+#include <vector>
+
+struct aiScene;
+struct aiNode;
 
 class AssimpModel : public Model
 {
@@ -27,16 +33,47 @@ public:
     static const char *s_FormatString[];
     static int FormatFromFilename(const char *filename);
 
+    AssimpModel() : m_ThreadCount(1), m_LodLevels(0), m_QuantizeVertices(false), m_CompressStreams(false), m_BenchmarkPostTransform(false) {}
+
     virtual bool Load(const char* filename) override;
     bool Save(const char* filename) const;
 
+    // the number of threads used to optimize meshes in parallel
+    void SetThreadCount(unsigned int threadCount) { m_ThreadCount = threadCount > 0 ? threadCount : 1; }
+
+    // the number of coarser levels of detail to generate per mesh (see Model::MeshLod)
+    void SetLodLevels(unsigned int levels) { m_LodLevels = levels < kMaxLods ? levels : kMaxLods - 1; }
+
+    // compress the full vertex stream when optimizing (see Model::HasQuantizedVertices)
+    void SetQuantizeVertices(bool quantize) { m_QuantizeVertices = quantize; }
+
+    // encode the vertex and index streams of saved H3D files (see Model::kSectionFlagCompressedStreams)
+    void SetCompressStreams(bool compress) { m_CompressStreams = compress; }
+
+    // time OptimizeFaces against OptimizeFacesForsyth on every mesh before optimizing (see IndexOptimizePostTransform.h)
+    void SetBenchmarkPostTransform(bool benchmark) { m_BenchmarkPostTransform = benchmark; }
+
 private:
 
     bool LoadAssimp(const char *filename);
+    void LoadSkeleton(const aiScene *scene, std::map<std::string, uint32_t> &boneIndices);
+    void LoadAnimations(const aiScene *scene, const std::vector<const aiNode*> &boneNodes);
 
     void Optimize();
     void OptimizeRemoveDuplicateVertices(bool depth);
     void OptimizePostTransform(bool depth);
+    void BenchmarkPostTransform(bool depth) const;
+    void OptimizeOverdraw(bool depth);
     void OptimizePreTransform(bool depth);
+    void PrintVertexCacheStats(const char *stage, bool depth) const;
+    void GenerateLods();
+    void GenerateMeshlets();
+    void QuantizeVertices();
+
+    unsigned int m_ThreadCount;
+    unsigned int m_LodLevels;
+    bool m_QuantizeVertices;
+    bool m_CompressStreams;
+    bool m_BenchmarkPostTransform;
 };
 
@@ -14,13 +14,23 @@
 #include "ModelAssimp.h"
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <thread>
 
 void PrintHelp()
 {
     printf("model_convert\n");
 
     printf("usage:\n");
-    printf("model_convert input_file output_file\n");
+    printf("model_convert [-j thread_count] [-lods level_count] [-quantize] [-compress] [-benchmark] input_file output_file\n");
+    printf("  -j         number of threads used to optimize meshes (default: one per hardware thread)\n");
+    printf("  -lods      number of simplified levels of detail per mesh, each with half the triangles (max: 3)\n");
+    printf("  -quantize  store 16-bit positions, half texture coordinates and octahedral normals\n");
+    printf("  -compress  encode the vertex and index streams, which are decoded when loaded\n");
+    printf("  -benchmark time the post transform optimizer against the previous one on every mesh\n");
 }
 
 void PrintModelStats(const Model *model)
@@ -65,6 +75,10 @@ void PrintModelStats(const Model *model)
             case Model::attrib_format_float:
                 printf("float");
                 break;
+
+            case Model::attrib_format_half:
+                printf("half");
+                break;
             }
         };
 
@@ -112,33 +126,88 @@ void PrintModelStats(const Model *model)
 
 int main(int argc, char **argv)
 {
-    if (argc != 3)
+    unsigned int thread_count = std::max(1u, std::thread::hardware_concurrency());
+
+    unsigned int lod_levels = 0;
+    bool quantize = false;
+    bool compress = false;
+    bool benchmark = false;
+
+    int arg = 1;
+    while (arg < argc && argv[arg][0] == '-')
+    {
+        if (arg + 1 < argc && strcmp(argv[arg], "-j") == 0)
+        {
+            thread_count = (unsigned int)atoi(argv[arg + 1]);
+            arg += 2;
+        }
+        else if (arg + 1 < argc && strcmp(argv[arg], "-lods") == 0)
+        {
+            lod_levels = (unsigned int)atoi(argv[arg + 1]);
+            arg += 2;
+        }
+        else if (strcmp(argv[arg], "-quantize") == 0)
+        {
+            quantize = true;
+            arg++;
+        }
+        else if (strcmp(argv[arg], "-compress") == 0)
+        {
+            compress = true;
+            arg++;
+        }
+        else if (strcmp(argv[arg], "-benchmark") == 0)
+        {
+            benchmark = true;
+            arg++;
+        }
+        else
+        {
+            break;
+        }
+    }
+
+    if (argc - arg != 2 || thread_count == 0)
     {
         PrintHelp();
         return -1;
     }
 
-    const char *input_file = argv[1];
-    const char *output_file = argv[2];
+    const char *input_file = argv[arg];
+    const char *output_file = argv[arg + 1];
 
     printf("input file %s\n", input_file);
     printf("output file %s\n", output_file);
 
     AssimpModel model;
+    model.SetThreadCount(thread_count);
+    model.SetLodLevels(lod_levels);
+    model.SetQuantizeVertices(quantize);
+    model.SetCompressStreams(compress);
+    model.SetBenchmarkPostTransform(benchmark);
+
+    auto elapsedMs = [](std::chrono::steady_clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    };
 
     printf("loading...\n");
+    auto start = std::chrono::steady_clock::now();
     if (!model.Load(input_file))
     {
         printf("failed to load model: %s\n", input_file);
         return -1;
     }
+    printf("%-24s %10.1f ms\n", "load", elapsedMs(start));
 
     printf("saving...\n");
+    start = std::chrono::steady_clock::now();
     if (!model.Save(output_file))
     {
         printf("failed to save model: %s\n", output_file);
         return -1;
     }
+    printf("%-24s %10.1f ms\n", "save", elapsedMs(start));
 
     printf("done\n");
 
@@ -13,53 +13,144 @@
 
 #include "ModelAssimp.h"
 #include "IndexOptimizePostTransform.h"
+#include "IndexOptimizeOverdraw.h"
+#include "MeshletBuilder.h"
+#include "MeshSimplify.h"
+#include "VertexFormats.h"
 
-#include <string.h>
+#include <DirectXPackedVector.h>
 
-void AssimpModel::OptimizeRemoveDuplicateVertices(bool depth)
+#include <string.h>
+#include <stdio.h>
+#include <math.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace
 {
-    unsigned char *deduplicatedVertexData = new unsigned char [depth ? m_Header.vertexDataByteSizeDepth : m_Header.vertexDataByteSize];
-    uint32_t deduplicatedVertexDataSize = 0;
+    // Runs func(index) for every index in [0, count) across threadCount threads, handing out indices one at a
+    // time because mesh sizes vary wildly
+    template <typename Func>
+    void ParallelFor(unsigned int count, unsigned int threadCount, const Func& func)
+    {
+        threadCount = std::max(1u, std::min(threadCount, count));
 
-    for (unsigned int meshIndex = 0; meshIndex < m_Header.meshCount; meshIndex++)
+        std::atomic<unsigned int> nextIndex(0);
+        auto worker = [&]()
+        {
+            for (unsigned int index = nextIndex++; index < count; index = nextIndex++)
+                func(index);
+        };
+
+        std::vector<std::thread> threads;
+        for (unsigned int n = 1; n < threadCount; n++)
+            threads.emplace_back(worker);
+        worker();
+
+        for (std::thread& thread : threads)
+            thread.join();
+    }
+
+    // Hashes and compares vertices by index, so the map does not need a copy of the vertex data
+    struct VertexHash
     {
-        Mesh *mesh = m_pMesh + meshIndex;
-        unsigned int vertexStride = depth ? mesh->vertexStrideDepth : mesh->vertexStride;
-        unsigned char *meshVertexData = depth ? (m_pVertexDataDepth + mesh->vertexDataByteOffsetDepth) : (m_pVertexData + mesh->vertexDataByteOffset);
+        const unsigned char *data;
+        unsigned int stride;
 
-        unsigned char *meshDeduplicatedVertexData = deduplicatedVertexData + deduplicatedVertexDataSize;
-        unsigned int deduplicatedCount = 0;
+        size_t operator()(uint32_t index) const
+        {
+            // FNV-1a
+            const unsigned char *bytes = data + index * stride;
+            uint32_t hash = 2166136261u;
+            for (unsigned int n = 0; n < stride; n++)
+                hash = (hash ^ bytes[n]) * 16777619u;
+            return hash;
+        }
+    };
 
-        unsigned int vertexCount = depth ? mesh->vertexCountDepth : mesh->vertexCount;
-        uint32_t *vertexRemap = new uint32_t [vertexCount];
-        memset(vertexRemap, (uint32_t)-1, sizeof(uint32_t) * vertexCount);
-        assert(vertexCount <= (uint32_t)-1);
+    struct VertexEqual
+    {
+        const unsigned char *data;
+        unsigned int stride;
 
-        for (unsigned int v1 = 0; v1 < vertexCount; v1++)
+        bool operator()(uint32_t a, uint32_t b) const
         {
-            if (vertexRemap[v1] != (uint32_t)-1)
-                continue; // this was already found to be a duplicate
+            return 0 == memcmp(data + a * stride, data + b * stride, stride);
+        }
+    };
 
-            const unsigned char *v1Data = meshVertexData + v1 * vertexStride;
+    uint16_t QuantizeUnorm16(float value)
+    {
+        value = std::min(std::max(value, 0.0f), 1.0f);
+        return (uint16_t)(value * 65535.0f + 0.5f);
+    }
 
-            // this is a new unique vertex
-            uint32_t remappedSlot = deduplicatedCount++;
-            vertexRemap[v1] = remappedSlot;
-            memcpy(meshDeduplicatedVertexData + remappedSlot * vertexStride, v1Data, vertexStride);
+    int16_t QuantizeSnorm16(float value)
+    {
+        value = std::min(std::max(value, -1.0f), 1.0f);
+        return (int16_t)(value * 32767.0f + (value >= 0.0f ? 0.5f : -0.5f));
+    }
 
-            // scan for duplicates
-            for (unsigned int v2 = v1 + 1; v2 < vertexCount; v2++)
+    // Projects a unit vector onto the octahedron |x| + |y| + |z| = 1 and folds the lower hemisphere over the
+    // upper one, so two components are enough.  Must match OctDecode() in VertexDecode.hlsli.
+    void OctEncode(const float *v, int16_t *result)
+    {
+        float x = 0.0f;
+        float y = 0.0f;
+        float l1 = fabsf(v[0]) + fabsf(v[1]) + fabsf(v[2]);
+        if (l1 > 0.0f)
+        {
+            x = v[0] / l1;
+            y = v[1] / l1;
+            if (v[2] < 0.0f)
             {
-                if (vertexRemap[v2] != (uint32_t)-1)
-                    continue; // this was already found to be a duplicate of another vertex
+                float foldedX = (1.0f - fabsf(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+                float foldedY = (1.0f - fabsf(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+                x = foldedX;
+                y = foldedY;
+            }
+        }
+        result[0] = QuantizeSnorm16(x);
+        result[1] = QuantizeSnorm16(y);
+    }
+}
+
+void AssimpModel::OptimizeRemoveDuplicateVertices(bool depth)
+{
+    // Each mesh is deduplicated into its own buffer in parallel, then the results are packed in mesh order
+    std::vector<std::vector<unsigned char>> deduplicatedMeshData(m_Header.meshCount);
+
+    ParallelFor(m_Header.meshCount, m_ThreadCount, [&](unsigned int meshIndex)
+    {
+        Mesh *mesh = m_pMesh + meshIndex;
+        unsigned int vertexStride = depth ? mesh->vertexStrideDepth : mesh->vertexStride;
+        unsigned char *meshVertexData = depth ? (m_pVertexDataDepth + mesh->vertexDataByteOffsetDepth) : (m_pVertexData + mesh->vertexDataByteOffset);
+        unsigned int vertexCount = depth ? mesh->vertexCountDepth : mesh->vertexCount;
 
-                const unsigned char *v2Data = meshVertexData + v2 * vertexStride;
+        std::vector<unsigned char>& meshDeduplicatedVertexData = deduplicatedMeshData[meshIndex];
+        meshDeduplicatedVertexData.reserve(vertexCount * vertexStride);
 
-                if (0 == memcmp(v1Data, v2Data, vertexStride))
-                {
-                    vertexRemap[v2] = remappedSlot;
-                }
+        VertexHash hash = { meshVertexData, vertexStride };
+        VertexEqual equal = { meshVertexData, vertexStride };
+        std::unordered_map<uint32_t, uint32_t, VertexHash, VertexEqual> uniqueVertices(vertexCount, hash, equal);
+
+        uint32_t *vertexRemap = new uint32_t [vertexCount];
+        for (unsigned int v = 0; v < vertexCount; v++)
+        {
+            // the first occurrence of each vertex gets the next slot
+            uint32_t remappedSlot = (uint32_t)uniqueVertices.size();
+            auto inserted = uniqueVertices.emplace(v, remappedSlot);
+            if (inserted.second)
+            {
+                const unsigned char *vData = meshVertexData + v * vertexStride;
+                meshDeduplicatedVertexData.insert(meshDeduplicatedVertexData.end(), vData, vData + vertexStride);
             }
+            vertexRemap[v] = inserted.first->second;
         }
 
         unsigned int indexCount = mesh->indexCount;
@@ -72,16 +163,27 @@ void AssimpModel::OptimizeRemoveDuplicateVertices(bool depth)
         delete [] vertexRemap;
 
         if (depth)
-        {
-            mesh->vertexCountDepth = deduplicatedCount;
+            mesh->vertexCountDepth = (uint32_t)uniqueVertices.size();
+        else
+            mesh->vertexCount = (uint32_t)uniqueVertices.size();
+    });
+
+    unsigned char *deduplicatedVertexData = new unsigned char [depth ? m_Header.vertexDataByteSizeDepth : m_Header.vertexDataByteSize];
+    uint32_t deduplicatedVertexDataSize = 0;
+
+    for (unsigned int meshIndex = 0; meshIndex < m_Header.meshCount; meshIndex++)
+    {
+        Mesh *mesh = m_pMesh + meshIndex;
+        const std::vector<unsigned char>& meshDeduplicatedVertexData = deduplicatedMeshData[meshIndex];
+
+        if (!meshDeduplicatedVertexData.empty())
+            memcpy(deduplicatedVertexData + deduplicatedVertexDataSize, meshDeduplicatedVertexData.data(), meshDeduplicatedVertexData.size());
+
+        if (depth)
             mesh->vertexDataByteOffsetDepth = deduplicatedVertexDataSize;
-        }
         else
-        {
-            mesh->vertexCount = deduplicatedCount;
             mesh->vertexDataByteOffset = deduplicatedVertexDataSize;
-        }
-        deduplicatedVertexDataSize += deduplicatedCount * vertexStride;
+        deduplicatedVertexDataSize += (uint32_t)meshDeduplicatedVertexData.size();
     }
 
     if (depth)
@@ -100,9 +202,11 @@ void AssimpModel::OptimizeRemoveDuplicateVertices(bool depth)
 
 void AssimpModel::OptimizePostTransform(bool depth)
 {
-    enum {lruCacheSize = 64};
+    // OptimizeFaces does best on caches of the size it simulates and worse on smaller ones, so target the small
+    // cache the statistics use
+    enum {lruCacheSize = 16};
 
-    for (unsigned int meshIndex = 0; meshIndex < m_Header.meshCount; meshIndex++)
+    ParallelFor(m_Header.meshCount, m_ThreadCount, [&](unsigned int meshIndex)
     {
         Mesh *mesh = m_pMesh + meshIndex;
 
@@ -113,14 +217,90 @@ void AssimpModel::OptimizePostTransform(bool depth)
         OptimizeFaces<uint16_t>(srcIndices, mesh->indexCount, dstIndices, lruCacheSize);
 
         delete [] srcIndices;
+    });
+}
+
+void AssimpModel::BenchmarkPostTransform(bool depth) const
+{
+    // The same cache sizes as OptimizePostTransform and PrintVertexCacheStats.  OptimizeFacesForsyth was
+    // tuned for a large LRU cache, which it still does better on.
+    enum {lruCacheSize = 16};
+    enum {lruCacheSizeForsyth = 64};
+
+    typedef void (*OptimizeFunc)(const uint16_t*, uint32_t, uint16_t*, uint16_t);
+    const struct
+    {
+        const char *name;
+        OptimizeFunc func;
+        uint16_t cacheSize;
+    }
+    optimizers[] =
+    {
+        { "forsyth", OptimizeFacesForsyth<uint16_t>, lruCacheSizeForsyth },
+        { "tipsify", OptimizeFaces<uint16_t>, lruCacheSize },
+    };
+
+    uint64_t triangleCount = 0;
+    for (unsigned int meshIndex = 0; meshIndex < m_Header.meshCount; meshIndex++)
+        triangleCount += m_pMesh[meshIndex].indexCount / 3;
+
+    // One thread, so the times compare the algorithms rather than the scheduling of meshes
+    for (const auto &optimizer : optimizers)
+    {
+        uint64_t transformCount = 0;
+        double elapsedMs = 0.0;
+        std::vector<uint16_t> indices;
+
+        for (unsigned int meshIndex = 0; meshIndex < m_Header.meshCount; meshIndex++)
+        {
+            const Mesh *mesh = m_pMesh + meshIndex;
+            const uint16_t *srcIndices = (const uint16_t*)((depth ? m_pIndexDataDepth : m_pIndexData) + mesh->indexDataByteOffset);
+            indices.resize(mesh->indexCount);
+
+            auto start = std::chrono::steady_clock::now();
+            optimizer.func(srcIndices, mesh->indexCount, indices.data(), optimizer.cacheSize);
+            elapsedMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+            transformCount += AnalyzeVertexCache<uint16_t>(indices.data(), mesh->indexCount, lruCacheSize);
+        }
+
+        printf("%-16s %-10s %10.1f ms, ACMR %.3f\n", optimizer.name, depth ? "depth-only" : "full", elapsedMs,
+            triangleCount == 0 ? 0.0 : (double)transformCount / triangleCount);
     }
 }
 
+void AssimpModel::OptimizeOverdraw(bool depth)
+{
+    enum {lruCacheSize = 64};
+    const float acmrThreshold = 1.05f;
+
+    ParallelFor(m_Header.meshCount, m_ThreadCount, [&](unsigned int meshIndex)
+    {
+        Mesh *mesh = m_pMesh + meshIndex;
+
+        const Attrib &position = depth ? mesh->attribDepth[attrib_position] : mesh->attrib[attrib_position];
+        if (position.format != attrib_format_float || position.components < 3)
+            return;
+
+        unsigned int vertexStride = depth ? mesh->vertexStrideDepth : mesh->vertexStride;
+        const unsigned char *meshVertexData = depth ? (m_pVertexDataDepth + mesh->vertexDataByteOffsetDepth) : (m_pVertexData + mesh->vertexDataByteOffset);
+        const float *positions = (const float*)(meshVertexData + position.offset);
+
+        uint16_t *srcIndices = new uint16_t [mesh->indexCount];
+        uint16_t *dstIndices = (uint16_t*)((depth ? m_pIndexDataDepth : m_pIndexData) + mesh->indexDataByteOffset);
+        memcpy(srcIndices, dstIndices, sizeof(uint16_t) * mesh->indexCount);
+
+        ::OptimizeOverdraw<uint16_t>(srcIndices, mesh->indexCount, positions, vertexStride, dstIndices, lruCacheSize, acmrThreshold);
+
+        delete [] srcIndices;
+    });
+}
+
 void AssimpModel::OptimizePreTransform(bool depth)
 {
     unsigned char *reorderedVertexData = new unsigned char [depth ? m_Header.vertexDataByteSizeDepth : m_Header.vertexDataByteSize];
 
-    for (unsigned int meshIndex = 0; meshIndex < m_Header.meshCount; meshIndex++)
+    ParallelFor(m_Header.meshCount, m_ThreadCount, [&](unsigned int meshIndex)
     {
         Mesh *mesh = m_pMesh + meshIndex;
         unsigned int indexCount = mesh->indexCount;
@@ -153,7 +333,7 @@ void AssimpModel::OptimizePreTransform(bool depth)
         }
 
         delete [] vertexRemap;
-    }
+    });
 
     if (depth)
     {
@@ -167,18 +347,374 @@ void AssimpModel::OptimizePreTransform(bool depth)
     }
 }
 
+void AssimpModel::GenerateLods()
+{
+    enum {lruCacheSize = 16};
+
+    const uint32_t lodCount = std::min(m_LodLevels, (unsigned int)kMaxLods - 1);
+
+    struct MeshLods
+    {
+        std::vector<uint16_t> indices[kMaxLods - 1];
+        float error[kMaxLods - 1];
+    };
+    std::vector<MeshLods> meshLods(m_Header.meshCount);
+
+    ParallelFor(m_Header.meshCount, m_ThreadCount, [&](unsigned int meshIndex)
+    {
+        const Mesh *mesh = m_pMesh + meshIndex;
+        MeshLods &result = meshLods[meshIndex];
+
+        const uint16_t *source = (const uint16_t*)(m_pIndexData + mesh->indexDataByteOffset);
+        uint32_t sourceCount = mesh->indexCount;
+        float sourceError = 0.0f;
+
+        // Without float positions every level stays at full detail
+        const Attrib &position = mesh->attrib[attrib_position];
+        const bool canSimplify = position.format == attrib_format_float && position.components >= 3;
+        const float *positions = (const float*)(m_pVertexData + mesh->vertexDataByteOffset + position.offset);
+
+        // Each level halves the previous one, and its error includes the errors of the levels before it
+        for (uint32_t level = 0; level < lodCount; level++)
+        {
+            std::vector<uint16_t> simplified(source, source + sourceCount);
+            float levelError = 0.0f;
+            if (canSimplify)
+            {
+                uint32_t targetCount = ((mesh->indexCount / 3) >> (level + 1)) * 3;
+                simplified.resize(SimplifyMesh<uint16_t>(source, sourceCount, positions, mesh->vertexStride, mesh->vertexCount,
+                    targetCount, simplified.data(), levelError));
+            }
+
+            // re-order the remaining triangles for the post transform cache, like the full mesh
+            std::vector<uint16_t> &indices = result.indices[level];
+            indices.resize(simplified.size());
+            if (!simplified.empty())
+                OptimizeFaces<uint16_t>(simplified.data(), (uint32_t)simplified.size(), indices.data(), lruCacheSize);
+
+            result.error[level] = sourceError + levelError;
+            source = indices.data();
+            sourceCount = (uint32_t)indices.size();
+            sourceError = result.error[level];
+        }
+    });
+
+    delete [] m_pMeshLods;
+    delete [] m_pLodIndices;
+
+    m_LodCount = lodCount;
+    m_LodIndexCount = 0;
+    for (const MeshLods &result : meshLods)
+    {
+        for (uint32_t level = 0; level < lodCount; level++)
+            m_LodIndexCount += (uint32_t)result.indices[level].size();
+    }
+
+    m_pMeshLods = new MeshLod [m_Header.meshCount * lodCount];
+    m_pLodIndices = new uint16_t [m_LodIndexCount];
+
+    // Pack the levels in mesh order after the mesh indices; see Model::MeshLod
+    uint32_t lodIndexOffset = 0;
+    std::vector<uint64_t> levelIndexCounts(lodCount, 0);
+    for (unsigned int meshIndex = 0; meshIndex < m_Header.meshCount; meshIndex++)
+    {
+        for (uint32_t level = 0; level < lodCount; level++)
+        {
+            const std::vector<uint16_t> &indices = meshLods[meshIndex].indices[level];
+
+            MeshLod &lod = m_pMeshLods[meshIndex * lodCount + level];
+            lod.indexDataByteOffset = m_Header.indexDataByteSize + lodIndexOffset * (uint32_t)sizeof(uint16_t);
+            lod.indexCount = (uint32_t)indices.size();
+            lod.error = meshLods[meshIndex].error[level];
+            lod.reserved = 0;
+
+            if (!indices.empty())
+                memcpy(m_pLodIndices + lodIndexOffset, indices.data(), indices.size() * sizeof(uint16_t));
+            lodIndexOffset += (uint32_t)indices.size();
+            levelIndexCounts[level] += indices.size();
+        }
+    }
+
+    uint64_t baseIndexCount = m_Header.indexDataByteSize / sizeof(uint16_t);
+    for (uint32_t level = 0; level < lodCount; level++)
+    {
+        printf("lod %u: %llu triangles (%.1f%%)\n", level + 1, levelIndexCounts[level] / 3,
+            baseIndexCount == 0 ? 0.0 : 100.0 * levelIndexCounts[level] / baseIndexCount);
+    }
+}
+
+void AssimpModel::GenerateMeshlets()
+{
+    struct MeshMeshlets
+    {
+        std::vector<Meshlet> meshlets;
+        std::vector<uint32_t> vertices;
+        std::vector<uint32_t> triangles;
+    };
+    std::vector<MeshMeshlets> meshMeshlets(m_Header.meshCount);
+
+    ParallelFor(m_Header.meshCount, m_ThreadCount, [&](unsigned int meshIndex)
+    {
+        const Mesh *mesh = m_pMesh + meshIndex;
+
+        const Attrib &position = mesh->attrib[attrib_position];
+        if (position.format != attrib_format_float || position.components < 3)
+            return;
+
+        const float *positions = (const float*)(m_pVertexData + mesh->vertexDataByteOffset + position.offset);
+        const uint16_t *indices = (const uint16_t*)(m_pIndexData + mesh->indexDataByteOffset);
+
+        MeshMeshlets &result = meshMeshlets[meshIndex];
+        BuildMeshlets(indices, mesh->indexCount, positions, mesh->vertexStride, kMaxMeshletVertices, kMaxMeshletTriangles,
+            result.meshlets, result.vertices, result.triangles);
+    });
+
+    delete [] m_pMeshletRanges;
+    delete [] m_pMeshlets;
+    delete [] m_pMeshletVertices;
+    delete [] m_pMeshletTriangles;
+
+    m_MeshletCount = 0;
+    m_MeshletVertexCount = 0;
+    m_MeshletTriangleCount = 0;
+    for (const MeshMeshlets &result : meshMeshlets)
+    {
+        m_MeshletCount += (uint32_t)result.meshlets.size();
+        m_MeshletVertexCount += (uint32_t)result.vertices.size();
+        m_MeshletTriangleCount += (uint32_t)result.triangles.size();
+    }
+
+    m_pMeshletRanges = new MeshletRange [m_Header.meshCount];
+    m_pMeshlets = new Meshlet [m_MeshletCount];
+    m_pMeshletVertices = new uint32_t [m_MeshletVertexCount];
+    m_pMeshletTriangles = new uint32_t [m_MeshletTriangleCount];
+
+    // Pack the meshes' meshlets in mesh order, rebasing their offsets into the combined lists
+    uint32_t meshletOffset = 0;
+    uint32_t vertexOffset = 0;
+    uint32_t triangleOffset = 0;
+    for (unsigned int meshIndex = 0; meshIndex < m_Header.meshCount; meshIndex++)
+    {
+        const MeshMeshlets &result = meshMeshlets[meshIndex];
+
+        m_pMeshletRanges[meshIndex].meshletOffset = meshletOffset;
+        m_pMeshletRanges[meshIndex].meshletCount = (uint32_t)result.meshlets.size();
+
+        for (Meshlet meshlet : result.meshlets)
+        {
+            meshlet.vertexOffset += vertexOffset;
+            meshlet.triangleOffset += triangleOffset;
+            m_pMeshlets[meshletOffset++] = meshlet;
+        }
+
+        if (!result.vertices.empty())
+            memcpy(m_pMeshletVertices + vertexOffset, result.vertices.data(), result.vertices.size() * sizeof(uint32_t));
+        if (!result.triangles.empty())
+            memcpy(m_pMeshletTriangles + triangleOffset, result.triangles.data(), result.triangles.size() * sizeof(uint32_t));
+        vertexOffset += (uint32_t)result.vertices.size();
+        triangleOffset += (uint32_t)result.triangles.size();
+    }
+
+    printf("meshlets: %u, %.1f vertices and %.1f triangles on average\n", m_MeshletCount,
+        m_MeshletCount == 0 ? 0.0 : (double)m_MeshletVertexCount / m_MeshletCount,
+        m_MeshletCount == 0 ? 0.0 : (double)m_MeshletTriangleCount / m_MeshletCount);
+}
+
+void AssimpModel::QuantizeVertices()
+{
+    // Skinning reads and writes float vertices (see VertexFormats::SkinnedVertex)
+    if (m_Header.meshCount == 0 || HasQuantizedVertices() || IsSkinned())
+        return;
+
+    // See VertexFormats::QuantizedVertex, which ModelViewer's input layout reads
+    typedef VertexFormats::QuantizedVertex Vertex;
+    enum
+    {
+        kPositionOffset = offsetof(Vertex, position), kTexcoordOffset = offsetof(Vertex, texcoord0),
+        kNormalOffset = offsetof(Vertex, normal), kTangentOffset = offsetof(Vertex, tangent), kBitangentOffset = offsetof(Vertex, bitangent)
+    };
+    enum { kQuantizedStride = sizeof(Vertex) };
+
+    unsigned int oldStride = m_pMesh[0].vertexStride;
+    uint32_t quantizedVertexDataSize = 0;
+    std::vector<uint32_t> quantizedOffsets(m_Header.meshCount);
+    for (unsigned int meshIndex = 0; meshIndex < m_Header.meshCount; meshIndex++)
+    {
+        quantizedOffsets[meshIndex] = quantizedVertexDataSize;
+        quantizedVertexDataSize += m_pMesh[meshIndex].vertexCount * kQuantizedStride;
+    }
+
+    unsigned char *quantizedVertexData = new unsigned char [quantizedVertexDataSize];
+    memset(quantizedVertexData, 0, quantizedVertexDataSize);
+
+    ParallelFor(m_Header.meshCount, m_ThreadCount, [&](unsigned int meshIndex)
+    {
+        Mesh *mesh = m_pMesh + meshIndex;
+        const unsigned char *srcVertexData = m_pVertexData + mesh->vertexDataByteOffset;
+        unsigned char *dstVertexData = quantizedVertexData + quantizedOffsets[meshIndex];
+
+        // positions are stored relative to the mesh bounding box, which the renderer uses to decode them
+        float boundsMin[3] = { mesh->boundingBox.min.GetX(), mesh->boundingBox.min.GetY(), mesh->boundingBox.min.GetZ() };
+        float boundsMax[3] = { mesh->boundingBox.max.GetX(), mesh->boundingBox.max.GetY(), mesh->boundingBox.max.GetZ() };
+        float invExtent[3];
+        for (int n = 0; n < 3; n++)
+            invExtent[n] = boundsMax[n] > boundsMin[n] ? 1.0f / (boundsMax[n] - boundsMin[n]) : 0.0f;
+
+        for (unsigned int v = 0; v < mesh->vertexCount; v++)
+        {
+            const unsigned char *src = srcVertexData + v * mesh->vertexStride;
+            unsigned char *dst = dstVertexData + v * kQuantizedStride;
+
+            const float *position = (const float*)(src + mesh->attrib[attrib_position].offset);
+            uint16_t *dstPosition = (uint16_t*)(dst + kPositionOffset);
+            for (int n = 0; n < 3; n++)
+                dstPosition[n] = QuantizeUnorm16((position[n] - boundsMin[n]) * invExtent[n]);
+
+            const float *texcoord0 = (const float*)(src + mesh->attrib[attrib_texcoord0].offset);
+            uint16_t *dstTexcoord0 = (uint16_t*)(dst + kTexcoordOffset);
+            dstTexcoord0[0] = DirectX::PackedVector::XMConvertFloatToHalf(texcoord0[0]);
+            dstTexcoord0[1] = DirectX::PackedVector::XMConvertFloatToHalf(texcoord0[1]);
+
+            OctEncode((const float*)(src + mesh->attrib[attrib_normal].offset), (int16_t*)(dst + kNormalOffset));
+            OctEncode((const float*)(src + mesh->attrib[attrib_tangent].offset), (int16_t*)(dst + kTangentOffset));
+            OctEncode((const float*)(src + mesh->attrib[attrib_bitangent].offset), (int16_t*)(dst + kBitangentOffset));
+        }
+
+        mesh->vertexStride = kQuantizedStride;
+        mesh->vertexDataByteOffset = quantizedOffsets[meshIndex];
+
+        mesh->attrib[attrib_position].offset = kPositionOffset;
+        mesh->attrib[attrib_position].normalized = 1;
+        mesh->attrib[attrib_position].components = 3;
+        mesh->attrib[attrib_position].format = attrib_format_ushort;
+
+        mesh->attrib[attrib_texcoord0].offset = kTexcoordOffset;
+        mesh->attrib[attrib_texcoord0].normalized = 0;
+        mesh->attrib[attrib_texcoord0].components = 2;
+        mesh->attrib[attrib_texcoord0].format = attrib_format_half;
+
+        const int directions[] = { attrib_normal, attrib_tangent, attrib_bitangent };
+        const uint16_t directionOffsets[] = { kNormalOffset, kTangentOffset, kBitangentOffset };
+        for (int n = 0; n < 3; n++)
+        {
+            mesh->attrib[directions[n]].offset = directionOffsets[n];
+            mesh->attrib[directions[n]].normalized = 1;
+            mesh->attrib[directions[n]].components = 2;
+            mesh->attrib[directions[n]].format = attrib_format_short;
+        }
+    });
+
+    printf("quantized vertices: %u -> %u bytes per vertex, %u -> %u bytes\n", oldStride, (unsigned int)kQuantizedStride,
+        m_Header.vertexDataByteSize, quantizedVertexDataSize);
+
+    delete [] m_pVertexData;
+    m_pVertexData = quantizedVertexData;
+    m_Header.vertexDataByteSize = quantizedVertexDataSize;
+}
+
+void AssimpModel::PrintVertexCacheStats(const char *stage, bool depth) const
+{
+    // Statistics use a smaller cache than the optimizer, to be representative of more hardware
+    enum {lruCacheSize = 16};
+
+    uint64_t triangleCount = 0;
+    uint64_t vertexCount = 0;
+    uint64_t transformCount = 0;
+    uint64_t vertexBytes = 0;
+    uint64_t fetchedBytes = 0;
+
+    for (unsigned int meshIndex = 0; meshIndex < m_Header.meshCount; meshIndex++)
+    {
+        const Mesh *mesh = m_pMesh + meshIndex;
+        const uint16_t *indices = (const uint16_t*)((depth ? m_pIndexDataDepth : m_pIndexData) + mesh->indexDataByteOffset);
+        unsigned int vertexStride = depth ? mesh->vertexStrideDepth : mesh->vertexStride;
+        unsigned int meshVertexCount = depth ? mesh->vertexCountDepth : mesh->vertexCount;
+
+        triangleCount += mesh->indexCount / 3;
+        vertexCount += meshVertexCount;
+        transformCount += AnalyzeVertexCache<uint16_t>(indices, mesh->indexCount, lruCacheSize);
+        vertexBytes += meshVertexCount * vertexStride;
+        fetchedBytes += AnalyzeVertexFetch<uint16_t>(indices, mesh->indexCount, vertexStride);
+    }
+
+    printf("%-16s %-10s ACMR %.3f, ATVR %.3f, overfetch %.3f\n", stage, depth ? "depth-only" : "full",
+        triangleCount == 0 ? 0.0 : (double)transformCount / triangleCount,
+        vertexCount == 0 ? 0.0 : (double)transformCount / vertexCount,
+        vertexBytes == 0 ? 0.0 : (double)fetchedBytes / vertexBytes);
+}
+
 void AssimpModel::Optimize()
 {
-    // TODO: quantize/compress vertex data
+    auto timeStage = [](const char *stage, const std::function<void()>& func)
+    {
+        auto start = std::chrono::steady_clock::now();
+        func();
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        printf("%-24s %10.1f ms\n", stage, elapsed.count());
+    };
+
+    printf("optimizing %u meshes on %u threads...\n", m_Header.meshCount, m_ThreadCount);
 
-    OptimizeRemoveDuplicateVertices(false);
-    OptimizeRemoveDuplicateVertices(true);
+    timeStage("remove duplicates", [this]()
+    {
+        OptimizeRemoveDuplicateVertices(false);
+        OptimizeRemoveDuplicateVertices(true);
+    });
+
+    PrintVertexCacheStats("before optimize", false);
+    PrintVertexCacheStats("before optimize", true);
+
+    if (m_BenchmarkPostTransform)
+    {
+        BenchmarkPostTransform(false);
+        BenchmarkPostTransform(true);
+    }
 
     // re-order indices for post transform cache
-    OptimizePostTransform(false);
-    OptimizePostTransform(true);
+    timeStage("post transform", [this]()
+    {
+        OptimizePostTransform(false);
+        OptimizePostTransform(true);
+    });
+
+    // re-order triangle clusters to draw occluders first, at a small cost in post transform cache efficiency
+    timeStage("overdraw", [this]()
+    {
+        OptimizeOverdraw(false);
+        OptimizeOverdraw(true);
+    });
 
     // re-order vertices for linear memory access
-    OptimizePreTransform(false);
-    OptimizePreTransform(true);
+    timeStage("pre transform", [this]()
+    {
+        OptimizePreTransform(false);
+        OptimizePreTransform(true);
+    });
+
+    PrintVertexCacheStats("after optimize", false);
+    PrintVertexCacheStats("after optimize", true);
+
+    // simplify the full vertex stream's meshes into coarser index lists
+    if (m_LodLevels > 0)
+    {
+        timeStage("lods", [this]()
+        {
+            GenerateLods();
+        });
+    }
+
+    // split the final index order into meshlets for finer grained culling
+    timeStage("meshlets", [this]()
+    {
+        GenerateMeshlets();
+    });
+
+    // shrink the full vertex stream last, every earlier stage reads float positions
+    if (m_QuantizeVertices)
+    {
+        timeStage("quantize", [this]()
+        {
+            QuantizeVertices();
+        });
+    }
 }
@@ -15,3 +15,9 @@ dxc.exe /Zi /E"main" /Vn"g_pDepthViewerVS_SM6" /Tvs_6_0 /Fh"DepthViewerVS_SM6.h"
 copy DepthViewerVS_SM6.h ..\Build_VS14\x64\Debug\Output\ModelViewer\CompiledShaders
 copy DepthViewerVS_SM6.h ..\Build_VS14\x64\Profile\Output\ModelViewer\CompiledShaders
 copy DepthViewerVS_SM6.h ..\Build_VS14\x64\Release\Output\ModelViewer\CompiledShaders
+
+dxc.exe /D_WAVE_OP /Zi /E"main" /Vn"g_pFillLightClustersCS_SM6" /Tcs_6_0 /Fh"FillLightClustersCS_SM6.h" /nologo Shaders/FillLightClustersCS.hlsl
+
+copy FillLightClustersCS_SM6.h ..\Build_VS14\x64\Debug\Output\ModelViewer\CompiledShaders
+copy FillLightClustersCS_SM6.h ..\Build_VS14\x64\Profile\Output\ModelViewer\CompiledShaders
+copy FillLightClustersCS_SM6.h ..\Build_VS14\x64\Release\Output\ModelViewer\CompiledShaders
@@ -18,11 +18,24 @@
 #include "CommandContext.h"
 #include "Camera.h"
 #include "BufferManager.h"
+#include "BitonicSort.h"
+#include "Math/Random.h"
 
 #include "CompiledShaders/FillLightGridCS_8.h"
 #include "CompiledShaders/FillLightGridCS_16.h"
 #include "CompiledShaders/FillLightGridCS_24.h"
 #include "CompiledShaders/FillLightGridCS_32.h"
+#include "CompiledShaders/FillLightClustersCS.h"
+#include "CompiledShaders/LightBVHKeysCS.h"
+#include "CompiledShaders/LightBVHLeavesCS.h"
+#include "CompiledShaders/LightBVHNodesCS.h"
+
+// To cull cluster lights with wave intrinsics, uncomment this macro along with the one in ModelViewer.cpp.
+// Run CompileSM6Test.bat to compile the SM6 variant with DXC.
+//#define _WAVE_OP
+#ifdef _WAVE_OP
+#include "CompiledShaders/FillLightClustersCS_SM6.h"
+#endif
 
 using namespace Math;
 using namespace Graphics;
@@ -37,27 +50,62 @@ struct LightData
     uint32_t type;
     float coneDir[3];
     float coneAngles[2];
+    uint32_t shadowSlice;
 
     float shadowTextureMatrix[16];
 };
 
+// must keep in sync with HLSL
+struct LightBVHNode
+{
+    float aabbMin[3];
+    uint32_t lightIndex;
+    float aabbMax[3];
+    uint32_t pad;
+};
+
 enum { kMinLightGridDim = 8 };
 
+// Room in the cluster light index list for this many lights per cluster on average
+enum { kAverageLightsPerCluster = 32 };
+
 namespace Lighting
 {
     IntVar LightGridDim("Application/Forward+/Light Grid Dim", 16, kMinLightGridDim, 32, 8 );
+    BoolVar EnableClusters("Application/Forward+/Clustered", false);
+    BoolVar EnableLightBVH("Application/Forward+/Light BVH", false);
+    IntVar ShadowUpdatesPerFrame("Application/Forward+/Shadow Updates Per Frame", 2, 1, 16);
 
     RootSignature m_FillLightRootSig;
     ComputePSO m_FillLightGridCS_8;
     ComputePSO m_FillLightGridCS_16;
     ComputePSO m_FillLightGridCS_24;
     ComputePSO m_FillLightGridCS_32;
+    ComputePSO m_FillLightClustersCS;
+
+    RootSignature m_LightBVHRootSig;
+    ComputePSO m_LightBVHKeysCS;
+    ComputePSO m_LightBVHLeavesCS;
+    ComputePSO m_LightBVHNodesCS;
 
-    LightData m_LightData[MaxLights];
+    __declspec(align(16)) LightData m_LightData[MaxLights];
     StructuredBuffer m_LightBuffer;
     ByteAddressBuffer m_LightGrid;
 
     ByteAddressBuffer m_LightGridBitMask;
+    ByteAddressBuffer m_LightClusters;
+    ByteAddressBuffer m_LightClusterIndices;
+    uint32_t m_LightClusterTileCountX;      // the scene tiles the cluster buffers were sized for
+    uint32_t m_LightClusterTileCountY;
+
+    // Morton code sort list, its count, and the tree.  The leaf count is the light count rounded up to a power of two.
+    ByteAddressBuffer m_LightBVHKeys;
+    ByteAddressBuffer m_LightBVHCount;
+    StructuredBuffer m_LightBVH;
+    uint32_t m_LightBVHLeafCount;
+    Vector3 m_LightBoundsMin;
+    Vector3 m_LightBoundsMax;
+
     uint32_t m_FirstConeLight;
     uint32_t m_FirstConeShadowedLight;
 
@@ -65,10 +113,24 @@ namespace Lighting
     ColorBuffer m_LightShadowArray;
     ShadowBuffer m_LightShadowTempBuffer;
     Matrix4 m_LightShadowMatrix[MaxLights];
+    Frustum m_LightShadowFrustum[MaxLights];
+
+    // The shadow cache.  A light's map is valid while the slice's matrix matches the light's and no dynamic
+    // caster was in its frustum when it was rendered.
+    uint32_t m_ShadowSliceLight[MaxShadowSlices];
+    uint64_t m_ShadowSliceLastVisible[MaxShadowSlices];
+    Matrix4 m_ShadowSliceMatrix[MaxShadowSlices];
+    bool m_ShadowIsValid[MaxLights];
+    bool m_ShadowHadDynamicCasters[MaxLights];
+    uint64_t m_ShadowFrame;
+    uint32_t m_ShadowCursor;
 
     void InitializeResources(void);
     void CreateRandomLights(const Vector3 minBound, const Vector3 maxBound);
+    void UpdateClusterBuffers(void);
     void FillLightGrid(GraphicsContext& gfxContext, const Camera& camera);
+    void FillLightClusters(ComputeContext& Context, const Camera& camera);
+    void BuildLightBVH(ComputeContext& Context);
     void Shutdown(void);
 }
 
@@ -76,7 +138,7 @@ void Lighting::InitializeResources( void )
 {
     m_FillLightRootSig.Reset(3, 0);
     m_FillLightRootSig[0].InitAsConstantBuffer(0);
-    m_FillLightRootSig[1].InitAsDescriptorRange(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 0, 2);
+    m_FillLightRootSig[1].InitAsDescriptorRange(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 0, 3);
     m_FillLightRootSig[2].InitAsDescriptorRange(D3D12_DESCRIPTOR_RANGE_TYPE_UAV, 0, 2);
     m_FillLightRootSig.Finalize(L"FillLightRS");
 
@@ -95,6 +157,32 @@ void Lighting::InitializeResources( void )
     m_FillLightGridCS_32.SetRootSignature(m_FillLightRootSig);
     m_FillLightGridCS_32.SetComputeShader(g_pFillLightGridCS_32, sizeof(g_pFillLightGridCS_32));
     m_FillLightGridCS_32.Finalize();
+
+    m_FillLightClustersCS.SetRootSignature(m_FillLightRootSig);
+#ifdef _WAVE_OP
+    m_FillLightClustersCS.SetComputeShader(g_pFillLightClustersCS_SM6, sizeof(g_pFillLightClustersCS_SM6));
+#else
+    m_FillLightClustersCS.SetComputeShader(g_pFillLightClustersCS, sizeof(g_pFillLightClustersCS));
+#endif
+    m_FillLightClustersCS.Finalize();
+
+    m_LightBVHRootSig.Reset(3, 0);
+    m_LightBVHRootSig[0].InitAsConstants(0, 10);
+    m_LightBVHRootSig[1].InitAsDescriptorRange(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 0, 2);
+    m_LightBVHRootSig[2].InitAsDescriptorRange(D3D12_DESCRIPTOR_RANGE_TYPE_UAV, 0, 1);
+    m_LightBVHRootSig.Finalize(L"LightBVHRS");
+
+    m_LightBVHKeysCS.SetRootSignature(m_LightBVHRootSig);
+    m_LightBVHKeysCS.SetComputeShader(g_pLightBVHKeysCS, sizeof(g_pLightBVHKeysCS));
+    m_LightBVHKeysCS.Finalize();
+
+    m_LightBVHLeavesCS.SetRootSignature(m_LightBVHRootSig);
+    m_LightBVHLeavesCS.SetComputeShader(g_pLightBVHLeavesCS, sizeof(g_pLightBVHLeavesCS));
+    m_LightBVHLeavesCS.Finalize();
+
+    m_LightBVHNodesCS.SetRootSignature(m_LightBVHRootSig);
+    m_LightBVHNodesCS.SetComputeShader(g_pLightBVHNodesCS, sizeof(g_pLightBVHNodesCS));
+    m_LightBVHNodesCS.Finalize();
 }
 
 void Lighting::CreateRandomLights( const Vector3 minBound, const Vector3 maxBound )
@@ -102,15 +190,11 @@ void Lighting::CreateRandomLights( const Vector3 minBound, const Vector3 maxBoun
     Vector3 posScale = maxBound - minBound;
     Vector3 posBias = minBound;
 
-    // todo: replace this with MT
-    srand(12645);
-    auto randUint = []() -> uint32_t
-    {
-        return rand(); // [0, RAND_MAX]
-    };
-    auto randFloat = [randUint]() -> float
+    // A fixed seed keeps the lights the same from run to run
+    Math::RandomNumberGenerator rng(12645);
+    auto randFloat = [&rng]() -> float
     {
-        return randUint() * (1.0f / RAND_MAX); // convert [0, RAND_MAX] to [0, 1]
+        return rng.NextFloat(); // [0, 1)
     };
     auto randVecUniform = [randFloat]() -> Vector3
     {
@@ -183,6 +267,7 @@ void Lighting::CreateRandomLights( const Vector3 minBound, const Vector3 maxBoun
         shadowCamera.SetPerspectiveMatrix(coneOuter * 2, 1.0f, lightRadius * .05f, lightRadius * 1.0f);
         shadowCamera.Update();
         m_LightShadowMatrix[n] = shadowCamera.GetViewProjMatrix();
+        m_LightShadowFrustum[n] = shadowCamera.GetWorldSpaceFrustum();
         Matrix4 shadowTextureMatrix = Matrix4(AffineTransform(Matrix3::MakeScale( 0.5f, -0.5f, 1.0f ), Vector3(0.5f, 0.5f, 0.0f))) * m_LightShadowMatrix[n];
 
         m_LightData[n].pos[0] = pos.GetX();
@@ -199,6 +284,9 @@ void Lighting::CreateRandomLights( const Vector3 minBound, const Vector3 maxBoun
         m_LightData[n].coneAngles[0] = 1.0f / (cos(coneInner) - cos(coneOuter));
         m_LightData[n].coneAngles[1] = cos(coneOuter);
         std::memcpy(m_LightData[n].shadowTextureMatrix, &shadowTextureMatrix, sizeof(shadowTextureMatrix));
+        m_LightData[n].shadowSlice = kNoShadowSlice;
+        m_ShadowIsValid[n] = false;
+        m_ShadowHadDynamicCasters[n] = false;
         //*(Matrix4*)(m_LightData[n].shadowTextureMatrix) = shadowTextureMatrix;
     }
     // sort lights by type, needed for efficiency in the BIT_MASK approach
@@ -242,6 +330,14 @@ void Lighting::CreateRandomLights( const Vector3 minBound, const Vector3 maxBoun
     }
     m_LightBuffer.Create(L"m_LightBuffer", MaxLights, sizeof(LightData), m_LightData);
 
+    for (uint32_t i = 0; i < MaxShadowSlices; ++i)
+    {
+        m_ShadowSliceLight[i] = kNoShadowSlice;
+        m_ShadowSliceLastVisible[i] = 0;
+    }
+    m_ShadowFrame = 0;
+    m_ShadowCursor = 0;
+
     // todo: assumes max resolution of 1920x1080
     uint32_t lightGridCells = Math::DivideByMultiple(1920, kMinLightGridDim) * Math::DivideByMultiple(1080, kMinLightGridDim);
     uint32_t lightGridSizeBytes = lightGridCells * (4 + MaxLights * 4);
@@ -250,27 +346,174 @@ void Lighting::CreateRandomLights( const Vector3 minBound, const Vector3 maxBoun
     uint32_t lightGridBitMaskSizeBytes = lightGridCells * 4 * 4;
     m_LightGridBitMask.Create(L"m_LightGridBitMask", lightGridBitMaskSizeBytes, 1, nullptr);
 
-    m_LightShadowArray.CreateArray(L"m_LightShadowArray", shadowDim, shadowDim, MaxLights, DXGI_FORMAT_R16_UNORM);
+    m_LightClusterTileCountX = 0;
+    m_LightClusterTileCountY = 0;
+    UpdateClusterBuffers();
+
+    // Light positions are within the bounds given, which quantize the Morton codes
+    const uint32_t numLights = MaxLights;
+    m_LightBoundsMin = minBound;
+    m_LightBoundsMax = maxBound;
+    m_LightBVHLeafCount = Math::AlignPowerOfTwo(numLights);
+    m_LightBVHKeys.Create(L"m_LightBVHKeys", numLights, 8, nullptr);
+    m_LightBVHCount.Create(L"m_LightBVHCount", 1, 4, &numLights);
+    m_LightBVH.Create(L"m_LightBVH", 2 * m_LightBVHLeafCount - 1, sizeof(LightBVHNode), nullptr);
+
+    m_LightShadowArray.CreateArray(L"m_LightShadowArray", shadowDim, shadowDim, MaxShadowSlices, DXGI_FORMAT_R16_UNORM);
     m_LightShadowTempBuffer.Create(L"m_LightShadowTempBuffer", shadowDim, shadowDim);
 }
 
+void Lighting::UpdateClusterBuffers(void)
+{
+    // Resizing idles the GPU before it recreates the scene buffers, so the old buffers are no longer in use.
+    // Recreating keeps the views' descriptors, and the bindless tables are refreshed on resize anyway.
+    uint32_t tileCountX = Math::DivideByMultiple(g_SceneColorBuffer.GetWidth(), ClusterTileDim);
+    uint32_t tileCountY = Math::DivideByMultiple(g_SceneColorBuffer.GetHeight(), ClusterTileDim);
+    if (tileCountX == m_LightClusterTileCountX && tileCountY == m_LightClusterTileCountY)
+        return;
+
+    m_LightClusterTileCountX = tileCountX;
+    m_LightClusterTileCountY = tileCountY;
+
+    // Each cluster is an offset into the index list and its light counts.  The list starts with its counter.
+    uint32_t lightClusterCount = tileCountX * tileCountY * ClusterSlices;
+    m_LightClusters.Create(L"m_LightClusters", lightClusterCount * 2, 4, nullptr);
+    m_LightClusterIndices.Create(L"m_LightClusterIndices", 1 + lightClusterCount * kAverageLightsPerCluster, 4, nullptr);
+}
+
 void Lighting::Shutdown(void)
 {
     m_LightBuffer.Destroy();
     m_LightGrid.Destroy();
     m_LightGridBitMask.Destroy();
+    m_LightClusters.Destroy();
+    m_LightClusterIndices.Destroy();
+    m_LightBVHKeys.Destroy();
+    m_LightBVHCount.Destroy();
+    m_LightBVH.Destroy();
     m_LightShadowArray.Destroy();
     m_LightShadowTempBuffer.Destroy();
 }
 
+uint32_t Lighting::UpdateShadowCache( GraphicsContext& gfxContext, const Camera& camera,
+    const Vector3* dynamicCasterBounds, uint32_t numDynamicCasters, uint32_t* lightIndices, uint32_t* slices )
+{
+    const uint64_t frame = ++m_ShadowFrame;
+    const Frustum& viewFrustum = camera.GetWorldSpaceFrustum();
+    const uint32_t firstLight = m_FirstConeShadowedLight;
+    const uint32_t numShadowed = MaxLights - firstLight;
+
+    bool isVisible[MaxLights];
+    bool hasDynamicCasters[MaxLights];
+
+    for (uint32_t n = firstLight; n < MaxLights; n++)
+    {
+        const LightData& light = m_LightData[n];
+        isVisible[n] = viewFrustum.IntersectSphere(BoundingSphere(
+            Vector3(light.pos[0], light.pos[1], light.pos[2]), Scalar(std::sqrt(light.radiusSq))));
+
+        // A light whose map saw a dynamic caster is rendered again even if the caster has left, to erase it
+        hasDynamicCasters[n] = false;
+        for (uint32_t i = 0; i < numDynamicCasters && !hasDynamicCasters[n]; ++i)
+        {
+            hasDynamicCasters[n] = m_LightShadowFrustum[n].IntersectBoundingBox(
+                dynamicCasterBounds[2 * i], dynamicCasterBounds[2 * i + 1]);
+        }
+        if (hasDynamicCasters[n] || m_ShadowHadDynamicCasters[n])
+            m_ShadowIsValid[n] = false;
+
+        const uint32_t slice = light.shadowSlice;
+        if (slice == kNoShadowSlice)
+            continue;
+
+        if (isVisible[n])
+            m_ShadowSliceLastVisible[slice] = frame;
+        if (std::memcmp(&m_ShadowSliceMatrix[slice], &m_LightShadowMatrix[n], sizeof(Matrix4)) != 0)
+            m_ShadowIsValid[n] = false;
+    }
+
+    // Visible lights without a valid map are served in turn, up to the budget, starting where the last frame
+    // left off so that none of them waits indefinitely.
+    const uint32_t budget = std::min<uint32_t>(ShadowUpdatesPerFrame, MaxShadowSlices);
+    bool slicesChanged = false;
+    uint32_t count = 0;
+    uint32_t k = 0;
+
+    for (; k < numShadowed && count < budget; ++k)
+    {
+        const uint32_t n = firstLight + (m_ShadowCursor + k) % numShadowed;
+        if (!isVisible[n] || m_ShadowIsValid[n])
+            continue;
+
+        uint32_t slice = m_LightData[n].shadowSlice;
+        if (slice == kNoShadowSlice)
+        {
+            // A free slice, or else the least recently visible one that is not visible now
+            for (uint32_t i = 0; i < MaxShadowSlices; ++i)
+            {
+                if (m_ShadowSliceLastVisible[i] == frame)
+                    continue;
+                if (slice == kNoShadowSlice || m_ShadowSliceLastVisible[i] < m_ShadowSliceLastVisible[slice])
+                    slice = i;
+            }
+            if (slice == kNoShadowSlice)
+                continue;
+
+            const uint32_t evicted = m_ShadowSliceLight[slice];
+            if (evicted != kNoShadowSlice)
+            {
+                m_LightData[evicted].shadowSlice = kNoShadowSlice;
+                m_ShadowIsValid[evicted] = false;
+            }
+
+            m_ShadowSliceLight[slice] = n;
+            m_ShadowSliceLastVisible[slice] = frame;
+            m_LightData[n].shadowSlice = slice;
+            slicesChanged = true;
+        }
+
+        m_ShadowSliceMatrix[slice] = m_LightShadowMatrix[n];
+        m_ShadowIsValid[n] = true;
+        m_ShadowHadDynamicCasters[n] = hasDynamicCasters[n];
+
+        lightIndices[count] = n;
+        slices[count] = slice;
+        ++count;
+    }
+
+    if (numShadowed > 0)
+        m_ShadowCursor = (m_ShadowCursor + k) % numShadowed;
+
+    if (slicesChanged)
+    {
+        gfxContext.TransitionResource(m_LightBuffer, D3D12_RESOURCE_STATE_COPY_DEST, true);
+        gfxContext.WriteBuffer(m_LightBuffer, 0, m_LightData, sizeof(m_LightData));
+        gfxContext.TransitionResource(m_LightBuffer, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+    }
+
+    return count;
+}
+
 void Lighting::FillLightGrid(GraphicsContext& gfxContext, const Camera& camera)
 {
     ScopedTimer _prof(L"FillLightGrid", gfxContext);
 
     ComputeContext& Context = gfxContext.GetComputeContext();
 
+    if (EnableLightBVH)
+        BuildLightBVH(Context);
+
     Context.SetRootSignature(m_FillLightRootSig);
 
+    Context.TransitionResource(m_LightBVH, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+    Context.SetDynamicDescriptor(1, 2, m_LightBVH.GetSRV());
+
+    if (EnableClusters)
+    {
+        FillLightClusters(Context, camera);
+        return;
+    }
+
     switch ((int)LightGridDim)
     {
     case  8: Context.SetPipelineState(m_FillLightGridCS_8 ); break;
@@ -284,7 +527,7 @@ void Lighting::FillLightGrid(GraphicsContext& gfxContext, const Camera& camera)
 
     Context.TransitionResource(m_LightBuffer, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
     Context.TransitionResource(LinearDepth, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
-    Context.TransitionResource(g_SceneDepthBuffer, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+    Context.TransitionDepthToReadOnly(g_SceneDepthBuffer);
     Context.TransitionResource(m_LightGrid, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
     Context.TransitionResource(m_LightGridBitMask, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
 
@@ -309,6 +552,7 @@ void Lighting::FillLightGrid(GraphicsContext& gfxContext, const Camera& camera)
         float RcpZMagic;
         uint32_t TileCount;
         Matrix4 ViewProjMatrix;
+        uint32_t LightBVHLeafCount;
     } csConstants;
     // todo: assumes 1920x1080 resolution
     csConstants.ViewportWidth = g_SceneColorBuffer.GetWidth();
@@ -317,6 +561,7 @@ void Lighting::FillLightGrid(GraphicsContext& gfxContext, const Camera& camera)
     csConstants.RcpZMagic = RcpZMagic;
     csConstants.TileCount = tileCountX;
     csConstants.ViewProjMatrix = camera.GetViewProjMatrix();
+    csConstants.LightBVHLeafCount = EnableLightBVH ? m_LightBVHLeafCount : 0;
     Context.SetDynamicConstantBufferView(0, sizeof(CSConstants), &csConstants);
 
     Context.Dispatch(tileCountX, tileCountY, 1);
@@ -324,3 +569,118 @@ void Lighting::FillLightGrid(GraphicsContext& gfxContext, const Camera& camera)
     Context.TransitionResource(m_LightGrid, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
     Context.TransitionResource(m_LightGridBitMask, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
 }
+
+void Lighting::FillLightClusters(ComputeContext& Context, const Camera& camera)
+{
+    Context.SetPipelineState(m_FillLightClustersCS);
+
+    // reset the index list's allocation counter
+    Context.FillBuffer(m_LightClusterIndices, 0, 0, sizeof(uint32_t));
+
+    Context.TransitionResource(m_LightBuffer, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+    Context.TransitionResource(m_LightClusters, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+    Context.TransitionResource(m_LightClusterIndices, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+
+    Context.SetDynamicDescriptor(1, 0, m_LightBuffer.GetSRV());
+    Context.SetDynamicDescriptor(2, 0, m_LightClusters.GetUAV());
+    Context.SetDynamicDescriptor(2, 1, m_LightClusterIndices.GetUAV());
+
+    // UpdateClusterBuffers() sizes the buffers for the scene, but never dispatch past what was allocated
+    uint32_t tileCountX = Math::DivideByMultiple(g_SceneColorBuffer.GetWidth(), ClusterTileDim);
+    uint32_t tileCountY = Math::DivideByMultiple(g_SceneColorBuffer.GetHeight(), ClusterTileDim);
+    ASSERT(tileCountX <= m_LightClusterTileCountX && tileCountY <= m_LightClusterTileCountY,
+        "Light cluster buffers are smaller than the scene; call Lighting::UpdateClusterBuffers() after resizing");
+    tileCountX = std::min(tileCountX, m_LightClusterTileCountX);
+    tileCountY = std::min(tileCountY, m_LightClusterTileCountY);
+
+    float FarClipDist = camera.GetFarClip();
+    float NearClipDist = camera.GetNearClip();
+
+    struct CSConstants
+    {
+        uint32_t ViewportWidth, ViewportHeight;
+        float NearClip, FarClip;
+        float RcpZMagic;
+        uint32_t NumLights;
+        uint32_t MaxClusterIndices;
+        uint32_t MaxClusters;
+        Matrix4 ViewProjMatrix;
+        uint32_t LightBVHLeafCount;
+    } csConstants;
+    csConstants.ViewportWidth = g_SceneColorBuffer.GetWidth();
+    csConstants.ViewportHeight = g_SceneColorBuffer.GetHeight();
+    csConstants.NearClip = NearClipDist;
+    csConstants.FarClip = FarClipDist;
+    csConstants.RcpZMagic = NearClipDist / (FarClipDist - NearClipDist);
+    csConstants.NumLights = MaxLights;
+    csConstants.MaxClusterIndices = (uint32_t)m_LightClusterIndices.GetElementCount() - 1;
+    csConstants.MaxClusters = (uint32_t)m_LightClusters.GetElementCount() / 2;
+    csConstants.ViewProjMatrix = camera.GetViewProjMatrix();
+    csConstants.LightBVHLeafCount = EnableLightBVH ? m_LightBVHLeafCount : 0;
+    Context.SetDynamicConstantBufferView(0, sizeof(CSConstants), &csConstants);
+
+    Context.Dispatch(tileCountX, tileCountY, ClusterSlices);
+
+    Context.TransitionResource(m_LightClusters, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+    Context.TransitionResource(m_LightClusterIndices, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+}
+
+void Lighting::BuildLightBVH(ComputeContext& Context)
+{
+    ScopedTimer _prof(L"Build Light BVH", Context);
+
+    struct
+    {
+        float BoundsMin[3];
+        uint32_t NumLights;
+        float BoundsScale[3];
+        uint32_t LeafCount;
+        uint32_t FirstNode;
+        uint32_t NodeCount;
+    } constants;
+
+    Vector3 boundsScale = Recip(Max(m_LightBoundsMax - m_LightBoundsMin, Vector3(1e-6f, 1e-6f, 1e-6f)));
+    constants.BoundsMin[0] = m_LightBoundsMin.GetX();
+    constants.BoundsMin[1] = m_LightBoundsMin.GetY();
+    constants.BoundsMin[2] = m_LightBoundsMin.GetZ();
+    constants.NumLights = MaxLights;
+    constants.BoundsScale[0] = boundsScale.GetX();
+    constants.BoundsScale[1] = boundsScale.GetY();
+    constants.BoundsScale[2] = boundsScale.GetZ();
+    constants.LeafCount = m_LightBVHLeafCount;
+    constants.FirstNode = 0;
+    constants.NodeCount = 0;
+
+    // Sort the lights along a Morton curve
+    Context.SetRootSignature(m_LightBVHRootSig);
+    Context.SetPipelineState(m_LightBVHKeysCS);
+    Context.TransitionResource(m_LightBuffer, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+    Context.TransitionResource(m_LightBVHKeys, D3D12_RESOURCE_STATE_UNORDERED_ACCESS, true);
+    Context.SetConstantArray(0, 10, &constants);
+    Context.SetDynamicDescriptor(1, 0, m_LightBuffer.GetSRV());
+    Context.SetDynamicDescriptor(2, 0, m_LightBVHKeys.GetUAV());
+    Context.Dispatch1D(MaxLights, 64);
+
+    BitonicSort::Sort(Context, m_LightBVHKeys, m_LightBVHCount, 0, false, true);
+
+    // Write the leaves in sorted order, then merge each level into the one above it
+    Context.SetRootSignature(m_LightBVHRootSig);
+    Context.SetPipelineState(m_LightBVHLeavesCS);
+    Context.TransitionResource(m_LightBVHKeys, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+    Context.TransitionResource(m_LightBVH, D3D12_RESOURCE_STATE_UNORDERED_ACCESS, true);
+    Context.SetConstantArray(0, 10, &constants);
+    Context.SetDynamicDescriptor(1, 0, m_LightBuffer.GetSRV());
+    Context.SetDynamicDescriptor(1, 1, m_LightBVHKeys.GetSRV());
+    Context.SetDynamicDescriptor(2, 0, m_LightBVH.GetUAV());
+    Context.Dispatch1D(m_LightBVHLeafCount, 64);
+
+    Context.SetPipelineState(m_LightBVHNodesCS);
+    for (uint32_t nodeCount = m_LightBVHLeafCount / 2; nodeCount > 0; nodeCount /= 2)
+    {
+        Context.InsertUAVBarrier(m_LightBVH);
+        constants.FirstNode = nodeCount - 1;
+        constants.NodeCount = nodeCount;
+        Context.SetConstantArray(0, 10, &constants);
+        Context.Dispatch1D(nodeCount, 64);
+    }
+}
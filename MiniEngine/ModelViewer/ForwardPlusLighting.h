@@ -24,33 +24,65 @@ class ColorBuffer;
 class ShadowBuffer;
 class GraphicsContext;
 class IntVar;
+class BoolVar;
 namespace Math
 {
     class Vector3;
     class Matrix4;
     class Camera;
+    class Frustum;
 }
 
 namespace Lighting
 {
     extern IntVar LightGridDim;
 
+    // Cull lights into 3D clusters (screen tiles split into log-depth slices) instead of depth-bounded tiles
+    extern BoolVar EnableClusters;
+
+    // Build a BVH over the lights every frame and cull tiles or clusters by walking it
+    extern BoolVar EnableLightBVH;
+
     enum { MaxLights = 128 };
 
+    // keep in sync with LightGrid.hlsli
+    enum { ClusterTileDim = 64, ClusterSlices = 16 };
+
     //LightData m_LightData[MaxLights];
     extern StructuredBuffer m_LightBuffer;
     extern ByteAddressBuffer m_LightGrid;
 
     extern ByteAddressBuffer m_LightGridBitMask;
+    extern ByteAddressBuffer m_LightClusters;
+    extern ByteAddressBuffer m_LightClusterIndices;
     extern std::uint32_t m_FirstConeLight;
     extern std::uint32_t m_FirstConeShadowedLight;
 
     extern ColorBuffer m_LightShadowArray;
     extern ShadowBuffer m_LightShadowTempBuffer;
     extern Math::Matrix4 m_LightShadowMatrix[MaxLights];
+    extern Math::Frustum m_LightShadowFrustum[MaxLights];    // World space, for culling shadow casters
+
+    // Shadowed cone lights share MaxShadowSlices slices of m_LightShadowArray.  A light keeps its slice and its
+    // map until its shadow matrix changes or a dynamic caster enters its frustum.  Visible lights without a valid
+    // map take a free slice or the one least recently visible.  A light without a slice is unshadowed.
+    enum { MaxShadowSlices = 16, kNoShadowSlice = 0xFFFFFFFF };
+    extern IntVar ShadowUpdatesPerFrame;
+
+    // Choose up to ShadowUpdatesPerFrame lights whose maps must be rendered this frame, and write their indices
+    // and slices.  The caller must render every one of them.  Slice changes are uploaded to m_LightBuffer.
+    // dynamicCasterBounds holds the world space minimum and maximum of each caster that moves.
+    std::uint32_t UpdateShadowCache( GraphicsContext& gfxContext, const Math::Camera& camera,
+        const Math::Vector3* dynamicCasterBounds, std::uint32_t numDynamicCasters, std::uint32_t* lightIndices,
+        std::uint32_t* slices );
 
     void InitializeResources(void);
     void CreateRandomLights(const Math::Vector3 minBound, const Math::Vector3 maxBound);
+
+    // Recreate the light cluster buffers if the scene buffers were resized.  Call before the bindless tables
+    // are updated, once per frame.
+    void UpdateClusterBuffers(void);
+
     void FillLightGrid(GraphicsContext& gfxContext, const Math::Camera& camera);
     void Shutdown(void);
 }
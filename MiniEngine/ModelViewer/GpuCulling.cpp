@@ -0,0 +1,213 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Developed by Minigraph
+//
+
+#include "GpuCulling.h"
+#include "PipelineState.h"
+#include "RootSignature.h"
+#include "CommandSignature.h"
+#include "CommandContext.h"
+#include "CommandListManager.h"
+#include "GraphicsCore.h"
+#include "BufferManager.h"
+#include "HiZ.h"
+#include "ColorBuffer.h"
+#include "DepthBuffer.h"
+#include "GpuBuffer.h"
+#include "Camera.h"
+#include "Model.h"
+#include "EngineTuning.h"
+#include "EngineProfiling.h"
+
+#include "CompiledShaders/CullMeshesCS.h"
+
+using namespace Math;
+using namespace Graphics;
+
+// must keep in sync with HLSL
+struct MeshCullData
+{
+    float boundsMin[3];
+    uint32_t materialIndex;
+    float boundsMax[3];
+    uint32_t firstArgument;
+    uint32_t indexCount;
+    uint32_t startIndex;
+    uint32_t baseVertex;
+    uint32_t vertexFlags;
+    uint32_t lodCount;
+    uint32_t lodStartIndex[Model::kMaxLods - 1];
+    uint32_t lodIndexCount[Model::kMaxLods - 1];
+    float lodError[Model::kMaxLods - 1];
+    uint32_t pad[2];
+};
+static_assert(Model::kMaxLods == 4, "MeshCullData stores three levels of detail");
+
+// Eight root constants (see VertexDecode.hlsli) followed by D3D12_DRAW_INDEXED_ARGUMENTS
+enum { kDrawArgumentStride = 8 * sizeof(uint32_t) + sizeof(D3D12_DRAW_INDEXED_ARGUMENTS) };
+
+namespace GpuCulling
+{
+    BoolVar Enable("Application/GPU Culling/Enable", false);
+    BoolVar EnableOcclusion("Application/GPU Culling/Occlusion Culling", true);
+
+    RootSignature s_RootSig;
+    ComputePSO s_CullMeshesCS;
+    CommandSignature s_DrawSignature(2);
+
+    StructuredBuffer s_MeshData;
+    IndirectArgsBuffer s_DrawArguments;
+    ByteAddressBuffer s_DrawCounts;
+    uint32_t s_MeshCount = 0;
+    std::vector<uint32_t> s_MaterialFirstArgument;
+    std::vector<uint32_t> s_MaterialMeshCount;
+}
+
+void GpuCulling::Initialize( const Model& model, const RootSignature& DrawRootSig, uint32_t RootConstantsIndex )
+{
+    s_RootSig.Reset(3, 0);
+    s_RootSig[0].InitAsConstantBuffer(0);
+    s_RootSig[1].InitAsDescriptorRange(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 0, 2);
+    s_RootSig[2].InitAsDescriptorRange(D3D12_DESCRIPTOR_RANGE_TYPE_UAV, 0, 2);
+    s_RootSig.Finalize(L"GpuCullingRS");
+
+    s_CullMeshesCS.SetRootSignature(s_RootSig);
+    s_CullMeshesCS.SetComputeShader(g_pCullMeshesCS, sizeof(g_pCullMeshesCS));
+    s_CullMeshesCS.Finalize();
+
+    s_DrawSignature[0].Constant(RootConstantsIndex, 0, 8);
+    s_DrawSignature[1].DrawIndexed();
+    s_DrawSignature.Finalize(&DrawRootSig);
+
+    const uint32_t MaterialCount = model.m_Header.materialCount;
+    s_MeshCount = model.m_Header.meshCount;
+
+    // Reserve a run of draw arguments for each material, big enough for all of its meshes
+    s_MaterialMeshCount.assign(MaterialCount, 0);
+    for (uint32_t meshIndex = 0; meshIndex < s_MeshCount; ++meshIndex)
+        s_MaterialMeshCount[model.m_pMesh[meshIndex].materialIndex]++;
+
+    s_MaterialFirstArgument.resize(MaterialCount);
+    uint32_t NumArguments = 0;
+    for (uint32_t materialIdx = 0; materialIdx < MaterialCount; ++materialIdx)
+    {
+        s_MaterialFirstArgument[materialIdx] = NumArguments;
+        NumArguments += s_MaterialMeshCount[materialIdx];
+    }
+
+    std::vector<MeshCullData> MeshData(s_MeshCount);
+    for (uint32_t meshIndex = 0; meshIndex < s_MeshCount; ++meshIndex)
+    {
+        const Model::Mesh& mesh = model.m_pMesh[meshIndex];
+        MeshCullData& data = MeshData[meshIndex];
+
+        data.boundsMin[0] = mesh.boundingBox.min.GetX();
+        data.boundsMin[1] = mesh.boundingBox.min.GetY();
+        data.boundsMin[2] = mesh.boundingBox.min.GetZ();
+        data.materialIndex = mesh.materialIndex;
+        data.boundsMax[0] = mesh.boundingBox.max.GetX();
+        data.boundsMax[1] = mesh.boundingBox.max.GetY();
+        data.boundsMax[2] = mesh.boundingBox.max.GetZ();
+        data.firstArgument = s_MaterialFirstArgument[mesh.materialIndex];
+        data.indexCount = mesh.indexCount;
+        data.startIndex = mesh.indexDataByteOffset / sizeof(uint16_t);
+        data.baseVertex = mesh.vertexDataByteOffset / model.m_VertexStride;
+        data.vertexFlags = (model.HasQuantizedVertices() ? 1 : 0) | meshIndex << 16;
+
+        data.lodCount = model.m_LodCount;
+        for (uint32_t level = 0; level < Model::kMaxLods - 1; ++level)
+        {
+            const bool present = level < model.m_LodCount;
+            const Model::MeshLod* lod = present ? &model.m_pMeshLods[meshIndex * model.m_LodCount + level] : nullptr;
+            data.lodStartIndex[level] = present ? lod->indexDataByteOffset / sizeof(uint16_t) : 0;
+            data.lodIndexCount[level] = present ? lod->indexCount : 0;
+            data.lodError[level] = present ? lod->error : 0.0f;
+        }
+        data.pad[0] = data.pad[1] = 0;
+    }
+
+    s_MeshData.Create(L"GpuCulling::MeshData", s_MeshCount, sizeof(MeshCullData), MeshData.data());
+    s_DrawArguments.Create(L"GpuCulling::DrawArguments", NumArguments * kDrawArgumentStride / 4, 4);
+    s_DrawCounts.Create(L"GpuCulling::DrawCounts", MaterialCount, 4);
+}
+
+void GpuCulling::Shutdown( void )
+{
+    s_MeshData.Destroy();
+    s_DrawArguments.Destroy();
+    s_DrawCounts.Destroy();
+    s_DrawSignature.Destroy();
+}
+
+void GpuCulling::CullMeshes( ComputeContext& Context, const BaseCamera& camera, float LodScale, bool Stereo )
+{
+    ScopedTimer _prof(L"GPU Culling", Context);
+
+    __declspec(align(16)) struct
+    {
+        Vector4 FrustumPlanes[6];
+        Matrix4 HiZViewProj;
+        float HiZSize[2];
+        uint32_t HiZMipCount;
+        uint32_t MeshCount;
+        uint32_t EnableOcclusion;
+        float LodViewPos[3];
+        float LodScale;
+        uint32_t StereoFlags;
+    } csConstants;
+
+    const Frustum& ViewFrustum = camera.GetWorldSpaceFrustum();
+    for (int i = 0; i < 6; ++i)
+        csConstants.FrustumPlanes[i] = Vector4(ViewFrustum.GetFrustumPlane((Frustum::PlaneID)i));
+    csConstants.HiZViewProj = HiZ::GetViewProjMatrix();
+    csConstants.HiZSize[0] = (float)g_HiZMinDepth.GetWidth();
+    csConstants.HiZSize[1] = (float)g_HiZMinDepth.GetHeight();
+    csConstants.HiZMipCount = HiZ::ComputeMipCount(g_HiZMinDepth.GetWidth(), g_HiZMinDepth.GetHeight());
+    csConstants.MeshCount = s_MeshCount;
+    csConstants.EnableOcclusion = EnableOcclusion && HiZ::IsValid() && !Stereo ? 1 : 0;
+    csConstants.LodViewPos[0] = camera.GetPosition().GetX();
+    csConstants.LodViewPos[1] = camera.GetPosition().GetY();
+    csConstants.LodViewPos[2] = camera.GetPosition().GetZ();
+    csConstants.LodScale = LodScale;
+    csConstants.StereoFlags = Stereo ? 16 : 0; // VERTEX_FLAG_STEREO
+
+    Context.FillBuffer(s_DrawCounts, 0, 0u, s_DrawCounts.GetBufferSize());
+
+    Context.SetRootSignature(s_RootSig);
+    Context.SetPipelineState(s_CullMeshesCS);
+
+    Context.TransitionResource(s_MeshData, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+    Context.TransitionResource(s_DrawArguments, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+    Context.TransitionResource(s_DrawCounts, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+
+    Context.SetDynamicConstantBufferView(0, sizeof(csConstants), &csConstants);
+    Context.SetDynamicDescriptor(1, 0, s_MeshData.GetSRV());
+    Context.SetDynamicDescriptor(2, 0, s_DrawArguments.GetUAV());
+    Context.SetDynamicDescriptor(2, 1, s_DrawCounts.GetUAV());
+
+    // With reversed Z, the min pyramid holds the farthest depth under each texel
+    Context.TransitionResource(g_HiZMinDepth, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+    Context.SetDynamicDescriptor(1, 1, g_HiZMinDepth.GetSRV());
+
+    Context.Dispatch1D(s_MeshCount, 64);
+
+    Context.TransitionResource(s_DrawArguments, D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT);
+    Context.TransitionResource(s_DrawCounts, D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT);
+}
+
+void GpuCulling::DrawMaterial( GraphicsContext& Context, uint32_t MaterialIndex )
+{
+    const uint32_t MaxDraws = s_MaterialMeshCount[MaterialIndex];
+    if (MaxDraws == 0)
+        return;
+
+    Context.ExecuteIndirect(s_DrawSignature, s_DrawArguments, s_MaterialFirstArgument[MaterialIndex] * kDrawArgumentStride,
+        MaxDraws, &s_DrawCounts, MaterialIndex * sizeof(uint32_t));
+}
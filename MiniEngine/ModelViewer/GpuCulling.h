@@ -0,0 +1,48 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Developed by Minigraph
+//
+
+#pragma once
+
+#include <cstdint>
+
+class Model;
+class RootSignature;
+class ComputeContext;
+class GraphicsContext;
+class BoolVar;
+namespace Math
+{
+    class BaseCamera;
+}
+
+// Culls the meshes of a model on the GPU and compacts the survivors into indirect draw arguments.  Draws are
+// grouped by material, because the material descriptor table still has to be bound from the CPU, so every
+// material gets its own run of arguments and a draw count.  Meshes are tested against the view frustum and,
+// optionally, against the previous frame's depth pyramid (see HiZ.h in Core).
+namespace GpuCulling
+{
+    extern BoolVar Enable;
+    extern BoolVar EnableOcclusion;
+
+    // DrawRootSig must be the root signature used to render the model.  The command signature writes the
+    // eight per-draw root constants (vertex dequantization and material index) at RootConstantsIndex.
+    void Initialize( const Model& model, const RootSignature& DrawRootSig, uint32_t RootConstantsIndex );
+    void Shutdown( void );
+
+    // Cull every mesh against the camera.  The results are valid for all passes drawn from this view.  A
+    // positive LodScale also picks each mesh's level of detail (see ModelViewer::SelectLod).  Stereo draws
+    // every survivor once per eye (see VERTEX_FLAG_STEREO in VertexDecode.hlsli), and skips occlusion
+    // culling because the depth pyramid is built from one view.
+    void CullMeshes( ComputeContext& Context, const Math::BaseCamera& camera, float LodScale = 0.0f, bool Stereo = false );
+
+    // Draw the surviving meshes that use this material.  The caller binds the pass and material state.
+    void DrawMaterial( GraphicsContext& Context, uint32_t MaterialIndex );
+}
@@ -0,0 +1,196 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Developed by Minigraph
+//
+
+#include "InstancedScene.h"
+#include "Utility.h"
+#include <algorithm>
+#include <unordered_map>
+
+using namespace Math;
+using namespace DirectX;
+using namespace std;
+
+bool InstancedScene::Load( const wstring& FileName, bool QuantizedVertices )
+{
+    Clear();
+
+    FILE* SceneFile = nullptr;
+    _wfopen_s(&SceneFile, FileName.c_str(), L"rb");
+    if (SceneFile == nullptr)
+        return false;
+
+    unordered_map<string, uint32_t> ModelIndices;
+    vector<vector<InstanceTransform>> ModelInstances;
+
+    char Line[512];
+    while (fgets(Line, sizeof(Line), SceneFile) != nullptr)
+    {
+        if (Line[0] == '#')
+            continue;
+
+        char Name[128];
+        char Path[260];
+        float X, Y, Z;
+        float Yaw = 0.0f;
+        float Scale = 1.0f;
+
+        if (sscanf_s(Line, " model %127s %259s", Name, (unsigned)_countof(Name), Path, (unsigned)_countof(Path)) == 2)
+        {
+            if (ModelIndices.find(Name) != ModelIndices.end())
+            {
+                Utility::Printf("Scene model %s is listed twice\n", Name);
+                continue;
+            }
+
+            unique_ptr<Model> NewModel(new Model);
+            if (!NewModel->Load(Path) || NewModel->m_Header.meshCount == 0)
+            {
+                Utility::Printf("Failed to load scene model %s from %s\n", Name, Path);
+                continue;
+            }
+            if (NewModel->HasQuantizedVertices() != QuantizedVertices)
+            {
+                Utility::Printf("Scene model %s has a different vertex format than the main model\n", Name);
+                continue;
+            }
+
+            ModelIndices[Name] = (uint32_t)m_Models.size();
+            m_FirstMaterial.push_back(m_MaterialCount);
+            m_MaterialModel.resize(m_MaterialCount + NewModel->m_Header.materialCount, (uint32_t)m_Models.size());
+            m_MaterialCount += NewModel->m_Header.materialCount;
+            m_Models.push_back(move(NewModel));
+            ModelInstances.emplace_back();
+        }
+        else if (sscanf_s(Line, " instance %127s %f %f %f %f %f", Name, (unsigned)_countof(Name),
+            &X, &Y, &Z, &Yaw, &Scale) >= 4)
+        {
+            auto Iter = ModelIndices.find(Name);
+            if (Iter == ModelIndices.end())
+            {
+                Utility::Printf("Scene instance of unknown model %s\n", Name);
+                continue;
+            }
+
+            AffineTransform ObjectToWorld(Matrix3::MakeYRotation(XMConvertToRadians(Yaw)) * Matrix3::MakeScale(Scale),
+                Vector3(X, Y, Z));
+
+            // The rows of the transpose are the rows of the 3x4 matrix
+            XMMATRIX Rows = XMMatrixTranspose((XMMATRIX)ObjectToWorld);
+            InstanceTransform Instance;
+            XMStoreFloat4(&Instance.Rows[0], Rows.r[0]);
+            XMStoreFloat4(&Instance.Rows[1], Rows.r[1]);
+            XMStoreFloat4(&Instance.Rows[2], Rows.r[2]);
+            ModelInstances[Iter->second].push_back(Instance);
+        }
+    }
+
+    fclose(SceneFile);
+
+    // Every mesh of a model draws all of the model's instances
+    vector<InstanceTransform> Instances;
+    for (uint32_t ModelIndex = 0; ModelIndex < m_Models.size(); ++ModelIndex)
+    {
+        const vector<InstanceTransform>& Transforms = ModelInstances[ModelIndex];
+        m_FirstInstance.push_back((uint32_t)Instances.size());
+        if (Transforms.empty())
+            continue;
+
+        const Model& SceneModel = *m_Models[ModelIndex];
+        for (uint32_t MeshIndex = 0; MeshIndex < SceneModel.m_Header.meshCount; ++MeshIndex)
+        {
+            Batch NewBatch;
+            NewBatch.ModelIndex = ModelIndex;
+            NewBatch.MeshIndex = MeshIndex;
+            NewBatch.MaterialIndex = m_FirstMaterial[ModelIndex] + SceneModel.m_pMesh[MeshIndex].materialIndex;
+            NewBatch.FirstInstance = (uint32_t)Instances.size();
+            NewBatch.InstanceCount = (uint32_t)Transforms.size();
+            m_Batches.push_back(NewBatch);
+        }
+
+        Instances.insert(Instances.end(), Transforms.begin(), Transforms.end());
+    }
+    m_FirstInstance.push_back((uint32_t)Instances.size());
+
+    if (m_Batches.empty())
+        return false;
+
+    stable_sort(m_Batches.begin(), m_Batches.end(), []( const Batch& A, const Batch& B )
+    {
+        return A.MaterialIndex < B.MaterialIndex;
+    });
+
+    m_InstanceCount = (uint32_t)Instances.size();
+    m_InstanceBuffer.Create(L"Scene Instance Transforms", m_InstanceCount, sizeof(InstanceTransform), Instances.data());
+    m_Instances = move(Instances);
+
+    Utility::Printf("Loaded %u instances of %u models in %u batches\n", m_InstanceCount, (uint32_t)m_Models.size(),
+        (uint32_t)m_Batches.size());
+
+    return true;
+}
+
+void InstancedScene::Clear( void )
+{
+    for (auto& SceneModel : m_Models)
+        SceneModel->Clear();
+
+    m_Models.clear();
+    m_FirstInstance.clear();
+    m_Instances.clear();
+    m_TextureResolutions.clear();
+    m_FirstMaterial.clear();
+    m_MaterialModel.clear();
+    m_Batches.clear();
+    m_InstanceBuffer.Destroy();
+    m_MaterialCount = 0;
+    m_InstanceCount = 0;
+}
+
+const Model::Material& InstancedScene::GetMaterial( uint32_t MaterialIndex ) const
+{
+    const uint32_t ModelIndex = m_MaterialModel[MaterialIndex];
+    return m_Models[ModelIndex]->m_pMaterial[MaterialIndex - m_FirstMaterial[ModelIndex]];
+}
+
+const D3D12_CPU_DESCRIPTOR_HANDLE* InstancedScene::GetMaterialSRVs( uint32_t MaterialIndex ) const
+{
+    const uint32_t ModelIndex = m_MaterialModel[MaterialIndex];
+    return m_Models[ModelIndex]->GetSRVs(MaterialIndex - m_FirstMaterial[ModelIndex]);
+}
+
+void InstancedScene::UpdateTextureResidency( Vector3 ViewPos, float PixelsPerUnit )
+{
+    if (IsEmpty())
+        return;
+
+    m_TextureResolutions.assign(m_MaterialCount, 0);
+
+    for (uint32_t ModelIndex = 0; ModelIndex < m_Models.size(); ++ModelIndex)
+    {
+        uint32_t* Resolutions = m_TextureResolutions.data() + m_FirstMaterial[ModelIndex];
+
+        for (uint32_t i = m_FirstInstance[ModelIndex]; i < m_FirstInstance[ModelIndex + 1]; ++i)
+        {
+            const InstanceTransform& Instance = m_Instances[i];
+            Vector3 Row0(Instance.Rows[0].x, Instance.Rows[0].y, Instance.Rows[0].z);
+            Vector3 Row1(Instance.Rows[1].x, Instance.Rows[1].y, Instance.Rows[1].z);
+            Vector3 Row2(Instance.Rows[2].x, Instance.Rows[2].y, Instance.Rows[2].z);
+            Vector3 Offset = ViewPos - Vector3(Instance.Rows[0].w, Instance.Rows[1].w, Instance.Rows[2].w);
+
+            // The inverse of a rotation and uniform scale is its transpose over the scale squared.  Scaling the
+            // model scales distances to it just as much, so the pixel counts are the same in model space.
+            Vector3 LocalViewPos = (Row0 * Offset.GetX() + Row1 * Offset.GetY() + Row2 * Offset.GetZ()) / Dot(Row0, Row0);
+            m_Models[ModelIndex]->ComputeTextureResolutions(LocalViewPos, PixelsPerUnit, Resolutions);
+        }
+
+        m_Models[ModelIndex]->RequestTextureResolutions(Resolutions);
+    }
+}
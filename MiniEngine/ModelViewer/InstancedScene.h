@@ -0,0 +1,83 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Developed by Minigraph
+//
+
+#pragma once
+
+#include "Model.h"
+#include "GpuBuffer.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+// Many instances of a few models, listed in a text file:
+//
+//   # comment
+//   model <name> <path to .h3d>
+//   instance <name> <x> <y> <z> [<yaw in degrees> [<uniform scale>]]
+//
+// Each model's vertex and index buffers and materials are loaded once, however many instances it has.  The
+// transforms of a model's instances are contiguous in one structured buffer, and each mesh of each model is one
+// batch drawn with DrawIndexedInstanced, so the draw count scales with unique meshes rather than instances.
+// Batches are sorted by material, so consecutive batches of a material share its bindings.
+class InstancedScene
+{
+public:
+    // Must keep in sync with VertexDecode.hlsli.  The object-to-world matrix in rows, so that each component of
+    // the world position is one dot product.
+    struct InstanceTransform
+    {
+        DirectX::XMFLOAT4 Rows[3];
+    };
+
+    struct Batch
+    {
+        uint32_t ModelIndex;
+        uint32_t MeshIndex;
+        uint32_t MaterialIndex;     // Over all of the scene's materials
+        uint32_t FirstInstance;
+        uint32_t InstanceCount;
+    };
+
+    InstancedScene() : m_MaterialCount(0), m_InstanceCount(0) {}
+
+    // Models whose vertex format does not match QuantizedVertices can't use the same PSOs and are skipped
+    bool Load( const std::wstring& FileName, bool QuantizedVertices );
+    void Clear( void );
+
+    bool IsEmpty( void ) const { return m_Batches.empty(); }
+    uint32_t GetInstanceCount( void ) const { return m_InstanceCount; }
+
+    const Model& GetModel( uint32_t ModelIndex ) const { return *m_Models[ModelIndex]; }
+
+    uint32_t GetMaterialCount( void ) const { return m_MaterialCount; }
+    const Model::Material& GetMaterial( uint32_t MaterialIndex ) const;
+    // The six texture descriptors of the material, laid out like Model::GetSRVs()
+    const D3D12_CPU_DESCRIPTOR_HANDLE* GetMaterialSRVs( uint32_t MaterialIndex ) const;
+
+    const std::vector<Batch>& GetBatches( void ) const { return m_Batches; }
+    const StructuredBuffer& GetInstanceBuffer( void ) const { return m_InstanceBuffer; }
+
+    // Ask for the texture detail that the nearest instance of each model needs, like
+    // Model::ComputeTextureResolutions()
+    void UpdateTextureResidency( Vector3 ViewPos, float PixelsPerUnit );
+
+private:
+    std::vector<std::unique_ptr<Model>> m_Models;
+    std::vector<uint32_t> m_FirstInstance;      // Per model, plus the instance count at the end
+    std::vector<InstanceTransform> m_Instances;
+    std::vector<uint32_t> m_TextureResolutions; // Per material
+    std::vector<uint32_t> m_FirstMaterial;      // Per model
+    std::vector<uint32_t> m_MaterialModel;      // Per material
+    std::vector<Batch> m_Batches;
+    StructuredBuffer m_InstanceBuffer;
+    uint32_t m_MaterialCount;
+    uint32_t m_InstanceCount;
+};
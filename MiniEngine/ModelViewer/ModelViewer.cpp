@@ -18,14 +18,19 @@
 #include "BufferManager.h"
 #include "Camera.h"
 #include "Model.h"
+#include "VertexFormats.h"
+#include "Math/BatchTransform.h"
 #include "GpuBuffer.h"
 #include "CommandContext.h"
+#include "RootSignatureLayout.h"
 #include "SamplerManager.h"
 #include "TemporalEffects.h"
 #include "MotionBlur.h"
 #include "DepthOfField.h"
 #include "PostEffects.h"
 #include "SSAO.h"
+#include "HiZ.h"
+#include "MSAAResolve.h"
 #include "FXAA.h"
 #include "SystemTime.h"
 #include "TextRenderer.h"
@@ -33,6 +38,16 @@
 #include "ParticleEffectManager.h"
 #include "GameInput.h"
 #include "./ForwardPlusLighting.h"
+#include "./GpuCulling.h"
+#include "./OcclusionQueries.h"
+#include "./VisibilityBuffer.h"
+#include "./InstancedScene.h"
+#include "./Skinning.h"
+#include "JobSystem.h"
+#include "RenderQueue.h"
+#include "ShaderHotReload.h"
+#include "Benchmark.h"
+#include "LateLatch.h"
 
 // To enable wave intrinsics, uncomment this macro and #define DXIL in Core/GraphcisCore.cpp.
 // Run CompileSM6Test.bat to compile the relevant shaders with DXC.
@@ -42,12 +57,16 @@
 #include "CompiledShaders/DepthViewerPS.h"
 #include "CompiledShaders/ModelViewerVS.h"
 #include "CompiledShaders/ModelViewerPS.h"
+#include "CompiledShaders/ModelViewerClusteredPS.h"
 #ifdef _WAVE_OP
 #include "CompiledShaders/DepthViewerVS_SM6.h"
 #include "CompiledShaders/ModelViewerVS_SM6.h"
 #include "CompiledShaders/ModelViewerPS_SM6.h"
 #endif
 #include "CompiledShaders/WaveTileCountPS.h"
+#include "CompiledShaders/VisibilityVS.h"
+#include "CompiledShaders/VisibilityPS.h"
+#include "CompiledShaders/VisibilityCutoutPS.h"
 
 using namespace GameCore;
 using namespace Math;
@@ -57,27 +76,165 @@ class ModelViewer : public GameCore::IGameApp
 {
 public:
 
-    ModelViewer( void ) {}
+    ModelViewer( void ) : m_Stereo(false), m_BindlessHeap(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, 4096), m_LodScale(0.0f) {}
 
     virtual void Startup( void ) override;
     virtual void Cleanup( void ) override;
 
+    virtual bool IsDone( void ) override;
     virtual void Update( float deltaT ) override;
     virtual void RenderScene( void ) override;
 
 private:
 
     void RenderLightShadows(GraphicsContext& gfxContext);
+    void RenderSunShadowCascades(GraphicsContext& gfxContext);
+
+    // Set the default state for command lists
+    void SetupGraphicsState(GraphicsContext& Context);
+
+    // The skinned vertices when the model is skinned, which every pass draws in place of the model's own
+    const StructuredBuffer& GetModelVertexBuffer(void) const
+    {
+        return m_Model.IsSkinned() ? m_SkinnedModel.GetVertexBuffer() : m_Model.m_VertexBuffer;
+    }
+
+    // Bind the pass textures (SSAO, shadows, and lights) to root parameter 3 and the material textures to
+    // root parameter 2, either from the bindless tables or through the dynamic descriptor heap.
+    void SetPassTextures(GraphicsContext& Context);
+    void SetMaterialTextures(GraphicsContext& Context, uint32_t MaterialIdx);
+
+    // Materials of the instanced scene are numbered after the model's
+    const D3D12_CPU_DESCRIPTOR_HANDLE* GetMaterialSRVs(uint32_t MaterialIdx) const;
+
+    // Refresh the bindless tables when texture descriptors have been rewritten by streaming or a resize
+    void UpdateBindlessTables(void);
 
     enum eObjectFilter { kOpaque = 0x1, kCutout = 0x2, kTransparent = 0x4, kAll = 0xF, kNone = 0x0 };
-    void RenderObjects( GraphicsContext& Context, const Matrix4& ViewProjMat, eObjectFilter Filter = kAll );
+
+    __declspec(align(16)) struct VSConstants
+    {
+        Matrix4 modelToProjection;
+        Matrix4 modelToShadow;
+        XMFLOAT3 viewerPos;
+
+        // The right eye of stereo draws (see m_Stereo)
+        Matrix4 modelToProjectionRight;
+        XMFLOAT3 viewerPosRight;
+    };
+
+    // Per-draw root constants, must keep in sync with VertexDecode.hlsli
+    struct MeshConstants
+    {
+        XMFLOAT3 positionScale;
+        uint32_t vertexFlags;
+        XMFLOAT3 positionOffset;
+        uint32_t materialIndex;
+    };
+    void SetMeshConstants( MeshConstants& Constants, uint32_t MeshIndex, uint32_t LodLevel ) const;
+    enum { kVertexFlagInstanced = 0x8, kVertexFlagStereo = 0x10 };
+
+    enum { kVSConstants, kPSConstants, kMaterialSRVs, kPassSRVs, kMeshConstants, kInstanceSRV };
+    typedef RootLayout::Layout<
+        RootLayout::CBV<0, D3D12_SHADER_VISIBILITY_VERTEX>,
+        RootLayout::CBV<0, D3D12_SHADER_VISIBILITY_PIXEL>,
+        RootLayout::Table<D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 0, 6, D3D12_SHADER_VISIBILITY_PIXEL>,
+        RootLayout::Table<D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 64, 8, D3D12_SHADER_VISIBILITY_PIXEL>,
+        RootLayout::Constants<1, sizeof(MeshConstants) / 4, D3D12_SHADER_VISIBILITY_VERTEX>,
+        RootLayout::SRV<16, D3D12_SHADER_VISIBILITY_VERTEX>
+    > ModelRootLayout;
+    typedef RootBinder<ModelRootLayout> ModelRootBinder;
+
+    // Replace the index range with the mesh's coarsest level of detail whose error stays below the pixel
+    // error threshold from the main camera.  Shadow passes use the same level so that meshes shadow themselves.
+    // Returns the level, where 0 is the mesh itself.
+    uint32_t SelectLod( uint32_t MeshIndex, uint32_t& StartIndex, uint32_t& IndexCount ) const;
+
+    // Render the objects that pass the filter with the given PSO.  SetupPass must bind everything else the
+    // pass needs (render targets, viewport, constants, and descriptor tables) because it is also invoked on
+    // the contexts used for parallel recording, which start out with no state.  Predicated draws are skipped by
+    // the GPU when last frame's occlusion query found the mesh hidden, which is only valid for the main view.
+    // The instances of the scene are drawn last unless DrawInstances is false.  Meshes whose bit is clear in
+    // VisibilityMask are skipped, as in QueueObjects().
+    // VSConstantsCBV, when not zero, holds the view's constants in place of ones built from ViewProjMat.
+    void RenderObjects( GraphicsContext& Context, const Matrix4& ViewProjMat, eObjectFilter Filter,
+        const GraphicsPSO& PSO, const std::function<void(GraphicsContext&)>& SetupPass, bool Predicated = false,
+        bool DrawInstances = true, const uint32_t* VisibilityMask = nullptr, D3D12_GPU_VIRTUAL_ADDRESS VSConstantsCBV = 0 );
+
+    // Copy the constants of a view to upload memory on Context, so that every pass of the view binds one copy
+    D3D12_GPU_VIRTUAL_ADDRESS UploadVSConstants( GraphicsContext& Context, const VSConstants& vsConstants ) const;
+    // The main view's constants.  With LateLatchCamera, the view-projection matrix is written when the frame is
+    // submitted, with the mouse motion that arrived while it was recorded.
+    D3D12_GPU_VIRTUAL_ADDRESS ReserveMainViewConstants( GraphicsContext& Context );
+
+    // Compute the eyes' matrices, viewports and culling camera from m_Camera and m_MainViewport
+    void UpdateStereoViews( void );
+    // Whether draws with these view constants are drawn once per eye
+    bool IsStereoView( D3D12_GPU_VIRTUAL_ADDRESS VSConstantsCBV ) const
+    {
+        return m_Stereo && VSConstantsCBV == m_MainViewConstants;
+    }
+    // The main viewport and scissor, or one per eye with m_Stereo
+    void SetMainViewports( GraphicsContext& Context ) const;
+
+    // The state changes of the draws recorded on the CPU, shown as counters in the profiler overlay
+    struct DrawStats
+    {
+        uint32_t Draws;
+        uint32_t PSOChanges;
+        uint32_t MaterialChanges;
+
+        void Add( const DrawStats& Other )
+        {
+            Draws += Other.Draws;
+            PSOChanges += Other.PSOChanges;
+            MaterialChanges += Other.MaterialChanges;
+        }
+    };
+
+    // Queue the meshes that pass the filter, skipping those whose bit is clear in VisibilityMask (one bit per mesh,
+    // 32 per word).  Opaque meshes use PSO 0 and cutouts PSO 1 so that one queue can hold both.  The depth is the
+    // distance of the mesh center from DepthPlane, so sorting draws each material's meshes front to back.
+    void QueueObjects( RenderQueue& Queue, eObjectFilter Filter, const Vector4& DepthPlane,
+        const uint32_t* VisibilityMask = nullptr ) const;
+    // Record draws [First, Last) of a sorted queue.  PSOs is indexed by the PSO of the keys.  The PSO and the
+    // material textures are only bound where the key changes them.
+    void RecordQueue( GraphicsContext& Context, D3D12_GPU_VIRTUAL_ADDRESS VSConstantsCBV, const RenderQueue& Queue,
+        uint32_t First, uint32_t Last, const GraphicsPSO* const* PSOs, DrawStats& Stats, bool Predicated = false );
+    // RecordQueue() for a model whose meshes all use the VertexFormats::Format of Vertex
+    template <typename Vertex>
+    void RecordQueueOfFormat( GraphicsContext& Context, D3D12_GPU_VIRTUAL_ADDRESS VSConstantsCBV, const RenderQueue& Queue,
+        uint32_t First, uint32_t Last, const GraphicsPSO* const* PSOs, DrawStats& Stats, bool Predicated );
+    // One instanced draw per batch of the scene, which is neither culled nor predicated.  Rebinds the model's
+    // vertex and index buffers afterwards.
+    void RecordInstances( GraphicsContext& Context, D3D12_GPU_VIRTUAL_ADDRESS VSConstantsCBV, eObjectFilter Filter, DrawStats& Stats );
+    // Render the objects of the main view that survived GpuCulling::CullMeshes() with one ExecuteIndirect per
+    // material.  Falls back to predicated RenderObjects() when GPU culling is disabled.
+    void RenderCulledObjects( GraphicsContext& Context, eObjectFilter Filter, const GraphicsPSO& PSO,
+        const std::function<void(GraphicsContext&)>& SetupPass, bool DrawInstances = true );
     void CreateParticleEffects();
     Camera m_Camera;
     std::auto_ptr<CameraController> m_CameraController;
+
+    // F6 adds the current view to a camera path for benchmarking and F7 saves it to BenchmarkCameraPath.txt.
+    // Keys are timed by when they were added.
+    Benchmark::CameraPath m_RecordedPath;
+    float m_RecordedPathTime;
     Matrix4 m_ViewProjMatrix;
+    D3D12_GPU_VIRTUAL_ADDRESS m_MainViewConstants;
     D3D12_VIEWPORT m_MainViewport;
     D3D12_RECT m_MainScissor;
 
+    // With StereoRendering, the main view is drawn for two eyes side by side.  Its draws have two instances per
+    // instance and the vertex shader sends each to its eye's viewport, so the meshes are walked once for both.
+    bool m_Stereo;
+    Matrix4 m_EyeViewProj[2];
+    Vector3 m_EyePosition[2];
+    D3D12_VIEWPORT m_EyeViewports[2];
+    D3D12_RECT m_EyeScissors[2];
+    // Behind the eyes, with a frustum that contains both of theirs, so culling against it serves both
+    Camera m_StereoCullingCamera;
+
     RootSignature m_RootSig;
     GraphicsPSO m_DepthPSO;
     GraphicsPSO m_CutoutDepthPSO;
@@ -87,20 +244,73 @@ private:
     GraphicsPSO m_ModelWaveOpsPSO;
 #endif
     GraphicsPSO m_CutoutModelPSO;
+    GraphicsPSO m_ClusteredModelPSO;
+    GraphicsPSO m_ClusteredCutoutModelPSO;
     GraphicsPSO m_ShadowPSO;
     GraphicsPSO m_CutoutShadowPSO;
     GraphicsPSO m_WaveTileCountPSO;
+    GraphicsPSO m_VisibilityPSO;
+    GraphicsPSO m_CutoutVisibilityPSO;
+
+    // The forward passes for MSAAResolve::Enable, which render to the MSAA scene buffers
+    GraphicsPSO m_DepthMsaaPSO;
+    GraphicsPSO m_CutoutDepthMsaaPSO;
+    GraphicsPSO m_ModelMsaaPSO;
+    GraphicsPSO m_CutoutModelMsaaPSO;
+    GraphicsPSO m_ClusteredModelMsaaPSO;
+    GraphicsPSO m_ClusteredCutoutModelMsaaPSO;
+    GraphicsPSO m_WaveTileCountMsaaPSO;
 
     D3D12_CPU_DESCRIPTOR_HANDLE m_DefaultSampler;
     D3D12_CPU_DESCRIPTOR_HANDLE m_ShadowSampler;
     D3D12_CPU_DESCRIPTOR_HANDLE m_BiasedDefaultSampler;
 
-    D3D12_CPU_DESCRIPTOR_HANDLE m_ExtraTextures[6];
+    D3D12_CPU_DESCRIPTOR_HANDLE m_ExtraTextures[8];
+
+    // A persistent shader-visible copy of the pass textures followed by every material's textures, so that
+    // bindless passes set descriptor tables instead of copying descriptors whenever the material changes.
+    // The visibility buffer's shading descriptors come last.
+    // The tables are double buffered because refreshing them must not touch a copy the GPU may be reading.
+    UserDescriptorHeap m_BindlessHeap;
+    DescriptorHandle m_BindlessTables[2];
+    uint64_t m_BindlessFence[2];
+    uint32_t m_BindlessIndex;
+    uint32_t m_BindlessTextureVersion;
+    uint32_t m_BindlessSceneWidth;
+    uint32_t m_BindlessSceneHeight;
+
     Model m_Model;
     std::vector<bool> m_pMaterialIsCutout;
 
+    // Animates m_Model when it has a skeleton.  GPU culling and the visibility buffer still use the bind pose.
+    Skinning::Instance m_SkinnedModel;
+
+    // Loaded with -scene <file>.  The visibility buffer can only identify triangles of m_Model, so it leaves
+    // the scene out.
+    InstancedScene m_Scene;
+
+    RenderQueue m_RenderQueue;
+    RenderQueue m_CascadeQueues[CascadedShadowCamera::kMaxCascades];
+    DrawStats m_FrameStats;
+
+    // A level of detail is used when its error times m_LodScale is within its distance from m_LodViewPos
+    Vector3 m_LodViewPos;
+    float m_LodScale;
+
+    // Per material, the texture resolution that the model needs from the camera
+    std::vector<uint32_t> m_TextureResolutions;
+
+    // Mesh bounds in SoA form for batch culling against the shadow cascades
+    std::vector<float> m_MeshBounds[6];
+    BoundingBoxSOA m_MeshBoundsSOA;
+    std::vector<uint32_t> m_CascadeVisibility[CascadedShadowCamera::kMaxCascades];
+    // Casters whose shadows can reach the main view, and casters inside the spot light being rendered
+    std::vector<uint32_t> m_ReceiverVisibility;
+    std::vector<uint32_t> m_LightCasterVisibility;
+
     Vector3 m_SunDirection;
-    ShadowCamera m_SunShadow;
+    CascadedShadowCamera m_SunShadow;
+    ShadowBuffer m_SunShadowCascades;
 };
 
 CREATE_APPLICATION( ModelViewer )
@@ -109,48 +319,102 @@ ExpVar m_SunLightIntensity("Application/Lighting/Sun Light Intensity", 4.0f, 0.0
 ExpVar m_AmbientIntensity("Application/Lighting/Ambient Intensity", 0.1f, -16.0f, 16.0f, 0.1f);
 NumVar m_SunOrientation("Application/Lighting/Sun Orientation", -0.5f, -100.0f, 100.0f, 0.1f );
 NumVar m_SunInclination("Application/Lighting/Sun Inclination", 0.75f, 0.0f, 1.0f, 0.01f );
-NumVar ShadowDimX("Application/Lighting/Shadow Dim X", 5000, 1000, 10000, 100 );
-NumVar ShadowDimY("Application/Lighting/Shadow Dim Y", 3000, 1000, 10000, 100 );
-NumVar ShadowDimZ("Application/Lighting/Shadow Dim Z", 3000, 1000, 10000, 100 );
+IntVar ShadowCascadeCount("Application/Lighting/Shadow Cascades", 4, 1, CascadedShadowCamera::kMaxCascades );
+NumVar ShadowDistance("Application/Lighting/Shadow Distance", 3000, 500, 10000, 100 );
+NumVar ShadowSplitLambda("Application/Lighting/Cascade Split Lambda", 0.8f, 0.0f, 1.0f, 0.05f );
+NumVar ShadowCasterDistance("Application/Lighting/Shadow Caster Distance", 3000, 0, 10000, 100 );
+BoolVar ShadowReceiverCulling("Application/Lighting/Shadow Receiver Culling", true);
 
 BoolVar ShowWaveTileCounts("Application/Forward+/Show Wave Tile Counts", false);
+
+// Draws the main view for both eyes of a stereo pair, left and right halves of the scene buffers, with one pass over
+// the meshes.  The shadows are shared.  SSAO, the light grid, and the temporal effects still treat the scene
+// buffers as one view from the camera.  The visibility buffer only draws one view, so it disables stereo.
+BoolVar StereoRendering("Application/Stereo/Enable", false);
+NumVar StereoEyeSeparation("Application/Stereo/Eye Separation", 6.5f, 0.0f, 100.0f, 0.5f);
+
+// Splits the mesh list of each pass across worker threads, each recording into its own context.  The contexts
+// are submitted in order right behind the main context, so the frame renders exactly as before.
+BoolVar ParallelRecording("Application/Parallel Recording/Enable", false);
+
+// Let the scene context split its barriers from the previous frame's transitions (see DeferTransitions).  Off by
+// default, because it needs every pass to transition what it binds, and not every pass has been checked yet.
+BoolVar DeferredTransitions("Application/Deferred Transitions", false);
+
+// Draw the main view with the mouse look that arrived while the frame was recorded.  Everything else about the
+// frame, such as culling, the light grid, and TAA's reprojection, still uses the camera from Update(), which
+// only differs by that last rotation.  The visibility buffer reconstructs its triangles with that camera, so it
+// is never late latched.
+BoolVar LateLatchCamera("Timing/Low Latency/Late Latch Camera", true);
+
+BoolVar EnableLod("Application/LOD/Enable", true);
+NumVar LodPixelError("Application/LOD/Pixel Error", 1.0f, 0.25f, 16.0f, 0.25f);
+IntVar ParallelRecordingThreads("Application/Parallel Recording/Max Threads", 4, 2, 16);
+IntVar ParallelRecordingMinDraws("Application/Parallel Recording/Min Draws Per Thread", 64, 1, 1024, 16);
+
+// Material and pass textures are read from one persistent shader-visible heap
+BoolVar BindlessMaterials("Application/Bindless Materials", true);
 #ifdef _WAVE_OP
 BoolVar EnableWaveOps("Application/Forward+/Enable Wave Ops", true);
 #endif
 
+// The value that follows Name on the command line, if any
+static const wchar_t* FindCommandLineValue( const wchar_t* Name )
+{
+#if WINAPI_FAMILY_PARTITION(WINAPI_PARTITION_DESKTOP)
+    for (int i = 1; i + 1 < __argc; ++i)
+    {
+        if (_wcsicmp(__wargv[i], Name) == 0)
+            return __wargv[i + 1];
+    }
+#else
+    (Name);
+#endif
+    return nullptr;
+}
+
 void ModelViewer::Startup( void )
 {
     SamplerDesc DefaultSamplerDesc;
     DefaultSamplerDesc.MaxAnisotropy = 8;
 
-    m_RootSig.Reset(5, 2);
+    ModelRootLayout::Initialize(m_RootSig, 2);
     m_RootSig.InitStaticSampler(0, DefaultSamplerDesc, D3D12_SHADER_VISIBILITY_PIXEL);
     m_RootSig.InitStaticSampler(1, SamplerShadowDesc, D3D12_SHADER_VISIBILITY_PIXEL);
-    m_RootSig[0].InitAsConstantBuffer(0, D3D12_SHADER_VISIBILITY_VERTEX);
-    m_RootSig[1].InitAsConstantBuffer(0, D3D12_SHADER_VISIBILITY_PIXEL);
-    m_RootSig[2].InitAsDescriptorRange(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 0, 6, D3D12_SHADER_VISIBILITY_PIXEL);
-    m_RootSig[3].InitAsDescriptorRange(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 64, 6, D3D12_SHADER_VISIBILITY_PIXEL);
-    m_RootSig[4].InitAsConstants(1, 2, D3D12_SHADER_VISIBILITY_VERTEX);
     m_RootSig.Finalize(L"ModelViewer", D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT);
 
     DXGI_FORMAT ColorFormat = g_SceneColorBuffer.GetFormat();
     DXGI_FORMAT DepthFormat = g_SceneDepthBuffer.GetFormat();
 
-    D3D12_INPUT_ELEMENT_DESC vertElem[] =
-    {
-        { "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, D3D12_APPEND_ALIGNED_ELEMENT, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
-        { "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 0, D3D12_APPEND_ALIGNED_ELEMENT, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
-        { "NORMAL", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, D3D12_APPEND_ALIGNED_ELEMENT, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
-        { "TANGENT", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, D3D12_APPEND_ALIGNED_ELEMENT, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
-        { "BITANGENT", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, D3D12_APPEND_ALIGNED_ELEMENT, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 }
-    };
+    // The input layout depends on whether the model was converted with quantized vertices
+    TextureManager::Initialize(L"Textures/");
+    ASSERT(m_Model.Load("Models/sponza.h3d"), "Failed to load model");
+    ASSERT(m_Model.m_Header.meshCount > 0, "Model contains no meshes");
+
+    // e.g. ModelViewer.exe -mathbench 100000 prints the timings of the batch transform kernels
+    if (const wchar_t* BenchCount = FindCommandLineValue(L"-mathbench"))
+        Math::BenchmarkBatchTransforms((uint32_t)_wtoi(BenchCount));
+
+    // e.g. ModelViewer.exe -scene Scene.txt (see InstancedScene.h)
+    const wchar_t* SceneFile = FindCommandLineValue(L"-scene");
+    if (SceneFile != nullptr && !m_Scene.Load(SceneFile, m_Model.HasQuantizedVertices()))
+        Utility::Printf(L"Failed to load scene %s\n", SceneFile);
+
+    // RecordQueue() draws with the stride of the format, so every mesh must use it
+    using namespace VertexFormats;
+    ASSERT(m_Model.IsSkinned() ? ModelUsesFormat<SkinnedVertex>(m_Model) :
+        m_Model.HasQuantizedVertices() ? ModelUsesFormat<QuantizedVertex>(m_Model) : ModelUsesFormat<FloatVertex>(m_Model),
+        "Model vertices are in no known format");
+
+    const D3D12_INPUT_ELEMENT_DESC* vertElem = m_Model.IsSkinned() ? Format<SkinnedVertex>::InputLayout() :
+        m_Model.HasQuantizedVertices() ? Format<QuantizedVertex>::InputLayout() : Format<FloatVertex>::InputLayout();
 
     // Depth-only (2x rate)
     m_DepthPSO.SetRootSignature(m_RootSig);
     m_DepthPSO.SetRasterizerState(RasterizerDefault);
     m_DepthPSO.SetBlendState(BlendNoColorWrite);
     m_DepthPSO.SetDepthStencilState(DepthStateReadWrite);
-    m_DepthPSO.SetInputLayout(_countof(vertElem), vertElem);
+    m_DepthPSO.SetInputLayout(kInputElementCount, vertElem);
     m_DepthPSO.SetPrimitiveTopologyType(D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE);
     m_DepthPSO.SetRenderTargetFormats(0, nullptr, DepthFormat);
     m_DepthPSO.SetVertexShader(g_pDepthViewerVS, sizeof(g_pDepthViewerVS));
@@ -165,7 +429,9 @@ void ModelViewer::Startup( void )
     // Depth-only but with a depth bias and/or render only backfaces
     m_ShadowPSO = m_DepthPSO;
     m_ShadowPSO.SetRasterizerState(RasterizerShadow);
-    m_ShadowPSO.SetRenderTargetFormats(0, nullptr, g_ShadowBuffer.GetFormat());
+    m_SunShadowCascades.CreateArray(L"Sun Shadow Cascades", 2048, 2048, CascadedShadowCamera::kMaxCascades);
+
+    m_ShadowPSO.SetRenderTargetFormats(0, nullptr, m_SunShadowCascades.GetFormat());
     m_ShadowPSO.Finalize();
 
     // Shadows with alpha testing
@@ -184,50 +450,130 @@ void ModelViewer::Startup( void )
     m_ModelPSO.Finalize();
 
 #ifdef _WAVE_OP
+    // These are optional variants, so compile them in the background and draw with the standard
+    // shaders until they are ready.
     m_DepthWaveOpsPSO = m_DepthPSO;
     m_DepthWaveOpsPSO.SetVertexShader( g_pDepthViewerVS_SM6, sizeof(g_pDepthViewerVS_SM6) );
-    m_DepthWaveOpsPSO.Finalize();
+    m_DepthWaveOpsPSO.FinalizeAsync(&m_DepthPSO);
 
     m_ModelWaveOpsPSO = m_ModelPSO;
     m_ModelWaveOpsPSO.SetVertexShader( g_pModelViewerVS_SM6, sizeof(g_pModelViewerVS_SM6) );
     m_ModelWaveOpsPSO.SetPixelShader( g_pModelViewerPS_SM6, sizeof(g_pModelViewerPS_SM6) );
-    m_ModelWaveOpsPSO.Finalize();
+    m_ModelWaveOpsPSO.FinalizeAsync(&m_ModelPSO);
 #endif
 
     m_CutoutModelPSO = m_ModelPSO;
     m_CutoutModelPSO.SetRasterizerState(RasterizerTwoSided);
     m_CutoutModelPSO.Finalize();
 
+    // Edits to the main shaders are picked up while running when Shaders/Hot Reload is enabled
+    ShaderHotReload::Initialize({ L"Shaders" });
+    ShaderHotReload::Register(m_ModelPSO, ShaderHotReload::kVertex, L"ModelViewerVS.hlsl");
+    ShaderHotReload::Register(m_ModelPSO, ShaderHotReload::kPixel, L"ModelViewerPS.hlsl");
+    ShaderHotReload::Register(m_CutoutModelPSO, ShaderHotReload::kVertex, L"ModelViewerVS.hlsl");
+    ShaderHotReload::Register(m_CutoutModelPSO, ShaderHotReload::kPixel, L"ModelViewerPS.hlsl");
+
+    // Forward+ shading from the clustered light grid
+    m_ClusteredModelPSO = m_ModelPSO;
+    m_ClusteredModelPSO.SetPixelShader( g_pModelViewerClusteredPS, sizeof(g_pModelViewerClusteredPS) );
+    m_ClusteredModelPSO.Finalize();
+
+    m_ClusteredCutoutModelPSO = m_ClusteredModelPSO;
+    m_ClusteredCutoutModelPSO.SetRasterizerState(RasterizerTwoSided);
+    m_ClusteredCutoutModelPSO.Finalize();
+
     // A debug shader for counting lights in a tile
     m_WaveTileCountPSO = m_ModelPSO;
     m_WaveTileCountPSO.SetPixelShader(g_pWaveTileCountPS, sizeof(g_pWaveTileCountPS));
     m_WaveTileCountPSO.Finalize();
 
+    // The visibility buffer's geometry pass replaces the depth prepass
+    DXGI_FORMAT VisibilityFormat = DXGI_FORMAT_R32_UINT;
+    m_VisibilityPSO = m_DepthPSO;
+    m_VisibilityPSO.SetBlendState(BlendDisable);
+    m_VisibilityPSO.SetRenderTargetFormats(1, &VisibilityFormat, DepthFormat);
+    m_VisibilityPSO.SetVertexShader(g_pVisibilityVS, sizeof(g_pVisibilityVS));
+    m_VisibilityPSO.SetPixelShader(g_pVisibilityPS, sizeof(g_pVisibilityPS));
+    m_VisibilityPSO.Finalize();
+
+    m_CutoutVisibilityPSO = m_VisibilityPSO;
+    m_CutoutVisibilityPSO.SetPixelShader(g_pVisibilityCutoutPS, sizeof(g_pVisibilityCutoutPS));
+    m_CutoutVisibilityPSO.SetRasterizerState(RasterizerTwoSided);
+    m_CutoutVisibilityPSO.Finalize();
+
+    // Multisampled copies of the forward passes.  The wave op variants are left out.
+    const uint32_t MsaaCount = g_SceneColorBufferMSAA.GetFragmentCount();
+    auto CreateMsaaPSO = [&]( GraphicsPSO& MsaaPSO, const GraphicsPSO& PSO, uint32_t NumRTVs )
+    {
+        MsaaPSO = PSO;
+        MsaaPSO.SetRenderTargetFormats(NumRTVs, &ColorFormat, DepthFormat, MsaaCount);
+        MsaaPSO.Finalize();
+    };
+    CreateMsaaPSO(m_DepthMsaaPSO, m_DepthPSO, 0);
+    CreateMsaaPSO(m_CutoutDepthMsaaPSO, m_CutoutDepthPSO, 0);
+    CreateMsaaPSO(m_ModelMsaaPSO, m_ModelPSO, 1);
+    CreateMsaaPSO(m_CutoutModelMsaaPSO, m_CutoutModelPSO, 1);
+    CreateMsaaPSO(m_ClusteredModelMsaaPSO, m_ClusteredModelPSO, 1);
+    CreateMsaaPSO(m_ClusteredCutoutModelMsaaPSO, m_ClusteredCutoutModelPSO, 1);
+    CreateMsaaPSO(m_WaveTileCountMsaaPSO, m_WaveTileCountPSO, 1);
+
+    ShaderHotReload::Register(m_ModelMsaaPSO, ShaderHotReload::kVertex, L"ModelViewerVS.hlsl");
+    ShaderHotReload::Register(m_ModelMsaaPSO, ShaderHotReload::kPixel, L"ModelViewerPS.hlsl");
+    ShaderHotReload::Register(m_CutoutModelMsaaPSO, ShaderHotReload::kVertex, L"ModelViewerVS.hlsl");
+    ShaderHotReload::Register(m_CutoutModelMsaaPSO, ShaderHotReload::kPixel, L"ModelViewerPS.hlsl");
+
     Lighting::InitializeResources();
 
     m_ExtraTextures[0] = g_SSAOFullScreen.GetSRV();
-    m_ExtraTextures[1] = g_ShadowBuffer.GetSRV();
-
-    TextureManager::Initialize(L"Textures/");
-    ASSERT(m_Model.Load("Models/sponza.h3d"), "Failed to load model");
-    ASSERT(m_Model.m_Header.meshCount > 0, "Model contains no meshes");
+    m_ExtraTextures[1] = m_SunShadowCascades.GetSRV();
 
     // The caller of this function can override which materials are considered cutouts
-    m_pMaterialIsCutout.resize(m_Model.m_Header.materialCount);
-    for (uint32_t i = 0; i < m_Model.m_Header.materialCount; ++i)
+    auto IsCutout = []( const Model::Material& mat )
     {
-        const Model::Material& mat = m_Model.m_pMaterial[i];
-        if (std::string(mat.texDiffusePath).find("thorn") != std::string::npos ||
+        return std::string(mat.texDiffusePath).find("thorn") != std::string::npos ||
             std::string(mat.texDiffusePath).find("plant") != std::string::npos ||
-            std::string(mat.texDiffusePath).find("chain") != std::string::npos)
-        {
-            m_pMaterialIsCutout[i] = true;
-        }
-        else
-        {
-            m_pMaterialIsCutout[i] = false;
-        }
+            std::string(mat.texDiffusePath).find("chain") != std::string::npos;
+    };
+
+    const uint32_t ModelMaterialCount = m_Model.m_Header.materialCount;
+    m_pMaterialIsCutout.resize(ModelMaterialCount + m_Scene.GetMaterialCount());
+    for (uint32_t i = 0; i < ModelMaterialCount; ++i)
+        m_pMaterialIsCutout[i] = IsCutout(m_Model.m_pMaterial[i]);
+    for (uint32_t i = 0; i < m_Scene.GetMaterialCount(); ++i)
+        m_pMaterialIsCutout[ModelMaterialCount + i] = IsCutout(m_Scene.GetMaterial(i));
+
+    const uint32_t MeshCount = m_Model.m_Header.meshCount;
+    for (uint32_t i = 0; i < 6; ++i)
+        m_MeshBounds[i].resize(MeshCount);
+    for (uint32_t i = 0; i < MeshCount; ++i)
+    {
+        const Model::BoundingBox& bbox = m_Model.m_pMesh[i].boundingBox;
+        m_MeshBounds[0][i] = bbox.min.GetX();
+        m_MeshBounds[1][i] = bbox.min.GetY();
+        m_MeshBounds[2][i] = bbox.min.GetZ();
+        m_MeshBounds[3][i] = bbox.max.GetX();
+        m_MeshBounds[4][i] = bbox.max.GetY();
+        m_MeshBounds[5][i] = bbox.max.GetZ();
     }
+    m_MeshBoundsSOA.MinX = m_MeshBounds[0].data();
+    m_MeshBoundsSOA.MinY = m_MeshBounds[1].data();
+    m_MeshBoundsSOA.MinZ = m_MeshBounds[2].data();
+    m_MeshBoundsSOA.MaxX = m_MeshBounds[3].data();
+    m_MeshBoundsSOA.MaxY = m_MeshBounds[4].data();
+    m_MeshBoundsSOA.MaxZ = m_MeshBounds[5].data();
+    m_MeshBoundsSOA.Count = MeshCount;
+    for (uint32_t i = 0; i < CascadedShadowCamera::kMaxCascades; ++i)
+        m_CascadeVisibility[i].resize((MeshCount + 31) / 32);
+    m_ReceiverVisibility.resize((MeshCount + 31) / 32);
+    m_LightCasterVisibility.resize((MeshCount + 31) / 32);
+
+    GpuCulling::Initialize(m_Model, m_RootSig, kMeshConstants);
+    OcclusionQueries::Initialize(m_Model);
+    VisibilityBuffer::Initialize(m_Model);
+
+    Skinning::Initialize();
+    if (m_Model.IsSkinned())
+        m_SkinnedModel.Create(m_Model);
 
     CreateParticleEffects();
 
@@ -235,7 +581,14 @@ void ModelViewer::Startup( void )
     const Vector3 eye = (m_Model.m_Header.boundingBox.min + m_Model.m_Header.boundingBox.max) * .5f + Vector3(modelRadius * .5f, 0.0f, 0.0f);
     m_Camera.SetEyeAtUp( eye, Vector3(kZero), Vector3(kYUnitVector) );
     m_Camera.SetZRange( 1.0f, 10000.0f );
+    ASSERT(g_SceneDepthBuffer.GetClearDepth() == m_Camera.GetClearDepth(), "Depth clears must match the optimized clear value");
     m_CameraController.reset(new CameraController(m_Camera, Vector3(kYUnitVector)));
+    m_RecordedPathTime = 0.0f;
+
+    // e.g. ModelViewer.exe -benchmark Sponza.txt -warmup 100 -frames 1000 -results Benchmark.json
+    Benchmark::Settings BenchmarkSettings;
+    if (Benchmark::ParseCommandLine(BenchmarkSettings))
+        Benchmark::Start(BenchmarkSettings);
 
     MotionBlur::Enable = true;
     TemporalEffects::EnableTAA = true;
@@ -250,10 +603,32 @@ void ModelViewer::Startup( void )
     m_ExtraTextures[3] = Lighting::m_LightShadowArray.GetSRV();
     m_ExtraTextures[4] = Lighting::m_LightGrid.GetSRV();
     m_ExtraTextures[5] = Lighting::m_LightGridBitMask.GetSRV();
+    m_ExtraTextures[6] = Lighting::m_LightClusters.GetSRV();
+    m_ExtraTextures[7] = Lighting::m_LightClusterIndices.GetSRV();
+
+    const uint32_t BindlessTableSize = _countof(m_ExtraTextures) + (uint32_t)m_pMaterialIsCutout.size() * 6 +
+        VisibilityBuffer::kShadeDescriptorCount;
+    m_BindlessHeap.Create(L"ModelViewer Bindless Heap");
+    ASSERT(m_BindlessHeap.HasAvailableSpace(2 * BindlessTableSize), "Too many materials for the bindless heap");
+    m_BindlessTables[0] = m_BindlessHeap.Alloc(BindlessTableSize);
+    m_BindlessTables[1] = m_BindlessHeap.Alloc(BindlessTableSize);
+    m_BindlessFence[0] = 0;
+    m_BindlessFence[1] = 0;
+    m_BindlessIndex = 0;
+    m_BindlessTextureVersion = 0;
+    m_BindlessSceneWidth = 0;
+    m_BindlessSceneHeight = 0;
+    UpdateBindlessTables();
 }
 
 void ModelViewer::Cleanup( void )
 {
+    GpuCulling::Shutdown();
+    OcclusionQueries::Shutdown();
+    VisibilityBuffer::Shutdown();
+    m_SkinnedModel.Destroy();
+    m_SunShadowCascades.Destroy();
+    m_Scene.Clear();
     m_Model.Clear();
     Lighting::Shutdown();
 }
@@ -263,6 +638,11 @@ namespace Graphics
     extern EnumVar DebugZoom;
 }
 
+bool ModelViewer::IsDone( void )
+{
+    return Benchmark::IsFinished() || IGameApp::IsDone();
+}
+
 void ModelViewer::Update( float deltaT )
 {
     ScopedTimer _prof(L"Update State");
@@ -272,15 +652,52 @@ void ModelViewer::Update( float deltaT )
     else if (GameInput::IsFirstPressed(GameInput::kRShoulder))
         DebugZoom.Increment();
 
-    m_CameraController->Update(deltaT);
+    if (Benchmark::IsRunning())
+    {
+        Benchmark::Update(m_Camera);
+    }
+    else
+    {
+        m_CameraController->Update(deltaT);
+
+        if (m_RecordedPath.GetNumKeys() > 0)
+            m_RecordedPathTime += deltaT;
+
+        if (GameInput::IsFirstPressed(GameInput::kKey_f6))
+            m_RecordedPath.AddKey(m_RecordedPathTime, m_Camera);
+        else if (GameInput::IsFirstPressed(GameInput::kKey_f7) && m_RecordedPath.GetNumKeys() > 0)
+            m_RecordedPath.Save(L"BenchmarkCameraPath.txt");
+    }
     m_ViewProjMatrix = m_Camera.GetViewProjMatrix();
 
+    if (m_Model.IsSkinned())
+    {
+        m_SkinnedModel.SetClip((uint32_t)(int32_t)Skinning::Clip);
+        if (Skinning::Animate)
+            m_SkinnedModel.Advance(deltaT * Skinning::PlaybackRate);
+    }
+
+    // An error of one model unit at distance d covers Height / (2 * tan(FOV / 2) * d) pixels
+    m_LodViewPos = m_Camera.GetPosition();
+    m_LodScale = EnableLod ?
+        (float)g_SceneColorBuffer.GetHeight() / (2.0f * tanf(m_Camera.GetFOV() * 0.5f) * LodPixelError) : 0.0f;
+
+    // Stream in as much texture detail as the meshes cover pixels from here
+    const float PixelsPerUnit = (float)g_SceneColorBuffer.GetHeight() / (2.0f * tanf(m_Camera.GetFOV() * 0.5f));
+    m_TextureResolutions.assign(m_Model.m_Header.materialCount, 0);
+    m_Model.ComputeTextureResolutions(m_LodViewPos, PixelsPerUnit, m_TextureResolutions.data());
+    m_Model.RequestTextureResolutions(m_TextureResolutions.data());
+    m_Scene.UpdateTextureResidency(m_LodViewPos, PixelsPerUnit);
+
     float costheta = cosf(m_SunOrientation);
     float sintheta = sinf(m_SunOrientation);
     float cosphi = cosf(m_SunInclination * 3.14159f * 0.5f);
     float sinphi = sinf(m_SunInclination * 3.14159f * 0.5f);
     m_SunDirection = Normalize(Vector3( costheta * cosphi, sinphi, sintheta * cosphi ));
 
+    m_SunShadow.UpdateMatrices(m_Camera, -m_SunDirection, ShadowCascadeCount, ShadowDistance, ShadowSplitLambda,
+        ShadowCasterDistance, (uint32_t)m_SunShadowCascades.GetWidth(), (uint32_t)m_SunShadowCascades.GetHeight(), 16);
+
     // We use viewport offsets to jitter sample positions from frame to frame (for TAA.)
     // D3D has a design quirk with fractional offsets such that the implicit scissor
     // region of a viewport is floor(TopLeftXY) and floor(TopLeftXY + WidthHeight), so
@@ -300,48 +717,496 @@ void ModelViewer::Update( float deltaT )
     m_MainScissor.top = 0;
     m_MainScissor.right = (LONG)g_SceneColorBuffer.GetWidth();
     m_MainScissor.bottom = (LONG)g_SceneColorBuffer.GetHeight();
+
+    m_Stereo = StereoRendering && !VisibilityBuffer::Enable;
+    if (m_Stereo)
+        UpdateStereoViews();
 }
 
-void ModelViewer::RenderObjects( GraphicsContext& gfxContext, const Matrix4& ViewProjMat, eObjectFilter Filter )
+void ModelViewer::UpdateStereoViews( void )
 {
-    struct VSConstants
+    const float HalfWidth = m_MainViewport.Width * 0.5f;
+    const float EyeOffset = StereoEyeSeparation * 0.5f;
+
+    // The eyes look the same way as the camera, each with half its width
+    Camera EyeCamera = m_Camera;
+    EyeCamera.SetAspectRatio(m_MainViewport.Height / HalfWidth);
+
+    for (uint32_t Eye = 0; Eye < 2; ++Eye)
     {
-        Matrix4 modelToProjection;
-        Matrix4 modelToShadow;
-        XMFLOAT3 viewerPos;
-    } vsConstants;
-    vsConstants.modelToProjection = ViewProjMat;
-    vsConstants.modelToShadow = m_SunShadow.GetShadowMatrix();
+        const float Offset = Eye == 0 ? -EyeOffset : EyeOffset;
+        m_EyeViewProj[Eye] = EyeCamera.GetProjMatrix() * Matrix4(XMMatrixTranslation(-Offset, 0.0f, 0.0f)) *
+            m_Camera.GetViewMatrix();
+        m_EyePosition[Eye] = m_Camera.GetPosition() + m_Camera.GetRightVec() * Offset;
+
+        m_EyeViewports[Eye] = m_MainViewport;
+        m_EyeViewports[Eye].TopLeftX += HalfWidth * Eye;
+        m_EyeViewports[Eye].Width = HalfWidth;
+
+        m_EyeScissors[Eye] = m_MainScissor;
+        m_EyeScissors[Eye].left = Eye == 0 ? m_MainScissor.left : m_MainScissor.right / 2;
+        m_EyeScissors[Eye].right = Eye == 0 ? m_MainScissor.right / 2 : m_MainScissor.right;
+    }
+
+    // Backing up until the horizontal field of view spans both eyes' frusta.  The culling camera is never
+    // rendered with, so it stays in the render space of m_Camera.
+    const float TanHalfFovX = tanf(m_Camera.GetFOV() * 0.5f) * HalfWidth / m_MainViewport.Height;
+    const float Backoff = TanHalfFovX > 0.0f ? EyeOffset / TanHalfFovX : 0.0f;
+    m_StereoCullingCamera = EyeCamera;
+    m_StereoCullingCamera.SetCameraRelative(false);
+    m_StereoCullingCamera.SetPosition(m_Camera.GetPosition() - m_Camera.GetForwardVec() * Backoff);
+    m_StereoCullingCamera.SetZRange(m_Camera.GetNearClip() + Backoff, m_Camera.GetFarClip() + Backoff);
+    m_StereoCullingCamera.Update();
+}
+
+void ModelViewer::SetMainViewports( GraphicsContext& Context ) const
+{
+    if (m_Stereo)
+        Context.SetViewportsAndScissors(2, m_EyeViewports, m_EyeScissors);
+    else
+        Context.SetViewportAndScissor(m_MainViewport, m_MainScissor);
+}
+
+void ModelViewer::SetupGraphicsState( GraphicsContext& Context )
+{
+    Context.SetRootSignature(m_RootSig);
+    Context.SetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+    Context.SetIndexBuffer(m_Model.m_IndexBuffer.IndexBufferView());
+    Context.SetVertexBuffer(0, GetModelVertexBuffer().VertexBufferView());
+}
+
+void ModelViewer::SetPassTextures( GraphicsContext& Context )
+{
+    if (BindlessMaterials)
+    {
+        Context.SetDescriptorHeap(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, m_BindlessHeap.GetHeapPointer());
+        ModelRootBinder(Context).SetDescriptorTable<kPassSRVs>(m_BindlessTables[m_BindlessIndex].GetGpuHandle());
+    }
+    else
+    {
+        ModelRootBinder(Context).SetDynamicDescriptors<kPassSRVs>(0, _countof(m_ExtraTextures), m_ExtraTextures);
+    }
+}
+
+void ModelViewer::SetMaterialTextures( GraphicsContext& Context, uint32_t MaterialIdx )
+{
+    if (BindlessMaterials)
+    {
+        const uint32_t DescriptorSize = g_Device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+        DescriptorHandle Table = m_BindlessTables[m_BindlessIndex] + (_countof(m_ExtraTextures) + MaterialIdx * 6) * DescriptorSize;
+        Context.SetDescriptorHeap(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, m_BindlessHeap.GetHeapPointer());
+        ModelRootBinder(Context).SetDescriptorTable<kMaterialSRVs>(Table.GetGpuHandle());
+    }
+    else
+    {
+        ModelRootBinder(Context).SetDynamicDescriptors<kMaterialSRVs>(0, 6, GetMaterialSRVs(MaterialIdx));
+    }
+}
+
+const D3D12_CPU_DESCRIPTOR_HANDLE* ModelViewer::GetMaterialSRVs( uint32_t MaterialIdx ) const
+{
+    const uint32_t ModelMaterialCount = m_Model.m_Header.materialCount;
+    return MaterialIdx < ModelMaterialCount ? m_Model.GetSRVs(MaterialIdx) :
+        m_Scene.GetMaterialSRVs(MaterialIdx - ModelMaterialCount);
+}
+
+void ModelViewer::UpdateBindlessTables( void )
+{
+    // Streaming rewrites texture descriptors in place, and resizing recreates the SSAO buffer's views
+    if (m_BindlessTextureVersion == TextureManager::GetDescriptorVersion() &&
+        m_BindlessSceneWidth == g_SceneColorBuffer.GetWidth() && m_BindlessSceneHeight == g_SceneColorBuffer.GetHeight())
+        return;
+
+    m_BindlessTextureVersion = TextureManager::GetDescriptorVersion();
+    m_BindlessSceneWidth = g_SceneColorBuffer.GetWidth();
+    m_BindlessSceneHeight = g_SceneColorBuffer.GetHeight();
+
+    // Write the copy that isn't used by the last frame, once the frame before that has finished with it
+    const uint32_t NextIndex = m_BindlessIndex ^ 1;
+    g_CommandManager.WaitForFence(m_BindlessFence[NextIndex]);
+
+    const uint32_t DescriptorSize = g_Device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+    DescriptorHandle Dest = m_BindlessTables[NextIndex];
+
+    UINT NumExtra = _countof(m_ExtraTextures);
+    D3D12_CPU_DESCRIPTOR_HANDLE DestHandle = Dest.GetCpuHandle();
+    g_Device->CopyDescriptors(1, &DestHandle, &NumExtra, NumExtra, m_ExtraTextures, nullptr,
+        D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+
+    UINT NumMaterial = m_Model.m_Header.materialCount * 6;
+    DestHandle = (Dest + NumExtra * DescriptorSize).GetCpuHandle();
+    g_Device->CopyDescriptors(1, &DestHandle, &NumMaterial, NumMaterial, m_Model.GetSRVs(0), nullptr,
+        D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+
+    // The scene's descriptors belong to several models, so they are copied one material at a time
+    for (uint32_t i = 0; i < m_Scene.GetMaterialCount(); ++i)
+    {
+        UINT NumTextures = 6;
+        DestHandle = (Dest + (NumExtra + NumMaterial + i * 6) * DescriptorSize).GetCpuHandle();
+        g_Device->CopyDescriptors(1, &DestHandle, &NumTextures, NumTextures, m_Scene.GetMaterialSRVs(i), nullptr,
+            D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+    }
+    NumMaterial += m_Scene.GetMaterialCount() * 6;
+
+    D3D12_CPU_DESCRIPTOR_HANDLE ShadeDescriptors[VisibilityBuffer::kShadeDescriptorCount];
+    VisibilityBuffer::GetShadeDescriptors(ShadeDescriptors);
+    UINT NumShade = _countof(ShadeDescriptors);
+    DestHandle = (Dest + (NumExtra + NumMaterial) * DescriptorSize).GetCpuHandle();
+    g_Device->CopyDescriptors(1, &DestHandle, &NumShade, NumShade, ShadeDescriptors, nullptr,
+        D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+
+    m_BindlessIndex = NextIndex;
+}
+
+void ModelViewer::RenderObjects( GraphicsContext& gfxContext, const Matrix4& ViewProjMat, eObjectFilter Filter,
+    const GraphicsPSO& PSO, const std::function<void(GraphicsContext&)>& SetupPass, bool Predicated, bool DrawInstances,
+    const uint32_t* VisibilityMask, D3D12_GPU_VIRTUAL_ADDRESS VSConstantsCBV )
+{
+    if (VSConstantsCBV == 0)
+    {
+        VSConstants vsConstants;
+        vsConstants.modelToProjection = ViewProjMat;
+        vsConstants.modelToShadow = m_SunShadow.GetCascade(0).GetShadowMatrix();
+        XMStoreFloat3(&vsConstants.viewerPos, m_Camera.GetPosition());
+        vsConstants.modelToProjectionRight = vsConstants.modelToProjection;
+        vsConstants.viewerPosRight = vsConstants.viewerPos;
+        VSConstantsCBV = UploadVSConstants(gfxContext, vsConstants);
+    }
+
+    // Clip space W is the view depth of a perspective projection
+    m_RenderQueue.Clear();
+    QueueObjects(m_RenderQueue, Filter, Transpose(ViewProjMat).GetW(), VisibilityMask);
+    m_RenderQueue.Sort();
+
+    const uint32_t DrawCount = m_RenderQueue.GetCount();
+    const GraphicsPSO* PSOs[] = { &PSO, &PSO };
+
+    uint32_t NumContexts = 1;
+    if (ParallelRecording)
+        NumContexts = std::min<uint32_t>(ParallelRecordingThreads, DrawCount / ParallelRecordingMinDraws);
+
+    if (NumContexts <= 1)
+    {
+        SetupPass(gfxContext);
+        gfxContext.SetPipelineState(PSO);
+        RecordQueue(gfxContext, VSConstantsCBV, m_RenderQueue, 0, DrawCount, PSOs, m_FrameStats, Predicated);
+        if (DrawInstances)
+            RecordInstances(gfxContext, VSConstantsCBV, Filter, m_FrameStats);
+        return;
+    }
+
+    // Contexts are acquired up front so that they can be submitted in mesh order.  They track resource
+    // states locally so that recording never touches the global states.
+    CommandContext* Contexts[16];
+    for (uint32_t i = 0; i < NumContexts; ++i)
+    {
+        Contexts[i] = &GraphicsContext::Begin();
+        Contexts[i]->TrackStatesLocally();
+    }
+
+    // Each context records a contiguous run of the sorted draws
+    DrawStats ContextStats[16] = {};
+    JobSystem::ParallelFor(0u, NumContexts, 1, [&](uint32_t i)
+    {
+        GraphicsContext& Context = Contexts[i]->GetGraphicsContext();
+        SetupPass(Context);
+        Context.SetPipelineState(PSO);
+        RecordQueue(Context, VSConstantsCBV, m_RenderQueue, DrawCount * i / NumContexts, DrawCount * (i + 1) / NumContexts,
+            PSOs, ContextStats[i], Predicated);
+    });
+
+    gfxContext.FlushAndJoin(Contexts, NumContexts);
+
+    for (uint32_t i = 0; i < NumContexts; ++i)
+        m_FrameStats.Add(ContextStats[i]);
+
+    // Flushing lost the pass state, so restore it in case the caller continues to draw
+    SetupPass(gfxContext);
+    gfxContext.SetPipelineState(PSO);
+
+    if (DrawInstances)
+        RecordInstances(gfxContext, VSConstantsCBV, Filter, m_FrameStats);
+}
+
+D3D12_GPU_VIRTUAL_ADDRESS ModelViewer::UploadVSConstants( GraphicsContext& Context, const VSConstants& vsConstants ) const
+{
+    DynAlloc Alloc = Context.ReserveUploadMemory(sizeof(VSConstants));
+    memcpy(Alloc.DataPtr, &vsConstants, sizeof(VSConstants));
+    return Alloc.GpuAddress;
+}
+
+D3D12_GPU_VIRTUAL_ADDRESS ModelViewer::ReserveMainViewConstants( GraphicsContext& Context )
+{
+    VSConstants vsConstants;
+    vsConstants.modelToProjection = m_ViewProjMatrix;
+    vsConstants.modelToShadow = m_SunShadow.GetCascade(0).GetShadowMatrix();
     XMStoreFloat3(&vsConstants.viewerPos, m_Camera.GetPosition());
+    vsConstants.modelToProjectionRight = vsConstants.modelToProjection;
+    vsConstants.viewerPosRight = vsConstants.viewerPos;
 
-    gfxContext.SetDynamicConstantBufferView(0, sizeof(vsConstants), &vsConstants);
+    // Both eyes in one buffer.  The latched matrix is the camera's, so stereo is not late latched.
+    if (m_Stereo)
+    {
+        vsConstants.modelToProjection = m_EyeViewProj[0];
+        vsConstants.modelToProjectionRight = m_EyeViewProj[1];
+        XMStoreFloat3(&vsConstants.viewerPos, m_EyePosition[0]);
+        XMStoreFloat3(&vsConstants.viewerPosRight, m_EyePosition[1]);
+        return UploadVSConstants(Context, vsConstants);
+    }
 
-    uint32_t materialIdx = 0xFFFFFFFFul;
+    if (!LateLatchCamera || VisibilityBuffer::Enable || Benchmark::IsRunning())
+        return UploadVSConstants(Context, vsConstants);
+
+    // Only the orientation changes, so the viewer position and the shadow matrix are already final
+    const CameraController& Controller = *m_CameraController;
+    return LateLatch::Reserve(Context, sizeof(VSConstants), [vsConstants, &Controller](void* Dest) mutable
+    {
+        vsConstants.modelToProjection = Controller.GetLateLatchedViewProj();
+        memcpy(Dest, &vsConstants, sizeof(VSConstants));
+    });
+}
+
+void ModelViewer::SetMeshConstants( MeshConstants& Constants, uint32_t MeshIndex, uint32_t LodLevel ) const
+{
+    const Model::Mesh& Mesh = m_Model.m_pMesh[MeshIndex];
+
+    // Quantized positions are UNORM relative to the mesh bounding box
+    if (m_Model.HasQuantizedVertices())
+    {
+        XMStoreFloat3(&Constants.positionScale, Mesh.boundingBox.max - Mesh.boundingBox.min);
+        XMStoreFloat3(&Constants.positionOffset, Mesh.boundingBox.min);
+        Constants.vertexFlags = 1;
+    }
+    else
+    {
+        Constants.positionScale = XMFLOAT3(1.0f, 1.0f, 1.0f);
+        Constants.positionOffset = XMFLOAT3(0.0f, 0.0f, 0.0f);
+        Constants.vertexFlags = 0;
+    }
+    Constants.vertexFlags |= LodLevel << 1 | MeshIndex << 16;
+    Constants.materialIndex = Mesh.materialIndex;
+}
+
+uint32_t ModelViewer::SelectLod( uint32_t MeshIndex, uint32_t& StartIndex, uint32_t& IndexCount ) const
+{
+    if (m_LodScale <= 0.0f || m_Model.m_LodCount == 0)
+        return 0;
+
+    // The distance to the nearest point of the bounding box, zero inside it
+    const Model::BoundingBox& Bounds = m_Model.m_pMesh[MeshIndex].boundingBox;
+    float Distance = Length(Max(Max(Bounds.min - m_LodViewPos, m_LodViewPos - Bounds.max), Vector3(kZero)));
+
+    uint32_t Level = 0;
+    for (; Level < m_Model.m_LodCount; ++Level)
+    {
+        const Model::MeshLod& Lod = m_Model.m_pMeshLods[MeshIndex * m_Model.m_LodCount + Level];
+        if (Lod.error * m_LodScale > Distance)
+            break;
+        StartIndex = Lod.indexDataByteOffset / sizeof(uint16_t);
+        IndexCount = Lod.indexCount;
+    }
+    return Level;
+}
 
-    uint32_t VertexStride = m_Model.m_VertexStride;
+void ModelViewer::QueueObjects( RenderQueue& Queue, eObjectFilter Filter, const Vector4& DepthPlane,
+    const uint32_t* VisibilityMask ) const
+{
+    const float PlaneX = DepthPlane.GetX();
+    const float PlaneY = DepthPlane.GetY();
+    const float PlaneZ = DepthPlane.GetZ();
+    const float PlaneW = DepthPlane.GetW();
 
     for (uint32_t meshIndex = 0; meshIndex < m_Model.m_Header.meshCount; meshIndex++)
     {
+        if (VisibilityMask != nullptr && (VisibilityMask[meshIndex / 32] & (1u << (meshIndex % 32))) == 0)
+            continue;
+
+        const uint32_t materialIdx = m_Model.m_pMesh[meshIndex].materialIndex;
+        const bool isCutout = m_pMaterialIsCutout[materialIdx];
+        if (!(Filter & (isCutout ? kCutout : kOpaque)))
+            continue;
+
+        const float depth = 0.5f * (PlaneX * (m_MeshBounds[0][meshIndex] + m_MeshBounds[3][meshIndex]) +
+            PlaneY * (m_MeshBounds[1][meshIndex] + m_MeshBounds[4][meshIndex]) +
+            PlaneZ * (m_MeshBounds[2][meshIndex] + m_MeshBounds[5][meshIndex])) + PlaneW;
+
+        Queue.Add(RenderQueue::MakeKey(0, isCutout ? 1 : 0, materialIdx, depth), meshIndex);
+    }
+}
+
+template <typename Vertex>
+void ModelViewer::RecordQueueOfFormat( GraphicsContext& gfxContext, D3D12_GPU_VIRTUAL_ADDRESS VSConstantsCBV, const RenderQueue& Queue,
+    uint32_t First, uint32_t Last, const GraphicsPSO* const* PSOs, DrawStats& Stats, bool Predicated )
+{
+    ModelRootBinder Binder(gfxContext);
+    Binder.SetConstantBuffer<kVSConstants>(VSConstantsCBV);
+
+    uint32_t psoIdx = 0xFFFFFFFFul;
+    uint32_t materialIdx = 0xFFFFFFFFul;
+
+    // A constant, so the division below is a multiply
+    const uint32_t VertexStride = sizeof(Vertex);
+
+    const bool Stereo = IsStereoView(VSConstantsCBV);
+
+    uint32_t CurrentQuery = OcclusionQueries::kNoQuery;
+
+    for (uint32_t i = First; i < Last; i++)
+    {
+        const uint64_t key = Queue.GetKey(i);
+        const uint32_t meshIndex = Queue.GetPayload(i);
         const Model::Mesh& mesh = m_Model.m_pMesh[meshIndex];
 
         uint32_t indexCount = mesh.indexCount;
         uint32_t startIndex = mesh.indexDataByteOffset / sizeof(uint16_t);
         uint32_t baseVertex = mesh.vertexDataByteOffset / VertexStride;
+        uint32_t lodLevel = SelectLod(meshIndex, startIndex, indexCount);
 
-        if (mesh.materialIndex != materialIdx)
+        if (RenderQueue::GetPSO(key) != psoIdx)
         {
-            if ( m_pMaterialIsCutout[mesh.materialIndex] && !(Filter & kCutout) ||
-                !m_pMaterialIsCutout[mesh.materialIndex] && !(Filter & kOpaque) )
-                continue;
+            psoIdx = RenderQueue::GetPSO(key);
+            gfxContext.SetPipelineState(*PSOs[psoIdx]);
+            ++Stats.PSOChanges;
+        }
 
-            materialIdx = mesh.materialIndex;
-            gfxContext.SetDynamicDescriptors(2, 0, 6, m_Model.GetSRVs(materialIdx) );
+        if (RenderQueue::GetMaterial(key) != materialIdx)
+        {
+            materialIdx = RenderQueue::GetMaterial(key);
+            SetMaterialTextures(gfxContext, materialIdx);
+            ++Stats.MaterialChanges;
         }
 
-        gfxContext.SetConstants(4, baseVertex, materialIdx);
+        MeshConstants meshConstants;
+        SetMeshConstants(meshConstants, meshIndex, lodLevel);
+        if (Stereo)
+            meshConstants.vertexFlags |= kVertexFlagStereo;
+        Binder.SetConstants<kMeshConstants>(meshConstants);
+
+        if (Predicated)
+            OcclusionQueries::PredicateMesh(gfxContext, meshIndex, CurrentQuery);
 
-        gfxContext.DrawIndexed(indexCount, startIndex, baseVertex);
+        if (Stereo)
+            gfxContext.DrawIndexedInstanced(indexCount, 2, startIndex, baseVertex, 0);
+        else
+            gfxContext.DrawIndexed(indexCount, startIndex, baseVertex);
+        ++Stats.Draws;
     }
+
+    // Predication would also apply to later clears and copies on this context
+    OcclusionQueries::EndPredication(gfxContext, CurrentQuery);
+}
+
+void ModelViewer::RecordQueue( GraphicsContext& gfxContext, D3D12_GPU_VIRTUAL_ADDRESS VSConstantsCBV, const RenderQueue& Queue,
+    uint32_t First, uint32_t Last, const GraphicsPSO* const* PSOs, DrawStats& Stats, bool Predicated )
+{
+    if (m_Model.IsSkinned())
+        RecordQueueOfFormat<VertexFormats::SkinnedVertex>(gfxContext, VSConstantsCBV, Queue, First, Last, PSOs, Stats, Predicated);
+    else if (m_Model.HasQuantizedVertices())
+        RecordQueueOfFormat<VertexFormats::QuantizedVertex>(gfxContext, VSConstantsCBV, Queue, First, Last, PSOs, Stats, Predicated);
+    else
+        RecordQueueOfFormat<VertexFormats::FloatVertex>(gfxContext, VSConstantsCBV, Queue, First, Last, PSOs, Stats, Predicated);
+}
+
+void ModelViewer::RecordInstances( GraphicsContext& gfxContext, D3D12_GPU_VIRTUAL_ADDRESS VSConstantsCBV, eObjectFilter Filter,
+    DrawStats& Stats )
+{
+    if (m_Scene.IsEmpty())
+        return;
+
+    ModelRootBinder Binder(gfxContext);
+    Binder.SetConstantBuffer<kVSConstants>(VSConstantsCBV);
+
+    const uint32_t ModelMaterialCount = m_Model.m_Header.materialCount;
+    const bool Stereo = IsStereoView(VSConstantsCBV);
+    uint32_t modelIdx = 0xFFFFFFFFul;
+    uint32_t materialIdx = 0xFFFFFFFFul;
+
+    for (const InstancedScene::Batch& batch : m_Scene.GetBatches())
+    {
+        const uint32_t batchMaterialIdx = ModelMaterialCount + batch.MaterialIndex;
+        if ( m_pMaterialIsCutout[batchMaterialIdx] && !(Filter & kCutout) ||
+            !m_pMaterialIsCutout[batchMaterialIdx] && !(Filter & kOpaque) )
+            continue;
+
+        const Model& sceneModel = m_Scene.GetModel(batch.ModelIndex);
+        if (batch.ModelIndex != modelIdx)
+        {
+            modelIdx = batch.ModelIndex;
+            gfxContext.SetIndexBuffer(sceneModel.m_IndexBuffer.IndexBufferView());
+            gfxContext.SetVertexBuffer(0, sceneModel.m_VertexBuffer.VertexBufferView());
+        }
+
+        if (batchMaterialIdx != materialIdx)
+        {
+            materialIdx = batchMaterialIdx;
+            SetMaterialTextures(gfxContext, materialIdx);
+            ++Stats.MaterialChanges;
+        }
+
+        const Model::Mesh& mesh = sceneModel.m_pMesh[batch.MeshIndex];
+
+        MeshConstants meshConstants;
+        if (sceneModel.HasQuantizedVertices())
+        {
+            XMStoreFloat3(&meshConstants.positionScale, mesh.boundingBox.max - mesh.boundingBox.min);
+            XMStoreFloat3(&meshConstants.positionOffset, mesh.boundingBox.min);
+            meshConstants.vertexFlags = 1 | kVertexFlagInstanced;
+        }
+        else
+        {
+            meshConstants.positionScale = XMFLOAT3(1.0f, 1.0f, 1.0f);
+            meshConstants.positionOffset = XMFLOAT3(0.0f, 0.0f, 0.0f);
+            meshConstants.vertexFlags = kVertexFlagInstanced;
+        }
+        meshConstants.materialIndex = materialIdx;
+        if (Stereo)
+            meshConstants.vertexFlags |= kVertexFlagStereo;
+        Binder.SetConstants<kMeshConstants>(meshConstants);
+
+        // SV_InstanceID starts at zero in every draw, so the SRV starts at the batch's first instance
+        Binder.SetBufferSRV<kInstanceSRV>(m_Scene.GetInstanceBuffer(),
+            batch.FirstInstance * sizeof(InstancedScene::InstanceTransform));
+
+        gfxContext.DrawIndexedInstanced(mesh.indexCount, batch.InstanceCount * (Stereo ? 2 : 1), mesh.indexDataByteOffset / sizeof(uint16_t),
+            mesh.vertexDataByteOffset / sceneModel.m_VertexStride, 0);
+        ++Stats.Draws;
+    }
+
+    if (modelIdx != 0xFFFFFFFFul)
+    {
+        gfxContext.SetIndexBuffer(m_Model.m_IndexBuffer.IndexBufferView());
+        gfxContext.SetVertexBuffer(0, GetModelVertexBuffer().VertexBufferView());
+    }
+}
+
+void ModelViewer::RenderCulledObjects( GraphicsContext& gfxContext, eObjectFilter Filter, const GraphicsPSO& PSO,
+    const std::function<void(GraphicsContext&)>& SetupPass, bool DrawInstances )
+{
+    // The occlusion queries are drawn from the camera, which neither eye sees from
+    if (!GpuCulling::Enable)
+    {
+        RenderObjects(gfxContext, m_ViewProjMatrix, Filter, PSO, SetupPass, !m_Stereo, DrawInstances, nullptr, m_MainViewConstants);
+        return;
+    }
+
+    SetupPass(gfxContext);
+    gfxContext.SetPipelineState(PSO);
+    ModelRootBinder(gfxContext).SetConstantBuffer<kVSConstants>(m_MainViewConstants);
+
+    for (uint32_t materialIdx = 0; materialIdx < m_Model.m_Header.materialCount; ++materialIdx)
+    {
+        if ( m_pMaterialIsCutout[materialIdx] && !(Filter & kCutout) ||
+            !m_pMaterialIsCutout[materialIdx] && !(Filter & kOpaque) )
+            continue;
+
+        SetMaterialTextures(gfxContext, materialIdx);
+        GpuCulling::DrawMaterial(gfxContext, materialIdx);
+        ++m_FrameStats.MaterialChanges;
+    }
+    ++m_FrameStats.PSOChanges;
+
+    if (DrawInstances)
+        RecordInstances(gfxContext, m_MainViewConstants, Filter, m_FrameStats);
 }
 
 void ModelViewer::RenderLightShadows(GraphicsContext& gfxContext)
@@ -350,27 +1215,137 @@ void ModelViewer::RenderLightShadows(GraphicsContext& gfxContext)
 
     ScopedTimer _prof(L"RenderLightShadows", gfxContext);
 
-    static uint32_t LightIndex = 0;
-    if (LightIndex >= MaxLights)
-        return;
+    // The skinned model is the only caster that moves.  Its bind pose bounds stand in for its pose.
+    const Vector3 DynamicBounds[] = { m_Model.GetBoundingBox().min, m_Model.GetBoundingBox().max };
+    const uint32_t NumDynamic = m_Model.IsSkinned() ? 1 : 0;
+
+    uint32_t LightIndices[MaxShadowSlices];
+    uint32_t Slices[MaxShadowSlices];
+    const uint32_t NumLights = UpdateShadowCache(gfxContext, m_Camera, DynamicBounds, NumDynamic, LightIndices, Slices);
 
-    m_LightShadowTempBuffer.BeginRendering(gfxContext);
+    auto pfnSetupShadowPass = [&](GraphicsContext& Context)
     {
-        gfxContext.SetPipelineState(m_ShadowPSO);
-        RenderObjects(gfxContext, m_LightShadowMatrix[LightIndex], kOpaque);
-        gfxContext.SetPipelineState(m_CutoutShadowPSO);
-        RenderObjects(gfxContext, m_LightShadowMatrix[LightIndex], kCutout);
-    }
-    m_LightShadowTempBuffer.EndRendering(gfxContext);
+        SetupGraphicsState(Context);
+        Context.SetDepthStencilTarget(m_LightShadowTempBuffer.GetDSV());
+        Context.SetViewportAndScissor(m_LightShadowTempBuffer.GetViewport(), m_LightShadowTempBuffer.GetScissor());
+    };
 
-    gfxContext.TransitionResource(m_LightShadowTempBuffer, D3D12_RESOURCE_STATE_GENERIC_READ);
-    gfxContext.TransitionResource(m_LightShadowArray, D3D12_RESOURCE_STATE_COPY_DEST);
+    for (uint32_t i = 0; i < NumLights; ++i)
+    {
+        const uint32_t LightIndex = LightIndices[i];
 
-    gfxContext.CopySubresource(m_LightShadowArray, LightIndex, m_LightShadowTempBuffer, 0);
+        // Cached maps are reused from any view, so only the light's own frustum can cull casters
+        m_LightShadowFrustum[LightIndex].IntersectBoundingBoxes(m_MeshBoundsSOA, m_LightCasterVisibility.data());
+
+        m_LightShadowTempBuffer.BeginRendering(gfxContext);
+        {
+            RenderObjects(gfxContext, m_LightShadowMatrix[LightIndex], kOpaque, m_ShadowPSO, pfnSetupShadowPass,
+                false, true, m_LightCasterVisibility.data());
+            RenderObjects(gfxContext, m_LightShadowMatrix[LightIndex], kCutout, m_CutoutShadowPSO, pfnSetupShadowPass,
+                false, true, m_LightCasterVisibility.data());
+        }
+        m_LightShadowTempBuffer.EndRendering(gfxContext);
+
+        gfxContext.TransitionResource(m_LightShadowTempBuffer, D3D12_RESOURCE_STATE_GENERIC_READ);
+        gfxContext.TransitionResource(m_LightShadowArray, D3D12_RESOURCE_STATE_COPY_DEST);
+
+        gfxContext.CopySubresource(m_LightShadowArray, Slices[i], m_LightShadowTempBuffer, 0);
+    }
 
     gfxContext.TransitionResource(m_LightShadowArray, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+}
+
+void ModelViewer::RenderSunShadowCascades(GraphicsContext& gfxContext)
+{
+    const uint32_t NumCascades = m_SunShadow.GetNumCascades();
+
+    // Cull every mesh against all of the cascades in one pass over the bounds
+    const Frustum* Frusta[CascadedShadowCamera::kMaxCascades];
+    uint32_t* VisibilityMasks[CascadedShadowCamera::kMaxCascades];
+    for (uint32_t i = 0; i < NumCascades; ++i)
+    {
+        Frusta[i] = &m_SunShadow.GetCascade(i).GetWorldSpaceFrustum();
+        VisibilityMasks[i] = m_CascadeVisibility[i].data();
+    }
+    Frustum::IntersectBoundingBoxes(Frusta, NumCascades, m_MeshBoundsSOA, VisibilityMasks);
+
+    // A cascade's frustum reaches back toward the sun to catch casters outside the view, but most of those
+    // shadow nothing the camera sees.  Keep only casters whose shadow volumes enter the view frustum.
+    if (ShadowReceiverCulling)
+    {
+        const Camera& ViewCamera = m_Stereo ? m_StereoCullingCamera : m_Camera;
+        ViewCamera.GetWorldSpaceFrustum().IntersectSweptBoundingBoxes(m_MeshBoundsSOA, -m_SunDirection,
+            m_ReceiverVisibility.data());
+
+        for (uint32_t i = 0; i < NumCascades; ++i)
+        {
+            for (size_t w = 0; w < m_ReceiverVisibility.size(); ++w)
+                VisibilityMasks[i][w] &= m_ReceiverVisibility[w];
+        }
+    }
+
+    // Opaque and cutout casters share a queue, ordered front to back along the light direction
+    const GraphicsPSO* PSOs[] = { &m_ShadowPSO, &m_CutoutShadowPSO };
+    const Vector4 LightDepthPlane(-m_SunDirection, 0.0f);
+    DrawStats CascadeStats[CascadedShadowCamera::kMaxCascades] = {};
+
+    auto RecordCascade = [&](GraphicsContext& Context, uint32_t Cascade)
+    {
+        const ShadowCamera& ShadowCam = m_SunShadow.GetCascade(Cascade);
+
+        VSConstants vsConstants;
+        vsConstants.modelToProjection = ShadowCam.GetViewProjMatrix();
+        vsConstants.modelToShadow = ShadowCam.GetShadowMatrix();
+        XMStoreFloat3(&vsConstants.viewerPos, m_Camera.GetPosition());
+        const D3D12_GPU_VIRTUAL_ADDRESS VSConstantsCBV = UploadVSConstants(Context, vsConstants);
+
+        SetupGraphicsState(Context);
+        Context.SetDepthStencilTarget(m_SunShadowCascades.GetSliceDSV(Cascade));
+        Context.SetViewportAndScissor(m_SunShadowCascades.GetViewport(), m_SunShadowCascades.GetScissor());
+
+        RenderQueue& Queue = m_CascadeQueues[Cascade];
+        Queue.Clear();
+        QueueObjects(Queue, (eObjectFilter)(kOpaque | kCutout), LightDepthPlane, VisibilityMasks[Cascade]);
+        Queue.Sort();
+        RecordQueue(Context, VSConstantsCBV, Queue, 0, Queue.GetCount(), PSOs, CascadeStats[Cascade]);
+
+        Context.SetPipelineState(m_ShadowPSO);
+        RecordInstances(Context, VSConstantsCBV, kOpaque, CascadeStats[Cascade]);
+        Context.SetPipelineState(m_CutoutShadowPSO);
+        RecordInstances(Context, VSConstantsCBV, kCutout, CascadeStats[Cascade]);
+    };
+
+    // Clears every slice and leaves the array in DEPTH_WRITE for the cascade contexts
+    m_SunShadowCascades.BeginRendering(gfxContext);
+
+    if (!ParallelRecording || NumCascades == 1)
+    {
+        for (uint32_t i = 0; i < NumCascades; ++i)
+            RecordCascade(gfxContext, i);
+    }
+    else
+    {
+        // The cascades are independent, so each is recorded on its own context and thread
+        CommandContext* Contexts[CascadedShadowCamera::kMaxCascades];
+        for (uint32_t i = 0; i < NumCascades; ++i)
+        {
+            Contexts[i] = &GraphicsContext::Begin();
+            Contexts[i]->TrackStatesLocally();
+        }
+
+        JobSystem::ParallelFor(0u, NumCascades, 1, [&](uint32_t i)
+        {
+            RecordCascade(Contexts[i]->GetGraphicsContext(), i);
+        });
+
+        gfxContext.FlushAndJoin(Contexts, NumCascades);
+        SetupGraphicsState(gfxContext);
+    }
+
+    for (uint32_t i = 0; i < NumCascades; ++i)
+        m_FrameStats.Add(CascadeStats[i]);
 
-    ++LightIndex;
+    m_SunShadowCascades.EndRendering(gfxContext);
 }
 
 void ModelViewer::RenderScene( void )
@@ -391,9 +1366,22 @@ void ModelViewer::RenderScene( void )
         s_ShowLightCounts = ShowWaveTileCounts;
     }
 
+    VisibilityBuffer::UpdateBuffer();
+    Lighting::UpdateClusterBuffers();
+    UpdateBindlessTables();
+
+    m_FrameStats = DrawStats();
+
     GraphicsContext& gfxContext = GraphicsContext::Begin(L"Scene Render");
+    if (DeferredTransitions)
+        gfxContext.DeferTransitions();
+
+    // Submitted to the async compute queue (by default) so the simulation overlaps the depth prepass and shadows
+    ParticleEffects::Update(gfxContext, Graphics::GetFrameTime());
 
-    ParticleEffects::Update(gfxContext.GetComputeContext(), Graphics::GetFrameTime());
+    // Skin once for all of this frame's passes
+    if (m_Model.IsSkinned())
+        m_SkinnedModel.Update(gfxContext.GetComputeContext());
 
     uint32_t FrameIndex = TemporalEffects::GetFrameIndexMod2();
 
@@ -408,12 +1396,16 @@ void ModelViewer::RenderScene( void )
         uint32_t TileCount[4];
         uint32_t FirstLightIndex[4];
         uint32_t FrameIndexMod2;
+        uint32_t NumCascades;
+        Matrix4 CascadeShadowMatrix[CascadedShadowCamera::kMaxCascades];
+        float ClusterZParams[4];
+        uint32_t ClusterTileCount[4];
     } psConstants;
 
     psConstants.sunDirection = m_SunDirection;
     psConstants.sunLight = Vector3(1.0f, 1.0f, 1.0f) * m_SunLightIntensity;
     psConstants.ambientLight = Vector3(1.0f, 1.0f, 1.0f) * m_AmbientIntensity;
-    psConstants.ShadowTexelSize[0] = 1.0f / g_ShadowBuffer.GetWidth();
+    psConstants.ShadowTexelSize[0] = 1.0f / m_SunShadowCascades.GetWidth();
     psConstants.InvTileDim[0] = 1.0f / Lighting::LightGridDim;
     psConstants.InvTileDim[1] = 1.0f / Lighting::LightGridDim;
     psConstants.TileCount[0] = Math::DivideByMultiple(g_SceneColorBuffer.GetWidth(), Lighting::LightGridDim);
@@ -421,45 +1413,94 @@ void ModelViewer::RenderScene( void )
     psConstants.FirstLightIndex[0] = Lighting::m_FirstConeLight;
     psConstants.FirstLightIndex[1] = Lighting::m_FirstConeShadowedLight;
     psConstants.FrameIndexMod2 = FrameIndex;
+    psConstants.NumCascades = m_SunShadow.GetNumCascades();
+    for (uint32_t i = 0; i < psConstants.NumCascades; ++i)
+        psConstants.CascadeShadowMatrix[i] = m_SunShadow.GetCascade(i).GetShadowMatrix();
+
+    // Cluster slices are spaced logarithmically in view Z from the near plane to the far plane
+    const float NearClip = m_Camera.GetNearClip();
+    const float FarClip = m_Camera.GetFarClip();
+    const float SliceScale = Lighting::ClusterSlices / log2f(FarClip / NearClip);
+    psConstants.ClusterZParams[0] = (FarClip - NearClip) / NearClip;
+    psConstants.ClusterZParams[1] = FarClip;
+    psConstants.ClusterZParams[2] = SliceScale;
+    psConstants.ClusterZParams[3] = -log2f(NearClip) * SliceScale;
+    psConstants.ClusterTileCount[0] = Math::DivideByMultiple(g_SceneColorBuffer.GetWidth(), Lighting::ClusterTileDim);
+    psConstants.ClusterTileCount[1] = Math::DivideByMultiple(g_SceneColorBuffer.GetHeight(), Lighting::ClusterTileDim);
+
+    SetupGraphicsState(gfxContext);
 
-    // Set the default state for command lists
-    auto pfnSetupGraphicsState = [&](void)
-    {
-        gfxContext.SetRootSignature(m_RootSig);
-        gfxContext.SetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-        gfxContext.SetIndexBuffer(m_Model.m_IndexBuffer.IndexBufferView());
-        gfxContext.SetVertexBuffer(0, m_Model.m_VertexBuffer.VertexBufferView());
-    };
+    RenderLightShadows(gfxContext);
 
-    pfnSetupGraphicsState();
+    if (GpuCulling::Enable)
+        GpuCulling::CullMeshes(gfxContext.GetComputeContext(), m_Stereo ? m_StereoCullingCamera : m_Camera, m_LodScale, m_Stereo);
+    else if (!m_Stereo)
+        OcclusionQueries::BeginFrame(m_Camera);
 
-    RenderLightShadows(gfxContext);
+    // The forward passes render to the MSAA buffers, which are resolved into the scene buffers that everything
+    // else reads.  The visibility buffer always shades one sample per pixel.
+    const bool Msaa = MSAAResolve::Enable && !VisibilityBuffer::Enable;
+    DepthBuffer& SceneDepth = Msaa ? g_SceneDepthBufferMSAA : g_SceneDepthBuffer;
+    ColorBuffer& SceneColor = Msaa ? g_SceneColorBufferMSAA : g_SceneColorBuffer;
+
+    // Reserved as late as possible, because the first submission from here on latches the camera
+    m_MainViewConstants = ReserveMainViewConstants(gfxContext);
 
     {
         ScopedTimer _prof(L"Z PrePass", gfxContext);
 
-        gfxContext.SetDynamicConstantBufferView(1, sizeof(psConstants), &psConstants);
+        auto pfnSetupDepthPass = [&](GraphicsContext& Context)
+        {
+            SetupGraphicsState(Context);
+            ModelRootBinder(Context).SetDynamicConstantBufferView<kPSConstants>(psConstants);
+            Context.SetDepthStencilTarget(SceneDepth.GetDSV());
+            SetMainViewports(Context);
+        };
+
+        // The visibility buffer is written along with depth
+        ColorBuffer& VisBuffer = VisibilityBuffer::GetBuffer();
+        auto pfnSetupVisibilityPass = [&](GraphicsContext& Context)
+        {
+            SetupGraphicsState(Context);
+            Context.SetRenderTarget(VisBuffer.GetRTV(), g_SceneDepthBuffer.GetDSV());
+            Context.SetViewportAndScissor(m_MainViewport, m_MainScissor);
+        };
 
         {
             ScopedTimer _prof1(L"Opaque", gfxContext);
-            gfxContext.TransitionResource(g_SceneDepthBuffer, D3D12_RESOURCE_STATE_DEPTH_WRITE, true);
-            gfxContext.ClearDepth(g_SceneDepthBuffer);
+            gfxContext.TransitionResource(SceneDepth, D3D12_RESOURCE_STATE_DEPTH_WRITE, true);
+            gfxContext.ClearDepth(SceneDepth);
 
+            if (VisibilityBuffer::Enable)
+            {
+                gfxContext.TransitionResource(VisBuffer, D3D12_RESOURCE_STATE_RENDER_TARGET, true);
+                gfxContext.ClearColor(VisBuffer);
+                RenderCulledObjects(gfxContext, kOpaque, m_VisibilityPSO, pfnSetupVisibilityPass, false);
+            }
+            else if (Msaa)
+            {
+                RenderCulledObjects(gfxContext, kOpaque, m_DepthMsaaPSO, pfnSetupDepthPass);
+            }
+            else
+            {
 #ifdef _WAVE_OP
-            gfxContext.SetPipelineState(EnableWaveOps ? m_DepthWaveOpsPSO : m_DepthPSO );
+                RenderCulledObjects(gfxContext, kOpaque, EnableWaveOps ? m_DepthWaveOpsPSO : m_DepthPSO, pfnSetupDepthPass);
 #else
-            gfxContext.SetPipelineState(m_DepthPSO);
+                RenderCulledObjects(gfxContext, kOpaque, m_DepthPSO, pfnSetupDepthPass);
 #endif
-            gfxContext.SetDepthStencilTarget(g_SceneDepthBuffer.GetDSV());
-            gfxContext.SetViewportAndScissor(m_MainViewport, m_MainScissor);
-            RenderObjects(gfxContext, m_ViewProjMatrix, kOpaque );
+            }
         }
 
         {
             ScopedTimer _prof2(L"Cutout", gfxContext);
-            gfxContext.SetPipelineState(m_CutoutDepthPSO);
-            RenderObjects(gfxContext, m_ViewProjMatrix, kCutout );
+            if (VisibilityBuffer::Enable)
+                RenderCulledObjects(gfxContext, kCutout, m_CutoutVisibilityPSO, pfnSetupVisibilityPass, false);
+            else
+                RenderCulledObjects(gfxContext, kCutout, Msaa ? m_CutoutDepthMsaaPSO : m_CutoutDepthPSO, pfnSetupDepthPass);
         }
+
+        if (Msaa)
+            MSAAResolve::ResolveDepth(gfxContext, g_SceneDepthBufferMSAA, g_SceneDepthBuffer);
     }
 
     SSAO::Render(gfxContext, m_Camera);
@@ -470,61 +1511,109 @@ void ModelViewer::RenderScene( void )
     {
         ScopedTimer _prof(L"Main Render", gfxContext);
 
-        gfxContext.TransitionResource(g_SceneColorBuffer, D3D12_RESOURCE_STATE_RENDER_TARGET, true);
-        gfxContext.ClearColor(g_SceneColorBuffer);
+        gfxContext.TransitionResource(SceneColor, D3D12_RESOURCE_STATE_RENDER_TARGET, true);
+        gfxContext.ClearColor(SceneColor);
 
-        pfnSetupGraphicsState();
+        SetupGraphicsState(gfxContext);
 
         {
             ScopedTimer _prof3(L"Render Shadow Map", gfxContext);
-
-            m_SunShadow.UpdateMatrix(-m_SunDirection, Vector3(0, -500.0f, 0), Vector3(ShadowDimX, ShadowDimY, ShadowDimZ),
-                (uint32_t)g_ShadowBuffer.GetWidth(), (uint32_t)g_ShadowBuffer.GetHeight(), 16);
-
-            g_ShadowBuffer.BeginRendering(gfxContext);
-            gfxContext.SetPipelineState(m_ShadowPSO);
-            RenderObjects(gfxContext, m_SunShadow.GetViewProjMatrix(), kOpaque);
-            gfxContext.SetPipelineState(m_CutoutShadowPSO);
-            RenderObjects(gfxContext, m_SunShadow.GetViewProjMatrix(), kCutout);
-            g_ShadowBuffer.EndRendering(gfxContext);
+            RenderSunShadowCascades(gfxContext);
         }
 
         if (SSAO::AsyncCompute)
         {
             gfxContext.Flush();
-            pfnSetupGraphicsState();
+            SetupGraphicsState(gfxContext);
 
             // Make the 3D queue wait for the Compute queue to finish SSAO
             g_CommandManager.GetGraphicsQueue().StallForProducer(g_CommandManager.GetComputeQueue());
         }
 
+        if (VisibilityBuffer::Enable)
+        {
+            ScopedTimer _prof4(L"Render Color", gfxContext);
+
+            // Leave the pass textures readable by the forward shaders as well, because not all of them are
+            // transitioned again every frame
+            const D3D12_RESOURCE_STATES ShaderRead =
+                D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE | D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE;
+            gfxContext.TransitionResource(g_SSAOFullScreen, ShaderRead);
+            gfxContext.TransitionDepthToReadOnly(m_SunShadowCascades);
+            gfxContext.TransitionResource(Lighting::m_LightShadowArray, ShaderRead);
+            gfxContext.TransitionResource(Lighting::m_LightGrid, ShaderRead);
+            gfxContext.TransitionResource(Lighting::m_LightGridBitMask, ShaderRead);
+            gfxContext.TransitionResource(Lighting::m_LightClusters, ShaderRead);
+            gfxContext.TransitionResource(Lighting::m_LightClusterIndices, ShaderRead);
+
+            const uint32_t DescriptorSize = g_Device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+            DescriptorHandle Table = m_BindlessTables[m_BindlessIndex];
+            DescriptorHandle ShadeTable = Table + (_countof(m_ExtraTextures) + (uint32_t)m_pMaterialIsCutout.size() * 6) * DescriptorSize;
+
+            VisibilityBuffer::Shade(gfxContext.GetComputeContext(), m_Camera, m_SunShadow.GetCascade(0).GetShadowMatrix(),
+                m_MainViewport, &psConstants, sizeof(psConstants), m_BindlessHeap.GetHeapPointer(),
+                Table.GetGpuHandle(), ShadeTable.GetGpuHandle());
+
+            gfxContext.TransitionDepthToReadOnly(g_SceneDepthBuffer);
+            SetupGraphicsState(gfxContext);
+        }
+        else
         {
             ScopedTimer _prof4(L"Render Color", gfxContext);
 
             gfxContext.TransitionResource(g_SSAOFullScreen, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+            gfxContext.TransitionDepthToReadOnly(SceneDepth);
+
+            auto pfnSetupColorPass = [&](GraphicsContext& Context)
+            {
+                SetupGraphicsState(Context);
+                SetPassTextures(Context);
+                ModelRootBinder(Context).SetDynamicConstantBufferView<kPSConstants>(psConstants);
+                Context.SetRenderTarget(SceneColor.GetRTV(), SceneDepth.GetDSV_DepthReadOnly());
+                SetMainViewports(Context);
+            };
+
+            if (Lighting::EnableClusters)
+            {
+                RenderCulledObjects( gfxContext, kOpaque, Msaa ? m_ClusteredModelMsaaPSO : m_ClusteredModelPSO, pfnSetupColorPass );
+                RenderCulledObjects( gfxContext, kCutout, Msaa ? m_ClusteredCutoutModelMsaaPSO : m_ClusteredCutoutModelPSO, pfnSetupColorPass );
+            }
+            else if (Msaa)
+            {
+                RenderCulledObjects( gfxContext, kOpaque, ShowWaveTileCounts ? m_WaveTileCountMsaaPSO : m_ModelMsaaPSO, pfnSetupColorPass );
 
-            gfxContext.SetDynamicDescriptors(3, 0, _countof(m_ExtraTextures), m_ExtraTextures);
-            gfxContext.SetDynamicConstantBufferView(1, sizeof(psConstants), &psConstants);
+                if (!ShowWaveTileCounts)
+                    RenderCulledObjects( gfxContext, kCutout, m_CutoutModelMsaaPSO, pfnSetupColorPass );
+            }
+            else
+            {
 #ifdef _WAVE_OP
-            gfxContext.SetPipelineState(EnableWaveOps ? m_ModelWaveOpsPSO : m_ModelPSO );
+                RenderCulledObjects( gfxContext, kOpaque, EnableWaveOps ? m_ModelWaveOpsPSO : m_ModelPSO, pfnSetupColorPass );
 #else
-            gfxContext.SetPipelineState(ShowWaveTileCounts ? m_WaveTileCountPSO : m_ModelPSO);
+                RenderCulledObjects( gfxContext, kOpaque, ShowWaveTileCounts ? m_WaveTileCountPSO : m_ModelPSO, pfnSetupColorPass );
 #endif
-            gfxContext.TransitionResource(g_SceneDepthBuffer, D3D12_RESOURCE_STATE_DEPTH_READ);
-            gfxContext.SetRenderTarget(g_SceneColorBuffer.GetRTV(), g_SceneDepthBuffer.GetDSV_DepthReadOnly());
-            gfxContext.SetViewportAndScissor(m_MainViewport, m_MainScissor);
-
-            RenderObjects( gfxContext, m_ViewProjMatrix, kOpaque );
 
-            if (!ShowWaveTileCounts)
-            {
-                gfxContext.SetPipelineState(m_CutoutModelPSO);
-                RenderObjects( gfxContext, m_ViewProjMatrix, kCutout );
+                if (!ShowWaveTileCounts)
+                    RenderCulledObjects( gfxContext, kCutout, m_CutoutModelPSO, pfnSetupColorPass );
             }
+
+            // One pass writes TAA's input from the samples
+            if (Msaa)
+                MSAAResolve::ResolveColor(gfxContext.GetComputeContext(), g_SceneColorBufferMSAA, g_SceneColorBuffer);
         }
 
     }
 
+    // The finished depth buffer is next frame's occluder.  With MSAA, Hi-Z reduces every sample.  A stereo
+    // depth buffer holds two views, so it occludes nothing.
+    if (!m_Stereo)
+    {
+        if (GpuCulling::Enable)
+            HiZ::Build(gfxContext.GetComputeContext(), SceneDepth, m_Camera);
+        else
+            OcclusionQueries::IssueQueries(gfxContext, g_SceneDepthBuffer, m_Camera);
+    }
+
     // Some systems generate a per-pixel velocity buffer to better track dynamic and skinned meshes.  Everything
     // is static in our scene, so we generate velocity from camera motion and the depth buffer.  A velocity buffer
     // is necessary for all temporal effects (and motion blur).
@@ -540,7 +1629,12 @@ void ModelViewer::RenderScene( void )
     else
         MotionBlur::RenderObjectBlur(gfxContext, g_VelocityBuffer);
 
-    gfxContext.Finish();
+    m_BindlessFence[m_BindlessIndex] = gfxContext.Finish();
+
+    // GPU culled draws are generated on the GPU and not counted
+    EngineProfiling::SetCounter(L"CPU Draws", m_FrameStats.Draws);
+    EngineProfiling::SetCounter(L"PSO Changes", m_FrameStats.PSOChanges);
+    EngineProfiling::SetCounter(L"Material Changes", m_FrameStats.MaterialChanges);
 }
 
 void ModelViewer::CreateParticleEffects()
@@ -0,0 +1,231 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Developed by Minigraph
+//
+
+#include "OcclusionQueries.h"
+#include "PipelineState.h"
+#include "RootSignature.h"
+#include "CommandContext.h"
+#include "GraphicsCore.h"
+#include "GraphicsCommon.h"
+#include "BufferManager.h"
+#include "DepthBuffer.h"
+#include "GpuBuffer.h"
+#include "Camera.h"
+#include "Model.h"
+#include "EngineTuning.h"
+#include "EngineProfiling.h"
+
+#include "CompiledShaders/OcclusionProxyVS.h"
+
+using namespace Math;
+using namespace Graphics;
+
+// must keep in sync with HLSL
+struct ProxyBox
+{
+    float boundsMin[3];
+    float pad0;
+    float boundsMax[3];
+    float pad1;
+};
+
+// The proxy is drawn as a 14 vertex triangle strip (see OcclusionProxyVS.hlsl)
+enum { kProxyVertexCount = 14 };
+
+namespace OcclusionQueries
+{
+    BoolVar Enable("Application/Occlusion Queries/Enable", false);
+    IntVar MeshesPerQuery("Application/Occlusion Queries/Meshes Per Query", 1, 1, 64);
+
+    RootSignature s_RootSig;
+    GraphicsPSO s_ProxyPSO;
+
+    ID3D12QueryHeap* s_QueryHeap = nullptr;
+    ByteAddressBuffer s_QueryResults;
+    StructuredBuffer s_ProxyBoxes;
+    uint32_t s_MeshCount = 0;
+
+    // The boxes are slightly inflated so that their faces never tie with the depth of the geometry inside them
+    std::vector<Model::BoundingBox> s_MeshBounds;
+
+    // Results are only used by the frame after they were resolved, so they are ignored after frames
+    // that issued no queries
+    uint32_t s_ResolvedMeshesPerQuery = 0;
+    uint64_t s_ResolvedFrame = 0;
+    bool s_Active = false;
+    std::vector<bool> s_AlwaysDraw;
+}
+
+void OcclusionQueries::Initialize( const Model& model )
+{
+    s_RootSig.Reset(3, 0);
+    s_RootSig[0].InitAsConstantBuffer(0, D3D12_SHADER_VISIBILITY_VERTEX);
+    s_RootSig[1].InitAsConstants(1, 1, D3D12_SHADER_VISIBILITY_VERTEX);
+    s_RootSig[2].InitAsDescriptorRange(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 0, 1, D3D12_SHADER_VISIBILITY_VERTEX);
+    s_RootSig.Finalize(L"OcclusionQueriesRS");
+
+    // Depth is tested but not written, and both faces are drawn because only coverage matters
+    s_ProxyPSO.SetRootSignature(s_RootSig);
+    s_ProxyPSO.SetRasterizerState(RasterizerTwoSided);
+    s_ProxyPSO.SetBlendState(BlendNoColorWrite);
+    s_ProxyPSO.SetDepthStencilState(DepthStateReadOnly);
+    s_ProxyPSO.SetPrimitiveTopologyType(D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE);
+    s_ProxyPSO.SetRenderTargetFormats(0, nullptr, g_SceneDepthBuffer.GetFormat());
+    s_ProxyPSO.SetVertexShader(g_pOcclusionProxyVS, sizeof(g_pOcclusionProxyVS));
+    s_ProxyPSO.Finalize();
+
+    s_MeshCount = model.m_Header.meshCount;
+
+    // One query per mesh is the most that can be needed
+    D3D12_QUERY_HEAP_DESC QueryHeapDesc;
+    QueryHeapDesc.Count = s_MeshCount;
+    QueryHeapDesc.NodeMask = 1;
+    QueryHeapDesc.Type = D3D12_QUERY_HEAP_TYPE_OCCLUSION;
+    ASSERT_SUCCEEDED(g_Device->CreateQueryHeap(&QueryHeapDesc, MY_IID_PPV_ARGS(&s_QueryHeap)));
+    s_QueryHeap->SetName(L"OcclusionQueries::QueryHeap");
+
+    // Every query resolves to a UINT64
+    s_QueryResults.Create(L"OcclusionQueries::Results", s_MeshCount * 2, 4);
+
+    const Vector3 ModelExtent = model.m_Header.boundingBox.max - model.m_Header.boundingBox.min;
+    const Vector3 Inflation(Length(ModelExtent) * 0.001f);
+
+    std::vector<ProxyBox> Boxes(s_MeshCount);
+    s_MeshBounds.resize(s_MeshCount);
+    for (uint32_t meshIndex = 0; meshIndex < s_MeshCount; ++meshIndex)
+    {
+        Model::BoundingBox& bounds = s_MeshBounds[meshIndex];
+        bounds.min = model.m_pMesh[meshIndex].boundingBox.min - Inflation;
+        bounds.max = model.m_pMesh[meshIndex].boundingBox.max + Inflation;
+
+        ProxyBox& box = Boxes[meshIndex];
+        box.boundsMin[0] = bounds.min.GetX();
+        box.boundsMin[1] = bounds.min.GetY();
+        box.boundsMin[2] = bounds.min.GetZ();
+        box.boundsMax[0] = bounds.max.GetX();
+        box.boundsMax[1] = bounds.max.GetY();
+        box.boundsMax[2] = bounds.max.GetZ();
+        box.pad0 = box.pad1 = 0.0f;
+    }
+
+    s_ProxyBoxes.Create(L"OcclusionQueries::ProxyBoxes", s_MeshCount, sizeof(ProxyBox), Boxes.data());
+
+    s_ResolvedMeshesPerQuery = 0;
+    s_ResolvedFrame = 0;
+    s_Active = false;
+}
+
+void OcclusionQueries::Shutdown( void )
+{
+    s_QueryResults.Destroy();
+    s_ProxyBoxes.Destroy();
+    if (s_QueryHeap != nullptr)
+    {
+        s_QueryHeap->Release();
+        s_QueryHeap = nullptr;
+    }
+    s_MeshBounds.clear();
+    s_AlwaysDraw.clear();
+}
+
+void OcclusionQueries::BeginFrame( const Camera& camera )
+{
+    s_Active = Enable && s_ResolvedMeshesPerQuery != 0 && s_ResolvedFrame + 1 == GetFrameCount();
+    if (!s_Active)
+        return;
+
+    const uint32_t QueryCount = (s_MeshCount + s_ResolvedMeshesPerQuery - 1) / s_ResolvedMeshesPerQuery;
+    s_AlwaysDraw.assign(QueryCount, false);
+
+    // The near plane can cut away every face of a box that is close enough to contain the camera
+    const Vector3 ViewPos = camera.GetPosition();
+    const Vector3 NearMargin(Scalar(camera.GetNearClip() * 2.0f));
+
+    for (uint32_t meshIndex = 0; meshIndex < s_MeshCount; ++meshIndex)
+    {
+        const Model::BoundingBox& bounds = s_MeshBounds[meshIndex];
+        const Vector3 Outside = Max(Max(bounds.min - NearMargin - ViewPos, ViewPos - bounds.max - NearMargin), Vector3(kZero));
+        if (Length(Outside) == 0.0f)
+            s_AlwaysDraw[meshIndex / s_ResolvedMeshesPerQuery] = true;
+    }
+}
+
+void OcclusionQueries::PredicateMesh( CommandContext& Context, uint32_t MeshIndex, uint32_t& CurrentQuery )
+{
+    uint32_t Query = kNoQuery;
+    if (s_Active)
+    {
+        Query = MeshIndex / s_ResolvedMeshesPerQuery;
+        if (s_AlwaysDraw[Query])
+            Query = kNoQuery;
+    }
+
+    if (Query == CurrentQuery)
+        return;
+
+    // The draws are skipped when the query's result is zero, i.e. none of the batch's boxes were visible
+    if (Query == kNoQuery)
+        Context.SetPredication(nullptr, 0, D3D12_PREDICATION_OP_EQUAL_ZERO);
+    else
+        Context.SetPredication(s_QueryResults.GetResource(), Query * sizeof(uint64_t), D3D12_PREDICATION_OP_EQUAL_ZERO);
+
+    CurrentQuery = Query;
+}
+
+void OcclusionQueries::EndPredication( CommandContext& Context, uint32_t& CurrentQuery )
+{
+    if (CurrentQuery != kNoQuery)
+        Context.SetPredication(nullptr, 0, D3D12_PREDICATION_OP_EQUAL_ZERO);
+    CurrentQuery = kNoQuery;
+}
+
+void OcclusionQueries::IssueQueries( GraphicsContext& Context, DepthBuffer& Depth, const Camera& camera )
+{
+    if (!Enable)
+        return;
+
+    ScopedTimer _prof(L"Occlusion Queries", Context);
+
+    const uint32_t BatchSize = (uint32_t)MeshesPerQuery;
+    const uint32_t QueryCount = (s_MeshCount + BatchSize - 1) / BatchSize;
+
+    Matrix4 ViewProj = camera.GetViewProjMatrix();
+
+    Context.TransitionDepthToReadOnly(Depth);
+    Context.TransitionResource(s_ProxyBoxes, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, true);
+
+    Context.SetRootSignature(s_RootSig);
+    Context.SetPipelineState(s_ProxyPSO);
+    Context.SetDepthStencilTarget(Depth.GetDSV_DepthReadOnly());
+    Context.SetViewportAndScissor(0, 0, Depth.GetWidth(), Depth.GetHeight());
+    Context.SetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP);
+    Context.SetDynamicConstantBufferView(0, sizeof(ViewProj), &ViewProj);
+    Context.SetDynamicDescriptor(2, 0, s_ProxyBoxes.GetSRV());
+
+    // Each batch draws one instance per mesh inside a single query
+    for (uint32_t Query = 0; Query < QueryCount; ++Query)
+    {
+        const uint32_t FirstMesh = Query * BatchSize;
+        const uint32_t BatchMeshCount = std::min(BatchSize, s_MeshCount - FirstMesh);
+
+        Context.SetConstants(1, FirstMesh);
+        Context.BeginQuery(s_QueryHeap, D3D12_QUERY_TYPE_BINARY_OCCLUSION, Query);
+        Context.DrawInstanced(kProxyVertexCount, BatchMeshCount);
+        Context.EndQuery(s_QueryHeap, D3D12_QUERY_TYPE_BINARY_OCCLUSION, Query);
+    }
+
+    Context.TransitionResource(s_QueryResults, D3D12_RESOURCE_STATE_COPY_DEST, true);
+    Context.ResolveQueryData(s_QueryHeap, D3D12_QUERY_TYPE_BINARY_OCCLUSION, 0, QueryCount, s_QueryResults.GetResource(), 0);
+    Context.TransitionResource(s_QueryResults, D3D12_RESOURCE_STATE_PREDICATION, true);
+
+    s_ResolvedMeshesPerQuery = BatchSize;
+    s_ResolvedFrame = GetFrameCount();
+}
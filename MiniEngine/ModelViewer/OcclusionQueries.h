@@ -0,0 +1,52 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Developed by Minigraph
+//
+
+#pragma once
+
+#include <cstdint>
+
+class Model;
+class DepthBuffer;
+class CommandContext;
+class GraphicsContext;
+class BoolVar;
+class IntVar;
+namespace Math
+{
+    class Camera;
+}
+
+// Occlusion culling with hardware queries and predication.  After the main view is drawn, the bounding boxes of
+// the meshes are drawn against its depth buffer in batches, one binary occlusion query per batch.  The results
+// are resolved into a predication buffer, and next frame's draws of a batch are skipped by the GPU when none of
+// its boxes passed the depth test.  The CPU never reads the results, so it never waits for them, but a mesh that
+// comes into view only appears one frame later.
+namespace OcclusionQueries
+{
+    extern BoolVar Enable;
+    extern IntVar MeshesPerQuery;
+
+    void Initialize( const Model& model );
+    void Shutdown( void );
+
+    // Decide which batches can be predicated from this camera.  Batches whose boxes contain the camera are
+    // always drawn because their proxies may be clipped by the near plane.  Call once per frame before drawing.
+    void BeginFrame( const Math::Camera& camera );
+
+    // Predicate the draws of this mesh.  CurrentQuery holds the predicate set on the context and must start
+    // out as kNoQuery; EndPredication() removes it again.
+    enum : uint32_t { kNoQuery = 0xFFFFFFFFu };
+    void PredicateMesh( CommandContext& Context, uint32_t MeshIndex, uint32_t& CurrentQuery );
+    void EndPredication( CommandContext& Context, uint32_t& CurrentQuery );
+
+    // Draw the proxies against the finished depth buffer and resolve the results for next frame.
+    void IssueQueries( GraphicsContext& Context, DepthBuffer& Depth, const Math::Camera& camera );
+}
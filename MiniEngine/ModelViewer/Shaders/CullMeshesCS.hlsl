@@ -0,0 +1,165 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Developed by Minigraph
+//
+// Tests each mesh's bounding box against the view frustum and the Hi-Z pyramid, then appends the
+// draw arguments of the survivors to the run of arguments reserved for the mesh's material.
+//
+
+#include "GpuCullingRS.hlsli"
+
+// must keep in sync with C++
+struct MeshCullData
+{
+    float3 BoundsMin;
+    uint MaterialIndex;
+    float3 BoundsMax;
+    uint FirstArgument;
+    uint IndexCount;
+    uint StartIndex;
+    uint BaseVertex;
+    uint VertexFlags;
+    uint LodCount;
+    uint3 LodStartIndex;
+    uint3 LodIndexCount;
+    float3 LodError;
+    uint2 Pad;
+};
+
+// Eight root constants (see VertexDecode.hlsli) followed by D3D12_DRAW_INDEXED_ARGUMENTS
+#define DRAW_ARGUMENT_STRIDE 52
+
+cbuffer CSConstants : register(b0)
+{
+    float4 FrustumPlanes[6];
+    float4x4 HiZViewProj;
+    float2 HiZSize;
+    uint HiZMipCount;
+    uint MeshCount;
+    uint EnableOcclusion;
+    float3 LodViewPos;
+    float LodScale;
+    uint StereoFlags;   // VERTEX_FLAG_STEREO to draw every mesh once per eye
+};
+
+StructuredBuffer<MeshCullData> MeshData : register(t0);
+Texture2D<float> HiZ : register(t1);
+RWByteAddressBuffer DrawArguments : register(u0);
+RWByteAddressBuffer DrawCounts : register(u1);
+
+bool IntersectFrustum( float3 BoundsMin, float3 BoundsMax )
+{
+    [unroll]
+    for (uint i = 0; i < 6; ++i)
+    {
+        float4 Plane = FrustumPlanes[i];
+        float3 FarCorner = Plane.xyz > 0.0 ? BoundsMax : BoundsMin;
+        if (dot(Plane.xyz, FarCorner) + Plane.w < 0.0)
+            return false;
+    }
+    return true;
+}
+
+// The pyramid holds the farthest depth of each footprint as seen by the camera of the previous frame.
+// Everything is static, so the only error is that geometry revealed by camera motion appears a frame late.
+bool IsVisibleInHiZ( float3 BoundsMin, float3 BoundsMax )
+{
+    float2 MinUV = 1.0;
+    float2 MaxUV = 0.0;
+    float NearestZ = 0.0;
+
+    [unroll]
+    for (uint i = 0; i < 8; ++i)
+    {
+        float3 Corner = float3(
+            i & 1 ? BoundsMax.x : BoundsMin.x,
+            i & 2 ? BoundsMax.y : BoundsMin.y,
+            i & 4 ? BoundsMax.z : BoundsMin.z);
+
+        float4 ClipPos = mul(HiZViewProj, float4(Corner, 1.0));
+
+        // The box crosses the camera plane, so its projection is unbounded
+        if (ClipPos.w <= 0.0)
+            return true;
+
+        float3 NDC = ClipPos.xyz / ClipPos.w;
+        float2 UV = NDC.xy * float2(0.5, -0.5) + 0.5;
+        MinUV = min(MinUV, UV);
+        MaxUV = max(MaxUV, UV);
+
+        // Reversed Z:  the closest point has the largest depth
+        NearestZ = max(NearestZ, NDC.z);
+    }
+
+    MinUV = saturate(MinUV);
+    MaxUV = saturate(MaxUV);
+
+    // Choose the level where the rectangle spans at most two texels in each direction
+    float2 Extent = (MaxUV - MinUV) * HiZSize;
+    uint Level = (uint)ceil(log2(max(max(Extent.x, Extent.y), 1.0)));
+    if (Level >= HiZMipCount)
+        return true;
+
+    uint2 LevelSize = max((uint2)HiZSize >> Level, 1);
+    uint2 TexelMin = min((uint2)(MinUV * HiZSize) >> Level, LevelSize - 1);
+    uint2 TexelMax = min((uint2)(MaxUV * HiZSize) >> Level, LevelSize - 1);
+
+    float FarthestZ = min(
+        min(HiZ.Load(int3(TexelMin.x, TexelMin.y, Level)), HiZ.Load(int3(TexelMax.x, TexelMin.y, Level))),
+        min(HiZ.Load(int3(TexelMin.x, TexelMax.y, Level)), HiZ.Load(int3(TexelMax.x, TexelMax.y, Level))));
+
+    return NearestZ >= FarthestZ;
+}
+
+[RootSignature(GpuCulling_RootSig)]
+[numthreads(64, 1, 1)]
+void main( uint3 DTid : SV_DispatchThreadID )
+{
+    if (DTid.x >= MeshCount)
+        return;
+
+    MeshCullData Mesh = MeshData[DTid.x];
+
+    if (!IntersectFrustum(Mesh.BoundsMin, Mesh.BoundsMax))
+        return;
+
+    if (EnableOcclusion && !IsVisibleInHiZ(Mesh.BoundsMin, Mesh.BoundsMax))
+        return;
+
+    // The coarsest level of detail whose error stays within budget at the distance to the bounding box
+    uint StartIndex = Mesh.StartIndex;
+    uint IndexCount = Mesh.IndexCount;
+    uint LodLevel = 0;
+    if (LodScale > 0.0)
+    {
+        float Distance = length(max(max(Mesh.BoundsMin - LodViewPos, LodViewPos - Mesh.BoundsMax), 0.0));
+
+        [unroll]
+        for (uint Level = 0; Level < 3; ++Level)
+        {
+            if (Level < Mesh.LodCount && Mesh.LodError[Level] * LodScale <= Distance)
+            {
+                StartIndex = Mesh.LodStartIndex[Level];
+                IndexCount = Mesh.LodIndexCount[Level];
+                LodLevel = Level + 1;
+            }
+        }
+    }
+
+    uint Slot;
+    DrawCounts.InterlockedAdd(Mesh.MaterialIndex * 4, 1, Slot);
+
+    uint Offset = (Mesh.FirstArgument + Slot) * DRAW_ARGUMENT_STRIDE;
+    // Quantized positions are relative to the mesh bounding box.  The visibility buffer records the level of
+    // detail from the vertex flags (see VertexDecode.hlsli).
+    DrawArguments.Store4(Offset, uint4(asuint(Mesh.BoundsMax - Mesh.BoundsMin), Mesh.VertexFlags | LodLevel << 1 | StereoFlags));
+    DrawArguments.Store4(Offset + 16, uint4(asuint(Mesh.BoundsMin), Mesh.MaterialIndex));
+    DrawArguments.Store4(Offset + 32, uint4(IndexCount, StereoFlags ? 2 : 1, StartIndex, Mesh.BaseVertex));
+    DrawArguments.Store(Offset + 48, 0);
+}
@@ -13,10 +13,15 @@
 //
 
 #include "ModelViewerRS.hlsli"
+#include "VertexDecode.hlsli"
 
+// Laid out as in ModelViewerVS.hlsl
 cbuffer VSConstants : register(b0)
 {
     float4x4 modelToProjection;
+    float4x4 modelToShadow;
+    float3 ViewerPos;
+    float4x4 modelToProjectionRight;
 };
 
 struct VSInput
@@ -32,13 +37,17 @@ struct VSOutput
 {
     float4 pos : SV_Position;
     float2 uv : TexCoord0;
+    uint viewport : SV_ViewportArrayIndex;
 };
 
 [RootSignature(ModelViewer_RootSig)]
-VSOutput main(VSInput vsInput)
+VSOutput main(VSInput vsInput, uint instanceID : SV_InstanceID)
 {
     VSOutput vsOutput;
-    vsOutput.pos = mul(modelToProjection, float4(vsInput.position, 1.0));
+    uint eye = GetStereoEye(instanceID);
+    float3 position = InstancePosition(DecodePosition(vsInput.position), GetStereoInstance(instanceID));
+    vsOutput.pos = mul(eye ? modelToProjectionRight : modelToProjection, float4(position, 1.0));
     vsOutput.uv = vsInput.texcoord0;
+    vsOutput.viewport = eye;
     return vsOutput;
 }
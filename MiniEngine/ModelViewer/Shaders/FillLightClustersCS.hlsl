@@ -0,0 +1,217 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Developed by Minigraph
+//
+
+// Builds the clustered light grid.  Each thread group culls every light against one cluster, a screen tile
+// bounded by the near and far view depth of its slice.  Unlike the tiled grid, the bounds don't come from the
+// depth buffer, so a tile spanning a depth discontinuity doesn't pull in every light in between.
+
+#include "LightGrid.hlsli"
+
+// outdated warning about for-loop variable scope
+#pragma warning (disable: 3078)
+
+#define WORK_GROUP_THREADS 64
+
+cbuffer CSConstants : register(b0)
+{
+    uint ViewportWidth, ViewportHeight;
+    float NearClip, FarClip;
+    float RcpZMagic;
+    uint NumLights;
+    uint MaxClusterIndices;
+    uint MaxClusters;
+    float4x4 ViewProjMatrix;
+    uint LightBVHLeafCount;     // zero to test every light
+};
+
+StructuredBuffer<LightData> lightBuffer : register(t0);
+StructuredBuffer<LightBVHNode> lightBVH : register(t2);
+RWByteAddressBuffer lightClusters : register(u0);
+RWByteAddressBuffer lightClusterIndices : register(u1);
+
+groupshared uint clusterLightCount[3];
+groupshared uint clusterLightIndices[3][MAX_LIGHTS_PER_CLUSTER_TYPE];
+groupshared uint clusterListOffset;
+
+#define _RootSig \
+    "RootFlags(0), " \
+    "CBV(b0), " \
+    "DescriptorTable(SRV(t0, numDescriptors = 3))," \
+    "DescriptorTable(UAV(u0, numDescriptors = 2))"
+
+// Adds the light to the cluster's list for the given type if this lane found an overlap
+void AppendLight(uint type, bool append, uint lightIndex)
+{
+#ifdef _WAVE_OP
+    // Lanes agree on consecutive slots with a prefix count, so only one lane per wave touches the counter
+    uint appendCount = WaveActiveCountBits(append);
+    if (appendCount == 0)
+        return;
+
+    uint firstSlot = 0;
+    if (WaveIsFirstLane())
+        InterlockedAdd(clusterLightCount[type], appendCount, firstSlot);
+
+    uint slot = WaveReadLaneFirst(firstSlot) + WavePrefixCountBits(append);
+    if (append && slot < MAX_LIGHTS_PER_CLUSTER_TYPE)
+        clusterLightIndices[type][slot] = lightIndex;
+#else
+    if (append)
+    {
+        uint slot = 0;
+        InterlockedAdd(clusterLightCount[type], 1, slot);
+        if (slot < MAX_LIGHTS_PER_CLUSTER_TYPE)
+            clusterLightIndices[type][slot] = lightIndex;
+    }
+#endif
+}
+
+// add the light to the cluster's lists if it overlaps the cluster
+void CullLight(uint lightIndex, float4 frustumPlanes[6])
+{
+    LightData lightData = lightBuffer[lightIndex];
+    float lightCullRadius = sqrt(lightData.radiusSq);
+
+    bool overlapping = true;
+    for (int n = 0; n < 6; n++)
+    {
+        float d = dot(lightData.pos, frustumPlanes[n].xyz) + frustumPlanes[n].w;
+        if (d < -lightCullRadius)
+        {
+            overlapping = false;
+        }
+    }
+
+    AppendLight(0, overlapping && lightData.type == 0, lightIndex);
+    AppendLight(1, overlapping && lightData.type == 1, lightIndex);
+    AppendLight(2, overlapping && lightData.type == 2, lightIndex);
+}
+
+#include "LightBVHTraversal.hlsli"
+
+[RootSignature(_RootSig)]
+[numthreads(WORK_GROUP_THREADS, 1, 1)]
+void main(
+    uint3 groupID : SV_GroupID,
+    uint threadIndex : SV_GroupIndex)
+{
+    uint2 tileCount = (uint2(ViewportWidth, ViewportHeight) + CLUSTER_TILE_DIM - 1) / CLUSTER_TILE_DIM;
+    uint clusterIndex = GetClusterIndex(groupID.xy, groupID.z, tileCount);
+
+    // The whole group leaves before any barrier if its cluster wasn't allocated
+    if (clusterIndex >= MaxClusters)
+        return;
+
+    if (threadIndex == 0)
+    {
+        clusterLightCount[0] = 0;
+        clusterLightCount[1] = 0;
+        clusterLightCount[2] = 0;
+    }
+    GroupMemoryBarrierWithGroupSync();
+
+    // Slices are spaced logarithmically from the near plane to the far plane.  With reversed Z, the far end
+    // of the slice has the smaller projected depth.
+    float depthRatio = FarClip / NearClip;
+    float sliceNear = NearClip * pow(depthRatio, groupID.z / (float)CLUSTER_SLICES);
+    float sliceFar = NearClip * pow(depthRatio, (groupID.z + 1) / (float)CLUSTER_SLICES);
+    float clusterMinDepth = (FarClip / sliceFar - 1.0) * RcpZMagic;
+    float clusterMaxDepth = (FarClip / sliceNear - 1.0) * RcpZMagic;
+    float invClusterDepthRange = rcp(clusterMaxDepth - clusterMinDepth);
+
+    // construct transform from world space to cluster space (same as the tiled grid, with the slice's depth range)
+    float2 invTileSize2X = float2(ViewportWidth, ViewportHeight) / CLUSTER_TILE_DIM;
+    float3 tileBias = float3(
+        -2.0 * float(groupID.x) + invTileSize2X.x - 1.0,
+        -2.0 * float(groupID.y) + invTileSize2X.y - 1.0,
+        -clusterMinDepth * invClusterDepthRange);
+    float4x4 projToTile = float4x4(
+        invTileSize2X.x, 0, 0, tileBias.x,
+        0, -invTileSize2X.y, 0, tileBias.y,
+        0, 0, invClusterDepthRange, tileBias.z,
+        0, 0, 0, 1
+        );
+    float4x4 tileMVP = mul(projToTile, ViewProjMatrix);
+
+    // extract frustum planes (these will be in world space)
+    float4 frustumPlanes[6];
+    frustumPlanes[0] = tileMVP[3] + tileMVP[0];
+    frustumPlanes[1] = tileMVP[3] - tileMVP[0];
+    frustumPlanes[2] = tileMVP[3] + tileMVP[1];
+    frustumPlanes[3] = tileMVP[3] - tileMVP[1];
+    frustumPlanes[4] = tileMVP[3] + tileMVP[2];
+    frustumPlanes[5] = tileMVP[3] - tileMVP[2];
+    for (int n = 0; n < 6; n++)
+    {
+        frustumPlanes[n] *= rsqrt(dot(frustumPlanes[n].xyz, frustumPlanes[n].xyz));
+    }
+
+    if (LightBVHLeafCount > 0)
+    {
+        TraverseLightBVH(threadIndex, WORK_GROUP_THREADS, LightBVHLeafCount, frustumPlanes);
+    }
+    else
+    {
+        for (uint lightIndex = threadIndex; lightIndex < NumLights; lightIndex += WORK_GROUP_THREADS)
+            CullLight(lightIndex, frustumPlanes);
+    }
+
+    GroupMemoryBarrierWithGroupSync();
+
+    if (threadIndex == 0)
+    {
+        uint countSphere = min(clusterLightCount[0], MAX_LIGHTS_PER_CLUSTER_TYPE);
+        uint countCone = min(clusterLightCount[1], MAX_LIGHTS_PER_CLUSTER_TYPE);
+        uint countConeShadowed = min(clusterLightCount[2], MAX_LIGHTS_PER_CLUSTER_TYPE);
+        uint total = countSphere + countCone + countConeShadowed;
+
+        uint listOffset = 0;
+        if (total > 0)
+            lightClusterIndices.InterlockedAdd(0, total, listOffset);
+
+        // Drop the cluster's lights rather than overrun the list
+        if (listOffset + total > MaxClusterIndices)
+        {
+            countSphere = 0;
+            countCone = 0;
+            countConeShadowed = 0;
+        }
+
+        clusterLightCount[0] = countSphere;
+        clusterLightCount[1] = countCone;
+        clusterLightCount[2] = countConeShadowed;
+        clusterListOffset = listOffset;
+
+        uint lightCount = (countSphere << 0) | (countCone << 8) | (countConeShadowed << 16);
+        lightClusters.Store2(clusterIndex * 8, uint2(listOffset, lightCount));
+    }
+
+    GroupMemoryBarrierWithGroupSync();
+
+    // write the compacted indices out with the whole group, sphere lights first
+    uint countSphere = clusterLightCount[0];
+    uint countCone = clusterLightCount[1];
+    uint total = countSphere + countCone + clusterLightCount[2];
+    uint storeOffset = 4 + clusterListOffset * 4;
+
+    for (uint n = threadIndex; n < total; n += WORK_GROUP_THREADS)
+    {
+        uint lightIndex;
+        if (n < countSphere)
+            lightIndex = clusterLightIndices[0][n];
+        else if (n < countSphere + countCone)
+            lightIndex = clusterLightIndices[1][n - countSphere];
+        else
+            lightIndex = clusterLightIndices[2][n - countSphere - countCone];
+
+        lightClusterIndices.Store(storeOffset + n * 4, lightIndex);
+    }
+}
@@ -31,10 +31,12 @@ cbuffer CSConstants : register(b0)
     float RcpZMagic;
     uint TileCountX;
     float4x4 ViewProjMatrix;
+    uint LightBVHLeafCount;     // zero to test every light
 };
 
 StructuredBuffer<LightData> lightBuffer : register(t0);
 Texture2D<float> depthTex : register(t1);
+StructuredBuffer<LightBVHNode> lightBVH : register(t2);
 RWByteAddressBuffer lightGrid : register(u0);
 RWByteAddressBuffer lightGridBitMask : register(u1);
 
@@ -54,9 +56,76 @@ groupshared uint4 tileLightBitMask;
 #define _RootSig \
     "RootFlags(0), " \
     "CBV(b0), " \
-    "DescriptorTable(SRV(t0, numDescriptors = 2))," \
+    "DescriptorTable(SRV(t0, numDescriptors = 3))," \
     "DescriptorTable(UAV(u0, numDescriptors = 2))"
 
+// add the light to the tile's lists if it overlaps the tile
+void CullLight(uint lightIndex, float4 frustumPlanes[6])
+{
+    LightData lightData = lightBuffer[lightIndex];
+    float3 lightWorldPos = lightData.pos;
+    float lightCullRadius = sqrt(lightData.radiusSq);
+
+    bool overlapping = true;
+    for (int n = 0; n < 6; n++)
+    {
+        float d = dot(lightWorldPos, frustumPlanes[n].xyz) + frustumPlanes[n].w;
+        if (d < -lightCullRadius)
+        {
+            overlapping = false;
+        }
+    }
+    
+    if (overlapping)
+    {
+        switch (lightData.type)
+        {
+        case 0: // sphere
+            {
+                uint slot = 0;
+                InterlockedAdd(tileLightCountSphere, 1, slot);
+                tileLightIndicesSphere[slot] = lightIndex;
+            }
+            break;
+
+        case 1: // cone
+            {
+                uint slot = 0;
+                InterlockedAdd(tileLightCountCone, 1, slot);
+                tileLightIndicesCone[slot] = lightIndex;
+            }
+            break;
+
+        case 2: // cone w/ shadow map
+            {
+                uint slot = 0;
+                InterlockedAdd(tileLightCountConeShadowed, 1, slot);
+                tileLightIndicesConeShadowed[slot] = lightIndex;
+            }
+            break;
+        }
+
+        // update bitmask
+        switch (lightIndex / 32)
+        {
+        case 0:
+            InterlockedOr(tileLightBitMask.x, 1 << (lightIndex % 32));
+            break;
+        case 1:
+            InterlockedOr(tileLightBitMask.y, 1 << (lightIndex % 32));
+            break;
+        case 2:
+            InterlockedOr(tileLightBitMask.z, 1 << (lightIndex % 32));
+            break;
+        case 3:
+            InterlockedOr(tileLightBitMask.w, 1 << (lightIndex % 32));
+            break;
+        }
+    }
+}
+
+#include "LightBVHTraversal.hlsli"
+
 [RootSignature(_RootSig)]
 [numthreads(WORK_GROUP_SIZE_X, WORK_GROUP_SIZE_Y, WORK_GROUP_SIZE_Z)]
 void main(
@@ -139,68 +208,14 @@ void main(
     uint tileOffset = GetTileOffset(tileIndex);
 
     // find set of lights that overlap this tile
-    for (uint lightIndex = threadIndex; lightIndex < MAX_LIGHTS; lightIndex += WORK_GROUP_THREADS)
+    if (LightBVHLeafCount > 0)
     {
-        LightData lightData = lightBuffer[lightIndex];
-        float3 lightWorldPos = lightData.pos;
-        float lightCullRadius = sqrt(lightData.radiusSq);
-
-        bool overlapping = true;
-        for (int n = 0; n < 6; n++)
-        {
-            float d = dot(lightWorldPos, frustumPlanes[n].xyz) + frustumPlanes[n].w;
-            if (d < -lightCullRadius)
-            {
-                overlapping = false;
-            }
-        }
-        
-        if (overlapping)
-        {
-            switch (lightData.type)
-            {
-            case 0: // sphere
-                {
-                    uint slot = 0;
-                    InterlockedAdd(tileLightCountSphere, 1, slot);
-                    tileLightIndicesSphere[slot] = lightIndex;
-                }
-                break;
-
-            case 1: // cone
-                {
-                    uint slot = 0;
-                    InterlockedAdd(tileLightCountCone, 1, slot);
-                    tileLightIndicesCone[slot] = lightIndex;
-                }
-                break;
-
-            case 2: // cone w/ shadow map
-                {
-                    uint slot = 0;
-                    InterlockedAdd(tileLightCountConeShadowed, 1, slot);
-                    tileLightIndicesConeShadowed[slot] = lightIndex;
-                }
-                break;
-            }
-
-            // update bitmask
-            switch (lightIndex / 32)
-            {
-            case 0:
-                InterlockedOr(tileLightBitMask.x, 1 << (lightIndex % 32));
-                break;
-            case 1:
-                InterlockedOr(tileLightBitMask.y, 1 << (lightIndex % 32));
-                break;
-            case 2:
-                InterlockedOr(tileLightBitMask.z, 1 << (lightIndex % 32));
-                break;
-            case 3:
-                InterlockedOr(tileLightBitMask.w, 1 << (lightIndex % 32));
-                break;
-            }
-        }
+        TraverseLightBVH(threadIndex, WORK_GROUP_THREADS, LightBVHLeafCount, frustumPlanes);
+    }
+    else
+    {
+        for (uint lightIndex = threadIndex; lightIndex < MAX_LIGHTS; lightIndex += WORK_GROUP_THREADS)
+            CullLight(lightIndex, frustumPlanes);
     }
 
     GroupMemoryBarrierWithGroupSync();
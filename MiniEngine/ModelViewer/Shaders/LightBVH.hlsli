@@ -0,0 +1,48 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Developed by Minigraph
+//
+
+// Shared by the passes that build the light BVH each frame:  sort the lights by the Morton code of their
+// centers, write a leaf per light in that order, then merge the children of each level up to the root.
+
+#include "LightGrid.hlsli"
+
+#define LightBVH_RootSig \
+    "RootFlags(0), " \
+    "RootConstants(b0, num32BitConstants = 10), " \
+    "DescriptorTable(SRV(t0, numDescriptors = 2))," \
+    "DescriptorTable(UAV(u0, numDescriptors = 1))"
+
+cbuffer CSConstants : register(b0)
+{
+    float3 BoundsMin;
+    uint NumLights;
+    float3 BoundsScale;     // 1 / (max - min)
+    uint LeafCount;
+    uint FirstNode;         // first node of the level being built
+    uint NodeCount;         // nodes in that level
+};
+
+// Spreads the low 10 bits of v out to every third bit
+uint ExpandBits(uint v)
+{
+    v = (v * 0x00010001u) & 0xFF0000FFu;
+    v = (v * 0x00000101u) & 0x0F00F00Fu;
+    v = (v * 0x00000011u) & 0xC30C30C3u;
+    v = (v * 0x00000005u) & 0x49249249u;
+    return v;
+}
+
+// 30-bit Morton code of a point in the unit cube
+uint MortonCode(float3 p)
+{
+    uint3 q = (uint3)clamp(p * 1024.0, 0.0, 1023.0);
+    return ExpandBits(q.x) * 4 + ExpandBits(q.y) * 2 + ExpandBits(q.z);
+}
@@ -0,0 +1,30 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Developed by Minigraph
+//
+
+// Writes a Morton code and light index pair for every light to be sorted by BitonicSort
+
+#include "LightBVH.hlsli"
+
+StructuredBuffer<LightData> lightBuffer : register(t0);
+RWByteAddressBuffer sortKeys : register(u0);
+
+[RootSignature(LightBVH_RootSig)]
+[numthreads(64, 1, 1)]
+void main( uint3 DTid : SV_DispatchThreadID )
+{
+    if (DTid.x >= NumLights)
+        return;
+
+    float3 center = (lightBuffer[DTid.x].pos - BoundsMin) * BoundsScale;
+
+    // 64-bit sort elements keep the key in the upper half
+    sortKeys.Store2(DTid.x * 8, uint2(DTid.x, MortonCode(center)));
+}
@@ -0,0 +1,49 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Developed by Minigraph
+//
+
+// Writes the bottom level of the light BVH from the lights in sorted order
+
+#include "LightBVH.hlsli"
+
+#define FLT_MAX         3.402823466e+38F        // max value
+
+StructuredBuffer<LightData> lightBuffer : register(t0);
+ByteAddressBuffer sortKeys : register(t1);
+RWStructuredBuffer<LightBVHNode> lightBVH : register(u0);
+
+[RootSignature(LightBVH_RootSig)]
+[numthreads(64, 1, 1)]
+void main( uint3 DTid : SV_DispatchThreadID )
+{
+    if (DTid.x >= LeafCount)
+        return;
+
+    LightBVHNode leaf;
+    leaf.pad = 0;
+
+    if (DTid.x < NumLights)
+    {
+        uint lightIndex = sortKeys.Load(DTid.x * 8);
+        LightData lightData = lightBuffer[lightIndex];
+        float radius = sqrt(lightData.radiusSq);
+        leaf.aabbMin = lightData.pos - radius;
+        leaf.aabbMax = lightData.pos + radius;
+        leaf.lightIndex = lightIndex;
+    }
+    else
+    {
+        leaf.aabbMin = FLT_MAX;
+        leaf.aabbMax = -FLT_MAX;
+        leaf.lightIndex = 0;
+    }
+
+    lightBVH[LeafCount - 1 + DTid.x] = leaf;
+}
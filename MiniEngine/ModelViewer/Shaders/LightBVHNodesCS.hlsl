@@ -0,0 +1,36 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Developed by Minigraph
+//
+
+// Builds one level of the light BVH by merging the bounds of the children below it
+
+#include "LightBVH.hlsli"
+
+RWStructuredBuffer<LightBVHNode> lightBVH : register(u0);
+
+[RootSignature(LightBVH_RootSig)]
+[numthreads(64, 1, 1)]
+void main( uint3 DTid : SV_DispatchThreadID )
+{
+    if (DTid.x >= NodeCount)
+        return;
+
+    uint node = FirstNode + DTid.x;
+    LightBVHNode left = lightBVH[2 * node + 1];
+    LightBVHNode right = lightBVH[2 * node + 2];
+
+    LightBVHNode merged;
+    merged.aabbMin = min(left.aabbMin, right.aabbMin);
+    merged.aabbMax = max(left.aabbMax, right.aabbMax);
+    merged.lightIndex = 0;
+    merged.pad = 0;
+
+    lightBVH[node] = merged;
+}
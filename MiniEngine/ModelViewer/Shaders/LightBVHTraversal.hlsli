@@ -0,0 +1,67 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Developed by Minigraph
+//
+
+// Culls the light BVH against a frustum with a whole thread group.  The includer declares the node buffer
+// as lightBVH and defines CullLight(lightIndex, frustumPlanes), which is called for every leaf whose bounds
+// overlap the frustum.
+
+bool BoundsOverlapFrustum(LightBVHNode node, float4 frustumPlanes[6])
+{
+    float3 center = (node.aabbMin + node.aabbMax) * 0.5;
+    float3 extent = (node.aabbMax - node.aabbMin) * 0.5;
+
+    // Empty bounds have a negative extent, which fails every plane
+    for (int n = 0; n < 6; n++)
+    {
+        float d = dot(center, frustumPlanes[n].xyz) + frustumPlanes[n].w;
+        if (d < -dot(extent, abs(frustumPlanes[n].xyz)))
+            return false;
+    }
+    return true;
+}
+
+// Every thread walks its own subtree starting at the deepest level that has no more nodes than threads.  The
+// tree is complete, so the walk needs no stack:  after a node is done, climb out of right children and step
+// over to the next sibling.
+void TraverseLightBVH(uint threadIndex, uint numThreads, uint leafCount, float4 frustumPlanes[6])
+{
+    uint subtreeCount = min(leafCount, 1u << firstbithigh(numThreads));
+    if (threadIndex >= subtreeCount)
+        return;
+
+    uint firstLeaf = leafCount - 1;
+    uint subtreeRoot = subtreeCount - 1 + threadIndex;
+    uint node = subtreeRoot;
+
+    while (true)
+    {
+        LightBVHNode nodeData = lightBVH[node];
+        if (BoundsOverlapFrustum(nodeData, frustumPlanes))
+        {
+            if (node < firstLeaf)
+            {
+                node = 2 * node + 1;
+                continue;
+            }
+
+            CullLight(nodeData.lightIndex, frustumPlanes);
+        }
+
+        // right children have even indices
+        while (node != subtreeRoot && (node & 1) == 0)
+            node = (node - 1) / 2;
+
+        if (node == subtreeRoot)
+            break;
+
+        ++node;
+    }
+}
@@ -25,10 +25,22 @@ struct LightData
 
     float3 coneDir;
     float2 coneAngles; // x = 1.0f / (cos(coneInner) - cos(coneOuter)), y = cos(coneOuter)
+    uint shadowSlice;  // Slice of the shadow map array, or 0xFFFFFFFF when the light has no map
 
     float4x4 shadowTextureMatrix;
 };
 
+// The light BVH is a complete binary tree stored implicitly in an array:  node n has children 2n+1 and 2n+2,
+// and the last LeafCount nodes are the leaves.  Leaves hold the bounds of one light each, in Morton order, so
+// that neighboring leaves are close in space.  Leaves past the last light have inverted (empty) bounds.
+struct LightBVHNode
+{
+    float3 aabbMin;
+    uint lightIndex;    // leaves only
+    float3 aabbMax;
+    uint pad;
+};
+
 uint2 GetTilePos(float2 pos, float2 invTileDim)
 {
     return pos * invTileDim;
@@ -41,3 +53,20 @@ uint GetTileOffset(uint tileIndex)
 {
     return tileIndex * TILE_SIZE;
 }
+
+// Clustered light grid: every CLUSTER_TILE_DIM square of pixels is split into CLUSTER_SLICES clusters spaced
+// logarithmically in view depth.  A cluster stores an offset into a shared list of light indices followed by
+// its sphere, cone, and shadowed cone counts packed like a tile header.  The first uint of the index list is
+// the allocation counter, so list offsets start at one.
+#define CLUSTER_TILE_DIM 64
+#define CLUSTER_SLICES 16
+#define MAX_LIGHTS_PER_CLUSTER_TYPE 255
+
+uint GetClusterSlice(float viewZ, float2 sliceScaleBias)
+{
+    return (uint)clamp(log2(viewZ) * sliceScaleBias.x + sliceScaleBias.y, 0.0, CLUSTER_SLICES - 1);
+}
+uint GetClusterIndex(uint2 tilePos, uint slice, uint2 tileCount)
+{
+    return (slice * tileCount.y + tilePos.y) * tileCount.x + tilePos.x;
+}
@@ -13,12 +13,17 @@
 //
 
 #include "ModelViewerRS.hlsli"
+#include "VertexDecode.hlsli"
 
 cbuffer VSConstants : register(b0)
 {
     float4x4 modelToProjection;
     float4x4 modelToShadow;
     float3 ViewerPos;
+
+    // The right eye of stereo draws, whose left eye uses the constants above
+    float4x4 modelToProjectionRight;
+    float3 ViewerPosRight;
 };
 
 struct VSInput
@@ -40,22 +45,29 @@ struct VSOutput
     float3 normal : Normal;
     float3 tangent : Tangent;
     float3 bitangent : Bitangent;
+    uint viewport : SV_ViewportArrayIndex;
 };
 
 [RootSignature(ModelViewer_RootSig)]
-VSOutput main(VSInput vsInput)
+VSOutput main(VSInput vsInput, uint instanceID : SV_InstanceID)
 {
     VSOutput vsOutput;
 
-    vsOutput.position = mul(modelToProjection, float4(vsInput.position, 1.0));
-    vsOutput.worldPos = vsInput.position;
+    uint eye = GetStereoEye(instanceID);
+    instanceID = GetStereoInstance(instanceID);
+
+    float3 position = InstancePosition(DecodePosition(vsInput.position), instanceID);
+
+    vsOutput.position = mul(eye ? modelToProjectionRight : modelToProjection, float4(position, 1.0));
+    vsOutput.worldPos = position;
     vsOutput.texCoord = vsInput.texcoord0;
-    vsOutput.viewDir = vsInput.position - ViewerPos;
-    vsOutput.shadowCoord = mul(modelToShadow, float4(vsInput.position, 1.0)).xyz;
+    vsOutput.viewDir = position - (eye ? ViewerPosRight : ViewerPos);
+    vsOutput.shadowCoord = mul(modelToShadow, float4(position, 1.0)).xyz;
 
-    vsOutput.normal = vsInput.normal;
-    vsOutput.tangent = vsInput.tangent;
-    vsOutput.bitangent = vsInput.bitangent;
+    vsOutput.normal = InstanceDirection(DecodeDirection(vsInput.normal), instanceID);
+    vsOutput.tangent = InstanceDirection(DecodeDirection(vsInput.tangent), instanceID);
+    vsOutput.bitangent = InstanceDirection(DecodeDirection(vsInput.bitangent), instanceID);
+    vsOutput.viewport = eye;
 
     return vsOutput;
 }
@@ -0,0 +1,52 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Developed by Minigraph
+//
+// Draws a mesh's bounding box for an occlusion query.  Every instance is one box, expanded from the
+// vertex ID as a 14 vertex triangle strip, so no vertex or index buffer is needed.
+//
+
+#define OcclusionQueries_RootSig \
+    "RootFlags(0), " \
+    "CBV(b0, visibility = SHADER_VISIBILITY_VERTEX), " \
+    "RootConstants(b1, num32BitConstants = 1, visibility = SHADER_VISIBILITY_VERTEX), " \
+    "DescriptorTable(SRV(t0, numDescriptors = 1), visibility = SHADER_VISIBILITY_VERTEX)"
+
+// must keep in sync with C++
+struct ProxyBox
+{
+    float3 BoundsMin;
+    float Pad0;
+    float3 BoundsMax;
+    float Pad1;
+};
+
+cbuffer VSConstants : register(b0)
+{
+    float4x4 ViewProj;
+};
+
+cbuffer BatchConstants : register(b1)
+{
+    uint FirstMesh;     // SV_InstanceID does not include the start instance
+};
+
+StructuredBuffer<ProxyBox> ProxyBoxes : register(t0);
+
+[RootSignature(OcclusionQueries_RootSig)]
+float4 main( uint VertexID : SV_VertexID, uint InstanceID : SV_InstanceID ) : SV_Position
+{
+    ProxyBox Box = ProxyBoxes[FirstMesh + InstanceID];
+
+    // Each bit selects the max or min corner of one axis for the vertex with that index
+    uint Bit = 1u << VertexID;
+    float3 Corner = float3((0x287a & Bit) != 0, (0x02af & Bit) != 0, (0x31e3 & Bit) != 0);
+
+    return mul(ViewProj, float4(lerp(Box.BoundsMin, Box.BoundsMax, Corner), 1.0));
+}
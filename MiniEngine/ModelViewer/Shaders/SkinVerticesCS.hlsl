@@ -0,0 +1,80 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Developed by Minigraph
+//
+// Blends the skin matrices of up to four bones per vertex and writes the transformed vertices in the layout
+// they were read from, so that every pass can draw them like the model's own vertices.
+//
+
+#include "SkinningRS.hlsli"
+
+// must keep in sync with C++ (VertexFormats::SkinnedVertex)
+struct SkinnedVertex
+{
+    float3 Position;
+    float2 Texcoord0;
+    float3 Normal;
+    float3 Tangent;
+    float3 Bitangent;
+    uint BlendIndices;  // four bytes each
+    uint BlendWeights;
+};
+
+cbuffer CSConstants : register(b0)
+{
+    uint VertexCount;
+    uint BoneCount;
+};
+
+StructuredBuffer<SkinnedVertex> SourceVertices : register(t0);
+StructuredBuffer<float4> SkinMatrices : register(t1);
+RWStructuredBuffer<SkinnedVertex> SkinnedVertices : register(u0);
+
+uint4 UnpackBytes( uint Packed )
+{
+    return uint4(Packed, Packed >> 8, Packed >> 16, Packed >> 24) & 0xFF;
+}
+
+[RootSignature(Skinning_RootSig)]
+[numthreads( 64, 1, 1 )]
+void main( uint DTid : SV_DispatchThreadID )
+{
+    if (DTid >= VertexCount)
+        return;
+
+    SkinnedVertex V = SourceVertices[DTid];
+
+    // The vertices of meshes that no bone moves have no weights and stay in place
+    if (V.BlendWeights != 0)
+    {
+        uint4 Indices = min(UnpackBytes(V.BlendIndices), BoneCount - 1);
+        float4 Weights = UnpackBytes(V.BlendWeights) / 255.0;
+
+        float4 Row0 = 0.0, Row1 = 0.0, Row2 = 0.0;
+
+        [unroll]
+        for (uint i = 0; i < 4; ++i)
+        {
+            Row0 += Weights[i] * SkinMatrices[Indices[i] * 3 + 0];
+            Row1 += Weights[i] * SkinMatrices[Indices[i] * 3 + 1];
+            Row2 += Weights[i] * SkinMatrices[Indices[i] * 3 + 2];
+        }
+
+        float3x4 Skin = float3x4(Row0, Row1, Row2);
+        V.Position = mul(Skin, float4(V.Position, 1.0));
+
+        // Without non-uniform scale, the upper 3x3 transforms normals as well as tangents
+        float3x3 Rotation = (float3x3)Skin;
+        V.Normal = normalize(mul(Rotation, V.Normal));
+        V.Tangent = normalize(mul(Rotation, V.Tangent));
+        V.Bitangent = normalize(mul(Rotation, V.Bitangent));
+    }
+
+    SkinnedVertices[DTid] = V;
+}
@@ -0,0 +1,115 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Developed by Minigraph
+//
+// Evaluates the pose of a skeleton at a point in time between two samples of a clip, one thread per bone.  Each
+// bone's transform relative to its parent is blended from the two samples, then the hierarchy is resolved one
+// depth at a time in group shared memory, parents ahead of children.  Writes a skin matrix per bone.
+//
+
+#include "SkinningRS.hlsli"
+
+#define MAX_BONES 256
+
+// must keep in sync with C++ (Model::Bone and Model::AnimationKey)
+struct Bone
+{
+    float4 InverseBind[3];
+    int Parent;
+    uint Depth;
+    uint2 Reserved;
+};
+
+struct AnimationKey
+{
+    float4 Rotation;
+    float3 Translation;
+    float3 Scale;
+    float2 Reserved;
+};
+
+cbuffer CSConstants : register(b0)
+{
+    uint BoneCount;
+    uint MaxDepth;
+    uint FirstKey0;     // the keys of the samples before and after the time to evaluate
+    uint FirstKey1;
+    float Blend;        // from the first sample to the second
+};
+
+StructuredBuffer<Bone> Bones : register(t0);
+StructuredBuffer<AnimationKey> Keys : register(t1);
+RWStructuredBuffer<float4> SkinMatrices : register(u0);
+
+// Model space transforms, one row per array so that neighboring bones do not share memory banks
+groupshared float4 gs_Row0[MAX_BONES];
+groupshared float4 gs_Row1[MAX_BONES];
+groupshared float4 gs_Row2[MAX_BONES];
+
+// Matrices are the top three rows of 4x4 matrices that transform column vectors
+float3x4 Concatenate( float3x4 A, float3x4 B )
+{
+    return mul(A, float4x4(B[0], B[1], B[2], float4(0, 0, 0, 1)));
+}
+
+float3x4 LocalTransform( AnimationKey A, AnimationKey B )
+{
+    // Normalized lerp along the shorter arc is close enough to slerp between neighboring samples
+    float4 Q = normalize(lerp(A.Rotation, dot(A.Rotation, B.Rotation) < 0.0 ? -B.Rotation : B.Rotation, Blend));
+    float3 T = lerp(A.Translation, B.Translation, Blend);
+    float3 S = lerp(A.Scale, B.Scale, Blend);
+
+    float3x3 R = float3x3(
+        1.0 - 2.0 * (Q.y * Q.y + Q.z * Q.z), 2.0 * (Q.x * Q.y - Q.w * Q.z), 2.0 * (Q.x * Q.z + Q.w * Q.y),
+        2.0 * (Q.x * Q.y + Q.w * Q.z), 1.0 - 2.0 * (Q.x * Q.x + Q.z * Q.z), 2.0 * (Q.y * Q.z - Q.w * Q.x),
+        2.0 * (Q.x * Q.z - Q.w * Q.y), 2.0 * (Q.y * Q.z + Q.w * Q.x), 1.0 - 2.0 * (Q.x * Q.x + Q.y * Q.y));
+
+    // Scale, then rotate, then translate
+    return float3x4(float4(R[0] * S, T.x), float4(R[1] * S, T.y), float4(R[2] * S, T.z));
+}
+
+[RootSignature(Skinning_RootSig)]
+[numthreads( MAX_BONES, 1, 1 )]
+void main( uint GI : SV_GroupIndex )
+{
+    const bool IsBone = GI < BoneCount;
+
+    Bone B = (Bone)0;
+    float3x4 Local = (float3x4)0;
+    if (IsBone)
+    {
+        B = Bones[GI];
+        Local = LocalTransform(Keys[FirstKey0 + GI], Keys[FirstKey1 + GI]);
+    }
+
+    // Every parent is one level up, so it was resolved by the previous iteration
+    for (uint Depth = 0; Depth <= MaxDepth; ++Depth)
+    {
+        if (IsBone && B.Depth == Depth)
+        {
+            float3x4 Global = Local;
+            if (B.Parent >= 0)
+                Global = Concatenate(float3x4(gs_Row0[B.Parent], gs_Row1[B.Parent], gs_Row2[B.Parent]), Local);
+
+            gs_Row0[GI] = Global[0];
+            gs_Row1[GI] = Global[1];
+            gs_Row2[GI] = Global[2];
+        }
+        GroupMemoryBarrierWithGroupSync();
+    }
+
+    if (!IsBone)
+        return;
+
+    float3x4 Global = float3x4(gs_Row0[GI], gs_Row1[GI], gs_Row2[GI]);
+    float3x4 Skin = Concatenate(Global, float3x4(B.InverseBind[0], B.InverseBind[1], B.InverseBind[2]));
+    SkinMatrices[GI * 3 + 0] = Skin[0];
+    SkinMatrices[GI * 3 + 1] = Skin[1];
+    SkinMatrices[GI * 3 + 2] = Skin[2];
+}
@@ -8,8 +8,10 @@
 //
 // Developed by Minigraph
 //
-// Author:  James Stanard 
 
-#define LOW_RESOLUTION
-#define DISABLE_DEPTH_TESTS
-#include "ParticleTileRenderCS.hlsl"
+#define Skinning_RootSig \
+    "RootFlags(0), " \
+    "CBV(b0), " \
+    "SRV(t0), " \
+    "SRV(t1), " \
+    "UAV(u0)"
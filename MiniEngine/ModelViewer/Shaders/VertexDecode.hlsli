@@ -0,0 +1,103 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Developed by Minigraph
+//
+
+// Per-draw root constants.  Quantized models (model_convert -quantize) store positions as 16-bit UNORM
+// relative to the mesh bounding box and directions as octahedral 16-bit SNORM pairs.  Must keep in sync
+// with MeshConstants in ModelViewer.cpp and the draw arguments written by CullMeshesCS.hlsl.
+cbuffer MeshConstants : register(b1)
+{
+    float3 PositionScale;
+    uint VertexFlags;
+    float3 PositionOffset;
+    uint MaterialIndex;
+};
+
+#define VERTEX_FLAG_QUANTIZED 1
+
+// The rest of the flags identify the draw for the visibility buffer:  bits 1-2 hold the level of detail (0 is the
+// full mesh, see ModelViewer::SelectLod) and bits 16-31 the mesh index.
+#define VERTEX_FLAG_LOD_SHIFT 1
+#define VERTEX_FLAG_MESH_SHIFT 16
+
+// Instanced draws (see InstancedScene.h) place every instance with its own object-to-world matrix.  The root SRV
+// starts at the draw's first instance, because SV_InstanceID does not include StartInstanceLocation.
+#define VERTEX_FLAG_INSTANCED 8
+
+struct InstanceTransform
+{
+    float4 Rows[3];
+};
+StructuredBuffer<InstanceTransform> InstanceTransforms : register(t16);
+
+// Stereo draws have two instances for every instance, even ones for the left eye and odd ones for the right.  The
+// eye is also the viewport (see VSConstants in ModelViewerVS.hlsl).
+#define VERTEX_FLAG_STEREO 16
+
+uint GetStereoEye( uint InstanceID )
+{
+    return VertexFlags & VERTEX_FLAG_STEREO ? InstanceID & 1 : 0;
+}
+
+// The scene instance that a stereo draw's instance is an eye of
+uint GetStereoInstance( uint InstanceID )
+{
+    return VertexFlags & VERTEX_FLAG_STEREO ? InstanceID >> 1 : InstanceID;
+}
+
+uint GetMeshIndex( void )
+{
+    return VertexFlags >> VERTEX_FLAG_MESH_SHIFT;
+}
+
+uint GetLodLevel( void )
+{
+    return (VertexFlags >> VERTEX_FLAG_LOD_SHIFT) & 3;
+}
+
+float3 DecodePosition( float3 Position )
+{
+    return VertexFlags & VERTEX_FLAG_QUANTIZED ? Position * PositionScale + PositionOffset : Position;
+}
+
+float3 OctDecode( float2 e )
+{
+    float3 n = float3(e, 1 - abs(e.x) - abs(e.y));
+    float t = saturate(-n.z);
+    n.xy += n.xy >= 0 ? -t : t;
+    return normalize(n);
+}
+
+// Float models bind three components, quantized ones two
+float3 DecodeDirection( float3 Direction )
+{
+    return VertexFlags & VERTEX_FLAG_QUANTIZED ? OctDecode(Direction.xy) : Direction;
+}
+
+float3 InstancePosition( float3 Position, uint InstanceID )
+{
+    if ((VertexFlags & VERTEX_FLAG_INSTANCED) == 0)
+        return Position;
+
+    InstanceTransform Transform = InstanceTransforms[InstanceID];
+    float4 P = float4(Position, 1.0);
+    return float3(dot(Transform.Rows[0], P), dot(Transform.Rows[1], P), dot(Transform.Rows[2], P));
+}
+
+// Scene instances are only scaled uniformly, so directions don't need the inverse transpose
+float3 InstanceDirection( float3 Direction, uint InstanceID )
+{
+    if ((VertexFlags & VERTEX_FLAG_INSTANCED) == 0)
+        return Direction;
+
+    InstanceTransform Transform = InstanceTransforms[InstanceID];
+    return normalize(float3(dot(Transform.Rows[0].xyz, Direction), dot(Transform.Rows[1].xyz, Direction),
+        dot(Transform.Rows[2].xyz, Direction)));
+}
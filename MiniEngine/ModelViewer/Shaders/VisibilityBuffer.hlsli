@@ -0,0 +1,29 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Developed by Minigraph
+//
+// A visibility buffer texel identifies the triangle that covers the pixel.  The high 14 bits hold the draw key,
+// which is the mesh index times four plus the level of detail plus one, so that zero means nothing was drawn.
+// The low 18 bits hold the primitive index within the draw.  Must keep in sync with VisibilityBuffer.cpp.
+//
+
+#define VISIBILITY_PRIMITIVE_BITS 18
+
+uint PackVisibility( uint MeshIndex, uint LodLevel, uint PrimitiveID )
+{
+    return (MeshIndex * 4 + LodLevel + 1) << VISIBILITY_PRIMITIVE_BITS | PrimitiveID;
+}
+
+void UnpackVisibility( uint Visibility, out uint MeshIndex, out uint LodLevel, out uint PrimitiveID )
+{
+    uint DrawKey = (Visibility >> VISIBILITY_PRIMITIVE_BITS) - 1;
+    MeshIndex = DrawKey >> 2;
+    LodLevel = DrawKey & 3;
+    PrimitiveID = Visibility & ((1 << VISIBILITY_PRIMITIVE_BITS) - 1);
+}
@@ -0,0 +1,37 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Developed by Minigraph
+//
+// Writes the visibility value of the triangle.  ALPHA_TEST makes the cutout variant.
+//
+
+#include "ModelViewerRS.hlsli"
+
+struct VSOutput
+{
+    float4 pos : SV_Position;
+    float2 uv : TexCoord0;
+    nointerpolation uint drawID : DrawID;
+};
+
+#ifdef ALPHA_TEST
+Texture2D<float4> texDiffuse : register(t0);
+SamplerState sampler0 : register(s0);
+#endif
+
+[RootSignature(ModelViewer_RootSig)]
+uint main(VSOutput vsOutput, uint primitiveID : SV_PrimitiveID) : SV_Target0
+{
+#ifdef ALPHA_TEST
+    if (texDiffuse.Sample(sampler0, vsOutput.uv).a < 0.5)
+        discard;
+#endif
+
+    return vsOutput.drawID | primitiveID;
+}
@@ -0,0 +1,226 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Developed by Minigraph
+//
+// Shades every pixel of the visibility buffer with the lighting of ModelViewerPS.hlsl.  Each thread fetches the
+// three vertices of its triangle, reprojects them, and recovers the barycentrics of the pixel center with their
+// screen-space derivatives, so that texture filtering matches the forward pass.  Every material uses the same
+// shading model, so all of them are shaded by one dispatch that indexes the bindless material textures.
+//
+// The unbounded texture table needs shader model 5.1 and /enable_unbounded_descriptor_tables.
+//
+
+#include "ModelViewerLighting.hlsli"
+#include "VertexDecode.hlsli"
+#include "VisibilityBuffer.hlsli"
+
+// b1 belongs to the mesh constants of VertexDecode.hlsli, which is only included for OctDecode()
+#define VisibilityShade_RootSig \
+    "RootFlags(0), " \
+    "CBV(b0), " \
+    "CBV(b2), " \
+    "DescriptorTable(SRV(t64, numDescriptors = 8), SRV(t0, space = 1, numDescriptors = unbounded))," \
+    "DescriptorTable(SRV(t0, numDescriptors = 2), UAV(u0, numDescriptors = 1))," \
+    "SRV(t2), " \
+    "SRV(t3), " \
+    "SRV(t4), " \
+    "StaticSampler(s0, maxAnisotropy = 8)," \
+    "StaticSampler(s1," \
+        "addressU = TEXTURE_ADDRESS_CLAMP," \
+        "addressV = TEXTURE_ADDRESS_CLAMP," \
+        "addressW = TEXTURE_ADDRESS_CLAMP," \
+        "comparisonFunc = COMPARISON_GREATER_EQUAL," \
+        "filter = FILTER_MIN_MAG_LINEAR_MIP_POINT)"
+
+cbuffer ShadeConstants : register(b2)
+{
+    float4x4 ViewProj;
+    float4x4 ModelToShadow;     // First sun shadow cascade
+    float3 ViewerPos;
+    uint VertexStride;
+    float2 ViewportOrigin;      // Top left corner of the viewport, which includes the TAA jitter
+    float2 InvViewportSize;
+    uint2 BufferSize;
+    uint QuantizedVertices;
+}
+
+// Must keep in sync with MeshShadeData in VisibilityBuffer.cpp
+struct MeshShadeData
+{
+    float3 PositionScale;
+    uint MaterialIndex;
+    float3 PositionOffset;
+    uint BaseVertex;
+    uint4 StartIndex;           // x is the full mesh, yzw the levels of detail
+};
+
+// Six textures per material, in the order of ModelViewerPS.hlsl
+Texture2D<float3> MaterialTextures[] : register(t0, space1);
+
+Texture2D<uint> VisibilityBuffer : register(t0);
+Texture2D<float> DepthBuffer : register(t1);
+StructuredBuffer<MeshShadeData> MeshData : register(t2);
+ByteAddressBuffer Indices : register(t3);
+ByteAddressBuffer Vertices : register(t4);
+RWTexture2D<float3> SceneColor : register(u0);
+
+struct Vertex
+{
+    float3 Position;
+    float2 UV;
+    float3 Normal;
+    float3 Tangent;
+    float3 Bitangent;
+};
+
+uint LoadIndex( uint Index )
+{
+    uint Address = Index * 2;
+    uint Pair = Indices.Load(Address & ~3);
+    return Address & 2 ? Pair >> 16 : Pair & 0xFFFF;
+}
+
+float2 UnpackSnorm2( uint Packed )
+{
+    int2 Value = int2(Packed << 16, Packed) >> 16;
+    return max(Value / 32767.0, -1.0);
+}
+
+// Decode either vertex layout of ModelViewer::Startup()
+Vertex LoadVertex( uint Index, MeshShadeData Mesh )
+{
+    uint Address = (Mesh.BaseVertex + Index) * VertexStride;
+    Vertex v;
+
+    if (QuantizedVertices)
+    {
+        uint4 Packed = Vertices.Load4(Address);
+        uint2 PackedTB = Vertices.Load2(Address + 16);
+        float3 Position = float3(Packed.x & 0xFFFF, Packed.x >> 16, Packed.y & 0xFFFF) / 65535.0;
+        v.Position = Position * Mesh.PositionScale + Mesh.PositionOffset;
+        v.UV = f16tof32(uint2(Packed.z, Packed.z >> 16));
+        v.Normal = OctDecode(UnpackSnorm2(Packed.w));
+        v.Tangent = OctDecode(UnpackSnorm2(PackedTB.x));
+        v.Bitangent = OctDecode(UnpackSnorm2(PackedTB.y));
+    }
+    else
+    {
+        v.Position = asfloat(Vertices.Load3(Address));
+        v.UV = asfloat(Vertices.Load2(Address + 12));
+        v.Normal = asfloat(Vertices.Load3(Address + 20));
+        v.Tangent = asfloat(Vertices.Load3(Address + 32));
+        v.Bitangent = asfloat(Vertices.Load3(Address + 44));
+    }
+
+    return v;
+}
+
+// Perspective-correct barycentrics of a point in NDC, and how much they change one pixel to the right and one
+// pixel down.  Attribute derivatives are the same weighted sums of the vertex attributes.
+struct Barycentrics
+{
+    float3 Lambda;
+    float3 Ddx;
+    float3 Ddy;
+};
+
+Barycentrics ComputeBarycentrics( float4 Clip0, float4 Clip1, float4 Clip2, float2 NDC )
+{
+    float3 InvW = rcp(float3(Clip0.w, Clip1.w, Clip2.w));
+    float2 P0 = Clip0.xy * InvW.x;
+    float2 P1 = Clip1.xy * InvW.y;
+    float2 P2 = Clip2.xy * InvW.z;
+
+    // Barycentrics divided by W are linear in NDC
+    float InvDet = rcp(determinant(float2x2(P2 - P1, P0 - P1)));
+    float3 DxOverW = float3(P1.y - P2.y, P2.y - P0.y, P0.y - P1.y) * InvDet * InvW;
+    float3 DyOverW = float3(P2.x - P1.x, P0.x - P2.x, P1.x - P0.x) * InvDet * InvW;
+    float DxInvW = dot(DxOverW, 1.0);
+    float DyInvW = dot(DyOverW, 1.0);
+
+    float2 Delta = NDC - P0;
+    float3 LambdaOverW = float3(InvW.x, 0.0, 0.0) + Delta.x * DxOverW + Delta.y * DyOverW;
+    float InterpInvW = InvW.x + Delta.x * DxInvW + Delta.y * DyInvW;
+
+    Barycentrics Result;
+    Result.Lambda = LambdaOverW / InterpInvW;
+
+    // NDC Y points up while pixel rows go down
+    float2 PixelStep = 2.0 * InvViewportSize * float2(1.0, -1.0);
+    Result.Ddx = (LambdaOverW + PixelStep.x * DxOverW) / (InterpInvW + PixelStep.x * DxInvW) - Result.Lambda;
+    Result.Ddy = (LambdaOverW + PixelStep.y * DyOverW) / (InterpInvW + PixelStep.y * DyInvW) - Result.Lambda;
+    return Result;
+}
+
+float2 Interpolate( float3 Weights, float2 A0, float2 A1, float2 A2 )
+{
+    return A0 * Weights.x + A1 * Weights.y + A2 * Weights.z;
+}
+
+float3 Interpolate( float3 Weights, float3 A0, float3 A1, float3 A2 )
+{
+    return A0 * Weights.x + A1 * Weights.y + A2 * Weights.z;
+}
+
+[RootSignature(VisibilityShade_RootSig)]
+[numthreads( 8, 8, 1 )]
+void main( uint3 DTid : SV_DispatchThreadID )
+{
+    uint2 pixelPos = DTid.xy;
+    if (any(pixelPos >= BufferSize))
+        return;
+
+    uint Visibility = VisibilityBuffer[pixelPos];
+    if (Visibility == 0)
+        return;
+
+    uint MeshIndex, LodLevel, PrimitiveID;
+    UnpackVisibility(Visibility, MeshIndex, LodLevel, PrimitiveID);
+    MeshShadeData Mesh = MeshData[MeshIndex];
+
+    uint FirstIndex = Mesh.StartIndex[LodLevel] + PrimitiveID * 3;
+    Vertex V0 = LoadVertex(LoadIndex(FirstIndex + 0), Mesh);
+    Vertex V1 = LoadVertex(LoadIndex(FirstIndex + 1), Mesh);
+    Vertex V2 = LoadVertex(LoadIndex(FirstIndex + 2), Mesh);
+
+    // The rasterizer sampled the pixel center relative to the jittered viewport
+    float2 NDC = (pixelPos + 0.5 - ViewportOrigin) * InvViewportSize * float2(2.0, -2.0) + float2(-1.0, 1.0);
+    Barycentrics Bary = ComputeBarycentrics(
+        mul(ViewProj, float4(V0.Position, 1.0)),
+        mul(ViewProj, float4(V1.Position, 1.0)),
+        mul(ViewProj, float4(V2.Position, 1.0)), NDC);
+
+    float3 worldPos = Interpolate(Bary.Lambda, V0.Position, V1.Position, V2.Position);
+    float2 uv = Interpolate(Bary.Lambda, V0.UV, V1.UV, V2.UV);
+    float2 uvDdx = Interpolate(Bary.Ddx, V0.UV, V1.UV, V2.UV);
+    float2 uvDdy = Interpolate(Bary.Ddy, V0.UV, V1.UV, V2.UV);
+
+    // Diffuse, specular and normal maps are the first, second and fourth textures
+    uint TextureBase = Mesh.MaterialIndex * 6;
+    float3 diffuseAlbedo = MaterialTextures[NonUniformResourceIndex(TextureBase + 0)].SampleGrad(sampler0, uv, uvDdx, uvDdy);
+
+    float gloss = 128.0;
+    float3 normal;
+    {
+        normal = MaterialTextures[NonUniformResourceIndex(TextureBase + 3)].SampleGrad(sampler0, uv, uvDdx, uvDdy) * 2.0 - 1.0;
+        AntiAliasSpecular(normal, gloss);
+        float3x3 tbn = float3x3(
+            normalize(Interpolate(Bary.Lambda, V0.Tangent, V1.Tangent, V2.Tangent)),
+            normalize(Interpolate(Bary.Lambda, V0.Bitangent, V1.Bitangent, V2.Bitangent)),
+            normalize(Interpolate(Bary.Lambda, V0.Normal, V1.Normal, V2.Normal)));
+        normal = normalize(mul(normal, tbn));
+    }
+
+    float specularMask = MaterialTextures[NonUniformResourceIndex(TextureBase + 1)].SampleGrad(sampler0, uv, uvDdx, uvDdy).g;
+    float3 viewDir = normalize(worldPos - ViewerPos);
+    float3 shadowCoord = mul(ModelToShadow, float4(worldPos, 1.0)).xyz;
+
+    SceneColor[pixelPos] = ComputeLighting( pixelPos, DepthBuffer[pixelPos], diffuseAlbedo, specularMask, gloss,
+        normal, viewDir, worldPos, shadowCoord );
+}
@@ -0,0 +1,48 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Developed by Minigraph
+//
+// Vertex shader of the visibility buffer's geometry pass.  The draw's half of the visibility value comes from
+// the mesh constants, so it is the same for every vertex.
+//
+
+#include "ModelViewerRS.hlsli"
+#include "VertexDecode.hlsli"
+#include "VisibilityBuffer.hlsli"
+
+cbuffer VSConstants : register(b0)
+{
+    float4x4 modelToProjection;
+};
+
+struct VSInput
+{
+    float3 position : POSITION;
+    float2 texcoord0 : TEXCOORD;
+    float3 normal : NORMAL;
+    float3 tangent : TANGENT;
+    float3 bitangent : BITANGENT;
+};
+
+struct VSOutput
+{
+    float4 pos : SV_Position;
+    float2 uv : TexCoord0;
+    nointerpolation uint drawID : DrawID;
+};
+
+[RootSignature(ModelViewer_RootSig)]
+VSOutput main(VSInput vsInput)
+{
+    VSOutput vsOutput;
+    vsOutput.pos = mul(modelToProjection, float4(DecodePosition(vsInput.position), 1.0));
+    vsOutput.uv = vsInput.texcoord0;
+    vsOutput.drawID = PackVisibility(GetMeshIndex(), GetLodLevel(), 0);
+    return vsOutput;
+}
@@ -33,7 +33,7 @@ Texture2D<float3> texNormal            : register(t3);
 //Texture2D<float4> texLightmap        : register(t4);
 //Texture2D<float4> texReflection    : register(t5);
 Texture2D<float> texSSAO            : register(t64);
-Texture2D<float> texShadow            : register(t65);
+Texture2DArray<float> texShadow        : register(t65);
 
 StructuredBuffer<LightData> lightBuffer : register(t66);
 Texture2DArray<float> lightShadowArrayTex : register(t67);
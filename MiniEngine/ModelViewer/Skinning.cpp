@@ -0,0 +1,156 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Developed by Minigraph
+//
+
+#include "Skinning.h"
+#include "PipelineState.h"
+#include "RootSignature.h"
+#include "CommandContext.h"
+#include "GraphicsCore.h"
+#include "GpuMemory.h"
+#include "Model.h"
+#include "EngineTuning.h"
+#include "EngineProfiling.h"
+#include <algorithm>
+#include <math.h>
+
+#include "CompiledShaders/SkinningPoseCS.h"
+#include "CompiledShaders/SkinVerticesCS.h"
+
+using namespace Graphics;
+
+namespace Skinning
+{
+    BoolVar Animate("Application/Skinning/Animate", true);
+    NumVar PlaybackRate("Application/Skinning/Playback Rate", 1.0f, 0.0f, 4.0f, 0.25f);
+    IntVar Clip("Application/Skinning/Clip", 0, 0, 255);
+
+    RootSignature s_RootSig;
+    ComputePSO s_PoseCS;
+    ComputePSO s_SkinCS;
+}
+
+void Skinning::Initialize( void )
+{
+    s_RootSig.Reset(4, 0);
+    s_RootSig[0].InitAsConstantBuffer(0);
+    s_RootSig[1].InitAsBufferSRV(0);
+    s_RootSig[2].InitAsBufferSRV(1);
+    s_RootSig[3].InitAsBufferUAV(0);
+    s_RootSig.Finalize(L"SkinningRS");
+
+    s_PoseCS.SetRootSignature(s_RootSig);
+    s_PoseCS.SetComputeShader(g_pSkinningPoseCS, sizeof(g_pSkinningPoseCS));
+    s_PoseCS.Finalize();
+
+    s_SkinCS.SetRootSignature(s_RootSig);
+    s_SkinCS.SetComputeShader(g_pSkinVerticesCS, sizeof(g_pSkinVerticesCS));
+    s_SkinCS.Finalize();
+}
+
+void Skinning::Instance::Create( const Model& model )
+{
+    ASSERT(model.IsSkinned() && model.m_BoneCount <= Model::kMaxBones);
+
+    m_Model = &model;
+    m_ClipIndex = 0;
+    m_Time = 0.0f;
+
+    // The pose shader resolves one depth of the skeleton per step
+    m_MaxDepth = 0;
+    for (uint32_t boneIndex = 0; boneIndex < model.m_BoneCount; ++boneIndex)
+        m_MaxDepth = std::max(m_MaxDepth, model.m_pBones[boneIndex].depth);
+
+    GpuMemory::ScopedCategory MemoryCategory(GpuMemory::kGeometry);
+    m_SkinMatrices.Create(L"Skinning::SkinMatrices", model.m_BoneCount * 3, sizeof(float) * 4);
+    m_VertexBuffer.Create(L"Skinning::VertexBuffer", model.m_Header.vertexDataByteSize / model.m_VertexStride, model.m_VertexStride);
+}
+
+void Skinning::Instance::Destroy( void )
+{
+    m_SkinMatrices.Destroy();
+    m_VertexBuffer.Destroy();
+    m_Model = nullptr;
+}
+
+void Skinning::Instance::SetClip( uint32_t ClipIndex )
+{
+    ClipIndex = std::min(ClipIndex, m_Model->m_AnimationClipCount - 1);
+    if (ClipIndex != m_ClipIndex)
+    {
+        m_ClipIndex = ClipIndex;
+        m_Time = 0.0f;
+    }
+}
+
+void Skinning::Instance::Advance( float DeltaTime )
+{
+    const Model::AnimationClip& clip = m_Model->m_pAnimationClips[m_ClipIndex];
+    m_Time = clip.duration > 0.0f ? fmodf(m_Time + DeltaTime, clip.duration) : 0.0f;
+}
+
+void Skinning::Instance::Update( ComputeContext& Context )
+{
+    ScopedTimer _prof(L"Skinning", Context);
+
+    const Model::AnimationClip& clip = m_Model->m_pAnimationClips[m_ClipIndex];
+    const uint32_t BoneCount = m_Model->m_BoneCount;
+
+    // Blend the samples on either side of the current time
+    const float Sample = m_Time * clip.sampleRate;
+    const uint32_t Sample0 = std::min((uint32_t)Sample, clip.sampleCount - 1);
+    const uint32_t Sample1 = std::min(Sample0 + 1, clip.sampleCount - 1);
+
+    __declspec(align(16)) struct
+    {
+        uint32_t BoneCount;
+        uint32_t MaxDepth;
+        uint32_t FirstKey0;
+        uint32_t FirstKey1;
+        float Blend;
+    } poseConstants;
+
+    poseConstants.BoneCount = BoneCount;
+    poseConstants.MaxDepth = m_MaxDepth;
+    poseConstants.FirstKey0 = clip.firstKey + Sample0 * BoneCount;
+    poseConstants.FirstKey1 = clip.firstKey + Sample1 * BoneCount;
+    poseConstants.Blend = Sample1 > Sample0 ? Sample - (float)Sample0 : 0.0f;
+
+    __declspec(align(16)) struct
+    {
+        uint32_t VertexCount;
+        uint32_t BoneCount;
+    } skinConstants;
+
+    skinConstants.VertexCount = (uint32_t)m_VertexBuffer.GetElementCount();
+    skinConstants.BoneCount = BoneCount;
+
+    Context.SetRootSignature(s_RootSig);
+
+    // The model's bones, keys and vertices stay in GENERIC_READ, which compute shaders can read
+    Context.TransitionResource(m_SkinMatrices, D3D12_RESOURCE_STATE_UNORDERED_ACCESS, true);
+    Context.SetPipelineState(s_PoseCS);
+    Context.SetDynamicConstantBufferView(0, sizeof(poseConstants), &poseConstants);
+    Context.SetBufferSRV(1, m_Model->m_BoneBuffer);
+    Context.SetBufferSRV(2, m_Model->m_AnimationKeyBuffer);
+    Context.SetBufferUAV(3, m_SkinMatrices);
+    Context.Dispatch(1, 1, 1);
+
+    Context.TransitionResource(m_SkinMatrices, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+    Context.TransitionResource(m_VertexBuffer, D3D12_RESOURCE_STATE_UNORDERED_ACCESS, true);
+    Context.SetPipelineState(s_SkinCS);
+    Context.SetDynamicConstantBufferView(0, sizeof(skinConstants), &skinConstants);
+    Context.SetBufferSRV(1, m_Model->m_VertexBuffer);
+    Context.SetBufferSRV(2, m_SkinMatrices);
+    Context.SetBufferUAV(3, m_VertexBuffer);
+    Context.Dispatch1D(skinConstants.VertexCount, 64);
+
+    Context.TransitionResource(m_VertexBuffer, D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER);
+}
@@ -0,0 +1,63 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Developed by Minigraph
+//
+
+#pragma once
+
+#include "GpuBuffer.h"
+#include <cstdint>
+
+class Model;
+class ComputeContext;
+class BoolVar;
+class NumVar;
+class IntVar;
+
+// Animates skinned models (see Model::Bone) on the GPU.  Once per frame, one dispatch evaluates the pose of the
+// skeleton and a second one skins every vertex of the model into a vertex buffer of the instance's own.  That
+// buffer has the model's vertex format, so the depth, shadow and color passes all draw it in place of the
+// model's vertex buffer, and the vertices are skinned once no matter how many passes draw them.
+namespace Skinning
+{
+    extern BoolVar Animate;
+    extern NumVar PlaybackRate;
+    extern IntVar Clip;
+
+    void Initialize( void );
+
+    class Instance
+    {
+    public:
+        Instance() : m_Model(nullptr), m_ClipIndex(0), m_Time(0.0f), m_MaxDepth(0) {}
+
+        // The model must be skinned
+        void Create( const Model& model );
+        void Destroy( void );
+
+        // Play the clip from its start.  Out of range clips play the last one.
+        void SetClip( uint32_t ClipIndex );
+
+        // Move the clip's time forward and loop it
+        void Advance( float DeltaTime );
+
+        // Skin the vertices at the current time.  The vertex buffer is ready to draw afterwards.
+        void Update( ComputeContext& Context );
+
+        const StructuredBuffer& GetVertexBuffer( void ) const { return m_VertexBuffer; }
+
+    private:
+        const Model* m_Model;
+        uint32_t m_ClipIndex;
+        float m_Time;
+        uint32_t m_MaxDepth;
+        StructuredBuffer m_SkinMatrices;
+        StructuredBuffer m_VertexBuffer;
+    };
+}
@@ -0,0 +1,208 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Developed by Minigraph
+//
+
+#include "VisibilityBuffer.h"
+#include "PipelineState.h"
+#include "RootSignature.h"
+#include "CommandContext.h"
+#include "GraphicsCore.h"
+#include "BufferManager.h"
+#include "ColorBuffer.h"
+#include "DepthBuffer.h"
+#include "GpuBuffer.h"
+#include "Camera.h"
+#include "Model.h"
+#include "EngineTuning.h"
+#include "EngineProfiling.h"
+#include "ForwardPlusLighting.h"
+
+#include "CompiledShaders/VisibilityShadeCS.h"
+#include "CompiledShaders/VisibilityShadeClusteredCS.h"
+
+using namespace Math;
+using namespace Graphics;
+
+// must keep in sync with HLSL
+struct MeshShadeData
+{
+    XMFLOAT3 positionScale;
+    uint32_t materialIndex;
+    XMFLOAT3 positionOffset;
+    uint32_t baseVertex;
+    uint32_t startIndex[Model::kMaxLods];
+};
+
+// See Shaders/VisibilityBuffer.hlsli
+enum { kPrimitiveBits = 18, kMaxMeshes = (1 << (32 - kPrimitiveBits)) / Model::kMaxLods - 1 };
+
+namespace VisibilityBuffer
+{
+    BoolVar Enable("Application/Visibility Buffer/Enable", false);
+
+    RootSignature s_RootSig;
+    ComputePSO s_ShadeCS;
+    ComputePSO s_ShadeClusteredCS;
+
+    ColorBuffer s_VisibilityBuffer;
+    StructuredBuffer s_MeshData;
+    const Model* s_Model = nullptr;
+}
+
+void VisibilityBuffer::Initialize( const Model& model )
+{
+    ASSERT(model.m_Header.meshCount <= kMaxMeshes, "Too many meshes for the visibility buffer");
+
+    SamplerDesc DefaultSamplerDesc;
+    DefaultSamplerDesc.MaxAnisotropy = 8;
+
+    s_RootSig.Reset(7, 2);
+    s_RootSig[0].InitAsConstantBuffer(0);
+    s_RootSig[1].InitAsConstantBuffer(2);
+    s_RootSig[2].InitAsDescriptorTable(2);
+    s_RootSig[2].SetTableRange(0, D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 64, 8);
+    s_RootSig[2].SetTableRange(1, D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 0, UINT_MAX, 1);
+    s_RootSig[3].InitAsDescriptorTable(2);
+    s_RootSig[3].SetTableRange(0, D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 0, 2);
+    s_RootSig[3].SetTableRange(1, D3D12_DESCRIPTOR_RANGE_TYPE_UAV, 0, 1);
+    s_RootSig[4].InitAsBufferSRV(2);
+    s_RootSig[5].InitAsBufferSRV(3);
+    s_RootSig[6].InitAsBufferSRV(4);
+    s_RootSig.InitStaticSampler(0, DefaultSamplerDesc);
+    s_RootSig.InitStaticSampler(1, SamplerShadowDesc);
+    s_RootSig.Finalize(L"VisibilityShadeRS");
+
+    s_ShadeCS.SetRootSignature(s_RootSig);
+    s_ShadeCS.SetComputeShader(g_pVisibilityShadeCS, sizeof(g_pVisibilityShadeCS));
+    s_ShadeCS.Finalize();
+
+    s_ShadeClusteredCS.SetRootSignature(s_RootSig);
+    s_ShadeClusteredCS.SetComputeShader(g_pVisibilityShadeClusteredCS, sizeof(g_pVisibilityShadeClusteredCS));
+    s_ShadeClusteredCS.Finalize();
+
+    const uint32_t MeshCount = model.m_Header.meshCount;
+    std::vector<MeshShadeData> MeshData(MeshCount);
+    for (uint32_t meshIndex = 0; meshIndex < MeshCount; ++meshIndex)
+    {
+        const Model::Mesh& mesh = model.m_pMesh[meshIndex];
+        MeshShadeData& data = MeshData[meshIndex];
+
+        // Quantized positions are UNORM relative to the mesh bounding box
+        if (model.HasQuantizedVertices())
+        {
+            XMStoreFloat3(&data.positionScale, mesh.boundingBox.max - mesh.boundingBox.min);
+            XMStoreFloat3(&data.positionOffset, mesh.boundingBox.min);
+        }
+        else
+        {
+            data.positionScale = XMFLOAT3(1.0f, 1.0f, 1.0f);
+            data.positionOffset = XMFLOAT3(0.0f, 0.0f, 0.0f);
+        }
+        data.materialIndex = mesh.materialIndex;
+        data.baseVertex = mesh.vertexDataByteOffset / model.m_VertexStride;
+
+        ASSERT(mesh.indexCount / 3 <= (1u << kPrimitiveBits), "Too many triangles for the visibility buffer");
+        data.startIndex[0] = mesh.indexDataByteOffset / sizeof(uint16_t);
+        for (uint32_t level = 1; level < Model::kMaxLods; ++level)
+        {
+            data.startIndex[level] = level <= model.m_LodCount ?
+                model.m_pMeshLods[meshIndex * model.m_LodCount + level - 1].indexDataByteOffset / sizeof(uint16_t) : 0;
+        }
+    }
+
+    s_MeshData.Create(L"VisibilityBuffer::MeshData", MeshCount, sizeof(MeshShadeData), MeshData.data());
+    s_Model = &model;
+
+    UpdateBuffer();
+}
+
+void VisibilityBuffer::Shutdown( void )
+{
+    s_VisibilityBuffer.Destroy();
+    s_MeshData.Destroy();
+    s_Model = nullptr;
+}
+
+void VisibilityBuffer::UpdateBuffer( void )
+{
+    // Resizing idles the GPU before it recreates the scene buffers, so the old buffer is no longer in use
+    if (s_VisibilityBuffer.GetWidth() == g_SceneColorBuffer.GetWidth() &&
+        s_VisibilityBuffer.GetHeight() == g_SceneColorBuffer.GetHeight())
+        return;
+
+    s_VisibilityBuffer.Destroy();
+    s_VisibilityBuffer.Create(L"Visibility Buffer", g_SceneColorBuffer.GetWidth(), g_SceneColorBuffer.GetHeight(), 1,
+        DXGI_FORMAT_R32_UINT);
+}
+
+ColorBuffer& VisibilityBuffer::GetBuffer( void )
+{
+    return s_VisibilityBuffer;
+}
+
+void VisibilityBuffer::GetShadeDescriptors( D3D12_CPU_DESCRIPTOR_HANDLE Handles[kShadeDescriptorCount] )
+{
+    Handles[0] = s_VisibilityBuffer.GetSRV();
+    Handles[1] = g_SceneDepthBuffer.GetDepthSRV();
+    Handles[2] = g_SceneColorBuffer.GetUAV();
+}
+
+void VisibilityBuffer::Shade( ComputeContext& Context, const Camera& camera, const Matrix4& ModelToShadow,
+    const D3D12_VIEWPORT& Viewport, const void* PSConstants, size_t PSConstantsSize, ID3D12DescriptorHeap* Heap,
+    D3D12_GPU_DESCRIPTOR_HANDLE MaterialTable, D3D12_GPU_DESCRIPTOR_HANDLE ShadeTable )
+{
+    ScopedTimer _prof(L"Visibility Shading", Context);
+
+    __declspec(align(16)) struct
+    {
+        Matrix4 ViewProj;
+        Matrix4 ModelToShadow;
+        float ViewerPos[3];
+        uint32_t VertexStride;
+        float ViewportOrigin[2];
+        float InvViewportSize[2];
+        uint32_t BufferSize[2];
+        uint32_t QuantizedVertices;
+    } csConstants;
+
+    csConstants.ViewProj = camera.GetViewProjMatrix();
+    csConstants.ModelToShadow = ModelToShadow;
+    csConstants.ViewerPos[0] = camera.GetPosition().GetX();
+    csConstants.ViewerPos[1] = camera.GetPosition().GetY();
+    csConstants.ViewerPos[2] = camera.GetPosition().GetZ();
+    csConstants.VertexStride = s_Model->m_VertexStride;
+    csConstants.ViewportOrigin[0] = Viewport.TopLeftX;
+    csConstants.ViewportOrigin[1] = Viewport.TopLeftY;
+    csConstants.InvViewportSize[0] = 1.0f / Viewport.Width;
+    csConstants.InvViewportSize[1] = 1.0f / Viewport.Height;
+    csConstants.BufferSize[0] = s_VisibilityBuffer.GetWidth();
+    csConstants.BufferSize[1] = s_VisibilityBuffer.GetHeight();
+    csConstants.QuantizedVertices = s_Model->HasQuantizedVertices() ? 1 : 0;
+
+    Context.SetRootSignature(s_RootSig);
+    Context.SetPipelineState(Lighting::EnableClusters ? s_ShadeClusteredCS : s_ShadeCS);
+
+    Context.TransitionResource(s_VisibilityBuffer, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+    Context.TransitionDepthToReadOnly(g_SceneDepthBuffer);
+    Context.TransitionResource(g_SceneColorBuffer, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+    Context.TransitionResource(s_MeshData, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+
+    // The model's vertex and index buffers stay in the common state and are promoted to shader reads
+    Context.SetDescriptorHeap(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, Heap);
+    Context.SetDynamicConstantBufferView(0, PSConstantsSize, PSConstants);
+    Context.SetDynamicConstantBufferView(1, sizeof(csConstants), &csConstants);
+    Context.SetDescriptorTable(2, MaterialTable);
+    Context.SetDescriptorTable(3, ShadeTable);
+    Context.SetBufferSRV(4, s_MeshData);
+    Context.SetBufferSRV(5, s_Model->m_IndexBuffer);
+    Context.SetBufferSRV(6, s_Model->m_VertexBuffer);
+
+    Context.Dispatch2D(s_VisibilityBuffer.GetWidth(), s_VisibilityBuffer.GetHeight(), 8, 8);
+}
@@ -0,0 +1,53 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Developed by Minigraph
+//
+
+#pragma once
+
+#include <cstdint>
+
+class Model;
+class ColorBuffer;
+class ComputeContext;
+class BoolVar;
+namespace Math
+{
+    class Camera;
+    class Matrix4;
+}
+
+// Renders the main view as a visibility buffer:  the geometry pass writes one 32-bit value per pixel that
+// identifies the mesh, level of detail and triangle (see Shaders/VisibilityBuffer.hlsli), and a compute pass
+// then fetches the triangle's vertices and shades the pixel with the Forward+ light grid.  Overdraw only costs
+// depth testing and a single store, and shading runs once per pixel in 8x8 tiles instead of in 2x2 quads.
+namespace VisibilityBuffer
+{
+    extern BoolVar Enable;
+
+    // The descriptors of Shade()'s second table, which are the visibility buffer and depth SRVs followed by the
+    // scene color UAV.  They change whenever the scene buffers are resized.
+    enum { kShadeDescriptorCount = 3 };
+
+    void Initialize( const Model& model );
+    void Shutdown( void );
+
+    // Match the visibility buffer to the scene color buffer.  Call at the start of each frame, before the shade
+    // descriptors are copied.
+    void UpdateBuffer( void );
+    ColorBuffer& GetBuffer( void );
+    void GetShadeDescriptors( D3D12_CPU_DESCRIPTOR_HANDLE Handles[kShadeDescriptorCount] );
+
+    // Shade every covered pixel into g_SceneColorBuffer.  Both tables must be in Heap:  MaterialTable holds the
+    // eight pass SRVs of ModelViewerPS.hlsl followed by six textures per material, and ShadeTable the descriptors
+    // from GetShadeDescriptors().  The pass SRVs must already be readable by non-pixel shaders.
+    void Shade( ComputeContext& Context, const Math::Camera& camera, const Math::Matrix4& ModelToShadow,
+        const D3D12_VIEWPORT& Viewport, const void* PSConstants, size_t PSConstantsSize, ID3D12DescriptorHeap* Heap,
+        D3D12_GPU_DESCRIPTOR_HANDLE MaterialTable, D3D12_GPU_DESCRIPTOR_HANDLE ShadeTable );
+}
@@ -18,6 +18,8 @@ D3D1211on12::D3D1211on12(UINT width, UINT height, std::wstring name) :
     m_viewport(0.0f, 0.0f, static_cast<float>(width), static_cast<float>(height)),
     m_scissorRect(0, 0, static_cast<LONG>(width), static_cast<LONG>(height)),
     m_rtvDescriptorSize(0),
+    m_useCachedUI(true),
+    m_uiLayerDirty(true),
     m_fenceValues{}
 {
 }
@@ -26,6 +28,7 @@ void D3D1211on12::OnInit()
 {
     LoadPipeline();
     LoadAssets();
+    UpdateWindowText();
 }
 
 // Load the rendering pipeline dependencies.
@@ -118,6 +121,7 @@ void D3D1211on12::LoadPipeline()
     queueDesc.Type = D3D12_COMMAND_LIST_TYPE_DIRECT;
 
     ThrowIfFailed(m_d3d12Device->CreateCommandQueue(&queueDesc, IID_PPV_ARGS(&m_commandQueue)));
+    SetBenchmarkCommandQueue(m_d3d12Device.Get(), m_commandQueue.Get());
     NAME_D3D12_OBJECT(m_commandQueue);
 
     // Describe the swap chain.
@@ -198,6 +202,13 @@ void D3D1211on12::LoadPipeline()
         ThrowIfFailed(m_d3d12Device->CreateDescriptorHeap(&rtvHeapDesc, IID_PPV_ARGS(&m_rtvHeap)));
 
         m_rtvDescriptorSize = m_d3d12Device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_RTV);
+
+        // Describe and create a shader resource view (SRV) heap for the UI layer.
+        D3D12_DESCRIPTOR_HEAP_DESC srvHeapDesc = {};
+        srvHeapDesc.NumDescriptors = 1;
+        srvHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
+        srvHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
+        ThrowIfFailed(m_d3d12Device->CreateDescriptorHeap(&srvHeapDesc, IID_PPV_ARGS(&m_srvHeap)));
     }
 
     // Create frame resources.
@@ -241,15 +252,66 @@ void D3D1211on12::LoadPipeline()
             ThrowIfFailed(m_d3d12Device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&m_commandAllocators[n])));
         }
     }
+
+    // Create the UI layer.
+    {
+        D3D12_RESOURCE_DESC layerDesc = CD3DX12_RESOURCE_DESC::Tex2D(
+            DXGI_FORMAT_R8G8B8A8_UNORM,
+            m_width,
+            m_height,
+            1,
+            1,
+            1,
+            0,
+            D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET);
+
+        ThrowIfFailed(m_d3d12Device->CreateCommittedResource(
+            &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT),
+            D3D12_HEAP_FLAG_NONE,
+            &layerDesc,
+            D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE,
+            nullptr,
+            IID_PPV_ARGS(&m_uiLayer)));
+
+        NAME_D3D12_OBJECT(m_uiLayer);
+
+        m_d3d12Device->CreateShaderResourceView(m_uiLayer.Get(), nullptr, m_srvHeap->GetCPUDescriptorHandleForHeapStart());
+
+        // D3D12 only ever reads the layer, so it enters and leaves D2D's
+        // hands as a pixel shader resource.
+        D3D11_RESOURCE_FLAGS d3d11Flags = { D3D11_BIND_RENDER_TARGET };
+        ThrowIfFailed(m_d3d11On12Device->CreateWrappedResource(
+            m_uiLayer.Get(),
+            &d3d11Flags,
+            D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE,
+            D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE,
+            IID_PPV_ARGS(&m_wrappedUILayer)
+            ));
+
+        ComPtr<IDXGISurface> surface;
+        ThrowIfFailed(m_wrappedUILayer.As(&surface));
+        ThrowIfFailed(m_d2dDeviceContext->CreateBitmapFromDxgiSurface(
+            surface.Get(),
+            &bitmapProperties,
+            &m_d2dUILayer
+            ));
+    }
 }
 
 // Load the sample assets.
 void D3D1211on12::LoadAssets()
 {
-    // Create an empty root signature.
+    // Create a root signature consisting of a descriptor table with a single SRV,
+    // which only the UI composite reads.
     {
+        CD3DX12_DESCRIPTOR_RANGE ranges[1];
+        ranges[0].Init(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 1, 0);
+
+        CD3DX12_ROOT_PARAMETER rootParameters[1];
+        rootParameters[0].InitAsDescriptorTable(1, &ranges[0], D3D12_SHADER_VISIBILITY_PIXEL);
+
         CD3DX12_ROOT_SIGNATURE_DESC rootSignatureDesc;
-        rootSignatureDesc.Init(0, nullptr, 0, nullptr, D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT);
+        rootSignatureDesc.Init(_countof(rootParameters), rootParameters, 0, nullptr, D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT);
 
         ComPtr<ID3DBlob> signature;
         ComPtr<ID3DBlob> error;
@@ -298,6 +360,29 @@ void D3D1211on12::LoadAssets()
 
         ThrowIfFailed(m_d3d12Device->CreateGraphicsPipelineState(&psoDesc, IID_PPV_ARGS(&m_pipelineState)));
         NAME_D3D12_OBJECT(m_pipelineState);
+
+        // The composite draws a fullscreen triangle generated from the vertex ID
+        // and blends the premultiplied UI layer over the scene.
+        ComPtr<ID3DBlob> compositeVertexShader;
+        ComPtr<ID3DBlob> compositePixelShader;
+        ThrowIfFailed(D3DCompileFromFile(GetAssetFullPath(L"shaders.hlsl").c_str(), nullptr, nullptr, "VSComposite", "vs_5_0", compileFlags, 0, &compositeVertexShader, nullptr));
+        ThrowIfFailed(D3DCompileFromFile(GetAssetFullPath(L"shaders.hlsl").c_str(), nullptr, nullptr, "PSComposite", "ps_5_0", compileFlags, 0, &compositePixelShader, nullptr));
+
+        D3D12_RENDER_TARGET_BLEND_DESC& blendDesc = psoDesc.BlendState.RenderTarget[0];
+        blendDesc.BlendEnable = TRUE;
+        blendDesc.SrcBlend = D3D12_BLEND_ONE;
+        blendDesc.DestBlend = D3D12_BLEND_INV_SRC_ALPHA;
+        blendDesc.BlendOp = D3D12_BLEND_OP_ADD;
+        blendDesc.SrcBlendAlpha = D3D12_BLEND_ONE;
+        blendDesc.DestBlendAlpha = D3D12_BLEND_INV_SRC_ALPHA;
+        blendDesc.BlendOpAlpha = D3D12_BLEND_OP_ADD;
+
+        psoDesc.InputLayout = { nullptr, 0 };
+        psoDesc.VS = CD3DX12_SHADER_BYTECODE(compositeVertexShader.Get());
+        psoDesc.PS = CD3DX12_SHADER_BYTECODE(compositePixelShader.Get());
+
+        ThrowIfFailed(m_d3d12Device->CreateGraphicsPipelineState(&psoDesc, IID_PPV_ARGS(&m_compositePipelineState)));
+        NAME_D3D12_OBJECT(m_compositePipelineState);
     }
 
     ThrowIfFailed(m_d3d12Device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, m_commandAllocators[m_frameIndex].Get(), m_pipelineState.Get(), IID_PPV_ARGS(&m_commandList)));
@@ -405,6 +490,15 @@ void D3D1211on12::OnUpdate()
 // Render the scene.
 void D3D1211on12::OnRender()
 {
+    // Redraw the UI layer before the frame that composites it is submitted, so
+    // that the queue orders the 11On12 work ahead of the D3D12 reads.
+    if (m_useCachedUI && m_uiLayerDirty)
+    {
+        PIXBeginEvent(m_commandQueue.Get(), 0, L"Render UI Layer");
+        RenderUILayer();
+        PIXEndEvent(m_commandQueue.Get());
+    }
+
     PIXBeginEvent(m_commandQueue.Get(), 0, L"Render 3D");
 
     // Record all the commands we need to render the scene into the command list.
@@ -416,12 +510,15 @@ void D3D1211on12::OnRender()
 
     PIXEndEvent(m_commandQueue.Get());
 
-    PIXBeginEvent(m_commandQueue.Get(), 0, L"Render UI");
-    RenderUI();
-    PIXEndEvent(m_commandQueue.Get());
+    if (!m_useCachedUI)
+    {
+        PIXBeginEvent(m_commandQueue.Get(), 0, L"Render UI");
+        RenderUI();
+        PIXEndEvent(m_commandQueue.Get());
+    }
 
     // Present the frame.
-    ThrowIfFailed(m_swapChain->Present(1, 0));
+    ThrowIfFailed(m_swapChain->Present(GetSyncInterval(), 0));
 
     MoveToNextFrame();
 }
@@ -435,6 +532,22 @@ void D3D1211on12::OnDestroy()
     CloseHandle(m_fenceEvent);
 }
 
+void D3D1211on12::OnKeyDown(UINT8 key)
+{
+    switch (key)
+    {
+    case VK_SPACE:
+        m_useCachedUI = !m_useCachedUI;
+        UpdateWindowText();
+        break;
+    }
+}
+
+void D3D1211on12::UpdateWindowText()
+{
+    SetCustomWindowText(m_useCachedUI ? L"[UI: Cached layer]" : L"[UI: Per-frame 11On12]");
+}
+
 void D3D1211on12::PopulateCommandList()
 {
     // Command list allocators can only be reset when the associated 
@@ -465,8 +578,20 @@ void D3D1211on12::PopulateCommandList()
     m_commandList->IASetVertexBuffers(0, 1, &m_vertexBufferView);
     m_commandList->DrawInstanced(3, 1, 0, 0);
 
-    // Note: do not transition the render target to present here.
-    // the transition will occur when the wrapped 11On12 render
+    if (m_useCachedUI)
+    {
+        // Composite the UI layer and present without involving the 11On12 device.
+        ID3D12DescriptorHeap* ppHeaps[] = { m_srvHeap.Get() };
+        m_commandList->SetDescriptorHeaps(_countof(ppHeaps), ppHeaps);
+        m_commandList->SetGraphicsRootDescriptorTable(0, m_srvHeap->GetGPUDescriptorHandleForHeapStart());
+        m_commandList->SetPipelineState(m_compositePipelineState.Get());
+        m_commandList->DrawInstanced(3, 1, 0, 0);
+
+        m_commandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(m_renderTargets[m_frameIndex].Get(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PRESENT));
+    }
+
+    // Note: otherwise, do not transition the render target to present here.
+    // The transition will occur when the wrapped 11On12 render
     // target resource is released.
 
     ThrowIfFailed(m_commandList->Close());
@@ -504,6 +629,36 @@ void D3D1211on12::RenderUI()
     m_d3d11DeviceContext->Flush();
 }
 
+// Render text into the UI layer using D2D via the 11On12 device. This is the
+// only place the cached path acquires, releases and flushes, so it should only
+// be called when the UI content changes.
+void D3D1211on12::RenderUILayer()
+{
+    D2D1_SIZE_F rtSize = m_d2dUILayer->GetSize();
+    D2D1_RECT_F textRect = D2D1::RectF(0, 0, rtSize.width, rtSize.height);
+    static const WCHAR text[] = L"11On12";
+
+    m_d3d11On12Device->AcquireWrappedResources(m_wrappedUILayer.GetAddressOf(), 1);
+
+    m_d2dDeviceContext->SetTarget(m_d2dUILayer.Get());
+    m_d2dDeviceContext->BeginDraw();
+    m_d2dDeviceContext->Clear(D2D1::ColorF(0.0f, 0.0f, 0.0f, 0.0f));
+    m_d2dDeviceContext->SetTransform(D2D1::Matrix3x2F::Identity());
+    m_d2dDeviceContext->DrawText(
+        text,
+        _countof(text) - 1,
+        m_textFormat.Get(),
+        &textRect,
+        m_textBrush.Get()
+        );
+    ThrowIfFailed(m_d2dDeviceContext->EndDraw());
+
+    m_d3d11On12Device->ReleaseWrappedResources(m_wrappedUILayer.GetAddressOf(), 1);
+    m_d3d11DeviceContext->Flush();
+
+    m_uiLayerDirty = false;
+}
+
 // Wait for pending GPU work to complete.
 void D3D1211on12::WaitForGpu()
 {
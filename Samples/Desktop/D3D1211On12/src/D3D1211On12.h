@@ -31,6 +31,7 @@ public:
     virtual void OnUpdate();
     virtual void OnRender();
     virtual void OnDestroy();
+    virtual void OnKeyDown(UINT8 key);
 
 private:
     static const UINT FrameCount = 3;
@@ -59,7 +60,9 @@ private:
     ComPtr<ID3D12CommandQueue> m_commandQueue;
     ComPtr<ID3D12RootSignature> m_rootSignature;
     ComPtr<ID3D12DescriptorHeap> m_rtvHeap;
+    ComPtr<ID3D12DescriptorHeap> m_srvHeap;
     ComPtr<ID3D12PipelineState> m_pipelineState;
+    ComPtr<ID3D12PipelineState> m_compositePipelineState;
     ComPtr<ID3D12GraphicsCommandList> m_commandList;
 
     // App resources.
@@ -69,6 +72,15 @@ private:
     ComPtr<ID3D12Resource> m_vertexBuffer;
     D3D12_VERTEX_BUFFER_VIEW m_vertexBufferView;
 
+    // The UI is drawn by D2D into this layer only when its content changes, and
+    // composited over each frame with a D3D12 draw. When m_useCachedUI is false,
+    // D2D draws into the back buffer every frame instead.
+    ComPtr<ID3D12Resource> m_uiLayer;
+    ComPtr<ID3D11Resource> m_wrappedUILayer;
+    ComPtr<ID2D1Bitmap1> m_d2dUILayer;
+    bool m_useCachedUI;
+    bool m_uiLayerDirty;
+
     // Synchronization objects.
     UINT m_frameIndex;
     HANDLE m_fenceEvent;
@@ -81,4 +93,6 @@ private:
     void WaitForGpu();
     void MoveToNextFrame();
     void RenderUI();
+    void RenderUILayer();
+    void UpdateWindowText();
 };
@@ -29,3 +29,18 @@ float4 PSMain(PSInput input) : SV_TARGET
 {
     return input.color;
 }
+
+Texture2D g_uiLayer : register(t0);
+
+// Fullscreen triangle covering the render target; the UI layer matches its size.
+float4 VSComposite(uint vertexId : SV_VertexID) : SV_POSITION
+{
+    float2 uv = float2((vertexId << 1) & 2, vertexId & 2);
+    return float4(uv * float2(2.0f, -2.0f) + float2(-1.0f, 1.0f), 0.0f, 1.0f);
+}
+
+float4 PSComposite(float4 position : SV_POSITION) : SV_TARGET
+{
+    // The layer holds premultiplied alpha.
+    return g_uiLayer[uint2(position.xy)];
+}
@@ -13,6 +13,8 @@
 #include "D3D12Bundles.h"
 #include "occcity.h"
 
+const UINT D3D12Bundles::CityScales[CityScaleCount] = { 1, 10, 100 };
+
 D3D12Bundles::D3D12Bundles(UINT width, UINT height, std::wstring name) :
     DXSample(width, height, name),
     m_frameIndex(0),
@@ -22,8 +24,19 @@ D3D12Bundles::D3D12Bundles(UINT width, UINT height, std::wstring name) :
     m_fenceValue(0),
     m_rtvDescriptorSize(0),
     m_currentFrameResourceIndex(0),
-    m_pCurrentFrameResource(nullptr)
+    m_pCurrentFrameResource(nullptr),
+    m_submissionMode(SubmissionModeBundles),
+    m_cityScaleIndex(0),
+    m_timestampFrequency(0),
+    m_cpuFrequency(0),
+    m_cpuTicks(0),
+    m_gpuTicks(0),
+    m_cpuTimedFrameCount(0),
+    m_gpuTimedFrameCount(0)
 {
+    LARGE_INTEGER frequency;
+    QueryPerformanceFrequency(&frequency);
+    m_cpuFrequency = frequency.QuadPart;
 }
 
 void D3D12Bundles::OnInit()
@@ -86,6 +99,7 @@ void D3D12Bundles::LoadPipeline()
     queueDesc.Type = D3D12_COMMAND_LIST_TYPE_DIRECT;
 
     ThrowIfFailed(m_device->CreateCommandQueue(&queueDesc, IID_PPV_ARGS(&m_commandQueue)));
+    SetBenchmarkCommandQueue(m_device.Get(), m_commandQueue.Get());
     NAME_D3D12_OBJECT(m_commandQueue);
 
     // Describe and create the swap chain.
@@ -134,7 +148,7 @@ void D3D12Bundles::LoadPipeline()
         // buffer view (CBV) descriptor heap.
         D3D12_DESCRIPTOR_HEAP_DESC cbvSrvHeapDesc = {};
         cbvSrvHeapDesc.NumDescriptors =
-            FrameCount * CityRowCount * CityColumnCount        // FrameCount frames * CityRowCount * CityColumnCount.
+            FrameCount * MaxCityCount                       // FrameCount frames * the largest city size.
             + 1;                                            // + 1 for the SRV.
         cbvSrvHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
         cbvSrvHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
@@ -196,21 +210,55 @@ void D3D12Bundles::LoadAssets()
         ThrowIfFailed(D3DX12SerializeVersionedRootSignature(&rootSignatureDesc, featureData.HighestVersion, &signature, &error));
         ThrowIfFailed(m_device->CreateRootSignature(0, signature->GetBufferPointer(), signature->GetBufferSize(), IID_PPV_ARGS(&m_rootSignature)));
         NAME_D3D12_OBJECT(m_rootSignature);
+
+        // The indirect draws replace the per-city CBV table with an instance base
+        // root constant, set by the command signature, and the instance buffer.
+        CD3DX12_ROOT_PARAMETER1 indirectRootParameters[4];
+        indirectRootParameters[0].InitAsDescriptorTable(1, &ranges[0], D3D12_SHADER_VISIBILITY_PIXEL);
+        indirectRootParameters[1].InitAsDescriptorTable(1, &ranges[1], D3D12_SHADER_VISIBILITY_PIXEL);
+        indirectRootParameters[2].InitAsConstants(1, 1, 0, D3D12_SHADER_VISIBILITY_VERTEX);
+        indirectRootParameters[3].InitAsShaderResourceView(1, 0, D3D12_ROOT_DESCRIPTOR_FLAG_DATA_STATIC_WHILE_SET_AT_EXECUTE, D3D12_SHADER_VISIBILITY_VERTEX);
+
+        rootSignatureDesc.Init_1_1(_countof(indirectRootParameters), indirectRootParameters, 0, nullptr, D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT);
+
+        ThrowIfFailed(D3DX12SerializeVersionedRootSignature(&rootSignatureDesc, featureData.HighestVersion, &signature, &error));
+        ThrowIfFailed(m_device->CreateRootSignature(0, signature->GetBufferPointer(), signature->GetBufferSize(), IID_PPV_ARGS(&m_indirectRootSignature)));
+        NAME_D3D12_OBJECT(m_indirectRootSignature);
+
+        // Create the compute root signature used to generate the indirect draws.
+        CD3DX12_ROOT_PARAMETER1 computeRootParameters[4];
+        computeRootParameters[0].InitAsConstantBufferView(0, 0, D3D12_ROOT_DESCRIPTOR_FLAG_DATA_STATIC);
+        computeRootParameters[1].InitAsShaderResourceView(0, 0, D3D12_ROOT_DESCRIPTOR_FLAG_DATA_STATIC);
+        computeRootParameters[2].InitAsUnorderedAccessView(0);
+        computeRootParameters[3].InitAsUnorderedAccessView(1);
+
+        CD3DX12_VERSIONED_ROOT_SIGNATURE_DESC computeRootSignatureDesc;
+        computeRootSignatureDesc.Init_1_1(_countof(computeRootParameters), computeRootParameters);
+
+        ThrowIfFailed(D3DX12SerializeVersionedRootSignature(&computeRootSignatureDesc, featureData.HighestVersion, &signature, &error));
+        ThrowIfFailed(m_device->CreateRootSignature(0, signature->GetBufferPointer(), signature->GetBufferSize(), IID_PPV_ARGS(&m_computeRootSignature)));
+        NAME_D3D12_OBJECT(m_computeRootSignature);
     }
 
     // Create the pipeline state, which includes loading shaders.
     {
         UINT8* pVertexShaderData;
+        UINT8* pInstancedVertexShaderData;
         UINT8* pPixelShaderData1;
         UINT8* pPixelShaderData2;
+        UINT8* pComputeShaderData;
         UINT vertexShaderDataLength;
+        UINT instancedVertexShaderDataLength;
         UINT pixelShaderDataLength1;
         UINT pixelShaderDataLength2;
+        UINT computeShaderDataLength;
 
         // Load pre-compiled shaders.
         ThrowIfFailed(ReadDataFromFile(GetAssetFullPath(L"shader_mesh_simple_vert.cso").c_str(), &pVertexShaderData, &vertexShaderDataLength));
         ThrowIfFailed(ReadDataFromFile(GetAssetFullPath(L"shader_mesh_simple_pixel.cso").c_str(), &pPixelShaderData1, &pixelShaderDataLength1));
         ThrowIfFailed(ReadDataFromFile(GetAssetFullPath(L"shader_mesh_alt_pixel.cso").c_str(), &pPixelShaderData2, &pixelShaderDataLength2));
+        ThrowIfFailed(ReadDataFromFile(GetAssetFullPath(L"shader_mesh_instanced_vert.cso").c_str(), &pInstancedVertexShaderData, &instancedVertexShaderDataLength));
+        ThrowIfFailed(ReadDataFromFile(GetAssetFullPath(L"city_instances_compute.cso").c_str(), &pComputeShaderData, &computeShaderDataLength));
 
         CD3DX12_RASTERIZER_DESC rasterizerStateDesc(D3D12_DEFAULT);
         rasterizerStateDesc.CullMode = D3D12_CULL_MODE_NONE;
@@ -241,9 +289,72 @@ void D3D12Bundles::LoadAssets()
         ThrowIfFailed(m_device->CreateGraphicsPipelineState(&psoDesc, IID_PPV_ARGS(&m_pipelineState2)));
         NAME_D3D12_OBJECT(m_pipelineState2);
 
+        // Create the same two PSOs for the indirect draws, which read the
+        // transforms of the cities from the instance buffer.
+        psoDesc.pRootSignature = m_indirectRootSignature.Get();
+        psoDesc.VS = CD3DX12_SHADER_BYTECODE(pInstancedVertexShaderData, instancedVertexShaderDataLength);
+        psoDesc.PS = CD3DX12_SHADER_BYTECODE(pPixelShaderData1, pixelShaderDataLength1);
+
+        ThrowIfFailed(m_device->CreateGraphicsPipelineState(&psoDesc, IID_PPV_ARGS(&m_indirectPipelineState1)));
+        NAME_D3D12_OBJECT(m_indirectPipelineState1);
+
+        psoDesc.PS = CD3DX12_SHADER_BYTECODE(pPixelShaderData2, pixelShaderDataLength2);
+
+        ThrowIfFailed(m_device->CreateGraphicsPipelineState(&psoDesc, IID_PPV_ARGS(&m_indirectPipelineState2)));
+        NAME_D3D12_OBJECT(m_indirectPipelineState2);
+
+        // Describe and create the compute pipeline state object (PSO).
+        D3D12_COMPUTE_PIPELINE_STATE_DESC computePsoDesc = {};
+        computePsoDesc.pRootSignature = m_computeRootSignature.Get();
+        computePsoDesc.CS = CD3DX12_SHADER_BYTECODE(pComputeShaderData, computeShaderDataLength);
+
+        ThrowIfFailed(m_device->CreateComputePipelineState(&computePsoDesc, IID_PPV_ARGS(&m_computeState)));
+        NAME_D3D12_OBJECT(m_computeState);
+
         delete pVertexShaderData;
+        delete pInstancedVertexShaderData;
         delete pPixelShaderData1;
         delete pPixelShaderData2;
+        delete pComputeShaderData;
+    }
+
+    // Create the command signature used for indirect drawing.
+    {
+        // Each command sets the instance base root constant and then draws.
+        D3D12_INDIRECT_ARGUMENT_DESC argumentDescs[2] = {};
+        argumentDescs[0].Type = D3D12_INDIRECT_ARGUMENT_TYPE_CONSTANT;
+        argumentDescs[0].Constant.RootParameterIndex = 2;
+        argumentDescs[0].Constant.DestOffsetIn32BitValues = 0;
+        argumentDescs[0].Constant.Num32BitValuesToSet = 1;
+        argumentDescs[1].Type = D3D12_INDIRECT_ARGUMENT_TYPE_DRAW_INDEXED;
+
+        D3D12_COMMAND_SIGNATURE_DESC commandSignatureDesc = {};
+        commandSignatureDesc.pArgumentDescs = argumentDescs;
+        commandSignatureDesc.NumArgumentDescs = _countof(argumentDescs);
+        commandSignatureDesc.ByteStride = sizeof(FrameResource::IndirectCommand);
+
+        ThrowIfFailed(m_device->CreateCommandSignature(&commandSignatureDesc, m_indirectRootSignature.Get(), IID_PPV_ARGS(&m_commandSignature)));
+        NAME_D3D12_OBJECT(m_commandSignature);
+    }
+
+    // Create the timestamp queries used to measure the GPU time spent drawing the cities.
+    {
+        D3D12_QUERY_HEAP_DESC queryHeapDesc = {};
+        queryHeapDesc.Count = FrameCount * 2;
+        queryHeapDesc.Type = D3D12_QUERY_HEAP_TYPE_TIMESTAMP;
+        ThrowIfFailed(m_device->CreateQueryHeap(&queryHeapDesc, IID_PPV_ARGS(&m_timestampQueryHeap)));
+        NAME_D3D12_OBJECT(m_timestampQueryHeap);
+
+        ThrowIfFailed(m_device->CreateCommittedResource(
+            &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_READBACK),
+            D3D12_HEAP_FLAG_NONE,
+            &CD3DX12_RESOURCE_DESC::Buffer(queryHeapDesc.Count * sizeof(UINT64)),
+            D3D12_RESOURCE_STATE_COPY_DEST,
+            nullptr,
+            IID_PPV_ARGS(&m_timestampReadbackBuffer)));
+        NAME_D3D12_OBJECT(m_timestampReadbackBuffer);
+
+        ThrowIfFailed(m_commandQueue->GetTimestampFrequency(&m_timestampFrequency));
     }
 
     ThrowIfFailed(m_device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, m_commandAllocator.Get(), nullptr, IID_PPV_ARGS(&m_commandList)));
@@ -475,11 +586,9 @@ void D3D12Bundles::OnUpdate()
 
     if (m_frameCounter == 500)
     {
-        // Update window text with FPS value.
-        wchar_t fps[64];
-        swprintf_s(fps, L"%ufps", m_timer.GetFramesPerSecond());
-        SetCustomWindowText(fps);
-        m_frameCounter = 0;
+        // Update window text with FPS value and the benchmark results.
+        UpdateWindowText();
+        ResetBenchmark();
     }
 
     m_frameCounter++;
@@ -500,8 +609,35 @@ void D3D12Bundles::OnUpdate()
         WaitForSingleObject(m_fenceEvent, INFINITE);
     }
 
+    // Read back the GPU time of the last frame that used this frame resource.
+    if (m_pCurrentFrameResource->m_fenceValue != 0)
+    {
+        const UINT timestampIndex = m_currentFrameResourceIndex * 2;
+        CD3DX12_RANGE readRange(timestampIndex * sizeof(UINT64), (timestampIndex + 2) * sizeof(UINT64));
+        CD3DX12_RANGE writeRange(0, 0);
+        UINT64* pTimestamps;
+
+        ThrowIfFailed(m_timestampReadbackBuffer->Map(0, &readRange, reinterpret_cast<void**>(&pTimestamps)));
+        m_gpuTicks += pTimestamps[timestampIndex + 1] - pTimestamps[timestampIndex];
+        m_gpuTimedFrameCount++;
+        m_timestampReadbackBuffer->Unmap(0, &writeRange);
+    }
+
     m_camera.Update(static_cast<float>(m_timer.GetElapsedSeconds()));
-    m_pCurrentFrameResource->UpdateConstantBuffers(m_camera.GetViewMatrix(), m_camera.GetProjectionMatrix(0.8f, m_aspectRatio));
+
+    // Only the direct and bundle paths compute the transforms of the cities on the CPU.
+    LARGE_INTEGER cpuStart, cpuEnd;
+    QueryPerformanceCounter(&cpuStart);
+    if (m_submissionMode == SubmissionModeIndirect)
+    {
+        m_pCurrentFrameResource->UpdateIndirectConstants(m_camera.GetViewMatrix(), m_camera.GetProjectionMatrix(0.8f, m_aspectRatio), m_numIndices);
+    }
+    else
+    {
+        m_pCurrentFrameResource->UpdateConstantBuffers(m_camera.GetViewMatrix(), m_camera.GetProjectionMatrix(0.8f, m_aspectRatio));
+    }
+    QueryPerformanceCounter(&cpuEnd);
+    m_cpuTicks += cpuEnd.QuadPart - cpuStart.QuadPart;
 }
 
 // Render the scene.
@@ -510,7 +646,12 @@ void D3D12Bundles::OnRender()
     PIXBeginEvent(m_commandQueue.Get(), 0, L"Render");
 
     // Record all the commands we need to render the scene into the command list.
+    LARGE_INTEGER cpuStart, cpuEnd;
+    QueryPerformanceCounter(&cpuStart);
     PopulateCommandList(m_pCurrentFrameResource);
+    QueryPerformanceCounter(&cpuEnd);
+    m_cpuTicks += cpuEnd.QuadPart - cpuStart.QuadPart;
+    m_cpuTimedFrameCount++;
 
     // Execute the command list.
     ID3D12CommandList* ppCommandLists[] = { m_commandList.Get() };
@@ -519,7 +660,7 @@ void D3D12Bundles::OnRender()
     PIXEndEvent(m_commandQueue.Get());
 
     // Present and update the frame index for the next frame.
-    ThrowIfFailed(m_swapChain->Present(1, 0));
+    ThrowIfFailed(m_swapChain->Present(GetSyncInterval(), 0));
     m_frameIndex = m_swapChain->GetCurrentBackBufferIndex();
 
     // Signal and increment the fence value.
@@ -532,25 +673,29 @@ void D3D12Bundles::OnDestroy()
 {
     // Ensure that the GPU is no longer referencing resources that are about to be
     // cleaned up by the destructor.
+    WaitForGpu();
+
+    for (UINT i = 0; i < m_frameResources.size(); i++)
     {
-        const UINT64 fence = m_fenceValue;
-        const UINT64 lastCompletedFence = m_fence->GetCompletedValue();
+        delete m_frameResources.at(i);
+    }
+}
 
-        // Signal and increment the fence value.
-        ThrowIfFailed(m_commandQueue->Signal(m_fence.Get(), m_fenceValue));
-        m_fenceValue++;
+// Wait for pending GPU work to complete.
+void D3D12Bundles::WaitForGpu()
+{
+    const UINT64 fence = m_fenceValue;
+    const UINT64 lastCompletedFence = m_fence->GetCompletedValue();
 
-        // Wait until the previous frame is finished.
-        if (lastCompletedFence < fence)
-        {
-            ThrowIfFailed(m_fence->SetEventOnCompletion(fence, m_fenceEvent));
-            WaitForSingleObject(m_fenceEvent, INFINITE);
-        }
-    }
+    // Signal and increment the fence value.
+    ThrowIfFailed(m_commandQueue->Signal(m_fence.Get(), m_fenceValue));
+    m_fenceValue++;
 
-    for (UINT i = 0; i < m_frameResources.size(); i++)
+    // Wait until the previous frame is finished.
+    if (lastCompletedFence < fence)
     {
-        delete m_frameResources.at(i);
+        ThrowIfFailed(m_fence->SetEventOnCompletion(fence, m_fenceEvent));
+        WaitForSingleObject(m_fenceEvent, INFINITE);
     }
 }
 
@@ -562,6 +707,55 @@ void D3D12Bundles::OnKeyDown(UINT8 key)
 void D3D12Bundles::OnKeyUp(UINT8 key)
 {
     m_camera.OnKeyUp(key);
+
+    switch (key)
+    {
+    // Cycle through bundles, direct and indirect submission.
+    case 'M':
+        m_submissionMode = static_cast<SubmissionMode>((m_submissionMode + 1) % SubmissionModeCount);
+        ResetBenchmark();
+        break;
+
+    // Cycle through the city sizes. The frame resources and their bundles are
+    // recreated for the new number of cities.
+    case 'C':
+        WaitForGpu();
+
+        for (UINT i = 0; i < m_frameResources.size(); i++)
+        {
+            delete m_frameResources.at(i);
+        }
+        m_frameResources.clear();
+        m_pCurrentFrameResource = nullptr;
+
+        m_cityScaleIndex = (m_cityScaleIndex + 1) % CityScaleCount;
+        CreateFrameResources();
+        ResetBenchmark();
+        break;
+    }
+}
+
+void D3D12Bundles::ResetBenchmark()
+{
+    m_frameCounter = 0;
+    m_cpuTicks = 0;
+    m_gpuTicks = 0;
+    m_cpuTimedFrameCount = 0;
+    m_gpuTimedFrameCount = 0;
+}
+
+void D3D12Bundles::UpdateWindowText()
+{
+    static const WCHAR* submissionModeNames[SubmissionModeCount] = { L"Bundles", L"Direct", L"Indirect" };
+
+    // Average CPU time to update the constants and record the frame, and GPU time to draw the cities.
+    const double cpuTime = m_cpuTimedFrameCount ? 1000.0 * m_cpuTicks / (static_cast<double>(m_cpuFrequency) * m_cpuTimedFrameCount) : 0.0;
+    const double gpuTime = m_gpuTimedFrameCount ? 1000.0 * m_gpuTicks / (static_cast<double>(m_timestampFrequency) * m_gpuTimedFrameCount) : 0.0;
+
+    wchar_t text[128];
+    swprintf_s(text, L"%ufps  [M] %s  [C] %u cities  CPU: %.3fms  GPU: %.3fms",
+        m_timer.GetFramesPerSecond(), submissionModeNames[m_submissionMode], GetCityRowCount() * GetCityColumnCount(), cpuTime, gpuTime);
+    SetCustomWindowText(text);
 }
 
 // Create the resources that will be used every frame.
@@ -571,12 +765,12 @@ void D3D12Bundles::CreateFrameResources()
     CD3DX12_CPU_DESCRIPTOR_HANDLE cbvSrvHandle(m_cbvSrvHeap->GetCPUDescriptorHandleForHeapStart(), 1, m_cbvSrvDescriptorSize);    // Move past the SRV in slot 1.
     for (UINT i = 0; i < FrameCount; i++)
     {
-        FrameResource* pFrameResource = new FrameResource(m_device.Get(), CityRowCount, CityColumnCount);
+        FrameResource* pFrameResource = new FrameResource(m_device.Get(), GetCityRowCount(), GetCityColumnCount());
 
         UINT64 cbOffset = 0;
-        for (UINT j = 0; j < CityRowCount; j++)
+        for (UINT j = 0; j < GetCityRowCount(); j++)
         {
-            for (UINT k = 0; k < CityColumnCount; k++)
+            for (UINT k = 0; k < GetCityColumnCount(); k++)
             {
                 // Describe and create a constant buffer view (CBV).
                 D3D12_CONSTANT_BUFFER_VIEW_DESC cbvDesc = {};
@@ -628,18 +822,33 @@ void D3D12Bundles::PopulateCommandList(FrameResource* pFrameResource)
     m_commandList->ClearRenderTargetView(rtvHandle, clearColor, 0, nullptr);
     m_commandList->ClearDepthStencilView(m_dsvHeap->GetCPUDescriptorHandleForHeapStart(), D3D12_CLEAR_FLAG_DEPTH, 1.0f, 0, 0, nullptr);
 
-    if (UseBundles)
+    // Time the city draws on the GPU.
+    const UINT timestampIndex = m_currentFrameResourceIndex * 2;
+    m_commandList->EndQuery(m_timestampQueryHeap.Get(), D3D12_QUERY_TYPE_TIMESTAMP, timestampIndex);
+
+    switch (m_submissionMode)
     {
+    case SubmissionModeBundles:
         // Execute the prebuilt bundle.
         m_commandList->ExecuteBundle(pFrameResource->m_bundle.Get());
-    }
-    else
-    {
+        break;
+
+    case SubmissionModeDirect:
         // Populate a new command list.
         pFrameResource->PopulateCommandList(m_commandList.Get(), m_pipelineState1.Get(), m_pipelineState2.Get(), m_currentFrameResourceIndex, m_numIndices, &m_indexBufferView,
             &m_vertexBufferView, m_cbvSrvHeap.Get(), m_cbvSrvDescriptorSize, m_samplerHeap.Get(), m_rootSignature.Get());
+        break;
+
+    case SubmissionModeIndirect:
+        // Generate the draws on the GPU and execute them.
+        pFrameResource->PopulateIndirectCommandList(m_commandList.Get(), m_computeState.Get(), m_computeRootSignature.Get(), m_indirectPipelineState1.Get(),
+            m_indirectPipelineState2.Get(), m_commandSignature.Get(), &m_indexBufferView, &m_vertexBufferView, m_cbvSrvHeap.Get(), m_samplerHeap.Get(), m_indirectRootSignature.Get());
+        break;
     }
 
+    m_commandList->EndQuery(m_timestampQueryHeap.Get(), D3D12_QUERY_TYPE_TIMESTAMP, timestampIndex + 1);
+    m_commandList->ResolveQueryData(m_timestampQueryHeap.Get(), D3D12_QUERY_TYPE_TIMESTAMP, timestampIndex, 2, m_timestampReadbackBuffer.Get(), timestampIndex * sizeof(UINT64));
+
     // Indicate that the back buffer will now be used to present.
     m_commandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(m_renderTargets[m_frameIndex].Get(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PRESENT));
 
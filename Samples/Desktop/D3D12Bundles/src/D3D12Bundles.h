@@ -41,7 +41,19 @@ private:
     static const UINT FrameCount = 3;
     static const UINT CityRowCount = 10;
     static const UINT CityColumnCount = 3;
-    static const bool UseBundles = true;
+
+    // The city can be scaled up to compare how the submission models scale.
+    static const UINT CityScaleCount = 3;
+    static const UINT CityScales[CityScaleCount];
+    static const UINT MaxCityCount = CityRowCount * CityColumnCount * 100;
+
+    enum SubmissionMode
+    {
+        SubmissionModeBundles,     // Execute a bundle recorded at startup.
+        SubmissionModeDirect,      // Record every draw into the command list each frame.
+        SubmissionModeIndirect,    // Generate the draws on the GPU and submit them with ExecuteIndirect.
+        SubmissionModeCount
+    };
 
     // Pipeline objects.
     CD3DX12_VIEWPORT m_viewport;
@@ -61,6 +73,14 @@ private:
     ComPtr<ID3D12PipelineState> m_pipelineState2;
     ComPtr<ID3D12GraphicsCommandList> m_commandList;
 
+    // Indirect submission objects.
+    ComPtr<ID3D12RootSignature> m_indirectRootSignature;
+    ComPtr<ID3D12RootSignature> m_computeRootSignature;
+    ComPtr<ID3D12PipelineState> m_indirectPipelineState1;
+    ComPtr<ID3D12PipelineState> m_indirectPipelineState2;
+    ComPtr<ID3D12PipelineState> m_computeState;
+    ComPtr<ID3D12CommandSignature> m_commandSignature;
+
     // App resources.
     UINT m_numIndices;
     ComPtr<ID3D12Resource> m_vertexBuffer;
@@ -72,6 +92,18 @@ private:
     UINT m_cbvSrvDescriptorSize;
     UINT m_rtvDescriptorSize;
     SimpleCamera m_camera;
+    SubmissionMode m_submissionMode;
+    UINT m_cityScaleIndex;
+
+    // Benchmark data, averaged over the frames between window text updates.
+    ComPtr<ID3D12QueryHeap> m_timestampQueryHeap;
+    ComPtr<ID3D12Resource> m_timestampReadbackBuffer;
+    UINT64 m_timestampFrequency;
+    UINT64 m_cpuFrequency;
+    UINT64 m_cpuTicks;
+    UINT64 m_gpuTicks;
+    UINT m_cpuTimedFrameCount;
+    UINT m_gpuTimedFrameCount;
 
     // Frame resources.
     std::vector<FrameResource*> m_frameResources;
@@ -89,4 +121,9 @@ private:
     void LoadAssets();
     void CreateFrameResources();
     void PopulateCommandList(FrameResource* pFrameResource);
+    void WaitForGpu();
+    void ResetBenchmark();
+    void UpdateWindowText();
+    UINT GetCityRowCount() const { return CityRowCount * (CityScales[m_cityScaleIndex] >= 10 ? 10 : 1); }
+    UINT GetCityColumnCount() const { return CityColumnCount * (CityScales[m_cityScaleIndex] >= 100 ? 10 : 1); }
 };
@@ -46,12 +46,67 @@ FrameResource::FrameResource(ID3D12Device* pDevice, UINT cityRowCount, UINT city
     // Update all of the model matrices once; our cities don't move so 
     // we don't need to do this ever again.
     SetCityPositions(8.0f, -8.0f);
+
+    // Create the resources used by indirect submission. The compute shader reads the
+    // world matrices and writes the per-instance data and the draw arguments.
+    {
+        const UINT cityCount = m_cityRowCount * m_cityColumnCount;
+        const UINT cityBufferSize = cityCount * sizeof(XMFLOAT4X4);
+
+        ThrowIfFailed(pDevice->CreateCommittedResource(
+            &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
+            D3D12_HEAP_FLAG_NONE,
+            &CD3DX12_RESOURCE_DESC::Buffer(cityBufferSize),
+            D3D12_RESOURCE_STATE_GENERIC_READ,
+            nullptr,
+            IID_PPV_ARGS(&m_cityBuffer)));
+
+        ThrowIfFailed(pDevice->CreateCommittedResource(
+            &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT),
+            D3D12_HEAP_FLAG_NONE,
+            &CD3DX12_RESOURCE_DESC::Buffer(cityBufferSize, D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS),
+            D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE,
+            nullptr,
+            IID_PPV_ARGS(&m_instanceBuffer)));
+
+        ThrowIfFailed(pDevice->CreateCommittedResource(
+            &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT),
+            D3D12_HEAP_FLAG_NONE,
+            &CD3DX12_RESOURCE_DESC::Buffer(IndirectCommandCount * sizeof(IndirectCommand), D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS),
+            D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT,
+            nullptr,
+            IID_PPV_ARGS(&m_indirectArgumentBuffer)));
+
+        ThrowIfFailed(pDevice->CreateCommittedResource(
+            &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
+            D3D12_HEAP_FLAG_NONE,
+            &CD3DX12_RESOURCE_DESC::Buffer(sizeof(IndirectConstantBuffer)),
+            D3D12_RESOURCE_STATE_GENERIC_READ,
+            nullptr,
+            IID_PPV_ARGS(&m_indirectConstantBuffer)));
+
+        NAME_D3D12_OBJECT(m_cityBuffer);
+        NAME_D3D12_OBJECT(m_instanceBuffer);
+        NAME_D3D12_OBJECT(m_indirectArgumentBuffer);
+        NAME_D3D12_OBJECT(m_indirectConstantBuffer);
+
+        // The cities don't move, so their world matrices are written once.
+        UINT8* pCityData;
+        ThrowIfFailed(m_cityBuffer->Map(0, &readRange, reinterpret_cast<void**>(&pCityData)));
+        memcpy(pCityData, m_modelMatrices.data(), cityBufferSize);
+        m_cityBuffer->Unmap(0, nullptr);
+
+        ThrowIfFailed(m_indirectConstantBuffer->Map(0, &readRange, reinterpret_cast<void**>(&m_pIndirectConstants)));
+    }
 }
 
 FrameResource::~FrameResource()
 {
     m_cbvUploadHeap->Unmap(0, nullptr);
     m_pConstantBuffers = nullptr;
+
+    m_indirectConstantBuffer->Unmap(0, nullptr);
+    m_pIndirectConstants = nullptr;
 }
 
 void FrameResource::InitBundle(ID3D12Device* pDevice, ID3D12PipelineState* pPso1, ID3D12PipelineState* pPso2,
@@ -125,6 +180,55 @@ void FrameResource::PopulateCommandList(ID3D12GraphicsCommandList* pCommandList,
     PIXEndEvent(pCommandList);
 }
 
+// Generates the per-instance data and draw arguments on the GPU, then draws all the
+// cities that use a PSO with a single ExecuteIndirect.
+void FrameResource::PopulateIndirectCommandList(ID3D12GraphicsCommandList* pCommandList, ID3D12PipelineState* pComputePso, ID3D12RootSignature* pComputeRootSignature,
+    ID3D12PipelineState* pPso1, ID3D12PipelineState* pPso2, ID3D12CommandSignature* pCommandSignature, D3D12_INDEX_BUFFER_VIEW* pIndexBufferViewDesc,
+    D3D12_VERTEX_BUFFER_VIEW* pVertexBufferViewDesc, ID3D12DescriptorHeap* pCbvSrvDescriptorHeap, ID3D12DescriptorHeap* pSamplerDescriptorHeap, ID3D12RootSignature* pRootSignature)
+{
+    const UINT cityCount = m_cityRowCount * m_cityColumnCount;
+
+    PIXBeginEvent(pCommandList, 0, L"Generate city instances");
+    {
+        D3D12_RESOURCE_BARRIER barriers[] =
+        {
+            CD3DX12_RESOURCE_BARRIER::Transition(m_instanceBuffer.Get(), D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS),
+            CD3DX12_RESOURCE_BARRIER::Transition(m_indirectArgumentBuffer.Get(), D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT, D3D12_RESOURCE_STATE_UNORDERED_ACCESS)
+        };
+        pCommandList->ResourceBarrier(_countof(barriers), barriers);
+
+        pCommandList->SetComputeRootSignature(pComputeRootSignature);
+        pCommandList->SetPipelineState(pComputePso);
+        pCommandList->SetComputeRootConstantBufferView(0, m_indirectConstantBuffer->GetGPUVirtualAddress());
+        pCommandList->SetComputeRootShaderResourceView(1, m_cityBuffer->GetGPUVirtualAddress());
+        pCommandList->SetComputeRootUnorderedAccessView(2, m_instanceBuffer->GetGPUVirtualAddress());
+        pCommandList->SetComputeRootUnorderedAccessView(3, m_indirectArgumentBuffer->GetGPUVirtualAddress());
+        pCommandList->Dispatch((cityCount + ComputeThreadBlockSize - 1) / ComputeThreadBlockSize, 1, 1);
+
+        barriers[0] = CD3DX12_RESOURCE_BARRIER::Transition(m_instanceBuffer.Get(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+        barriers[1] = CD3DX12_RESOURCE_BARRIER::Transition(m_indirectArgumentBuffer.Get(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT);
+        pCommandList->ResourceBarrier(_countof(barriers), barriers);
+    }
+    PIXEndEvent(pCommandList);
+
+    pCommandList->SetGraphicsRootSignature(pRootSignature);
+    pCommandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+    pCommandList->IASetIndexBuffer(pIndexBufferViewDesc);
+    pCommandList->IASetVertexBuffers(0, 1, pVertexBufferViewDesc);
+    pCommandList->SetGraphicsRootDescriptorTable(0, pCbvSrvDescriptorHeap->GetGPUDescriptorHandleForHeapStart());
+    pCommandList->SetGraphicsRootDescriptorTable(1, pSamplerDescriptorHeap->GetGPUDescriptorHandleForHeapStart());
+    pCommandList->SetGraphicsRootShaderResourceView(3, m_instanceBuffer->GetGPUVirtualAddress());
+
+    PIXBeginEvent(pCommandList, 0, L"Draw cities");
+    for (UINT i = 0; i < IndirectCommandCount; i++)
+    {
+        // The command sets the instance base root constant before drawing.
+        pCommandList->SetPipelineState(i == 0 ? pPso1 : pPso2);
+        pCommandList->ExecuteIndirect(pCommandSignature, 1, m_indirectArgumentBuffer.Get(), i * sizeof(IndirectCommand), nullptr, 0);
+    }
+    PIXEndEvent(pCommandList);
+}
+
 void XM_CALLCONV FrameResource::UpdateConstantBuffers(FXMMATRIX view, CXMMATRIX projection)
 {
     XMMATRIX model;
@@ -144,3 +248,12 @@ void XM_CALLCONV FrameResource::UpdateConstantBuffers(FXMMATRIX view, CXMMATRIX
         }
     }
 }
+
+void XM_CALLCONV FrameResource::UpdateIndirectConstants(FXMMATRIX view, CXMMATRIX projection, UINT numIndices)
+{
+    // The shaders use row-major matrices, so unlike the per-city constant buffers
+    // the matrix is not transposed.
+    XMStoreFloat4x4(&m_pIndirectConstants->viewProj, view * projection);
+    m_pIndirectConstants->cityCount = m_cityRowCount * m_cityColumnCount;
+    m_pIndirectConstants->indexCount = numIndices;
+}
@@ -28,6 +28,25 @@ public:
         FLOAT padding[48];
     };
 
+    // Constants used by the compute shader that generates the indirect draws.
+    struct IndirectConstantBuffer
+    {
+        XMFLOAT4X4 viewProj;
+        UINT cityCount;
+        UINT indexCount;
+        FLOAT padding[46];
+    };
+
+    // Data structure to match the command signature used for ExecuteIndirect.
+    struct IndirectCommand
+    {
+        UINT instanceBase;
+        D3D12_DRAW_INDEXED_ARGUMENTS drawArguments;
+    };
+
+    static const UINT IndirectCommandCount = 2;     // One per PSO.
+    static const UINT ComputeThreadBlockSize = 128; // Should match the value in city_instances_compute.hlsl.
+
     ComPtr<ID3D12CommandAllocator> m_commandAllocator;
     ComPtr<ID3D12CommandAllocator> m_bundleAllocator;
     ComPtr<ID3D12GraphicsCommandList> m_bundle;
@@ -35,6 +54,13 @@ public:
     SceneConstantBuffer* m_pConstantBuffers;
     UINT64 m_fenceValue;
 
+    // Indirect submission resources.
+    ComPtr<ID3D12Resource> m_cityBuffer;                // World matrix of each city.
+    ComPtr<ID3D12Resource> m_instanceBuffer;            // World-view-projection matrix of each city, grouped by PSO.
+    ComPtr<ID3D12Resource> m_indirectArgumentBuffer;    // One IndirectCommand per PSO.
+    ComPtr<ID3D12Resource> m_indirectConstantBuffer;
+    IndirectConstantBuffer* m_pIndirectConstants;
+
     std::vector<XMFLOAT4X4> m_modelMatrices;
     UINT m_cityRowCount;
     UINT m_cityColumnCount;
@@ -50,5 +76,10 @@ public:
         UINT frameResourceIndex, UINT numIndices, D3D12_INDEX_BUFFER_VIEW* pIndexBufferViewDesc, D3D12_VERTEX_BUFFER_VIEW* pVertexBufferViewDesc,
         ID3D12DescriptorHeap* pCbvSrvDescriptorHeap, UINT cbvSrvDescriptorSize, ID3D12DescriptorHeap* pSamplerDescriptorHeap, ID3D12RootSignature* pRootSignature);
 
+    void PopulateIndirectCommandList(ID3D12GraphicsCommandList* pCommandList, ID3D12PipelineState* pComputePso, ID3D12RootSignature* pComputeRootSignature,
+        ID3D12PipelineState* pPso1, ID3D12PipelineState* pPso2, ID3D12CommandSignature* pCommandSignature, D3D12_INDEX_BUFFER_VIEW* pIndexBufferViewDesc,
+        D3D12_VERTEX_BUFFER_VIEW* pVertexBufferViewDesc, ID3D12DescriptorHeap* pCbvSrvDescriptorHeap, ID3D12DescriptorHeap* pSamplerDescriptorHeap, ID3D12RootSignature* pRootSignature);
+
     void XM_CALLCONV UpdateConstantBuffers(FXMMATRIX view, CXMMATRIX projection);
+    void XM_CALLCONV UpdateIndirectConstants(FXMMATRIX view, CXMMATRIX projection, UINT numIndices);
 };
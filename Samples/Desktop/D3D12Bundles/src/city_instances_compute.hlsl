@@ -0,0 +1,65 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#define threadBlockSize 128
+
+struct CityData
+{
+    row_major float4x4 world;
+};
+
+struct InstanceData
+{
+    row_major float4x4 worldViewProj;
+};
+
+// Must match FrameResource::IndirectConstantBuffer.
+cbuffer IndirectConstantBuffer : register(b0)
+{
+    row_major float4x4 g_viewProj;
+    uint g_cityCount;
+    uint g_indexCount;
+};
+
+StructuredBuffer<CityData> g_cities : register(t0);
+RWStructuredBuffer<InstanceData> g_instances : register(u0);
+RWByteAddressBuffer g_indirectArguments : register(u1);
+
+// One argument record per PSO: the instance base root constant followed by
+// D3D12_DRAW_INDEXED_ARGUMENTS. Must match FrameResource::IndirectCommand.
+static const uint commandSizeInBytes = 24;
+
+// Cities alternate between the two PSOs, so the instances of each PSO are gathered
+// into their own range of the instance buffer and drawn by a single indirect draw.
+[numthreads(threadBlockSize, 1, 1)]
+void CSMain(uint3 dispatchThreadId : SV_DispatchThreadID)
+{
+    const uint city = dispatchThreadId.x;
+    const uint firstPsoCount = (g_cityCount + 1) / 2;
+
+    if (city < g_cityCount)
+    {
+        const uint pso = city & 1;
+        const uint slot = (pso == 0 ? 0 : firstPsoCount) + city / 2;
+
+        g_instances[slot].worldViewProj = mul(g_cities[city].world, g_viewProj);
+    }
+
+    if (city == 0)
+    {
+        for (uint pso = 0; pso < 2; pso++)
+        {
+            const uint offset = pso * commandSizeInBytes;
+            g_indirectArguments.Store2(offset, uint2(pso == 0 ? 0 : firstPsoCount, g_indexCount));
+            g_indirectArguments.Store4(offset + 8, uint4(pso == 0 ? firstPsoCount : g_cityCount - firstPsoCount, 0, 0, 0));
+        }
+    }
+}
@@ -0,0 +1,47 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+struct VSInput
+{
+    float3 position    : POSITION;
+    float3 normal    : NORMAL;
+    float2 uv        : TEXCOORD0;
+    float3 tangent    : TANGENT;
+};
+
+struct PSInput
+{
+    float4 position    : SV_POSITION;
+    float2 uv        : TEXCOORD0;
+};
+
+struct InstanceData
+{
+    row_major float4x4 worldViewProj;
+};
+
+// Set by the indirect command: where this draw's instances start in g_instances.
+cbuffer cb1 : register(b1)
+{
+    uint g_instanceBase;
+};
+
+StructuredBuffer<InstanceData> g_instances : register(t1);
+
+PSInput VSMain(VSInput input, uint instanceID : SV_InstanceID)
+{
+    PSInput result;
+
+    result.position = mul(float4(input.position, 1.0f), g_instances[g_instanceBase + instanceID].worldViewProj);
+    result.uv = input.uv;
+
+    return result;
+}
@@ -80,6 +80,7 @@ void D3D12DepthBoundsTest::LoadPipeline()
     queueDesc.Type = D3D12_COMMAND_LIST_TYPE_DIRECT;
 
     ThrowIfFailed(m_device->CreateCommandQueue(&queueDesc, IID_PPV_ARGS(&m_commandQueue)));
+    SetBenchmarkCommandQueue(m_device.Get(), m_commandQueue.Get());
 
     // Describe and create the swap chain.
     DXGI_SWAP_CHAIN_DESC1 swapChainDesc = {};
@@ -362,7 +363,7 @@ void D3D12DepthBoundsTest::OnRender()
     m_commandQueue->ExecuteCommandLists(_countof(ppCommandLists), ppCommandLists);
 
     // Present the frame.
-    ThrowIfFailed(m_swapChain->Present(1, 0));
+    ThrowIfFailed(m_swapChain->Present(GetSyncInterval(), 0));
 
     WaitForPreviousFrame();
 }
@@ -25,8 +25,14 @@ D3D12DynamicIndexing::D3D12DynamicIndexing(UINT width, UINT height, std::wstring
     m_rtvDescriptorSize(0),
     m_cbvSrvDescriptorSize(0),
     m_currentFrameResourceIndex(0),
-    m_pCurrentFrameResource(nullptr)
+    m_pCurrentFrameResource(nullptr),
+    m_useInstancing(false),
+    m_cpuTicks(0),
+    m_cpuTimedFrameCount(0)
 {
+    LARGE_INTEGER frequency;
+    QueryPerformanceFrequency(&frequency);
+    m_cpuFrequency = frequency.QuadPart;
 }
 
 void D3D12DynamicIndexing::OnInit()
@@ -90,6 +96,7 @@ void D3D12DynamicIndexing::LoadPipeline()
     queueDesc.Type = D3D12_COMMAND_LIST_TYPE_DIRECT;
 
     ThrowIfFailed(m_device->CreateCommandQueue(&queueDesc, IID_PPV_ARGS(&m_commandQueue)));
+    SetBenchmarkCommandQueue(m_device.Get(), m_commandQueue.Get());
     NAME_D3D12_OBJECT(m_commandQueue);
 
     // Describe and create the swap chain.
@@ -188,11 +195,12 @@ void D3D12DynamicIndexing::LoadAssets()
         ranges[1].Init(D3D12_DESCRIPTOR_RANGE_TYPE_SAMPLER, 1, 0);
         ranges[2].Init(D3D12_DESCRIPTOR_RANGE_TYPE_CBV, 1, 0, 0, D3D12_DESCRIPTOR_RANGE_FLAG_DATA_STATIC);
 
-        CD3DX12_ROOT_PARAMETER1 rootParameters[4];
+        CD3DX12_ROOT_PARAMETER1 rootParameters[5];
         rootParameters[0].InitAsDescriptorTable(1, &ranges[0], D3D12_SHADER_VISIBILITY_PIXEL);
         rootParameters[1].InitAsDescriptorTable(1, &ranges[1], D3D12_SHADER_VISIBILITY_PIXEL);
         rootParameters[2].InitAsDescriptorTable(1, &ranges[2], D3D12_SHADER_VISIBILITY_VERTEX);
         rootParameters[3].InitAsConstants(1, 0, 0, D3D12_SHADER_VISIBILITY_PIXEL);
+        rootParameters[4].InitAsShaderResourceView(0, 1, D3D12_ROOT_DESCRIPTOR_FLAG_DATA_STATIC_WHILE_SET_AT_EXECUTE, D3D12_SHADER_VISIBILITY_VERTEX);    // Per-instance data for the instanced draw.
 
         CD3DX12_VERSIONED_ROOT_SIGNATURE_DESC rootSignatureDesc;
         rootSignatureDesc.Init_1_1(_countof(rootParameters), rootParameters, 0, nullptr, D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT);
@@ -208,11 +216,17 @@ void D3D12DynamicIndexing::LoadAssets()
     {
         UINT8* pVertexShaderData;
         UINT8* pPixelShaderData;
+        UINT8* pInstancedVertexShaderData;
+        UINT8* pInstancedPixelShaderData;
         UINT vertexShaderDataLength;
         UINT pixelShaderDataLength;
+        UINT instancedVertexShaderDataLength;
+        UINT instancedPixelShaderDataLength;
 
         ThrowIfFailed(ReadDataFromFile(GetAssetFullPath(L"shader_mesh_simple_vert.cso").c_str(), &pVertexShaderData, &vertexShaderDataLength));
         ThrowIfFailed(ReadDataFromFile(GetAssetFullPath(L"shader_mesh_dynamic_indexing_pixel.cso").c_str(), &pPixelShaderData, &pixelShaderDataLength));
+        ThrowIfFailed(ReadDataFromFile(GetAssetFullPath(L"shader_mesh_instanced_vert.cso").c_str(), &pInstancedVertexShaderData, &instancedVertexShaderDataLength));
+        ThrowIfFailed(ReadDataFromFile(GetAssetFullPath(L"shader_mesh_dynamic_indexing_instanced_pixel.cso").c_str(), &pInstancedPixelShaderData, &instancedPixelShaderDataLength));
 
         CD3DX12_RASTERIZER_DESC rasterizerStateDesc(D3D12_DEFAULT);
         rasterizerStateDesc.CullMode = D3D12_CULL_MODE_NONE;
@@ -236,8 +250,17 @@ void D3D12DynamicIndexing::LoadAssets()
         ThrowIfFailed(m_device->CreateGraphicsPipelineState(&psoDesc, IID_PPV_ARGS(&m_pipelineState)));
         NAME_D3D12_OBJECT(m_pipelineState);
 
+        // The instanced PSO takes the transforms and material indices from per-instance data.
+        psoDesc.VS = CD3DX12_SHADER_BYTECODE(pInstancedVertexShaderData, instancedVertexShaderDataLength);
+        psoDesc.PS = CD3DX12_SHADER_BYTECODE(pInstancedPixelShaderData, instancedPixelShaderDataLength);
+
+        ThrowIfFailed(m_device->CreateGraphicsPipelineState(&psoDesc, IID_PPV_ARGS(&m_instancedPipelineState)));
+        NAME_D3D12_OBJECT(m_instancedPipelineState);
+
         delete pVertexShaderData;
         delete pPixelShaderData;
+        delete pInstancedVertexShaderData;
+        delete pInstancedPixelShaderData;
     }
 
     ThrowIfFailed(m_device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, m_commandAllocator.Get(), nullptr, IID_PPV_ARGS(&m_commandList)));
@@ -573,11 +596,9 @@ void D3D12DynamicIndexing::OnUpdate()
 
     if (m_frameCounter == 500)
     {
-        // Update window text with FPS value.
-        wchar_t fps[64];
-        swprintf_s(fps, L"%ufps", m_timer.GetFramesPerSecond());
-        SetCustomWindowText(fps);
-        m_frameCounter = 0;
+        // Update window text with FPS value and the CPU frame time.
+        UpdateWindowText();
+        ResetBenchmark();
     }
 
     m_frameCounter++;
@@ -599,7 +620,12 @@ void D3D12DynamicIndexing::OnUpdate()
     }
 
     m_camera.Update(static_cast<float>(m_timer.GetElapsedSeconds()));
+
+    LARGE_INTEGER cpuStart, cpuEnd;
+    QueryPerformanceCounter(&cpuStart);
     m_pCurrentFrameResource->UpdateConstantBuffers(m_camera.GetViewMatrix(), m_camera.GetProjectionMatrix(0.8f, m_aspectRatio));
+    QueryPerformanceCounter(&cpuEnd);
+    m_cpuTicks += cpuEnd.QuadPart - cpuStart.QuadPart;
 }
 
 // Render the scene.
@@ -608,7 +634,12 @@ void D3D12DynamicIndexing::OnRender()
     PIXBeginEvent(m_commandQueue.Get(), 0, L"Render");
 
     // Record all the commands we need to render the scene into the command list.
+    LARGE_INTEGER cpuStart, cpuEnd;
+    QueryPerformanceCounter(&cpuStart);
     PopulateCommandList(m_pCurrentFrameResource);
+    QueryPerformanceCounter(&cpuEnd);
+    m_cpuTicks += cpuEnd.QuadPart - cpuStart.QuadPart;
+    m_cpuTimedFrameCount++;
 
     // Execute the command list.
     ID3D12CommandList* ppCommandLists[] = { m_commandList.Get() };
@@ -617,7 +648,7 @@ void D3D12DynamicIndexing::OnRender()
     PIXEndEvent(m_commandQueue.Get());
 
     // Present and update the frame index for the next frame.
-    ThrowIfFailed(m_swapChain->Present(1, 0));
+    ThrowIfFailed(m_swapChain->Present(GetSyncInterval(), 0));
     m_frameIndex = m_swapChain->GetCurrentBackBufferIndex();
 
     // Signal and increment the fence value.
@@ -660,6 +691,31 @@ void D3D12DynamicIndexing::OnKeyDown(UINT8 key)
 void D3D12DynamicIndexing::OnKeyUp(UINT8 key)
 {
     m_camera.OnKeyUp(key);
+
+    // Toggle between one draw per city and a single instanced draw.
+    if (key == 'I')
+    {
+        m_useInstancing = !m_useInstancing;
+        ResetBenchmark();
+    }
+}
+
+void D3D12DynamicIndexing::ResetBenchmark()
+{
+    m_frameCounter = 0;
+    m_cpuTicks = 0;
+    m_cpuTimedFrameCount = 0;
+}
+
+void D3D12DynamicIndexing::UpdateWindowText()
+{
+    const UINT drawCount = m_useInstancing ? 1 : CityRowCount * CityColumnCount;
+    const double cpuTime = m_cpuTimedFrameCount ? 1000.0 * m_cpuTicks / (static_cast<double>(m_cpuFrequency) * m_cpuTimedFrameCount) : 0.0;
+
+    wchar_t text[128];
+    swprintf_s(text, L"%ufps  [I] %s  Draws: %u  CPU: %.3fms",
+        m_timer.GetFramesPerSecond(), m_useInstancing ? L"Instanced" : L"Per-city", drawCount, cpuTime);
+    SetCustomWindowText(text);
 }
 
 // Create the resources that will be used every frame.
@@ -726,7 +782,13 @@ void D3D12DynamicIndexing::PopulateCommandList(FrameResource* pFrameResource)
     m_commandList->ClearRenderTargetView(rtvHandle, clearColor, 0, nullptr);
     m_commandList->ClearDepthStencilView(m_dsvHeap->GetCPUDescriptorHandleForHeapStart(), D3D12_CLEAR_FLAG_DEPTH, 1.0f, 0, 0, nullptr);
 
-    if (UseBundles)
+    if (m_useInstancing)
+    {
+        // Draw every city at once.
+        pFrameResource->PopulateInstancedCommandList(m_commandList.Get(), m_instancedPipelineState.Get(), m_numIndices, &m_indexBufferView,
+            &m_vertexBufferView, m_cbvSrvHeap.Get(), m_samplerHeap.Get(), m_rootSignature.Get());
+    }
+    else if (UseBundles)
     {
         // Execute the prebuilt bundle.
         m_commandList->ExecuteBundle(pFrameResource->m_bundle.Get());
@@ -63,6 +63,7 @@ private:
     ComPtr<ID3D12DescriptorHeap> m_dsvHeap;
     ComPtr<ID3D12DescriptorHeap> m_samplerHeap;
     ComPtr<ID3D12PipelineState> m_pipelineState;
+    ComPtr<ID3D12PipelineState> m_instancedPipelineState;
     ComPtr<ID3D12GraphicsCommandList> m_commandList;
 
     // App resources.
@@ -78,6 +79,15 @@ private:
     UINT m_rtvDescriptorSize;
     SimpleCamera m_camera;
 
+    // Draw all of the cities with one instanced draw instead of one draw per city.
+    bool m_useInstancing;
+
+    // CPU time spent updating constants and recording the frame, averaged
+    // over the frames between window text updates.
+    INT64 m_cpuFrequency;
+    INT64 m_cpuTicks;
+    UINT m_cpuTimedFrameCount;
+
     // Frame resources.
     std::vector<FrameResource*> m_frameResources;
     FrameResource* m_pCurrentFrameResource;
@@ -94,4 +104,6 @@ private:
     void LoadAssets();
     void CreateFrameResources();
     void PopulateCommandList(FrameResource* pFrameResource);
+    void ResetBenchmark();
+    void UpdateWindowText();
 };
@@ -47,6 +47,12 @@ FrameResource::FrameResource(ID3D12Device* pDevice, UINT cityRowCount, UINT city
     // Update all of the model matrices once; our cities don't move so 
     // we don't need to do this ever again.
     SetCityPositions(citySpacingInterval, -citySpacingInterval);
+
+    // The material indices don't change either. Each city uses its own material.
+    for (UINT i = 0; i < m_cityRowCount * m_cityColumnCount; i++)
+    {
+        m_pConstantBuffers[i].materialIndex = i;
+    }
 }
 
 FrameResource::~FrameResource()
@@ -125,6 +131,31 @@ void FrameResource::PopulateCommandList(ID3D12GraphicsCommandList* pCommandList,
     PIXEndEvent(pCommandList);
 }
 
+// Draw every city with a single instanced draw. The constant buffers are bound as
+// a structured buffer that the vertex shader indexes with the instance ID, and the
+// material index is passed on to the pixel shader, which still indexes the
+// material array dynamically.
+void FrameResource::PopulateInstancedCommandList(ID3D12GraphicsCommandList* pCommandList, ID3D12PipelineState* pPso,
+    UINT numIndices, D3D12_INDEX_BUFFER_VIEW* pIndexBufferViewDesc, D3D12_VERTEX_BUFFER_VIEW* pVertexBufferViewDesc,
+    ID3D12DescriptorHeap* pCbvSrvDescriptorHeap, ID3D12DescriptorHeap* pSamplerDescriptorHeap, ID3D12RootSignature* pRootSignature)
+{
+    pCommandList->SetGraphicsRootSignature(pRootSignature);
+
+    ID3D12DescriptorHeap* ppHeaps[] = { pCbvSrvDescriptorHeap, pSamplerDescriptorHeap };
+    pCommandList->SetDescriptorHeaps(_countof(ppHeaps), ppHeaps);
+    pCommandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+    pCommandList->IASetIndexBuffer(pIndexBufferViewDesc);
+    pCommandList->IASetVertexBuffers(0, 1, pVertexBufferViewDesc);
+    pCommandList->SetGraphicsRootDescriptorTable(0, pCbvSrvDescriptorHeap->GetGPUDescriptorHandleForHeapStart());
+    pCommandList->SetGraphicsRootDescriptorTable(1, pSamplerDescriptorHeap->GetGPUDescriptorHandleForHeapStart());
+    pCommandList->SetGraphicsRootShaderResourceView(4, m_cbvUploadHeap->GetGPUVirtualAddress());
+
+    PIXBeginEvent(pCommandList, 0, L"Draw cities instanced");
+    pCommandList->SetPipelineState(pPso);
+    pCommandList->DrawIndexedInstanced(numIndices, m_cityRowCount * m_cityColumnCount, 0, 0, 0);
+    PIXEndEvent(pCommandList);
+}
+
 void XM_CALLCONV FrameResource::UpdateConstantBuffers(FXMMATRIX view, CXMMATRIX projection)
 {
     XMMATRIX model;
@@ -22,10 +22,13 @@ private:
     void SetCityPositions(FLOAT intervalX, FLOAT intervalZ);
 
 public:
+    // Each city's constants are also read as a structured buffer element by the
+    // instanced vertex shader, so the layout must match InstanceData in HLSL.
     struct SceneConstantBuffer
     {
         XMFLOAT4X4 mvp;        // Model-view-projection (MVP) matrix.
-        FLOAT padding[48];
+        UINT materialIndex;    // Only used when the cities are drawn instanced.
+        FLOAT padding[47];
     };
 
     ComPtr<ID3D12CommandAllocator> m_commandAllocator;
@@ -51,5 +54,9 @@ public:
         UINT frameResourceIndex, UINT numIndices, D3D12_INDEX_BUFFER_VIEW* pIndexBufferViewDesc, D3D12_VERTEX_BUFFER_VIEW* pVertexBufferViewDesc,
         ID3D12DescriptorHeap* pCbvSrvDescriptorHeap, UINT cbvSrvDescriptorSize, ID3D12DescriptorHeap* pSamplerDescriptorHeap, ID3D12RootSignature* pRootSignature);
 
+    void PopulateInstancedCommandList(ID3D12GraphicsCommandList* pCommandList, ID3D12PipelineState* pPso,
+        UINT numIndices, D3D12_INDEX_BUFFER_VIEW* pIndexBufferViewDesc, D3D12_VERTEX_BUFFER_VIEW* pVertexBufferViewDesc,
+        ID3D12DescriptorHeap* pCbvSrvDescriptorHeap, ID3D12DescriptorHeap* pSamplerDescriptorHeap, ID3D12RootSignature* pRootSignature);
+
     void XM_CALLCONV UpdateConstantBuffers(FXMMATRIX view, CXMMATRIX projection);
 };
@@ -0,0 +1,31 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+struct PSInput
+{
+    float4 position    : SV_POSITION;
+    float2 uv        : TEXCOORD0;
+    nointerpolation uint matIndex    : MATERIAL;    // Per-instance index for looking up from g_txMats[].
+};
+
+Texture2D        g_txDiffuse    : register(t0);
+Texture2D        g_txMats[]    : register(t1);
+SamplerState    g_sampler    : register(s0);
+
+float4 PSMain(PSInput input) : SV_TARGET
+{
+    float3 diffuse = g_txDiffuse.Sample(g_sampler, input.uv).rgb;
+
+    // Pixels of different instances can be shaded together, so the index
+    // is not uniform across the wave.
+    float3 mat = g_txMats[NonUniformResourceIndex(input.matIndex)].Sample(g_sampler, input.uv).rgb;
+    return float4(diffuse * mat, 1.0f);
+}
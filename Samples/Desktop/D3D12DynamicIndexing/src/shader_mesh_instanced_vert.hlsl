@@ -0,0 +1,48 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+struct VSInput
+{
+    float3 position    : POSITION;
+    float3 normal    : NORMAL;
+    float2 uv        : TEXCOORD0;
+    float3 tangent    : TANGENT;
+};
+
+struct PSInput
+{
+    float4 position    : SV_POSITION;
+    float2 uv        : TEXCOORD0;
+    nointerpolation uint matIndex    : MATERIAL;
+};
+
+// Must match FrameResource::SceneConstantBuffer.
+struct InstanceData
+{
+    float4x4 worldViewProj;
+    uint matIndex;
+    float3 padding0;
+    float4 padding1[11];
+};
+
+StructuredBuffer<InstanceData> g_instances : register(t0, space1);
+
+PSInput VSMain(VSInput input, uint instanceID : SV_InstanceID)
+{
+    PSInput result;
+
+    InstanceData instance = g_instances[instanceID];
+    result.position = mul(float4(input.position, 1.0f), instance.worldViewProj);
+    result.uv = input.uv;
+    result.matIndex = instance.matIndex;
+
+    return result;
+}
@@ -28,14 +28,23 @@ D3D12ExecuteIndirect::D3D12ExecuteIndirect(UINT width, UINT height, std::wstring
     m_cbvSrvUavDescriptorSize(0),
     m_csRootConstants(),
     m_enableCulling(true),
-    m_fenceValues{}
+    m_enableHierarchicalCulling(false),
+    m_fenceValues{},
+    m_timestampFrequency(0),
+    m_cullingTimed{},
+    m_cullingTicks(0),
+    m_cullingTimedFrameCount(0),
+    m_frameCounter(0)
 {
     m_constantBufferData.resize(TriangleCount);
+    m_clusterBoundsData.resize(ClusterCount);
 
     m_csRootConstants.xOffset = TriangleHalfWidth;
     m_csRootConstants.zOffset = TriangleDepth;
     m_csRootConstants.cullOffset = CullingCutoff;
     m_csRootConstants.commandCount = TriangleCount;
+    m_csRootConstants.clusterCount = ClusterCount;
+    m_csRootConstants.commandCounterOffset = CommandBufferCounterOffset;
 
     float center = width / 2.0f;
     m_cullingScissorRect.left = static_cast<LONG>(center - (center * CullingCutoff));
@@ -101,6 +110,7 @@ void D3D12ExecuteIndirect::LoadPipeline()
     queueDesc.Type = D3D12_COMMAND_LIST_TYPE_DIRECT;
 
     ThrowIfFailed(m_device->CreateCommandQueue(&queueDesc, IID_PPV_ARGS(&m_commandQueue)));
+    SetBenchmarkCommandQueue(m_device.Get(), m_commandQueue.Get());
     NAME_D3D12_OBJECT(m_commandQueue);
 
     D3D12_COMMAND_QUEUE_DESC computeQueueDesc = {};
@@ -218,7 +228,11 @@ void D3D12ExecuteIndirect::LoadAssets()
 
         CD3DX12_ROOT_PARAMETER1 computeRootParameters[ComputeRootParametersCount];
         computeRootParameters[SrvUavTable].InitAsDescriptorTable(2, ranges);
-        computeRootParameters[RootConstants].InitAsConstants(4, 0);
+        computeRootParameters[RootConstants].InitAsConstants(sizeof(CSRootConstants) / sizeof(UINT), 0);
+        computeRootParameters[ClusterBoundsSrv].InitAsShaderResourceView(2, 0, D3D12_ROOT_DESCRIPTOR_FLAG_DATA_STATIC_WHILE_SET_AT_EXECUTE);
+        computeRootParameters[VisibleClustersSrv].InitAsShaderResourceView(3, 0, D3D12_ROOT_DESCRIPTOR_FLAG_DATA_VOLATILE);
+        computeRootParameters[VisibleClustersUav].InitAsUnorderedAccessView(1, 0, D3D12_ROOT_DESCRIPTOR_FLAG_DATA_VOLATILE);
+        computeRootParameters[ProcessedCommandsUav].InitAsUnorderedAccessView(2, 0, D3D12_ROOT_DESCRIPTOR_FLAG_DATA_VOLATILE);
 
         CD3DX12_VERSIONED_ROOT_SIGNATURE_DESC computeRootSignatureDesc;
         computeRootSignatureDesc.Init_1_1(_countof(computeRootParameters), computeRootParameters);
@@ -233,6 +247,8 @@ void D3D12ExecuteIndirect::LoadAssets()
         ComPtr<ID3DBlob> vertexShader;
         ComPtr<ID3DBlob> pixelShader;
         ComPtr<ID3DBlob> computeShader;
+        ComPtr<ID3DBlob> clusterCullingShader;
+        ComPtr<ID3DBlob> clusterTriangleCullingShader;
         ComPtr<ID3DBlob> error;
 
 #if defined(_DEBUG)
@@ -245,6 +261,8 @@ void D3D12ExecuteIndirect::LoadAssets()
         ThrowIfFailed(D3DCompileFromFile(GetAssetFullPath(L"shaders.hlsl").c_str(), nullptr, nullptr, "VSMain", "vs_5_0", compileFlags, 0, &vertexShader, &error));
         ThrowIfFailed(D3DCompileFromFile(GetAssetFullPath(L"shaders.hlsl").c_str(), nullptr, nullptr, "PSMain", "ps_5_0", compileFlags, 0, &pixelShader, &error));
         ThrowIfFailed(D3DCompileFromFile(GetAssetFullPath(L"compute.hlsl").c_str(), nullptr, nullptr, "CSMain", "cs_5_0", compileFlags, 0, &computeShader, &error));
+        ThrowIfFailed(D3DCompileFromFile(GetAssetFullPath(L"compute.hlsl").c_str(), nullptr, nullptr, "CSCullClusters", "cs_5_0", compileFlags, 0, &clusterCullingShader, &error));
+        ThrowIfFailed(D3DCompileFromFile(GetAssetFullPath(L"compute.hlsl").c_str(), nullptr, nullptr, "CSCullClusterTriangles", "cs_5_0", compileFlags, 0, &clusterTriangleCullingShader, &error));
 
         // Define the vertex input layout.
         D3D12_INPUT_ELEMENT_DESC inputElementDescs[] =
@@ -278,6 +296,15 @@ void D3D12ExecuteIndirect::LoadAssets()
 
         ThrowIfFailed(m_device->CreateComputePipelineState(&computePsoDesc, IID_PPV_ARGS(&m_computeState)));
         NAME_D3D12_OBJECT(m_computeState);
+
+        // Create the PSOs for the two passes of hierarchical culling.
+        computePsoDesc.CS = CD3DX12_SHADER_BYTECODE(clusterCullingShader.Get());
+        ThrowIfFailed(m_device->CreateComputePipelineState(&computePsoDesc, IID_PPV_ARGS(&m_clusterCullingState)));
+        NAME_D3D12_OBJECT(m_clusterCullingState);
+
+        computePsoDesc.CS = CD3DX12_SHADER_BYTECODE(clusterTriangleCullingShader.Get());
+        ThrowIfFailed(m_device->CreateComputePipelineState(&computePsoDesc, IID_PPV_ARGS(&m_clusterTriangleCullingState)));
+        NAME_D3D12_OBJECT(m_clusterTriangleCullingState);
     }
 
     // Create the command list.
@@ -381,15 +408,30 @@ void D3D12ExecuteIndirect::LoadAssets()
 
         NAME_D3D12_OBJECT(m_constantBuffer);
 
-        // Initialize the constant buffers for each of the triangles.
-        for (UINT n = 0; n < TriangleCount; n++)
+        // Initialize the constant buffers for each of the triangles. The triangles of a cluster
+        // are placed around the same point and move together, so the cluster stays small.
+        const float clusterHalfWidth = 0.25f;
+        for (UINT cluster = 0; cluster < ClusterCount; cluster++)
         {
-            m_constantBufferData[n].velocity = XMFLOAT4(GetRandomFloat(0.01f, 0.02f), 0.0f, 0.0f, 0.0f);
-            m_constantBufferData[n].offset = XMFLOAT4(GetRandomFloat(-5.0f, -1.5f), GetRandomFloat(-1.0f, 1.0f), GetRandomFloat(0.0f, 2.0f), 0.0f);
-            m_constantBufferData[n].color = XMFLOAT4(GetRandomFloat(0.5f, 1.0f), GetRandomFloat(0.5f, 1.0f), GetRandomFloat(0.5f, 1.0f), 1.0f);
-            XMStoreFloat4x4(&m_constantBufferData[n].projection, XMMatrixTranspose(XMMatrixPerspectiveFovLH(XM_PIDIV4, m_aspectRatio, 0.01f, 20.0f)));
+            const float velocity = GetRandomFloat(0.01f, 0.02f);
+            const float center = GetRandomFloat(-5.0f, -1.5f);
+
+            for (UINT n = cluster * ClusterSize; n < (cluster + 1) * ClusterSize; n++)
+            {
+                m_constantBufferData[n].velocity = XMFLOAT4(velocity, 0.0f, 0.0f, 0.0f);
+                m_constantBufferData[n].offset = XMFLOAT4(center + GetRandomFloat(-clusterHalfWidth, clusterHalfWidth), GetRandomFloat(-1.0f, 1.0f), GetRandomFloat(0.0f, 2.0f), 0.0f);
+                m_constantBufferData[n].color = XMFLOAT4(GetRandomFloat(0.5f, 1.0f), GetRandomFloat(0.5f, 1.0f), GetRandomFloat(0.5f, 1.0f), 1.0f);
+                XMStoreFloat4x4(&m_constantBufferData[n].projection, XMMatrixTranspose(XMMatrixPerspectiveFovLH(XM_PIDIV4, m_aspectRatio, 0.01f, 20.0f)));
+            }
+
+            // The bounds cover every offset the triangles could have been given.
+            m_clusterBoundsData[cluster].minOffset = XMFLOAT4(center - clusterHalfWidth, -1.0f, 0.0f, 0.0f);
+            m_clusterBoundsData[cluster].maxOffset = XMFLOAT4(center + clusterHalfWidth, 1.0f, 2.0f, 0.0f);
         }
 
+        // Every triangle uses the same projection.
+        m_csRootConstants.projectionScale = m_constantBufferData[0].projection._11;
+
         // Map and initialize the constant buffer. We don't unmap this until the
         // app closes. Keeping things mapped for the lifetime of the resource is okay.
         CD3DX12_RANGE readRange(0, 0);        // We do not intend to read from this resource on the CPU.
@@ -415,6 +457,25 @@ void D3D12ExecuteIndirect::LoadAssets()
         }
     }
 
+    // Create the cluster bounds, which the compute shader reads through a root SRV.
+    {
+        const UINT clusterBoundsDataSize = ClusterCount * FrameCount * sizeof(ClusterBounds);
+
+        ThrowIfFailed(m_device->CreateCommittedResource(
+            &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
+            D3D12_HEAP_FLAG_NONE,
+            &CD3DX12_RESOURCE_DESC::Buffer(clusterBoundsDataSize),
+            D3D12_RESOURCE_STATE_GENERIC_READ,
+            nullptr,
+            IID_PPV_ARGS(&m_clusterBoundsBuffer)));
+
+        NAME_D3D12_OBJECT(m_clusterBoundsBuffer);
+
+        CD3DX12_RANGE readRange(0, 0);        // We do not intend to read from this resource on the CPU.
+        ThrowIfFailed(m_clusterBoundsBuffer->Map(0, &readRange, reinterpret_cast<void**>(&m_pClusterBoundsDataBegin)));
+        memcpy(m_pClusterBoundsDataBegin, &m_clusterBoundsData[0], ClusterCount * sizeof(ClusterBounds));
+    }
+
     // Create the command signature used for indirect drawing.
     {
         // Each command consists of a CBV update and a DrawInstanced call.
@@ -430,6 +491,17 @@ void D3D12ExecuteIndirect::LoadAssets()
 
         ThrowIfFailed(m_device->CreateCommandSignature(&commandSignatureDesc, m_rootSignature.Get(), IID_PPV_ARGS(&m_commandSignature)));
         NAME_D3D12_OBJECT(m_commandSignature);
+
+        // The first pass of hierarchical culling writes the number of thread groups the second pass needs.
+        D3D12_INDIRECT_ARGUMENT_DESC dispatchArgumentDesc = {};
+        dispatchArgumentDesc.Type = D3D12_INDIRECT_ARGUMENT_TYPE_DISPATCH;
+
+        commandSignatureDesc.pArgumentDescs = &dispatchArgumentDesc;
+        commandSignatureDesc.NumArgumentDescs = 1;
+        commandSignatureDesc.ByteStride = sizeof(D3D12_DISPATCH_ARGUMENTS);
+
+        ThrowIfFailed(m_device->CreateCommandSignature(&commandSignatureDesc, nullptr, IID_PPV_ARGS(&m_dispatchCommandSignature)));
+        NAME_D3D12_OBJECT(m_dispatchCommandSignature);
     }
 
     // Create the command buffers and UAVs to store the results of the compute work.
@@ -537,12 +609,28 @@ void D3D12ExecuteIndirect::LoadAssets()
             processedCommandsHandle.Offset(CbvSrvUavDescriptorCountPerFrame, m_cbvSrvUavDescriptorSize);
         }
 
+        // Allocate the buffers that the first pass of hierarchical culling lists the visible
+        // clusters in, after the dispatch arguments of the second pass.
+        for (UINT frame = 0; frame < FrameCount; frame++)
+        {
+            ThrowIfFailed(m_device->CreateCommittedResource(
+                &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT),
+                D3D12_HEAP_FLAG_NONE,
+                &CD3DX12_RESOURCE_DESC::Buffer(VisibleClusterListOffset + ClusterCount * sizeof(UINT), D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS),
+                D3D12_RESOURCE_STATE_COPY_DEST,
+                nullptr,
+                IID_PPV_ARGS(&m_visibleClusterBuffers[frame])));
+
+            NAME_D3D12_OBJECT_INDEXED(m_visibleClusterBuffers, frame);
+        }
+
         // Allocate a buffer that can be used to reset the UAV counters and initialize
-        // it to 0.
+        // it to 0. It is followed by the dispatch arguments for no thread groups, which
+        // reset the visible cluster buffers.
         ThrowIfFailed(m_device->CreateCommittedResource(
             &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
             D3D12_HEAP_FLAG_NONE,
-            &CD3DX12_RESOURCE_DESC::Buffer(sizeof(UINT)),
+            &CD3DX12_RESOURCE_DESC::Buffer(sizeof(UINT) + sizeof(D3D12_DISPATCH_ARGUMENTS)),
             D3D12_RESOURCE_STATE_GENERIC_READ,
             nullptr,
             IID_PPV_ARGS(&m_processedCommandBufferCounterReset)));
@@ -551,9 +639,31 @@ void D3D12ExecuteIndirect::LoadAssets()
         CD3DX12_RANGE readRange(0, 0);        // We do not intend to read from this resource on the CPU.
         ThrowIfFailed(m_processedCommandBufferCounterReset->Map(0, &readRange, reinterpret_cast<void**>(&pMappedCounterReset)));
         ZeroMemory(pMappedCounterReset, sizeof(UINT));
+        const D3D12_DISPATCH_ARGUMENTS emptyDispatch = { 0, 1, 1 };
+        memcpy(pMappedCounterReset + sizeof(UINT), &emptyDispatch, sizeof(emptyDispatch));
         m_processedCommandBufferCounterReset->Unmap(0, nullptr);
     }
 
+    // Create the timestamp queries used to measure the GPU time spent culling.
+    {
+        D3D12_QUERY_HEAP_DESC queryHeapDesc = {};
+        queryHeapDesc.Count = FrameCount * 2;
+        queryHeapDesc.Type = D3D12_QUERY_HEAP_TYPE_TIMESTAMP;
+        ThrowIfFailed(m_device->CreateQueryHeap(&queryHeapDesc, IID_PPV_ARGS(&m_timestampQueryHeap)));
+        NAME_D3D12_OBJECT(m_timestampQueryHeap);
+
+        ThrowIfFailed(m_device->CreateCommittedResource(
+            &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_READBACK),
+            D3D12_HEAP_FLAG_NONE,
+            &CD3DX12_RESOURCE_DESC::Buffer(queryHeapDesc.Count * sizeof(UINT64)),
+            D3D12_RESOURCE_STATE_COPY_DEST,
+            nullptr,
+            IID_PPV_ARGS(&m_timestampReadbackBuffer)));
+        NAME_D3D12_OBJECT(m_timestampReadbackBuffer);
+
+        ThrowIfFailed(m_computeCommandQueue->GetTimestampFrequency(&m_timestampFrequency));
+    }
+
     // Close the command list and execute it to begin the vertex buffer copy into
     // the default heap.
     ThrowIfFailed(m_commandList->Close());
@@ -591,21 +701,63 @@ float D3D12ExecuteIndirect::GetRandomFloat(float min, float max)
 // Update frame-based values.
 void D3D12ExecuteIndirect::OnUpdate()
 {
-    for (UINT n = 0; n < TriangleCount; n++)
+    if (m_frameCounter == 100)
+    {
+        // Update window text with the average culling time.
+        UpdateWindowText();
+        ResetBenchmark();
+    }
+
+    m_frameCounter++;
+
+    // Read back the culling time of the last frame that used this frame index.
+    if (m_cullingTimed[m_frameIndex])
+    {
+        const UINT timestampIndex = m_frameIndex * 2;
+        CD3DX12_RANGE readRange(timestampIndex * sizeof(UINT64), (timestampIndex + 2) * sizeof(UINT64));
+        CD3DX12_RANGE writeRange(0, 0);
+        UINT64* pTimestamps;
+
+        ThrowIfFailed(m_timestampReadbackBuffer->Map(0, &readRange, reinterpret_cast<void**>(&pTimestamps)));
+        m_cullingTicks += pTimestamps[timestampIndex + 1] - pTimestamps[timestampIndex];
+        m_cullingTimedFrameCount++;
+        m_timestampReadbackBuffer->Unmap(0, &writeRange);
+
+        m_cullingTimed[m_frameIndex] = false;
+    }
+
+    for (UINT cluster = 0; cluster < ClusterCount; cluster++)
     {
         const float offsetBounds = 2.5f;
 
-        // Animate the triangles.
-        m_constantBufferData[n].offset.x += m_constantBufferData[n].velocity.x;
-        if (m_constantBufferData[n].offset.x > offsetBounds)
+        SceneConstantBuffer* pTriangles = &m_constantBufferData[cluster * ClusterSize];
+        ClusterBounds& bounds = m_clusterBoundsData[cluster];
+
+        // Animate the clusters. Once every triangle of a cluster is past the bounds, the
+        // cluster starts over on the other side.
+        float velocity = pTriangles[0].velocity.x;
+        float distance = velocity;
+        if (bounds.minOffset.x + distance > offsetBounds)
         {
-            m_constantBufferData[n].velocity.x = GetRandomFloat(0.01f, 0.02f);
-            m_constantBufferData[n].offset.x = -offsetBounds;
+            velocity = GetRandomFloat(0.01f, 0.02f);
+            distance = -offsetBounds - bounds.maxOffset.x;
+        }
+
+        bounds.minOffset.x += distance;
+        bounds.maxOffset.x += distance;
+
+        for (UINT n = 0; n < ClusterSize; n++)
+        {
+            pTriangles[n].velocity.x = velocity;
+            pTriangles[n].offset.x += distance;
         }
     }
 
     UINT8* destination = m_pCbvDataBegin + (TriangleCount * m_frameIndex * sizeof(SceneConstantBuffer));
     memcpy(destination, &m_constantBufferData[0], TriangleCount * sizeof(SceneConstantBuffer));
+
+    destination = m_pClusterBoundsDataBegin + (ClusterCount * m_frameIndex * sizeof(ClusterBounds));
+    memcpy(destination, &m_clusterBoundsData[0], ClusterCount * sizeof(ClusterBounds));
 }
 
 // Render the scene.
@@ -639,7 +791,7 @@ void D3D12ExecuteIndirect::OnRender()
     PIXEndEvent(m_commandQueue.Get());
 
     // Present the frame.
-    ThrowIfFailed(m_swapChain->Present(1, 0));
+    ThrowIfFailed(m_swapChain->Present(GetSyncInterval(), 0));
 
     MoveToNextFrame();
 }
@@ -655,12 +807,44 @@ void D3D12ExecuteIndirect::OnDestroy()
 
 void D3D12ExecuteIndirect::OnKeyDown(UINT8 key)
 {
-    if (key == VK_SPACE)
+    switch (key)
     {
+    case VK_SPACE:
         m_enableCulling = !m_enableCulling;
+        ResetBenchmark();
+        break;
+
+    case 'H':
+        m_enableHierarchicalCulling = !m_enableHierarchicalCulling;
+        ResetBenchmark();
+        break;
+    }
+}
+
+// Discard the timing data gathered so far, including that of the frames still in flight.
+void D3D12ExecuteIndirect::ResetBenchmark()
+{
+    m_frameCounter = 0;
+    m_cullingTicks = 0;
+    m_cullingTimedFrameCount = 0;
+
+    for (UINT n = 0; n < FrameCount; n++)
+    {
+        m_cullingTimed[n] = false;
     }
 }
 
+void D3D12ExecuteIndirect::UpdateWindowText()
+{
+    // Average GPU time of the culling work.
+    const double cullingTime = m_cullingTimedFrameCount ? 1000.0 * m_cullingTicks / (static_cast<double>(m_timestampFrequency) * m_cullingTimedFrameCount) : 0.0;
+    const WCHAR* cullingModeName = m_enableCulling ? (m_enableHierarchicalCulling ? L"Hierarchical" : L"Flat") : L"Off";
+
+    wchar_t text[128];
+    swprintf_s(text, L"%u triangles  [SPACE/H] Culling: %s  GPU: %.3fms", TriangleCount, cullingModeName, cullingTime);
+    SetCustomWindowText(text);
+}
+
 // Fill the command list with all the render commands and dependent state.
 void D3D12ExecuteIndirect::PopulateCommandLists()
 {
@@ -691,15 +875,60 @@ void D3D12ExecuteIndirect::PopulateCommandLists()
             SrvUavTable,
             CD3DX12_GPU_DESCRIPTOR_HANDLE(cbvSrvUavHandle, CbvSrvOffset + frameDescriptorOffset, m_cbvSrvUavDescriptorSize));
 
-        m_computeCommandList->SetComputeRoot32BitConstants(RootConstants, 4, reinterpret_cast<void*>(&m_csRootConstants), 0);
+        m_computeCommandList->SetComputeRoot32BitConstants(RootConstants, sizeof(CSRootConstants) / sizeof(UINT), reinterpret_cast<void*>(&m_csRootConstants), 0);
+
+        // Time the culling work on the GPU.
+        const UINT timestampIndex = m_frameIndex * 2;
+        m_computeCommandList->EndQuery(m_timestampQueryHeap.Get(), D3D12_QUERY_TYPE_TIMESTAMP, timestampIndex);
 
         // Reset the UAV counter for this frame.
         m_computeCommandList->CopyBufferRegion(m_processedCommandBuffers[m_frameIndex].Get(), CommandBufferCounterOffset, m_processedCommandBufferCounterReset.Get(), 0, sizeof(UINT));
 
-        D3D12_RESOURCE_BARRIER barrier = CD3DX12_RESOURCE_BARRIER::Transition(m_processedCommandBuffers[m_frameIndex].Get(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
-        m_computeCommandList->ResourceBarrier(1, &barrier);
+        if (m_enableHierarchicalCulling)
+        {
+            ID3D12Resource* pVisibleClusters = m_visibleClusterBuffers[m_frameIndex].Get();
+
+            // Reset the dispatch arguments of the second pass.
+            m_computeCommandList->CopyBufferRegion(pVisibleClusters, 0, m_processedCommandBufferCounterReset.Get(), sizeof(UINT), sizeof(D3D12_DISPATCH_ARGUMENTS));
+
+            D3D12_RESOURCE_BARRIER barriers[2] = {
+                CD3DX12_RESOURCE_BARRIER::Transition(m_processedCommandBuffers[m_frameIndex].Get(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_UNORDERED_ACCESS),
+                CD3DX12_RESOURCE_BARRIER::Transition(pVisibleClusters, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_UNORDERED_ACCESS)
+            };
+            m_computeCommandList->ResourceBarrier(_countof(barriers), barriers);
+
+            m_computeCommandList->SetComputeRootShaderResourceView(ClusterBoundsSrv, m_clusterBoundsBuffer->GetGPUVirtualAddress() + m_frameIndex * ClusterCount * sizeof(ClusterBounds));
+            m_computeCommandList->SetComputeRootShaderResourceView(VisibleClustersSrv, pVisibleClusters->GetGPUVirtualAddress());
+            m_computeCommandList->SetComputeRootUnorderedAccessView(VisibleClustersUav, pVisibleClusters->GetGPUVirtualAddress());
+            m_computeCommandList->SetComputeRootUnorderedAccessView(ProcessedCommandsUav, m_processedCommandBuffers[m_frameIndex]->GetGPUVirtualAddress());
+
+            // Cull the clusters, then the triangles of the clusters that are left. The second pass
+            // only launches a thread group for each visible cluster.
+            m_computeCommandList->SetPipelineState(m_clusterCullingState.Get());
+            m_computeCommandList->Dispatch(static_cast<UINT>(ceil(ClusterCount / float(ComputeThreadBlockSize))), 1, 1);
+
+            barriers[1].Transition.StateBefore = D3D12_RESOURCE_STATE_UNORDERED_ACCESS;
+            barriers[1].Transition.StateAfter = D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT | D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE;
+            m_computeCommandList->ResourceBarrier(1, &barriers[1]);
+
+            m_computeCommandList->SetPipelineState(m_clusterTriangleCullingState.Get());
+            m_computeCommandList->ExecuteIndirect(m_dispatchCommandSignature.Get(), 1, pVisibleClusters, 0, nullptr, 0);
+
+            barriers[1].Transition.StateBefore = barriers[1].Transition.StateAfter;
+            barriers[1].Transition.StateAfter = D3D12_RESOURCE_STATE_COPY_DEST;
+            m_computeCommandList->ResourceBarrier(1, &barriers[1]);
+        }
+        else
+        {
+            D3D12_RESOURCE_BARRIER barrier = CD3DX12_RESOURCE_BARRIER::Transition(m_processedCommandBuffers[m_frameIndex].Get(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+            m_computeCommandList->ResourceBarrier(1, &barrier);
+
+            m_computeCommandList->Dispatch(static_cast<UINT>(ceil(TriangleCount / float(ComputeThreadBlockSize))), 1, 1);
+        }
 
-        m_computeCommandList->Dispatch(static_cast<UINT>(ceil(TriangleCount / float(ComputeThreadBlockSize))), 1, 1);
+        m_computeCommandList->EndQuery(m_timestampQueryHeap.Get(), D3D12_QUERY_TYPE_TIMESTAMP, timestampIndex + 1);
+        m_computeCommandList->ResolveQueryData(m_timestampQueryHeap.Get(), D3D12_QUERY_TYPE_TIMESTAMP, timestampIndex, 2, m_timestampReadbackBuffer.Get(), timestampIndex * sizeof(UINT64));
+        m_cullingTimed[m_frameIndex] = true;
     }
 
     ThrowIfFailed(m_computeCommandList->Close());
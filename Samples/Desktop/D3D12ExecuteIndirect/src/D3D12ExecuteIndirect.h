@@ -40,6 +40,10 @@ private:
     static const UINT CommandSizePerFrame;                // The size of the indirect commands to draw all of the triangles in a single frame.
     static const UINT CommandBufferCounterOffset;        // The offset of the UAV counter in the processed command buffer.
     static const UINT ComputeThreadBlockSize = 128;        // Should match the value in compute.hlsl.
+    static const UINT ClusterSize = 64;                    // The number of triangles in a cluster. Should match the value in compute.hlsl.
+    static const UINT ClusterCount = TriangleCount / ClusterSize;
+    static_assert(TriangleCount % ClusterSize == 0, "Every cluster must be full.");
+    static const UINT VisibleClusterListOffset = 16;    // The offset of the visible cluster indices, after the dispatch arguments.
     static const float TriangleHalfWidth;                // The x and y offsets used by the triangle vertices.
     static const float TriangleDepth;                    // The z offset used by the triangle vertices.
     static const float CullingCutoff;                    // The +/- x offset of the clipping planes in homogenous space [-1,1].
@@ -70,6 +74,16 @@ private:
         float zOffset;
         float cullOffset;
         float commandCount;
+        float clusterCount;
+        float projectionScale;
+        UINT commandCounterOffset;
+    };
+
+    // The range of the offsets of the triangles in a cluster, read by the compute shader.
+    struct ClusterBounds
+    {
+        XMFLOAT4 minOffset;
+        XMFLOAT4 maxOffset;
     };
 
     // Data structure to match the command signature used for ExecuteIndirect.
@@ -91,6 +105,10 @@ private:
     {
         SrvUavTable,
         RootConstants,            // Root constants that give the shader information about the triangle vertices and culling planes.
+        ClusterBoundsSrv,        // SRV that points to the bounds of the clusters for this frame.
+        VisibleClustersSrv,        // SRV that the second culling pass reads the visible clusters from.
+        VisibleClustersUav,        // UAV that the first culling pass writes the visible clusters and dispatch arguments to.
+        ProcessedCommandsUav,    // UAV that the second culling pass writes the commands and their count to.
         ComputeRootParametersCount
     };
 
@@ -107,8 +125,13 @@ private:
     std::vector<SceneConstantBuffer> m_constantBufferData;
     UINT8* m_pCbvDataBegin;
 
+    // Each cluster gets its own bounds per frame.
+    std::vector<ClusterBounds> m_clusterBoundsData;
+    UINT8* m_pClusterBoundsDataBegin;
+
     CSRootConstants m_csRootConstants;    // Constants for the compute shader.
     bool m_enableCulling;                // Toggle whether the compute shader pre-processes the indirect commands.
+    bool m_enableHierarchicalCulling;    // Toggle whether clusters are culled before the triangles in them.
 
     // Pipeline objects.
     CD3DX12_VIEWPORT m_viewport;
@@ -124,6 +147,7 @@ private:
     ComPtr<ID3D12RootSignature> m_rootSignature;
     ComPtr<ID3D12RootSignature> m_computeRootSignature;
     ComPtr<ID3D12CommandSignature> m_commandSignature;
+    ComPtr<ID3D12CommandSignature> m_dispatchCommandSignature;
     ComPtr<ID3D12DescriptorHeap> m_rtvHeap;
     ComPtr<ID3D12DescriptorHeap> m_dsvHeap;
     ComPtr<ID3D12DescriptorHeap> m_cbvSrvUavHeap;
@@ -140,6 +164,8 @@ private:
     // Asset objects.
     ComPtr<ID3D12PipelineState> m_pipelineState;
     ComPtr<ID3D12PipelineState> m_computeState;
+    ComPtr<ID3D12PipelineState> m_clusterCullingState;
+    ComPtr<ID3D12PipelineState> m_clusterTriangleCullingState;
     ComPtr<ID3D12GraphicsCommandList> m_commandList;
     ComPtr<ID3D12GraphicsCommandList> m_computeCommandList;
     ComPtr<ID3D12Resource> m_vertexBuffer;
@@ -148,14 +174,27 @@ private:
     ComPtr<ID3D12Resource> m_commandBuffer;
     ComPtr<ID3D12Resource> m_processedCommandBuffers[FrameCount];
     ComPtr<ID3D12Resource> m_processedCommandBufferCounterReset;
+    ComPtr<ID3D12Resource> m_clusterBoundsBuffer;
+    ComPtr<ID3D12Resource> m_visibleClusterBuffers[FrameCount];
     D3D12_VERTEX_BUFFER_VIEW m_vertexBufferView;
 
+    // Timestamps taken around the culling work of each frame, averaged between window text updates.
+    ComPtr<ID3D12QueryHeap> m_timestampQueryHeap;
+    ComPtr<ID3D12Resource> m_timestampReadbackBuffer;
+    UINT64 m_timestampFrequency;
+    bool m_cullingTimed[FrameCount];
+    UINT64 m_cullingTicks;
+    UINT m_cullingTimedFrameCount;
+    UINT m_frameCounter;
+
     void LoadPipeline();
     void LoadAssets();
     float GetRandomFloat(float min, float max);
     void PopulateCommandLists();
     void WaitForGpu();
     void MoveToNextFrame();
+    void ResetBenchmark();
+    void UpdateWindowText();
 
     // We pack the UAV counter into the same buffer as the commands rather than create
     // a separate 64K resource/heap for it. The counter must be aligned on 4K boundaries,
@@ -10,6 +10,9 @@
 //*********************************************************
 
 #define threadBlockSize 128
+#define clusterSize 64
+#define visibleClusterListOffset 16
+#define commandSize 24            // sizeof(IndirectCommand)
 
 struct SceneConstantBuffer
 {
@@ -26,17 +29,75 @@ struct IndirectCommand
     uint4 drawArguments;
 };
 
+struct ClusterBounds
+{
+    float4 minOffset;
+    float4 maxOffset;
+};
+
 cbuffer RootConstants : register(b0)
 {
-    float xOffset;        // Half the width of the triangles.
-    float zOffset;        // The z offset for the triangle vertices.
-    float cullOffset;    // The culling plane offset in homogenous space.
-    float commandCount;    // The number of commands to be processed.
+    float xOffset;                // Half the width of the triangles.
+    float zOffset;                // The z offset for the triangle vertices.
+    float cullOffset;            // The culling plane offset in homogenous space.
+    float commandCount;            // The number of commands to be processed.
+    float clusterCount;            // The number of clusters to be processed.
+    float projectionScale;        // The x scale of the projection.
+    uint commandCounterOffset;    // The offset of the command count in processedCommands.
 };
 
 StructuredBuffer<SceneConstantBuffer> cbv                : register(t0);    // SRV: Wrapped constant buffers
 StructuredBuffer<IndirectCommand> inputCommands            : register(t1);    // SRV: Indirect commands
+StructuredBuffer<ClusterBounds> clusterBounds            : register(t2);    // SRV: Bounds of the clusters of triangles
+ByteAddressBuffer visibleClustersIn                        : register(t3);    // SRV: Clusters that passed the first culling pass
 AppendStructuredBuffer<IndirectCommand> outputCommands    : register(u0);    // UAV: Processed indirect commands
+RWByteAddressBuffer visibleClusters                        : register(u1);    // UAV: Dispatch arguments followed by the visible clusters
+RWByteAddressBuffer processedCommands                    : register(u2);    // UAV: Processed indirect commands and their count
+
+groupshared uint appendCount;
+groupshared uint appendOffset;
+
+bool IsTriangleVisible(uint index)
+{
+    // Project the left and right bounds of the triangle into homogenous space.
+    float4 left = float4(-xOffset, 0.0f, zOffset, 1.0f) + cbv[index].offset;
+    left = mul(left, cbv[index].projection);
+    left /= left.w;
+
+    float4 right = float4(xOffset, 0.0f, zOffset, 1.0f) + cbv[index].offset;
+    right = mul(right, cbv[index].projection);
+    right /= right.w;
+
+    // Only draw triangles that are within the culling space.
+    return -cullOffset < right.x && left.x < cullOffset;
+}
+
+// Reserves an element for every thread of the group that appends one, with a single atomic on the counter
+// at counterOffset in counterBuffer. This keeps the threads of the whole dispatch from contending for the
+// same counter. Must be called by every thread of the group. Returns the index of the thread's element.
+uint GroupAppend(RWByteAddressBuffer counterBuffer, uint counterOffset, bool append, uint groupIndex)
+{
+    if (groupIndex == 0)
+    {
+        appendCount = 0;
+    }
+    GroupMemoryBarrierWithGroupSync();
+
+    uint index = 0;
+    if (append)
+    {
+        InterlockedAdd(appendCount, 1, index);
+    }
+    GroupMemoryBarrierWithGroupSync();
+
+    if (groupIndex == 0 && appendCount > 0)
+    {
+        counterBuffer.InterlockedAdd(counterOffset, appendCount, appendOffset);
+    }
+    GroupMemoryBarrierWithGroupSync();
+
+    return appendOffset + index;
+}
 
 [numthreads(threadBlockSize, 1, 1)]
 void CSMain(uint3 groupId : SV_GroupID, uint groupIndex : SV_GroupIndex)
@@ -48,19 +109,57 @@ void CSMain(uint3 groupId : SV_GroupID, uint groupIndex : SV_GroupIndex)
     // than commands.
     if (index < commandCount)
     {
-        // Project the left and right bounds of the triangle into homogenous space.
-        float4 left = float4(-xOffset, 0.0f, zOffset, 1.0f) + cbv[index].offset;
-        left = mul(left, cbv[index].projection);
-        left /= left.w;
-
-        float4 right = float4(xOffset, 0.0f, zOffset, 1.0f) + cbv[index].offset;
-        right = mul(right, cbv[index].projection);
-        right /= right.w;
-
-        // Only draw triangles that are within the culling space.
-        if (-cullOffset < right.x && left.x < cullOffset)
+        if (IsTriangleVisible(index))
         {
             outputCommands.Append(inputCommands[index]);
         }
     }
 }
+
+// The first pass of hierarchical culling. Each thread tests the bounds of one cluster, and the visible
+// clusters are listed for the second pass along with the number of thread groups it needs.
+[numthreads(threadBlockSize, 1, 1)]
+void CSCullClusters(uint3 groupId : SV_GroupID, uint groupIndex : SV_GroupIndex)
+{
+    uint index = (groupId.x * threadBlockSize) + groupIndex;
+
+    bool visible = false;
+    if (index < clusterCount)
+    {
+        // A triangle is visible when, in homogenous space, its right bound is right of -cullOffset and its
+        // left bound is left of cullOffset. Every triangle in the cluster fails one of those tests if the
+        // corner of the bounds that is best for that test fails it too. The projection divides x by z,
+        // which is positive, so compare before the divide.
+        ClusterBounds bounds = clusterBounds[index];
+        float farDepth = bounds.maxOffset.z + zOffset;
+        float right = (bounds.maxOffset.x + xOffset) * projectionScale;
+        float left = (bounds.minOffset.x - xOffset) * projectionScale;
+
+        visible = -cullOffset * farDepth < right && left < cullOffset * farDepth;
+    }
+
+    // The thread group count of the second pass is the first dispatch argument.
+    uint visibleIndex = GroupAppend(visibleClusters, 0, visible, groupIndex);
+    if (visible)
+    {
+        visibleClusters.Store(visibleClusterListOffset + visibleIndex * 4, index);
+    }
+}
+
+// The second pass of hierarchical culling. Each thread group culls the triangles of one visible cluster.
+[numthreads(clusterSize, 1, 1)]
+void CSCullClusterTriangles(uint3 groupId : SV_GroupID, uint groupIndex : SV_GroupIndex)
+{
+    uint cluster = visibleClustersIn.Load(visibleClusterListOffset + groupId.x * 4);
+    uint index = (cluster * clusterSize) + groupIndex;
+
+    bool visible = IsTriangleVisible(index);
+
+    uint commandIndex = GroupAppend(processedCommands, commandCounterOffset, visible, groupIndex);
+    if (visible)
+    {
+        IndirectCommand command = inputCommands[index];
+        processedCommands.Store2(commandIndex * commandSize, command.cbvAddress);
+        processedCommands.Store4(commandIndex * commandSize + 8, command.drawArguments);
+    }
+}
@@ -44,8 +44,19 @@ D3D12Fullscreen::D3D12Fullscreen(UINT width, UINT height, std::wstring name) :
     m_windowVisible(true),
     m_windowedMode(true),
     m_sceneConstantBufferData{},
-    m_fenceValues{}
+    m_fenceValues{},
+    m_measureLatency(false),
+    m_allowTearing(true),
+    m_presentTimes{},
+    m_lastLatencyReportTime{},
+    m_lastStatisticsPresentCount(0),
+    m_latencySum(0.0),
+    m_latencySampleCount(0),
+    m_averageLatencyMs(0.0),
+    m_presentationMode(DXGI_FRAME_PRESENTATION_MODE_COMPOSED),
+    m_presentationModeValid(false)
 {
+    QueryPerformanceFrequency(&m_qpcFrequency);
 }
 
 void D3D12Fullscreen::OnInit()
@@ -145,6 +156,10 @@ void D3D12Fullscreen::LoadPipeline()
     ThrowIfFailed(swapChain.As(&m_swapChain));
     m_frameIndex = m_swapChain->GetCurrentBackBufferIndex();
 
+    // The media interface reports whether presents are composed or independently flipped.
+    // It is optional; the latency measurement mode reports the mode as unknown without it.
+    swapChain.As(&m_swapChainMedia);
+
     // Create descriptor heaps.
     {
         // Describe and create a render target view (RTV) descriptor heap.
@@ -566,11 +581,23 @@ void D3D12Fullscreen::OnRender()
         // flag when it is supported, even when presenting in windowed mode.
         // However, this flag cannot be used if the app is in fullscreen mode as a
         // result of calling SetFullscreenState.
-        UINT presentFlags = (m_tearingSupport && m_windowedMode) ? DXGI_PRESENT_ALLOW_TEARING : 0;
+        UINT presentFlags = (m_allowTearing && m_tearingSupport && m_windowedMode) ? DXGI_PRESENT_ALLOW_TEARING : 0;
 
         // Present the frame.
+        LARGE_INTEGER presentTime;
+        QueryPerformanceCounter(&presentTime);
         ThrowIfFailed(m_swapChain->Present(0, presentFlags));
 
+        if (m_measureLatency)
+        {
+            UINT presentCount;
+            if (SUCCEEDED(m_swapChain->GetLastPresentCount(&presentCount)))
+            {
+                m_presentTimes[presentCount % PresentHistoryCount] = presentTime;
+            }
+            MeasurePresentLatency();
+        }
+
         MoveToNextFrame();
     }
 }
@@ -592,6 +619,9 @@ void D3D12Fullscreen::OnSizeChanged(UINT width, UINT height, bool minimized)
             m_fenceValues[n] = m_fenceValues[m_frameIndex];
         }
 
+        // Presents from before the resize won't show up in the frame statistics anymore.
+        ZeroMemory(m_presentTimes, sizeof(m_presentTimes));
+
         // Resize the swap chain to the desired dimensions.
         DXGI_SWAP_CHAIN_DESC desc = {};
         m_swapChain->GetDesc(&desc);
@@ -695,6 +725,29 @@ void D3D12Fullscreen::OnKeyDown(UINT8 key)
         LoadSceneResolutionDependentResources();
     }
     break;
+
+    // Instrument the L key to toggle the present latency measurement mode.
+    case 'L':
+    {
+        m_measureLatency = !m_measureLatency;
+        m_lastStatisticsPresentCount = 0;
+        m_latencySum = 0.0;
+        m_latencySampleCount = 0;
+        m_averageLatencyMs = 0.0;
+        m_presentationModeValid = false;
+        QueryPerformanceCounter(&m_lastLatencyReportTime);
+        UpdateTitle();
+    }
+    break;
+
+    // Instrument the T key to toggle DXGI_PRESENT_ALLOW_TEARING, so that the latency of
+    // presents with and without tearing can be compared.
+    case 'T':
+    {
+        m_allowTearing = !m_allowTearing;
+        UpdateTitle();
+    }
+    break;
     }
 }
 
@@ -908,10 +961,81 @@ void D3D12Fullscreen::UpdateTitle()
 {
     // Update resolutions shown in app title.
     wchar_t updatedTitle[256];
-    swprintf_s(updatedTitle, L"( %u x %u ) scaled to ( %u x %u )", m_resolutionOptions[m_resolutionIndex].Width, m_resolutionOptions[m_resolutionIndex].Height, m_width, m_height);
+    int length = swprintf_s(updatedTitle, L"( %u x %u ) scaled to ( %u x %u )", m_resolutionOptions[m_resolutionIndex].Width, m_resolutionOptions[m_resolutionIndex].Height, m_width, m_height);
+
+    // Append the measurements of the latency measurement mode.
+    if (m_measureLatency && length > 0)
+    {
+        LPCWSTR presentationMode = L"Unknown";
+        if (m_presentationModeValid)
+        {
+            switch (m_presentationMode)
+            {
+            case DXGI_FRAME_PRESENTATION_MODE_COMPOSED:             presentationMode = L"Composed"; break;
+            case DXGI_FRAME_PRESENTATION_MODE_OVERLAY:              presentationMode = L"Overlay"; break;
+            case DXGI_FRAME_PRESENTATION_MODE_NONE:                 presentationMode = L"Independent flip"; break;
+            case DXGI_FRAME_PRESENTATION_MODE_COMPOSITION_FAILURE:  presentationMode = L"Composition failure"; break;
+            }
+        }
+
+        bool tearing = m_allowTearing && m_tearingSupport && m_windowedMode;
+        swprintf_s(updatedTitle + length, _countof(updatedTitle) - length, L" - Present latency: %.2f ms, %s, Tearing: %s",
+            m_averageLatencyMs, presentationMode, tearing ? L"On" : L"Off");
+    }
+
     SetCustomWindowText(updatedTitle);
 }
 
+// Match the presents that have reached the display against the time they were submitted and
+// periodically report the average latency and the presentation mode in the title bar.
+void D3D12Fullscreen::MeasurePresentLatency()
+{
+    // The statistics describe the most recent present that the display picked up. SyncQPCTime
+    // is the time of the vblank at which that happened, in the same units as QueryPerformanceCounter.
+    // Frame statistics are unavailable while the swap chain is occluded or after a mode change.
+    DXGI_FRAME_STATISTICS statistics = {};
+    if (SUCCEEDED(m_swapChain->GetFrameStatistics(&statistics)) && statistics.PresentCount != m_lastStatisticsPresentCount)
+    {
+        UINT lastPresentCount = 0;
+        m_swapChain->GetLastPresentCount(&lastPresentCount);
+
+        // Only use presents that were timestamped and haven't been overwritten in the history since.
+        LARGE_INTEGER presentTime = m_presentTimes[statistics.PresentCount % PresentHistoryCount];
+        if (lastPresentCount - statistics.PresentCount < PresentHistoryCount && presentTime.QuadPart != 0 && statistics.SyncQPCTime.QuadPart >= presentTime.QuadPart)
+        {
+            m_latencySum += 1000.0 * (statistics.SyncQPCTime.QuadPart - presentTime.QuadPart) / m_qpcFrequency.QuadPart;
+            m_latencySampleCount++;
+        }
+        m_lastStatisticsPresentCount = statistics.PresentCount;
+    }
+
+    if (m_swapChainMedia)
+    {
+        DXGI_FRAME_STATISTICS_MEDIA mediaStatistics = {};
+        m_presentationModeValid = SUCCEEDED(m_swapChainMedia->GetFrameStatisticsMedia(&mediaStatistics));
+        if (m_presentationModeValid)
+        {
+            m_presentationMode = mediaStatistics.CompositionMode;
+        }
+    }
+
+    // Report twice a second.
+    LARGE_INTEGER now;
+    QueryPerformanceCounter(&now);
+    if (now.QuadPart - m_lastLatencyReportTime.QuadPart >= m_qpcFrequency.QuadPart / 2)
+    {
+        if (m_latencySampleCount > 0)
+        {
+            m_averageLatencyMs = m_latencySum / m_latencySampleCount;
+        }
+        m_latencySum = 0.0;
+        m_latencySampleCount = 0;
+        m_lastLatencyReportTime = now;
+
+        UpdateTitle();
+    }
+}
+
 void D3D12Fullscreen::OnWindowMoved(int, int)
 {
 }
\ No newline at end of file
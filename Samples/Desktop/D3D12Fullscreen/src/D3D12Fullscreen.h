@@ -40,6 +40,7 @@ protected:
 
 private:
     static const UINT FrameCount = 2;
+    static const UINT PresentHistoryCount = 64;
     static const float QuadWidth;
     static const float QuadHeight;
     static const float LetterboxColor[4];
@@ -117,6 +118,22 @@ private:
     bool m_windowVisible;
     bool m_windowedMode;
 
+    // Latency measurement mode.
+    // Each Present() is timestamped and matched against the time the display picked it up,
+    // as reported by the swap chain's frame statistics.
+    ComPtr<IDXGISwapChainMedia> m_swapChainMedia;
+    bool m_measureLatency;
+    bool m_allowTearing;                                    // Pass DXGI_PRESENT_ALLOW_TEARING when tearing is supported.
+    LARGE_INTEGER m_qpcFrequency;
+    LARGE_INTEGER m_presentTimes[PresentHistoryCount];      // Indexed by present count.
+    LARGE_INTEGER m_lastLatencyReportTime;
+    UINT m_lastStatisticsPresentCount;
+    double m_latencySum;
+    UINT m_latencySampleCount;
+    double m_averageLatencyMs;
+    DXGI_FRAME_PRESENTATION_MODE m_presentationMode;
+    bool m_presentationModeValid;
+
     void LoadPipeline();
     void LoadAssets();
     void LoadSizeDependentResources();
@@ -126,4 +143,5 @@ private:
     void MoveToNextFrame();
     void UpdatePostViewAndScissor();
     void UpdateTitle();
+    void MeasurePresentLatency();
 };
@@ -21,8 +21,10 @@
 #include "palettePS.hlsl.h"
 #include "presentVS.hlsl.h"
 #include "presentPS.hlsl.h"
+#include "presentCS.hlsl.h"
 
 const float D3D12HDR::ClearColor[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+const D3D12_RESOURCE_STATES D3D12HDR::SceneReadStates = D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE | D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE;
 const float D3D12HDR::HDRMetaDataPool[4][4] =
 {
     // MaxOutputNits, MinOutputNits, MaxCLL, MaxFALL
@@ -48,6 +50,7 @@ D3D12HDR::D3D12HDR(UINT width, UINT height, std::wstring name) :
     m_dxgiFactoryFlags(0),
     m_rootConstants{},
     m_updateVertexBuffer(true),
+    m_sceneDirty(true),
     m_fenceValues{},
     m_windowVisible(true),
     m_windowedMode(true)
@@ -164,7 +167,7 @@ void D3D12HDR::LoadPipeline()
 
         // Describe and create a shader resource view (SRV) descriptor heap.
         D3D12_DESCRIPTOR_HEAP_DESC srvHeapDesc = {};
-        srvHeapDesc.NumDescriptors = 2;                    // A descriptor for each of the 2 intermediate render targets.
+        srvHeapDesc.NumDescriptors = 3;                    // A descriptor for each of the 2 intermediate render targets + the compute present target.
         srvHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
         srvHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
         ThrowIfFailed(m_device->CreateDescriptorHeap(&srvHeapDesc, IID_PPV_ARGS(&m_srvHeap)));
@@ -185,14 +188,16 @@ void D3D12HDR::LoadAssets()
 {
     // Create a root signature containing root constants for brightness information
     // and the desired output curve as well as a SRV descriptor table pointing to the
-    // intermediate render targets.
+    // intermediate render targets and a UAV descriptor table for the compute present path.
     {
-        CD3DX12_DESCRIPTOR_RANGE ranges[1];
+        CD3DX12_DESCRIPTOR_RANGE ranges[2];
         ranges[0].Init(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 2, 0);
+        ranges[1].Init(D3D12_DESCRIPTOR_RANGE_TYPE_UAV, 1, 0);
 
-        CD3DX12_ROOT_PARAMETER rootParameters[2];
+        CD3DX12_ROOT_PARAMETER rootParameters[3];
         rootParameters[0].InitAsConstants(4, 0);
         rootParameters[1].InitAsDescriptorTable(1, &ranges[0]);
+        rootParameters[2].InitAsDescriptorTable(1, &ranges[1]);
 
         D3D12_STATIC_SAMPLER_DESC sampler = {};
         sampler.Filter = D3D12_FILTER_MIN_MAG_MIP_POINT;
@@ -283,6 +288,13 @@ void D3D12HDR::LoadAssets()
 
         psoDesc.RTVFormats[0] = m_swapChainFormats[_16];
         ThrowIfFailed(m_device->CreateGraphicsPipelineState(&psoDesc, IID_PPV_ARGS(&m_pipelineStates[Present16bitPSO])));
+
+        // Create the pipeline state for the compute present path. It writes typed UAV stores,
+        // so a single pipeline state covers every swap chain format.
+        D3D12_COMPUTE_PIPELINE_STATE_DESC computePsoDesc = {};
+        computePsoDesc.pRootSignature = m_rootSignature.Get();
+        computePsoDesc.CS = CD3DX12_SHADER_BYTECODE(g_presentCS, sizeof(g_presentCS));
+        ThrowIfFailed(m_device->CreateComputePipelineState(&computePsoDesc, IID_PPV_ARGS(&m_pipelineStates[PresentComputePSO])));
     }
 
     // Create the command list.
@@ -411,6 +423,7 @@ void D3D12HDR::LoadSizeDependentResources()
         }
 
         // Create the intermediate render target and an RTV for it.
+        // The scene is drawn into it only when it changes, so it otherwise stays readable by both present paths.
         D3D12_RESOURCE_DESC renderTargetDesc = m_renderTargets[0]->GetDesc();
         renderTargetDesc.Format = m_intermediateRenderTargetFormat;
 
@@ -421,7 +434,7 @@ void D3D12HDR::LoadSizeDependentResources()
             &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT),
             D3D12_HEAP_FLAG_NONE,
             &renderTargetDesc,
-            D3D12_RESOURCE_STATE_RENDER_TARGET,
+            SceneReadStates,
             &clearValue,
             IID_PPV_ARGS(&m_intermediateRenderTarget)));
 
@@ -450,8 +463,29 @@ void D3D12HDR::LoadSizeDependentResources()
 
         m_device->CreateRenderTargetView(m_UIRenderTarget.Get(), nullptr, rtvHandle);
         m_device->CreateShaderResourceView(m_UIRenderTarget.Get(), nullptr, srvHandle);
+        srvHandle.Offset(1, m_srvDescriptorSize);
+
+        // Create the target of the compute present path and a UAV for it. Swap chain buffers
+        // can't be written as UAVs, so it matches the back buffer format and gets copied into it.
+        D3D12_RESOURCE_DESC presentTargetDesc = m_renderTargets[0]->GetDesc();
+        presentTargetDesc.Flags = D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS;
+
+        ThrowIfFailed(m_device->CreateCommittedResource(
+            &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT),
+            D3D12_HEAP_FLAG_NONE,
+            &presentTargetDesc,
+            D3D12_RESOURCE_STATE_UNORDERED_ACCESS,
+            nullptr,
+            IID_PPV_ARGS(&m_presentTarget)));
+
+        NAME_D3D12_OBJECT(m_presentTarget);
+
+        m_device->CreateUnorderedAccessView(m_presentTarget.Get(), nullptr, nullptr, srvHandle);
     }
 
+    // The new intermediate render target needs the scene drawn into it.
+    m_sceneDirty = true;
+
     m_viewport.Width = static_cast<float>(m_width);
     m_viewport.Height = static_cast<float>(m_height);
 
@@ -640,10 +674,15 @@ void D3D12HDR::RenderScene()
     m_commandList->SetGraphicsRoot32BitConstants(0, RootConstantsCount, m_rootConstants, 0);
     m_commandList->SetGraphicsRootDescriptorTable(1, m_srvHeap->GetGPUDescriptorHandleForHeapStart());
 
-    // Draw the scene into the intermediate render target.
+    // The gradients and color space triangles only change with the size of the render target,
+    // so the intermediate render target keeps them between frames and is only redrawn when needed.
+    if (m_sceneDirty)
     {
         PIXBeginEvent(m_commandList.Get(), 0, L"Draw scene content");
 
+        D3D12_RESOURCE_BARRIER barrier = CD3DX12_RESOURCE_BARRIER::Transition(m_intermediateRenderTarget.Get(), SceneReadStates, D3D12_RESOURCE_STATE_RENDER_TARGET);
+        m_commandList->ResourceBarrier(1, &barrier);
+
         CD3DX12_CPU_DESCRIPTOR_HANDLE intermediateRtv(m_rtvHeap->GetCPUDescriptorHandleForHeapStart(), FrameCount, m_rtvDescriptorSize);
         m_commandList->OMSetRenderTargets(1, &intermediateRtv, FALSE, nullptr);
 
@@ -676,54 +715,98 @@ void D3D12HDR::RenderScene()
         m_commandList->DrawInstanced(3, 1, 15, 0);
         PIXEndEvent(m_commandList.Get());
 
+        barrier.Transition.StateBefore = D3D12_RESOURCE_STATE_RENDER_TARGET;
+        barrier.Transition.StateAfter = SceneReadStates;
+        m_commandList->ResourceBarrier(1, &barrier);
+
+        m_sceneDirty = false;
+
         PIXEndEvent(m_commandList.Get());
+    }
 
-        if (!m_enableUI)
-        {
-            intermediateRtv.Offset(1, m_rtvDescriptorSize);
-            m_commandList->OMSetRenderTargets(1, &intermediateRtv, FALSE, nullptr);
-            m_commandList->ClearRenderTargetView(intermediateRtv, clearColor, 0, nullptr);
-        }
+    if (!m_enableUI)
+    {
+        CD3DX12_CPU_DESCRIPTOR_HANDLE uiRtv(m_rtvHeap->GetCPUDescriptorHandleForHeapStart(), FrameCount + 1, m_rtvDescriptorSize);
+        const float clearColor[] = { 0.0f, 0.0f, 0.0f, 0.0f };
+        m_commandList->ClearRenderTargetView(uiRtv, clearColor, 0, nullptr);
     }
 
-    // Indicate that the intermediates will be used as SRVs in the pixel shader
-    // and the back buffer will be used as a render target.
-    D3D12_RESOURCE_BARRIER barriers[] = {
-        CD3DX12_RESOURCE_BARRIER::Transition(m_intermediateRenderTarget.Get(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE),
-        CD3DX12_RESOURCE_BARRIER::Transition(m_renderTargets[m_frameIndex].Get(), D3D12_RESOURCE_STATE_PRESENT, D3D12_RESOURCE_STATE_RENDER_TARGET),
-        CD3DX12_RESOURCE_BARRIER::Transition(m_UIRenderTarget.Get(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE),
-    };
+    // If the UI is enabled, the 11on12 layer has already transitioned the UI render target
+    // into the pixel shader resource state for us.
+    const D3D12_RESOURCE_STATES uiState = m_enableUI ? D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE : D3D12_RESOURCE_STATE_RENDER_TARGET;
 
-    // Process the intermediate and draw into the swap chain render target.
+    if (m_computePresent)
     {
-        PIXBeginEvent(m_commandList.Get(), 0, L"Apply HDR");
+        // Compose, encode and write the whole frame with one dispatch over 8x8 tiles and then copy it into the swap chain render target.
+        PIXBeginEvent(m_commandList.Get(), 0, L"Apply HDR (compute)");
+
+        D3D12_RESOURCE_BARRIER barrier = CD3DX12_RESOURCE_BARRIER::Transition(m_UIRenderTarget.Get(), uiState, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+        m_commandList->ResourceBarrier(1, &barrier);
+
+        m_commandList->SetComputeRootSignature(m_rootSignature.Get());
+        m_commandList->SetPipelineState(m_pipelineStates[PresentComputePSO].Get());
+        m_commandList->SetComputeRoot32BitConstants(0, RootConstantsCount, m_rootConstants, 0);
+        m_commandList->SetComputeRootDescriptorTable(1, m_srvHeap->GetGPUDescriptorHandleForHeapStart());
+        m_commandList->SetComputeRootDescriptorTable(2, CD3DX12_GPU_DESCRIPTOR_HANDLE(m_srvHeap->GetGPUDescriptorHandleForHeapStart(), 2, m_srvDescriptorSize));
+        m_commandList->Dispatch((m_width + 7) / 8, (m_height + 7) / 8, 1);
+
+        D3D12_RESOURCE_BARRIER copyBarriers[] = {
+            CD3DX12_RESOURCE_BARRIER::Transition(m_presentTarget.Get(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_COPY_SOURCE),
+            CD3DX12_RESOURCE_BARRIER::Transition(m_renderTargets[m_frameIndex].Get(), D3D12_RESOURCE_STATE_PRESENT, D3D12_RESOURCE_STATE_COPY_DEST),
+            CD3DX12_RESOURCE_BARRIER::Transition(m_UIRenderTarget.Get(), D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_RENDER_TARGET),
+        };
+        m_commandList->ResourceBarrier(2, copyBarriers);
 
-        // If the UI is enabled, the 11on12 layer will do the state transition for us.
-        UINT barrierCount = m_enableUI ? 2 : _countof(barriers);
-        m_commandList->ResourceBarrier(barrierCount, barriers);
-        m_commandList->SetPipelineState(m_pipelineStates[Present8bitPSO + m_currentSwapChainBitDepth].Get());
+        m_commandList->CopyResource(m_renderTargets[m_frameIndex].Get(), m_presentTarget.Get());
 
-        CD3DX12_CPU_DESCRIPTOR_HANDLE rtvHandle(m_rtvHeap->GetCPUDescriptorHandleForHeapStart(), m_frameIndex, m_rtvDescriptorSize);
-        m_commandList->OMSetRenderTargets(1, &rtvHandle, FALSE, nullptr);
+        // Return the present target to the UAV state, the back buffer to the present state
+        // and the UI render target to the render target state.
+        copyBarriers[0].Transition.StateBefore = D3D12_RESOURCE_STATE_COPY_SOURCE;
+        copyBarriers[0].Transition.StateAfter = D3D12_RESOURCE_STATE_UNORDERED_ACCESS;
+        copyBarriers[1].Transition.StateBefore = D3D12_RESOURCE_STATE_COPY_DEST;
+        copyBarriers[1].Transition.StateAfter = D3D12_RESOURCE_STATE_PRESENT;
 
-        m_commandList->ClearRenderTargetView(rtvHandle, ClearColor, 0, nullptr);
-
-        m_commandList->IASetVertexBuffers(0, 1, &m_presentVertexBufferView);
-        m_commandList->DrawInstanced(3, 1, 0, 0);
+        m_commandList->ResourceBarrier(_countof(copyBarriers), copyBarriers);
 
         PIXEndEvent(m_commandList.Get());
     }
+    else
+    {
+        // Indicate that the back buffer will be used as a render target and the UI render target as an SRV in the pixel shader.
+        D3D12_RESOURCE_BARRIER barriers[] = {
+            CD3DX12_RESOURCE_BARRIER::Transition(m_renderTargets[m_frameIndex].Get(), D3D12_RESOURCE_STATE_PRESENT, D3D12_RESOURCE_STATE_RENDER_TARGET),
+            CD3DX12_RESOURCE_BARRIER::Transition(m_UIRenderTarget.Get(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE),
+        };
+
+        // Process the intermediate and draw into the swap chain render target.
+        {
+            PIXBeginEvent(m_commandList.Get(), 0, L"Apply HDR");
+
+            UINT barrierCount = m_enableUI ? 1 : _countof(barriers);
+            m_commandList->ResourceBarrier(barrierCount, barriers);
+            m_commandList->SetPipelineState(m_pipelineStates[Present8bitPSO + m_currentSwapChainBitDepth].Get());
 
-    // Indicate that the intermediates will be used as render targets and the swap chain
-    // back buffer will be used for presentation.
-    barriers[0].Transition.StateBefore = D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE;
-    barriers[0].Transition.StateAfter = D3D12_RESOURCE_STATE_RENDER_TARGET;
-    barriers[1].Transition.StateBefore = D3D12_RESOURCE_STATE_RENDER_TARGET;
-    barriers[1].Transition.StateAfter = D3D12_RESOURCE_STATE_PRESENT;
-    barriers[2].Transition.StateBefore = D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE;
-    barriers[2].Transition.StateAfter = D3D12_RESOURCE_STATE_RENDER_TARGET;
+            CD3DX12_CPU_DESCRIPTOR_HANDLE rtvHandle(m_rtvHeap->GetCPUDescriptorHandleForHeapStart(), m_frameIndex, m_rtvDescriptorSize);
+            m_commandList->OMSetRenderTargets(1, &rtvHandle, FALSE, nullptr);
 
-    m_commandList->ResourceBarrier(_countof(barriers), barriers);
+            m_commandList->ClearRenderTargetView(rtvHandle, ClearColor, 0, nullptr);
+
+            m_commandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+            m_commandList->IASetVertexBuffers(0, 1, &m_presentVertexBufferView);
+            m_commandList->DrawInstanced(3, 1, 0, 0);
+
+            PIXEndEvent(m_commandList.Get());
+        }
+
+        // Indicate that the UI render target will be used as a render target and the swap chain
+        // back buffer will be used for presentation.
+        barriers[0].Transition.StateBefore = D3D12_RESOURCE_STATE_RENDER_TARGET;
+        barriers[0].Transition.StateAfter = D3D12_RESOURCE_STATE_PRESENT;
+        barriers[1].Transition.StateBefore = D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE;
+        barriers[1].Transition.StateAfter = D3D12_RESOURCE_STATE_RENDER_TARGET;
+
+        m_commandList->ResourceBarrier(_countof(barriers), barriers);
+    }
 
     ThrowIfFailed(m_commandList->Close());
 
@@ -853,6 +936,13 @@ void D3D12HDR::OnKeyDown(UINT8 key)
             break;
         }
 
+        case 'C':
+        {
+            // Switch between the compute and pixel shader present paths.
+            m_computePresent = !m_computePresent;
+            break;
+        }
+
         case 'M':
         {
             // Switch meta data value for testing. TV should adjust the content based on the metadata we sent.
@@ -39,6 +39,7 @@ public:
         return m_rootConstants[DisplayCurve] == sRGB ? L"sRGB" : m_rootConstants[DisplayCurve] == ST2084 ? L"ST.2084" : L"Linear";
     }
     inline bool GetHDRSupport() { return m_hdrSupport; }
+    inline bool GetComputePresent() { return m_computePresent; }
     inline float GetReferenceWhiteNits() { return m_referenceWhiteNits; }
     inline UINT GetHDRMetaDataPoolIndex() { return m_hdrMetaDataPoolIdx; }
 
@@ -58,6 +59,7 @@ protected:
 
 private:
     static const float ClearColor[4];
+    static const D3D12_RESOURCE_STATES SceneReadStates;    // The intermediate render target is read by both present paths.
     static const UINT TrianglesVertexCount = 18;
 
     // Vertex definitions.
@@ -98,6 +100,7 @@ private:
         Present8bitPSO,
         Present10bitPSO,
         Present16bitPSO,
+        PresentComputePSO,
         PipelineStateCount
     };
 
@@ -133,6 +136,7 @@ private:
     ComPtr<ID3D12Resource> m_renderTargets[FrameCount];
     ComPtr<ID3D12Resource> m_intermediateRenderTarget;
     ComPtr<ID3D12Resource> m_UIRenderTarget;
+    ComPtr<ID3D12Resource> m_presentTarget;
     ComPtr<ID3D12CommandAllocator> m_commandAllocators[FrameCount];
     ComPtr<ID3D12CommandQueue> m_commandQueue;
     ComPtr<ID3D12RootSignature> m_rootSignature;
@@ -158,6 +162,8 @@ private:
     UINT m_rootConstants[RootConstantsCount];
     float* m_rootConstantsF;
     bool m_updateVertexBuffer;
+    bool m_sceneDirty;
+    bool m_computePresent = true;
     std::shared_ptr<UILayer> m_uiLayer;
     bool m_enableUI = true;
     UINT m_hdrMetaDataPoolIdx = 0;
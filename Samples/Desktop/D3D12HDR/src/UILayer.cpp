@@ -28,6 +28,7 @@ UILayer::UILayer(D3D12HDR* pSample) :
     m_labels[ChangeFormat] = L"PgUp/PgDn\tChange back buffer format";
     m_labels[ChangeCurve] = L"H\tToggle between sRGB and ST.2084 (10-bit swap chain only)";
     m_labels[HideUI] = L"U\tToggle UI Visibility";
+    m_labels[PresentPath] = L"C\tToggle compute present";
     m_labels[MetaData] = L"M\tToggle HDR Meta Data";
 
     Initialize();
@@ -142,6 +143,7 @@ void UILayer::UpdateLabels()
     m_ui[Format].text = m_labels[Format];
     m_ui[Signal].text = m_labels[Signal];
     m_ui[HDRSupport].text = m_labels[HDRSupport];
+    m_ui[PresentPath].text = m_labels[PresentPath] + (m_pSample->GetComputePresent() ? L" (compute)" : L" (pixel shader)");
 
     float MaxOutputNits = D3D12HDR::HDRMetaDataPool[m_pSample->GetHDRMetaDataPoolIndex()][0];
     float MinOutputNits = D3D12HDR::HDRMetaDataPool[m_pSample->GetHDRMetaDataPoolIndex()][1];
@@ -261,7 +263,8 @@ void UILayer::Resize()
     m_ui[Rec2020] = { m_labels[Rec2020], D2D1::RectF(width * 0.5f, height * 0.75f + fontSize, width * 0.8f, height), m_textFormat.Get() };
 
     m_ui[ChangeFormat] = { m_labels[ChangeFormat], D2D1::RectF(smallFontSize, height - fontSize * 5.0f, width, height), m_smallTextFormat.Get() };
-    m_ui[ChangeCurve] = { m_labels[ChangeCurve], D2D1::RectF(smallFontSize, height - fontSize * 3.0f, width, height), m_smallTextFormat.Get() };
+    m_ui[ChangeCurve] = { m_labels[ChangeCurve], D2D1::RectF(smallFontSize, height - fontSize * 4.0f, width, height), m_smallTextFormat.Get() };
+    m_ui[PresentPath] = { m_labels[PresentPath], D2D1::RectF(smallFontSize, height - fontSize * 3.0f, width, height), m_smallTextFormat.Get() };
     m_ui[HideUI] = { m_labels[HideUI], D2D1::RectF(smallFontSize, height - fontSize * 2.0f, width, height), m_smallTextFormat.Get() };
     m_ui[MetaData] = { m_labels[MetaData], D2D1::RectF(smallFontSize, height - fontSize * 1.0f, width, height), m_smallTextFormat.Get() };
 }
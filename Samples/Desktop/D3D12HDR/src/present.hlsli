@@ -9,6 +9,8 @@
 //
 //*********************************************************
 
+#include "color.hlsli"
+
 struct PSInput
 {
     float4 position : SV_POSITION;
@@ -24,3 +26,32 @@ cbuffer RootConstants : register(b0)
 Texture2D g_scene : register(t0);
 Texture2D g_ui : register(t1);
 SamplerState g_sampler : register(s0);
+
+// Shared by the pixel and compute shader present paths.
+float3 ComposeAndEncode(float3 scene, float4 uiLayer)
+{
+    // Compose the scene and UI layers. Note that we convert UI layer from gamma 2.2 to to linear gamma before composing so both UI layers and the scene are with linear gamma and Rec.709 primaries. 
+    float3 result = lerp(scene, SRGBToLinear(uiLayer.rgb), uiLayer.a);
+
+    if (displayCurve == DISPLAY_CURVE_SRGB)
+    {
+        result = LinearToSRGB(result);
+    }
+    else if (displayCurve == DISPLAY_CURVE_ST2084)
+    {
+        const float st2084max = 10000.0;
+        const float hdrScalar = standardNits / st2084max;
+
+        // The HDR scene is in Rec.709, but the display is Rec.2020
+        result = Rec709ToRec2020(result);
+
+        // Apply the ST.2084 curve to the scene.
+        result = LinearToST2084(result * hdrScalar);
+    }
+    else // displayCurve == DISPLAY_CURVE_LINEAR
+    {
+        // Just pass through
+    }
+
+    return result;
+}
@@ -0,0 +1,33 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#include "present.hlsli"
+
+RWTexture2D<float4> g_output : register(u0);
+
+// Composes the UI over the scene and encodes it for the swap chain in a single pass,
+// with each thread group covering an 8x8 tile of the output.
+[numthreads(8, 8, 1)]
+void CSMain(uint3 dispatchThreadId : SV_DispatchThreadID)
+{
+    uint2 dimensions;
+    g_output.GetDimensions(dimensions.x, dimensions.y);
+    if (any(dispatchThreadId.xy >= dimensions))
+    {
+        return;
+    }
+
+    // Both layers match the output resolution, so each thread loads its texel directly instead of sampling.
+    float3 scene = g_scene[dispatchThreadId.xy].rgb;
+    float4 uiLayer = g_ui[dispatchThreadId.xy];
+
+    g_output[dispatchThreadId.xy] = float4(ComposeAndEncode(scene, uiLayer), 1.0);
+}
\ No newline at end of file
@@ -15,6 +15,7 @@
 const float D3D12HeterogeneousMultiadapter::TriangleHalfWidth = 0.025f;
 const float D3D12HeterogeneousMultiadapter::TriangleDepth = 1.0f;
 const float D3D12HeterogeneousMultiadapter::ClearColor[4] = { 0.0f, 0.2f, 0.3f, 1.0f };
+const float D3D12HeterogeneousMultiadapter::BlurSplitHysteresis = 0.1f;
 
 D3D12HeterogeneousMultiadapter::D3D12HeterogeneousMultiadapter(int width, int height, LPCWSTR name) :
     DXSample(width, height, name),
@@ -25,18 +26,29 @@ D3D12HeterogeneousMultiadapter::D3D12HeterogeneousMultiadapter(int width, int he
     m_currentTimesIndex(0),
     m_drawTimeMovingAverage(0),
     m_blurTimeMovingAverage(0),
+    m_primaryBlurTimeMovingAverage(0),
+    m_primaryBlurPassCount(0),
+    m_blurSplitCooldown(0),
     m_viewport(0.0f, 0.0f, static_cast<float>(width), static_cast<float>(height)),
     m_scissorRect(0, 0, static_cast<LONG>(width), static_cast<LONG>(height)),
     m_currentPresentFenceValue(1),
     m_currentRenderFenceValue(1),
+    m_currentCopyFenceValue(1),
     m_currentCrossAdapterFenceValue(1),
     m_workloadConstantBufferData(),
     m_blurWorkloadConstantBufferData(),
     m_crossAdapterTextureSupport(false),
+    m_copyQueueTimestampSupport{},
+    m_copyCommandQueueTimestampFrequencies{},
     m_rtvDescriptorSizes{},
     m_srvDescriptorSizes{},
     m_drawTimes{},
     m_blurTimes{},
+    m_primaryBlurTimes{},
+    m_transferTimes{},
+    m_transferTimeMovingAverages{},
+    m_blurPassTimes{},
+    m_pBlurWorkloadCbvDataBegin{},
     m_frameFenceValues{}
 {
     m_constantBufferData.resize(MaxTriangleCount);
@@ -134,8 +146,30 @@ void D3D12HeterogeneousMultiadapter::LoadPipeline()
         ThrowIfFailed(m_directCommandQueues[i]->GetTimestampFrequency(&m_directCommandQueueTimestampFrequencies[i]));
     }
 
+    // The secondary adapter presents, so its direct queue ends every frame.
+    SetBenchmarkCommandQueue(m_devices[Secondary].Get(), m_directCommandQueues[Secondary].Get());
+
+    // Each adapter has a copy queue so that both sides of the cross-adapter transfer
+    // can overlap with the direct queues working on other frames.
     queueDesc.Type = D3D12_COMMAND_LIST_TYPE_COPY;
-    ThrowIfFailed(m_devices[Primary]->CreateCommandQueue(&queueDesc, IID_PPV_ARGS(&m_copyCommandQueue)));
+
+    for (UINT i = 0; i < GraphicsAdaptersCount; i++)
+    {
+        ThrowIfFailed(m_devices[i]->CreateCommandQueue(&queueDesc, IID_PPV_ARGS(&m_copyCommandQueues[i])));
+
+        // Timestamps on the copy queues measure the cost of the cross-adapter transfer,
+        // but not every adapter supports them.
+        D3D12_FEATURE_DATA_D3D12_OPTIONS3 options3 = {};
+        if (SUCCEEDED(m_devices[i]->CheckFeatureSupport(D3D12_FEATURE_D3D12_OPTIONS3, &options3, sizeof(options3))))
+        {
+            m_copyQueueTimestampSupport[i] = options3.CopyQueueTimestampQueriesSupported;
+        }
+
+        if (m_copyQueueTimestampSupport[i])
+        {
+            ThrowIfFailed(m_copyCommandQueues[i]->GetTimestampFrequency(&m_copyCommandQueueTimestampFrequencies[i]));
+        }
+    }
 
     // Describe and create the swap chain on the secondary device because that's where we present from.
     DXGI_SWAP_CHAIN_DESC1 swapChainDesc = {};
@@ -176,6 +210,11 @@ void D3D12HeterogeneousMultiadapter::LoadPipeline()
                 // Add space for the intermediate render target.
                 rtvHeapDesc.NumDescriptors++;
             }
+            else
+            {
+                // Add space for the blur render targets used when blur passes run on the primary adapter.
+                rtvHeapDesc.NumDescriptors += FrameCount;
+            }
 
             rtvHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_RTV;
             rtvHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
@@ -189,12 +228,22 @@ void D3D12HeterogeneousMultiadapter::LoadPipeline()
         dsvHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
         ThrowIfFailed(m_devices[Primary]->CreateDescriptorHeap(&dsvHeapDesc, IID_PPV_ARGS(&m_dsvHeap)));
 
-        // Describe and create a shader resource view (SRV) descriptor heap.
-        D3D12_DESCRIPTOR_HEAP_DESC cbvSrvUavHeapDesc = {};
-        cbvSrvUavHeapDesc.NumDescriptors = FrameCount + 1;    // +1 for the intermediate blur render target.
-        cbvSrvUavHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
-        cbvSrvUavHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
-        ThrowIfFailed(m_devices[Secondary]->CreateDescriptorHeap(&cbvSrvUavHeapDesc, IID_PPV_ARGS(&m_cbvSrvUavHeap)));
+        // Describe and create the shader resource view (SRV) descriptor heaps.
+        for (UINT i = 0; i < GraphicsAdaptersCount; i++)
+        {
+            D3D12_DESCRIPTOR_HEAP_DESC cbvSrvUavHeapDesc = {};
+            cbvSrvUavHeapDesc.NumDescriptors = FrameCount;
+            cbvSrvUavHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
+            cbvSrvUavHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
+
+            if (i == Secondary)
+            {
+                // Add space for the intermediate blur render target.
+                cbvSrvUavHeapDesc.NumDescriptors++;
+            }
+
+            ThrowIfFailed(m_devices[i]->CreateDescriptorHeap(&cbvSrvUavHeapDesc, IID_PPV_ARGS(&m_cbvSrvUavHeaps[i])));
+        }
 
         for (UINT i = 0; i < GraphicsAdaptersCount; i++)
         {
@@ -205,8 +254,8 @@ void D3D12HeterogeneousMultiadapter::LoadPipeline()
 
     // Create query heaps and result buffers.
     {
-        // Two timestamps for each frame.
-        const UINT resultCount = 2 * FrameCount;
+        // Three timestamps for each frame.
+        const UINT resultCount = TimestampsPerFrame * FrameCount;
         const UINT resultBufferSize = resultCount * sizeof(UINT64);
 
         D3D12_QUERY_HEAP_DESC timestampHeapDesc = {};
@@ -225,6 +274,26 @@ void D3D12HeterogeneousMultiadapter::LoadPipeline()
 
             ThrowIfFailed(m_devices[i]->CreateQueryHeap(&timestampHeapDesc, IID_PPV_ARGS(&m_timestampQueryHeaps[i])));
         }
+
+        // Two timestamps for each frame bracket the copies.
+        timestampHeapDesc.Type = D3D12_QUERY_HEAP_TYPE_COPY_QUEUE_TIMESTAMP;
+        timestampHeapDesc.Count = 2 * FrameCount;
+
+        for (UINT i = 0; i < GraphicsAdaptersCount; i++)
+        {
+            if (m_copyQueueTimestampSupport[i])
+            {
+                ThrowIfFailed(m_devices[i]->CreateCommittedResource(
+                    &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_READBACK),
+                    D3D12_HEAP_FLAG_NONE,
+                    &CD3DX12_RESOURCE_DESC::Buffer(timestampHeapDesc.Count * sizeof(UINT64)),
+                    D3D12_RESOURCE_STATE_COPY_DEST,
+                    nullptr,
+                    IID_PPV_ARGS(&m_copyTimestampResultBuffers[i])));
+
+                ThrowIfFailed(m_devices[i]->CreateQueryHeap(&timestampHeapDesc, IID_PPV_ARGS(&m_copyTimestampQueryHeaps[i])));
+            }
+        }
     }
 
     // Create frame resources.
@@ -266,11 +335,30 @@ void D3D12HeterogeneousMultiadapter::LoadPipeline()
                 rtvHandle.Offset(1, m_rtvDescriptorSizes[i]);
 
                 ThrowIfFailed(m_devices[i]->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&m_directCommandAllocators[i][n])));
+                ThrowIfFailed(m_devices[i]->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_COPY, IID_PPV_ARGS(&m_copyCommandAllocators[i][n])));
+            }
+        }
 
-                if (i == Primary)
-                {
-                    ThrowIfFailed(m_devices[i]->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_COPY, IID_PPV_ARGS(&m_copyCommandAllocators[n])));
-                }
+        // Create the render targets that receive the blur passes run on the primary adapter,
+        // and SRVs of the primary adapter's render targets for those passes to sample.
+        {
+            CD3DX12_CPU_DESCRIPTOR_HANDLE rtvHandle(m_rtvHeaps[Primary]->GetCPUDescriptorHandleForHeapStart(), FrameCount, m_rtvDescriptorSizes[Primary]);
+            CD3DX12_CPU_DESCRIPTOR_HANDLE srvHandle(m_cbvSrvUavHeaps[Primary]->GetCPUDescriptorHandleForHeapStart());
+            for (UINT n = 0; n < FrameCount; n++)
+            {
+                ThrowIfFailed(m_devices[Primary]->CreateCommittedResource(
+                    &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT),
+                    D3D12_HEAP_FLAG_NONE,
+                    &renderTargetDesc,
+                    D3D12_RESOURCE_STATE_COMMON,
+                    nullptr,
+                    IID_PPV_ARGS(&m_primaryBlurRenderTargets[n])));
+
+                m_devices[Primary]->CreateRenderTargetView(m_primaryBlurRenderTargets[n].Get(), nullptr, rtvHandle);
+                rtvHandle.Offset(1, m_rtvDescriptorSizes[Primary]);
+
+                m_devices[Primary]->CreateShaderResourceView(m_renderTargets[Primary][n].Get(), nullptr, srvHandle);
+                srvHandle.Offset(m_srvDescriptorSizes[Primary]);
             }
         }
 
@@ -358,11 +446,13 @@ void D3D12HeterogeneousMultiadapter::LoadPipeline()
                 {
                     // If the primary adapter's render target must be shared as a buffer,
                     // create a texture resource to copy it into on the secondary adapter.
+                    // The texture is written by the secondary adapter's copy queue, so it
+                    // starts out and is returned to the common state after each frame.
                     ThrowIfFailed(m_devices[Secondary]->CreateCommittedResource(
                         &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT),
                         D3D12_HEAP_FLAG_NONE,
                         &renderTargetDesc,
-                        D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE,
+                        D3D12_RESOURCE_STATE_COMMON,
                         nullptr,
                         IID_PPV_ARGS(&m_secondaryAdapterTextures[n])));
                 }
@@ -387,7 +477,7 @@ void D3D12HeterogeneousMultiadapter::LoadPipeline()
         
         // Create SRVs for the shared resources and intermediate render target on the secondary adapter.
         {
-            CD3DX12_CPU_DESCRIPTOR_HANDLE srvHandle(m_cbvSrvUavHeap->GetCPUDescriptorHandleForHeapStart());
+            CD3DX12_CPU_DESCRIPTOR_HANDLE srvHandle(m_cbvSrvUavHeaps[Secondary]->GetCPUDescriptorHandleForHeapStart());
             for (UINT n = 0; n < FrameCount; n++)
             {
                 ID3D12Resource* pSrvResource = m_crossAdapterTextureSupport ? m_crossAdapterResources[Secondary][n].Get() : m_secondaryAdapterTextures[n].Get();
@@ -427,13 +517,6 @@ void D3D12HeterogeneousMultiadapter::LoadAssets()
         ThrowIfFailed(D3DX12SerializeVersionedRootSignature(&rootSignatureDesc, featureData.HighestVersion, &signature, &error));
         ThrowIfFailed(m_devices[Primary]->CreateRootSignature(0, signature->GetBufferPointer(), signature->GetBufferSize(), IID_PPV_ARGS(&m_rootSignature)));
 
-        featureData.HighestVersion = D3D_ROOT_SIGNATURE_VERSION_1_1;
-
-        if (FAILED(m_devices[Secondary]->CheckFeatureSupport(D3D12_FEATURE_ROOT_SIGNATURE, &featureData, sizeof(featureData))))
-        {
-            featureData.HighestVersion = D3D_ROOT_SIGNATURE_VERSION_1_0;
-        }
-
         // We don't modify the SRV in the command list after SetGraphicsRootDescriptorTable
         // is executed on the GPU so we can use the default range behavior:
         // D3D12_DESCRIPTOR_RANGE_FLAG_DATA_STATIC_WHILE_SET_AT_EXECUTE
@@ -456,8 +539,19 @@ void D3D12HeterogeneousMultiadapter::LoadAssets()
         D3D12_STATIC_SAMPLER_DESC staticSamplers[] = { staticPointSampler, staticLinearSampler };
         rootSignatureDesc.Init_1_1(_countof(blurRootParameters), blurRootParameters, _countof(staticSamplers), staticSamplers, D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT);
 
-        ThrowIfFailed(D3DX12SerializeVersionedRootSignature(&rootSignatureDesc, featureData.HighestVersion, &signature, &error));
-        ThrowIfFailed(m_devices[Secondary]->CreateRootSignature(0, signature->GetBufferPointer(), signature->GetBufferSize(), IID_PPV_ARGS(&m_blurRootSignature)));
+        // Both adapters can run blur passes.
+        for (UINT i = 0; i < GraphicsAdaptersCount; i++)
+        {
+            featureData.HighestVersion = D3D_ROOT_SIGNATURE_VERSION_1_1;
+
+            if (FAILED(m_devices[i]->CheckFeatureSupport(D3D12_FEATURE_ROOT_SIGNATURE, &featureData, sizeof(featureData))))
+            {
+                featureData.HighestVersion = D3D_ROOT_SIGNATURE_VERSION_1_0;
+            }
+
+            ThrowIfFailed(D3DX12SerializeVersionedRootSignature(&rootSignatureDesc, featureData.HighestVersion, &signature, &error));
+            ThrowIfFailed(m_devices[i]->CreateRootSignature(0, signature->GetBufferPointer(), signature->GetBufferSize(), IID_PPV_ARGS(&m_blurRootSignatures[i])));
+        }
     }
 
     // Create the pipeline states, which includes compiling and loading shaders.
@@ -513,30 +607,37 @@ void D3D12HeterogeneousMultiadapter::LoadAssets()
         ThrowIfFailed(m_devices[Primary]->CreateGraphicsPipelineState(&psoDesc, IID_PPV_ARGS(&m_pipelineState)));
 
         psoDesc.InputLayout = { blurInputElementDescs, _countof(blurInputElementDescs) };
-        psoDesc.pRootSignature = m_blurRootSignature.Get();
         psoDesc.VS = CD3DX12_SHADER_BYTECODE(vertexShaderBlur.Get());
-        psoDesc.PS = CD3DX12_SHADER_BYTECODE(pixelShaderBlurU.Get());
         psoDesc.DepthStencilState.DepthEnable = false;
         psoDesc.DSVFormat = DXGI_FORMAT_UNKNOWN;
-        ThrowIfFailed(m_devices[Secondary]->CreateGraphicsPipelineState(&psoDesc, IID_PPV_ARGS(&m_blurPipelineStates[0])));
 
-        psoDesc.PS = CD3DX12_SHADER_BYTECODE(pixelShaderBlurV.Get());
-        ThrowIfFailed(m_devices[Secondary]->CreateGraphicsPipelineState(&psoDesc, IID_PPV_ARGS(&m_blurPipelineStates[1])));
+        for (UINT i = 0; i < GraphicsAdaptersCount; i++)
+        {
+            psoDesc.pRootSignature = m_blurRootSignatures[i].Get();
+            psoDesc.PS = CD3DX12_SHADER_BYTECODE(pixelShaderBlurU.Get());
+            ThrowIfFailed(m_devices[i]->CreateGraphicsPipelineState(&psoDesc, IID_PPV_ARGS(&m_blurPipelineStates[i][0])));
+
+            psoDesc.PS = CD3DX12_SHADER_BYTECODE(pixelShaderBlurV.Get());
+            ThrowIfFailed(m_devices[i]->CreateGraphicsPipelineState(&psoDesc, IID_PPV_ARGS(&m_blurPipelineStates[i][1])));
+        }
     }
 
     // Create the command lists.
     ThrowIfFailed(m_devices[Primary]->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, m_directCommandAllocators[Primary][m_frameIndex].Get(), m_pipelineState.Get(), IID_PPV_ARGS(&m_directCommandLists[Primary])));
-    ThrowIfFailed(m_devices[Primary]->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_COPY, m_copyCommandAllocators[m_frameIndex].Get(), m_pipelineState.Get(), IID_PPV_ARGS(&m_copyCommandList)));
-    ThrowIfFailed(m_copyCommandList->Close());
+    for (UINT i = 0; i < GraphicsAdaptersCount; i++)
+    {
+        ThrowIfFailed(m_devices[i]->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_COPY, m_copyCommandAllocators[i][m_frameIndex].Get(), nullptr, IID_PPV_ARGS(&m_copyCommandLists[i])));
+        ThrowIfFailed(m_copyCommandLists[i]->Close());
+    }
 
-    ThrowIfFailed(m_devices[Secondary]->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, m_directCommandAllocators[Secondary][m_frameIndex].Get(), m_blurPipelineStates[0].Get(), IID_PPV_ARGS(&m_directCommandLists[Secondary])));
+    ThrowIfFailed(m_devices[Secondary]->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, m_directCommandAllocators[Secondary][m_frameIndex].Get(), m_blurPipelineStates[Secondary][0].Get(), IID_PPV_ARGS(&m_directCommandLists[Secondary])));
 
     // Note: ComPtr's are CPU objects but these resources need to stay in scope until
     // the command list that references them has finished executing on the GPU.
     // We will flush the GPU at the end of this method to ensure the resources are not
     // prematurely destroyed.
     ComPtr<ID3D12Resource> vertexBufferUpload;
-    ComPtr<ID3D12Resource> fullscreenQuadVertexBufferUpload;
+    ComPtr<ID3D12Resource> fullscreenQuadVertexBufferUploads[GraphicsAdaptersCount];
 
     // Create the vertex buffer for the primary adapter.
     {
@@ -582,7 +683,8 @@ void D3D12HeterogeneousMultiadapter::LoadAssets()
         m_vertexBufferView.SizeInBytes = sizeof(triangleVertices);
     }
 
-    // Create the vertex buffer for the secondary adapter.
+    // Create the fullscreen quad vertex buffers used by the blur passes on each adapter.
+    for (UINT i = 0; i < GraphicsAdaptersCount; i++)
     {
         // Define the geometry for a fullscreen triangle.
         VertexPositionUV quadVertices[] =
@@ -595,21 +697,21 @@ void D3D12HeterogeneousMultiadapter::LoadAssets()
 
         const UINT vertexBufferSize = sizeof(quadVertices);
 
-        ThrowIfFailed(m_devices[Secondary]->CreateCommittedResource(
+        ThrowIfFailed(m_devices[i]->CreateCommittedResource(
             &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT),
             D3D12_HEAP_FLAG_NONE,
             &CD3DX12_RESOURCE_DESC::Buffer(vertexBufferSize),
             D3D12_RESOURCE_STATE_COPY_DEST,
             nullptr,
-            IID_PPV_ARGS(&m_fullscreenQuadVertexBuffer)));
+            IID_PPV_ARGS(&m_fullscreenQuadVertexBuffers[i])));
 
-        ThrowIfFailed(m_devices[Secondary]->CreateCommittedResource(
+        ThrowIfFailed(m_devices[i]->CreateCommittedResource(
             &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
             D3D12_HEAP_FLAG_NONE,
             &CD3DX12_RESOURCE_DESC::Buffer(vertexBufferSize),
             D3D12_RESOURCE_STATE_GENERIC_READ,
             nullptr,
-            IID_PPV_ARGS(&fullscreenQuadVertexBufferUpload)));
+            IID_PPV_ARGS(&fullscreenQuadVertexBufferUploads[i])));
 
         // Copy data to the intermediate upload heap and then schedule a copy
         // from the upload heap to the vertex buffer.
@@ -618,13 +720,13 @@ void D3D12HeterogeneousMultiadapter::LoadAssets()
         vertexData.RowPitch = vertexBufferSize;
         vertexData.SlicePitch = vertexData.RowPitch;
 
-        UpdateSubresources<1>(m_directCommandLists[Secondary].Get(), m_fullscreenQuadVertexBuffer.Get(), fullscreenQuadVertexBufferUpload.Get(), 0, 0, 1, &vertexData);
-        m_directCommandLists[Secondary]->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(m_fullscreenQuadVertexBuffer.Get(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER));
+        UpdateSubresources<1>(m_directCommandLists[i].Get(), m_fullscreenQuadVertexBuffers[i].Get(), fullscreenQuadVertexBufferUploads[i].Get(), 0, 0, 1, &vertexData);
+        m_directCommandLists[i]->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(m_fullscreenQuadVertexBuffers[i].Get(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER));
 
         // Initialize the vertex buffer view.
-        m_fullscreenQuadVertexBufferView.BufferLocation = m_fullscreenQuadVertexBuffer->GetGPUVirtualAddress();
-        m_fullscreenQuadVertexBufferView.StrideInBytes = sizeof(VertexPositionUV);
-        m_fullscreenQuadVertexBufferView.SizeInBytes = sizeof(quadVertices);
+        m_fullscreenQuadVertexBufferViews[i].BufferLocation = m_fullscreenQuadVertexBuffers[i]->GetGPUVirtualAddress();
+        m_fullscreenQuadVertexBufferViews[i].StrideInBytes = sizeof(VertexPositionUV);
+        m_fullscreenQuadVertexBufferViews[i].SizeInBytes = sizeof(quadVertices);
     }
 
     // Create the depth stencil view.
@@ -698,16 +800,18 @@ void D3D12HeterogeneousMultiadapter::LoadAssets()
             memcpy(m_pWorkloadCbvDataBegin, &m_workloadConstantBufferData, workloadConstantBufferSize / FrameCount);
         }
 
+        // The blur constant buffers are created on both adapters because either can run blur passes.
+        for (UINT i = 0; i < GraphicsAdaptersCount; i++)
         {
             const UINT64 blurWorkloadConstantBufferSize = sizeof(WorkloadConstantBufferData) * FrameCount;
 
-            ThrowIfFailed(m_devices[Secondary]->CreateCommittedResource(
+            ThrowIfFailed(m_devices[i]->CreateCommittedResource(
                 &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
                 D3D12_HEAP_FLAG_NONE,
                 &CD3DX12_RESOURCE_DESC::Buffer(blurWorkloadConstantBufferSize),
                 D3D12_RESOURCE_STATE_GENERIC_READ,
                 nullptr,
-                IID_PPV_ARGS(&m_blurWorkloadConstantBuffer)));
+                IID_PPV_ARGS(&m_blurWorkloadConstantBuffers[i])));
 
             // Setup constant buffer data.
             m_blurWorkloadConstantBufferData.loopCount = m_blurPSLoopCount;
@@ -715,22 +819,23 @@ void D3D12HeterogeneousMultiadapter::LoadAssets()
             // Map and initialize the constant buffer. We don't unmap this until the
             // app closes. Keeping things mapped for the lifetime of the resource is okay.
             CD3DX12_RANGE readRange(0, 0);        // We do not intend to read from this resource on the CPU.
-            ThrowIfFailed(m_blurWorkloadConstantBuffer->Map(0, &readRange, reinterpret_cast<void**>(&m_pBlurWorkloadCbvDataBegin)));
-            memcpy(m_pBlurWorkloadCbvDataBegin, &m_blurWorkloadConstantBufferData, blurWorkloadConstantBufferSize / FrameCount);
+            ThrowIfFailed(m_blurWorkloadConstantBuffers[i]->Map(0, &readRange, reinterpret_cast<void**>(&m_pBlurWorkloadCbvDataBegin[i])));
+            memcpy(m_pBlurWorkloadCbvDataBegin[i], &m_blurWorkloadConstantBufferData, blurWorkloadConstantBufferSize / FrameCount);
         }
 
+        for (UINT i = 0; i < GraphicsAdaptersCount; i++)
         {
-            ThrowIfFailed(m_devices[Secondary]->CreateCommittedResource(
+            ThrowIfFailed(m_devices[i]->CreateCommittedResource(
                 &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
                 D3D12_HEAP_FLAG_NONE,
                 &CD3DX12_RESOURCE_DESC::Buffer(sizeof(BlurConstantBufferData)),
                 D3D12_RESOURCE_STATE_GENERIC_READ,
                 nullptr,
-                IID_PPV_ARGS(&m_blurConstantBuffer)));
+                IID_PPV_ARGS(&m_blurConstantBuffers[i])));
 
             // Map the constant buffer.
             CD3DX12_RANGE readRange(0, 0);        // We do not intend to read from this resource on the CPU.
-            ThrowIfFailed(m_blurConstantBuffer->Map(0, &readRange, reinterpret_cast<void**>(&m_pBlurCbvDataBegin)));
+            ThrowIfFailed(m_blurConstantBuffers[i]->Map(0, &readRange, reinterpret_cast<void**>(&m_pBlurCbvDataBegin)));
 
             // Setup constant buffer data.
             m_pBlurCbvDataBegin[0].offset = 0.5f;
@@ -740,7 +845,7 @@ void D3D12HeterogeneousMultiadapter::LoadAssets()
             // Unmap the constant buffer because we don't update this again.
             // If we ever do, it should be buffered by the number of frames like other constant buffers.
             const CD3DX12_RANGE emptyRange(0, 0);
-            m_blurConstantBuffer->Unmap(0, &emptyRange);
+            m_blurConstantBuffers[i]->Unmap(0, &emptyRange);
             m_pBlurCbvDataBegin = nullptr;
         }
     }
@@ -764,6 +869,11 @@ void D3D12HeterogeneousMultiadapter::LoadAssets()
         // When this is signaled, the primary adapter's copy queue can begin copying to the cross-adapter shared resource.
         ThrowIfFailed(m_devices[Primary]->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&m_renderFence)));
 
+        // Fence used by the secondary adapter's copy queue to signal its direct queue that it has
+        // copied the cross-adapter shared resource into a texture it can sample from.
+        // Only used if cross-adapter row-major textures are not supported.
+        ThrowIfFailed(m_devices[Secondary]->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&m_copyFence)));
+
         // Cross-adapter shared fence used by both adapters.
         // Used by the primary adapter to signal the secondary adapter that it has completed copying to the cross-adapter shared resource.
         // When this is signaled, the secondary adapter can begin its work.
@@ -824,24 +934,61 @@ void D3D12HeterogeneousMultiadapter::OnUpdate()
         D3D12_RANGE readRange = {};
         const D3D12_RANGE emptyRange = {};
 
-        UINT64* ppMovingAverage[] = { m_drawTimes, m_blurTimes };
+        // The cross-adapter transfer runs on the copy queues. The secondary adapter's copy
+        // queue is only used if the shared resource must be copied into a texture.
+        for (UINT i = 0; i < GraphicsAdaptersCount; i++)
+        {
+            m_transferTimes[i][m_currentTimesIndex] = 0;
+
+            if (m_copyQueueTimestampSupport[i] && (i == Primary || !m_crossAdapterTextureSupport))
+            {
+                readRange.Begin = 2 * oldestFrameIndex * sizeof(UINT64);
+                readRange.End = readRange.Begin + 2 * sizeof(UINT64);
+
+                void* pData = nullptr;
+                ThrowIfFailed(m_copyTimestampResultBuffers[i]->Map(0, &readRange, &pData));
+
+                const UINT64* pTimestamps = reinterpret_cast<UINT64*>(static_cast<UINT8*>(pData) + readRange.Begin);
+                const UINT64 timeStampDelta = pTimestamps[1] - pTimestamps[0];
+
+                // Unmap with an empty range (written range).
+                m_copyTimestampResultBuffers[i]->Unmap(0, &emptyRange);
+
+                m_transferTimes[i][m_currentTimesIndex] = (timeStampDelta * 1000000) / m_copyCommandQueueTimestampFrequencies[i];
+            }
+        }
+
+        // The first span of each direct command list is the scene on the primary adapter and the
+        // transition of the received texture on the secondary adapter, which is counted as part
+        // of the transfer. The second span is the blur passes.
+        UINT64* ppBlurTimes[] = { m_primaryBlurTimes, m_blurTimes };
         for (UINT i = 0; i < GraphicsAdaptersCount; i++)
         {
-            readRange.Begin = 2 * oldestFrameIndex * sizeof(UINT64);
-            readRange.End = readRange.Begin + 2 * sizeof(UINT64);
+            readRange.Begin = TimestampsPerFrame * oldestFrameIndex * sizeof(UINT64);
+            readRange.End = readRange.Begin + TimestampsPerFrame * sizeof(UINT64);
 
             void* pData = nullptr;
             ThrowIfFailed(m_timestampResultBuffers[i]->Map(0, &readRange, &pData));
 
             const UINT64* pTimestamps = reinterpret_cast<UINT64*>(static_cast<UINT8*>(pData) + readRange.Begin);
-            const UINT64 timeStampDelta = pTimestamps[1] - pTimestamps[0];
+            const UINT64 firstSpanDelta = pTimestamps[1] - pTimestamps[0];
+            const UINT64 blurDelta = pTimestamps[2] - pTimestamps[1];
 
             // Unmap with an empty range (written range).
             m_timestampResultBuffers[i]->Unmap(0, &emptyRange);
 
-            // Calculate the GPU execution time in microseconds.
-            const UINT64 gpuTimeUS =  (timeStampDelta * 1000000) / m_directCommandQueueTimestampFrequencies[i];
-            ppMovingAverage[i][m_currentTimesIndex] = gpuTimeUS;
+            // Calculate the GPU execution times in microseconds.
+            const UINT64 firstSpanTimeUS = (firstSpanDelta * 1000000) / m_directCommandQueueTimestampFrequencies[i];
+            if (i == Primary)
+            {
+                m_drawTimes[m_currentTimesIndex] = firstSpanTimeUS;
+            }
+            else
+            {
+                m_transferTimes[i][m_currentTimesIndex] += firstSpanTimeUS;
+            }
+
+            ppBlurTimes[i][m_currentTimesIndex] = (blurDelta * 1000000) / m_directCommandQueueTimestampFrequencies[i];
         }
 
         // Move to the next index.
@@ -856,28 +1003,40 @@ void D3D12HeterogeneousMultiadapter::OnUpdate()
         framesSinceLastUpdate++;
         if (framesSinceLastUpdate > MovingAverageFrameCount)
         {
-            // Calculate the average draw and blur times for last few frames.
+            // Calculate the average draw, blur, and transfer times for last few frames.
             m_drawTimeMovingAverage = 0;
             m_blurTimeMovingAverage = 0;
+            m_primaryBlurTimeMovingAverage = 0;
+            m_transferTimeMovingAverages[Primary] = 0;
+            m_transferTimeMovingAverages[Secondary] = 0;
             for (UINT i = 0; i < MovingAverageFrameCount; i++)
             {
                 m_drawTimeMovingAverage += m_drawTimes[i];
                 m_blurTimeMovingAverage += m_blurTimes[i];
+                m_primaryBlurTimeMovingAverage += m_primaryBlurTimes[i];
+                m_transferTimeMovingAverages[Primary] += m_transferTimes[Primary][i];
+                m_transferTimeMovingAverages[Secondary] += m_transferTimes[Secondary][i];
             }
 
             m_drawTimeMovingAverage /= MovingAverageFrameCount;
             m_blurTimeMovingAverage /= MovingAverageFrameCount;
+            m_primaryBlurTimeMovingAverage /= MovingAverageFrameCount;
+            m_transferTimeMovingAverages[Primary] /= MovingAverageFrameCount;
+            m_transferTimeMovingAverages[Secondary] /= MovingAverageFrameCount;
             framesSinceLastUpdate = 0;
 
             // Adjust the shader blur time to be at least 20ms/frame.
             // Note: This is just done to show that we can reach ~100% utilization of both adapters.
             if (AllowShaderDynamicWorkload)
             {
+                // Measure the blur as if every pass ran on the secondary adapter so that the
+                // target does not move when passes are moved to the primary adapter.
+                const UINT64 blurTimeUS = (m_blurTimeMovingAverage / (BlurPassCount - m_primaryBlurPassCount)) * BlurPassCount;
                 const UINT64 desiredBlurPSTimeUS = 20000;    // 20 ms
-                if (m_blurTimeMovingAverage < desiredBlurPSTimeUS || m_blurPSLoopCount != 0)
+                if (blurTimeUS < desiredBlurPSTimeUS || m_blurPSLoopCount != 0)
                 {
                     // Adjust the PS blur time based on the moving average.
-                    const float timeDelta = (static_cast<float>(desiredBlurPSTimeUS) - static_cast<float>(m_blurTimeMovingAverage)) / static_cast<float>(m_blurTimeMovingAverage);
+                    const float timeDelta = (static_cast<float>(desiredBlurPSTimeUS) - static_cast<float>(blurTimeUS)) / static_cast<float>(blurTimeUS);
                     if (timeDelta < -.05f || timeDelta > .01f)
                     {
                         const float stepSize = max(1.0f, m_blurPSLoopCount);
@@ -886,8 +1045,15 @@ void D3D12HeterogeneousMultiadapter::OnUpdate()
                 }
             }
 
-            // Adjust the render time to be greater than the blur time.
+            // Move blur passes to whichever adapter has headroom. The scene workload is left
+            // alone in that case; matching it to the blur time would leave nothing to balance.
+            if (AllowAdaptiveBlurSplit)
+            {
+                UpdateBlurSplit();
+            }
+            else
             {
+                // Adjust the render time to be greater than the blur time.
                 const UINT64 desiredDrawPSTimeUS = m_blurTimeMovingAverage + static_cast<UINT64>(m_blurTimeMovingAverage * .10f);
                 const float timeDelta = (static_cast<float>(desiredDrawPSTimeUS) - static_cast<float>(m_drawTimeMovingAverage)) / static_cast<float>(m_drawTimeMovingAverage);
                 if (timeDelta < -.10f || timeDelta > .01f)
@@ -922,10 +1088,14 @@ void D3D12HeterogeneousMultiadapter::OnUpdate()
         pWorkloadSrc->loopCount = m_psLoopCount;
         memcpy(pWorkloadDst, pWorkloadSrc, sizeof(WorkloadConstantBufferData));
 
-        WorkloadConstantBufferData* pBlurWorkloadDst = m_pBlurWorkloadCbvDataBegin + m_frameIndex;
+        // Blur passes cost the same amount of (simulated) work on either adapter.
         WorkloadConstantBufferData* pBlurWorkloadSrc = &m_blurWorkloadConstantBufferData;
         pBlurWorkloadSrc->loopCount = m_blurPSLoopCount;
-        memcpy(pBlurWorkloadDst, pBlurWorkloadSrc, sizeof(WorkloadConstantBufferData));
+        for (UINT i = 0; i < GraphicsAdaptersCount; i++)
+        {
+            WorkloadConstantBufferData* pBlurWorkloadDst = m_pBlurWorkloadCbvDataBegin[i] + m_frameIndex;
+            memcpy(pBlurWorkloadDst, pBlurWorkloadSrc, sizeof(WorkloadConstantBufferData));
+        }
     }
 
     // Update the triangles.
@@ -966,28 +1136,51 @@ void D3D12HeterogeneousMultiadapter::OnRender()
 
         {
             // GPU Wait for the primary adapter to finish rendering.
-            ThrowIfFailed(m_copyCommandQueue->Wait(m_renderFence.Get(), m_currentRenderFenceValue));
+            ThrowIfFailed(m_copyCommandQueues[Primary]->Wait(m_renderFence.Get(), m_currentRenderFenceValue));
             m_currentRenderFenceValue++;
 
-            ID3D12CommandList* ppCopyCommandLists[] = { m_copyCommandList.Get() };
-            m_copyCommandQueue->ExecuteCommandLists(_countof(ppCopyCommandLists), ppCopyCommandLists);
+            ID3D12CommandList* ppCopyCommandLists[] = { m_copyCommandLists[Primary].Get() };
+            m_copyCommandQueues[Primary]->ExecuteCommandLists(_countof(ppCopyCommandLists), ppCopyCommandLists);
 
             // Signal the secondary adapter to indicate the copy is complete.
-            ThrowIfFailed(m_copyCommandQueue->Signal(m_crossAdapterFences[Primary].Get(), m_currentCrossAdapterFenceValue));
+            ThrowIfFailed(m_copyCommandQueues[Primary]->Signal(m_crossAdapterFences[Primary].Get(), m_currentCrossAdapterFenceValue));
         }
 
+        if (!m_crossAdapterTextureSupport)
         {
             // GPU Wait for the primary adapter to finish copying.
-            ThrowIfFailed(m_directCommandQueues[Secondary]->Wait(m_crossAdapterFences[Secondary].Get(), m_currentCrossAdapterFenceValue));
+            ThrowIfFailed(m_copyCommandQueues[Secondary]->Wait(m_crossAdapterFences[Secondary].Get(), m_currentCrossAdapterFenceValue));
             m_currentCrossAdapterFenceValue++;
 
+            // Copy the shared buffer into a texture on the secondary adapter's copy queue,
+            // so that it can overlap with the blur of the previous frame.
+            ID3D12CommandList* ppCopyCommandLists[] = { m_copyCommandLists[Secondary].Get() };
+            m_copyCommandQueues[Secondary]->ExecuteCommandLists(_countof(ppCopyCommandLists), ppCopyCommandLists);
+
+            // Signal the secondary adapter's direct queue to indicate the texture is ready.
+            ThrowIfFailed(m_copyCommandQueues[Secondary]->Signal(m_copyFence.Get(), m_currentCopyFenceValue));
+        }
+
+        {
+            // GPU Wait for the shared resource, or the texture it was copied into, to be ready.
+            if (m_crossAdapterTextureSupport)
+            {
+                ThrowIfFailed(m_directCommandQueues[Secondary]->Wait(m_crossAdapterFences[Secondary].Get(), m_currentCrossAdapterFenceValue));
+                m_currentCrossAdapterFenceValue++;
+            }
+            else
+            {
+                ThrowIfFailed(m_directCommandQueues[Secondary]->Wait(m_copyFence.Get(), m_currentCopyFenceValue));
+                m_currentCopyFenceValue++;
+            }
+
             ID3D12CommandList* ppBlurCommandLists[] = { m_directCommandLists[Secondary].Get() };
             m_directCommandQueues[Secondary]->ExecuteCommandLists(_countof(ppBlurCommandLists), ppBlurCommandLists);
         }
     }
 
     // Present the frame.
-    ThrowIfFailed(m_swapChain->Present(1, 0));
+    ThrowIfFailed(m_swapChain->Present(GetSyncInterval(), 0));
 
     // Signal the frame is complete.
     ThrowIfFailed(m_directCommandQueues[Secondary]->Signal(m_frameFence.Get(), m_currentPresentFenceValue));
@@ -1026,7 +1219,7 @@ void D3D12HeterogeneousMultiadapter::PopulateCommandLists()
         ThrowIfFailed(m_directCommandLists[adapter]->Reset(m_directCommandAllocators[adapter][m_frameIndex].Get(), m_pipelineState.Get()));
 
         // Get a timestamp at the start of the command list.
-        const UINT timestampHeapIndex = 2 * m_frameIndex;
+        const UINT timestampHeapIndex = TimestampsPerFrame * m_frameIndex;
         m_directCommandLists[adapter]->EndQuery(m_timestampQueryHeaps[adapter].Get(), D3D12_QUERY_TYPE_TIMESTAMP, timestampHeapIndex);
 
         // Set necessary state.
@@ -1059,12 +1252,51 @@ void D3D12HeterogeneousMultiadapter::PopulateCommandLists()
             m_directCommandLists[adapter]->DrawInstanced(3, 1, 0, 0);
         }
 
-        // Indicate that the render target will now be used to copy.
-        m_directCommandLists[adapter]->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(m_renderTargets[adapter][m_frameIndex].Get(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_COMMON));
+        // Get a timestamp between the scene and the blur passes.
+        m_directCommandLists[adapter]->EndQuery(m_timestampQueryHeaps[adapter].Get(), D3D12_QUERY_TYPE_TIMESTAMP, timestampHeapIndex + 1);
+
+        if (m_primaryBlurPassCount > 0)
+        {
+            // Indicate that the render target will be used as a SRV and the blur
+            // render target will be used as a render target.
+            D3D12_RESOURCE_BARRIER barriers[] = {
+                CD3DX12_RESOURCE_BARRIER::Transition(m_renderTargets[adapter][m_frameIndex].Get(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE),
+                CD3DX12_RESOURCE_BARRIER::Transition(m_primaryBlurRenderTargets[m_frameIndex].Get(), D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_STATE_RENDER_TARGET)
+            };
+
+            m_directCommandLists[adapter]->ResourceBarrier(_countof(barriers), barriers);
+
+            // Set necessary state.
+            m_directCommandLists[adapter]->SetGraphicsRootSignature(m_blurRootSignatures[adapter].Get());
+
+            ID3D12DescriptorHeap* ppHeaps[] = { m_cbvSrvUavHeaps[adapter].Get() };
+            m_directCommandLists[adapter]->SetDescriptorHeaps(_countof(ppHeaps), ppHeaps);
+
+            m_directCommandLists[adapter]->IASetVertexBuffers(0, 1, &m_fullscreenQuadVertexBufferViews[adapter]);
+            m_directCommandLists[adapter]->SetGraphicsRootConstantBufferView(0, m_blurConstantBuffers[adapter]->GetGPUVirtualAddress());
+            m_directCommandLists[adapter]->SetGraphicsRootConstantBufferView(2, m_blurWorkloadConstantBuffers[adapter]->GetGPUVirtualAddress() + (m_frameIndex * sizeof(WorkloadConstantBufferData)));
+
+            // Draw the fullscreen quad - Blur pass #1.
+            CD3DX12_GPU_DESCRIPTOR_HANDLE srvHandle(m_cbvSrvUavHeaps[adapter]->GetGPUDescriptorHandleForHeapStart(), m_frameIndex, m_srvDescriptorSizes[adapter]);
+            CD3DX12_CPU_DESCRIPTOR_HANDLE blurRtvHandle(m_rtvHeaps[adapter]->GetCPUDescriptorHandleForHeapStart(), FrameCount + m_frameIndex, m_rtvDescriptorSizes[adapter]);
+            PopulateBlurPass(adapter, 0, srvHandle, blurRtvHandle);
+
+            // Indicate that the blur render target will now be used to copy.
+            barriers[0].Transition.StateBefore = D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE;
+            barriers[0].Transition.StateAfter = D3D12_RESOURCE_STATE_COMMON;
+            barriers[1].Transition.StateBefore = D3D12_RESOURCE_STATE_RENDER_TARGET;
+            barriers[1].Transition.StateAfter = D3D12_RESOURCE_STATE_COMMON;
+            m_directCommandLists[adapter]->ResourceBarrier(_countof(barriers), barriers);
+        }
+        else
+        {
+            // Indicate that the render target will now be used to copy.
+            m_directCommandLists[adapter]->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(m_renderTargets[adapter][m_frameIndex].Get(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_COMMON));
+        }
 
         // Get a timestamp at the end of the command list and resolve the query data.
-        m_directCommandLists[adapter]->EndQuery(m_timestampQueryHeaps[adapter].Get(), D3D12_QUERY_TYPE_TIMESTAMP, timestampHeapIndex + 1);
-        m_directCommandLists[adapter]->ResolveQueryData(m_timestampQueryHeaps[adapter].Get(), D3D12_QUERY_TYPE_TIMESTAMP, timestampHeapIndex, 2, m_timestampResultBuffers[adapter].Get(), timestampHeapIndex * sizeof(UINT64));
+        m_directCommandLists[adapter]->EndQuery(m_timestampQueryHeaps[adapter].Get(), D3D12_QUERY_TYPE_TIMESTAMP, timestampHeapIndex + 2);
+        m_directCommandLists[adapter]->ResolveQueryData(m_timestampQueryHeaps[adapter].Get(), D3D12_QUERY_TYPE_TIMESTAMP, timestampHeapIndex, TimestampsPerFrame, m_timestampResultBuffers[adapter].Get(), timestampHeapIndex * sizeof(UINT64));
 
         ThrowIfFailed(m_directCommandLists[adapter]->Close());
     }
@@ -1074,8 +1306,18 @@ void D3D12HeterogeneousMultiadapter::PopulateCommandLists()
         const GraphicsAdapter adapter = Primary;
 
         // Reset the copy command allocator and command list.
-        ThrowIfFailed(m_copyCommandAllocators[m_frameIndex]->Reset());
-        ThrowIfFailed(m_copyCommandList->Reset(m_copyCommandAllocators[m_frameIndex].Get(), nullptr));
+        ThrowIfFailed(m_copyCommandAllocators[adapter][m_frameIndex]->Reset());
+        ThrowIfFailed(m_copyCommandLists[adapter]->Reset(m_copyCommandAllocators[adapter][m_frameIndex].Get(), nullptr));
+
+        // Get a timestamp at the start of the command list.
+        const UINT timestampHeapIndex = 2 * m_frameIndex;
+        if (m_copyQueueTimestampSupport[adapter])
+        {
+            m_copyCommandLists[adapter]->EndQuery(m_copyTimestampQueryHeaps[adapter].Get(), D3D12_QUERY_TYPE_TIMESTAMP, timestampHeapIndex);
+        }
+
+        // Share the output of the last blur pass run on the primary adapter, if any.
+        ID3D12Resource* pSourceRenderTarget = (m_primaryBlurPassCount > 0) ? m_primaryBlurRenderTargets[m_frameIndex].Get() : m_renderTargets[adapter][m_frameIndex].Get();
 
         // Copy the intermediate render target to the cross-adapter shared resource.
         // Transition barriers are not required since there are fences guarding against
@@ -1084,7 +1326,7 @@ void D3D12HeterogeneousMultiadapter::PopulateCommandLists()
         {
             // If cross-adapter row-major textures are supported by the adapter,
             // simply copy the texture into the cross-adapter texture.
-            m_copyCommandList->CopyResource(m_crossAdapterResources[adapter][m_frameIndex].Get(), m_renderTargets[adapter][m_frameIndex].Get());
+            m_copyCommandLists[adapter]->CopyResource(m_crossAdapterResources[adapter][m_frameIndex].Get(), pSourceRenderTarget);
         }
         else
         {
@@ -1094,19 +1336,66 @@ void D3D12HeterogeneousMultiadapter::PopulateCommandLists()
 
             // Copy the intermediate render target into the shared buffer using the
             // memory layout prescribed by the render target.
-            D3D12_RESOURCE_DESC renderTargetDesc = m_renderTargets[adapter][m_frameIndex]->GetDesc();
+            D3D12_RESOURCE_DESC renderTargetDesc = pSourceRenderTarget->GetDesc();
             D3D12_PLACED_SUBRESOURCE_FOOTPRINT renderTargetLayout;
 
             m_devices[adapter]->GetCopyableFootprints(&renderTargetDesc, 0, 1, 0, &renderTargetLayout, nullptr, nullptr, nullptr);
 
             CD3DX12_TEXTURE_COPY_LOCATION dest(m_crossAdapterResources[adapter][m_frameIndex].Get(), renderTargetLayout);
-            CD3DX12_TEXTURE_COPY_LOCATION src(m_renderTargets[adapter][m_frameIndex].Get(), 0);
+            CD3DX12_TEXTURE_COPY_LOCATION src(pSourceRenderTarget, 0);
             CD3DX12_BOX box(0, 0, m_width, m_height);
 
-            m_copyCommandList->CopyTextureRegion(&dest, 0, 0, 0, &src, &box);
+            m_copyCommandLists[adapter]->CopyTextureRegion(&dest, 0, 0, 0, &src, &box);
+        }
+
+        // Get a timestamp at the end of the command list and resolve the query data.
+        if (m_copyQueueTimestampSupport[adapter])
+        {
+            m_copyCommandLists[adapter]->EndQuery(m_copyTimestampQueryHeaps[adapter].Get(), D3D12_QUERY_TYPE_TIMESTAMP, timestampHeapIndex + 1);
+            m_copyCommandLists[adapter]->ResolveQueryData(m_copyTimestampQueryHeaps[adapter].Get(), D3D12_QUERY_TYPE_TIMESTAMP, timestampHeapIndex, 2, m_copyTimestampResultBuffers[adapter].Get(), timestampHeapIndex * sizeof(UINT64));
+        }
+
+        ThrowIfFailed(m_copyCommandLists[adapter]->Close());
+    }
+
+    // Command list to copy the shared buffer into a texture on the secondary adapter.
+    if (!m_crossAdapterTextureSupport)
+    {
+        const GraphicsAdapter adapter = Secondary;
+
+        // Reset the copy command allocator and command list.
+        ThrowIfFailed(m_copyCommandAllocators[adapter][m_frameIndex]->Reset());
+        ThrowIfFailed(m_copyCommandLists[adapter]->Reset(m_copyCommandAllocators[adapter][m_frameIndex].Get(), nullptr));
+
+        // Get a timestamp at the start of the command list.
+        const UINT timestampHeapIndex = 2 * m_frameIndex;
+        if (m_copyQueueTimestampSupport[adapter])
+        {
+            m_copyCommandLists[adapter]->EndQuery(m_copyTimestampQueryHeaps[adapter].Get(), D3D12_QUERY_TYPE_TIMESTAMP, timestampHeapIndex);
+        }
+
+        // Copy the shared buffer contents into the texture using the memory
+        // layout prescribed by the texture. The texture is implicitly promoted
+        // from the common state to the copy destination state.
+        D3D12_RESOURCE_DESC secondaryAdapterTexture = m_secondaryAdapterTextures[m_frameIndex]->GetDesc();
+        D3D12_PLACED_SUBRESOURCE_FOOTPRINT textureLayout;
+
+        m_devices[adapter]->GetCopyableFootprints(&secondaryAdapterTexture, 0, 1, 0, &textureLayout, nullptr, nullptr, nullptr);
+
+        CD3DX12_TEXTURE_COPY_LOCATION dest(m_secondaryAdapterTextures[m_frameIndex].Get(), 0);
+        CD3DX12_TEXTURE_COPY_LOCATION src(m_crossAdapterResources[adapter][m_frameIndex].Get(), textureLayout);
+        CD3DX12_BOX box(0, 0, m_width, m_height);
+
+        m_copyCommandLists[adapter]->CopyTextureRegion(&dest, 0, 0, 0, &src, &box);
+
+        // Get a timestamp at the end of the command list and resolve the query data.
+        if (m_copyQueueTimestampSupport[adapter])
+        {
+            m_copyCommandLists[adapter]->EndQuery(m_copyTimestampQueryHeaps[adapter].Get(), D3D12_QUERY_TYPE_TIMESTAMP, timestampHeapIndex + 1);
+            m_copyCommandLists[adapter]->ResolveQueryData(m_copyTimestampQueryHeaps[adapter].Get(), D3D12_QUERY_TYPE_TIMESTAMP, timestampHeapIndex, 2, m_copyTimestampResultBuffers[adapter].Get(), timestampHeapIndex * sizeof(UINT64));
         }
 
-        ThrowIfFailed(m_copyCommandList->Close());
+        ThrowIfFailed(m_copyCommandLists[adapter]->Close());
     }
 
     // Command list to blur the render target and present.
@@ -1121,108 +1410,152 @@ void D3D12HeterogeneousMultiadapter::PopulateCommandLists()
         // However, when ExecuteCommandList() is called on a particular command 
         // list, that command list can then be reset at any time and must be before 
         // re-recording.
-        ThrowIfFailed(m_directCommandLists[adapter]->Reset(m_directCommandAllocators[adapter][m_frameIndex].Get(), m_blurPipelineStates[0].Get()));
+        ThrowIfFailed(m_directCommandLists[adapter]->Reset(m_directCommandAllocators[adapter][m_frameIndex].Get(), m_blurPipelineStates[adapter][m_primaryBlurPassCount].Get()));
+
+        // Get a timestamp at the start of the command list.
+        const UINT timestampHeapIndex = TimestampsPerFrame * m_frameIndex;
+        m_directCommandLists[adapter]->EndQuery(m_timestampQueryHeaps[adapter].Get(), D3D12_QUERY_TYPE_TIMESTAMP, timestampHeapIndex);
 
         if (!m_crossAdapterTextureSupport)
         {
-            // Copy the buffer in the shared heap into a texture that the secondary
-            // adapter can sample from.
-            D3D12_RESOURCE_BARRIER barrier = CD3DX12_RESOURCE_BARRIER::Transition(
-                m_secondaryAdapterTextures[m_frameIndex].Get(),
-                D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE,
-                D3D12_RESOURCE_STATE_COPY_DEST);
-            m_directCommandLists[adapter]->ResourceBarrier(1, &barrier);
-
-            // Copy the shared buffer contents into the texture using the memory
-            // layout prescribed by the texture.
-            D3D12_RESOURCE_DESC secondaryAdapterTexture = m_secondaryAdapterTextures[m_frameIndex]->GetDesc();
-            D3D12_PLACED_SUBRESOURCE_FOOTPRINT textureLayout;
-
-            m_devices[adapter]->GetCopyableFootprints(&secondaryAdapterTexture, 0, 1, 0, &textureLayout, nullptr, nullptr, nullptr);
-
-            CD3DX12_TEXTURE_COPY_LOCATION dest(m_secondaryAdapterTextures[m_frameIndex].Get(), 0);
-            CD3DX12_TEXTURE_COPY_LOCATION src(m_crossAdapterResources[adapter][m_frameIndex].Get(), textureLayout);
-            CD3DX12_BOX box(0, 0, m_width, m_height);
-
-            m_directCommandLists[adapter]->CopyTextureRegion(&dest, 0, 0, 0, &src, &box);
-
-            barrier.Transition.StateBefore = D3D12_RESOURCE_STATE_COPY_DEST;
-            barrier.Transition.StateAfter = D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE;
-            m_directCommandLists[adapter]->ResourceBarrier(1, &barrier);
+            // Indicate that the texture copied by the secondary adapter's copy queue will be used as a SRV.
+            m_directCommandLists[adapter]->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(m_secondaryAdapterTextures[m_frameIndex].Get(), D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE));
         }
 
-        // Get a timestamp at the start of the command list.
-        const UINT timestampHeapIndex = 2 * m_frameIndex;
-        m_directCommandLists[adapter]->EndQuery(m_timestampQueryHeaps[adapter].Get(), D3D12_QUERY_TYPE_TIMESTAMP, timestampHeapIndex);
+        // Get a timestamp between the received texture transition and the blur passes.
+        m_directCommandLists[adapter]->EndQuery(m_timestampQueryHeaps[adapter].Get(), D3D12_QUERY_TYPE_TIMESTAMP, timestampHeapIndex + 1);
 
         // Set necessary state.
-        m_directCommandLists[adapter]->SetGraphicsRootSignature(m_blurRootSignature.Get());
+        m_directCommandLists[adapter]->SetGraphicsRootSignature(m_blurRootSignatures[adapter].Get());
 
-        ID3D12DescriptorHeap* ppHeaps[] = { m_cbvSrvUavHeap.Get() };
+        ID3D12DescriptorHeap* ppHeaps[] = { m_cbvSrvUavHeaps[adapter].Get() };
         m_directCommandLists[adapter]->SetDescriptorHeaps(_countof(ppHeaps), ppHeaps);
 
         m_directCommandLists[adapter]->RSSetViewports(1, &m_viewport);
         m_directCommandLists[adapter]->RSSetScissorRects(1, &m_scissorRect);
 
-        // Indicate that the intermediate render target will be used as a render target.
-        m_directCommandLists[adapter]->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(m_intermediateBlurRenderTarget.Get(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_RENDER_TARGET));
-
         // Record commands.
         m_directCommandLists[adapter]->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP);
-        m_directCommandLists[adapter]->IASetVertexBuffers(0, 1, &m_fullscreenQuadVertexBufferView);
-        m_directCommandLists[adapter]->SetGraphicsRootConstantBufferView(0, m_blurConstantBuffer->GetGPUVirtualAddress());
-        m_directCommandLists[adapter]->SetGraphicsRootConstantBufferView(2, m_blurWorkloadConstantBuffer->GetGPUVirtualAddress() + (m_frameIndex * sizeof(WorkloadConstantBufferData)));
+        m_directCommandLists[adapter]->IASetVertexBuffers(0, 1, &m_fullscreenQuadVertexBufferViews[adapter]);
+        m_directCommandLists[adapter]->SetGraphicsRootConstantBufferView(0, m_blurConstantBuffers[adapter]->GetGPUVirtualAddress());
+        m_directCommandLists[adapter]->SetGraphicsRootConstantBufferView(2, m_blurWorkloadConstantBuffers[adapter]->GetGPUVirtualAddress() + (m_frameIndex * sizeof(WorkloadConstantBufferData)));
 
-        // Draw the fullscreen quad - Blur pass #1.
+        // The first blur pass on this adapter reads the shared resource.
+        CD3DX12_GPU_DESCRIPTOR_HANDLE srvHandle(m_cbvSrvUavHeaps[adapter]->GetGPUDescriptorHandleForHeapStart(), m_frameIndex, m_srvDescriptorSizes[adapter]);
+
+        // Draw the fullscreen quad - Blur pass #1, unless the primary adapter already ran it.
+        if (m_primaryBlurPassCount == 0)
         {
-            CD3DX12_GPU_DESCRIPTOR_HANDLE srvHandle(m_cbvSrvUavHeap->GetGPUDescriptorHandleForHeapStart(), m_frameIndex, m_srvDescriptorSizes[adapter]);
-            m_directCommandLists[adapter]->SetGraphicsRootDescriptorTable(1, srvHandle);
+            // Indicate that the intermediate render target will be used as a render target.
+            m_directCommandLists[adapter]->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(m_intermediateBlurRenderTarget.Get(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_RENDER_TARGET));
 
             CD3DX12_CPU_DESCRIPTOR_HANDLE rtvHandle(m_rtvHeaps[adapter]->GetCPUDescriptorHandleForHeapStart(), FrameCount, m_rtvDescriptorSizes[adapter]);
-            m_directCommandLists[adapter]->OMSetRenderTargets(1, &rtvHandle, false, nullptr);
+            PopulateBlurPass(adapter, 0, srvHandle, rtvHandle);
 
-            m_directCommandLists[adapter]->DrawInstanced(4, 1, 0, 0);
+            srvHandle.InitOffsetted(m_cbvSrvUavHeaps[adapter]->GetGPUDescriptorHandleForHeapStart(), FrameCount, m_srvDescriptorSizes[adapter]);
         }
 
         // Draw the fullscreen quad - Blur pass #2.
         {
-            m_directCommandLists[adapter]->SetPipelineState(m_blurPipelineStates[1].Get());
-
             // Indicate that the back buffer will be used as a render target and the
-            // intermediate render target will be used as a SRV.
+            // intermediate render target, if it was written, will be used as a SRV.
             D3D12_RESOURCE_BARRIER barriers[] = {
                 CD3DX12_RESOURCE_BARRIER::Transition(m_renderTargets[adapter][m_frameIndex].Get(), D3D12_RESOURCE_STATE_PRESENT, D3D12_RESOURCE_STATE_RENDER_TARGET),
                 CD3DX12_RESOURCE_BARRIER::Transition(m_intermediateBlurRenderTarget.Get(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE)
             };
 
-            m_directCommandLists[adapter]->ResourceBarrier(_countof(barriers), barriers);
-
-            CD3DX12_GPU_DESCRIPTOR_HANDLE srvHandle(m_cbvSrvUavHeap->GetGPUDescriptorHandleForHeapStart(), FrameCount, m_srvDescriptorSizes[adapter]);
-            m_directCommandLists[adapter]->SetGraphicsRootDescriptorTable(1, srvHandle);
+            m_directCommandLists[adapter]->ResourceBarrier((m_primaryBlurPassCount == 0) ? _countof(barriers) : 1, barriers);
 
             CD3DX12_CPU_DESCRIPTOR_HANDLE rtvHandle(m_rtvHeaps[adapter]->GetCPUDescriptorHandleForHeapStart(), m_frameIndex, m_rtvDescriptorSizes[adapter]);
-            m_directCommandLists[adapter]->OMSetRenderTargets(1, &rtvHandle, false, nullptr);
-
-            m_directCommandLists[adapter]->DrawInstanced(4, 1, 0, 0);
+            PopulateBlurPass(adapter, 1, srvHandle, rtvHandle);
         }
 
         // Indicate that the back buffer will now be used to present.
         m_directCommandLists[adapter]->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(m_renderTargets[adapter][m_frameIndex].Get(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PRESENT));
 
+        if (!m_crossAdapterTextureSupport)
+        {
+            // Return the texture to the common state for the next copy into it.
+            m_directCommandLists[adapter]->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(m_secondaryAdapterTextures[m_frameIndex].Get(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_COMMON));
+        }
+
         // Get a timestamp at the end of the command list and resolve the query data.
-        m_directCommandLists[adapter]->EndQuery(m_timestampQueryHeaps[adapter].Get(), D3D12_QUERY_TYPE_TIMESTAMP, timestampHeapIndex + 1);
-        m_directCommandLists[adapter]->ResolveQueryData(m_timestampQueryHeaps[adapter].Get(), D3D12_QUERY_TYPE_TIMESTAMP, timestampHeapIndex, 2, m_timestampResultBuffers[adapter].Get(), timestampHeapIndex * sizeof(UINT64));
+        m_directCommandLists[adapter]->EndQuery(m_timestampQueryHeaps[adapter].Get(), D3D12_QUERY_TYPE_TIMESTAMP, timestampHeapIndex + 2);
+        m_directCommandLists[adapter]->ResolveQueryData(m_timestampQueryHeaps[adapter].Get(), D3D12_QUERY_TYPE_TIMESTAMP, timestampHeapIndex, TimestampsPerFrame, m_timestampResultBuffers[adapter].Get(), timestampHeapIndex * sizeof(UINT64));
 
         ThrowIfFailed(m_directCommandLists[adapter]->Close());
     }
 }
 
+// Record a fullscreen blur pass on the given adapter. The root signature, descriptor
+// heap, and constant buffers must already be set on the adapter's direct command list.
+void D3D12HeterogeneousMultiadapter::PopulateBlurPass(GraphicsAdapter adapter, UINT pass, D3D12_GPU_DESCRIPTOR_HANDLE srvHandle, D3D12_CPU_DESCRIPTOR_HANDLE rtvHandle)
+{
+    m_directCommandLists[adapter]->SetPipelineState(m_blurPipelineStates[adapter][pass].Get());
+    m_directCommandLists[adapter]->SetGraphicsRootDescriptorTable(1, srvHandle);
+    m_directCommandLists[adapter]->OMSetRenderTargets(1, &rtvHandle, false, nullptr);
+    m_directCommandLists[adapter]->DrawInstanced(4, 1, 0, 0);
+}
+
+// Move a blur pass between the adapters when doing so is predicted to shorten the frame.
+// Each adapter's load is its direct queue time plus its side of the cross-adapter
+// transfer; adapters work on different frames concurrently, so the frame time is bound
+// by the busier of the two.
+void D3D12HeterogeneousMultiadapter::UpdateBlurSplit()
+{
+    // Give the moving averages a full window to settle on the current split.
+    if (m_blurSplitCooldown > 0)
+    {
+        m_blurSplitCooldown--;
+        return;
+    }
+
+    // Refresh the cost of a single blur pass on the adapters that currently run them.
+    m_blurPassTimes[Secondary] = m_blurTimeMovingAverage / (BlurPassCount - m_primaryBlurPassCount);
+    if (m_primaryBlurPassCount > 0)
+    {
+        m_blurPassTimes[Primary] = m_primaryBlurTimeMovingAverage / m_primaryBlurPassCount;
+    }
+
+    // Until a blur pass has run on the primary adapter, assume it costs the same as on the secondary.
+    const UINT64 primaryBlurPassTime = (m_blurPassTimes[Primary] > 0) ? m_blurPassTimes[Primary] : m_blurPassTimes[Secondary];
+    const UINT64 secondaryBlurPassTime = m_blurPassTimes[Secondary];
+
+    const UINT64 primaryLoad = m_drawTimeMovingAverage + m_primaryBlurTimeMovingAverage + m_transferTimeMovingAverages[Primary];
+    const UINT64 secondaryLoad = m_transferTimeMovingAverages[Secondary] + m_blurTimeMovingAverage;
+    const float threshold = static_cast<float>(max(primaryLoad, secondaryLoad)) * (1.0f - BlurSplitHysteresis);
+
+    if (secondaryLoad > primaryLoad && m_primaryBlurPassCount < MaxPrimaryBlurPassCount)
+    {
+        const UINT64 predictedLoad = max(primaryLoad + primaryBlurPassTime, secondaryLoad - secondaryBlurPassTime);
+        if (static_cast<float>(predictedLoad) < threshold)
+        {
+            m_primaryBlurPassCount++;
+            m_blurSplitCooldown = 1;
+        }
+    }
+    else if (primaryLoad > secondaryLoad && m_primaryBlurPassCount > 0)
+    {
+        const UINT64 predictedLoad = max(primaryLoad - primaryBlurPassTime, secondaryLoad + secondaryBlurPassTime);
+        if (static_cast<float>(predictedLoad) < threshold)
+        {
+            m_primaryBlurPassCount--;
+            m_blurSplitCooldown = 1;
+        }
+    }
+}
+
 void D3D12HeterogeneousMultiadapter::UpdateWindowTitle()
 {
     std::wstringstream stringStream;
 
     stringStream << L"[" << m_triangleCount << L" triangles]";
     stringStream << L" [Render, " << m_adapterDescs[Primary].Description << ": " << m_drawTimeMovingAverage << L"us" << L" (PS loop count : " << m_psLoopCount<< ")]";
+    if (m_primaryBlurPassCount > 0)
+    {
+        stringStream << L" [Blur, " << m_adapterDescs[Primary].Description << ": " << m_primaryBlurTimeMovingAverage << L"us" << L" (" << m_primaryBlurPassCount << L" of " << BlurPassCount << L" passes)]";
+    }
+    stringStream << L" [Transfer: " << m_transferTimeMovingAverages[Primary] + m_transferTimeMovingAverages[Secondary] << L"us]";
     stringStream << L" [Blur, " << m_adapterDescs[Secondary].Description << ": " << m_blurTimeMovingAverage << L"us" << L" (PS loop count : " << m_blurPSLoopCount << ")]";
 
     SetCustomWindowText(stringStream.str().c_str());
@@ -1247,11 +1580,19 @@ void D3D12HeterogeneousMultiadapter::MoveToNextFrame()
     // Get the current the frame index.
     m_frameIndex = m_swapChain->GetCurrentBackBufferIndex();
 
+    // The next frame needs the resources of the frame that last used this back buffer,
+    // and no more than FramesInFlight frames may be queued, including the next one.
+    UINT64 waitFenceValue = m_frameFenceValues[m_frameIndex];
+    if (m_currentPresentFenceValue > FramesInFlight)
+    {
+        waitFenceValue = max(waitFenceValue, m_currentPresentFenceValue - FramesInFlight);
+    }
+
     // If the next frame is not ready to be rendered yet, wait until it is ready.
     const UINT64 completedFenceValue = m_frameFence->GetCompletedValue();
-    if (completedFenceValue < m_frameFenceValues[m_frameIndex])
+    if (completedFenceValue < waitFenceValue)
     {
-        ThrowIfFailed(m_frameFence->SetEventOnCompletion(m_frameFenceValues[m_frameIndex], m_fenceEvents[Secondary]));
+        ThrowIfFailed(m_frameFence->SetEventOnCompletion(waitFenceValue, m_fenceEvents[Secondary]));
         WaitForSingleObject(m_fenceEvents[Secondary], INFINITE);
     }
 }
@@ -35,14 +35,20 @@ public:
 private:
     static const bool AllowDrawDynamicWorkload = false;        // Allow the sample to change the number of triangles drawn, in an attempt to balance the workload between adapters.
     static const bool AllowShaderDynamicWorkload = true;    // Allow the sample to change PS complexity (simulated), in an attempt to balance the workload between adapters.
+    static const bool AllowAdaptiveBlurSplit = true;        // Allow the sample to move blur passes between adapters, in an attempt to balance the workload between adapters.
 
     static const UINT FrameCount = 3;
+    static const UINT FramesInFlight = 3;                // The number of frames the CPU may queue ahead of the GPUs, in [1, FrameCount]. Each additional frame adds a frame of latency and lets the adapters and copy queues overlap work on one more frame.
     static const float ClearColor[4];
     static const UINT MovingAverageFrameCount = 20;
     static const UINT WindowTextUpdateFrequency = 20;    // Update the window title every x frames.
     static const UINT MaxTriangleCount = 15000;            // The max number of triangles per frame.
     static const float TriangleHalfWidth;                // The x and y offsets used by the triangle vertices.
     static const float TriangleDepth;                    // The z offset used by the triangle vertices.
+    static const UINT TimestampsPerFrame = 3;            // Start, split point, and end of each direct command list.
+    static const UINT BlurPassCount = 2;                // The blur is separable: a horizontal pass followed by a vertical pass.
+    static const UINT MaxPrimaryBlurPassCount = 1;        // The last blur pass writes the back buffer, so it always runs on the secondary adapter.
+    static const float BlurSplitHysteresis;                // The fraction by which moving a blur pass must lower the frame time before it is moved.
 
     UINT m_frameIndex;
     UINT m_triangleCount;
@@ -51,8 +57,10 @@ private:
     UINT m_currentTimesIndex;
     UINT64 m_drawTimes[MovingAverageFrameCount];
     UINT64 m_blurTimes[MovingAverageFrameCount];
+    UINT64 m_primaryBlurTimes[MovingAverageFrameCount];
     UINT64 m_drawTimeMovingAverage;
     UINT64 m_blurTimeMovingAverage;
+    UINT64 m_primaryBlurTimeMovingAverage;
 
     // Vertex definitions.
     struct Vertex
@@ -108,6 +116,13 @@ private:
         GraphicsAdaptersCount
     };
 
+    // Adaptive blur split.
+    UINT64 m_transferTimes[GraphicsAdaptersCount][MovingAverageFrameCount];    // Copy queue time on the primary adapter, shared buffer copy time on the secondary adapter.
+    UINT64 m_transferTimeMovingAverages[GraphicsAdaptersCount];
+    UINT64 m_blurPassTimes[GraphicsAdaptersCount];        // The last measured cost of one blur pass on each adapter (0 if not yet measured).
+    UINT m_primaryBlurPassCount;                        // The number of leading blur passes that run on the primary adapter.
+    UINT m_blurSplitCooldown;                            // The number of moving average updates to skip before the blur split may change again.
+
     // Pipeline objects.
     CD3DX12_VIEWPORT m_viewport;
     CD3DX12_RECT m_scissorRect;
@@ -117,61 +132,70 @@ private:
     ComPtr<IDXGISwapChain3> m_swapChain;
     ComPtr<ID3D12Device> m_devices[GraphicsAdaptersCount];
     ComPtr<ID3D12CommandAllocator> m_directCommandAllocators[GraphicsAdaptersCount][FrameCount];
-    ComPtr<ID3D12CommandAllocator> m_copyCommandAllocators[FrameCount];
+    ComPtr<ID3D12CommandAllocator> m_copyCommandAllocators[GraphicsAdaptersCount][FrameCount];
     ComPtr<ID3D12CommandQueue> m_directCommandQueues[GraphicsAdaptersCount];
-    ComPtr<ID3D12CommandQueue> m_copyCommandQueue;
+    ComPtr<ID3D12CommandQueue> m_copyCommandQueues[GraphicsAdaptersCount];
     ComPtr<ID3D12RootSignature> m_rootSignature;
-    ComPtr<ID3D12RootSignature> m_blurRootSignature;
+    ComPtr<ID3D12RootSignature> m_blurRootSignatures[GraphicsAdaptersCount];
     ComPtr<ID3D12PipelineState> m_pipelineState;
-    ComPtr<ID3D12PipelineState> m_blurPipelineStates[2];
+    ComPtr<ID3D12PipelineState> m_blurPipelineStates[GraphicsAdaptersCount][BlurPassCount];
     ComPtr<ID3D12DescriptorHeap> m_rtvHeaps[GraphicsAdaptersCount];
     ComPtr<ID3D12DescriptorHeap> m_dsvHeap;
-    ComPtr<ID3D12DescriptorHeap> m_cbvSrvUavHeap;
+    ComPtr<ID3D12DescriptorHeap> m_cbvSrvUavHeaps[GraphicsAdaptersCount];
     ComPtr<ID3D12GraphicsCommandList> m_directCommandLists[GraphicsAdaptersCount];
-    ComPtr<ID3D12GraphicsCommandList> m_copyCommandList;
+    ComPtr<ID3D12GraphicsCommandList> m_copyCommandLists[GraphicsAdaptersCount];
 
     // Synchronization objects.
     ComPtr<ID3D12Fence> m_frameFence;
     ComPtr<ID3D12Fence> m_renderFence;
+    ComPtr<ID3D12Fence> m_copyFence;
     ComPtr<ID3D12Fence> m_crossAdapterFences[GraphicsAdaptersCount];
     UINT64 m_currentPresentFenceValue;
     UINT64 m_currentRenderFenceValue;
+    UINT64 m_currentCopyFenceValue;
     UINT64 m_currentCrossAdapterFenceValue;
     UINT64 m_frameFenceValues[FrameCount];
     HANDLE m_fenceEvents[GraphicsAdaptersCount];
 
     // Asset objects.
     ComPtr<ID3D12Resource> m_vertexBuffer;
-    ComPtr<ID3D12Resource> m_fullscreenQuadVertexBuffer;
+    ComPtr<ID3D12Resource> m_fullscreenQuadVertexBuffers[GraphicsAdaptersCount];
     ComPtr<ID3D12Resource> m_constantBuffer;
     ComPtr<ID3D12Resource> m_workloadConstantBuffer;
-    ComPtr<ID3D12Resource> m_blurWorkloadConstantBuffer;
-    ComPtr<ID3D12Resource> m_blurConstantBuffer;
+    ComPtr<ID3D12Resource> m_blurWorkloadConstantBuffers[GraphicsAdaptersCount];
+    ComPtr<ID3D12Resource> m_blurConstantBuffers[GraphicsAdaptersCount];
     ComPtr<ID3D12Resource> m_depthStencil;
     D3D12_VERTEX_BUFFER_VIEW m_vertexBufferView;
-    D3D12_VERTEX_BUFFER_VIEW m_fullscreenQuadVertexBufferView;
+    D3D12_VERTEX_BUFFER_VIEW m_fullscreenQuadVertexBufferViews[GraphicsAdaptersCount];
     std::vector<SceneConstantBuffer> m_constantBufferData;
     SceneConstantBuffer* m_pCbvDataBegin;
     BlurConstantBufferData* m_pBlurCbvDataBegin;
     WorkloadConstantBufferData m_workloadConstantBufferData;
     WorkloadConstantBufferData* m_pWorkloadCbvDataBegin;
     WorkloadConstantBufferData m_blurWorkloadConstantBufferData;
-    WorkloadConstantBufferData* m_pBlurWorkloadCbvDataBegin;
+    WorkloadConstantBufferData* m_pBlurWorkloadCbvDataBegin[GraphicsAdaptersCount];
     ComPtr<ID3D12Heap> m_crossAdapterResourceHeaps[GraphicsAdaptersCount];
     ComPtr<ID3D12Resource> m_crossAdapterResources[GraphicsAdaptersCount][FrameCount];
     BOOL m_crossAdapterTextureSupport;
     ComPtr<ID3D12Resource> m_secondaryAdapterTextures[FrameCount];            // Only used if cross adapter texture support is unavailable.
     ComPtr<ID3D12Resource> m_renderTargets[GraphicsAdaptersCount][FrameCount];
     ComPtr<ID3D12Resource> m_intermediateBlurRenderTarget;
+    ComPtr<ID3D12Resource> m_primaryBlurRenderTargets[FrameCount];            // Only used when the primary adapter runs blur passes.
     ComPtr<ID3D12QueryHeap> m_timestampQueryHeaps[GraphicsAdaptersCount];
     ComPtr<ID3D12Resource> m_timestampResultBuffers[GraphicsAdaptersCount];
     UINT64 m_directCommandQueueTimestampFrequencies[GraphicsAdaptersCount];
+    BOOL m_copyQueueTimestampSupport[GraphicsAdaptersCount];
+    ComPtr<ID3D12QueryHeap> m_copyTimestampQueryHeaps[GraphicsAdaptersCount];        // Only used if copy queue timestamps are supported.
+    ComPtr<ID3D12Resource> m_copyTimestampResultBuffers[GraphicsAdaptersCount];
+    UINT64 m_copyCommandQueueTimestampFrequencies[GraphicsAdaptersCount];
 
     HRESULT GetHardwareAdapters(_In_ IDXGIFactory2* pFactory, _Outptr_result_maybenull_ IDXGIAdapter1** ppPrimaryAdapter, _Outptr_result_maybenull_ IDXGIAdapter1** ppSecondaryAdapter);
     void LoadPipeline();
     void LoadAssets();
     float GetRandomFloat(float min, float max);
     void PopulateCommandLists();
+    void PopulateBlurPass(GraphicsAdapter adapter, UINT pass, D3D12_GPU_DESCRIPTOR_HANDLE srvHandle, D3D12_CPU_DESCRIPTOR_HANDLE rtvHandle);
+    void UpdateBlurSplit();
     void UpdateWindowTitle();
     void WaitForGpu(GraphicsAdapter adapter);
     void MoveToNextFrame();
@@ -52,6 +52,20 @@ void CrossNodeResources::LoadPipeline()
         ppQueues[n] = m_queues[nodeIndex].Get();
     }
 
+    // Linked nodes also get a copy queue each for split-frame rendering.
+    if (Settings::NodeCount > 1)
+    {
+        D3D12_COMMAND_QUEUE_DESC copyQueueDesc = {};
+        copyQueueDesc.Flags = D3D12_COMMAND_QUEUE_FLAG_NONE;
+        copyQueueDesc.Type = D3D12_COMMAND_LIST_TYPE_COPY;
+
+        for (UINT nodeIndex = 0; nodeIndex < Settings::NodeCount; nodeIndex++)
+        {
+            copyQueueDesc.NodeMask = 1 << nodeIndex;
+            ThrowIfFailed(m_device->CreateCommandQueue(&copyQueueDesc, IID_PPV_ARGS(&m_copyQueues[nodeIndex])));
+        }
+    }
+
     // Describe and create the swap chain.
     DXGI_SWAP_CHAIN_DESC1 swapChainDesc = {};
     swapChainDesc.BufferCount = Settings::BackBufferCount;
@@ -114,12 +128,12 @@ void CrossNodeResources::LoadAssets()
         }
 
         // Create a root signature for rendering the triangle scene.
+        // The constant buffer is bound as a root CBV. Descriptor heaps can only be visible
+        // to a single node, so a descriptor table would need its own copy of every CBV on
+        // every node.
         {
-            CD3DX12_DESCRIPTOR_RANGE1 sceneRanges[1];
-            sceneRanges[0].Init(D3D12_DESCRIPTOR_RANGE_TYPE_CBV, 1, 0, 0, D3D12_DESCRIPTOR_RANGE_FLAG_DATA_STATIC);
-
             CD3DX12_ROOT_PARAMETER1 sceneRootParameters[2];
-            sceneRootParameters[0].InitAsDescriptorTable(1, &sceneRanges[0], D3D12_SHADER_VISIBILITY_VERTEX);
+            sceneRootParameters[0].InitAsConstantBufferView(0, 0, D3D12_ROOT_DESCRIPTOR_FLAG_DATA_STATIC, D3D12_SHADER_VISIBILITY_VERTEX);
             sceneRootParameters[1].InitAsConstants(1, 1, 0, D3D12_SHADER_VISIBILITY_VERTEX);
 
             CD3DX12_VERSIONED_ROOT_SIGNATURE_DESC sceneRootSignatureDesc;
@@ -136,17 +150,20 @@ void CrossNodeResources::LoadAssets()
             // We don't modify the SRV in the post-processing command list after
             // SetGraphicsRootDescriptorTable is executed on the GPU so we can use the default
             // range behavior: D3D12_DESCRIPTOR_RANGE_FLAG_DATA_STATIC_WHILE_SET_AT_EXECUTE
-            CD3DX12_DESCRIPTOR_RANGE1 postRanges[2];
+            CD3DX12_DESCRIPTOR_RANGE1 postRanges[1];
             postRanges[0].Init(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, Settings::SceneHistoryCount, 0);
-            postRanges[1].Init(D3D12_DESCRIPTOR_RANGE_TYPE_SAMPLER, 1, 0);
 
-            CD3DX12_ROOT_PARAMETER1 postRootParameters[3];
+            CD3DX12_ROOT_PARAMETER1 postRootParameters[2];
             postRootParameters[0].InitAsDescriptorTable(1, &postRanges[0], D3D12_SHADER_VISIBILITY_PIXEL);
-            postRootParameters[1].InitAsDescriptorTable(1, &postRanges[1], D3D12_SHADER_VISIBILITY_PIXEL);
-            postRootParameters[2].InitAsConstants(2, 0, 0, D3D12_SHADER_VISIBILITY_PIXEL);
+            postRootParameters[1].InitAsConstants(2, 0, 0, D3D12_SHADER_VISIBILITY_PIXEL);
+
+            // A static sampler is part of the root signature, so it is shared by every node
+            // instead of needing a sampler heap on each of them.
+            CD3DX12_STATIC_SAMPLER_DESC sampler(0, D3D12_FILTER_MIN_MAG_MIP_LINEAR);
+            sampler.ShaderVisibility = D3D12_SHADER_VISIBILITY_PIXEL;
 
             CD3DX12_VERSIONED_ROOT_SIGNATURE_DESC postRootSignatureDesc;
-            postRootSignatureDesc.Init_1_1(_countof(postRootParameters), postRootParameters, 0, nullptr, D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT);
+            postRootSignatureDesc.Init_1_1(_countof(postRootParameters), postRootParameters, 1, &sampler, D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT);
 
             ComPtr<ID3DBlob> signature;
             ComPtr<ID3DBlob> error;
@@ -231,6 +248,57 @@ void CrossNodeResources::LoadAssets()
         ThrowIfFailed(m_sceneConstantBuffer->Map(0, nullptr, reinterpret_cast<void**>(&m_mappedConstantBuffer)));
         ZeroMemory(m_mappedConstantBuffer, constantBufferDataSize);
     }
+
+    // Create the vertex buffers.
+    // Both are a few bytes and never change, so rather than uploading a copy into every
+    // node's local memory, one upload heap buffer is made visible to all nodes.
+    {
+        // Define the geometry for a triangle.
+        const SceneVertex triangleVertices[] =
+        {
+            { { 0.0f, Settings::TriangleHalfWidth, Settings::TriangleDepth } },
+            { { Settings::TriangleHalfWidth, -Settings::TriangleHalfWidth, Settings::TriangleDepth } },
+            { { -Settings::TriangleHalfWidth, -Settings::TriangleHalfWidth, Settings::TriangleDepth } }
+        };
+
+        // Define the geometry for a quad.
+        const PostVertex quadVertices[] =
+        {
+            { { -1.0f, -1.0f, 0.0f },{ 0.0f, 1.0f } },    // Bottom Left
+            { { -1.0f, 1.0f, 0.0f },{ 0.0f, 0.0f } },    // Top Left
+            { { 1.0f, -1.0f, 0.0f },{ 1.0f, 1.0f } },    // Bottom Right
+            { { 1.0f, 1.0f, 0.0f },{ 1.0f, 0.0f } },    // Top Right
+        };
+
+        const UINT vertexBufferSize = sizeof(triangleVertices) + sizeof(quadVertices);
+
+        D3D12_HEAP_PROPERTIES uploadHeapProps = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD);
+        uploadHeapProps.VisibleNodeMask = Settings::SharedNodeMask;
+
+        ThrowIfFailed(m_device->CreateCommittedResource(
+            &uploadHeapProps,
+            D3D12_HEAP_FLAG_NONE,
+            &CD3DX12_RESOURCE_DESC::Buffer(vertexBufferSize),
+            D3D12_RESOURCE_STATE_GENERIC_READ,
+            nullptr,
+            IID_PPV_ARGS(&m_vertexBuffer)));
+
+        UINT8* pVertexData;
+        const CD3DX12_RANGE readRange(0, 0);        // We do not intend to read from this resource on the CPU.
+        ThrowIfFailed(m_vertexBuffer->Map(0, &readRange, reinterpret_cast<void**>(&pVertexData)));
+        memcpy(pVertexData, triangleVertices, sizeof(triangleVertices));
+        memcpy(pVertexData + sizeof(triangleVertices), quadVertices, sizeof(quadVertices));
+        m_vertexBuffer->Unmap(0, nullptr);
+
+        // Initialize the vertex buffer views.
+        m_sceneVertexBufferView.BufferLocation = m_vertexBuffer->GetGPUVirtualAddress();
+        m_sceneVertexBufferView.StrideInBytes = sizeof(SceneVertex);
+        m_sceneVertexBufferView.SizeInBytes = sizeof(triangleVertices);
+
+        m_postVertexBufferView.BufferLocation = m_sceneVertexBufferView.BufferLocation + sizeof(triangleVertices);
+        m_postVertexBufferView.StrideInBytes = sizeof(PostVertex);
+        m_postVertexBufferView.SizeInBytes = sizeof(quadVertices);
+    }
 }
 
 void CrossNodeResources::UpdateConstantBuffer(UINT8* data, UINT dataSize, UINT64 frameId)
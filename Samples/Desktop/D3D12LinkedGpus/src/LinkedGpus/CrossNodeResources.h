@@ -28,6 +28,18 @@ struct SceneConstantBuffer
     float padding[36];
 };
 
+// Vertex definitions.
+struct SceneVertex
+{
+    DirectX::XMFLOAT3 position;
+};
+
+struct PostVertex
+{
+    DirectX::XMFLOAT3 position;
+    DirectX::XMFLOAT2 uv;
+};
+
 // Container for resources that are shareable across GPU nodes.
 class CrossNodeResources
 {
@@ -42,15 +54,24 @@ public:
 
     inline ID3D12Device* GetDevice()                             { return m_device.Get(); }
     inline ID3D12CommandQueue* GetCommandQueue(UINT nodeIndex)   { return m_queues[nodeIndex].Get(); }
+    inline ID3D12CommandQueue* GetCopyQueue(UINT nodeIndex)      { return m_copyQueues[nodeIndex].Get(); }
     inline IDXGISwapChain3* GetSwapChain()                       { return m_swapChain.Get(); }
     inline ID3D12RootSignature* GetSceneRootSignature()          { return m_sceneRootSignature.Get(); }
     inline ID3D12PipelineState* GetScenePipelineState()          { return m_scenePipelineState.Get(); }
     inline ID3D12RootSignature* GetPostRootSignature()           { return m_postRootSignature.Get(); }
     inline ID3D12PipelineState* GetPostPipelineState()           { return m_postPipelineState.Get(); }
 
-    inline D3D12_GPU_VIRTUAL_ADDRESS GetSceneConstantBufferGpuVirtualAddress()
+    inline const D3D12_VERTEX_BUFFER_VIEW& GetSceneVertexBufferView() const { return m_sceneVertexBufferView; }
+    inline const D3D12_VERTEX_BUFFER_VIEW& GetPostVertexBufferView() const  { return m_postVertexBufferView; }
+
+    // The constant buffer is a ring of Settings::SceneConstantBufferFrames slots, one per
+    // frame, each holding a SceneConstantBuffer per triangle. Consecutive frames go to
+    // different nodes in alternate-frame rendering, so a node only ever reads the slots
+    // of its own frames and never waits on another node's updates.
+    inline D3D12_GPU_VIRTUAL_ADDRESS GetSceneConstantBufferGpuVirtualAddress(UINT64 frameId)
     {
-        return m_sceneConstantBuffer->GetGPUVirtualAddress();
+        const UINT64 slot = frameId % Settings::SceneConstantBufferFrames;
+        return m_sceneConstantBuffer->GetGPUVirtualAddress() + slot * Settings::TriangleCount * sizeof(SceneConstantBuffer);
     }
 
 private:
@@ -68,7 +89,16 @@ private:
     ComPtr<ID3D12Resource> m_sceneConstantBuffer;
     UINT8* m_mappedConstantBuffer;
 
+    // The static vertex data for both passes lives in a single upload heap buffer.
+    ComPtr<ID3D12Resource> m_vertexBuffer;
+    D3D12_VERTEX_BUFFER_VIEW m_sceneVertexBufferView;
+    D3D12_VERTEX_BUFFER_VIEW m_postVertexBufferView;
+
     // The command queues are actually tied to specific GPU nodes, but are placed here
     // for convenience since all queues are needed for swap chain creation and resizing.
     ComPtr<ID3D12CommandQueue> m_queues[Settings::MaxNodeCount];
+
+    // Split-frame rendering sends each node's part of the frame to the presenting node
+    // on a copy queue, so that the transfer can overlap that node's rendering.
+    ComPtr<ID3D12CommandQueue> m_copyQueues[Settings::MaxNodeCount];
 };
@@ -21,7 +21,10 @@ D3D12LinkedGpus::D3D12LinkedGpus(UINT width, UINT height, std::wstring name) :
     m_simulatedGpuLoad(0x1000),
     m_syncInterval(0),
     m_windowVisible(true),
-    m_windowedMode(true)
+    m_windowedMode(true),
+    m_splitFrame(false),
+    m_splitRows{},
+    m_rowRates{}
 {
     m_sceneData.resize(Settings::TriangleCount);
 }
@@ -89,6 +92,7 @@ void D3D12LinkedGpus::OnInit()
     }
 
     LoadSceneData();
+    ResetSplit();
     UpdateWindowTitle();
 }
 
@@ -114,7 +118,7 @@ float D3D12LinkedGpus::GetRandomFloat(float min, float max)
 
 void D3D12LinkedGpus::UpdateWindowTitle()
 {
-    WCHAR nodeText[100];
+    WCHAR nodeText[128];
     if (Settings::NodeCount == 1)
     {
         swprintf_s(nodeText, L"Node Count = 1 | SyncInterval = %u | SimulatedLoad = %u", m_syncInterval, m_simulatedGpuLoad);
@@ -123,9 +127,10 @@ void D3D12LinkedGpus::UpdateWindowTitle()
     {
         swprintf_s(
             nodeText,
-            L"Node Count = %u | Cross Node Sharing Tier = %d | SyncInterval = %u | SimulatedLoad = %u",
+            L"Node Count = %u | Cross Node Sharing Tier = %d | Mode = %s | SyncInterval = %u | SimulatedLoad = %u",
             Settings::NodeCount,
             Settings::Tier2Support ? 2 : 1,
+            m_splitFrame ? L"SFR" : L"AFR",
             m_syncInterval,
             m_simulatedGpuLoad);
     }
@@ -159,8 +164,29 @@ void D3D12LinkedGpus::OnRender()
         auto currentNode = m_nodes[m_nodeIndex];
 
         // Render and present the current frame.
-        currentNode->RenderScene(m_frameId, m_simulatedGpuLoad);
-        currentNode->RenderPost(m_frameId);
+        if (m_splitFrame)
+        {
+            // Every node renders its band, and the node that owns the current back
+            // buffer gathers the other bands into it.
+            UpdateSplit();
+
+            for (UINT n = 0; n < Settings::NodeCount; n++)
+            {
+                m_nodes[n]->RenderScene(m_frameId, m_simulatedGpuLoad, &m_bands[n]);
+            }
+            for (UINT n = 0; n < Settings::NodeCount; n++)
+            {
+                m_nodes[n]->RenderPost(m_frameId, &m_bands[n], m_nodeIndex);
+            }
+
+            currentNode->CompositeSplitFrame(m_bands, Settings::NodeCount);
+        }
+        else
+        {
+            currentNode->RenderScene(m_frameId, m_simulatedGpuLoad);
+            currentNode->RenderPost(m_frameId);
+        }
+
         currentNode->Present(m_syncInterval, m_windowedMode);
 
         MoveToNextFrame();
@@ -190,19 +216,8 @@ void D3D12LinkedGpus::OnSizeChanged(UINT width, UINT height, bool minimized)
         ThrowIfFailed(m_crossNodeResources->GetSwapChain()->GetFullscreenState(&fullscreenState, nullptr));
         m_windowedMode = !fullscreenState;
 
-        // Re-create and re-link render targets.
-        for (UINT n = 0; n < Settings::NodeCount; n++)
-        {
-            m_nodes[n]->LoadSizeDependentResources();
-        }
-        for (UINT n = 0; n < Settings::NodeCount; n++)
-        {
-            m_nodes[n]->LinkSharedResources(m_nodes, Settings::NodeCount);
-        }
-
-        // Reset the node index and align the frameId so that assumptions in post-processing hold.
-        m_nodeIndex = m_crossNodeResources->GetSwapChain()->GetCurrentBackBufferIndex() % Settings::NodeCount;
-        m_frameId += (Settings::SceneHistoryCount - (m_frameId % Settings::SceneHistoryCount));
+        ReloadSizeDependentResources();
+        ResetSplit();
 
         // Update the m_width, m_height, and m_aspectRatio member variables.
         UpdateForSizeChange(width, height);
@@ -280,6 +295,10 @@ void D3D12LinkedGpus::OnKeyDown(UINT8 key)
         }
         UpdateWindowTitle();
         break;
+
+    case 'S':
+        ToggleSplitFrame();
+        break;
     }
 }
 
@@ -315,8 +334,19 @@ void D3D12LinkedGpus::MoveToNextFrame()
     }
     else
     {
-        // Advance the frame on the current node.
-        m_nodes[m_nodeIndex]->MoveToNextFrame();
+        // Advance the frame on the current node, or on every node when they all
+        // took part in it.
+        if (m_splitFrame)
+        {
+            for (UINT n = 0; n < Settings::NodeCount; n++)
+            {
+                m_nodes[n]->MoveToNextFrame();
+            }
+        }
+        else
+        {
+            m_nodes[m_nodeIndex]->MoveToNextFrame();
+        }
 
         // Advance to the next node.
         m_nodeIndex = nextNode;
@@ -324,3 +354,121 @@ void D3D12LinkedGpus::MoveToNextFrame()
         m_frameId++;
     }
 }
+
+// Re-create and re-link the nodes' render targets. The GPUs must be idle.
+void D3D12LinkedGpus::ReloadSizeDependentResources()
+{
+    for (UINT n = 0; n < Settings::NodeCount; n++)
+    {
+        m_nodes[n]->SetSplitFrame(m_splitFrame);
+        m_nodes[n]->LoadSizeDependentResources();
+    }
+    for (UINT n = 0; n < Settings::NodeCount; n++)
+    {
+        m_nodes[n]->LinkSharedResources(m_nodes, Settings::NodeCount);
+    }
+
+    // Reset the node index and align the frameId so that assumptions in post-processing hold.
+    m_nodeIndex = m_crossNodeResources->GetSwapChain()->GetCurrentBackBufferIndex() % Settings::NodeCount;
+    m_frameId += (Settings::SceneHistoryCount - (m_frameId % Settings::SceneHistoryCount));
+}
+
+// Switch between alternate-frame and split-frame rendering. The scene render
+// targets start out in different states in each mode, so they are re-created.
+void D3D12LinkedGpus::ToggleSplitFrame()
+{
+    if (Settings::NodeCount < 2)
+    {
+        return;
+    }
+
+    WaitForGpus();
+
+    m_splitFrame = !m_splitFrame;
+    ReloadSizeDependentResources();
+    ResetSplit();
+
+    UpdateWindowTitle();
+}
+
+// Start with every node owning an equal share of the rows.
+void D3D12LinkedGpus::ResetSplit()
+{
+    for (UINT n = 0; n <= Settings::NodeCount; n++)
+    {
+        m_splitRows[n] = Settings::Height * n / Settings::NodeCount;
+    }
+    for (UINT n = 0; n < Settings::NodeCount; n++)
+    {
+        m_rowRates[n] = 1.0f;
+        m_bands[n].renderTop = 0;
+        m_bands[n].renderBottom = 0;
+    }
+}
+
+// Rebalance the split lines from the nodes' GPU timings and work out which
+// triangles each node has to draw this frame.
+void D3D12LinkedGpus::UpdateSplit()
+{
+    // The timings are a frame or two old and noisy, so each node's speed in rows
+    // per millisecond is smoothed.
+    float totalRate = 0.0f;
+    for (UINT n = 0; n < Settings::NodeCount; n++)
+    {
+        const float frameTime = m_nodes[n]->GetFrameTime();
+        const UINT rows = m_bands[n].renderBottom - m_bands[n].renderTop;
+        if (frameTime > 0.0f && rows > 0)
+        {
+            m_rowRates[n] += 0.25f * (rows / frameTime - m_rowRates[n]);
+        }
+        totalRate += m_rowRates[n];
+    }
+
+    // Move each split line toward the row where the nodes would finish together,
+    // a few rows at a time so that every node's history covers the rows it owns.
+    const INT maxStep = static_cast<INT>(Settings::SplitFrameMaxStep);
+    float rate = 0.0f;
+    for (UINT n = 1; n < Settings::NodeCount; n++)
+    {
+        rate += m_rowRates[n - 1];
+
+        const INT current = static_cast<INT>(m_splitRows[n]);
+        const INT target = static_cast<INT>(Settings::Height * rate / totalRate + 0.5f);
+        INT split = current + max(-maxStep, min(target - current, maxStep));
+        split = max(split, static_cast<INT>(m_splitRows[n - 1]) + 1);
+        split = min(split, static_cast<INT>(Settings::Height - (Settings::NodeCount - n)));
+
+        m_splitRows[n] = static_cast<UINT>(split);
+    }
+    m_splitRows[0] = 0;
+    m_splitRows[Settings::NodeCount] = Settings::Height;
+
+    for (UINT n = 0; n < Settings::NodeCount; n++)
+    {
+        SplitFrameBand& band = m_bands[n];
+        band.top = m_splitRows[n];
+        band.bottom = m_splitRows[n + 1];
+        band.renderTop = (band.top > Settings::SplitFrameMargin) ? band.top - Settings::SplitFrameMargin : 0;
+        band.renderBottom = min(band.bottom + Settings::SplitFrameMargin, Settings::Height);
+        band.triangles.clear();
+    }
+
+    // Find the rows each triangle covers from its offset and the projection.
+    const float yScale = XMVectorGetY(m_sceneData[0].projection.r[1]);
+    const float halfHeight = 0.5f * Settings::Height;
+    for (UINT t = 0; t < Settings::TriangleCount; t++)
+    {
+        const XMFLOAT4& offset = m_sceneData[t].offset;
+        const float depth = offset.z + Settings::TriangleDepth;
+        const float top = (1.0f - (offset.y + Settings::TriangleHalfWidth) * yScale / depth) * halfHeight;
+        const float bottom = (1.0f - (offset.y - Settings::TriangleHalfWidth) * yScale / depth) * halfHeight;
+
+        for (UINT n = 0; n < Settings::NodeCount; n++)
+        {
+            if (bottom >= m_bands[n].renderTop && top <= m_bands[n].renderBottom)
+            {
+                m_bands[n].triangles.push_back(t);
+            }
+        }
+    }
+}
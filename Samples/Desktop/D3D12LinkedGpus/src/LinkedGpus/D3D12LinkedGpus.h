@@ -29,6 +29,10 @@ using Microsoft::WRL::ComPtr;
 // When this sample runs on a system with linked GPUs, each node will take turns
 // rendering the scene pass and share that frame's resulting render target with the
 // other linked nodes.
+//
+// Linked GPUs can also use split-frame rendering (SFR), which avoids the extra frame of
+// latency that AFR adds. Every node renders a horizontal band of every frame, and the
+// split lines move each frame toward where the nodes' measured GPU times would be equal.
 class D3D12LinkedGpus : public DXSample
 {
 public:
@@ -56,9 +60,19 @@ private:
     bool m_windowVisible;
     bool m_windowedMode;
 
+    // Split-frame state. Node n owns the rows in [m_splitRows[n], m_splitRows[n + 1]).
+    bool m_splitFrame;
+    UINT m_splitRows[Settings::MaxNodeCount + 1];
+    float m_rowRates[Settings::MaxNodeCount];        // Smoothed rows per millisecond.
+    SplitFrameBand m_bands[Settings::MaxNodeCount];
+
     void LoadSceneData();
     float GetRandomFloat(float min, float max);
     void UpdateWindowTitle();
     void WaitForGpus();
     void MoveToNextFrame();
+    void ReloadSizeDependentResources();
+    void ToggleSplitFrame();
+    void ResetSplit();
+    void UpdateSplit();
 };
@@ -16,8 +16,12 @@ GpuNode::GpuNode(UINT nodeIndex, std::shared_ptr<CrossNodeResources> crossNodeRe
     m_frameIndex(0),
     m_nodeIndex(nodeIndex),
     m_nodeMask(1 << nodeIndex),
+    m_splitFrame(false),
     m_crossNodeResources(crossNodeResources),
-    m_sceneRenderTargetIndex(0)
+    m_sceneRenderTargetIndex(0),
+    m_timestampFrequency(0),
+    m_timestampsPending(false),
+    m_frameTime(0.0f)
 {
     m_sceneCommandAllocators.resize(Settings::FrameCount);
     m_postCommandAllocators.resize(Settings::FrameCount);
@@ -30,6 +34,13 @@ GpuNode::GpuNode(UINT nodeIndex, std::shared_ptr<CrossNodeResources> crossNodeRe
     if (Settings::NodeCount > 1)
     {
         m_nodeSync = std::make_unique<NodeSynchronization>();
+
+        m_copyCommandAllocators.resize(Settings::FrameCount);
+        m_compositeCommandAllocators.resize(Settings::FrameCount);
+
+        ThrowIfFailed(crossNodeResources->GetCopyQueue(nodeIndex)->QueryInterface(IID_PPV_ARGS(&m_copyQueue)));
+        m_splitPostFence = std::make_shared<Fence>(m_graphicsQueue.Get());
+        m_copyFence = std::make_shared<LinearFence>(m_copyQueue.Get(), Settings::FrameCount);
     }
 
     LoadPipeline();
@@ -57,17 +68,11 @@ void GpuNode::LoadPipeline()
         dsvHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
         dsvHeapDesc.NodeMask = m_nodeMask;
         ThrowIfFailed(pDevice->CreateDescriptorHeap(&dsvHeapDesc, IID_PPV_ARGS(&m_sceneDsvHeap)));
-
-        // Describe and create a constant buffer view (CBV) descriptor heap.
-        D3D12_DESCRIPTOR_HEAP_DESC cbvHeapDesc = {};
-        cbvHeapDesc.NumDescriptors = Settings::TriangleCount * Settings::SceneConstantBufferFrames;
-        cbvHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
-        cbvHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
-        cbvHeapDesc.NodeMask = m_nodeMask;
-        ThrowIfFailed(pDevice->CreateDescriptorHeap(&cbvHeapDesc, IID_PPV_ARGS(&m_sceneCbvHeap)));
     }
 
     // Post-process descriptor heaps.
+    // The scene render targets are different on every node, and a descriptor heap can only
+    // be visible to one node, so each node needs its own SRVs.
     {
         // Describe and create a render target view (RTV) descriptor heap for 
         // the final output.
@@ -85,14 +90,6 @@ void GpuNode::LoadPipeline()
         srvHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
         srvHeapDesc.NodeMask = m_nodeMask;
         ThrowIfFailed(pDevice->CreateDescriptorHeap(&srvHeapDesc, IID_PPV_ARGS(&m_postSrvHeap)));
-
-        // Describe and create a sampler descriptor heap.
-        D3D12_DESCRIPTOR_HEAP_DESC samplerHeapDesc = {};
-        samplerHeapDesc.NumDescriptors = 1;
-        samplerHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER;
-        samplerHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
-        samplerHeapDesc.NodeMask = m_nodeMask;
-        ThrowIfFailed(pDevice->CreateDescriptorHeap(&samplerHeapDesc, IID_PPV_ARGS(&m_postSamplerHeap)));
     }
 
     // Create command allocators for each frame.
@@ -101,19 +98,47 @@ void GpuNode::LoadPipeline()
         ThrowIfFailed(pDevice->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&m_sceneCommandAllocators[n])));
         ThrowIfFailed(pDevice->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&m_postCommandAllocators[n])));
     }
+
+    // Split-frame objects.
+    if (m_nodeSync)
+    {
+        for (UINT n = 0; n < Settings::FrameCount; n++)
+        {
+            ThrowIfFailed(pDevice->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_COPY, IID_PPV_ARGS(&m_copyCommandAllocators[n])));
+            ThrowIfFailed(pDevice->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&m_compositeCommandAllocators[n])));
+        }
+
+        // Describe and create an RTV descriptor heap for the split render target.
+        D3D12_DESCRIPTOR_HEAP_DESC splitRtvHeapDesc = {};
+        splitRtvHeapDesc.NumDescriptors = 1;
+        splitRtvHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_RTV;
+        splitRtvHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
+        splitRtvHeapDesc.NodeMask = m_nodeMask;
+        ThrowIfFailed(pDevice->CreateDescriptorHeap(&splitRtvHeapDesc, IID_PPV_ARGS(&m_splitRtvHeap)));
+
+        // Two timestamps each for the scene and post passes.
+        D3D12_QUERY_HEAP_DESC queryHeapDesc = {};
+        queryHeapDesc.Count = 4;
+        queryHeapDesc.Type = D3D12_QUERY_HEAP_TYPE_TIMESTAMP;
+        queryHeapDesc.NodeMask = m_nodeMask;
+        ThrowIfFailed(pDevice->CreateQueryHeap(&queryHeapDesc, IID_PPV_ARGS(&m_timestampQueryHeap)));
+
+        ThrowIfFailed(pDevice->CreateCommittedResource(
+            &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_READBACK, m_nodeMask, m_nodeMask),
+            D3D12_HEAP_FLAG_NONE,
+            &CD3DX12_RESOURCE_DESC::Buffer(queryHeapDesc.Count * sizeof(UINT64)),
+            D3D12_RESOURCE_STATE_COPY_DEST,
+            nullptr,
+            IID_PPV_ARGS(&m_timestampReadbackBuffer)));
+
+        ThrowIfFailed(m_graphicsQueue->GetTimestampFrequency(&m_timestampFrequency));
+    }
 }
 
 void GpuNode::LoadAssets()
 {
     auto pDevice = m_crossNodeResources->GetDevice();
 
-    // Single-use command allocator/list for resource initialization.
-    ComPtr<ID3D12CommandAllocator> commandAllocator;
-    ComPtr<ID3D12GraphicsCommandList> commandList;
-
-    ThrowIfFailed(pDevice->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&commandAllocator)));
-    ThrowIfFailed(pDevice->CreateCommandList(m_nodeMask, D3D12_COMMAND_LIST_TYPE_DIRECT, commandAllocator.Get(), nullptr, IID_PPV_ARGS(&commandList)));
-
     // Create the command lists.
     {
         ThrowIfFailed(pDevice->CreateCommandList(
@@ -135,162 +160,30 @@ void GpuNode::LoadAssets()
         // these here for the first frame.
         ThrowIfFailed(m_sceneCommandList->Close());
         ThrowIfFailed(m_postCommandList->Close());
-    }
-
-    ComPtr<ID3D12Resource> triangleVertexBufferUpload;
-    ComPtr<ID3D12Resource> quadVertexBufferUpload;
 
-    // Create the triangle vertex buffer.
-    {
-        // Define the geometry for a triangle.
-        SceneVertex vertices[] =
+        if (m_nodeSync)
         {
-            { { 0.0f, Settings::TriangleHalfWidth, Settings::TriangleDepth } },
-            { { Settings::TriangleHalfWidth, -Settings::TriangleHalfWidth, Settings::TriangleDepth } },
-            { { -Settings::TriangleHalfWidth, -Settings::TriangleHalfWidth, Settings::TriangleDepth } }
-        };
-
-        const UINT vertexBufferSize = sizeof(vertices);
-
-        D3D12_HEAP_PROPERTIES heapProps = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT);
-        heapProps.CreationNodeMask = m_nodeMask;
-        heapProps.VisibleNodeMask = m_nodeMask;
-
-        ThrowIfFailed(pDevice->CreateCommittedResource(
-            &heapProps,
-            D3D12_HEAP_FLAG_NONE,
-            &CD3DX12_RESOURCE_DESC::Buffer(vertexBufferSize),
-            D3D12_RESOURCE_STATE_COPY_DEST,
-            nullptr,
-            IID_PPV_ARGS(&m_sceneVertexBuffer)));
-
-        D3D12_HEAP_PROPERTIES uploadHeapProps = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD);
-        uploadHeapProps.CreationNodeMask = m_nodeMask;
-        uploadHeapProps.VisibleNodeMask = m_nodeMask;        // Upload heap is single-use and doesn't need to be shared.
-
-        ThrowIfFailed(pDevice->CreateCommittedResource(
-            &uploadHeapProps,
-            D3D12_HEAP_FLAG_NONE,
-            &CD3DX12_RESOURCE_DESC::Buffer(vertexBufferSize),
-            D3D12_RESOURCE_STATE_GENERIC_READ,
-            nullptr,
-            IID_PPV_ARGS(&triangleVertexBufferUpload)));
-
-        // Copy data to the intermediate upload heap and then schedule a copy
-        // from the upload heap to the vertex buffer.
-        D3D12_SUBRESOURCE_DATA vertexData = {};
-        vertexData.pData = reinterpret_cast<UINT8*>(vertices);
-        vertexData.RowPitch = vertexBufferSize;
-        vertexData.SlicePitch = vertexData.RowPitch;
-
-        UpdateSubresources<1>(commandList.Get(), m_sceneVertexBuffer.Get(), triangleVertexBufferUpload.Get(), 0, 0, 1, &vertexData);
-        commandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(m_sceneVertexBuffer.Get(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER));
-
-        // Initialize the vertex buffer view.
-        m_sceneVertexBufferView.BufferLocation = m_sceneVertexBuffer->GetGPUVirtualAddress();
-        m_sceneVertexBufferView.StrideInBytes = sizeof(SceneVertex);
-        m_sceneVertexBufferView.SizeInBytes = sizeof(vertices);
-    }
-
-    // Create the quad vertex buffer.
-    {
-        // Define the geometry for a quad.
-        PostVertex vertices[] =
-        {
-            { { -1.0f, -1.0f, 0.0f },{ 0.0f, 1.0f } },    // Bottom Left
-            { { -1.0f, 1.0f, 0.0f },{ 0.0f, 0.0f } },    // Top Left
-            { { 1.0f, -1.0f, 0.0f },{ 1.0f, 1.0f } },    // Bottom Right
-            { { 1.0f, 1.0f, 0.0f },{ 1.0f, 0.0f } },    // Top Right
-        };
-
-        const UINT vertexBufferSize = sizeof(vertices);
-
-        D3D12_HEAP_PROPERTIES heapProps = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT);
-        heapProps.CreationNodeMask = m_nodeMask;
-        heapProps.VisibleNodeMask = m_nodeMask;
-
-        ThrowIfFailed(pDevice->CreateCommittedResource(
-            &heapProps,
-            D3D12_HEAP_FLAG_NONE,
-            &CD3DX12_RESOURCE_DESC::Buffer(vertexBufferSize),
-            D3D12_RESOURCE_STATE_COPY_DEST,
-            nullptr,
-            IID_PPV_ARGS(&m_postVertexBuffer)));
-
-        D3D12_HEAP_PROPERTIES uploadHeapProps = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD);
-        uploadHeapProps.CreationNodeMask = m_nodeMask;
-        uploadHeapProps.VisibleNodeMask = m_nodeMask;        // Upload heap is single-use and doesn't need to be shared.
-
-        ThrowIfFailed(pDevice->CreateCommittedResource(
-            &uploadHeapProps,
-            D3D12_HEAP_FLAG_NONE,
-            &CD3DX12_RESOURCE_DESC::Buffer(vertexBufferSize),
-            D3D12_RESOURCE_STATE_GENERIC_READ,
-            nullptr,
-            IID_PPV_ARGS(&quadVertexBufferUpload)));
-
-        // Copy data to the intermediate upload heap and then schedule a copy
-        // from the upload heap to the vertex buffer.
-        D3D12_SUBRESOURCE_DATA vertexData = {};
-        vertexData.pData = reinterpret_cast<UINT8*>(vertices);
-        vertexData.RowPitch = vertexBufferSize;
-        vertexData.SlicePitch = vertexData.RowPitch;
-
-        UpdateSubresources<1>(commandList.Get(), m_postVertexBuffer.Get(), quadVertexBufferUpload.Get(), 0, 0, 1, &vertexData);
-        commandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(m_postVertexBuffer.Get(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER));
-
-        // Initialize the vertex buffer view.
-        m_postVertexBufferView.BufferLocation = m_postVertexBuffer->GetGPUVirtualAddress();
-        m_postVertexBufferView.StrideInBytes = sizeof(PostVertex);
-        m_postVertexBufferView.SizeInBytes = sizeof(vertices);
-    }
-
-    // Create constant buffer views.
-    {
-        CD3DX12_CPU_DESCRIPTOR_HANDLE cpuHandle(m_sceneCbvHeap->GetCPUDescriptorHandleForHeapStart());
-
-        D3D12_CONSTANT_BUFFER_VIEW_DESC cbvDesc = {};
-        cbvDesc.SizeInBytes = sizeof(SceneConstantBuffer);
-        cbvDesc.BufferLocation = m_crossNodeResources->GetSceneConstantBufferGpuVirtualAddress();
-
-        for (UINT frame = 0; frame < Settings::SceneConstantBufferFrames; frame++)
-        {
-            for (UINT n = 0; n < Settings::TriangleCount; n++)
-            {
-                pDevice->CreateConstantBufferView(&cbvDesc, cpuHandle);
-
-                cpuHandle.Offset(Settings::CbvSrvDescriptorSize);
-                cbvDesc.BufferLocation += cbvDesc.SizeInBytes;
-            }
+            ThrowIfFailed(pDevice->CreateCommandList(
+                m_nodeMask,
+                D3D12_COMMAND_LIST_TYPE_COPY,
+                m_copyCommandAllocators[m_frameIndex].Get(),
+                nullptr,
+                IID_PPV_ARGS(&m_copyCommandList)));
+
+            ThrowIfFailed(pDevice->CreateCommandList(
+                m_nodeMask,
+                D3D12_COMMAND_LIST_TYPE_DIRECT,
+                m_compositeCommandAllocators[m_frameIndex].Get(),
+                nullptr,
+                IID_PPV_ARGS(&m_compositeCommandList)));
+
+            ThrowIfFailed(m_copyCommandList->Close());
+            ThrowIfFailed(m_compositeCommandList->Close());
         }
     }
 
-    // Describe and create a sampler.
-    {
-        D3D12_SAMPLER_DESC samplerDesc = {};
-        samplerDesc.Filter = D3D12_FILTER_MIN_MAG_MIP_LINEAR;
-        samplerDesc.AddressU = D3D12_TEXTURE_ADDRESS_MODE_WRAP;
-        samplerDesc.AddressV = D3D12_TEXTURE_ADDRESS_MODE_WRAP;
-        samplerDesc.AddressW = D3D12_TEXTURE_ADDRESS_MODE_WRAP;
-        samplerDesc.MinLOD = 0;
-        samplerDesc.MaxLOD = D3D12_FLOAT32_MAX;
-        samplerDesc.MipLODBias = 0.0f;
-        samplerDesc.MaxAnisotropy = 1;
-        samplerDesc.ComparisonFunc = D3D12_COMPARISON_FUNC_ALWAYS;
-
-        pDevice->CreateSampler(&samplerDesc, m_postSamplerHeap->GetCPUDescriptorHandleForHeapStart());
-    }
-
-    ThrowIfFailed(commandList->Close());
-
-    // Submit the initialization work to the GPU.
-    ID3D12CommandList* ppCommandLists[] = { commandList.Get() };
-    m_graphicsQueue->ExecuteCommandLists(_countof(ppCommandLists), ppCommandLists);
-
-    // Wait for the graphics queue to finish executing the commands.
-    Fence fence(m_graphicsQueue.Get());
-    fence.FlushGpuQueue();
-
+    // The vertex buffers, constant buffer and sampler are all shared through
+    // CrossNodeResources, so there is nothing to upload here.
     LoadSizeDependentResources();
 }
 
@@ -321,6 +214,8 @@ void GpuNode::LoadSizeDependentResources()
 
     m_frameIndex = 0;
     m_sceneRenderTargetIndex = m_nodeIndex;
+    m_timestampsPending = false;
+    m_frameTime = 0.0f;
 
     // Create the render targets used to draw the scene.
     // These will be sampled from during the post-processing step.
@@ -354,18 +249,20 @@ void GpuNode::LoadSizeDependentResources()
             // The post-processing pass expects that a previous post-processing pass has
             // transitioned the next frame's dependencies into the COPY_DEST state.
             // Since these resources were created with the PIXEL_SHADER_RESOURCE state,
-            // we need to transition them to COPY_DEST.
+            // we need to transition them to COPY_DEST. In split-frame mode every node
+            // keeps its own history, so nothing is copied into it.
 
             UINT firstResource = (m_nodeIndex + Settings::SceneHistoryCount - (Settings::NodeCount - 1)) % Settings::SceneHistoryCount;
             UINT lastResource = (m_nodeIndex + Settings::SceneHistoryCount - 1) % Settings::SceneHistoryCount;
+            const bool copiedInto = m_nodeSync && !m_splitFrame;
             bool initCopyDest = false;
             if (firstResource <= lastResource)
             {
-                initCopyDest = m_nodeSync && (firstResource <= n && n <= lastResource);
+                initCopyDest = copiedInto && (firstResource <= n && n <= lastResource);
             }
             else
             {
-                initCopyDest = m_nodeSync && (n <= lastResource || firstResource <= n);
+                initCopyDest = copiedInto && (n <= lastResource || firstResource <= n);
             }
 
             ThrowIfFailed(pDevice->CreatePlacedResource(
@@ -386,6 +283,33 @@ void GpuNode::LoadSizeDependentResources()
         }
 
         commandList->ResourceBarrier(_countof(barriers), barriers);
+
+        // Create the split-frame targets. Both start in the COMMON state, which is the
+        // state copy queues use them in.
+        if (m_nodeSync)
+        {
+            ThrowIfFailed(pDevice->CreateCommittedResource(
+                &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT, m_nodeMask, m_nodeMask),
+                D3D12_HEAP_FLAG_NONE,
+                &renderTargetDesc,
+                D3D12_RESOURCE_STATE_COMMON,
+                nullptr,
+                IID_PPV_ARGS(&m_splitRenderTarget)));
+
+            pDevice->CreateRenderTargetView(m_splitRenderTarget.Get(), nullptr, m_splitRtvHeap->GetCPUDescriptorHandleForHeapStart());
+
+            // The other nodes copy into the receive target, so it has to be visible to them.
+            D3D12_RESOURCE_DESC receiveTargetDesc = renderTargetDesc;
+            receiveTargetDesc.Flags = D3D12_RESOURCE_FLAG_NONE;
+
+            ThrowIfFailed(pDevice->CreateCommittedResource(
+                &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT, m_nodeMask, Settings::SharedNodeMask),
+                D3D12_HEAP_FLAG_NONE,
+                &receiveTargetDesc,
+                D3D12_RESOURCE_STATE_COMMON,
+                nullptr,
+                IID_PPV_ARGS(&m_splitReceiveTarget)));
+        }
     }
 
     // Create the depth stencil and its view.
@@ -446,6 +370,11 @@ void GpuNode::LinkSharedResources(std::shared_ptr<GpuNode>* ppNodes, UINT nodeCo
             // Keep a reference to the other nodes' fences so this node can wait to
             // perform the copy until the resource barriers are correctly set.
             m_nodeSync->postFences[nodeIndex] = ppNodes[nodeIndex]->m_postFence;
+
+            // In split-frame mode this node copies its band into the presenting node's
+            // receive target, and waits for the other nodes' copies when it presents.
+            ThrowIfFailed(ppNodes[nodeIndex]->m_splitReceiveTarget.As(&m_nodeSync->splitReceiveTargets[nodeIndex]));
+            m_nodeSync->copyFences[nodeIndex] = ppNodes[nodeIndex]->m_copyFence;
         }
     }
 }
@@ -456,10 +385,16 @@ void GpuNode::OnUpdate(SceneConstantBuffer* pBuffers, UINT bufferCount, UINT64 f
 }
 
 // Fill the command list with all the render commands and dependent state.
-void GpuNode::RenderScene(UINT64 frameId, UINT simulatedGpuLoad)
+// In split-frame mode, only the triangles in the node's band are drawn.
+void GpuNode::RenderScene(UINT64 frameId, UINT simulatedGpuLoad, const SplitFrameBand* pBand)
 {
-    UINT cbvDescriptorTableOffset = Settings::TriangleCount * (frameId % Settings::SceneConstantBufferFrames);
-    CD3DX12_GPU_DESCRIPTOR_HANDLE cbvHandle(m_sceneCbvHeap->GetGPUDescriptorHandleForHeapStart(), cbvDescriptorTableOffset, Settings::CbvSrvDescriptorSize);
+    if (pBand)
+    {
+        // Every node draws the same frame, so they all use the same history slot.
+        m_sceneRenderTargetIndex = frameId % Settings::SceneHistoryCount;
+    }
+
+    const D3D12_GPU_VIRTUAL_ADDRESS cbvAddress = m_crossNodeResources->GetSceneConstantBufferGpuVirtualAddress(frameId);
     CD3DX12_CPU_DESCRIPTOR_HANDLE rtvHandle(m_sceneRtvHeap->GetCPUDescriptorHandleForHeapStart(), m_sceneRenderTargetIndex, Settings::RtvDescriptorSize);
     CD3DX12_CPU_DESCRIPTOR_HANDLE dsvHandle(m_sceneDsvHeap->GetCPUDescriptorHandleForHeapStart());
 
@@ -469,38 +404,60 @@ void GpuNode::RenderScene(UINT64 frameId, UINT simulatedGpuLoad)
     ThrowIfFailed(m_sceneCommandAllocators[m_frameIndex]->Reset());
     ThrowIfFailed(m_sceneCommandList->Reset(m_sceneCommandAllocators[m_frameIndex].Get(), m_crossNodeResources->GetScenePipelineState()));
 
+    if (pBand)
+    {
+        m_sceneCommandList->EndQuery(m_timestampQueryHeap.Get(), D3D12_QUERY_TYPE_TIMESTAMP, 0);
+    }
+
     // Set necessary state.
     m_sceneCommandList->SetGraphicsRootSignature(m_crossNodeResources->GetSceneRootSignature());
     m_sceneCommandList->SetGraphicsRoot32BitConstant(1, simulatedGpuLoad, 0);
-    
-    ID3D12DescriptorHeap* ppHeaps[] = { m_sceneCbvHeap.Get() };
-    m_sceneCommandList->SetDescriptorHeaps(_countof(ppHeaps), ppHeaps);
+
+    const CD3DX12_RECT scissorRect = pBand ?
+        CD3DX12_RECT(0, static_cast<LONG>(pBand->renderTop), static_cast<LONG>(Settings::Width), static_cast<LONG>(pBand->renderBottom)) :
+        CD3DX12_RECT(Settings::ScissorRect);
 
     m_sceneCommandList->RSSetViewports(1, &Settings::Viewport);
-    m_sceneCommandList->RSSetScissorRects(1, &Settings::ScissorRect);
+    m_sceneCommandList->RSSetScissorRects(1, &scissorRect);
     m_sceneCommandList->OMSetRenderTargets(1, &rtvHandle, FALSE, &dsvHandle);
 
     // Record commands.
     D3D12_RESOURCE_BARRIER barrier = CD3DX12_RESOURCE_BARRIER::Transition(m_sceneRenderTargets[m_sceneRenderTargetIndex].Get(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_RENDER_TARGET);
     m_sceneCommandList->ResourceBarrier(1, &barrier);
-    m_sceneCommandList->ClearRenderTargetView(rtvHandle, Settings::ClearColor, 0, nullptr);
-    m_sceneCommandList->ClearDepthStencilView(dsvHandle, D3D12_CLEAR_FLAG_DEPTH, 1.0f, 0, 0, nullptr);
+    m_sceneCommandList->ClearRenderTargetView(rtvHandle, Settings::ClearColor, pBand ? 1 : 0, pBand ? &scissorRect : nullptr);
+    m_sceneCommandList->ClearDepthStencilView(dsvHandle, D3D12_CLEAR_FLAG_DEPTH, 1.0f, 0, pBand ? 1 : 0, pBand ? &scissorRect : nullptr);
     
     m_sceneCommandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-    m_sceneCommandList->IASetVertexBuffers(0, 1, &m_sceneVertexBufferView);
+    m_sceneCommandList->IASetVertexBuffers(0, 1, &m_crossNodeResources->GetSceneVertexBufferView());
 
-    for (UINT m = 0; m < Settings::TriangleCount; m++)
+    if (pBand)
     {
-        m_sceneCommandList->SetGraphicsRootDescriptorTable(0, cbvHandle);
-        m_sceneCommandList->DrawInstanced(3, 1, 0, 0);
-
-        cbvHandle.Offset(Settings::CbvSrvDescriptorSize);
+        // The simulated load is in the vertex shader, so only drawing the triangles
+        // that reach this band is what actually splits the work.
+        for (UINT triangle : pBand->triangles)
+        {
+            m_sceneCommandList->SetGraphicsRootConstantBufferView(0, cbvAddress + triangle * sizeof(SceneConstantBuffer));
+            m_sceneCommandList->DrawInstanced(3, 1, 0, 0);
+        }
+    }
+    else
+    {
+        for (UINT m = 0; m < Settings::TriangleCount; m++)
+        {
+            m_sceneCommandList->SetGraphicsRootConstantBufferView(0, cbvAddress + m * sizeof(SceneConstantBuffer));
+            m_sceneCommandList->DrawInstanced(3, 1, 0, 0);
+        }
     }
 
     barrier.Transition.StateBefore = D3D12_RESOURCE_STATE_RENDER_TARGET;
-    barrier.Transition.StateAfter = m_nodeSync ? D3D12_RESOURCE_STATE_COPY_SOURCE : D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE;
+    barrier.Transition.StateAfter = (m_nodeSync && !pBand) ? D3D12_RESOURCE_STATE_COPY_SOURCE : D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE;
     m_sceneCommandList->ResourceBarrier(1, &barrier);
 
+    if (pBand)
+    {
+        m_sceneCommandList->EndQuery(m_timestampQueryHeap.Get(), D3D12_QUERY_TYPE_TIMESTAMP, 1);
+    }
+
     ThrowIfFailed(m_sceneCommandList->Close());
 
     ID3D12CommandList* ppSceneCommandLists[] = { m_sceneCommandList.Get() };
@@ -509,17 +466,41 @@ void GpuNode::RenderScene(UINT64 frameId, UINT simulatedGpuLoad)
     m_sceneFence->Signal();
 }
 
-void GpuNode::RenderPost(UINT64 frameId)
+// In split-frame mode, a node that isn't presenting post-processes its band into the
+// split render target and sends it to the presenting node on its copy queue.
+void GpuNode::RenderPost(UINT64 frameId, const SplitFrameBand* pBand, UINT presentingNode)
 {
+    const bool toBackBuffer = !pBand || (presentingNode == m_nodeIndex);
     UINT backBufferIndex = m_crossNodeResources->GetSwapChain()->GetCurrentBackBufferIndex() / Settings::NodeCount;
-    CD3DX12_CPU_DESCRIPTOR_HANDLE rtvHandle = CD3DX12_CPU_DESCRIPTOR_HANDLE(m_postRtvHeap->GetCPUDescriptorHandleForHeapStart(), backBufferIndex, Settings::RtvDescriptorSize);
+    CD3DX12_CPU_DESCRIPTOR_HANDLE rtvHandle = toBackBuffer ?
+        CD3DX12_CPU_DESCRIPTOR_HANDLE(m_postRtvHeap->GetCPUDescriptorHandleForHeapStart(), backBufferIndex, Settings::RtvDescriptorSize) :
+        CD3DX12_CPU_DESCRIPTOR_HANDLE(m_splitRtvHeap->GetCPUDescriptorHandleForHeapStart());
+    ID3D12Resource* pRenderTarget = toBackBuffer ? m_postRenderTargets[backBufferIndex].Get() : m_splitRenderTarget.Get();
 
     m_postFence->Next();
 
+    if (m_timestampsPending)
+    {
+        // Split-frame rendering only runs on linked GPUs, where each node buffers a
+        // single frame, so the wait above means the last frame's timestamps are ready.
+        const CD3DX12_RANGE readRange(0, 4 * sizeof(UINT64));
+        UINT64* pTimestamps;
+        ThrowIfFailed(m_timestampReadbackBuffer->Map(0, &readRange, reinterpret_cast<void**>(&pTimestamps)));
+        const UINT64 ticks = (pTimestamps[1] - pTimestamps[0]) + (pTimestamps[3] - pTimestamps[2]);
+        m_timestampReadbackBuffer->Unmap(0, &CD3DX12_RANGE(0, 0));
+
+        m_frameTime = static_cast<float>(static_cast<double>(ticks) * 1000.0 / m_timestampFrequency);
+        m_timestampsPending = false;
+    }
+
     ThrowIfFailed(m_postCommandAllocators[m_frameIndex]->Reset());
     ThrowIfFailed(m_postCommandList->Reset(m_postCommandAllocators[m_frameIndex].Get(), m_crossNodeResources->GetPostPipelineState()));
 
-    if (m_nodeSync)
+    if (pBand)
+    {
+        m_postCommandList->EndQuery(m_timestampQueryHeap.Get(), D3D12_QUERY_TYPE_TIMESTAMP, 2);
+    }
+    else if (m_nodeSync)
     {
         // If the rendered scenes need to be copied across nodes, we need to wait
         // until the other nodes are done with their post processing passes (which
@@ -573,56 +554,166 @@ void GpuNode::RenderPost(UINT64 frameId)
 
     m_postCommandList->SetGraphicsRootSignature(m_crossNodeResources->GetPostRootSignature());
 
-    ID3D12DescriptorHeap* ppPostHeaps[] = { m_postSrvHeap.Get(), m_postSamplerHeap.Get() };
+    ID3D12DescriptorHeap* ppPostHeaps[] = { m_postSrvHeap.Get() };
     m_postCommandList->SetDescriptorHeaps(_countof(ppPostHeaps), ppPostHeaps);
 
+    // The blur only samples each history target at the pixel being shaded, so a
+    // node can post-process exactly the rows it owns.
+    const CD3DX12_RECT scissorRect = pBand ?
+        CD3DX12_RECT(0, static_cast<LONG>(pBand->top), static_cast<LONG>(Settings::Width), static_cast<LONG>(pBand->bottom)) :
+        CD3DX12_RECT(Settings::ScissorRect);
+
     m_postCommandList->RSSetViewports(1, &Settings::Viewport);
-    m_postCommandList->RSSetScissorRects(1, &Settings::ScissorRect);
+    m_postCommandList->RSSetScissorRects(1, &scissorRect);
 
-    D3D12_RESOURCE_BARRIER barrier = CD3DX12_RESOURCE_BARRIER::Transition(m_postRenderTargets[backBufferIndex].Get(), D3D12_RESOURCE_STATE_PRESENT, D3D12_RESOURCE_STATE_RENDER_TARGET);
+    D3D12_RESOURCE_BARRIER barrier = CD3DX12_RESOURCE_BARRIER::Transition(pRenderTarget, toBackBuffer ? D3D12_RESOURCE_STATE_PRESENT : D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_STATE_RENDER_TARGET);
     m_postCommandList->ResourceBarrier(1, &barrier);
 
     m_postCommandList->OMSetRenderTargets(1, &rtvHandle, false, nullptr);
 
     m_postCommandList->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP);
-    m_postCommandList->IASetVertexBuffers(0, 1, &m_postVertexBufferView);
+    m_postCommandList->IASetVertexBuffers(0, 1, &m_crossNodeResources->GetPostVertexBufferView());
 
     m_postCommandList->SetGraphicsRootDescriptorTable(0, m_postSrvHeap->GetGPUDescriptorHandleForHeapStart());
-    m_postCommandList->SetGraphicsRootDescriptorTable(1, m_postSamplerHeap->GetGPUDescriptorHandleForHeapStart());
-    m_postCommandList->SetGraphicsRoot32BitConstant(2, frameId % Settings::SceneHistoryCount, 0);
-    m_postCommandList->SetGraphicsRoot32BitConstant(2, static_cast<UINT>(min(frameId + 1, Settings::SceneHistoryCount)), 1);
+    m_postCommandList->SetGraphicsRoot32BitConstant(1, frameId % Settings::SceneHistoryCount, 0);
+    m_postCommandList->SetGraphicsRoot32BitConstant(1, static_cast<UINT>(min(frameId + 1, Settings::SceneHistoryCount)), 1);
 
     m_postCommandList->DrawInstanced(4, 1, 0, 0);
 
-    // Indicate that the back buffer will now be used to present.
-    barrier.Transition.StateBefore = D3D12_RESOURCE_STATE_RENDER_TARGET;
-    barrier.Transition.StateAfter = D3D12_RESOURCE_STATE_PRESENT;
-
-    D3D12_RESOURCE_BARRIER barriers[Settings::MaxNodeCount];
-    barriers[0] = barrier;
+    if (pBand)
+    {
+        // The presenting node's back buffer stays a render target until the other
+        // bands are composited into it. The split render target goes back to the
+        // COMMON state so that the copy queue can read it.
+        if (!toBackBuffer)
+        {
+            barrier.Transition.StateBefore = D3D12_RESOURCE_STATE_RENDER_TARGET;
+            barrier.Transition.StateAfter = D3D12_RESOURCE_STATE_COMMON;
+            m_postCommandList->ResourceBarrier(1, &barrier);
+        }
 
-    if (m_nodeSync)
+        m_postCommandList->EndQuery(m_timestampQueryHeap.Get(), D3D12_QUERY_TYPE_TIMESTAMP, 3);
+        m_postCommandList->ResolveQueryData(m_timestampQueryHeap.Get(), D3D12_QUERY_TYPE_TIMESTAMP, 0, 4, m_timestampReadbackBuffer.Get(), 0);
+        m_timestampsPending = true;
+    }
+    else
     {
-        // Transition render target resources rendered by the next nodes into the
-        // COPY_DEST state to prepare them to be copied to during those nodes'
-        // post-process passes.
-        for (UINT offset = 1; offset < Settings::NodeCount; offset++)
+        // Indicate that the back buffer will now be used to present.
+        barrier.Transition.StateBefore = D3D12_RESOURCE_STATE_RENDER_TARGET;
+        barrier.Transition.StateAfter = D3D12_RESOURCE_STATE_PRESENT;
+
+        D3D12_RESOURCE_BARRIER barriers[Settings::MaxNodeCount];
+        barriers[0] = barrier;
+
+        if (m_nodeSync)
         {
-            UINT renderTargetIndex = (m_sceneRenderTargetIndex + offset) % Settings::SceneHistoryCount;
+            // Transition render target resources rendered by the next nodes into the
+            // COPY_DEST state to prepare them to be copied to during those nodes'
+            // post-process passes.
+            for (UINT offset = 1; offset < Settings::NodeCount; offset++)
+            {
+                UINT renderTargetIndex = (m_sceneRenderTargetIndex + offset) % Settings::SceneHistoryCount;
 
-            barriers[offset] = CD3DX12_RESOURCE_BARRIER::Transition(
-                m_sceneRenderTargets[renderTargetIndex].Get(),
-                D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE,
-                D3D12_RESOURCE_STATE_COPY_DEST);
+                barriers[offset] = CD3DX12_RESOURCE_BARRIER::Transition(
+                    m_sceneRenderTargets[renderTargetIndex].Get(),
+                    D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE,
+                    D3D12_RESOURCE_STATE_COPY_DEST);
+            }
         }
-    }
 
-    m_postCommandList->ResourceBarrier(Settings::NodeCount, barriers);
+        m_postCommandList->ResourceBarrier(Settings::NodeCount, barriers);
+    }
 
     ThrowIfFailed(m_postCommandList->Close());
 
+    if (!toBackBuffer)
+    {
+        // The last copy out of the split render target has to finish before it is
+        // drawn to again.
+        Fence::GpuWait(m_graphicsQueue.Get(), m_copyFence.get());
+    }
+
     ID3D12CommandList* ppPostCommandLists[] = { m_postCommandList.Get() };
     m_graphicsQueue->ExecuteCommandLists(_countof(ppPostCommandLists), ppPostCommandLists);
+
+    if (!toBackBuffer)
+    {
+        m_splitPostFence->Signal();
+
+        m_copyFence->Next();
+
+        ThrowIfFailed(m_copyCommandAllocators[m_frameIndex]->Reset());
+        ThrowIfFailed(m_copyCommandList->Reset(m_copyCommandAllocators[m_frameIndex].Get(), nullptr));
+
+        // Only this node's band is sent, not the whole frame. Both resources are in
+        // the COMMON state and are promoted for the copy.
+        const CD3DX12_BOX band(0, static_cast<LONG>(pBand->top), static_cast<LONG>(Settings::Width), static_cast<LONG>(pBand->bottom));
+        const CD3DX12_TEXTURE_COPY_LOCATION dest(m_nodeSync->splitReceiveTargets[presentingNode].Get(), 0);
+        const CD3DX12_TEXTURE_COPY_LOCATION source(m_splitRenderTarget.Get(), 0);
+        m_copyCommandList->CopyTextureRegion(&dest, 0, pBand->top, 0, &source, &band);
+
+        ThrowIfFailed(m_copyCommandList->Close());
+
+        // Wait for the band to be post-processed, and for the presenting node to be
+        // done with what was last copied into its receive target.
+        Fence::GpuWait(m_copyQueue.Get(), m_splitPostFence.get());
+        Fence::GpuWait(m_copyQueue.Get(), m_nodeSync->postFences[presentingNode].get());
+
+        ID3D12CommandList* ppCopyCommandLists[] = { m_copyCommandList.Get() };
+        m_copyQueue->ExecuteCommandLists(_countof(ppCopyCommandLists), ppCopyCommandLists);
+
+        m_copyFence->Signal();
+    }
+}
+
+// Copy the bands of the other nodes into this node's back buffer once they arrive,
+// and prepare it to be presented.
+void GpuNode::CompositeSplitFrame(const SplitFrameBand* pBands, UINT bandCount)
+{
+    UINT backBufferIndex = m_crossNodeResources->GetSwapChain()->GetCurrentBackBufferIndex() / Settings::NodeCount;
+    ID3D12Resource* pBackBuffer = m_postRenderTargets[backBufferIndex].Get();
+
+    ThrowIfFailed(m_compositeCommandAllocators[m_frameIndex]->Reset());
+    ThrowIfFailed(m_compositeCommandList->Reset(m_compositeCommandAllocators[m_frameIndex].Get(), nullptr));
+
+    D3D12_RESOURCE_BARRIER barriers[] =
+    {
+        CD3DX12_RESOURCE_BARRIER::Transition(pBackBuffer, D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_COPY_DEST),
+        CD3DX12_RESOURCE_BARRIER::Transition(m_splitReceiveTarget.Get(), D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_STATE_COPY_SOURCE)
+    };
+    m_compositeCommandList->ResourceBarrier(_countof(barriers), barriers);
+
+    const CD3DX12_TEXTURE_COPY_LOCATION dest(pBackBuffer, 0);
+    const CD3DX12_TEXTURE_COPY_LOCATION source(m_splitReceiveTarget.Get(), 0);
+    for (UINT n = 0; n < bandCount; n++)
+    {
+        if (n != m_nodeIndex)
+        {
+            const CD3DX12_BOX band(0, static_cast<LONG>(pBands[n].top), static_cast<LONG>(Settings::Width), static_cast<LONG>(pBands[n].bottom));
+            m_compositeCommandList->CopyTextureRegion(&dest, 0, pBands[n].top, 0, &source, &band);
+        }
+    }
+
+    // Indicate that the back buffer will now be used to present, and hand the
+    // receive target back to the other nodes' copy queues.
+    barriers[0].Transition.StateBefore = D3D12_RESOURCE_STATE_COPY_DEST;
+    barriers[0].Transition.StateAfter = D3D12_RESOURCE_STATE_PRESENT;
+    barriers[1].Transition.StateBefore = D3D12_RESOURCE_STATE_COPY_SOURCE;
+    barriers[1].Transition.StateAfter = D3D12_RESOURCE_STATE_COMMON;
+    m_compositeCommandList->ResourceBarrier(_countof(barriers), barriers);
+
+    ThrowIfFailed(m_compositeCommandList->Close());
+
+    for (UINT n = 0; n < bandCount; n++)
+    {
+        if (n != m_nodeIndex)
+        {
+            Fence::GpuWait(m_graphicsQueue.Get(), m_nodeSync->copyFences[n].get());
+        }
+    }
+
+    ID3D12CommandList* ppCommandLists[] = { m_compositeCommandList.Get() };
+    m_graphicsQueue->ExecuteCommandLists(_countof(ppCommandLists), ppCommandLists);
 }
 
 void GpuNode::Present(UINT syncInterval, bool windowedMode)
@@ -651,6 +742,11 @@ void GpuNode::ReleaseBackBuffers()
 void GpuNode::WaitForGpu()
 {
     m_postFence->FlushGpuQueue();
+
+    if (m_copyFence)
+    {
+        m_copyFence->FlushGpuQueue();
+    }
 }
 
 void GpuNode::MoveToNextFrame()
@@ -17,7 +17,18 @@
 
 using Microsoft::WRL::ComPtr;
 
-// Container and logic for resources consumed only by a single GPU node.
+// The part of the frame a node is responsible for in split-frame rendering.
+struct SplitFrameBand
+{
+    UINT top;                       // The rows this node post-processes and presents.
+    UINT bottom;
+    UINT renderTop;                 // The rows this node draws the scene into, which
+    UINT renderBottom;              // include Settings::SplitFrameMargin past each split.
+    std::vector<UINT> triangles;    // The triangles that overlap the drawn rows.
+};
+
+// Container and logic for resources consumed only by a single GPU node. Anything that
+// can be shared across nodes lives in CrossNodeResources instead.
 class GpuNode
 {
 public:
@@ -27,18 +38,26 @@ public:
     void LoadSizeDependentResources();
     void LinkSharedResources(std::shared_ptr<GpuNode>* ppNodes, UINT nodeCount);
     void OnUpdate(SceneConstantBuffer* pBuffers, UINT bufferCount, UINT64 frameId);
-    void RenderScene(UINT64 frameId, UINT simulatedGpuLoad);
-    void RenderPost(UINT64 frameId);
+    void RenderScene(UINT64 frameId, UINT simulatedGpuLoad, const SplitFrameBand* pBand = nullptr);
+    void RenderPost(UINT64 frameId, const SplitFrameBand* pBand = nullptr, UINT presentingNode = 0);
+    void CompositeSplitFrame(const SplitFrameBand* pBands, UINT bandCount);
     void Present(UINT syncInterval, bool windowedMode);
 
     void ReleaseBackBuffers();
     void WaitForGpu();
     void MoveToNextFrame();
 
+    // Takes effect the next time the size dependent resources are loaded.
+    inline void SetSplitFrame(bool splitFrame)  { m_splitFrame = splitFrame; }
+
+    // The GPU time, in milliseconds, this node spent on its last split frame.
+    inline float GetFrameTime() const           { return m_frameTime; }
+
 private:
     UINT m_frameIndex;
     UINT m_nodeIndex;
     UINT m_nodeMask;
+    bool m_splitFrame;
 
     std::shared_ptr<CrossNodeResources> m_crossNodeResources;
 
@@ -47,26 +66,10 @@ private:
     std::vector<ComPtr<ID3D12CommandAllocator>> m_postCommandAllocators;
     ComPtr<ID3D12DescriptorHeap> m_sceneRtvHeap;
     ComPtr<ID3D12DescriptorHeap> m_sceneDsvHeap;
-    ComPtr<ID3D12DescriptorHeap> m_sceneCbvHeap;
     ComPtr<ID3D12DescriptorHeap> m_postRtvHeap;
     ComPtr<ID3D12DescriptorHeap> m_postSrvHeap;
-    ComPtr<ID3D12DescriptorHeap> m_postSamplerHeap;
-
-    // Vertex definitions.
-    struct SceneVertex
-    {
-        DirectX::XMFLOAT3 position;
-    };
-
-    struct PostVertex
-    {
-        DirectX::XMFLOAT3 position;
-        DirectX::XMFLOAT2 uv;
-    };
 
     // Scene objects.
-    ComPtr<ID3D12Resource> m_sceneVertexBuffer;
-    D3D12_VERTEX_BUFFER_VIEW m_sceneVertexBufferView;
     ComPtr<ID3D12GraphicsCommandList> m_sceneCommandList;
     ComPtr<ID3D12Heap> m_sceneRenderTargetHeap;
     ComPtr<ID3D12Resource> m_sceneDepthStencil;
@@ -81,21 +84,44 @@ private:
     UINT m_sceneRenderTargetIndex;
 
     // Post-process objects.
-    ComPtr<ID3D12Resource> m_postVertexBuffer;
-    D3D12_VERTEX_BUFFER_VIEW m_postVertexBufferView;
     ComPtr<ID3D12GraphicsCommandList> m_postCommandList;
     std::vector<ComPtr<ID3D12Resource>> m_postRenderTargets;
 
+    // Split-frame objects. When this node isn't presenting, it post-processes its band
+    // into the split render target and copies that band into the presenting node's
+    // receive target. When it is presenting, it copies the other bands out of its
+    // receive target into the back buffer.
+    ComPtr<ID3D12CommandQueue> m_copyQueue;
+    std::vector<ComPtr<ID3D12CommandAllocator>> m_copyCommandAllocators;
+    std::vector<ComPtr<ID3D12CommandAllocator>> m_compositeCommandAllocators;
+    ComPtr<ID3D12GraphicsCommandList> m_copyCommandList;
+    ComPtr<ID3D12GraphicsCommandList> m_compositeCommandList;
+    ComPtr<ID3D12Resource> m_splitRenderTarget;
+    ComPtr<ID3D12Resource> m_splitReceiveTarget;
+    ComPtr<ID3D12DescriptorHeap> m_splitRtvHeap;
+
+    // The scene and post passes are timed separately so that the time spent waiting on
+    // other queues between them isn't counted.
+    ComPtr<ID3D12QueryHeap> m_timestampQueryHeap;
+    ComPtr<ID3D12Resource> m_timestampReadbackBuffer;
+    UINT64 m_timestampFrequency;
+    bool m_timestampsPending;
+    float m_frameTime;
+
     // Objects used to support synchronizing render target contents across GPU nodes.
     struct NodeSynchronization
     {
         ComPtr<ID3D12Resource> sceneRenderTargets[Settings::MaxNodeCount][Settings::SceneHistoryCount];
+        ComPtr<ID3D12Resource> splitReceiveTargets[Settings::MaxNodeCount];
         std::shared_ptr<Fence> postFences[Settings::MaxNodeCount];
+        std::shared_ptr<Fence> copyFences[Settings::MaxNodeCount];
     };
     std::unique_ptr<NodeSynchronization> m_nodeSync;
 
     std::shared_ptr<LinearFence> m_sceneFence;
     std::shared_ptr<LinearFence> m_postFence;
+    std::shared_ptr<Fence> m_splitPostFence;    // Signaled once the split render target is ready to copy.
+    std::shared_ptr<LinearFence> m_copyFence;
 
     static inline UINT64 AlignResource(UINT64 size, UINT64 alignment = D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT)
     {
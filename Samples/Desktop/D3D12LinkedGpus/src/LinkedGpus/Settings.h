@@ -29,6 +29,12 @@ struct Settings
     static const float TriangleDepth;                    // The z offset used by the triangle vertices.
     static const float ClearColor[4];
 
+    // In split-frame mode each node draws this many rows past its split lines. Moving a
+    // split line by at most SplitFrameMaxStep rows per frame keeps the rows a node owns
+    // inside everything it drew over the whole scene history.
+    static const UINT SplitFrameMargin = 48;
+    static const UINT SplitFrameMaxStep = SplitFrameMargin / SceneHistoryCount;
+
     static UINT NodeCount;                                // The number of linked GPUs on the system.
     static UINT SharedNodeMask;                            // The mask representing all GPUs on the system.
     static bool Tier2Support;
@@ -26,7 +26,12 @@ D3D12Multithreading::D3D12Multithreading(UINT width, UINT height, std::wstring n
     m_fenceValue(0),
     m_rtvDescriptorSize(0),
     m_currentFrameResourceIndex(0),
-    m_pCurrentFrameResource(nullptr)
+    m_pCurrentFrameResource(nullptr),
+    m_workerBeginRenderFrame(nullptr),
+    m_chunksFinished(nullptr),
+    m_workerCount(0),
+    m_workersExit(false),
+    m_chunksRemaining(0)
 {
     s_app = this;
 
@@ -97,6 +102,7 @@ void D3D12Multithreading::LoadPipeline()
     queueDesc.Type = D3D12_COMMAND_LIST_TYPE_DIRECT;
 
     ThrowIfFailed(m_device->CreateCommandQueue(&queueDesc, IID_PPV_ARGS(&m_commandQueue)));
+    SetBenchmarkCommandQueue(m_device.Get(), m_commandQueue.Get());
     NAME_D3D12_OBJECT(m_commandQueue);
 
     // Describe and create the swap chain.
@@ -612,26 +618,25 @@ void D3D12Multithreading::LoadContexts()
         }
     };
 
-    for (int i = 0; i < NumContexts; i++)
-    {
-        m_workerBeginRenderFrame[i] = CreateEvent(
-            NULL,
-            FALSE,
-            FALSE,
-            NULL);
+    // Size the pool to the machine. The main thread records chunks as well
+    // once its own command lists are done, so it keeps a core for itself.
+    SYSTEM_INFO systemInfo;
+    GetSystemInfo(&systemInfo);
+    const UINT coreCount = static_cast<UINT>(systemInfo.dwNumberOfProcessors);
+    m_workerCount = (coreCount > 1) ? min(coreCount - 1, MaxWorkerThreads) : 1;
 
-        m_workerFinishedRenderFrame[i] = CreateEvent(
-            NULL,
-            FALSE,
-            FALSE,
-            NULL);
+    m_chunkQueues.reset(new ChunkQueue[m_workerCount]);
 
-        m_workerFinishShadowPass[i] = CreateEvent(
-            NULL,
-            FALSE,
-            FALSE,
-            NULL);
+    // Extra releases left over from frames that finished before every worker
+    // woke up are harmless, so the count is effectively unbounded.
+    m_workerBeginRenderFrame = CreateSemaphore(nullptr, 0, LONG_MAX, nullptr);
+    m_chunksFinished = CreateEvent(nullptr, FALSE, FALSE, nullptr);
+    assert(m_workerBeginRenderFrame != NULL);
+    assert(m_chunksFinished != NULL);
 
+    for (UINT i = 0; i < m_workerCount; i++)
+    {
+        m_chunkQueues[i].range = 0;
         m_threadParameters[i].threadIndex = i;
 
         m_threadHandles[i] = reinterpret_cast<HANDLE>(_beginthreadex(
@@ -642,10 +647,7 @@ void D3D12Multithreading::LoadContexts()
             0,
             nullptr));
 
-        assert(m_workerBeginRenderFrame[i] != NULL);
-        assert(m_workerFinishedRenderFrame[i] != NULL);
         assert(m_threadHandles[i] != NULL);
-
     }
 #endif
 }
@@ -718,35 +720,31 @@ void D3D12Multithreading::OnRender()
     BeginFrame();
 
 #if SINGLETHREADED
-    for (int i = 0; i < NumContexts; i++)
+    for (UINT i = 0; i < NumChunks; i++)
     {
-        WorkerThread(i);
+        RecordChunk(i);
     }
     MidFrame();
     EndFrame();
-    m_commandQueue->ExecuteCommandLists(_countof(m_pCurrentFrameResource->m_batchSubmit), m_pCurrentFrameResource->m_batchSubmit);
 #else
-    for (int i = 0; i < NumContexts; i++)
-    {
-        SetEvent(m_workerBeginRenderFrame[i]); // Tell each worker to start drawing.
-    }
+    DistributeChunks();
+    ReleaseSemaphore(m_workerBeginRenderFrame, m_workerCount, nullptr); // Tell the workers to start drawing.
 
     MidFrame();
     EndFrame();
 
-    WaitForMultipleObjects(NumContexts, m_workerFinishShadowPass, TRUE, INFINITE);
-
-    // You can execute command lists on any thread. Depending on the work 
-    // load, apps can choose between using ExecuteCommandLists on one thread 
-    // vs ExecuteCommandList from multiple threads.
-    m_commandQueue->ExecuteCommandLists(NumContexts + 2, m_pCurrentFrameResource->m_batchSubmit); // Submit PRE, MID and shadows.
-
-    WaitForMultipleObjects(NumContexts, m_workerFinishedRenderFrame, TRUE, INFINITE);
-
-    // Submit remaining command lists.
-    m_commandQueue->ExecuteCommandLists(_countof(m_pCurrentFrameResource->m_batchSubmit) - NumContexts - 2, m_pCurrentFrameResource->m_batchSubmit + NumContexts + 2);
+    // Help record whatever chunks are left, then wait for the ones still in
+    // flight on the workers.
+    RunChunks(-1);
+    WaitForSingleObject(m_chunksFinished, INFINITE);
 #endif
 
+    // Each chunk recorded its shadow and scene passes into lists of its own, so
+    // the workers never wait for each other between the passes. The lists are
+    // merged here in draw order: PRE, every shadow chunk, MID, every scene chunk
+    // and POST.
+    m_commandQueue->ExecuteCommandLists(_countof(m_pCurrentFrameResource->m_batchSubmit), m_pCurrentFrameResource->m_batchSubmit);
+
     m_cpuTimer.Tick(NULL);
     if (m_titleCount == TitleThrottle)
     {
@@ -766,7 +764,7 @@ void D3D12Multithreading::OnRender()
 
     // Present and update the frame index for the next frame.
     PIXBeginEvent(m_commandQueue.Get(), 0, L"Presenting to screen");
-    ThrowIfFailed(m_swapChain->Present(1, 0));
+    ThrowIfFailed(m_swapChain->Present(GetSyncInterval(), 0));
     PIXEndEvent(m_commandQueue.Get());
     m_frameIndex = m_swapChain->GetCurrentBackBufferIndex();
 
@@ -797,14 +795,20 @@ void D3D12Multithreading::OnDestroy()
         CloseHandle(m_fenceEvent);
     }
 
-    // Close thread events and thread handles.
-    for (int i = 0; i < NumContexts; i++)
+#if !SINGLETHREADED
+    // Wake the workers one last time so that they exit, then close thread
+    // events and thread handles.
+    m_workersExit = true;
+    ReleaseSemaphore(m_workerBeginRenderFrame, m_workerCount, nullptr);
+    WaitForMultipleObjects(m_workerCount, m_threadHandles, TRUE, INFINITE);
+
+    for (UINT i = 0; i < m_workerCount; i++)
     {
-        CloseHandle(m_workerBeginRenderFrame[i]);
-        CloseHandle(m_workerFinishShadowPass[i]);
-        CloseHandle(m_workerFinishedRenderFrame[i]);
         CloseHandle(m_threadHandles[i]);
     }
+    CloseHandle(m_workerBeginRenderFrame);
+    CloseHandle(m_chunksFinished);
+#endif
 
     for (int i = 0; i < _countof(m_frameResources); i++)
     {
@@ -890,91 +894,160 @@ void D3D12Multithreading::EndFrame()
     ThrowIfFailed(m_pCurrentFrameResource->m_commandLists[CommandListPost]->Close());
 }
 
-// Worker thread body. workerIndex is an integer from 0 to NumContexts 
-// describing the worker's thread index.
+// Worker thread body. threadIndex is an integer from 0 to m_workerCount
+// describing the worker's thread index and the chunk queue it owns.
 void D3D12Multithreading::WorkerThread(int threadIndex)
 {
     assert(threadIndex >= 0);
-    assert(threadIndex < NumContexts);
-#if !SINGLETHREADED
+    assert(threadIndex < static_cast<int>(m_workerCount));
 
-    while (threadIndex >= 0 && threadIndex < NumContexts)
+    while (true)
     {
         // Wait for main thread to tell us to draw.
+        WaitForSingleObject(m_workerBeginRenderFrame, INFINITE);
 
-        WaitForSingleObject(m_workerBeginRenderFrame[threadIndex], INFINITE);
-
-#endif
-        ID3D12GraphicsCommandList* pShadowCommandList = m_pCurrentFrameResource->m_shadowCommandLists[threadIndex].Get();
-        ID3D12GraphicsCommandList* pSceneCommandList = m_pCurrentFrameResource->m_sceneCommandLists[threadIndex].Get();
+        if (m_workersExit)
+        {
+            break;
+        }
 
-        //
-        // Shadow pass
-        //
+        RunChunks(threadIndex);
+    }
+}
 
-        // Populate the command list.
-        SetCommonPipelineState(pShadowCommandList);
-        m_pCurrentFrameResource->Bind(pShadowCommandList, FALSE, nullptr, nullptr);    // No need to pass RTV or DSV descriptor heap.
+// Hand each worker an equal, contiguous range of chunks for this frame.
+// Everything the chunks read must be written before this, since a worker may
+// still be awake from the last frame and start on them right away.
+void D3D12Multithreading::DistributeChunks()
+{
+    m_chunksRemaining = NumChunks;
 
-        // Set null SRVs for the diffuse/normal textures.
-        pShadowCommandList->SetGraphicsRootDescriptorTable(0, m_cbvSrvHeap->GetGPUDescriptorHandleForHeapStart());
+    for (UINT i = 0; i < m_workerCount; i++)
+    {
+        const UINT64 begin = static_cast<UINT64>(NumChunks) * i / m_workerCount;
+        const UINT64 end = static_cast<UINT64>(NumChunks) * (i + 1) / m_workerCount;
+        m_chunkQueues[i].range = (begin << 32) | end;
+    }
+}
 
-        // Distribute objects over threads by drawing only 1/NumContexts 
-        // objects per worker (i.e. every object such that objectnum % 
-        // NumContexts == threadIndex).
-        PIXBeginEvent(pShadowCommandList, 0, L"Worker drawing shadow pass...");
+// Take the next chunk from the front of the thread's own range, otherwise
+// steal one from the back of another worker's. The main thread passes -1 and
+// only steals.
+bool D3D12Multithreading::ClaimChunk(int threadIndex, UINT* pChunk)
+{
+    if (threadIndex >= 0)
+    {
+        std::atomic<UINT64>& range = m_chunkQueues[threadIndex].range;
+        UINT64 packed = range.load();
+        while (static_cast<UINT>(packed >> 32) < static_cast<UINT>(packed))
+        {
+            if (range.compare_exchange_weak(packed, packed + (1ull << 32)))
+            {
+                *pChunk = static_cast<UINT>(packed >> 32);
+                return true;
+            }
+        }
+    }
 
-        for (int j = threadIndex; j < _countof(SampleAssets::Draws); j += NumContexts)
+    // Start with the next worker over so that thieves spread out.
+    for (UINT i = 1; i <= m_workerCount; i++)
+    {
+        const UINT victim = static_cast<UINT>(threadIndex + static_cast<int>(i)) % m_workerCount;
+        std::atomic<UINT64>& range = m_chunkQueues[victim].range;
+        UINT64 packed = range.load();
+        while (static_cast<UINT>(packed >> 32) < static_cast<UINT>(packed))
         {
-            SampleAssets::DrawParameters drawArgs = SampleAssets::Draws[j];
+            if (range.compare_exchange_weak(packed, packed - 1))
+            {
+                *pChunk = static_cast<UINT>(packed) - 1;
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+void D3D12Multithreading::RunChunks(int threadIndex)
+{
+    UINT chunk;
+    while (ClaimChunk(threadIndex, &chunk))
+    {
+        RecordChunk(chunk);
 
-            pShadowCommandList->DrawIndexedInstanced(drawArgs.IndexCount, 1, drawArgs.IndexStart, drawArgs.VertexBase, 0);
+        // Tell main thread that we are done.
+        if (--m_chunksRemaining == 0)
+        {
+            SetEvent(m_chunksFinished);
         }
+    }
+}
 
-        PIXEndEvent(pShadowCommandList);
+// Record the shadow and scene passes for one chunk of draws into the chunk's
+// own pair of command lists.
+void D3D12Multithreading::RecordChunk(UINT chunk)
+{
+    assert(chunk < NumChunks);
 
-        ThrowIfFailed(pShadowCommandList->Close());
+    const UINT firstDraw = chunk * DrawsPerChunk;
+    const UINT lastDraw = min(firstDraw + DrawsPerChunk, static_cast<UINT>(_countof(SampleAssets::Draws)));
 
-#if !SINGLETHREADED
-        // Submit shadow pass.
-        SetEvent(m_workerFinishShadowPass[threadIndex]);
-#endif
+    ID3D12GraphicsCommandList* pShadowCommandList = m_pCurrentFrameResource->m_shadowCommandLists[chunk].Get();
+    ID3D12GraphicsCommandList* pSceneCommandList = m_pCurrentFrameResource->m_sceneCommandLists[chunk].Get();
 
-        //
-        // Scene pass
-        // 
+    //
+    // Shadow pass
+    //
 
-        // Populate the command list.  These can only be sent after the shadow 
-        // passes for this frame have been submitted.
-        SetCommonPipelineState(pSceneCommandList);
-        CD3DX12_CPU_DESCRIPTOR_HANDLE rtvHandle(m_rtvHeap->GetCPUDescriptorHandleForHeapStart(), m_frameIndex, m_rtvDescriptorSize);
-        CD3DX12_CPU_DESCRIPTOR_HANDLE dsvHandle(m_dsvHeap->GetCPUDescriptorHandleForHeapStart());
-        m_pCurrentFrameResource->Bind(pSceneCommandList, TRUE, &rtvHandle, &dsvHandle);
+    // Populate the command list.
+    SetCommonPipelineState(pShadowCommandList);
+    m_pCurrentFrameResource->Bind(pShadowCommandList, FALSE, nullptr, nullptr);    // No need to pass RTV or DSV descriptor heap.
 
-        PIXBeginEvent(pSceneCommandList, 0, L"Worker drawing scene pass...");
+    // Set null SRVs for the diffuse/normal textures.
+    pShadowCommandList->SetGraphicsRootDescriptorTable(0, m_cbvSrvHeap->GetGPUDescriptorHandleForHeapStart());
 
-        D3D12_GPU_DESCRIPTOR_HANDLE cbvSrvHeapStart = m_cbvSrvHeap->GetGPUDescriptorHandleForHeapStart();
-        const UINT cbvSrvDescriptorSize = m_device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
-        const UINT nullSrvCount = 2;
-        for (int j = threadIndex; j < _countof(SampleAssets::Draws); j += NumContexts)
-        {
-            SampleAssets::DrawParameters drawArgs = SampleAssets::Draws[j];
+    PIXBeginEvent(pShadowCommandList, 0, L"Worker drawing shadow pass...");
 
-            // Set the diffuse and normal textures for the current object.
-            CD3DX12_GPU_DESCRIPTOR_HANDLE cbvSrvHandle(cbvSrvHeapStart, nullSrvCount + drawArgs.DiffuseTextureIndex, cbvSrvDescriptorSize);
-            pSceneCommandList->SetGraphicsRootDescriptorTable(0, cbvSrvHandle);
+    for (UINT j = firstDraw; j < lastDraw; j++)
+    {
+        SampleAssets::DrawParameters drawArgs = SampleAssets::Draws[j];
 
-            pSceneCommandList->DrawIndexedInstanced(drawArgs.IndexCount, 1, drawArgs.IndexStart, drawArgs.VertexBase, 0);
-        }
+        pShadowCommandList->DrawIndexedInstanced(drawArgs.IndexCount, 1, drawArgs.IndexStart, drawArgs.VertexBase, 0);
+    }
 
-        PIXEndEvent(pSceneCommandList);
-        ThrowIfFailed(pSceneCommandList->Close());
+    PIXEndEvent(pShadowCommandList);
 
-#if !SINGLETHREADED
-        // Tell main thread that we are done.
-        SetEvent(m_workerFinishedRenderFrame[threadIndex]); 
+    ThrowIfFailed(pShadowCommandList->Close());
+
+    //
+    // Scene pass
+    // 
+
+    // Populate the command list.  These are submitted after the MID command
+    // list, so they see the shadow map of every chunk.
+    SetCommonPipelineState(pSceneCommandList);
+    CD3DX12_CPU_DESCRIPTOR_HANDLE rtvHandle(m_rtvHeap->GetCPUDescriptorHandleForHeapStart(), m_frameIndex, m_rtvDescriptorSize);
+    CD3DX12_CPU_DESCRIPTOR_HANDLE dsvHandle(m_dsvHeap->GetCPUDescriptorHandleForHeapStart());
+    m_pCurrentFrameResource->Bind(pSceneCommandList, TRUE, &rtvHandle, &dsvHandle);
+
+    PIXBeginEvent(pSceneCommandList, 0, L"Worker drawing scene pass...");
+
+    D3D12_GPU_DESCRIPTOR_HANDLE cbvSrvHeapStart = m_cbvSrvHeap->GetGPUDescriptorHandleForHeapStart();
+    const UINT cbvSrvDescriptorSize = m_device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+    const UINT nullSrvCount = 2;
+    for (UINT j = firstDraw; j < lastDraw; j++)
+    {
+        SampleAssets::DrawParameters drawArgs = SampleAssets::Draws[j];
+
+        // Set the diffuse and normal textures for the current object.
+        CD3DX12_GPU_DESCRIPTOR_HANDLE cbvSrvHandle(cbvSrvHeapStart, nullSrvCount + drawArgs.DiffuseTextureIndex, cbvSrvDescriptorSize);
+        pSceneCommandList->SetGraphicsRootDescriptorTable(0, cbvSrvHandle);
+
+        pSceneCommandList->DrawIndexedInstanced(drawArgs.IndexCount, 1, drawArgs.IndexStart, drawArgs.VertexBase, 0);
     }
-#endif
+
+    PIXEndEvent(pSceneCommandList);
+    ThrowIfFailed(pSceneCommandList->Close());
 }
 
 void D3D12Multithreading::SetCommonPipelineState(ID3D12GraphicsCommandList* pCommandList)
@@ -18,6 +18,8 @@
 
 using namespace DirectX;
 
+static const UINT NumChunks = (_countof(SampleAssets::Draws) + DrawsPerChunk - 1) / DrawsPerChunk;
+
 // Note that while ComPtr is used to manage the lifetime of resources on the CPU,
 // it has no understanding of the lifetime of resources on the GPU. Apps must account
 // for the GPU lifetime of resources to avoid destroying objects that may still be
@@ -111,10 +113,12 @@ private:
     double m_cpuTime;
 
     // Synchronization objects.
-    HANDLE m_workerBeginRenderFrame[NumContexts];
-    HANDLE m_workerFinishShadowPass[NumContexts];
-    HANDLE m_workerFinishedRenderFrame[NumContexts];
-    HANDLE m_threadHandles[NumContexts];
+    HANDLE m_workerBeginRenderFrame;    // Semaphore released once per worker each frame.
+    HANDLE m_chunksFinished;            // Set by whichever thread records the last chunk.
+    HANDLE m_threadHandles[MaxWorkerThreads];
+    UINT m_workerCount;
+    bool m_workersExit;
+    std::atomic<UINT> m_chunksRemaining;
     UINT m_frameIndex;
     HANDLE m_fenceEvent;
     ComPtr<ID3D12Fence> m_fence;
@@ -132,9 +136,22 @@ private:
     {
         int threadIndex;
     };
-    ThreadParameter m_threadParameters[NumContexts];
+    ThreadParameter m_threadParameters[MaxWorkerThreads];
+
+    // Each worker starts the frame owning a contiguous range of chunks, packed
+    // as (begin << 32) | end. The owner takes chunks from the front and other
+    // threads steal from the back, so both only ever need a compare-exchange.
+    struct ChunkQueue
+    {
+        std::atomic<UINT64> range;
+    };
+    std::unique_ptr<ChunkQueue[]> m_chunkQueues;
 
     void WorkerThread(int threadIndex);
+    void DistributeChunks();
+    bool ClaimChunk(int threadIndex, UINT* pChunk);
+    void RunChunks(int threadIndex);
+    void RecordChunk(UINT chunk);
     void SetCommonPipelineState(ID3D12GraphicsCommandList* pCommandList);
 
     void LoadPipeline();
@@ -29,7 +29,7 @@ FrameResource::FrameResource(ID3D12Device* pDevice, ID3D12PipelineState* pPso, I
         ThrowIfFailed(m_commandLists[i]->Close());
     }
 
-    for (UINT i = 0; i < NumContexts; i++)
+    for (UINT i = 0; i < NumChunks; i++)
     {
         // Create command list allocators for worker threads. One alloc is 
         // for the shadow pass command list, and one is for the scene pass.
@@ -182,7 +182,7 @@ FrameResource::~FrameResource()
     m_shadowConstantBuffer = nullptr;
     m_sceneConstantBuffer = nullptr;
 
-    for (int i = 0; i < NumContexts; i++)
+    for (int i = 0; i < NumChunks; i++)
     {
         m_shadowCommandLists[i] = nullptr;
         m_shadowCommandAllocators[i] = nullptr;
@@ -242,7 +242,7 @@ void FrameResource::Init()
     m_commandLists[CommandListPre]->ClearDepthStencilView(m_shadowDepthView, D3D12_CLEAR_FLAG_DEPTH, 1.0f, 0, 0, nullptr);
 
     // Reset the worker command allocators and lists.
-    for (int i = 0; i < NumContexts; i++)
+    for (int i = 0; i < NumChunks; i++)
     {
         ThrowIfFailed(m_shadowCommandAllocators[i]->Reset());
         ThrowIfFailed(m_shadowCommandLists[i]->Reset(m_shadowCommandAllocators[i].Get(), m_pipelineStateShadowMap.Get()));
@@ -22,16 +22,16 @@ using namespace Microsoft::WRL;
 class FrameResource
 {
 public:
-    ID3D12CommandList* m_batchSubmit[NumContexts * 2 + CommandListCount];
+    ID3D12CommandList* m_batchSubmit[NumChunks * 2 + CommandListCount];
 
     ComPtr<ID3D12CommandAllocator> m_commandAllocators[CommandListCount];
     ComPtr<ID3D12GraphicsCommandList> m_commandLists[CommandListCount];
 
-    ComPtr<ID3D12CommandAllocator> m_shadowCommandAllocators[NumContexts];
-    ComPtr<ID3D12GraphicsCommandList> m_shadowCommandLists[NumContexts];
+    ComPtr<ID3D12CommandAllocator> m_shadowCommandAllocators[NumChunks];
+    ComPtr<ID3D12GraphicsCommandList> m_shadowCommandLists[NumChunks];
 
-    ComPtr<ID3D12CommandAllocator> m_sceneCommandAllocators[NumContexts];
-    ComPtr<ID3D12GraphicsCommandList> m_sceneCommandLists[NumContexts];
+    ComPtr<ID3D12CommandAllocator> m_sceneCommandAllocators[NumChunks];
+    ComPtr<ID3D12GraphicsCommandList> m_sceneCommandLists[NumChunks];
 
     UINT64 m_fenceValue;
 
@@ -29,6 +29,8 @@
 #include <pix3.h>
 
 #include <string>
+#include <atomic>
+#include <memory>
 #include <wrl.h>
 #include <process.h>
 #include <shellapi.h>
@@ -37,7 +39,10 @@
 
 static const UINT FrameCount = 3;
 
-static const UINT NumContexts = 3;
+// Draws are recorded in chunks, each with its own shadow and scene command
+// lists, that worker threads take from each other as they run out of work.
+static const UINT DrawsPerChunk = 64;
+static const UINT MaxWorkerThreads = 32;
 static const UINT NumLights = 3;        // Keep this in sync with "shaders.hlsl".
 
 static const UINT TitleThrottle = 200;    // Only update the titlebar every X number of frames.
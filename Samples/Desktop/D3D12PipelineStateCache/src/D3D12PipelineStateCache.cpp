@@ -26,7 +26,8 @@ D3D12PipelineStateCache::D3D12PipelineStateCache(UINT width, UINT height, std::w
     m_scissorRect(0, 0, static_cast<LONG>(width), static_cast<LONG>(height)),
     m_rtvDescriptorSize(0),
     m_srvDescriptorSize(0),
-    m_fenceValues{}
+    m_fenceValues{},
+    m_displayedCompileCount(0)
 {
     memset(m_enabledEffects, true, sizeof(m_enabledEffects));
 }
@@ -95,6 +96,7 @@ void D3D12PipelineStateCache::LoadPipeline()
     queueDesc.Type = D3D12_COMMAND_LIST_TYPE_DIRECT;
 
     ThrowIfFailed(m_device->CreateCommandQueue(&queueDesc, IID_PPV_ARGS(&m_commandQueue)));
+    SetBenchmarkCommandQueue(m_device.Get(), m_commandQueue.Get());
     NAME_D3D12_OBJECT(m_commandQueue);
 
     // Describe and create the swap chain.
@@ -403,11 +405,17 @@ void D3D12PipelineStateCache::OnRender()
     PIXEndEvent(m_commandQueue.Get());
 
     // Present the frame.
-    ThrowIfFailed(m_swapChain->Present(1, 0));
+    ThrowIfFailed(m_swapChain->Present(GetSyncInterval(), 0));
 
     m_drawIndex = 0;
     m_psoLibrary.EndFrame();
 
+    // Refresh the compile latencies shown in the window title as background compiles finish.
+    if (m_psoLibrary.GetCompileCount() != m_displayedCompileCount)
+    {
+        UpdateWindowTextPso();
+    }
+
     MoveToNextFrame();
 }
 
@@ -449,6 +457,14 @@ void D3D12PipelineStateCache::OnKeyUp(UINT8 key)
         m_psoLibrary.SwitchPSOCachingMechanism();
         break;
 
+    case 'P':
+        m_psoLibrary.TogglePrewarm();
+        break;
+
+    case 'F':
+        m_psoLibrary.ToggleIncrementalFlush();
+        break;
+
     case '1':
         ToggleEffect(PostBlit);
         break;
@@ -641,6 +657,19 @@ void D3D12PipelineStateCache::UpdateWindowTextPso()
         stringStream <<  L"false]";
     }
 
+    stringStream << L"   [Pre-warm: ";
+    stringStream << (m_psoLibrary.PrewarmEnabled() ? L"true]" : L"false]");
+    stringStream << L"   [Incremental Flush: ";
+    stringStream << (m_psoLibrary.IncrementalFlushEnabled() ? L"true]" : L"false]");
+
+    m_displayedCompileCount = m_psoLibrary.GetCompileCount();
+    if (m_displayedCompileCount > 0)
+    {
+        stringStream << L"   [Compiles: " << m_displayedCompileCount;
+        stringStream << L", p50 < " << m_psoLibrary.GetCompileLatencyPercentile(0.5f) << L" ms";
+        stringStream << L", p95 < " << m_psoLibrary.GetCompileLatencyPercentile(0.95f) << L" ms]";
+    }
+
     SetCustomWindowText(stringStream.str().c_str());
 }
 
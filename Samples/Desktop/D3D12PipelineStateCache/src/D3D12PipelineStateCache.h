@@ -99,6 +99,7 @@ private:
 
     UINT m_drawIndex;
     UINT m_maxDrawsPerFrame;
+    UINT m_displayedCompileCount;
 
     SimpleCamera m_camera;
     XMMATRIX m_projectionMatrix;
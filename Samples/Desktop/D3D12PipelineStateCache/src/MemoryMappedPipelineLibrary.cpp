@@ -15,6 +15,18 @@
 
 using std::wstring;
 using Microsoft::WRL::ComPtr;
+using namespace Microsoft::WRL::Wrappers;
+
+MemoryMappedPipelineLibrary::MemoryMappedPipelineLibrary() :
+    m_libraryMutex(CreateMutex(nullptr, FALSE, nullptr)),
+    m_dirty(false)
+{
+}
+
+MemoryMappedPipelineLibrary::~MemoryMappedPipelineLibrary()
+{
+    CloseHandle(m_libraryMutex);
+}
 
 bool MemoryMappedPipelineLibrary::Init(ID3D12Device* pDevice, std::wstring filename)
 {
@@ -32,8 +44,17 @@ bool MemoryMappedPipelineLibrary::Init(ID3D12Device* pDevice, std::wstring filen
         ComPtr<ID3D12Device1> device1;
         if (SUCCEEDED(pDevice->QueryInterface(IID_PPV_ARGS(&device1))))
         {
+            // A snapshot is only left behind when the last session didn't exit cleanly, in which case
+            // it is newer than the library file.
+            const wstring snapshotFilename = filename + L".snapshot";
+            if (GetFileAttributes(snapshotFilename.c_str()) != INVALID_FILE_ATTRIBUTES)
+            {
+                MoveFileEx(snapshotFilename.c_str(), filename.c_str(), MOVEFILE_REPLACE_EXISTING);
+            }
+
             // Init the memory mapped file.
             MemoryMappedFile::Init(filename);
+            m_dirty = false;
 
             // Create a Pipeline Library from the serialized blob.
             // Note: The provided Library Blob must remain valid for the lifetime of the object returned - for efficiency, the data is not copied.
@@ -112,6 +133,77 @@ void MemoryMappedPipelineLibrary::Destroy(bool deleteFile)
         }
     }
 
+    // The library file is now at least as recent as the snapshot.
+    if (!m_filename.empty())
+    {
+        DeleteFile(GetSnapshotFilename().c_str());
+    }
+
     MemoryMappedFile::Destroy(deleteFile);
     m_pipelineLibrary = nullptr;
 }
+
+HRESULT MemoryMappedPipelineLibrary::StorePipeline(LPCWSTR pName, ID3D12PipelineState* pPipeline)
+{
+    auto lock = Mutex::Lock(m_libraryMutex);
+
+    const HRESULT hr = m_pipelineLibrary->StorePipeline(pName, pPipeline);
+    if (SUCCEEDED(hr))
+    {
+        m_dirty = true;
+    }
+
+    return hr;
+}
+
+void MemoryMappedPipelineLibrary::Flush()
+{
+    // The mapped file can't be written while the library references it, so the library is serialized
+    // to temporary memory and saved to a separate file.
+    BYTE* pData = nullptr;
+    UINT dataSize = 0;
+    {
+        auto lock = Mutex::Lock(m_libraryMutex);
+
+        if (!m_pipelineLibrary || !m_dirty)
+        {
+            return;
+        }
+
+        assert(m_pipelineLibrary->GetSerializedSize() <= UINT_MAX - sizeof(UINT));    // Code below casts to UINT.
+        const UINT librarySize = static_cast<UINT>(m_pipelineLibrary->GetSerializedSize());
+
+        // Same layout as the mapped file: the size of the library followed by the library itself.
+        dataSize = sizeof(UINT) + librarySize;
+        pData = new BYTE[dataSize];
+        memcpy(pData, &librarySize, sizeof(UINT));
+        ThrowIfFailed(m_pipelineLibrary->Serialize(pData + sizeof(UINT), librarySize));
+
+        m_dirty = false;
+    }
+
+    // Write to a temporary file first and then replace the snapshot, so a crash during the write
+    // never leaves a truncated snapshot.
+    const wstring tempFilename = m_filename + L".tmp";
+    bool written = false;
+
+    HANDLE file = CreateFile2(tempFilename.c_str(), GENERIC_WRITE, 0, CREATE_ALWAYS, nullptr);
+    if (file != INVALID_HANDLE_VALUE)
+    {
+        DWORD bytesWritten = 0;
+        written = WriteFile(file, pData, dataSize, &bytesWritten, nullptr) && bytesWritten == dataSize && FlushFileBuffers(file);
+        CloseHandle(file);
+    }
+
+    if (!written || !MoveFileEx(tempFilename.c_str(), GetSnapshotFilename().c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH))
+    {
+        std::cerr << (L"\nError %ld occurred writing the pipeline library snapshot!", GetLastError());
+        DeleteFile(tempFilename.c_str());
+
+        // Try again on the next flush.
+        auto lock = Mutex::Lock(m_libraryMutex);
+        m_dirty = true;
+    }
+
+    delete[] pData;
+}
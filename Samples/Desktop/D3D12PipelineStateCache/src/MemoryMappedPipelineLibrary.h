@@ -15,14 +15,28 @@
 
 // Native, hardware-specific, PSO cache using a Pipeline Library.
 // Pipeline Libraries allow applications to explicitly group PSOs which are expected to share data.
+//
+// The library is saved to the mapped file on exit. Flush() additionally saves it to a snapshot file
+// whenever new PSOs were stored, so a crash doesn't lose the PSOs compiled during the session. The
+// snapshot replaces the library file on the next Init().
 class MemoryMappedPipelineLibrary : public MemoryMappedFile
 {
 public:
+    MemoryMappedPipelineLibrary();
+    ~MemoryMappedPipelineLibrary();
+
     bool Init(ID3D12Device* pDevice, std::wstring filename);
     void Destroy(bool deleteFile);
+
+    HRESULT StorePipeline(LPCWSTR pName, ID3D12PipelineState* pPipeline);
+    void Flush();
     
     ID3D12PipelineLibrary* GetPipelineLibrary() { return m_pipelineLibrary.Get(); }
 
 private:
+    std::wstring GetSnapshotFilename() const { return m_filename + L".snapshot"; }
+
     Microsoft::WRL::ComPtr<ID3D12PipelineLibrary> m_pipelineLibrary;
+    HANDLE m_libraryMutex;    // Serializes storing pipelines with serializing the library.
+    bool m_dirty;             // Pipelines were stored since the last flush.
 };
@@ -21,23 +21,84 @@ PSOLibrary::PSOLibrary(UINT frameCount, UINT cbvRootSignatureIndex) :
     m_flagsMutex(),
     m_useUberShaders(true),
     m_useDiskLibraries(true),
+    m_usePrewarm(true),
+    m_useIncrementalFlush(true),
     m_psoCachingMechanism(PSOCachingMechanism::PipelineLibraries),
     m_drawIndex(0),
     m_compiledPSOFlags{},
     m_inflightPSOFlags{},
-    m_workerThreads{}
+    m_compileData{},
+    m_prewarmThread{},
+    m_compileThreads{},
+    m_compileThreadCount(0),
+    m_shutdownCompileThreads(false),
+    m_queuedPSOFlags{},
+    m_requestPriorities{},
+    m_requestTimes{},
+    m_pendingCompileCount(0),
+    m_compileLatencyHistogram{},
+    m_compileCount(0)
 {
     WCHAR path[512];
     GetAssetsPath(path, _countof(path));
     m_cachePath = path;
 
     m_flagsMutex = CreateMutex(nullptr, FALSE, nullptr);
+
+    LARGE_INTEGER frequency;
+    QueryPerformanceFrequency(&frequency);
+    m_timerFrequency = frequency.QuadPart;
+
+    m_compileRequestSemaphore = CreateSemaphore(nullptr, 0, EffectPipelineTypeCount, nullptr);
+    m_compileIdleEvent = CreateEvent(nullptr, TRUE, TRUE, nullptr);
+    if (!m_compileRequestSemaphore || !m_compileIdleEvent)
+    {
+        ThrowIfFailed(HRESULT_FROM_WIN32(GetLastError()));
+    }
+
+    // Leave a core to the render thread. The pool is never larger than the number of effects that
+    // can be compiled in the background.
+    SYSTEM_INFO systemInfo;
+    GetSystemInfo(&systemInfo);
+    m_compileThreadCount = (systemInfo.dwNumberOfProcessors > 1) ? systemInfo.dwNumberOfProcessors - 1 : 1;
+    m_compileThreadCount = min(m_compileThreadCount, min(MaxCompileThreads, EffectPipelineTypeCount - BaseEffectCount));
+
+    for (UINT i = 0; i < m_compileThreadCount; i++)
+    {
+        m_compileThreads[i] = CreateThread(
+            nullptr,
+            0,
+            reinterpret_cast<LPTHREAD_START_ROUTINE>(CompileWorker),
+            reinterpret_cast<void*>(this),
+            0,
+            nullptr);
+
+        if (!m_compileThreads[i])
+        {
+            ThrowIfFailed(HRESULT_FROM_WIN32(GetLastError()));
+        }
+    }
 }
 
 PSOLibrary::~PSOLibrary()
 {
     WaitForThreads();
 
+    {
+        auto lock = Mutex::Lock(m_flagsMutex);
+
+        m_shutdownCompileThreads = true;
+    }
+
+    ReleaseSemaphore(m_compileRequestSemaphore, m_compileThreadCount, nullptr);
+    WaitForMultipleObjects(m_compileThreadCount, m_compileThreads, TRUE, INFINITE);
+    for (UINT i = 0; i < m_compileThreadCount; i++)
+    {
+        CloseHandle(m_compileThreads[i]);
+    }
+    CloseHandle(m_compileRequestSemaphore);
+    CloseHandle(m_compileIdleEvent);
+
     for (UINT i = 0; i < EffectPipelineTypeCount; i++)
     {
         m_diskCaches[i].Destroy(false);
@@ -49,14 +110,14 @@ PSOLibrary::~PSOLibrary()
 
 void PSOLibrary::WaitForThreads()
 {
-    for (auto& thread : m_workerThreads)
+    // Wait for the queued requests to be compiled.
+    WaitForSingleObject(m_compileIdleEvent, INFINITE);
+
+    if (m_prewarmThread.threadHandle)
     {
-        if (thread.threadHandle)
-        {
-            WaitForSingleObject(thread.threadHandle, INFINITE);
-            CloseHandle(thread.threadHandle);
-        }
-        thread.threadHandle = nullptr;
+        WaitForSingleObject(m_prewarmThread.threadHandle, INFINITE);
+        CloseHandle(m_prewarmThread.threadHandle);
+        m_prewarmThread.threadHandle = nullptr;
     }
 }
 
@@ -79,11 +140,32 @@ void PSOLibrary::Build(ID3D12Device* pDevice, ID3D12RootSignature* pRootSignatur
     // Always compile the 3D shader and the Ubershader.
     for (UINT i = 0; i < BaseEffectCount; i++)
     {
-        m_workerThreads[i].pDevice = pDevice;
-        m_workerThreads[i].pRootSignature = pRootSignature;
-        m_workerThreads[i].type = EffectPipelineType(i);
-        m_workerThreads[i].pLibrary = this;
-        CompilePSO(&m_workerThreads[i]);
+        m_compileData[i].pDevice = pDevice;
+        m_compileData[i].pRootSignature = pRootSignature;
+        m_compileData[i].type = EffectPipelineType(i);
+        m_compileData[i].pLibrary = this;
+        CompilePSO(&m_compileData[i]);
+    }
+
+    // Load the effects stored by previous sessions on a background thread, so that they are ready
+    // before their first use and the uber shader is never needed for them.
+    if (m_usePrewarm && m_useDiskLibraries && (m_psoCachingMechanism == PSOCachingMechanism::PipelineLibraries))
+    {
+        m_prewarmThread.pDevice = pDevice;
+        m_prewarmThread.pRootSignature = pRootSignature;
+        m_prewarmThread.pLibrary = this;
+        m_prewarmThread.threadHandle = CreateThread(
+            nullptr,
+            0,
+            reinterpret_cast<LPTHREAD_START_ROUTINE>(PrewarmPSOs),
+            reinterpret_cast<void*>(&m_prewarmThread),
+            0,
+            nullptr);
+
+        if (!m_prewarmThread.threadHandle)
+        {
+            ThrowIfFailed(HRESULT_FROM_WIN32(GetLastError()));
+        }
     }
 
     m_dynamicCB.Init(pDevice);
@@ -120,49 +202,39 @@ void PSOLibrary::SetPipelineState(
             constantData->effectIndex = type;
             pCommandList->SetGraphicsRootConstantBufferView(m_cbvRootSignatureIndex, m_dynamicCB.GetGpuVirtualAddress(m_drawIndex, frameIndex));
 
-            // We don't want to double compile.
-            if (!isInFlight)
-            {
-                m_workerThreads[type].pDevice = pDevice;
-                m_workerThreads[type].pRootSignature = pRootSignature;
-                m_workerThreads[type].type = type;
-                m_workerThreads[type].pLibrary = this;
-
-                // Compile the PSO on a background thread.
-                m_workerThreads[type].threadHandle = CreateThread(
-                    nullptr,
-                    0,
-                    reinterpret_cast<LPTHREAD_START_ROUTINE>(CompilePSO),
-                    reinterpret_cast<void*>(&m_workerThreads[type]),
-                    CREATE_SUSPENDED,
-                    nullptr);
-
-                if (!m_workerThreads[type].threadHandle)
-                {
-                    ThrowIfFailed(HRESULT_FROM_WIN32(GetLastError()));
-                }
-
-                ResumeThread(m_workerThreads[type].threadHandle);
-
-                {
-                    auto lock = Mutex::Lock(m_flagsMutex);
-
-                    m_inflightPSOFlags[type] = true;
-                }
-            }
+            // Compile the PSO on the worker pool. The effect is needed now, so it goes ahead of
+            // speculative requests.
+            RequestPSO(pDevice, pRootSignature, type, CompilePriorityHigh);
 
             type = BaseUberShader;
         }
         else if (!isBuilt && !m_useUberShaders)
         {
+            // Let a compile or pre-warm that is already building this effect finish instead of
+            // building it twice.
+            if (isInFlight)
+            {
+                WaitForThreads();
+
+                auto lock = Mutex::Lock(m_flagsMutex);
+                isBuilt = m_compiledPSOFlags[type];
+            }
+
             // When not using ubershaders this will take a long time and cause a hitch as the 
             // CPU is stalled!
-            m_workerThreads[type].pDevice = pDevice;
-            m_workerThreads[type].pRootSignature = pRootSignature;
-            m_workerThreads[type].type = type;
-            m_workerThreads[type].pLibrary = this;
+            if (!isBuilt)
+            {
+                m_compileData[type].pDevice = pDevice;
+                m_compileData[type].pRootSignature = pRootSignature;
+                m_compileData[type].type = type;
+                m_compileData[type].pLibrary = this;
 
-            CompilePSO(&m_workerThreads[type]);
+                LARGE_INTEGER requestTime;
+                QueryPerformanceCounter(&requestTime);
+
+                CompilePSO(&m_compileData[type]);
+                RecordCompileLatency(requestTime.QuadPart);
+            }
         }
     }
     else
@@ -176,22 +248,165 @@ void PSOLibrary::SetPipelineState(
     m_drawIndex++;
 }
 
-void PSOLibrary::CompilePSO(CompilePSOThreadData* pDataPackage)
+// Queues a background compile of an effect. Requesting an effect that is already queued only raises
+// the priority of its request.
+void PSOLibrary::RequestPSO(
+    ID3D12Device* pDevice,
+    ID3D12RootSignature* pRootSignature,
+    _In_range_(0, EffectPipelineTypeCount-1) EffectPipelineType type,
+    CompilePriority priority)
 {
-    PSOLibrary* pLibrary = pDataPackage->pLibrary;
-    ID3D12Device* pDevice = pDataPackage->pDevice;
-    ID3D12RootSignature* pRootSignature = pDataPackage->pRootSignature;
-    EffectPipelineType type = pDataPackage->type;
-    bool useCache = false;
-    bool sleepToEmulateComplexCreatePSO = false;
+    assert(type > BaseUberShader);
 
     {
-        auto lock = Mutex::Lock(pLibrary->m_flagsMutex);
+        auto lock = Mutex::Lock(m_flagsMutex);
 
-        // When using the disk cache compilation should be extremely quick so don't sleep.
-        useCache = pLibrary->m_useDiskLibraries;
+        if (m_queuedPSOFlags[type])
+        {
+            m_requestPriorities[type] = max(m_requestPriorities[type], priority);
+            return;
+        }
+
+        // We don't want to double compile.
+        if (m_compiledPSOFlags[type] || m_inflightPSOFlags[type])
+        {
+            return;
+        }
+
+        m_compileData[type].pDevice = pDevice;
+        m_compileData[type].pRootSignature = pRootSignature;
+        m_compileData[type].type = type;
+        m_compileData[type].pLibrary = this;
+
+        LARGE_INTEGER requestTime;
+        QueryPerformanceCounter(&requestTime);
+
+        m_queuedPSOFlags[type] = true;
+        m_inflightPSOFlags[type] = true;
+        m_requestPriorities[type] = priority;
+        m_requestTimes[type] = requestTime.QuadPart;
+
+        m_pendingCompileCount++;
+        ResetEvent(m_compileIdleEvent);
+    }
+
+    ReleaseSemaphore(m_compileRequestSemaphore, 1, nullptr);
+}
+
+bool PSOLibrary::IsPSOReady(EffectPipelineType type)
+{
+    auto lock = Mutex::Lock(m_flagsMutex);
+
+    return m_compiledPSOFlags[type];
+}
+
+UINT PSOLibrary::GetCompileCount()
+{
+    auto lock = Mutex::Lock(m_flagsMutex);
+
+    return m_compileCount;
+}
+
+// Returns the upper bound, in ms, of the bucket holding the given percentile of the compile latencies.
+UINT PSOLibrary::GetCompileLatencyPercentile(float percentile)
+{
+    auto lock = Mutex::Lock(m_flagsMutex);
+
+    if (m_compileCount == 0)
+    {
+        return 0;
+    }
+
+    const UINT rank = max(1u, static_cast<UINT>(percentile * m_compileCount + 0.5f));
+    UINT count = 0;
+    for (UINT i = 0; i < CompileLatencyBucketCount - 1; i++)
+    {
+        count += m_compileLatencyHistogram[i];
+        if (count >= rank)
+        {
+            return 1u << i;
+        }
+    }
+
+    return 1u << (CompileLatencyBucketCount - 1);
+}
+
+void PSOLibrary::GetCompileLatencyHistogram(UINT (&counts)[CompileLatencyBucketCount])
+{
+    auto lock = Mutex::Lock(m_flagsMutex);
+
+    memcpy(counts, m_compileLatencyHistogram, sizeof(counts));
+}
+
+void PSOLibrary::RecordCompileLatency(UINT64 requestTime)
+{
+    LARGE_INTEGER time;
+    QueryPerformanceCounter(&time);
+    const UINT64 latencyMs = (time.QuadPart - requestTime) * 1000 / m_timerFrequency;
+
+    UINT bucket = 0;
+    while ((bucket < CompileLatencyBucketCount - 1) && (latencyMs >= (1ull << bucket)))
+    {
+        bucket++;
     }
 
+    auto lock = Mutex::Lock(m_flagsMutex);
+
+    m_compileLatencyHistogram[bucket]++;
+    m_compileCount++;
+}
+
+// Runs on each thread of the compile pool. Every signal of the semaphore hands the thread one queued request.
+void PSOLibrary::CompileWorker(PSOLibrary* pLibrary)
+{
+    for (;;)
+    {
+        WaitForSingleObject(pLibrary->m_compileRequestSemaphore, INFINITE);
+
+        EffectPipelineType type = EffectPipelineTypeCount;
+        UINT64 requestTime = 0;
+
+        {
+            auto lock = Mutex::Lock(pLibrary->m_flagsMutex);
+
+            if (pLibrary->m_shutdownCompileThreads)
+            {
+                return;
+            }
+
+            // Take the highest priority request, the oldest one first.
+            for (UINT i = PostBlit; i < EffectPipelineTypeCount; i++)
+            {
+                if (pLibrary->m_queuedPSOFlags[i] &&
+                    ((type == EffectPipelineTypeCount) ||
+                     (pLibrary->m_requestPriorities[i] > pLibrary->m_requestPriorities[type]) ||
+                     ((pLibrary->m_requestPriorities[i] == pLibrary->m_requestPriorities[type]) && (pLibrary->m_requestTimes[i] < pLibrary->m_requestTimes[type]))))
+                {
+                    type = EffectPipelineType(i);
+                }
+            }
+
+            assert(type != EffectPipelineTypeCount);
+            pLibrary->m_queuedPSOFlags[type] = false;
+            requestTime = pLibrary->m_requestTimes[type];
+        }
+
+        CompilePSO(&pLibrary->m_compileData[type]);
+        pLibrary->RecordCompileLatency(requestTime);
+
+        {
+            auto lock = Mutex::Lock(pLibrary->m_flagsMutex);
+
+            if (--pLibrary->m_pendingCompileCount == 0)
+            {
+                SetEvent(pLibrary->m_compileIdleEvent);
+            }
+        }
+    }
+}
+
+void PSOLibrary::GetPipelineDesc(ID3D12RootSignature* pRootSignature, EffectPipelineType type, D3D12_GRAPHICS_PIPELINE_STATE_DESC* pDesc)
+{
     D3D12_GRAPHICS_PIPELINE_STATE_DESC baseDesc = {};
     baseDesc.pRootSignature = pRootSignature;
     baseDesc.SampleMask = UINT_MAX;
@@ -211,6 +426,28 @@ void PSOLibrary::CompilePSO(CompilePSOThreadData* pDataPackage)
     baseDesc.HS = g_cEffectShaderData[type].HS;
     baseDesc.GS = g_cEffectShaderData[type].GS;
 
+    *pDesc = baseDesc;
+}
+
+void PSOLibrary::CompilePSO(CompilePSOThreadData* pDataPackage)
+{
+    PSOLibrary* pLibrary = pDataPackage->pLibrary;
+    ID3D12Device* pDevice = pDataPackage->pDevice;
+    ID3D12RootSignature* pRootSignature = pDataPackage->pRootSignature;
+    EffectPipelineType type = pDataPackage->type;
+    bool useCache = false;
+    bool sleepToEmulateComplexCreatePSO = false;
+
+    {
+        auto lock = Mutex::Lock(pLibrary->m_flagsMutex);
+
+        // When using the disk cache compilation should be extremely quick so don't sleep.
+        useCache = pLibrary->m_useDiskLibraries;
+    }
+
+    D3D12_GRAPHICS_PIPELINE_STATE_DESC baseDesc;
+    GetPipelineDesc(pRootSignature, type, &baseDesc);
+
     if (useCache && 
         (pLibrary->m_psoCachingMechanism == PSOCachingMechanism::PipelineLibraries))
     {
@@ -226,7 +463,7 @@ void PSOLibrary::CompilePSO(CompilePSOThreadData* pDataPackage)
             ThrowIfFailed(pDevice->CreateGraphicsPipelineState(&baseDesc, IID_PPV_ARGS(&pLibrary->m_pipelineStates[type])));
 
             // Note: You don't need to pass StorePipeline() a name if the object is already named. If the name parameter is null, it will use the object's name.
-            hr = pPipelineLibrary->StorePipeline(g_cEffectNames[type], pLibrary->m_pipelineStates[type].Get());
+            hr = pLibrary->m_pipelineLibrary.StorePipeline(g_cEffectNames[type], pLibrary->m_pipelineStates[type].Get());
             if (E_INVALIDARG == hr)
             {
                 // A PSO with the specified name already exists in the library.
@@ -311,9 +548,67 @@ void PSOLibrary::CompilePSO(CompilePSOThreadData* pDataPackage)
     }
 }
 
+// Loads every effect the Pipeline Library has an entry for. Loading only fails for effects that were never
+// stored; those are still compiled on first use.
+void PSOLibrary::PrewarmPSOs(CompilePSOThreadData* pDataPackage)
+{
+    PSOLibrary* pLibrary = pDataPackage->pLibrary;
+    ID3D12PipelineLibrary* pPipelineLibrary = pLibrary->m_pipelineLibrary.GetPipelineLibrary();
+
+    for (UINT i = PostBlit; i < EffectPipelineTypeCount; i++)
+    {
+        const EffectPipelineType type = EffectPipelineType(i);
+
+        {
+            auto lock = Mutex::Lock(pLibrary->m_flagsMutex);
+
+            // The effect was used before the pre-warm got to it.
+            if (pLibrary->m_compiledPSOFlags[type] || pLibrary->m_inflightPSOFlags[type])
+            {
+                continue;
+            }
+
+            // Keep SetPipelineState() from compiling it at the same time.
+            pLibrary->m_inflightPSOFlags[type] = true;
+        }
+
+        D3D12_GRAPHICS_PIPELINE_STATE_DESC baseDesc;
+        GetPipelineDesc(pDataPackage->pRootSignature, type, &baseDesc);
+
+        ComPtr<ID3D12PipelineState> pipelineState;
+        const bool loaded = SUCCEEDED(pPipelineLibrary->LoadGraphicsPipeline(g_cEffectNames[type], &baseDesc, IID_PPV_ARGS(&pipelineState)));
+
+        if (loaded)
+        {
+            WCHAR name[50];
+            if (swprintf_s(name, L"m_pipelineStates[%s]", g_cEffectNames[type]) > 0)
+            {
+                SetName(pipelineState.Get(), name);
+            }
+        }
+
+        {
+            auto lock = Mutex::Lock(pLibrary->m_flagsMutex);
+
+            if (loaded)
+            {
+                pLibrary->m_pipelineStates[type] = pipelineState;
+                pLibrary->m_compiledPSOFlags[type] = true;
+            }
+            pLibrary->m_inflightPSOFlags[type] = false;
+        }
+    }
+}
+
 void PSOLibrary::EndFrame()
 {
     m_drawIndex = 0;
+
+    // Save the PSOs stored this frame, so that they survive a crash.
+    if (m_useIncrementalFlush && m_useDiskLibraries && (m_psoCachingMechanism == PSOCachingMechanism::PipelineLibraries))
+    {
+        m_pipelineLibrary.Flush();
+    }
 }
 
 void PSOLibrary::ClearPSOCache()
@@ -355,6 +650,17 @@ void PSOLibrary::ToggleDiskLibrary()
     WaitForThreads();
 }
 
+void PSOLibrary::TogglePrewarm()
+{
+    // Takes effect the next time the library is built.
+    m_usePrewarm = !m_usePrewarm;
+}
+
+void PSOLibrary::ToggleIncrementalFlush()
+{
+    m_useIncrementalFlush = !m_useIncrementalFlush;
+}
+
 void PSOLibrary::SwitchPSOCachingMechanism()
 {
     {
@@ -213,6 +213,18 @@ static const LPWCH g_cEffectNames[EffectPipelineTypeCount] =
 class PSOLibrary
 {
 public:
+    // Compile requests are served highest priority first, then in the order they were made.
+    enum CompilePriority
+    {
+        CompilePriorityLow,     // Speculative, the effect isn't drawn yet.
+        CompilePriorityHigh,    // The effect is being drawn with the uber shader.
+        CompilePriorityCount
+    };
+
+    // Compile latencies are counted in power of two buckets: bucket i holds the
+    // compiles that took less than 2^i ms, the last one holds all slower compiles.
+    static const UINT CompileLatencyBucketCount = 12;
+
     PSOLibrary(UINT frameCount, UINT cbvRootSignatureIndex);
     ~PSOLibrary();
 
@@ -225,19 +237,34 @@ public:
         _In_range_(0, EffectPipelineTypeCount-1) EffectPipelineType type,
         UINT frameIndex);
 
+    void RequestPSO(
+        ID3D12Device* pDevice,
+        ID3D12RootSignature* pRootSignature,
+        _In_range_(0, EffectPipelineTypeCount-1) EffectPipelineType type,
+        CompilePriority priority);
+    bool IsPSOReady(EffectPipelineType type);
+    UINT GetCompileCount();
+    UINT GetCompileLatencyPercentile(float percentile);
+    void GetCompileLatencyHistogram(UINT (&counts)[CompileLatencyBucketCount]);
+
     void EndFrame();
     void ClearPSOCache();
     void ToggleUberShader();
     void ToggleDiskLibrary();
+    void TogglePrewarm();
+    void ToggleIncrementalFlush();
     void SwitchPSOCachingMechanism();
     void DestroyShader(EffectPipelineType type);
 
     bool UberShadersEnabled() { return m_useUberShaders; }
     bool DiskCacheEnabled() { return m_useDiskLibraries; }
+    bool PrewarmEnabled() { return m_usePrewarm; }
+    bool IncrementalFlushEnabled() { return m_useIncrementalFlush; }
     PSOCachingMechanism GetPSOCachingMechanism() { return m_psoCachingMechanism; }
 
 private:
     static const UINT BaseEffectCount = 2;
+    static const UINT MaxCompileThreads = 4;
 
     struct CompilePSOThreadData
     {
@@ -255,7 +282,11 @@ private:
         UINT32 effectIndex;
     };
 
+    static void GetPipelineDesc(ID3D12RootSignature* pRootSignature, EffectPipelineType type, D3D12_GRAPHICS_PIPELINE_STATE_DESC* pDesc);
     static void CompilePSO(CompilePSOThreadData* pDataPackage);
+    static void PrewarmPSOs(CompilePSOThreadData* pDataPackage);
+    static void CompileWorker(PSOLibrary* pLibrary);
+    void RecordCompileLatency(UINT64 requestTime);
     void WaitForThreads();
 
     ComPtr<ID3D12PipelineState> m_pipelineStates[EffectPipelineTypeCount];
@@ -264,10 +295,29 @@ private:
     MemoryMappedPSOCache m_diskCaches[EffectPipelineTypeCount];    // Cached blobs.
     MemoryMappedPipelineLibrary m_pipelineLibrary; // Pipeline Library.
     HANDLE m_flagsMutex;
-    CompilePSOThreadData m_workerThreads[EffectPipelineTypeCount];
+    CompilePSOThreadData m_compileData[EffectPipelineTypeCount];
+    CompilePSOThreadData m_prewarmThread;    // Loads the stored effects from the Pipeline Library at startup.
+
+    // Compile worker pool. Requests are queued per effect, so an effect is never queued twice.
+    HANDLE m_compileThreads[MaxCompileThreads];
+    UINT m_compileThreadCount;
+    HANDLE m_compileRequestSemaphore;    // Signaled once per queued request.
+    HANDLE m_compileIdleEvent;           // Set while no request is queued or compiling.
+    bool m_shutdownCompileThreads;
+    bool m_queuedPSOFlags[EffectPipelineTypeCount];
+    CompilePriority m_requestPriorities[EffectPipelineTypeCount];
+    UINT64 m_requestTimes[EffectPipelineTypeCount];
+    UINT m_pendingCompileCount;
+
+    // Compile latency statistics, from the request to the PSO being ready.
+    UINT64 m_timerFrequency;
+    UINT m_compileLatencyHistogram[CompileLatencyBucketCount];
+    UINT m_compileCount;
 
     bool m_useUberShaders;
     bool m_useDiskLibraries;
+    bool m_usePrewarm;
+    bool m_useIncrementalFlush;
     bool m_pipelineLibrariesSupported;
     PSOCachingMechanism m_psoCachingMechanism;
     std::wstring m_cachePath;
@@ -25,6 +25,8 @@ const wchar_t* D3D12RaytracingHelloWorld::c_missShaderName = L"MyMissShader";
 D3D12RaytracingHelloWorld::D3D12RaytracingHelloWorld(UINT width, UINT height, std::wstring name) :
     DXSample(width, height, name),
     m_raytracingOutputResourceUAVDescriptorHeapIndex(UINT_MAX),
+    m_rayGenShaderRecordStride(0),
+    m_mappedRayGenRootArguments(nullptr),
     m_isDxrSupported(false)
 {
     m_forceComputeFallback = false;
@@ -539,17 +541,29 @@ void D3D12RaytracingHelloWorld::BuildShaderTables()
     }
 
     // Ray gen shader table
+    // The ray gen constants change with the window size, so keep one version of the record per frame context.
+    // Each frame rewrites only its own version, which the GPU is done with, and a resize doesn't need to rebuild the table.
     {
         struct RootArguments {
             RayGenConstantBuffer cb;
         } rootArguments;
         rootArguments.cb = m_rayGenCB;
 
-        UINT numShaderRecords = 1;
-        UINT shaderRecordSize = shaderIdentifierSize + sizeof(rootArguments);
+        UINT numShaderRecords = FrameCount;
+        UINT shaderRecordSize = Align(shaderIdentifierSize + static_cast<UINT>(sizeof(rootArguments)), D3D12_RAYTRACING_SHADER_TABLE_BYTE_ALIGNMENT);
         ShaderTable rayGenShaderTable(device, numShaderRecords, shaderRecordSize, L"RayGenShaderTable");
-        rayGenShaderTable.push_back(ShaderRecord(rayGenShaderIdentifier, shaderIdentifierSize, &rootArguments, sizeof(rootArguments)));
+        for (UINT i = 0; i < numShaderRecords; i++)
+        {
+            rayGenShaderTable.push_back(ShaderRecord(rayGenShaderIdentifier, shaderIdentifierSize, &rootArguments, sizeof(rootArguments)));
+        }
         m_rayGenShaderTable = rayGenShaderTable.GetResource();
+        m_rayGenShaderRecordStride = rayGenShaderTable.GetShaderRecordSize();
+
+        // Keep the table mapped for per-frame updates of the root arguments.
+        uint8_t* mappedShaderRecords;
+        CD3DX12_RANGE readRange(0, 0);        // We do not intend to read from this resource on the CPU.
+        ThrowIfFailed(m_rayGenShaderTable->Map(0, &readRange, reinterpret_cast<void**>(&mappedShaderRecords)));
+        m_mappedRayGenRootArguments = mappedShaderRecords + shaderIdentifierSize;
     }
 
     // Miss shader table
@@ -654,6 +668,11 @@ void D3D12RaytracingHelloWorld::ParseCommandLineArgs(WCHAR* argv[], int argc)
 void D3D12RaytracingHelloWorld::DoRaytracing()
 {
     auto commandList = m_deviceResources->GetCommandList();
+    auto frameIndex = m_deviceResources->GetCurrentFrameIndex();
+
+    // Copy the current ray gen constants into this frame's version of the ray gen shader record.
+    UINT64 rayGenShaderRecordOffset = frameIndex * m_rayGenShaderRecordStride;
+    memcpy(m_mappedRayGenRootArguments + rayGenShaderRecordOffset, &m_rayGenCB, sizeof(m_rayGenCB));
     
     auto DispatchRays = [&](auto* commandList, auto* stateObject, auto* dispatchDesc)
     {
@@ -664,8 +683,8 @@ void D3D12RaytracingHelloWorld::DoRaytracing()
         dispatchDesc->MissShaderTable.StartAddress = m_missShaderTable->GetGPUVirtualAddress();
         dispatchDesc->MissShaderTable.SizeInBytes = m_missShaderTable->GetDesc().Width;
         dispatchDesc->MissShaderTable.StrideInBytes = dispatchDesc->MissShaderTable.SizeInBytes;
-        dispatchDesc->RayGenerationShaderRecord.StartAddress = m_rayGenShaderTable->GetGPUVirtualAddress();
-        dispatchDesc->RayGenerationShaderRecord.SizeInBytes = m_rayGenShaderTable->GetDesc().Width;
+        dispatchDesc->RayGenerationShaderRecord.StartAddress = m_rayGenShaderTable->GetGPUVirtualAddress() + rayGenShaderRecordOffset;
+        dispatchDesc->RayGenerationShaderRecord.SizeInBytes = m_rayGenShaderRecordStride;
         dispatchDesc->Width = m_width;
         dispatchDesc->Height = m_height;
         dispatchDesc->Depth = 1;
@@ -742,17 +761,11 @@ void D3D12RaytracingHelloWorld::CopyRaytracingOutputToBackbuffer()
 void D3D12RaytracingHelloWorld::CreateWindowSizeDependentResources()
 {
     CreateRaytracingOutputResource(); 
-
-    // For simplicity, we will rebuild the shader tables.
-    BuildShaderTables();
 }
 
 // Release resources that are dependent on the size of the main window.
 void D3D12RaytracingHelloWorld::ReleaseWindowSizeDependentResources()
 {
-    m_rayGenShaderTable.Reset();
-    m_missShaderTable.Reset();
-    m_hitGroupShaderTable.Reset();
     m_raytracingOutput.Reset();
 }
 
@@ -774,6 +787,10 @@ void D3D12RaytracingHelloWorld::ReleaseDeviceDependentResources()
     m_raytracingOutputResourceUAVDescriptorHeapIndex = UINT_MAX;
     m_indexBuffer.Reset();
     m_vertexBuffer.Reset();
+    m_rayGenShaderTable.Reset();
+    m_missShaderTable.Reset();
+    m_hitGroupShaderTable.Reset();
+    m_mappedRayGenRootArguments = nullptr;
 
     m_accelerationStructure.Reset();
     m_bottomLevelAccelerationStructure.Reset();
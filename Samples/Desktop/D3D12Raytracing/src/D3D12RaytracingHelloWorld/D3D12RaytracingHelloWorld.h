@@ -111,6 +111,8 @@ private:
     ComPtr<ID3D12Resource> m_missShaderTable;
     ComPtr<ID3D12Resource> m_hitGroupShaderTable;
     ComPtr<ID3D12Resource> m_rayGenShaderTable;
+    UINT m_rayGenShaderRecordStride;
+    uint8_t* m_mappedRayGenRootArguments;
     
     // Application state
     RaytracingAPI m_raytracingAPI;
@@ -84,14 +84,15 @@ namespace DX
         ID3D12Resource*             GetRenderTarget() const { return m_renderTargets[m_backBufferIndex].Get(); }
         ID3D12Resource*             GetDepthStencil() const { return m_depthStencil.Get(); }
         ID3D12CommandQueue*         GetCommandQueue() const { return m_commandQueue.Get(); }
-        ID3D12CommandAllocator*     GetCommandAllocator() const { return m_commandAllocators[m_backBufferIndex].Get(); }
+        ID3D12CommandAllocator*     GetCommandAllocator() const { return m_commandAllocators[m_frameIndex].Get(); }
         ID3D12GraphicsCommandList*  GetCommandList() const { return m_commandList.Get(); }
         DXGI_FORMAT                 GetBackBufferFormat() const { return m_backBufferFormat; }
         DXGI_FORMAT                 GetDepthBufferFormat() const { return m_depthBufferFormat; }
         D3D12_VIEWPORT              GetScreenViewport() const { return m_screenViewport; }
         D3D12_RECT                  GetScissorRect() const { return m_scissorRect; }
-        UINT                        GetCurrentFrameIndex() const { return m_backBufferIndex; }
-        UINT                        GetPreviousFrameIndex() const { return m_backBufferIndex == 0 ? m_backBufferCount - 1 : m_backBufferIndex - 1; }
+        // Index of the frame context being recorded. Per-frame resources indexed by it are not in use by the GPU after Prepare().
+        UINT                        GetCurrentFrameIndex() const { return m_frameIndex; }
+        UINT                        GetPreviousFrameIndex() const { return m_frameIndex == 0 ? m_backBufferCount - 1 : m_frameIndex - 1; }
         UINT                        GetBackBufferCount() const { return m_backBufferCount; }
         unsigned int                GetDeviceOptions() const { return m_options; }
         LPCWSTR                     GetAdapterDescription() const { return m_adapterDescription.c_str(); }
@@ -114,6 +115,7 @@ namespace DX
 
         UINT                                                m_adapterIDoverride;
         UINT                                                m_backBufferIndex;
+        UINT                                                m_frameIndex;
         ComPtr<IDXGIAdapter1>                               m_adapter;
         UINT                                                m_adapterID;
         std::wstring                                        m_adapterDescription;
@@ -131,8 +133,10 @@ namespace DX
         Microsoft::WRL::ComPtr<ID3D12Resource>              m_depthStencil;
 
         // Presentation fence objects.
+        // m_fenceValues holds the value signaled after each frame context's last submission.
         Microsoft::WRL::ComPtr<ID3D12Fence>                 m_fence;
         UINT64                                              m_fenceValues[MAX_BACK_BUFFER_COUNT];
+        UINT64                                              m_nextFenceValue;
         Microsoft::WRL::Wrappers::Event                     m_fenceEvent;
 
         // Direct3D rendering objects.
@@ -266,7 +266,7 @@ void Hit(inout RayPayload payload, in BuiltInTriangleIntersectionAttributes attr
 
     float3 worldPosition = WorldRayOrigin() + WorldRayDirection() * RayTCurrent();
 
-    uint2 threadID = DispatchRaysIndex().xy;
+    uint2 threadID = GetRayPixel();
     float3 ddxOrigin, ddxDir, ddyOrigin, ddyDir;
     GenerateCameraRay(uint2(threadID.x + 1, threadID.y), ddxOrigin, ddxDir);
     GenerateCameraRay(uint2(threadID.x, threadID.y + 1), ddyOrigin, ddyDir);
@@ -295,7 +295,7 @@ void Hit(inout RayPayload payload, in BuiltInTriangleIntersectionAttributes attr
         normal = normalize(mul(normal, tbn));
     }
     
-    float3 outputColor = AmbientColor * diffuseColor * texSSAO[DispatchRaysIndex().xy];
+    float3 outputColor = AmbientColor * diffuseColor * texSSAO[threadID];
 
     float shadow = 1.0;
     if (UseShadowRays)
@@ -335,9 +335,9 @@ void Hit(inout RayPayload payload, in BuiltInTriangleIntersectionAttributes attr
     // TODO: Should be passed in via material info
     if (IsReflection)
     {
-        float reflectivity = normals[DispatchRaysIndex().xy].w;
-        outputColor = g_screenOutput[DispatchRaysIndex().xy].rgb + reflectivity * outputColor;
+        float reflectivity = normals[threadID].w;
+        outputColor = g_screenOutput[threadID].rgb + reflectivity * outputColor;
     }
 
-    g_screenOutput[DispatchRaysIndex().xy] = float4(outputColor, 1);
+    g_screenOutput[threadID] = float4(outputColor, 1);
 }
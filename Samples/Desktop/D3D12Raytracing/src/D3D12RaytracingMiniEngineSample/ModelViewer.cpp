@@ -35,9 +35,13 @@
 #include "ShadowCamera.h"
 #include "ParticleEffectManager.h"
 #include "GameInput.h"
+#include "ReadbackBuffer.h"
+#include "HiZ.h"
+#include "FileUtility.h"
 #include "./ForwardPlusLighting.h"
 #include <atlbase.h>
 #include <atlbase.h>
+#include <fstream>
 
 #include "CompiledShaders/DepthViewerVS.h"
 #include "CompiledShaders/DepthViewerPS.h"
@@ -51,10 +55,16 @@
 #include "CompiledShaders/DiffuseHitShaderLib.h"
 #include "CompiledShaders/RayGenerationShadowsLib.h"
 #include "CompiledShaders/MissShadowsLib.h"
+#include "CompiledShaders/RayBinningCountCS.h"
+#include "CompiledShaders/RayBinningScanCS.h"
+#include "CompiledShaders/RayBinningScatterCS.h"
+#include "CompiledShaders/RayGenerationAdaptiveShadowsLib.h"
+#include "CompiledShaders/AdaptiveShadowsTemporalCS.h"
 
 #include "RaytracingHlslCompat.h"
 #include "ModelViewerRayTracing.h"
 #include "D3D12RaytracingFallback.h"
+#include "D3D12RaytracingCompactionHelpers.hpp"
 
 using namespace GameCore;
 using namespace Math;
@@ -91,7 +101,71 @@ std::vector<CComPtr<ID3D12Resource>>   g_bvh_bottomLevelAccelerationStructures;
 CComPtr<ID3D12Resource>   g_bvh_topLevelAccelerationStructure;
 WRAPPED_GPU_POINTER g_bvh_topLevelAccelerationStructurePointer;
 
+// Bottom levels built at startup are compacted over the next few frames, after which the top level is rebuilt
+typedef CD3D12_ACCELERATION_STRUCTURE_COMPACTOR<ID3D12RaytracingFallbackDevice, ID3D12RaytracingFallbackCommandList> BottomLevelCompactor;
+std::unique_ptr<BottomLevelCompactor> g_pBottomLevelCompactor;
+std::vector<UINT> g_bottomLevelHandles;
+D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_DESC g_topLevelAccelerationStructureDesc;
+std::vector<D3D12_RAYTRACING_FALLBACK_INSTANCE_DESC> g_bvh_instanceDescs;
+ByteAddressBuffer g_bvh_instanceDataBuffer;
+ByteAddressBuffer g_bvh_topLevelScratchBuffer;
+std::wstring g_bottomLevelCacheFile;
+uint64_t g_bottomLevelSceneHash;
+
 DynamicCB           g_dynamicCb;
+
+// Secondary rays are sorted by direction octant and origin Morton code before they are traced, so neighbouring
+// launch indices walk the same parts of the acceleration structure (see Shaders/RayBinningCommon.hlsli)
+struct RayBinningConstants
+{
+    float cameraToWorld[16];
+    XMFLOAT3 worldCameraPosition;
+    UINT32 binReflections;
+    XMFLOAT3 fixedDirection;
+    UINT32 dispatchWidth;
+    XMFLOAT3 sceneMin;
+    UINT32 screenWidth;
+    XMFLOAT3 sceneInvExtent;
+    UINT32 screenHeight;
+};
+static_assert(sizeof(RayBinningConstants) == 32 * sizeof(UINT32), "Must match the root constants in RayBinningCommon.hlsli");
+
+const static UINT c_RayBinCount = 8 << 12;
+
+RootSignature g_RayBinningRootSig;
+ComputePSO g_RayBinningCountPSO;
+ComputePSO g_RayBinningScanPSO;
+ComputePSO g_RayBinningScatterPSO;
+StructuredBuffer g_RayBins;
+StructuredBuffer g_RayBinCounts;
+StructuredBuffer g_RayBinOffsets;
+StructuredBuffer g_BinnedRayPixels;
+Vector3 g_RayBinningSceneMin;
+Vector3 g_RayBinningSceneInvExtent;
+
+// Adaptive shadows trace one ray per 2x2 quad, add rays only in penumbras, and accumulate the result over frames
+// (see RayGenerationAdaptiveShadowsLib.hlsl and Shaders/AdaptiveShadowsTemporalCS.hlsl)
+struct AdaptiveShadowConstants
+{
+    UINT32 pass;
+    UINT32 frameIndex;
+    float sunConeTangent;
+    float penumbraVarianceThreshold;
+    UINT32 penumbraRayCount;
+};
+
+ColorBuffer g_SparseShadows;
+ColorBuffer g_NoisyShadows;
+ColorBuffer g_ShadowHistory[2];
+D3D12_GPU_DESCRIPTOR_HANDLE g_AdaptiveShadowsTable;
+RootSignature g_AdaptiveShadowsTemporalRootSig;
+ComputePSO g_AdaptiveShadowsTemporalPSO;
+uint64_t g_AdaptiveShadowsLastFrame = ~0ull;
+
+// Hybrid reflections resolve rays against the depth buffer first and read the hit from a copy of the lit scene,
+// since the reflection pass writes the scene color while it runs
+ColorBuffer g_ReflectionSourceColor;
+
 CComPtr<ID3D12RootSignature> g_GlobalRaytracingRootSignature;
 CComPtr<ID3D12RootSignature> g_LocalRaytracingRootSignature;
 
@@ -102,6 +176,7 @@ enum RaytracingTypes
     Shadows,
     DiffuseHitShader,
     Reflection,
+    AdaptiveShadows,
     NumTypes
 };
 
@@ -197,6 +272,7 @@ private:
     void RenderObjects( GraphicsContext& Context, const Matrix4& ViewProjMat, eObjectFilter Filter = kAll );
     void RaytraceDiffuse(GraphicsContext& context, const Math::Camera& camera, ColorBuffer& colorTarget);
     void RaytraceShadows(GraphicsContext& context, const Math::Camera& camera, ColorBuffer& colorTarget, DepthBuffer& depth);
+    void RaytraceAdaptiveShadows(GraphicsContext& context, const Math::Camera& camera, ColorBuffer& colorTarget, DepthBuffer& depth);
     void RaytraceReflections(GraphicsContext& context, const Math::Camera& camera, ColorBuffer& colorTarget, DepthBuffer& depth, ColorBuffer& normals);
 
     Camera m_Camera;
@@ -319,6 +395,13 @@ enum RaytracingMode
     RTM_REFLECTIONS,
 };
 EnumVar rayTracingMode("Application/Raytracing/RayTraceMode", RTM_DIFFUSE_WITH_SHADOWMAPS, _countof(rayTracingModes), rayTracingModes);
+BoolVar g_BinSecondaryRays("Application/Raytracing/Bin Secondary Rays", true);
+BoolVar g_AdaptiveShadows("Application/Raytracing/Adaptive Shadows", false);
+NumVar g_SunAngularRadius("Application/Raytracing/Sun Angular Radius", 1.0f, 0.0f, 5.0f, 0.1f);
+NumVar g_PenumbraVarianceThreshold("Application/Raytracing/Penumbra Variance Threshold", 0.05f, 0.0f, 0.25f, 0.01f);
+IntVar g_PenumbraRayCount("Application/Raytracing/Penumbra Rays", 4, 1, 16);
+NumVar g_ShadowTemporalBlend("Application/Raytracing/Shadow Temporal Blend", 0.1f, 0.01f, 1.0f, 0.01f);
+BoolVar g_HybridReflections("Application/Raytracing/Hybrid Reflections", true);
 
 class DescriptorHeapStack
 {
@@ -423,6 +506,66 @@ void InitializeSceneInfo(
     g_SceneMeshInfo = g_hitShaderMeshInfoBuffer.GetSRV();
 }
 
+static
+void InitializeRayBinning(const Model& model)
+{
+    g_RayBinningRootSig.Reset(6, 0);
+    g_RayBinningRootSig[0].InitAsConstants(0, sizeof(RayBinningConstants) / sizeof(UINT32));
+    g_RayBinningRootSig[1].InitAsDescriptorRange(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 0, 2);
+    g_RayBinningRootSig[2].InitAsBufferUAV(0);
+    g_RayBinningRootSig[3].InitAsBufferUAV(1);
+    g_RayBinningRootSig[4].InitAsBufferUAV(2);
+    g_RayBinningRootSig[5].InitAsBufferUAV(3);
+    g_RayBinningRootSig.Finalize(L"Ray Binning");
+
+#define CreatePSO( ObjName, ShaderByteCode ) \
+    ObjName.SetRootSignature(g_RayBinningRootSig); \
+    ObjName.SetComputeShader(ShaderByteCode, sizeof(ShaderByteCode) ); \
+    ObjName.Finalize();
+
+    CreatePSO(g_RayBinningCountPSO, g_pRayBinningCountCS);
+    CreatePSO(g_RayBinningScanPSO, g_pRayBinningScanCS);
+    CreatePSO(g_RayBinningScatterPSO, g_pRayBinningScatterCS);
+
+#undef CreatePSO
+
+    // One entry per pixel of the dispatch, padded to whole 8x8 tiles
+    const uint32_t numPixels = (uint32_t)(AlignUp(g_SceneColorBuffer.GetWidth(), 8) * AlignUp(g_SceneColorBuffer.GetHeight(), 8));
+    g_RayBins.Create(L"Ray Bins", numPixels, sizeof(UINT));
+    g_BinnedRayPixels.Create(L"Binned Ray Pixels", numPixels, sizeof(UINT));
+
+    // The scan pass clears the counts after reading them, so they only need to start at zero
+    std::vector<UINT> zeroes(c_RayBinCount, 0);
+    g_RayBinCounts.Create(L"Ray Bin Counts", c_RayBinCount, sizeof(UINT), zeroes.data());
+    g_RayBinOffsets.Create(L"Ray Bin Offsets", c_RayBinCount, sizeof(UINT));
+
+    const Model::BoundingBox& bounds = model.GetBoundingBox();
+    g_RayBinningSceneMin = bounds.min;
+    g_RayBinningSceneInvExtent = Recip(Max(bounds.max - bounds.min, Vector3(Scalar(1e-3f))));
+}
+
+static
+void InitializeAdaptiveShadows()
+{
+    const uint32_t width = g_SceneColorBuffer.GetWidth();
+    const uint32_t height = g_SceneColorBuffer.GetHeight();
+    g_SparseShadows.Create(L"Sparse Shadows", (width + 1) / 2, (height + 1) / 2, 1, DXGI_FORMAT_R16_FLOAT);
+    g_NoisyShadows.Create(L"Noisy Shadows", width, height, 1, DXGI_FORMAT_R16_FLOAT);
+    g_ShadowHistory[0].Create(L"Shadow History 0", width, height, 1, DXGI_FORMAT_R16_FLOAT);
+    g_ShadowHistory[1].Create(L"Shadow History 1", width, height, 1, DXGI_FORMAT_R16_FLOAT);
+
+    g_AdaptiveShadowsTemporalRootSig.Reset(3, 1);
+    g_AdaptiveShadowsTemporalRootSig[0].InitAsConstants(0, 3);
+    g_AdaptiveShadowsTemporalRootSig[1].InitAsDescriptorRange(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 0, 3);
+    g_AdaptiveShadowsTemporalRootSig[2].InitAsDescriptorRange(D3D12_DESCRIPTOR_RANGE_TYPE_UAV, 0, 2);
+    g_AdaptiveShadowsTemporalRootSig.InitStaticSampler(0, SamplerLinearClampDesc);
+    g_AdaptiveShadowsTemporalRootSig.Finalize(L"Adaptive Shadows Temporal");
+
+    g_AdaptiveShadowsTemporalPSO.SetRootSignature(g_AdaptiveShadowsTemporalRootSig);
+    g_AdaptiveShadowsTemporalPSO.SetComputeShader(g_pAdaptiveShadowsTemporalCS, sizeof(g_pAdaptiveShadowsTemporalCS));
+    g_AdaptiveShadowsTemporalPSO.Finalize();
+}
+
 static
 void InitializeViews(const Model& model)
 {
@@ -443,6 +586,29 @@ void InitializeViews(const Model& model)
         g_pRaytracingDescriptorHeap->AllocateDescriptor(srvHandle, unused);
         Graphics::g_Device->CopyDescriptorsSimple(1, srvHandle, g_SceneNormalBuffer.GetSRV(), D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
 
+        g_pRaytracingDescriptorHeap->AllocateDescriptor(srvHandle, unused);
+        Graphics::g_Device->CopyDescriptorsSimple(1, srvHandle, g_BinnedRayPixels.GetSRV(), D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+
+        g_pRaytracingDescriptorHeap->AllocateDescriptor(srvHandle, unused);
+        Graphics::g_Device->CopyDescriptorsSimple(1, srvHandle, g_HiZMaxDepth.GetSRV(), D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+
+        g_pRaytracingDescriptorHeap->AllocateDescriptor(srvHandle, unused);
+        Graphics::g_Device->CopyDescriptorsSimple(1, srvHandle, g_ReflectionSourceColor.GetSRV(), D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+    }
+
+    {
+        D3D12_CPU_DESCRIPTOR_HANDLE handle;
+        UINT descriptorIndex;
+        g_pRaytracingDescriptorHeap->AllocateDescriptor(handle, descriptorIndex);
+        Graphics::g_Device->CopyDescriptorsSimple(1, handle, g_SparseShadows.GetUAV(), D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+        g_AdaptiveShadowsTable = g_pRaytracingDescriptorHeap->GetGpuHandle(descriptorIndex);
+
+        UINT unused;
+        g_pRaytracingDescriptorHeap->AllocateDescriptor(handle, unused);
+        Graphics::g_Device->CopyDescriptorsSimple(1, handle, g_NoisyShadows.GetUAV(), D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+
+        g_pRaytracingDescriptorHeap->AllocateDescriptor(handle, unused);
+        Graphics::g_Device->CopyDescriptorsSimple(1, handle, g_SparseShadows.GetSRV(), D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
     }
 
     {
@@ -537,7 +703,7 @@ void InitializeRaytracingStateObjects(const Model &model, UINT numMeshes)
 
     D3D12_DESCRIPTOR_RANGE1 srvDescriptorRange = {};
     srvDescriptorRange.BaseShaderRegister = 12;
-    srvDescriptorRange.NumDescriptors = 2;
+    srvDescriptorRange.NumDescriptors = 5;
     srvDescriptorRange.RangeType = D3D12_DESCRIPTOR_RANGE_TYPE_SRV;
     srvDescriptorRange.Flags = D3D12_DESCRIPTOR_RANGE_FLAG_NONE;
 
@@ -547,7 +713,19 @@ void InitializeRaytracingStateObjects(const Model &model, UINT numMeshes)
     uavDescriptorRange.RangeType = D3D12_DESCRIPTOR_RANGE_TYPE_UAV;
     uavDescriptorRange.Flags = D3D12_DESCRIPTOR_RANGE_FLAG_NONE;
 
-    CD3DX12_ROOT_PARAMETER1 globalRootSignatureParameters[8];
+    // Sparse and full resolution results of the adaptive shadow rays, then the sparse results again as an SRV
+    D3D12_DESCRIPTOR_RANGE1 adaptiveShadowsDescriptorRanges[2] = {};
+    adaptiveShadowsDescriptorRanges[0].BaseShaderRegister = 12;
+    adaptiveShadowsDescriptorRanges[0].NumDescriptors = 2;
+    adaptiveShadowsDescriptorRanges[0].RangeType = D3D12_DESCRIPTOR_RANGE_TYPE_UAV;
+    adaptiveShadowsDescriptorRanges[0].Flags = D3D12_DESCRIPTOR_RANGE_FLAG_NONE;
+    adaptiveShadowsDescriptorRanges[1].BaseShaderRegister = 17;
+    adaptiveShadowsDescriptorRanges[1].NumDescriptors = 1;
+    adaptiveShadowsDescriptorRanges[1].RangeType = D3D12_DESCRIPTOR_RANGE_TYPE_SRV;
+    adaptiveShadowsDescriptorRanges[1].Flags = D3D12_DESCRIPTOR_RANGE_FLAG_NONE;
+    adaptiveShadowsDescriptorRanges[1].OffsetInDescriptorsFromTableStart = D3D12_DESCRIPTOR_RANGE_OFFSET_APPEND;
+
+    CD3DX12_ROOT_PARAMETER1 globalRootSignatureParameters[10];
     globalRootSignatureParameters[0].InitAsDescriptorTable(1, &sceneBuffersDescriptorRange);
     globalRootSignatureParameters[1].InitAsConstantBufferView(0);
     globalRootSignatureParameters[2].InitAsConstantBufferView(1);
@@ -556,6 +734,8 @@ void InitializeRaytracingStateObjects(const Model &model, UINT numMeshes)
     globalRootSignatureParameters[5].InitAsUnorderedAccessView(0);
     globalRootSignatureParameters[6].InitAsUnorderedAccessView(1);
     globalRootSignatureParameters[7].InitAsShaderResourceView(0);
+    globalRootSignatureParameters[8].InitAsDescriptorTable(ARRAYSIZE(adaptiveShadowsDescriptorRanges), adaptiveShadowsDescriptorRanges);
+    globalRootSignatureParameters[9].InitAsConstants(sizeof(AdaptiveShadowConstants) / sizeof(UINT32), 2);
     auto globalRootSignatureDesc = CD3DX12_VERSIONED_ROOT_SIGNATURE_DESC(ARRAYSIZE(globalRootSignatureParameters), globalRootSignatureParameters, ARRAYSIZE(staticSamplerDescs), staticSamplerDescs);
 
     CComPtr<ID3DBlob> pGlobalRootSignatureBlob;
@@ -712,6 +892,15 @@ void InitializeRaytracingStateObjects(const Model &model, UINT numMeshes)
         g_RaytracingInputs[Shadows] = RaytracingDispatchRayInputs(*g_pRaytracingDevice, pShadowsPSO, pHitShaderTable.data(), shaderRecordSizeInBytes, (UINT)pHitShaderTable.size(), rayGenShaderExportName, missExportName);
     }
 
+    {
+        rayGenDxilLibSubobject = CreateDxilLibrary(rayGenShaderExportName, g_pRayGenerationAdaptiveShadowsLib, sizeof(g_pRayGenerationAdaptiveShadowsLib), rayGenDxilLibDesc, rayGenExportDesc);
+
+        CComPtr<ID3D12RaytracingFallbackStateObject> pAdaptiveShadowsPSO;
+        g_pRaytracingDevice->CreateStateObject(&stateObject, IID_PPV_ARGS(&pAdaptiveShadowsPSO));
+        GetShaderTable(model, pAdaptiveShadowsPSO, pHitShaderTable.data());
+        g_RaytracingInputs[AdaptiveShadows] = RaytracingDispatchRayInputs(*g_pRaytracingDevice, pAdaptiveShadowsPSO, pHitShaderTable.data(), shaderRecordSizeInBytes, (UINT)pHitShaderTable.size(), rayGenShaderExportName, missExportName);
+    }
+
     {
         rayGenDxilLibSubobject = CreateDxilLibrary(rayGenShaderExportName, g_pRayGenerationShaderLib, sizeof(g_pRayGenerationShaderLib), rayGenDxilLibDesc, rayGenExportDesc);
         hitGroupLibSubobject = CreateDxilLibrary(closestHitExportName, g_pDiffuseHitShaderLib, sizeof(g_pDiffuseHitShaderLib), hitGroupDxilLibDesc, hitGroupExportDesc);
@@ -742,6 +931,274 @@ void InitializeRaytracingStateObjects(const Model &model, UINT numMeshes)
    }
 }
 
+// Building the bottom level dominates startup for large scenes, so it's serialized to disk after the first build
+// and deserialized on later runs.  The cache is keyed on the model's mesh layout and the build flags, and it's
+// skipped whenever the device reports that the serialized data came from a different driver or Fallback Layer
+// version.  Bottom levels hold no pointers, so only the wrapped pointers in the instance descs need recreating.
+struct BottomLevelCacheHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint64_t sceneHash;
+    uint32_t numBottomLevels;
+    uint32_t padding[3];
+};
+enum { kBottomLevelCacheMagic = 0x53414c42 /* "BLAS" */ };
+enum { kBottomLevelCacheVersion = 1 };
+
+// Serialized bottom levels are padded so each one stays aligned for SIMDMemCopy when uploaded
+static const size_t c_BottomLevelCacheAlignment = 16;
+
+uint64_t HashBottomLevelInputs(const Model &model, D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAGS buildFlags)
+{
+    // FNV-1a.  The vertex data itself is released once it's uploaded, so edited geometry is caught by the mesh
+    // sizes and bounds instead.
+    uint64_t hash = 14695981039346656037ull;
+    auto HashBytes = [&hash](const void *pData, size_t size)
+    {
+        const unsigned char *pBytes = (const unsigned char *)pData;
+        for (size_t i = 0; i < size; i++)
+        {
+            hash = (hash ^ pBytes[i]) * 1099511628211ull;
+        }
+    };
+
+    HashBytes(&buildFlags, sizeof(buildFlags));
+    HashBytes(&model.m_Header.meshCount, sizeof(model.m_Header.meshCount));
+    HashBytes(&model.m_Header.vertexDataByteSize, sizeof(model.m_Header.vertexDataByteSize));
+    HashBytes(&model.m_Header.indexDataByteSize, sizeof(model.m_Header.indexDataByteSize));
+    for (UINT i = 0; i < model.m_Header.meshCount; i++)
+    {
+        const Model::Mesh &mesh = model.m_pMesh[i];
+        const float bounds[] =
+        {
+            mesh.boundingBox.min.GetX(), mesh.boundingBox.min.GetY(), mesh.boundingBox.min.GetZ(),
+            mesh.boundingBox.max.GetX(), mesh.boundingBox.max.GetY(), mesh.boundingBox.max.GetZ()
+        };
+        HashBytes(bounds, sizeof(bounds));
+        HashBytes(&mesh.attrib[Model::attrib_position], sizeof(mesh.attrib[Model::attrib_position]));
+        HashBytes(&mesh.vertexStride, sizeof(mesh.vertexStride));
+        HashBytes(&mesh.vertexDataByteOffset, sizeof(mesh.vertexDataByteOffset));
+        HashBytes(&mesh.vertexCount, sizeof(mesh.vertexCount));
+        HashBytes(&mesh.indexDataByteOffset, sizeof(mesh.indexDataByteOffset));
+        HashBytes(&mesh.indexCount, sizeof(mesh.indexCount));
+    }
+    return hash;
+}
+
+bool LoadBottomLevelCache(
+    const std::wstring &fileName,
+    uint64_t sceneHash,
+    UINT numBottomLevels,
+    std::vector<CComPtr<ID3D12Resource>> &bottomLevels)
+{
+    Utility::ByteArray file = Utility::ReadFileSync(fileName);
+    if (file->size() < sizeof(BottomLevelCacheHeader))
+        return false;
+
+    const BottomLevelCacheHeader &header = *(const BottomLevelCacheHeader *)file->data();
+    if (header.magic != kBottomLevelCacheMagic || header.version != kBottomLevelCacheVersion ||
+        header.sceneHash != sceneHash || header.numBottomLevels != numBottomLevels)
+    {
+        return false;
+    }
+
+    // Validate every entry before creating any resources
+    std::vector<const D3D12_SERIALIZED_RAYTRACING_ACCELERATION_STRUCTURE_HEADER *> serializedHeaders(numBottomLevels);
+    size_t offset = sizeof(BottomLevelCacheHeader);
+    for (UINT i = 0; i < numBottomLevels; i++)
+    {
+        if (file->size() - offset < sizeof(D3D12_SERIALIZED_RAYTRACING_ACCELERATION_STRUCTURE_HEADER))
+            return false;
+
+        auto pSerializedHeader = (const D3D12_SERIALIZED_RAYTRACING_ACCELERATION_STRUCTURE_HEADER *)(file->data() + offset);
+        const size_t entrySize = AlignUp((size_t)pSerializedHeader->SerializedSizeInBytesIncludingHeader, c_BottomLevelCacheAlignment);
+        if (entrySize > file->size() - offset ||
+            g_pRaytracingDevice->CheckDriverMatchingIdentifier(
+                D3D12_SERIALIZED_DATA_RAYTRACING_ACCELERATION_STRUCTURE,
+                &pSerializedHeader->DriverMatchingIdentifier) != D3D12_DRIVER_MATCHING_IDENTIFIER_COMPATIBLE_WITH_DEVICE)
+        {
+            return false;
+        }
+
+        serializedHeaders[i] = pSerializedHeader;
+        offset += entrySize;
+    }
+
+    D3D12_HEAP_PROPERTIES defaultHeapDesc = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT);
+    std::vector<std::unique_ptr<ByteAddressBuffer>> serializedBuffers(numBottomLevels);
+    bottomLevels.resize(numBottomLevels);
+    for (UINT i = 0; i < numBottomLevels; i++)
+    {
+        const uint32_t entrySize = (uint32_t)AlignUp(serializedHeaders[i]->SerializedSizeInBytesIncludingHeader, c_BottomLevelCacheAlignment);
+        serializedBuffers[i].reset(new ByteAddressBuffer);
+        serializedBuffers[i]->Create(L"Serialized Bottom Level Acceleration Structure", entrySize / sizeof(uint32_t), sizeof(uint32_t), serializedHeaders[i]);
+
+        auto bottomLevelDesc = CD3DX12_RESOURCE_DESC::Buffer(serializedHeaders[i]->DeserializedSizeInBytes, D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
+        g_Device->CreateCommittedResource(
+            &defaultHeapDesc,
+            D3D12_HEAP_FLAG_NONE,
+            &bottomLevelDesc,
+            g_pRaytracingDevice->GetAccelerationStructureResourceState(),
+            nullptr,
+            IID_PPV_ARGS(&bottomLevels[i]));
+    }
+
+    GraphicsContext& gfxContext = GraphicsContext::Begin(L"Load Acceleration Structure Cache");
+
+    CComPtr<ID3D12RaytracingFallbackCommandList> pRaytracingCommandList;
+    g_pRaytracingDevice->QueryRaytracingCommandList(gfxContext.GetCommandList(), IID_PPV_ARGS(&pRaytracingCommandList));
+
+    // The Fallback Layer reads the serialized data through a UAV while drivers read it as a shader resource
+    const D3D12_RESOURCE_STATES serializedState = g_pRaytracingDevice->UsingRaytracingDriver() ?
+        D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE : D3D12_RESOURCE_STATE_UNORDERED_ACCESS;
+    for (UINT i = 0; i < numBottomLevels; i++)
+    {
+        gfxContext.TransitionResource(*serializedBuffers[i], serializedState);
+    }
+    gfxContext.FlushResourceBarriers();
+
+    for (UINT i = 0; i < numBottomLevels; i++)
+    {
+        pRaytracingCommandList->CopyRaytracingAccelerationStructure(
+            bottomLevels[i]->GetGPUVirtualAddress(),
+            serializedBuffers[i]->GetGpuVirtualAddress(),
+            D3D12_RAYTRACING_ACCELERATION_STRUCTURE_COPY_MODE_DESERIALIZE);
+    }
+
+    gfxContext.Finish(true);
+    return true;
+}
+
+void SaveBottomLevelCache(
+    const std::wstring &fileName,
+    uint64_t sceneHash,
+    const std::vector<D3D12_GPU_VIRTUAL_ADDRESS> &bottomLevelAddresses)
+{
+    const UINT numBottomLevels = (UINT)bottomLevelAddresses.size();
+
+    typedef D3D12_RAYTRACING_ACCELERATION_STRUCTURE_POSTBUILD_INFO_SERIALIZATION_DESC SerializationDesc;
+    ByteAddressBuffer serializationInfo;
+    serializationInfo.Create(L"Acceleration Structure Serialization Info", numBottomLevels, sizeof(SerializationDesc));
+    ReadbackBuffer serializationInfoReadback;
+    serializationInfoReadback.Create(L"Acceleration Structure Serialization Info Readback", numBottomLevels, sizeof(SerializationDesc));
+
+    // Ask how large each bottom level is once serialized
+    {
+        GraphicsContext& gfxContext = GraphicsContext::Begin(L"Query Acceleration Structure Serialization Info");
+
+        CComPtr<ID3D12RaytracingFallbackCommandList> pRaytracingCommandList;
+        g_pRaytracingDevice->QueryRaytracingCommandList(gfxContext.GetCommandList(), IID_PPV_ARGS(&pRaytracingCommandList));
+
+        gfxContext.TransitionResource(serializationInfo, D3D12_RESOURCE_STATE_UNORDERED_ACCESS, true);
+
+        D3D12_RAYTRACING_ACCELERATION_STRUCTURE_POSTBUILD_INFO_DESC postbuildInfoDesc = {};
+        postbuildInfoDesc.DestBuffer = serializationInfo.GetGpuVirtualAddress();
+        postbuildInfoDesc.InfoType = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_POSTBUILD_INFO_SERIALIZATION;
+        pRaytracingCommandList->EmitRaytracingAccelerationStructurePostbuildInfo(&postbuildInfoDesc, numBottomLevels, bottomLevelAddresses.data());
+
+        gfxContext.CopyBuffer(serializationInfoReadback, serializationInfo);
+        gfxContext.Finish(true);
+    }
+
+    std::vector<std::unique_ptr<ByteAddressBuffer>> serializedBuffers(numBottomLevels);
+    std::vector<std::unique_ptr<ReadbackBuffer>> serializedReadbacks(numBottomLevels);
+    const SerializationDesc *pSerializationInfo = (const SerializationDesc *)serializationInfoReadback.Map();
+    for (UINT i = 0; i < numBottomLevels; i++)
+    {
+        const uint32_t entrySize = (uint32_t)AlignUp(pSerializationInfo[i].SerializedSizeInBytes, c_BottomLevelCacheAlignment);
+        serializedBuffers[i].reset(new ByteAddressBuffer);
+        serializedBuffers[i]->Create(L"Serialized Bottom Level Acceleration Structure", entrySize / sizeof(uint32_t), sizeof(uint32_t));
+        serializedReadbacks[i].reset(new ReadbackBuffer);
+        serializedReadbacks[i]->Create(L"Serialized Bottom Level Acceleration Structure Readback", entrySize / sizeof(uint32_t), sizeof(uint32_t));
+    }
+    serializationInfoReadback.Unmap();
+
+    {
+        GraphicsContext& gfxContext = GraphicsContext::Begin(L"Serialize Acceleration Structures");
+
+        CComPtr<ID3D12RaytracingFallbackCommandList> pRaytracingCommandList;
+        g_pRaytracingDevice->QueryRaytracingCommandList(gfxContext.GetCommandList(), IID_PPV_ARGS(&pRaytracingCommandList));
+
+        for (UINT i = 0; i < numBottomLevels; i++)
+        {
+            gfxContext.TransitionResource(*serializedBuffers[i], D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+        }
+        gfxContext.FlushResourceBarriers();
+
+        for (UINT i = 0; i < numBottomLevels; i++)
+        {
+            pRaytracingCommandList->CopyRaytracingAccelerationStructure(
+                serializedBuffers[i]->GetGpuVirtualAddress(),
+                bottomLevelAddresses[i],
+                D3D12_RAYTRACING_ACCELERATION_STRUCTURE_COPY_MODE_SERIALIZE);
+        }
+
+        for (UINT i = 0; i < numBottomLevels; i++)
+        {
+            gfxContext.CopyBuffer(*serializedReadbacks[i], *serializedBuffers[i]);
+        }
+        gfxContext.Finish(true);
+    }
+
+    std::ofstream OutFile(fileName, std::ios::out | std::ios::binary);
+    if (!OutFile.is_open())
+        return;
+
+    BottomLevelCacheHeader header = {};
+    header.magic = kBottomLevelCacheMagic;
+    header.version = kBottomLevelCacheVersion;
+    header.sceneHash = sceneHash;
+    header.numBottomLevels = numBottomLevels;
+    OutFile.write((const char *)&header, sizeof(header));
+
+    for (UINT i = 0; i < numBottomLevels; i++)
+    {
+        // Padding past the serialized size is written too, matching the alignment the loader expects
+        const void *pSerialized = serializedReadbacks[i]->Map();
+        OutFile.write((const char *)pSerialized, serializedReadbacks[i]->GetBufferSize());
+        serializedReadbacks[i]->Unmap();
+    }
+    OutFile.close();
+}
+
+// Points the instances at wherever the bottom levels currently live and rebuilds the top level over them.
+// Compaction moves the bottom levels, so this runs again every time the compactor reports that they moved.
+void BuildTopLevelAccelerationStructure(GraphicsContext &gfxContext, ID3D12RaytracingFallbackCommandList *pRaytracingCommandList)
+{
+    for (UINT i = 0; i < (UINT)g_bvh_instanceDescs.size(); i++)
+    {
+        ID3D12Resource *pBottomLevel = g_bvh_bottomLevelAccelerationStructures[i];
+        UINT64 offsetInBytes = 0;
+        if (g_pBottomLevelCompactor)
+        {
+            pBottomLevel = g_pBottomLevelCompactor->GetResource(g_bottomLevelHandles[i]);
+            offsetInBytes = g_pBottomLevelCompactor->GetOffsetInBytes(g_bottomLevelHandles[i]);
+        }
+
+        // Compacted bottom levels share pooled buffers, so the compute fallback needs the offset into the UAV
+        WRAPPED_GPU_POINTER &bottomLevelPointer = g_bvh_instanceDescs[i].AccelerationStructure;
+        if (g_pRaytracingDevice->UsingRaytracingDriver())
+        {
+            bottomLevelPointer = g_pRaytracingDevice->GetWrappedPointerFromGpuVA(pBottomLevel->GetGPUVirtualAddress() + offsetInBytes);
+        }
+        else
+        {
+            bottomLevelPointer = g_pRaytracingDevice->GetWrappedPointerFromDescriptorHeapIndex(
+                g_pRaytracingDescriptorHeap->AllocateBufferUav(*pBottomLevel), (UINT32)offsetInBytes);
+        }
+    }
+
+    gfxContext.WriteBuffer(g_bvh_instanceDataBuffer, 0, g_bvh_instanceDescs.data(),
+        g_bvh_instanceDescs.size() * sizeof(D3D12_RAYTRACING_FALLBACK_INSTANCE_DESC));
+    gfxContext.TransitionResource(g_bvh_instanceDataBuffer, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, true);
+
+    pRaytracingCommandList->BuildRaytracingAccelerationStructure(&g_topLevelAccelerationStructureDesc, 0, nullptr);
+
+    auto uavBarrier = CD3DX12_RESOURCE_BARRIER::UAV(g_bvh_topLevelAccelerationStructure);
+    gfxContext.GetCommandList()->ResourceBarrier(1, &uavBarrier);
+}
+
 void D3D12RaytracingMiniEngineSample::Startup( void )
 {
     D3D12CreateRaytracingFallbackDevice(g_Device, CreateRaytracingFallbackDeviceFlags::None, 0, IID_PPV_ARGS(&g_pRaytracingDevice));
@@ -875,6 +1332,9 @@ void D3D12RaytracingMiniEngineSample::Startup( void )
     g_hitConstantBuffer.Create(L"Hit Constant Buffer", 1, sizeof(HitShaderConstants));
     g_dynamicConstantBuffer.Create(L"Dynamic Constant Buffer", 1, sizeof(DynamicCB));
 
+    InitializeRayBinning(m_Model);
+    InitializeAdaptiveShadows();
+    g_ReflectionSourceColor.Create(L"Reflection Source Color", g_SceneColorBuffer.GetWidth(), g_SceneColorBuffer.GetHeight(), 1, g_SceneColorBuffer.GetFormat());
     InitializeSceneInfo(m_Model);
     InitializeViews(m_Model);
     UINT numMeshes = m_Model.m_Header.meshCount;
@@ -882,7 +1342,7 @@ void D3D12RaytracingMiniEngineSample::Startup( void )
     const UINT numBottomLevels = 1;
 
     D3D12_RAYTRACING_ACCELERATION_STRUCTURE_PREBUILD_INFO topLevelPrebuildInfo;
-    D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_DESC topLevelAccelerationStructureDesc = {};
+    D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_DESC &topLevelAccelerationStructureDesc = g_topLevelAccelerationStructureDesc;
     D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS &topLevelInputs = topLevelAccelerationStructureDesc.Inputs;
     topLevelInputs.Type = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_TYPE_TOP_LEVEL;
     topLevelInputs.NumDescs = numBottomLevels;
@@ -893,7 +1353,6 @@ void D3D12RaytracingMiniEngineSample::Startup( void )
     
     const D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAGS buildFlag = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_PREFER_FAST_TRACE;
     std::vector<D3D12_RAYTRACING_GEOMETRY_DESC> geometryDescs(m_Model.m_Header.meshCount);
-    UINT64 scratchBufferSizeNeeded = topLevelPrebuildInfo.ScratchDataSizeInBytes;
     for (UINT i = 0; i < numMeshes; i++)
     {
         auto &mesh = m_Model.m_pMesh[i];
@@ -913,27 +1372,22 @@ void D3D12RaytracingMiniEngineSample::Startup( void )
         trianglesDesc.Transform3x4 = 0;
     }
 
-    std::vector<UINT64> bottomLevelAccelerationStructureSize(numBottomLevels);
-    std::vector<D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_DESC> bottomLevelAccelerationStructureDescs(numBottomLevels);
+    std::vector<D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS> bottomLevelInputs(numBottomLevels);
     for (UINT i = 0; i < numBottomLevels; i++)
     {
-        D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_DESC &bottomLevelAccelerationStructureDesc = bottomLevelAccelerationStructureDescs[i];
-        D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS &bottomLevelInputs = bottomLevelAccelerationStructureDesc.Inputs;
-        bottomLevelInputs.Type = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL;
-        bottomLevelInputs.NumDescs = numMeshes;
-        bottomLevelInputs.pGeometryDescs = &geometryDescs[i];
-        bottomLevelInputs.Flags = buildFlag;
-        bottomLevelInputs.DescsLayout = D3D12_ELEMENTS_LAYOUT_ARRAY;
-
-        D3D12_RAYTRACING_ACCELERATION_STRUCTURE_PREBUILD_INFO bottomLevelprebuildInfo;
-        g_pRaytracingDevice->GetRaytracingAccelerationStructurePrebuildInfo(&bottomLevelInputs, &bottomLevelprebuildInfo);
-
-        bottomLevelAccelerationStructureSize[i] = bottomLevelprebuildInfo.ResultDataMaxSizeInBytes;
-        scratchBufferSizeNeeded = std::max(bottomLevelprebuildInfo.ScratchDataSizeInBytes, scratchBufferSizeNeeded);
+        bottomLevelInputs[i].Type = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL;
+        bottomLevelInputs[i].NumDescs = numMeshes;
+        bottomLevelInputs[i].pGeometryDescs = &geometryDescs[i];
+        bottomLevelInputs[i].Flags = buildFlag;
+        bottomLevelInputs[i].DescsLayout = D3D12_ELEMENTS_LAYOUT_ARRAY;
     }
 
-    ByteAddressBuffer scratchBuffer;
-    scratchBuffer.Create(L"Acceleration Structure Scratch Buffer", (UINT)scratchBufferSizeNeeded, 1);
+    g_bottomLevelCacheFile = ASSET_DIRECTORY L"Models/sponza.blascache";
+    g_bottomLevelSceneHash = HashBottomLevelInputs(m_Model, buildFlag);
+    const bool bBottomLevelsFromCache = LoadBottomLevelCache(g_bottomLevelCacheFile, g_bottomLevelSceneHash, numBottomLevels, g_bvh_bottomLevelAccelerationStructures);
+
+    // The compactor owns the bottom levels' build and scratch memory, so only the top level needs scratch here
+    g_bvh_topLevelScratchBuffer.Create(L"Top Level Acceleration Structure Scratch Buffer", (UINT)topLevelPrebuildInfo.ScratchDataSizeInBytes, 1);
 
     D3D12_HEAP_PROPERTIES defaultHeapDesc = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT);
     auto topLevelDesc = CD3DX12_RESOURCE_DESC::Buffer(topLevelPrebuildInfo.ResultDataMaxSizeInBytes, D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
@@ -946,28 +1400,22 @@ void D3D12RaytracingMiniEngineSample::Startup( void )
         IID_PPV_ARGS(&g_bvh_topLevelAccelerationStructure));
 
     topLevelAccelerationStructureDesc.DestAccelerationStructureData = g_bvh_topLevelAccelerationStructure->GetGPUVirtualAddress();
-    topLevelAccelerationStructureDesc.ScratchAccelerationStructureData = scratchBuffer.GetGpuVirtualAddress();
+    topLevelAccelerationStructureDesc.ScratchAccelerationStructureData = g_bvh_topLevelScratchBuffer.GetGpuVirtualAddress();
 
-    std::vector<D3D12_RAYTRACING_FALLBACK_INSTANCE_DESC> instanceDescs(numBottomLevels);
-    g_bvh_bottomLevelAccelerationStructures.resize(numBottomLevels);
-    for (UINT i = 0; i < bottomLevelAccelerationStructureDescs.size(); i++)
+    if (!bBottomLevelsFromCache)
     {
-        auto &bottomLevelStructure = g_bvh_bottomLevelAccelerationStructures[i];
-
-        auto bottomLevelDesc = CD3DX12_RESOURCE_DESC::Buffer(bottomLevelAccelerationStructureSize[i], D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
-        g_Device->CreateCommittedResource(
-            &defaultHeapDesc,
-            D3D12_HEAP_FLAG_NONE, 
-            &bottomLevelDesc, 
-            g_pRaytracingDevice->GetAccelerationStructureResourceState(),
-            nullptr, 
-            IID_PPV_ARGS(&bottomLevelStructure));
-
-        bottomLevelAccelerationStructureDescs[i].DestAccelerationStructureData = bottomLevelStructure->GetGPUVirtualAddress();
-        bottomLevelAccelerationStructureDescs[i].ScratchAccelerationStructureData = scratchBuffer.GetGpuVirtualAddress();
+        g_pBottomLevelCompactor.reset(new BottomLevelCompactor(
+            g_Device, g_pRaytracingDevice, g_pRaytracingDevice->GetAccelerationStructureResourceState()));
+        for (UINT i = 0; i < numBottomLevels; i++)
+        {
+            g_bottomLevelHandles.push_back(g_pBottomLevelCompactor->AddBottomLevel(bottomLevelInputs[i]));
+        }
+    }
 
-        D3D12_RAYTRACING_FALLBACK_INSTANCE_DESC &instanceDesc = instanceDescs[i];
-        UINT descriptorIndex = g_pRaytracingDescriptorHeap->AllocateBufferUav(*bottomLevelStructure);
+    g_bvh_instanceDescs.resize(numBottomLevels);
+    for (UINT i = 0; i < numBottomLevels; i++)
+    {
+        D3D12_RAYTRACING_FALLBACK_INSTANCE_DESC &instanceDesc = g_bvh_instanceDescs[i];
         
         // Identity matrix
         ZeroMemory(instanceDesc.Transform, sizeof(instanceDesc.Transform));
@@ -975,17 +1423,15 @@ void D3D12RaytracingMiniEngineSample::Startup( void )
         instanceDesc.Transform[1][1] = 1.0f;
         instanceDesc.Transform[2][2] = 1.0f;
         
-        instanceDesc.AccelerationStructure = g_pRaytracingDevice->GetWrappedPointerSimple(descriptorIndex, g_bvh_bottomLevelAccelerationStructures[i]->GetGPUVirtualAddress());
         instanceDesc.Flags = 0;
         instanceDesc.InstanceID = 0;
         instanceDesc.InstanceMask = 1;
         instanceDesc.InstanceContributionToHitGroupIndex = i;
     }
 
-    ByteAddressBuffer instanceDataBuffer;
-    instanceDataBuffer.Create(L"Instance Data Buffer", numBottomLevels, sizeof(D3D12_RAYTRACING_FALLBACK_INSTANCE_DESC), instanceDescs.data());
+    g_bvh_instanceDataBuffer.Create(L"Instance Data Buffer", numBottomLevels, sizeof(D3D12_RAYTRACING_FALLBACK_INSTANCE_DESC));
 
-    topLevelInputs.InstanceDescs = instanceDataBuffer.GetGpuVirtualAddress();
+    topLevelInputs.InstanceDescs = g_bvh_instanceDataBuffer.GetGpuVirtualAddress();
     topLevelInputs.DescsLayout = D3D12_ELEMENTS_LAYOUT_ARRAY;
 
     GraphicsContext& gfxContext = GraphicsContext::Begin(L"Create Acceleration Structure");
@@ -997,14 +1443,12 @@ void D3D12RaytracingMiniEngineSample::Startup( void )
     ID3D12DescriptorHeap *descriptorHeaps[] = { &g_pRaytracingDescriptorHeap->GetDescriptorHeap() };
     pRaytracingCommandList->SetDescriptorHeaps(ARRAYSIZE(descriptorHeaps), descriptorHeaps);
 
-    auto uavBarrier = CD3DX12_RESOURCE_BARRIER::UAV(nullptr);
-    for (UINT i = 0; i < bottomLevelAccelerationStructureDescs.size(); i++)
+    if (g_pBottomLevelCompactor)
     {
-        pRaytracingCommandList->BuildRaytracingAccelerationStructure(&bottomLevelAccelerationStructureDescs[i], 0, nullptr);
+        g_pBottomLevelCompactor->BuildPending(pCommandList, pRaytracingCommandList);
     }
-    pCommandList->ResourceBarrier(1, &uavBarrier);
 
-    pRaytracingCommandList->BuildRaytracingAccelerationStructure(&topLevelAccelerationStructureDesc, 0, nullptr);
+    BuildTopLevelAccelerationStructure(gfxContext, pRaytracingCommandList);
     
     g_bvh_topLevelAccelerationStructurePointer = g_pRaytracingDevice->GetWrappedPointerSimple(
         g_pRaytracingDescriptorHeap->AllocateBufferUav(*g_bvh_topLevelAccelerationStructure),
@@ -1012,6 +1456,11 @@ void D3D12RaytracingMiniEngineSample::Startup( void )
 
     gfxContext.Finish(true);
 
+    if (g_pBottomLevelCompactor)
+    {
+        g_pBottomLevelCompactor->Signal(g_CommandManager.GetCommandQueue());
+    }
+
     InitializeRaytracingStateObjects(m_Model, numMeshes);
 
     float modelRadius = Length(m_Model.m_Header.boundingBox.max - m_Model.m_Header.boundingBox.min) * .5f;
@@ -1120,6 +1569,37 @@ void D3D12RaytracingMiniEngineSample::Update( float deltaT )
         m_CameraController->Update(deltaT);
     }
 
+    // Compact the startup bottom levels once their sizes are back, then cache the compacted versions on disk
+    if (g_pBottomLevelCompactor && !g_pBottomLevelCompactor->IsIdle())
+    {
+        GraphicsContext& gfxContext = GraphicsContext::Begin(L"Compact Acceleration Structures");
+        CComPtr<ID3D12RaytracingFallbackCommandList> pRaytracingCommandList;
+        g_pRaytracingDevice->QueryRaytracingCommandList(gfxContext.GetCommandList(), IID_PPV_ARGS(&pRaytracingCommandList));
+
+        ID3D12DescriptorHeap *descriptorHeaps[] = { &g_pRaytracingDescriptorHeap->GetDescriptorHeap() };
+        pRaytracingCommandList->SetDescriptorHeaps(ARRAYSIZE(descriptorHeaps), descriptorHeaps);
+
+        if (g_pBottomLevelCompactor->Update(gfxContext.GetCommandList(), pRaytracingCommandList))
+        {
+            BuildTopLevelAccelerationStructure(gfxContext, pRaytracingCommandList);
+        }
+        gfxContext.Finish();
+        g_pBottomLevelCompactor->Signal(g_CommandManager.GetCommandQueue());
+
+        if (g_pBottomLevelCompactor->IsIdle())
+        {
+            Utility::Printf("Compacted bottom level acceleration structures from %llu to %llu bytes\n",
+                g_pBottomLevelCompactor->GetBuiltSizeInBytes(), g_pBottomLevelCompactor->GetCompactedSizeInBytes());
+
+            std::vector<D3D12_GPU_VIRTUAL_ADDRESS> bottomLevelAddresses;
+            for (UINT handle : g_bottomLevelHandles)
+            {
+                bottomLevelAddresses.push_back(g_pBottomLevelCompactor->GetGpuVirtualAddress(handle));
+            }
+            SaveBottomLevelCache(g_bottomLevelCacheFile, g_bottomLevelSceneHash, bottomLevelAddresses);
+        }
+    }
+
     m_ViewProjMatrix = m_Camera.GetViewProjMatrix();
 
     float costheta = cosf(m_SunOrientation);
@@ -1488,6 +1968,84 @@ void Raytracebarycentrics(
     pRaytracingCommandList->DispatchRays(&dispatchRaysDesc);
 }
 
+// Binned dispatches are padded to whole 8x8 tiles of the sorted pixels
+UINT GetRayDispatchWidth(const DynamicCB& inputs)
+{
+    return inputs.binRays ? (UINT)AlignUp((UINT)inputs.resolution.x, 8) : (UINT)inputs.resolution.x;
+}
+
+UINT GetRayDispatchHeight(const DynamicCB& inputs)
+{
+    return inputs.binRays ? (UINT)AlignUp((UINT)inputs.resolution.y, 8) : (UINT)inputs.resolution.y;
+}
+
+// Sorts the rays of the next dispatch into g_BinnedRayPixels.  Reflection rays are rebuilt from the depth and
+// normal buffers, otherwise every ray points along pFixedDirection.  Returns false when binning is disabled, in
+// which case the dispatch should trace in launch order.
+bool BinSecondaryRays(ComputeContext& ctx, const DynamicCB& inputs, const Vector3* pFixedDirection)
+{
+    const UINT screenWidth = (UINT)inputs.resolution.x;
+    const UINT screenHeight = (UINT)inputs.resolution.y;
+    const UINT dispatchWidth = (UINT)AlignUp(screenWidth, 8);
+    const UINT dispatchHeight = (UINT)AlignUp(screenHeight, 8);
+    if (!g_BinSecondaryRays || dispatchWidth * dispatchHeight > g_BinnedRayPixels.GetElementCount())
+        return false;
+
+    ScopedTimer _p0(L"Bin Rays", ctx);
+
+    RayBinningConstants constants = {};
+    memcpy(constants.cameraToWorld, &inputs.cameraToWorld, sizeof(constants.cameraToWorld));
+    memcpy(&constants.worldCameraPosition, &inputs.worldCameraPosition, sizeof(constants.worldCameraPosition));
+    constants.binReflections = pFixedDirection == nullptr;
+    if (pFixedDirection != nullptr)
+        XMStoreFloat3(&constants.fixedDirection, *pFixedDirection);
+    constants.dispatchWidth = dispatchWidth;
+    XMStoreFloat3(&constants.sceneMin, g_RayBinningSceneMin);
+    constants.screenWidth = screenWidth;
+    XMStoreFloat3(&constants.sceneInvExtent, g_RayBinningSceneInvExtent);
+    constants.screenHeight = screenHeight;
+
+    ctx.TransitionResource(g_SceneDepthBuffer, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+    ctx.TransitionResource(g_SceneNormalBuffer, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+    ctx.TransitionResource(g_RayBins, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+    ctx.TransitionResource(g_RayBinCounts, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+    ctx.TransitionResource(g_RayBinOffsets, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+    ctx.TransitionResource(g_BinnedRayPixels, D3D12_RESOURCE_STATE_UNORDERED_ACCESS, true);
+
+    // The raytracing passes bind through the raw command list, which leaves the context's cached root
+    // signature and heaps stale, so the binning passes are bound the same way
+    ID3D12GraphicsCommandList *pCommandList = ctx.GetCommandList();
+
+    CComPtr<ID3D12RaytracingFallbackCommandList> pRaytracingCommandList;
+    g_pRaytracingDevice->QueryRaytracingCommandList(pCommandList, IID_PPV_ARGS(&pRaytracingCommandList));
+
+    ID3D12DescriptorHeap *pDescriptorHeaps[] = { &g_pRaytracingDescriptorHeap->GetDescriptorHeap() };
+    pRaytracingCommandList->SetDescriptorHeaps(ARRAYSIZE(pDescriptorHeaps), pDescriptorHeaps);
+
+    pCommandList->SetComputeRootSignature(g_RayBinningRootSig.GetSignature());
+    pCommandList->SetComputeRoot32BitConstants(0, sizeof(constants) / sizeof(UINT32), &constants, 0);
+    pCommandList->SetComputeRootDescriptorTable(1, g_DepthAndNormalsTable);
+    pCommandList->SetComputeRootUnorderedAccessView(2, g_RayBins.GetGpuVirtualAddress());
+    pCommandList->SetComputeRootUnorderedAccessView(3, g_RayBinCounts.GetGpuVirtualAddress());
+    pCommandList->SetComputeRootUnorderedAccessView(4, g_RayBinOffsets.GetGpuVirtualAddress());
+    pCommandList->SetComputeRootUnorderedAccessView(5, g_BinnedRayPixels.GetGpuVirtualAddress());
+
+    pCommandList->SetPipelineState(g_RayBinningCountPSO.GetPipelineStateObject());
+    pCommandList->Dispatch(dispatchWidth / 8, dispatchHeight / 8, 1);
+    ctx.InsertUAVBarrier(g_RayBins);
+    ctx.InsertUAVBarrier(g_RayBinCounts, true);
+
+    pCommandList->SetPipelineState(g_RayBinningScanPSO.GetPipelineStateObject());
+    pCommandList->Dispatch(1, 1, 1);
+    ctx.InsertUAVBarrier(g_RayBinOffsets, true);
+
+    pCommandList->SetPipelineState(g_RayBinningScatterPSO.GetPipelineStateObject());
+    pCommandList->Dispatch(dispatchWidth / 8, dispatchHeight / 8, 1);
+    ctx.TransitionResource(g_BinnedRayPixels, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, true);
+
+    return true;
+}
+
 void RaytracebarycentricsSSR(
     CommandContext& context,
     const Math::Camera& camera,
@@ -1512,6 +2070,8 @@ void RaytracebarycentricsSSR(
     ComputeContext& ctx = context.GetComputeContext();
     ID3D12GraphicsCommandList *pCommandList = context.GetCommandList();
 
+    inputs.binRays = BinSecondaryRays(ctx, inputs, nullptr);
+
     ctx.WriteBuffer(g_dynamicConstantBuffer, 0, &inputs, sizeof(inputs));
     ctx.TransitionResource(g_dynamicConstantBuffer, D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER);
     ctx.TransitionResource(g_hitConstantBuffer, D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER);
@@ -1534,7 +2094,8 @@ void RaytracebarycentricsSSR(
     pCommandList->SetComputeRootDescriptorTable(3, g_DepthAndNormalsTable);
     pRaytracingCommandList->SetTopLevelAccelerationStructure(7, g_bvh_topLevelAccelerationStructurePointer);
 
-    D3D12_DISPATCH_RAYS_DESC dispatchRaysDesc = g_RaytracingInputs[Reflectionbarycentric].GetDispatchRayDesc(colorTarget.GetWidth(), colorTarget.GetHeight());
+    D3D12_DISPATCH_RAYS_DESC dispatchRaysDesc = g_RaytracingInputs[Reflectionbarycentric].GetDispatchRayDesc(
+        GetRayDispatchWidth(inputs), GetRayDispatchHeight(inputs));
     pRaytracingCommandList->SetPipelineState1(g_RaytracingInputs[Reflectionbarycentric].m_pPSO);
     pRaytracingCommandList->DispatchRays(&dispatchRaysDesc);
 }
@@ -1568,6 +2129,8 @@ void D3D12RaytracingMiniEngineSample::RaytraceShadows(
     ComputeContext& ctx = context.GetComputeContext();
     ID3D12GraphicsCommandList *pCommandList = context.GetCommandList();
 
+    inputs.binRays = BinSecondaryRays(ctx, inputs, &hitShaderConstants.sunDirection);
+
     ctx.WriteBuffer(g_dynamicConstantBuffer, 0, &inputs, sizeof(inputs));
     ctx.TransitionResource(g_dynamicConstantBuffer, D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER);
     ctx.TransitionResource(g_SceneNormalBuffer, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
@@ -1591,11 +2154,114 @@ void D3D12RaytracingMiniEngineSample::RaytraceShadows(
     pCommandList->SetComputeRootDescriptorTable(3, g_DepthAndNormalsTable);
     pRaytracingCommandList->SetTopLevelAccelerationStructure(7, g_bvh_topLevelAccelerationStructurePointer);
 
-    D3D12_DISPATCH_RAYS_DESC dispatchRaysDesc = g_RaytracingInputs[Shadows].GetDispatchRayDesc(colorTarget.GetWidth(), colorTarget.GetHeight());
+    D3D12_DISPATCH_RAYS_DESC dispatchRaysDesc = g_RaytracingInputs[Shadows].GetDispatchRayDesc(
+        GetRayDispatchWidth(inputs), GetRayDispatchHeight(inputs));
     pRaytracingCommandList->SetPipelineState1(g_RaytracingInputs[Shadows].m_pPSO);
     pRaytracingCommandList->DispatchRays(&dispatchRaysDesc);
 }
 
+void D3D12RaytracingMiniEngineSample::RaytraceAdaptiveShadows(
+    GraphicsContext& context,
+    const Math::Camera& camera,
+    ColorBuffer& colorTarget,
+    DepthBuffer& depth)
+{
+    ScopedTimer _p0(L"Raytracing Adaptive Shadows", context);
+
+    DynamicCB inputs = g_dynamicCb;
+    auto m0 = camera.GetViewProjMatrix();
+    auto m1 = Transpose(Invert(m0));
+    memcpy(&inputs.cameraToWorld, &m1, sizeof(inputs.cameraToWorld));
+    memcpy(&inputs.worldCameraPosition, &camera.GetPosition(), sizeof(inputs.worldCameraPosition));
+    inputs.resolution.x = (float)colorTarget.GetWidth();
+    inputs.resolution.y = (float)colorTarget.GetHeight();
+
+    // The sparse pass launches one ray per quad, so its launch indices can't be remapped through the binned pixels
+    inputs.binRays = false;
+
+    HitShaderConstants hitShaderConstants = {};
+    hitShaderConstants.sunDirection = m_SunDirection;
+    hitShaderConstants.sunLight = Vector3(1.0f, 1.0f, 1.0f) * m_SunLightIntensity;
+    hitShaderConstants.ambientLight = Vector3(1.0f, 1.0f, 1.0f) * m_AmbientIntensity;
+    hitShaderConstants.ShadowTexelSize[0] = 1.0f / g_ShadowBuffer.GetWidth();
+    hitShaderConstants.modelToShadow = m_SunShadow.GetShadowMatrix();
+    hitShaderConstants.IsReflection = false;
+    hitShaderConstants.UseShadowRays = false;
+    context.WriteBuffer(g_hitConstantBuffer, 0, &hitShaderConstants, sizeof(hitShaderConstants));
+
+    ComputeContext& ctx = context.GetComputeContext();
+    ID3D12GraphicsCommandList *pCommandList = context.GetCommandList();
+
+    ctx.WriteBuffer(g_dynamicConstantBuffer, 0, &inputs, sizeof(inputs));
+    ctx.TransitionResource(g_dynamicConstantBuffer, D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER);
+    ctx.TransitionResource(g_hitConstantBuffer, D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER);
+    ctx.TransitionResource(depth, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+    ctx.TransitionResource(g_SparseShadows, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+    ctx.TransitionResource(g_NoisyShadows, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+    ctx.TransitionResource(colorTarget, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+    ctx.FlushResourceBarriers();
+
+    CComPtr<ID3D12RaytracingFallbackCommandList> pRaytracingCommandList;
+    g_pRaytracingDevice->QueryRaytracingCommandList(pCommandList, IID_PPV_ARGS(&pRaytracingCommandList));
+
+    ID3D12DescriptorHeap *pDescriptorHeaps[] = { &g_pRaytracingDescriptorHeap->GetDescriptorHeap() };
+    pRaytracingCommandList->SetDescriptorHeaps(ARRAYSIZE(pDescriptorHeaps), pDescriptorHeaps);
+
+    pCommandList->SetComputeRootSignature(g_GlobalRaytracingRootSignature);
+    pCommandList->SetComputeRootConstantBufferView(1, g_hitConstantBuffer.GetGpuVirtualAddress());
+    pCommandList->SetComputeRootConstantBufferView(2, g_dynamicConstantBuffer.GetGpuVirtualAddress());
+    pCommandList->SetComputeRootDescriptorTable(4, g_OutputUAV);
+    pCommandList->SetComputeRootDescriptorTable(3, g_DepthAndNormalsTable);
+    pCommandList->SetComputeRootDescriptorTable(8, g_AdaptiveShadowsTable);
+    pRaytracingCommandList->SetTopLevelAccelerationStructure(7, g_bvh_topLevelAccelerationStructurePointer);
+    pRaytracingCommandList->SetPipelineState1(g_RaytracingInputs[AdaptiveShadows].m_pPSO);
+
+    AdaptiveShadowConstants constants;
+    constants.pass = 0;
+    constants.frameIndex = (UINT32)Graphics::GetFrameCount();
+    constants.sunConeTangent = tanf(g_SunAngularRadius * XM_PI / 180.0f);
+    constants.penumbraVarianceThreshold = g_PenumbraVarianceThreshold;
+    constants.penumbraRayCount = (UINT32)g_PenumbraRayCount;
+    pCommandList->SetComputeRoot32BitConstants(9, sizeof(constants) / sizeof(UINT32), &constants, 0);
+
+    D3D12_DISPATCH_RAYS_DESC dispatchRaysDesc = g_RaytracingInputs[AdaptiveShadows].GetDispatchRayDesc(
+        g_SparseShadows.GetWidth(), g_SparseShadows.GetHeight());
+    pRaytracingCommandList->DispatchRays(&dispatchRaysDesc);
+
+    ctx.TransitionResource(g_SparseShadows, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, true);
+
+    constants.pass = 1;
+    pCommandList->SetComputeRoot32BitConstants(9, sizeof(constants) / sizeof(UINT32), &constants, 0);
+
+    dispatchRaysDesc = g_RaytracingInputs[AdaptiveShadows].GetDispatchRayDesc(colorTarget.GetWidth(), colorTarget.GetHeight());
+    pRaytracingCommandList->DispatchRays(&dispatchRaysDesc);
+
+    // Blend with the reprojected history.  It's only valid when the previous frame also traced adaptive shadows.
+    const uint64_t frameCount = Graphics::GetFrameCount();
+    const float temporalBlend = g_AdaptiveShadowsLastFrame + 1 == frameCount ? (float)g_ShadowTemporalBlend : 1.0f;
+    g_AdaptiveShadowsLastFrame = frameCount;
+
+    ColorBuffer& prevHistory = g_ShadowHistory[TemporalEffects::GetFrameIndexMod2() ^ 1];
+    ColorBuffer& outHistory = g_ShadowHistory[TemporalEffects::GetFrameIndexMod2()];
+
+    ctx.TransitionResource(g_NoisyShadows, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+    ctx.TransitionResource(g_VelocityBuffer, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+    ctx.TransitionResource(prevHistory, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+    ctx.TransitionResource(outHistory, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+
+    // Ray tracing bound its own descriptor heap and root signature underneath the context
+    ctx.SetDescriptorHeap(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, nullptr);
+    ctx.SetRootSignature(g_AdaptiveShadowsTemporalRootSig);
+    ctx.SetPipelineState(g_AdaptiveShadowsTemporalPSO);
+    ctx.SetConstants(0, 1.0f / colorTarget.GetWidth(), 1.0f / colorTarget.GetHeight(), temporalBlend);
+
+    D3D12_CPU_DESCRIPTOR_HANDLE srvs[] = { g_NoisyShadows.GetSRV(), g_VelocityBuffer.GetSRV(), prevHistory.GetSRV() };
+    D3D12_CPU_DESCRIPTOR_HANDLE uavs[] = { outHistory.GetUAV(), colorTarget.GetUAV() };
+    ctx.SetDynamicDescriptors(1, 0, ARRAYSIZE(srvs), srvs);
+    ctx.SetDynamicDescriptors(2, 0, ARRAYSIZE(uavs), uavs);
+    ctx.Dispatch2D(colorTarget.GetWidth(), colorTarget.GetHeight());
+}
+
 void D3D12RaytracingMiniEngineSample::RaytraceDiffuse(
     GraphicsContext& context,
     const Math::Camera& camera,
@@ -1677,6 +2343,19 @@ void D3D12RaytracingMiniEngineSample::RaytraceReflections(
     hitShaderConstants.IsReflection = true;
     hitShaderConstants.UseShadowRays = false;
     context.WriteBuffer(g_hitConstantBuffer, 0, &hitShaderConstants, sizeof(hitShaderConstants));
+
+    if (g_HybridReflections)
+    {
+        HiZ::Build(context.GetComputeContext(), depth, camera);
+        context.CopyBuffer(g_ReflectionSourceColor, colorTarget);
+        context.TransitionResource(g_ReflectionSourceColor, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+
+        auto m2 = Transpose(m0);
+        memcpy(&inputs.worldToClip, &m2, sizeof(inputs.worldToClip));
+        inputs.hybridReflections = true;
+    }
+
+    inputs.binRays = BinSecondaryRays(context.GetComputeContext(), inputs, nullptr);
     context.WriteBuffer(g_dynamicConstantBuffer, 0, &inputs, sizeof(inputs));
 
     context.TransitionResource(g_dynamicConstantBuffer, D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER);
@@ -1704,7 +2383,8 @@ void D3D12RaytracingMiniEngineSample::RaytraceReflections(
     pCommandList->SetComputeRootDescriptorTable(4, g_OutputUAV);
     pRaytracingCommandList->SetTopLevelAccelerationStructure(7, g_bvh_topLevelAccelerationStructurePointer);
 
-    D3D12_DISPATCH_RAYS_DESC dispatchRaysDesc = g_RaytracingInputs[Reflection].GetDispatchRayDesc(colorTarget.GetWidth(), colorTarget.GetHeight());
+    D3D12_DISPATCH_RAYS_DESC dispatchRaysDesc = g_RaytracingInputs[Reflection].GetDispatchRayDesc(
+        GetRayDispatchWidth(inputs), GetRayDispatchHeight(inputs));
     pRaytracingCommandList->SetPipelineState1(g_RaytracingInputs[Reflection].m_pPSO);
     pRaytracingCommandList->DispatchRays(&dispatchRaysDesc);
 }
@@ -1746,7 +2426,10 @@ void D3D12RaytracingMiniEngineSample::Raytrace(class GraphicsContext& gfxContext
         break;
 
     case RTM_SHADOWS:
-        RaytraceShadows(gfxContext, m_Camera, g_SceneColorBuffer, g_SceneDepthBuffer);
+        if (g_AdaptiveShadows)
+            RaytraceAdaptiveShadows(gfxContext, m_Camera, g_SceneColorBuffer, g_SceneDepthBuffer);
+        else
+            RaytraceShadows(gfxContext, m_Camera, g_SceneColorBuffer, g_SceneDepthBuffer);
         break;
 
     case RTM_DIFFUSE_WITH_SHADOWMAPS:
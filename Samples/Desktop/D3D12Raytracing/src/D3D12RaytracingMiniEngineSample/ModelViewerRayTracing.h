@@ -20,8 +20,11 @@ struct DynamicCB
 {
     float4x4 cameraToWorld;
     float3   worldCameraPosition;
-    uint     padding;
+    uint     binRays;          // Launch indices are remapped through g_binnedRayPixels
     float2   resolution;
+    uint     hybridReflections; // Reflection rays march the Hi-Z pyramid before falling back to TraceRay
+    uint     padding;
+    float4x4 worldToClip;
 };
 #ifdef HLSL
 #ifndef SINGLE
@@ -48,6 +51,24 @@ cbuffer b1 : register(b1)
     DynamicCB g_dynamic;
 };
 
+// Pixels sorted by ray bin, packed as x | y << 16 (see Shaders/RayBinningCommon.hlsli)
+StructuredBuffer<uint> g_binnedRayPixels : register(t14);
+
+// Returns the pixel this launch traces.  When the rays were binned, each 8x8 tile of launch indices reads a
+// contiguous run of the sorted pixels, so a wave traces rays from the same few bins.  The dispatch is padded
+// to whole tiles and the padding reads pixels outside the screen, which callers must skip.
+inline uint2 GetRayPixel()
+{
+    uint2 launchIndex = DispatchRaysIndex().xy;
+    if (!g_dynamic.binRays)
+        return launchIndex;
+
+    uint tilesPerRow = ((uint)g_dynamic.resolution.x + 7) / 8;
+    uint tileIndex = (launchIndex.y / 8) * tilesPerRow + launchIndex.x / 8;
+    uint packedPixel = g_binnedRayPixels[tileIndex * 64 + (launchIndex.y % 8) * 8 + launchIndex.x % 8];
+    return uint2(packedPixel & 0xFFFF, packedPixel >> 16);
+}
+
 inline void GenerateCameraRay(uint2 index, out float3 origin, out float3 direction)
 {
     float2 xy = index + 0.5; // center in the middle of the pixel
@@ -0,0 +1,161 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+//
+// Adaptive shadow rays.  The sparse pass traces one ray per 2x2 quad at half resolution, moving to another pixel
+// of the quad every frame.  The penumbra pass then runs at full resolution and measures the variance of the sparse
+// results around each pixel.  Where they disagree the pixel is in a penumbra and traces extra rays, everywhere
+// else it reuses the sparse results.  Shaders/AdaptiveShadowsTemporalCS.hlsl accumulates the result over frames.
+//
+
+#define HLSL
+#include "ModelViewerRaytracing.h"
+
+Texture2D<float>    depth    : register(t12);
+Texture2D<float>    g_sparseShadowsInput : register(t17);
+
+RWTexture2D<float>  g_sparseShadows : register(u12);
+RWTexture2D<float>  g_noisyShadows : register(u13);
+
+cbuffer AdaptiveShadowConstants : register(b2)
+{
+    uint AdaptiveShadowPass;        // 0 = sparse, 1 = penumbra
+    uint FrameIndex;
+    float SunConeTangent;           // Tangent of the angular radius of the sun
+    float PenumbraVarianceThreshold;
+    uint PenumbraRayCount;
+}
+
+uint HashUint(uint x)
+{
+    x ^= x >> 16;
+    x *= 0x7feb352d;
+    x ^= x >> 15;
+    x *= 0x846ca68b;
+    x ^= x >> 16;
+    return x;
+}
+
+float HashToFloat(uint x)
+{
+    return (HashUint(x) >> 8) * (1.0 / 16777216.0);
+}
+
+float3 GetWorldPosition(uint2 pixel)
+{
+    float2 xy = pixel + 0.5;
+    float2 screenPos = xy / g_dynamic.resolution * 2.0 - 1.0;
+    screenPos.y = -screenPos.y;
+
+    float sceneDepth = depth.Load(int3(pixel, 0));
+    float4 unprojected = mul(g_dynamic.cameraToWorld, float4(screenPos, sceneDepth, 1));
+    return unprojected.xyz / unprojected.w;
+}
+
+// Returns 1 when a ray toward a random point on the sun's disk escapes the scene
+float TraceShadowRay(float3 origin, uint seed)
+{
+    float3 tangent = normalize(cross(SunDirection, abs(SunDirection.y) < 0.99 ? float3(0, 1, 0) : float3(1, 0, 0)));
+    float3 bitangent = cross(SunDirection, tangent);
+
+    float radius = SunConeTangent * sqrt(HashToFloat(seed));
+    float angle = 6.28318530718 * HashToFloat(seed ^ 0x9e3779b9);
+    float3 direction = normalize(SunDirection + radius * (cos(angle) * tangent + sin(angle) * bitangent));
+
+    RayDesc rayDesc = { origin,
+        0.1f,
+        direction,
+        FLT_MAX };
+
+    // The hit and miss shaders leave the screen alone, the visibility is written once per pixel below
+    RayPayload payload = { true, FLT_MAX };
+    TraceRay(g_accel, RAY_FLAG_ACCEPT_FIRST_HIT_AND_END_SEARCH, ~0,0,1,0, rayDesc, payload);
+
+    return payload.RayHitT < FLT_MAX ? 0.0 : 1.0;
+}
+
+uint GetPixelSeed(uint2 pixel, uint ray)
+{
+    return HashUint(pixel.x | pixel.y << 16) ^ HashUint(FrameIndex * 16 + ray);
+}
+
+// The pixel of each 2x2 quad that the sparse pass traces this frame.  Every pixel is covered once per 4 frames.
+uint2 GetSparsePixel(uint2 quad)
+{
+    static const uint2 kQuadOffsets[4] = { uint2(0, 0), uint2(1, 1), uint2(1, 0), uint2(0, 1) };
+    uint2 pixel = quad * 2 + kQuadOffsets[FrameIndex % 4];
+    return any(pixel >= (uint2)g_dynamic.resolution) ? quad * 2 : pixel;
+}
+
+void SparsePass(uint2 quad)
+{
+    uint2 pixel = GetSparsePixel(quad);
+    g_sparseShadows[quad] = TraceShadowRay(GetWorldPosition(pixel), GetPixelSeed(pixel, 0));
+}
+
+void PenumbraPass(uint2 pixel)
+{
+    uint2 quad = pixel / 2;
+    uint2 sparseSize = ((uint2)g_dynamic.resolution + 1) / 2;
+
+    float sum = 0.0;
+    float sumOfSquares = 0.0;
+    [unroll]
+    for (int y = -1; y <= 1; ++y)
+    {
+        [unroll]
+        for (int x = -1; x <= 1; ++x)
+        {
+            int2 neighbor = clamp((int2)quad + int2(x, y), 0, (int2)sparseSize - 1);
+            float visibility = g_sparseShadowsInput[neighbor];
+            sum += visibility;
+            sumOfSquares += visibility * visibility;
+        }
+    }
+
+    float mean = sum / 9.0;
+    float variance = sumOfSquares / 9.0 - mean * mean;
+
+    if (variance <= PenumbraVarianceThreshold)
+    {
+        g_noisyShadows[pixel] = mean;
+        return;
+    }
+
+    // The pixel the sparse pass traced already has one of its rays
+    bool hasSparseRay = all(GetSparsePixel(quad) == pixel);
+    float visibility = hasSparseRay ? g_sparseShadowsInput[quad] : 0.0;
+    uint rayCount = hasSparseRay ? 1 : 0;
+
+    float3 origin = GetWorldPosition(pixel);
+    for (uint ray = 1; ray <= PenumbraRayCount; ++ray)
+        visibility += TraceShadowRay(origin, GetPixelSeed(pixel, ray));
+
+    g_noisyShadows[pixel] = visibility / (rayCount + PenumbraRayCount);
+}
+
+[shader("raygeneration")]
+void RayGen()
+{
+    uint2 launchIndex = DispatchRaysIndex().xy;
+
+    if (AdaptiveShadowPass == 0)
+    {
+        SparsePass(launchIndex);
+    }
+    else
+    {
+        if (any(launchIndex >= (uint2)g_dynamic.resolution))
+            return;
+
+        PenumbraPass(launchIndex);
+    }
+}
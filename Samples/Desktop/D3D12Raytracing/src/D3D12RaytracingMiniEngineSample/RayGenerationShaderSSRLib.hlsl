@@ -14,11 +14,136 @@
 
 Texture2D<float>    depth    : register(t12);
 Texture2D<float4>   normals  : register(t13);
+Texture2D<float>    g_hiZMaxDepth : register(t15);          // Nearest depth of each cell (see MiniEngine/Core/HiZ.h)
+Texture2D<float4>   g_reflectionSourceColor : register(t16);
+
+// Hybrid reflections march the ray through the Hi-Z pyramid in screen space and only call TraceRay when the
+// depth buffer can't resolve it: the ray leaves the screen, passes behind a surface thicker than
+// c_RelativeThickness, or runs out of iterations.  The trace then starts where the march last knew the ray was
+// in front of every visible surface, since nothing can lie along that part of the ray.
+static const uint c_MaxHiZIterations = 64;
+static const float c_RelativeThickness = 0.02;  // Of the distance from the camera to the surface behind the ray
+
+float3 ProjectToScreen(float3 world)
+{
+    float4 clip = mul(g_dynamic.worldToClip, float4(world, 1));
+    float3 ndc = clip.xyz / clip.w;
+    return float3((ndc.xy * float2(0.5, -0.5) + 0.5) * g_dynamic.resolution, ndc.z);
+}
+
+float3 UnprojectFromScreen(float3 screen)
+{
+    float2 screenPos = screen.xy / g_dynamic.resolution * 2.0 - 1.0;
+    screenPos.y = -screenPos.y;
+    float4 unprojected = mul(g_dynamic.cameraToWorld, float4(screenPos, screen.z, 1));
+    return unprojected.xyz / unprojected.w;
+}
+
+// Where the ray start + delta * s leaves the square cell of cellSize pixels containing pos
+float GetCellExit(float3 start, float2 invDelta, float2 crossStep, float2 crossOffset, float3 pos, float cellSize)
+{
+    float2 cell = floor(pos.xy / cellSize);
+    float2 exit = ((cell + crossStep) * cellSize + crossOffset - start.xy) * invDelta;
+    return min(exit.x, exit.y);
+}
+
+// Positions are in pixels with device depth, which is reversed so nearer surfaces have larger depths.  Returns
+// true with the pixel the ray hits when the depth buffer resolves it.  Otherwise freeDistance is how far along the
+// ray it is known not to hit anything.
+bool MarchHiZ(float3 origin, float3 direction, out uint2 hitPixel, out float freeDistance)
+{
+    hitPixel = 0;
+    freeDistance = 0.0;
+
+    // Keep the end of the ray in front of the camera.  Screen space is only linear in front of it.
+    float4 clipOrigin = mul(g_dynamic.worldToClip, float4(origin, 1));
+    float dw = mul(g_dynamic.worldToClip, float4(direction, 0)).w;
+    float rayLength = dw < 0.0 ? 0.5 * clipOrigin.w / -dw : 1e6;
+
+    float3 start = ProjectToScreen(origin);
+    float3 delta = ProjectToScreen(origin + direction * rayLength) - start;
+    float2 invDelta = 1.0 / (abs(delta.xy) < 1e-6 ? 1e-6 : delta.xy);
+    float2 crossStep = delta.xy >= 0.0 ? 1.0 : 0.0;
+    float2 crossOffset = delta.xy >= 0.0 ? 1e-3 : -1e-3;
+
+    uint mip0Width, mip0Height, mipCount;
+    g_hiZMaxDepth.GetDimensions(0, mip0Width, mip0Height, mipCount);
+
+    // Leave the starting pixel first, so the ray can't hit the surface it starts on
+    float s = GetCellExit(start, invDelta, crossStep, crossOffset, start, 1.0);
+    float freeS = 0.0;
+    uint level = 0;
+    bool resolved = false;
+
+    for (uint i = 0; i < c_MaxHiZIterations && s < 1.0; ++i)
+    {
+        float3 pos = start + delta * s;
+        if (any(pos.xy < 0.0) || any(pos.xy >= g_dynamic.resolution))
+            break;
+
+        // Mip 0 of the pyramid is half resolution
+        float cellSize = (float)(2u << level);
+        float cellExit = GetCellExit(start, invDelta, crossStep, crossOffset, pos, cellSize);
+        float nearestDepth = g_hiZMaxDepth.Load(int3(pos.xy / cellSize, level));
+
+        // Where the ray passes behind the nearest surface of the cell
+        float crossing = pos.z > nearestDepth ? (delta.z < 0.0 ? (nearestDepth - start.z) / delta.z : 1.0) : s;
+        if (crossing >= cellExit)
+        {
+            // In front of everything in the cell, so skip it and try a coarser level
+            s = cellExit;
+            freeS = s;
+            level = min(level + 1, mipCount - 1);
+            continue;
+        }
+
+        s = max(s, crossing);
+        freeS = s;
+        if (level > 0)
+        {
+            --level;
+            continue;
+        }
+
+        // Resolve against the full resolution depth
+        pos = start + delta * s;
+        float sceneDepth = depth.Load(int3(pos.xy, 0));
+        if (pos.z > sceneDepth)
+        {
+            s = GetCellExit(start, invDelta, crossStep, crossOffset, pos, 1.0);
+            continue;
+        }
+
+        float3 camera = g_dynamic.worldCameraPosition;
+        float surfaceDistance = distance(UnprojectFromScreen(float3(pos.xy, sceneDepth)), camera);
+        float rayDistance = distance(UnprojectFromScreen(pos), camera);
+        if (rayDistance - surfaceDistance <= c_RelativeThickness * surfaceDistance)
+        {
+            hitPixel = (uint2)pos.xy;
+            resolved = true;
+        }
+
+        // Otherwise the ray is occluded and the trace will find what it hits behind the surface
+        break;
+    }
+
+    if (!resolved && freeS > 0.0)
+    {
+        float3 freePosition = UnprojectFromScreen(start + delta * min(freeS, 1.0));
+        float t = dot(freePosition - origin, direction);
+        freeDistance = isfinite(t) ? max(0.9 * t, 0.0) : 0.0;
+    }
+
+    return resolved;
+}
 
 [shader("raygeneration")]
 void RayGen()
 {
-    uint2 DTid = DispatchRaysIndex().xy;
+    uint2 DTid = GetRayPixel();
+    if (any(DTid >= (uint2)g_dynamic.resolution))
+        return;
+
     float2 xy = DTid.xy + 0.5;
 
     // Screen position for the ray
@@ -55,8 +180,21 @@ void RayGen()
     float3 direction = normalize(-primaryRayDirection - 2 * dot(-primaryRayDirection, normal) * normal);
     float3 origin = world - primaryRayDirection * 0.1f;     // Lift off the surface a bit
 
+    float tMin = 0.0f;
+    if (g_dynamic.hybridReflections)
+    {
+        uint2 hitPixel;
+        if (MarchHiZ(origin, direction, hitPixel, tMin))
+        {
+            // Shade the same way the hit shader does for reflections, from the rasterized scene
+            float reflectivity = normalData.w;
+            g_screenOutput[DTid] = float4(g_screenOutput[DTid].rgb + reflectivity * g_reflectionSourceColor[hitPixel].rgb, 1);
+            return;
+        }
+    }
+
     RayDesc rayDesc = { origin,
-        0.0f,
+        tMin,
         direction,
         FLT_MAX };
 
@@ -17,7 +17,10 @@ Texture2D<float>    depth    : register(t12);
 [shader("raygeneration")]
 void RayGen()
 {
-    uint2 DTid = DispatchRaysIndex().xy;
+    uint2 DTid = GetRayPixel();
+    if (any(DTid >= (uint2)g_dynamic.resolution))
+        return;
+
     float2 xy = DTid.xy + 0.5;
 
     // Screen position for the ray
@@ -51,11 +54,11 @@ void RayGen()
 
     if (payload.RayHitT < FLT_MAX)
     {
-        g_screenOutput[DispatchRaysIndex().xy] = float4(0, 0, 0, 1);
+        g_screenOutput[DTid] = float4(0, 0, 0, 1);
     }
     else
     {
-        g_screenOutput[DispatchRaysIndex().xy] = float4(1, 1, 1, 1);
+        g_screenOutput[DTid] = float4(1, 1, 1, 1);
     }
 }
 
@@ -0,0 +1,76 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+
+#include "PixelPacking_Velocity.hlsli"
+
+#define AdaptiveShadowsTemporal_RootSig \
+    "RootFlags(0), " \
+    "RootConstants(b0, num32BitConstants = 3), " \
+    "DescriptorTable(SRV(t0, numDescriptors = 3))," \
+    "DescriptorTable(UAV(u0, numDescriptors = 2))," \
+    "StaticSampler(s0," \
+        "addressU = TEXTURE_ADDRESS_CLAMP," \
+        "addressV = TEXTURE_ADDRESS_CLAMP," \
+        "addressW = TEXTURE_ADDRESS_CLAMP," \
+        "filter = FILTER_MIN_MAG_MIP_LINEAR)"
+
+Texture2D<float> NoisyShadows : register(t0);
+Texture2D<packed_velocity_t> VelocityBuffer : register(t1);
+Texture2D<float> PrevHistory : register(t2);
+RWTexture2D<float> OutHistory : register(u0);
+RWTexture2D<float4> OutColor : register(u1);
+SamplerState LinearSampler : register(s0);
+
+cbuffer CB0 : register(b0)
+{
+    float2 RcpBufferDim;
+    float TemporalBlendFactor;  // Weight of the current frame, 1 when there is no history
+}
+
+// Blends this frame's adaptive shadow rays with the previous frames', reprojected with the same camera velocity
+// that TemporalEffects uses.  The history is clamped to the current neighborhood so it can't lag behind moving
+// shadows or leak across disocclusions.
+[RootSignature(AdaptiveShadowsTemporal_RootSig)]
+[numthreads(8, 8, 1)]
+void main(uint3 DTid : SV_DispatchThreadID)
+{
+    uint2 ST = DTid.xy;
+    float2 uv = (ST + 0.5) * RcpBufferDim;
+    if (any(uv >= 1.0))
+        return;
+
+    float current = NoisyShadows[ST];
+    float neighborhoodMin = current;
+    float neighborhoodMax = current;
+    [unroll]
+    for (int y = -1; y <= 1; ++y)
+    {
+        [unroll]
+        for (int x = -1; x <= 1; ++x)
+        {
+            float neighbor = NoisyShadows.SampleLevel(LinearSampler, uv + float2(x, y) * RcpBufferDim, 0);
+            neighborhoodMin = min(neighborhoodMin, neighbor);
+            neighborhoodMax = max(neighborhoodMax, neighbor);
+        }
+    }
+
+    float3 Velocity = UnpackVelocity(VelocityBuffer[ST]);
+    float2 prevUV = (ST + 0.5 + Velocity.xy) * RcpBufferDim;
+
+    float blendFactor = TemporalBlendFactor;
+    float history = current;
+    if (any(prevUV != saturate(prevUV)))
+        blendFactor = 1.0;
+    else
+        history = clamp(PrevHistory.SampleLevel(LinearSampler, prevUV, 0), neighborhoodMin, neighborhoodMax);
+
+    float visibility = lerp(history, current, blendFactor);
+    OutHistory[ST] = visibility;
+    OutColor[ST] = float4(visibility, visibility, visibility, 1);
+}
@@ -0,0 +1,74 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+// Sorts the secondary rays of a frame into bins so that neighbouring launch indices trace similar rays.  A
+// bin is the ray's direction octant followed by the high bits of the Morton code of its origin within the
+// scene bounds.  The raygen shaders read the pixel they should trace from BinnedRayPixels.
+//
+
+#define RAY_BINNING_MORTON_BITS 12
+#define RAY_BINNING_BIN_COUNT (8 << RAY_BINNING_MORTON_BITS)
+#define RAY_BINNING_INVALID_BIN (RAY_BINNING_BIN_COUNT - 1)
+
+// The bin counts are scanned by a single group, each thread owning a contiguous run of bins
+#define RAY_BINNING_SCAN_THREADS 1024
+#define RAY_BINNING_BINS_PER_THREAD (RAY_BINNING_BIN_COUNT / RAY_BINNING_SCAN_THREADS)
+
+#define RayBinning_RootSig \
+    "RootFlags(0), " \
+    "RootConstants(b0, num32BitConstants = 32), " \
+    "DescriptorTable(SRV(t0, numDescriptors = 2))," \
+    "UAV(u0), " \
+    "UAV(u1), " \
+    "UAV(u2), " \
+    "UAV(u3)"
+
+cbuffer CSConstants : register(b0)
+{
+    row_major float4x4 CameraToWorld;
+    float3 WorldCameraPosition;
+    uint BinReflections;        // Otherwise every ray points along FixedDirection
+    float3 FixedDirection;
+    uint DispatchWidth;         // Screen width rounded up to a whole 8x8 tile
+    float3 SceneMin;
+    uint ScreenWidth;
+    float3 SceneInvExtent;
+    uint ScreenHeight;
+};
+
+Texture2D<float> depth : register(t0);
+Texture2D<float4> normals : register(t1);
+RWStructuredBuffer<uint> RayBins : register(u0);
+RWStructuredBuffer<uint> BinCounts : register(u1);
+RWStructuredBuffer<uint> BinOffsets : register(u2);
+RWStructuredBuffer<uint> BinnedRayPixels : register(u3);
+
+// Same 10 bits per axis interleave, y then x then z, as the fallback layer's GetMortonCodesFromUnitCoord
+uint SpreadBits10(uint x)
+{
+    x &= 0x3FF;
+    x = (x | (x << 16)) & 0x030000FF;
+    x = (x | (x << 8)) & 0x0300F00F;
+    x = (x | (x << 4)) & 0x030C30C3;
+    x = (x | (x << 2)) & 0x09249249;
+    return x;
+}
+
+uint MortonCode3D(float3 unitCoord)
+{
+    uint3 quantized = (uint3)clamp(unitCoord * 1024.0, 0.0, 1023.0);
+    return (SpreadBits10(quantized.y) << 2) | (SpreadBits10(quantized.x) << 1) | SpreadBits10(quantized.z);
+}
+
+uint GetRayBin(float3 origin, float3 direction)
+{
+    uint octant = (direction.x < 0.0 ? 1 : 0) | (direction.y < 0.0 ? 2 : 0) | (direction.z < 0.0 ? 4 : 0);
+    uint morton = MortonCode3D((origin - SceneMin) * SceneInvExtent);
+    uint bin = (octant << RAY_BINNING_MORTON_BITS) | (morton >> (30 - RAY_BINNING_MORTON_BITS));
+    return min(bin, RAY_BINNING_INVALID_BIN - 1);
+}
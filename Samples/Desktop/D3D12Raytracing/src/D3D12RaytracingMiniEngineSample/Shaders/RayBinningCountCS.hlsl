@@ -0,0 +1,48 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+
+#include "RayBinningCommon.hlsli"
+
+// Computes the bin of every pixel's ray and counts the rays in each bin.  Pixels of the padded dispatch that
+// fall off the screen, and pixels without a ray, go to the invalid bin so the raygen shader skips them.
+[RootSignature(RayBinning_RootSig)]
+[numthreads(8, 8, 1)]
+void main(uint3 DTid : SV_DispatchThreadID)
+{
+    uint bin = RAY_BINNING_INVALID_BIN;
+
+    if (DTid.x < ScreenWidth && DTid.y < ScreenHeight)
+    {
+        float2 xy = DTid.xy + 0.5;
+        float2 screenPos = xy / float2(ScreenWidth, ScreenHeight) * 2.0 - 1.0;
+        screenPos.y = -screenPos.y;
+
+        // Rebuild the ray exactly as the raygen shader will
+        float4 unprojected = mul(CameraToWorld, float4(screenPos, depth[DTid.xy], 1));
+        float3 origin = unprojected.xyz / unprojected.w;
+        float3 direction = FixedDirection;
+        bool hasRay = true;
+
+        if (BinReflections)
+        {
+            float4 normalData = normals[DTid.xy];
+            hasRay = normalData.w != 0.0;
+
+            float3 primaryRayDirection = normalize(WorldCameraPosition - origin);
+            direction = reflect(-primaryRayDirection, normalData.xyz);
+            origin -= primaryRayDirection * 0.1f;
+        }
+
+        if (hasRay)
+            bin = GetRayBin(origin, direction);
+    }
+
+    RayBins[DTid.y * DispatchWidth + DTid.x] = bin;
+    InterlockedAdd(BinCounts[bin], 1);
+}
@@ -0,0 +1,45 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+
+#include "RayBinningCommon.hlsli"
+
+groupshared uint ThreadTotals[RAY_BINNING_SCAN_THREADS];
+
+// Turns the bin counts into the exclusive offset of each bin in BinnedRayPixels, then clears the counts for
+// the next pass so they never need a separate clear.
+[RootSignature(RayBinning_RootSig)]
+[numthreads(RAY_BINNING_SCAN_THREADS, 1, 1)]
+void main(uint GI : SV_GroupIndex)
+{
+    uint firstBin = GI * RAY_BINNING_BINS_PER_THREAD;
+
+    uint total = 0;
+    for (uint i = 0; i < RAY_BINNING_BINS_PER_THREAD; ++i)
+        total += BinCounts[firstBin + i];
+
+    ThreadTotals[GI] = total;
+    GroupMemoryBarrierWithGroupSync();
+
+    for (uint stride = 1; stride < RAY_BINNING_SCAN_THREADS; stride <<= 1)
+    {
+        uint neighbour = GI >= stride ? ThreadTotals[GI - stride] : 0;
+        GroupMemoryBarrierWithGroupSync();
+        ThreadTotals[GI] += neighbour;
+        GroupMemoryBarrierWithGroupSync();
+    }
+
+    uint offset = ThreadTotals[GI] - total;
+    for (uint j = 0; j < RAY_BINNING_BINS_PER_THREAD; ++j)
+    {
+        uint count = BinCounts[firstBin + j];
+        BinOffsets[firstBin + j] = offset;
+        BinCounts[firstBin + j] = 0;
+        offset += count;
+    }
+}
@@ -0,0 +1,22 @@
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+
+#include "RayBinningCommon.hlsli"
+
+// Writes every pixel into the next free slot of its bin.  Pixels are packed as x | y << 16.
+[RootSignature(RayBinning_RootSig)]
+[numthreads(8, 8, 1)]
+void main(uint3 DTid : SV_DispatchThreadID)
+{
+    uint bin = RayBins[DTid.y * DispatchWidth + DTid.x];
+
+    uint slot;
+    InterlockedAdd(BinOffsets[bin], 1, slot);
+    BinnedRayPixels[slot] = DTid.x | (DTid.y << 16);
+}
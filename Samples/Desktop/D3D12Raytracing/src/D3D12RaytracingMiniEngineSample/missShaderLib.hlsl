@@ -17,7 +17,7 @@ void Miss(inout RayPayload payload)
 {
     if (!payload.SkipShading && !IsReflection)
     {
-        g_screenOutput[DispatchRaysIndex().xy] = float4(0, 0, 0, 1);
+        g_screenOutput[GetRayPixel()] = float4(0, 0, 0, 1);
     }
 }
 
@@ -52,11 +52,12 @@ D3D12RaytracingProceduralGeometry::D3D12RaytracingProceduralGeometry(UINT width,
     m_animateCamera(false),
     m_animateGeometry(true),
     m_animateLight(false),
+    m_decomposeAABBs(true),
+    m_enableLOD(true),
     m_isDxrSupported(false),
     m_descriptorsAllocated(0),
     m_descriptorSize(0),
     m_missShaderTableStrideInBytes(UINT_MAX),
-    m_hitGroupShaderTableStrideInBytes(UINT_MAX),
     m_forceComputeFallback(false)
 {
     m_forceComputeFallback = false;
@@ -126,6 +127,9 @@ void D3D12RaytracingProceduralGeometry::UpdateCameraMatrices()
     XMMATRIX proj = XMMatrixPerspectiveFovLH(XMConvertToRadians(fovAngleY), m_aspectRatio, 0.01f, 125.0f);
     XMMATRIX viewProj = view * proj;
     m_sceneCB->projectionToWorld = XMMatrixInverse(nullptr, viewProj);
+
+    // Angle between the primary rays of vertically adjacent pixels.
+    m_sceneCB->pixelConeSpreadAngle = m_enableLOD ? 2.0f * tanf(XMConvertToRadians(fovAngleY) / 2.0f) / m_height : 0.0f;
 }
 
 // Update AABB primite attributes buffers passed into the shader.
@@ -375,6 +379,7 @@ void D3D12RaytracingProceduralGeometry::CreateRootSignatures()
         rootParameters[GlobalRootSignature::Slot::AccelerationStructure].InitAsShaderResourceView(0);
         rootParameters[GlobalRootSignature::Slot::SceneConstant].InitAsConstantBufferView(0);
         rootParameters[GlobalRootSignature::Slot::AABBattributeBuffer].InitAsShaderResourceView(3);
+        rootParameters[GlobalRootSignature::Slot::AABBBuffer].InitAsShaderResourceView(4);
         rootParameters[GlobalRootSignature::Slot::VertexBuffers].InitAsDescriptorTable(1, &ranges[1]);
         CD3DX12_ROOT_SIGNATURE_DESC globalRootSignatureDesc(ARRAYSIZE(rootParameters), rootParameters);
         SerializeAndCreateRaytracingRootSignature(globalRootSignatureDesc, &m_raytracingGlobalRootSignature);
@@ -677,7 +682,90 @@ void D3D12RaytracingProceduralGeometry::BuildProceduralGeometryAABBs()
             m_aabbs[offset + Cylinder] = InitializeAABB(XMINT3(0, 0, 3), XMFLOAT3(2, 3, 2));
             m_aabbs[offset + FractalPyramid] = InitializeAABB(XMINT3(2, 0, 2), XMFLOAT3(6, 6, 6));
         }
-        AllocateUploadBuffer(device, m_aabbs.data(), m_aabbs.size()*sizeof(m_aabbs[0]), &m_aabbBuffer.resource);
+    }
+
+    // Decompose the primitive AABBs into AABBs that bound the geometry tighter.
+    // Rays that hit empty space within a primitive's AABB invoke its intersection shader for nothing,
+    // which is particularly expensive for the ray marched primitives.
+    // The decompositions are in primitive local space, where AABB is <-1,1>. Primitives that animate
+    // rotation around the Y axis get decompositions that are symmetric around it, so the bottom-level AS
+    // stays valid for any rotation.
+    {
+        vector<D3D12_RAYTRACING_AABB> localAABBs[IntersectionShaderType::TotalPrimitiveCount];
+        if (m_decomposeAABBs)
+        {
+            UINT offset = 0;
+            // Analytic primitives.
+            {
+                using namespace AnalyticPrimitive;
+                localAABBs[offset + Spheres] = { { -1, -0.9f, -1, 1, 0.5f, 1 } };
+                offset += AnalyticPrimitive::Count;
+            }
+
+            // Volumetric primitives fill their AABB.
+            offset += VolumetricPrimitive::Count;
+
+            // Signed distance primitives.
+            {
+                using namespace SignedDistancePrimitive;
+
+                // A ring around the torus hole.
+                const float outer = 0.9f, inner = 0.42f, height = 0.15f;
+                localAABBs[offset + SquareTorus] = {
+                    { -outer, -height, inner, outer, height, outer },
+                    { -outer, -height, -outer, outer, height, -inner },
+                    { inner, -height, -inner, outer, height, inner },
+                    { -outer, -height, -inner, -inner, height, inner } };
+
+                localAABBs[offset + TwistedTorus] = { { -0.83f, -0.8f, -0.83f, 0.83f, 0.8f, 0.83f } };
+                localAABBs[offset + Cog] = { { -0.9f, -0.3f, -0.9f, 0.9f, 0.3f, 0.9f } };
+
+                // One AABB per repeated cylinder.
+                for (float x : { -0.5f, 0.5f })
+                    for (float z : { -0.5f, 0.5f })
+                    {
+                        localAABBs[offset + Cylinder].push_back({ x - 0.3f, -1, z - 0.3f, x + 0.3f, 1, z + 0.3f });
+                    }
+
+                // Slices of the pyramid, each as wide as the pyramid at its base.
+                const UINT numPyramidSlices = 4;
+                for (UINT i = 0; i < numPyramidSlices; i++)
+                {
+                    float bottom = -1 + 2.0f * i / numPyramidSlices;
+                    float top = -1 + 2.0f * (i + 1) / numPyramidSlices;
+                    float halfWidth = (1 - bottom) / 2;
+                    localAABBs[offset + FractalPyramid].push_back({ -halfWidth, bottom, -halfWidth, halfWidth, top, halfWidth });
+                }
+            }
+        }
+
+        // Transform the local space AABBs into the primitive AABBs in bottom-level AS space.
+        m_geometryAABBs.clear();
+        for (UINT i = 0; i < IntersectionShaderType::TotalPrimitiveCount; i++)
+        {
+            if (localAABBs[i].empty())
+            {
+                localAABBs[i] = { { -1, -1, -1, 1, 1, 1 } };
+            }
+
+            const auto& aabb = m_aabbs[i];
+            XMFLOAT3 center(0.5f * (aabb.MaxX + aabb.MinX), 0.5f * (aabb.MaxY + aabb.MinY), 0.5f * (aabb.MaxZ + aabb.MinZ));
+            XMFLOAT3 halfExtent(0.5f * (aabb.MaxX - aabb.MinX), 0.5f * (aabb.MaxY - aabb.MinY), 0.5f * (aabb.MaxZ - aabb.MinZ));
+
+            m_geometryAABBOffsets[i] = static_cast<UINT>(m_geometryAABBs.size());
+            m_geometryAABBCounts[i] = static_cast<UINT>(localAABBs[i].size());
+            for (auto& localAABB : localAABBs[i])
+            {
+                m_geometryAABBs.push_back({
+                    center.x + halfExtent.x * localAABB.MinX,
+                    center.y + halfExtent.y * localAABB.MinY,
+                    center.z + halfExtent.z * localAABB.MinZ,
+                    center.x + halfExtent.x * localAABB.MaxX,
+                    center.y + halfExtent.y * localAABB.MaxY,
+                    center.z + halfExtent.z * localAABB.MaxZ });
+            }
+        }
+        AllocateUploadBuffer(device, m_geometryAABBs.data(), m_geometryAABBs.size()*sizeof(m_geometryAABBs[0]), &m_aabbBuffer.resource);
     }
 }
 
@@ -748,11 +836,10 @@ void D3D12RaytracingProceduralGeometry::BuildGeometryDescsForBottomLevelAS(array
     {
         D3D12_RAYTRACING_GEOMETRY_DESC aabbDescTemplate = {};
         aabbDescTemplate.Type = D3D12_RAYTRACING_GEOMETRY_TYPE_PROCEDURAL_PRIMITIVE_AABBS;
-        aabbDescTemplate.AABBs.AABBCount = 1;
         aabbDescTemplate.AABBs.AABBs.StrideInBytes = sizeof(D3D12_RAYTRACING_AABB);
         aabbDescTemplate.Flags = geometryFlags;
 
-        // One AABB primitive per geometry.
+        // One procedural primitive per geometry, bounded by one or more AABBs.
         geometryDescs[BottomLevelASType::AABB].resize(IntersectionShaderType::TotalPrimitiveCount, aabbDescTemplate);
 
         // Create AABB geometries. 
@@ -761,7 +848,8 @@ void D3D12RaytracingProceduralGeometry::BuildGeometryDescsForBottomLevelAS(array
         for (UINT i = 0; i < IntersectionShaderType::TotalPrimitiveCount; i++)
         {
             auto& geometryDesc = geometryDescs[BottomLevelASType::AABB][i];
-            geometryDesc.AABBs.AABBs.StartAddress = m_aabbBuffer.resource->GetGPUVirtualAddress() + i * sizeof(D3D12_RAYTRACING_AABB);
+            geometryDesc.AABBs.AABBCount = m_geometryAABBCounts[i];
+            geometryDesc.AABBs.AABBs.StartAddress = m_aabbBuffer.resource->GetGPUVirtualAddress() + m_geometryAABBOffsets[i] * sizeof(D3D12_RAYTRACING_AABB);
         }
     }
 }
@@ -1161,26 +1249,32 @@ void D3D12RaytracingProceduralGeometry::BuildShaderTables()
     }
 
     // Hit group shader table.
+    // The table lives in default heap memory and is copied to the GPU before the next DispatchRays().
+    // The records of each bottom-level AS instance are added as one range, starting at the instance's
+    // InstanceContributionToHitGroupIndex, so that instances with identical records could share them.
     {
         UINT numShaderRecords = RayType::Count + IntersectionShaderType::TotalPrimitiveCount * RayType::Count;
         UINT shaderRecordSize = shaderIDSize + LocalRootSignature::MaxRootArgumentsSize();
-        ShaderTable hitGroupShaderTable(device, numShaderRecords, shaderRecordSize, L"HitGroupShaderTable");
+        m_hitGroupShaderTable.Create(device, numShaderRecords, shaderRecordSize, m_deviceResources->GetBackBufferCount(), L"HitGroupShaderTable");
 
         // Triangle geometry hit groups.
         {
             LocalRootSignature::Triangle::RootArguments rootArgs;
             rootArgs.materialCb = m_planeMaterialCB;
 
+            vector<ShaderRecord> shaderRecords;
             for (auto& hitGroupShaderID : hitGroupShaderIDs_TriangleGeometry)
             {
-                hitGroupShaderTable.push_back(ShaderRecord(hitGroupShaderID, shaderIDSize, &rootArgs, sizeof(rootArgs)));
+                shaderRecords.push_back(ShaderRecord(hitGroupShaderID, shaderIDSize, &rootArgs, sizeof(rootArgs)));
             }
+            UINT index = m_hitGroupShaderTable.AddRecords(shaderRecords.data(), static_cast<UINT>(shaderRecords.size()));
+            ThrowIfFalse(index == BottomLevelASType::Triangle * RayType::Count, L"Triangle hit groups must start at the triangle BLAS instance's hit group contribution.");
         }
       
         // AABB geometry hit groups.
         {
-            LocalRootSignature::AABB::RootArguments rootArgs;
-            UINT instanceIndex = 0;
+            LocalRootSignature::AABB::RootArguments rootArgs[IntersectionShaderType::TotalPrimitiveCount];
+            vector<ShaderRecord> shaderRecords;
 
             // Create a shader record for each primitive.
             for (UINT iShader = 0, instanceIndex = 0; iShader < IntersectionShaderType::Count; iShader++)
@@ -1190,22 +1284,24 @@ void D3D12RaytracingProceduralGeometry::BuildShaderTables()
                 // Primitives for each intersection shader.
                 for (UINT primitiveIndex = 0; primitiveIndex < numPrimitiveTypes; primitiveIndex++, instanceIndex++)
                 {
-                    rootArgs.materialCb = m_aabbMaterialCB[instanceIndex];
-                    rootArgs.aabbCB.instanceIndex = instanceIndex;
-                    rootArgs.aabbCB.primitiveType = primitiveIndex;
+                    auto& primitiveRootArgs = rootArgs[instanceIndex];
+                    primitiveRootArgs.materialCb = m_aabbMaterialCB[instanceIndex];
+                    primitiveRootArgs.aabbCB.instanceIndex = instanceIndex;
+                    primitiveRootArgs.aabbCB.primitiveType = primitiveIndex;
+                    primitiveRootArgs.aabbCB.aabbOffset = m_geometryAABBOffsets[instanceIndex];
                     
                     // Ray types.
                     for (UINT r = 0; r < RayType::Count; r++)
                     {
                         auto& hitGroupShaderID = hitGroupShaderIDs_AABBGeometry[iShader][r];
-                        hitGroupShaderTable.push_back(ShaderRecord(hitGroupShaderID, shaderIDSize, &rootArgs, sizeof(rootArgs)));
+                        shaderRecords.push_back(ShaderRecord(hitGroupShaderID, shaderIDSize, &primitiveRootArgs, sizeof(primitiveRootArgs)));
                     }
                 }
             }
+            UINT index = m_hitGroupShaderTable.AddRecords(shaderRecords.data(), static_cast<UINT>(shaderRecords.size()));
+            ThrowIfFalse(index == BottomLevelASType::AABB * RayType::Count, L"AABB hit groups must start at the AABB BLAS instance's hit group contribution.");
         }
-        hitGroupShaderTable.DebugPrint(shaderIdToStringMap);
-        m_hitGroupShaderTableStrideInBytes = hitGroupShaderTable.GetShaderRecordSize();
-        m_hitGroupShaderTable = hitGroupShaderTable.GetResource();
+        m_hitGroupShaderTable.DebugPrint(shaderIdToStringMap);
     }
 }
 
@@ -1233,6 +1329,7 @@ void D3D12RaytracingProceduralGeometry::OnKeyDown(UINT8 key)
     // Store previous values.
     RaytracingAPI previousRaytracingAPI = m_raytracingAPI;
     bool previousForceComputeFallback = m_forceComputeFallback;
+    bool previousDecomposeAABBs = m_decomposeAABBs;
 
     switch (key)
     {
@@ -1259,6 +1356,13 @@ void D3D12RaytracingProceduralGeometry::OnKeyDown(UINT8 key)
     case 'L': 
         m_animateLight = !m_animateLight;
         break;
+    case 'A':
+        m_decomposeAABBs = !m_decomposeAABBs;
+        break;
+    case 'D':
+        m_enableLOD = !m_enableLOD;
+        UpdateCameraMatrices();
+        break;
         break;
     }
 
@@ -1268,6 +1372,11 @@ void D3D12RaytracingProceduralGeometry::OnKeyDown(UINT8 key)
         // Raytracing API selection changed, recreate everything.
         RecreateD3D();
     }
+    else if (m_decomposeAABBs != previousDecomposeAABBs)
+    {
+        // The AABBs changed, rebuild the acceleration structures and the shader tables that reference them.
+        RecreateD3D();
+    }
 }
 
 // Update frame-based values.
@@ -1337,9 +1446,9 @@ void D3D12RaytracingProceduralGeometry::DoRaytracing()
 
     auto DispatchRays = [&](auto* raytracingCommandList, auto* stateObject, auto* dispatchDesc)
     {
-        dispatchDesc->HitGroupTable.StartAddress = m_hitGroupShaderTable->GetGPUVirtualAddress();
-        dispatchDesc->HitGroupTable.SizeInBytes = m_hitGroupShaderTable->GetDesc().Width;
-        dispatchDesc->HitGroupTable.StrideInBytes = m_hitGroupShaderTableStrideInBytes;
+        dispatchDesc->HitGroupTable.StartAddress = m_hitGroupShaderTable.GpuVirtualAddress();
+        dispatchDesc->HitGroupTable.SizeInBytes = m_hitGroupShaderTable.GetSizeInBytes();
+        dispatchDesc->HitGroupTable.StrideInBytes = m_hitGroupShaderTable.GetShaderRecordStride();
         dispatchDesc->MissShaderTable.StartAddress = m_missShaderTable->GetGPUVirtualAddress();
         dispatchDesc->MissShaderTable.SizeInBytes = m_missShaderTable->GetDesc().Width;
         dispatchDesc->MissShaderTable.StrideInBytes = m_missShaderTableStrideInBytes;
@@ -1361,6 +1470,7 @@ void D3D12RaytracingProceduralGeometry::DoRaytracing()
         // Set index and successive vertex buffer decriptor tables.
         commandList->SetComputeRootDescriptorTable(GlobalRootSignature::Slot::VertexBuffers, m_indexBuffer.gpuDescriptorHandle);
         commandList->SetComputeRootDescriptorTable(GlobalRootSignature::Slot::OutputView, m_raytracingOutputResourceUAVGpuDescriptor);
+        commandList->SetComputeRootShaderResourceView(GlobalRootSignature::Slot::AABBBuffer, m_aabbBuffer.resource->GetGPUVirtualAddress());
     };
 
     commandList->SetComputeRootSignature(m_raytracingGlobalRootSignature.Get());
@@ -1372,6 +1482,8 @@ void D3D12RaytracingProceduralGeometry::DoRaytracing()
 
         m_aabbPrimitiveAttributeBuffer.CopyStagingToGpu(frameIndex);
         commandList->SetComputeRootShaderResourceView(GlobalRootSignature::Slot::AABBattributeBuffer, m_aabbPrimitiveAttributeBuffer.GpuVirtualAddress(frameIndex));
+
+        m_hitGroupShaderTable.CopyDirtyRecordsToGpu(commandList, frameIndex);
     }
 
     // Bind the heaps, acceleration structure and dispatch rays.  
@@ -1465,7 +1577,7 @@ void D3D12RaytracingProceduralGeometry::ReleaseDeviceDependentResources()
     m_raytracingOutputResourceUAVDescriptorHeapIndex = UINT_MAX;
     m_rayGenShaderTable.Reset();
     m_missShaderTable.Reset();
-    m_hitGroupShaderTable.Reset();
+    m_hitGroupShaderTable.Release();
 }
 
 void D3D12RaytracingProceduralGeometry::RecreateD3D()
@@ -1573,6 +1685,8 @@ void D3D12RaytracingProceduralGeometry::CalculateFrameStats()
             << L"    fps: " << fps 
             << L"    DispatchRays(): " << raytracingTime << "ms"
             << L"     ~Million Primary Rays/s: " << MRaysPerSecond
+            << L"    AABBs: " << m_geometryAABBs.size()
+            << L"    LOD: " << (m_enableLOD ? L"on" : L"off")
             << L"    GPU[" << m_deviceResources->GetAdapterID() << L"]: " << m_deviceResources->GetAdapterDescription();
         SetCustomWindowText(windowText.str().c_str());
     }
@@ -1587,6 +1701,7 @@ void D3D12RaytracingProceduralGeometry::OnSizeChanged(UINT width, UINT height, b
     }
 
     UpdateForSizeChange(width, height);
+    UpdateCameraMatrices();
 
     ReleaseWindowSizeDependentResources();
     CreateWindowSizeDependentResources();
@@ -78,7 +78,10 @@ private:
     // Raytracing scene
     ConstantBuffer<SceneConstantBuffer> m_sceneCB;
     StructuredBuffer<PrimitiveInstancePerFrameBuffer> m_aabbPrimitiveAttributeBuffer;
-    std::vector<D3D12_RAYTRACING_AABB> m_aabbs;
+    std::vector<D3D12_RAYTRACING_AABB> m_aabbs;                   // Bounds of each primitive.
+    std::vector<D3D12_RAYTRACING_AABB> m_geometryAABBs;           // AABBs the primitives are built from in the bottom-level AS.
+    UINT m_geometryAABBOffsets[IntersectionShaderType::TotalPrimitiveCount];
+    UINT m_geometryAABBCounts[IntersectionShaderType::TotalPrimitiveCount];
 
     // Root constants
     PrimitiveConstantBuffer m_planeMaterialCB;
@@ -108,8 +111,7 @@ private:
 
     ComPtr<ID3D12Resource> m_missShaderTable;
     UINT m_missShaderTableStrideInBytes;
-    ComPtr<ID3D12Resource> m_hitGroupShaderTable;
-    UINT m_hitGroupShaderTableStrideInBytes;
+    GpuShaderTable m_hitGroupShaderTable;
     ComPtr<ID3D12Resource> m_rayGenShaderTable;
 
     // Application state
@@ -121,6 +123,8 @@ private:
     bool m_animateGeometry;
     bool m_animateCamera;
     bool m_animateLight;
+    bool m_decomposeAABBs;
+    bool m_enableLOD;
     XMVECTOR m_eye;
     XMVECTOR m_at;
     XMVECTOR m_up;
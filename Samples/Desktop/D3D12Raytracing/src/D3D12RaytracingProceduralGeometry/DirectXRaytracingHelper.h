@@ -110,6 +110,213 @@ public:
     }
 };
 
+// Shader table in default heap memory that only copies changed shader records to the GPU.
+// Records are packed at the smallest stride that fits the largest record in D3D12_RAYTRACING_SHADER_RECORD_BYTE_ALIGNMENT.
+// A range of records identical to one added before is not stored again. AddRecords() returns the index
+// of the existing range instead, to be used as a hit group index contribution, e.g. InstanceContributionToHitGroupIndex.
+// Usage:
+//    GpuShaderTable st;
+//    st.Create(...);
+//    index = st.AddRecords(...); | st.SetRecord(index, ...);
+//    st.CopyDirtyRecordsToGpu(...);
+//    DispatchRays(... st.GpuVirtualAddress() ...);
+class GpuShaderTable
+{
+    ComPtr<ID3D12Resource> m_resource;
+    ComPtr<ID3D12Resource> m_uploadResource;    // A staging copy of the table per frame.
+    uint8_t* m_mappedUploadData;
+    D3D12_RESOURCE_STATES m_resourceState;
+    UINT m_shaderRecordStride;
+    UINT m_maxNumShaderRecords;
+    UINT m_numFrames;
+
+    std::vector<uint8_t> m_records;
+    std::vector<bool> m_isRecordDirty;
+    std::unordered_map<std::string, UINT> m_recordRangeIndices;
+
+    // Debug support
+    std::wstring m_name;
+    std::vector<ShaderRecord> m_shaderRecords;
+
+    void TransitionTo(ID3D12GraphicsCommandList* commandList, D3D12_RESOURCE_STATES state)
+    {
+        if (m_resourceState != state)
+        {
+            D3D12_RESOURCE_BARRIER barrier = CD3DX12_RESOURCE_BARRIER::Transition(m_resource.Get(), m_resourceState, state);
+            commandList->ResourceBarrier(1, &barrier);
+            m_resourceState = state;
+        }
+    }
+
+public:
+    GpuShaderTable() : m_mappedUploadData(nullptr), m_resourceState(D3D12_RESOURCE_STATE_COMMON), m_shaderRecordStride(0), m_maxNumShaderRecords(0), m_numFrames(0) {}
+
+    void Create(ID3D12Device* device, UINT maxNumShaderRecords, UINT maxShaderRecordSize, UINT numFrames, LPCWSTR resourceName = nullptr)
+    {
+        Release();
+        m_name = resourceName ? resourceName : L"";
+        m_shaderRecordStride = Align(maxShaderRecordSize, D3D12_RAYTRACING_SHADER_RECORD_BYTE_ALIGNMENT);
+        m_maxNumShaderRecords = maxNumShaderRecords;
+        m_numFrames = numFrames;
+        m_records.reserve(maxNumShaderRecords * m_shaderRecordStride);
+        m_shaderRecords.reserve(maxNumShaderRecords);
+
+        UINT bufferSize = maxNumShaderRecords * m_shaderRecordStride;
+        auto defaultHeapProperties = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT);
+        auto uploadHeapProperties = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD);
+        auto bufferDesc = CD3DX12_RESOURCE_DESC::Buffer(bufferSize);
+        auto uploadBufferDesc = CD3DX12_RESOURCE_DESC::Buffer(numFrames * bufferSize);
+
+        m_resourceState = D3D12_RESOURCE_STATE_COPY_DEST;
+        ThrowIfFailed(device->CreateCommittedResource(
+            &defaultHeapProperties,
+            D3D12_HEAP_FLAG_NONE,
+            &bufferDesc,
+            m_resourceState,
+            nullptr,
+            IID_PPV_ARGS(&m_resource)));
+        ThrowIfFailed(device->CreateCommittedResource(
+            &uploadHeapProperties,
+            D3D12_HEAP_FLAG_NONE,
+            &uploadBufferDesc,
+            D3D12_RESOURCE_STATE_GENERIC_READ,
+            nullptr,
+            IID_PPV_ARGS(&m_uploadResource)));
+        if (resourceName)
+        {
+            m_resource->SetName(resourceName);
+        }
+
+        // We don't unmap this until the table is released. Keeping buffer mapped for the lifetime of the resource is okay.
+        CD3DX12_RANGE readRange(0, 0);        // We do not intend to read from this resource on the CPU.
+        ThrowIfFailed(m_uploadResource->Map(0, &readRange, reinterpret_cast<void**>(&m_mappedUploadData)));
+    }
+
+    void Release()
+    {
+        if (m_uploadResource.Get())
+        {
+            m_uploadResource->Unmap(0, nullptr);
+        }
+        m_uploadResource.Reset();
+        m_resource.Reset();
+        m_mappedUploadData = nullptr;
+        m_records.clear();
+        m_isRecordDirty.clear();
+        m_recordRangeIndices.clear();
+        m_shaderRecords.clear();
+    }
+
+    // Add a range of consecutive shader records and return the index of the first one.
+    UINT AddRecords(const ShaderRecord* shaderRecords, UINT numShaderRecords)
+    {
+        std::vector<uint8_t> range(numShaderRecords * m_shaderRecordStride, 0);
+        for (UINT i = 0; i < numShaderRecords; i++)
+        {
+            ThrowIfFalse(shaderRecords[i].shaderIdentifier.size + shaderRecords[i].localRootArguments.size <= m_shaderRecordStride);
+            shaderRecords[i].CopyTo(&range[i * m_shaderRecordStride]);
+        }
+
+        std::string key(reinterpret_cast<const char*>(range.data()), range.size());
+        auto existingRange = m_recordRangeIndices.find(key);
+        if (existingRange != m_recordRangeIndices.end())
+        {
+            return existingRange->second;
+        }
+
+        UINT index = NumShaderRecords();
+        ThrowIfFalse(index + numShaderRecords <= m_maxNumShaderRecords);
+        m_records.insert(m_records.end(), range.begin(), range.end());
+        m_isRecordDirty.resize(index + numShaderRecords, true);
+        m_shaderRecords.insert(m_shaderRecords.end(), shaderRecords, shaderRecords + numShaderRecords);
+        m_recordRangeIndices[key] = index;
+        return index;
+    }
+
+    UINT push_back(const ShaderRecord& shaderRecord)
+    {
+        return AddRecords(&shaderRecord, 1);
+    }
+
+    // Change a record. Ranges that AddRecords() returned more than once change for all of their users.
+    void SetRecord(UINT index, const ShaderRecord& shaderRecord)
+    {
+        ThrowIfFalse(index < NumShaderRecords());
+        ThrowIfFalse(shaderRecord.shaderIdentifier.size + shaderRecord.localRootArguments.size <= m_shaderRecordStride);
+
+        std::vector<uint8_t> record(m_shaderRecordStride, 0);
+        shaderRecord.CopyTo(record.data());
+        uint8_t* currentRecord = &m_records[index * m_shaderRecordStride];
+        if (memcmp(currentRecord, record.data(), m_shaderRecordStride) != 0)
+        {
+            memcpy(currentRecord, record.data(), m_shaderRecordStride);
+            m_isRecordDirty[index] = true;
+            m_shaderRecords[index] = shaderRecord;
+
+            // The stored ranges no longer match their keys, so don't share them with new ranges.
+            m_recordRangeIndices.clear();
+        }
+    }
+
+    // Copy the records that changed since the last call to the GPU.
+    // The frame's staging copy must not be in use by the GPU anymore.
+    void CopyDirtyRecordsToGpu(ID3D12GraphicsCommandList* commandList, UINT frameIndex)
+    {
+        UINT64 stagingOffset = static_cast<UINT64>(frameIndex) * m_maxNumShaderRecords * m_shaderRecordStride;
+        UINT numShaderRecords = NumShaderRecords();
+
+        for (UINT i = 0; i < numShaderRecords; )
+        {
+            if (!m_isRecordDirty[i])
+            {
+                i++;
+                continue;
+            }
+
+            // Copy a contiguous run of dirty records at once.
+            UINT first = i;
+            while (i < numShaderRecords && m_isRecordDirty[i])
+            {
+                m_isRecordDirty[i++] = false;
+            }
+            UINT64 offset = first * m_shaderRecordStride;
+            UINT64 size = (i - first) * m_shaderRecordStride;
+            memcpy(m_mappedUploadData + stagingOffset + offset, &m_records[offset], size);
+
+            TransitionTo(commandList, D3D12_RESOURCE_STATE_COPY_DEST);
+            commandList->CopyBufferRegion(m_resource.Get(), offset, m_uploadResource.Get(), stagingOffset + offset, size);
+        }
+
+        TransitionTo(commandList, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+    }
+
+    // Accessors
+    UINT NumShaderRecords() { return static_cast<UINT>(m_shaderRecords.size()); }
+    UINT GetShaderRecordStride() { return m_shaderRecordStride; }
+    UINT64 GetSizeInBytes() { return static_cast<UINT64>(NumShaderRecords()) * m_shaderRecordStride; }
+    D3D12_GPU_VIRTUAL_ADDRESS GpuVirtualAddress() { return m_resource->GetGPUVirtualAddress(); }
+
+    // Pretty-print the shader records.
+    void DebugPrint(std::unordered_map<void*, std::wstring> shaderIdToStringMap)
+    {
+        std::wstringstream wstr;
+        wstr << L"|--------------------------------------------------------------------\n";
+        wstr << L"|Shader table - " << m_name.c_str() << L": " 
+             << m_shaderRecordStride << L" | "
+             << GetSizeInBytes() << L" bytes\n";
+
+        for (UINT i = 0; i < m_shaderRecords.size(); i++)
+        {
+            wstr << L"| [" << i << L"]: ";
+            wstr << shaderIdToStringMap[m_shaderRecords[i].shaderIdentifier.ptr] << L", ";
+            wstr << m_shaderRecords[i].shaderIdentifier.size << L" + " << m_shaderRecords[i].localRootArguments.size << L" bytes \n";
+        }
+        wstr << L"|--------------------------------------------------------------------\n";
+        wstr << L"\n";
+        OutputDebugStringW(wstr.str().c_str());
+    }
+};
+
 inline void AllocateUAVBuffer(ID3D12Device* pDevice, UINT64 bufferSize, ID3D12Resource **ppResource, D3D12_RESOURCE_STATES initialResourceState = D3D12_RESOURCE_STATE_COMMON, const wchar_t* resourceName = nullptr)
 {
     auto uploadHeapProperties = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT);
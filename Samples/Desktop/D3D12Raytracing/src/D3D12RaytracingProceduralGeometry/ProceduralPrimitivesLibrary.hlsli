@@ -47,11 +47,11 @@ bool RayAnalyticGeometryIntersectionTest(in Ray ray, in AnalyticPrimitive::Enum
 
 // Analytic geometry intersection test.
 // AABB local space dimensions: <-1,1>.
-bool RayVolumetricGeometryIntersectionTest(in Ray ray, in VolumetricPrimitive::Enum volumetricPrimitive, out float thit, out ProceduralPrimitiveAttributes attr, in float elapsedTime)
+bool RayVolumetricGeometryIntersectionTest(in Ray ray, in VolumetricPrimitive::Enum volumetricPrimitive, out float thit, out ProceduralPrimitiveAttributes attr, in float elapsedTime, in RayMarchExtents extents)
 {
     switch (volumetricPrimitive)
     {
-    case VolumetricPrimitive::Metaballs: return RayMetaballsIntersectionTest(ray, thit, attr, elapsedTime);
+    case VolumetricPrimitive::Metaballs: return RayMetaballsIntersectionTest(ray, thit, attr, elapsedTime, extents);
     default: return false;
     }
 }
@@ -59,8 +59,9 @@ bool RayVolumetricGeometryIntersectionTest(in Ray ray, in VolumetricPrimitive::E
 // Signed distance functions use a shared ray signed distance test.
 // The test, instead, calls into this function to retrieve a distance for a primitive.
 // AABB local space dimensions: <-1,1>.
+// footprint - local space width of the ray cone at the position, used to skip unresolvable detail.
 // Ref: http://www.iquilezles.org/www/articles/distfunctions/distfunctions.htm
-float GetDistanceFromSignedDistancePrimitive(in float3 position, in SignedDistancePrimitive::Enum signedDistancePrimitive)
+float GetDistanceFromSignedDistancePrimitive(in float3 position, in SignedDistancePrimitive::Enum signedDistancePrimitive, in float footprint)
 {
     switch (signedDistancePrimitive)
     {
@@ -91,7 +92,7 @@ float GetDistanceFromSignedDistancePrimitive(in float3 position, in SignedDistan
     case SignedDistancePrimitive::FractalPyramid: 
          // Let pyramid have a base at y == -1 of AABB => position + float3(0,1,0) 
          // Pyramid: 63.435 degrees at base, height 2
-         return sdFractalPyramid(position + float3(0, 1, 0), float3(0.894, 0.447, 2.0), 2.0f);
+         return sdFractalPyramid(position + float3(0, 1, 0), float3(0.894, 0.447, 2.0), 2.0f, footprint);
     
     default: return 0;
     }
@@ -77,6 +77,7 @@ struct SceneConstantBuffer
     XMVECTOR lightDiffuseColor;
     float    reflectance;
     float    elapsedTime;                 // Elapsed application time.
+    float    pixelConeSpreadAngle;        // Angle a primary ray cone spreads by per pixel. 0 disables LOD.
 };
 
 // Attributes per primitive type.
@@ -98,6 +99,7 @@ struct PrimitiveInstanceConstantBuffer
 {
     UINT instanceIndex;  
     UINT primitiveType; // Procedural primitive type
+    UINT aabbOffset;    // Index of the primitive's first AABB in the AABB buffer.
 };
 
 // Dynamic attributes per primitive instance.
@@ -34,6 +34,7 @@ StructuredBuffer<Vertex> g_vertices : register(t2, space0);
 
 // Procedural geometry resources
 StructuredBuffer<PrimitiveInstancePerFrameBuffer> g_AABBPrimitiveAttributes : register(t3, space0);
+StructuredBuffer<RaytracingAABB> g_AABBs : register(t4, space0);
 ConstantBuffer<PrimitiveConstantBuffer> l_materialCB : register(b1);
 ConstantBuffer<PrimitiveInstanceConstantBuffer> l_aabbCB: register(b2);
 
@@ -297,6 +298,29 @@ Ray GetRayInAABBPrimitiveLocalSpace()
     return ray;
 }
 
+// Get the ray segment within the AABB the intersection shader was invoked for.
+// A primitive can be bounded by multiple AABBs, so marching only this segment avoids repeating
+// the work of invocations for the other AABBs.
+RayMarchExtents GetRayMarchExtentsInAABB(in Ray localRay)
+{
+    RaytracingAABB aabb = g_AABBs[l_aabbCB.aabbOffset + PrimitiveIndex()];
+
+    // The local space transform is affine, so t is the same in bottom level AS and local space.
+    float3 t0 = (aabb.minimum - ObjectRayOrigin()) / ObjectRayDirection();
+    float3 t1 = (aabb.maximum - ObjectRayOrigin()) / ObjectRayDirection();
+    float3 tEnter = min(t0, t1);
+    float3 tExit = max(t0, t1);
+
+    RayMarchExtents extents;
+    extents.tMin = max(RayTMin(), max(max(tEnter.x, tEnter.y), tEnter.z));
+    extents.tMax = min(RayTCurrent(), min(min(tExit.x, tExit.y), tExit.z));
+
+    // The ray cone widens by pixelConeSpreadAngle per unit of world distance and the local ray direction
+    // scales that to local space. Secondary rays restart the cone at their origin, which only underestimates it.
+    extents.coneWidthPerT = g_sceneCB.pixelConeSpreadAngle * length(localRay.direction);
+    return extents;
+}
+
 [shader("intersection")]
 void MyIntersectionShader_AnalyticPrimitive()
 {
@@ -323,7 +347,7 @@ void MyIntersectionShader_VolumetricPrimitive()
     
     float thit;
     ProceduralPrimitiveAttributes attr;
-    if (RayVolumetricGeometryIntersectionTest(localRay, primitiveType, thit, attr, g_sceneCB.elapsedTime))
+    if (RayVolumetricGeometryIntersectionTest(localRay, primitiveType, thit, attr, g_sceneCB.elapsedTime, GetRayMarchExtentsInAABB(localRay)))
     {
         PrimitiveInstancePerFrameBuffer aabbAttribute = g_AABBPrimitiveAttributes[l_aabbCB.instanceIndex];
         attr.normal = mul(attr.normal, (float3x3) aabbAttribute.localSpaceToBottomLevelAS);
@@ -341,7 +365,7 @@ void MyIntersectionShader_SignedDistancePrimitive()
 
     float thit;
     ProceduralPrimitiveAttributes attr;
-    if (RaySignedDistancePrimitiveTest(localRay, primitiveType, thit, attr, l_materialCB.stepScale))
+    if (RaySignedDistancePrimitiveTest(localRay, primitiveType, GetRayMarchExtentsInAABB(localRay), thit, attr, l_materialCB.stepScale))
     {
         PrimitiveInstancePerFrameBuffer aabbAttribute = g_AABBPrimitiveAttributes[l_aabbCB.instanceIndex];
         attr.normal = mul(attr.normal, (float3x3) aabbAttribute.localSpaceToBottomLevelAS);
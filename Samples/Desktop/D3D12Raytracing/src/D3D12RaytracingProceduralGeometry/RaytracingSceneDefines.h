@@ -20,6 +20,7 @@ namespace GlobalRootSignature {
             AccelerationStructure,
             SceneConstant,
             AABBattributeBuffer,
+            AABBBuffer,
             VertexBuffers,
             Count
         };
@@ -22,6 +22,21 @@ struct Ray
     float3 direction;
 };
 
+// A bottom-level AS AABB as laid out in D3D12_RAYTRACING_AABB.
+struct RaytracingAABB
+{
+    float3 minimum;
+    float3 maximum;
+};
+
+// Ray segment within the AABB an intersection shader was invoked for and the ray cone footprint along it.
+struct RayMarchExtents
+{
+    float tMin;
+    float tMax;
+    float coneWidthPerT;    // Local space width of the ray cone per unit of t. 0 disables LOD.
+};
+
 float length_toPow2(float2 p)
 {
     return dot(p, p);
@@ -30,9 +30,17 @@
 // a = pyramid's inner angle between its side plane and a ground plane.
 // Pyramid position - sitting on a ground plane.
 // Pyramid span: {<-a,0,-a>, <a,h.z,a>}, where a = width of base = h.z * h.y / h.x.
+// footprint - ray cone width at the position. Iterations adding detail smaller than it are skipped.
 // More info here http://blog.hvidtfeldts.net/index.php/2011/08/distance-estimated-3d-fractals-iii-folding-space/
-float sdFractalPyramid(in float3 position, float3 h, in float Scale = 2.0f)
+float sdFractalPyramid(in float3 position, float3 h, in float Scale = 2.0f, in float footprint = 0)
 {
+    // Each iteration shrinks the pyramid copies by Scale.
+    int nIterations = N_FRACTAL_ITERATIONS;
+    if (footprint > 0)
+    {
+        nIterations = clamp(int(log(h.z / footprint) / log(Scale)), 1, N_FRACTAL_ITERATIONS);
+    }
+
     // Set pyramid vertices to AABB's extremities.
     float a = h.z * h.y / h.x;
     float3 v1 = float3(0, h.z, 0);
@@ -42,7 +50,7 @@ float sdFractalPyramid(in float3 position, float3 h, in float Scale = 2.0f)
     float3 v5 = float3(-a, 0, -a);
 
     int n = 0;
-    for (n = 0; n < N_FRACTAL_ITERATIONS; n++)
+    for (n = 0; n < nIterations; n++)
     {
         // Find the closest vertex.
         float dist, d;
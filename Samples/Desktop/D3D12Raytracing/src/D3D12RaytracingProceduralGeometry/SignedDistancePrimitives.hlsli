@@ -47,7 +47,7 @@
 #include "RaytracingShaderHelper.hlsli"
 
 //------------------------------------------------------------------
-float GetDistanceFromSignedDistancePrimitive(in float3 position, in SignedDistancePrimitive::Enum sdPrimitive);
+float GetDistanceFromSignedDistancePrimitive(in float3 position, in SignedDistancePrimitive::Enum sdPrimitive, in float footprint);
 
 //------------------------------------------------------------------
 
@@ -272,35 +272,38 @@ float sdCylinder6(float3 p, float2 h)
     return max(length_toPowNegative6(p.xz) - h.x, abs(p.y) - h.y);
 }
 
-float3 sdCalculateNormal(in float3 pos, in SignedDistancePrimitive::Enum sdPrimitive)
+float3 sdCalculateNormal(in float3 pos, in SignedDistancePrimitive::Enum sdPrimitive, in float footprint)
 {
     float2 e = float2(1.0, -1.0) * 0.5773 * 0.0001;
     return normalize(
-        e.xyy * GetDistanceFromSignedDistancePrimitive(pos + e.xyy, sdPrimitive) +
-        e.yyx * GetDistanceFromSignedDistancePrimitive(pos + e.yyx, sdPrimitive) +
-        e.yxy * GetDistanceFromSignedDistancePrimitive(pos + e.yxy, sdPrimitive) +
-        e.xxx * GetDistanceFromSignedDistancePrimitive(pos + e.xxx, sdPrimitive));
+        e.xyy * GetDistanceFromSignedDistancePrimitive(pos + e.xyy, sdPrimitive, footprint) +
+        e.yyx * GetDistanceFromSignedDistancePrimitive(pos + e.yyx, sdPrimitive, footprint) +
+        e.yxy * GetDistanceFromSignedDistancePrimitive(pos + e.yxy, sdPrimitive, footprint) +
+        e.xxx * GetDistanceFromSignedDistancePrimitive(pos + e.xxx, sdPrimitive, footprint));
 }
 
 // Test ray against a signed distance primitive.
 // Ref: https://www.scratchapixel.com/lessons/advanced-rendering/rendering-distance-fields/basic-sphere-tracer
-bool RaySignedDistancePrimitiveTest(in Ray ray, in SignedDistancePrimitive::Enum sdPrimitive, out float thit, out ProceduralPrimitiveAttributes attr, in float stepScale = 1.0f)
+bool RaySignedDistancePrimitiveTest(in Ray ray, in SignedDistancePrimitive::Enum sdPrimitive, in RayMarchExtents extents, out float thit, out ProceduralPrimitiveAttributes attr, in float stepScale = 1.0f)
 {
-    const float threshold = 0.0001;
-    float t = RayTMin();
+    // Getting closer to the surface than half of the ray cone footprint doesn't change the result,
+    // so distant rays converge in fewer steps.
+    const float threshold = max(0.0001, 0.5 * extents.coneWidthPerT);
+    float t = extents.tMin;
     const UINT MaxSteps = 512;
 
     // Do sphere tracing through the AABB.
     UINT i = 0;
-    while (i++ < MaxSteps && t <= RayTCurrent())
+    while (i++ < MaxSteps && t <= extents.tMax)
     {
         float3 position = ray.origin + t * ray.direction;
-        float distance = GetDistanceFromSignedDistancePrimitive(position, sdPrimitive);
+        float footprint = extents.coneWidthPerT * t;
+        float distance = GetDistanceFromSignedDistancePrimitive(position, sdPrimitive, footprint);
 
         // Has the ray intersected the primitive? 
         if (distance <= threshold * t)
         {
-            float3 hitSurfaceNormal = sdCalculateNormal(position, sdPrimitive);
+            float3 hitSurfaceNormal = sdCalculateNormal(position, sdPrimitive, footprint);
             if (IsAValidHit(ray, t, hitSurfaceNormal))
             {
                 thit = t;
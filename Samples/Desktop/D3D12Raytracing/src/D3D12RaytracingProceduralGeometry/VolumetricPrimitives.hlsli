@@ -148,7 +148,8 @@ void FindIntersectingMetaballs(in Ray ray, out float tmin, out float tmax, inout
 
 // Test if a ray with RayFlags and segment <RayTMin(), RayTCurrent()> intersects metaball field.
 // The test sphere traces through the metaball field until it hits a threshold isosurface. 
-bool RayMetaballsIntersectionTest(in Ray ray, out float thit, out ProceduralPrimitiveAttributes attr, in float elapsedTime)
+// The ray marches only the extents' segment, with steps no finer than the ray cone footprint.
+bool RayMetaballsIntersectionTest(in Ray ray, out float thit, out ProceduralPrimitiveAttributes attr, in float elapsedTime, in RayMarchExtents extents)
 {
     Metaball blobs[N_METABALLS];
     InitializeAnimatedMetaballs(blobs, elapsedTime, 12.0f);
@@ -156,13 +157,15 @@ bool RayMetaballsIntersectionTest(in Ray ray, out float thit, out ProceduralPrim
     float tmin, tmax;   // Ray extents to first and last metaball intersections.
     UINT nActiveMetaballs = 0;  // Number of metaballs's that the ray intersects.
     FindIntersectingMetaballs(ray, tmin, tmax, blobs, nActiveMetaballs);
+    tmin = max(tmin, extents.tMin);
+    tmax = min(tmax, extents.tMax);
 
     UINT MAX_STEPS = 128;
     float t = tmin;
     float minTStep = (tmax - tmin) / (MAX_STEPS / 1);
     UINT iStep = 0;
 
-    while (iStep++ < MAX_STEPS)
+    while (iStep++ < MAX_STEPS && t <= tmax)
     {
         float3 position = ray.origin + t * ray.direction;
         float fieldPotentials[N_METABALLS];    // Field potentials for each metaball.
@@ -195,7 +198,8 @@ bool RayMetaballsIntersectionTest(in Ray ray, out float thit, out ProceduralPrim
                 return true;
             }
         }
-        t += minTStep;
+        // Steps finer than the ray cone footprint don't resolve any more detail.
+        t += max(minTStep, extents.coneWidthPerT * t);
     }
 
     return false;
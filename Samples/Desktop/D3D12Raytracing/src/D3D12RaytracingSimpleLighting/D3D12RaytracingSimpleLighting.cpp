@@ -25,6 +25,7 @@ const wchar_t* D3D12RaytracingSimpleLighting::c_missShaderName = L"MyMissShader"
 D3D12RaytracingSimpleLighting::D3D12RaytracingSimpleLighting(UINT width, UINT height, std::wstring name) :
     DXSample(width, height, name),
     m_raytracingOutputResourceUAVDescriptorHeapIndex(UINT_MAX),
+    m_bottomLevelHandle(0),
     m_curRotationAngleRad(0.0f),
     m_isDxrSupported(false)
 {
@@ -405,11 +406,11 @@ void D3D12RaytracingSimpleLighting::CreateDescriptorHeap()
     auto device = m_deviceResources->GetD3DDevice();
 
     D3D12_DESCRIPTOR_HEAP_DESC descriptorHeapDesc = {};
-    // Allocate a heap for 5 descriptors:
+    // Allocate a heap for 6 descriptors:
     // 2 - vertex and index buffer SRVs
     // 1 - raytracing output texture SRV
-    // 2 - bottom and top level acceleration structure fallback wrapped pointer UAVs
-    descriptorHeapDesc.NumDescriptors = 5; 
+    // 3 - bottom level (before and after compaction) and top level acceleration structure fallback wrapped pointer UAVs
+    descriptorHeapDesc.NumDescriptors = 6; 
     descriptorHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
     descriptorHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
     descriptorHeapDesc.NodeMask = 0;
@@ -520,16 +521,15 @@ void D3D12RaytracingSimpleLighting::BuildAccelerationStructures()
     // Get required sizes for an acceleration structure.
     D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAGS buildFlags = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_PREFER_FAST_TRACE;
     
-    D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_DESC bottomLevelBuildDesc = {};
-    D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS &bottomLevelInputs = bottomLevelBuildDesc.Inputs;
+    D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS bottomLevelInputs = {};
     bottomLevelInputs.DescsLayout = D3D12_ELEMENTS_LAYOUT_ARRAY;
     bottomLevelInputs.Flags = buildFlags;
     bottomLevelInputs.NumDescs = 1;
     bottomLevelInputs.Type = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL;
     bottomLevelInputs.pGeometryDescs = &geometryDesc;
 
-    D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_DESC topLevelBuildDesc = {};
-    D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS &topLevelInputs = topLevelBuildDesc.Inputs;
+    m_topLevelBuildDesc = {};
+    D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS &topLevelInputs = m_topLevelBuildDesc.Inputs;
     topLevelInputs.DescsLayout = D3D12_ELEMENTS_LAYOUT_ARRAY;
     topLevelInputs.Flags = buildFlags;
     topLevelInputs.NumDescs = 1;
@@ -547,19 +547,9 @@ void D3D12RaytracingSimpleLighting::BuildAccelerationStructures()
     }
     ThrowIfFalse(topLevelPrebuildInfo.ResultDataMaxSizeInBytes > 0);
 
-    D3D12_RAYTRACING_ACCELERATION_STRUCTURE_PREBUILD_INFO bottomLevelPrebuildInfo = {};
-    if (m_raytracingAPI == RaytracingAPI::FallbackLayer)
-    {
-        m_fallbackDevice->GetRaytracingAccelerationStructurePrebuildInfo(&bottomLevelInputs, &bottomLevelPrebuildInfo);
-    }
-    else // DirectX Raytracing
-    {
-        m_dxrDevice->GetRaytracingAccelerationStructurePrebuildInfo(&bottomLevelInputs, &bottomLevelPrebuildInfo);
-    }
-    ThrowIfFalse(bottomLevelPrebuildInfo.ResultDataMaxSizeInBytes > 0);
-
-    ComPtr<ID3D12Resource> scratchResource;
-    AllocateUAVBuffer(device, max(topLevelPrebuildInfo.ScratchDataSizeInBytes, bottomLevelPrebuildInfo.ScratchDataSizeInBytes), &scratchResource, D3D12_RESOURCE_STATE_UNORDERED_ACCESS, L"ScratchResource");
+    // The compactor sizes and allocates the bottom level's scratch itself. The top level keeps its scratch,
+    // since it is rebuilt once the bottom level has been compacted.
+    AllocateUAVBuffer(device, topLevelPrebuildInfo.ScratchDataSizeInBytes, &m_topLevelScratchResource, D3D12_RESOURCE_STATE_UNORDERED_ACCESS, L"TopLevelScratchResource");
 
     // Allocate resources for acceleration structures.
     // Acceleration structures can only be placed in resources that are created in the default heap (or custom heap equivalent). 
@@ -579,8 +569,21 @@ void D3D12RaytracingSimpleLighting::BuildAccelerationStructures()
             initialResourceState = D3D12_RESOURCE_STATE_RAYTRACING_ACCELERATION_STRUCTURE;
         }
 
-        AllocateUAVBuffer(device, bottomLevelPrebuildInfo.ResultDataMaxSizeInBytes, &m_bottomLevelAccelerationStructure, initialResourceState, L"BottomLevelAccelerationStructure");
         AllocateUAVBuffer(device, topLevelPrebuildInfo.ResultDataMaxSizeInBytes, &m_topLevelAccelerationStructure, initialResourceState, L"TopLevelAccelerationStructure");
+
+        // Compaction only pays off when the bottom level is built with ALLOW_COMPACTION, which the compactor adds.
+        if (m_raytracingAPI == RaytracingAPI::FallbackLayer)
+        {
+            m_fallbackCompactor.reset(new CD3D12_ACCELERATION_STRUCTURE_COMPACTOR<ID3D12RaytracingFallbackDevice, ID3D12RaytracingFallbackCommandList>(
+                device, m_fallbackDevice.Get(), initialResourceState));
+            m_bottomLevelHandle = m_fallbackCompactor->AddBottomLevel(bottomLevelInputs);
+        }
+        else // DirectX Raytracing
+        {
+            m_dxrCompactor.reset(new CD3D12_ACCELERATION_STRUCTURE_COMPACTOR<ID3D12Device5, ID3D12GraphicsCommandList5>(
+                device, m_dxrDevice.Get(), initialResourceState));
+            m_bottomLevelHandle = m_dxrCompactor->AddBottomLevel(bottomLevelInputs);
+        }
     }
     
     // Note on Emulated GPU pointers (AKA Wrapped pointers) requirement in Fallback Layer:
@@ -594,26 +597,6 @@ void D3D12RaytracingSimpleLighting::BuildAccelerationStructures()
     // The Fallback Layer interface uses WRAPPED_GPU_POINTER to encapsulate the underlying pointer
     // which will either be an emulated GPU pointer for the compute - based path or a GPU_VIRTUAL_ADDRESS for the DXR path.
 
-    // Create an instance desc for the bottom-level acceleration structure.
-    ComPtr<ID3D12Resource> instanceDescs;
-    if (m_raytracingAPI == RaytracingAPI::FallbackLayer)
-    {
-        D3D12_RAYTRACING_FALLBACK_INSTANCE_DESC instanceDesc = {};
-        instanceDesc.Transform[0][0] = instanceDesc.Transform[1][1] = instanceDesc.Transform[2][2] = 1;
-        instanceDesc.InstanceMask = 1;
-        UINT numBufferElements = static_cast<UINT>(bottomLevelPrebuildInfo.ResultDataMaxSizeInBytes) / sizeof(UINT32);
-        instanceDesc.AccelerationStructure = CreateFallbackWrappedPointer(m_bottomLevelAccelerationStructure.Get(), numBufferElements); 
-        AllocateUploadBuffer(device, &instanceDesc, sizeof(instanceDesc), &instanceDescs, L"InstanceDescs");
-    }
-    else // DirectX Raytracing
-    {
-        D3D12_RAYTRACING_INSTANCE_DESC instanceDesc = {};
-        instanceDesc.Transform[0][0] = instanceDesc.Transform[1][1] = instanceDesc.Transform[2][2] = 1;
-        instanceDesc.InstanceMask = 1;
-        instanceDesc.AccelerationStructure = m_bottomLevelAccelerationStructure->GetGPUVirtualAddress();
-        AllocateUploadBuffer(device, &instanceDesc, sizeof(instanceDesc), &instanceDescs, L"InstanceDescs");
-    }
-
     // Create a wrapped pointer to the acceleration structure.
     if (m_raytracingAPI == RaytracingAPI::FallbackLayer)
     {
@@ -621,24 +604,18 @@ void D3D12RaytracingSimpleLighting::BuildAccelerationStructures()
         m_fallbackTopLevelAccelerationStructurePointer = CreateFallbackWrappedPointer(m_topLevelAccelerationStructure.Get(), numBufferElements); 
     }
 
-    // Bottom Level Acceleration Structure desc
-    {
-        bottomLevelBuildDesc.ScratchAccelerationStructureData = scratchResource->GetGPUVirtualAddress();
-        bottomLevelBuildDesc.DestAccelerationStructureData = m_bottomLevelAccelerationStructure->GetGPUVirtualAddress();
-    }
-
     // Top Level Acceleration Structure desc
+    // The instance descs are filled in by BuildTopLevelAccelerationStructure().
     {
-        topLevelBuildDesc.DestAccelerationStructureData = m_topLevelAccelerationStructure->GetGPUVirtualAddress();
-        topLevelBuildDesc.ScratchAccelerationStructureData = scratchResource->GetGPUVirtualAddress();
-        topLevelBuildDesc.Inputs.InstanceDescs = instanceDescs->GetGPUVirtualAddress();
+        m_topLevelBuildDesc.DestAccelerationStructureData = m_topLevelAccelerationStructure->GetGPUVirtualAddress();
+        m_topLevelBuildDesc.ScratchAccelerationStructureData = m_topLevelScratchResource->GetGPUVirtualAddress();
     }
 
-    auto BuildAccelerationStructure = [&](auto* raytracingCommandList)
+    // The bottom level build also queries its compacted size, which is read back a few frames later without stalling.
+    auto BuildAccelerationStructure = [&](auto* compactor, auto* raytracingCommandList)
     {
-        raytracingCommandList->BuildRaytracingAccelerationStructure(&bottomLevelBuildDesc, 0, nullptr);
-        commandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::UAV(m_bottomLevelAccelerationStructure.Get()));
-        raytracingCommandList->BuildRaytracingAccelerationStructure(&topLevelBuildDesc, 0, nullptr);
+        compactor->BuildPending(commandList, raytracingCommandList);
+        BuildTopLevelAccelerationStructure();
     };
 
     // Build acceleration structure.
@@ -647,20 +624,115 @@ void D3D12RaytracingSimpleLighting::BuildAccelerationStructures()
         // Set the descriptor heaps to be used during acceleration structure build for the Fallback Layer.
         ID3D12DescriptorHeap *pDescriptorHeaps[] = { m_descriptorHeap.Get() };
         m_fallbackCommandList->SetDescriptorHeaps(ARRAYSIZE(pDescriptorHeaps), pDescriptorHeaps);
-        BuildAccelerationStructure(m_fallbackCommandList.Get());
+        BuildAccelerationStructure(m_fallbackCompactor.get(), m_fallbackCommandList.Get());
     }
     else // DirectX Raytracing
     {
-        BuildAccelerationStructure(m_dxrCommandList.Get());
+        BuildAccelerationStructure(m_dxrCompactor.get(), m_dxrCommandList.Get());
     }
 
     // Kick off acceleration structure construction.
     m_deviceResources->ExecuteCommandList();
+    if (m_raytracingAPI == RaytracingAPI::FallbackLayer)
+    {
+        m_fallbackCompactor->Signal(commandQueue);
+    }
+    else // DirectX Raytracing
+    {
+        m_dxrCompactor->Signal(commandQueue);
+    }
 
-    // Wait for GPU to finish as the locally created temporary GPU resources will get released once we go out of scope.
+    // Wait for GPU to finish before the first frame traces against the acceleration structures.
     m_deviceResources->WaitForGpu();
 }
 
+// Point the instance at wherever the bottom level currently lives and build the top level over it.
+// Compaction moves the bottom level, so this is recorded again once the compacted copy has been made.
+void D3D12RaytracingSimpleLighting::BuildTopLevelAccelerationStructure()
+{
+    auto device = m_deviceResources->GetD3DDevice();
+    auto commandList = m_deviceResources->GetCommandList();
+
+    auto UploadInstanceDesc = [&](auto& instanceDesc)
+    {
+        if (!m_instanceDescs)
+        {
+            AllocateUploadBuffer(device, &instanceDesc, sizeof(instanceDesc), &m_instanceDescs, L"InstanceDescs");
+            m_topLevelBuildDesc.Inputs.InstanceDescs = m_instanceDescs->GetGPUVirtualAddress();
+        }
+        else
+        {
+            // No top level build that reads the previous desc is still in flight, as there is only one compaction.
+            void* pMappedData;
+            ThrowIfFailed(m_instanceDescs->Map(0, nullptr, &pMappedData));
+            memcpy(pMappedData, &instanceDesc, sizeof(instanceDesc));
+            m_instanceDescs->Unmap(0, nullptr);
+        }
+    };
+
+    // Create an instance desc for the bottom-level acceleration structure.
+    if (m_raytracingAPI == RaytracingAPI::FallbackLayer)
+    {
+        D3D12_RAYTRACING_FALLBACK_INSTANCE_DESC instanceDesc = {};
+        instanceDesc.Transform[0][0] = instanceDesc.Transform[1][1] = instanceDesc.Transform[2][2] = 1;
+        instanceDesc.InstanceMask = 1;
+        ID3D12Resource* bottomLevelResource = m_fallbackCompactor->GetResource(m_bottomLevelHandle);
+        UINT numBufferElements = static_cast<UINT>(bottomLevelResource->GetDesc().Width) / sizeof(UINT32);
+        instanceDesc.AccelerationStructure = CreateFallbackWrappedPointer(bottomLevelResource, numBufferElements, m_fallbackCompactor->GetOffsetInBytes(m_bottomLevelHandle));
+        UploadInstanceDesc(instanceDesc);
+
+        m_fallbackCommandList->BuildRaytracingAccelerationStructure(&m_topLevelBuildDesc, 0, nullptr);
+    }
+    else // DirectX Raytracing
+    {
+        D3D12_RAYTRACING_INSTANCE_DESC instanceDesc = {};
+        instanceDesc.Transform[0][0] = instanceDesc.Transform[1][1] = instanceDesc.Transform[2][2] = 1;
+        instanceDesc.InstanceMask = 1;
+        instanceDesc.AccelerationStructure = m_dxrCompactor->GetGpuVirtualAddress(m_bottomLevelHandle);
+        UploadInstanceDesc(instanceDesc);
+
+        m_dxrCommandList->BuildRaytracingAccelerationStructure(&m_topLevelBuildDesc, 0, nullptr);
+    }
+    commandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::UAV(m_topLevelAccelerationStructure.Get()));
+}
+
+// Compact the bottom level once its compacted size has been read back, and free its build memory once the copy is done.
+// Returns true while there is compaction work in flight, in which case the compactor must be signaled after the frame is submitted.
+bool D3D12RaytracingSimpleLighting::UpdateAccelerationStructureCompaction()
+{
+    auto commandList = m_deviceResources->GetCommandList();
+
+    auto UpdateCompaction = [&](auto* compactor, auto* raytracingCommandList)
+    {
+        if (!compactor || compactor->IsIdle())
+        {
+            return false;
+        }
+
+        if (compactor->Update(commandList, raytracingCommandList))
+        {
+            BuildTopLevelAccelerationStructure();
+
+            wstringstream compactionStats;
+            compactionStats << L"Compacted bottom level acceleration structure from " << compactor->GetBuiltSizeInBytes()
+                            << L" to " << compactor->GetCompactedSizeInBytes() << L" bytes.\n";
+            OutputDebugString(compactionStats.str().c_str());
+        }
+        return true;
+    };
+
+    if (m_raytracingAPI == RaytracingAPI::FallbackLayer)
+    {
+        // The top level build needs the descriptor heap for the Fallback Layer.
+        m_fallbackCommandList->SetDescriptorHeaps(1, m_descriptorHeap.GetAddressOf());
+        return UpdateCompaction(m_fallbackCompactor.get(), m_fallbackCommandList.Get());
+    }
+    else // DirectX Raytracing
+    {
+        return UpdateCompaction(m_dxrCompactor.get(), m_dxrCommandList.Get());
+    }
+}
+
 // Build shader tables.
 // This encapsulates all shader records - shaders and the arguments for their local root signatures.
 void D3D12RaytracingSimpleLighting::BuildShaderTables()
@@ -863,6 +935,7 @@ void D3D12RaytracingSimpleLighting::DoRaytracing()
     commandList->SetComputeRootSignature(m_raytracingGlobalRootSignature.Get());
 
     // Copy the updated scene constant buffer to GPU.
+    // Prepare() has already waited for this frame context, so the GPU is done reading its copy and no further sync is needed.
     memcpy(&m_mappedConstantData[frameIndex].constants, &m_sceneCB[frameIndex], sizeof(m_sceneCB[frameIndex]));
     auto cbGpuAddress = m_perFrameConstants->GetGPUVirtualAddress() + frameIndex * sizeof(m_mappedConstantData[0]);
     commandList->SetComputeRootConstantBufferView(GlobalRootSignatureParams::SceneConstantSlot, cbGpuAddress);
@@ -945,8 +1018,11 @@ void D3D12RaytracingSimpleLighting::ReleaseDeviceDependentResources()
     m_missShaderTable.Reset();
     m_hitGroupShaderTable.Reset();
 
-    m_bottomLevelAccelerationStructure.Reset();
+    m_fallbackCompactor.reset();
+    m_dxrCompactor.reset();
     m_topLevelAccelerationStructure.Reset();
+    m_topLevelScratchResource.Reset();
+    m_instanceDescs.Reset();
 
 }
 
@@ -973,10 +1049,25 @@ void D3D12RaytracingSimpleLighting::OnRender()
     }
 
     m_deviceResources->Prepare();
+    bool compactingAccelerationStructures = UpdateAccelerationStructureCompaction();
     DoRaytracing();
     CopyRaytracingOutputToBackbuffer();
 
     m_deviceResources->Present(D3D12_RESOURCE_STATE_PRESENT);
+
+    // Let the compactor know when this frame's work has completed. Present() releases everything on device lost.
+    if (compactingAccelerationStructures)
+    {
+        auto commandQueue = m_deviceResources->GetCommandQueue();
+        if (m_fallbackCompactor)
+        {
+            m_fallbackCompactor->Signal(commandQueue);
+        }
+        else if (m_dxrCompactor)
+        {
+            m_dxrCompactor->Signal(commandQueue);
+        }
+    }
 }
 
 void D3D12RaytracingSimpleLighting::OnDestroy()
@@ -1058,7 +1149,7 @@ void D3D12RaytracingSimpleLighting::OnSizeChanged(UINT width, UINT height, bool
 }
 
 // Create a wrapped pointer for the Fallback Layer path.
-WRAPPED_GPU_POINTER D3D12RaytracingSimpleLighting::CreateFallbackWrappedPointer(ID3D12Resource* resource, UINT bufferNumElements)
+WRAPPED_GPU_POINTER D3D12RaytracingSimpleLighting::CreateFallbackWrappedPointer(ID3D12Resource* resource, UINT bufferNumElements, UINT64 offsetInBytes)
 {
     auto device = m_deviceResources->GetD3DDevice();
 
@@ -1071,13 +1162,14 @@ WRAPPED_GPU_POINTER D3D12RaytracingSimpleLighting::CreateFallbackWrappedPointer(
     D3D12_CPU_DESCRIPTOR_HANDLE bottomLevelDescriptor;
    
     // Only compute fallback requires a valid descriptor index when creating a wrapped pointer.
-    UINT descriptorHeapIndex = 0;
+    // Acceleration structures suballocated from a larger resource are addressed by their offset into the view.
     if (!m_fallbackDevice->UsingRaytracingDriver())
     {
-        descriptorHeapIndex = AllocateDescriptor(&bottomLevelDescriptor);
+        UINT descriptorHeapIndex = AllocateDescriptor(&bottomLevelDescriptor);
         device->CreateUnorderedAccessView(resource, nullptr, &rawBufferUavDesc, bottomLevelDescriptor);
+        return m_fallbackDevice->GetWrappedPointerFromDescriptorHeapIndex(descriptorHeapIndex, static_cast<UINT32>(offsetInBytes));
     }
-    return m_fallbackDevice->GetWrappedPointerSimple(descriptorHeapIndex, resource->GetGPUVirtualAddress());
+    return m_fallbackDevice->GetWrappedPointerFromGpuVA(resource->GetGPUVirtualAddress() + offsetInBytes);
 }
 
 // Allocate a descriptor and return its index. 
@@ -111,8 +111,14 @@ private:
     D3DBuffer m_vertexBuffer;
 
     // Acceleration structure
-    ComPtr<ID3D12Resource> m_bottomLevelAccelerationStructure;
+    // The bottom level is owned by the compactor, which moves it into a smaller buffer once its compacted size is known.
+    std::unique_ptr<CD3D12_ACCELERATION_STRUCTURE_COMPACTOR<ID3D12RaytracingFallbackDevice, ID3D12RaytracingFallbackCommandList>> m_fallbackCompactor;
+    std::unique_ptr<CD3D12_ACCELERATION_STRUCTURE_COMPACTOR<ID3D12Device5, ID3D12GraphicsCommandList5>> m_dxrCompactor;
+    UINT m_bottomLevelHandle;
     ComPtr<ID3D12Resource> m_topLevelAccelerationStructure;
+    ComPtr<ID3D12Resource> m_topLevelScratchResource;
+    ComPtr<ID3D12Resource> m_instanceDescs;
+    D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_DESC m_topLevelBuildDesc;
 
     // Raytracing output
     ComPtr<ID3D12Resource> m_raytracingOutput;
@@ -157,6 +163,8 @@ private:
     void CreateRaytracingOutputResource();
     void BuildGeometry();
     void BuildAccelerationStructures();
+    void BuildTopLevelAccelerationStructure();
+    bool UpdateAccelerationStructureCompaction();
     void BuildShaderTables();
     void SelectRaytracingAPI(RaytracingAPI type);
     void UpdateForSizeChange(UINT clientWidth, UINT clientHeight);
@@ -164,5 +172,5 @@ private:
     void CalculateFrameStats();
     UINT AllocateDescriptor(D3D12_CPU_DESCRIPTOR_HANDLE* cpuDescriptor, UINT descriptorIndexToUse = UINT_MAX);
     UINT CreateBufferSRV(D3DBuffer* buffer, UINT numElements, UINT elementSize);
-    WRAPPED_GPU_POINTER CreateFallbackWrappedPointer(ID3D12Resource* resource, UINT bufferNumElements);
+    WRAPPED_GPU_POINTER CreateFallbackWrappedPointer(ID3D12Resource* resource, UINT bufferNumElements, UINT64 offsetInBytes = 0);
 };
@@ -35,7 +35,9 @@ namespace
 // Constructor for DeviceResources.
 DeviceResources::DeviceResources(DXGI_FORMAT backBufferFormat, DXGI_FORMAT depthBufferFormat, UINT backBufferCount, D3D_FEATURE_LEVEL minFeatureLevel, UINT flags, UINT adapterIDoverride) :
     m_backBufferIndex(0),
+    m_frameIndex(0),
     m_fenceValues{},
+    m_nextFenceValue(1),
     m_rtvDescriptorSize(0),
     m_screenViewport{},
     m_scissorRect{},
@@ -213,7 +215,7 @@ void DeviceResources::CreateDeviceResources()
         ThrowIfFailed(m_d3dDevice->CreateDescriptorHeap(&dsvDescriptorHeapDesc, IID_PPV_ARGS(&m_dsvDescriptorHeap)));
     }
 
-    // Create a command allocator for each back buffer that will be rendered to.
+    // Create a command allocator for each frame context.
     for (UINT n = 0; n < m_backBufferCount; n++)
     {
         ThrowIfFailed(m_d3dDevice->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&m_commandAllocators[n])));
@@ -224,8 +226,8 @@ void DeviceResources::CreateDeviceResources()
     ThrowIfFailed(m_commandList->Close());
 
     // Create a fence for tracking GPU execution progress.
-    ThrowIfFailed(m_d3dDevice->CreateFence(m_fenceValues[m_backBufferIndex], D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&m_fence)));
-    m_fenceValues[m_backBufferIndex]++;
+    // Starting at the last scheduled value makes every frame context available after a device reset.
+    ThrowIfFailed(m_d3dDevice->CreateFence(m_nextFenceValue - 1, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&m_fence)));
 
     m_fenceEvent.Attach(CreateEvent(nullptr, FALSE, FALSE, nullptr));
     if (!m_fenceEvent.IsValid())
@@ -245,11 +247,10 @@ void DeviceResources::CreateWindowSizeDependentResources()
     // Wait until all previous GPU work is complete.
     WaitForGpu();
 
-    // Release resources that are tied to the swap chain and update fence values.
+    // Release resources that are tied to the swap chain.
     for (UINT n = 0; n < m_backBufferCount; n++)
     {
         m_renderTargets[n].Reset();
-        m_fenceValues[n] = m_fenceValues[m_backBufferIndex];
     }
 
     // Determine the render target size in pixels.
@@ -490,9 +491,19 @@ void DeviceResources::HandleDeviceLost()
 // Prepare the command list and render target for rendering.
 void DeviceResources::Prepare(D3D12_RESOURCE_STATES beforeState)
 {
+    // If the GPU is still executing the last frame recorded with this frame context, wait until it is done.
+    // Waiting here rather than at the end of Present() lets the application update the next frame
+    // while the GPU is still busy with the previous ones.
+    const UINT64 frameFenceValue = m_fenceValues[m_frameIndex];
+    if (m_fence->GetCompletedValue() < frameFenceValue)
+    {
+        ThrowIfFailed(m_fence->SetEventOnCompletion(frameFenceValue, m_fenceEvent.Get()));
+        WaitForSingleObjectEx(m_fenceEvent.Get(), INFINITE, FALSE);
+    }
+
     // Reset command list and allocator.
-    ThrowIfFailed(m_commandAllocators[m_backBufferIndex]->Reset());
-    ThrowIfFailed(m_commandList->Reset(m_commandAllocators[m_backBufferIndex].Get(), nullptr));
+    ThrowIfFailed(m_commandAllocators[m_frameIndex]->Reset());
+    ThrowIfFailed(m_commandList->Reset(m_commandAllocators[m_frameIndex].Get(), nullptr));
 
     if (beforeState != D3D12_RESOURCE_STATE_RENDER_TARGET)
     {
@@ -561,16 +572,15 @@ void DeviceResources::WaitForGpu() noexcept
     if (m_commandQueue && m_fence && m_fenceEvent.IsValid())
     {
         // Schedule a Signal command in the GPU queue.
-        UINT64 fenceValue = m_fenceValues[m_backBufferIndex];
+        UINT64 fenceValue = m_nextFenceValue;
         if (SUCCEEDED(m_commandQueue->Signal(m_fence.Get(), fenceValue)))
         {
+            m_nextFenceValue++;
+
             // Wait until the Signal has been processed.
             if (SUCCEEDED(m_fence->SetEventOnCompletion(fenceValue, m_fenceEvent.Get())))
             {
                 WaitForSingleObjectEx(m_fenceEvent.Get(), INFINITE, FALSE);
-
-                // Increment the fence value for the current frame.
-                m_fenceValues[m_backBufferIndex]++;
             }
         }
     }
@@ -579,22 +589,14 @@ void DeviceResources::WaitForGpu() noexcept
 // Prepare to render the next frame.
 void DeviceResources::MoveToNextFrame()
 {
-    // Schedule a Signal command in the queue.
-    const UINT64 currentFenceValue = m_fenceValues[m_backBufferIndex];
-    ThrowIfFailed(m_commandQueue->Signal(m_fence.Get(), currentFenceValue));
+    // Schedule a Signal command in the queue and remember which value retires the current frame context.
+    ThrowIfFailed(m_commandQueue->Signal(m_fence.Get(), m_nextFenceValue));
+    m_fenceValues[m_frameIndex] = m_nextFenceValue++;
 
-    // Update the back buffer index.
+    // Move on to the next frame context in the ring and the back buffer DXGI hands out next.
+    // Prepare() waits for the frame context only when it is about to be reused.
+    m_frameIndex = (m_frameIndex + 1) % m_backBufferCount;
     m_backBufferIndex = m_swapChain->GetCurrentBackBufferIndex();
-
-    // If the next frame is not ready to be rendered yet, wait until it is ready.
-    if (m_fence->GetCompletedValue() < m_fenceValues[m_backBufferIndex])
-    {
-        ThrowIfFailed(m_fence->SetEventOnCompletion(m_fenceValues[m_backBufferIndex], m_fenceEvent.Get()));
-        WaitForSingleObjectEx(m_fenceEvent.Get(), INFINITE, FALSE);
-    }
-
-    // Set the fence value for the next frame.
-    m_fenceValues[m_backBufferIndex] = currentFenceValue + 1;
 }
 
 // This method acquires the first available hardware adapter that supports Direct3D 12.
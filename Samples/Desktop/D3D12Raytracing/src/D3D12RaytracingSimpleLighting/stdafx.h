@@ -42,6 +42,7 @@
 #include "D3D12RaytracingFallback.h"
 #include "D3D12RaytracingHelpers.hpp"
 #include "d3dx12.h"
+#include "D3D12RaytracingCompactionHelpers.hpp"
 
 #include <DirectXMath.h>
 
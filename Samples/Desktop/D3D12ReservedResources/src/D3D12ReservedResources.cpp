@@ -12,6 +12,8 @@
 #include "stdafx.h"
 #include "D3D12ReservedResources.h"
 
+const float D3D12ReservedResources::MinZoom = 1.0f / 64.0f;
+
 D3D12ReservedResources::D3D12ReservedResources(UINT width, UINT height, std::wstring name) :
     DXSample(width, height, name),
     m_frameIndex(0),
@@ -19,18 +21,15 @@ D3D12ReservedResources::D3D12ReservedResources(UINT width, UINT height, std::wst
     m_scissorRect(0, 0, static_cast<LONG>(width), static_cast<LONG>(height)),
     m_rtvDescriptorSize(0),
     m_tilingSupport(false),
-    m_packedMipInfo(),
-    m_activeMip(0),
-    m_activeMipChanged(true),
+    m_tileStreamer(TextureWidth, TextureHeight, TilePoolSize, MaxTileUploadsPerFrame, FrameCount),
+    m_zoom(1.0f),
+    m_mappedTileCount(UINT_MAX),
+    m_evictionCount(0),
     m_fenceValues{}
 {
-    UINT mipLevels = 0;
-    for (UINT w = TextureWidth, h = TextureHeight; w > 0 && h > 0; w >>= 1, h >>= 1)
-    {
-        mipLevels++;
-    }
-    m_activeMip = mipLevels - 1;    // Show the least detailed mip first.
-    m_mips.resize(mipLevels);
+    m_rootConstants.uvScale = XMFLOAT2(1.0f, 1.0f);
+    m_rootConstants.uvOffset = XMFLOAT2(0.0f, 0.0f);
+    m_rootConstants.frameNumber = 0;
 }
 
 void D3D12ReservedResources::OnInit()
@@ -111,6 +110,7 @@ void D3D12ReservedResources::LoadPipeline()
     queueDesc.Type = D3D12_COMMAND_LIST_TYPE_DIRECT;
 
     ThrowIfFailed(m_device->CreateCommandQueue(&queueDesc, IID_PPV_ARGS(&m_commandQueue)));
+    SetBenchmarkCommandQueue(m_device.Get(), m_commandQueue.Get());
 
     // Describe and create the swap chain.
     DXGI_SWAP_CHAIN_DESC1 swapChainDesc = {};
@@ -147,9 +147,10 @@ void D3D12ReservedResources::LoadPipeline()
         rtvHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
         ThrowIfFailed(m_device->CreateDescriptorHeap(&rtvHeapDesc, IID_PPV_ARGS(&m_rtvHeap)));
 
-        // Describe and create a shader resource view (SRV) heap for the reserved resource.
+        // Describe and create a shader resource view (SRV) heap for the reserved resource
+        // and the views the tile streamer uses along with it.
         D3D12_DESCRIPTOR_HEAP_DESC srvHeapDesc = {};
-        srvHeapDesc.NumDescriptors = 1;
+        srvHeapDesc.NumDescriptors = TileStreamer::DescriptorCount;
         srvHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
         srvHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
         ThrowIfFailed(m_device->CreateDescriptorHeap(&srvHeapDesc, IID_PPV_ARGS(&m_srvHeap)));
@@ -188,15 +189,16 @@ void D3D12ReservedResources::LoadAssets()
             featureData.HighestVersion = D3D_ROOT_SIGNATURE_VERSION_1_0;
         }
 
-        // We don't modify the SRV in the command list after SetGraphicsRootDescriptorTable
-        // is executed on the GPU so we can use the default range behavior:
-        // D3D12_DESCRIPTOR_RANGE_FLAG_DATA_STATIC_WHILE_SET_AT_EXECUTE
-        CD3DX12_DESCRIPTOR_RANGE1 ranges[1];
-        ranges[0].Init(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 1, 0);
+        // The reserved texture is remapped and the residency map is updated between
+        // frames, so the SRVs use the volatile range behavior. The feedback UAV is
+        // written by the pixel shader.
+        CD3DX12_DESCRIPTOR_RANGE1 ranges[2];
+        ranges[0].Init(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 2, 0, 0, D3D12_DESCRIPTOR_RANGE_FLAG_DATA_VOLATILE);
+        ranges[1].Init(D3D12_DESCRIPTOR_RANGE_TYPE_UAV, 1, 0, 0, D3D12_DESCRIPTOR_RANGE_FLAG_DATA_VOLATILE);
 
         CD3DX12_ROOT_PARAMETER1 rootParameters[2];
-        rootParameters[0].InitAsConstants(1, 0, 0, D3D12_SHADER_VISIBILITY_PIXEL);
-        rootParameters[1].InitAsDescriptorTable(1, &ranges[0], D3D12_SHADER_VISIBILITY_PIXEL);
+        rootParameters[0].InitAsConstants(sizeof(RootConstants) / sizeof(UINT32), 0, 0, D3D12_SHADER_VISIBILITY_ALL);
+        rootParameters[1].InitAsDescriptorTable(_countof(ranges), &ranges[0], D3D12_SHADER_VISIBILITY_PIXEL);
 
         D3D12_STATIC_SAMPLER_DESC sampler = {};
         sampler.Filter = D3D12_FILTER_MIN_MAG_MIP_LINEAR;
@@ -278,10 +280,10 @@ void D3D12ReservedResources::LoadAssets()
         // Create geometry for a quad.
         Vertex quadVertices[] =
         {
-            { { -0.25f, -0.25f * m_aspectRatio, 0.0f }, { 0.0f, 1.0f } },    // Bottom left.
-            { { -0.25f, 0.25f * m_aspectRatio, 0.0f }, { 0.0f, 0.0f } },    // Top left.
-            { { 0.25f, -0.25f * m_aspectRatio, 0.0f }, { 1.0f, 1.0f } },    // Bottom right.
-            { { 0.25f, 0.25f * m_aspectRatio, 0.0f }, { 1.0f, 0.0f } },        // Top right.
+            { { -0.5f, -0.5f * m_aspectRatio, 0.0f }, { 0.0f, 1.0f } },    // Bottom left.
+            { { -0.5f, 0.5f * m_aspectRatio, 0.0f }, { 0.0f, 0.0f } },    // Top left.
+            { { 0.5f, -0.5f * m_aspectRatio, 0.0f }, { 1.0f, 1.0f } },    // Bottom right.
+            { { 0.5f, 0.5f * m_aspectRatio, 0.0f }, { 1.0f, 0.0f } },        // Top right.
         };
 
         const UINT vertexBufferSize = sizeof(quadVertices);
@@ -318,109 +320,9 @@ void D3D12ReservedResources::LoadAssets()
         m_vertexBufferView.SizeInBytes = sizeof(quadVertices);
     }
 
-    // Create the reserved texture and map the low-resolution mips into it.
-    {
-        // Describe and create a reserved Texture2D. This resource has no backing texture
-        // when it is created. It will be mapped to a physical resource dynamically.
-        D3D12_RESOURCE_DESC reservedTextureDesc = {};
-        reservedTextureDesc.MipLevels = static_cast<UINT16>(m_mips.size());
-        reservedTextureDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
-        reservedTextureDesc.Width = TextureWidth;
-        reservedTextureDesc.Height = TextureHeight;
-        reservedTextureDesc.Flags = D3D12_RESOURCE_FLAG_NONE;
-        reservedTextureDesc.DepthOrArraySize = 1;
-        reservedTextureDesc.SampleDesc.Count = 1;
-        reservedTextureDesc.SampleDesc.Quality = 0;
-        reservedTextureDesc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
-        reservedTextureDesc.Layout = D3D12_TEXTURE_LAYOUT_64KB_UNDEFINED_SWIZZLE;
-
-        ThrowIfFailed(m_device->CreateReservedResource(
-            &reservedTextureDesc,
-            D3D12_RESOURCE_STATE_COPY_DEST,
-            nullptr,
-            IID_PPV_ARGS(&m_reservedResource)));
-
-        // Describe and create a SRV for the resource.
-        D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
-        srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
-        srvDesc.Format = reservedTextureDesc.Format;
-        srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
-        srvDesc.Texture2D.MipLevels = reservedTextureDesc.MipLevels;
-        m_device->CreateShaderResourceView(m_reservedResource.Get(), &srvDesc, m_srvHeap->GetCPUDescriptorHandleForHeapStart());
-
-        // Create an upload heap big enough to fit the largest mip.
-        const UINT64 resourceSize = GetRequiredIntermediateSize(m_reservedResource.Get(), 0, 1);
-
-        // Create the GPU upload buffer.
-        ThrowIfFailed(m_device->CreateCommittedResource(
-            &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
-            D3D12_HEAP_FLAG_NONE,
-            &CD3DX12_RESOURCE_DESC::Buffer(resourceSize),
-            D3D12_RESOURCE_STATE_GENERIC_READ,
-            nullptr,
-            IID_PPV_ARGS(&m_uploadHeap)));
-
-        // Get information about the tile layout for the resource.
-        //
-        // The GetResourceTiling method should always be used rather than manually
-        // calculating it since the tile information is dependent on the driver
-        // implementation.
-
-        UINT numTiles = 0;
-        D3D12_TILE_SHAPE tileShape = {};
-        UINT subresourceCount = reservedTextureDesc.MipLevels;
-        std::vector<D3D12_SUBRESOURCE_TILING> tilings(subresourceCount);
-        m_device->GetResourceTiling(m_reservedResource.Get(), &numTiles, &m_packedMipInfo, &tileShape, &subresourceCount, 0, &tilings[0]);
-
-        UINT heapCount = m_packedMipInfo.NumStandardMips + (m_packedMipInfo.NumPackedMips > 0 ? 1 : 0);
-        for (UINT n = 0; n < m_mips.size(); n++)
-        {
-            if (n < m_packedMipInfo.NumStandardMips)
-            {
-                m_mips[n].heapIndex = n;
-                m_mips[n].packedMip = false;
-                m_mips[n].mapped = false;
-                m_mips[n].startCoordinate = CD3DX12_TILED_RESOURCE_COORDINATE(0, 0, 0, n);
-                m_mips[n].regionSize.Width = tilings[n].WidthInTiles;
-                m_mips[n].regionSize.Height = tilings[n].HeightInTiles;
-                m_mips[n].regionSize.Depth = tilings[n].DepthInTiles;
-                m_mips[n].regionSize.NumTiles = tilings[n].WidthInTiles * tilings[n].HeightInTiles * tilings[n].DepthInTiles;
-                m_mips[n].regionSize.UseBox = TRUE;
-            }
-            else
-            {
-                // All of the packed mips will go into the last heap.
-                m_mips[n].heapIndex = heapCount - 1;
-                m_mips[n].packedMip = true;
-                m_mips[n].mapped = false;
-
-                // Mark all of the packed mips as having the same start coordinate and size.
-                m_mips[n].startCoordinate = CD3DX12_TILED_RESOURCE_COORDINATE(0, 0, 0, heapCount - 1);
-                m_mips[n].regionSize.NumTiles = m_packedMipInfo.NumTilesForPackedMips;
-                m_mips[n].regionSize.UseBox = FALSE;    // regionSize.Width/Height/Depth will be ignored.
-            }
-        }
-
-        // Describe and create heaps for the mips in the mip chain to be used by the
-        // reserved resource. The packed mips will all be stored in the same heap.
-        // 
-        // You could also put all of the mips in the same heap, but we do it this way
-        // in the sample to illustrate the ability to map tiles from multiple heaps
-        // into the same reserved resource.
-
-        m_heaps.resize(heapCount);
-        for (UINT n = 0; n < heapCount; n++)
-        {
-            const UINT heapSize = m_mips[n].regionSize.NumTiles * D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
-
-            CD3DX12_HEAP_DESC heapDesc(heapSize, D3D12_HEAP_TYPE_DEFAULT, 0, D3D12_HEAP_FLAG_DENY_BUFFERS | D3D12_HEAP_FLAG_DENY_RT_DS_TEXTURES);
-            ThrowIfFailed(m_device->CreateHeap(&heapDesc, IID_PPV_ARGS(&m_heaps[n])));
-        }
-
-        UpdateTileMapping();
-
-        m_commandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(m_reservedResource.Get(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE));
-    }
+    // Create the reserved texture and the objects used to stream its tiles. The
+    // packed mips are uploaded by the tile streamer before it returns.
+    m_tileStreamer.OnInit(m_device.Get(), m_srvHeap->GetCPUDescriptorHandleForHeapStart(), m_srvHeap->GetGPUDescriptorHandleForHeapStart());
 
     // Close the command list and execute it to begin the vertex buffer copy into
     // the default heap.
@@ -447,154 +349,43 @@ void D3D12ReservedResources::LoadAssets()
     }
 }
 
-// Generate and upload the texture corresponding to the active mip level then
-// map it to the reserved resource.
-void D3D12ReservedResources::UpdateTileMapping()
+// Move the visible part of the texture, in units of the visible size.
+void D3D12ReservedResources::Pan(float x, float y)
 {
-    UINT firstSubresource = m_mips[m_activeMip].heapIndex;
-    UINT subresourceCount = m_mips[m_activeMip].packedMip ? m_packedMipInfo.NumPackedMips : 1;
-
-    // Only update tile mappings if necessary.
-    if (!m_mips[firstSubresource].mapped)
-    {
-        // Generate the texture data for the active mip level.
-        // If the mip level corresponds to a packed mip, generate all the packed mips.
-        std::vector<UINT8> texture = GenerateTextureData(firstSubresource, subresourceCount);
-
-        // Update the tile mappings on the reserved resource.
-        {
-            UINT updatedRegions = 0;
-            std::vector<D3D12_TILED_RESOURCE_COORDINATE> startCoordinates;
-            std::vector<D3D12_TILE_REGION_SIZE> regionSizes;
-            std::vector<D3D12_TILE_RANGE_FLAGS> rangeFlags;
-            std::vector<UINT> heapRangeStartOffsets;
-            std::vector<UINT> rangeTileCounts;
-
-            for (UINT n = 0; n < m_heaps.size(); n++)
-            {
-                if (!m_mips[n].mapped && n != firstSubresource)
-                {
-                    // Skip unchanged tile regions.
-                    continue;
-                }
-
-                startCoordinates.push_back(m_mips[n].startCoordinate);
-                regionSizes.push_back(m_mips[n].regionSize);
-
-                if (n == firstSubresource)
-                {
-                    // Map the currently active mip.
-                    rangeFlags.push_back(D3D12_TILE_RANGE_FLAG_NONE);
-                    m_mips[n].mapped = true;
-                }
-                else
-                {
-                    // Unmap the previously active mip.
-                    assert(m_mips[n].mapped);
-
-                    rangeFlags.push_back(D3D12_TILE_RANGE_FLAG_NULL);
-                    m_mips[n].mapped = false;
-                }
-                heapRangeStartOffsets.push_back(0);        // In this sample, each heap contains only one tile region.
-                rangeTileCounts.push_back(m_mips[n].regionSize.NumTiles);
-
-                updatedRegions++;
-            }
-
-            m_commandQueue->UpdateTileMappings(
-                m_reservedResource.Get(),
-                updatedRegions,
-                &startCoordinates[0],
-                &regionSizes[0],
-                m_heaps[firstSubresource].Get(),
-                updatedRegions,
-                &rangeFlags[0],
-                &heapRangeStartOffsets[0],
-                &rangeTileCounts[0],
-                D3D12_TILE_MAPPING_FLAG_NONE
-                );
-        }
-
-        // Upload the mip(s) to the GPU and copy them to the reserved resource.
-        {
-            UINT mipOffset = 0;
-            std::vector<D3D12_SUBRESOURCE_DATA> data(subresourceCount);
-            for (UINT n = 0; n < subresourceCount; n++)
-            {
-                UINT currentMip = firstSubresource + n;
-
-                data[n].pData = &texture[mipOffset];
-                data[n].RowPitch = (TextureWidth >> currentMip) * TexturePixelSizeInBytes;
-                data[n].SlicePitch = data[n].RowPitch * (TextureHeight >> currentMip);
-
-                mipOffset += static_cast<UINT>(data[n].SlicePitch);
-            }
-
-            UpdateSubresources(m_commandList.Get(), m_reservedResource.Get(), m_uploadHeap.Get(), 0, firstSubresource, subresourceCount, &data[0]);
-        }
-    }
-
-    m_activeMipChanged = false;
+    m_rootConstants.uvOffset.x = min(max(m_rootConstants.uvOffset.x + x * m_zoom, 0.0f), 1.0f - m_zoom);
+    m_rootConstants.uvOffset.y = min(max(m_rootConstants.uvOffset.y + y * m_zoom, 0.0f), 1.0f - m_zoom);
+}
 
-    WCHAR message[100];
-    swprintf_s(message, L"Mip Level: %d", m_activeMip);
-    SetCustomWindowText(message);
+// Scale the visible part of the texture around its center.
+void D3D12ReservedResources::Zoom(float scale)
+{
+    const float zoom = min(max(m_zoom * scale, MinZoom), 1.0f);
+    const float centerX = m_rootConstants.uvOffset.x + m_zoom * 0.5f;
+    const float centerY = m_rootConstants.uvOffset.y + m_zoom * 0.5f;
+
+    m_zoom = zoom;
+    m_rootConstants.uvScale = XMFLOAT2(m_zoom, m_zoom);
+    m_rootConstants.uvOffset = XMFLOAT2(centerX - m_zoom * 0.5f, centerY - m_zoom * 0.5f);
+    Pan(0.0f, 0.0f);
 }
 
-// Generate a simple red and white checkerboard texture.
-std::vector<UINT8> D3D12ReservedResources::GenerateTextureData(UINT firstMip, UINT mipCount)
+void D3D12ReservedResources::UpdateWindowText()
 {
-    // Determine the size of the data required by the mips(s).
-    UINT dataSize = (TextureWidth >> firstMip) * (TextureHeight >> firstMip) * TexturePixelSizeInBytes;
-    if (mipCount > 1)
+    if (m_mappedTileCount != m_tileStreamer.GetMappedTileCount() || m_evictionCount != m_tileStreamer.GetEvictionCount())
     {
-        // If generating more than 1 mip, double the size of the texture allocation
-        // (you will never need more than this).
-        dataSize *= 2;
-    }
-    std::vector<UINT8> data(dataSize);
-    UINT8* pData = &data[0];
+        m_mappedTileCount = m_tileStreamer.GetMappedTileCount();
+        m_evictionCount = m_tileStreamer.GetEvictionCount();
 
-    UINT index = 0;
-    for (UINT n = 0; n < mipCount; n++)
-    {
-        const UINT currentMip = firstMip + n;
-        const UINT width = TextureWidth >> currentMip;
-        const UINT height = TextureHeight >> currentMip;
-        const UINT rowPitch = width * TexturePixelSizeInBytes;
-        const UINT cellPitch = max(rowPitch >> 3, TexturePixelSizeInBytes);    // The width of a cell in the checkboard texture.
-        const UINT cellHeight = max(height >> 3, 1);                        // The height of a cell in the checkerboard texture.
-        const UINT textureSize = rowPitch * height;
-
-        for (UINT m = 0; m < textureSize; m += TexturePixelSizeInBytes)
-        {
-            UINT x = m % rowPitch;
-            UINT y = m / rowPitch;
-            UINT i = x / cellPitch;
-            UINT j = y / cellHeight;
-
-            if (i % 2 == j % 2)
-            {
-                pData[index++] = 0xff;    // R
-                pData[index++] = 0x00;    // G
-                pData[index++] = 0x00;    // B
-                pData[index++] = 0xff;    // A
-            }
-            else
-            {
-                pData[index++] = 0xff;    // R
-                pData[index++] = 0xff;    // G
-                pData[index++] = 0xff;    // B
-                pData[index++] = 0xff;    // A
-            }
-        }
+        WCHAR message[100];
+        swprintf_s(message, L"Mapped tiles: %u/%u, Evictions: %u", m_mappedTileCount, m_tileStreamer.GetPoolTileCount(), m_evictionCount);
+        SetCustomWindowText(message);
     }
-    return data;
 }
 
 // Update frame-based values.
 void D3D12ReservedResources::OnUpdate()
 {
+    UpdateWindowText();
 }
 
 // Render the scene.
@@ -605,12 +396,15 @@ void D3D12ReservedResources::OnRender()
         // Record all the commands we need to render the scene into the command list.
         PopulateCommandList();
 
+        // Don't sample the tiles uploaded last frame until their upload completes.
+        m_tileStreamer.WaitForUploads(m_commandQueue.Get());
+
         // Execute the command list.
         ID3D12CommandList* ppCommandLists[] = { m_commandList.Get() };
         m_commandQueue->ExecuteCommandLists(_countof(ppCommandLists), ppCommandLists);
 
         // Present the frame.
-        ThrowIfFailed(m_swapChain->Present(1, 0));
+        ThrowIfFailed(m_swapChain->Present(GetSyncInterval(), 0));
 
         MoveToNextFrame();
     }
@@ -623,6 +417,7 @@ void D3D12ReservedResources::OnDestroy()
         // Ensure that the GPU is no longer referencing resources that are about to be
         // cleaned up by the destructor.
         WaitForGpu();
+        m_tileStreamer.WaitForGpu();
 
         CloseHandle(m_fenceEvent);
     }
@@ -633,21 +428,29 @@ void D3D12ReservedResources::OnKeyDown(UINT8 key)
     switch (key)
     {
     case VK_LEFT:
-    case VK_UP:
-        if (m_activeMip != 0)
-        {
-            m_activeMip--;
-            m_activeMipChanged = true;
-        }
+        Pan(-0.1f, 0.0f);
         break;
 
     case VK_RIGHT:
+        Pan(0.1f, 0.0f);
+        break;
+
+    case VK_UP:
+        Pan(0.0f, -0.1f);
+        break;
+
     case VK_DOWN:
-        if (m_activeMip < m_mips.size() - 1)
-        {
-            m_activeMip++;
-            m_activeMipChanged = true;
-        }
+        Pan(0.0f, 0.1f);
+        break;
+
+    case VK_ADD:
+    case VK_OEM_PLUS:
+        Zoom(0.5f);
+        break;
+
+    case VK_SUBTRACT:
+    case VK_OEM_MINUS:
+        Zoom(2.0f);
         break;
     }
 }
@@ -665,20 +468,17 @@ void D3D12ReservedResources::PopulateCommandList()
     // re-recording.
     ThrowIfFailed(m_commandList->Reset(m_commandAllocators[m_frameIndex].Get(), m_pipelineState.Get()));
 
-    if (m_activeMipChanged)
-    {
-        m_commandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(m_reservedResource.Get(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_COPY_DEST));
-        UpdateTileMapping();
-        m_commandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(m_reservedResource.Get(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE));
-    }
-
-    // Set necessary state.
-    m_commandList->SetGraphicsRootSignature(m_rootSignature.Get());
-
     ID3D12DescriptorHeap* ppHeaps[] = { m_srvHeap.Get() };
     m_commandList->SetDescriptorHeaps(_countof(ppHeaps), ppHeaps);
 
-    m_commandList->SetGraphicsRoot32BitConstant(0, m_activeMip, 0);
+    // Stream in the tiles requested by earlier frames. The last frame submitted is
+    // the one signaling the fence value preceding this frame's.
+    m_tileStreamer.BeginFrame(m_commandList.Get(), m_frameIndex, m_fence.Get(), m_fenceValues[m_frameIndex] - 1);
+    m_rootConstants.frameNumber++;
+
+    // Set necessary state.
+    m_commandList->SetGraphicsRootSignature(m_rootSignature.Get());
+    m_commandList->SetGraphicsRoot32BitConstants(0, sizeof(RootConstants) / sizeof(UINT32), &m_rootConstants, 0);
     m_commandList->SetGraphicsRootDescriptorTable(1, m_srvHeap->GetGPUDescriptorHandleForHeapStart());
     m_commandList->RSSetViewports(1, &m_viewport);
     m_commandList->RSSetScissorRects(1, &m_scissorRect);
@@ -696,6 +496,8 @@ void D3D12ReservedResources::PopulateCommandList()
     m_commandList->IASetVertexBuffers(0, 1, &m_vertexBufferView);
     m_commandList->DrawInstanced(4, 1, 0, 0);
 
+    m_tileStreamer.EndFrame(m_commandList.Get());
+
     // Indicate that the back buffer will now be used to present.
     m_commandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(m_renderTargets[m_frameIndex].Get(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PRESENT));
 
@@ -12,6 +12,7 @@
 #pragma once
 
 #include "DXSample.h"
+#include "TileStreamer.h"
 
 using namespace DirectX;
 
@@ -35,9 +36,11 @@ public:
 
 private:
     static const UINT FrameCount = 2;
-    static const UINT TextureWidth = 256;
-    static const UINT TextureHeight = 256;
-    static const UINT TexturePixelSizeInBytes = 4;
+    static const UINT TextureWidth = 16384;
+    static const UINT TextureHeight = 16384;
+    static const UINT TilePoolSize = 512;               // In 64KB tiles, 32MB in total.
+    static const UINT MaxTileUploadsPerFrame = 32;
+    static const float MinZoom;
 
     // Vertex definition.
     struct Vertex
@@ -46,14 +49,12 @@ private:
         XMFLOAT2 uv;
     };
 
-    // Information about the mips in the reserved resource.
-    struct MipInfo
+    // Root constants used to place the quad's texture coordinates in the texture.
+    struct RootConstants
     {
-        UINT heapIndex;
-        bool packedMip;
-        bool mapped;
-        D3D12_TILED_RESOURCE_COORDINATE startCoordinate;
-        D3D12_TILE_REGION_SIZE regionSize;
+        XMFLOAT2 uvScale;
+        XMFLOAT2 uvOffset;
+        UINT frameNumber;
     };
 
     // Pipeline objects.
@@ -81,18 +82,17 @@ private:
     ComPtr<ID3D12GraphicsCommandList> m_commandList;
     ComPtr<ID3D12Resource> m_vertexBuffer;
     D3D12_VERTEX_BUFFER_VIEW m_vertexBufferView;
-    ComPtr<ID3D12Resource> m_uploadHeap;
-    ComPtr<ID3D12Resource> m_reservedResource;
-    std::vector<ComPtr<ID3D12Heap>> m_heaps;
-    std::vector<MipInfo> m_mips;
-    D3D12_PACKED_MIP_INFO m_packedMipInfo;
-    UINT m_activeMip;
-    bool m_activeMipChanged;
+    TileStreamer m_tileStreamer;
+    RootConstants m_rootConstants;
+    float m_zoom;
+    UINT m_mappedTileCount;
+    UINT m_evictionCount;
 
     void LoadPipeline();
     void LoadAssets();
-    std::vector<UINT8> GenerateTextureData(UINT firstMip, UINT lastMip);
-    void UpdateTileMapping();
+    void Pan(float x, float y);
+    void Zoom(float scale);
+    void UpdateWindowText();
     void PopulateCommandList();
     void WaitForGpu();
     void MoveToNextFrame();
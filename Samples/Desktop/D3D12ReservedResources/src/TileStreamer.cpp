@@ -0,0 +1,669 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#include "stdafx.h"
+#include "TileStreamer.h"
+
+TileStreamer::TileStreamer(UINT width, UINT height, UINT poolTileCount, UINT maxUploadsPerFrame, UINT frameCount) :
+    m_width(width),
+    m_height(height),
+    m_mipCount(0),
+    m_poolTileCount(poolTileCount),
+    m_maxUploadsPerFrame(maxUploadsPerFrame),
+    m_frameCount(frameCount),
+    m_frameIndex(0),
+    m_frameNumber(0),
+    m_packedMipInfo(),
+    m_tileShape(),
+    m_feedbackWidth(0),
+    m_feedbackHeight(0),
+    m_feedbackFootprint(),
+    m_feedbackReadbackSize(0),
+    m_feedbackUavHandle(),
+    m_residencyChanged(true),
+    m_copyFenceValue(0),
+    m_residentUploadFenceValue(0),
+    m_copyFenceEvent(nullptr),
+    m_uploadCount(0),
+    m_evictionCount(0)
+{
+    for (UINT w = m_width, h = m_height; w > 0 && h > 0; w >>= 1, h >>= 1)
+    {
+        m_mipCount++;
+    }
+
+    m_copyCommandAllocators.resize(m_frameCount);
+    m_uploadBuffers.resize(m_frameCount);
+    m_uploadBufferPointers.resize(m_frameCount);
+    m_feedbackReadbackBuffers.resize(m_frameCount);
+    m_feedbackValid.resize(m_frameCount, false);
+    m_residencyUploadBuffers.resize(m_frameCount);
+    m_residencyUploadPointers.resize(m_frameCount);
+    m_copyFenceValues.resize(m_frameCount, 0);
+}
+
+TileStreamer::~TileStreamer()
+{
+    if (m_copyFenceEvent)
+    {
+        CloseHandle(m_copyFenceEvent);
+    }
+}
+
+// Create the reserved texture along with the objects used to stream it and
+// upload its packed mips. The descriptors are created at the given handles.
+void TileStreamer::OnInit(ID3D12Device* pDevice, D3D12_CPU_DESCRIPTOR_HANDLE cpuDescriptorHandle, D3D12_GPU_DESCRIPTOR_HANDLE gpuDescriptorHandle)
+{
+    const UINT descriptorSize = pDevice->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+    CD3DX12_CPU_DESCRIPTOR_HANDLE cpuHandle(cpuDescriptorHandle);
+
+    // Describe and create a reserved Texture2D. This resource has no backing memory
+    // when it is created. Tiles are mapped to the pool as they are requested.
+    //
+    // The texture is written on the copy queue and read on the direct queue, so it
+    // is left in the COMMON state and relies on implicit state promotion and decay.
+    {
+        D3D12_RESOURCE_DESC textureDesc = {};
+        textureDesc.MipLevels = static_cast<UINT16>(m_mipCount);
+        textureDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+        textureDesc.Width = m_width;
+        textureDesc.Height = m_height;
+        textureDesc.Flags = D3D12_RESOURCE_FLAG_NONE;
+        textureDesc.DepthOrArraySize = 1;
+        textureDesc.SampleDesc.Count = 1;
+        textureDesc.SampleDesc.Quality = 0;
+        textureDesc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+        textureDesc.Layout = D3D12_TEXTURE_LAYOUT_64KB_UNDEFINED_SWIZZLE;
+
+        ThrowIfFailed(pDevice->CreateReservedResource(
+            &textureDesc,
+            D3D12_RESOURCE_STATE_COMMON,
+            nullptr,
+            IID_PPV_ARGS(&m_texture)));
+        NAME_D3D12_OBJECT(m_texture);
+
+        D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+        srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+        srvDesc.Format = textureDesc.Format;
+        srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
+        srvDesc.Texture2D.MipLevels = textureDesc.MipLevels;
+        pDevice->CreateShaderResourceView(m_texture.Get(), &srvDesc, cpuHandle);
+        cpuHandle.Offset(1, descriptorSize);
+
+        // Get information about the tile layout for the resource.
+        //
+        // The GetResourceTiling method should always be used rather than manually
+        // calculating it since the tile information is dependent on the driver
+        // implementation.
+        UINT numTiles = 0;
+        UINT subresourceCount = m_mipCount;
+        m_tilings.resize(subresourceCount);
+        pDevice->GetResourceTiling(m_texture.Get(), &numTiles, &m_packedMipInfo, &m_tileShape, &subresourceCount, 0, &m_tilings[0]);
+
+        m_feedbackWidth = m_tilings[0].WidthInTiles;
+        m_feedbackHeight = m_tilings[0].HeightInTiles;
+
+        m_requestedTiles.resize(m_packedMipInfo.NumStandardMips);
+        m_residentMips.resize(m_feedbackWidth * m_feedbackHeight);
+    }
+
+    // Describe and create the tile pool. This is the only memory backing the
+    // standard mips, no matter how large the texture is.
+    {
+        CD3DX12_HEAP_DESC heapDesc(m_poolTileCount * D3D12_TILED_RESOURCE_TILE_SIZE_IN_BYTES, D3D12_HEAP_TYPE_DEFAULT, 0, D3D12_HEAP_FLAG_DENY_BUFFERS | D3D12_HEAP_FLAG_DENY_RT_DS_TEXTURES);
+        ThrowIfFailed(pDevice->CreateHeap(&heapDesc, IID_PPV_ARGS(&m_tileHeap)));
+        NAME_D3D12_OBJECT(m_tileHeap);
+
+        for (UINT n = m_poolTileCount; n > 0; n--)
+        {
+            m_freePoolTiles.push_back(n - 1);
+        }
+    }
+
+    // Describe and create the residency map, holding the finest resident mip for each mip 0 tile,
+    // along with an upload buffer for each frame to update it from.
+    {
+        const UINT64 residencyBufferSize = m_feedbackWidth * m_feedbackHeight * sizeof(UINT);
+        ThrowIfFailed(pDevice->CreateCommittedResource(
+            &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT),
+            D3D12_HEAP_FLAG_NONE,
+            &CD3DX12_RESOURCE_DESC::Buffer(residencyBufferSize),
+            D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE,
+            nullptr,
+            IID_PPV_ARGS(&m_residencyBuffer)));
+        NAME_D3D12_OBJECT(m_residencyBuffer);
+
+        D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+        srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+        srvDesc.Format = DXGI_FORMAT_R32_UINT;
+        srvDesc.ViewDimension = D3D12_SRV_DIMENSION_BUFFER;
+        srvDesc.Buffer.NumElements = m_feedbackWidth * m_feedbackHeight;
+        pDevice->CreateShaderResourceView(m_residencyBuffer.Get(), &srvDesc, cpuHandle);
+        cpuHandle.Offset(1, descriptorSize);
+
+        CD3DX12_RANGE readRange(0, 0);        // We do not intend to read from these resources on the CPU.
+        for (UINT n = 0; n < m_frameCount; n++)
+        {
+            ThrowIfFailed(pDevice->CreateCommittedResource(
+                &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
+                D3D12_HEAP_FLAG_NONE,
+                &CD3DX12_RESOURCE_DESC::Buffer(residencyBufferSize),
+                D3D12_RESOURCE_STATE_GENERIC_READ,
+                nullptr,
+                IID_PPV_ARGS(&m_residencyUploadBuffers[n])));
+            ThrowIfFailed(m_residencyUploadBuffers[n]->Map(0, &readRange, reinterpret_cast<void**>(&m_residencyUploadPointers[n])));
+        }
+    }
+
+    // Describe and create the feedback texture, holding the finest mip requested for each
+    // mip 0 tile, along with a readback buffer for each frame.
+    {
+        CD3DX12_RESOURCE_DESC feedbackDesc = CD3DX12_RESOURCE_DESC::Tex2D(DXGI_FORMAT_R32_UINT, m_feedbackWidth, m_feedbackHeight, 1, 1, 1, 0, D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
+        ThrowIfFailed(pDevice->CreateCommittedResource(
+            &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT),
+            D3D12_HEAP_FLAG_NONE,
+            &feedbackDesc,
+            D3D12_RESOURCE_STATE_UNORDERED_ACCESS,
+            nullptr,
+            IID_PPV_ARGS(&m_feedbackTexture)));
+        NAME_D3D12_OBJECT(m_feedbackTexture);
+
+        D3D12_UNORDERED_ACCESS_VIEW_DESC uavDesc = {};
+        uavDesc.Format = DXGI_FORMAT_R32_UINT;
+        uavDesc.ViewDimension = D3D12_UAV_DIMENSION_TEXTURE2D;
+        pDevice->CreateUnorderedAccessView(m_feedbackTexture.Get(), nullptr, &uavDesc, cpuHandle);
+        m_feedbackUavHandle = CD3DX12_GPU_DESCRIPTOR_HANDLE(gpuDescriptorHandle, 2, descriptorSize);
+
+        // ClearUnorderedAccessViewUint needs the UAV in a CPU visible heap as well.
+        D3D12_DESCRIPTOR_HEAP_DESC clearHeapDesc = {};
+        clearHeapDesc.NumDescriptors = 1;
+        clearHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
+        clearHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
+        ThrowIfFailed(pDevice->CreateDescriptorHeap(&clearHeapDesc, IID_PPV_ARGS(&m_feedbackClearHeap)));
+        pDevice->CreateUnorderedAccessView(m_feedbackTexture.Get(), nullptr, &uavDesc, m_feedbackClearHeap->GetCPUDescriptorHandleForHeapStart());
+
+        pDevice->GetCopyableFootprints(&feedbackDesc, 0, 1, 0, &m_feedbackFootprint, nullptr, nullptr, &m_feedbackReadbackSize);
+        for (UINT n = 0; n < m_frameCount; n++)
+        {
+            ThrowIfFailed(pDevice->CreateCommittedResource(
+                &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_READBACK),
+                D3D12_HEAP_FLAG_NONE,
+                &CD3DX12_RESOURCE_DESC::Buffer(m_feedbackReadbackSize),
+                D3D12_RESOURCE_STATE_COPY_DEST,
+                nullptr,
+                IID_PPV_ARGS(&m_feedbackReadbackBuffers[n])));
+        }
+    }
+
+    // Create the copy queue objects used for uploading tiles.
+    {
+        D3D12_COMMAND_QUEUE_DESC queueDesc = {};
+        queueDesc.Flags = D3D12_COMMAND_QUEUE_FLAG_NONE;
+        queueDesc.Type = D3D12_COMMAND_LIST_TYPE_COPY;
+        ThrowIfFailed(pDevice->CreateCommandQueue(&queueDesc, IID_PPV_ARGS(&m_copyCommandQueue)));
+        NAME_D3D12_OBJECT(m_copyCommandQueue);
+
+        CD3DX12_RANGE readRange(0, 0);        // We do not intend to read from these resources on the CPU.
+        for (UINT n = 0; n < m_frameCount; n++)
+        {
+            ThrowIfFailed(pDevice->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_COPY, IID_PPV_ARGS(&m_copyCommandAllocators[n])));
+
+            ThrowIfFailed(pDevice->CreateCommittedResource(
+                &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
+                D3D12_HEAP_FLAG_NONE,
+                &CD3DX12_RESOURCE_DESC::Buffer(m_maxUploadsPerFrame * D3D12_TILED_RESOURCE_TILE_SIZE_IN_BYTES),
+                D3D12_RESOURCE_STATE_GENERIC_READ,
+                nullptr,
+                IID_PPV_ARGS(&m_uploadBuffers[n])));
+            ThrowIfFailed(m_uploadBuffers[n]->Map(0, &readRange, reinterpret_cast<void**>(&m_uploadBufferPointers[n])));
+        }
+
+        ThrowIfFailed(pDevice->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_COPY, m_copyCommandAllocators[m_frameIndex].Get(), nullptr, IID_PPV_ARGS(&m_copyCommandList)));
+
+        ThrowIfFailed(pDevice->CreateFence(m_copyFenceValue, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&m_copyFence)));
+        m_copyFenceEvent = CreateEvent(nullptr, FALSE, FALSE, nullptr);
+        if (m_copyFenceEvent == nullptr)
+        {
+            ThrowIfFailed(HRESULT_FROM_WIN32(GetLastError()));
+        }
+    }
+
+    // Map the packed mips to a heap of their own and upload them. They stay resident
+    // for the lifetime of the texture, so sampling always has a mip to fall back to.
+    if (m_packedMipInfo.NumPackedMips > 0)
+    {
+        CD3DX12_HEAP_DESC heapDesc(m_packedMipInfo.NumTilesForPackedMips * D3D12_TILED_RESOURCE_TILE_SIZE_IN_BYTES, D3D12_HEAP_TYPE_DEFAULT, 0, D3D12_HEAP_FLAG_DENY_BUFFERS | D3D12_HEAP_FLAG_DENY_RT_DS_TEXTURES);
+        ThrowIfFailed(pDevice->CreateHeap(&heapDesc, IID_PPV_ARGS(&m_packedMipHeap)));
+
+        D3D12_TILED_RESOURCE_COORDINATE startCoordinate = CD3DX12_TILED_RESOURCE_COORDINATE(0, 0, 0, m_packedMipInfo.NumStandardMips);
+        D3D12_TILE_REGION_SIZE regionSize = {};
+        regionSize.NumTiles = m_packedMipInfo.NumTilesForPackedMips;
+        regionSize.UseBox = FALSE;    // All of the packed mips are mapped as a single region.
+        const UINT heapRangeStartOffset = 0;
+        const UINT rangeTileCount = regionSize.NumTiles;
+
+        m_copyCommandQueue->UpdateTileMappings(
+            m_texture.Get(),
+            1,
+            &startCoordinate,
+            &regionSize,
+            m_packedMipHeap.Get(),
+            1,
+            nullptr,
+            &heapRangeStartOffset,
+            &rangeTileCount,
+            D3D12_TILE_MAPPING_FLAG_NONE);
+
+        const UINT firstSubresource = m_packedMipInfo.NumStandardMips;
+        const UINT subresourceCount = m_packedMipInfo.NumPackedMips;
+        const UINT64 uploadBufferSize = GetRequiredIntermediateSize(m_texture.Get(), firstSubresource, subresourceCount);
+        ThrowIfFailed(pDevice->CreateCommittedResource(
+            &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
+            D3D12_HEAP_FLAG_NONE,
+            &CD3DX12_RESOURCE_DESC::Buffer(uploadBufferSize),
+            D3D12_RESOURCE_STATE_GENERIC_READ,
+            nullptr,
+            IID_PPV_ARGS(&m_packedMipUploadBuffer)));
+
+        // Generate the texture data for the packed mips.
+        std::vector<std::vector<UINT8>> texels(subresourceCount);
+        std::vector<D3D12_SUBRESOURCE_DATA> data(subresourceCount);
+        for (UINT n = 0; n < subresourceCount; n++)
+        {
+            const UINT mip = firstSubresource + n;
+            const UINT width = max(m_width >> mip, 1);
+            const UINT height = max(m_height >> mip, 1);
+
+            texels[n].resize(width * height * TexturePixelSizeInBytes);
+            GenerateTexels(mip, 0, 0, width, height, width * TexturePixelSizeInBytes, &texels[n][0]);
+
+            data[n].pData = &texels[n][0];
+            data[n].RowPitch = width * TexturePixelSizeInBytes;
+            data[n].SlicePitch = data[n].RowPitch * height;
+        }
+
+        UpdateSubresources(m_copyCommandList.Get(), m_texture.Get(), m_packedMipUploadBuffer.Get(), 0, firstSubresource, subresourceCount, &data[0]);
+    }
+
+    // Close the command list and execute it to begin the packed mip upload.
+    ThrowIfFailed(m_copyCommandList->Close());
+    ID3D12CommandList* ppCommandLists[] = { m_copyCommandList.Get() };
+    m_copyCommandQueue->ExecuteCommandLists(_countof(ppCommandLists), ppCommandLists);
+
+    // Wait for the upload to complete, which also makes the packed mips resident
+    // for the first frame's WaitForUploads().
+    WaitForGpu();
+    m_residentUploadFenceValue = m_copyFenceValue;
+}
+
+// Process the feedback of the last frame that used this frame index, and upload the
+// tiles it requested. Tiles uploaded last frame are made resident for this frame.
+// The descriptor heap holding the streamer's descriptors is expected to be set on the command list.
+void TileStreamer::BeginFrame(ID3D12GraphicsCommandList* pCommandList, UINT frameIndex, ID3D12Fence* pFence, UINT64 lastSubmittedFenceValue)
+{
+    m_frameIndex = frameIndex;
+    m_frameNumber++;
+
+    // The upload buffer and copy command allocator of this frame index can only be
+    // reused once the copy queue is done with them.
+    if (m_copyFence->GetCompletedValue() < m_copyFenceValues[m_frameIndex])
+    {
+        ThrowIfFailed(m_copyFence->SetEventOnCompletion(m_copyFenceValues[m_frameIndex], m_copyFenceEvent));
+        WaitForSingleObjectEx(m_copyFenceEvent, INFINITE, FALSE);
+    }
+
+    // This frame waits for the uploads submitted last frame in WaitForUploads(),
+    // so the tiles they contain can be sampled.
+    for (UINT key : m_uploadingTiles)
+    {
+        auto tile = m_tiles.find(key);
+        if (tile != m_tiles.end())
+        {
+            tile->second.state = TileStateResident;
+            m_residencyChanged = true;
+        }
+    }
+    m_uploadingTiles.clear();
+    m_residentUploadFenceValue = m_copyFenceValue;
+
+    ProcessFeedback();
+    UploadRequestedTiles(pFence, lastSubmittedFenceValue);
+
+    if (m_residencyChanged)
+    {
+        UpdateResidencyMap(pCommandList);
+        m_residencyChanged = false;
+    }
+
+    const UINT clearValue[4] = { FeedbackNoRequest, FeedbackNoRequest, FeedbackNoRequest, FeedbackNoRequest };
+    pCommandList->ClearUnorderedAccessViewUint(m_feedbackUavHandle, m_feedbackClearHeap->GetCPUDescriptorHandleForHeapStart(), m_feedbackTexture.Get(), clearValue, 0, nullptr);
+}
+
+// Copy this frame's feedback to its readback buffer. It is processed the next time
+// this frame index is used, once the GPU is guaranteed to be done with it.
+void TileStreamer::EndFrame(ID3D12GraphicsCommandList* pCommandList)
+{
+    pCommandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(m_feedbackTexture.Get(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_COPY_SOURCE));
+
+    CD3DX12_TEXTURE_COPY_LOCATION destination(m_feedbackReadbackBuffers[m_frameIndex].Get(), m_feedbackFootprint);
+    CD3DX12_TEXTURE_COPY_LOCATION source(m_feedbackTexture.Get(), 0);
+    pCommandList->CopyTextureRegion(&destination, 0, 0, 0, &source, nullptr);
+
+    pCommandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(m_feedbackTexture.Get(), D3D12_RESOURCE_STATE_COPY_SOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS));
+
+    m_feedbackValid[m_frameIndex] = true;
+}
+
+// Make the queue wait for the uploads of the tiles that are resident this frame.
+void TileStreamer::WaitForUploads(ID3D12CommandQueue* pCommandQueue)
+{
+    ThrowIfFailed(pCommandQueue->Wait(m_copyFence.Get(), m_residentUploadFenceValue));
+}
+
+// Wait for pending uploads to complete.
+void TileStreamer::WaitForGpu()
+{
+    m_copyFenceValue++;
+    ThrowIfFailed(m_copyCommandQueue->Signal(m_copyFence.Get(), m_copyFenceValue));
+
+    ThrowIfFailed(m_copyFence->SetEventOnCompletion(m_copyFenceValue, m_copyFenceEvent));
+    WaitForSingleObjectEx(m_copyFenceEvent, INFINITE, FALSE);
+}
+
+// Build the tile request queue from the feedback read back for this frame index.
+void TileStreamer::ProcessFeedback()
+{
+    m_tileRequests.clear();
+    if (!m_feedbackValid[m_frameIndex])
+    {
+        return;
+    }
+
+    for (UINT mip = 0; mip < m_packedMipInfo.NumStandardMips; mip++)
+    {
+        m_requestedTiles[mip].assign(m_tilings[mip].WidthInTiles * m_tilings[mip].HeightInTiles, false);
+    }
+
+    UINT8* pFeedback;
+    CD3DX12_RANGE readRange(0, static_cast<SIZE_T>(m_feedbackReadbackSize));
+    ThrowIfFailed(m_feedbackReadbackBuffers[m_frameIndex]->Map(0, &readRange, reinterpret_cast<void**>(&pFeedback)));
+
+    for (UINT y = 0; y < m_feedbackHeight; y++)
+    {
+        const UINT* pRow = reinterpret_cast<const UINT*>(pFeedback + m_feedbackFootprint.Offset + y * m_feedbackFootprint.Footprint.RowPitch);
+        for (UINT x = 0; x < m_feedbackWidth; x++)
+        {
+            // The coarser mips of a requested tile are requested as well, as sampling falls
+            // back to them until the tile is resident. Packed mips are always resident.
+            for (UINT mip = pRow[x]; mip < m_packedMipInfo.NumStandardMips; mip++)
+            {
+                const UINT tileX = min(x >> mip, m_tilings[mip].WidthInTiles - 1);
+                const UINT tileY = min(y >> mip, m_tilings[mip].HeightInTiles - 1);
+                const UINT index = tileY * m_tilings[mip].WidthInTiles + tileX;
+                if (m_requestedTiles[mip][index])
+                {
+                    // The coarser mips of this tile have been requested already too.
+                    break;
+                }
+
+                m_requestedTiles[mip][index] = true;
+                RequestTile(TileKey(mip, tileX, tileY));
+            }
+        }
+    }
+
+    CD3DX12_RANGE writeRange(0, 0);
+    m_feedbackReadbackBuffers[m_frameIndex]->Unmap(0, &writeRange);
+
+    // Coarse tiles are streamed in first: they cover more of the screen and finer tiles
+    // can't be sampled until the coarser ones are resident.
+    std::stable_sort(m_tileRequests.begin(), m_tileRequests.end(), [](UINT a, UINT b) { return TileMip(a) > TileMip(b); });
+}
+
+// Mark a mapped tile as recently used, or queue a tile that isn't mapped yet.
+void TileStreamer::RequestTile(UINT key)
+{
+    auto tile = m_tiles.find(key);
+    if (tile != m_tiles.end())
+    {
+        tile->second.lastRequestedFrame = m_frameNumber;
+        m_lruTiles.splice(m_lruTiles.begin(), m_lruTiles, tile->second.lruPosition);
+    }
+    else
+    {
+        m_tileRequests.push_back(key);
+    }
+}
+
+// Map requested tiles to the pool, evicting the least recently requested tiles if it
+// is full, and upload them on the copy queue.
+void TileStreamer::UploadRequestedTiles(ID3D12Fence* pFence, UINT64 lastSubmittedFenceValue)
+{
+    std::vector<D3D12_TILED_RESOURCE_COORDINATE> startCoordinates;
+    std::vector<D3D12_TILE_RANGE_FLAGS> rangeFlags;
+    std::vector<UINT> heapRangeStartOffsets;
+    std::vector<D3D12_TILED_RESOURCE_COORDINATE> uploadCoordinates;
+
+    m_uploadCount = 0;
+    for (UINT key : m_tileRequests)
+    {
+        if (m_uploadCount == m_maxUploadsPerFrame)
+        {
+            break;
+        }
+
+        if (m_freePoolTiles.empty())
+        {
+            // Tiles requested by the latest feedback are never evicted. If those are all
+            // there is, the pool is too small for what is on screen and requests have to wait.
+            const UINT evictedKey = m_lruTiles.back();
+            Tile& evictedTile = m_tiles[evictedKey];
+            if (evictedTile.lastRequestedFrame == m_frameNumber)
+            {
+                break;
+            }
+
+            startCoordinates.push_back(CD3DX12_TILED_RESOURCE_COORDINATE(TileX(evictedKey), TileY(evictedKey), 0, TileMip(evictedKey)));
+            rangeFlags.push_back(D3D12_TILE_RANGE_FLAG_NULL);
+            heapRangeStartOffsets.push_back(0);
+
+            m_freePoolTiles.push_back(evictedTile.poolIndex);
+            m_lruTiles.pop_back();
+            m_tiles.erase(evictedKey);
+            m_residencyChanged = true;
+            m_evictionCount++;
+        }
+
+        const UINT poolIndex = m_freePoolTiles.back();
+        m_freePoolTiles.pop_back();
+
+        const UINT mip = TileMip(key);
+        const UINT tileX = TileX(key);
+        const UINT tileY = TileY(key);
+        const D3D12_TILED_RESOURCE_COORDINATE coordinate = CD3DX12_TILED_RESOURCE_COORDINATE(tileX, tileY, 0, mip);
+        startCoordinates.push_back(coordinate);
+        rangeFlags.push_back(D3D12_TILE_RANGE_FLAG_NONE);
+        heapRangeStartOffsets.push_back(poolIndex);
+        uploadCoordinates.push_back(coordinate);
+
+        m_lruTiles.push_front(key);
+        Tile tile = { poolIndex, TileStateUploading, m_frameNumber, m_lruTiles.begin() };
+        m_tiles[key] = tile;
+        m_uploadingTiles.push_back(key);
+
+        // Generate the tile's texels into this frame's upload buffer, in the linear
+        // layout CopyTiles expects.
+        UINT8* pTileData = m_uploadBufferPointers[m_frameIndex] + m_uploadCount * D3D12_TILED_RESOURCE_TILE_SIZE_IN_BYTES;
+        const UINT tileRowPitch = m_tileShape.WidthInTexels * TexturePixelSizeInBytes;
+        GenerateTexels(mip, tileX * m_tileShape.WidthInTexels, tileY * m_tileShape.HeightInTexels, m_tileShape.WidthInTexels, m_tileShape.HeightInTexels, tileRowPitch, pTileData);
+
+        m_uploadCount++;
+    }
+
+    if (m_uploadCount == 0)
+    {
+        return;
+    }
+
+    D3D12_TILE_REGION_SIZE tileRegionSize = {};
+    tileRegionSize.NumTiles = 1;
+    tileRegionSize.UseBox = FALSE;
+
+    ThrowIfFailed(m_copyCommandAllocators[m_frameIndex]->Reset());
+    ThrowIfFailed(m_copyCommandList->Reset(m_copyCommandAllocators[m_frameIndex].Get(), nullptr));
+    for (UINT n = 0; n < uploadCoordinates.size(); n++)
+    {
+        m_copyCommandList->CopyTiles(
+            m_texture.Get(),
+            &uploadCoordinates[n],
+            &tileRegionSize,
+            m_uploadBuffers[m_frameIndex].Get(),
+            n * D3D12_TILED_RESOURCE_TILE_SIZE_IN_BYTES,
+            D3D12_TILE_COPY_FLAG_LINEAR_BUFFER_TO_SWIZZLED_TILED_RESOURCE);
+    }
+    ThrowIfFailed(m_copyCommandList->Close());
+
+    // Evicted tiles may still be sampled by the frames in flight. They are no longer
+    // resident for this frame, so only the last submitted frame has to be waited for.
+    ThrowIfFailed(m_copyCommandQueue->Wait(pFence, lastSubmittedFenceValue));
+
+    // Update all of this frame's tile mappings at once: evicted tiles are unmapped and
+    // new tiles are mapped to their pool tiles.
+    const UINT regionCount = static_cast<UINT>(startCoordinates.size());
+    std::vector<D3D12_TILE_REGION_SIZE> regionSizes(regionCount, tileRegionSize);
+    std::vector<UINT> rangeTileCounts(regionCount, 1);
+    m_copyCommandQueue->UpdateTileMappings(
+        m_texture.Get(),
+        regionCount,
+        &startCoordinates[0],
+        &regionSizes[0],
+        m_tileHeap.Get(),
+        regionCount,
+        &rangeFlags[0],
+        &heapRangeStartOffsets[0],
+        &rangeTileCounts[0],
+        D3D12_TILE_MAPPING_FLAG_NONE);
+
+    ID3D12CommandList* ppCommandLists[] = { m_copyCommandList.Get() };
+    m_copyCommandQueue->ExecuteCommandLists(_countof(ppCommandLists), ppCommandLists);
+
+    m_copyFenceValue++;
+    ThrowIfFailed(m_copyCommandQueue->Signal(m_copyFence.Get(), m_copyFenceValue));
+    m_copyFenceValues[m_frameIndex] = m_copyFenceValue;
+}
+
+// Compute the finest resident mip for each mip 0 tile and copy it to the residency map.
+void TileStreamer::UpdateResidencyMap(ID3D12GraphicsCommandList* pCommandList)
+{
+    // Walk the mips from coarse to fine. A tile can only be sampled if the coarser
+    // tiles covering it are resident too, as trilinear filtering may blend with them.
+    std::fill(m_residentMips.begin(), m_residentMips.end(), m_packedMipInfo.NumStandardMips);
+    for (UINT mip = m_packedMipInfo.NumStandardMips; mip-- > 0;)
+    {
+        for (UINT tileY = 0; tileY < m_tilings[mip].HeightInTiles; tileY++)
+        {
+            for (UINT tileX = 0; tileX < m_tilings[mip].WidthInTiles; tileX++)
+            {
+                const UINT firstX = tileX << mip;
+                const UINT firstY = tileY << mip;
+                if (m_residentMips[firstY * m_feedbackWidth + firstX] != mip + 1)
+                {
+                    continue;
+                }
+
+                auto tile = m_tiles.find(TileKey(mip, tileX, tileY));
+                if (tile == m_tiles.end() || tile->second.state != TileStateResident)
+                {
+                    continue;
+                }
+
+                for (UINT y = firstY; y < min(firstY + (1u << mip), m_feedbackHeight); y++)
+                {
+                    for (UINT x = firstX; x < min(firstX + (1u << mip), m_feedbackWidth); x++)
+                    {
+                        m_residentMips[y * m_feedbackWidth + x] = mip;
+                    }
+                }
+            }
+        }
+    }
+
+    // Bilinear filtering reads across tile boundaries, so each mip 0 tile is clamped to
+    // the mips resident for its neighbors as well.
+    UINT* pResidency = m_residencyUploadPointers[m_frameIndex];
+    for (UINT y = 0; y < m_feedbackHeight; y++)
+    {
+        for (UINT x = 0; x < m_feedbackWidth; x++)
+        {
+            UINT residentMip = 0;
+            for (UINT neighborY = (y > 0 ? y - 1 : y); neighborY <= min(y + 1, m_feedbackHeight - 1); neighborY++)
+            {
+                for (UINT neighborX = (x > 0 ? x - 1 : x); neighborX <= min(x + 1, m_feedbackWidth - 1); neighborX++)
+                {
+                    residentMip = max(residentMip, m_residentMips[neighborY * m_feedbackWidth + neighborX]);
+                }
+            }
+            pResidency[y * m_feedbackWidth + x] = residentMip;
+        }
+    }
+
+    pCommandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(m_residencyBuffer.Get(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_COPY_DEST));
+    pCommandList->CopyBufferRegion(m_residencyBuffer.Get(), 0, m_residencyUploadBuffers[m_frameIndex].Get(), 0, m_feedbackWidth * m_feedbackHeight * sizeof(UINT));
+    pCommandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(m_residencyBuffer.Get(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE));
+}
+
+// Generate a region of a red and white checkerboard texture. The white cells are
+// tinted per mip and tile boundaries are outlined, so that streaming is easy to follow.
+void TileStreamer::GenerateTexels(UINT mip, UINT x, UINT y, UINT width, UINT height, UINT rowPitch, UINT8* pDestination)
+{
+    static const UINT8 MipTints[][3] =
+    {
+        { 0xff, 0xff, 0xff },
+        { 0xff, 0xff, 0x80 },
+        { 0x80, 0xff, 0x80 },
+        { 0x80, 0xff, 0xff },
+        { 0x80, 0x80, 0xff },
+        { 0xff, 0x80, 0xff },
+    };
+    const UINT8* pTint = MipTints[mip % _countof(MipTints)];
+    const UINT cellSize = max(CheckerboardCellSize >> mip, 1);    // The cells cover the same area in all mips.
+
+    for (UINT row = 0; row < height; row++)
+    {
+        UINT8* pTexel = pDestination + row * rowPitch;
+        for (UINT column = 0; column < width; column++)
+        {
+            const UINT texelX = x + column;
+            const UINT texelY = y + row;
+
+            if (texelX % m_tileShape.WidthInTexels == 0 || texelY % m_tileShape.HeightInTexels == 0)
+            {
+                pTexel[0] = 0x20;    // R
+                pTexel[1] = 0x20;    // G
+                pTexel[2] = 0x20;    // B
+            }
+            else if ((texelX / cellSize) % 2 == (texelY / cellSize) % 2)
+            {
+                pTexel[0] = 0xff;    // R
+                pTexel[1] = 0x00;    // G
+                pTexel[2] = 0x00;    // B
+            }
+            else
+            {
+                pTexel[0] = pTint[0];    // R
+                pTexel[1] = pTint[1];    // G
+                pTexel[2] = pTint[2];    // B
+            }
+            pTexel[3] = 0xff;    // A
+            pTexel += TexturePixelSizeInBytes;
+        }
+    }
+}
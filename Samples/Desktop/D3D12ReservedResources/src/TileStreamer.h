@@ -0,0 +1,141 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+#include "DXSampleHelper.h"
+
+// Streams the tiles of a reserved texture into a fixed amount of memory, regardless of
+// the size of the texture.
+//
+// - Feedback: the pixel shader writes the finest mip it samples into a feedback texture
+//   holding one texel per mip 0 tile (a UAV min-mip map), which is read back every frame.
+// - Requests: tiles named by the feedback, along with their coarser mips, are queued
+//   coarsest first. A bounded number of them is uploaded per frame, the rest is requested
+//   again by the next feedback if still needed.
+// - Pool: tiles are mapped into a fixed size heap. Once it is full, the least recently
+//   requested tiles are evicted to make room.
+// - Uploads: a frame's mapping changes are batched into one UpdateTileMappings call and
+//   the tile data is uploaded with CopyTiles, both on a dedicated copy queue.
+// - Residency: a buffer holding the finest resident mip for each mip 0 tile is updated as
+//   uploads complete. The pixel shader clamps sampling to it so it never reads unmapped tiles.
+//
+// The packed mips are mapped and uploaded once, so there always is a mip to fall back to.
+class TileStreamer
+{
+public:
+    static const UINT DescriptorCount = 3;    // Texture SRV, residency map SRV and feedback UAV.
+
+    TileStreamer(UINT width, UINT height, UINT poolTileCount, UINT maxUploadsPerFrame, UINT frameCount);
+    ~TileStreamer();
+
+    void OnInit(ID3D12Device* pDevice, D3D12_CPU_DESCRIPTOR_HANDLE cpuDescriptorHandle, D3D12_GPU_DESCRIPTOR_HANDLE gpuDescriptorHandle);
+    void BeginFrame(ID3D12GraphicsCommandList* pCommandList, UINT frameIndex, ID3D12Fence* pFence, UINT64 lastSubmittedFenceValue);
+    void EndFrame(ID3D12GraphicsCommandList* pCommandList);
+    void WaitForUploads(ID3D12CommandQueue* pCommandQueue);
+    void WaitForGpu();
+
+    UINT GetPoolTileCount() const       { return m_poolTileCount; }
+    UINT GetMappedTileCount() const     { return static_cast<UINT>(m_tiles.size()); }
+    UINT GetUploadCount() const         { return m_uploadCount; }
+    UINT GetEvictionCount() const       { return m_evictionCount; }
+
+private:
+    static const UINT TexturePixelSizeInBytes = 4;
+    static const UINT CheckerboardCellSize = 1024;    // In mip 0 texels.
+    static const UINT FeedbackNoRequest = UINT_MAX;
+
+    enum TileState
+    {
+        TileStateUploading,
+        TileStateResident
+    };
+
+    // A tile mapped to the pool.
+    struct Tile
+    {
+        UINT poolIndex;
+        TileState state;
+        UINT64 lastRequestedFrame;
+        std::list<UINT>::iterator lruPosition;
+    };
+
+    UINT m_width;
+    UINT m_height;
+    UINT m_mipCount;
+    UINT m_poolTileCount;
+    UINT m_maxUploadsPerFrame;
+    UINT m_frameCount;
+    UINT m_frameIndex;
+    UINT64 m_frameNumber;
+
+    // Tile layout of the reserved texture.
+    D3D12_PACKED_MIP_INFO m_packedMipInfo;
+    D3D12_TILE_SHAPE m_tileShape;
+    std::vector<D3D12_SUBRESOURCE_TILING> m_tilings;
+    UINT m_feedbackWidth;        // Mip 0 width in tiles.
+    UINT m_feedbackHeight;       // Mip 0 height in tiles.
+
+    // D3D objects.
+    ComPtr<ID3D12Resource> m_texture;
+    ComPtr<ID3D12Heap> m_tileHeap;
+    ComPtr<ID3D12Heap> m_packedMipHeap;
+    ComPtr<ID3D12Resource> m_packedMipUploadBuffer;
+    ComPtr<ID3D12CommandQueue> m_copyCommandQueue;
+    std::vector<ComPtr<ID3D12CommandAllocator>> m_copyCommandAllocators;
+    ComPtr<ID3D12GraphicsCommandList> m_copyCommandList;
+    std::vector<ComPtr<ID3D12Resource>> m_uploadBuffers;
+    std::vector<UINT8*> m_uploadBufferPointers;
+
+    // Feedback objects.
+    ComPtr<ID3D12Resource> m_feedbackTexture;
+    std::vector<ComPtr<ID3D12Resource>> m_feedbackReadbackBuffers;
+    std::vector<bool> m_feedbackValid;
+    D3D12_PLACED_SUBRESOURCE_FOOTPRINT m_feedbackFootprint;
+    UINT64 m_feedbackReadbackSize;
+    ComPtr<ID3D12DescriptorHeap> m_feedbackClearHeap;    // CPU visible UAV, needed for clearing.
+    D3D12_GPU_DESCRIPTOR_HANDLE m_feedbackUavHandle;
+
+    // Residency objects.
+    ComPtr<ID3D12Resource> m_residencyBuffer;
+    std::vector<ComPtr<ID3D12Resource>> m_residencyUploadBuffers;
+    std::vector<UINT*> m_residencyUploadPointers;
+    std::vector<UINT> m_residentMips;
+    bool m_residencyChanged;
+
+    // Synchronization objects.
+    ComPtr<ID3D12Fence> m_copyFence;
+    UINT64 m_copyFenceValue;
+    std::vector<UINT64> m_copyFenceValues;
+    UINT64 m_residentUploadFenceValue;
+    HANDLE m_copyFenceEvent;
+
+    // Streaming state.
+    std::unordered_map<UINT, Tile> m_tiles;
+    std::list<UINT> m_lruTiles;                         // Most recently requested first.
+    std::vector<UINT> m_freePoolTiles;
+    std::vector<UINT> m_uploadingTiles;
+    std::vector<UINT> m_tileRequests;
+    std::vector<std::vector<bool>> m_requestedTiles;    // Per standard mip, reset for each feedback.
+    UINT m_uploadCount;
+    UINT m_evictionCount;
+
+    static UINT TileKey(UINT mip, UINT x, UINT y) { return (mip << 24) | (y << 12) | x; }
+    static UINT TileMip(UINT key)   { return key >> 24; }
+    static UINT TileX(UINT key)     { return key & 0xfff; }
+    static UINT TileY(UINT key)     { return (key >> 12) & 0xfff; }
+
+    void ProcessFeedback();
+    void RequestTile(UINT key);
+    void UploadRequestedTiles(ID3D12Fence* pFence, UINT64 lastSubmittedFenceValue);
+    void UpdateResidencyMap(ID3D12GraphicsCommandList* pCommandList);
+    void GenerateTexels(UINT mip, UINT x, UINT y, UINT width, UINT height, UINT rowPitch, UINT8* pDestination);
+};
@@ -17,10 +17,14 @@ struct PSInput
 
 cbuffer RootConstants : register(b0)
 {
-    uint activeMip;
+    float2 uvScale;
+    float2 uvOffset;
+    uint frameNumber;
 }
 
 Texture2D g_texture : register(t0);
+Buffer<uint> g_residencyMap : register(t1);        // Finest resident mip for each mip 0 tile.
+RWTexture2D<uint> g_feedback : register(u0);       // Finest requested mip for each mip 0 tile.
 SamplerState g_sampler : register(s0);
 
 PSInput VSMain(float4 position : POSITION, float4 uv : TEXCOORD)
@@ -28,12 +32,28 @@ PSInput VSMain(float4 position : POSITION, float4 uv : TEXCOORD)
     PSInput result;
 
     result.position = position;
-    result.uv = uv;
+    result.uv = uv.xy * uvScale + uvOffset;
 
     return result;
 }
 
 float4 PSMain(PSInput input) : SV_TARGET
 {
-    return g_texture.SampleLevel(g_sampler, input.uv, activeMip);
+    uint feedbackWidth, feedbackHeight;
+    g_feedback.GetDimensions(feedbackWidth, feedbackHeight);
+    uint2 tile = min(uint2(saturate(input.uv) * float2(feedbackWidth, feedbackHeight)), uint2(feedbackWidth - 1, feedbackHeight - 1));
+
+    float lod = max(g_texture.CalculateLevelOfDetail(g_sampler, input.uv), 0.0f);
+
+    // Only one pixel of each 4x4 block writes feedback, rotating every frame, which
+    // keeps the atomics cheap while still covering the whole screen in a few frames.
+    uint2 pixel = uint2(input.position.xy);
+    if ((pixel.y % 4) * 4 + (pixel.x % 4) == frameNumber % 16)
+    {
+        InterlockedMin(g_feedback[tile], uint(lod));
+    }
+
+    // Never sample finer than what is resident, unmapped tiles would read as zero.
+    float residentMip = g_residencyMap[tile.y * feedbackWidth + tile.x];
+    return g_texture.SampleLevel(g_sampler, input.uv, max(lod, residentMip));
 }
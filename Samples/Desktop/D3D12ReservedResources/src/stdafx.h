@@ -29,4 +29,7 @@
 
 #include <wrl.h>
 #include <vector>
+#include <list>
+#include <unordered_map>
+#include <algorithm>
 #include <shellapi.h>
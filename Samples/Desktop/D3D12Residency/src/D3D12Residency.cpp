@@ -20,9 +20,11 @@ D3D12Residency::D3D12Residency(UINT width, UINT height, std::wstring name) :
     m_rtvDescriptorSize(0),
     m_totalAllocations(0),
     m_textureIndex(0),
+    m_statsHistoryIndex(0),
     m_cancel(false),
     m_loadedTextureCount(0)
 {
+    ZeroMemory(m_statsHistory, sizeof(m_statsHistory));
 }
 
 void D3D12Residency::OnInit()
@@ -88,6 +90,7 @@ void D3D12Residency::LoadPipeline()
     queueDesc.Type = D3D12_COMMAND_LIST_TYPE_DIRECT;
 
     ThrowIfFailed(m_device->CreateCommandQueue(&queueDesc, IID_PPV_ARGS(&m_commandQueue)));
+    SetBenchmarkCommandQueue(m_device.Get(), m_commandQueue.Get());
 
     // Describe and create the swap chain.
     DXGI_SWAP_CHAIN_DESC1 swapChainDesc = {};
@@ -468,6 +471,9 @@ void D3D12Residency::LoadTexturesAsync()
 // Update frame-based values.
 void D3D12Residency::OnUpdate()
 {
+    // Collect the paging work done since the last frame.
+    m_statsHistoryIndex = (m_statsHistoryIndex + 1) % StatsHistoryLength;
+    m_residencyManager.GetStatistics(&m_statsHistory[m_statsHistoryIndex]);
 }
 
 // Render the scene.
@@ -507,7 +513,7 @@ void D3D12Residency::OnRender()
     m_fenceValue++;
 
     // Present the frame.
-    ThrowIfFailed(m_swapChain->Present(1, 0));
+    ThrowIfFailed(m_swapChain->Present(GetSyncInterval(), 0));
     m_frameIndex = m_swapChain->GetCurrentBackBufferIndex();
 
     pManagedCommandList->fenceValue = fence;
@@ -535,8 +541,16 @@ void D3D12Residency::PopulateCommandList(std::shared_ptr<ManagedCommandList> pMa
     DXGI_QUERY_VIDEO_MEMORY_INFO memoryInfo = {};
     ThrowIfFailed(m_adapter->QueryVideoMemoryInfo(0, DXGI_MEMORY_SEGMENT_GROUP_LOCAL, &memoryInfo));
 
-    WCHAR message[200];
-    swprintf_s(message, L"Total Allocated: %llu MB | Budget: %llu MB | Using: %llu MB", m_totalAllocations >> 20, memoryInfo.Budget >> 20, memoryInfo.CurrentUsage >> 20);
+    // The paging statistics are listed in the same order as the graphs, left to right.
+    const D3DX12Residency::RESIDENCY_STATS& stats = m_statsHistory[m_statsHistoryIndex];
+
+    WCHAR message[400];
+    swprintf_s(message, L"Total Allocated: %llu MB | Budget: %llu MB | Using: %llu MB | Made resident: %llu MB | Evicted: %llu MB | MakeResident: %.2f ms (max %.2f ms) | Blocked: %.2f ms | Headroom: %lld MB",
+        m_totalAllocations >> 20, memoryInfo.Budget >> 20, memoryInfo.CurrentUsage >> 20,
+        stats.BytesMadeResident >> 20, stats.BytesEvicted >> 20,
+        stats.MakeResidentTime, stats.MaxMakeResidentTime,
+        stats.WaitForSyncPointTime + stats.WaitForWorkerTime,
+        stats.BudgetHeadroom / (1 << 20));
     this->SetCustomWindowText(message);
 
     auto commandList = pManagedCommandList->commandList;
@@ -614,6 +628,8 @@ void D3D12Residency::PopulateCommandList(std::shared_ptr<ManagedCommandList> pMa
         }
     }
 
+    DrawStatsGraphs(commandList.Get(), rtvHandle);
+
     // Indicate that the back buffer will now be used to present.
     commandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(m_renderTargets[m_frameIndex].Get(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PRESENT));
 
@@ -621,6 +637,78 @@ void D3D12Residency::PopulateCommandList(std::shared_ptr<ManagedCommandList> pMa
     ThrowIfFailed(pManagedCommandList->residencySet->Close());
 }
 
+// Draw a bar graph of the recent history of each paging statistic across the bottom
+// of the render target. The bars are cleared rectangles so no extra pipeline state
+// is needed, and each graph is scaled to the largest value in its history.
+void D3D12Residency::DrawStatsGraphs(ID3D12GraphicsCommandList* pCommandList, D3D12_CPU_DESCRIPTOR_HANDLE rtvHandle)
+{
+    // Made resident (MB), evicted (MB), time in MakeResident (ms), time blocked (ms), budget headroom (MB).
+    const float graphColors[NumStatsGraphs][4] =
+    {
+        { 0.2f, 0.8f, 0.2f, 1.0f },
+        { 0.9f, 0.3f, 0.2f, 1.0f },
+        { 0.9f, 0.8f, 0.2f, 1.0f },
+        { 0.8f, 0.3f, 0.8f, 1.0f },
+        { 0.3f, 0.7f, 0.9f, 1.0f },
+    };
+    const float backgroundColor[] = { 0.0f, 0.0f, 0.0f, 1.0f };
+
+    const auto& GetGraphValue = [](const D3DX12Residency::RESIDENCY_STATS& stats, UINT graph)
+    {
+        switch (graph)
+        {
+        case 0: return static_cast<float>(stats.BytesMadeResident >> 20);
+        case 1: return static_cast<float>(stats.BytesEvicted >> 20);
+        case 2: return stats.MakeResidentTime;
+        case 3: return stats.WaitForSyncPointTime + stats.WaitForWorkerTime;
+        default: return static_cast<float>(max(stats.BudgetHeadroom, 0LL) >> 20);
+        }
+    };
+
+    const LONG graphWidth = static_cast<LONG>(m_width / NumStatsGraphs);
+    const LONG barWidth = max(graphWidth / static_cast<LONG>(StatsHistoryLength), 1L);
+    const LONG bottom = static_cast<LONG>(m_height);
+    const LONG top = bottom - static_cast<LONG>(StatsGraphHeight);
+
+    for (UINT graph = 0; graph < NumStatsGraphs; graph++)
+    {
+        const LONG left = static_cast<LONG>(graph) * graphWidth;
+        const D3D12_RECT backgroundRect = { left, top, left + graphWidth - 2, bottom };
+        pCommandList->ClearRenderTargetView(rtvHandle, backgroundColor, 1, &backgroundRect);
+
+        float maxValue = 0.0f;
+        for (UINT n = 0; n < StatsHistoryLength; n++)
+        {
+            maxValue = max(maxValue, GetGraphValue(m_statsHistory[n], graph));
+        }
+
+        if (maxValue <= 0.0f)
+        {
+            continue;
+        }
+
+        // Oldest sample on the left.
+        D3D12_RECT bars[StatsHistoryLength];
+        UINT barCount = 0;
+        for (UINT n = 0; n < StatsHistoryLength; n++)
+        {
+            const UINT historyIndex = (m_statsHistoryIndex + 1 + n) % StatsHistoryLength;
+            const LONG barHeight = static_cast<LONG>(GetGraphValue(m_statsHistory[historyIndex], graph) / maxValue * (StatsGraphHeight - 4));
+            const LONG barLeft = left + static_cast<LONG>(n) * barWidth;
+
+            if (barHeight > 0 && barLeft + barWidth <= left + graphWidth - 2)
+            {
+                bars[barCount++] = { barLeft, bottom - barHeight, barLeft + barWidth, bottom };
+            }
+        }
+
+        if (barCount > 0)
+        {
+            pCommandList->ClearRenderTargetView(rtvHandle, graphColors[graph], barCount, bars);
+        }
+    }
+}
+
 void D3D12Residency::FlushGpu()
 {
     // Signal and increment the fence value.
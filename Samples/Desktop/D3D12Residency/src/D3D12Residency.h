@@ -97,6 +97,13 @@ private:
     UINT64 m_totalAllocations;
     UINT m_textureIndex;
     D3DX12Residency::ResidencyManager m_residencyManager;
+
+    // Per frame paging statistics, graphed along the bottom of the window.
+    static const UINT StatsHistoryLength = 128;
+    static const UINT NumStatsGraphs = 5;
+    static const UINT StatsGraphHeight = 96;
+    D3DX12Residency::RESIDENCY_STATS m_statsHistory[StatsHistoryLength];
+    UINT m_statsHistoryIndex;
     std::queue<std::shared_ptr<ManagedCommandList>> m_commandListPool;
 
     // Thread and texture loading management.
@@ -140,5 +147,6 @@ private:
     void LoadAssets();
     void LoadTexturesAsync();
     void PopulateCommandList(std::shared_ptr<ManagedCommandList> pManagedCommandList);
+    void DrawStatsGraphs(ID3D12GraphicsCommandList* pCommandList, D3D12_CPU_DESCRIPTOR_HANDLE rtvHandle);
     void FlushGpu();
 };
@@ -11,10 +11,29 @@
 
 #include "stdafx.h"
 #include "D3D12Residency.h"
+#include "TrimBenchmark.h"
 
 _Use_decl_annotations_
 int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE, LPSTR, int nCmdShow)
 {
+    int argc;
+    LPWSTR* argv = CommandLineToArgvW(GetCommandLineW(), &argc);
+    bool trimBenchmark = false;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (_wcsicmp(argv[i], L"-trimbench") == 0 || _wcsicmp(argv[i], L"/trimbench") == 0)
+        {
+            trimBenchmark = true;
+        }
+    }
+    LocalFree(argv);
+
+    if (trimBenchmark)
+    {
+        RunTrimBenchmark();
+        return 0;
+    }
+
     D3D12Residency sample(1280, 720, L"D3D12 Residency Sample");
     return Win32Application::Run(&sample, hInstance, nCmdShow);
 }
@@ -0,0 +1,291 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#include "stdafx.h"
+#include "TrimBenchmark.h"
+#include "DXSampleHelper.h"
+#include "d3dx12Residency.h"
+#include <algorithm>
+#include <cfloat>
+#include <fstream>
+#include <vector>
+
+using namespace D3DX12Residency;
+
+namespace
+{
+    const UINT ObjectCounts[] = { 10000, 100000, 1000000 };
+    const UINT ObjectsPerSyncPoint = 64;    // Objects referenced by each submission.
+    const UINT64 ObjectSize = 64 * 1024;
+    const UINT NumRuns = 5;                 // The fastest run is reported.
+    const UINT32 NumPriorities = Internal::LRUCache::NumPriorities;
+
+    // The LRU as it was before resident objects were bucketed by sync point: one list of
+    // objects per priority class, which the trims walk and compare one object at a time.
+    class LinearLRUCache
+    {
+    public:
+        LinearLRUCache() :
+            NumResidentObjects(0),
+            NumEvictedObjects(0),
+            ResidentSize(0)
+        {
+            for (UINT32 i = 0; i < NumPriorities; i++)
+            {
+                Internal::InitializeListHead(&ResidentObjectListHeads[i]);
+            }
+            Internal::InitializeListHead(&EvictedObjectListHead);
+        }
+
+        void Insert(ManagedObject* pObject)
+        {
+            Internal::InsertHeadList(&ResidentObjectListHeads[UINT32(pObject->Priority)], &pObject->ListEntry);
+            NumResidentObjects++;
+            ResidentSize += pObject->Size;
+        }
+
+        void ObjectReferenced(ManagedObject* pObject)
+        {
+            Internal::RemoveEntryList(&pObject->ListEntry);
+            Internal::InsertTailList(&ResidentObjectListHeads[UINT32(pObject->Priority)], &pObject->ListEntry);
+        }
+
+        void Evict(ManagedObject* pObject)
+        {
+            pObject->ResidencyStatus = ManagedObject::RESIDENCY_STATUS::EVICTED;
+            Internal::RemoveEntryList(&pObject->ListEntry);
+            Internal::InsertTailList(&EvictedObjectListHead, &pObject->ListEntry);
+
+            NumResidentObjects--;
+            ResidentSize -= pObject->Size;
+            NumEvictedObjects++;
+        }
+
+        void TrimToSyncPointInclusive(INT64 CurrentUsage, INT64 CurrentBudget, ID3D12Pageable** EvictionList, UINT32& NumObjectsToEvict, UINT64 SyncPoint)
+        {
+            NumObjectsToEvict = 0;
+
+            for (UINT32 i = 0; i < NumPriorities && CurrentUsage >= CurrentBudget; i++)
+            {
+                LIST_ENTRY* pListHead = &ResidentObjectListHeads[i];
+                LIST_ENTRY* pResourceEntry = pListHead->Flink;
+                while (pResourceEntry != pListHead)
+                {
+                    ManagedObject* pObject = CONTAINING_RECORD(pResourceEntry, ManagedObject, ListEntry);
+
+                    if (pObject->LastGPUSyncPoint > SyncPoint || CurrentUsage < CurrentBudget)
+                    {
+                        break;
+                    }
+
+                    EvictionList[NumObjectsToEvict++] = pObject->pUnderlying;
+                    Evict(pObject);
+
+                    CurrentUsage -= pObject->Size;
+
+                    pResourceEntry = pListHead->Flink;
+                }
+            }
+        }
+
+        void TrimAgedAllocations(Internal::DeviceWideSyncPoint* MaxSyncPoint, ID3D12Pageable** EvictionList, UINT32& NumObjectsToEvict, UINT64 CurrentTimeStamp, UINT64 MinDelta)
+        {
+            for (UINT32 i = 0; i < NumPriorities; i++)
+            {
+                LIST_ENTRY* pListHead = &ResidentObjectListHeads[i];
+                LIST_ENTRY* pResourceEntry = pListHead->Flink;
+                while (pResourceEntry != pListHead)
+                {
+                    ManagedObject* pObject = CONTAINING_RECORD(pResourceEntry, ManagedObject, ListEntry);
+
+                    if ((MaxSyncPoint && pObject->LastGPUSyncPoint >= MaxSyncPoint->GenerationID) ||
+                        CurrentTimeStamp - pObject->LastUsedTimestamp <= MinDelta)
+                    {
+                        break;
+                    }
+
+                    EvictionList[NumObjectsToEvict++] = pObject->pUnderlying;
+                    Evict(pObject);
+
+                    pResourceEntry = pListHead->Flink;
+                }
+            }
+        }
+
+    private:
+        LIST_ENTRY ResidentObjectListHeads[NumPriorities];
+        LIST_ENTRY EvictedObjectListHead;
+
+        UINT32 NumResidentObjects;
+        UINT32 NumEvictedObjects;
+        UINT64 ResidentSize;
+    };
+
+    struct TrimTimings
+    {
+        double referenceMs;             // ObjectReferenced() of every object, oldest first.
+        double trimToSyncPointMs;
+        double trimAgedMs;
+        UINT32 trimToSyncPointEvictions;
+        UINT32 trimAgedEvictions;
+    };
+
+    double ElapsedMs(const LARGE_INTEGER& start)
+    {
+        LARGE_INTEGER end, frequency;
+        QueryPerformanceCounter(&end);
+        QueryPerformanceFrequency(&frequency);
+        return 1000.0 * (end.QuadPart - start.QuadPart) / frequency.QuadPart;
+    }
+
+    // Every submission references a new group of objects, spread over the priority classes.
+    // Timestamps follow the sync points, so the older half of the objects is also the aged half.
+    void ResetObjects(std::vector<ManagedObject>& objects)
+    {
+        for (UINT i = 0; i < objects.size(); i++)
+        {
+            ManagedObject& object = objects[i];
+            object.pUnderlying = reinterpret_cast<ID3D12Pageable*>(&object);
+            object.Size = ObjectSize;
+            object.ResidencyStatus = ManagedObject::RESIDENCY_STATUS::RESIDENT;
+            object.Priority = ManagedObject::RESIDENCY_PRIORITY(i % NumPriorities);
+            object.LastGPUSyncPoint = i / ObjectsPerSyncPoint + 1;
+            object.LastUsedTimestamp = object.LastGPUSyncPoint;
+            object.pLRUBucket = nullptr;
+        }
+    }
+
+    // Fills a cache the way the residency manager does, and returns how long referencing took.
+    template <typename Cache>
+    double FillCache(Cache& cache, std::vector<ManagedObject>& objects)
+    {
+        ResetObjects(objects);
+        for (ManagedObject& object : objects)
+        {
+            cache.Insert(&object);
+        }
+
+        LARGE_INTEGER start;
+        QueryPerformanceCounter(&start);
+        for (ManagedObject& object : objects)
+        {
+            cache.ObjectReferenced(&object);
+        }
+        return ElapsedMs(start);
+    }
+
+    // Each trim starts from a freshly filled cache. The eviction lists of the last run are kept
+    // so that the two implementations can be checked against each other.
+    template <typename Cache>
+    TrimTimings TimeTrims(std::vector<ManagedObject>& objects, std::vector<ID3D12Pageable*>& trimToSyncPointList, std::vector<ID3D12Pageable*>& trimAgedList)
+    {
+        const UINT64 lastSyncPoint = (objects.size() - 1) / ObjectsPerSyncPoint + 1;
+        const INT64 totalSize = INT64(objects.size() * ObjectSize);
+
+        TrimTimings best = { DBL_MAX, DBL_MAX, DBL_MAX, 0, 0 };
+        for (UINT run = 0; run < NumRuns; run++)
+        {
+            LARGE_INTEGER start;
+
+            // Everything but the newest quarter may go, and the budget stops the trim half way.
+            {
+                Cache cache;
+                const double referenceMs = FillCache(cache, objects);
+                best.referenceMs = min(best.referenceMs, referenceMs);
+
+                QueryPerformanceCounter(&start);
+                cache.TrimToSyncPointInclusive(totalSize, totalSize / 2, trimToSyncPointList.data(), best.trimToSyncPointEvictions, lastSyncPoint * 3 / 4);
+                const double trimMs = ElapsedMs(start);
+                best.trimToSyncPointMs = min(best.trimToSyncPointMs, trimMs);
+            }
+
+            // Everything not used in the last half of the sync points has aged out.
+            {
+                Cache cache;
+                FillCache(cache, objects);
+
+                best.trimAgedEvictions = 0;
+                QueryPerformanceCounter(&start);
+                cache.TrimAgedAllocations(nullptr, trimAgedList.data(), best.trimAgedEvictions, lastSyncPoint, lastSyncPoint / 2);
+                const double trimMs = ElapsedMs(start);
+                best.trimAgedMs = min(best.trimAgedMs, trimMs);
+            }
+        }
+        return best;
+    }
+
+    bool SameEvictions(const std::vector<ID3D12Pageable*>& a, const std::vector<ID3D12Pageable*>& b, UINT32 count)
+    {
+        return std::equal(a.begin(), a.begin() + count, b.begin());
+    }
+
+    void WriteTimings(std::ofstream& file, const char* name, double linearMs, double bucketedMs)
+    {
+        file << "      \"" << name << "\": { \"linear\": " << linearMs << ", \"bucketed\": " << bucketedMs << " }";
+    }
+}
+
+void RunTrimBenchmark()
+{
+    WCHAR assetsPath[512];
+    GetAssetsPath(assetsPath, _countof(assetsPath));
+    std::wstring outputPath = std::wstring(assetsPath) + L"trimbenchmark.json";
+
+    std::ofstream file(outputPath.c_str(), std::ios::out | std::ios::trunc);
+    if (!file)
+    {
+        throw std::exception();
+    }
+
+    file << "{\n";
+    file << "  \"objectsPerSyncPoint\": " << ObjectsPerSyncPoint << ",\n";
+    file << "  \"runs\": [\n";
+
+    for (UINT i = 0; i < _countof(ObjectCounts); i++)
+    {
+        const UINT objectCount = ObjectCounts[i];
+        std::vector<ManagedObject> objects(objectCount);
+        std::vector<ID3D12Pageable*> linearTrimToSyncPoint(objectCount), linearTrimAged(objectCount);
+        std::vector<ID3D12Pageable*> bucketedTrimToSyncPoint(objectCount), bucketedTrimAged(objectCount);
+
+        const TrimTimings linear = TimeTrims<LinearLRUCache>(objects, linearTrimToSyncPoint, linearTrimAged);
+        const TrimTimings bucketed = TimeTrims<Internal::LRUCache>(objects, bucketedTrimToSyncPoint, bucketedTrimAged);
+
+        // Both implementations must pick the same objects in the same order.
+        const bool identical =
+            linear.trimToSyncPointEvictions == bucketed.trimToSyncPointEvictions &&
+            linear.trimAgedEvictions == bucketed.trimAgedEvictions &&
+            SameEvictions(linearTrimToSyncPoint, bucketedTrimToSyncPoint, linear.trimToSyncPointEvictions) &&
+            SameEvictions(linearTrimAged, bucketedTrimAged, linear.trimAgedEvictions);
+
+        file << "    {\n";
+        file << "      \"objects\": " << objectCount << ",\n";
+        WriteTimings(file, "objectReferencedMs", linear.referenceMs, bucketed.referenceMs);
+        file << ",\n";
+        WriteTimings(file, "trimToSyncPointInclusiveMs", linear.trimToSyncPointMs, bucketed.trimToSyncPointMs);
+        file << ",\n";
+        WriteTimings(file, "trimAgedAllocationsMs", linear.trimAgedMs, bucketed.trimAgedMs);
+        file << ",\n";
+        file << "      \"trimToSyncPointInclusiveEvictions\": " << bucketed.trimToSyncPointEvictions << ",\n";
+        file << "      \"trimAgedAllocationsEvictions\": " << bucketed.trimAgedEvictions << ",\n";
+        file << "      \"identicalEvictions\": " << (identical ? "true" : "false") << "\n";
+        file << "    }" << (i + 1 < _countof(ObjectCounts) ? "," : "") << "\n";
+
+        char line[256];
+        sprintf_s(line, "%u objects: TrimToSyncPointInclusive %.3f ms (linear %.3f ms), TrimAgedAllocations %.3f ms (linear %.3f ms)%s\n",
+            objectCount, bucketed.trimToSyncPointMs, linear.trimToSyncPointMs, bucketed.trimAgedMs, linear.trimAgedMs,
+            identical ? "" : ", EVICTIONS DIFFER");
+        OutputDebugStringA(line);
+    }
+
+    file << "  ]\n";
+    file << "}\n";
+}
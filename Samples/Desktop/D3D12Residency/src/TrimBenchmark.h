@@ -0,0 +1,18 @@
+//*********************************************************
+//
+// Copyright (c) Microsoft. All rights reserved.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+// Trim benchmark. "-trimbench" times the residency library's LRU trims against the
+// per-object walk that preceded the sync point buckets, at 10k, 100k and 1M resident
+// objects, writes the results to trimbenchmark.json next to the executable and to the
+// debugger output, and then quits without creating a window or a device.
+void RunTrimBenchmark();
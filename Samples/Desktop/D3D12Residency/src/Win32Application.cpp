@@ -105,7 +105,9 @@ LRESULT CALLBACK Win32Application::WindowProc(HWND hWnd, UINT message, WPARAM wP
         if (pSample)
         {
             pSample->OnUpdate();
+            pSample->BeginBenchmarkFrame();
             pSample->OnRender();
+            pSample->EndBenchmarkFrame();
         }
         return 0;
 
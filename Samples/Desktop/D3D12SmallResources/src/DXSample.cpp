@@ -11,14 +11,51 @@
 
 #include "stdafx.h"
 #include "DXSample.h"
+#include <algorithm>
+#include <fstream>
 
 using namespace Microsoft::WRL;
 
+namespace
+{
+    // Writes the min, mean, max and a few percentiles of a set of frame times as a JSON object.
+    void WriteFrameTimeStatistics(std::ofstream& file, std::vector<double> frameTimes)
+    {
+        std::sort(frameTimes.begin(), frameTimes.end());
+
+        double sum = 0.0;
+        for (double frameTime : frameTimes)
+        {
+            sum += frameTime;
+        }
+
+        // Nearest-rank percentile.
+        auto percentile = [&frameTimes](size_t p)
+        {
+            const size_t rank = (p * frameTimes.size() + 99) / 100;
+            return frameTimes[rank > 0 ? rank - 1 : 0];
+        };
+
+        file << "{ \"min\": " << frameTimes.front()
+            << ", \"mean\": " << sum / frameTimes.size()
+            << ", \"p50\": " << percentile(50)
+            << ", \"p90\": " << percentile(90)
+            << ", \"p95\": " << percentile(95)
+            << ", \"p99\": " << percentile(99)
+            << ", \"max\": " << frameTimes.back() << " }";
+    }
+}
+
 DXSample::DXSample(UINT width, UINT height, std::wstring name) :
     m_width(width),
     m_height(height),
     m_title(name),
-    m_useWarpDevice(false)
+    m_useWarpDevice(false),
+    m_benchmarkFrameCount(0),
+    m_benchmarkFrameIndex(0),
+    m_benchmarkFenceValues{},
+    m_benchmarkNextFenceValue(0),
+    m_benchmarkFenceEvent(nullptr)
 {
     WCHAR assetsPath[512];
     GetAssetsPath(assetsPath, _countof(assetsPath));
@@ -29,6 +66,10 @@ DXSample::DXSample(UINT width, UINT height, std::wstring name) :
 
 DXSample::~DXSample()
 {
+    if (m_benchmarkFenceEvent)
+    {
+        CloseHandle(m_benchmarkFenceEvent);
+    }
 }
 
 // Helper function for resolving the full path of assets.
@@ -87,5 +128,198 @@ void DXSample::ParseCommandLineArgs(WCHAR* argv[], int argc)
             m_useWarpDevice = true;
             m_title = m_title + L" (WARP)";
         }
+        else if ((_wcsicmp(argv[i], L"-bench") == 0 || _wcsicmp(argv[i], L"/bench") == 0) && i + 1 < argc)
+        {
+            const int frameCount = _wtoi(argv[++i]);
+            m_benchmarkFrameCount = frameCount > 0 ? static_cast<UINT>(frameCount) : 0;
+            m_benchmarkCpuTicks.reserve(m_benchmarkFrameCount + 1);
+        }
+        else if ((_wcsicmp(argv[i], L"-benchout") == 0 || _wcsicmp(argv[i], L"/benchout") == 0) && i + 1 < argc)
+        {
+            m_benchmarkOutputPath = argv[++i];
+        }
+    }
+}
+
+// Creates the timestamp queries used to measure the GPU time of each benchmarked frame.
+// Only the work submitted to this queue is measured.
+_Use_decl_annotations_
+void DXSample::SetBenchmarkCommandQueue(ID3D12Device* pDevice, ID3D12CommandQueue* pCommandQueue)
+{
+    if (!IsBenchmarking())
+    {
+        return;
+    }
+
+    m_benchmarkQueue = pCommandQueue;
+    const D3D12_COMMAND_LIST_TYPE commandListType = pCommandQueue->GetDesc().Type;
+
+    // Two timestamps per frame, resolved into their own slots so results are only read back once at the end.
+    D3D12_QUERY_HEAP_DESC queryHeapDesc = {};
+    queryHeapDesc.Type = D3D12_QUERY_HEAP_TYPE_TIMESTAMP;
+    queryHeapDesc.Count = m_benchmarkFrameCount * 2;
+    ThrowIfFailed(pDevice->CreateQueryHeap(&queryHeapDesc, IID_PPV_ARGS(&m_benchmarkQueryHeap)));
+
+    ThrowIfFailed(pDevice->CreateCommittedResource(
+        &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_READBACK),
+        D3D12_HEAP_FLAG_NONE,
+        &CD3DX12_RESOURCE_DESC::Buffer(queryHeapDesc.Count * sizeof(UINT64)),
+        D3D12_RESOURCE_STATE_COPY_DEST,
+        nullptr,
+        IID_PPV_ARGS(&m_benchmarkReadback)));
+
+    for (UINT n = 0; n < BenchmarkFrameLatency; n++)
+    {
+        ThrowIfFailed(pDevice->CreateCommandAllocator(commandListType, IID_PPV_ARGS(&m_benchmarkAllocators[n])));
+    }
+
+    ThrowIfFailed(pDevice->CreateCommandList(0, commandListType, m_benchmarkAllocators[0].Get(), nullptr, IID_PPV_ARGS(&m_benchmarkBeginList)));
+    ThrowIfFailed(pDevice->CreateCommandList(0, commandListType, m_benchmarkAllocators[0].Get(), nullptr, IID_PPV_ARGS(&m_benchmarkEndList)));
+    ThrowIfFailed(m_benchmarkBeginList->Close());
+    ThrowIfFailed(m_benchmarkEndList->Close());
+
+    ThrowIfFailed(pDevice->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&m_benchmarkFence)));
+    m_benchmarkFenceEvent = CreateEvent(nullptr, FALSE, FALSE, nullptr);
+    if (m_benchmarkFenceEvent == nullptr)
+    {
+        ThrowIfFailed(HRESULT_FROM_WIN32(GetLastError()));
+    }
+}
+
+// Called by Win32Application between OnUpdate and OnRender. The CPU frame time is the
+// interval between consecutive calls so it covers the whole frame, including Present.
+void DXSample::BeginBenchmarkFrame()
+{
+    if (m_benchmarkFrameIndex >= m_benchmarkFrameCount)
+    {
+        return;
+    }
+
+    LARGE_INTEGER ticks;
+    QueryPerformanceCounter(&ticks);
+    m_benchmarkCpuTicks.push_back(ticks.QuadPart);
+
+    if (m_benchmarkQueue)
+    {
+        const UINT slot = m_benchmarkFrameIndex % BenchmarkFrameLatency;
+        if (m_benchmarkFence->GetCompletedValue() < m_benchmarkFenceValues[slot])
+        {
+            ThrowIfFailed(m_benchmarkFence->SetEventOnCompletion(m_benchmarkFenceValues[slot], m_benchmarkFenceEvent));
+            WaitForSingleObject(m_benchmarkFenceEvent, INFINITE);
+        }
+
+        ThrowIfFailed(m_benchmarkAllocators[slot]->Reset());
+        ThrowIfFailed(m_benchmarkBeginList->Reset(m_benchmarkAllocators[slot].Get(), nullptr));
+        m_benchmarkBeginList->EndQuery(m_benchmarkQueryHeap.Get(), D3D12_QUERY_TYPE_TIMESTAMP, m_benchmarkFrameIndex * 2);
+        ThrowIfFailed(m_benchmarkBeginList->Close());
+
+        ID3D12CommandList* ppCommandLists[] = { m_benchmarkBeginList.Get() };
+        m_benchmarkQueue->ExecuteCommandLists(_countof(ppCommandLists), ppCommandLists);
+    }
+}
+
+// Called by Win32Application after OnRender. Writes the results and quits once the
+// requested number of frames has been rendered.
+void DXSample::EndBenchmarkFrame()
+{
+    if (m_benchmarkFrameIndex >= m_benchmarkFrameCount)
+    {
+        return;
+    }
+
+    if (m_benchmarkQueue)
+    {
+        const UINT slot = m_benchmarkFrameIndex % BenchmarkFrameLatency;
+        const UINT queryIndex = m_benchmarkFrameIndex * 2;
+
+        ThrowIfFailed(m_benchmarkEndList->Reset(m_benchmarkAllocators[slot].Get(), nullptr));
+        m_benchmarkEndList->EndQuery(m_benchmarkQueryHeap.Get(), D3D12_QUERY_TYPE_TIMESTAMP, queryIndex + 1);
+        m_benchmarkEndList->ResolveQueryData(m_benchmarkQueryHeap.Get(), D3D12_QUERY_TYPE_TIMESTAMP, queryIndex, 2, m_benchmarkReadback.Get(), queryIndex * sizeof(UINT64));
+        ThrowIfFailed(m_benchmarkEndList->Close());
+
+        ID3D12CommandList* ppCommandLists[] = { m_benchmarkEndList.Get() };
+        m_benchmarkQueue->ExecuteCommandLists(_countof(ppCommandLists), ppCommandLists);
+
+        m_benchmarkFenceValues[slot] = ++m_benchmarkNextFenceValue;
+        ThrowIfFailed(m_benchmarkQueue->Signal(m_benchmarkFence.Get(), m_benchmarkFenceValues[slot]));
+    }
+
+    if (++m_benchmarkFrameIndex == m_benchmarkFrameCount)
+    {
+        LARGE_INTEGER ticks;
+        QueryPerformanceCounter(&ticks);
+        m_benchmarkCpuTicks.push_back(ticks.QuadPart);
+
+        WriteBenchmarkResults();
+        PostQuitMessage(0);
+    }
+}
+
+void DXSample::WriteBenchmarkResults()
+{
+    LARGE_INTEGER frequency;
+    QueryPerformanceFrequency(&frequency);
+
+    std::vector<double> cpuFrameTimes(m_benchmarkFrameCount);
+    for (UINT i = 0; i < m_benchmarkFrameCount; i++)
+    {
+        cpuFrameTimes[i] = 1000.0 * (m_benchmarkCpuTicks[i + 1] - m_benchmarkCpuTicks[i]) / frequency.QuadPart;
+    }
+
+    std::vector<double> gpuFrameTimes;
+    if (m_benchmarkQueue)
+    {
+        // Wait for the last frame's timestamps to be resolved.
+        if (m_benchmarkFence->GetCompletedValue() < m_benchmarkNextFenceValue)
+        {
+            ThrowIfFailed(m_benchmarkFence->SetEventOnCompletion(m_benchmarkNextFenceValue, m_benchmarkFenceEvent));
+            WaitForSingleObject(m_benchmarkFenceEvent, INFINITE);
+        }
+
+        UINT64 gpuFrequency;
+        ThrowIfFailed(m_benchmarkQueue->GetTimestampFrequency(&gpuFrequency));
+
+        const D3D12_RANGE readRange = { 0, m_benchmarkFrameCount * 2 * sizeof(UINT64) };
+        const D3D12_RANGE emptyRange = {};
+        UINT64* pTimestamps;
+        ThrowIfFailed(m_benchmarkReadback->Map(0, &readRange, reinterpret_cast<void**>(&pTimestamps)));
+
+        gpuFrameTimes.resize(m_benchmarkFrameCount);
+        for (UINT i = 0; i < m_benchmarkFrameCount; i++)
+        {
+            gpuFrameTimes[i] = 1000.0 * (pTimestamps[i * 2 + 1] - pTimestamps[i * 2]) / gpuFrequency;
+        }
+
+        m_benchmarkReadback->Unmap(0, &emptyRange);
+    }
+
+    std::wstring outputPath = m_benchmarkOutputPath.empty() ? GetAssetFullPath(L"benchmark.json") : m_benchmarkOutputPath;
+    std::ofstream file(outputPath.c_str(), std::ios::out | std::ios::trunc);
+    if (!file)
+    {
+        throw std::exception();
+    }
+
+    // The title is only ever plain ASCII in these samples.
+    std::string title;
+    for (WCHAR c : m_title)
+    {
+        title += (c < 0x80 && c != L'"' && c != L'\\') ? static_cast<char>(c) : '?';
+    }
+
+    file << "{\n";
+    file << "  \"sample\": \"" << title << "\",\n";
+    file << "  \"frames\": " << m_benchmarkFrameCount << ",\n";
+    file << "  \"cpuFrameTimeMs\": ";
+    WriteFrameTimeStatistics(file, cpuFrameTimes);
+    file << ",\n  \"gpuFrameTimeMs\": ";
+    if (gpuFrameTimes.empty())
+    {
+        file << "null";
+    }
+    else
+    {
+        WriteFrameTimeStatistics(file, gpuFrameTimes);
     }
+    file << "\n}\n";
 }
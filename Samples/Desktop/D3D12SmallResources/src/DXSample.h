@@ -13,6 +13,7 @@
 
 #include "DXSampleHelper.h"
 #include "Win32Application.h"
+#include <vector>
 
 class DXSample
 {
@@ -36,11 +37,23 @@ public:
 
     void ParseCommandLineArgs(_In_reads_(argc) WCHAR* argv[], int argc);
 
+    // Benchmark mode. "-bench N" runs N frames unthrottled, writes CPU and GPU frame
+    // time percentiles to a JSON file ("-benchout <path>", benchmark.json next to the
+    // executable by default) and then quits. Win32Application brackets every frame.
+    bool IsBenchmarking() const     { return m_benchmarkFrameCount > 0; }
+    UINT GetSyncInterval() const    { return IsBenchmarking() ? 0 : 1; }
+    void BeginBenchmarkFrame();
+    void EndBenchmarkFrame();
+
 protected:
     std::wstring GetAssetFullPath(LPCWSTR assetName);
     void GetHardwareAdapter(_In_ IDXGIFactory2* pFactory, _Outptr_result_maybenull_ IDXGIAdapter1** ppAdapter);
     void SetCustomWindowText(LPCWSTR text);
 
+    // Samples register the queue they present from so that benchmark mode can bracket
+    // each frame with timestamp queries. Without it only CPU frame times are recorded.
+    void SetBenchmarkCommandQueue(_In_ ID3D12Device* pDevice, _In_ ID3D12CommandQueue* pCommandQueue);
+
     // Viewport dimensions.
     UINT m_width;
     UINT m_height;
@@ -55,4 +68,25 @@ private:
 
     // Window title.
     std::wstring m_title;
+
+    // Benchmark state.
+    static const UINT BenchmarkFrameLatency = 3;
+
+    void WriteBenchmarkResults();
+
+    UINT m_benchmarkFrameCount;
+    UINT m_benchmarkFrameIndex;
+    std::wstring m_benchmarkOutputPath;
+    std::vector<LONGLONG> m_benchmarkCpuTicks;
+
+    Microsoft::WRL::ComPtr<ID3D12CommandQueue> m_benchmarkQueue;
+    Microsoft::WRL::ComPtr<ID3D12QueryHeap> m_benchmarkQueryHeap;
+    Microsoft::WRL::ComPtr<ID3D12Resource> m_benchmarkReadback;
+    Microsoft::WRL::ComPtr<ID3D12CommandAllocator> m_benchmarkAllocators[BenchmarkFrameLatency];
+    Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList> m_benchmarkBeginList;
+    Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList> m_benchmarkEndList;
+    Microsoft::WRL::ComPtr<ID3D12Fence> m_benchmarkFence;
+    UINT64 m_benchmarkFenceValues[BenchmarkFrameLatency];
+    UINT64 m_benchmarkNextFenceValue;
+    HANDLE m_benchmarkFenceEvent;
 };
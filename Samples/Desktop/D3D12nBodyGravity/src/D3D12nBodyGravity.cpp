@@ -18,6 +18,7 @@
 #define InterlockedGetValue(object) InterlockedCompareExchange(object, 0, 0)
 
 const float D3D12nBodyGravity::ParticleSpread = 400.0f;
+const float D3D12nBodyGravity::BarnesHutTheta = 0.5f;
 
 D3D12nBodyGravity::D3D12nBodyGravity(UINT width, UINT height, std::wstring name) :
     DXSample(width, height, name),
@@ -29,22 +30,24 @@ D3D12nBodyGravity::D3D12nBodyGravity(UINT width, UINT height, std::wstring name)
     m_pConstantBufferGSData(nullptr),
     m_renderContextFenceValue(0),
     m_terminating(0),
-    m_srvIndex{},
-    m_frameFenceValues{}
+    m_stopCompute(false),
+    m_srvIndex(0),
+    m_frameFenceValues{},
+    m_particleCount(DefaultParticleCount),
+    m_sortCount(0),
+    m_useBarnesHut(false),
+    m_useVertexPulling(false),
+    m_timestampFrequencies{},
+    m_drawTimestampFrequency(0),
+    m_drawTime(0.0f),
+    m_sliceOffsets{},
+    m_sliceTimes{}
 {
     for (int n = 0; n < ThreadCount; n++)
     {
         m_renderContextFenceValues[n] = 0;
         m_threadFenceValues[n] = 0;
-    }
-
-    float sqRootNumAsyncContexts = sqrt(static_cast<float>(ThreadCount));
-    m_heightInstances = static_cast<UINT>(ceil(sqRootNumAsyncContexts));
-    m_widthInstances = static_cast<UINT>(ceil(sqRootNumAsyncContexts));
-
-    if (m_widthInstances * (m_heightInstances - 1) >= ThreadCount)
-    {
-        m_heightInstances--;
+        m_sliceRates[n] = 1.0f;
     }
 }
 
@@ -56,6 +59,41 @@ void D3D12nBodyGravity::OnInit()
     LoadPipeline();
     LoadAssets();
     CreateAsyncContexts();
+    UpdateTitle();
+}
+
+_Use_decl_annotations_
+void D3D12nBodyGravity::ParseCommandLineArgs(WCHAR* argv[], int argc)
+{
+    DXSample::ParseCommandLineArgs(argv, argc);
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if ((_wcsicmp(argv[i], L"-particles") == 0 || _wcsicmp(argv[i], L"/particles") == 0) && i + 1 < argc)
+        {
+            // The particles are split evenly between two galaxies.
+            m_particleCount = min(max(_wtoi(argv[++i]), 2), static_cast<int>(MaxParticleCount)) & ~1u;
+        }
+        else if (_wcsicmp(argv[i], L"-barneshut") == 0 || _wcsicmp(argv[i], L"/barneshut") == 0)
+        {
+            m_useBarnesHut = true;
+        }
+        else if (_wcsicmp(argv[i], L"-vertexpulling") == 0 || _wcsicmp(argv[i], L"/vertexpulling") == 0)
+        {
+            m_useVertexPulling = true;
+        }
+    }
+}
+
+void D3D12nBodyGravity::UpdateTitle()
+{
+    WCHAR text[128];
+    swprintf_s(text, L"%u particles, %s (B to toggle), %s (V to toggle) %.2f ms",
+        m_particleCount,
+        m_useBarnesHut ? L"Barnes-Hut" : L"brute force",
+        m_useVertexPulling ? L"vertex pulling" : L"geometry shader",
+        m_drawTime);
+    SetCustomWindowText(text);
 }
 
 // Load the rendering pipeline dependencies.
@@ -110,6 +148,7 @@ void D3D12nBodyGravity::LoadPipeline()
     queueDesc.Type = D3D12_COMMAND_LIST_TYPE_DIRECT;
 
     ThrowIfFailed(m_device->CreateCommandQueue(&queueDesc, IID_PPV_ARGS(&m_commandQueue)));
+    SetBenchmarkCommandQueue(m_device.Get(), m_commandQueue.Get());
     NAME_D3D12_OBJECT(m_commandQueue);
 
     // Describe and create the swap chain.
@@ -203,6 +242,7 @@ void D3D12nBodyGravity::LoadAssets()
             CD3DX12_ROOT_PARAMETER1 rootParameters[GraphicsRootParametersCount];
             rootParameters[GraphicsRootCBV].InitAsConstantBufferView(0, 0, D3D12_ROOT_DESCRIPTOR_FLAG_DATA_STATIC, D3D12_SHADER_VISIBILITY_ALL);
             rootParameters[GraphicsRootSRVTable].InitAsDescriptorTable(1, &ranges[0], D3D12_SHADER_VISIBILITY_VERTEX);
+            rootParameters[GraphicsRootDrawConstants].InitAsConstants(1, 1, 0, D3D12_SHADER_VISIBILITY_VERTEX);
 
             CD3DX12_VERSIONED_ROOT_SIGNATURE_DESC rootSignatureDesc;
             rootSignatureDesc.Init_1_1(_countof(rootParameters), rootParameters, 0, nullptr, D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT);
@@ -214,7 +254,8 @@ void D3D12nBodyGravity::LoadAssets()
             NAME_D3D12_OBJECT(m_rootSignature);
         }
 
-        // Compute root signature.
+        // Compute root signature. The Barnes-Hut passes bind their scratch 
+        // buffers as root UAVs; the brute force pass ignores them.
         {
             CD3DX12_DESCRIPTOR_RANGE1 ranges[2];
             ranges[0].Init(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 1, 0, 0, D3D12_DESCRIPTOR_RANGE_FLAG_DESCRIPTORS_VOLATILE);
@@ -224,6 +265,12 @@ void D3D12nBodyGravity::LoadAssets()
             rootParameters[ComputeRootCBV].InitAsConstantBufferView(0, 0, D3D12_ROOT_DESCRIPTOR_FLAG_DATA_STATIC, D3D12_SHADER_VISIBILITY_ALL);
             rootParameters[ComputeRootSRVTable].InitAsDescriptorTable(1, &ranges[0], D3D12_SHADER_VISIBILITY_ALL);
             rootParameters[ComputeRootUAVTable].InitAsDescriptorTable(1, &ranges[1], D3D12_SHADER_VISIBILITY_ALL);
+            rootParameters[ComputeRootSortConstants].InitAsConstants(2, 1, 0, D3D12_SHADER_VISIBILITY_ALL);
+            rootParameters[ComputeRootSliceConstants].InitAsConstants(2, 2, 0, D3D12_SHADER_VISIBILITY_ALL);
+            rootParameters[ComputeRootSceneBoundsUAV].InitAsUnorderedAccessView(1, 0, D3D12_ROOT_DESCRIPTOR_FLAG_DATA_VOLATILE, D3D12_SHADER_VISIBILITY_ALL);
+            rootParameters[ComputeRootSortKeysUAV].InitAsUnorderedAccessView(2, 0, D3D12_ROOT_DESCRIPTOR_FLAG_DATA_VOLATILE, D3D12_SHADER_VISIBILITY_ALL);
+            rootParameters[ComputeRootTreeNodesUAV].InitAsUnorderedAccessView(3, 0, D3D12_ROOT_DESCRIPTOR_FLAG_DATA_VOLATILE, D3D12_SHADER_VISIBILITY_ALL);
+            rootParameters[ComputeRootTreeLinksUAV].InitAsUnorderedAccessView(4, 0, D3D12_ROOT_DESCRIPTOR_FLAG_DATA_VOLATILE, D3D12_SHADER_VISIBILITY_ALL);
 
             CD3DX12_VERSIONED_ROOT_SIGNATURE_DESC computeRootSignatureDesc;
             computeRootSignatureDesc.Init_1_1(_countof(rootParameters), rootParameters, 0, nullptr);
@@ -239,6 +286,7 @@ void D3D12nBodyGravity::LoadAssets()
     // Create the pipeline states, which includes compiling and loading shaders.
     {
         ComPtr<ID3DBlob> vertexShader;
+        ComPtr<ID3DBlob> quadVertexShader;
         ComPtr<ID3DBlob> geometryShader;
         ComPtr<ID3DBlob> pixelShader;
         ComPtr<ID3DBlob> computeShader;
@@ -252,6 +300,7 @@ void D3D12nBodyGravity::LoadAssets()
 
         // Load and compile shaders.
         ThrowIfFailed(D3DCompileFromFile(GetAssetFullPath(L"ParticleDraw.hlsl").c_str(), nullptr, nullptr, "VSParticleDraw", "vs_5_0", compileFlags, 0, &vertexShader, nullptr));
+        ThrowIfFailed(D3DCompileFromFile(GetAssetFullPath(L"ParticleDraw.hlsl").c_str(), nullptr, nullptr, "VSParticleDrawQuad", "vs_5_0", compileFlags, 0, &quadVertexShader, nullptr));
         ThrowIfFailed(D3DCompileFromFile(GetAssetFullPath(L"ParticleDraw.hlsl").c_str(), nullptr, nullptr, "GSParticleDraw", "gs_5_0", compileFlags, 0, &geometryShader, nullptr));
         ThrowIfFailed(D3DCompileFromFile(GetAssetFullPath(L"ParticleDraw.hlsl").c_str(), nullptr, nullptr, "PSParticleDraw", "ps_5_0", compileFlags, 0, &pixelShader, nullptr));
         ThrowIfFailed(D3DCompileFromFile(GetAssetFullPath(L"NBodyGravityCS.hlsl").c_str(), nullptr, nullptr, "CSMain", "cs_5_0", compileFlags, 0, &computeShader, nullptr));
@@ -293,6 +342,16 @@ void D3D12nBodyGravity::LoadAssets()
         ThrowIfFailed(m_device->CreateGraphicsPipelineState(&psoDesc, IID_PPV_ARGS(&m_pipelineState)));
         NAME_D3D12_OBJECT(m_pipelineState);
 
+        // The vertex pulling PSO expands the sprites in the vertex shader. 
+        // It reads everything from the particle SRV, so it has no input layout.
+        psoDesc.InputLayout = {};
+        psoDesc.VS = CD3DX12_SHADER_BYTECODE(quadVertexShader.Get());
+        psoDesc.GS = {};
+        psoDesc.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
+
+        ThrowIfFailed(m_device->CreateGraphicsPipelineState(&psoDesc, IID_PPV_ARGS(&m_quadPipelineState)));
+        NAME_D3D12_OBJECT(m_quadPipelineState);
+
         // Describe and create the compute pipeline state object (PSO).
         D3D12_COMPUTE_PIPELINE_STATE_DESC computePsoDesc = {};
         computePsoDesc.pRootSignature = m_computeRootSignature.Get();
@@ -300,14 +359,60 @@ void D3D12nBodyGravity::LoadAssets()
 
         ThrowIfFailed(m_device->CreateComputePipelineState(&computePsoDesc, IID_PPV_ARGS(&m_computeState)));
         NAME_D3D12_OBJECT(m_computeState);
+
+        // The Barnes-Hut passes live alongside the brute force shader.
+        const LPCSTR treeEntryPoints[TreePassCount] =
+        {
+            "CSClearBounds",
+            "CSComputeBounds",
+            "CSMortonCodes",
+            "CSBitonicSortLocal",
+            "CSBitonicSortStep",
+            "CSBitonicSortMerge",
+            "CSBuildTree",
+            "CSSummarizeTree",
+            "CSTreeForces",
+        };
+
+        for (UINT pass = 0; pass < TreePassCount; pass++)
+        {
+            ComPtr<ID3DBlob> treeShader;
+            ThrowIfFailed(D3DCompileFromFile(GetAssetFullPath(L"NBodyGravityCS.hlsl").c_str(), nullptr, nullptr, treeEntryPoints[pass], "cs_5_0", compileFlags, 0, &treeShader, nullptr));
+
+            computePsoDesc.CS = CD3DX12_SHADER_BYTECODE(treeShader.Get());
+            ThrowIfFailed(m_device->CreateComputePipelineState(&computePsoDesc, IID_PPV_ARGS(&m_treeStates[pass])));
+            NAME_D3D12_OBJECT_INDEXED(m_treeStates, pass);
+        }
     }
 
     // Create the command list.
     ThrowIfFailed(m_device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, m_commandAllocators[m_frameIndex].Get(), m_pipelineState.Get(), IID_PPV_ARGS(&m_commandList)));
     NAME_D3D12_OBJECT(m_commandList);
 
+    // Time the particle draw of every frame in flight, so that the two draw
+    // modes can be compared.
+    {
+        D3D12_QUERY_HEAP_DESC queryHeapDesc = {};
+        queryHeapDesc.Type = D3D12_QUERY_HEAP_TYPE_TIMESTAMP;
+        queryHeapDesc.Count = 2 * FrameCount;
+        ThrowIfFailed(m_device->CreateQueryHeap(&queryHeapDesc, IID_PPV_ARGS(&m_drawTimestampQueryHeap)));
+
+        ThrowIfFailed(m_device->CreateCommittedResource(
+            &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_READBACK),
+            D3D12_HEAP_FLAG_NONE,
+            &CD3DX12_RESOURCE_DESC::Buffer(2 * FrameCount * sizeof(UINT64)),
+            D3D12_RESOURCE_STATE_COPY_DEST,
+            nullptr,
+            IID_PPV_ARGS(&m_drawTimestampReadbackBuffer)));
+
+        ThrowIfFailed(m_commandQueue->GetTimestampFrequency(&m_drawTimestampFrequency));
+    }
+
     CreateVertexBuffer();
+    CreateQuadIndexBuffer();
     CreateParticleBuffers();
+    CreateTreeBuffers();
+    RebalanceSlices();
 
     // Note: ComPtr's are CPU objects but this resource needs to stay in scope until
     // the command list that references it has finished executing on the GPU.
@@ -338,10 +443,12 @@ void D3D12nBodyGravity::LoadAssets()
         NAME_D3D12_OBJECT(m_constantBufferCS);
 
         ConstantBufferCS constantBufferCS = {};
-        constantBufferCS.param[0] = ParticleCount;
-        constantBufferCS.param[1] = int(ceil(ParticleCount / 128.0f));
+        constantBufferCS.param[0] = m_particleCount;
+        constantBufferCS.param[1] = int(ceil(m_particleCount / 128.0f));
+        constantBufferCS.param[2] = m_sortCount;
         constantBufferCS.paramf[0] = 0.1f;
         constantBufferCS.paramf[1] = 1.0f;
+        constantBufferCS.paramf[2] = BarnesHutTheta * BarnesHutTheta;
 
         D3D12_SUBRESOURCE_DATA computeCBData = {};
         computeCBData.pData = reinterpret_cast<UINT8*>(&constantBufferCS);
@@ -396,12 +503,12 @@ void D3D12nBodyGravity::LoadAssets()
 void D3D12nBodyGravity::CreateVertexBuffer()
 {
     std::vector<ParticleVertex> vertices;
-    vertices.resize(ParticleCount);
-    for (UINT i = 0; i < ParticleCount; i++)
+    vertices.resize(m_particleCount);
+    for (UINT i = 0; i < m_particleCount; i++)
     {
         vertices[i].color = XMFLOAT4(1.0f, 1.0f, 0.2f, 1.0f);
     }
-    const UINT bufferSize = ParticleCount * sizeof(ParticleVertex);
+    const UINT bufferSize = m_particleCount * sizeof(ParticleVertex);
 
     ThrowIfFailed(m_device->CreateCommittedResource(
         &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT),
@@ -434,6 +541,55 @@ void D3D12nBodyGravity::CreateVertexBuffer()
     m_vertexBufferView.StrideInBytes = sizeof(ParticleVertex);
 }
 
+// Create the index buffer of the vertex pulling draw. Quad n is made of 
+// vertices [4n, 4n + 4), in the same order the geometry shader emits them, 
+// and each instance of the draw covers QuadsPerInstance particles.
+void D3D12nBodyGravity::CreateQuadIndexBuffer()
+{
+    const UINT quadIndices[6] = { 0, 1, 2, 2, 1, 3 };
+
+    std::vector<UINT16> indices;
+    indices.resize(QuadsPerInstance * 6);
+    for (UINT i = 0; i < QuadsPerInstance; i++)
+    {
+        for (UINT j = 0; j < 6; j++)
+        {
+            indices[i * 6 + j] = static_cast<UINT16>(i * 4 + quadIndices[j]);
+        }
+    }
+    const UINT bufferSize = static_cast<UINT>(indices.size() * sizeof(UINT16));
+
+    ThrowIfFailed(m_device->CreateCommittedResource(
+        &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT),
+        D3D12_HEAP_FLAG_NONE,
+        &CD3DX12_RESOURCE_DESC::Buffer(bufferSize),
+        D3D12_RESOURCE_STATE_COPY_DEST,
+        nullptr,
+        IID_PPV_ARGS(&m_quadIndexBuffer)));
+
+    ThrowIfFailed(m_device->CreateCommittedResource(
+        &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
+        D3D12_HEAP_FLAG_NONE,
+        &CD3DX12_RESOURCE_DESC::Buffer(bufferSize),
+        D3D12_RESOURCE_STATE_GENERIC_READ,
+        nullptr,
+        IID_PPV_ARGS(&m_quadIndexBufferUpload)));
+
+    NAME_D3D12_OBJECT(m_quadIndexBuffer);
+
+    D3D12_SUBRESOURCE_DATA indexData = {};
+    indexData.pData = reinterpret_cast<UINT8*>(&indices[0]);
+    indexData.RowPitch = bufferSize;
+    indexData.SlicePitch = indexData.RowPitch;
+
+    UpdateSubresources<1>(m_commandList.Get(), m_quadIndexBuffer.Get(), m_quadIndexBufferUpload.Get(), 0, 0, 1, &indexData);
+    m_commandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(m_quadIndexBuffer.Get(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_INDEX_BUFFER));
+
+    m_quadIndexBufferView.BufferLocation = m_quadIndexBuffer->GetGPUVirtualAddress();
+    m_quadIndexBufferView.SizeInBytes = bufferSize;
+    m_quadIndexBufferView.Format = DXGI_FORMAT_R16_UINT;
+}
+
 // Random percent value, from -1 to 1.
 float D3D12nBodyGravity::RandomPercent()
 {
@@ -469,103 +625,171 @@ void D3D12nBodyGravity::CreateParticleBuffers()
 {
     // Initialize the data in the buffers.
     std::vector<Particle> data;
-    data.resize(ParticleCount);
-    const UINT dataSize = ParticleCount * sizeof(Particle);
+    data.resize(m_particleCount);
+    const UINT dataSize = m_particleCount * sizeof(Particle);
 
     // Split the particles into two groups.
     float centerSpread = ParticleSpread * 0.50f;
-    LoadParticles(&data[0], XMFLOAT3(centerSpread, 0, 0), XMFLOAT4(0, 0, -20, 1 / 100000000.0f), ParticleSpread, ParticleCount / 2);
-    LoadParticles(&data[ParticleCount / 2], XMFLOAT3(-centerSpread, 0, 0), XMFLOAT4(0, 0, 20, 1 / 100000000.0f), ParticleSpread, ParticleCount / 2);
+    LoadParticles(&data[0], XMFLOAT3(centerSpread, 0, 0), XMFLOAT4(0, 0, -20, 1 / 100000000.0f), ParticleSpread, m_particleCount / 2);
+    LoadParticles(&data[m_particleCount / 2], XMFLOAT3(-centerSpread, 0, 0), XMFLOAT4(0, 0, 20, 1 / 100000000.0f), ParticleSpread, m_particleCount / 2);
 
     D3D12_HEAP_PROPERTIES defaultHeapProperties = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT);
     D3D12_HEAP_PROPERTIES uploadHeapProperties = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD);
     D3D12_RESOURCE_DESC bufferDesc = CD3DX12_RESOURCE_DESC::Buffer(dataSize, D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
     D3D12_RESOURCE_DESC uploadBufferDesc = CD3DX12_RESOURCE_DESC::Buffer(dataSize);
 
-    for (UINT index = 0; index < ThreadCount; index++)
+    // Create two buffers in the GPU, each with a copy of the particles data.
+    // The compute shader will update one of them while the rendering thread 
+    // renders the other. When rendering completes, the threads will swap 
+    // which buffer they work on.
+    //
+    // The buffers are left in the common state. Every queue promotes them 
+    // implicitly, and the compute queues write to them at the same time, 
+    // each within its own slice, which is allowed for buffers as long as 
+    // the writes don't overlap.
+
+    ThrowIfFailed(m_device->CreateCommittedResource(
+        &defaultHeapProperties,
+        D3D12_HEAP_FLAG_NONE,
+        &bufferDesc,
+        D3D12_RESOURCE_STATE_COPY_DEST,
+        nullptr,
+        IID_PPV_ARGS(&m_particleBuffer0)));
+
+    ThrowIfFailed(m_device->CreateCommittedResource(
+        &defaultHeapProperties,
+        D3D12_HEAP_FLAG_NONE,
+        &bufferDesc,
+        D3D12_RESOURCE_STATE_COPY_DEST,
+        nullptr,
+        IID_PPV_ARGS(&m_particleBuffer1)));
+
+    ThrowIfFailed(m_device->CreateCommittedResource(
+        &uploadHeapProperties,
+        D3D12_HEAP_FLAG_NONE,
+        &uploadBufferDesc,
+        D3D12_RESOURCE_STATE_GENERIC_READ,
+        nullptr,
+        IID_PPV_ARGS(&m_particleBuffer0Upload)));
+
+    ThrowIfFailed(m_device->CreateCommittedResource(
+        &uploadHeapProperties,
+        D3D12_HEAP_FLAG_NONE,
+        &uploadBufferDesc,
+        D3D12_RESOURCE_STATE_GENERIC_READ,
+        nullptr,
+        IID_PPV_ARGS(&m_particleBuffer1Upload)));
+
+    NAME_D3D12_OBJECT(m_particleBuffer0);
+    NAME_D3D12_OBJECT(m_particleBuffer1);
+
+    D3D12_SUBRESOURCE_DATA particleData = {};
+    particleData.pData = reinterpret_cast<UINT8*>(&data[0]);
+    particleData.RowPitch = dataSize;
+    particleData.SlicePitch = particleData.RowPitch;
+
+    UpdateSubresources<1>(m_commandList.Get(), m_particleBuffer0.Get(), m_particleBuffer0Upload.Get(), 0, 0, 1, &particleData);
+    UpdateSubresources<1>(m_commandList.Get(), m_particleBuffer1.Get(), m_particleBuffer1Upload.Get(), 0, 0, 1, &particleData);
+    m_commandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(m_particleBuffer0.Get(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_COMMON));
+    m_commandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(m_particleBuffer1.Get(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_COMMON));
+
+    D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+    srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+    srvDesc.Format = DXGI_FORMAT_UNKNOWN;
+    srvDesc.ViewDimension = D3D12_SRV_DIMENSION_BUFFER;
+    srvDesc.Buffer.FirstElement = 0;
+    srvDesc.Buffer.NumElements = m_particleCount;
+    srvDesc.Buffer.StructureByteStride = sizeof(Particle);
+    srvDesc.Buffer.Flags = D3D12_BUFFER_SRV_FLAG_NONE;
+
+    CD3DX12_CPU_DESCRIPTOR_HANDLE srvHandle0(m_srvUavHeap->GetCPUDescriptorHandleForHeapStart(), SrvParticlePosVelo0, m_srvUavDescriptorSize);
+    CD3DX12_CPU_DESCRIPTOR_HANDLE srvHandle1(m_srvUavHeap->GetCPUDescriptorHandleForHeapStart(), SrvParticlePosVelo1, m_srvUavDescriptorSize);
+    m_device->CreateShaderResourceView(m_particleBuffer0.Get(), &srvDesc, srvHandle0);
+    m_device->CreateShaderResourceView(m_particleBuffer1.Get(), &srvDesc, srvHandle1);
+
+    D3D12_UNORDERED_ACCESS_VIEW_DESC uavDesc = {};
+    uavDesc.Format = DXGI_FORMAT_UNKNOWN;
+    uavDesc.ViewDimension = D3D12_UAV_DIMENSION_BUFFER;
+    uavDesc.Buffer.FirstElement = 0;
+    uavDesc.Buffer.NumElements = m_particleCount;
+    uavDesc.Buffer.StructureByteStride = sizeof(Particle);
+    uavDesc.Buffer.CounterOffsetInBytes = 0;
+    uavDesc.Buffer.Flags = D3D12_BUFFER_UAV_FLAG_NONE;
+
+    CD3DX12_CPU_DESCRIPTOR_HANDLE uavHandle0(m_srvUavHeap->GetCPUDescriptorHandleForHeapStart(), UavParticlePosVelo0, m_srvUavDescriptorSize);
+    CD3DX12_CPU_DESCRIPTOR_HANDLE uavHandle1(m_srvUavHeap->GetCPUDescriptorHandleForHeapStart(), UavParticlePosVelo1, m_srvUavDescriptorSize);
+    m_device->CreateUnorderedAccessView(m_particleBuffer0.Get(), nullptr, &uavDesc, uavHandle0);
+    m_device->CreateUnorderedAccessView(m_particleBuffer1.Get(), nullptr, &uavDesc, uavHandle1);
+}
+
+// Create the scratch buffers the Barnes-Hut passes rebuild every step. None 
+// of them needs initial data, so they are created straight in the UAV state.
+void D3D12nBodyGravity::CreateTreeBuffers()
+{
+    // The bitonic sort works on a power of two number of keys, and on at 
+    // least one full block of them.
+    m_sortCount = SortBlockSize;
+    while (m_sortCount < m_particleCount)
     {
-        // Create two buffers in the GPU, each with a copy of the particles data.
-        // The compute shader will update one of them while the rendering thread 
-        // renders the other. When rendering completes, the threads will swap 
-        // which buffer they work on.
+        m_sortCount *= 2;
+    }
+
+    const UINT nodeCount = 2 * m_particleCount - 1;    // Internal nodes, then one leaf per particle.
+    const UINT sceneBoundsSize = 6 * sizeof(UINT);
+    const UINT sortKeySize = m_sortCount * 2 * sizeof(UINT);
+    const UINT treeNodeSize = nodeCount * 12 * sizeof(float);
+    const UINT treeLinkSize = nodeCount * 2 * sizeof(UINT);
+
+    D3D12_HEAP_PROPERTIES defaultHeapProperties = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT);
 
+    for (UINT index = 0; index < ThreadCount; index++)
+    {
         ThrowIfFailed(m_device->CreateCommittedResource(
             &defaultHeapProperties,
             D3D12_HEAP_FLAG_NONE,
-            &bufferDesc,
-            D3D12_RESOURCE_STATE_COPY_DEST,
+            &CD3DX12_RESOURCE_DESC::Buffer(sceneBoundsSize, D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS),
+            D3D12_RESOURCE_STATE_UNORDERED_ACCESS,
             nullptr,
-            IID_PPV_ARGS(&m_particleBuffer0[index])));
+            IID_PPV_ARGS(&m_sceneBoundsBuffer[index])));
 
         ThrowIfFailed(m_device->CreateCommittedResource(
             &defaultHeapProperties,
             D3D12_HEAP_FLAG_NONE,
-            &bufferDesc,
-            D3D12_RESOURCE_STATE_COPY_DEST,
+            &CD3DX12_RESOURCE_DESC::Buffer(sortKeySize, D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS),
+            D3D12_RESOURCE_STATE_UNORDERED_ACCESS,
             nullptr,
-            IID_PPV_ARGS(&m_particleBuffer1[index])));
+            IID_PPV_ARGS(&m_sortKeyBuffer[index])));
 
         ThrowIfFailed(m_device->CreateCommittedResource(
-            &uploadHeapProperties,
+            &defaultHeapProperties,
             D3D12_HEAP_FLAG_NONE,
-            &uploadBufferDesc,
-            D3D12_RESOURCE_STATE_GENERIC_READ,
+            &CD3DX12_RESOURCE_DESC::Buffer(treeNodeSize, D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS),
+            D3D12_RESOURCE_STATE_UNORDERED_ACCESS,
             nullptr,
-            IID_PPV_ARGS(&m_particleBuffer0Upload[index])));
+            IID_PPV_ARGS(&m_treeNodeBuffer[index])));
 
         ThrowIfFailed(m_device->CreateCommittedResource(
-            &uploadHeapProperties,
+            &defaultHeapProperties,
             D3D12_HEAP_FLAG_NONE,
-            &uploadBufferDesc,
-            D3D12_RESOURCE_STATE_GENERIC_READ,
+            &CD3DX12_RESOURCE_DESC::Buffer(treeLinkSize, D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS),
+            D3D12_RESOURCE_STATE_UNORDERED_ACCESS,
             nullptr,
-            IID_PPV_ARGS(&m_particleBuffer1Upload[index])));
-
-        NAME_D3D12_OBJECT_INDEXED(m_particleBuffer0, index);
-        NAME_D3D12_OBJECT_INDEXED(m_particleBuffer1, index);
-
-        D3D12_SUBRESOURCE_DATA particleData = {};
-        particleData.pData = reinterpret_cast<UINT8*>(&data[0]);
-        particleData.RowPitch = dataSize;
-        particleData.SlicePitch = particleData.RowPitch;
-
-        UpdateSubresources<1>(m_commandList.Get(), m_particleBuffer0[index].Get(), m_particleBuffer0Upload[index].Get(), 0, 0, 1, &particleData);
-        UpdateSubresources<1>(m_commandList.Get(), m_particleBuffer1[index].Get(), m_particleBuffer1Upload[index].Get(), 0, 0, 1, &particleData);
-        m_commandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(m_particleBuffer0[index].Get(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE));
-        m_commandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(m_particleBuffer1[index].Get(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE));
-
-        D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
-        srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
-        srvDesc.Format = DXGI_FORMAT_UNKNOWN;
-        srvDesc.ViewDimension = D3D12_SRV_DIMENSION_BUFFER;
-        srvDesc.Buffer.FirstElement = 0;
-        srvDesc.Buffer.NumElements = ParticleCount;
-        srvDesc.Buffer.StructureByteStride = sizeof(Particle);
-        srvDesc.Buffer.Flags = D3D12_BUFFER_SRV_FLAG_NONE;
-
-        CD3DX12_CPU_DESCRIPTOR_HANDLE srvHandle0(m_srvUavHeap->GetCPUDescriptorHandleForHeapStart(), SrvParticlePosVelo0 + index, m_srvUavDescriptorSize);
-        CD3DX12_CPU_DESCRIPTOR_HANDLE srvHandle1(m_srvUavHeap->GetCPUDescriptorHandleForHeapStart(), SrvParticlePosVelo1 + index, m_srvUavDescriptorSize);
-        m_device->CreateShaderResourceView(m_particleBuffer0[index].Get(), &srvDesc, srvHandle0);
-        m_device->CreateShaderResourceView(m_particleBuffer1[index].Get(), &srvDesc, srvHandle1);
-
-        D3D12_UNORDERED_ACCESS_VIEW_DESC uavDesc = {};
-        uavDesc.Format = DXGI_FORMAT_UNKNOWN;
-        uavDesc.ViewDimension = D3D12_UAV_DIMENSION_BUFFER;
-        uavDesc.Buffer.FirstElement = 0;
-        uavDesc.Buffer.NumElements = ParticleCount;
-        uavDesc.Buffer.StructureByteStride = sizeof(Particle);
-        uavDesc.Buffer.CounterOffsetInBytes = 0;
-        uavDesc.Buffer.Flags = D3D12_BUFFER_UAV_FLAG_NONE;
-
-        CD3DX12_CPU_DESCRIPTOR_HANDLE uavHandle0(m_srvUavHeap->GetCPUDescriptorHandleForHeapStart(), UavParticlePosVelo0 + index, m_srvUavDescriptorSize);
-        CD3DX12_CPU_DESCRIPTOR_HANDLE uavHandle1(m_srvUavHeap->GetCPUDescriptorHandleForHeapStart(), UavParticlePosVelo1 + index, m_srvUavDescriptorSize);
-        m_device->CreateUnorderedAccessView(m_particleBuffer0[index].Get(), nullptr, &uavDesc, uavHandle0);
-        m_device->CreateUnorderedAccessView(m_particleBuffer1[index].Get(), nullptr, &uavDesc, uavHandle1);
+            IID_PPV_ARGS(&m_treeLinkBuffer[index])));
+
+        NAME_D3D12_OBJECT_INDEXED(m_sceneBoundsBuffer, index);
+        NAME_D3D12_OBJECT_INDEXED(m_sortKeyBuffer, index);
+        NAME_D3D12_OBJECT_INDEXED(m_treeNodeBuffer, index);
+        NAME_D3D12_OBJECT_INDEXED(m_treeLinkBuffer, index);
     }
 }
 
 void D3D12nBodyGravity::CreateAsyncContexts()
 {
+    if (!InitializeSynchronizationBarrier(&m_computeBarrier, ThreadCount, -1))
+    {
+        ThrowIfFailed(HRESULT_FROM_WIN32(GetLastError()));
+    }
+
     for (UINT threadIndex = 0; threadIndex < ThreadCount; ++threadIndex)
     {
         // Create compute resources.
@@ -575,6 +799,23 @@ void D3D12nBodyGravity::CreateAsyncContexts()
         ThrowIfFailed(m_device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_COMPUTE, m_computeAllocator[threadIndex].Get(), nullptr, IID_PPV_ARGS(&m_computeCommandList[threadIndex])));
         ThrowIfFailed(m_device->CreateFence(0, D3D12_FENCE_FLAG_SHARED, IID_PPV_ARGS(&m_threadFences[threadIndex])));
 
+        // Two timestamps around the slice's dispatches, resolved to a readback 
+        // buffer that the thread reads once the step completes.
+        D3D12_QUERY_HEAP_DESC queryHeapDesc = {};
+        queryHeapDesc.Type = D3D12_QUERY_HEAP_TYPE_TIMESTAMP;
+        queryHeapDesc.Count = 2;
+        ThrowIfFailed(m_device->CreateQueryHeap(&queryHeapDesc, IID_PPV_ARGS(&m_timestampQueryHeaps[threadIndex])));
+
+        ThrowIfFailed(m_device->CreateCommittedResource(
+            &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_READBACK),
+            D3D12_HEAP_FLAG_NONE,
+            &CD3DX12_RESOURCE_DESC::Buffer(2 * sizeof(UINT64)),
+            D3D12_RESOURCE_STATE_COPY_DEST,
+            nullptr,
+            IID_PPV_ARGS(&m_timestampReadbackBuffers[threadIndex])));
+
+        ThrowIfFailed(m_computeCommandQueue[threadIndex]->GetTimestampFrequency(&m_timestampFrequencies[threadIndex]));
+
         m_threadFenceEvents[threadIndex] = CreateEvent(nullptr, FALSE, FALSE, nullptr);
         if (m_threadFenceEvents[threadIndex] == nullptr)
         {
@@ -647,7 +888,7 @@ void D3D12nBodyGravity::OnRender()
     PIXEndEvent(m_commandQueue.Get());
 
     // Present the frame.
-    ThrowIfFailed(m_swapChain->Present(1, 0));
+    ThrowIfFailed(m_swapChain->Present(GetSyncInterval(), 0));
 
     MoveToNextFrame();
 }
@@ -666,7 +907,7 @@ void D3D12nBodyGravity::PopulateCommandList()
     ThrowIfFailed(m_commandList->Reset(m_commandAllocators[m_frameIndex].Get(), m_pipelineState.Get()));
 
     // Set necessary state.
-    m_commandList->SetPipelineState(m_pipelineState.Get());
+    m_commandList->SetPipelineState(m_useVertexPulling ? m_quadPipelineState.Get() : m_pipelineState.Get());
     m_commandList->SetGraphicsRootSignature(m_rootSignature.Get());
 
     m_commandList->SetGraphicsRootConstantBufferView(GraphicsRootCBV, m_constantBufferGS->GetGPUVirtualAddress() + m_frameIndex * sizeof(ConstantBufferGS));
@@ -674,8 +915,16 @@ void D3D12nBodyGravity::PopulateCommandList()
     ID3D12DescriptorHeap* ppHeaps[] = { m_srvUavHeap.Get() };
     m_commandList->SetDescriptorHeaps(_countof(ppHeaps), ppHeaps);
 
-    m_commandList->IASetVertexBuffers(0, 1, &m_vertexBufferView);
-    m_commandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_POINTLIST);
+    if (m_useVertexPulling)
+    {
+        m_commandList->IASetIndexBuffer(&m_quadIndexBufferView);
+        m_commandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+    }
+    else
+    {
+        m_commandList->IASetVertexBuffers(0, 1, &m_vertexBufferView);
+        m_commandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_POINTLIST);
+    }
     m_commandList->RSSetScissorRects(1, &m_scissorRect);
 
     // Indicate that the back buffer will be used as a render target.
@@ -688,30 +937,43 @@ void D3D12nBodyGravity::PopulateCommandList()
     const float clearColor[] = { 0.0f, 0.0f, 0.1f, 0.0f };
     m_commandList->ClearRenderTargetView(rtvHandle, clearColor, 0, nullptr);
 
-    // Render the particles.
-    float viewportHeight = static_cast<float>(static_cast<UINT>(m_viewport.Height) / m_heightInstances);
-    float viewportWidth = static_cast<float>(static_cast<UINT>(m_viewport.Width) / m_widthInstances);
-    for (UINT n = 0; n < ThreadCount; n++)
-    {
-        const UINT srvIndex = n + (m_srvIndex[n] == 0 ? SrvParticlePosVelo0 : SrvParticlePosVelo1);
-
-        CD3DX12_VIEWPORT viewport(
-            (n % m_widthInstances) * viewportWidth,
-            (n / m_widthInstances) * viewportHeight,
-            viewportWidth,
-            viewportHeight);
+    // Render the particles. Every compute thread wrote its slice of the same 
+    // buffer, so they are drawn together.
+    m_commandList->RSSetViewports(1, &m_viewport);
 
-        m_commandList->RSSetViewports(1, &viewport);
+    const UINT srvIndex = (m_srvIndex == 0 ? SrvParticlePosVelo0 : SrvParticlePosVelo1);
+    CD3DX12_GPU_DESCRIPTOR_HANDLE srvHandle(m_srvUavHeap->GetGPUDescriptorHandleForHeapStart(), srvIndex, m_srvUavDescriptorSize);
+    m_commandList->SetGraphicsRootDescriptorTable(GraphicsRootSRVTable, srvHandle);
 
-        CD3DX12_GPU_DESCRIPTOR_HANDLE srvHandle(m_srvUavHeap->GetGPUDescriptorHandleForHeapStart(), srvIndex, m_srvUavDescriptorSize);
-        m_commandList->SetGraphicsRootDescriptorTable(GraphicsRootSRVTable, srvHandle);
+    PIXBeginEvent(m_commandList.Get(), 0, L"Draw particles");
+    m_commandList->EndQuery(m_drawTimestampQueryHeap.Get(), D3D12_QUERY_TYPE_TIMESTAMP, 2 * m_frameIndex);
 
-        PIXBeginEvent(m_commandList.Get(), 0, L"Draw particles for thread %u", n);
-        m_commandList->DrawInstanced(ParticleCount, 1, 0, 0);
-        PIXEndEvent(m_commandList.Get());
+    if (m_useVertexPulling)
+    {
+        // SV_InstanceID does not include the start instance, so the first 
+        // particle of the draw is passed as a root constant instead. Full 
+        // instances are drawn together and the remainder as one short instance.
+        const UINT fullInstances = m_particleCount / QuadsPerInstance;
+        const UINT remainder = m_particleCount % QuadsPerInstance;
+        if (fullInstances > 0)
+        {
+            m_commandList->SetGraphicsRoot32BitConstant(GraphicsRootDrawConstants, 0, 0);
+            m_commandList->DrawIndexedInstanced(QuadsPerInstance * 6, fullInstances, 0, 0, 0);
+        }
+        if (remainder > 0)
+        {
+            m_commandList->SetGraphicsRoot32BitConstant(GraphicsRootDrawConstants, fullInstances * QuadsPerInstance, 0);
+            m_commandList->DrawIndexedInstanced(remainder * 6, 1, 0, 0, 0);
+        }
+    }
+    else
+    {
+        m_commandList->DrawInstanced(m_particleCount, 1, 0, 0);
     }
 
-    m_commandList->RSSetViewports(1, &m_viewport);
+    m_commandList->EndQuery(m_drawTimestampQueryHeap.Get(), D3D12_QUERY_TYPE_TIMESTAMP, 2 * m_frameIndex + 1);
+    m_commandList->ResolveQueryData(m_drawTimestampQueryHeap.Get(), D3D12_QUERY_TYPE_TIMESTAMP, 2 * m_frameIndex, 2, m_drawTimestampReadbackBuffer.Get(), 2 * m_frameIndex * sizeof(UINT64));
+    PIXEndEvent(m_commandList.Get());
 
     // Indicate that the back buffer will now be used to present.
     m_commandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(m_renderTargets[m_frameIndex].Get(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PRESENT));
@@ -726,7 +988,7 @@ DWORD D3D12nBodyGravity::AsyncComputeThreadProc(int threadIndex)
     ID3D12GraphicsCommandList* pCommandList = m_computeCommandList[threadIndex].Get();
     ID3D12Fence* pFence = m_threadFences[threadIndex].Get();
 
-    while (0 == InterlockedGetValue(&m_terminating))
+    while (true)
     {
         // Run the particle simulation.
         Simulate(threadIndex);
@@ -745,6 +1007,13 @@ DWORD D3D12nBodyGravity::AsyncComputeThreadProc(int threadIndex)
         ThrowIfFailed(pFence->SetEventOnCompletion(threadFenceValue, m_threadFenceEvents[threadIndex]));
         WaitForSingleObject(m_threadFenceEvents[threadIndex], INFINITE);
 
+        // Read back how long this thread's slice took.
+        const CD3DX12_RANGE timestampRange(0, 2 * sizeof(UINT64));
+        UINT64* pTimestamps;
+        ThrowIfFailed(m_timestampReadbackBuffers[threadIndex]->Map(0, &timestampRange, reinterpret_cast<void**>(&pTimestamps)));
+        m_sliceTimes[threadIndex] = static_cast<float>(static_cast<double>(pTimestamps[1] - pTimestamps[0]) * 1000.0 / m_timestampFrequencies[threadIndex]);
+        m_timestampReadbackBuffers[threadIndex]->Unmap(0, &CD3DX12_RANGE(0, 0));
+
         // Wait for the render thread to be done with the SRV so that
         // the next frame in the simulation can run.
         UINT64 renderContextFenceValue = InterlockedGetValue(&m_renderContextFenceValues[threadIndex]);
@@ -754,12 +1023,29 @@ DWORD D3D12nBodyGravity::AsyncComputeThreadProc(int threadIndex)
             InterlockedExchange(&m_renderContextFenceValues[threadIndex], 0);
         }
 
-        // Swap the indices to the SRV and UAV.
-        m_srvIndex[threadIndex] = 1 - m_srvIndex[threadIndex];
-
         // Prepare for the next frame.
         ThrowIfFailed(pCommandAllocator->Reset());
         ThrowIfFailed(pCommandList->Reset(pCommandAllocator, m_computeState.Get()));
+
+        // Every slice of this step has to finish before any thread reads the 
+        // buffer it was written to. Once all threads are here, the first one 
+        // swaps the buffers, resizes the slices and checks for shutdown while 
+        // the others wait, so all of them agree on the next step.
+        EnterSynchronizationBarrier(&m_computeBarrier, 0);
+        if (threadIndex == 0)
+        {
+            // Swap the indices to the SRV and UAV.
+            m_srvIndex = 1 - m_srvIndex;
+
+            RebalanceSlices();
+            m_stopCompute = (InterlockedGetValue(&m_terminating) != 0);
+        }
+        EnterSynchronizationBarrier(&m_computeBarrier, 0);
+
+        if (m_stopCompute)
+        {
+            break;
+        }
     }
 
     return 0;
@@ -770,23 +1056,10 @@ void D3D12nBodyGravity::Simulate(UINT threadIndex)
 {
     ID3D12GraphicsCommandList* pCommandList = m_computeCommandList[threadIndex].Get();
 
-    UINT srvIndex;
-    UINT uavIndex;
-    ID3D12Resource *pUavResource;
-    if (m_srvIndex[threadIndex] == 0)
-    {
-        srvIndex = SrvParticlePosVelo0;
-        uavIndex = UavParticlePosVelo1;
-        pUavResource = m_particleBuffer1[threadIndex].Get();
-    }
-    else
-    {
-        srvIndex = SrvParticlePosVelo1;
-        uavIndex = UavParticlePosVelo0;
-        pUavResource = m_particleBuffer0[threadIndex].Get();
-    }
-
-    pCommandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(pUavResource, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS));
+    // The particle buffers stay in the common state and are promoted on use, 
+    // so no transitions are needed even though every queue shares them.
+    const UINT srvIndex = (m_srvIndex == 0) ? SrvParticlePosVelo0 : SrvParticlePosVelo1;
+    const UINT uavIndex = (m_srvIndex == 0) ? UavParticlePosVelo1 : UavParticlePosVelo0;
 
     pCommandList->SetPipelineState(m_computeState.Get());
     pCommandList->SetComputeRootSignature(m_computeRootSignature.Get());
@@ -794,16 +1067,142 @@ void D3D12nBodyGravity::Simulate(UINT threadIndex)
     ID3D12DescriptorHeap* ppHeaps[] = { m_srvUavHeap.Get() };
     pCommandList->SetDescriptorHeaps(_countof(ppHeaps), ppHeaps);
 
-    CD3DX12_GPU_DESCRIPTOR_HANDLE srvHandle(m_srvUavHeap->GetGPUDescriptorHandleForHeapStart(), srvIndex + threadIndex, m_srvUavDescriptorSize);
-    CD3DX12_GPU_DESCRIPTOR_HANDLE uavHandle(m_srvUavHeap->GetGPUDescriptorHandleForHeapStart(), uavIndex + threadIndex, m_srvUavDescriptorSize);
+    CD3DX12_GPU_DESCRIPTOR_HANDLE srvHandle(m_srvUavHeap->GetGPUDescriptorHandleForHeapStart(), srvIndex, m_srvUavDescriptorSize);
+    CD3DX12_GPU_DESCRIPTOR_HANDLE uavHandle(m_srvUavHeap->GetGPUDescriptorHandleForHeapStart(), uavIndex, m_srvUavDescriptorSize);
 
     pCommandList->SetComputeRootConstantBufferView(ComputeRootCBV, m_constantBufferCS->GetGPUVirtualAddress());
     pCommandList->SetComputeRootDescriptorTable(ComputeRootSRVTable, srvHandle);
     pCommandList->SetComputeRootDescriptorTable(ComputeRootUAVTable, uavHandle);
 
-    pCommandList->Dispatch(static_cast<int>(ceil(ParticleCount / 128.0f)), 1, 1);
+    // This thread only updates its own slice, but against every particle.
+    const UINT sliceConstants[] = { m_sliceOffsets[threadIndex], m_sliceOffsets[threadIndex + 1] - m_sliceOffsets[threadIndex] };
+    pCommandList->SetComputeRoot32BitConstants(ComputeRootSliceConstants, _countof(sliceConstants), sliceConstants, 0);
 
-    pCommandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(pUavResource, D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE));
+    ID3D12QueryHeap* pQueryHeap = m_timestampQueryHeaps[threadIndex].Get();
+    if (m_useBarnesHut)
+    {
+        SimulateBarnesHut(threadIndex);
+    }
+    else
+    {
+        pCommandList->EndQuery(pQueryHeap, D3D12_QUERY_TYPE_TIMESTAMP, 0);
+        pCommandList->Dispatch((sliceConstants[1] + 127) / 128, 1, 1);
+        pCommandList->EndQuery(pQueryHeap, D3D12_QUERY_TYPE_TIMESTAMP, 1);
+    }
+
+    pCommandList->ResolveQueryData(pQueryHeap, D3D12_QUERY_TYPE_TIMESTAMP, 0, 2, m_timestampReadbackBuffers[threadIndex].Get(), 0);
+}
+
+// Resize the slices in proportion to how many particles per millisecond each 
+// queue got through last step, in whole thread groups.
+void D3D12nBodyGravity::RebalanceSlices()
+{
+    // Blend each measurement into a running average so that one noisy step 
+    // doesn't move the split much.
+    float totalRate = 0.0f;
+    for (UINT n = 0; n < ThreadCount; n++)
+    {
+        const UINT sliceCount = m_sliceOffsets[n + 1] - m_sliceOffsets[n];
+        if (sliceCount > 0 && m_sliceTimes[n] > 0.0f)
+        {
+            m_sliceRates[n] += 0.25f * (sliceCount / m_sliceTimes[n] - m_sliceRates[n]);
+        }
+        totalRate += m_sliceRates[n];
+    }
+
+    // Leave every queue at least one group so that it keeps being measured.
+    const UINT groupCount = (m_particleCount + 127) / 128;
+    const UINT minGroups = (groupCount >= ThreadCount) ? 1 : 0;
+
+    float rate = 0.0f;
+    UINT group = 0;
+    m_sliceOffsets[0] = 0;
+    for (UINT n = 1; n < ThreadCount; n++)
+    {
+        rate += m_sliceRates[n - 1];
+        UINT end = static_cast<UINT>(groupCount * rate / totalRate + 0.5f);
+        end = max(end, group + minGroups);
+        end = min(end, groupCount - minGroups * (ThreadCount - n));
+
+        m_sliceOffsets[n] = min(end * 128, m_particleCount);
+        group = end;
+    }
+    m_sliceOffsets[ThreadCount] = m_particleCount;
+}
+
+// Record the Barnes-Hut passes. Simulate() has already bound the particle 
+// buffers and the slice. Each queue builds the whole tree itself, which is 
+// cheap next to the force pass, and only the force pass is sliced and timed.
+void D3D12nBodyGravity::SimulateBarnesHut(UINT threadIndex)
+{
+    ID3D12GraphicsCommandList* pCommandList = m_computeCommandList[threadIndex].Get();
+
+    pCommandList->SetComputeRootUnorderedAccessView(ComputeRootSceneBoundsUAV, m_sceneBoundsBuffer[threadIndex]->GetGPUVirtualAddress());
+    pCommandList->SetComputeRootUnorderedAccessView(ComputeRootSortKeysUAV, m_sortKeyBuffer[threadIndex]->GetGPUVirtualAddress());
+    pCommandList->SetComputeRootUnorderedAccessView(ComputeRootTreeNodesUAV, m_treeNodeBuffer[threadIndex]->GetGPUVirtualAddress());
+    pCommandList->SetComputeRootUnorderedAccessView(ComputeRootTreeLinksUAV, m_treeLinkBuffer[threadIndex]->GetGPUVirtualAddress());
+
+    // Every pass reads what the one before it wrote.
+    const CD3DX12_RESOURCE_BARRIER uavBarrier = CD3DX12_RESOURCE_BARRIER::UAV(nullptr);
+    const UINT particleGroups = (m_particleCount + 127) / 128;
+    const UINT sortBlocks = m_sortCount / SortBlockSize;
+
+    PIXBeginEvent(pCommandList, 0, L"Build Barnes-Hut tree");
+
+    pCommandList->SetPipelineState(m_treeStates[TreePassClearBounds].Get());
+    pCommandList->Dispatch(1, 1, 1);
+    pCommandList->ResourceBarrier(1, &uavBarrier);
+
+    pCommandList->SetPipelineState(m_treeStates[TreePassComputeBounds].Get());
+    pCommandList->Dispatch(particleGroups, 1, 1);
+    pCommandList->ResourceBarrier(1, &uavBarrier);
+
+    pCommandList->SetPipelineState(m_treeStates[TreePassMortonCodes].Get());
+    pCommandList->Dispatch(m_sortCount / 128, 1, 1);
+    pCommandList->ResourceBarrier(1, &uavBarrier);
+
+    // Bitonic sort of the Morton codes. Blocks are sorted in group shared 
+    // memory first, and each merge after that only goes to device memory for 
+    // the steps whose compare distance spans more than a block.
+    pCommandList->SetPipelineState(m_treeStates[TreePassSortLocal].Get());
+    pCommandList->Dispatch(sortBlocks, 1, 1);
+    pCommandList->ResourceBarrier(1, &uavBarrier);
+
+    for (UINT k = 2 * SortBlockSize; k <= m_sortCount; k *= 2)
+    {
+        pCommandList->SetPipelineState(m_treeStates[TreePassSortStep].Get());
+        for (UINT j = k / 2; j >= SortBlockSize; j /= 2)
+        {
+            const UINT sortConstants[] = { k, j };
+            pCommandList->SetComputeRoot32BitConstants(ComputeRootSortConstants, _countof(sortConstants), sortConstants, 0);
+            pCommandList->Dispatch(m_sortCount / 2 / 128, 1, 1);
+            pCommandList->ResourceBarrier(1, &uavBarrier);
+        }
+
+        const UINT sortConstants[] = { k, SortBlockSize / 2 };
+        pCommandList->SetComputeRoot32BitConstants(ComputeRootSortConstants, _countof(sortConstants), sortConstants, 0);
+        pCommandList->SetPipelineState(m_treeStates[TreePassSortMerge].Get());
+        pCommandList->Dispatch(sortBlocks, 1, 1);
+        pCommandList->ResourceBarrier(1, &uavBarrier);
+    }
+
+    pCommandList->SetPipelineState(m_treeStates[TreePassBuildTree].Get());
+    pCommandList->Dispatch((m_particleCount - 1 + 127) / 128, 1, 1);
+    pCommandList->ResourceBarrier(1, &uavBarrier);
+
+    pCommandList->SetPipelineState(m_treeStates[TreePassSummarizeTree].Get());
+    pCommandList->Dispatch(particleGroups, 1, 1);
+    pCommandList->ResourceBarrier(1, &uavBarrier);
+
+    PIXEndEvent(pCommandList);
+
+    const UINT sliceCount = m_sliceOffsets[threadIndex + 1] - m_sliceOffsets[threadIndex];
+    ID3D12QueryHeap* pQueryHeap = m_timestampQueryHeaps[threadIndex].Get();
+
+    pCommandList->SetPipelineState(m_treeStates[TreePassForces].Get());
+    pCommandList->EndQuery(pQueryHeap, D3D12_QUERY_TYPE_TIMESTAMP, 0);
+    pCommandList->Dispatch((sliceCount + 127) / 128, 1, 1);
+    pCommandList->EndQuery(pQueryHeap, D3D12_QUERY_TYPE_TIMESTAMP, 1);
 }
 
 void D3D12nBodyGravity::OnDestroy()
@@ -817,6 +1216,7 @@ void D3D12nBodyGravity::OnDestroy()
     WaitForRenderContext();
 
     // Close handles to fence events and threads.
+    DeleteSynchronizationBarrier(&m_computeBarrier);
     CloseHandle(m_renderContextFenceEvent);
     for (int n = 0; n < ThreadCount; n++)
     {
@@ -828,6 +1228,18 @@ void D3D12nBodyGravity::OnDestroy()
 void D3D12nBodyGravity::OnKeyDown(UINT8 key)
 {
     m_camera.OnKeyDown(key);
+
+    if (key == 'B')
+    {
+        // The compute thread picks this up at its next simulation step.
+        m_useBarnesHut = !m_useBarnesHut;
+        UpdateTitle();
+    }
+    else if (key == 'V')
+    {
+        m_useVertexPulling = !m_useVertexPulling;
+        UpdateTitle();
+    }
 }
 
 void D3D12nBodyGravity::OnKeyUp(UINT8 key)
@@ -869,4 +1281,20 @@ void D3D12nBodyGravity::MoveToNextFrame()
         ThrowIfFailed(m_renderContextFence->SetEventOnCompletion(m_frameFenceValues[m_frameIndex], m_renderContextFenceEvent));
         WaitForSingleObject(m_renderContextFenceEvent, INFINITE);
     }
+
+    // The frame that last used this frame index has completed, so its draw
+    // timestamps can be read back. The title is refreshed about once a second.
+    const CD3DX12_RANGE timestampRange(2 * m_frameIndex * sizeof(UINT64), (2 * m_frameIndex + 2) * sizeof(UINT64));
+    UINT64* pTimestamps;
+    ThrowIfFailed(m_drawTimestampReadbackBuffer->Map(0, &timestampRange, reinterpret_cast<void**>(&pTimestamps)));
+    const UINT64 drawTicks = pTimestamps[2 * m_frameIndex + 1] - pTimestamps[2 * m_frameIndex];
+    m_drawTimestampReadbackBuffer->Unmap(0, &CD3DX12_RANGE(0, 0));
+
+    const float drawTime = static_cast<float>(static_cast<double>(drawTicks) * 1000.0 / m_drawTimestampFrequency);
+    m_drawTime = 0.9f * m_drawTime + 0.1f * drawTime;
+
+    if (m_timer.GetFrameCount() % 60 == 0)
+    {
+        UpdateTitle();
+    }
 }
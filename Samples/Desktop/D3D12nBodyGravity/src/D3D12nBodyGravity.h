@@ -35,12 +35,17 @@ public:
     virtual void OnDestroy();
     virtual void OnKeyDown(UINT8 key);
     virtual void OnKeyUp(UINT8 key);
+    virtual void ParseCommandLineArgs(_In_reads_(argc) WCHAR* argv[], int argc);
 
 private:
     static const UINT FrameCount = 2;
-    static const UINT ThreadCount = 1;
+    static const UINT ThreadCount = 4;              // Compute queues, each simulating a slice of the particles.
     static const float ParticleSpread;
-    static const UINT ParticleCount = 10000;        // The number of particles in the n-body simulation.
+    static const UINT DefaultParticleCount = 10000; // The number of particles in the n-body simulation, unless "-particles <count>" is given.
+    static const UINT MaxParticleCount = 1 << 22;   // Keeps every dispatch under the 65535 thread group limit.
+    static const UINT SortBlockSize = 2048;         // Keys sorted in group shared memory at a time. Keep this in sync with "nBodyGravityCS.hlsl".
+    static const float BarnesHutTheta;              // Nodes smaller than theta times their distance are treated as a single body.
+    static const UINT QuadsPerInstance = 16384;     // Quads per instance of the vertex pulling draw. Four vertices each keeps the indices 16-bit.
 
     // "Vertex" definition for particles. Triangle vertices are generated 
     // by the geometry shader. Color data will be assigned to those 
@@ -52,7 +57,8 @@ private:
 
     // Position and velocity data for the particles in the system.
     // Two buffers full of Particle data are utilized in this sample.
-    // The compute thread alternates writing to each of them.
+    // The compute threads alternate writing to each of them, every thread 
+    // writing its own slice of the particles.
     // The render thread renders using the buffer that is not currently
     // in use by the compute shader.
     struct Particle
@@ -95,22 +101,28 @@ private:
 
     // Asset objects.
     ComPtr<ID3D12PipelineState> m_pipelineState;
+    ComPtr<ID3D12PipelineState> m_quadPipelineState;
     ComPtr<ID3D12PipelineState> m_computeState;
     ComPtr<ID3D12GraphicsCommandList> m_commandList;
     ComPtr<ID3D12Resource> m_vertexBuffer;
     ComPtr<ID3D12Resource> m_vertexBufferUpload;
     D3D12_VERTEX_BUFFER_VIEW m_vertexBufferView;
-    ComPtr<ID3D12Resource> m_particleBuffer0[ThreadCount];
-    ComPtr<ID3D12Resource> m_particleBuffer1[ThreadCount];
-    ComPtr<ID3D12Resource> m_particleBuffer0Upload[ThreadCount];
-    ComPtr<ID3D12Resource> m_particleBuffer1Upload[ThreadCount];
+    ComPtr<ID3D12Resource> m_quadIndexBuffer;
+    ComPtr<ID3D12Resource> m_quadIndexBufferUpload;
+    D3D12_INDEX_BUFFER_VIEW m_quadIndexBufferView;
+    ComPtr<ID3D12Resource> m_particleBuffer0;
+    ComPtr<ID3D12Resource> m_particleBuffer1;
+    ComPtr<ID3D12Resource> m_particleBuffer0Upload;
+    ComPtr<ID3D12Resource> m_particleBuffer1Upload;
     ComPtr<ID3D12Resource> m_constantBufferGS;
     UINT8* m_pConstantBufferGSData;
     ComPtr<ID3D12Resource> m_constantBufferCS;
 
-    UINT m_srvIndex[ThreadCount];        // Denotes which of the particle buffer resource views is the SRV (0 or 1). The UAV is 1 - srvIndex.
-    UINT m_heightInstances;
-    UINT m_widthInstances;
+    UINT volatile m_srvIndex;            // Denotes which of the particle buffer resource views is the SRV (0 or 1). The UAV is 1 - srvIndex.
+    UINT m_particleCount;
+    UINT m_sortCount;                    // Particle count rounded up to a power of two for the bitonic sort.
+    bool volatile m_useBarnesHut;        // Toggled with the B key. The brute force simulation is kept for comparison.
+    bool m_useVertexPulling;             // Toggled with the V key. Draws the sprites without the geometry shader.
     SimpleCamera m_camera;
     StepTimer m_timer;
 
@@ -119,6 +131,25 @@ private:
     ComPtr<ID3D12CommandQueue> m_computeCommandQueue[ThreadCount];
     ComPtr<ID3D12GraphicsCommandList> m_computeCommandList[ThreadCount];
 
+    // Load balancing. Every step each thread times its slice on the GPU, and 
+    // the slices are resized so that the queues finish at the same time.
+    ComPtr<ID3D12QueryHeap> m_timestampQueryHeaps[ThreadCount];
+    ComPtr<ID3D12Resource> m_timestampReadbackBuffers[ThreadCount];
+    UINT64 m_timestampFrequencies[ThreadCount];
+    ComPtr<ID3D12QueryHeap> m_drawTimestampQueryHeap;    // Two timestamps around each frame's particle draw.
+    ComPtr<ID3D12Resource> m_drawTimestampReadbackBuffer;
+    UINT64 m_drawTimestampFrequency;
+    float m_drawTime;                       // Smoothed milliseconds of the particle draw.
+    UINT m_sliceOffsets[ThreadCount + 1];   // Thread n simulates particles [m_sliceOffsets[n], m_sliceOffsets[n + 1]).
+    float m_sliceTimes[ThreadCount];        // Milliseconds the last step of each slice took.
+    float m_sliceRates[ThreadCount];        // Smoothed particles per millisecond of each queue.
+
+    // Barnes-Hut objects. The tree is rebuilt from scratch every simulation step.
+    ComPtr<ID3D12Resource> m_sceneBoundsBuffer[ThreadCount];
+    ComPtr<ID3D12Resource> m_sortKeyBuffer[ThreadCount];
+    ComPtr<ID3D12Resource> m_treeNodeBuffer[ThreadCount];
+    ComPtr<ID3D12Resource> m_treeLinkBuffer[ThreadCount];
+
     // Synchronization objects.
     HANDLE m_swapChainEvent;
     ComPtr<ID3D12Fence> m_renderContextFence;
@@ -129,7 +160,10 @@ private:
     ComPtr<ID3D12Fence> m_threadFences[ThreadCount];
     volatile HANDLE m_threadFenceEvents[ThreadCount];
 
-    // Thread state.
+    // Thread state. The compute threads step the simulation in lockstep, 
+    // meeting at m_computeBarrier between steps.
+    SYNCHRONIZATION_BARRIER m_computeBarrier;
+    bool m_stopCompute;
     LONG volatile m_terminating;
     UINT64 volatile m_renderContextFenceValues[ThreadCount];
     UINT64 volatile m_threadFenceValues[ThreadCount];
@@ -147,6 +181,7 @@ private:
     {
         GraphicsRootCBV = 0,
         GraphicsRootSRVTable,
+        GraphicsRootDrawConstants,
         GraphicsRootParametersCount
     };
 
@@ -155,26 +190,51 @@ private:
         ComputeRootCBV = 0,
         ComputeRootSRVTable,
         ComputeRootUAVTable,
+        ComputeRootSortConstants,
+        ComputeRootSliceConstants,
+        ComputeRootSceneBoundsUAV,
+        ComputeRootSortKeysUAV,
+        ComputeRootTreeNodesUAV,
+        ComputeRootTreeLinksUAV,
         ComputeRootParametersCount
     };
 
+    // Compute passes of the Barnes-Hut simulation, in the order they run.
+    enum TreePass : UINT32
+    {
+        TreePassClearBounds = 0,
+        TreePassComputeBounds,
+        TreePassMortonCodes,
+        TreePassSortLocal,
+        TreePassSortStep,
+        TreePassSortMerge,
+        TreePassBuildTree,
+        TreePassSummarizeTree,
+        TreePassForces,
+        TreePassCount
+    };
+    ComPtr<ID3D12PipelineState> m_treeStates[TreePassCount];
+
     // Indices of shader resources in the descriptor heap.
     enum DescriptorHeapIndex : UINT32
     {
         UavParticlePosVelo0 = 0,
-        UavParticlePosVelo1 = UavParticlePosVelo0 + ThreadCount,
-        SrvParticlePosVelo0 = UavParticlePosVelo1 + ThreadCount,
-        SrvParticlePosVelo1 = SrvParticlePosVelo0 + ThreadCount,
-        DescriptorCount = SrvParticlePosVelo1 + ThreadCount
+        UavParticlePosVelo1,
+        SrvParticlePosVelo0,
+        SrvParticlePosVelo1,
+        DescriptorCount
     };
 
     void LoadPipeline();
     void LoadAssets();
     void CreateAsyncContexts();
     void CreateVertexBuffer();
+    void CreateQuadIndexBuffer();
     float RandomPercent();
     void LoadParticles(_Out_writes_(numParticles) Particle* pParticles, const XMFLOAT3 &center, const XMFLOAT4 &velocity, float spread, UINT numParticles);
     void CreateParticleBuffers();
+    void CreateTreeBuffers();
+    void UpdateTitle();
     void PopulateCommandList();
 
     static DWORD WINAPI ThreadProc(ThreadData* pData)
@@ -183,6 +243,8 @@ private:
     }
     DWORD AsyncComputeThreadProc(int threadIndex);
     void Simulate(UINT threadIndex);
+    void SimulateBarnesHut(UINT threadIndex);
+    void RebalanceSlices();
 
     void WaitForRenderContext();
     void MoveToNextFrame();
@@ -53,6 +53,17 @@ cbuffer cb1
     static float g_fParticleRad = 10.0f;
 };
 
+// Keep this in sync with "D3D12nBodyGravity.h".
+static const uint g_quadsPerInstance = 16384;
+
+// The color the vertex buffer gives every particle.
+static const float4 g_particleColor = float4(1.0f, 1.0f, 0.2f, 1.0f);
+
+cbuffer cbDraw : register(b1)
+{
+    uint g_firstParticle;    // First particle of the vertex pulling draw.
+};
+
 cbuffer cbImmutable
 {
     static float3 g_positions[4] =
@@ -110,6 +121,31 @@ void GSParticleDraw(point VSParticleDrawOut input[1], inout TriangleStream<GSPar
     SpriteStream.RestartStrip();
 }
 
+//
+// VS for drawing the particles without a geometry shader. Every particle is
+// a quad of four vertices, and each instance covers g_quadsPerInstance of
+// them. The vertex is placed the same way GSParticleDraw places it.
+//
+GSParticleDrawOut VSParticleDrawQuad(uint vertexId : SV_VERTEXID, uint instanceId : SV_INSTANCEID)
+{
+    GSParticleDrawOut output;
+
+    uint particle = g_firstParticle + instanceId * g_quadsPerInstance + vertexId / 4;
+    uint corner = vertexId % 4;
+
+    PosVelo posVelo = g_bufPosVelo[particle];
+
+    float3 position = g_positions[corner] * g_fParticleRad;
+    position = mul(position, (float3x3)g_mInvView) + posVelo.pos.xyz;
+    output.pos = mul(float4(position, 1.0), g_mWorldViewProj);
+
+    float mag = posVelo.velo.w / 9;
+    output.color = lerp(float4(1.0f, 0.1f, 0.1f, 1.0f), g_particleColor, mag);
+    output.tex = g_texcoords[corner];
+
+    return output;
+}
+
 //
 // PS for drawing particles. Use the texture coordinates to generate a 
 // radial gradient representing the particle.
@@ -20,7 +20,7 @@ groupshared float4 sharedPos[blocksize];
 // Body to body interaction, acceleration of the particle at position 
 // bi is updated.
 //
-void bodyBodyInteraction(inout float3 ai, float4 bj, float4 bi, float mass, int particles) 
+void bodyBodyInteraction(inout float3 ai, float4 bj, float4 bi, float mass, float particles) 
 {
     float3 r = bj.xyz - bi.xyz;
 
@@ -39,8 +39,17 @@ cbuffer cbCS : register(b0)
 {
     uint4   g_param;    // param[0] = MAX_PARTICLES;
                         // param[1] = dimx;
+                        // param[2] = sort count (power of two);
     float4  g_paramf;    // paramf[0] = 0.1f;
                         // paramf[1] = 1; 
+                        // paramf[2] = theta squared;
+};
+
+// Each async compute queue updates one slice of the particles.
+cbuffer cbSlice : register(b2)
+{
+    uint g_sliceOffset;
+    uint g_sliceCount;
 };
 
 struct PosVelo
@@ -55,9 +64,10 @@ RWStructuredBuffer<PosVelo> newPosVelo    : register(u0);    // UAV
 [numthreads(blocksize, 1, 1)]
 void CSMain(uint3 Gid : SV_GroupID, uint3 DTid : SV_DispatchThreadID, uint3 GTid : SV_GroupThreadID, uint GI : SV_GroupIndex)
 {
-    // Each thread of the CS updates one of the particles.
-    float4 pos = oldPosVelo[DTid.x].pos;
-    float4 vel = oldPosVelo[DTid.x].velo;
+    // Each thread of the CS updates one of the particles in this slice.
+    uint index = g_sliceOffset + DTid.x;
+    float4 pos = oldPosVelo[index].pos;
+    float4 vel = oldPosVelo[index].velo;
     float3 accel = 0;
     float mass = g_fParticleMass;
 
@@ -100,9 +110,396 @@ void CSMain(uint3 Gid : SV_GroupID, uint3 DTid : SV_DispatchThreadID, uint3 GTid
     vel.xyz *= g_paramf.y;                    //damping;
     pos.xyz += vel.xyz * g_paramf.x;        //deltaTime;
 
+    if (DTid.x < g_sliceCount)
+    {
+        newPosVelo[index].pos = pos;
+        newPosVelo[index].velo = float4(vel.xyz, length(accel));
+    }
+}
+
+//
+// Barnes-Hut mode. Every frame the bodies are Morton sorted, a binary radix 
+// tree is built over the sorted codes (Karras 2012, the same construction the 
+// raytracing fallback layer uses for its BVHs), each node is summarized by 
+// its center of mass and bounds, and each body then walks the tree, treating 
+// any node that is small enough relative to its distance as a single body.
+//
+
+#define sortBlockSize 2048
+#define maxTreeDepth 64
+
+cbuffer cbSort : register(b1)
+{
+    uint g_sortK;       // Size of the bitonic sequences being merged.
+    uint g_sortJ;       // Distance between the elements being compared.
+};
+
+struct TreeNode
+{
+    float4 center;      // xyz = center of mass, w = number of bodies.
+    float3 boundsMin;
+    uint left;
+    float3 boundsMax;
+    uint right;
+};
+
+RWStructuredBuffer<uint> sceneBounds                : register(u1);    // Order preserving min xyz and max xyz.
+RWStructuredBuffer<uint2> sortKeys                  : register(u2);    // Morton code and body index.
+globallycoherent RWStructuredBuffer<TreeNode> treeNodes : register(u3);    // Internal nodes, then one leaf per body.
+globallycoherent RWStructuredBuffer<uint2> treeLinks    : register(u4);    // Parent and visit count.
+
+groupshared uint2 sharedKeys[sortBlockSize];
+groupshared float3 sharedMin[blocksize];
+groupshared float3 sharedMax[blocksize];
+
+// Floats reinterpreted this way sort the same as unsigned integers, so the 
+// bounds can be reduced with atomics.
+uint FloatToOrderedUint(float f)
+{
+    uint u = asuint(f);
+    return (u & 0x80000000) ? ~u : (u | 0x80000000);
+}
+
+float OrderedUintToFloat(uint u)
+{
+    return asfloat((u & 0x80000000) ? (u & 0x7fffffff) : ~u);
+}
+
+// Spread the low 10 bits of v out to every third bit.
+uint ExpandBits(uint v)
+{
+    v = (v * 0x00010001u) & 0xFF0000FFu;
+    v = (v * 0x00000101u) & 0x0F00F00Fu;
+    v = (v * 0x00000011u) & 0xC30C30C3u;
+    v = (v * 0x00000005u) & 0x49249249u;
+    return v;
+}
+
+uint MortonCode(float3 unitCoord)
+{
+    uint3 coord = (uint3)clamp(unitCoord * 1024.0f, 0.0f, 1023.0f);
+    return (ExpandBits(coord.x) << 2) | (ExpandBits(coord.y) << 1) | ExpandBits(coord.z);
+}
+
+[numthreads(1, 1, 1)]
+void CSClearBounds()
+{
+    [unroll]
+    for (uint i = 0; i < 3; i++)
+    {
+        sceneBounds[i] = 0xffffffff;
+        sceneBounds[i + 3] = 0;
+    }
+}
+
+[numthreads(blocksize, 1, 1)]
+void CSComputeBounds(uint3 DTid : SV_DispatchThreadID, uint GI : SV_GroupIndex)
+{
+    float3 pos = oldPosVelo[min(DTid.x, g_param.x - 1)].pos.xyz;
+    sharedMin[GI] = pos;
+    sharedMax[GI] = pos;
+
+    GroupMemoryBarrierWithGroupSync();
+
+    [unroll]
+    for (uint stride = blocksize / 2; stride > 0; stride >>= 1)
+    {
+        if (GI < stride)
+        {
+            sharedMin[GI] = min(sharedMin[GI], sharedMin[GI + stride]);
+            sharedMax[GI] = max(sharedMax[GI], sharedMax[GI + stride]);
+        }
+        GroupMemoryBarrierWithGroupSync();
+    }
+
+    if (GI < 3)
+    {
+        InterlockedMin(sceneBounds[GI], FloatToOrderedUint(sharedMin[0][GI]));
+        InterlockedMax(sceneBounds[GI + 3], FloatToOrderedUint(sharedMax[0][GI]));
+    }
+}
+
+[numthreads(blocksize, 1, 1)]
+void CSMortonCodes(uint3 DTid : SV_DispatchThreadID)
+{
+    if (DTid.x >= g_param.z)
+    {
+        return;
+    }
+
+    // Padding sorts after every real body.
+    uint2 key = uint2(0xffffffff, DTid.x);
     if (DTid.x < g_param.x)
     {
-        newPosVelo[DTid.x].pos = pos;
-        newPosVelo[DTid.x].velo = float4(vel.xyz, length(accel));
+        float3 boundsMin = float3(OrderedUintToFloat(sceneBounds[0]), OrderedUintToFloat(sceneBounds[1]), OrderedUintToFloat(sceneBounds[2]));
+        float3 boundsMax = float3(OrderedUintToFloat(sceneBounds[3]), OrderedUintToFloat(sceneBounds[4]), OrderedUintToFloat(sceneBounds[5]));
+        float3 extent = max(boundsMax - boundsMin, 1e-6f);
+
+        key.x = MortonCode((oldPosVelo[DTid.x].pos.xyz - boundsMin) / extent);
+    }
+
+    sortKeys[DTid.x] = key;
+}
+
+bool KeyGreater(uint2 a, uint2 b)
+{
+    return a.x > b.x || (a.x == b.x && a.y > b.y);
+}
+
+// Compare and swap the pair that thread t of a bitonic step with distance j 
+// is responsible for. Index is relative to base, which is a multiple of 2j.
+void BitonicCompareShared(uint t, uint j, uint k, uint base)
+{
+    uint low = ((t & ~(j - 1)) << 1) | (t & (j - 1));
+    uint high = low | j;
+    bool ascending = ((base + low) & k) == 0;
+
+    uint2 a = sharedKeys[low];
+    uint2 b = sharedKeys[high];
+    if (KeyGreater(a, b) == ascending)
+    {
+        sharedKeys[low] = b;
+        sharedKeys[high] = a;
+    }
+}
+
+// Fully sorts each block of sortBlockSize keys in group shared memory, in 
+// alternating directions so that neighboring blocks form bitonic sequences.
+[numthreads(sortBlockSize / 2, 1, 1)]
+void CSBitonicSortLocal(uint3 Gid : SV_GroupID, uint GI : SV_GroupIndex)
+{
+    uint base = Gid.x * sortBlockSize;
+    sharedKeys[GI] = sortKeys[base + GI];
+    sharedKeys[GI + sortBlockSize / 2] = sortKeys[base + GI + sortBlockSize / 2];
+
+    GroupMemoryBarrierWithGroupSync();
+
+    for (uint k = 2; k <= sortBlockSize; k <<= 1)
+    {
+        for (uint j = k >> 1; j > 0; j >>= 1)
+        {
+            BitonicCompareShared(GI, j, k, base);
+            GroupMemoryBarrierWithGroupSync();
+        }
+    }
+
+    sortKeys[base + GI] = sharedKeys[GI];
+    sortKeys[base + GI + sortBlockSize / 2] = sharedKeys[GI + sortBlockSize / 2];
+}
+
+// One step of a merge whose compare distance spans more than a block.
+[numthreads(blocksize, 1, 1)]
+void CSBitonicSortStep(uint3 DTid : SV_DispatchThreadID)
+{
+    uint t = DTid.x;
+    if (t >= g_param.z / 2)
+    {
+        return;
+    }
+
+    uint low = ((t & ~(g_sortJ - 1)) << 1) | (t & (g_sortJ - 1));
+    uint high = low | g_sortJ;
+    bool ascending = (low & g_sortK) == 0;
+
+    uint2 a = sortKeys[low];
+    uint2 b = sortKeys[high];
+    if (KeyGreater(a, b) == ascending)
+    {
+        sortKeys[low] = b;
+        sortKeys[high] = a;
+    }
+}
+
+// The remaining steps of a merge, once the compare distance fits in a block.
+[numthreads(sortBlockSize / 2, 1, 1)]
+void CSBitonicSortMerge(uint3 Gid : SV_GroupID, uint GI : SV_GroupIndex)
+{
+    uint base = Gid.x * sortBlockSize;
+    sharedKeys[GI] = sortKeys[base + GI];
+    sharedKeys[GI + sortBlockSize / 2] = sortKeys[base + GI + sortBlockSize / 2];
+
+    GroupMemoryBarrierWithGroupSync();
+
+    for (uint j = sortBlockSize / 2; j > 0; j >>= 1)
+    {
+        BitonicCompareShared(GI, j, g_sortK, base);
+        GroupMemoryBarrierWithGroupSync();
+    }
+
+    sortKeys[base + GI] = sharedKeys[GI];
+    sortKeys[base + GI + sortBlockSize / 2] = sharedKeys[GI + sortBlockSize / 2];
+}
+
+// Length of the common prefix of two sorted keys, with the index breaking 
+// ties between equal Morton codes. -1 when j is out of range.
+int CommonPrefix(int i, int j)
+{
+    if (j < 0 || j >= (int)g_param.x)
+    {
+        return -1;
+    }
+
+    uint2 a = sortKeys[i];
+    uint2 b = sortKeys[j];
+    if (a.x != b.x)
+    {
+        return 31 - firstbithigh(a.x ^ b.x);
+    }
+    return 32 + 31 - firstbithigh((uint)i ^ (uint)j);
+}
+
+// Thread i builds internal node i. Leaves follow the n - 1 internal nodes.
+[numthreads(blocksize, 1, 1)]
+void CSBuildTree(uint3 DTid : SV_DispatchThreadID)
+{
+    int i = (int)DTid.x;
+    int internalCount = (int)g_param.x - 1;
+    if (i >= internalCount)
+    {
+        return;
+    }
+
+    // Find the direction and the other end of the range of keys this node covers.
+    int d = (CommonPrefix(i, i + 1) - CommonPrefix(i, i - 1)) >= 0 ? 1 : -1;
+    int minPrefix = CommonPrefix(i, i - d);
+
+    int maxLength = 2;
+    while (CommonPrefix(i, i + maxLength * d) > minPrefix)
+    {
+        maxLength *= 2;
+    }
+
+    int length = 0;
+    for (int t = maxLength / 2; t > 0; t /= 2)
+    {
+        if (CommonPrefix(i, i + (length + t) * d) > minPrefix)
+        {
+            length += t;
+        }
+    }
+
+    int j = i + length * d;
+    int first = min(i, j);
+    int last = max(i, j);
+
+    // Split where the common prefix of the range changes.
+    int nodePrefix = CommonPrefix(first, last);
+    int split = first;
+    int step = last - first;
+    do
+    {
+        step = (step + 1) >> 1;
+        if (split + step < last && CommonPrefix(first, split + step) > nodePrefix)
+        {
+            split += step;
+        }
+    } while (step > 1);
+
+    uint left = (split == first) ? internalCount + split : split;
+    uint right = (split + 1 == last) ? internalCount + split + 1 : split + 1;
+
+    treeNodes[i].left = left;
+    treeNodes[i].right = right;
+    treeLinks[left].x = i;
+    treeLinks[right].x = i;
+    treeLinks[i].y = 0;
+
+    if (i == 0)
+    {
+        treeLinks[0].x = 0xffffffff;
     }
 }
+
+// Thread i fills in leaf i and walks towards the root. The second child to 
+// arrive at a node summarizes it, so every node is written exactly once.
+[numthreads(blocksize, 1, 1)]
+void CSSummarizeTree(uint3 DTid : SV_DispatchThreadID)
+{
+    if (DTid.x >= g_param.x)
+    {
+        return;
+    }
+
+    uint internalCount = g_param.x - 1;
+    uint node = internalCount + DTid.x;
+
+    float3 pos = oldPosVelo[sortKeys[DTid.x].y].pos.xyz;
+    treeNodes[node].center = float4(pos, 1.0f);
+    treeNodes[node].boundsMin = pos;
+    treeNodes[node].boundsMax = pos;
+
+    node = treeLinks[node].x;
+    while (node != 0xffffffff)
+    {
+        DeviceMemoryBarrier();
+
+        uint visits;
+        InterlockedAdd(treeLinks[node].y, 1, visits);
+        if (visits == 0)
+        {
+            return;
+        }
+
+        TreeNode a = treeNodes[treeNodes[node].left];
+        TreeNode b = treeNodes[treeNodes[node].right];
+
+        float count = a.center.w + b.center.w;
+        treeNodes[node].center = float4((a.center.xyz * a.center.w + b.center.xyz * b.center.w) / count, count);
+        treeNodes[node].boundsMin = min(a.boundsMin, b.boundsMin);
+        treeNodes[node].boundsMax = max(a.boundsMax, b.boundsMax);
+
+        node = treeLinks[node].x;
+    }
+}
+
+// Each thread updates the body at one position in Morton order, so 
+// neighboring threads take similar paths through the tree.
+[numthreads(blocksize, 1, 1)]
+void CSTreeForces(uint3 DTid : SV_DispatchThreadID)
+{
+    if (DTid.x >= g_sliceCount)
+    {
+        return;
+    }
+
+    uint index = sortKeys[g_sliceOffset + DTid.x].y;
+    float4 pos = oldPosVelo[index].pos;
+    float4 vel = oldPosVelo[index].velo;
+    float3 accel = 0;
+    float mass = g_fParticleMass;
+    uint internalCount = g_param.x - 1;
+
+    uint stack[maxTreeDepth];
+    uint stackSize = 1;
+    stack[0] = 0;
+
+    [loop]
+    while (stackSize > 0)
+    {
+        uint node = stack[--stackSize];
+        TreeNode tree = treeNodes[node];
+
+        float3 r = tree.center.xyz - pos.xyz;
+        float3 extent = tree.boundsMax - tree.boundsMin;
+        float size = max(extent.x, max(extent.y, extent.z));
+
+        // Open nodes that are too close to approximate, as long as there is 
+        // room on the stack for their children.
+        if (node < internalCount && size * size > g_paramf.z * dot(r, r) && stackSize + 2 <= maxTreeDepth)
+        {
+            stack[stackSize++] = tree.left;
+            stack[stackSize++] = tree.right;
+        }
+        else
+        {
+            bodyBodyInteraction(accel, float4(tree.center.xyz, 0), pos, mass, tree.center.w);
+        }
+    }
+
+    vel.xyz += accel.xyz * g_paramf.x;        //deltaTime;
+    vel.xyz *= g_paramf.y;                    //damping;
+    pos.xyz += vel.xyz * g_paramf.x;        //deltaTime;
+
+    newPosVelo[index].pos = pos;
+    newPosVelo[index].velo = float4(vel.xyz, length(accel));
+}
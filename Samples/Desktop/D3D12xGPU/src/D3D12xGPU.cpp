@@ -107,23 +107,60 @@ void D3D12xGPU::LoadPipeline()
 #endif
 
     EnumerateGPUadapters();
+    ReleaseUnavailableAdapterDevices();
 
-    ComPtr<IDXGIAdapter1> hardwareAdapter;
-    GetGPUAdapter(m_activeAdapter, &hardwareAdapter);
-    ThrowIfFailed(D3D12CreateDevice(
-        hardwareAdapter.Get(),
-        D3D_FEATURE_LEVEL_11_0,
-        IID_PPV_ARGS(&m_device)
-    ));
+    LoadDevice();
+
+    // Create an event handle to use for frame synchronization.
+    m_fenceEvent = CreateEvent(nullptr, FALSE, FALSE, nullptr);
+    if (m_fenceEvent == nullptr)
+    {
+        ThrowIfFailed(HRESULT_FROM_WIN32(GetLastError()));
+    }
+}
+
+// Create the device, command queue, swap chain and fence for the active adapter.
+// Device objects left alive on the adapter by an earlier switch are reused.
+void D3D12xGPU::LoadDevice()
+{
     m_activeAdapterLuid = m_gpuAdapterDescs[m_activeAdapter].desc.AdapterLuid;
 
-    // Describe and create the command queue.
-    D3D12_COMMAND_QUEUE_DESC queueDesc = {};
-    queueDesc.Flags = D3D12_COMMAND_QUEUE_FLAG_NONE;
-    queueDesc.Type = D3D12_COMMAND_LIST_TYPE_DIRECT;
+    auto inactiveDevice = m_inactiveAdapterDevices.find(LuidToKey(m_activeAdapterLuid));
+    if (inactiveDevice != m_inactiveAdapterDevices.end())
+    {
+        if (inactiveDevice->second.device->GetDeviceRemovedReason() == S_OK)
+        {
+            m_device = inactiveDevice->second.device;
+            m_commandQueue = inactiveDevice->second.commandQueue;
+            m_fence = inactiveDevice->second.fence;
+        }
+        m_inactiveAdapterDevices.erase(inactiveDevice);
+    }
+
+    if (!m_device)
+    {
+        // Anything cached for the adapter belongs to a device that is no longer usable.
+        if (m_scene)
+        {
+            m_scene->EvictD3DObjects(m_activeAdapterLuid);
+        }
+
+        ComPtr<IDXGIAdapter1> hardwareAdapter;
+        GetGPUAdapter(m_activeAdapter, &hardwareAdapter);
+        ThrowIfFailed(D3D12CreateDevice(
+            hardwareAdapter.Get(),
+            D3D_FEATURE_LEVEL_11_0,
+            IID_PPV_ARGS(&m_device)
+        ));
 
-    ThrowIfFailed(m_device->CreateCommandQueue(&queueDesc, IID_PPV_ARGS(&m_commandQueue)));
-    NAME_D3D12_OBJECT(m_commandQueue);
+        // Describe and create the command queue.
+        D3D12_COMMAND_QUEUE_DESC queueDesc = {};
+        queueDesc.Flags = D3D12_COMMAND_QUEUE_FLAG_NONE;
+        queueDesc.Type = D3D12_COMMAND_LIST_TYPE_DIRECT;
+
+        ThrowIfFailed(m_device->CreateCommandQueue(&queueDesc, IID_PPV_ARGS(&m_commandQueue)));
+        NAME_D3D12_OBJECT(m_commandQueue);
+    }
 
     // Describe and create the swap chain.
     DXGI_SWAP_CHAIN_DESC1 swapChainDesc = {};
@@ -169,15 +206,19 @@ void D3D12xGPU::LoadPipeline()
 
     // Create synchronization objects.
     {
-        ThrowIfFailed(m_device->CreateFence(m_fenceValues[m_frameIndex], D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&m_fence)));
-        m_fenceValues[m_frameIndex]++;
+        if (!m_fence)
+        {
+            ThrowIfFailed(m_device->CreateFence(m_fenceValues[m_frameIndex], D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&m_fence)));
+        }
 
-        // Create an event handle to use for frame synchronization.
-        m_fenceEvent = CreateEvent(nullptr, FALSE, FALSE, nullptr);
-        if (m_fenceEvent == nullptr)
+        // Continue from the value the fence is at, which for a reused fence is
+        // unrelated to the fence values used on the previous adapter.
+        const UINT64 completedFenceValue = m_fence->GetCompletedValue();
+        for (UINT i = 0; i < FrameCount; i++)
         {
-            ThrowIfFailed(HRESULT_FROM_WIN32(GetLastError()));
+            m_fenceValues[i] = completedFenceValue;
         }
+        m_fenceValues[m_frameIndex]++;
     }
 }
 
@@ -188,10 +229,15 @@ void D3D12xGPU::LoadAssets()
     {
         m_scene = make_unique<ShadowsFogScatteringSquidScene>(FrameCount, this);
     }
-    m_scene->Initialize(m_device.Get(), m_commandQueue.Get(), m_frameIndex );
 
-    // Wait until assets have been uploaded to the GPU.
-    WaitForGpu();
+    // Scene objects left alive on the adapter by an earlier switch are already uploaded.
+    if (!m_scene->RestoreD3DObjects(m_activeAdapterLuid, m_frameIndex))
+    {
+        m_scene->Initialize(m_device.Get(), m_commandQueue.Get(), m_frameIndex );
+
+        // Wait until assets have been uploaded to the GPU.
+        WaitForGpu();
+    }
 }
 
 // Load resources that are dependent on the size of the main window.
@@ -465,7 +511,11 @@ void D3D12xGPU::OnRender()
 #endif
 
                 // Check if the application should switch to a different adapter.
-                ThrowIfFailed(ValidateActiveAdapter());
+                if (FAILED(ValidateActiveAdapter()))
+                {
+                    SwitchAdapter();
+                    return;
+                }
             }
 
             // UILayer will transition backbuffer to a present state.
@@ -515,6 +565,65 @@ void D3D12xGPU::RecreateD3Dresources()
     OnInit();
 }
 
+// Moves rendering to the active adapter. Unlike RecreateD3Dresources(), the device objects
+// of the adapter being switched away from are kept alive, so that switching back to it
+// doesn't stall on recreating the device, recompiling PSOs and reuploading assets.
+void D3D12xGPU::SwitchAdapter()
+{
+    UINT previousAdapter;
+    bool keepPreviousDevice = RetrieveAdapterIndex(&previousAdapter, m_activeAdapterLuid) && m_device->GetDeviceRemovedReason() == S_OK;
+    if (keepPreviousDevice)
+    {
+        try
+        {
+            WaitForGpu();
+        }
+        catch (HrException&)
+        {
+            keepPreviousDevice = false;
+        }
+    }
+
+    if (!keepPreviousDevice)
+    {
+        // There is nothing worth keeping on an adapter that is gone or unresponsive.
+        RecreateD3Dresources();
+        return;
+    }
+
+    ReleaseSizeDependentResources();
+    m_scene->CacheD3DObjects();
+    m_inactiveAdapterDevices[LuidToKey(m_activeAdapterLuid)] = { m_device, m_commandQueue, m_fence };
+
+    m_fence.Reset();
+    m_commandQueue.Reset();
+    m_swapChain.Reset();
+    m_device.Reset();
+
+    LoadDevice();
+    LoadAssets();
+    LoadSizeDependentResources();
+}
+
+// Releases device objects kept alive for adapters that are no longer enumerated.
+void D3D12xGPU::ReleaseUnavailableAdapterDevices()
+{
+    for (auto inactiveDevice = m_inactiveAdapterDevices.begin(); inactiveDevice != m_inactiveAdapterDevices.end();)
+    {
+        UINT adapterIndex;
+        const LUID adapterLuid = inactiveDevice->second.device->GetAdapterLuid();
+        if (RetrieveAdapterIndex(&adapterIndex, adapterLuid))
+        {
+            inactiveDevice++;
+        }
+        else
+        {
+            m_scene->EvictD3DObjects(adapterLuid);
+            inactiveDevice = m_inactiveAdapterDevices.erase(inactiveDevice);
+        }
+    }
+}
+
 void D3D12xGPU::OnDestroy()
 {
     // Ensure that the GPU is no longer referencing resources that are about to be
@@ -539,7 +648,7 @@ void D3D12xGPU::SelectAdapter(UINT index)
     if (index != m_activeAdapter && index < m_gpuAdapterDescs.size() && m_gpuAdapterDescs[index].supportsDx12FL11)
     {
         m_activeAdapter = index;
-        RecreateD3Dresources();
+        SwitchAdapter();
     }
 }
 
@@ -568,8 +677,8 @@ void D3D12xGPU::SelectGPUPreference(UINT index)
         // Verify the active adapter still meets the new gpu preference setting. 
         if (FAILED(ValidateActiveAdapter()))
         {
-            // It does not, recreate the resources on a matching adapter.
-            RecreateD3Dresources();
+            // It does not, move rendering to a matching adapter.
+            SwitchAdapter();
         }
     }
 }
@@ -579,6 +688,7 @@ void D3D12xGPU::SelectGPUPreference(UINT index)
 HRESULT D3D12xGPU::ValidateActiveAdapter()
 {
     EnumerateGPUadapters();
+    ReleaseUnavailableAdapterDevices();
 
     if (!RetrieveAdapterIndex(&m_activeAdapter, m_activeAdapterLuid))
     {
@@ -73,6 +73,16 @@ private:
     UINT m_dxgiFactoryFlags;
     ComPtr<ID3D12Resource> m_renderTargets[FrameCount];
     ComPtr<ID3D12Fence> m_fence;
+
+    // Devices of adapters that rendering has been moved away from, keyed by adapter LUID.
+    // They are kept alive, along with the scene's objects on them, so that switching back is near-instant.
+    struct InactiveAdapterDevice
+    {
+        ComPtr<ID3D12Device> device;
+        ComPtr<ID3D12CommandQueue> commandQueue;
+        ComPtr<ID3D12Fence> fence;
+    };
+    std::map<UINT64, InactiveAdapterDevice> m_inactiveAdapterDevices;
     
     // Scene rendering resources
     std::unique_ptr<ShadowsFogScatteringSquidScene> m_scene;
@@ -97,11 +107,14 @@ private:
     static D3D12xGPU* s_app;
 
     void LoadPipeline();
+    void LoadDevice();
     void LoadAssets();
     void LoadSizeDependentResources();
     void ReleaseSizeDependentResources();
     void UpdateUI();
     void RecreateD3Dresources();
+    void SwitchAdapter();
+    void ReleaseUnavailableAdapterDevices();
     void ReleaseD3DObjects(); 
     void EnumerateGPUadapters();
     void GetGPUAdapter(UINT adapterIndex, IDXGIAdapter1** ppAdapter);
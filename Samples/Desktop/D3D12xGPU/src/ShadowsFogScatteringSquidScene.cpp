@@ -28,6 +28,7 @@ ShadowsFogScatteringSquidScene::ShadowsFogScatteringSquidScene(UINT frameCount,
     m_rtvDescriptorSize(0),
     m_keyboardInput(),
     m_pCurrentFrameResource(nullptr),
+    m_adapterLuid{},
     m_pSample(pSample)
 {
     s_app = this;
@@ -86,6 +87,8 @@ void ShadowsFogScatteringSquidScene::InitializeCameraAndLights()
 
 void ShadowsFogScatteringSquidScene::Initialize(ID3D12Device* pDevice, ID3D12CommandQueue* pCommandQueue, UINT frameIndex)
 {
+    m_adapterLuid = pDevice->GetAdapterLuid();
+
     CreateDescriptorHeaps(pDevice);
     CreateRootSignatures(pDevice);
     CreatePipelineStates(pDevice);
@@ -217,13 +220,15 @@ void ShadowsFogScatteringSquidScene::CreateRootSignatures(ID3D12Device* pDevice)
 
 void ShadowsFogScatteringSquidScene::CreatePipelineStates(ID3D12Device* pDevice)
 {
+    CreatePipelineLibrary(pDevice);
+
     // Create the scene and shadow render pass pipeline state.
     {
         ComPtr<ID3DBlob> vertexShader;
         ComPtr<ID3DBlob> pixelShader;
 
-        vertexShader = CompileShader(m_pSample->GetAssetFullPath(L"ShadowsAndScenePass.hlsl").c_str(), nullptr, "VSMain", "vs_5_0");
-        pixelShader = CompileShader(m_pSample->GetAssetFullPath(L"ShadowsAndScenePass.hlsl").c_str(), nullptr, "PSMain", "ps_5_0");
+        vertexShader = GetShader(L"ShadowsAndScenePass.hlsl", "VSMain", "vs_5_0");
+        pixelShader = GetShader(L"ShadowsAndScenePass.hlsl", "PSMain", "ps_5_0");
 
         D3D12_INPUT_LAYOUT_DESC inputLayoutDesc;
         inputLayoutDesc.pInputElementDescs = SampleAssets::StandardVertexDescription;
@@ -251,7 +256,7 @@ void ShadowsFogScatteringSquidScene::CreatePipelineStates(ID3D12Device* pDevice)
         psoDesc.DSVFormat = DXGI_FORMAT_D32_FLOAT;
         psoDesc.SampleDesc.Count = 1;
 
-        ThrowIfFailed(pDevice->CreateGraphicsPipelineState(&psoDesc, IID_PPV_ARGS(&m_pipelineStates[RenderPass::Scene])));
+        CreateGraphicsPipelineState(pDevice, psoDesc, RenderPass::Scene, L"Scene");
         NAME_D3D12_OBJECT(m_pipelineStates[RenderPass::Scene]);
 
         // Alter the description and create the PSO for rendering
@@ -261,7 +266,7 @@ void ShadowsFogScatteringSquidScene::CreatePipelineStates(ID3D12Device* pDevice)
         psoDesc.RTVFormats[0] = DXGI_FORMAT_UNKNOWN;
         psoDesc.NumRenderTargets = 0;
 
-        ThrowIfFailed(pDevice->CreateGraphicsPipelineState(&psoDesc, IID_PPV_ARGS(&m_pipelineStates[RenderPass::Shadow])));
+        CreateGraphicsPipelineState(pDevice, psoDesc, RenderPass::Shadow, L"Shadow");
         NAME_D3D12_OBJECT(m_pipelineStates[RenderPass::Shadow]);
     }
 
@@ -270,8 +275,8 @@ void ShadowsFogScatteringSquidScene::CreatePipelineStates(ID3D12Device* pDevice)
         ComPtr<ID3DBlob> vertexShader;
         ComPtr<ID3DBlob> pixelShader;
 
-        vertexShader = CompileShader(m_pSample->GetAssetFullPath(L"PostprocessPass.hlsl").c_str(), nullptr, "VSMain", "vs_5_0");
-        pixelShader = CompileShader(m_pSample->GetAssetFullPath(L"PostprocessPass.hlsl").c_str(), nullptr, "PSMain", "ps_5_0");
+        vertexShader = GetShader(L"PostprocessPass.hlsl", "VSMain", "vs_5_0");
+        pixelShader = GetShader(L"PostprocessPass.hlsl", "PSMain", "ps_5_0");
 
 
         // Define the vertex input layout.
@@ -299,7 +304,83 @@ void ShadowsFogScatteringSquidScene::CreatePipelineStates(ID3D12Device* pDevice)
         psoDesc.NumRenderTargets = 1;
         psoDesc.RTVFormats[0] = DXGI_FORMAT_R8G8B8A8_UNORM;
         psoDesc.SampleDesc.Count = 1;
-        ThrowIfFailed(pDevice->CreateGraphicsPipelineState(&psoDesc, IID_PPV_ARGS(&m_pipelineStates[RenderPass::Postprocess])));
+        CreateGraphicsPipelineState(pDevice, psoDesc, RenderPass::Postprocess, L"Postprocess");
+    }
+}
+
+// Compiled shaders don't depend on the device, so each shader is compiled once
+// and reused when the device objects are recreated on another adapter.
+ComPtr<ID3DBlob> ShadowsFogScatteringSquidScene::GetShader(const wstring& filename, const string& entrypoint, const string& target)
+{
+    const wstring key = filename + L":" + wstring(entrypoint.begin(), entrypoint.end()) + L":" + wstring(target.begin(), target.end());
+    auto shader = m_shaders.find(key);
+    if (shader == m_shaders.end())
+    {
+        shader = m_shaders.emplace(key, CompileShader(m_pSample->GetAssetFullPath(filename.c_str()), nullptr, entrypoint, target)).first;
+    }
+    return shader->second;
+}
+
+// Creates a pipeline library for the device from the library last serialized on the same adapter, if any.
+void ShadowsFogScatteringSquidScene::CreatePipelineLibrary(ID3D12Device* pDevice)
+{
+    ComPtr<ID3D12Device1> device1;
+    if (FAILED(pDevice->QueryInterface(IID_PPV_ARGS(&device1))))
+    {
+        return;
+    }
+
+    // The library references the serialized blob for its whole lifetime, so the blob
+    // is only replaced once the library has been released.
+    vector<BYTE>& serializedLibrary = m_pipelineLibraryBlobs[LuidToKey(m_adapterLuid)];
+    HRESULT hr = device1->CreatePipelineLibrary(serializedLibrary.data(), serializedLibrary.size(), IID_PPV_ARGS(&m_pipelineLibrary));
+    if (hr == D3D12_ERROR_DRIVER_VERSION_MISMATCH || hr == D3D12_ERROR_ADAPTER_NOT_FOUND || hr == E_INVALIDARG)
+    {
+        // The serialized library is stale (e.g. the driver got updated), start over with an empty one.
+        serializedLibrary.clear();
+        hr = device1->CreatePipelineLibrary(nullptr, 0, IID_PPV_ARGS(&m_pipelineLibrary));
+    }
+
+    if (hr == DXGI_ERROR_UNSUPPORTED)
+    {
+        // Pipeline libraries can be unsupported, e.g. when running under a graphics debugger.
+        m_pipelineLibrary.Reset();
+        return;
+    }
+    ThrowIfFailed(hr);
+}
+
+// Serializes and releases a pipeline library, so that a device recreated on the same adapter starts with warm PSOs.
+void ShadowsFogScatteringSquidScene::ReleasePipelineLibrary(ComPtr<ID3D12PipelineLibrary>* pPipelineLibrary, LUID adapterLuid)
+{
+    if (*pPipelineLibrary)
+    {
+        vector<BYTE> serializedLibrary((*pPipelineLibrary)->GetSerializedSize());
+        HRESULT hr = (*pPipelineLibrary)->Serialize(serializedLibrary.data(), serializedLibrary.size());
+        pPipelineLibrary->Reset();
+
+        // Serialization fails on a removed device, in which case the previous blob is kept.
+        if (SUCCEEDED(hr))
+        {
+            m_pipelineLibraryBlobs[LuidToKey(adapterLuid)] = move(serializedLibrary);
+        }
+    }
+}
+
+// Loads a PSO from the pipeline library, falling back to compiling it if it hasn't been stored yet.
+void ShadowsFogScatteringSquidScene::CreateGraphicsPipelineState(ID3D12Device* pDevice, const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc, RenderPass::Value renderPass, LPCWSTR name)
+{
+    if (m_pipelineLibrary && SUCCEEDED(m_pipelineLibrary->LoadGraphicsPipeline(name, &desc, IID_PPV_ARGS(&m_pipelineStates[renderPass]))))
+    {
+        return;
+    }
+
+    ThrowIfFailed(pDevice->CreateGraphicsPipelineState(&desc, IID_PPV_ARGS(&m_pipelineStates[renderPass])));
+    if (m_pipelineLibrary)
+    {
+        // Storing fails if a PSO with a different description was stored under the same name
+        // (e.g. a shader got changed). It will simply keep being compiled in that case.
+        m_pipelineLibrary->StorePipeline(name, m_pipelineStates[renderPass].Get());
     }
 }
 
@@ -684,6 +765,76 @@ void ShadowsFogScatteringSquidScene::ReleaseD3DObjects()
 
     ResetUniquePtrArray(&m_frameResources);
     m_pCurrentFrameResource = nullptr;
+
+    ReleasePipelineLibrary(&m_pipelineLibrary, m_adapterLuid);
+}
+
+// Moves the device objects of the current adapter aside, so that switching back to it
+// doesn't need to recreate them. Caller is expected to have waited for the GPU to go idle.
+void ShadowsFogScatteringSquidScene::CacheD3DObjects()
+{
+    // Upload heaps are only needed for the initial asset upload.
+    ResetComPtrArray(&m_renderTargets);
+    ResetComPtrArray(&m_textureUploads);
+    m_indexBufferUpload.Reset();
+    m_vertexBufferUpload.Reset();
+
+    assert(m_cachedD3DObjects.find(LuidToKey(m_adapterLuid)) == m_cachedD3DObjects.end());
+    SwapD3DObjects(&m_cachedD3DObjects[LuidToKey(m_adapterLuid)]);
+    m_frameResources.resize(m_frameCount);
+    m_pCurrentFrameResource = nullptr;
+}
+
+// Makes device objects cached for an adapter current again.
+// Returns false if there are none, in which case Initialize() needs to be called.
+bool ShadowsFogScatteringSquidScene::RestoreD3DObjects(LUID adapterLuid, UINT frameIndex)
+{
+    auto cachedObjects = m_cachedD3DObjects.find(LuidToKey(adapterLuid));
+    if (cachedObjects == m_cachedD3DObjects.end())
+    {
+        return false;
+    }
+
+    SwapD3DObjects(&cachedObjects->second);
+    m_cachedD3DObjects.erase(cachedObjects);
+    m_frameResources.resize(m_frameCount);
+    m_adapterLuid = adapterLuid;
+
+    SetFrameIndex(frameIndex);
+    return true;
+}
+
+// Releases device objects cached for an adapter, e.g. when the adapter has been removed.
+void ShadowsFogScatteringSquidScene::EvictD3DObjects(LUID adapterLuid)
+{
+    auto cachedObjects = m_cachedD3DObjects.find(LuidToKey(adapterLuid));
+    if (cachedObjects != m_cachedD3DObjects.end())
+    {
+        // PSOs are released before the library they were loaded from.
+        ResetUniquePtrArray(&cachedObjects->second.frameResources);
+        ResetComPtrArray(&cachedObjects->second.pipelineStates);
+        ReleasePipelineLibrary(&cachedObjects->second.pipelineLibrary, adapterLuid);
+        m_cachedD3DObjects.erase(cachedObjects);
+    }
+}
+
+void ShadowsFogScatteringSquidScene::SwapD3DObjects(D3DObjects* pObjects)
+{
+    swap(m_rootSignatures, pObjects->rootSignatures);
+    swap(m_pipelineStates, pObjects->pipelineStates);
+    swap(m_pipelineLibrary, pObjects->pipelineLibrary);
+    swap(m_vertexBuffers, pObjects->vertexBuffers);
+    swap(m_vertexBufferViews, pObjects->vertexBufferViews);
+    swap(m_indexBufferView, pObjects->indexBufferView);
+    swap(m_textures, pObjects->textures);
+    swap(m_indexBuffer, pObjects->indexBuffer);
+    swap(m_rtvHeap, pObjects->rtvHeap);
+    swap(m_dsvHeap, pObjects->dsvHeap);
+    swap(m_cbvSrvHeap, pObjects->cbvSrvHeap);
+    swap(m_samplerHeap, pObjects->samplerHeap);
+    swap(m_rtvDescriptorSize, pObjects->rtvDescriptorSize);
+    swap(m_cbvSrvDescriptorSize, pObjects->cbvSrvDescriptorSize);
+    swap(m_frameResources, pObjects->frameResources);
 }
 
 // Caller is expected to enforce frame synchronization and that the GPU is done with frameIndex frame before being set as current frame again.
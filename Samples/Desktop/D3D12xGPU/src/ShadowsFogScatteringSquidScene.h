@@ -45,6 +45,12 @@ static const int CommandListPre = 0;
 static const int CommandListMid = 1;
 static const int CommandListPost = 2;
 
+// Adapter LUIDs are used as keys for objects kept per adapter.
+inline UINT64 LuidToKey(const LUID& luid)
+{
+    return (static_cast<UINT64>(luid.HighPart) << 32) | luid.LowPart;
+}
+
 namespace SceneEnums
 {
     namespace RenderPass {
@@ -116,6 +122,9 @@ public:
     void ReleaseSizeDependentResources();
     void SetFrameIndex(UINT frameIndex);
     void ReleaseD3DObjects();    
+    void CacheD3DObjects();
+    bool RestoreD3DObjects(LUID adapterLuid, UINT frameIndex);
+    void EvictD3DObjects(LUID adapterLuid);
     void KeyDown(UINT8 key);
     void KeyUp(UINT8 key);
     void Update(double elapsedTime);
@@ -137,6 +146,7 @@ private:
     std::vector<ComPtr<ID3D12Resource>> m_renderTargets;
     ComPtr<ID3D12RootSignature> m_rootSignatures[SceneEnums::RootSignature::Count];
     ComPtr<ID3D12PipelineState> m_pipelineStates[SceneEnums::RenderPass::Count];
+    ComPtr<ID3D12PipelineLibrary> m_pipelineLibrary;
     ComPtr<ID3D12Resource> m_vertexBuffers[SceneEnums::VertexBuffer::Count];
     D3D12_VERTEX_BUFFER_VIEW m_vertexBufferViews[SceneEnums::VertexBuffer::Count];
     D3D12_INDEX_BUFFER_VIEW m_indexBufferView;
@@ -159,6 +169,33 @@ private:
     FrameResource* m_pCurrentFrameResource;
     UINT m_frameIndex;
 
+    // Device objects of adapters that rendering has been moved away from, keyed by adapter LUID.
+    // Keeping them alive makes switching back to an adapter near-instant.
+    struct D3DObjects
+    {
+        ComPtr<ID3D12RootSignature> rootSignatures[SceneEnums::RootSignature::Count];
+        ComPtr<ID3D12PipelineState> pipelineStates[SceneEnums::RenderPass::Count];
+        ComPtr<ID3D12PipelineLibrary> pipelineLibrary;
+        ComPtr<ID3D12Resource> vertexBuffers[SceneEnums::VertexBuffer::Count];
+        D3D12_VERTEX_BUFFER_VIEW vertexBufferViews[SceneEnums::VertexBuffer::Count];
+        D3D12_INDEX_BUFFER_VIEW indexBufferView;
+        ComPtr<ID3D12Resource> textures[_countof(SampleAssets::Textures)];
+        ComPtr<ID3D12Resource> indexBuffer;
+        ComPtr<ID3D12DescriptorHeap> rtvHeap;
+        ComPtr<ID3D12DescriptorHeap> dsvHeap;
+        ComPtr<ID3D12DescriptorHeap> cbvSrvHeap;
+        ComPtr<ID3D12DescriptorHeap> samplerHeap;
+        UINT rtvDescriptorSize;
+        UINT cbvSrvDescriptorSize;
+        std::vector<std::unique_ptr<FrameResource>> frameResources;
+    };
+    std::map<UINT64, D3DObjects> m_cachedD3DObjects;
+    LUID m_adapterLuid;
+
+    // Device independent caches that survive device recreation.
+    std::map<std::wstring, ComPtr<ID3DBlob>> m_shaders;
+    std::map<UINT64, std::vector<BYTE>> m_pipelineLibraryBlobs;     // Serialized pipeline libraries, keyed by adapter LUID.
+
     // App resources.
     DXSample*  m_pSample;
     InputState m_keyboardInput;
@@ -193,6 +230,11 @@ private:
     void CreateDescriptorHeaps(ID3D12Device* pDevice);
     void CreateRootSignatures(ID3D12Device* pDevice);
     void CreatePipelineStates(ID3D12Device* pDevice);
+    void CreatePipelineLibrary(ID3D12Device* pDevice);
+    void ReleasePipelineLibrary(ComPtr<ID3D12PipelineLibrary>* pPipelineLibrary, LUID adapterLuid);
+    void CreateGraphicsPipelineState(ID3D12Device* pDevice, const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc, SceneEnums::RenderPass::Value renderPass, LPCWSTR name);
+    ComPtr<ID3DBlob> GetShader(const std::wstring& filename, const std::string& entrypoint, const std::string& target);
+    void SwapD3DObjects(D3DObjects* pObjects);
     void CreateFrameResources(ID3D12Device* pDevice);
     void CreateAssetResources(ID3D12Device* pDevice, ID3D12GraphicsCommandList* pAssetLoadingCmdList);
     void CreatePostprocessPassResources(ID3D12Device* pDevice);
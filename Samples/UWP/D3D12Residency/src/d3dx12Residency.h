@@ -13,6 +13,7 @@
 namespace D3DX12Residency
 {
     __declspec(selectany) INT64 g_ResidencyManagerUniqueID = 0;
+    __declspec(selectany) INT64 g_ResidencySetMergeStamp = 0;
 
 #if 0
 #define RESIDENCY_CHECK(x) \
@@ -33,6 +34,32 @@ namespace D3DX12Residency
     // This size can be tuned to your app in order to save space
 #define MAX_NUM_CONCURRENT_CMD_LISTS 32
 
+    enum RESIDENCY_MANAGER_FLAGS
+    {
+        RESIDENCY_MANAGER_FLAG_NONE = 0x0,
+        // Run a low priority thread which watches the trend in video memory usage and evicts cold objects
+        // before the budget is crossed, rather than waiting for a submission to run out of space.
+        RESIDENCY_MANAGER_FLAG_BACKGROUND_EVICTION = 0x1,
+    };
+
+    // Paging activity since the statistics were last reset. Times are in milliseconds.
+    struct RESIDENCY_STATS
+    {
+        UINT64 BytesMadeResident;
+        UINT64 BytesEvicted;
+        UINT32 NumMakeResidentCalls;
+        float MakeResidentTime;
+        float MaxMakeResidentTime;
+        // Time the worker thread spent waiting on the GPU so that it could trim before making objects resident
+        float WaitForSyncPointTime;
+        // Time ExecuteCommandLists spent blocked because the worker thread was MaxLatency submissions behind
+        float WaitForWorkerTime;
+
+        // Sampled at the most recent submission. Headroom is negative when usage is over budget.
+        INT64 BudgetHeadroom;
+        UINT64 ResidentSize;
+    };
+
     namespace Internal
     {
         class CriticalSection
@@ -100,6 +127,7 @@ namespace D3DX12Residency
 
         //Forward Declaration
         class ResidencyManagerInternal;
+        struct LRUBucket;
     }
 
     // Used to track meta data for each object the app potentially wants
@@ -113,22 +141,37 @@ namespace D3DX12Residency
             EVICTED
         };
 
+        // Under memory pressure objects are evicted from the lowest class first, oldest first within a class.
+        // Each class also maps to a D3D12_RESIDENCY_PRIORITY so the OS makes the same choice.
+        enum class RESIDENCY_PRIORITY
+        {
+            STREAMABLE,     // Data that can be streamed back in at a lower quality, e.g. distant texture mips
+            NORMAL,
+            HIGH,
+            CRITICAL,       // Render targets and anything else the frame can't be drawn without
+            COUNT
+        };
+
         ManagedObject() :
             pUnderlying(nullptr),
             Size(0),
             ResidencyStatus(RESIDENCY_STATUS::RESIDENT),
+            Priority(RESIDENCY_PRIORITY::NORMAL),
             LastGPUSyncPoint(0),
-            LastUsedTimestamp(0)
+            LastUsedTimestamp(0),
+            MergeStamp(0),
+            pLRUBucket(nullptr)
         {
             memset(CommandListsUsedOn, 0, sizeof(CommandListsUsedOn));
         }
 
-        void Initialize(ID3D12Pageable* pUnderlyingIn, UINT64 ObjectSize, UINT64 InitialGPUSyncPoint = 0)
+        void Initialize(ID3D12Pageable* pUnderlyingIn, UINT64 ObjectSize, UINT64 InitialGPUSyncPoint = 0, RESIDENCY_PRIORITY InitialPriority = RESIDENCY_PRIORITY::NORMAL)
         {
             RESIDENCY_CHECK(pUnderlying == nullptr);
             pUnderlying = pUnderlyingIn;
             Size = ObjectSize;
             LastGPUSyncPoint = InitialGPUSyncPoint;
+            Priority = InitialPriority;
         }
 
         inline bool IsInitialized() { return pUnderlying != nullptr; }
@@ -136,6 +179,9 @@ namespace D3DX12Residency
         // Wether the object is resident or not
         RESIDENCY_STATUS ResidencyStatus;
 
+        // Use ResidencyManager::SetResidencyPriority to change this once the object is tracked
+        RESIDENCY_PRIORITY Priority;
+
         // The underlying D3D Object being tracked
         ID3D12Pageable* pUnderlying;
         // The size of the D3D Object in bytes
@@ -144,11 +190,17 @@ namespace D3DX12Residency
         UINT64 LastGPUSyncPoint;
         UINT64 LastUsedTimestamp;
 
+        // The last ConcurrentResidencySet::Close that added this object, used to drop duplicates in one pass
+        INT64 MergeStamp;
+
         // This is used to track which open command lists this resource is currently used on.
         bool CommandListsUsedOn[MAX_NUM_CONCURRENT_CMD_LISTS];
 
         // Linked list entry
         LIST_ENTRY ListEntry;
+
+        // The LRU bucket holding this object while it is resident
+        Internal::LRUBucket* pLRUBucket;
     };
 
     // This represents a set of objects which are referenced by a command list i.e. every time a resource
@@ -157,6 +209,7 @@ namespace D3DX12Residency
     class ResidencySet
     {
         friend class ResidencyManager;
+        friend class ConcurrentResidencySet;
         friend class Internal::ResidencyManagerInternal;
     public:
 
@@ -330,6 +383,188 @@ namespace D3DX12Residency
         Internal::SyncManager* pSyncManager;
     };
 
+    // A residency set that several threads can record into at once, e.g. when a command list is recorded in
+    // parallel bundles or the app splits a frame across threads. Each thread inserts into its own sub-set
+    // without any locking, and Close merges the sub-sets into a ResidencySet, which GetResidencySet returns
+    // for ExecuteCommandLists.
+    class ConcurrentResidencySet
+    {
+        friend class ResidencyManager;
+    public:
+
+        ConcurrentResidencySet() :
+            pSubSets(nullptr),
+            NumSubSets(0)
+        {
+        }
+
+        ~ConcurrentResidencySet()
+        {
+            for (UINT32 i = 0; i < NumSubSets; i++)
+            {
+                delete[](pSubSets[i].ppObjects);
+            }
+            delete[](pSubSets);
+        }
+
+        // ThreadIndex identifies the calling thread's sub-set and must be less than the thread count the set was
+        // created with. Two threads must never use the same index while the set is open.
+        // Returns true if the object was inserted, false otherwise
+        inline bool Insert(UINT32 ThreadIndex, ManagedObject* pObject)
+        {
+            RESIDENCY_CHECK(MergedSet.IsOpen);
+            RESIDENCY_CHECK(ThreadIndex < NumSubSets);
+
+            SubSet& Set = pSubSets[ThreadIndex];
+
+            // Bindings tend to repeat back to back, skip those here and leave the rest for Close
+            if (Set.Count > 0 && Set.ppObjects[Set.Count - 1] == pObject)
+            {
+                return false;
+            }
+
+            if (Set.Count >= Set.Capacity && Set.Grow() == false)
+            {
+                Set.OutOfMemory = true;
+                return false;
+            }
+
+            Set.ppObjects[Set.Count++] = pObject;
+            return true;
+        }
+
+        // The merged set is marked open too, so ExecuteCommandLists rejects it until Close.
+        HRESULT Open()
+        {
+            // It's invalid to open a set that is already open
+            if (MergedSet.IsOpen)
+            {
+                return E_INVALIDARG;
+            }
+
+            for (UINT32 i = 0; i < NumSubSets; i++)
+            {
+                pSubSets[i].Count = 0;
+                pSubSets[i].OutOfMemory = false;
+            }
+
+            MergedSet.CurrentSetSize = 0;
+
+            MergedSet.IsOpen = true;
+            MergedSet.OutOfMemory = false;
+            return S_OK;
+        }
+
+        // Must only be called once every thread has finished inserting
+        HRESULT Close()
+        {
+            if (MergedSet.IsOpen == false)
+            {
+                return E_INVALIDARG;
+            }
+
+            MergedSet.IsOpen = false;
+
+            INT32 TotalSize = 0;
+            for (UINT32 i = 0; i < NumSubSets; i++)
+            {
+                if (pSubSets[i].OutOfMemory)
+                {
+                    return E_OUTOFMEMORY;
+                }
+                TotalSize += pSubSets[i].Count;
+            }
+
+            if (TotalSize > MergedSet.MaxResidencySetSize)
+            {
+                delete[](MergedSet.ppSet);
+                MergedSet.MaxResidencySetSize = TotalSize;
+                MergedSet.ppSet = new ManagedObject*[MergedSet.MaxResidencySetSize];
+                if (MergedSet.ppSet == nullptr)
+                {
+                    MergedSet.MaxResidencySetSize = 0;
+                    return E_OUTOFMEMORY;
+                }
+            }
+
+            // Every Close gets a unique stamp, so an object already carrying it has been added by this merge.
+            // If two sets close at once on different threads an object can end up in a set twice, which
+            // ExecuteCommandLists already tolerates.
+            const INT64 Stamp = InterlockedIncrement64(&g_ResidencySetMergeStamp);
+            for (UINT32 i = 0; i < NumSubSets; i++)
+            {
+                const SubSet& Set = pSubSets[i];
+                for (INT32 x = 0; x < Set.Count; x++)
+                {
+                    ManagedObject* pObject = Set.ppObjects[x];
+                    if (pObject->MergeStamp != Stamp)
+                    {
+                        pObject->MergeStamp = Stamp;
+                        MergedSet.ppSet[MergedSet.CurrentSetSize++] = pObject;
+                    }
+                }
+            }
+
+            return S_OK;
+        }
+
+        // The merged objects, for ExecuteCommandLists.  Only valid while the set is closed, and it must not be
+        // opened or inserted into directly.
+        ResidencySet* GetResidencySet()
+        {
+            return &MergedSet;
+        }
+
+    private:
+
+        struct SubSet
+        {
+            SubSet() : ppObjects(nullptr), Capacity(0), Count(0), OutOfMemory(false) {}
+
+            bool Grow()
+            {
+                const INT32 NewCapacity = (Capacity == 0) ? 1024 : INT32(Capacity + (Capacity / 2.0f));
+                ManagedObject** ppNewAlloc = new ManagedObject*[NewCapacity];
+                if (ppNewAlloc == nullptr)
+                {
+                    return false;
+                }
+
+                if (ppObjects)
+                {
+                    memcpy(ppNewAlloc, ppObjects, Count * sizeof(ManagedObject*));
+                    delete[](ppObjects);
+                }
+
+                ppObjects = ppNewAlloc;
+                Capacity = NewCapacity;
+                return true;
+            }
+
+            ManagedObject** ppObjects;
+            INT32 Capacity;
+            INT32 Count;
+            bool OutOfMemory;
+
+            // Pad to a cache line so that threads inserting side by side don't share one
+            BYTE Padding[64 - sizeof(ManagedObject**) - 2 * sizeof(INT32) - sizeof(bool)];
+        };
+
+        bool Initialize(Internal::SyncManager* pSyncManagerIn, UINT32 NumThreads)
+        {
+            MergedSet.Initialize(pSyncManagerIn);
+
+            NumSubSets = NumThreads;
+            pSubSets = new SubSet[NumSubSets];
+
+            return pSubSets != nullptr;
+        }
+
+        ResidencySet MergedSet;
+        SubSet* pSubSets;
+        UINT32 NumSubSets;
+    };
+
     namespace Internal
     {
         /* List Helpers */
@@ -497,25 +732,67 @@ namespace D3DX12Residency
             QueueSyncPoint pQueueSyncPoints[1];
         };
 
+        inline D3D12_RESIDENCY_PRIORITY GetD3D12ResidencyPriority(ManagedObject::RESIDENCY_PRIORITY Priority)
+        {
+            switch (Priority)
+            {
+            case ManagedObject::RESIDENCY_PRIORITY::STREAMABLE: return D3D12_RESIDENCY_PRIORITY_LOW;
+            case ManagedObject::RESIDENCY_PRIORITY::HIGH: return D3D12_RESIDENCY_PRIORITY_HIGH;
+            case ManagedObject::RESIDENCY_PRIORITY::CRITICAL: return D3D12_RESIDENCY_PRIORITY_MAXIMUM;
+            default: return D3D12_RESIDENCY_PRIORITY_NORMAL;
+            }
+        }
+
+        // Resident objects of one priority class that were last used by the same sync point generation.
+        // Buckets are kept oldest first, so trimming compares one generation per bucket instead of one per object.
+        struct LRUBucket
+        {
+            UINT64 Generation;
+            // The newest use of any object in the bucket
+            UINT64 LastUsedTimestamp;
+            UINT64 Size;
+            LIST_ENTRY ObjectListHead;
+            // Entry in the bucket list of the class, or in the free list
+            LIST_ENTRY ListEntry;
+        };
+
         // A Least Recently Used Cache. Tracks all of the objects requested by the app so that objects
         // that aren't used freqently can get evicted to help the app stay under buget.
+        // Resident objects are kept in one list of buckets per priority class.
         class LRUCache
         {
         public:
+            static const UINT32 NumPriorities = UINT32(ManagedObject::RESIDENCY_PRIORITY::COUNT);
+
             LRUCache() :
                 NumResidentObjects(0),
                 NumEvictedObjects(0),
-                ResidentSize(0)
+                ResidentSize(0),
+                BytesMadeResident(0),
+                BytesEvicted(0)
             {
-                Internal::InitializeListHead(&ResidentObjectListHead);
+                for (UINT32 i = 0; i < NumPriorities; i++)
+                {
+                    Internal::InitializeListHead(&ResidentBucketListHeads[i]);
+                }
+                Internal::InitializeListHead(&FreeBucketListHead);
                 Internal::InitializeListHead(&EvictedObjectListHead);
             };
 
+            ~LRUCache()
+            {
+                for (UINT32 i = 0; i < NumPriorities; i++)
+                {
+                    FreeBuckets(&ResidentBucketListHeads[i]);
+                }
+                FreeBuckets(&FreeBucketListHead);
+            }
+
             void Insert(ManagedObject* pObject)
             {
                 if (pObject->ResidencyStatus == ManagedObject::RESIDENCY_STATUS::RESIDENT)
                 {
-                    Internal::InsertHeadList(&ResidentObjectListHead, &pObject->ListEntry);
+                    AddResident(pObject, true);
                     NumResidentObjects++;
                     ResidentSize += pObject->Size;
                 }
@@ -528,14 +805,15 @@ namespace D3DX12Residency
 
             void Remove(ManagedObject* pObject)
             {
-                Internal::RemoveEntryList(&pObject->ListEntry);
                 if (pObject->ResidencyStatus == ManagedObject::RESIDENCY_STATUS::RESIDENT)
                 {
+                    RemoveResident(pObject);
                     NumResidentObjects--;
                     ResidentSize -= pObject->Size;
                 }
                 else
                 {
+                    Internal::RemoveEntryList(&pObject->ListEntry);
                     NumEvictedObjects--;
                 }
             }
@@ -547,8 +825,23 @@ namespace D3DX12Residency
             {
                 RESIDENCY_CHECK(pObject->ResidencyStatus == ManagedObject::RESIDENCY_STATUS::RESIDENT);
 
-                Internal::RemoveEntryList(&pObject->ListEntry);
-                Internal::InsertTailList(&ResidentObjectListHead, &pObject->ListEntry);
+                RemoveResident(pObject);
+                AddResident(pObject, false);
+            }
+
+            // The object moves to the end of its new class, as if it had just been used
+            void SetPriority(ManagedObject* pObject, ManagedObject::RESIDENCY_PRIORITY Priority)
+            {
+                if (pObject->ResidencyStatus == ManagedObject::RESIDENCY_STATUS::RESIDENT)
+                {
+                    RemoveResident(pObject);
+                    pObject->Priority = Priority;
+                    AddResident(pObject, false);
+                }
+                else
+                {
+                    pObject->Priority = Priority;
+                }
             }
 
             void MakeResident(ManagedObject* pObject)
@@ -557,11 +850,12 @@ namespace D3DX12Residency
 
                 pObject->ResidencyStatus = ManagedObject::RESIDENCY_STATUS::RESIDENT;
                 Internal::RemoveEntryList(&pObject->ListEntry);
-                Internal::InsertTailList(&ResidentObjectListHead, &pObject->ListEntry);
+                AddResident(pObject, false);
 
                 NumEvictedObjects--;
                 NumResidentObjects++;
                 ResidentSize += pObject->Size;
+                BytesMadeResident += pObject->Size;
             }
 
             void Evict(ManagedObject* pObject)
@@ -569,78 +863,187 @@ namespace D3DX12Residency
                 RESIDENCY_CHECK(pObject->ResidencyStatus == ManagedObject::RESIDENCY_STATUS::RESIDENT);
 
                 pObject->ResidencyStatus = ManagedObject::RESIDENCY_STATUS::EVICTED;
-                Internal::RemoveEntryList(&pObject->ListEntry);
+                RemoveResident(pObject);
                 Internal::InsertTailList(&EvictedObjectListHead, &pObject->ListEntry);
 
                 NumResidentObjects--;
                 ResidentSize -= pObject->Size;
                 NumEvictedObjects++;
+                BytesEvicted += pObject->Size;
             }
 
-            // Evict all of the resident objects used in sync points up to the specficied one (inclusive)
+            // Evict all of the resident objects used in sync points up to the specficied one (inclusive), lowest priority class first
             void TrimToSyncPointInclusive(INT64 CurrentUsage, INT64 CurrentBudget, ID3D12Pageable** EvictionList, UINT32& NumObjectsToEvict, UINT64 SyncPoint)
             {
                 NumObjectsToEvict = 0;
 
-                LIST_ENTRY* pResourceEntry = ResidentObjectListHead.Flink;
-                while (pResourceEntry != &ResidentObjectListHead)
+                for (UINT32 i = 0; i < NumPriorities && CurrentUsage >= CurrentBudget; i++)
                 {
-                    ManagedObject* pObject = CONTAINING_RECORD(pResourceEntry, ManagedObject, ListEntry);
-
-                    if (pObject->LastGPUSyncPoint > SyncPoint || CurrentUsage < CurrentBudget)
+                    LIST_ENTRY* pListHead = &ResidentBucketListHeads[i];
+                    while (pListHead->Flink != pListHead && CurrentUsage >= CurrentBudget)
                     {
-                        break;
-                    }
+                        LRUBucket* pBucket = CONTAINING_RECORD(pListHead->Flink, LRUBucket, ListEntry);
+                        if (pBucket->Generation > SyncPoint)
+                        {
+                            break;
+                        }
 
-                    RESIDENCY_CHECK(pObject->ResidencyStatus == ManagedObject::RESIDENCY_STATUS::RESIDENT);
+                        // Every object in the bucket is old enough, so only the budget decides where to stop
+                        while (CurrentUsage >= CurrentBudget)
+                        {
+                            // The last object empties the bucket, which returns it to the free list
+                            const bool LastObject = pBucket->ObjectListHead.Flink->Flink == &pBucket->ObjectListHead;
+                            ManagedObject* pObject = CONTAINING_RECORD(pBucket->ObjectListHead.Flink, ManagedObject, ListEntry);
 
-                    EvictionList[NumObjectsToEvict++] = pObject->pUnderlying;
-                    Evict(pObject);
+                            EvictionList[NumObjectsToEvict++] = pObject->pUnderlying;
+                            Evict(pObject);
 
-                    CurrentUsage -= pObject->Size;
+                            CurrentUsage -= pObject->Size;
 
-                    pResourceEntry = ResidentObjectListHead.Flink;
+                            if (LastObject)
+                            {
+                                break;
+                            }
+                        }
+                    }
                 }
             }
 
             // Trim all objects which are older than the specified time
             void TrimAgedAllocations(DeviceWideSyncPoint* MaxSyncPoint, ID3D12Pageable** EvictionList, UINT32& NumObjectsToEvict, UINT64 CurrentTimeStamp, UINT64 MinDelta)
             {
-                LIST_ENTRY* pResourceEntry = ResidentObjectListHead.Flink;
-                while (pResourceEntry != &ResidentObjectListHead)
+                for (UINT32 i = 0; i < NumPriorities; i++)
                 {
-                    ManagedObject* pObject = CONTAINING_RECORD(pResourceEntry, ManagedObject, ListEntry);
-
-                    if ((MaxSyncPoint && pObject->LastGPUSyncPoint >= MaxSyncPoint->GenerationID) || // Only trim allocations done on the GPU
-                        CurrentTimeStamp - pObject->LastUsedTimestamp <= MinDelta) // Don't evict things which have been used recently
+                    LIST_ENTRY* pListHead = &ResidentBucketListHeads[i];
+                    while (pListHead->Flink != pListHead)
                     {
-                        break;
-                    }
+                        LRUBucket* pBucket = CONTAINING_RECORD(pListHead->Flink, LRUBucket, ListEntry);
 
-                    RESIDENCY_CHECK(pObject->ResidencyStatus == ManagedObject::RESIDENCY_STATUS::RESIDENT);
-                    EvictionList[NumObjectsToEvict++] = pObject->pUnderlying;
-                    Evict(pObject);
+                        if ((MaxSyncPoint && pBucket->Generation >= MaxSyncPoint->GenerationID) || // Only trim allocations done on the GPU
+                            CurrentTimeStamp - pBucket->LastUsedTimestamp <= MinDelta) // Don't evict things which have been used recently
+                        {
+                            break;
+                        }
 
-                    pResourceEntry = ResidentObjectListHead.Flink;
+                        // The whole bucket goes, and the last eviction returns it to the free list
+                        bool LastObject = false;
+                        while (!LastObject)
+                        {
+                            LastObject = pBucket->ObjectListHead.Flink->Flink == &pBucket->ObjectListHead;
+                            ManagedObject* pObject = CONTAINING_RECORD(pBucket->ObjectListHead.Flink, ManagedObject, ListEntry);
+
+                            RESIDENCY_CHECK(pObject->ResidencyStatus == ManagedObject::RESIDENCY_STATUS::RESIDENT);
+                            EvictionList[NumObjectsToEvict++] = pObject->pUnderlying;
+                            Evict(pObject);
+                        }
+                    }
                 }
             }
 
+            // Returns the least recently used resident object across all priority classes
             ManagedObject* GetResidentListHead()
             {
-                if (IsListEmpty(&ResidentObjectListHead))
+                LRUBucket* pOldest = nullptr;
+                for (UINT32 i = 0; i < NumPriorities; i++)
                 {
-                    return nullptr;
+                    if (IsListEmpty(&ResidentBucketListHeads[i]) == false)
+                    {
+                        LRUBucket* pHead = CONTAINING_RECORD(ResidentBucketListHeads[i].Flink, LRUBucket, ListEntry);
+                        if (pOldest == nullptr || pHead->Generation < pOldest->Generation)
+                        {
+                            pOldest = pHead;
+                        }
+                    }
                 }
-                return CONTAINING_RECORD(ResidentObjectListHead.Flink, ManagedObject, ListEntry);
+                return pOldest ? CONTAINING_RECORD(pOldest->ObjectListHead.Flink, ManagedObject, ListEntry) : nullptr;
             }
 
-            LIST_ENTRY ResidentObjectListHead;
+            LIST_ENTRY ResidentBucketListHeads[NumPriorities];
+            LIST_ENTRY FreeBucketListHead;
             LIST_ENTRY EvictedObjectListHead;
 
             UINT32 NumResidentObjects;
             UINT32 NumEvictedObjects;
 
             UINT64 ResidentSize;
+
+            // Running totals of paging traffic, cleared when the statistics are reset
+            UINT64 BytesMadeResident;
+            UINT64 BytesEvicted;
+
+        private:
+            // Files the object under its class and sync point, at the oldest end of the class or the newest.
+            // Only the bucket at that end is a candidate, so this is constant time.
+            void AddResident(ManagedObject* pObject, bool AtHead)
+            {
+                RESIDENCY_CHECK(UINT32(pObject->Priority) < NumPriorities);
+                LIST_ENTRY* pListHead = &ResidentBucketListHeads[UINT32(pObject->Priority)];
+                LIST_ENTRY* pEnd = AtHead ? pListHead->Flink : pListHead->Blink;
+
+                LRUBucket* pBucket = (pEnd != pListHead) ? CONTAINING_RECORD(pEnd, LRUBucket, ListEntry) : nullptr;
+                if (pBucket == nullptr || pBucket->Generation != pObject->LastGPUSyncPoint)
+                {
+                    if (IsListEmpty(&FreeBucketListHead))
+                    {
+                        pBucket = new LRUBucket;
+                    }
+                    else
+                    {
+                        pBucket = CONTAINING_RECORD(Internal::RemoveHeadList(&FreeBucketListHead), LRUBucket, ListEntry);
+                    }
+
+                    pBucket->Generation = pObject->LastGPUSyncPoint;
+                    pBucket->LastUsedTimestamp = 0;
+                    pBucket->Size = 0;
+                    Internal::InitializeListHead(&pBucket->ObjectListHead);
+
+                    if (AtHead)
+                    {
+                        Internal::InsertHeadList(pListHead, &pBucket->ListEntry);
+                    }
+                    else
+                    {
+                        Internal::InsertTailList(pListHead, &pBucket->ListEntry);
+                    }
+                }
+
+                if (AtHead)
+                {
+                    Internal::InsertHeadList(&pBucket->ObjectListHead, &pObject->ListEntry);
+                }
+                else
+                {
+                    Internal::InsertTailList(&pBucket->ObjectListHead, &pObject->ListEntry);
+                }
+
+                pBucket->Size += pObject->Size;
+                pBucket->LastUsedTimestamp = RESIDENCY_MAX(pBucket->LastUsedTimestamp, pObject->LastUsedTimestamp);
+                pObject->pLRUBucket = pBucket;
+            }
+
+            void RemoveResident(ManagedObject* pObject)
+            {
+                LRUBucket* pBucket = pObject->pLRUBucket;
+                RESIDENCY_CHECK(pBucket != nullptr);
+
+                Internal::RemoveEntryList(&pObject->ListEntry);
+                pBucket->Size -= pObject->Size;
+                pObject->pLRUBucket = nullptr;
+
+                if (IsListEmpty(&pBucket->ObjectListHead))
+                {
+                    Internal::RemoveEntryList(&pBucket->ListEntry);
+                    Internal::InsertHeadList(&FreeBucketListHead, &pBucket->ListEntry);
+                }
+            }
+
+            static void FreeBuckets(LIST_ENTRY* pListHead)
+            {
+                while (IsListEmpty(pListHead) == false)
+                {
+                    delete CONTAINING_RECORD(Internal::RemoveHeadList(pListHead), LRUBucket, ListEntry);
+                }
+            }
         };
 
         class ResidencyManagerInternal
@@ -648,6 +1051,7 @@ namespace D3DX12Residency
         public:
             ResidencyManagerInternal(SyncManager* pSyncManagerIn) :
                 Device(nullptr),
+                Device1(nullptr),
                 AsyncThreadFence(1),
                 CompletionEvent(INVALID_HANDLE_VALUE),
                 AsyncThreadWorkCompletionEvent(INVALID_HANDLE_VALUE),
@@ -667,6 +1071,22 @@ namespace D3DX12Residency
                 AsyncWorkQueue(nullptr),
                 MaxSoftwareQueueLatency(6),
                 AsyncWorkQueueSize(7),
+                BackgroundEvictionEvent(INVALID_HANDLE_VALUE),
+                BackgroundEvictionThread(INVALID_HANDLE_VALUE),
+                FinishBackgroundEviction(false),
+                LastSampledUsage(-1),
+                AverageUsageGrowth(0.0),
+                cBackgroundEvictionInterval(100),
+                cUsageGrowthSmoothing(0.25),
+                cBackgroundEvictionTriggerThreshold(0.95f),
+                cBackgroundEvictionTargetThreshold(0.9f),
+                TicksPerSecond(1),
+                NumMakeResidentCalls(0),
+                MakeResidentTicks(0),
+                MaxMakeResidentTicks(0),
+                WaitForSyncPointTicks(0),
+                WaitForWorkerTicks(0),
+                BudgetHeadroom(0),
                 pSyncManager(pSyncManagerIn)
             {
                 Internal::InitializeListHead(&QueueFencesListHead);
@@ -676,10 +1096,16 @@ namespace D3DX12Residency
             };
 
             // NOTE: DeviceNodeIndex is an index not a mask. The majority of D3D12 uses bit masks to identify a GPU node whereas DXGI uses 0 based indices.
-            HRESULT Initialize(ID3D12Device* ParentDevice, UINT DeviceNodeIndex, IDXGIAdapter3* ParentAdapter, UINT32 MaxLatency)
+            HRESULT Initialize(ID3D12Device* ParentDevice, UINT DeviceNodeIndex, IDXGIAdapter3* ParentAdapter, UINT32 MaxLatency, UINT Flags)
             {
                 Device = ParentDevice;
                 NodeIndex = DeviceNodeIndex;
+
+                // Residency priorities are only passed on to the OS when the runtime supports them
+                if (FAILED(Device->QueryInterface(IID_PPV_ARGS(&Device1))))
+                {
+                    Device1 = nullptr;
+                }
                 Adapter = ParentAdapter;
                 MaxSoftwareQueueLatency = MaxLatency;
 
@@ -693,6 +1119,7 @@ namespace D3DX12Residency
 
                 LARGE_INTEGER Frequency;
                 QueryPerformanceFrequency(&Frequency);
+                TicksPerSecond = Frequency.QuadPart;
 
                 // Calculate how many QPC ticks are equivalent to the given time in seconds
                 MinEvictionGracePeriodTicks = UINT64(Frequency.QuadPart * cMinEvictionGracePeriod);
@@ -738,6 +1165,11 @@ namespace D3DX12Residency
                         hr = HRESULT_FROM_WIN32(GetLastError());
                     }
                 }
+
+                if (SUCCEEDED(hr) && (Flags & RESIDENCY_MANAGER_FLAG_BACKGROUND_EVICTION))
+                {
+                    hr = StartBackgroundEviction();
+                }
 #endif
 
                 return hr;
@@ -745,8 +1177,18 @@ namespace D3DX12Residency
 
             void Destroy()
             {
+#if !RESIDENCY_SINGLE_THREADED
+                StopBackgroundEviction();
+#endif
+
                 AsyncThreadFence.Destroy();
 
+                if (Device1)
+                {
+                    Device1->Release();
+                    Device1 = nullptr;
+                }
+
                 if (CompletionEvent != INVALID_HANDLE_VALUE)
                 {
                     CloseHandle(CompletionEvent);
@@ -814,6 +1256,11 @@ namespace D3DX12Residency
                     }
 
                     LRU.Insert(pObject);
+
+                    if (pObject->Priority != ManagedObject::RESIDENCY_PRIORITY::NORMAL)
+                    {
+                        ApplyResidencyPriority(pObject);
+                    }
                 }
             }
 
@@ -824,6 +1271,17 @@ namespace D3DX12Residency
                 LRU.Remove(pObject);
             }
 
+            void SetResidencyPriority(ManagedObject* pObject, ManagedObject::RESIDENCY_PRIORITY Priority)
+            {
+                Internal::ScopedLock Lock(&Mutex);
+
+                if (pObject->Priority != Priority)
+                {
+                    LRU.SetPriority(pObject, Priority);
+                    ApplyResidencyPriority(pObject);
+                }
+            }
+
             // One residency set per command-list
             HRESULT ExecuteCommandLists(ID3D12CommandQueue* Queue, ID3D12CommandList** CommandLists, ResidencySet** ResidencySets, UINT32 Count)
             {
@@ -845,7 +1303,46 @@ namespace D3DX12Residency
                 return hr;
             }
 
+            void GetStatistics(RESIDENCY_STATS* pStats, bool Reset)
+            {
+                Internal::ScopedLock Lock(&Mutex);
+
+                const double TicksToMilliseconds = 1000.0 / double(TicksPerSecond);
+
+                pStats->BytesMadeResident = LRU.BytesMadeResident;
+                pStats->BytesEvicted = LRU.BytesEvicted;
+                pStats->NumMakeResidentCalls = NumMakeResidentCalls;
+                pStats->MakeResidentTime = float(MakeResidentTicks * TicksToMilliseconds);
+                pStats->MaxMakeResidentTime = float(MaxMakeResidentTicks * TicksToMilliseconds);
+                pStats->WaitForSyncPointTime = float(WaitForSyncPointTicks * TicksToMilliseconds);
+                pStats->BudgetHeadroom = BudgetHeadroom;
+                pStats->ResidentSize = LRU.ResidentSize;
+
+                // The app thread adds to this one without taking the lock
+                const INT64 WorkerTicks = Reset ? InterlockedExchange64(&WaitForWorkerTicks, 0) : WaitForWorkerTicks;
+                pStats->WaitForWorkerTime = float(WorkerTicks * TicksToMilliseconds);
+
+                if (Reset)
+                {
+                    LRU.BytesMadeResident = 0;
+                    LRU.BytesEvicted = 0;
+                    NumMakeResidentCalls = 0;
+                    MakeResidentTicks = 0;
+                    MaxMakeResidentTicks = 0;
+                    WaitForSyncPointTicks = 0;
+                }
+            }
+
         private:
+            void ApplyResidencyPriority(ManagedObject* pObject)
+            {
+                if (Device1)
+                {
+                    const D3D12_RESIDENCY_PRIORITY Priority = GetD3D12ResidencyPriority(pObject->Priority);
+                    RESIDENCY_CHECK_RESULT(Device1->SetResidencyPriority(1, &pObject->pUnderlying, &Priority));
+                }
+            }
+
             HRESULT GetFence(ID3D12CommandQueue *Queue, Internal::Fence *&QueueFence)
             {
                 // We have to track each object on each queue so we know when it is safe to evict them. Therefore, for every queue that we
@@ -903,13 +1400,23 @@ namespace D3DX12Residency
                 }
 
                 CurrentSyncPointGeneration++;
+
+#if !RESIDENCY_SINGLE_THREADED
+                // Give the background thread a sample of the budget for every submission
+                if (BackgroundEvictionEvent != INVALID_HANDLE_VALUE)
+                {
+                    SetEvent(BackgroundEvictionEvent);
+                }
+#endif
                 return hr;
             }
 
+            // Command lists are packed in order into the largest groups whose combined working set fits in the budget,
+            // and each group is submitted on its own. A group's set stays open while it is built, so its command list
+            // slot marks the objects already in the group and each set is merged once. A set that doesn't fit is taken
+            // back out, which only touches the objects it added, and it starts the next group.
             HRESULT ExecuteSubset(ID3D12CommandQueue* Queue, ID3D12CommandList** CommandLists, ResidencySet** ResidencySets, UINT32 Count)
             {
-                HRESULT hr = S_OK;
-
                 DXGI_QUERY_VIDEO_MEMORY_INFO LocalMemory;
                 ZeroMemory(&LocalMemory, sizeof(LocalMemory));
                 GetCurrentBudget(&LocalMemory, DXGI_MEMORY_SEGMENT_GROUP_LOCAL);
@@ -918,9 +1425,10 @@ namespace D3DX12Residency
                 ZeroMemory(&NonLocalMemory, sizeof(NonLocalMemory));
                 GetCurrentBudget(&NonLocalMemory, DXGI_MEMORY_SEGMENT_GROUP_NON_LOCAL);
 
-                UINT64 TotalSizeNeeded = 0;
+                const UINT64 TotalBudget = LocalMemory.Budget + NonLocalMemory.Budget;
+                InterlockedExchange64(&BudgetHeadroom, INT64(TotalBudget) - INT64(LocalMemory.CurrentUsage + NonLocalMemory.CurrentUsage));
 
-                UINT32 MaxObjectsReferenced = 0;
+                UINT32 RemainingObjectsReferenced = 0;
                 for (UINT32 i = 0; i < Count; i++)
                 {
                     if (ResidencySets[i])
@@ -930,90 +1438,146 @@ namespace D3DX12Residency
                             // Residency Sets must be closed before execution just like Command Lists
                             return E_INVALIDARG;
                         }
-                        MaxObjectsReferenced += ResidencySets[i]->CurrentSetSize;
+                        RemainingObjectsReferenced += ResidencySets[i]->CurrentSetSize;
                     }
                 }
 
-                // Create a set to gather up all unique resources required by this call
-                ResidencySet* pMasterSet = new ResidencySet();
-                if (pMasterSet == nullptr || pMasterSet->Initialize(pSyncManager, MaxObjectsReferenced) == false)
+                Internal::Fence* QueueFence = nullptr;
+                HRESULT hr = GetFence(Queue, QueueFence);
+                if (FAILED(hr))
                 {
-                    return E_OUTOFMEMORY;
+                    return hr;
                 }
 
-                hr = pMasterSet->Open();
+                // Create a set to gather up all unique resources required by the first group
+                ResidencySet* pGroupSet = nullptr;
+                hr = OpenGroupSet(pGroupSet, RemainingObjectsReferenced);
                 if (FAILED(hr))
                 {
                     return hr;
                 }
 
-                // For each residency set
+                HRESULT Result = S_OK;
+                UINT32 GroupStart = 0;
+                UINT64 GroupSize = 0;
+
                 for (UINT32 i = 0; i < Count; i++)
                 {
-                    if (ResidencySets[i])
+                    const INT32 GroupSetSize = pGroupSet->CurrentSetSize;
+                    const UINT64 SizeAdded = InsertIntoGroup(pGroupSet, ResidencySets[i]);
+
+                    // If there is only one command list in the group there is nothing we can do
+                    if (i == GroupStart || GroupSize + SizeAdded <= TotalBudget)
                     {
-                        // For each object in this set
-                        for (INT32 x = 0; x < ResidencySets[i]->CurrentSetSize; x++)
+                        GroupSize += SizeAdded;
+                    }
+                    else
+                    {
+                        // Command list i doesn't fit, so submit the ones before it
+                        for (INT32 x = GroupSetSize; x < pGroupSet->CurrentSetSize; x++)
                         {
-                            if (pMasterSet->Insert(ResidencySets[i]->ppSet[x]))
-                            {
-                                TotalSizeNeeded += ResidencySets[i]->ppSet[x]->Size;
-                            }
+                            pGroupSet->Remove(pGroupSet->ppSet[x]);
                         }
+                        pGroupSet->CurrentSetSize = GroupSetSize;
+
+                        hr = SubmitGroup(Queue, QueueFence, &CommandLists[GroupStart], i - GroupStart, pGroupSet);
+                        if (FAILED(hr) && SUCCEEDED(Result))
+                        {
+                            Result = hr;
+                        }
+
+                        hr = OpenGroupSet(pGroupSet, RemainingObjectsReferenced);
+                        if (FAILED(hr))
+                        {
+                            return hr;
+                        }
+
+                        GroupStart = i;
+                        GroupSize = InsertIntoGroup(pGroupSet, ResidencySets[i]);
+                    }
+
+                    if (ResidencySets[i])
+                    {
+                        RemainingObjectsReferenced -= ResidencySets[i]->CurrentSetSize;
                     }
                 }
-                // Close this set to free it's slot up for the app
-                hr = pMasterSet->Close();
-                if (FAILED(hr))
+
+                hr = SubmitGroup(Queue, QueueFence, &CommandLists[GroupStart], Count - GroupStart, pGroupSet);
+                return FAILED(Result) ? Result : hr;
+            }
+
+            HRESULT OpenGroupSet(ResidencySet*& pGroupSet, UINT32 MaxObjectsReferenced)
+            {
+                pGroupSet = new ResidencySet();
+                if (pGroupSet == nullptr || pGroupSet->Initialize(pSyncManager, MaxObjectsReferenced) == false)
                 {
-                    return hr;
+                    delete(pGroupSet);
+                    pGroupSet = nullptr;
+                    return E_OUTOFMEMORY;
                 }
 
-                // This set of commandlists can't possibly fit within the budget, they need to be split up. If the number of command lists is 1 there is
-                // nothing we can do
-                if (Count > 1 && TotalSizeNeeded > LocalMemory.Budget + NonLocalMemory.Budget)
+                const HRESULT hr = pGroupSet->Open();
+                if (FAILED(hr))
                 {
-                    delete(pMasterSet);
-
-                    // Recursively try to find a small enough set to fit in memory
-                    const UINT32 Half = Count / 2;
-                    const HRESULT LowerHR = ExecuteSubset(Queue, CommandLists, ResidencySets, Half);
-                    const HRESULT UpperHR = ExecuteSubset(Queue, &CommandLists[Half], &ResidencySets[Half], Count - Half);
-
-                    return (LowerHR == S_OK && UpperHR == S_OK) ? S_OK : E_FAIL;
+                    delete(pGroupSet);
+                    pGroupSet = nullptr;
                 }
+                return hr;
+            }
 
+            // Returns the size of the objects in pSet that weren't in the group yet
+            UINT64 InsertIntoGroup(ResidencySet* pGroupSet, ResidencySet* pSet)
+            {
+                UINT64 SizeAdded = 0;
+                if (pSet)
+                {
+                    // For each object in this set
+                    for (INT32 x = 0; x < pSet->CurrentSetSize; x++)
+                    {
+                        if (pGroupSet->Insert(pSet->ppSet[x]))
+                        {
+                            SizeAdded += pSet->ppSet[x]->Size;
+                        }
+                    }
+                }
+                return SizeAdded;
+            }
 
-                Internal::Fence* QueueFence = nullptr;
-                hr = GetFence(Queue, QueueFence);
-
-                if (SUCCEEDED(hr))
+            // Takes ownership of pGroupSet, which holds every object the command lists reference
+            HRESULT SubmitGroup(ID3D12CommandQueue* Queue, Internal::Fence* QueueFence, ID3D12CommandList** CommandLists, UINT32 Count, ResidencySet* pGroupSet)
+            {
+                // Close this set to free it's slot up for the app
+                HRESULT hr = pGroupSet->Close();
+                if (FAILED(hr))
                 {
-                    // The following code must be atomic so that things get ordered correctly
+                    delete(pGroupSet);
+                    return hr;
+                }
 
-                    Internal::ScopedLock Lock(&ExecutionCS);
-                    // Evict or make resident all of the objects we identified above.
-                    // This will run on an async thread, allowing the current to continue while still blocking the GPU if required
-                    hr = EnqueueAsyncWork(pMasterSet, AsyncThreadFence.FenceValue, CurrentSyncPointGeneration);
+                // The following code must be atomic so that things get ordered correctly
+
+                Internal::ScopedLock Lock(&ExecutionCS);
+                // Evict or make resident all of the objects we identified above.
+                // This will run on an async thread, allowing the current to continue while still blocking the GPU if required
+                hr = EnqueueAsyncWork(pGroupSet, AsyncThreadFence.FenceValue, CurrentSyncPointGeneration);
 #if RESIDENCY_SINGLE_THREADED
-                    AsyncWorkload* pWorkload = DequeueAsyncWork();
-                    ProcessPagingWork(pWorkload);
+                AsyncWorkload* pWorkload = DequeueAsyncWork();
+                ProcessPagingWork(pWorkload);
 #endif
 
-                    // If there are some things that need to be made resident we need to make sure that the GPU
-                    // doesn't execute until the async thread signals that the MakeResident call has returned.
-                    if (SUCCEEDED(hr))
-                    {
-                        hr = AsyncThreadFence.GPUWait(Queue);
-                        AsyncThreadFence.Increment();
-                    }
+                // If there are some things that need to be made resident we need to make sure that the GPU
+                // doesn't execute until the async thread signals that the MakeResident call has returned.
+                if (SUCCEEDED(hr))
+                {
+                    hr = AsyncThreadFence.GPUWait(Queue);
+                    AsyncThreadFence.Increment();
+                }
 
-                    Queue->ExecuteCommandLists(Count, CommandLists);
+                Queue->ExecuteCommandLists(Count, CommandLists);
 
-                    if (SUCCEEDED(hr))
-                    {
-                        hr = SignalFence(Queue, QueueFence);
-                    }
+                if (SUCCEEDED(hr))
+                {
+                    hr = SignalFence(Queue, QueueFence);
                 }
                 return hr;
             }
@@ -1082,6 +1646,131 @@ namespace D3DX12Residency
                 return 0;
             }
 
+            HANDLE BackgroundEvictionEvent;
+            HANDLE BackgroundEvictionThread;
+            volatile bool FinishBackgroundEviction;
+
+            // Only touched by the background thread
+            INT64 LastSampledUsage;
+            double AverageUsageGrowth;
+
+            HRESULT StartBackgroundEviction()
+            {
+                BackgroundEvictionEvent = CreateEvent(nullptr, false, false, nullptr);
+                if (BackgroundEvictionEvent == nullptr)
+                {
+                    BackgroundEvictionEvent = INVALID_HANDLE_VALUE;
+                    return HRESULT_FROM_WIN32(GetLastError());
+                }
+
+                BackgroundEvictionThread = CreateThread(nullptr, 0, BackgroundEvictionThreadStart, (void*) this, 0, nullptr);
+                if (BackgroundEvictionThread == nullptr)
+                {
+                    BackgroundEvictionThread = INVALID_HANDLE_VALUE;
+                    return HRESULT_FROM_WIN32(GetLastError());
+                }
+
+                // Trimming is never urgent, it must not compete with the app's own threads
+                SetThreadPriority(BackgroundEvictionThread, THREAD_PRIORITY_LOWEST);
+                return S_OK;
+            }
+
+            void StopBackgroundEviction()
+            {
+                if (BackgroundEvictionThread != INVALID_HANDLE_VALUE)
+                {
+                    FinishBackgroundEviction = true;
+                    if (SetEvent(BackgroundEvictionEvent) == false)
+                    {
+                        RESIDENCY_CHECK_RESULT(HRESULT_FROM_WIN32(GetLastError()));
+                    }
+
+                    WaitForSingleObject(BackgroundEvictionThread, INFINITE);
+                    CloseHandle(BackgroundEvictionThread);
+                    BackgroundEvictionThread = INVALID_HANDLE_VALUE;
+                }
+
+                if (BackgroundEvictionEvent != INVALID_HANDLE_VALUE)
+                {
+                    CloseHandle(BackgroundEvictionEvent);
+                    BackgroundEvictionEvent = INVALID_HANDLE_VALUE;
+                }
+            }
+
+            static unsigned long WINAPI BackgroundEvictionThreadStart(void* pData)
+            {
+                ResidencyManagerInternal* pManager = (ResidencyManagerInternal*)pData;
+
+                while (1)
+                {
+                    // Woken on every submission, and periodically so that memory used by other processes is still noticed
+                    WaitForSingleObject(pManager->BackgroundEvictionEvent, pManager->cBackgroundEvictionInterval);
+
+                    if (pManager->FinishBackgroundEviction)
+                    {
+                        return 0;
+                    }
+
+                    pManager->ProcessBackgroundEviction();
+                }
+
+                return 0;
+            }
+
+            // Predicts the memory usage a few submissions ahead from the recent trend and, if that would cross the
+            // budget, evicts the least recently used objects the GPU is done with. This keeps space free so that
+            // ProcessPagingWork rarely has to wait on the GPU and trim inline before it can call MakeResident.
+            void ProcessBackgroundEviction()
+            {
+                DXGI_QUERY_VIDEO_MEMORY_INFO LocalMemory;
+                ZeroMemory(&LocalMemory, sizeof(LocalMemory));
+                GetCurrentBudget(&LocalMemory, DXGI_MEMORY_SEGMENT_GROUP_LOCAL);
+
+                DXGI_QUERY_VIDEO_MEMORY_INFO NonLocalMemory;
+                ZeroMemory(&NonLocalMemory, sizeof(NonLocalMemory));
+                GetCurrentBudget(&NonLocalMemory, DXGI_MEMORY_SEGMENT_GROUP_NON_LOCAL);
+
+                const INT64 TotalUsage = LocalMemory.CurrentUsage + NonLocalMemory.CurrentUsage;
+                const INT64 TotalBudget = LocalMemory.Budget + NonLocalMemory.Budget;
+
+                if (LastSampledUsage >= 0)
+                {
+                    const double Growth = double(TotalUsage - LastSampledUsage);
+                    AverageUsageGrowth += (Growth - AverageUsageGrowth) * cUsageGrowthSmoothing;
+                }
+                LastSampledUsage = TotalUsage;
+
+                // The worker thread can be up to MaxSoftwareQueueLatency submissions behind, each of which may grow usage further
+                const INT64 PredictedUsage = TotalUsage + INT64(RESIDENCY_MAX(AverageUsageGrowth, 0.0) * MaxSoftwareQueueLatency);
+                if (PredictedUsage < INT64(TotalBudget * cBackgroundEvictionTriggerThreshold))
+                {
+                    return;
+                }
+
+                // Read the generation before looking at the in flight sync points. A sync point is queued before the generation
+                // is advanced, so if none are outstanding every generation before this one has completed.
+                const UINT64 Generation = CurrentSyncPointGeneration;
+                const UINT64 FirstUncompletedGeneration = GetFirstUncompletedSyncPointGeneration(Generation);
+                if (FirstUncompletedGeneration == 0)
+                {
+                    return;
+                }
+
+                Internal::ScopedLock Lock(&Mutex);
+
+                ID3D12Pageable** pEvictionList = new ID3D12Pageable*[LRU.NumResidentObjects];
+                UINT32 NumObjectsToEvict = 0;
+
+                LRU.TrimToSyncPointInclusive(PredictedUsage, INT64(TotalBudget * cBackgroundEvictionTargetThreshold), pEvictionList, NumObjectsToEvict, FirstUncompletedGeneration - 1);
+
+                if (NumObjectsToEvict)
+                {
+                    RESIDENCY_CHECK_RESULT(Device->Evict(NumObjectsToEvict, pEvictionList));
+                }
+
+                delete[](pEvictionList);
+            }
+
             // This will be run from a worker thread and will emulate a software queue for making gpu resources resident or evicted.
             // The GPU will be synchronized by this queue to ensure that it never executes using an evicted resource.
             void ProcessPagingWork(AsyncWorkload* pWork)
@@ -1134,6 +1823,34 @@ namespace D3DX12Residency
                         LRU.ObjectReferenced(pObject);
                     }
 
+                    // Make the highest priority objects resident first, so that if the budget runs out part way through
+                    // it is the low priority objects that wait for the GPU to free up space
+                    if (NumObjectsToMakeResident > 1)
+                    {
+                        UINT32 ClassOffsets[LRUCache::NumPriorities] = {};
+                        for (UINT32 i = 0; i < NumObjectsToMakeResident; i++)
+                        {
+                            ClassOffsets[UINT32(pMakeResidentList[i].pManagedObject->Priority)]++;
+                        }
+
+                        UINT32 Offset = 0;
+                        for (INT32 c = LRUCache::NumPriorities - 1; c >= 0; c--)
+                        {
+                            const UINT32 Count = ClassOffsets[c];
+                            ClassOffsets[c] = Offset;
+                            Offset += Count;
+                        }
+
+                        ResidentScratchSpace* pSortedList = new ResidentScratchSpace[NumObjectsToMakeResident];
+                        for (UINT32 i = 0; i < NumObjectsToMakeResident; i++)
+                        {
+                            pSortedList[ClassOffsets[UINT32(pMakeResidentList[i].pManagedObject->Priority)]++] = pMakeResidentList[i];
+                        }
+
+                        delete[](pMakeResidentList);
+                        pMakeResidentList = pSortedList;
+                    }
+
                     DXGI_QUERY_VIDEO_MEMORY_INFO LocalMemory;
                     ZeroMemory(&LocalMemory, sizeof(LocalMemory));
                     GetCurrentBudget(&LocalMemory, DXGI_MEMORY_SEGMENT_GROUP_LOCAL);
@@ -1191,7 +1908,7 @@ namespace D3DX12Residency
                                     }
                                 }
 
-                                hr = Device->MakeResident(NumObjectsInBatch, &pMakeResidentList[BatchStart].pUnderlying);
+                                hr = TimedMakeResident(NumObjectsInBatch, &pMakeResidentList[BatchStart].pUnderlying);
                                 if (SUCCEEDED(hr))
                                 {
                                     SizeToMakeResident -= BatchSize;
@@ -1219,7 +1936,7 @@ namespace D3DX12Residency
                                         pMakeResidentList[i].pUnderlying = pMakeResidentList[i].pManagedObject->pUnderlying;
                                     }
 
-                                    hr = Device->MakeResident(NumObjects, &pMakeResidentList[MakeResidentIndex].pUnderlying);
+                                    hr = TimedMakeResident(NumObjects, &pMakeResidentList[MakeResidentIndex].pUnderlying);
                                     if (FAILED(hr))
                                     {
                                         // TODO: What should we do if this fails? This is a catastrophic failure in which the app is trying to use more memory
@@ -1238,7 +1955,11 @@ namespace D3DX12Residency
                                     GenerationToWaitFor -= 1;
                                 }
                                 // Wait until the GPU is done
+                                LARGE_INTEGER WaitStart, WaitEnd;
+                                QueryPerformanceCounter(&WaitStart);
                                 WaitForSyncPoint(GenerationToWaitFor);
+                                QueryPerformanceCounter(&WaitEnd);
+                                WaitForSyncPointTicks += WaitEnd.QuadPart - WaitStart.QuadPart;
 
                                 LRU.TrimToSyncPointInclusive(TotalUsage + INT64(SizeToMakeResident), TotalBudget, pEvictionList, NumObjectsToEvict, GenerationToWaitFor);
 
@@ -1267,9 +1988,16 @@ namespace D3DX12Residency
             HRESULT EnqueueAsyncWork(ResidencySet* pMasterSet, UINT64 FenceValueToSignal, UINT64 SyncPointGeneration)
             {
                 // We can't get too far ahead of the worker thread otherwise huge hitches occur
-                while ((CurrentAsyncWorkloadTail - CurrentAsyncWorkloadHead) >= MaxSoftwareQueueLatency)
+                if ((CurrentAsyncWorkloadTail - CurrentAsyncWorkloadHead) >= MaxSoftwareQueueLatency)
                 {
-                    WaitForSingleObject(AsyncThreadWorkCompletionEvent, INFINITE);
+                    LARGE_INTEGER WaitStart, WaitEnd;
+                    QueryPerformanceCounter(&WaitStart);
+                    while ((CurrentAsyncWorkloadTail - CurrentAsyncWorkloadHead) >= MaxSoftwareQueueLatency)
+                    {
+                        WaitForSingleObject(AsyncThreadWorkCompletionEvent, INFINITE);
+                    }
+                    QueryPerformanceCounter(&WaitEnd);
+                    InterlockedExchangeAdd64(&WaitForWorkerTicks, WaitEnd.QuadPart - WaitStart.QuadPart);
                 }
 
                 RESIDENCY_CHECK(CurrentAsyncWorkloadTail >= CurrentAsyncWorkloadHead);
@@ -1302,6 +2030,21 @@ namespace D3DX12Residency
                 return pWork;
             }
 
+            // Must be called with Mutex held
+            HRESULT TimedMakeResident(UINT32 NumObjects, ID3D12Pageable* const* ppObjects)
+            {
+                LARGE_INTEGER Start, End;
+                QueryPerformanceCounter(&Start);
+                const HRESULT hr = Device->MakeResident(NumObjects, ppObjects);
+                QueryPerformanceCounter(&End);
+
+                const INT64 Ticks = End.QuadPart - Start.QuadPart;
+                MakeResidentTicks += Ticks;
+                MaxMakeResidentTicks = RESIDENCY_MAX(MaxMakeResidentTicks, Ticks);
+                NumMakeResidentCalls++;
+                return hr;
+            }
+
             void GetCurrentBudget(DXGI_QUERY_VIDEO_MEMORY_INFO* InfoOut, DXGI_MEMORY_SEGMENT_GROUP Segment)
             {
                 RESIDENCY_CHECK_RESULT(Adapter->QueryVideoMemoryInfo(NodeIndex, Segment, InfoOut));
@@ -1336,6 +2079,26 @@ namespace D3DX12Residency
                 return S_OK;
             }
 
+            // Unlike DequeueCompletedSyncPoints this leaves the list untouched, the worker thread may be holding on to
+            // one of its sync points
+            UINT64 GetFirstUncompletedSyncPointGeneration(UINT64 AllCompletedGeneration)
+            {
+                Internal::ScopedLock Lock(&AsyncWorkMutex);
+
+                LIST_ENTRY* pPointEntry = InFlightSyncPointsHead.Flink;
+                while (pPointEntry != &InFlightSyncPointsHead)
+                {
+                    Internal::DeviceWideSyncPoint* pPoint = CONTAINING_RECORD(pPointEntry, Internal::DeviceWideSyncPoint, ListEntry);
+                    if (pPoint->IsCompleted() == false)
+                    {
+                        return pPoint->GenerationID;
+                    }
+                    pPointEntry = pPointEntry->Flink;
+                }
+
+                return AllCompletedGeneration;
+            }
+
             // Returns a pointer to the first synch point which is not completed
             Internal::DeviceWideSyncPoint* DequeueCompletedSyncPoints()
             {
@@ -1426,6 +2189,7 @@ namespace D3DX12Residency
             HANDLE AsyncThreadWorkCompletionEvent;
 
             ID3D12Device* Device;
+            ID3D12Device1* Device1;
             // NOTE: This is an index not a mask. The majority of D3D12 uses bit masks to identify a GPU node whereas DXGI uses 0 based indices.
             UINT NodeIndex;
             IDXGIAdapter3* Adapter;
@@ -1448,6 +2212,24 @@ namespace D3DX12Residency
             UINT32 MaxSoftwareQueueLatency;
             INT64 ResidencyManagerUniqueID;
 
+            // How long the background thread sleeps if no work is submitted, in milliseconds
+            const DWORD cBackgroundEvictionInterval;
+            // Weight of the newest sample in the moving average of usage growth per submission
+            const double cUsageGrowthSmoothing;
+            // Background eviction starts when the predicted usage crosses this % of the budget and trims it down
+            // to the target % (valid between 0.0 - 1.0)
+            const float cBackgroundEvictionTriggerThreshold;
+            const float cBackgroundEvictionTargetThreshold;
+
+            // Statistics. Everything but the last two is protected by Mutex.
+            INT64 TicksPerSecond;
+            UINT32 NumMakeResidentCalls;
+            INT64 MakeResidentTicks;
+            INT64 MaxMakeResidentTicks;
+            INT64 WaitForSyncPointTicks;
+            volatile INT64 WaitForWorkerTicks;
+            volatile INT64 BudgetHeadroom;
+
             SyncManager* pSyncManager;
         };
     }
@@ -1461,9 +2243,10 @@ namespace D3DX12Residency
         }
 
         // NOTE: DeviceNodeIndex is an index not a mask. The majority of D3D12 uses bit masks to identify a GPU node whereas DXGI uses 0 based indices.
-        FORCEINLINE HRESULT Initialize(ID3D12Device* ParentDevice, UINT DeviceNodeIndex, IDXGIAdapter3* ParentAdapter, UINT32 MaxLatency)
+        // Flags is a combination of RESIDENCY_MANAGER_FLAGS
+        FORCEINLINE HRESULT Initialize(ID3D12Device* ParentDevice, UINT DeviceNodeIndex, IDXGIAdapter3* ParentAdapter, UINT32 MaxLatency, UINT Flags = RESIDENCY_MANAGER_FLAG_NONE)
         {
-            return Manager.Initialize(ParentDevice, DeviceNodeIndex, ParentAdapter, MaxLatency);
+            return Manager.Initialize(ParentDevice, DeviceNodeIndex, ParentAdapter, MaxLatency, Flags);
         }
 
         FORCEINLINE void Destroy()
@@ -1481,6 +2264,12 @@ namespace D3DX12Residency
             Manager.EndTrackingObject(pObject);
         }
 
+        // Moves a tracked object to another priority class and passes the matching priority on to the OS
+        FORCEINLINE void SetResidencyPriority(ManagedObject* pObject, ManagedObject::RESIDENCY_PRIORITY Priority)
+        {
+            Manager.SetResidencyPriority(pObject, Priority);
+        }
+
         HRESULT GetCurrentGPUSyncPoint(ID3D12CommandQueue* Queue, UINT64 *pCurrentGPUSyncPoint)
         {
             return Manager.GetCurrentGPUSyncPoint(Queue, pCurrentGPUSyncPoint);
@@ -1508,6 +2297,30 @@ namespace D3DX12Residency
             delete(pSet);
         }
 
+        // NumThreads is the number of threads that may insert into the set while it is open
+        FORCEINLINE ConcurrentResidencySet* CreateConcurrentResidencySet(UINT32 NumThreads)
+        {
+            ConcurrentResidencySet* pSet = new ConcurrentResidencySet();
+
+            if (pSet && pSet->Initialize(&SyncManager, NumThreads) == false)
+            {
+                delete(pSet);
+                pSet = nullptr;
+            }
+            return pSet;
+        }
+
+        FORCEINLINE void DestroyResidencySet(ConcurrentResidencySet* pSet)
+        {
+            delete(pSet);
+        }
+
+        // Reports paging activity since the last reset. Calling this once a frame with Reset = true gives per frame numbers.
+        FORCEINLINE void GetStatistics(RESIDENCY_STATS* pStats, bool Reset = true)
+        {
+            Manager.GetStatistics(pStats, Reset);
+        }
+
     private:
         Internal::ResidencyManagerInternal Manager;
         Internal::SyncManager SyncManager;
@@ -200,6 +200,47 @@ void Context::WaitForAllFrames()
     }
 }
 
+//
+// Retires every active frame that has already completed on the GPU, without waiting on
+// any frame that is still running.
+//
+void Context::RetireCompletedFrames()
+{
+    UINT64 CompletedFence = m_pFenceObject->GetCompletedValue();
+
+    while (!IsListEmpty(&m_ActiveFrameListHead))
+    {
+        Frame* pFrame = static_cast<Frame*>(m_ActiveFrameListHead.Flink);
+        if (pFrame->CompletionFence > CompletedFence)
+        {
+            break;
+        }
+
+        RetireFrameInternal(pFrame);
+    }
+}
+
+//
+// Signals the specified event once the oldest active frame completes on the GPU. The
+// event is signaled immediately if there are no active frames.
+//
+void Context::SetEventOnFrameCompletion(HANDLE hEvent)
+{
+    if (IsListEmpty(&m_ActiveFrameListHead))
+    {
+        SetEvent(hEvent);
+        return;
+    }
+
+    Frame* pFrame = static_cast<Frame*>(m_ActiveFrameListHead.Flink);
+    HRESULT hr = m_pFenceObject->SetEventOnCompletion(pFrame->CompletionFence, hEvent);
+    if (FAILED(hr))
+    {
+        LOG_WARNING("Failed to set frame completion event, hr=0x%.8x", hr);
+        SetEvent(hEvent);
+    }
+}
+
 HRESULT Context::InitializeFrame(Frame* pFrame, D3D12_COMMAND_LIST_TYPE Type)
 {
     HRESULT hr;
@@ -92,6 +92,8 @@ public:
     void WaitForFence(UINT64 Fence);
     void WaitForSingleFrame();
     void WaitForAllFrames();
+    void RetireCompletedFrames();
+    void SetEventOnFrameCompletion(HANDLE hEvent);
 
     void Flush();
 
@@ -37,6 +37,20 @@
 //
 #define PREFETCH_DISTANCE 600.0f
 
+//
+// The number of frames ahead that the camera motion is extrapolated when predicting which
+// images to prefetch, and the weight given to the most recent frame when smoothing the
+// camera velocity.
+//
+#define PREFETCH_LOOKAHEAD_FRAMES 30.0f
+#define PREFETCH_VELOCITY_SMOOTHING 0.25f
+
+//
+// The relative change in priority score required to notify the paging thread, which
+// prevents every image from being reprioritized on each frame of camera movement.
+//
+#define PRIORITY_SCORE_TOLERANCE 0.25f
+
 //
 // Helper function to calculate an average for a numbe rof statistic points.
 //
@@ -485,7 +499,37 @@ bool D3D12MemoryManagement::HandleMessage(HWND hwnd, UINT Message, WPARAM wParam
     return false;
 }
 
-void D3D12MemoryManagement::CalculateImagePagingData(const RectF* pViewportBounds, const Image* pImage, UINT8* pVisibleMip, UINT8* pPrefetchMip)
+//
+// Extrapolates the scene bounds along the current camera motion. Each edge of the bounds
+// is tracked separately, so both panning and zooming out extend the prediction in the
+// direction the viewport is growing. The returned bounds cover the whole path from the
+// current viewport to the predicted one.
+//
+RectF D3D12MemoryManagement::PredictSceneBounds(const RectF& SceneBounds)
+{
+    if (!m_bPreviousSceneBoundsValid)
+    {
+        m_PreviousSceneBounds = SceneBounds;
+        m_bPreviousSceneBoundsValid = true;
+    }
+
+    const float Smoothing = PREFETCH_VELOCITY_SMOOTHING;
+    m_SceneBoundsVelocity.Left += (SceneBounds.Left - m_PreviousSceneBounds.Left - m_SceneBoundsVelocity.Left) * Smoothing;
+    m_SceneBoundsVelocity.Top += (SceneBounds.Top - m_PreviousSceneBounds.Top - m_SceneBoundsVelocity.Top) * Smoothing;
+    m_SceneBoundsVelocity.Right += (SceneBounds.Right - m_PreviousSceneBounds.Right - m_SceneBoundsVelocity.Right) * Smoothing;
+    m_SceneBoundsVelocity.Bottom += (SceneBounds.Bottom - m_PreviousSceneBounds.Bottom - m_SceneBoundsVelocity.Bottom) * Smoothing;
+    m_PreviousSceneBounds = SceneBounds;
+
+    RectF PredictedBounds;
+    PredictedBounds.Left = min(SceneBounds.Left, SceneBounds.Left + m_SceneBoundsVelocity.Left * PREFETCH_LOOKAHEAD_FRAMES);
+    PredictedBounds.Top = min(SceneBounds.Top, SceneBounds.Top + m_SceneBoundsVelocity.Top * PREFETCH_LOOKAHEAD_FRAMES);
+    PredictedBounds.Right = max(SceneBounds.Right, SceneBounds.Right + m_SceneBoundsVelocity.Right * PREFETCH_LOOKAHEAD_FRAMES);
+    PredictedBounds.Bottom = max(SceneBounds.Bottom, SceneBounds.Bottom + m_SceneBoundsVelocity.Bottom * PREFETCH_LOOKAHEAD_FRAMES);
+
+    return PredictedBounds;
+}
+
+void D3D12MemoryManagement::CalculateImagePagingData(const RectF* pViewportBounds, const RectF* pPredictedBounds, const Image* pImage, UINT8* pVisibleMip, UINT8* pPrefetchMip, float* pPriorityScore)
 {
     float ImageScale = (pImage->Bounds.Right - pImage->Bounds.Left) * m_pSceneCamera->GetZoom();
     UINT8 RequiredMip = (UINT8)CalculateRequiredMipLevel(pImage->pResource, ImageScale);
@@ -495,11 +539,22 @@ void D3D12MemoryManagement::CalculateImagePagingData(const RectF* pViewportBound
     // or prefetchable mipmap index for this resource. This is used to determine the
     // priority which the paging thread will stream in the resources. Visible mipmaps
     // have a higher priority than prefetched ones, and prefetched mipmaps are higher
-    // priority than all others.
+    // priority than all others. The prefetch zone is measured from the predicted bounds,
+    // so images the camera is moving towards are streamed in before they are reached.
     //
     float ScaledPrefetchDistance = PREFETCH_DISTANCE / m_pSceneCamera->GetZoom();
     bool IsVisible = RectIntersects(*pViewportBounds, pImage->Bounds);
-    bool IsNearlyVisible = RectNearlyIntersects(*pViewportBounds, pImage->Bounds, ScaledPrefetchDistance);
+    bool IsNearlyVisible = RectNearlyIntersects(*pPredictedBounds, pImage->Bounds, ScaledPrefetchDistance);
+
+    //
+    // The priority score orders resources within a paging priority. Larger images are
+    // preferred since they are the most noticeable, and the score falls off with the
+    // distance (in screen pixels) from the predicted bounds.
+    //
+    float DistanceX = max(0.0f, max(pPredictedBounds->Left - pImage->Bounds.Right, pImage->Bounds.Left - pPredictedBounds->Right));
+    float DistanceY = max(0.0f, max(pPredictedBounds->Top - pImage->Bounds.Bottom, pImage->Bounds.Top - pPredictedBounds->Bottom));
+    float Falloff = 1.0f + (DistanceX + DistanceY) * m_pSceneCamera->GetZoom() / PREFETCH_DISTANCE;
+    *pPriorityScore = ImageScale / (Falloff * Falloff);
 
     UINT8 VisibleMip;
     UINT8 PrefetchMip;
@@ -527,6 +582,7 @@ void D3D12MemoryManagement::CalculateImagePagingData(const RectF* pViewportBound
 HRESULT D3D12MemoryManagement::RenderScene(const RectF& ViewportBounds)
 {
     RectF SceneBounds = m_pSceneCamera->GenerateViewportBounds();
+    RectF PredictedBounds = PredictSceneBounds(SceneBounds);
 
     for (auto& Img : m_Images)
     {
@@ -537,16 +593,19 @@ HRESULT D3D12MemoryManagement::RenderScene(const RectF& ViewportBounds)
         //
         UINT8 VisibleMip;
         UINT8 PrefetchMip;
-        CalculateImagePagingData(&SceneBounds, &Img, &VisibleMip, &PrefetchMip);
+        float PriorityScore;
+        CalculateImagePagingData(&SceneBounds, &PredictedBounds, &Img, &VisibleMip, &PrefetchMip, &PriorityScore);
 
         //
-        // If the visibility or prefetch values have changed, notify the paging thread
-        // so it can update this resource's priority.
+        // If the visibility or prefetch values have changed, or the priority score changed
+        // significantly, notify the paging thread so it can update this resource's priority.
         //
-        if (pResource->VisibleMip != VisibleMip || pResource->PrefetchMip != PrefetchMip)
+        bool ScoreChanged = fabsf(PriorityScore - pResource->PriorityScore) > pResource->PriorityScore * PRIORITY_SCORE_TOLERANCE;
+        if (pResource->VisibleMip != VisibleMip || pResource->PrefetchMip != PrefetchMip || ScoreChanged)
         {
             pResource->VisibleMip = VisibleMip;
             pResource->PrefetchMip = PrefetchMip;
+            pResource->PriorityScore = PriorityScore;
             NotifyPagingWork(pResource);
         }
 
@@ -617,6 +676,12 @@ HRESULT D3D12MemoryManagement::RenderScene(const RectF& ViewportBounds)
         pColor = &ViewportColor;
 
         DrawRectangle(&SceneBounds, Thickness, pColor);
+
+        //
+        // Outline the bounds predicted from the camera motion, which extend the prefetch zone.
+        //
+        ColorF PredictedColor = { 1.0f, 1.0f, 0.0f, 0.5f };
+        DrawRectangle(&PredictedBounds, 2 / m_ViewportCamera.GetZoom(), &PredictedColor);
     }
 
     return S_OK;
@@ -665,6 +730,7 @@ HRESULT D3D12MemoryManagement::RenderUI()
             float StatTimeBetweenFrames = AverageStatistics(m_StatTimeBetweenFrames, STATISTIC_COUNT);
             float StatRenderScene = AverageStatistics(m_StatRenderScene, STATISTIC_COUNT);
             float StatRenderUI = AverageStatistics(m_StatRenderUI, STATISTIC_COUNT);
+            PagingStatistics PagingStats = GetPagingStatistics();
 
             m_pTextFormat->SetTextAlignment(DWRITE_TEXT_ALIGNMENT_LEADING);
             m_pTextFormat->SetParagraphAlignment(DWRITE_PARAGRAPH_ALIGNMENT_NEAR);
@@ -676,12 +742,21 @@ HRESULT D3D12MemoryManagement::RenderUI()
                 L"Glitch Count: %d\n"
                 L"\n"
                 L"RenderScene: %.2f ms\n"
-                L"RenderUI: %.2f ms",
+                L"RenderUI: %.2f ms\n"
+                L"\n"
+                L"Paging reads: %.1f MB/s\n"
+                L"Read latency: %.2f ms\n"
+                L"Reads: %d/%d (%d threads)",
                 (UINT)(1.0f / StatTimeBetweenFrames),
                 StatTimeBetweenFrames * 1000.0f,
                 GetGlitchCount(),
                 StatRenderScene * 1000.0f,
-                StatRenderUI * 1000.0f);
+                StatRenderUI * 1000.0f,
+                PagingStats.ReadThroughput,
+                PagingStats.AverageReadLatency,
+                PagingStats.ReadsOutstanding,
+                PagingStats.ReadQueueDepth,
+                PagingStats.ReadThreadCount);
 
             m_pD2DContext->DrawTextW(
                 FPSString,
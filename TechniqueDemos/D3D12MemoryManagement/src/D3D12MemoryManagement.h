@@ -55,6 +55,13 @@ private:
     UINT32 m_CurrentGraphPoint = 0;
     UINT64 m_GraphPoints[NUM_GRAPH_POINTS];
 
+    //
+    // Predictive prefetching
+    //
+    RectF m_PreviousSceneBounds = {};
+    RectF m_SceneBoundsVelocity = {};
+    bool m_bPreviousSceneBoundsValid = false;
+
     bool m_bDrawMipColors = false;
     bool m_bSimulateDeviceRemoved = false;
     bool m_bFullscreen = false;
@@ -80,11 +87,14 @@ protected:
     HRESULT GenerateMemoryGraphGeometry(const RectF& Bounds, UINT GraphSizeMB, ID2D1PathGeometry** ppPathGeometry);
     void RenderMemoryGraph();
 
+    RectF PredictSceneBounds(const RectF& SceneBounds);
     void CalculateImagePagingData(
         const RectF* pViewportBounds,
+        const RectF* pPredictedBounds,
         const Image* pImage,
         UINT8* pVisibleMip,
-        UINT8* pPrefetchMip);
+        UINT8* pPrefetchMip,
+        float* pPriorityScore);
 
 public:
     D3D12MemoryManagement();
@@ -631,7 +631,7 @@ HRESULT DX12Framework::CreateDeviceDependentStateInternal()
     //
     try
     {
-        m_pWorkerThread = new PagingWorkerThread(this);
+        m_pWorkerThread = new PagingWorkerThread(this, m_PagingReadThreadCount, m_PagingReadQueueDepth);
     }
     catch (std::bad_alloc&)
     {
@@ -852,7 +852,7 @@ HRESULT DX12Framework::InitDynamicBuffer(DynamicBuffer* pBuffer)
     }
 
     pBuffer->m_pBuffer = pNewBuffer;
-    pBuffer->m_pCurrentAddress = pNewBuffer->pBaseAddress;
+    pBuffer->m_CurrentOffset = 0;
 
     return S_OK;
 }
@@ -1753,6 +1753,10 @@ HRESULT DX12Framework::LoadMip(Resource* pResource, UINT32 Mip)
     }
     else
     {
+        //
+        // Each read owns its upload buffer, so it can be decoded by a read thread and remain
+        // in flight while other mipmaps are read and transferred.
+        //
         hr = m_pDevice->CreateCommittedResource(
             &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
             D3D12_HEAP_FLAG_NONE,
@@ -1822,102 +1826,61 @@ HRESULT DX12Framework::LoadMip(Resource* pResource, UINT32 Mip)
     }
 
     //
-    // Copy the pixel data into the staging resource, and then transfer it to the
-    // reserved resource via CopyTextureRegion.
+    // Describe the pixel data to copy into the staging resource, which is then transferred
+    // to the reserved resource via CopyTextureRegion.
     //
-    D3D12_PLACED_SUBRESOURCE_FOOTPRINT Layout;
+    PagingRequest Request = {};
+    Request.pResource = pResource;
+    Request.Mip = static_cast<UINT8>(Mip);
+    Request.pDdsFrame = pDdsFrame;
+    Request.pSourceBitmap = pSourceBitmap;
+    Request.FrameInfo = MipFrameInfo;
+    Request.pUploadBuffer = pUploadBuffer;
+    Request.pUploadData = pUploadData;
 
-    UINT NumRows;
     UINT64 RowSizeInBytes;
-    UINT64 TotalBytes;
     D3D12_RESOURCE_DESC Desc = pResource->pDeviceState->pD3DResource->GetDesc();
-    m_pDevice->GetCopyableFootprints(&Desc, Mip, 1, 0, &Layout, &NumRows, &RowSizeInBytes, &TotalBytes);
-    UINT64 RemainingBytes = TotalBytes;
+    m_pDevice->GetCopyableFootprints(&Desc, Mip, 1, 0, &Request.Layout, &Request.NumRows, &RowSizeInBytes, &Request.TotalBytes);
+
+    if (!m_bUseSharedStagingSurface)
+    {
+        //
+        // Reading the pixel data is left to the paging read threads, so several mipmaps
+        // can be read at once. The mipmap is transferred once its read completes.
+        //
+        return m_pWorkerThread->QueueRead(Request);
+    }
 
+    UINT64 RemainingBytes = Request.TotalBytes;
     UINT32 CurrentRow = 0;
 
     while (RemainingBytes > 0)
     {
-        UINT32 MaxTransferHeightInBlocks;
-
         //
         // Begin a paging frame. Each paging operation (i.e. a copy/transfer) must be contained
         // within a paging frame so we can track and synchronize the operation on the context.
         //
         m_PagingContext.Begin();
 
-        UINT64 BytesInTransfer;
-        if (m_bUseSharedStagingSurface)
-        {
-            MaxTransferHeightInBlocks = static_cast<UINT32>(MAX_TRANSFER_SIZE / Layout.Footprint.RowPitch);
-            BytesInTransfer = min(MAX_TRANSFER_SIZE, RemainingBytes);
-        }
-        else
-        {
-            MaxTransferHeightInBlocks = NumRows;
-            BytesInTransfer = RemainingBytes;
-        }
+        UINT32 MaxTransferHeightInBlocks = static_cast<UINT32>(MAX_TRANSFER_SIZE / Request.Layout.Footprint.RowPitch);
+        UINT64 BytesInTransfer = min(MAX_TRANSFER_SIZE, RemainingBytes);
 
-        UINT32 TransferHeightInBlocks = static_cast<UINT32>((BytesInTransfer + Layout.Footprint.RowPitch - 1) / Layout.Footprint.RowPitch);
+        UINT32 TransferHeightInBlocks = static_cast<UINT32>((BytesInTransfer + Request.Layout.Footprint.RowPitch - 1) / Request.Layout.Footprint.RowPitch);
         TransferHeightInBlocks = min(TransferHeightInBlocks, MaxTransferHeightInBlocks);
 
         UINT32 TransferHeightInRows = TransferHeightInBlocks * MipFrameInfo.BlockHeight;
 
-        WICRect SourceRect;
-        SourceRect.X = 0;
-        SourceRect.Y = CurrentRow / MipFrameInfo.BlockHeight;
-        SourceRect.Width = MipFrameInfo.WidthInBlocks;
-        SourceRect.Height = TransferHeightInBlocks;
-
-        //
-        // The copy differs slightly based on whether or not this is a DDS file with block compressed data.
-        //
-        if (pDdsFrame)
-        {
-            hr = pDdsFrame->CopyBlocks(&SourceRect, Layout.Footprint.RowPitch, Layout.Footprint.RowPitch * TransferHeightInBlocks, ((BYTE*)pUploadData));
-        }
-        else if (pSourceBitmap.Get())
-        {
-            hr = pSourceBitmap->CopyPixels(&SourceRect, Layout.Footprint.RowPitch, Layout.Footprint.RowPitch * TransferHeightInBlocks, ((BYTE*)pUploadData));
-        }
-        else
-        {
-            hr = GenerateMip(pResource->GeneratedImageIndex, &SourceRect, Layout.Footprint.RowPitch, Layout.Footprint.RowPitch * TransferHeightInBlocks, (UINT*)pUploadData);
-        }
+        hr = ReadMipData(&Request, CurrentRow / MipFrameInfo.BlockHeight, TransferHeightInBlocks, pUploadData);
         if (FAILED(hr))
         {
-            LOG_ERROR("Failed to copy frame data to upload staging buffer, hr=0x%.8x", hr);
             return hr;
         }
 
         //
         // Copy the texture region on the copy command queue.
         //
-        Frame* pPagingFrame = m_PagingContext.GetCurrentFrame();
-
-        D3D12_BOX SrcBox =
-        {
-            0,                      // UINT left;
-            0,                      // UINT top;
-            0,                      // UINT front;
-            MipFrameInfo.WidthInBlocks * MipFrameInfo.BlockWidth, // UINT right;
-            TransferHeightInRows,   // UINT bottom;
-            1,                      // UINT back;
-        };
+        RecordMipCopy(&Request, pUploadSurface, CurrentRow, TransferHeightInRows);
 
-        CD3DX12_TEXTURE_COPY_LOCATION Dst(pResource->pDeviceState->pD3DResource, Mip);
-        CD3DX12_TEXTURE_COPY_LOCATION Src(pUploadSurface, Layout);
-        Src.PlacedFootprint.Footprint.Height = TransferHeightInRows;
-        Src.PlacedFootprint.Offset = 0;
-        pPagingFrame->pCommandList->CopyTextureRegion(&Dst, 0, CurrentRow, 0, &Src, &SrcBox);
-
-        //
-        // Synchronize on this transfer. An application may extend this implementation
-        // to support multiple operations at a time (by allowing multiple paging frames
-        // to run concurrently). However, in the interest of simplifying the concepts
-        // in the sample, it was opted to serialize paging operations to make things
-        // easier to understand.
-        //
         hr = m_PagingContext.Execute();
         if (FAILED(hr))
         {
@@ -1925,18 +1888,149 @@ HRESULT DX12Framework::LoadMip(Resource* pResource, UINT32 Mip)
             return hr;
         }
 
+        CurrentRow += TransferHeightInRows;
+        RemainingBytes -= BytesInTransfer;
+
+        //
+        // The frame containing the last transfer for the mip publishes it to the renderer
+        // once it completes on the GPU (see CompleteMipLoad).
+        //
+        m_PagingContext.TrackTransfer(
+            RemainingBytes == 0 ? pResource : nullptr,
+            static_cast<UINT8>(Mip),
+            nullptr,
+            BytesInTransfer);
+
         m_PagingContext.End();
+
+        //
+        // The shared staging surface is reused by the next transfer, and so we must
+        // synchronize on this one before overwriting it.
+        //
         m_PagingContext.Flush();
+    }
 
-        CurrentRow += TransferHeightInRows;
-        RemainingBytes -= BytesInTransfer;
+    return S_OK;
+}
+
+//
+// Copies the specified rows of blocks of a mipmap into the destination buffer, which uses
+// the row pitch of the request's layout. This is called by the paging read threads, and
+// by the paging worker thread when the shared staging surface is used.
+//
+HRESULT DX12Framework::ReadMipData(const PagingRequest* pRequest, UINT32 FirstBlockRow, UINT32 HeightInBlocks, void* pDestination)
+{
+    HRESULT hr;
+
+    const BitmapFrameInfo& MipFrameInfo = pRequest->FrameInfo;
+    UINT RowPitch = pRequest->Layout.Footprint.RowPitch;
+
+    WICRect SourceRect;
+    SourceRect.X = 0;
+    SourceRect.Y = FirstBlockRow;
+    SourceRect.Width = MipFrameInfo.WidthInBlocks;
+    SourceRect.Height = HeightInBlocks;
+
+    //
+    // The copy differs slightly based on whether or not this is a DDS file with block compressed data.
+    //
+    if (pRequest->pDdsFrame)
+    {
+        hr = pRequest->pDdsFrame->CopyBlocks(&SourceRect, RowPitch, RowPitch * HeightInBlocks, ((BYTE*)pDestination));
+    }
+    else if (pRequest->pSourceBitmap)
+    {
+        hr = pRequest->pSourceBitmap->CopyPixels(&SourceRect, RowPitch, RowPitch * HeightInBlocks, ((BYTE*)pDestination));
+    }
+    else
+    {
+        hr = GenerateMip(pRequest->pResource->GeneratedImageIndex, &SourceRect, RowPitch, RowPitch * HeightInBlocks, (UINT*)pDestination);
+    }
+    if (FAILED(hr))
+    {
+        LOG_ERROR("Failed to copy frame data to upload staging buffer, hr=0x%.8x", hr);
+        return hr;
+    }
+
+    return S_OK;
+}
+
+//
+// Records the copy of the specified rows of a mipmap from the upload surface into the
+// reserved resource in the current paging frame.
+//
+void DX12Framework::RecordMipCopy(const PagingRequest* pRequest, ID3D12Resource* pUploadSurface, UINT32 FirstRow, UINT32 HeightInRows)
+{
+    const BitmapFrameInfo& MipFrameInfo = pRequest->FrameInfo;
+    Frame* pPagingFrame = m_PagingContext.GetCurrentFrame();
+
+    D3D12_BOX SrcBox =
+    {
+        0,                      // UINT left;
+        0,                      // UINT top;
+        0,                      // UINT front;
+        MipFrameInfo.WidthInBlocks * MipFrameInfo.BlockWidth, // UINT right;
+        HeightInRows,           // UINT bottom;
+        1,                      // UINT back;
+    };
+
+    CD3DX12_TEXTURE_COPY_LOCATION Dst(pRequest->pResource->pDeviceState->pD3DResource, pRequest->Mip);
+    CD3DX12_TEXTURE_COPY_LOCATION Src(pUploadSurface, pRequest->Layout);
+    Src.PlacedFootprint.Footprint.Height = HeightInRows;
+    Src.PlacedFootprint.Offset = 0;
+    pPagingFrame->pCommandList->CopyTextureRegion(&Dst, 0, FirstRow, 0, &Src, &SrcBox);
+}
+
+//
+// Transfers a mipmap read by the paging read threads on the paging queue. The upload buffer
+// is kept alive by the paging frame until the transfer completes.
+//
+HRESULT DX12Framework::SubmitMipTransfer(PagingRequest* pRequest)
+{
+    HRESULT hr;
+
+    //
+    // Wait for earlier transfers to complete if this one does not fit within the in-flight
+    // budget of the paging queue.
+    //
+    m_PagingContext.WaitForTransferBudget(pRequest->TotalBytes);
+
+    m_PagingContext.Begin();
+
+    RecordMipCopy(pRequest, pRequest->pUploadBuffer.Get(), 0, pRequest->NumRows * pRequest->FrameInfo.BlockHeight);
+
+    hr = m_PagingContext.Execute();
+    if (FAILED(hr))
+    {
+        LOG_WARNING("Failed to transfer content for resource 0x%p, mip %d. hr=0x%.8x", pRequest->pResource, pRequest->Mip, hr);
+        m_PagingContext.End();
+        return hr;
     }
 
+    m_PagingContext.TrackTransfer(pRequest->pResource, pRequest->Mip, pRequest->pUploadBuffer.Get(), pRequest->TotalBytes);
+
+    m_PagingContext.End();
+
+    return S_OK;
+}
+
+//
+// Called by the paging context when the last transfer of a mip completes on the GPU.
+//
+void DX12Framework::CompleteMipLoad(Resource* pResource, UINT8 Mip)
+{
     pResource->MostDetailedMipResident = Mip;
+    pResource->bPagingInFlight = false;
 
     AddResourceCommitment(pResource);
 
-    return S_OK;
+    //
+    // The next level of detail can now be paged in, so reprioritize the resource.
+    //
+    if (m_pWorkerThread)
+    {
+        m_pWorkerThread->PrioritizeResource(pResource);
+    }
 }
 
 _Use_decl_annotations_
@@ -2596,6 +2690,15 @@ bool DX12Framework::TrimToTarget(ResourceTrimPass MaxPass, UINT64 TargetUsage)
                     continue;
                 }
 
+                if (pResource->bPagingInFlight)
+                {
+                    //
+                    // Skip resources with a transfer in flight, since the transfer will make
+                    // its mip the most detailed one resident when it completes.
+                    //
+                    continue;
+                }
+
                 ResourceMip* pResourceMip = &pResource->pDeviceState->Mips[Mip];
 
                 UINT64 WaitFence = 0;
@@ -2728,5 +2831,13 @@ void DX12Framework::LoadConfig(int argc, LPCSTR argv[])
         {
             m_bUseSharedStagingSurface = true;
         }
+        else if (_strcmpi(pArg, "-pagingthreads") == 0 && i + 1 < argc)
+        {
+            m_PagingReadThreadCount = max(atoi(argv[++i]), 1);
+        }
+        else if (_strcmpi(pArg, "-pagingqueuedepth") == 0 && i + 1 < argc)
+        {
+            m_PagingReadQueueDepth = max(atoi(argv[++i]), 1);
+        }
     }
 }
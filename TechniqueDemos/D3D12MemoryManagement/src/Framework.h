@@ -49,10 +49,47 @@ struct BitmapFrameInfo
     GUID TargetPixelFormat;
 };
 
+//
+// Describes the decoding of one mipmap into an upload buffer. When the shared staging
+// surface is used, the mipmap is decoded and transferred in chunks by the paging worker
+// thread. Otherwise the request is queued to the paging read threads, which decode the
+// whole mipmap into its own upload buffer, and is then returned to the paging worker
+// thread to be transferred on the paging queue.
+//
+struct PagingRequest
+{
+    LIST_ENTRY ListEntry;
+
+    Resource* pResource;
+    UINT8 Mip;
+
+    // The source of the pixel data. Generated images have neither a DDS frame nor a
+    // bitmap source.
+    ComPtr<IWICDdsFrameDecode> pDdsFrame;
+    ComPtr<IWICBitmapSource> pSourceBitmap;
+    BitmapFrameInfo FrameInfo;
+
+    // The layout of the mipmap in the upload buffer.
+    D3D12_PLACED_SUBRESOURCE_FOOTPRINT Layout;
+    UINT NumRows;
+    UINT64 TotalBytes;
+
+    // The upload buffer receiving the pixel data, or null if the shared staging surface is used.
+    ComPtr<ID3D12Resource> pUploadBuffer;
+    void* pUploadData;
+
+    // The result of the read, along with the times at which the request was queued to
+    // and completed by the read threads.
+    HRESULT Result;
+    LARGE_INTEGER QueuedTime;
+    LARGE_INTEGER CompletedTime;
+};
+
 class DX12Framework
 {
     friend class RenderContext;
     friend class PagingContext;
+    friend class PagingWorkerThread;
 
 private:
     //
@@ -83,6 +120,10 @@ private:
     HRESULT GetDdsFrameInfo(IWICDdsFrameDecode* pFrame, BitmapFrameInfo* pFormatInfo);
     HRESULT GetBitmapFrameInfo(IWICBitmapFrameDecode* pFrame, BitmapFrameInfo* pFormatInfo);
     HRESULT LoadMip(Resource* pResource, UINT32 Mip);
+    HRESULT ReadMipData(const PagingRequest* pRequest, UINT32 FirstBlockRow, UINT32 HeightInBlocks, void* pDestination);
+    void RecordMipCopy(const PagingRequest* pRequest, ID3D12Resource* pUploadSurface, UINT32 FirstRow, UINT32 HeightInRows);
+    HRESULT SubmitMipTransfer(PagingRequest* pRequest);
+    void CompleteMipLoad(Resource* pResource, UINT8 Mip);
     HRESULT GenerateMip(UINT ImageIndex, WICRect* pRect, UINT RowPitch, UINT BufferSizeInBytes, _In_reads_bytes_(BufferSizeInBytes) UINT* pBuffer);
     void RemoveResourceCommitment(Resource* pResource);
     void AddResourceCommitment(Resource* pResource);
@@ -206,6 +247,9 @@ protected:
     bool m_bUseSharedStagingSurface = false;
     bool m_bPresentOnVsync = true;
 
+    UINT m_PagingReadThreadCount = DEFAULT_PAGING_READ_THREAD_COUNT;
+    UINT m_PagingReadQueueDepth = DEFAULT_PAGING_READ_QUEUE_DEPTH;
+
     HRESULT m_SimulatedRenderResult = S_OK;
     UINT m_NewAdapterIndex = 0xFFFFFFFF;
 
@@ -250,6 +294,10 @@ public:
     }
     HRESULT PageInNextLevelOfDetail(Resource* pResource);
     bool TrimToTarget(ResourceTrimPass TrimLimit, UINT64 TargetUsage);
+    inline PagingStatistics GetPagingStatistics()
+    {
+        return m_pWorkerThread->GetStatistics();
+    }
     inline bool TrimToBudget(ResourceTrimPass TrimLimit)
     {
         return TrimToTarget(TrimLimit, m_LocalVideoMemoryInfo.Budget);
@@ -19,12 +19,28 @@
 // mapping the heaps for the resource mipmaps as they are needed.
 //
 
-PagingWorkerThread::PagingWorkerThread(DX12Framework* pFramework) :
+//
+// The total size of the mipmap reads that may be outstanding at once. Each outstanding
+// read holds an upload buffer for its whole mipmap, so this bounds the upload memory used
+// by the read threads. A read larger than this is allowed once no other read is outstanding.
+//
+#define MAX_PAGING_READ_BYTES_OUTSTANDING _128MB
+
+PagingWorkerThread::PagingWorkerThread(DX12Framework* pFramework, UINT ReadThreadCount, UINT ReadQueueDepth) :
     m_pFramework(pFramework),
     m_hThread(nullptr),
     m_CurrentStatus(EWTS_Suspended),
     m_RequestedStatus(EWTS_Suspended),
-    m_BudgetNotificationCookie(0)
+    m_BudgetNotificationCookie(0),
+    m_ReadThreadCount(max(ReadThreadCount, 1u)),
+    m_ReadQueueDepth(max(ReadQueueDepth, 1u)),
+    m_ReadsOutstanding(0),
+    m_ReadBytesOutstanding(0),
+    m_hReadSemaphore(nullptr),
+    m_hReadShutdownEvent(nullptr),
+    m_StatisticsWindowBytes(0),
+    m_StatisticsWindowLatency(0),
+    m_StatisticsWindowReads(0)
 {
     InitializeListHead(&m_PrioritizationListHead);
     for (int i = 0; i < _ERP_COUNT; ++i)
@@ -32,9 +48,21 @@ PagingWorkerThread::PagingWorkerThread(DX12Framework* pFramework) :
         InitializeListHead(&m_PriorityQueues[i]);
     }
 
+    InitializeListHead(&m_PendingReadListHead);
+    InitializeListHead(&m_CompletedReadListHead);
+
     InitializeCriticalSection(&m_PrioritizationListLock);
+    InitializeCriticalSection(&m_ReadListLock);
+    InitializeCriticalSection(&m_StatisticsLock);
 
     ZeroMemory(m_hWakeEvents, sizeof(m_hWakeEvents));
+
+    ZeroMemory(&m_Statistics, sizeof(m_Statistics));
+    m_Statistics.ReadQueueDepth = m_ReadQueueDepth;
+    m_Statistics.ReadThreadCount = m_ReadThreadCount;
+
+    QueryPerformanceFrequency(&m_PerformanceFrequency);
+    QueryPerformanceCounter(&m_StatisticsWindowStart);
 }
 
 PagingWorkerThread::~PagingWorkerThread()
@@ -51,6 +79,37 @@ PagingWorkerThread::~PagingWorkerThread()
         CloseHandle(m_hThread);
     }
 
+    //
+    // The worker thread waits for all outstanding reads before shutting down, so the read
+    // threads are idle and can simply be told to exit.
+    //
+    if (m_hReadShutdownEvent)
+    {
+        SetEvent(m_hReadShutdownEvent);
+    }
+
+    for (HANDLE hReadThread : m_ReadThreads)
+    {
+        WaitForSingleObject(hReadThread, INFINITE);
+        CloseHandle(hReadThread);
+    }
+
+    assert(IsListEmpty(&m_PendingReadListHead));
+    assert(IsListEmpty(&m_CompletedReadListHead));
+
+    if (m_hReadSemaphore)
+    {
+        CloseHandle(m_hReadSemaphore);
+    }
+
+    if (m_hReadShutdownEvent)
+    {
+        CloseHandle(m_hReadShutdownEvent);
+    }
+
+    DeleteCriticalSection(&m_ReadListLock);
+    DeleteCriticalSection(&m_StatisticsLock);
+
     for (UINT i = 0; i < _countof(m_hWakeEvents); ++i)
     {
         if (m_hWakeEvents[i] != INVALID_HANDLE_VALUE)
@@ -93,6 +152,42 @@ HRESULT PagingWorkerThread::Init()
         return HRESULT_FROM_WIN32(GetLastError());
     }
 
+    m_hReadSemaphore = CreateSemaphore(nullptr, 0, MAXLONG, nullptr);
+    if (m_hReadSemaphore == nullptr)
+    {
+        LOG_ERROR("Failed to create paging read semaphore, Error=0x%.8x", GetLastError());
+        return HRESULT_FROM_WIN32(GetLastError());
+    }
+
+    m_hReadShutdownEvent = CreateEvent(nullptr, TRUE, FALSE, nullptr);
+    if (m_hReadShutdownEvent == nullptr)
+    {
+        LOG_ERROR("Failed to create paging read shutdown event, Error=0x%.8x", GetLastError());
+        return HRESULT_FROM_WIN32(GetLastError());
+    }
+
+    try
+    {
+        m_ReadThreads.reserve(m_ReadThreadCount);
+    }
+    catch (std::bad_alloc&)
+    {
+        LOG_ERROR("Failed to allocate paging read thread handles");
+        return E_OUTOFMEMORY;
+    }
+
+    for (UINT i = 0; i < m_ReadThreadCount; ++i)
+    {
+        HANDLE hReadThread = CreateThread(nullptr, 0, PagingWorkerThread::ReadThreadEntry, this, 0, nullptr);
+        if (hReadThread == nullptr)
+        {
+            LOG_ERROR("Failed to create paging read thread, Error=0x%.8x", GetLastError());
+            return HRESULT_FROM_WIN32(GetLastError());
+        }
+
+        m_ReadThreads.push_back(hReadThread);
+    }
+
     m_hThread = CreateThread(nullptr, 0, PagingWorkerThread::ThreadEntry, this, 0, nullptr);
     if (m_hThread == nullptr)
     {
@@ -122,10 +217,20 @@ HRESULT PagingWorkerThread::Init()
 void PagingWorkerThread::Flush()
 {
     bool bMoreWork = true;
-    while (bMoreWork)
+    while (bMoreWork || m_ReadsOutstanding > 0)
     {
+        if (!bMoreWork)
+        {
+            WaitForSingleObject(m_hWakeEvents[EWR_ReadCompletion], INFINITE);
+        }
+
         ProcessSubmission(&bMoreWork);
     }
+
+    //
+    // Wait for the in-flight transfers, so every paged in mipmap is visible to the renderer.
+    //
+    m_pFramework->m_PagingContext.Flush();
 }
 
 DWORD CALLBACK PagingWorkerThread::ThreadEntry(void* pArg)
@@ -167,6 +272,14 @@ DWORD PagingWorkerThread::Run()
         // worker thread state change to 'shutdown'), which will block for long periods
         // of time.
         //
+        // When there is no more work, but transfers are still in flight on the copy queue,
+        // the paging completion event wakes the thread to publish the transferred mipmaps.
+        //
+        if (!bMoreWork && m_pFramework->m_PagingContext.GetActiveFrameCount() > 0)
+        {
+            m_pFramework->m_PagingContext.SetEventOnFrameCompletion(m_hWakeEvents[EWR_PagingCompletion]);
+        }
+
         DWORD Timeout = bMoreWork ? 0 : INFINITE;
         DWORD WaitResult = WaitForMultipleObjects(_countof(m_hWakeEvents), m_hWakeEvents, FALSE, Timeout);
 
@@ -206,6 +319,16 @@ DWORD PagingWorkerThread::Run()
                 ProcessBudgetChangeNotification();
                 bMoreWork = true;
             }
+            else if (Reason == EWR_PagingCompletion)
+            {
+                m_pFramework->m_PagingContext.RetireCompletedFrames();
+                bMoreWork = true;
+            }
+            else if (Reason == EWR_ReadCompletion)
+            {
+                ProcessReadCompletions();
+                bMoreWork = true;
+            }
             else
             {
                 assert(false);
@@ -246,6 +369,13 @@ void PagingWorkerThread::ProcessStatusChangeRequest()
         if (m_RequestedStatus == EWTS_Shutdown)
         {
             DiscardPendingWork();
+
+            //
+            // Let the outstanding reads and in-flight transfers complete before the paging
+            // context is destroyed.
+            //
+            WaitForReads();
+            m_pFramework->m_PagingContext.Flush();
         }
     }
 
@@ -259,6 +389,23 @@ void PagingWorkerThread::ProcessSubmission(bool* pMoreWork)
 {
     *pMoreWork = true;
 
+    //
+    // Publish any transfers that completed since the last submission, so the resources
+    // can be selected for their next level of detail.
+    //
+    m_pFramework->m_PagingContext.RetireCompletedFrames();
+    ProcessReadCompletions();
+
+    //
+    // Stop issuing paging operations once the read queue is full. The worker thread is woken
+    // up again as reads complete.
+    //
+    if (m_ReadsOutstanding >= m_ReadQueueDepth || m_ReadBytesOutstanding >= MAX_PAGING_READ_BYTES_OUTSTANDING)
+    {
+        *pMoreWork = false;
+        return;
+    }
+
     //
     // Select the highest priority paging operation from the priority queues. SelectResource
     // may return null if there are no entries, or if none of the operations can be selected
@@ -281,7 +428,8 @@ void PagingWorkerThread::ProcessSubmission(bool* pMoreWork)
     }
 
     //
-    // After the paging operation completes, we need to reprioritize this specific resource.
+    // After the paging operation is submitted, we need to reprioritize this specific resource.
+    // If the transfer is still in flight, this is deferred until the transfer completes.
     //
     PrioritizeResource(pResource);
 
@@ -369,6 +517,14 @@ void PagingWorkerThread::PrioritizeResource(Resource* pResource)
         pResource->PagingEntry.Flink = nullptr;
     }
 
+    if (pResource->bPagingInFlight)
+    {
+        //
+        // The resource is reprioritized once its in-flight transfer completes.
+        //
+        return;
+    }
+
     bool AnyPackedMipsMissing = MostDetailedMipResident > GetLeastDetailedMipHeapIndex(pResource);
     bool IsInPrefetchZone = (PrefetchMip != UNDEFINED_MIPMAP_INDEX);
 
@@ -430,6 +586,26 @@ void PagingWorkerThread::PrioritizeResource(Resource* pResource)
     }
 }
 
+//
+// Returns the resource with the highest priority score in the specified queue. Resources
+// with equal scores are selected in queue order.
+//
+Resource* PagingWorkerThread::SelectHighestScoringResource(LIST_ENTRY* pQueue)
+{
+    Resource* pSelectedResource = nullptr;
+
+    for (LIST_ENTRY* pEntry = pQueue->Flink; pEntry != pQueue; pEntry = pEntry->Flink)
+    {
+        Resource* pResource = CONTAINING_RECORD(pEntry, Resource, PagingEntry);
+        if (pSelectedResource == nullptr || pResource->PriorityScore > pSelectedResource->PriorityScore)
+        {
+            pSelectedResource = pResource;
+        }
+    }
+
+    return pSelectedResource;
+}
+
 //
 // SelectResource will look at each of the priority queues and select the best operation
 // to process. Unless marked otherwise, paging operations will not be selected if the
@@ -450,16 +626,17 @@ Resource* PagingWorkerThread::SelectResource()
         //
         UINT64 BudgetBias = _1MB + _8MB * i;
 
-        if (!IsListEmpty(&m_PriorityQueues[i]))
+        Resource* pResource = SelectHighestScoringResource(&m_PriorityQueues[i]);
+        if (pResource != nullptr)
         {
-            LIST_ENTRY* pEntry = m_PriorityQueues[i].Flink;
-            Resource* pResource = CONTAINING_RECORD(pEntry, Resource, PagingEntry);
+            LIST_ENTRY* pEntry = &pResource->PagingEntry;
 
             //
             // The paging thread will only page in one mipmap at a time to be fair to all
             // resources. This allows resources to be selected in a round-robin sequence,
             // preventing prefetching of low priority allocations to delay visibility changes
-            // from reprioritizing operations.
+            // from reprioritizing operations. Resources of equal score keep this round-robin
+            // order, since they are selected in queue order.
             //
             // Even though the paging operations are asycnhronous from rendering (i.e. they
             // should not impact performance), it is still possible for the paging operations,
@@ -509,11 +686,198 @@ Resource* PagingWorkerThread::SelectResource()
     return nullptr;
 }
 
+//
+// Queues a mipmap read to the read threads. The resource is marked as in flight until the
+// mipmap has been read and transferred.
+//
+HRESULT PagingWorkerThread::QueueRead(const PagingRequest& Request)
+{
+    PagingRequest* pRequest = nullptr;
+    try
+    {
+        pRequest = new PagingRequest(Request);
+    }
+    catch (std::bad_alloc&)
+    {
+        LOG_ERROR("Failed to allocate paging read request");
+        return E_OUTOFMEMORY;
+    }
+
+    QueryPerformanceCounter(&pRequest->QueuedTime);
+    pRequest->pResource->bPagingInFlight = true;
+
+    ++m_ReadsOutstanding;
+    m_ReadBytesOutstanding += pRequest->TotalBytes;
+
+    EnterCriticalSection(&m_ReadListLock);
+    InsertTailList(&m_PendingReadListHead, &pRequest->ListEntry);
+    LeaveCriticalSection(&m_ReadListLock);
+
+    ReleaseSemaphore(m_hReadSemaphore, 1, nullptr);
+
+    return S_OK;
+}
+
+//
+// Transfers the mipmaps decoded by the read threads on the paging queue.
+//
+void PagingWorkerThread::ProcessReadCompletions()
+{
+    for (;;)
+    {
+        EnterCriticalSection(&m_ReadListLock);
+        LIST_ENTRY* pEntry = IsListEmpty(&m_CompletedReadListHead) ? nullptr : RemoveHeadList(&m_CompletedReadListHead);
+        LeaveCriticalSection(&m_ReadListLock);
+
+        if (pEntry == nullptr)
+        {
+            break;
+        }
+
+        PagingRequest* pRequest = CONTAINING_RECORD(pEntry, PagingRequest, ListEntry);
+
+        assert(m_ReadsOutstanding > 0);
+        --m_ReadsOutstanding;
+        m_ReadBytesOutstanding -= pRequest->TotalBytes;
+
+        HRESULT hr = pRequest->Result;
+        if (SUCCEEDED(hr))
+        {
+            UpdateReadStatistics(pRequest);
+
+            hr = m_pFramework->SubmitMipTransfer(pRequest);
+        }
+
+        if (FAILED(hr))
+        {
+            //
+            // The resource is not reprioritized here, so a failing mipmap is not retried
+            // continuously. It will be retried the next time the render thread updates the
+            // resource's visibility.
+            //
+            LOG_WARNING("Failed to page in resource 0x%p mip %d, hr=0x%.8x", pRequest->pResource, pRequest->Mip, hr);
+            pRequest->pResource->bPagingInFlight = false;
+        }
+
+        delete pRequest;
+    }
+}
+
+void PagingWorkerThread::WaitForReads()
+{
+    ProcessReadCompletions();
+
+    while (m_ReadsOutstanding > 0)
+    {
+        WaitForSingleObject(m_hWakeEvents[EWR_ReadCompletion], INFINITE);
+        ProcessReadCompletions();
+    }
+}
+
+void PagingWorkerThread::UpdateReadStatistics(const PagingRequest* pRequest)
+{
+    m_StatisticsWindowBytes += pRequest->TotalBytes;
+    m_StatisticsWindowLatency += pRequest->CompletedTime.QuadPart - pRequest->QueuedTime.QuadPart;
+    ++m_StatisticsWindowReads;
+
+    LARGE_INTEGER Now;
+    QueryPerformanceCounter(&Now);
+
+    //
+    // Publish the statistics once per second.
+    //
+    LONGLONG WindowTicks = Now.QuadPart - m_StatisticsWindowStart.QuadPart;
+    if (WindowTicks >= m_PerformanceFrequency.QuadPart)
+    {
+        float WindowSeconds = (float)WindowTicks / m_PerformanceFrequency.QuadPart;
+        float AverageLatencySeconds = (float)m_StatisticsWindowLatency / m_StatisticsWindowReads / m_PerformanceFrequency.QuadPart;
+
+        EnterCriticalSection(&m_StatisticsLock);
+        m_Statistics.ReadThroughput = (float)m_StatisticsWindowBytes / _1MB / WindowSeconds;
+        m_Statistics.AverageReadLatency = AverageLatencySeconds * 1000.0f;
+        LeaveCriticalSection(&m_StatisticsLock);
+
+        m_StatisticsWindowStart = Now;
+        m_StatisticsWindowBytes = 0;
+        m_StatisticsWindowLatency = 0;
+        m_StatisticsWindowReads = 0;
+    }
+}
+
+PagingStatistics PagingWorkerThread::GetStatistics()
+{
+    EnterCriticalSection(&m_StatisticsLock);
+    PagingStatistics Statistics = m_Statistics;
+    LeaveCriticalSection(&m_StatisticsLock);
+
+    //
+    // This is read without synchronization, and is only used for display purposes.
+    //
+    Statistics.ReadsOutstanding = m_ReadsOutstanding;
+
+    return Statistics;
+}
+
+DWORD CALLBACK PagingWorkerThread::ReadThreadEntry(void* pArg)
+{
+    PagingWorkerThread* pWorkerThread = (PagingWorkerThread*)pArg;
+
+    return pWorkerThread->RunReadThread();
+}
+
+//
+// Each read thread decodes one mipmap at a time into its upload buffer, and returns it to
+// the worker thread. Requests for different resources are decoded in parallel, while a
+// resource never has more than one request outstanding, since it is marked as in flight.
+//
+DWORD PagingWorkerThread::RunReadThread()
+{
+    HANDLE hWaitHandles[] = { m_hReadShutdownEvent, m_hReadSemaphore };
+
+    for (;;)
+    {
+        DWORD WaitResult = WaitForMultipleObjects(_countof(hWaitHandles), hWaitHandles, FALSE, INFINITE);
+        if (WaitResult == WAIT_FAILED)
+        {
+            LOG_CRITICAL_ERROR("Paging read thread wait failed, Error=0x%.8x", GetLastError());
+        }
+        else if (WaitResult == WAIT_OBJECT_0)
+        {
+            break;
+        }
+
+        EnterCriticalSection(&m_ReadListLock);
+        assert(!IsListEmpty(&m_PendingReadListHead));
+        LIST_ENTRY* pEntry = RemoveHeadList(&m_PendingReadListHead);
+        LeaveCriticalSection(&m_ReadListLock);
+
+        PagingRequest* pRequest = CONTAINING_RECORD(pEntry, PagingRequest, ListEntry);
+
+        pRequest->Result = m_pFramework->ReadMipData(pRequest, 0, pRequest->NumRows, pRequest->pUploadData);
+        QueryPerformanceCounter(&pRequest->CompletedTime);
+
+        EnterCriticalSection(&m_ReadListLock);
+        InsertTailList(&m_CompletedReadListHead, &pRequest->ListEntry);
+        LeaveCriticalSection(&m_ReadListLock);
+
+        SetEvent(m_hWakeEvents[EWR_ReadCompletion]);
+    }
+
+    return 0;
+}
+
 //
 // PagingContext
 //
 #define PAGING_CONTEXT_COMMAND_LIST_TYPE D3D12_COMMAND_LIST_TYPE_COPY
 
+//
+// The number of paging frames, and the total upload size, that may be in flight on the
+// paging queue at once.
+//
+#define PAGING_FRAME_COUNT 4
+#define MAX_PAGING_BYTES_IN_FLIGHT _64MB
+
 PagingContext::PagingContext(DX12Framework* pFramework) :
     Context(pFramework)
 {
@@ -537,16 +901,19 @@ HRESULT PagingContext::CreateDeviceDependentState()
     try
     {
         //
-        // The paging context always has only a single frame, since we will only process
-        // one paging operation at a time.
+        // Each paging operation uses its own frame, so the paging thread can decode the
+        // next mipmap while the previous transfers are still running on the copy queue.
         //
-        PagingFrame* pFrame = new PagingFrame();
-
-        hr = InitializeFrame(pFrame, PAGING_CONTEXT_COMMAND_LIST_TYPE);
-        if (FAILED(hr))
+        for (UINT i = 0; i < PAGING_FRAME_COUNT; ++i)
         {
-            LOG_WARNING("Failed to initialize frame object, hr=0x%.8x", hr);
-            return hr;
+            PagingFrame* pFrame = new PagingFrame();
+
+            hr = InitializeFrame(pFrame, PAGING_CONTEXT_COMMAND_LIST_TYPE);
+            if (FAILED(hr))
+            {
+                LOG_WARNING("Failed to initialize frame object, hr=0x%.8x", hr);
+                return hr;
+            }
         }
     }
     catch (std::bad_alloc&)
@@ -588,3 +955,59 @@ void PagingContext::DestroyDeviceDependentState()
 
     Context::DestroyDeviceDependentState();
 }
+
+//
+// Blocks until the specified transfer fits within the in-flight budget of the paging queue.
+// A transfer larger than the budget is allowed once no other transfer is in flight.
+//
+void PagingContext::WaitForTransferBudget(UINT64 TransferSize)
+{
+    while (m_ActiveFrames > 0 && m_TransferBytesInFlight + TransferSize > MAX_PAGING_BYTES_IN_FLIGHT)
+    {
+        WaitForSingleFrame();
+    }
+}
+
+//
+// Records the transfer in the current paging frame. The upload buffer is kept alive until
+// the frame completes, at which point the mipmap (if any) is published to the renderer.
+//
+void PagingContext::TrackTransfer(Resource* pResource, UINT8 Mip, ID3D12Resource* pUploadBuffer, UINT64 TransferSize)
+{
+    PagingFrame* pFrame = GetCurrentFrame();
+    assert(pFrame != nullptr);
+
+    pFrame->pResource = pResource;
+    pFrame->Mip = Mip;
+    pFrame->pUploadBuffer = pUploadBuffer;
+    pFrame->TransferSize = TransferSize;
+
+    if (pUploadBuffer)
+    {
+        pUploadBuffer->AddRef();
+    }
+
+    if (pResource)
+    {
+        pResource->bPagingInFlight = true;
+    }
+
+    m_TransferBytesInFlight += TransferSize;
+}
+
+void PagingContext::RetireFrame(Frame* pFrame)
+{
+    PagingFrame* pPagingFrame = static_cast<PagingFrame*>(pFrame);
+
+    SafeRelease(pPagingFrame->pUploadBuffer);
+
+    assert(m_TransferBytesInFlight >= pPagingFrame->TransferSize);
+    m_TransferBytesInFlight -= pPagingFrame->TransferSize;
+    pPagingFrame->TransferSize = 0;
+
+    if (pPagingFrame->pResource)
+    {
+        m_pFramework->CompleteMipLoad(pPagingFrame->pResource, pPagingFrame->Mip);
+        pPagingFrame->pResource = nullptr;
+    }
+}
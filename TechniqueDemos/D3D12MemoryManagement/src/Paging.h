@@ -11,6 +11,13 @@
 
 #pragma once
 
+//
+// The default number of paging read threads, and the default number of mipmap reads that
+// may be outstanding at once. Both can be overridden on the command line.
+//
+#define DEFAULT_PAGING_READ_THREAD_COUNT 4
+#define DEFAULT_PAGING_READ_QUEUE_DEPTH 8
+
 //
 // Specifies the reason that the paging thread was woken up.
 //
@@ -32,6 +39,15 @@ enum WakeReason
     // resources to remain under the budget.
     EWR_BudgetNotification,
 
+    // Indicates that the oldest in-flight paging operation has completed on the copy
+    // queue, and the worker thread should publish the transferred mipmap to the
+    // rendering thread.
+    EWR_PagingCompletion,
+
+    // Indicates that a paging read thread has finished decoding a mipmap, which the
+    // worker thread should now transfer on the paging queue.
+    EWR_ReadCompletion,
+
     _EWR_COUNT
 };
 
@@ -47,6 +63,23 @@ enum WorkerThreadStatus
     _EWTS_COUNT
 };
 
+//
+// Statistics about the mipmap reads performed by the paging read threads, updated roughly
+// once per second.
+//
+struct PagingStatistics
+{
+    // The rate at which mipmap data was decoded into upload buffers, in MB/s.
+    float ReadThroughput;
+
+    // The average time between queuing a read and its completion, in milliseconds.
+    float AverageReadLatency;
+
+    UINT ReadsOutstanding;
+    UINT ReadQueueDepth;
+    UINT ReadThreadCount;
+};
+
 //
 // The paging worker thread is the powerhouse behind all paging and texture streaming
 // for the sample.
@@ -83,15 +116,61 @@ private:
     LIST_ENTRY m_PrioritizationListHead;
 
     // An array of priority-ordered linked list heads. The worker thread will process
-    // resources in these arrays in strict order.
+    // resources in these arrays in strict order. Within a single queue, the resource
+    // with the highest priority score is processed first.
     LIST_ENTRY m_PriorityQueues[_ERP_COUNT];
 
+    //
+    // Read threads
+    //
+    // Decoding a mipmap is mostly spent waiting on file reads, so the worker thread hands
+    // mipmap reads to a pool of read threads, which keeps several reads outstanding.
+    //
+    std::vector<HANDLE> m_ReadThreads;
+    UINT m_ReadThreadCount;
+    UINT m_ReadQueueDepth;
+
+    // The number and total size of reads that have been queued, but not yet returned to
+    // the worker thread. Only accessed by the worker thread.
+    UINT m_ReadsOutstanding;
+    UINT64 m_ReadBytesOutstanding;
+
+    // Lock for accessing the pending and completed read lists, which are shared by the
+    // worker thread and the read threads.
+    CRITICAL_SECTION m_ReadListLock;
+    LIST_ENTRY m_PendingReadListHead;
+    LIST_ENTRY m_CompletedReadListHead;
+
+    // Counts the requests in the pending read list, and wakes a read thread per request.
+    HANDLE m_hReadSemaphore;
+
+    // Signaled when the read threads should exit.
+    HANDLE m_hReadShutdownEvent;
+
+    //
+    // Read statistics
+    //
+    CRITICAL_SECTION m_StatisticsLock;
+    PagingStatistics m_Statistics;
+    LARGE_INTEGER m_PerformanceFrequency;
+    LARGE_INTEGER m_StatisticsWindowStart;
+    UINT64 m_StatisticsWindowBytes;
+    UINT64 m_StatisticsWindowLatency;
+    UINT m_StatisticsWindowReads;
+
 private:
-    PagingWorkerThread(DX12Framework* pFramework);
+    PagingWorkerThread(DX12Framework* pFramework, UINT ReadThreadCount, UINT ReadQueueDepth);
     ~PagingWorkerThread();
 
     HRESULT Init();
 
+    HRESULT QueueRead(const PagingRequest& Request);
+    void ProcessReadCompletions();
+    void WaitForReads();
+    void UpdateReadStatistics(const PagingRequest* pRequest);
+    PagingStatistics GetStatistics();
+    DWORD RunReadThread();
+
     void Flush();
     void DiscardPendingWork();
     DWORD Run();
@@ -100,6 +179,7 @@ private:
     void ReprioritizeResources();
     void PrioritizeResource(Resource* pResource);
     Resource* SelectResource();
+    Resource* SelectHighestScoringResource(LIST_ENTRY* pQueue);
 
     void ProcessStatusChangeRequest();
     void ProcessSubmission(bool* pMoreWork);
@@ -108,13 +188,25 @@ private:
     void SetStatus(WorkerThreadStatus Status);
 
     static DWORD CALLBACK ThreadEntry(void* pArg);
+    static DWORD CALLBACK ReadThreadEntry(void* pArg);
 };
 
 //
-// A paging frame does not have any special state.
+// A paging frame tracks the transfer recorded in it, so that the transferred mipmap can
+// be published and the upload buffer released once the frame completes on the GPU.
 //
 struct PagingFrame : Frame
 {
+    // The resource and mip made resident by this frame, or null if the frame only
+    // transfers part of a mipmap.
+    Resource* pResource;
+    UINT8 Mip;
+
+    // The upload buffer read by the frame, or null if the shared staging surface is used.
+    ID3D12Resource* pUploadBuffer;
+
+    // The number of bytes uploaded by the frame, counted against the in-flight budget.
+    UINT64 TransferSize;
 };
 
 //
@@ -126,8 +218,17 @@ struct PagingFrame : Frame
 // the paging operations to run completely in parallel with 3D graphics work
 // submitted on the 3D engines.
 //
+// Several paging operations may be in flight at once, bounded both by the number of
+// paging frames and by the total size of the transfers.
+//
 class PagingContext : public Context
 {
+private:
+    UINT64 m_TransferBytesInFlight = 0;
+
+protected:
+    virtual void RetireFrame(Frame* pFrame) override;
+
 public:
     PagingContext(DX12Framework* pFramework);
     ~PagingContext();
@@ -135,6 +236,9 @@ public:
     HRESULT CreateDeviceDependentState();
     void DestroyDeviceDependentState();
 
+    void WaitForTransferBudget(UINT64 TransferSize);
+    void TrackTransfer(Resource* pResource, UINT8 Mip, ID3D12Resource* pUploadBuffer, UINT64 TransferSize);
+
     inline PagingFrame* GetCurrentFrame() const
     {
         return static_cast<PagingFrame*>(m_pCurrentFrame);
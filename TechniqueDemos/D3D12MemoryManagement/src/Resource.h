@@ -157,6 +157,16 @@ struct Resource
     // to ensure that every resource has at least some low quality content.
     bool bIgnoreBudget : 1;
 
+    // True while a mipmap of this resource is being transferred on the paging queue.
+    // The resource is neither selected for paging nor trimmed until the transfer
+    // completes and MostDetailedMipResident is updated.
+    bool bPagingInFlight : 1;
+
+    // Set by the render thread to rank resources within the same paging priority. The
+    // score grows with the on-screen size of the resource, and shrinks with its distance
+    // from the predicted viewport.
+    float PriorityScore;
+
     // The maximum trimming pass that should be used to help resolve paging failures
     // when paging in a resource would normally go over the budget. This limitation
     // prevents resources from recursively trimming one another by preventing lower
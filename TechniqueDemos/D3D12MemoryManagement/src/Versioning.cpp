@@ -17,10 +17,14 @@ HRESULT DynamicBuffer::Allocate(UINT32 ElementSize, UINT32 ElementCount, void**
     UINT32 AllocationSize = ElementSize * ElementCount;
     assert(AllocationSize <= DYNAMIC_BUFFER_SIZE);
 
-    ULONG_PTR pCurrentAddress = (ULONG_PTR)m_pCurrentAddress;
-    ULONG_PTR pEndAddress = (ULONG_PTR)m_pBuffer->pBaseAddress + DYNAMIC_BUFFER_SIZE;
+    //
+    // Claim the space before checking it, so concurrent producers never hand out
+    // overlapping ranges. A failed claim leaves the offset past the end, which keeps
+    // every later allocation failing until the buffer is renamed.
+    //
+    LONG64 Offset = InterlockedExchangeAdd64(&m_CurrentOffset, (LONG64)AllocationSize);
 
-    if (pCurrentAddress + AllocationSize > pEndAddress)
+    if (Offset + AllocationSize > DYNAMIC_BUFFER_SIZE)
     {
         //
         // Allocation would overflow buffer, return out of memory to signal to
@@ -30,10 +34,9 @@ HRESULT DynamicBuffer::Allocate(UINT32 ElementSize, UINT32 ElementCount, void**
         return E_OUTOFMEMORY;
     }
 
-    *pData = (void*)pCurrentAddress;
-    *pOffset = (UINT32)(m_pCurrentAddress - m_pBuffer->pBaseAddress);
+    *pData = (void*)(m_pBuffer->pBaseAddress + (ULONG_PTR)Offset);
+    *pOffset = (UINT32)Offset;
 
-    m_pCurrentAddress = pCurrentAddress + AllocationSize;
     return S_OK;
 }
 
@@ -170,7 +173,7 @@ retry_allocation:
     // Assign the new versioned buffer, and set the current pointer to the start.
     //
     pDynamicBuffer->m_pBuffer = pBuffer;
-    pDynamicBuffer->m_pCurrentAddress = pBuffer->pBaseAddress;
+    InterlockedExchange64(&pDynamicBuffer->m_CurrentOffset, 0);
 }
 
 //
@@ -178,11 +181,21 @@ retry_allocation:
 // need to be a power of two. This function is used to allow a single vertex buffer
 // to be shared across multiple vertex types (of different sizes).
 //
+// Other threads may move the offset at the same time, so the aligned value is only
+// published if nothing changed in between. Alignment is only guaranteed for the next
+// allocation when a single thread is producing data of that type.
+//
 void DynamicBuffer::Align(UINT32 Alignment)
 {
-    ULONG_PTR Offset = (m_pCurrentAddress - m_pBuffer->pBaseAddress) + Alignment - 1;
-    ULONG_PTR AlignedAligned = Offset - (Offset % Alignment);
-    m_pCurrentAddress = m_pBuffer->pBaseAddress + AlignedAligned;
+    LONG64 CurrentOffset;
+    LONG64 AlignedOffset;
+
+    do
+    {
+        CurrentOffset = m_CurrentOffset;
+        LONG64 Offset = CurrentOffset + Alignment - 1;
+        AlignedOffset = Offset - (Offset % Alignment);
+    } while (InterlockedCompareExchange64(&m_CurrentOffset, AlignedOffset, CurrentOffset) != CurrentOffset);
 }
 
 //
@@ -300,5 +313,5 @@ retry_allocation:
     // Assign the new versioned heap, and set the current descriptor to the start.
     //
     pDynamicHeap->m_pHeap = pHeap;
-    pDynamicHeap->m_CurrentHandleIndex = 0;
+    InterlockedExchange(&pDynamicHeap->m_CurrentHandleIndex, 0);
 }
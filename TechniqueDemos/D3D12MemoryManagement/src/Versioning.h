@@ -27,13 +27,19 @@ struct Buffer : LIST_ENTRY
 // D3D12 resource, while maintaining information used for versioning the buffers as
 // they run out of space.
 //
+// Allocate and Align may be called from any number of threads at once; space is
+// claimed with an interlocked add on the current offset. Renaming and Reset swap the
+// backing buffer, and must only happen on the render thread while no other thread
+// is allocating from this buffer (i.e. at frame boundaries). A thread that receives
+// E_OUTOFMEMORY must hand the work back to the render thread so it can rename.
+//
 class DynamicBuffer
 {
     friend class DX12Framework;
 
 private:
     Buffer* m_pBuffer;
-    ULONG_PTR m_pCurrentAddress;
+    volatile LONG64 m_CurrentOffset;
 
 public:
     //
@@ -51,7 +57,7 @@ public:
 
     inline void Reset()
     {
-        m_pCurrentAddress = m_pBuffer->pBaseAddress;
+        InterlockedExchange64(&m_CurrentOffset, 0);
     }
 };
 
@@ -67,7 +73,7 @@ struct DescriptorHeap : LIST_ENTRY
 //
 // A DynamicDescriptorHeap allows the application to allocate descriptors from a backing
 // D3D12 descriptor heap, while maintaining information used for versioning the heaps as
-// they run out of space.
+// they run out of space. It follows the same threading rules as DynamicBuffer.
 //
 class DynamicDescriptorHeap
 {
@@ -75,7 +81,7 @@ class DynamicDescriptorHeap
 
 private:
     DescriptorHeap* m_pHeap;
-    UINT32 m_CurrentHandleIndex;
+    volatile LONG m_CurrentHandleIndex;
     UINT32 m_DescriptorSize;
 
 public:
@@ -86,25 +92,28 @@ public:
 
     HRESULT Allocate(UINT32 ElementCount, D3D12_GPU_DESCRIPTOR_HANDLE* pGpuHandleStart, D3D12_CPU_DESCRIPTOR_HANDLE* pCpuHandleStart)
     {
-        if (m_CurrentHandleIndex + ElementCount > DYNAMIC_HEAP_SIZE)
+        //
+        // Claim the range first. On overflow the index is left past the end so every
+        // other producer fails too, until the render thread renames the heap.
+        //
+        UINT32 HandleIndex = (UINT32)InterlockedExchangeAdd(&m_CurrentHandleIndex, (LONG)ElementCount);
+        if (HandleIndex + ElementCount > DYNAMIC_HEAP_SIZE)
         {
             return E_OUTOFMEMORY;
         }
 
-        UINT32 Offset = m_CurrentHandleIndex * m_DescriptorSize;
+        UINT32 Offset = HandleIndex * m_DescriptorSize;
         CD3DX12_GPU_DESCRIPTOR_HANDLE GpuHandle(m_pHeap->pHeap->GetGPUDescriptorHandleForHeapStart(), Offset);
         CD3DX12_CPU_DESCRIPTOR_HANDLE CpuHandle(m_pHeap->pHeap->GetCPUDescriptorHandleForHeapStart(), Offset);
 
         *pGpuHandleStart = GpuHandle;
         *pCpuHandleStart = CpuHandle;
 
-        m_CurrentHandleIndex += ElementCount;
-
         return S_OK;
     }
 
     void Reset()
     {
-        m_CurrentHandleIndex = 0;
+        InterlockedExchange(&m_CurrentHandleIndex, 0);
     }
 };
@@ -72,6 +72,7 @@ using Microsoft::WRL::ComPtr;
 
 struct Frame;
 struct PagingFrame;
+struct PagingRequest;
 struct RenderFrame;
 struct ResourceMip;
 struct ResourceDeviceState;